@@ -0,0 +1,607 @@
+/* Generates 'nmd_x86_opcode_tables.c', the opcode tables used by the table-driven decoder(nmd_x86_decode_light()) and the table-driven length disassembler(nmd_x86_ldisasm()),
+the perfect hash tables used by the assembler to look up mnemonics and registers, and the table of mnemonics indexed by instruction id used by the formatter.
+
+The tables are produced by running the full decoder(nmd_x86_decode()) and the branch-based length disassembler(_nmd_ldisasm()) on every opcode of the one and
+two byte opcode maps with every ModR/M byte and a set of prefix combinations, so the table-driven functions give the same results by construction. An opcode whose
+properties depend on something the tables can't describe(e.g. a mandatory prefix) is marked with '_NMD_X86_OPCODE_FALLBACK', which makes
+the table-driven decoder call the full decoder. The mnemonic of an id is taken from the formatter's output for the same encodings, so an id the
+formatter prints in more than one way gets an empty entry and the formatter keeps choosing its mnemonic by opcode.
+
+Run this program every time the decoder's logic changes, in the same commit. Usage:
+ gcc generate_opcode_tables.c -o generate_opcode_tables && ./generate_opcode_tables > nmd_x86_opcode_tables.c && python merge_files.py
+
+'tests/assembly_test.cpp' includes this file with 'GENERATE_OPCODE_TABLES_NO_MAIN' defined, calls generate_tables() and fails if the tables compiled
+into 'nmd_assembly.h' are not the ones generated from the decoder.
+*/
+
+#ifndef NMD_ASSEMBLY_H
+#define NMD_ASSEMBLY_IMPLEMENTATION
+#include "../nmd_assembly.h"
+#endif /* NMD_ASSEMBLY_H */
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_EXTENSION_ROWS 256
+#define NUM_INSTRUCTION_IDS (NMD_X86_INSTRUCTION_ENDBR64 + 1)
+#define MNEMONIC_PADDING 16 /* See '_nmd_x86_mnemonics'. */
+
+typedef struct prefix_combination
+{
+	uint8_t bytes[3];
+	size_t num_bytes;
+	bool only_64bit_mode;
+} prefix_combination;
+
+/* LOCK is not listed because the table-driven functions always fall back when it's present. */
+static const prefix_combination prefix_combinations[] = {
+	{ {0}, 0, false },
+	{ {0x66}, 1, false }, { {0x67}, 1, false }, { {0xf2}, 1, false }, { {0xf3}, 1, false }, { {0x2e}, 1, false }, { {0x64}, 1, false },
+	{ {0x66, 0x67}, 2, false }, { {0x66, 0xf2}, 2, false }, { {0x66, 0xf3}, 2, false }, { {0xf2, 0x66}, 2, false }, { {0xf3, 0x66}, 2, false },
+	{ {0xf2, 0xf3}, 2, false }, { {0xf3, 0xf2}, 2, false }, { {0x66, 0x67, 0xf3}, 3, false },
+	{ {0x40}, 1, true }, { {0x41}, 1, true }, { {0x42}, 1, true }, { {0x44}, 1, true }, { {0x48}, 1, true }, { {0x4f}, 1, true },
+	{ {0x66, 0x48}, 2, true }, { {0x48, 0x66}, 2, true }, { {0x67, 0x48}, 2, true }, { {0xf3, 0x48}, 2, true }, { {0xf2, 0x4c}, 2, true }
+};
+
+static const NMD_X86_MODE modes[] = { NMD_X86_MODE_16, NMD_X86_MODE_32, NMD_X86_MODE_64 };
+static const char* const mode_names[] = { "NMD_X86_MODE_16", "NMD_X86_MODE_32", "NMD_X86_MODE_64" };
+
+static _nmd_x86_opcode_info op_info[2][3][256];
+static _nmd_x86_opcode_info extensions[MAX_EXTENSION_ROWS][8];
+static uint8_t ldisasm_flags[2][3][256];
+static size_t num_extensions = 0;
+static uint8_t prefix_classes[256];
+static uint32_t mnemonic_hash_seed;
+static uint8_t mnemonic_hash_table[1 << _NMD_X86_ASM_MNEMONIC_HASH_BITS];
+static uint32_t reg_hash_seed;
+static uint8_t reg_hash_table[1 << _NMD_X86_ASM_REG_HASH_BITS];
+static char mnemonics[NUM_INSTRUCTION_IDS][MNEMONIC_PADDING]; /* The mnemonic the formatter gives to an id, empty if it was never seen. */
+static bool inconsistent_mnemonics[NUM_INSTRUCTION_IDS];     /* Set if the formatter gives different mnemonics to an id. */
+static char mnemonic_strings[NUM_INSTRUCTION_IDS * MNEMONIC_PADDING + MNEMONIC_PADDING];
+static size_t mnemonic_strings_size;
+static uint16_t mnemonic_offsets[NUM_INSTRUCTION_IDS];
+
+static size_t get_imm_size(uint8_t imm, NMD_X86_MODE mode, uint16_t prefixes)
+{
+	return _nmd_x86_get_imm_size(imm, mode, (prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE) != 0, (prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE) != 0, (prefixes & NMD_X86_PREFIXES_REX_W) != 0);
+}
+
+/* Opcodes the tables never describe: escape bytes, prefixes, VEX/EVEX/3DNow! and 'mov' to/from control/debug registers(ModR/M.mod is ignored). */
+static bool is_forced_fallback(size_t map, uint8_t op, NMD_X86_MODE mode)
+{
+	if (map == 0)
+		return op == 0x0f || op == 0x26 || op == 0x2e || op == 0x36 || op == 0x3e || op == 0x64 || op == 0x65 || op == 0x66 || op == 0x67 ||
+			op == 0xf0 || op == 0xf2 || op == 0xf3 || op == 0x62 || op == 0xc4 || op == 0xc5 || (mode == NMD_X86_MODE_64 && _NMD_R(op) == 4);
+	else
+		return op == 0x0f || op == 0x38 || op == 0x3a || (op >= 0x20 && op <= 0x23);
+}
+
+/* Returns the prefixes of a prefix combination that affect the size of an immediate. */
+static uint16_t get_prefixes(const prefix_combination* p)
+{
+	uint16_t prefixes = 0;
+	size_t i;
+	for (i = 0; i < p->num_bytes; i++)
+	{
+		if (p->bytes[i] == 0x66)
+			prefixes |= NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE;
+		else if (p->bytes[i] == 0x67)
+			prefixes |= NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE;
+		else if (_NMD_R(p->bytes[i]) == 4 && (p->bytes[i] & 0b1000))
+			prefixes |= NMD_X86_PREFIXES_REX_W;
+	}
+	return prefixes;
+}
+
+/* Generates the flags of an opcode used by the table-driven length disassembler. */
+static uint8_t generate_ldisasm_flags(size_t map, uint8_t op, NMD_X86_MODE mode)
+{
+	uint32_t candidates = 0xffffffff; /* Bit '16 * has_modrm + imm' is set if the combination matches every valid result. */
+	bool seen[2] = { false, false }, valid[2] = { false, false }; /* [mod == 0b11] */
+	size_t i, j;
+	uint8_t buffer[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH];
+
+	/* Escape bytes, prefixes and VEX(the length depends on the VEX prefix) */
+	if (map == 0 ? (op == 0xc4 || op == 0xc5 || (op != 0x62 && is_forced_fallback(map, op, mode))) : is_forced_fallback(map, op, mode))
+		return _NMD_X86_OPCODE_FALLBACK;
+
+	for (i = 0; i < sizeof(prefix_combinations) / sizeof(prefix_combinations[0]); i++)
+	{
+		const prefix_combination* const p = &prefix_combinations[i];
+		const uint16_t prefixes = get_prefixes(p);
+		size_t modrm;
+		if (p->only_64bit_mode && mode != NMD_X86_MODE_64)
+			continue;
+
+		for (modrm = 0; modrm < 256; modrm++)
+		{
+			const bool is_reg_form = modrm >> 6 == 3;
+			size_t n = 0, length;
+			for (j = 0; j < sizeof(buffer); j++)
+				buffer[j] = 0;
+			for (j = 0; j < p->num_bytes; j++)
+				buffer[n++] = p->bytes[j];
+			if (map == 1)
+				buffer[n++] = 0x0f;
+			buffer[n++] = op;
+			buffer[n] = (uint8_t)modrm;
+
+			length = _nmd_ldisasm(buffer, sizeof(buffer), mode);
+			if (!seen[is_reg_form])
+			{
+				seen[is_reg_form] = true;
+				valid[is_reg_form] = length != 0;
+			}
+			else if (valid[is_reg_form] != (length != 0))
+				return _NMD_X86_OPCODE_FALLBACK;
+
+			if (length)
+			{
+				const uint8_t* b = buffer + n;
+				size_t size = sizeof(buffer) - n;
+				uint32_t sample_candidates = 0;
+				uint8_t imm;
+				nmd_x86_modrm m;
+				_nmd_ldisasm_decode_modrm(&b, &size, (prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE) != 0, mode, &m);
+
+				for (imm = 0; imm <= _NMD_X86_OPCODE_IMM_FAR; imm++)
+				{
+					const size_t imm_size = get_imm_size(imm, mode, prefixes);
+					if (n + imm_size == length)
+						sample_candidates |= (uint32_t)1 << imm;
+					if ((size_t)(b - buffer) + imm_size == length)
+						sample_candidates |= (uint32_t)1 << (16 + imm);
+				}
+				candidates &= sample_candidates;
+			}
+		}
+	}
+
+	if (!valid[0] && !valid[1])
+		return _NMD_X86_OPCODE_FALLBACK;
+
+	for (i = 0; i <= _NMD_X86_OPCODE_IMM_FAR; i++)
+	{
+		if (candidates & ((uint32_t)1 << (16 + i)))
+			return (uint8_t)(_NMD_X86_OPCODE_MODRM | i | (valid[1] ? 0 : _NMD_X86_OPCODE_INVALID_REG) | (valid[0] ? 0 : _NMD_X86_OPCODE_INVALID_MEM));
+	}
+
+	for (i = 0; i <= _NMD_X86_OPCODE_IMM_FAR; i++)
+	{
+		if (candidates & ((uint32_t)1 << i))
+			return (uint8_t)(valid[0] && valid[1] ? i : _NMD_X86_OPCODE_FALLBACK);
+	}
+
+	return _NMD_X86_OPCODE_FALLBACK;
+}
+
+/* Returns the classes of a byte. See '_NMD_X86_PREFIX_CLASS'. */
+static uint8_t get_prefix_classes(uint8_t byte)
+{
+	switch (byte)
+	{
+	case 0x26: case 0x2e: case 0x36: case 0x3e: case 0x64: case 0x65: case 0xf2: case 0xf3: return _NMD_X86_PREFIX_CLASS_LEGACY;
+	case 0x66: return _NMD_X86_PREFIX_CLASS_LEGACY | _NMD_X86_PREFIX_CLASS_OPERAND_SIZE;
+	case 0x67: return _NMD_X86_PREFIX_CLASS_LEGACY | _NMD_X86_PREFIX_CLASS_ADDRESS_SIZE;
+	case 0xf0: return _NMD_X86_PREFIX_CLASS_LEGACY | _NMD_X86_PREFIX_CLASS_LOCK;
+	default:
+		if (_NMD_R(byte) == 4)
+			return (uint8_t)(_NMD_X86_PREFIX_CLASS_REX | (byte & 0b1000 ? _NMD_X86_PREFIX_CLASS_REX_W : 0));
+		return 0;
+	}
+}
+
+/* Finds a seed for which the names' hashes index different entries of a table with 2^'bits' entries. Then fills the table with the names' values(zero means empty). */
+static uint32_t generate_hash_table(const char* const* names, const uint8_t* values, size_t num_names, size_t bits, uint8_t* table)
+{
+	uint32_t seed = 2166136261; /* The FNV-1a offset basis. */
+	size_t i;
+	for (;; seed++)
+	{
+		for (i = 0; i < ((size_t)1 << bits); i++)
+			table[i] = 0;
+
+		for (i = 0; i < num_names; i++)
+		{
+			const size_t index = _nmd_hash_string(names[i], strlen(names[i]), seed) >> (32 - bits);
+			if (table[index])
+				break;
+			table[index] = values[i];
+		}
+
+		if (i == num_names)
+			return seed;
+	}
+}
+
+typedef struct slot
+{
+	bool seen;
+	bool consistent;
+	bool valid;
+	uint16_t id;
+	uint8_t group;
+	bool has_modrm;
+	uint16_t imm_candidates; /* Bit 'n' is set if '_NMD_X86_OPCODE_IMM' 'n' matches every valid result. */
+} slot;
+
+static void add_result(slot* s, bool valid, const nmd_x86_instruction* instruction, NMD_X86_MODE mode)
+{
+	uint16_t candidates = 0;
+	uint8_t imm;
+	if (valid)
+	{
+		for (imm = 0; imm <= _NMD_X86_OPCODE_IMM_FAR; imm++)
+		{
+			if (get_imm_size(imm, mode, instruction->prefixes) == instruction->imm_mask)
+				candidates |= (uint16_t)(1 << imm);
+		}
+	}
+
+	if (!s->seen)
+	{
+		s->seen = true;
+		s->consistent = true;
+		s->valid = valid;
+		s->id = valid ? instruction->id : 0;
+		s->group = valid ? instruction->group : 0;
+		s->has_modrm = valid ? instruction->has_modrm : false;
+		s->imm_candidates = valid ? candidates : 0xffff;
+	}
+	else if (s->valid != valid || (valid && (s->id != instruction->id || s->group != instruction->group || s->has_modrm != instruction->has_modrm)))
+		s->consistent = false;
+	else if (valid)
+		s->imm_candidates &= candidates;
+}
+
+static uint8_t get_imm(uint16_t candidates)
+{
+	uint8_t imm;
+	for (imm = 0; imm <= _NMD_X86_OPCODE_IMM_FAR; imm++)
+	{
+		if (candidates & (1 << imm))
+			return imm;
+	}
+	return 0xff;
+}
+
+/* Merges the register(mod=0b11) and memory(mod!=0b11) forms of the slots for a value of ModR/M.reg. */
+static _nmd_x86_opcode_info merge_forms(const slot* reg_form, const slot* mem_form)
+{
+	_nmd_x86_opcode_info info = { 0, 0, _NMD_X86_OPCODE_FALLBACK };
+	uint8_t imm;
+	if (!reg_form->consistent || !mem_form->consistent || (!reg_form->valid && !mem_form->valid))
+		return info;
+
+	if (reg_form->valid && mem_form->valid && (reg_form->id != mem_form->id || reg_form->group != mem_form->group))
+		return info;
+
+	if ((imm = get_imm((uint16_t)(reg_form->imm_candidates & mem_form->imm_candidates))) == 0xff)
+		return info;
+
+	info.id = reg_form->valid ? reg_form->id : mem_form->id;
+	info.group = reg_form->valid ? reg_form->group : mem_form->group;
+	info.flags = (uint8_t)(_NMD_X86_OPCODE_MODRM | imm | (reg_form->valid ? 0 : _NMD_X86_OPCODE_INVALID_REG) | (mem_form->valid ? 0 : _NMD_X86_OPCODE_INVALID_MEM));
+	return info;
+}
+
+static bool is_same_info(const _nmd_x86_opcode_info* a, const _nmd_x86_opcode_info* b)
+{
+	return a->id == b->id && a->group == b->group && a->flags == b->flags;
+}
+
+static uint16_t add_extension(const _nmd_x86_opcode_info* row)
+{
+	size_t i, j;
+	for (i = 0; i < num_extensions; i++)
+	{
+		for (j = 0; j < 8 && is_same_info(&extensions[i][j], &row[j]); j++);
+		if (j == 8)
+			return (uint16_t)i;
+	}
+
+	if (num_extensions == MAX_EXTENSION_ROWS)
+	{
+		fprintf(stderr, "error: too many extension rows\n");
+		return 0;
+	}
+
+	for (j = 0; j < 8; j++)
+		extensions[num_extensions][j] = row[j];
+
+	return (uint16_t)num_extensions++;
+}
+
+/* Formats the instruction with the mnemonics chosen by opcode(id is cleared) and records its first token that is not a prefix as the mnemonic of its id. */
+static void add_mnemonic(const nmd_x86_instruction* instruction)
+{
+	static const char* const prefixes[] = { "lock", "rep", "repe", "repz", "repne", "repnz", "bnd", "xacquire", "xrelease" };
+	nmd_x86_instruction copy = *instruction;
+	char string[NMD_X86_FORMATTER_MAX_LENGTH];
+	const char* token = string;
+	size_t length, i;
+
+	if (!instruction->id || inconsistent_mnemonics[instruction->id])
+		return;
+
+	copy.id = 0;
+	_nmd_x86_format(&copy, string, NMD_X86_INVALID_RUNTIME_ADDRESS, 0);
+	for (;;)
+	{
+		for (length = 0; token[length] && token[length] != ' '; length++);
+		for (i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]) && (strlen(prefixes[i]) != length || strncmp(prefixes[i], token, length)); i++);
+		if (i == sizeof(prefixes) / sizeof(prefixes[0]) || !token[length])
+			break;
+		token += length + 1;
+	}
+
+	if (length == 0 || length >= MNEMONIC_PADDING)
+		inconsistent_mnemonics[instruction->id] = true;
+	else if (!mnemonics[instruction->id][0])
+		memcpy(mnemonics[instruction->id], token, length);
+	else if (strlen(mnemonics[instruction->id]) != length || strncmp(mnemonics[instruction->id], token, length))
+		inconsistent_mnemonics[instruction->id] = true;
+}
+
+/* Builds '_nmd_x86_mnemonics' and '_nmd_x86_mnemonic_offsets' from the recorded mnemonics. Ids without a consistent mnemonic share the empty string at offset zero. */
+static void generate_mnemonic_table(void)
+{
+	size_t id, other, length;
+
+	memset(mnemonic_strings, 0, sizeof(mnemonic_strings));
+	mnemonic_strings_size = 1;
+	for (id = 0; id < NUM_INSTRUCTION_IDS; id++)
+	{
+		mnemonic_offsets[id] = 0;
+		if (inconsistent_mnemonics[id] || !mnemonics[id][0])
+			continue;
+
+		for (other = 0; other < id && (mnemonic_offsets[other] == 0 || strcmp(mnemonics[other], mnemonics[id])); other++);
+		if (other < id)
+		{
+			mnemonic_offsets[id] = mnemonic_offsets[other];
+			continue;
+		}
+
+		length = strlen(mnemonics[id]);
+		mnemonic_offsets[id] = (uint16_t)mnemonic_strings_size;
+		mnemonic_strings[mnemonic_strings_size] = (char)length;
+		memcpy(mnemonic_strings + mnemonic_strings_size + 1, mnemonics[id], length);
+		mnemonic_strings_size += length + 1;
+	}
+}
+
+static _nmd_x86_opcode_info generate_info(size_t map, uint8_t op, NMD_X86_MODE mode)
+{
+	const uint32_t flags = NMD_X86_DECODER_FLAGS_VALIDITY_CHECK | NMD_X86_DECODER_FLAGS_INSTRUCTION_ID | NMD_X86_DECODER_FLAGS_GROUP;
+	_nmd_x86_opcode_info info = { 0, 0, _NMD_X86_OPCODE_FALLBACK };
+	_nmd_x86_opcode_info row[8];
+	slot slots[8][2]; /* [ModR/M.reg][mod == 0b11] */
+	slot no_modrm;
+	bool has_modrm = false, no_modrm_seen = false;
+	size_t i, j, reg;
+	nmd_x86_instruction instruction;
+	uint8_t buffer[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH];
+
+	if (is_forced_fallback(map, op, mode))
+		return info;
+
+	for (i = 0; i < sizeof(slots); i++)
+		((uint8_t*)slots)[i] = 0;
+	for (i = 0; i < sizeof(no_modrm); i++)
+		((uint8_t*)&no_modrm)[i] = 0;
+
+	for (i = 0; i < sizeof(prefix_combinations) / sizeof(prefix_combinations[0]); i++)
+	{
+		const prefix_combination* const p = &prefix_combinations[i];
+		size_t modrm;
+		if (p->only_64bit_mode && mode != NMD_X86_MODE_64)
+			continue;
+
+		for (modrm = 0; modrm < 256; modrm++)
+		{
+			size_t n = 0;
+			bool valid;
+			for (j = 0; j < sizeof(buffer); j++)
+				buffer[j] = 0;
+			for (j = 0; j < p->num_bytes; j++)
+				buffer[n++] = p->bytes[j];
+			if (map == 1)
+				buffer[n++] = 0x0f;
+			buffer[n++] = op;
+			buffer[n++] = (uint8_t)modrm;
+
+			valid = nmd_x86_decode(buffer, sizeof(buffer), &instruction, mode, flags);
+			if (valid)
+				add_mnemonic(&instruction);
+			if (valid && instruction.has_modrm)
+				has_modrm = true;
+			else if (valid)
+				no_modrm_seen = true;
+
+			add_result(&no_modrm, valid, &instruction, mode);
+			add_result(&slots[(modrm >> 3) & 7][modrm >> 6 == 3], valid, &instruction, mode);
+		}
+	}
+
+	if (has_modrm && no_modrm_seen)
+		return info;
+
+	if (!has_modrm)
+	{
+		uint8_t imm;
+		if (no_modrm.consistent && no_modrm.valid && (imm = get_imm(no_modrm.imm_candidates)) != 0xff)
+		{
+			info.id = no_modrm.id;
+			info.group = no_modrm.group;
+			info.flags = imm;
+		}
+		return info;
+	}
+
+	for (reg = 0; reg < 8; reg++)
+		row[reg] = merge_forms(&slots[reg][1], &slots[reg][0]);
+
+	for (reg = 1; reg < 8 && is_same_info(&row[reg], &row[0]); reg++);
+	if (reg == 8)
+		return row[0];
+
+	info.id = add_extension(row);
+	info.group = 0;
+	info.flags = _NMD_X86_OPCODE_MODRM | _NMD_X86_OPCODE_EXTENSION;
+	return info;
+}
+
+/* Generates every table from the decoder's logic. */
+static void generate_tables(void)
+{
+	const char* names[256];
+	uint8_t values[256];
+	size_t map, mode, i, num_names = 0;
+
+	num_extensions = 0;
+	memset(mnemonics, 0, sizeof(mnemonics));
+	memset(inconsistent_mnemonics, 0, sizeof(inconsistent_mnemonics));
+	for (map = 0; map < 2; map++)
+	{
+		for (mode = 0; mode < 3; mode++)
+		{
+			for (i = 0; i < 256; i++)
+			{
+				op_info[map][mode][i] = generate_info(map, (uint8_t)i, modes[mode]);
+				ldisasm_flags[map][mode][i] = generate_ldisasm_flags(map, (uint8_t)i, modes[mode]);
+			}
+		}
+	}
+
+	generate_mnemonic_table();
+
+	for (i = 0; i < 256; i++)
+		prefix_classes[i] = get_prefix_classes((uint8_t)i);
+
+	for (i = _NMD_X86_ASM_MNEMONIC_NONE + 1; i < _NMD_X86_ASM_MNEMONIC_NUM; i++, num_names++)
+		names[num_names] = _nmd_x86_asm_mnemonics[i], values[num_names] = (uint8_t)i;
+	mnemonic_hash_seed = generate_hash_table(names, values, num_names, _NMD_X86_ASM_MNEMONIC_HASH_BITS, mnemonic_hash_table);
+
+	num_names = 0;
+	for (i = NMD_X86_REG_AL; i <= NMD_X86_REG_GS; i++, num_names++)
+		names[num_names] = _nmd_get_asm_reg_name((uint8_t)i), values[num_names] = (uint8_t)i;
+	reg_hash_seed = generate_hash_table(names, values, num_names, _NMD_X86_ASM_REG_HASH_BITS, reg_hash_table);
+}
+
+#ifndef GENERATE_OPCODE_TABLES_NO_MAIN
+static void print_info(const _nmd_x86_opcode_info* info)
+{
+	printf("{%4d,0x%02x,0x%02x}", info->id, info->group, info->flags);
+}
+
+static void print_byte_table(const uint8_t* table, size_t size, const char* indent)
+{
+	size_t i, j;
+	for (i = 0; i < size; i += 16)
+	{
+		printf("%s/* %02X */ ", indent, (int)i);
+		for (j = 0; j < 16; j++)
+			printf(i + j == size - 1 ? "0x%02x\n" : (j == 15 ? "0x%02x,\n" : "0x%02x, "), table[i + j]);
+	}
+}
+
+/* Prints 'nmd_x86_opcode_tables.c'. generate_tables() must be called first. */
+static void print_tables(void)
+{
+	size_t map, mode, i, j;
+
+	printf("/* This file is generated by 'generate_opcode_tables.c' from the decoder's logic. Do not edit it manually. */\n\n");
+	printf("#include \"nmd_common.h\"\n");
+
+	for (map = 0; map < 2; map++)
+	{
+		printf("\n/* Properties of the opcodes of the %s opcode map. Indexed by [mode >> 2][opcode]. See '_nmd_x86_opcode_info'. */\n", map == 0 ? "one byte" : "two byte(0F)");
+		printf("NMD_ASSEMBLY_API const _nmd_x86_opcode_info _nmd_x86_op%d_info[3][256] = {\n", (int)map + 1);
+		for (mode = 0; mode < 3; mode++)
+		{
+			printf("\t{ /* %s */\n", mode_names[mode]);
+			for (i = 0; i < 256; i += 8)
+			{
+				printf("\t\t/* %02X */ ", (int)i);
+				for (j = 0; j < 8; j++)
+				{
+					print_info(&op_info[map][mode][i + j]);
+					printf(i + j == 255 ? "\n" : (j == 7 ? ",\n" : ", "));
+				}
+			}
+			printf(mode == 2 ? "\t}\n" : "\t},\n");
+		}
+		printf("};\n");
+	}
+
+	printf("\n/* Properties of the opcodes whose properties depend on ModR/M.reg. Indexed by [_nmd_x86_opcode_info.id][ModR/M.reg]. */\n");
+	printf("NMD_ASSEMBLY_API const _nmd_x86_opcode_info _nmd_x86_opcode_extensions[%d][8] = {\n", (int)num_extensions);
+	for (i = 0; i < num_extensions; i++)
+	{
+		printf("\t{ ");
+		for (j = 0; j < 8; j++)
+		{
+			print_info(&extensions[i][j]);
+			printf(j == 7 ? " }" : ", ");
+		}
+		printf(i == num_extensions - 1 ? "\n" : ",\n");
+	}
+	printf("};\n");
+
+	for (map = 0; map < 2; map++)
+	{
+		printf("\n/* Flags('_NMD_X86_OPCODE_FLAGS') of the opcodes of the %s opcode map used by the table-driven length disassembler. Indexed by [mode >> 2][opcode]. */\n", map == 0 ? "one byte" : "two byte(0F)");
+		printf("NMD_ASSEMBLY_API const uint8_t _nmd_x86_ldisasm_op%d_flags[3][256] = {\n", (int)map + 1);
+		for (mode = 0; mode < 3; mode++)
+		{
+			printf("\t{ /* %s */\n", mode_names[mode]);
+			print_byte_table(ldisasm_flags[map][mode], 256, "\t\t");
+			printf(mode == 2 ? "\t}\n" : "\t},\n");
+		}
+		printf("};\n");
+	}
+
+	printf("\n/* Length-prefixed mnemonics of the instructions as printed by the formatter, followed by %d zero bytes so that '_nmd_append_mnemonic' can always copy %d bytes. */\n", MNEMONIC_PADDING, MNEMONIC_PADDING);
+	printf("NMD_ASSEMBLY_API const char _nmd_x86_mnemonics[%d] =", (int)(mnemonic_strings_size + MNEMONIC_PADDING));
+	for (i = 0, j = 0; i < mnemonic_strings_size; i += (size_t)mnemonic_strings[i] + 1, j++)
+	{
+		printf(j % 8 == 0 ? "\n\t" : " ");
+		printf(mnemonic_strings[i] ? "\"\\%03o\" \"%.*s\"" : "\"\\%03o\"", mnemonic_strings[i], (int)mnemonic_strings[i], mnemonic_strings + i + 1);
+	}
+	printf(";\n");
+
+	printf("\n/* Offsets in '_nmd_x86_mnemonics' of the mnemonics of the instructions. Indexed by 'NMD_X86_INSTRUCTION'. */\n");
+	printf("NMD_ASSEMBLY_API const uint16_t _nmd_x86_mnemonic_offsets[NMD_X86_INSTRUCTION_ENDBR64 + 1] = {\n");
+	for (i = 0; i < NUM_INSTRUCTION_IDS; i += 16)
+	{
+		printf("\t/* %4d */ ", (int)i);
+		for (j = 0; j < 16 && i + j < NUM_INSTRUCTION_IDS; j++)
+			printf(i + j == NUM_INSTRUCTION_IDS - 1 ? "%4d\n" : (j == 15 ? "%4d,\n" : "%4d, "), mnemonic_offsets[i + j]);
+	}
+	printf("};\n");
+
+	printf("\n/* Classes('_NMD_X86_PREFIX_CLASS') of every byte. */\n");
+	printf("NMD_ASSEMBLY_API const uint8_t _nmd_x86_prefix_classes[256] = {\n");
+	print_byte_table(prefix_classes, 256, "\t");
+	printf("};\n");
+
+	printf("\n/* Perfect hash table of the assembler's mnemonics('_NMD_X86_ASM_MNEMONIC'). Indexed by the high-order bits of _nmd_hash_string(mnemonic, length, _nmd_x86_asm_mnemonic_hash_seed). */\n");
+	printf("NMD_ASSEMBLY_API const uint32_t _nmd_x86_asm_mnemonic_hash_seed = 0x%08x;\n", mnemonic_hash_seed);
+	printf("NMD_ASSEMBLY_API const uint8_t _nmd_x86_asm_mnemonic_hash_table[1 << _NMD_X86_ASM_MNEMONIC_HASH_BITS] = {\n");
+	print_byte_table(mnemonic_hash_table, sizeof(mnemonic_hash_table), "\t");
+	printf("};\n");
+
+	printf("\n/* Perfect hash table of the general-purpose and segment registers('NMD_X86_REG'). Indexed by the high-order bits of _nmd_hash_string(name, length, _nmd_x86_asm_reg_hash_seed). */\n");
+	printf("NMD_ASSEMBLY_API const uint32_t _nmd_x86_asm_reg_hash_seed = 0x%08x;\n", reg_hash_seed);
+	printf("NMD_ASSEMBLY_API const uint8_t _nmd_x86_asm_reg_hash_table[1 << _NMD_X86_ASM_REG_HASH_BITS] = {\n");
+	print_byte_table(reg_hash_table, sizeof(reg_hash_table), "\t");
+	printf("};\n");
+}
+
+int main()
+{
+	generate_tables();
+	print_tables();
+	return 0;
+}
+#endif /* GENERATE_OPCODE_TABLES_NO_MAIN */
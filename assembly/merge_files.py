@@ -4,10 +4,15 @@ file_names = [
 
     # Implementation files
     'nmd_common.c', # common macros, functions, structs...
+    'nmd_x86_opcode_tables.c', # generated by 'generate_opcode_tables.c'
     'nmd_x86_assembler.c',
     'nmd_x86_decoder.c',
     'nmd_x86_ldisasm.c',
     'nmd_x86_formatter.c',
+    'nmd_x86_cache.c',
+    'nmd_x86_cfg.c',
+    'nmd_x86_parallel.c',
+    'nmd_x86_pipeline.c',
 ]
 
 file_contents = []
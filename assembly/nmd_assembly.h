@@ -18,10 +18,14 @@ Interfaces(i.e the functions you call from your application):
      - string          [in]         A pointer to a string that represents one or more instructions in assembly language.
      - buffer          [out]        A pointer to a buffer that receives the encoded instructions.
      - buffer_size     [in]         The size of the buffer in bytes.
-     - runtime_address [in]         The instruction's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+     - runtime_address [in]         The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
      - mode            [in]         The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
      - count           [in/out/opt] A pointer to a variable that on input is the maximum number of instructions that can be parsed(or zero for unlimited instructions), and on output is the number of instructions parsed. This parameter may be zero.
     size_t nmd_x86_assemble(const char* string, void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, size_t* const count);
+    - Same as nmd_x86_assemble(), but the instruction is described by a variable of type 'nmd_x86_instruction'(e.g. filled by nmd_x86_decode()) instead of a string.
+      size_t nmd_x86_encode(const nmd_x86_instruction* instruction, void* buffer, size_t buffer_size);
+    - Same as nmd_x86_assemble(), but the instructions may define and refer to labels('loop: dec ecx' 'jnz loop'). The shortest branch encodings are chosen.
+      size_t nmd_x86_assemble_block(const char* string, void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, void* arena, size_t arena_size);
 
  - The disassembler is composed of a decoder and a formatter implemented by these two functions respectively:
 	- Decodes an instruction. Returns true if the instruction is valid, false otherwise.
@@ -33,14 +37,66 @@ Interfaces(i.e the functions you call from your application):
        - flags       [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use. If uncertain, use 'NMD_X86_DECODER_FLAGS_MINIMAL'.
       bool nmd_x86_decode(const void* buffer, size_t buffer_size, nmd_x86_instruction* instruction, NMD_X86_MODE mode, uint32_t flags);
 
+    - Decodes consecutive instructions until the end of the buffer, an invalid instruction or the end of the output array is reached. Returns the number of instructions decoded.
+      Parameters:
+       - buffer           [in]      A pointer to a buffer containing encoded instructions.
+       - buffer_size      [in]      The buffer's size in bytes.
+       - runtime_address  [in]      The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+       - mode             [in]      The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+       - flags            [in]      A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+       - instructions     [out]     A pointer to an array of 'nmd_x86_instruction' that receives the decoded instructions.
+       - num_instructions [in]      The number of elements in 'instructions'.
+       - info             [out/opt] A pointer to a variable of type 'nmd_x86_buffer_info' that receives where and why the function stopped. This parameter may be null.
+      size_t nmd_x86_decode_buffer(const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags, nmd_x86_instruction* instructions, size_t num_instructions, nmd_x86_buffer_info* info);
+
+    - Decodes an instruction into a compact(24 bytes) record using precomputed opcode tables. Returns true if the instruction is valid, false otherwise.
+      Parameters:
+       - buffer          [in]  A pointer to a buffer containing an encoded instruction.
+       - buffer_size     [in]  The buffer's size in bytes.
+       - runtime_address [in]  The instruction's runtime address used to compute 'branch_target'. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+       - instruction     [out] A pointer to a variable of type 'nmd_x86_light_instruction' that receives information about the instruction.
+       - mode            [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+       - flags           [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX'. 'NMD_X86_DECODER_FLAGS_OPERANDS', 'NMD_X86_DECODER_FLAGS_CPU_FLAGS' and 'NMD_X86_DECODER_FLAGS_REGISTERS' are ignored.
+      bool nmd_x86_decode_light(const void* buffer, size_t buffer_size, uint64_t runtime_address, nmd_x86_light_instruction* instruction, NMD_X86_MODE mode, uint32_t flags);
+
+    - Same as nmd_x86_decode_buffer(), but fills an array of 'nmd_x86_light_instruction'.
+      size_t nmd_x86_decode_buffer_light(const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags, nmd_x86_light_instruction* instructions, size_t num_instructions, nmd_x86_buffer_info* info);
+
+    - Computes the registers and cpu flags read and written by an instruction as fixed-width masks. The decoder fills 'instruction->registers' the same way if 'NMD_X86_DECODER_FLAGS_REGISTERS' is set.
+      void nmd_x86_get_register_use(const nmd_x86_instruction* instruction, nmd_x86_register_use* registers);
+
     - Formats an instruction. This function may access invalid memory(thus causing a crash) if you modify 'instruction' manually.
       Parameters:
        - instruction     [in]  A pointer to a variable of type 'nmd_x86_instruction' describing the instruction to be formatted.
-       - buffer          [out] A pointer to buffer that receives the string. The buffer's recommended size is 128 bytes.
+       - buffer          [out] A pointer to buffer that receives the string. It should have at least 'NMD_X86_FORMATTER_MAX_LENGTH' bytes.
        - runtime_address [in]  The instruction's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
        - flags           [in]  A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the function should format the instruction. If uncertain, use 'NMD_X86_FORMAT_FLAGS_DEFAULT'.
       void nmd_x86_format(const nmd_x86_instruction* instruction, char buffer[], uint64_t runtime_address, uint32_t flags);
 
+    - Same as nmd_x86_format(), but takes the buffer's size and returns the length of the string(excluding the null character), or zero if the instruction
+      is invalid or the string does not fit in the buffer. If 'buffer_size' is at least 'NMD_X86_FORMATTER_MAX_LENGTH' the string is formatted in place.
+      size_t nmd_x86_format_ex(const nmd_x86_instruction* instruction, char* buffer, size_t buffer_size, uint64_t runtime_address, uint32_t flags);
+
+    - Formats consecutive instructions into a single buffer, one line per instruction, and optionally returns the position of each line.
+      Lines are separated by '\n'. If 'NMD_X86_FORMAT_FLAGS_ADDRESS' is set each line starts with the instruction's runtime address.
+      size_t nmd_x86_format_buffer(const nmd_x86_instruction* instructions, size_t num_instructions, uint64_t runtime_address, uint32_t flags, char* buffer, size_t buffer_size, nmd_x86_text_line* lines, size_t* text_length);
+
+ - The decode cache keeps decoded and formatted instructions in a memory block provided by the caller, so code that is disassembled repeatedly(e.g. around
+   a debugger's program counter) is only decoded once:
+    - Initializes a cache. Returns the number of entries.
+      size_t nmd_x86_cache_init(nmd_x86_cache* cache, void* memory, size_t memory_size);
+    - Same as nmd_x86_decode(), but the instruction is looked up in the cache first. Returns a pointer to the instruction or a null pointer if it's invalid.
+      const nmd_x86_instruction* nmd_x86_cache_decode(nmd_x86_cache* cache, const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags);
+    - Same as nmd_x86_cache_decode(), but returns the formatted instruction.
+      const char* nmd_x86_cache_format(nmd_x86_cache* cache, const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t decoder_flags, uint32_t format_flags);
+    - Removes the instructions that overlap a range of memory(e.g. self-modifying code), or every instruction.
+      size_t nmd_x86_cache_invalidate(nmd_x86_cache* cache, uint64_t runtime_address, size_t size);
+      void nmd_x86_cache_clear(nmd_x86_cache* cache);
+
+ - The control flow graph builder finds the basic blocks reachable from one or more entry points and the edges between them. The graph is stored as
+   struct of arrays in a memory block provided by the caller. Returns the number of blocks.
+    size_t nmd_x86_cfg_build(const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, const uint64_t* entry_points, size_t num_entry_points, nmd_x86_cfg* cfg, void* memory, size_t memory_size);
+
  - The length disassembler is implemented by the following function:
     Returns the length of the instruction if it is valid, zero otherwise.
     Parameters:
@@ -49,6 +105,38 @@ Interfaces(i.e the functions you call from your application):
      - mode        [in] The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
     size_t nmd_x86_ldisasm(const void* buffer, size_t buffer_size, NMD_X86_MODE mode);
 
+ - The length of consecutive instructions is computed by the following function:
+    Computes the length of consecutive instructions until the end of the buffer, an invalid instruction or the end of the output array is reached. Returns the number of lengths written to 'lengths'.
+    Parameters:
+     - buffer      [in]      A pointer to a buffer containing encoded instructions.
+     - buffer_size [in]      The buffer's size in bytes.
+     - mode        [in]      The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+     - lengths     [out]     A pointer to an array that receives the length of each instruction.
+     - num_lengths [in]      The number of elements in 'lengths'.
+     - info        [out/opt] A pointer to a variable of type 'nmd_x86_buffer_info' that receives where and why the function stopped. This parameter may be null.
+    size_t nmd_x86_ldisasm_buffer(const void* buffer, size_t buffer_size, NMD_X86_MODE mode, uint8_t* lengths, size_t num_lengths, nmd_x86_buffer_info* info);
+
+ - Multithreaded disassembly(only available if 'NMD_ASSEMBLY_ENABLE_THREADS' is defined) is implemented by the following functions:
+    - Computes the instruction boundaries of a buffer using multiple threads. Returns the number of valid instructions.
+      The buffer is split in chunks which are decoded concurrently as if an instruction started at the first byte of each chunk. Afterwards the instruction
+      stream of every chunk is resynchronized with the stream of the previous chunk(decoding from where the previous chunk's stream left off until both
+      streams reach the same instruction), so the result is identical to a linear sweep that skips invalid instructions one byte at a time.
+      'lengths' must have 'buffer_size' elements. 'lengths[i]' is the length of the instruction at offset 'i' if one starts there, zero otherwise.
+      size_t nmd_x86_ldisasm_parallel(const void* buffer, size_t buffer_size, NMD_X86_MODE mode, uint8_t* lengths, size_t num_threads);
+
+    - Decodes every instruction of a buffer using multiple threads. The instruction boundaries are computed with the decoder's lengths and the instructions are written in address order.
+      size_t nmd_x86_decode_parallel(const void* buffer, size_t buffer_size, NMD_X86_MODE mode, uint32_t flags, uint8_t* lengths, nmd_x86_instruction* instructions, size_t num_instructions, size_t num_threads);
+
+    - Disassembles a stream of code on three threads: nmd_x86_ldisasm() splits the code in instructions, the decoder decodes them and the formatter formats
+      them. The stages run concurrently and are connected by single-producer/single-consumer lock-free ring buffers stored in a memory block provided by the caller.
+      Code is pushed in blocks and the formatted instructions are popped in batches, both functions never block.
+      size_t nmd_x86_pipeline_start(nmd_x86_pipeline* pipeline, NMD_X86_MODE mode, uint32_t decoder_flags, uint32_t format_flags, void* memory, size_t memory_size);
+      size_t nmd_x86_pipeline_push(nmd_x86_pipeline* pipeline, const void* buffer, size_t buffer_size, uint64_t runtime_address);
+      size_t nmd_x86_pipeline_pop(nmd_x86_pipeline* pipeline, nmd_x86_pipeline_line* lines, size_t num_lines);
+      void nmd_x86_pipeline_close(nmd_x86_pipeline* pipeline);
+      bool nmd_x86_pipeline_finished(nmd_x86_pipeline* pipeline);
+      void nmd_x86_pipeline_stop(nmd_x86_pipeline* pipeline);
+
 Enabling and disabling features of the decoder at compile-time:
 To dynamically choose which features are used by the decoder, use the 'flags' parameter of nmd_x86_decode(). The less features specified in the mask, the
 faster the decoder runs. By default all features are available, some can be completely disabled at compile time(thus reducing code size and increasing code speed) by defining
@@ -61,6 +149,14 @@ the following macros:
  - 'NMD_ASSEMBLY_DISABLE_DECODER_VEX': the decoder does not support VEX instructions.
  - 'NMD_ASSEMBLY_DISABLE_DECODER_EVEX': the decoder does not support EVEX instructions.
  - 'NMD_ASSEMBLY_DISABLE_DECODER_3DNOW': the decoder does not support 3DNow! instructions.
+ - 'NMD_ASSEMBLY_DISABLE_DECODER_REGISTERS': the decoder does not fill the 'registers' variable.
+
+These macros apply to every call of the decoder. To use a decoder with fixed mode and features next to the generic one, define a specialized decoder in the
+source file that defines 'NMD_ASSEMBLY_IMPLEMENTATION'(after the include statement). The compiler removes the code of the modes and features that are not used:
+NMD_X86_DEFINE_DECODER(nmd_x86_decode_64_minimal, NMD_X86_MODE_64, NMD_X86_DECODER_FLAGS_MINIMAL)
+NMD_X86_DEFINE_DECODER(nmd_x86_decode_32_full, NMD_X86_MODE_32, NMD_X86_DECODER_FLAGS_ALL)
+Other source files may declare them with 'NMD_X86_DECLARE_DECODER(nmd_x86_decode_64_minimal);'. They're called like nmd_x86_decode() without the last two parameters:
+bool nmd_x86_decode_64_minimal(const void* buffer, size_t buffer_size, nmd_x86_instruction* instruction);
 
 Enabling and disabling features of the formatter at compile-time:
 To dynamically choose which features are used by the formatter, use the 'flags' parameter of nmd_x86_format(). The less features specified in the mask, the
@@ -81,6 +177,11 @@ Use the following macros to disable features at compile-time:
  - 'NMD_ASSEMBLY_DISABLE_LENGTH_DISASSEMBLER_VALIDITY_CHECK': the length disassembler does not check if the instruction is invalid.
  - 'NMD_ASSEMBLY_DISABLE_LENGTH_DISASSEMBLER_VEX': the length disassembler does not support VEX instructions.
  - 'NMD_ASSEMBLY_DISABLE_LENGTH_DISASSEMBLER_3DNOW': the length disassembler does not support 3DNow! instructions.
+ - 'NMD_ASSEMBLY_ENABLE_LENGTH_DISASSEMBLER_SSE2': the length disassembler classifies prefixes using SSE2 intrinsics when at least 16 bytes are available. This macro includes <emmintrin.h>.
+
+Multithreading:
+Threads are not used by default. Define the 'NMD_ASSEMBLY_ENABLE_THREADS' macro to enable nmd_x86_ldisasm_parallel(), nmd_x86_decode_parallel() and the pipeline. This macro includes
+<windows.h> on Windows and <pthread.h> and <sched.h> elsewhere(link with '-pthread'). No memory is allocated, the maximum number of threads is 'NMD_ASSEMBLY_MAX_THREADS'(64 by default).
 
 Fixed width integer types:
 By default the library includes <stdint.h> and <stddef.h> to include int types.
@@ -193,10 +294,30 @@ Contributors(This may not be a complete list):
 #define NMD_X86_FORMATTER_NUM_PADDING_BYTES 10
 #endif /* NMD_X86_FORMATTER_NUM_PADDING_BYTES */
 
+/* The size of the buffer the formatter needs to write any instruction in place(including the null character). */
+#define NMD_X86_FORMATTER_MAX_LENGTH 256
+
 #define NMD_X86_INVALID_RUNTIME_ADDRESS ((uint64_t)(-1))
 #define NMD_X86_MAXIMUM_INSTRUCTION_LENGTH 15
 #define NMD_X86_MAXIMUM_NUM_OPERANDS 10
 
+/* The size of the arena nmd_x86_assemble_block() needs for a block of 'num_lines' lines and 'string_length' characters. */
+#define NMD_X86_ASSEMBLE_BLOCK_ARENA_SIZE(num_lines, string_length) ((num_lines) * 64 + (string_length) + 8)
+
+/* The size of the string stored with each instruction of the decode cache(including the null character). Longer strings are not cached. */
+#ifndef NMD_X86_CACHE_STRING_SIZE
+#define NMD_X86_CACHE_STRING_SIZE 128
+#endif /* NMD_X86_CACHE_STRING_SIZE */
+
+/* The number of entries of each bucket of the decode cache. An instruction may be stored in any entry of the bucket of its runtime address. */
+#define NMD_X86_CACHE_BUCKET_SIZE 4
+
+/* The size of the memory block nmd_x86_cache_init() needs for 'num_entries' entries. */
+#define NMD_X86_CACHE_MEMORY_SIZE(num_entries) ((num_entries) * (sizeof(nmd_x86_cache_key) + sizeof(nmd_x86_cache_entry)) + 8)
+
+/* The size of the memory block nmd_x86_cfg_build() needs in the worst case(every instruction is a block) for a buffer of 'buffer_size' bytes. */
+#define NMD_X86_CFG_MEMORY_SIZE(buffer_size) ((buffer_size) * 28 + 8)
+
 /* Define the api macro to potentially change functions's attributes. */
 #ifndef NMD_ASSEMBLY_API
 #ifdef NMD_ASSEMBLY_PRIVATE
@@ -225,6 +346,7 @@ enum NMD_X86_FORMATTER_FLAGS
 	NMD_X86_FORMAT_FLAGS_SCALE_ONE                 = (1 << 13), /* If set, scale one is displayed. E.g. add byte ptr [eax+eax*1], al. */
 	NMD_X86_FORMAT_FLAGS_BYTES                     = (1 << 14), /* The instruction's bytes are displayed before the instructions. */
 	NMD_X86_FORMAT_FLAGS_ATT_SYNTAX                = (1 << 15), /* AT&T syntax is used instead of Intel's. */
+	NMD_X86_FORMAT_FLAGS_ADDRESS                   = (1 << 16), /* The instruction's runtime address is displayed at the start of the line. Only used by nmd_x86_format_buffer(). */
 
 	/* The formatter's default formatting style. */
 	NMD_X86_FORMAT_FLAGS_DEFAULT  = (NMD_X86_FORMAT_FLAGS_HEX | NMD_X86_FORMAT_FLAGS_H_SUFFIX | NMD_X86_FORMAT_FLAGS_ONLY_SEGMENT_OVERRIDE | NMD_X86_FORMAT_FLAGS_SIGNED_NUMBER_MEMORY_VIEW | NMD_X86_FORMAT_FLAGS_SIGNED_NUMBER_HINT_DEC),
@@ -241,10 +363,16 @@ enum NMD_X86_DECODER_FLAGS
 	NMD_X86_DECODER_FLAGS_EVEX           = (1 << 6), /* The decoder parses EVEX instructions. */
 	NMD_X86_DECODER_FLAGS_3DNOW          = (1 << 7), /* The decoder parses 3DNow! instructions. */
 
+	/* This feature makes every call noticeably slower, so it's opt-in and not part of 'NMD_X86_DECODER_FLAGS_ALL'. */
+	NMD_X86_DECODER_FLAGS_REGISTERS      = (1 << 8), /* The decoder fills the 'registers' variable. The masks are complete if 'NMD_X86_DECODER_FLAGS_INSTRUCTION_ID', 'NMD_X86_DECODER_FLAGS_CPU_FLAGS', 'NMD_X86_DECODER_FLAGS_OPERANDS' and 'NMD_X86_DECODER_FLAGS_GROUP' are also set. */
+
+	/* This is not a feature, so it's not part of 'NMD_X86_DECODER_FLAGS_ALL'. */
+	NMD_X86_DECODER_FLAGS_ZERO_COPY      = (1 << 9), /* The decoder does not copy the instruction's bytes to 'buffer', 'source' points to them instead. The decoded buffer must stay valid while the instruction is used. */
+
 	/* These are not actual features, but rather masks of features. */
 	NMD_X86_DECODER_FLAGS_NONE    = 0,
 	NMD_X86_DECODER_FLAGS_MINIMAL = (NMD_X86_DECODER_FLAGS_VALIDITY_CHECK | NMD_X86_DECODER_FLAGS_VEX | NMD_X86_DECODER_FLAGS_EVEX), /* Mask that specifies minimal features to provide acurate results in any environment. */
-	NMD_X86_DECODER_FLAGS_ALL     = (1 << 8) - 1, /* Mask that specifies all features. */
+	NMD_X86_DECODER_FLAGS_ALL     = (1 << 8) - 1, /* Mask that specifies all features except 'NMD_X86_DECODER_FLAGS_REGISTERS'. */
 };
 
 enum NMD_X86_PREFIXES
@@ -2248,6 +2376,7 @@ typedef struct nmd_x86_memory_operand
 	uint8_t base;        /* The base register. A member of 'NMD_X86_REG'. */
 	uint8_t index;       /* The index register. A member of 'NMD_X86_REG'. */
 	uint8_t scale;       /* Scale(1, 2, 4 or 8). */
+	uint8_t size;        /* The size of the operand in bytes(e.g. 1 for 'byte ptr [eax]'), or zero if unknown. */
 	int64_t disp;        /* Displacement. */
 } nmd_x86_memory_operand;
 
@@ -2366,6 +2495,61 @@ enum NMD_X86_FPU_FLAGS
 	NMD_X86_FPU_FLAGS_C3 = (1 << 14)
 };
 
+/* Bits of the masks of 'nmd_x86_register_use'. Every size of a register(e.g. 'al', 'ah', 'ax', 'eax' and 'rax') has the same bit. */
+enum NMD_X86_REGISTER_USE
+{
+	/* Bits of 'gpr_read' and 'gpr_written'. */
+	NMD_X86_REGISTER_USE_RAX = (1 << 0),
+	NMD_X86_REGISTER_USE_RCX = (1 << 1),
+	NMD_X86_REGISTER_USE_RDX = (1 << 2),
+	NMD_X86_REGISTER_USE_RBX = (1 << 3),
+	NMD_X86_REGISTER_USE_RSP = (1 << 4),
+	NMD_X86_REGISTER_USE_RBP = (1 << 5),
+	NMD_X86_REGISTER_USE_RSI = (1 << 6),
+	NMD_X86_REGISTER_USE_RDI = (1 << 7),
+	NMD_X86_REGISTER_USE_R8  = (1 << 8),
+	NMD_X86_REGISTER_USE_R9  = (1 << 9),
+	NMD_X86_REGISTER_USE_R10 = (1 << 10),
+	NMD_X86_REGISTER_USE_R11 = (1 << 11),
+	NMD_X86_REGISTER_USE_R12 = (1 << 12),
+	NMD_X86_REGISTER_USE_R13 = (1 << 13),
+	NMD_X86_REGISTER_USE_R14 = (1 << 14),
+	NMD_X86_REGISTER_USE_R15 = (1 << 15),
+	NMD_X86_REGISTER_USE_IP  = (1 << 16), /* The instruction pointer(ip, eip or rip). */
+	NMD_X86_REGISTER_USE_ES  = (1 << 17),
+	NMD_X86_REGISTER_USE_CS  = (1 << 18),
+	NMD_X86_REGISTER_USE_SS  = (1 << 19),
+	NMD_X86_REGISTER_USE_DS  = (1 << 20),
+	NMD_X86_REGISTER_USE_FS  = (1 << 21),
+	NMD_X86_REGISTER_USE_GS  = (1 << 22),
+
+	/* Bits of 'other_read' and 'other_written'. 'mmN' is 'NMD_X86_REGISTER_USE_MM0 << N', the same applies to 'kN' and 'st(N)'. */
+	NMD_X86_REGISTER_USE_MM0 = (1 << 0),
+	NMD_X86_REGISTER_USE_K0  = (1 << 8),
+	NMD_X86_REGISTER_USE_ST0 = (1 << 16),
+	NMD_X86_REGISTER_USE_CR  = (1 << 24), /* Any control register. */
+	NMD_X86_REGISTER_USE_DR  = (1 << 25), /* Any debug register. */
+};
+
+/*
+Registers and cpu flags read and written by an instruction, as fixed-width masks that can be combined with bitwise operations(e.g. for liveness or taint analysis).
+Registers read through a memory operand(base, index and segment) are included in the read masks. A write to an 8 or 16-bit general purpose register keeps the
+register's other bits, so the register is also in the read mask. Conditional reads and writes(e.g. 'cmovz') are included as reads and writes.
+For instructions whose operands are not filled by the decoder(e.g. VEX instructions), only the destination register of the ModR/M byte is in the write masks,
+and it's also in the read masks because it's not known if it's read.
+*/
+typedef struct nmd_x86_register_use
+{
+	uint32_t gpr_read;       /* General purpose, instruction pointer and segment registers read by the instruction. A mask of 'NMD_X86_REGISTER_USE_XXX'. */
+	uint32_t gpr_written;    /* General purpose, instruction pointer and segment registers written by the instruction. A mask of 'NMD_X86_REGISTER_USE_XXX'. */
+	uint32_t vector_read;    /* Vector registers read by the instruction. Bit 'N' is xmmN, ymmN or zmmN. */
+	uint32_t vector_written; /* Vector registers written by the instruction. Bit 'N' is xmmN, ymmN or zmmN. */
+	uint32_t other_read;     /* MMX, mask, x87, control and debug registers read by the instruction. A mask of 'NMD_X86_REGISTER_USE_XXX'. */
+	uint32_t other_written;  /* MMX, mask, x87, control and debug registers written by the instruction. A mask of 'NMD_X86_REGISTER_USE_XXX'. */
+	uint32_t flags_read;     /* Cpu flags read by the instruction. A mask of 'NMD_X86_EFLAGS', or 'NMD_X86_FPU_FLAGS' for x87 instructions(like 'tested_flags'). */
+	uint32_t flags_written;  /* Cpu flags written by the instruction(modified, set, cleared or undefined). A mask of 'NMD_X86_EFLAGS', or 'NMD_X86_FPU_FLAGS' for x87 instructions. */
+} nmd_x86_register_use;
+
 typedef struct nmd_x86_instruction
 {
 	bool valid : 1;                                         /* If true, the instruction is valid. */
@@ -2383,7 +2567,7 @@ typedef struct nmd_x86_instruction
 	uint8_t num_prefixes;                                   /* Number of prefixes. */
 	uint8_t num_operands;                                   /* The number of operands. */
 	uint8_t group;                                          /* The instruction's group(e.g. jmp, prvileged...). A member of 'NMD_GROUP'. */
-	uint8_t buffer[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH];     /* A buffer containing the full instruction. */
+	uint8_t buffer[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH];     /* A buffer containing the full instruction. Not filled if 'source' is not null. */
 	nmd_x86_operand operands[NMD_X86_MAXIMUM_NUM_OPERANDS]; /* Operands. */
 	nmd_x86_modrm modrm;                                    /* The Mod/RM byte. Check 'flags.fields.has_modrm'. */
 	nmd_x86_sib sib;                                        /* The SIB byte. Check 'flags.fields.has_sib'. */
@@ -2402,8 +2586,35 @@ typedef struct nmd_x86_instruction
 	uint8_t rex;                                            /* REX prefix. */
 	uint8_t segment_override;                               /* The segment override prefix closest to the opcode. A member of 'NMD_X86_PREFIXES'. */
 	uint16_t simd_prefix;                                   /* One of these prefixes that is the closest to the opcode: NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE, NMD_X86_PREFIXES_LOCK, NMD_X86_PREFIXES_REPEAT_NOT_ZERO, NMD_X86_PREFIXES_REPEAT, or NMD_X86_PREFIXES_NONE. The prefixes are specified as members of the 'NMD_X86_PREFIXES' enum. */
+	nmd_x86_register_use registers;                         /* Registers and cpu flags read and written by the instruction. Check 'NMD_X86_DECODER_FLAGS_REGISTERS'. */
+	const uint8_t* source;                                  /* A pointer to the instruction's bytes in the decoded buffer if 'NMD_X86_DECODER_FLAGS_ZERO_COPY' was set, null otherwise. */
 } nmd_x86_instruction;
 
+enum NMD_X86_LIGHT_FLAGS
+{
+	NMD_X86_LIGHT_FLAGS_MEMORY_OPERAND = (1 << 0), /* The instruction has a ModR/M memory operand described by 'segment', 'base', 'index', 'scale' and 'displacement'. */
+	NMD_X86_LIGHT_FLAGS_BRANCH_TARGET  = (1 << 1), /* The instruction is a relative branch whose target is 'branch_target'. */
+	NMD_X86_LIGHT_FLAGS_LOCK           = (1 << 2), /* The instruction has a lock prefix. */
+	NMD_X86_LIGHT_FLAGS_REPEAT         = (1 << 3), /* The instruction has a repeat(F3h) or repeat not zero(F2h) prefix. */
+};
+
+/* A compact description of an instruction filled by nmd_x86_decode_light(). */
+typedef struct nmd_x86_light_instruction
+{
+	uint64_t branch_target; /* The branch's target. Check 'flags'. Relative to the instruction's address if no runtime address was specified. */
+	int32_t displacement;   /* The memory operand's displacement(sign extended, except 16-bit absolute addresses like '[0xDDFE]'). */
+	uint16_t id;            /* The instruction's identifier. A member of 'NMD_X86_INSTRUCTION'. */
+	uint8_t length;         /* The instruction's length in bytes. */
+	uint8_t opcode;         /* Opcode byte. */
+	uint8_t opcode_map;     /* The instruction's opcode map. A member of 'NMD_X86_OPCODE_MAP'. */
+	uint8_t group;          /* The instruction's group(e.g. jmp, prvileged...). A member of 'NMD_GROUP'. */
+	uint8_t flags;          /* A mask of 'NMD_X86_LIGHT_FLAGS'. */
+	uint8_t segment;        /* The memory operand's segment register. A member of 'NMD_X86_REG'. */
+	uint8_t base;           /* The memory operand's base register(NMD_X86_REG_RIP/NMD_X86_REG_EIP if it's relative to the instruction pointer). A member of 'NMD_X86_REG'. */
+	uint8_t index;          /* The memory operand's index register. A member of 'NMD_X86_REG'. */
+	uint8_t scale;          /* The memory operand's scale(1, 2, 4 or 8, zero if there's no index register). */
+} nmd_x86_light_instruction;
+
 typedef union nmd_x86_register
 {
 	int8_t  h8;
@@ -2420,18 +2631,144 @@ typedef union nmd_x86_register_512
 	uint64_t zmm0[8];
 } nmd_x86_register_512;
 
+/* Specifies why a function that processes a whole buffer(e.g. nmd_x86_decode_buffer()) stopped. */
+enum NMD_X86_BUFFER_STATUS
+{
+	NMD_X86_BUFFER_STATUS_END = 0,     /* Every instruction in the buffer was processed. */
+	NMD_X86_BUFFER_STATUS_INVALID,     /* The bytes at 'offset' do not form a valid instruction(or the buffer ends in the middle of an instruction). */
+	NMD_X86_BUFFER_STATUS_OUTPUT_FULL, /* The output array is full. The instruction at 'offset' was not processed. */
+};
+
+typedef struct nmd_x86_buffer_info
+{
+	size_t offset;            /* The offset in bytes relative to the start of the buffer where the function stopped. */
+	uint64_t runtime_address; /* The runtime address where the function stopped, or 'NMD_X86_INVALID_RUNTIME_ADDRESS' if no runtime address was specified. */
+	uint8_t status;           /* The reason the function stopped. A member of 'NMD_X86_BUFFER_STATUS'. */
+} nmd_x86_buffer_info;
+
+typedef struct nmd_x86_text_line
+{
+	size_t offset; /* The offset of the line's first character relative to the start of the output buffer. */
+	size_t length; /* The number of characters in the line, excluding the new line character. */
+} nmd_x86_text_line;
+
+/* The part of a decode cache entry that is compared on lookups. Keys are stored apart from the entries so a lookup only touches one entry. */
+typedef struct nmd_x86_cache_key
+{
+	uint64_t runtime_address; /* The instruction's runtime address. */
+	uint32_t flags;           /* The decoder flags used to decode the instruction. */
+	uint8_t mode;             /* The instruction's mode. A member of 'NMD_X86_MODE'. */
+	uint8_t length;           /* The instruction's length in bytes, or zero if the entry is empty. */
+} nmd_x86_cache_key;
+
+typedef struct nmd_x86_cache_entry
+{
+	nmd_x86_instruction instruction;         /* The decoded instruction. 'instruction.buffer' is compared with the bytes in memory on every lookup. */
+	uint32_t format_flags;                   /* The flags used to format 'string'. */
+	size_t string_length;                    /* The length of 'string', or zero if the instruction was not formatted yet. */
+	char string[NMD_X86_CACHE_STRING_SIZE];  /* The formatted instruction. */
+} nmd_x86_cache_entry;
+
+/* Properties of a basic block built by nmd_x86_cfg_build(). */
+enum NMD_X86_CFG_BLOCK_FLAGS
+{
+	NMD_X86_CFG_BLOCK_FUNCTION        = (1 << 0), /* The block starts at an entry point or at the target of a call. */
+	NMD_X86_CFG_BLOCK_RETURN          = (1 << 1), /* The block ends with a return. */
+	NMD_X86_CFG_BLOCK_INDIRECT_BRANCH = (1 << 2), /* The block ends with a branch whose target is not known(e.g. 'jmp rax'). */
+	NMD_X86_CFG_BLOCK_EXTERNAL_BRANCH = (1 << 3), /* The block ends with a branch whose target is not an instruction of the buffer. */
+	NMD_X86_CFG_BLOCK_TRUNCATED       = (1 << 4), /* The execution continues after the block, but the next bytes are not a valid instruction or the buffer ends. */
+};
+
+/* The type of an edge between two basic blocks. */
+enum NMD_X86_CFG_EDGE
+{
+	NMD_X86_CFG_EDGE_FALLTHROUGH = 0, /* The target block follows the source block(e.g. the condition of a conditional branch is false). */
+	NMD_X86_CFG_EDGE_BRANCH_TAKEN,    /* The condition of the conditional branch that ends the source block is true. */
+	NMD_X86_CFG_EDGE_JUMP,            /* The unconditional branch that ends the source block. */
+};
+
+/* A control flow graph built by nmd_x86_cfg_build(). Blocks and edges are stored as struct of arrays. Its arrays point to the memory block passed to nmd_x86_cfg_build(). */
+typedef struct nmd_x86_cfg
+{
+	size_t num_blocks;                /* The number of basic blocks. */
+	size_t num_edges;                 /* The number of edges. */
+
+	/* Basic blocks sorted by offset('num_blocks' elements). */
+	uint32_t* block_offset;           /* The offset of the block's first instruction relative to the start of the buffer. */
+	uint32_t* block_size;             /* The block's size in bytes. */
+	uint32_t* block_num_instructions; /* The number of instructions of the block. */
+	uint32_t* block_first_edge;       /* The successors of block 'i' are the edges in the range [block_first_edge[i], block_first_edge[i + 1]). This array has 'num_blocks + 1' elements. */
+	uint8_t* block_flags;             /* A mask of 'NMD_X86_CFG_BLOCK_FLAGS'. */
+
+	/* Edges sorted by source block('num_edges' elements). */
+	uint32_t* edge_target;            /* The index of the target block. */
+	uint8_t* edge_type;               /* The edge's type. A member of 'NMD_X86_CFG_EDGE'. */
+} nmd_x86_cfg;
+
+/* A decode cache. It's initialized by nmd_x86_cache_init() and it does not own any memory. It must not be used by more than one thread at the same time. */
+typedef struct nmd_x86_cache
+{
+	nmd_x86_cache_key* keys;
+	nmd_x86_cache_entry* entries;
+	size_t num_buckets; /* The number of buckets. It's a power of two. */
+	size_t num_hits;    /* The number of lookups that found the instruction. */
+	size_t num_misses;  /* The number of lookups that had to decode the instruction. */
+	uint32_t next_victim;
+} nmd_x86_cache;
+
 /*
 Assembles one or more instructions from a string. Returns the number of bytes written to the buffer on success, zero otherwise. Instructions can be separated using the '\n'(new line) character.
 Parameters:
  - string          [in]         A pointer to a string that represents one or more instructions in assembly language.
  - buffer          [out]        A pointer to a buffer that receives the encoded instructions.
  - buffer_size     [in]         The size of the buffer in bytes.
- - runtime_address [in]         The instruction's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - runtime_address [in]         The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
  - mode            [in]         The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
  - count           [in/out/opt] A pointer to a variable that on input is the maximum number of instructions that can be parsed, and on output the number of instructions parsed. This parameter may be null.
 */
 NMD_ASSEMBLY_API size_t nmd_x86_assemble(const char* string, void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, size_t* count);
 
+/*
+Encodes an instruction from a structured description instead of a string. Returns the number of bytes written to the buffer on success, zero otherwise.
+The description follows the decoder's conventions, so instructions filled by nmd_x86_decode() with 'NMD_X86_DECODER_FLAGS_OPERANDS' can be encoded again:
+ - 'mode' and 'id' select the instruction. Only the explicit operands(the ones whose 'is_implicit' is false) are used, the other variables are ignored
+   except 'prefixes', from which only 'NMD_X86_PREFIXES_LOCK' and 'NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE' are used, 'opcode' and 'opcode_map', which are only used
+   to reject far branches, 'length', see below, and 'has_rex', which makes the registers 'NMD_X86_REG_AH' to 'NMD_X86_REG_BH' mean 'spl', 'bpl', 'sil' and 'dil'
+   like in the decoder. 'ah' to 'bh' can't be used with registers that require a REX prefix.
+ - 16-bit addressing(e.g. '[bx+si]' or a 16-bit displacement) and far pointers('call ptr16:32') can't be encoded.
+ - The operand size is given by the register operands(e.g. 'ax' selects 16-bit operands), or else by the 'size' of the memory operand(a dword if zero).
+ - The immediate of a relative branch(e.g. 'jmp', 'jz' and 'call') is the displacement from the end of the instruction, whose length is 'length'.
+   The shortest encoding that reaches the same target is used and the displacement is adjusted to its length. If 'length' is zero, the displacement is
+   relative to the end of the new encoding instead.
+Supported instructions: instructions without explicit operands known by nmd_x86_assemble(), 'add', 'or', 'adc', 'sbb', 'and', 'sub', 'xor', 'cmp' and 'mov'
+(r/m,reg reg,mem r/m,imm), 'lea', 'inc', 'dec', 'push', 'pop'(reg, segment register, imm), 'jmp', 'call', 'jcc'(rel), 'ret', 'retf'(imm16) and 'int'(imm8).
+Parameters:
+ - instruction [in]  A pointer to a variable of type 'nmd_x86_instruction' that describes the instruction.
+ - buffer      [out] A pointer to a buffer that receives the encoded instruction.
+ - buffer_size [in]  The size of the buffer in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_encode(const nmd_x86_instruction* instruction, void* buffer, size_t buffer_size);
+
+/*
+Assembles a block of instructions separated by the '\n'(new line) character, which may define and refer to labels. Returns the number of bytes written to the buffer on success, zero otherwise.
+ - A label is defined by an identifier followed by ':' at the start of a line, e.g. 'loop:' or 'loop: dec ecx'. Labels are case insensitive and can be referred to before they are defined.
+ - The operand of 'jmp', 'call' and conditional jumps may be a label. The shortest encoding of 'jmp' and conditional jumps is chosen by iterative relaxation: every branch
+   starts with an 8-bit displacement and only the ones whose target is out of range grow, until no branch has to grow.
+ - Empty lines are ignored. The address of each instruction is the runtime address of the block plus its offset, so a number used as the operand of a branch is an address
+   (or, without a runtime address, a displacement relative to the start of the instruction, same as in nmd_x86_assemble()).
+The instructions are assembled directly to the buffer and moved when a branch before them grows, so the buffer must have room for the whole block. The symbol table and the
+per-instruction information are stored in the arena, see 'NMD_X86_ASSEMBLE_BLOCK_ARENA_SIZE'.
+Parameters:
+ - string          [in]  A pointer to a string that represents a block of instructions in assembly language.
+ - buffer          [out] A pointer to a buffer that receives the encoded instructions.
+ - buffer_size     [in]  The size of the buffer in bytes.
+ - runtime_address [in]  The block's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - mode            [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - arena           [in]  A pointer to memory used by the assembler.
+ - arena_size      [in]  The size of the arena in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_assemble_block(const char* string, void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, void* arena, size_t arena_size);
+
 /*
 Decodes an instruction. Returns true if the instruction is valid, false otherwise.
 Parameters:
@@ -2443,16 +2780,182 @@ Parameters:
 */
 NMD_ASSEMBLY_API bool nmd_x86_decode(const void* buffer, size_t buffer_size, nmd_x86_instruction* instruction, NMD_X86_MODE mode, uint32_t flags);
 
+/*
+Decodes consecutive instructions until the end of the buffer, an invalid instruction or the end of the output array is reached. Returns the number of instructions decoded.
+This is faster than calling nmd_x86_decode() in a loop because only the variables selected by 'flags' are cleared: 'buffer' is only filled up to 'length' bytes,
+'operands' is left unspecified if 'NMD_X86_DECODER_FLAGS_OPERANDS' is not set, the cpu flags are left unspecified if 'NMD_X86_DECODER_FLAGS_CPU_FLAGS' is not set
+and 'registers' is left unspecified if 'NMD_X86_DECODER_FLAGS_REGISTERS' is not set.
+With 'NMD_X86_DECODER_FLAGS_ZERO_COPY' the bytes are not copied at all, which suits buffers that outlive the instructions(e.g. memory-mapped files).
+Parameters:
+ - buffer           [in]      A pointer to a buffer containing encoded instructions.
+ - buffer_size      [in]      The buffer's size in bytes.
+ - runtime_address  [in]      The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - mode             [in]      The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags            [in]      A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use. If uncertain, use 'NMD_X86_DECODER_FLAGS_MINIMAL'.
+ - instructions     [out]     A pointer to an array of 'nmd_x86_instruction' that receives the decoded instructions.
+ - num_instructions [in]      The number of elements in 'instructions'.
+ - info             [out/opt] A pointer to a variable of type 'nmd_x86_buffer_info' that receives where and why the function stopped. This parameter may be null.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_decode_buffer(const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags, nmd_x86_instruction* instructions, size_t num_instructions, nmd_x86_buffer_info* info);
+
+/*
+Defines a decoder named 'name' whose mode and flags are constants, so the compiler removes the code of the modes and features that are not used.
+The decoder has the same parameters as nmd_x86_decode() except 'mode' and 'flags'. Like nmd_x86_decode_buffer(), it only clears the variables
+of 'instruction' required by 'flags'. This macro must be used in the source file that defines 'NMD_ASSEMBLY_IMPLEMENTATION', after the include statement.
+Example: NMD_X86_DEFINE_DECODER(nmd_x86_decode_64_minimal, NMD_X86_MODE_64, NMD_X86_DECODER_FLAGS_MINIMAL)
+*/
+#define NMD_X86_DEFINE_DECODER(name, mode, flags) \
+	NMD_ASSEMBLY_API bool name(const void* buffer, size_t buffer_size, nmd_x86_instruction* instruction) \
+	{ \
+		_nmd_clear_instruction(instruction, (flags)); \
+		return _nmd_decode_instruction_inline(buffer, buffer_size > NMD_X86_MAXIMUM_INSTRUCTION_LENGTH ? NMD_X86_MAXIMUM_INSTRUCTION_LENGTH : buffer_size, instruction, (mode), (flags)); \
+	}
+
+/* Declares a decoder defined by NMD_X86_DEFINE_DECODER(). */
+#define NMD_X86_DECLARE_DECODER(name) NMD_ASSEMBLY_API bool name(const void* buffer, size_t buffer_size, nmd_x86_instruction* instruction)
+
+/*
+Decodes an instruction into a compact record. Returns true if the instruction is valid, false otherwise.
+Most instructions are decoded using precomputed opcode tables, the rest(e.g. SSE, VEX and FPU instructions) are decoded by nmd_x86_decode().
+Both paths give the same results with the same flags.
+Parameters:
+ - buffer          [in]  A pointer to a buffer containing an encoded instruction.
+ - buffer_size     [in]  The buffer's size in bytes.
+ - runtime_address [in]  The instruction's runtime address used to compute 'branch_target'. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - instruction     [out] A pointer to a variable of type 'nmd_x86_light_instruction' that receives information about the instruction.
+ - mode            [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags           [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use. 'NMD_X86_DECODER_FLAGS_OPERANDS', 'NMD_X86_DECODER_FLAGS_CPU_FLAGS' and 'NMD_X86_DECODER_FLAGS_REGISTERS' are ignored.
+*/
+NMD_ASSEMBLY_API bool nmd_x86_decode_light(const void* buffer, size_t buffer_size, uint64_t runtime_address, nmd_x86_light_instruction* instruction, NMD_X86_MODE mode, uint32_t flags);
+
+/*
+Same as nmd_x86_decode_buffer(), but the instructions are decoded by nmd_x86_decode_light(). Returns the number of instructions decoded.
+Parameters:
+ - buffer           [in]      A pointer to a buffer containing encoded instructions.
+ - buffer_size      [in]      The buffer's size in bytes.
+ - runtime_address  [in]      The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - mode             [in]      The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags            [in]      A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+ - instructions     [out]     A pointer to an array of 'nmd_x86_light_instruction' that receives the decoded instructions.
+ - num_instructions [in]      The number of elements in 'instructions'.
+ - info             [out/opt] A pointer to a variable of type 'nmd_x86_buffer_info' that receives where and why the function stopped. This parameter may be null.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_decode_buffer_light(const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags, nmd_x86_light_instruction* instructions, size_t num_instructions, nmd_x86_buffer_info* info);
+
+/*
+Computes the registers and cpu flags read and written by an instruction. This is the function used by the decoder to fill the 'registers' variable
+if 'NMD_X86_DECODER_FLAGS_REGISTERS' is set. The masks are complete if the instruction was decoded with 'NMD_X86_DECODER_FLAGS_INSTRUCTION_ID',
+'NMD_X86_DECODER_FLAGS_CPU_FLAGS', 'NMD_X86_DECODER_FLAGS_OPERANDS' and 'NMD_X86_DECODER_FLAGS_GROUP'.
+Parameters:
+ - instruction [in]  A pointer to a variable of type 'nmd_x86_instruction' describing the instruction.
+ - registers   [out] A pointer to a variable of type 'nmd_x86_register_use' that receives the masks.
+*/
+NMD_ASSEMBLY_API void nmd_x86_get_register_use(const nmd_x86_instruction* instruction, nmd_x86_register_use* registers);
+
 /*
 Formats an instruction. This function may cause a crash if you modify 'instruction' manually.
 Parameters:
  - instruction     [in]  A pointer to a variable of type 'nmd_x86_instruction' describing the instruction to be formatted.
- - buffer          [out] A pointer to buffer that receives the string. The buffer's recommended size is 128 bytes.
+ - buffer          [out] A pointer to buffer that receives the string. It should have at least 'NMD_X86_FORMATTER_MAX_LENGTH' bytes.
  - runtime_address [in]  The instruction's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
  - flags           [in]  A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the function should format the instruction. If uncertain, use 'NMD_X86_FORMAT_FLAGS_DEFAULT'.
 */
 NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, char* buffer, uint64_t runtime_address, uint32_t flags);
 
+/*
+Formats an instruction. Returns the length of the string(excluding the null character), or zero if the instruction is invalid or 'buffer_size' is too small.
+Parameters:
+ - instruction     [in]  A pointer to a variable of type 'nmd_x86_instruction' describing the instruction to be formatted.
+ - buffer          [out] A pointer to buffer that receives the string.
+ - buffer_size     [in]  The buffer's size in bytes. If it's smaller than 'NMD_X86_FORMATTER_MAX_LENGTH' the string is formatted in a temporary buffer and then copied.
+ - runtime_address [in]  The instruction's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - flags           [in]  A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the function should format the instruction. If uncertain, use 'NMD_X86_FORMAT_FLAGS_DEFAULT'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_format_ex(const nmd_x86_instruction* instruction, char* buffer, size_t buffer_size, uint64_t runtime_address, uint32_t flags);
+
+/*
+Formats consecutive instructions into a single buffer, one line per instruction. Lines are separated by the '\n'(new line) character. Returns the number of instructions formatted.
+The function stops at the first invalid instruction or when the next line does not fit in the buffer. The text is null-terminated if there's room for the null character.
+Parameters:
+ - instructions     [in]      A pointer to an array of 'nmd_x86_instruction', usually filled by nmd_x86_decode_buffer().
+ - num_instructions [in]      The number of instructions in the array.
+ - runtime_address  [in]      The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - flags            [in]      A mask of 'NMD_X86_FORMAT_FLAGS_XXX'. If 'NMD_X86_FORMAT_FLAGS_ADDRESS' is set, each line starts with the instruction's runtime address.
+ - buffer           [out]     A pointer to a buffer that receives the lines.
+ - buffer_size      [in]      The buffer's size in bytes.
+ - lines            [out/opt] A pointer to an array of 'nmd_x86_text_line' with at least 'num_instructions' elements that receives the position of each line in 'buffer'. This parameter may be null.
+ - text_length      [out/opt] A pointer to a variable that receives the number of characters written to 'buffer'(excluding the null character). This parameter may be null.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_format_buffer(const nmd_x86_instruction* instructions, size_t num_instructions, uint64_t runtime_address, uint32_t flags, char* buffer, size_t buffer_size, nmd_x86_text_line* lines, size_t* text_length);
+
+/*
+Initializes a decode cache in a memory block provided by the caller. Returns the number of entries of the cache, or zero if the block is too small for one bucket.
+The number of entries is the largest power of two times 'NMD_X86_CACHE_BUCKET_SIZE' that fits in the block. Use 'NMD_X86_CACHE_MEMORY_SIZE()' to compute the block's size.
+Parameters:
+ - cache       [out] A pointer to a variable of type 'nmd_x86_cache'.
+ - memory      [in]  A pointer to the memory block. It must stay valid while the cache is used.
+ - memory_size [in]  The size of the memory block in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_cache_init(nmd_x86_cache* cache, void* memory, size_t memory_size);
+
+/*
+Same as nmd_x86_decode(), but the instruction is looked up in the cache first. Returns a pointer to the decoded instruction, or a null pointer if the instruction is invalid.
+Instructions are looked up by runtime address, mode and flags, and the cached instruction's bytes are compared with the bytes in 'buffer', so an instruction that
+was modified is decoded again even if it was not invalidated. The pointer is valid until the next call that modifies the cache.
+Parameters:
+ - cache           [in/out] A pointer to a cache initialized by nmd_x86_cache_init().
+ - buffer          [in]     A pointer to a buffer containing an encoded instruction.
+ - buffer_size     [in]     The buffer's size in bytes.
+ - runtime_address [in]     The instruction's runtime address. This is the key of the cache, so 'NMD_X86_INVALID_RUNTIME_ADDRESS' only caches a few instructions.
+ - mode            [in]     The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags           [in]     A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+*/
+NMD_ASSEMBLY_API const nmd_x86_instruction* nmd_x86_cache_decode(nmd_x86_cache* cache, const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags);
+
+/*
+Same as nmd_x86_cache_decode(), but returns the formatted instruction, which is also cached. Returns a null pointer if the instruction is invalid or its string
+does not fit in 'NMD_X86_CACHE_STRING_SIZE' bytes. The pointer is valid until the next call that modifies the cache.
+Parameters:
+ - cache           [in/out] A pointer to a cache initialized by nmd_x86_cache_init().
+ - buffer          [in]     A pointer to a buffer containing an encoded instruction.
+ - buffer_size     [in]     The buffer's size in bytes.
+ - runtime_address [in]     The instruction's runtime address.
+ - mode            [in]     The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - decoder_flags   [in]     A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+ - format_flags    [in]     A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the instruction is formatted.
+*/
+NMD_ASSEMBLY_API const char* nmd_x86_cache_format(nmd_x86_cache* cache, const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t decoder_flags, uint32_t format_flags);
+
+/*
+Removes every cached instruction that overlaps a range of memory(e.g. after the code was patched). Returns the number of instructions removed.
+Parameters:
+ - cache           [in/out] A pointer to a cache initialized by nmd_x86_cache_init().
+ - runtime_address [in]     The runtime address of the range's first byte.
+ - size            [in]     The range's size in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_cache_invalidate(nmd_x86_cache* cache, uint64_t runtime_address, size_t size);
+
+/* Removes every cached instruction and resets the cache's counters. */
+NMD_ASSEMBLY_API void nmd_x86_cache_clear(nmd_x86_cache* cache);
+
+/*
+Builds the control flow graph of the code reachable from one or more entry points. Returns the number of basic blocks, or zero if 'memory_size' is too small,
+'buffer_size' is not less than 4GiB or no entry point is in the buffer.
+Instructions are decoded recursively: conditional branches continue at both successors, unconditional branches at their target and returns, indirect branches
+and invalid instructions end the path. Targets of calls are traced as well(the block they start has the 'NMD_X86_CFG_BLOCK_FUNCTION' flag), but calls do not end blocks.
+Parameters:
+ - buffer           [in]  A pointer to a buffer containing encoded instructions.
+ - buffer_size      [in]  The buffer's size in bytes.
+ - runtime_address  [in]  The runtime address of the buffer's first byte. If it's 'NMD_X86_INVALID_RUNTIME_ADDRESS', offsets are used as runtime addresses.
+ - mode             [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - entry_points     [in]  A pointer to an array of runtime addresses where the code starts. Addresses outside the buffer are ignored.
+ - num_entry_points [in]  The number of elements in 'entry_points'.
+ - cfg              [out] A pointer to a variable of type 'nmd_x86_cfg' that receives the graph. Its arrays point to 'memory'.
+ - memory           [in]  A pointer to a memory block used by the function and to store the graph. 'NMD_X86_CFG_MEMORY_SIZE(buffer_size)' bytes are always enough.
+ - memory_size      [in]  The size of the memory block in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_cfg_build(const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, const uint64_t* entry_points, size_t num_entry_points, nmd_x86_cfg* cfg, void* memory, size_t memory_size);
+
 /*
 Returns the instruction's length if it's valid, zero otherwise.
 Parameters:
@@ -2462,4 +2965,120 @@ Parameters:
 */
 NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* buffer, size_t buffer_size, NMD_X86_MODE mode);
 
+/*
+Computes the length of consecutive instructions until the end of the buffer, an invalid instruction or the end of the output array is reached. Returns the number of lengths written to 'lengths'.
+Parameters:
+ - buffer      [in]      A pointer to a buffer containing encoded instructions.
+ - buffer_size [in]      The buffer's size in bytes.
+ - mode        [in]      The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - lengths     [out]     A pointer to an array that receives the length of each instruction.
+ - num_lengths [in]      The number of elements in 'lengths'.
+ - info        [out/opt] A pointer to a variable of type 'nmd_x86_buffer_info' that receives where and why the function stopped. This parameter may be null.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_ldisasm_buffer(const void* buffer, size_t buffer_size, NMD_X86_MODE mode, uint8_t* lengths, size_t num_lengths, nmd_x86_buffer_info* info);
+
+#ifdef NMD_ASSEMBLY_ENABLE_THREADS
+
+#ifndef NMD_ASSEMBLY_MAX_THREADS
+#define NMD_ASSEMBLY_MAX_THREADS 64
+#endif /* NMD_ASSEMBLY_MAX_THREADS */
+
+/*
+Computes the instruction boundaries of a buffer using multiple threads. The result is the same as a linear sweep that starts at the first byte and skips invalid instructions one byte at a time.
+Returns the number of valid instructions.
+Parameters:
+ - buffer      [in]  A pointer to a buffer containing encoded instructions.
+ - buffer_size [in]  The buffer's size in bytes.
+ - mode        [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - lengths     [out] A pointer to an array of 'buffer_size' elements. 'lengths[i]' receives the length of the instruction at offset 'i' if one starts there, zero otherwise.
+ - num_threads [in]  The number of threads to use, including the calling thread. It's clamped to 'NMD_ASSEMBLY_MAX_THREADS'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_ldisasm_parallel(const void* buffer, size_t buffer_size, NMD_X86_MODE mode, uint8_t* lengths, size_t num_threads);
+
+/*
+Decodes every instruction of a buffer using multiple threads. The instructions are written in address order. Returns the number of valid instructions, which may be greater than 'num_instructions'.
+Parameters:
+ - buffer           [in]  A pointer to a buffer containing encoded instructions.
+ - buffer_size      [in]  The buffer's size in bytes.
+ - mode             [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags            [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+ - lengths          [out] A pointer to an array of 'buffer_size' elements that receives the instruction boundaries. See nmd_x86_ldisasm_parallel().
+ - instructions     [out] A pointer to an array of 'nmd_x86_instruction' that receives the decoded instructions.
+ - num_instructions [in]  The number of elements in 'instructions'.
+ - num_threads      [in]  The number of threads to use, including the calling thread. It's clamped to 'NMD_ASSEMBLY_MAX_THREADS'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_decode_parallel(const void* buffer, size_t buffer_size, NMD_X86_MODE mode, uint32_t flags, uint8_t* lengths, nmd_x86_instruction* instructions, size_t num_instructions, size_t num_threads);
+
+/* The maximum number of bytes of a block of code queued by nmd_x86_pipeline_push(). Larger buffers are split in several blocks. It must be a multiple of eight. */
+#ifndef NMD_X86_PIPELINE_BLOCK_SIZE
+#define NMD_X86_PIPELINE_BLOCK_SIZE 256
+#endif /* NMD_X86_PIPELINE_BLOCK_SIZE */
+
+/* The number of bytes reserved for the pipeline's private state in the memory block. */
+#define NMD_X86_PIPELINE_STATE_SIZE 1024
+
+/* The size in bytes of a memory block for a pipeline whose rings hold 'capacity' items each('capacity' should be a power of two). */
+#define NMD_X86_PIPELINE_MEMORY_SIZE(capacity) ((capacity) * (NMD_X86_PIPELINE_BLOCK_SIZE + 16 + 24 + 8 + sizeof(nmd_x86_instruction) + sizeof(nmd_x86_pipeline_line)) + NMD_X86_PIPELINE_STATE_SIZE)
+
+typedef struct nmd_x86_pipeline_line
+{
+	uint64_t runtime_address;                   /* The instruction's runtime address. */
+	size_t length;                              /* The string's length in bytes, excluding the null terminator. */
+	char string[NMD_X86_FORMATTER_MAX_LENGTH]; /* The formatted instruction. */
+} nmd_x86_pipeline_line;
+
+typedef struct nmd_x86_pipeline
+{
+	void* state;     /* The pipeline's private state, stored in the memory block. */
+	size_t capacity; /* The number of items each ring holds. */
+} nmd_x86_pipeline;
+
+/*
+Starts a pipeline that splits blocks of code in instructions, decodes them and formats them on three threads(one per stage). The stages are connected by
+single-producer/single-consumer lock-free ring buffers stored in a memory block provided by the caller, no memory is allocated.
+Returns the capacity of each ring in items(a power of two), or zero if the block is too small for rings of 16 items or a thread can't be created.
+Use 'NMD_X86_PIPELINE_MEMORY_SIZE()' to compute the block's size. Idle stages yield their time slice, call nmd_x86_pipeline_stop() when the pipeline is not needed anymore.
+Parameters:
+ - pipeline      [out] A pointer to a variable of type 'nmd_x86_pipeline'.
+ - mode          [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - decoder_flags [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+ - format_flags  [in]  A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the instructions are formatted.
+ - memory        [in]  A pointer to the memory block. It must stay valid until nmd_x86_pipeline_stop() returns.
+ - memory_size   [in]  The size of the memory block in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_pipeline_start(nmd_x86_pipeline* pipeline, NMD_X86_MODE mode, uint32_t decoder_flags, uint32_t format_flags, void* memory, size_t memory_size);
+
+/*
+Queues a block of code. Returns the number of bytes queued, which is less than 'buffer_size' if the input ring is full. The bytes are copied, so 'buffer'
+can be reused after the call. Blocks whose runtime addresses are contiguous form a single instruction stream, so an instruction may be split between them.
+This function must not be called by more than one thread at a time.
+Parameters:
+ - pipeline        [in] A pointer to a pipeline started by nmd_x86_pipeline_start().
+ - buffer          [in] A pointer to a buffer containing encoded instructions.
+ - buffer_size     [in] The buffer's size in bytes.
+ - runtime_address [in] The runtime address of the buffer's first byte. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_pipeline_push(nmd_x86_pipeline* pipeline, const void* buffer, size_t buffer_size, uint64_t runtime_address);
+
+/*
+Copies up to 'num_lines' formatted instructions to 'lines' in the order they were pushed. Returns the number of lines copied, which is zero if no line is ready.
+Invalid instructions are skipped one byte at a time, so they produce no lines. This function must not be called by more than one thread at a time.
+Parameters:
+ - pipeline  [in]  A pointer to a pipeline started by nmd_x86_pipeline_start().
+ - lines     [out] A pointer to an array of 'nmd_x86_pipeline_line' that receives the lines.
+ - num_lines [in]  The number of elements in 'lines'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_pipeline_pop(nmd_x86_pipeline* pipeline, nmd_x86_pipeline_line* lines, size_t num_lines);
+
+/* Marks the end of the input. The stages process the queued bytes and exit, nmd_x86_pipeline_finished() returns true after the last line was popped. */
+NMD_ASSEMBLY_API void nmd_x86_pipeline_close(nmd_x86_pipeline* pipeline);
+
+/* Returns true if the pipeline was closed, every stage exited and every line was popped. */
+NMD_ASSEMBLY_API bool nmd_x86_pipeline_finished(nmd_x86_pipeline* pipeline);
+
+/* Stops the pipeline and waits for its threads to exit. The queued bytes and lines that were not popped are discarded. The memory block can be reused after the call. */
+NMD_ASSEMBLY_API void nmd_x86_pipeline_stop(nmd_x86_pipeline* pipeline);
+
+#endif /* NMD_ASSEMBLY_ENABLE_THREADS */
+
 #endif /* NMD_ASSEMBLY_H */
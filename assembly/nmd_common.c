@@ -1,5 +1,18 @@
 #include "nmd_common.h"
 
+#ifdef NMD_ASSEMBLY_ENABLE_LENGTH_DISASSEMBLER_SSE2
+#include <emmintrin.h>
+#endif /* NMD_ASSEMBLY_ENABLE_LENGTH_DISASSEMBLER_SSE2 */
+
+#ifdef NMD_ASSEMBLY_ENABLE_THREADS
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif /* _WIN32 */
+#endif /* NMD_ASSEMBLY_ENABLE_THREADS */
+
 /* Four high-order bits of an opcode to index a row of the opcode table */
 #define _NMD_R(b) ((b) >> 4)
 
@@ -8,6 +21,19 @@
 
 #define _NMD_NUM_ELEMENTS(arr) (sizeof(arr) / sizeof((arr)[0]))
 
+#define _NMD_OFFSETOF(type, member) ((size_t)&(((type*)0)->member))
+
+/* Marks a function that must be inlined in every caller(e.g. so constant arguments remove dead branches). */
+#ifndef _NMD_FORCE_INLINE
+#if defined(_MSC_VER)
+#define _NMD_FORCE_INLINE static __forceinline
+#elif defined(__GNUC__) || defined(__clang__)
+#define _NMD_FORCE_INLINE static __inline__ __attribute__((always_inline))
+#else
+#define _NMD_FORCE_INLINE static
+#endif
+#endif /* _NMD_FORCE_INLINE */
+
 #ifndef _NMD_IS_UPPERCASE
 #define _NMD_IS_UPPERCASE(c) ((c) >= 'A' && (c) <= 'Z')
 #define _NMD_IS_LOWERCASE(c) ((c) >= 'a' && (c) <= 'z')
@@ -30,6 +56,55 @@
 /* Make sure we can read a byte, read a byte, increment the buffer and decrement the buffer's size */
 #define _NMD_READ_BYTE(buffer_, buffer_size_, var_) { if ((buffer_size_) < sizeof(uint8_t)) { return false; } var_ = *((uint8_t*)(buffer_)); buffer_ = ((uint8_t*)(buffer_)) + sizeof(uint8_t); (buffer_size_) -= sizeof(uint8_t); }
 
+/* Immediate size of an opcode. Stored in the low-order bits of '_nmd_x86_opcode_info.flags'. */
+enum _NMD_X86_OPCODE_IMM
+{
+	_NMD_X86_OPCODE_IMM_NONE = 0,
+	_NMD_X86_OPCODE_IMM8,
+	_NMD_X86_OPCODE_IMM16,
+	_NMD_X86_OPCODE_IMM24,     /* imm16 + imm8(enter). */
+	_NMD_X86_OPCODE_IMM32,
+	_NMD_X86_OPCODE_IMMZ,      /* imm16 or imm32 depending on the operand size. */
+	_NMD_X86_OPCODE_IMMV,      /* imm16, imm32 or imm64 depending on the operand size and REX.W(mov r,imm). */
+	_NMD_X86_OPCODE_IMM_MOFFS, /* moffs16, moffs32 or moffs64 depending on the address size. */
+	_NMD_X86_OPCODE_IMM_FAR,   /* ptr16:16 or ptr16:32. */
+};
+
+enum _NMD_X86_OPCODE_FLAGS
+{
+	_NMD_X86_OPCODE_IMM_MASK    = 0x0f,       /* Mask of a member of '_NMD_X86_OPCODE_IMM'. */
+	_NMD_X86_OPCODE_MODRM       = (1 << 4),   /* The opcode has a ModR/M byte. */
+	_NMD_X86_OPCODE_INVALID_REG = (1 << 5),   /* The opcode is invalid if ModR/M.mod is 0b11. */
+	_NMD_X86_OPCODE_INVALID_MEM = (1 << 6),   /* The opcode is invalid if ModR/M.mod is not 0b11. */
+	_NMD_X86_OPCODE_EXTENSION   = (1 << 7),   /* The properties depend on ModR/M.reg. 'id' is the index of a row in '_nmd_x86_opcode_extensions'. */
+
+	/* The properties cannot be described by the tables(e.g. they depend on prefixes), the full decoder must be used instead. */
+	_NMD_X86_OPCODE_FALLBACK    = (_NMD_X86_OPCODE_INVALID_REG | _NMD_X86_OPCODE_INVALID_MEM)
+};
+
+/* Properties of an opcode used by the table-driven decoder. The tables are generated by 'generate_opcode_tables.c'. */
+typedef struct _nmd_x86_opcode_info
+{
+	uint16_t id;   /* The instruction's id. A member of 'NMD_X86_INSTRUCTION'. */
+	uint8_t group; /* The instruction's group. A member of 'NMD_GROUP'. */
+	uint8_t flags; /* A mask of '_NMD_X86_OPCODE_FLAGS'. */
+} _nmd_x86_opcode_info;
+
+/* Classes of a prefix byte used by the table-driven length disassembler. See '_nmd_x86_prefix_classes'. */
+enum _NMD_X86_PREFIX_CLASS
+{
+	_NMD_X86_PREFIX_CLASS_LEGACY       = (1 << 0), /* A legacy prefix. */
+	_NMD_X86_PREFIX_CLASS_OPERAND_SIZE = (1 << 1), /* 0x66 */
+	_NMD_X86_PREFIX_CLASS_ADDRESS_SIZE = (1 << 2), /* 0x67 */
+	_NMD_X86_PREFIX_CLASS_LOCK         = (1 << 3), /* 0xF0 */
+	_NMD_X86_PREFIX_CLASS_REX          = (1 << 4), /* A REX prefix. Only a prefix in 64-bit mode. */
+	_NMD_X86_PREFIX_CLASS_REX_W        = (1 << 5)  /* A REX prefix with the W bit set. */
+};
+
+/* The number of bits of a hash used to index the assembler's perfect hash tables('_nmd_x86_asm_mnemonic_hash_table' and '_nmd_x86_asm_reg_hash_table'). */
+#define _NMD_X86_ASM_MNEMONIC_HASH_BITS 9
+#define _NMD_X86_ASM_REG_HASH_BITS 8
+
 NMD_ASSEMBLY_API const char* const _nmd_reg8[] = { "al", "cl", "dl", "bl", "ah", "ch", "dh", "bh" };
 NMD_ASSEMBLY_API const char* const _nmd_reg8_x64[] = { "al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil" };
 NMD_ASSEMBLY_API const char* const _nmd_reg16[] = { "ax", "cx", "dx", "bx", "sp", "bp", "si", "di" };
@@ -43,6 +118,10 @@ NMD_ASSEMBLY_API const char* const _nmd_segment_reg[] = { "es", "cs", "ss", "ds"
 
 NMD_ASSEMBLY_API const char* const _nmd_condition_suffixes[] = { "o", "no", "b", "nb", "z", "nz", "be", "a", "s", "ns", "p", "np", "l", "ge", "le", "g" };
 
+NMD_ASSEMBLY_API const char _nmd_hex_digits[2][16] = { { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' }, { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' } };
+NMD_ASSEMBLY_API const char _nmd_decimal_digit_pairs[] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+NMD_ASSEMBLY_API const uint64_t _nmd_powers_of_ten[19] = { 0xA, 0x64, 0x3E8, 0x2710, 0x186A0, 0xF4240, 0x989680, 0x5F5E100, 0x3B9ACA00, 0x2540BE400, 0x174876E800, 0xE8D4A51000, 0x9184E72A000, 0x5AF3107A4000, 0x38D7EA4C68000, 0x2386F26FC10000, 0x16345785D8A0000, 0xDE0B6B3A7640000, 0x8AC7230489E80000 }; /* 10^1 to 10^19 */
+
 NMD_ASSEMBLY_API const char* const _nmd_op1_opcode_map_mnemonics[] = { "add", "adc", "and", "xor", "or", "sbb", "sub", "cmp" };
 NMD_ASSEMBLY_API const char* const _nmd_opcode_extensions_grp1[] = { "add", "or", "adc", "sbb", "and", "sub", "xor", "cmp" };
 NMD_ASSEMBLY_API const char* const _nmd_opcode_extensions_grp2[] = { "rol", "ror", "rcl", "rcr", "shl", "shr", "shl", "sar" };
@@ -229,6 +308,49 @@ NMD_ASSEMBLY_API size_t _nmd_get_bit_index(uint32_t mask)
 	return i;
 }
 
+/* Sign-extends the first 'size' bytes of 'value'. */
+NMD_ASSEMBLY_API int64_t _nmd_sign_extend(uint64_t value, size_t size)
+{
+	switch (size)
+	{
+	case 1:  return (int8_t)value;
+	case 2:  return (int16_t)value;
+	case 4:  return (int32_t)value;
+	default: return (int64_t)value;
+	}
+}
+
+/* Returns the general-purpose register selected when a REX prefix extends 'reg'(e.g. 'r9d' for 'ecx'). Other registers are returned unchanged. */
+NMD_ASSEMBLY_API uint8_t _nmd_extend_gpr(uint8_t reg)
+{
+	if (reg >= NMD_X86_REG_AL && reg <= NMD_X86_REG_BH)
+		return (uint8_t)(NMD_X86_REG_R8B + reg % 8);
+	else if (reg >= NMD_X86_REG_AX && reg <= NMD_X86_REG_DI)
+		return (uint8_t)(NMD_X86_REG_R8W + reg % 8);
+	else if (reg >= NMD_X86_REG_EAX && reg <= NMD_X86_REG_EDI)
+		return (uint8_t)(NMD_X86_REG_R8D + reg % 8);
+	else if (reg >= NMD_X86_REG_RAX && reg <= NMD_X86_REG_RDI)
+		return (uint8_t)(NMD_X86_REG_R8 + reg % 8);
+	return reg;
+}
+
+/* Returns the size in bytes of an immediate of type 'imm'(a member of '_NMD_X86_OPCODE_IMM'). */
+NMD_ASSEMBLY_API size_t _nmd_x86_get_imm_size(uint8_t imm, NMD_X86_MODE mode, bool operand_size_prefix, bool address_size_prefix, bool rex_w_prefix)
+{
+	switch (imm)
+	{
+	case _NMD_X86_OPCODE_IMM8:      return 1;
+	case _NMD_X86_OPCODE_IMM16:     return 2;
+	case _NMD_X86_OPCODE_IMM24:     return 3;
+	case _NMD_X86_OPCODE_IMM32:     return 4;
+	case _NMD_X86_OPCODE_IMMZ:      return (mode == NMD_X86_MODE_16) == operand_size_prefix ? 4 : 2;
+	case _NMD_X86_OPCODE_IMMV:      return rex_w_prefix ? 8 : (operand_size_prefix || mode == NMD_X86_MODE_16 ? 2 : 4);
+	case _NMD_X86_OPCODE_IMM_MOFFS: return mode == NMD_X86_MODE_64 ? (address_size_prefix ? 4 : 8) : (address_size_prefix ? 2 : 4);
+	case _NMD_X86_OPCODE_IMM_FAR:   return operand_size_prefix ? 4 : 6;
+	default:                        return 0;
+	}
+}
+
 NMD_ASSEMBLY_API size_t _nmd_assembly_get_num_digits_hex(uint64_t n)
 {
 	if (n == 0)
@@ -11,6 +11,19 @@
 
 #define _NMD_NUM_ELEMENTS(arr) (sizeof(arr) / sizeof((arr)[0]))
 
+#define _NMD_OFFSETOF(type, member) ((size_t)&(((type*)0)->member))
+
+/* Marks a function that must be inlined in every caller(e.g. so constant arguments remove dead branches). */
+#ifndef _NMD_FORCE_INLINE
+#if defined(_MSC_VER)
+#define _NMD_FORCE_INLINE static __forceinline
+#elif defined(__GNUC__) || defined(__clang__)
+#define _NMD_FORCE_INLINE static __inline__ __attribute__((always_inline))
+#else
+#define _NMD_FORCE_INLINE static
+#endif
+#endif /* _NMD_FORCE_INLINE */
+
 #define _NMD_IS_UPPERCASE(c) (c >= 'A' && c <= 'Z')
 #define _NMD_IS_LOWERCASE(c) (c >= 'a' && c <= 'z')
 #define _NMD_TOLOWER(c) (_NMD_IS_UPPERCASE(c) ? c + 0x20 : c)
@@ -31,6 +44,55 @@
 /* Make sure we can read a byte, read a byte, increment the buffer and decrement the buffer's size */
 #define _NMD_READ_BYTE(buffer_, buffer_size_, var_) { if ((buffer_size_) < sizeof(uint8_t)) { return false; } var_ = *((uint8_t*)(buffer_)); buffer_ = ((uint8_t*)(buffer_)) + sizeof(uint8_t); (buffer_size_) -= sizeof(uint8_t); }
 
+/* Immediate size of an opcode. Stored in the low-order bits of '_nmd_x86_opcode_info.flags'. */
+enum _NMD_X86_OPCODE_IMM
+{
+	_NMD_X86_OPCODE_IMM_NONE = 0,
+	_NMD_X86_OPCODE_IMM8,
+	_NMD_X86_OPCODE_IMM16,
+	_NMD_X86_OPCODE_IMM24,     /* imm16 + imm8(enter). */
+	_NMD_X86_OPCODE_IMM32,
+	_NMD_X86_OPCODE_IMMZ,      /* imm16 or imm32 depending on the operand size. */
+	_NMD_X86_OPCODE_IMMV,      /* imm16, imm32 or imm64 depending on the operand size and REX.W(mov r,imm). */
+	_NMD_X86_OPCODE_IMM_MOFFS, /* moffs16, moffs32 or moffs64 depending on the address size. */
+	_NMD_X86_OPCODE_IMM_FAR,   /* ptr16:16 or ptr16:32. */
+};
+
+enum _NMD_X86_OPCODE_FLAGS
+{
+	_NMD_X86_OPCODE_IMM_MASK    = 0x0f,       /* Mask of a member of '_NMD_X86_OPCODE_IMM'. */
+	_NMD_X86_OPCODE_MODRM       = (1 << 4),   /* The opcode has a ModR/M byte. */
+	_NMD_X86_OPCODE_INVALID_REG = (1 << 5),   /* The opcode is invalid if ModR/M.mod is 0b11. */
+	_NMD_X86_OPCODE_INVALID_MEM = (1 << 6),   /* The opcode is invalid if ModR/M.mod is not 0b11. */
+	_NMD_X86_OPCODE_EXTENSION   = (1 << 7),   /* The properties depend on ModR/M.reg. 'id' is the index of a row in '_nmd_x86_opcode_extensions'. */
+
+	/* The properties cannot be described by the tables(e.g. they depend on prefixes), the full decoder must be used instead. */
+	_NMD_X86_OPCODE_FALLBACK    = (_NMD_X86_OPCODE_INVALID_REG | _NMD_X86_OPCODE_INVALID_MEM)
+};
+
+/* Properties of an opcode used by the table-driven decoder. The tables are generated by 'generate_opcode_tables.c'. */
+typedef struct _nmd_x86_opcode_info
+{
+	uint16_t id;   /* The instruction's id. A member of 'NMD_X86_INSTRUCTION'. */
+	uint8_t group; /* The instruction's group. A member of 'NMD_GROUP'. */
+	uint8_t flags; /* A mask of '_NMD_X86_OPCODE_FLAGS'. */
+} _nmd_x86_opcode_info;
+
+/* Classes of a prefix byte used by the table-driven length disassembler. See '_nmd_x86_prefix_classes'. */
+enum _NMD_X86_PREFIX_CLASS
+{
+	_NMD_X86_PREFIX_CLASS_LEGACY       = (1 << 0), /* A legacy prefix. */
+	_NMD_X86_PREFIX_CLASS_OPERAND_SIZE = (1 << 1), /* 0x66 */
+	_NMD_X86_PREFIX_CLASS_ADDRESS_SIZE = (1 << 2), /* 0x67 */
+	_NMD_X86_PREFIX_CLASS_LOCK         = (1 << 3), /* 0xF0 */
+	_NMD_X86_PREFIX_CLASS_REX          = (1 << 4), /* A REX prefix. Only a prefix in 64-bit mode. */
+	_NMD_X86_PREFIX_CLASS_REX_W        = (1 << 5)  /* A REX prefix with the W bit set. */
+};
+
+/* The number of bits of a hash used to index the assembler's perfect hash tables('_nmd_x86_asm_mnemonic_hash_table' and '_nmd_x86_asm_reg_hash_table'). */
+#define _NMD_X86_ASM_MNEMONIC_HASH_BITS 9
+#define _NMD_X86_ASM_REG_HASH_BITS 8
+
 NMD_ASSEMBLY_API const char* const _nmd_reg8[8];
 NMD_ASSEMBLY_API const char* const _nmd_reg8_x64[8];
 NMD_ASSEMBLY_API const char* const _nmd_reg16[8];
@@ -44,6 +106,10 @@ NMD_ASSEMBLY_API const char* const _nmd_segment_reg[6];
 
 NMD_ASSEMBLY_API const char* const _nmd_condition_suffixes[16];
 
+NMD_ASSEMBLY_API const char _nmd_hex_digits[2][16];
+NMD_ASSEMBLY_API const char _nmd_decimal_digit_pairs[201];
+NMD_ASSEMBLY_API const uint64_t _nmd_powers_of_ten[19];
+
 NMD_ASSEMBLY_API const char* const _nmd_op1_opcode_map_mnemonics[8];
 NMD_ASSEMBLY_API const char* const _nmd_opcode_extensions_grp1[8];
 NMD_ASSEMBLY_API const char* const _nmd_opcode_extensions_grp2[8];
@@ -71,6 +137,19 @@ NMD_ASSEMBLY_API const uint8_t _nmd_op1_imm8[13];
 NMD_ASSEMBLY_API const uint8_t _nmd_op1_imm32[7];
 NMD_ASSEMBLY_API const uint8_t _nmd_invalid_op2[7];
 NMD_ASSEMBLY_API const uint8_t _nmd_two_opcodes[6];
+
+NMD_ASSEMBLY_API const _nmd_x86_opcode_info _nmd_x86_op1_info[3][256];
+NMD_ASSEMBLY_API const _nmd_x86_opcode_info _nmd_x86_op2_info[3][256];
+NMD_ASSEMBLY_API const _nmd_x86_opcode_info _nmd_x86_opcode_extensions[][8];
+NMD_ASSEMBLY_API const uint8_t _nmd_x86_ldisasm_op1_flags[3][256];
+NMD_ASSEMBLY_API const uint8_t _nmd_x86_ldisasm_op2_flags[3][256];
+NMD_ASSEMBLY_API const char _nmd_x86_mnemonics[];
+NMD_ASSEMBLY_API const uint16_t _nmd_x86_mnemonic_offsets[NMD_X86_INSTRUCTION_ENDBR64 + 1];
+NMD_ASSEMBLY_API const uint8_t _nmd_x86_prefix_classes[256];
+NMD_ASSEMBLY_API const uint32_t _nmd_x86_asm_mnemonic_hash_seed;
+NMD_ASSEMBLY_API const uint8_t _nmd_x86_asm_mnemonic_hash_table[1 << _NMD_X86_ASM_MNEMONIC_HASH_BITS];
+NMD_ASSEMBLY_API const uint32_t _nmd_x86_asm_reg_hash_seed;
+NMD_ASSEMBLY_API const uint8_t _nmd_x86_asm_reg_hash_table[1 << _NMD_X86_ASM_REG_HASH_BITS];
 NMD_ASSEMBLY_API const uint8_t _nmd_valid_3DNow_opcodes[24];
 
 NMD_ASSEMBLY_API bool _nmd_find_byte(const uint8_t* arr, const size_t N, const uint8_t x);
@@ -100,6 +179,9 @@ NMD_ASSEMBLY_API const char* _nmd_find_number(const char* s1, const char* s2);
 NMD_ASSEMBLY_API bool _nmd_strcmp(const char* s1, const char* s2);
 
 NMD_ASSEMBLY_API size_t _nmd_get_bit_index(uint32_t mask);
+NMD_ASSEMBLY_API int64_t _nmd_sign_extend(uint64_t value, size_t size);
+NMD_ASSEMBLY_API uint8_t _nmd_extend_gpr(uint8_t reg);
+NMD_ASSEMBLY_API size_t _nmd_x86_get_imm_size(uint8_t imm, NMD_X86_MODE mode, bool operand_size_prefix, bool address_size_prefix, bool rex_w_prefix);
 
 NMD_ASSEMBLY_API size_t _nmd_assembly_get_num_digits_hex(uint64_t n);
 
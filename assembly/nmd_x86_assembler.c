@@ -16,53 +16,122 @@ enum _NMD_NUMBER_BASE
 	_NMD_NUMBER_BASE_BINARY = 2
 };
 
-NMD_ASSEMBLY_API size_t _nmd_assemble_reg(_nmd_assemble_info* ai, uint8_t base_byte)
+/*
+Mnemonics(and prefixes) known by the assembler. The order of some ranges matters:
+ - The instructions from 'INT3' to 'STD' are encoded by a single opcode byte('_nmd_x86_asm_op1_bytes') and the ones from 'SYSCALL' to 'RSM' by 0x0F plus a byte('_nmd_x86_asm_op2_bytes').
+ - The instructions from 'ADD' to 'CMP' are in the same order as '_nmd_op1_opcode_map_mnemonics'.
+ - The instructions from 'JO' to 'JG' are in the same order as '_nmd_condition_suffixes'.
+*/
+enum _NMD_X86_ASM_MNEMONIC
 {
-	uint8_t i = 0;
-	if (ai->mode == NMD_X86_MODE_64)
-	{
-		for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg64); i++)
-		{
-			if (_nmd_strcmp(ai->s, _nmd_reg64[i]))
-			{
-				ai->b[0] = base_byte + i;
-				return 1;
-			}
-		}
+	_NMD_X86_ASM_MNEMONIC_NONE = 0,
 
-		for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_regrx); i++)
-		{
-			if (_nmd_strcmp(ai->s, _nmd_regrx[i]))
-			{
-				ai->b[0] = 0x41;
-				ai->b[1] = base_byte + i;
-				return 2;
-			}
-		}
-	}
-	else if (ai->mode == NMD_X86_MODE_32)
-	{
-		for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg32); i++)
-		{
-			if (_nmd_strcmp(ai->s, _nmd_reg32[i]))
-			{
-				ai->b[0] = base_byte + i;
-				return 1;
-			}
-		}
-	}	
+	_NMD_X86_ASM_MNEMONIC_LOCK, _NMD_X86_ASM_MNEMONIC_REP, _NMD_X86_ASM_MNEMONIC_REPE, _NMD_X86_ASM_MNEMONIC_REPZ, _NMD_X86_ASM_MNEMONIC_REPNE, _NMD_X86_ASM_MNEMONIC_REPNZ,
+
+	_NMD_X86_ASM_MNEMONIC_INT3, _NMD_X86_ASM_MNEMONIC_NOP, _NMD_X86_ASM_MNEMONIC_RET, _NMD_X86_ASM_MNEMONIC_RETF, _NMD_X86_ASM_MNEMONIC_LEAVE, _NMD_X86_ASM_MNEMONIC_INT1,
+	_NMD_X86_ASM_MNEMONIC_DAA, _NMD_X86_ASM_MNEMONIC_AAA, _NMD_X86_ASM_MNEMONIC_DAS, _NMD_X86_ASM_MNEMONIC_AAS, _NMD_X86_ASM_MNEMONIC_XLAT, _NMD_X86_ASM_MNEMONIC_FWAIT,
+	_NMD_X86_ASM_MNEMONIC_HLT, _NMD_X86_ASM_MNEMONIC_CMC, _NMD_X86_ASM_MNEMONIC_CLC, _NMD_X86_ASM_MNEMONIC_SAHF, _NMD_X86_ASM_MNEMONIC_LAHF, _NMD_X86_ASM_MNEMONIC_INTO,
+	_NMD_X86_ASM_MNEMONIC_SALC, _NMD_X86_ASM_MNEMONIC_SLC, _NMD_X86_ASM_MNEMONIC_STC, _NMD_X86_ASM_MNEMONIC_CLI, _NMD_X86_ASM_MNEMONIC_STI, _NMD_X86_ASM_MNEMONIC_CLD,
+	_NMD_X86_ASM_MNEMONIC_STD,
+
+	_NMD_X86_ASM_MNEMONIC_SYSCALL, _NMD_X86_ASM_MNEMONIC_CLTS, _NMD_X86_ASM_MNEMONIC_SYSRET, _NMD_X86_ASM_MNEMONIC_INVD, _NMD_X86_ASM_MNEMONIC_WBINVD, _NMD_X86_ASM_MNEMONIC_UD2,
+	_NMD_X86_ASM_MNEMONIC_FEMMS, _NMD_X86_ASM_MNEMONIC_WRMSR, _NMD_X86_ASM_MNEMONIC_RDTSC, _NMD_X86_ASM_MNEMONIC_RDMSR, _NMD_X86_ASM_MNEMONIC_RDPMC, _NMD_X86_ASM_MNEMONIC_SYSENTER,
+	_NMD_X86_ASM_MNEMONIC_SYSEXIT, _NMD_X86_ASM_MNEMONIC_GETSEC, _NMD_X86_ASM_MNEMONIC_EMMS, _NMD_X86_ASM_MNEMONIC_CPUID, _NMD_X86_ASM_MNEMONIC_RSM,
+
+	_NMD_X86_ASM_MNEMONIC_ADD, _NMD_X86_ASM_MNEMONIC_ADC, _NMD_X86_ASM_MNEMONIC_AND, _NMD_X86_ASM_MNEMONIC_XOR, _NMD_X86_ASM_MNEMONIC_OR, _NMD_X86_ASM_MNEMONIC_SBB,
+	_NMD_X86_ASM_MNEMONIC_SUB, _NMD_X86_ASM_MNEMONIC_CMP,
+
+	_NMD_X86_ASM_MNEMONIC_JO, _NMD_X86_ASM_MNEMONIC_JNO, _NMD_X86_ASM_MNEMONIC_JB, _NMD_X86_ASM_MNEMONIC_JNB, _NMD_X86_ASM_MNEMONIC_JZ, _NMD_X86_ASM_MNEMONIC_JNZ,
+	_NMD_X86_ASM_MNEMONIC_JBE, _NMD_X86_ASM_MNEMONIC_JA, _NMD_X86_ASM_MNEMONIC_JS, _NMD_X86_ASM_MNEMONIC_JNS, _NMD_X86_ASM_MNEMONIC_JP, _NMD_X86_ASM_MNEMONIC_JNP,
+	_NMD_X86_ASM_MNEMONIC_JL, _NMD_X86_ASM_MNEMONIC_JGE, _NMD_X86_ASM_MNEMONIC_JLE, _NMD_X86_ASM_MNEMONIC_JG,
+
+	_NMD_X86_ASM_MNEMONIC_MOV, _NMD_X86_ASM_MNEMONIC_PUSH, _NMD_X86_ASM_MNEMONIC_POP, _NMD_X86_ASM_MNEMONIC_XCHG, _NMD_X86_ASM_MNEMONIC_INC, _NMD_X86_ASM_MNEMONIC_DEC,
+	_NMD_X86_ASM_MNEMONIC_JMP, _NMD_X86_ASM_MNEMONIC_CALL, _NMD_X86_ASM_MNEMONIC_INT, _NMD_X86_ASM_MNEMONIC_EMIT,
+
+	_NMD_X86_ASM_MNEMONIC_PUSHF, _NMD_X86_ASM_MNEMONIC_POPF, _NMD_X86_ASM_MNEMONIC_PUSHFD, _NMD_X86_ASM_MNEMONIC_POPFD, _NMD_X86_ASM_MNEMONIC_PUSHFQ, _NMD_X86_ASM_MNEMONIC_POPFQ,
+	_NMD_X86_ASM_MNEMONIC_PUSHA, _NMD_X86_ASM_MNEMONIC_PUSHAD, _NMD_X86_ASM_MNEMONIC_POPA, _NMD_X86_ASM_MNEMONIC_POPAD, _NMD_X86_ASM_MNEMONIC_IRET, _NMD_X86_ASM_MNEMONIC_IRETD,
+	_NMD_X86_ASM_MNEMONIC_IRETQ, _NMD_X86_ASM_MNEMONIC_PAUSE, _NMD_X86_ASM_MNEMONIC_CBW, _NMD_X86_ASM_MNEMONIC_CWDE, _NMD_X86_ASM_MNEMONIC_CDQE, _NMD_X86_ASM_MNEMONIC_CWD,
+	_NMD_X86_ASM_MNEMONIC_CDQ, _NMD_X86_ASM_MNEMONIC_CQO,
+
+	_NMD_X86_ASM_MNEMONIC_NUM
+};
+
+/* The names of the members of '_NMD_X86_ASM_MNEMONIC'. */
+NMD_ASSEMBLY_API const char* const _nmd_x86_asm_mnemonics[] = {
+	"",
+	"lock", "rep", "repe", "repz", "repne", "repnz",
+	"int3", "nop", "ret", "retf", "leave", "int1", "daa", "aaa", "das", "aas", "xlat", "fwait", "hlt", "cmc", "clc", "sahf", "lahf", "into", "salc", "slc", "stc", "cli", "sti", "cld", "std",
+	"syscall", "clts", "sysret", "invd", "wbinvd", "ud2", "femms", "wrmsr", "rdtsc", "rdmsr", "rdpmc", "sysenter", "sysexit", "getsec", "emms", "cpuid", "rsm",
+	"add", "adc", "and", "xor", "or", "sbb", "sub", "cmp",
+	"jo", "jno", "jb", "jnb", "jz", "jnz", "jbe", "ja", "js", "jns", "jp", "jnp", "jl", "jge", "jle", "jg",
+	"mov", "push", "pop", "xchg", "inc", "dec", "jmp", "call", "int", "emit",
+	"pushf", "popf", "pushfd", "popfd", "pushfq", "popfq", "pusha", "pushad", "popa", "popad", "iret", "iretd", "iretq", "pause", "cbw", "cwde", "cdqe", "cwd", "cdq", "cqo"
+};
+
+NMD_ASSEMBLY_API const uint8_t _nmd_x86_asm_op1_bytes[] = { 0xcc, 0x90, 0xc3, 0xcb, 0xc9, 0xf1, 0x27, 0x37, 0x2f, 0x3f, 0xd7, 0x9b, 0xf4, 0xf5, 0xf8, 0x9e, 0x9f, 0xce, 0xd6, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd };
+NMD_ASSEMBLY_API const uint8_t _nmd_x86_asm_op2_bytes[] = { 0x05, 0x06, 0x07, 0x08, 0x09, 0x0b, 0x0e, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x37, 0x77, 0xa2, 0xaa };
 
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg16); i++)
+/*
+Hashes the first 'length' characters of 's'(FNV-1a using 'seed' as the offset basis). The hash tables are indexed by the high-order bits of the result,
+which are mixed at the end because FNV-1a alone leaves them almost equal for short names that differ in a single character(e.g. 'r8w' and 'r9w').
+*/
+NMD_ASSEMBLY_API uint32_t _nmd_hash_string(const char* s, size_t length, uint32_t seed)
+{
+	size_t i = 0;
+	for (; i < length; i++)
+		seed = (seed ^ (uint8_t)s[i]) * 16777619;
+
+	seed ^= seed >> 16;
+	seed *= 0x85ebca6b;
+	seed ^= seed >> 13;
+	return seed;
+}
+
+/* Returns the number of characters of the token(a sequence of lowercase letters and digits) at 's'. */
+NMD_ASSEMBLY_API size_t _nmd_get_token_length(const char* s)
+{
+	const char* const start = s;
+	while (_NMD_IS_LOWERCASE(*s) || _NMD_IS_DECIMAL_NUMBER(*s))
+		s++;
+
+	return (size_t)(s - start);
+}
+
+/* Returns true if the first 'length' characters of 's' are exactly 'name'. */
+NMD_ASSEMBLY_API bool _nmd_token_equals(const char* name, const char* s, size_t length)
+{
+	size_t i = 0;
+	for (; i < length; i++)
 	{
-		if (_nmd_strcmp(ai->s, _nmd_reg16[i]))
-		{
-			ai->b[0] = 0x66;
-			ai->b[1] = base_byte + i;
-			return 2;
-		}
+		if (name[i] != s[i])
+			return false;
 	}
 
-	return 0;
+	return name[length] == '\0';
+}
+
+/* Returns the name of a general-purpose or segment register(from 'NMD_X86_REG_AL' to 'NMD_X86_REG_GS'), or a null pointer if 'reg' is not one of them. */
+NMD_ASSEMBLY_API const char* _nmd_get_asm_reg_name(uint8_t reg)
+{
+	static const char* const* const names[] = { _nmd_reg8, _nmd_reg16, _nmd_reg32, _nmd_reg64, _nmd_regrx, _nmd_regrxb, _nmd_regrxw, _nmd_regrxd, _nmd_segment_reg };
+	if (reg < NMD_X86_REG_AL || reg > NMD_X86_REG_GS)
+		return 0;
+
+	return names[(reg - NMD_X86_REG_AL) / 8][reg % 8];
+}
+
+/* Returns the mnemonic('_NMD_X86_ASM_MNEMONIC') whose name is the first 'length' characters of 's', or '_NMD_X86_ASM_MNEMONIC_NONE'. */
+NMD_ASSEMBLY_API uint8_t _nmd_find_asm_mnemonic(const char* s, size_t length)
+{
+	const uint8_t mnemonic = _nmd_x86_asm_mnemonic_hash_table[_nmd_hash_string(s, length, _nmd_x86_asm_mnemonic_hash_seed) >> (32 - _NMD_X86_ASM_MNEMONIC_HASH_BITS)];
+	return mnemonic && _nmd_token_equals(_nmd_x86_asm_mnemonics[mnemonic], s, length) ? mnemonic : (uint8_t)_NMD_X86_ASM_MNEMONIC_NONE;
+}
+
+/* Returns the register whose name is the first 'length' characters of 's', or 'NMD_X86_REG_NONE'. Only general-purpose and segment registers are recognized. */
+NMD_ASSEMBLY_API NMD_X86_REG _nmd_find_asm_reg(const char* s, size_t length)
+{
+	const uint8_t reg = _nmd_x86_asm_reg_hash_table[_nmd_hash_string(s, length, _nmd_x86_asm_reg_hash_seed) >> (32 - _NMD_X86_ASM_REG_HASH_BITS)];
+	return reg && _nmd_token_equals(_nmd_get_asm_reg_name(reg), s, length) ? (NMD_X86_REG)reg : NMD_X86_REG_NONE;
 }
 
 NMD_ASSEMBLY_API uint8_t _nmd_encode_segment_reg(NMD_X86_REG segment_reg)
@@ -152,7 +221,8 @@ NMD_ASSEMBLY_API size_t _nmd_parse_number(const char* string, int64_t* p_num)
 	if (num_digits == 0)
 		return 0;
 
-	int64_t num = 0;
+	/* Accumulated as unsigned, numbers up to 2^64-1 overflow a signed integer */
+	uint64_t num = 0;
 	for (i = 0; i < num_digits; i++)
 	{
 		const char c = s[i];
@@ -166,9 +236,9 @@ NMD_ASSEMBLY_API size_t _nmd_parse_number(const char* string, int64_t* p_num)
 			/* Return false if number is greater than 2^64-1 */
 			if ( num_digits > 16 && i >= 15)
 			{
-				if ((base == _NMD_NUMBER_BASE_DECIMAL && (uint64_t)num >= (uint64_t)1844674407370955162) || /* ceiling((2^64-1) / 10) */
-					(base == _NMD_NUMBER_BASE_HEXADECIMAL && (uint64_t)num >= (uint64_t)1152921504606846976) || /* *ceiling((2^64-1) / 16) */
-					(base == _NMD_NUMBER_BASE_BINARY && (uint64_t)num >= (uint64_t)9223372036854775808U)) /* ceiling((2^64-1) / 2) */
+				if ((base == _NMD_NUMBER_BASE_DECIMAL && num >= (uint64_t)1844674407370955162) || /* ceiling((2^64-1) / 10) */
+					(base == _NMD_NUMBER_BASE_HEXADECIMAL && num >= (uint64_t)1152921504606846976) || /* *ceiling((2^64-1) / 16) */
+					(base == _NMD_NUMBER_BASE_BINARY && num >= (uint64_t)9223372036854775808U)) /* ceiling((2^64-1) / 2) */
 				{
 					return 0;
 				}
@@ -179,9 +249,9 @@ NMD_ASSEMBLY_API size_t _nmd_parse_number(const char* string, int64_t* p_num)
 	}
 
 	if (is_negative)
-		num *= -1;
+		num = ~num + 1;
 
-	*p_num = num;
+	*p_num = (int64_t)num;
 
 	size_t offset = 0;
 
@@ -195,206 +265,116 @@ NMD_ASSEMBLY_API size_t _nmd_parse_number(const char* string, int64_t* p_num)
 	
 	return offset + num_digits;
 }
+/* Parses a number that takes the rest of the string. Registers that look like numbers(e.g. 'ah' and 'ch' with the 'h' suffix) are not numbers. */
+NMD_ASSEMBLY_API bool _nmd_parse_immediate(const char* string, int64_t* p_num)
+{
+	const size_t num_digits = _nmd_parse_number(string, p_num);
+	return num_digits && string[num_digits] == '\0' && !_nmd_find_asm_reg(string, num_digits);
+}
 
 NMD_ASSEMBLY_API size_t _nmd_append_prefix_by_reg_size(uint8_t* b, const char* s, size_t* num_prefixes, size_t* index)
 {
-	size_t i;
-	
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg32); i++)
-	{
-		if (_nmd_strcmp(s, _nmd_reg32[i]))
-		{
-			*num_prefixes = 0;
-			*index = i;
-			return 4;
-		}
-	}
+	const size_t length = _nmd_get_token_length(s);
+	const NMD_X86_REG reg = s[length] == '\0' ? _nmd_find_asm_reg(s, length) : NMD_X86_REG_NONE;
 
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg8); i++)
-	{
-		if (_nmd_strcmp(s, _nmd_reg8[i]))
-		{
-			*num_prefixes = 0;
-			*index = i;
-			return 1;
-		}
-	}
+	*num_prefixes = 0;
+	*index = reg % 8;
 
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg16); i++)
+	if (reg >= NMD_X86_REG_EAX && reg <= NMD_X86_REG_EDI)
+		return 4;
+	else if (reg >= NMD_X86_REG_AL && reg <= NMD_X86_REG_BH)
+		return 1;
+	else if (reg >= NMD_X86_REG_AX && reg <= NMD_X86_REG_DI)
 	{
-		if (_nmd_strcmp(s, _nmd_reg16[i]))
-		{
-			b[0] = 0x66;
-			*num_prefixes = 1;
-			*index = i;
-			return 2;
-		}
-	}	
-
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg64); i++)
+		b[(*num_prefixes)++] = 0x66;
+		return 2;
+	}
+	else if (reg >= NMD_X86_REG_RAX && reg <= NMD_X86_REG_RDI)
 	{
-		if (_nmd_strcmp(s, _nmd_reg64[i]))
-		{
-			b[0] = 0x48;
-			*num_prefixes = 1;
-			*index = i;
-			return 8;
-		}
+		b[(*num_prefixes)++] = 0x48;
+		return 8;
 	}
-
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_regrx); i++)
+	else if (reg >= NMD_X86_REG_R8 && reg <= NMD_X86_REG_R15)
 	{
-		if (_nmd_strcmp(s, _nmd_regrx[i]))
-		{
-			b[0] = 0x49;
-			*num_prefixes = 1;
-			*index = i;
-			return 8;
-		}
+		b[(*num_prefixes)++] = 0x49;
+		return 8;
 	}
-
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_regrxd); i++)
+	else if (reg >= NMD_X86_REG_R8D && reg <= NMD_X86_REG_R15D)
 	{
-		if (_nmd_strcmp(s, _nmd_regrxd[i]))
-		{
-			b[0] = 0x41;
-			*num_prefixes = 1;
-			*index = i;
-			return 4;
-		}
+		b[(*num_prefixes)++] = 0x41;
+		return 4;
 	}
-
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_regrxw); i++)
+	else if (reg >= NMD_X86_REG_R8W && reg <= NMD_X86_REG_R15W)
 	{
-		if (_nmd_strcmp(s, _nmd_regrxw[i]))
-		{
-			b[0] = 0x66;
-			b[1] = 0x41;
-			*num_prefixes = 2;
-			*index = i;
-			return 2;
-		}
+		b[(*num_prefixes)++] = 0x66;
+		b[(*num_prefixes)++] = 0x41;
+		return 2;
 	}
-
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_regrxb); i++)
+	else if (reg >= NMD_X86_REG_R8B && reg <= NMD_X86_REG_R15B)
 	{
-		if (_nmd_strcmp(s, _nmd_regrxb[i]))
-		{
-			b[0] = 0x41;
-			*num_prefixes = 1;
-			*index = i;
-			return 1;
-		}
+		b[(*num_prefixes)++] = 0x41;
+		return 1;
 	}
 
 	return 0;
 }
 
+/* Parses a register from 'first_reg' to 'last_reg'. 'string' is advanced past the register only if it's parsed. */
+NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_reg_range(const char** string, NMD_X86_REG first_reg, NMD_X86_REG last_reg)
+{
+	const size_t length = _nmd_get_token_length(*string);
+	const NMD_X86_REG reg = _nmd_find_asm_reg(*string, length);
+	if (reg < first_reg || reg > last_reg)
+		return NMD_X86_REG_NONE;
+
+	*string += length;
+	return reg;
+}
+
 NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_reg8(const char** string)
 {
-	const char* s = *string;
-	size_t i;
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg8); i++)
-	{
-		if (_nmd_strstr_ex(s, _nmd_reg8[i], string) == s)
-			return (NMD_X86_REG)(NMD_X86_REG_AL + i);
-	}
-	return NMD_X86_REG_NONE;
+	return _nmd_parse_reg_range(string, NMD_X86_REG_AL, NMD_X86_REG_BH);
 }
 
 NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_reg16(const char** string)
 {
-	const char* s = *string;
-	size_t i;
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg16); i++)
-	{
-		if (_nmd_strstr_ex(s, _nmd_reg16[i], string) == s)
-			return (NMD_X86_REG)(NMD_X86_REG_AX + i);
-	}
-	return NMD_X86_REG_NONE;
+	return _nmd_parse_reg_range(string, NMD_X86_REG_AX, NMD_X86_REG_DI);
 }
 
 NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_reg32(const char** string)
 {
-	const char* s = *string;
-	size_t i;
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg32); i++)
-	{
-		if (_nmd_strstr_ex(s, _nmd_reg32[i], string) == s)
-			return (NMD_X86_REG)(NMD_X86_REG_EAX + i);
-	}
-	return NMD_X86_REG_NONE;
+	return _nmd_parse_reg_range(string, NMD_X86_REG_EAX, NMD_X86_REG_EDI);
 }
 
 NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_reg64(const char** string)
 {
-	const char* s = *string;
-	size_t i;
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg64); i++)
-	{
-		if (_nmd_strstr_ex(s, _nmd_reg64[i], string) == s)
-			return (NMD_X86_REG)(NMD_X86_REG_RAX + i);
-	}
-	return NMD_X86_REG_NONE;
+	return _nmd_parse_reg_range(string, NMD_X86_REG_RAX, NMD_X86_REG_RDI);
 }
 
 NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_regrxb(const char** string)
 {
-	const char* s = *string;
-	size_t i;
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_regrxb); i++)
-	{
-		if (_nmd_strstr_ex(s, _nmd_regrxb[i], string) == s)
-			return (NMD_X86_REG)(NMD_X86_REG_R8B + i);
-	}
-	return NMD_X86_REG_NONE;
+	return _nmd_parse_reg_range(string, NMD_X86_REG_R8B, NMD_X86_REG_R15B);
 }
 
 NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_regrxw(const char** string)
 {
-	const char* s = *string;
-	size_t i;
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_regrxw); i++)
-	{
-		if (_nmd_strstr_ex(s, _nmd_regrxw[i], string) == s)
-			return (NMD_X86_REG)(NMD_X86_REG_R8W + i);
-	}
-	return NMD_X86_REG_NONE;
+	return _nmd_parse_reg_range(string, NMD_X86_REG_R8W, NMD_X86_REG_R15W);
 }
 
 NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_regrxd(const char** string)
 {
-	const char* s = *string;
-	size_t i;
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_regrxd); i++)
-	{
-		if (_nmd_strstr_ex(s, _nmd_regrxd[i], string) == s)
-			return (NMD_X86_REG)(NMD_X86_REG_R8D + i);
-	}
-	return NMD_X86_REG_NONE;
+	return _nmd_parse_reg_range(string, NMD_X86_REG_R8D, NMD_X86_REG_R15D);
 }
 
 NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_regrx(const char** string)
 {
-	const char* s = *string;
-	size_t i;
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_regrx); i++)
-	{
-		if (_nmd_strstr_ex(s, _nmd_regrx[i], string) == s)
-			return (NMD_X86_REG)(NMD_X86_REG_R8 + i);
-	}
-	return NMD_X86_REG_NONE;
+	return _nmd_parse_reg_range(string, NMD_X86_REG_R8, NMD_X86_REG_R15);
 }
 
-/* Parses a register */
+/* Parses a general-purpose register */
 NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_reg(const char** string)
 {
-    NMD_X86_REG reg;
-    if(!(reg = _nmd_parse_reg8(string)) && !(reg = _nmd_parse_reg16(string)) && !(reg = _nmd_parse_reg32(string)) && !(reg = _nmd_parse_reg64(string)) &&
-    !(reg = _nmd_parse_regrxb(string)) && !(reg = _nmd_parse_regrxw(string)) && !(reg = _nmd_parse_regrxd(string)) && !(reg = _nmd_parse_regrx(string)))
-    { }
-    
-    return reg;
+	return _nmd_parse_reg_range(string, NMD_X86_REG_AL, NMD_X86_REG_R15D);
 }
 
 /* 
@@ -437,20 +417,9 @@ NMD_ASSEMBLY_API bool _nmd_parse_memory_operand(const char** string, nmd_x86_mem
 	}
 
 	/* Check for a segment register */
-	size_t i = 0;
-	operand->segment = NMD_X86_REG_NONE;
-	for (; i < _NMD_NUM_ELEMENTS(_nmd_segment_reg); i++)
-	{
-		if (_nmd_strstr(s, _nmd_segment_reg[i]) == s)
-		{
-			if (s[2] != ':')
-				return false;
-
-			s += 3;
-			operand->segment = (uint8_t)(NMD_X86_REG_ES + i);
-			break;
-		}
-	}
+	operand->segment = (uint8_t)_nmd_parse_reg_range(&s, NMD_X86_REG_ES, NMD_X86_REG_GS);
+	if (operand->segment && *s++ != ':')
+		return false;
 
 	/* Check for the actual memory operand expression. If this check fails, this is not a memory operand */
 	if (s[0] == '[')
@@ -470,6 +439,7 @@ NMD_ASSEMBLY_API bool _nmd_parse_memory_operand(const char** string, nmd_x86_mem
 	bool add = false;
 	bool sub = false;
 	bool multiply = false;
+	bool scaled = false;
 	bool is_register = false;
 	while (true)
 	{
@@ -478,27 +448,27 @@ NMD_ASSEMBLY_API bool _nmd_parse_memory_operand(const char** string, nmd_x86_mem
 		nor multiplication because these are not valid for registers(only addition is).
 		*/
 		bool parsed_element = false;
-		if (!sub && !multiply)
+		NMD_X86_REG reg;
+		if (!sub && !multiply && (reg = _nmd_parse_reg32(&s)))
 		{
-			for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg32); i++)
+			if (add)
 			{
-				const char* tmp;
-				if (_nmd_strstr_ex(s, _nmd_reg32[i], &tmp) == s)
+				/* '[index*scale+base]' */
+				if (operand->index && operand->base)
+					return false;
+				else if (operand->index)
+					operand->base = (uint8_t)reg;
+				else
 				{
-					s = tmp;
-					if (add)
-					{
-						operand->index = (uint8_t)(NMD_X86_REG_EAX + i);
-						operand->scale = 1;
-						add = false;
-					}
-					else
-						operand->base = (uint8_t)(NMD_X86_REG_EAX + i);
-					parsed_element = true;
-					is_register = true;
-					break;
+					operand->index = (uint8_t)reg;
+					operand->scale = 1;
 				}
+				add = false;
 			}
+			else
+				operand->base = (uint8_t)reg;
+			parsed_element = true;
+			is_register = true;
 		}
 
 		int64_t num;
@@ -522,7 +492,15 @@ NMD_ASSEMBLY_API bool _nmd_parse_memory_operand(const char** string, nmd_x86_mem
 				if (!is_register || (num != 1 && num != 2 && num != 4 && num != 8))
 					return false;
 
+				/* The scaled register is the index, even if it was parsed first('[eax*8+disp]') */
+				if (!operand->index)
+				{
+					operand->index = operand->base;
+					operand->base = 0;
+				}
 				operand->scale = (uint8_t)num;
+				multiply = false;
+				scaled = true;
 			}
 			else
 				operand->disp = num;
@@ -540,7 +518,7 @@ NMD_ASSEMBLY_API bool _nmd_parse_memory_operand(const char** string, nmd_x86_mem
 		else if (s[0] == '*')
 		{
 			/* There cannot be more than one '*' operator. */
-			if (multiply)
+			if (multiply || scaled)
 				return false;
 
 			multiply = true;
@@ -557,786 +535,664 @@ NMD_ASSEMBLY_API bool _nmd_parse_memory_operand(const char** string, nmd_x86_mem
 	return true;
 }
 
-NMD_ASSEMBLY_API size_t _nmd_assemble_mem_reg(uint8_t* buffer, nmd_x86_memory_operand* mem, uint8_t opcode, uint8_t modrm_reg)
+/* Returns the size in bytes of a general-purpose register, or zero if 'reg' is not a general-purpose register. */
+NMD_ASSEMBLY_API size_t _nmd_get_gpr_size(NMD_X86_REG reg)
+{
+	static const uint8_t sizes[] = { 1, 2, 4, 8, 8, 1, 2, 4 };
+	return reg >= NMD_X86_REG_AL && reg <= NMD_X86_REG_R15D ? sizes[(reg - NMD_X86_REG_AL) / 8] : 0;
+}
+
+/* Returns the ModR/M encoding of a general-purpose register. Bit 3 is set for 'r8' to 'r15'(the bit stored in the REX prefix). */
+NMD_ASSEMBLY_API uint8_t _nmd_get_gpr_index(NMD_X86_REG reg)
+{
+	return (uint8_t)(reg % 8 + (reg >= NMD_X86_REG_R8 ? 8 : 0));
+}
+
+/* What the byte registers whose identifiers are 'NMD_X86_REG_AH' to 'NMD_X86_REG_BH' mean in an instruction. */
+enum _NMD_BYTE_REGS
+{
+	_NMD_BYTE_REGS_NONE = 0, /* The instruction doesn't use them. */
+	_NMD_BYTE_REGS_HIGH,     /* 'ah', 'ch', 'dh' and 'bh', which can't be encoded with a REX prefix. */
+	_NMD_BYTE_REGS_REX       /* 'spl', 'bpl', 'sil' and 'dil', which require a REX prefix(the decoder sets 'has_rex'). */
+};
+
+/*
+Appends the operand size prefix and the REX prefix required by an instruction whose operand size is 'size' bytes. 'rex' is a mask of the R, X and B bits of the REX prefix.
+'byte_regs' is a member of '_NMD_BYTE_REGS'. Returns false if the combination is not valid in 'mode'.
+*/
+NMD_ASSEMBLY_API bool _nmd_append_operand_size_prefixes(uint8_t* buffer, size_t* offset, NMD_X86_MODE mode, size_t size, uint8_t rex, uint8_t byte_regs)
+{
+	if ((size == 2 && mode != NMD_X86_MODE_16) || (size == 4 && mode == NMD_X86_MODE_16))
+		buffer[(*offset)++] = 0x66;
+
+	if (size == 8)
+		rex |= 0x08; /* REX.W */
+	if (byte_regs == _NMD_BYTE_REGS_REX)
+		rex |= 0x40;
+
+	if (rex)
+	{
+		if (mode != NMD_X86_MODE_64 || byte_regs == _NMD_BYTE_REGS_HIGH)
+			return false;
+
+		buffer[(*offset)++] = 0x40 | rex;
+	}
+
+	return true;
+}
+
+/* Returns true if 'reg' is 'ah', 'ch', 'dh' or 'bh', which can't be encoded with a REX prefix. */
+NMD_ASSEMBLY_API bool _nmd_is_high_byte_reg(uint8_t reg)
+{
+	return reg >= NMD_X86_REG_AH && reg <= NMD_X86_REG_BH;
+}
+
+/*
+Assembles an instruction with an opcode byte followed by a ModR/M byte whose r/m field describes 'mem'. Returns the number of bytes written, or zero if the operand can't be encoded.
+Parameters:
+ - buffer       [out] A pointer to a buffer that receives the instruction.
+ - mode         [in]  The architecture mode.
+ - mem          [in]  The memory operand. The base and index registers(if any) are 32-bit or 64-bit registers, the base may also be 'rip' or 'eip' in 64-bit mode.
+ - opcode       [in]  The opcode byte.
+ - modrm_reg    [in]  The value of the ModR/M.reg field, see _nmd_get_gpr_index(). Bit 3 is encoded in REX.R.
+ - operand_size [in]  The operand size in bytes, used to choose the operand size and REX.W prefixes.
+ - byte_regs    [in]  A member of '_NMD_BYTE_REGS' that tells what 'modrm_reg' means if it's the index of 'ah', 'ch', 'dh' or 'bh'.
+*/
+NMD_ASSEMBLY_API size_t _nmd_assemble_mem_reg(uint8_t* buffer, NMD_X86_MODE mode, const nmd_x86_memory_operand* mem, uint8_t opcode, uint8_t modrm_reg, size_t operand_size, uint8_t byte_regs)
 {
 	size_t offset = 0;
-	
+	nmd_x86_modrm modrm;
+	nmd_x86_sib sib;
+	bool has_sib = false;
+	size_t disp_size = 0;
+	const bool is_rip_relative = mem->base == NMD_X86_REG_RIP || mem->base == NMD_X86_REG_EIP;
+	const uint8_t base = is_rip_relative ? 0 : _nmd_get_gpr_index((NMD_X86_REG)mem->base), index = _nmd_get_gpr_index((NMD_X86_REG)mem->index);
+	const size_t address_size = is_rip_relative ? (mem->base == NMD_X86_REG_RIP ? 8 : 4) : _nmd_get_gpr_size((NMD_X86_REG)(mem->base ? mem->base : mem->index));
+
+	/* The registers must be 32-bit(or 64-bit in 64-bit mode) registers of the same size. ESP(and RSP) can't be an index register */
+	if ((mem->base && !is_rip_relative && _nmd_get_gpr_size((NMD_X86_REG)mem->base) != address_size) || (mem->index && (_nmd_get_gpr_size((NMD_X86_REG)mem->index) != address_size || index == 0b100 || is_rip_relative)) ||
+		(address_size && address_size != 4 && address_size != 8) || (address_size == 8 && mode != NMD_X86_MODE_64) || (is_rip_relative && mode != NMD_X86_MODE_64))
+		return 0;
+
+	/* The scale is 1, 2, 4 or 8(zero means 1). The displacement has 32 bits(sign-extended in 64-bit mode without registers) */
+	if ((mem->scale & (mem->scale - 1)) || mem->scale > 8 || mem->disp < -(int64_t)0x80000000 || mem->disp > ((mode == NMD_X86_MODE_64 && (!mem->base || is_rip_relative) && !mem->index) ? 0x7fffffff : 0xffffffff))
+		return 0;
+
 	/* Assemble segment register if required */
-	if (mem->segment && mem->segment != ((mem->base == NMD_X86_REG_ESP || mem->index == NMD_X86_REG_ESP) ? NMD_X86_REG_SS : NMD_X86_REG_DS))
+	if (mem->segment && mem->segment != ((mem->base == NMD_X86_REG_ESP || mem->base == NMD_X86_REG_EBP || mem->base == NMD_X86_REG_RSP || mem->base == NMD_X86_REG_RBP) ? NMD_X86_REG_SS : NMD_X86_REG_DS))
 		buffer[offset++] = _nmd_encode_segment_reg((NMD_X86_REG)mem->segment);
 
+	/* The address size prefix selects 32-bit addressing in 16-bit mode and 32-bit registers in 64-bit mode */
+	if (mode == NMD_X86_MODE_16 || (mode == NMD_X86_MODE_64 && address_size == 4))
+		buffer[offset++] = 0x67;
+
+	if (!_nmd_append_operand_size_prefixes(buffer, &offset, mode, operand_size, (modrm_reg & 8 ? 0x04 : 0) | (index & 8 ? 0x02 : 0) | (base & 8 ? 0x01 : 0), byte_regs))
+		return 0;
+
 	buffer[offset++] = opcode;
 
-	nmd_x86_modrm modrm;
-	modrm.fields.reg = modrm_reg;
+	modrm.fields.reg = modrm_reg % 8;
 	modrm.fields.mod = 0;
 
-	if (mem->index != NMD_X86_REG_NONE && mem->base != NMD_X86_REG_NONE)
+	if (is_rip_relative)
 	{
-		modrm.fields.rm = 0b100;
-		nmd_x86_sib sib;
-		sib.fields.scale = (uint8_t)_nmd_get_bit_index(mem->scale);
-		sib.fields.base = mem->base - NMD_X86_REG_EAX;
-		sib.fields.index = mem->index - NMD_X86_REG_EAX;
-
-		const size_t next_offset = offset;
-		if (mem->disp != 0)
-		{
-			if (mem->disp >= -128 && mem->disp <= 127)
-			{
-				modrm.fields.mod = 1;
-				*(int8_t*)(buffer + offset + 2) = (int8_t)mem->disp;
-				offset++;
-			}
-			else
-			{
-				modrm.fields.mod = 2;
-				*(int32_t*)(buffer + offset + 2) = (int32_t)mem->disp;
-				offset += 4;
-			}
-		}
-
-		buffer[next_offset] = modrm.modrm;
-		buffer[next_offset + 1] = sib.sib;
-		offset += 2;
-
-		return offset;
+		/* ModR/M.rm=0b101 without a displacement means RIP-relative in 64-bit mode */
+		modrm.fields.rm = 0b101;
+		disp_size = 4;
 	}
-	else if (mem->base != NMD_X86_REG_NONE)
+	else if (mem->index || base % 8 == 0b100 || (!mem->base && mode == NMD_X86_MODE_64))
 	{
-		modrm.fields.rm = mem->base - NMD_X86_REG_EAX;
-		const size_t next_offset = offset;
-		if (mem->disp != 0)
-		{
-			if (mem->disp >= -128 && mem->disp <= 127)
-			{
-				modrm.fields.mod = 1;
-				*(int8_t*)(buffer + offset + 1) = (int8_t)mem->disp;
-				offset++;
-			}
-			else
-			{
-				modrm.fields.mod = 2;
-				*(int32_t*)(buffer + offset + 1) = (int32_t)mem->disp;
-				offset += 4;
-			}
-		}
-		buffer[next_offset] = modrm.modrm;
-		offset++;
+		/* SIB byte. Without a base register(and in 64-bit mode without any register, because ModR/M.rm=0b101 means RIP-relative) base=0b101 means disp32 */
+		modrm.fields.rm = 0b100;
+		has_sib = true;
+		sib.fields.scale = mem->index && mem->scale ? (uint8_t)_nmd_get_bit_index(mem->scale) : 0;
+		sib.fields.index = mem->index ? index % 8 : 0b100;
+		sib.fields.base = mem->base ? base % 8 : 0b101;
 	}
 	else
+		modrm.fields.rm = mem->base ? base % 8 : 0b101;
+
+	if (!mem->base)
+		disp_size = 4;
+	else if (!is_rip_relative && (mem->disp != 0 || base % 8 == 0b101)) /* [ebp] must be encoded as [ebp+0] */
 	{
-		modrm.fields.rm = 0b101;
-		buffer[offset++] = modrm.modrm;
-		*(int32_t*)(buffer + offset) = (int32_t)mem->disp;
-		offset += 4;
+		disp_size = mem->disp >= -128 && mem->disp <= 127 ? 1 : 4;
+		modrm.fields.mod = disp_size == 1 ? 1 : 2;
 	}
 
+	buffer[offset++] = modrm.modrm;
+	if (has_sib)
+		buffer[offset++] = sib.sib;
+
+	if (disp_size == 1)
+		*(int8_t*)(buffer + offset) = (int8_t)mem->disp;
+	else if (disp_size == 4)
+		*(int32_t*)(buffer + offset) = (int32_t)mem->disp;
+
+	return offset + disp_size;
+}
+
+/*
+Same as _nmd_assemble_mem_reg(), but the r/m field describes 'rm', which is either a memory operand or a general-purpose register of 'operand_size' bytes.
+If 'byte_regs' is '_NMD_BYTE_REGS_NONE', an 'rm' whose identifier is the one of 'ah' to 'bh' is a high byte register.
+*/
+NMD_ASSEMBLY_API size_t _nmd_assemble_rm_reg(uint8_t* buffer, NMD_X86_MODE mode, const nmd_x86_operand* rm, uint8_t opcode, uint8_t modrm_reg, size_t operand_size, uint8_t byte_regs)
+{
+	size_t offset = 0;
+	uint8_t index;
+
+	if (rm->type == NMD_X86_OPERAND_TYPE_MEMORY)
+		return _nmd_assemble_mem_reg(buffer, mode, &rm->fields.mem, opcode, modrm_reg, operand_size, byte_regs);
+	else if (rm->type != NMD_X86_OPERAND_TYPE_REGISTER || _nmd_get_gpr_size((NMD_X86_REG)rm->fields.reg) != operand_size)
+		return 0;
+
+	index = _nmd_get_gpr_index((NMD_X86_REG)rm->fields.reg);
+	if (!_nmd_append_operand_size_prefixes(buffer, &offset, mode, operand_size, (modrm_reg & 8 ? 0x04 : 0) | (index & 8 ? 0x01 : 0), (byte_regs == _NMD_BYTE_REGS_NONE && _nmd_is_high_byte_reg(rm->fields.reg)) ? (uint8_t)_NMD_BYTE_REGS_HIGH : byte_regs))
+		return 0;
+
+	buffer[offset++] = opcode;
+	buffer[offset++] = (uint8_t)(0b11000000 | ((modrm_reg % 8) << 3) | (index % 8));
 	return offset;
 }
 
-NMD_ASSEMBLY_API size_t _nmd_assemble_single(_nmd_assemble_info* ai)
+/* Returns the length of a relative branch. 'mnemonic' is '_NMD_X86_ASM_MNEMONIC_JMP', '_NMD_X86_ASM_MNEMONIC_CALL' or a conditional jump. */
+NMD_ASSEMBLY_API size_t _nmd_get_relative_branch_length(NMD_X86_MODE mode, uint8_t mnemonic, bool is_short)
 {
-    const char* s;
-    int64_t num;
-    size_t num_digits;
-    NMD_X86_REG reg, reg2;
-	size_t i = 0;
+	if (is_short)
+		return 2;
 
-	/* Parse prefixes */
-	bool lock_prefix = false, repeat_prefix = false, repeat_zero_prefix = false, repeat_not_zero_prefix = false;
-	if (_nmd_strstr(ai->s, "lock ") == ai->s)
-		lock_prefix = true, ai->s += 5;
-	else if (_nmd_strstr(ai->s, "rep ") == ai->s)
-		repeat_prefix = true, ai->s += 4;
-	else if (_nmd_strstr(ai->s, "repe ") == ai->s || _nmd_strstr(ai->s, "repz ") == ai->s)
-		repeat_zero_prefix = true, ai->s += 5;
-	else if (_nmd_strstr(ai->s, "repne ") == ai->s || _nmd_strstr(ai->s, "repnz ") == ai->s)
-		repeat_not_zero_prefix = true, ai->s += 6;
-	
-	if (_nmd_strstr(ai->s, "xacquire ") == ai->s)
-	{
+	return (mode == NMD_X86_MODE_16 ? 1 : 0) + (mnemonic >= _NMD_X86_ASM_MNEMONIC_JO && mnemonic <= _NMD_X86_ASM_MNEMONIC_JG ? 2 : 1) + 4;
+}
 
-	}
-	else if (_nmd_strstr(ai->s, "xrelease ") == ai->s)
+/*
+Assembles a relative branch('jmp', 'call' or a conditional jump) to the address 'delta' bytes after the start of the instruction. The short form has an 8-bit displacement
+and doesn't exist for 'call', the long form has a 32-bit displacement(and the operand size prefix in 16-bit mode). Returns the number of bytes written, or zero if the displacement doesn't fit.
+*/
+NMD_ASSEMBLY_API size_t _nmd_assemble_relative_branch(uint8_t* b, NMD_X86_MODE mode, uint8_t mnemonic, int64_t delta, bool is_short)
+{
+	const bool is_conditional = mnemonic >= _NMD_X86_ASM_MNEMONIC_JO && mnemonic <= _NMD_X86_ASM_MNEMONIC_JG;
+	const size_t length = _nmd_get_relative_branch_length(mode, mnemonic, is_short);
+	const int64_t disp = delta - (int64_t)length;
+	size_t offset = 0;
+
+	if (is_short)
 	{
+		if (mnemonic == _NMD_X86_ASM_MNEMONIC_CALL || disp < -0x80 || disp > 0x7f)
+			return 0;
 
+		b[0] = (uint8_t)(is_conditional ? 0x70 + (mnemonic - _NMD_X86_ASM_MNEMONIC_JO) : 0xeb);
+		b[1] = (uint8_t)disp;
+		return 2;
 	}
+	else if (disp < -(int64_t)0x80000000 || disp > 0x7fffffff)
+		return 0;
+
+	if (mode == NMD_X86_MODE_16)
+		b[offset++] = 0x66;
 
-	/* Parse opcodes */
-	if (ai->mode == NMD_X86_MODE_64) /* Only x86-64. */
+	if (is_conditional)
 	{
-		if (_nmd_strstr(ai->s, "mov "))
-		{
-			const char* s = ai->s + 4;
-			if ((reg = _nmd_parse_regrxb((const char**)&s)))
-			{
-				ai->b[0] = 0x41;
-				ai->b[1] = 0xb0 + (reg - NMD_X86_REG_R8B);
+		b[offset++] = 0x0f;
+		b[offset++] = (uint8_t)(0x80 + (mnemonic - _NMD_X86_ASM_MNEMONIC_JO));
+	}
+	else
+		b[offset++] = (uint8_t)(mnemonic == _NMD_X86_ASM_MNEMONIC_JMP ? 0xe9 : 0xe8);
 
-				if (*s++ != ',')
-					return 0;
+	*(int32_t*)(b + offset) = (int32_t)disp;
+	return length;
+}
 
-				if ((num_digits = _nmd_parse_number(s, &num)))
-				{
-					ai->b[2] = (uint8_t)num;
-					return 3;
-				}
-			}
+/* Assembles an instruction without operands. Returns the number of bytes written, or zero if 'mnemonic'(a member of '_NMD_X86_ASM_MNEMONIC') requires operands or is not valid in 'mode'. */
+NMD_ASSEMBLY_API size_t _nmd_assemble_without_operands(uint8_t* b, NMD_X86_MODE mode, uint8_t mnemonic)
+{
+	if (mnemonic >= _NMD_X86_ASM_MNEMONIC_INT3 && mnemonic <= _NMD_X86_ASM_MNEMONIC_STD)
+	{
+		b[0] = _nmd_x86_asm_op1_bytes[mnemonic - _NMD_X86_ASM_MNEMONIC_INT3];
+		return 1;
+	}
+	else if (mnemonic >= _NMD_X86_ASM_MNEMONIC_SYSCALL && mnemonic <= _NMD_X86_ASM_MNEMONIC_RSM)
+	{
+		b[0] = 0x0f;
+		b[1] = _nmd_x86_asm_op2_bytes[mnemonic - _NMD_X86_ASM_MNEMONIC_SYSCALL];
+		return 2;
+	}
+
+	switch (mnemonic)
+	{
+	case _NMD_X86_ASM_MNEMONIC_PUSHFQ:
+	case _NMD_X86_ASM_MNEMONIC_POPFQ:
+		if (mode != NMD_X86_MODE_64)
+			return 0;
+		b[0] = mnemonic == _NMD_X86_ASM_MNEMONIC_PUSHFQ ? 0x9c : 0x9d;
+		return 1;
+	case _NMD_X86_ASM_MNEMONIC_IRETQ:
+	case _NMD_X86_ASM_MNEMONIC_CDQE:
+	case _NMD_X86_ASM_MNEMONIC_CQO:
+		if (mode != NMD_X86_MODE_64)
+			return 0;
+		b[0] = 0x48;
+		b[1] = mnemonic == _NMD_X86_ASM_MNEMONIC_IRETQ ? 0xcf : (mnemonic == _NMD_X86_ASM_MNEMONIC_CDQE ? 0x98 : 0x99);
+		return 2;
+	case _NMD_X86_ASM_MNEMONIC_PUSHAD:
+	case _NMD_X86_ASM_MNEMONIC_POPAD:
+	case _NMD_X86_ASM_MNEMONIC_PUSHFD:
+	case _NMD_X86_ASM_MNEMONIC_POPFD:
+	case _NMD_X86_ASM_MNEMONIC_PUSHA:
+	case _NMD_X86_ASM_MNEMONIC_POPA:
+	{
+		/* The 32-bit forms need the operand size prefix in 16-bit mode and the 16-bit forms need it in 32-bit mode */
+		const bool is_32bit_form = mnemonic == _NMD_X86_ASM_MNEMONIC_PUSHAD || mnemonic == _NMD_X86_ASM_MNEMONIC_POPAD || mnemonic == _NMD_X86_ASM_MNEMONIC_PUSHFD || mnemonic == _NMD_X86_ASM_MNEMONIC_POPFD;
+		size_t offset = 0;
+		if (mode == NMD_X86_MODE_64)
+			return 0;
+		if ((mode == NMD_X86_MODE_16) == is_32bit_form)
+			b[offset++] = 0x66;
+		switch (mnemonic)
+		{
+		case _NMD_X86_ASM_MNEMONIC_PUSHAD: case _NMD_X86_ASM_MNEMONIC_PUSHA: b[offset++] = 0x60; break;
+		case _NMD_X86_ASM_MNEMONIC_POPAD: case _NMD_X86_ASM_MNEMONIC_POPA: b[offset++] = 0x61; break;
+		case _NMD_X86_ASM_MNEMONIC_PUSHFD: b[offset++] = 0x9c; break;
+		default: b[offset++] = 0x9d; break;
+		}
+		return offset;
+	}
+	case _NMD_X86_ASM_MNEMONIC_PUSHF:
+	case _NMD_X86_ASM_MNEMONIC_POPF:
+	case _NMD_X86_ASM_MNEMONIC_IRET:
+	case _NMD_X86_ASM_MNEMONIC_CBW:
+	case _NMD_X86_ASM_MNEMONIC_CWD:
+	{
+		/* 16-bit forms */
+		size_t offset = 0;
+		if (mode != NMD_X86_MODE_16)
+			b[offset++] = 0x66;
+		switch (mnemonic)
+		{
+		case _NMD_X86_ASM_MNEMONIC_PUSHF: b[offset++] = 0x9c; break;
+		case _NMD_X86_ASM_MNEMONIC_POPF: b[offset++] = 0x9d; break;
+		case _NMD_X86_ASM_MNEMONIC_IRET: b[offset++] = 0xcf; break;
+		case _NMD_X86_ASM_MNEMONIC_CBW: b[offset++] = 0x98; break;
+		default: b[offset++] = 0x99; break;
+		}
+		return offset;
+	}
+	case _NMD_X86_ASM_MNEMONIC_IRETD:
+	case _NMD_X86_ASM_MNEMONIC_CWDE:
+	case _NMD_X86_ASM_MNEMONIC_CDQ:
+	{
+		/* 32-bit forms */
+		size_t offset = 0;
+		if (mode == NMD_X86_MODE_16)
+			b[offset++] = 0x66;
+		b[offset++] = mnemonic == _NMD_X86_ASM_MNEMONIC_IRETD ? 0xcf : (mnemonic == _NMD_X86_ASM_MNEMONIC_CWDE ? 0x98 : 0x99);
+		return offset;
+	}
+	case _NMD_X86_ASM_MNEMONIC_PAUSE:
+		b[0] = 0xf3;
+		b[1] = 0x90;
+		return 2;
+	}
+
+	return 0;
+}
+
+/* Assembles the instruction whose mnemonic is the first 'length' characters of 'ai->s'. Prefixes were already parsed by _nmd_assemble_single(). */
+NMD_ASSEMBLY_API size_t _nmd_assemble_instruction(_nmd_assemble_info* ai, uint8_t mnemonic, size_t length)
+{
+	const char* s;
+	int64_t num;
+	size_t num_digits;
+	NMD_X86_REG reg, reg2;
+	size_t i = 0;
+
+	if (!mnemonic || (ai->s[length] != ' ' && ai->s[length] != '\0'))
+		return 0;
+
+	/* Make 'ai->s' point to the operands. It's an empty string if the instruction has no operands */
+	ai->s += ai->s[length] == ' ' ? length + 1 : length;
+
+	if (!*ai->s)
+		return _nmd_assemble_without_operands(ai->b, ai->mode, mnemonic);
+
+	/* Parse 'add', 'adc', 'and', 'xor', 'or', 'sbb', 'sub' and 'cmp' . Opcodes in first "4 rows"/[80, 83] */
+	if (mnemonic >= _NMD_X86_ASM_MNEMONIC_ADD && mnemonic <= _NMD_X86_ASM_MNEMONIC_CMP)
+	{
+		i = mnemonic - _NMD_X86_ASM_MNEMONIC_ADD;
+		const uint8_t base_opcode = (i % 4) * 0x10 + (i >= 4 ? 8 : 0);
+
+		nmd_x86_memory_operand memory_operand;
+		size_t pointer_size, offset = 0, size;
+		if (_nmd_parse_memory_operand((const char**)&ai->s, &memory_operand, &pointer_size)) /* Colum 00,01,08,09 */
+		{
+			if (*ai->s++ != ',' || !(reg = _nmd_parse_reg((const char**)&ai->s)) || *ai->s)
+				return 0;
+
+			size = _nmd_get_gpr_size(reg);
+			if (pointer_size && pointer_size != size)
+				return 0;
+
+			return _nmd_assemble_mem_reg(ai->b, ai->mode, &memory_operand, base_opcode + (size == 1 ? 0 : 1), _nmd_get_gpr_index(reg), size, _nmd_is_high_byte_reg(reg) ? _NMD_BYTE_REGS_HIGH : _NMD_BYTE_REGS_NONE);
+		}
+		else if (_nmd_strstr_ex(ai->s, "al,", &s) == ai->s && _nmd_parse_immediate(s, &num)) /* column 04,0C */
+		{
+			if (num < -0x80 || num > 0xff)
+				return 0;
+
+			ai->b[0] = base_opcode + 4;
+			ai->b[1] = (int8_t)num;
+			return 2;
 		}
-		else if (_nmd_strstr(ai->s, "push ") == ai->s || _nmd_strstr(ai->s, "pop ") == ai->s)
+		else if ((_nmd_strstr_ex(ai->s, "eax,", &s) == ai->s || _nmd_strstr_ex(ai->s, "ax,", &s) == ai->s || _nmd_strstr_ex(ai->s, "rax,", &s) == ai->s) && _nmd_parse_immediate(s, &num)) /* column 05,0D */
 		{
-			const bool is_push = ai->s[1] == 'u';
-			s = ai->s + (is_push ? 5 : 4);
-			if (((reg = _nmd_parse_reg64(&s))) && !*s)
+			size = ai->s[0] == 'e' ? 4 : (ai->s[0] == 'r' ? 8 : 2);
+			if (!_nmd_append_operand_size_prefixes(ai->b, &offset, ai->mode, size, 0, _NMD_BYTE_REGS_NONE))
+				return 0;
+
+			/* A sign-extended 8-bit immediate is shorter(83 /r), the same choice nmd_x86_encode() makes */
+			if (num >= -0x80 && num <= 0x7f)
 			{
-				ai->b[0] = (is_push ? 0x50 : 0x58) + reg % 8;
-				return 1;
+				ai->b[offset++] = 0x83;
+				ai->b[offset++] = (uint8_t)(0b11000000 | base_opcode); /* ModR/M.reg is the opcode's row */
+				ai->b[offset++] = (uint8_t)num;
+				return offset;
 			}
-			else if ((reg = _nmd_parse_regrxw(&s)) && !*s)
+
+			ai->b[offset++] = base_opcode + 5;
+
+			if (size == 2)
 			{
-				ai->b[0] = 0x66;
-				ai->b[1] = 0x41;
-				ai->b[2] = (is_push ? 0x50 : 0x58) + reg % 8;
-				return 3;
+				if (num < -0x8000 || num > 0xffff)
+					return 0;
+
+				*(int16_t*)(ai->b + offset) = (int16_t)num;
+				return offset + 2;
 			}
-			else if (((reg = _nmd_parse_regrx(&s))) && !*s)
+			else
 			{
-				ai->b[0] = 0x41;
-				ai->b[1] = (is_push ? 0x50 : 0x58) + reg % 8;
-				return 2;
+				/* The 64-bit form sign-extends the 32-bit immediate */
+				if (num < -(int64_t)0x80000000 || num > (size == 8 ? 0x7fffffff : 0xffffffff))
+					return 0;
+
+				*(int32_t*)(ai->b + offset) = (int32_t)num;
+				return offset + 4;
 			}
 		}
-		else if (_nmd_strstr(ai->s, "mov ") == ai->s)
+		else if ((reg = _nmd_parse_reg((const char**)&ai->s)) && *ai->s++ == ',') /* column 00-04,08-0B */
 		{
-			ai->s += 4;
-			if ((reg = _nmd_parse_reg8((const char**)&ai->s)))
+			if (_nmd_parse_memory_operand((const char**)&ai->s, &memory_operand, &pointer_size)) /* column 02,03,0A,0B */
+			{
+				return 0;
+			}
+			else /* 00,01,08,09 */
 			{
-				ai->b[0] = 0xb0 + reg % 8;
+				if (!(reg2 = _nmd_parse_reg((const char**)&ai->s)) || *ai->s)
+					return 0;
 
-				if (*ai->s++ != ',')
+				size = _nmd_get_gpr_size(reg);
+				if (size != _nmd_get_gpr_size(reg2))
 					return 0;
 
-				if ((num_digits = _nmd_parse_number(ai->s, &num)))
-				{
-					ai->b[1] = (uint8_t)num;
-					return 2;
-				}
+				const uint8_t index = _nmd_get_gpr_index(reg), index2 = _nmd_get_gpr_index(reg2);
+				if (!_nmd_append_operand_size_prefixes(ai->b, &offset, ai->mode, size, (index2 & 8 ? 0x04 : 0) | (index & 8 ? 0x01 : 0), (_nmd_is_high_byte_reg(reg) || _nmd_is_high_byte_reg(reg2)) ? _NMD_BYTE_REGS_HIGH : _NMD_BYTE_REGS_NONE))
+					return 0;
+
+				ai->b[offset++] = base_opcode + (size == 1 ? 0 : 1);
+
+				/* mod = 0b11, reg = reg2, rm = reg */
+				ai->b[offset++] = 0b11000000 | ((index2 % 8) << 3) | (index % 8);
+
+				return offset;
 			}
 		}
-		else if (_nmd_strcmp(ai->s, "xchg r8,rax") || _nmd_strcmp(ai->s, "xchg rax,r8"))
-		{
-			ai->b[0] = 0x49;
-			ai->b[1] = 0x90;
-			return 2;
-		}
-		else if (_nmd_strcmp(ai->s, "xchg r8d,eax") || _nmd_strcmp(ai->s, "xchg eax,r8d"))
-		{
-			ai->b[0] = 0x41;
-			ai->b[1] = 0x90;
-			return 2;
-		}
-		else if (_nmd_strcmp(ai->s, "pushfq"))
-		{
-			ai->b[0] = 0x9c;
-			return 1;
-		}
-		else if (_nmd_strcmp(ai->s, "popfq"))
-		{
-			ai->b[0] = 0x9d;
-			return 1;
-		}
-		else if (_nmd_strcmp(ai->s, "iretq"))
-		{
-			ai->b[0] = 0x48;
-			ai->b[1] = 0xcf;
-			return 2;
-		}
-		else if (_nmd_strcmp(ai->s, "cdqe"))
-		{
-			ai->b[0] = 0x48;
-			ai->b[1] = 0x98;
-			return 2;
-		}
-		else if (_nmd_strcmp(ai->s, "cqo"))
-		{
-			ai->b[0] = 0x48;
-			ai->b[1] = 0x99;
-			return 2;
-		}
+
+		return 0;
+	}
+
+	/* Parse conditional jumps. The shortest encoding is used */
+	if (mnemonic >= _NMD_X86_ASM_MNEMONIC_JO && mnemonic <= _NMD_X86_ASM_MNEMONIC_JG)
+	{
+		if (!_nmd_parse_immediate(ai->s, &num))
+			return 0;
+
+		const int64_t delta = (ai->runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? num : num - (int64_t)ai->runtime_address);
+		length = _nmd_assemble_relative_branch(ai->b, ai->mode, mnemonic, delta, true);
+		return length ? length : _nmd_assemble_relative_branch(ai->b, ai->mode, mnemonic, delta, false);
 	}
-	else /* x86-16 / x86-32 */
+
+	switch (mnemonic)
 	{
-		if (_nmd_strstr(ai->s, "inc ") || _nmd_strstr(ai->s, "dec "))
+	case _NMD_X86_ASM_MNEMONIC_MOV:
+		s = ai->s;
+		if (ai->mode == NMD_X86_MODE_64 && (reg = _nmd_parse_regrxb(&s)))
 		{
-			const bool is_inc = ai->s[0] == 'i';
-			s = ai->s + 4;
-			int offset = 0;
-			if (((reg = _nmd_parse_reg32(&s))) && !*s)
-			{
-				if (ai->mode == NMD_X86_MODE_16)
-					ai->b[offset++] = 0x66;
-			}
-			else if (((reg = _nmd_parse_reg16(&s))) && !*s)
-			{
-				if (ai->mode == NMD_X86_MODE_32)
-					ai->b[offset++] = 0x66;
-			}
-			else
+			ai->b[0] = 0x41;
+			ai->b[1] = 0xb0 + (reg - NMD_X86_REG_R8B);
+
+			if (*s++ != ',')
 				return 0;
 
-			ai->b[offset++] = (is_inc ? 0x40 : 0x48) + reg % 8;
-			return offset;
-		}
-		else if (_nmd_strstr(ai->s, "push ") == ai->s || _nmd_strstr(ai->s, "pop ") == ai->s)
-		{
-			const bool is_push = ai->s[1] == 'u';
-			s = ai->s + (is_push ? 5 : 4);
-			if (((reg = _nmd_parse_reg32(&s))) && !*s)
+			if (_nmd_parse_immediate(s, &num))
 			{
-				if (ai->mode == NMD_X86_MODE_16)
-				{
-					ai->b[0] = 0x66;
-					ai->b[1] = (is_push ? 0x50 : 0x58) + reg % 8;
-					return 2;
-				}
-				else
-				{
-					ai->b[0] = (is_push ? 0x50 : 0x58) + reg % 8;
-					return 1;
-				}
+				ai->b[2] = (uint8_t)num;
+				return 3;
 			}
+			return 0;
 		}
-		else if (_nmd_strcmp(ai->s, "pushad"))
+		else if ((reg = _nmd_parse_reg8(&s)))
 		{
-			if (ai->mode == NMD_X86_MODE_16)
+			ai->b[0] = 0xb0 + (reg - NMD_X86_REG_AL);
+
+			if (*s++ != ',')
+				return 0;
+
+			if (_nmd_parse_immediate(s, &num))
 			{
-				ai->b[0] = 0x66;
-				ai->b[1] = 0x60;
+				ai->b[1] = (uint8_t)num;
 				return 2;
 			}
-			else
-			{
-				ai->b[0] = 0x60;
-				return 1;
-			}
 		}
-		else if (_nmd_strcmp(ai->s, "pusha"))
+		return 0;
+
+	case _NMD_X86_ASM_MNEMONIC_PUSH:
+	case _NMD_X86_ASM_MNEMONIC_POP:
+	{
+		const bool is_push = mnemonic == _NMD_X86_ASM_MNEMONIC_PUSH;
+		s = ai->s;
+		if (ai->mode == NMD_X86_MODE_64)
 		{
-			if (ai->mode == NMD_X86_MODE_16)
+			if ((reg = _nmd_parse_reg64(&s)) && !*s)
 			{
-				ai->b[0] = 0x60;
+				ai->b[0] = (is_push ? 0x50 : 0x58) + reg % 8;
 				return 1;
 			}
-			else
+			else if ((reg = _nmd_parse_regrxw(&s)) && !*s)
 			{
 				ai->b[0] = 0x66;
-				ai->b[1] = 0x60;
+				ai->b[1] = 0x41;
+				ai->b[2] = (is_push ? 0x50 : 0x58) + reg % 8;
+				return 3;
+			}
+			else if ((reg = _nmd_parse_regrx(&s)) && !*s)
+			{
+				ai->b[0] = 0x41;
+				ai->b[1] = (is_push ? 0x50 : 0x58) + reg % 8;
 				return 2;
 			}
 		}
-		else if (_nmd_strcmp(ai->s, "popad"))
+		else if ((reg = _nmd_parse_reg32(&s)) && !*s)
 		{
 			if (ai->mode == NMD_X86_MODE_16)
 			{
 				ai->b[0] = 0x66;
-				ai->b[1] = 0x61;
+				ai->b[1] = (is_push ? 0x50 : 0x58) + reg % 8;
 				return 2;
 			}
 			else
 			{
-				ai->b[0] = 0x61;
+				ai->b[0] = (is_push ? 0x50 : 0x58) + reg % 8;
 				return 1;
 			}
 		}
-		else if (_nmd_strcmp(ai->s, "popa"))
+
+		s = ai->s;
+		if ((reg = _nmd_parse_reg_range(&s, NMD_X86_REG_ES, NMD_X86_REG_GS)) && !*s)
 		{
-			if (ai->mode == NMD_X86_MODE_16)
+			if (reg == NMD_X86_REG_FS || reg == NMD_X86_REG_GS)
 			{
-				ai->b[0] = 0x61;
-				return 1;
+				ai->b[0] = 0x0f;
+				ai->b[1] = (reg == NMD_X86_REG_FS ? 0xa0 : 0xa8) + (is_push ? 0 : 1);
+				return 2;
 			}
-			else
+			else if (is_push || reg != NMD_X86_REG_CS)
 			{
-				ai->b[0] = 0x66;
-				ai->b[1] = 0x61;
-				return 2;
+				ai->b[0] = 0x06 + (uint8_t)(reg - NMD_X86_REG_ES) * 8 + (is_push ? 0 : 1);
+				return 1;
 			}
+			return 0;
 		}
-		else if (_nmd_strcmp(ai->s, "pushfd"))
+
+		if ((reg = _nmd_parse_reg16((const char**)&ai->s)))
 		{
 			if (ai->mode == NMD_X86_MODE_16)
 			{
-				ai->b[0] = 0x66;
-				ai->b[1] = 0x9c;
-				return 2;
+				ai->b[0] = (is_push ? 0x50 : 0x58) + reg % 8;
+				return 1;
 			}
 			else
 			{
-				ai->b[0] = 0x9c;
-				return 1;
+				ai->b[0] = 0x66;
+				ai->b[1] = (is_push ? 0x50 : 0x58) + reg % 8;
+				return 2;
 			}
 		}
-		else if (_nmd_strcmp(ai->s, "popfd"))
+		else if (is_push && _nmd_parse_immediate(ai->s, &num))
 		{
-			if (ai->mode == NMD_X86_MODE_16)
+			if (num >= -(1 << 7) && num <= (1 << 7) - 1)
 			{
-				ai->b[0] = 0x66;
-				ai->b[1] = 0x9d;
+				ai->b[0] = 0x6a;
+				*(int8_t*)(ai->b + 1) = (int8_t)num;
 				return 2;
 			}
 			else
 			{
-				ai->b[0] = 0x9d;
-				return 1;
+				size_t offset = 0;
+				if (ai->mode == NMD_X86_MODE_16)
+					ai->b[offset++] = 0x66;
+				ai->b[offset++] = 0x68;
+				*(int32_t*)(ai->b + offset) = (int32_t)num;
+				return offset + 4;
 			}
 		}
+		return 0;
 	}
 
-	typedef struct _nmd_string_byte_pair { const char* s; uint8_t b; } _nmd_string_byte_pair;
-
-	const _nmd_string_byte_pair single_byte_op1[] = {
-		{ "int3",    0xcc },
-		{ "nop",     0x90 },
-		{ "ret",     0xc3 },
-		{ "retf",    0xcb },
-		{ "ret far", 0xcb },
-		{ "leave",   0xc9 },
-		{ "int1",    0xf1 },
-		{ "push es", 0x06 },
-		{ "push ss", 0x16 },
-		{ "push ds", 0x1e },
-		{ "push cs", 0x0e },
-		{ "pop es",  0x07 },
-		{ "pop ss",  0x17 },
-		{ "pop ds",  0x1f },
-		{ "daa",     0x27 },
-		{ "aaa",     0x37 },
-		{ "das",     0x2f },
-		{ "aas",     0x3f },
-		{ "xlat",    0xd7 },
-		{ "fwait",   0x9b },
-		{ "hlt",     0xf4 },
-		{ "cmc",     0xf5 },
-		{ "clc",     0xf8 },
-		{ "sahf",    0x9e },
-		{ "lahf",    0x9f },
-		{ "into",    0xce },
-		{ "salc",    0xd6 },
-		{ "slc",     0xf8 },
-		{ "stc",     0xf9 },
-		{ "cli",     0xfa },
-		{ "sti",     0xfb },
-		{ "cld",     0xfc },
-		{ "std",     0xfd },
-	};
-	for (i = 0; i < _NMD_NUM_ELEMENTS(single_byte_op1); i++)
-	{
-		if (_nmd_strcmp(ai->s, single_byte_op1[i].s))
+	case _NMD_X86_ASM_MNEMONIC_XCHG:
+		if (ai->mode != NMD_X86_MODE_64)
+			return 0;
+		else if (_nmd_strcmp(ai->s, "r8,rax") || _nmd_strcmp(ai->s, "rax,r8"))
 		{
-			ai->b[0] = single_byte_op1[i].b;
-			return 1;
+			ai->b[0] = 0x49;
+			ai->b[1] = 0x90;
+			return 2;
 		}
-	}
-
-	const _nmd_string_byte_pair single_byte_op2[] = {
-		{ "syscall",  0x05 },
-		{ "clts",     0x06 },
-		{ "sysret",   0x07 },
-		{ "invd",     0x08 },
-		{ "wbinvd",   0x09 },
-		{ "ud2",      0x0b },
-		{ "femms",    0x0e },
-		{ "wrmsr",    0x30 },
-		{ "rdtsc",    0x31 },
-		{ "rdmsr",    0x32 },
-		{ "rdpmc",    0x33 },
-		{ "sysenter", 0x34 },
-		{ "sysexit",  0x35 },
-		{ "getsec",   0x37 },
-		{ "emms",     0x77 },
-		{ "push fs",  0xa0 },
-		{ "pop fs",   0xa1 },
-		{ "cpuid",    0xa2 },
-		{ "push gs",  0xa8 },
-		{ "pop gs",   0xa9 },
-		{ "rsm",      0xaa }
-	};
-	for (i = 0; i < _NMD_NUM_ELEMENTS(single_byte_op2); i++)
-	{
-		if (_nmd_strcmp(ai->s, single_byte_op2[i].s))
+		else if (_nmd_strcmp(ai->s, "r8d,eax") || _nmd_strcmp(ai->s, "eax,r8d"))
 		{
-			ai->b[0] = 0x0f;
-			ai->b[1] = single_byte_op2[i].b;
+			ai->b[0] = 0x41;
+			ai->b[1] = 0x90;
 			return 2;
 		}
-	}
-	
-	/* Parse 'add', 'adc', 'and', 'xor', 'or', 'sbb', 'sub' and 'cmp' . Opcodes in first "4 rows"/[80, 83] */
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_op1_opcode_map_mnemonics); i++)
+		return 0;
+
+	case _NMD_X86_ASM_MNEMONIC_INC:
+	case _NMD_X86_ASM_MNEMONIC_DEC:
 	{
-		if (_nmd_strstr(ai->s, _nmd_op1_opcode_map_mnemonics[i]) == ai->s)
+		const bool is_inc = mnemonic == _NMD_X86_ASM_MNEMONIC_INC;
+		if (ai->mode != NMD_X86_MODE_64)
 		{
-			const uint8_t base_opcode = (i % 4) * 0x10 + (i >= 4 ? 8 : 0);
-			ai->s += 4;
-            
-			nmd_x86_memory_operand memory_operand;
-			size_t pointer_size;
-			if (_nmd_parse_memory_operand((const char**)&ai->s, &memory_operand, &pointer_size)) /* Colum 00,01,08,09 */
-			{                
-				if (*ai->s++ != ',' || !(reg = _nmd_parse_reg((const char**)&ai->s)))
-					return 0;
-                
-				return _nmd_assemble_mem_reg(ai->b, &memory_operand, base_opcode, reg % 8);
-
-				/*
-				size_t offset = 0;
-				if (memory_operand.segment && memory_operand.segment != ((memory_operand.base == NMD_X86_REG_ESP || memory_operand.index == NMD_X86_REG_ESP) ? NMD_X86_REG_SS : NMD_X86_REG_DS))
-					ai->b[offset++] = _nmd_encode_segment_reg((NMD_X86_REG)memory_operand.segment);
-				
-				if (pointer_size == 1)
-				{
-					ai->b[offset++] = base_opcode + 0;
-				
-					if (*ai->s++ != ',')
-						return 0;
-				
-					NMD_X86_REG reg = _nmd_parse_reg(&ai->s);
-				
-					nmd_x86_modrm modrm;
-					modrm.fields.mod = 0;
-					modrm.fields.reg = (reg - 1) % 8;
-					modrm.fields.rm = (memory_operand.base - 1) % 8;
-				
-					ai->b[offset++] = modrm.modrm;
-				
-					return offset;
-				}
-				*/
-			}
-            else if (_nmd_strstr_ex(ai->s, "al,", &s) == ai->s && (num_digits = _nmd_parse_number(s, &num)) && *(s + num_digits) == '\0') /* column 04,0C */
+			s = ai->s;
+			int offset = 0;
+			if (((reg = _nmd_parse_reg32(&s))) && !*s)
 			{
-				if (num < -0x80 || num > 0xff)
-					return 0;
-
-				ai->b[0] = base_opcode + 4;
-				ai->b[1] = (int8_t)num;
-				return 2;
+				if (ai->mode == NMD_X86_MODE_16)
+					ai->b[offset++] = 0x66;
+				ai->b[offset++] = (is_inc ? 0x40 : 0x48) + reg % 8;
+				return offset;
 			}
-			else if ((_nmd_strstr_ex(ai->s, "eax,", &s) == ai->s || _nmd_strstr_ex(ai->s, "ax,", &s) == ai->s || _nmd_strstr_ex(ai->s, "rax,", &s) == ai->s) && _nmd_parse_number(s, &num)) /* column 05,0D */
+			else if (((reg = _nmd_parse_reg16(&s))) && !*s)
 			{
-				const bool is_eax = ai->s[0] == 'e';
-				const bool is_ax = ai->s[1] == 'x';
-
-				if (is_eax)
-				{
-					if (num < -(int64_t)0x80000000 || num > 0xffffffff)
-						return 0;
-
-					ai->b[0] = base_opcode + 5;
-					*(int32_t*)(ai->b + 1) = (int32_t)num;
-					return 5;
-				}
-				else if (!is_eax)
-				{
-					if (ai->mode != NMD_X86_MODE_64 && !is_ax)
-						return 0;
-
-					ai->b[0] = is_ax ? 0x66 : 0x48;
-					ai->b[1] = base_opcode + 5;
-
-					if (is_ax)
-					{
-						if (num < -0x8000 || num > 0xffff)
-							return 0;
-
-						*(int16_t*)(ai->b + 2) = (int16_t)num;
-						return 4;
-					}
-					else
-					{
-						if (num < -(int64_t)0x80000000 || num > 0xffffffff)
-							return 0;
-
-						*(int32_t*)(ai->b + 2) = (int32_t)num;
-						return 6;
-					}
-				}
+				if (ai->mode == NMD_X86_MODE_32)
+					ai->b[offset++] = 0x66;
+				ai->b[offset++] = (is_inc ? 0x40 : 0x48) + reg % 8;
+				return offset;
 			}
-            else if ((reg = _nmd_parse_reg((const char**)&ai->s)) && *ai->s++ == ',') /* column 00-04,08-0B */
-            {
-                if(_nmd_parse_memory_operand((const char**)&ai->s, &memory_operand, &pointer_size)) /* column 02,03,0A,0B */
-                {
-                    return 0;
-                }
-                else /* 00,01,08,09 */
-                {
-                    if(!(reg2 = _nmd_parse_reg((const char**)&ai->s)))
-                        return 0;
-                    
-                    ai->b[0] = base_opcode;
-                    
-                    /* mod = 0b11, reg = reg2, rm = reg */
-                    ai->b[1] = 0b11000000 | ((reg2 % 8) << 3) | (reg % 8);
-                    
-                    return 2;
-                }
-            }
-
-			return 0;
 		}
-	}
 
-	if (_nmd_strstr(ai->s, "jmp ") == ai->s)
-	{
-		if (!(num_digits = _nmd_parse_number(ai->s + 4, &num)) && ai->s[4 + num_digits] == '\0')
-			return 0;
-
-		size_t offset = 0;
-		if (ai->mode == NMD_X86_MODE_16)
-			ai->b[offset++] = 0x66;
-		ai->b[offset++] = 0xe9;
-		const int64_t size = (int64_t)offset + 4;
-		*(uint32_t*)(ai->b + offset) = (uint32_t)((ai->runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS) ? (num - size) : (ai->runtime_address + size + num));
-		return size;
-	}
-	else if (ai->s[0] == 'j')
-	{
-		char* s = ai->s;
-		while (true)
-		{
-			if (*s == ' ')
-			{
-				*s = '\0';
-				break;
-			}
-			else if (*s == '\0')
-				return 0;
-
-			s++;
-		}
-
-		for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_condition_suffixes); i++)
-		{
-			if (_nmd_strcmp(ai->s + 1, _nmd_condition_suffixes[i]))
-			{
-				if (!(num_digits = _nmd_parse_number(s + 1, &num)))
-					return 0;
-
-				const int64_t delta = (ai->runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? num : num - ai->runtime_address);
-				if (delta >= -(1 << 7) + 2 && delta <= (1 << 7) - 1 + 2)
-				{
-					ai->b[0] = 0x70 + (uint8_t)i;
-					*(int8_t*)(ai->b + 1) = (int8_t)(delta - 2);
-					return 2;
-				}
-				else if (delta >= -((int64_t)1 << 31) + 6 && delta <= ((int64_t)1 << 31) - 1 + 6)
-				{
-					size_t offset = 0;
-					if (ai->mode == NMD_X86_MODE_16)
-						ai->b[offset++] = 0x66;
-
-					ai->b[offset++] = 0x0f;
-					ai->b[offset++] = 0x80 + (uint8_t)i;
-					*(int32_t*)(ai->b + offset) = (int32_t)(delta - (offset+4));
-					return offset + 4;
-				}
-			}
-		}
-	}
-	else if (_nmd_strstr(ai->s, "inc ") == ai->s || _nmd_strstr(ai->s, "dec ") == ai->s)
-	{
-		const char* tmp = ai->s + 4;
+		const char* tmp = ai->s;
 		nmd_x86_memory_operand memory_operand;
 		size_t size;
 		if (_nmd_parse_memory_operand(&tmp, &memory_operand, &size))
 		{
-			size_t offset = 0;
-			if (memory_operand.segment && memory_operand.segment != ((memory_operand.base == NMD_X86_REG_ESP || memory_operand.index == NMD_X86_REG_ESP) ? NMD_X86_REG_SS : NMD_X86_REG_DS))
-				ai->b[offset++] = _nmd_encode_segment_reg((NMD_X86_REG)memory_operand.segment);
-
-			ai->b[offset++] = size == 1 ? 0xfe : 0xff;
-
-			nmd_x86_modrm modrm;
-			modrm.fields.reg = ai->s[0] == 'i' ? 0 : 8;
-			modrm.fields.mod = 0;
-
-			if (memory_operand.index != NMD_X86_REG_NONE && memory_operand.base != NMD_X86_REG_NONE)
-			{
-				modrm.fields.rm = 0b100;
-				nmd_x86_sib sib;
-				sib.fields.scale = (uint8_t)_nmd_get_bit_index(memory_operand.scale);
-				sib.fields.base = memory_operand.base - NMD_X86_REG_EAX;
-				sib.fields.index = memory_operand.index - NMD_X86_REG_EAX;
-
-				const size_t next_offset = offset;
-				if (memory_operand.disp != 0)
-				{
-					if (memory_operand.disp >= -128 && memory_operand.disp <= 127)
-					{
-						modrm.fields.mod = 1;
-						*(int8_t*)(ai->b + offset + 2) = (int8_t)memory_operand.disp;
-						offset++;
-					}
-					else
-					{
-						modrm.fields.mod = 2;
-						*(int32_t*)(ai->b + offset + 2) = (int32_t)memory_operand.disp;
-						offset += 4;
-					}
-				}
-
-				ai->b[next_offset] = modrm.modrm;
-				ai->b[next_offset + 1] = sib.sib;
-				offset += 2;
-
-				return offset;
-			}
-			else if (memory_operand.base != NMD_X86_REG_NONE)
-			{
-				modrm.fields.rm = memory_operand.base - NMD_X86_REG_EAX;
-				const size_t next_offset = offset;
-				if (memory_operand.disp != 0)
-				{
-					if (memory_operand.disp >= -128 && memory_operand.disp <= 127)
-					{
-						modrm.fields.mod = 1;
-						*(int8_t*)(ai->b + offset + 1) = (int8_t)memory_operand.disp;
-						offset++;
-					}
-					else
-					{
-						modrm.fields.mod = 2;
-						*(int32_t*)(ai->b + offset + 1) = (int32_t)memory_operand.disp;
-						offset += 4;
-					}
-				}
-				ai->b[next_offset] = modrm.modrm;
-				offset++;
-			}
-			else
-			{
-				modrm.fields.rm = 0b101;
-				ai->b[offset++] = modrm.modrm;
-				*(int32_t*)(ai->b + offset) = (int32_t)memory_operand.disp;
-				offset += 4;
-			}
+			if (*tmp)
+				return 0;
 
-			return offset;
+			/* The operand is a dword if the pointer size is not specified */
+			return _nmd_assemble_mem_reg(ai->b, ai->mode, &memory_operand, size == 1 ? 0xfe : 0xff, is_inc ? 0 : 1, size ? size : 4, _NMD_BYTE_REGS_NONE);
 		}
 
 		size_t num_prefixes, index;
-		size = _nmd_append_prefix_by_reg_size(ai->b, ai->s + 4, &num_prefixes, &index);
+		size = _nmd_append_prefix_by_reg_size(ai->b, ai->s, &num_prefixes, &index);
 		if (size > 0)
 		{
-			if (ai->mode == NMD_X86_MODE_64)
-			{
-				ai->b[num_prefixes + 0] = size == 1 ? 0xfe : 0xff;
-				ai->b[num_prefixes + 1] = 0xc0 + (ai->s[0] == 'i' ? 0 : 8) + (uint8_t)index;
-				return num_prefixes + 2;
-			}
-			else
-			{
-				if (size == 1)
-				{
-					ai->b[0] = 0xfe;
-					ai->b[1] = 0xc0 + (ai->s[0] == 'i' ? 0 : 8) + (uint8_t)index;
-					return 2;
-				}
-				else
-				{
-					ai->b[num_prefixes + 0] = (ai->s[0] == 'i' ? 0x40 : 0x48) + (uint8_t)index;
-					return num_prefixes + 1;
-				}
-			}
-		}
-	}
-	else if (_nmd_strstr(ai->s, "call ") == ai->s)
-	{
-		if ((num_digits = _nmd_parse_number(ai->s + 5, &num)))
-		{
-			ai->b[0] = 0xe8;
-			if(ai->runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS)
-				*(int32_t*)(ai->b + 1) = (int32_t)(num - 5);
-			else
-				*(int32_t*)(ai->b + 1) = (int32_t)(num - (ai->runtime_address + 5));
-			return 5;
-		}
-	}
-	else if (_nmd_strstr(ai->s, "push ") == ai->s || _nmd_strstr(ai->s, "pop ") == ai->s)
-	{
-		const bool is_push = ai->s[1] == 'u';
-		ai->s += is_push ? 5 : 4;
-		NMD_X86_REG reg;
-		if ((reg = _nmd_parse_reg16((const char**)&ai->s)))
-		{
-			if (ai->mode == NMD_X86_MODE_16)
-			{
-				ai->b[0] = (is_push ? 0x50 : 0x58) + reg % 8;
-				return 1;
-			}
-			else
-			{
-				ai->b[0] = 0x66;
-				ai->b[1] = (is_push ? 0x50 : 0x58) + reg % 8;
-				return 2;
-			}
-		}
-		else if (is_push && (num_digits = _nmd_parse_number(ai->s, &num)) && ai->s[num_digits] == '\0')
-		{
-			if (num >= -(1 << 7) && num <= (1 << 7) - 1)
-			{
-				ai->b[0] = 0x6a;
-				*(int8_t*)(ai->b + 1) = (int8_t)num;
-				return 2;
-			}
-			else
-			{
-				size_t offset = 0;
-				if (ai->mode == NMD_X86_MODE_16)
-					ai->b[offset++] = 0x66;
-				ai->b[offset++] = 0x68;
-				*(int32_t*)(ai->b + offset) = (int32_t)num;
-				return offset + 4;
-			}
+			/* Only 8-bit registers reach here in 16-bit and 32-bit mode, the other prefixes are REX prefixes */
+			if (ai->mode != NMD_X86_MODE_64 && num_prefixes)
+				return 0;
+
+			ai->b[num_prefixes + 0] = size == 1 ? 0xfe : 0xff;
+			ai->b[num_prefixes + 1] = 0xc0 + (is_inc ? 0 : 8) + (uint8_t)index;
+			return num_prefixes + 2;
 		}
+		return 0;
 	}
-	else if (_nmd_strstr(ai->s, "mov ") == ai->s)
+
+	case _NMD_X86_ASM_MNEMONIC_JMP:
+	case _NMD_X86_ASM_MNEMONIC_CALL:
+		if (!_nmd_parse_immediate(ai->s, &num))
+			return 0;
+		return _nmd_assemble_relative_branch(ai->b, ai->mode, mnemonic, ai->runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? num : num - (int64_t)ai->runtime_address, false);
+
+	case _NMD_X86_ASM_MNEMONIC_RET:
+	case _NMD_X86_ASM_MNEMONIC_RETF:
 	{
-		ai->s += 4;
-		const NMD_X86_REG reg = _nmd_parse_reg8((const char**)&ai->s);
-		if (reg)
+		const bool is_far = mnemonic == _NMD_X86_ASM_MNEMONIC_RETF;
+		if (!is_far && _nmd_strcmp(ai->s, "far"))
 		{
-			ai->b[0] = 0xb0 + (reg - NMD_X86_REG_AL);
-			
-			if (*ai->s++ != ',')
-				return 0;
-            
-			if ((num_digits = _nmd_parse_number(ai->s, &num)))
-			{
-				ai->b[1] = (uint8_t)num;
-				return 2;
-			}
+			ai->b[0] = 0xcb;
+			return 1;
 		}
-	}
-	else if (_nmd_strstr(ai->s, "ret ") == ai->s || _nmd_strstr(ai->s, "retf ") == ai->s)
-	{
-		const bool is_far = ai->s[3] == 'f';
-		ai->s += is_far ? 5 : 4;
-        
-		if ((num_digits = _nmd_parse_number(ai->s, &num)) && ai->s[num_digits] == '\0')
+		else if (_nmd_parse_immediate(ai->s, &num))
 		{
 			ai->b[0] = is_far ? 0xca : 0xc2;
 			*(uint16_t*)(ai->b + 1) = (uint16_t)num;
 			return 3;
 		}
+		return 0;
 	}
-	else if (_nmd_strstr(ai->s, "emit ") == ai->s)
+
+	case _NMD_X86_ASM_MNEMONIC_INT:
+		if (_nmd_parse_immediate(ai->s, &num))
+		{
+			ai->b[0] = 0xcd;
+			ai->b[1] = (uint8_t)num;
+			return 2;
+		}
+		return 0;
+
+	case _NMD_X86_ASM_MNEMONIC_EMIT:
 	{
-		size_t offset = 5;
+		size_t offset = 0;
 		while ((num_digits = _nmd_parse_number(ai->s + offset, &num)))
 		{
-			if (num < 0 || num > 0xff)
+			if (num < 0 || num > 0xff || i == NMD_X86_MAXIMUM_INSTRUCTION_LENGTH)
 				return 0;
 
 			ai->b[i++] = (uint8_t)num;
@@ -1347,120 +1203,446 @@ NMD_ASSEMBLY_API size_t _nmd_assemble_single(_nmd_assemble_info* ai)
 		}
 		return i;
 	}
-	else if (_nmd_strcmp(ai->s, "pushf"))
+	}
+
+	return 0;
+}
+
+/* Assembles a single instruction, which may have the 'lock' prefix and one of the 'rep', 'repe', 'repz', 'repne' and 'repnz' prefixes. Returns zero on failure. */
+NMD_ASSEMBLY_API size_t _nmd_assemble_single(_nmd_assemble_info* ai)
+{
+	uint8_t* const b = ai->b;
+	const uint64_t runtime_address = ai->runtime_address;
+	bool has_lock = false, has_repeat = false;
+	size_t length;
+	uint8_t mnemonic;
+
+	/* Encode the prefixes in the order they are written */
+	while (true)
 	{
-		if (ai->mode == NMD_X86_MODE_16)
+		length = _nmd_get_token_length(ai->s);
+		mnemonic = _nmd_find_asm_mnemonic(ai->s, length);
+		if (mnemonic < _NMD_X86_ASM_MNEMONIC_LOCK || mnemonic > _NMD_X86_ASM_MNEMONIC_REPNZ || ai->s[length] != ' ')
+			break;
+
+		if (mnemonic == _NMD_X86_ASM_MNEMONIC_LOCK)
 		{
-			ai->b[0] = 0x9c;
-			return 1;
+			if (has_lock)
+				return 0;
+			has_lock = true;
+			*ai->b++ = 0xf0;
 		}
 		else
 		{
-			ai->b[0] = 0x66;
-			ai->b[1] = 0x9c;
-			return 2;
+			if (has_repeat)
+				return 0;
+			has_repeat = true;
+			*ai->b++ = mnemonic >= _NMD_X86_ASM_MNEMONIC_REPNE ? 0xf2 : 0xf3;
 		}
+
+		ai->s += length + 1;
 	}
-	else if (_nmd_strcmp(ai->s, "popf"))
+
+	/* Relative branches are relative to the end of the instruction, prefixes included */
+	if (runtime_address != NMD_X86_INVALID_RUNTIME_ADDRESS)
+		ai->runtime_address += (size_t)(ai->b - b);
+
+	length = _nmd_assemble_instruction(ai, mnemonic, length);
+	if (length)
+		length += (size_t)(ai->b - b);
+
+	ai->b = b;
+	ai->runtime_address = runtime_address;
+	return length;
+}
+
+
+/*
+Copies the instruction at '*string' to 'parsed_string' converting it to lowercase and removing unwanted spaces, then makes '*string' point to the next instruction.
+Instructions are separated by the '\n'(new line) character. Returns the length of the parsed string, or (size_t)(-1) if it would have more than 255 characters.
+*/
+NMD_ASSEMBLY_API size_t _nmd_parse_line(const char** string, char* parsed_string)
+{
+	const char* s = *string;
+	char prev_c = ' '; /* Leading spaces are skipped */
+	size_t length = 0;
+
+	while (*s && *s != '\n')
 	{
-		if (ai->mode == NMD_X86_MODE_16)
-		{
-			ai->b[0] = 0x9d;
-			return 1;
-		}
-		else
-		{
-			ai->b[0] = 0x66;
-			ai->b[1] = 0x9d;
-			return 2;
-		}
+		const char c = *s++;
+
+		/* Ignore(skip) the current character if it's a space and the previous character is one of the following: ' ', '+', '*', '[' */
+		if (c == ' ' && (prev_c == ' ' || prev_c == '+' || prev_c == '*' || prev_c == '['))
+			continue;
+
+		/* The maximum length is 255 */
+		if (length >= 255)
+			return (size_t)(-1);
+
+		parsed_string[length++] = _NMD_TOLOWER(c);
+		prev_c = c;
 	}
-	else if (_nmd_strcmp(ai->s, "pause"))
+
+	/* Skip the instruction separator character */
+	if (*s /* == '\n' */)
+		s++;
+
+	/* If the last character is a space, remove it. */
+	if (length > 0 && parsed_string[length - 1] == ' ')
+		length--;
+
+	parsed_string[length] = '\0';
+	*string = s;
+	return length;
+}
+
+/*
+Assembles one or more instructions from a string. Returns the number of bytes written to the buffer on success, zero otherwise. Instructions can be separated using the '\n'(new line) character.
+Parameters:
+ - string          [in]         A pointer to a string that represents one or more instructions in assembly language.
+ - buffer          [out]        A pointer to a buffer that receives the encoded instructions.
+ - buffer_size     [in]         The size of the buffer in bytes.
+ - runtime_address [in]         The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - mode            [in]         The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - count           [in/out/opt] A pointer to a variable that on input is the maximum number of instructions that can be parsed, and on output the number of instructions parsed. This parameter may be null.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_assemble(const char* string, void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, size_t* count)
+{
+	if (!*string)
+		return 0;
+
+	const uint8_t* const buffer_end = (uint8_t*)buffer + buffer_size;
+	const size_t num_max_instructions = count ? *count : (size_t)(-1);
+	size_t num_instructions = 0;
+	char parsed_string[256];
+	uint8_t temp_buffer[15]; /* The assembling takes place on this buffer instead of the user's buffer because the assembler doesn't check the buffer size. If it assembled directly to the user's buffer it could access bad memory */
+	uint8_t* b = (uint8_t*)buffer;
+	size_t remaining_size;
+
+	_nmd_assemble_info ai;
+	ai.mode = mode;
+	ai.runtime_address = runtime_address;
+	ai.b = temp_buffer;
+
+	while (*string && num_instructions < num_max_instructions)
 	{
-		ai->b[0] = 0xf3;
-		ai->b[1] = 0x90;
-		return 2;
+		remaining_size = buffer_end - b;
+
+		if (_nmd_parse_line(&string, parsed_string) == (size_t)(-1))
+			return 0;
+
+		/* Try to assemble the instruction */
+		ai.s = parsed_string;
+		const size_t num_bytes = _nmd_assemble_single(&ai);
+		if (num_bytes == 0 || num_bytes > remaining_size)
+			return 0;
+
+		/* Copy bytes from 'temp_buffer' to 'buffer' */
+		size_t i = 0;
+		for (; i < num_bytes; i++)
+			b[i] = temp_buffer[i];
+		b += num_bytes;
+
+		/* The next instruction starts where this one ends */
+		if (ai.runtime_address != NMD_X86_INVALID_RUNTIME_ADDRESS)
+			ai.runtime_address += num_bytes;
+
+		num_instructions++;
 	}
-	else if (_nmd_strcmp(ai->s, "iret"))
+
+	if (count)
+		*count = num_instructions;
+
+	/* Return the number of bytes written to the buffer */
+	return (size_t)((ptrdiff_t)b - (ptrdiff_t)buffer);
+}
+
+/* Returns the assembler's mnemonic('_NMD_X86_ASM_MNEMONIC') of an instruction without explicit operands identified by 'id'(a member of 'NMD_X86_INSTRUCTION'), or '_NMD_X86_ASM_MNEMONIC_NONE'. */
+NMD_ASSEMBLY_API uint8_t _nmd_get_asm_mnemonic_without_operands(uint16_t id)
+{
+#define _NMD_ASM_MNEMONIC_CASE(name) case NMD_X86_INSTRUCTION_##name: return _NMD_X86_ASM_MNEMONIC_##name;
+	switch (id)
 	{
-		if (ai->mode == NMD_X86_MODE_16)
-		{
-			ai->b[0] = 0xcf;
-			return 1;
-		}
-		else
-		{
-			ai->b[0] = 0x66;
-			ai->b[1] = 0xcf;
-			return 2;
-		}
+	_NMD_ASM_MNEMONIC_CASE(INT3) _NMD_ASM_MNEMONIC_CASE(NOP) _NMD_ASM_MNEMONIC_CASE(RET) _NMD_ASM_MNEMONIC_CASE(RETF) _NMD_ASM_MNEMONIC_CASE(LEAVE) _NMD_ASM_MNEMONIC_CASE(INT1)
+	_NMD_ASM_MNEMONIC_CASE(DAA) _NMD_ASM_MNEMONIC_CASE(AAA) _NMD_ASM_MNEMONIC_CASE(DAS) _NMD_ASM_MNEMONIC_CASE(AAS) _NMD_ASM_MNEMONIC_CASE(XLAT) _NMD_ASM_MNEMONIC_CASE(FWAIT)
+	_NMD_ASM_MNEMONIC_CASE(HLT) _NMD_ASM_MNEMONIC_CASE(CMC) _NMD_ASM_MNEMONIC_CASE(CLC) _NMD_ASM_MNEMONIC_CASE(SAHF) _NMD_ASM_MNEMONIC_CASE(LAHF) _NMD_ASM_MNEMONIC_CASE(INTO)
+	_NMD_ASM_MNEMONIC_CASE(SALC) _NMD_ASM_MNEMONIC_CASE(STC) _NMD_ASM_MNEMONIC_CASE(CLI) _NMD_ASM_MNEMONIC_CASE(STI) _NMD_ASM_MNEMONIC_CASE(CLD) _NMD_ASM_MNEMONIC_CASE(STD)
+	_NMD_ASM_MNEMONIC_CASE(SYSCALL) _NMD_ASM_MNEMONIC_CASE(CLTS) _NMD_ASM_MNEMONIC_CASE(SYSRET) _NMD_ASM_MNEMONIC_CASE(INVD) _NMD_ASM_MNEMONIC_CASE(WBINVD) _NMD_ASM_MNEMONIC_CASE(UD2)
+	_NMD_ASM_MNEMONIC_CASE(FEMMS) _NMD_ASM_MNEMONIC_CASE(WRMSR) _NMD_ASM_MNEMONIC_CASE(RDTSC) _NMD_ASM_MNEMONIC_CASE(RDMSR) _NMD_ASM_MNEMONIC_CASE(RDPMC) _NMD_ASM_MNEMONIC_CASE(SYSENTER)
+	_NMD_ASM_MNEMONIC_CASE(SYSEXIT) _NMD_ASM_MNEMONIC_CASE(GETSEC) _NMD_ASM_MNEMONIC_CASE(EMMS) _NMD_ASM_MNEMONIC_CASE(CPUID) _NMD_ASM_MNEMONIC_CASE(RSM)
+	_NMD_ASM_MNEMONIC_CASE(PUSHF) _NMD_ASM_MNEMONIC_CASE(POPF) _NMD_ASM_MNEMONIC_CASE(PUSHFD) _NMD_ASM_MNEMONIC_CASE(POPFD) _NMD_ASM_MNEMONIC_CASE(PUSHFQ) _NMD_ASM_MNEMONIC_CASE(POPFQ)
+	_NMD_ASM_MNEMONIC_CASE(PUSHA) _NMD_ASM_MNEMONIC_CASE(PUSHAD) _NMD_ASM_MNEMONIC_CASE(POPA) _NMD_ASM_MNEMONIC_CASE(POPAD) _NMD_ASM_MNEMONIC_CASE(IRET) _NMD_ASM_MNEMONIC_CASE(IRETD)
+	_NMD_ASM_MNEMONIC_CASE(IRETQ) _NMD_ASM_MNEMONIC_CASE(PAUSE) _NMD_ASM_MNEMONIC_CASE(CBW) _NMD_ASM_MNEMONIC_CASE(CWDE) _NMD_ASM_MNEMONIC_CASE(CDQE) _NMD_ASM_MNEMONIC_CASE(CWD)
+	_NMD_ASM_MNEMONIC_CASE(CDQ) _NMD_ASM_MNEMONIC_CASE(CQO)
+	default: return _NMD_X86_ASM_MNEMONIC_NONE;
 	}
-	else if (_nmd_strcmp(ai->s, "iretd"))
+#undef _NMD_ASM_MNEMONIC_CASE
+}
+
+/*
+Converts 'imm' to an immediate of 'size' bytes, which is returned sign-extended in 'p_imm'. Immediates smaller than 8 bytes may be either sign-extended
+or zero-extended(e.g. -1 and 0xff are the same byte), 8-byte immediates are taken as they are. Returns false if 'imm' doesn't fit in 'size' bytes.
+*/
+NMD_ASSEMBLY_API bool _nmd_get_sized_immediate(int64_t imm, size_t size, int64_t* p_imm)
+{
+	if (size < 8)
 	{
-		if (ai->mode == NMD_X86_MODE_16)
-		{
-			ai->b[0] = 0x66;
-			ai->b[1] = 0xcf;
-			return 2;
-		}
-		else
-		{
-			ai->b[0] = 0xcf;
-			return 1;
-		}
+		const int64_t mask = ((int64_t)1 << (size * 8)) - 1;
+		if (imm < -(mask / 2) - 1 || imm > mask)
+			return false;
+		imm = _nmd_sign_extend((uint64_t)imm, size);
 	}
-	else if (_nmd_strcmp(ai->s, "pushf"))
+
+	*p_imm = imm;
+	return true;
+}
+
+/* Appends an immediate of 'size' bytes. */
+NMD_ASSEMBLY_API size_t _nmd_append_immediate(uint8_t* buffer, int64_t imm, size_t size)
+{
+	size_t i = 0;
+	for (; i < size; i++)
+		buffer[i] = (uint8_t)((uint64_t)imm >> (i * 8));
+	return size;
+}
+
+/* Encodes an instruction described by 'instruction' to 'b', which must have at least 'NMD_X86_MAXIMUM_INSTRUCTION_LENGTH' bytes. Returns the number of bytes written, zero on failure. */
+NMD_ASSEMBLY_API size_t _nmd_encode(const nmd_x86_instruction* instruction, uint8_t* b)
+{
+	const NMD_X86_MODE mode = (NMD_X86_MODE)instruction->mode;
+	const nmd_x86_operand* operands[2] = { 0, 0 };
+	const nmd_x86_operand* reg_operand = 0;
+	const nmd_x86_operand* rm_operand = 0;
+	size_t num_operands = 0, offset = 0, size = 0, length, i;
+	int64_t imm;
+	uint8_t reg = 0, index, byte_regs = _NMD_BYTE_REGS_NONE;
+
+	/* Only the explicit operands describe the instruction */
+	for (i = 0; i < instruction->num_operands && i < NMD_X86_MAXIMUM_NUM_OPERANDS; i++)
 	{
-		ai->b[0] = 0x66;
-		ai->b[1] = 0x9c;
-		return 2;
+		if (instruction->operands[i].is_implicit)
+			continue;
+		else if (num_operands == 2)
+			return 0;
+
+		operands[num_operands++] = &instruction->operands[i];
 	}
-	else if (_nmd_strcmp(ai->s, "popf"))
+
+	/* The operand size is the size of the first register operand. If no register operand exists, it's the size of the memory operand(a dword if unknown) */
+	for (i = 0; i < num_operands; i++)
 	{
-		ai->b[0] = 0x66;
-		ai->b[1] = 0x9d;
-		return 2;
+		if (operands[i]->type == NMD_X86_OPERAND_TYPE_REGISTER && !reg_operand)
+		{
+			reg_operand = operands[i];
+			reg = operands[i]->fields.reg;
+			size = _nmd_get_gpr_size((NMD_X86_REG)reg);
+		}
+		else if (operands[i]->type == NMD_X86_OPERAND_TYPE_MEMORY)
+			rm_operand = operands[i];
+
+		/* The decoder describes 'spl', 'bpl', 'sil' and 'dil' as 'ah' to 'bh' in an instruction with a REX prefix */
+		if (operands[i]->type == NMD_X86_OPERAND_TYPE_REGISTER && _nmd_is_high_byte_reg(operands[i]->fields.reg))
+			byte_regs = instruction->has_rex ? _NMD_BYTE_REGS_REX : _NMD_BYTE_REGS_HIGH;
 	}
-	else if (_nmd_strcmp(ai->s, "cwde"))
+	if (!reg_operand && rm_operand)
+		size = rm_operand->fields.mem.size ? rm_operand->fields.mem.size : 4;
+	index = _nmd_get_gpr_index((NMD_X86_REG)reg);
+
+	/* 16-bit addressing can't be encoded. Registers such as '[bx+si]' are rejected when the operand is encoded, an operand without registers('[di]' is decoded as one) is
+	   a 16-bit displacement in 16-bit mode without the address size prefix and in 32-bit mode with it */
+	if (rm_operand && !rm_operand->fields.mem.base && !rm_operand->fields.mem.index && mode != NMD_X86_MODE_64 && (mode == NMD_X86_MODE_16) != !!(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE))
+		return 0;
+
+	/* The operand of a far branch('call ptr16:32'(9A)) is a pointer, not a displacement */
+	if (instruction->opcode_map == NMD_X86_OPCODE_MAP_DEFAULT && instruction->opcode == 0x9a)
+		return 0;
+
+	if (instruction->prefixes & NMD_X86_PREFIXES_LOCK)
+		b[offset++] = 0xf0;
+
+	/* Instructions without explicit operands */
+	if (num_operands == 0)
 	{
-		int offset = 0;
-		if (ai->mode == NMD_X86_MODE_16)
-			ai->b[offset++] = 0x66;
-		ai->b[offset++] = 0x98;
-		return offset;
+		length = _nmd_assemble_without_operands(b + offset, mode, _nmd_get_asm_mnemonic_without_operands(instruction->id));
+		return length ? offset + length : 0;
 	}
-	else if (_nmd_strstr(ai->s, "int ") == ai->s)
+
+	switch (instruction->id)
+	{
+	case NMD_X86_INSTRUCTION_ADD:
+	case NMD_X86_INSTRUCTION_OR:
+	case NMD_X86_INSTRUCTION_ADC:
+	case NMD_X86_INSTRUCTION_SBB:
+	case NMD_X86_INSTRUCTION_AND:
+	case NMD_X86_INSTRUCTION_SUB:
+	case NMD_X86_INSTRUCTION_XOR:
+	case NMD_X86_INSTRUCTION_CMP:
+	case NMD_X86_INSTRUCTION_MOV:
 	{
-		ai->s += 4;
-		if ((num_digits = _nmd_parse_number(ai->s, &num)) && ai->s[num_digits] == '\0')
+		/* The identifiers from 'add' to 'cmp' are in the same order as the opcodes('add' is 00, 'or' is 08...) */
+		const bool is_mov = instruction->id == NMD_X86_INSTRUCTION_MOV;
+		const uint8_t alu = (uint8_t)(instruction->id - NMD_X86_INSTRUCTION_ADD);
+		if (num_operands != 2 || !size)
+			return 0;
+
+		if (operands[1]->type == NMD_X86_OPERAND_TYPE_IMMEDIATE)
 		{
-			ai->b[0] = 0xcd;
-			ai->b[1] = (uint8_t)num;
-			return 2;
+			/* The immediate of a 64-bit operand is a sign-extended 32-bit immediate, except for 'mov reg,imm64' */
+			if (!_nmd_get_sized_immediate(operands[1]->fields.imm, size, &imm))
+				return 0;
+
+			if (operands[0]->type == NMD_X86_OPERAND_TYPE_REGISTER && (is_mov ? (size < 8 || imm < -(int64_t)0x80000000 || imm > 0x7fffffff) : (index == 0 && !(size > 1 && imm >= -0x80 && imm <= 0x7f))))
+			{
+				/* 'mov reg,imm'(B0-BF) or 'op al/ax/eax/rax,imm'(04,05,0C,0D...) */
+				if (!_nmd_append_operand_size_prefixes(b, &offset, mode, size, index & 8 ? 0x01 : 0, byte_regs))
+					return 0;
+				b[offset++] = (uint8_t)(is_mov ? (size == 1 ? 0xb0 : 0xb8) + index % 8 : alu * 8 + (size == 1 ? 4 : 5));
+				return offset + _nmd_append_immediate(b + offset, imm, (is_mov || size < 4) ? size : 4);
+			}
+			else
+			{
+				/* 'op r/m,imm'(80,81,83) or 'mov r/m,imm'(C6,C7) */
+				const bool imm8 = !is_mov && size > 1 && imm >= -0x80 && imm <= 0x7f;
+				if (size == 8 && (imm < -(int64_t)0x80000000 || imm > 0x7fffffff))
+					return 0;
+				if (!(length = _nmd_assemble_rm_reg(b + offset, mode, operands[0], (uint8_t)(is_mov ? (size == 1 ? 0xc6 : 0xc7) : (size == 1 ? 0x80 : (imm8 ? 0x83 : 0x81))), is_mov ? 0 : alu, size, byte_regs)))
+					return 0;
+				offset += length;
+				return offset + _nmd_append_immediate(b + offset, imm, (size == 1 || imm8) ? 1 : (size == 2 ? 2 : 4));
+			}
 		}
+		else if (operands[1]->type == NMD_X86_OPERAND_TYPE_REGISTER && _nmd_get_gpr_size((NMD_X86_REG)operands[1]->fields.reg) == size) /* 'op r/m,reg'(00,01,08,09...,88,89) */
+			length = _nmd_assemble_rm_reg(b + offset, mode, operands[0], (uint8_t)((is_mov ? 0x88 : alu * 8) + (size > 1)), _nmd_get_gpr_index((NMD_X86_REG)operands[1]->fields.reg), size, byte_regs);
+		else if (operands[0]->type == NMD_X86_OPERAND_TYPE_REGISTER && operands[1]->type == NMD_X86_OPERAND_TYPE_MEMORY) /* 'op reg,mem'(02,03,0A,0B...,8A,8B) */
+			length = _nmd_assemble_mem_reg(b + offset, mode, &operands[1]->fields.mem, (uint8_t)((is_mov ? 0x8a : alu * 8 + 2) + (size > 1)), index, size, byte_regs);
+		else
+			return 0;
+
+		return length ? offset + length : 0;
 	}
-	else if (_nmd_strcmp(ai->s, "cbw"))
+
+	case NMD_X86_INSTRUCTION_LEA:
+		if (num_operands != 2 || operands[0]->type != NMD_X86_OPERAND_TYPE_REGISTER || operands[1]->type != NMD_X86_OPERAND_TYPE_MEMORY || size < 2)
+			return 0;
+		length = _nmd_assemble_mem_reg(b + offset, mode, &operands[1]->fields.mem, 0x8d, index, size, _NMD_BYTE_REGS_NONE);
+		return length ? offset + length : 0;
+
+	case NMD_X86_INSTRUCTION_INC:
+	case NMD_X86_INSTRUCTION_DEC:
 	{
-		int offset = 0;
-		if (ai->mode != NMD_X86_MODE_16)
-			ai->b[offset++] = 0x66;
-		ai->b[offset++] = 0x98;
-		return offset;
+		const bool is_inc = instruction->id == NMD_X86_INSTRUCTION_INC;
+		if (num_operands != 1 || !size)
+			return 0;
+
+		/* The short forms(40-4F) are REX prefixes in 64-bit mode */
+		if (reg_operand && mode != NMD_X86_MODE_64 && size > 1)
+		{
+			if (!_nmd_append_operand_size_prefixes(b, &offset, mode, size, 0, _NMD_BYTE_REGS_NONE))
+				return 0;
+			b[offset++] = (uint8_t)((is_inc ? 0x40 : 0x48) + index);
+			return offset;
+		}
+
+		length = _nmd_assemble_rm_reg(b + offset, mode, operands[0], (uint8_t)(size == 1 ? 0xfe : 0xff), is_inc ? 0 : 1, size, byte_regs);
+		return length ? offset + length : 0;
 	}
-	else if (_nmd_strcmp(ai->s, "cdq"))
+
+	case NMD_X86_INSTRUCTION_PUSH:
+	case NMD_X86_INSTRUCTION_POP:
 	{
-		int offset = 0;
-		if (ai->mode == NMD_X86_MODE_16)
-			ai->b[offset++] = 0x66;
-		ai->b[offset++] = 0x99;
-		return offset;
+		const bool is_push = instruction->id == NMD_X86_INSTRUCTION_PUSH;
+		if (num_operands != 1)
+			return 0;
+
+		if (operands[0]->type == NMD_X86_OPERAND_TYPE_IMMEDIATE)
+		{
+			/* The operand size is the default one. In 64-bit mode the immediate is sign-extended */
+			size = mode == NMD_X86_MODE_16 ? 2 : 4;
+			if (!is_push || !_nmd_get_sized_immediate(operands[0]->fields.imm, mode == NMD_X86_MODE_64 ? 8 : size, &imm) || imm < -(int64_t)0x80000000 || imm > 0x7fffffff)
+				return 0;
+
+			b[offset++] = (uint8_t)(imm >= -0x80 && imm <= 0x7f ? 0x6a : 0x68);
+			return offset + _nmd_append_immediate(b + offset, imm, b[offset - 1] == 0x6a ? 1 : size);
+		}
+		else if (reg >= NMD_X86_REG_ES && reg <= NMD_X86_REG_GS)
+		{
+			if (reg == NMD_X86_REG_FS || reg == NMD_X86_REG_GS)
+			{
+				b[offset++] = 0x0f;
+				b[offset++] = (uint8_t)((reg == NMD_X86_REG_FS ? 0xa0 : 0xa8) + (is_push ? 0 : 1));
+				return offset;
+			}
+			else if (mode == NMD_X86_MODE_64 || (!is_push && reg == NMD_X86_REG_CS))
+				return 0;
+
+			b[offset++] = (uint8_t)(0x06 + (reg - NMD_X86_REG_ES) * 8 + (is_push ? 0 : 1));
+			return offset;
+		}
+		else if (reg_operand)
+		{
+			/* 32-bit registers can't be pushed in 64-bit mode, 64-bit registers can only be pushed in 64-bit mode */
+			if (size == 1 || (size == 8) != (mode == NMD_X86_MODE_64) || (size == 4 && mode == NMD_X86_MODE_64) || ((index & 8) && mode != NMD_X86_MODE_64))
+				return 0;
+
+			if ((size == 2) != (mode == NMD_X86_MODE_16))
+				b[offset++] = 0x66;
+			if (index & 8)
+				b[offset++] = 0x41;
+			b[offset++] = (uint8_t)((is_push ? 0x50 : 0x58) + index % 8);
+			return offset;
+		}
+		return 0;
 	}
-	else if (_nmd_strcmp(ai->s, "cwd"))
+
+	case NMD_X86_INSTRUCTION_JMP:
+	case NMD_X86_INSTRUCTION_CALL:
+	case NMD_X86_INSTRUCTION_JO: case NMD_X86_INSTRUCTION_JNO: case NMD_X86_INSTRUCTION_JB: case NMD_X86_INSTRUCTION_JNB:
+	case NMD_X86_INSTRUCTION_JZ: case NMD_X86_INSTRUCTION_JNZ: case NMD_X86_INSTRUCTION_JBE: case NMD_X86_INSTRUCTION_JA:
+	case NMD_X86_INSTRUCTION_JS: case NMD_X86_INSTRUCTION_JNS: case NMD_X86_INSTRUCTION_JP: case NMD_X86_INSTRUCTION_JNP:
+	case NMD_X86_INSTRUCTION_JL: case NMD_X86_INSTRUCTION_JGE: case NMD_X86_INSTRUCTION_JLE: case NMD_X86_INSTRUCTION_JG:
 	{
-		int offset = 0;
-		if (ai->mode != NMD_X86_MODE_16)
-			ai->b[offset++] = 0x66;
-		ai->b[offset++] = 0x99;
+		/* The immediate is the displacement relative to the end of the instruction, as filled by the decoder. If 'length' is set, the displacement is
+		   adjusted to the length of the new encoding so the target stays the same, otherwise it's relative to the end of the new encoding */
+		const size_t rel_size = mode == NMD_X86_MODE_16 ? 2 : 4;
+		const size_t long_length = offset + (instruction->id == NMD_X86_INSTRUCTION_JMP || instruction->id == NMD_X86_INSTRUCTION_CALL ? 1 : 2) + rel_size;
+		int64_t short_imm;
+		if (num_operands != 1 || operands[0]->type != NMD_X86_OPERAND_TYPE_IMMEDIATE)
+			return 0;
+
+		short_imm = instruction->length ? operands[0]->fields.imm + instruction->length - (int64_t)(offset + 2) : operands[0]->fields.imm;
+		if (instruction->id != NMD_X86_INSTRUCTION_CALL && short_imm >= -0x80 && short_imm <= 0x7f)
+		{
+			b[offset++] = (uint8_t)(instruction->id == NMD_X86_INSTRUCTION_JMP ? 0xeb : 0x70 + (instruction->id - NMD_X86_INSTRUCTION_JO));
+			b[offset++] = (uint8_t)short_imm;
+			return offset;
+		}
+
+		imm = instruction->length ? operands[0]->fields.imm + instruction->length - (int64_t)long_length : operands[0]->fields.imm;
+		if (rel_size == 2 ? (imm < -0x8000 || imm > 0x7fff) : (imm < -(int64_t)0x80000000 || imm > 0x7fffffff))
+			return 0;
+
+		if (instruction->id == NMD_X86_INSTRUCTION_JMP || instruction->id == NMD_X86_INSTRUCTION_CALL)
+			b[offset++] = (uint8_t)(instruction->id == NMD_X86_INSTRUCTION_JMP ? 0xe9 : 0xe8);
+		else
+		{
+			b[offset++] = 0x0f;
+			b[offset++] = (uint8_t)(0x80 + (instruction->id - NMD_X86_INSTRUCTION_JO));
+		}
+		return offset + _nmd_append_immediate(b + offset, imm, rel_size);
+	}
+
+	case NMD_X86_INSTRUCTION_RET:
+	case NMD_X86_INSTRUCTION_RETF:
+		if (num_operands != 1 || operands[0]->type != NMD_X86_OPERAND_TYPE_IMMEDIATE || !_nmd_get_sized_immediate(operands[0]->fields.imm, 2, &imm))
+			return 0;
+		b[offset++] = (uint8_t)(instruction->id == NMD_X86_INSTRUCTION_RET ? 0xc2 : 0xca);
+		return offset + _nmd_append_immediate(b + offset, imm, 2);
+
+	case NMD_X86_INSTRUCTION_INT:
+		if (num_operands != 1 || operands[0]->type != NMD_X86_OPERAND_TYPE_IMMEDIATE || !_nmd_get_sized_immediate(operands[0]->fields.imm, 1, &imm))
+			return 0;
+		b[offset++] = 0xcd;
+		b[offset++] = (uint8_t)imm;
 		return offset;
 	}
 
@@ -1468,105 +1650,328 @@ NMD_ASSEMBLY_API size_t _nmd_assemble_single(_nmd_assemble_info* ai)
 }
 
 /*
-Assembles one or more instructions from a string. Returns the number of bytes written to the buffer on success, zero otherwise. Instructions can be separated using the '\n'(new line) character.
+Encodes an instruction from a structured description instead of a string. Returns the number of bytes written to the buffer on success, zero otherwise.
+The description follows the decoder's conventions, so instructions filled by nmd_x86_decode() with 'NMD_X86_DECODER_FLAGS_OPERANDS' can be encoded again:
+ - 'mode' and 'id' select the instruction. Only the explicit operands(the ones whose 'is_implicit' is false) are used, the other variables are ignored
+   except 'prefixes', from which only 'NMD_X86_PREFIXES_LOCK' and 'NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE' are used, 'opcode' and 'opcode_map', which are only used
+   to reject far branches, 'length', see below, and 'has_rex', which makes the registers 'NMD_X86_REG_AH' to 'NMD_X86_REG_BH' mean 'spl', 'bpl', 'sil' and 'dil'
+   like in the decoder. 'ah' to 'bh' can't be used with registers that require a REX prefix.
+ - 16-bit addressing(e.g. '[bx+si]' or a 16-bit displacement) and far pointers('call ptr16:32') can't be encoded.
+ - The operand size is given by the register operands(e.g. 'ax' selects 16-bit operands), or else by the 'size' of the memory operand(a dword if zero).
+ - The immediate of a relative branch(e.g. 'jmp', 'jz' and 'call') is the displacement from the end of the instruction, whose length is 'length'.
+   The shortest encoding that reaches the same target is used and the displacement is adjusted to its length. If 'length' is zero, the displacement is
+   relative to the end of the new encoding instead.
+Supported instructions: instructions without explicit operands known by nmd_x86_assemble(), 'add', 'or', 'adc', 'sbb', 'and', 'sub', 'xor', 'cmp' and 'mov'
+(r/m,reg reg,mem r/m,imm), 'lea', 'inc', 'dec', 'push', 'pop'(reg, segment register, imm), 'jmp', 'call', 'jcc'(rel), 'ret', 'retf'(imm16) and 'int'(imm8).
 Parameters:
- - string          [in]         A pointer to a string that represents one or more instructions in assembly language.
- - buffer          [out]        A pointer to a buffer that receives the encoded instructions.
- - buffer_size     [in]         The size of the buffer in bytes.
- - runtime_address [in]         The instruction's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
- - mode            [in]         The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
- - count           [in/out/opt] A pointer to a variable that on input is the maximum number of instructions that can be parsed, and on output the number of instructions parsed. This parameter may be null.
+ - instruction [in]  A pointer to a variable of type 'nmd_x86_instruction' that describes the instruction.
+ - buffer      [out] A pointer to a buffer that receives the encoded instruction.
+ - buffer_size [in]  The size of the buffer in bytes.
 */
-NMD_ASSEMBLY_API size_t nmd_x86_assemble(const char* string, void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, size_t* count)
+NMD_ASSEMBLY_API size_t nmd_x86_encode(const nmd_x86_instruction* instruction, void* buffer, size_t buffer_size)
 {
-	if (!*string)
+	uint8_t temp_buffer[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH];
+	size_t length, i = 0;
+
+	/* The encoder doesn't check the buffer size, so small buffers receive a copy of the instruction */
+	if (buffer_size >= NMD_X86_MAXIMUM_INSTRUCTION_LENGTH)
+		return _nmd_encode(instruction, (uint8_t*)buffer);
+
+	length = _nmd_encode(instruction, temp_buffer);
+	if (length == 0 || length > buffer_size)
 		return 0;
 
-	const uint8_t* const buffer_end = (uint8_t*)buffer + buffer_size;
-	const size_t num_max_instructions = count ? *count : (size_t)(-1);
-	size_t num_instructions = 0;
+	for (; i < length; i++)
+		((uint8_t*)buffer)[i] = temp_buffer[i];
+
+	return length;
+}
+
+/* The kinds of elements recorded by nmd_x86_assemble_block(). */
+enum _NMD_BLOCK_ITEM
+{
+	_NMD_BLOCK_ITEM_INSTRUCTION = 0, /* An instruction assembled while parsing, whose bytes don't depend on its address. */
+	_NMD_BLOCK_ITEM_LABEL,           /* A label. Its length is zero. */
+	_NMD_BLOCK_ITEM_BRANCH,          /* A relative branch to an address. */
+	_NMD_BLOCK_ITEM_BRANCH_TO_LABEL  /* A relative branch to a label, or to an address if the name is also a number(e.g. 'beef') and no such label is defined. */
+};
+
+/* An element of the block. The elements are stored at the start of the arena. */
+typedef struct _nmd_block_item
+{
+	int64_t target;      /* The target of a branch: the label's index or the address(the offset relative to the instruction if the runtime address is invalid). */
+	uint32_t offset;     /* The offset of the element relative to the start of the block. */
+	uint32_t name;       /* The offset of the name of a label(or the label a branch refers to) relative to the start of the arena. */
+	uint8_t type;        /* A member of '_NMD_BLOCK_ITEM'. */
+	uint8_t length;      /* The length of the instruction in bytes. */
+	uint8_t mnemonic;    /* The mnemonic('_NMD_X86_ASM_MNEMONIC') of a branch. */
+	bool is_number;      /* True if the name of the label a branch refers to is also a number, stored in 'target' until the labels are resolved. */
+	uint16_t name_length; /* The number of characters of the name. */
+} _nmd_block_item;
+
+/* Returns the number of characters of the identifier(a letter, '_' or '.' followed by letters, digits, '_' or '.') at 's'. */
+NMD_ASSEMBLY_API size_t _nmd_get_identifier_length(const char* s)
+{
+	size_t i = 0;
+	for (; _NMD_IS_LOWERCASE(s[i]) || s[i] == '_' || s[i] == '.' || (i > 0 && _NMD_IS_DECIMAL_NUMBER(s[i])); i++);
+	return i;
+}
+
+/* Returns true if the elements 'a' and 'b' have the same name. */
+NMD_ASSEMBLY_API bool _nmd_block_names_equal(const char* arena, const _nmd_block_item* a, const _nmd_block_item* b)
+{
+	size_t i = 0;
+	if (a->name_length != b->name_length)
+		return false;
+
+	for (; i < a->name_length; i++)
+	{
+		if (arena[a->name + i] != arena[b->name + i])
+			return false;
+	}
+
+	return true;
+}
+
+/* Returns the address of the target of the branch 'item' given the runtime address of the block(zero if it's invalid). The block's offsets must be up to date. */
+NMD_ASSEMBLY_API int64_t _nmd_get_block_branch_target(const _nmd_block_item* items, const _nmd_block_item* item, uint64_t runtime_address)
+{
+	if (item->type == _NMD_BLOCK_ITEM_BRANCH_TO_LABEL)
+		return (int64_t)((runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? 0 : runtime_address) + items[item->target].offset);
+	else if (runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS)
+		return (int64_t)item->offset + item->target;
+	else
+		return item->target;
+}
+
+/*
+Assembles a block of instructions separated by the '\n'(new line) character, which may define and refer to labels. Returns the number of bytes written to the buffer on success, zero otherwise.
+ - A label is defined by an identifier followed by ':' at the start of a line, e.g. 'loop:' or 'loop: dec ecx'. Labels are case insensitive and can be referred to before they are defined.
+ - The operand of 'jmp', 'call' and conditional jumps may be a label. A label whose name is also a hexadecimal number(e.g. 'beef') takes precedence over the number. The shortest encoding of 'jmp' and conditional jumps is chosen by iterative relaxation: every branch
+   starts with an 8-bit displacement and only the ones whose target is out of range grow, until no branch has to grow.
+ - Empty lines are ignored. The address of each instruction is the runtime address of the block plus its offset, so a number used as the operand of a branch is an address
+   (or, without a runtime address, a displacement relative to the start of the instruction, same as in nmd_x86_assemble()).
+The instructions are assembled directly to the buffer and moved when a branch before them grows, so the buffer must have room for the whole block. The symbol table and the
+per-instruction information are stored in the arena, see 'NMD_X86_ASSEMBLE_BLOCK_ARENA_SIZE'.
+Parameters:
+ - string          [in]  A pointer to a string that represents a block of instructions in assembly language.
+ - buffer          [out] A pointer to a buffer that receives the encoded instructions.
+ - buffer_size     [in]  The size of the buffer in bytes.
+ - runtime_address [in]  The block's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - mode            [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - arena           [in]  A pointer to memory used by the assembler.
+ - arena_size      [in]  The size of the arena in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_assemble_block(const char* string, void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, void* arena, size_t arena_size)
+{
+	/* The elements grow from the start of the arena(aligned to eight bytes) and the names from its end */
+	const size_t alignment = (8 - (size_t)((ptrdiff_t)arena % 8)) % 8;
+	_nmd_block_item* const items = (_nmd_block_item*)((char*)arena + alignment);
+	char* names = (char*)arena + arena_size;
+	uint8_t* const b = (uint8_t*)buffer;
+	size_t num_items = 0, num_labels = 0, num_slots = 1, size = 0, length, i, j;
+	uint8_t temp_buffer[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH];
 	char parsed_string[256];
-	uint8_t temp_buffer[15]; /* The assembling takes place on this buffer instead of the user's buffer because the assembler doesn't check the buffer size. If it assembled directly to the user's buffer it could access bad memory */
-	uint8_t* b = (uint8_t*)buffer;
-	size_t remaining_size;
-	size_t length = 0;
+	uint32_t* slots;
+	bool has_grown;
 
 	_nmd_assemble_info ai;
-	ai.s = parsed_string;
 	ai.mode = mode;
-	ai.runtime_address = runtime_address;
-	ai.b = temp_buffer;
-	
-	/* Parse the first character of the string because the loop just ahead accesses `string-1` which could be bad memory if we didn't do this */
-	if (*string == ' ')
-		string++;
-	else
-	{
-		parsed_string[0] = *string++;
-		length++;
-	}
+	ai.runtime_address = NMD_X86_INVALID_RUNTIME_ADDRESS; /* Instructions that depend on their address are assembled later */
 
-	while (*string && num_instructions < num_max_instructions)
+	if (arena_size < alignment)
+		return 0;
+
+	/* Parse the block. Instructions are assembled right away, one after the other. Branches don't take space yet */
+	while (*string)
 	{
-		remaining_size = buffer_end - b;
-				
-		/* Copy 'string' to 'parsed_string' converting it to lowercase and removing unwanted spaces. If the instruction separator character '\n' is found, stop. */
-		char c = *string; /* Current character */
-		char prev_c = *(string - 1); /* Previous character */
-		while (c && c != '\n')
+		if (_nmd_parse_line(&string, parsed_string) == (size_t)(-1))
+			return 0;
+
+		char* s = parsed_string;
+		while (*s)
 		{
-			/* Ignore(skip) the current character if it's a space and the previous character is one of the following: ' ', '+', '*', '[' */
-			if (c == ' ' && (prev_c == ' ' || prev_c == '+' || prev_c == '*' || prev_c == '['))
+			_nmd_block_item* const item = items + num_items;
+			if ((char*)(item + 1) > names)
+				return 0;
+
+			item->offset = (uint32_t)size;
+			item->length = 0;
+			item->name_length = 0;
+			item->is_number = false;
+
+			/* Labels */
+			length = _nmd_get_identifier_length(s);
+			if (length && s[length] == ':')
 			{
-				c = *++string;
+				if ((size_t)(names - (char*)(item + 1)) < length)
+					return 0;
+
+				names -= length;
+				for (i = 0; i < length; i++)
+					names[i] = s[i];
+
+				item->type = _NMD_BLOCK_ITEM_LABEL;
+				item->name = (uint32_t)(names - (char*)arena);
+				item->name_length = (uint16_t)length;
+				num_items++;
+				num_labels++;
+
+				s += length + 1;
+				if (*s == ' ')
+					s++;
 				continue;
 			}
 
-			/* Append character */
-			parsed_string[length++] = _NMD_TOLOWER(c);
+			/* Relative branches to labels or addresses. An identifier that is also a number(e.g. 'beef') refers to a label if one with that name is defined */
+			length = _nmd_get_token_length(s);
+			item->mnemonic = _nmd_find_asm_mnemonic(s, length);
+			if ((item->mnemonic == _NMD_X86_ASM_MNEMONIC_JMP || item->mnemonic == _NMD_X86_ASM_MNEMONIC_CALL || (item->mnemonic >= _NMD_X86_ASM_MNEMONIC_JO && item->mnemonic <= _NMD_X86_ASM_MNEMONIC_JG)) && s[length] == ' ')
+			{
+				const char* const operand = s + length + 1;
+				item->is_number = _nmd_parse_immediate(operand, &item->target);
+
+				length = _nmd_get_identifier_length(operand);
+				if (length && !operand[length] && !_nmd_find_asm_reg(operand, length))
+				{
+					if ((size_t)(names - (char*)(item + 1)) < length)
+						return 0;
+
+					names -= length;
+					for (i = 0; i < length; i++)
+						names[i] = operand[i];
+
+					item->type = _NMD_BLOCK_ITEM_BRANCH_TO_LABEL;
+					item->name = (uint32_t)(names - (char*)arena);
+					item->name_length = (uint16_t)length;
+					num_items++;
+					break;
+				}
+				else if (item->is_number)
+				{
+					item->type = _NMD_BLOCK_ITEM_BRANCH;
+					num_items++;
+					break;
+				}
+			}
 
-			/* The maximum length is 255 */
-			if (length >= 256)
+			/* Other instructions. The assembler doesn't check the buffer size, so it only assembles directly to the buffer if it has enough space */
+			ai.s = s;
+			ai.b = buffer_size - size >= NMD_X86_MAXIMUM_INSTRUCTION_LENGTH ? b + size : temp_buffer;
+			if (!(length = _nmd_assemble_single(&ai)) || length > buffer_size - size)
 				return 0;
 
-			/* Set previous character */
-			prev_c = c;
+			if (ai.b == temp_buffer)
+			{
+				for (i = 0; i < length; i++)
+					b[size + i] = temp_buffer[i];
+			}
 
-			/* Get the next character */
-			c = *++string;
+			item->type = _NMD_BLOCK_ITEM_INSTRUCTION;
+			item->length = (uint8_t)length;
+			size += length;
+			num_items++;
+			break;
 		}
+	}
 
-		/* This check is only ever true if *string == '\n', that is the instruction separator character */
-		if (*string /* == '\n' */)
-			string++; /* Go forward by one character so 'string' points to the next instruction */
+	/* Build the symbol table, a hash table of label indices(plus one, zero means an empty slot) placed after the elements */
+	while (num_slots < num_labels * 2)
+		num_slots *= 2;
+	slots = (uint32_t*)(items + num_items);
+	if ((char*)(slots + num_slots) > names)
+		return 0;
+	for (i = 0; i < num_slots; i++)
+		slots[i] = 0;
 
-		/* If the last character is a space, remove it. */
-		if (length > 0 && parsed_string[length - 1] == ' ')
-			length--;
+	for (i = 0; i < num_items; i++)
+	{
+		if (items[i].type != _NMD_BLOCK_ITEM_LABEL)
+			continue;
 
-		/* After all of the string manipulation, place the null character */
-		parsed_string[length] = '\0';
+		for (j = _nmd_hash_string((char*)arena + items[i].name, items[i].name_length, 2166136261) & (num_slots - 1); slots[j]; j = (j + 1) & (num_slots - 1))
+		{
+			/* A label can only be defined once */
+			if (_nmd_block_names_equal((const char*)arena, items + slots[j] - 1, items + i))
+				return 0;
+		}
+		slots[j] = (uint32_t)(i + 1);
+	}
 
-		/* Try to assemble the instruction */
-		const size_t num_bytes = _nmd_assemble_single(&ai);
-		if (num_bytes == 0 || num_bytes > remaining_size)
-			return 0;
+	/* Resolve the labels branches refer to */
+	for (i = 0; i < num_items; i++)
+	{
+		if (items[i].type != _NMD_BLOCK_ITEM_BRANCH_TO_LABEL)
+			continue;
 
-		/* Copy bytes from 'temp_buffer' to 'buffer' */
-		size_t i = 0;
-		for (; i < num_bytes; i++)
-			b[i] = temp_buffer[i];
-		b += num_bytes;
+		for (j = _nmd_hash_string((char*)arena + items[i].name, items[i].name_length, 2166136261) & (num_slots - 1); slots[j]; j = (j + 1) & (num_slots - 1))
+		{
+			if (_nmd_block_names_equal((const char*)arena, items + slots[j] - 1, items + i))
+				break;
+		}
 
-		num_instructions++;
+		if (slots[j])
+			items[i].target = slots[j] - 1;
+		else if (items[i].is_number)
+			items[i].type = _NMD_BLOCK_ITEM_BRANCH; /* Not a label, the address was parsed already */
+		else
+			return 0; /* Undefined label */
+	}
 
-		/* Reset length in case there's another instruction */
-		length = 0;
+	/* Relaxation. 'call' has no short form */
+	for (i = 0; i < num_items; i++)
+	{
+		if (items[i].type == _NMD_BLOCK_ITEM_BRANCH || items[i].type == _NMD_BLOCK_ITEM_BRANCH_TO_LABEL)
+			items[i].length = (uint8_t)_nmd_get_relative_branch_length(mode, items[i].mnemonic, items[i].mnemonic != _NMD_X86_ASM_MNEMONIC_CALL);
 	}
 
-	if (count)
-		*count = num_instructions;
+	do
+	{
+		size_t offset = 0;
+		for (i = 0; i < num_items; i++)
+		{
+			items[i].offset = (uint32_t)offset;
+			offset += items[i].length;
+		}
 
-	/* Return the number of bytes written to the buffer */
-	return (size_t)((ptrdiff_t)b - (ptrdiff_t)buffer);
+		if (offset > buffer_size || offset > 0xffffffff)
+			return 0;
+
+		has_grown = false;
+		for (i = 0; i < num_items; i++)
+		{
+			if ((items[i].type == _NMD_BLOCK_ITEM_BRANCH || items[i].type == _NMD_BLOCK_ITEM_BRANCH_TO_LABEL) && items[i].length == 2)
+			{
+				const int64_t disp = _nmd_get_block_branch_target(items, items + i, runtime_address) - (int64_t)((runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? 0 : runtime_address) + items[i].offset) - 2;
+				if (disp < -0x80 || disp > 0x7f)
+				{
+					items[i].length = (uint8_t)_nmd_get_relative_branch_length(mode, items[i].mnemonic, false);
+					has_grown = true;
+				}
+			}
+		}
+	} while (has_grown);
+
+	/*
+	Move the instructions to their final offsets and assemble the branches. The instructions were assembled one after the other, so their final offsets are greater or equal
+	and moving them from the last to the first one never overwrites bytes that haven't been moved yet.
+	*/
+	for (i = num_items; i-- > 0;)
+	{
+		_nmd_block_item* const item = items + i;
+		if (item->type == _NMD_BLOCK_ITEM_INSTRUCTION)
+		{
+			size -= item->length;
+			for (j = item->length; j-- > 0;)
+				b[item->offset + j] = b[size + j];
+		}
+		else if (item->type != _NMD_BLOCK_ITEM_LABEL)
+		{
+			const int64_t delta = _nmd_get_block_branch_target(items, item, runtime_address) - (int64_t)((runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? 0 : runtime_address) + item->offset);
+			if (!_nmd_assemble_relative_branch(b + item->offset, mode, item->mnemonic, delta, item->length == 2))
+				return 0;
+		}
+	}
+
+	return num_items ? items[num_items - 1].offset + items[num_items - 1].length : 0;
 }
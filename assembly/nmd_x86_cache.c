@@ -0,0 +1,203 @@
+#include "nmd_common.h"
+
+/* Returns the index of the bucket of 'runtime_address'(Fibonacci hashing, so consecutive addresses go to different buckets). */
+NMD_ASSEMBLY_API size_t _nmd_x86_cache_get_bucket(const nmd_x86_cache* cache, uint64_t runtime_address)
+{
+	return (size_t)((runtime_address * 0x9E3779B97F4A7C15) >> 32) & (cache->num_buckets - 1);
+}
+
+/*
+Initializes a decode cache in a memory block provided by the caller. Returns the number of entries of the cache, or zero if the block is too small for one bucket.
+The number of entries is the largest power of two times 'NMD_X86_CACHE_BUCKET_SIZE' that fits in the block. Use 'NMD_X86_CACHE_MEMORY_SIZE()' to compute the block's size.
+Parameters:
+ - cache       [out] A pointer to a variable of type 'nmd_x86_cache'.
+ - memory      [in]  A pointer to the memory block. It must stay valid while the cache is used.
+ - memory_size [in]  The size of the memory block in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_cache_init(nmd_x86_cache* cache, void* memory, size_t memory_size)
+{
+	const size_t bucket_size = NMD_X86_CACHE_BUCKET_SIZE * (sizeof(nmd_x86_cache_key) + sizeof(nmd_x86_cache_entry));
+	const size_t padding = (8 - ((size_t)memory & 7)) & 7; /* The keys start at an 8-byte boundary. */
+	size_t num_buckets = 1;
+
+	cache->num_buckets = 0;
+	if (memory_size < padding + bucket_size)
+		return 0;
+
+	memory_size -= padding;
+	while (num_buckets * 2 <= memory_size / bucket_size)
+		num_buckets *= 2;
+
+	cache->keys = (nmd_x86_cache_key*)((uint8_t*)memory + padding);
+	cache->entries = (nmd_x86_cache_entry*)(cache->keys + num_buckets * NMD_X86_CACHE_BUCKET_SIZE);
+	cache->num_buckets = num_buckets;
+	nmd_x86_cache_clear(cache);
+
+	return num_buckets * NMD_X86_CACHE_BUCKET_SIZE;
+}
+
+/* Returns the index of the entry of the instruction at 'runtime_address', decoding it if it's not in the cache. Returns '(size_t)-1' if the instruction is invalid. */
+NMD_ASSEMBLY_API size_t _nmd_x86_cache_lookup(nmd_x86_cache* cache, const uint8_t* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags)
+{
+	const size_t first = _nmd_x86_cache_get_bucket(cache, runtime_address) * NMD_X86_CACHE_BUCKET_SIZE;
+	size_t i, j, victim = (size_t)-1;
+
+	for (i = first; i < first + NMD_X86_CACHE_BUCKET_SIZE; i++)
+	{
+		const nmd_x86_cache_key* key = &cache->keys[i];
+		if (!key->length)
+		{
+			if (victim == (size_t)-1)
+				victim = i;
+			continue;
+		}
+
+		if (key->runtime_address != runtime_address || key->mode != (uint8_t)mode || key->flags != flags)
+			continue;
+
+		/* The bytes in memory must still be the same, otherwise the code was modified and the instruction is decoded again in this entry. */
+		if (key->length <= buffer_size)
+		{
+			const uint8_t* cached = cache->entries[i].instruction.buffer;
+			for (j = 0; j < key->length; j++)
+			{
+				if (cached[j] != buffer[j])
+					break;
+			}
+
+			if (j == key->length)
+			{
+				cache->num_hits++;
+				return i;
+			}
+		}
+
+		victim = i;
+		break;
+	}
+
+	/* Every entry of the bucket is in use, so one is replaced in round-robin order. */
+	if (victim == (size_t)-1)
+		victim = first + (cache->next_victim++ % NMD_X86_CACHE_BUCKET_SIZE);
+
+	cache->num_misses++;
+	cache->keys[victim].length = 0;
+
+	/* The bytes are always copied, they're compared with memory on lookups. */
+	if (!nmd_x86_decode(buffer, buffer_size, &cache->entries[victim].instruction, mode, flags & ~NMD_X86_DECODER_FLAGS_ZERO_COPY))
+		return (size_t)-1;
+
+	cache->keys[victim].runtime_address = runtime_address;
+	cache->keys[victim].flags = flags;
+	cache->keys[victim].mode = (uint8_t)mode;
+	cache->keys[victim].length = cache->entries[victim].instruction.length;
+	cache->entries[victim].string_length = 0;
+
+	return victim;
+}
+
+/*
+Same as nmd_x86_decode(), but the instruction is looked up in the cache first. Returns a pointer to the decoded instruction, or a null pointer if the instruction is invalid.
+Instructions are looked up by runtime address, mode and flags, and the cached instruction's bytes are compared with the bytes in 'buffer', so an instruction that
+was modified is decoded again even if it was not invalidated. The pointer is valid until the next call that modifies the cache.
+Parameters:
+ - cache           [in/out] A pointer to a cache initialized by nmd_x86_cache_init().
+ - buffer          [in]     A pointer to a buffer containing an encoded instruction.
+ - buffer_size     [in]     The buffer's size in bytes.
+ - runtime_address [in]     The instruction's runtime address. This is the key of the cache, so 'NMD_X86_INVALID_RUNTIME_ADDRESS' only caches a few instructions.
+ - mode            [in]     The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags           [in]     A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+*/
+NMD_ASSEMBLY_API const nmd_x86_instruction* nmd_x86_cache_decode(nmd_x86_cache* cache, const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags)
+{
+	const size_t i = _nmd_x86_cache_lookup(cache, (const uint8_t*)buffer, buffer_size, runtime_address, mode, flags);
+	return i != (size_t)-1 ? &cache->entries[i].instruction : 0;
+}
+
+/*
+Same as nmd_x86_cache_decode(), but returns the formatted instruction, which is also cached. Returns a null pointer if the instruction is invalid or its string
+does not fit in 'NMD_X86_CACHE_STRING_SIZE' bytes. The pointer is valid until the next call that modifies the cache.
+Parameters:
+ - cache           [in/out] A pointer to a cache initialized by nmd_x86_cache_init().
+ - buffer          [in]     A pointer to a buffer containing an encoded instruction.
+ - buffer_size     [in]     The buffer's size in bytes.
+ - runtime_address [in]     The instruction's runtime address.
+ - mode            [in]     The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - decoder_flags   [in]     A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+ - format_flags    [in]     A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the instruction is formatted.
+*/
+NMD_ASSEMBLY_API const char* nmd_x86_cache_format(nmd_x86_cache* cache, const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t decoder_flags, uint32_t format_flags)
+{
+	const size_t i = _nmd_x86_cache_lookup(cache, (const uint8_t*)buffer, buffer_size, runtime_address, mode, decoder_flags);
+	nmd_x86_cache_entry* entry;
+	if (i == (size_t)-1)
+		return 0;
+
+	entry = &cache->entries[i];
+	if (!entry->string_length || entry->format_flags != format_flags)
+	{
+		entry->format_flags = format_flags;
+		if (!(entry->string_length = nmd_x86_format_ex(&entry->instruction, entry->string, NMD_X86_CACHE_STRING_SIZE, runtime_address, format_flags)))
+			return 0;
+	}
+
+	return entry->string;
+}
+
+/*
+Removes every cached instruction that overlaps a range of memory(e.g. after the code was patched). Returns the number of instructions removed.
+Parameters:
+ - cache           [in/out] A pointer to a cache initialized by nmd_x86_cache_init().
+ - runtime_address [in]     The runtime address of the range's first byte.
+ - size            [in]     The range's size in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_cache_invalidate(nmd_x86_cache* cache, uint64_t runtime_address, size_t size)
+{
+	/* An instruction that overlaps the range starts at most 14 bytes before it. */
+	const uint64_t start = runtime_address >= NMD_X86_MAXIMUM_INSTRUCTION_LENGTH - 1 ? runtime_address - (NMD_X86_MAXIMUM_INSTRUCTION_LENGTH - 1) : 0;
+	const uint64_t end = runtime_address + size;
+	size_t num_removed = 0, i;
+
+	if (!size)
+		return 0;
+
+	if (end < runtime_address || end - start > cache->num_buckets)
+	{
+		/* The range is as large as the cache, so every entry is checked. */
+		for (i = 0; i < cache->num_buckets * NMD_X86_CACHE_BUCKET_SIZE; i++)
+		{
+			nmd_x86_cache_key* key = &cache->keys[i];
+			if (key->length && key->runtime_address + key->length > runtime_address && (end < runtime_address || key->runtime_address < end))
+				key->length = 0, num_removed++;
+		}
+	}
+	else
+	{
+		/* Only the buckets of the addresses where an overlapping instruction may start are checked. */
+		uint64_t address;
+		for (address = start; address < end; address++)
+		{
+			const size_t first = _nmd_x86_cache_get_bucket(cache, address) * NMD_X86_CACHE_BUCKET_SIZE;
+			for (i = first; i < first + NMD_X86_CACHE_BUCKET_SIZE; i++)
+			{
+				nmd_x86_cache_key* key = &cache->keys[i];
+				if (key->length && key->runtime_address == address && address + key->length > runtime_address)
+					key->length = 0, num_removed++;
+			}
+		}
+	}
+
+	return num_removed;
+}
+
+/* Removes every cached instruction and resets the cache's counters. */
+NMD_ASSEMBLY_API void nmd_x86_cache_clear(nmd_x86_cache* cache)
+{
+	size_t i;
+	for (i = 0; i < cache->num_buckets * NMD_X86_CACHE_BUCKET_SIZE; i++)
+		cache->keys[i].length = 0;
+
+	cache->num_hits = 0;
+	cache->num_misses = 0;
+	cache->next_victim = 0;
+}
@@ -0,0 +1,280 @@
+#include "nmd_common.h"
+
+/* Each byte of the buffer has a byte of information. The four low-order bits are the length of the instruction that starts there(zero if none). */
+#define _NMD_X86_CFG_LENGTH_MASK 0x0f
+#define _NMD_X86_CFG_LEADER      0x10 /* The instruction starts a block. */
+#define _NMD_X86_CFG_END         0x20 /* The instruction ends a block(branch or return). */
+#define _NMD_X86_CFG_PENDING     0x40 /* The offset must be traced. */
+#define _NMD_X86_CFG_FUNCTION    0x80 /* The offset is an entry point or the target of a call. */
+
+#define _NMD_X86_CFG_DECODER_FLAGS (NMD_X86_DECODER_FLAGS_VALIDITY_CHECK | NMD_X86_DECODER_FLAGS_GROUP | NMD_X86_DECODER_FLAGS_VEX | NMD_X86_DECODER_FLAGS_EVEX | NMD_X86_DECODER_FLAGS_3DNOW)
+
+typedef struct _nmd_x86_cfg_context
+{
+	const uint8_t* buffer;
+	size_t buffer_size;
+	uint64_t base; /* The runtime address of the first byte. */
+	NMD_X86_MODE mode;
+	uint8_t* info;
+	uint32_t* stack; /* Offsets to be traced. Offsets that do not fit are only marked as pending and found by a sweep. */
+	size_t stack_size;
+	size_t stack_capacity;
+} _nmd_x86_cfg_context;
+
+/* Marks the target of a branch as a block leader that must be traced. */
+NMD_ASSEMBLY_API void _nmd_x86_cfg_add_target(_nmd_x86_cfg_context* context, uint64_t target, uint8_t flags)
+{
+	size_t offset;
+	if (target < context->base || target - context->base >= context->buffer_size)
+		return;
+
+	offset = (size_t)(target - context->base);
+	if (context->info[offset] & _NMD_X86_CFG_LENGTH_MASK)
+	{
+		context->info[offset] |= _NMD_X86_CFG_LEADER | flags;
+		return;
+	}
+
+	if (context->info[offset] & _NMD_X86_CFG_PENDING)
+	{
+		context->info[offset] |= flags;
+		return;
+	}
+
+	context->info[offset] |= _NMD_X86_CFG_LEADER | _NMD_X86_CFG_PENDING | flags;
+	if (context->stack_size < context->stack_capacity)
+		context->stack[context->stack_size++] = (uint32_t)offset;
+}
+
+/* Decodes the instructions from 'offset' until a return, an unconditional branch, an invalid instruction or an instruction that was already decoded. */
+NMD_ASSEMBLY_API void _nmd_x86_cfg_trace(_nmd_x86_cfg_context* context, size_t offset)
+{
+	nmd_x86_light_instruction instruction;
+	context->info[offset] &= ~_NMD_X86_CFG_PENDING;
+
+	while (offset < context->buffer_size)
+	{
+		/* The stream merges with one that was already decoded, so the instruction has more than one predecessor. */
+		if (context->info[offset] & _NMD_X86_CFG_LENGTH_MASK)
+		{
+			context->info[offset] |= _NMD_X86_CFG_LEADER;
+			return;
+		}
+
+		if (!nmd_x86_decode_light(context->buffer + offset, context->buffer_size - offset, context->base + offset, &instruction, context->mode, _NMD_X86_CFG_DECODER_FLAGS))
+			return;
+
+		context->info[offset] = (uint8_t)((context->info[offset] & ~_NMD_X86_CFG_PENDING) | instruction.length);
+
+		if (instruction.group & NMD_GROUP_CALL)
+		{
+			if (instruction.flags & NMD_X86_LIGHT_FLAGS_BRANCH_TARGET)
+				_nmd_x86_cfg_add_target(context, instruction.branch_target, _NMD_X86_CFG_FUNCTION);
+		}
+		else if (instruction.group & (NMD_GROUP_BRANCH | NMD_GROUP_RET))
+		{
+			context->info[offset] |= _NMD_X86_CFG_END;
+			if (instruction.flags & NMD_X86_LIGHT_FLAGS_BRANCH_TARGET)
+				_nmd_x86_cfg_add_target(context, instruction.branch_target, 0);
+
+			/* The instruction after a conditional branch starts a block, the ones after a return or an unconditional branch are not reachable from here. */
+			if (!(instruction.group & NMD_GROUP_CONDITIONAL_BRANCH))
+				return;
+
+			offset += instruction.length;
+			if (offset < context->buffer_size)
+				context->info[offset] |= _NMD_X86_CFG_LEADER;
+			continue;
+		}
+
+		offset += instruction.length;
+	}
+}
+
+/* Returns the index of the block that starts at 'offset', or 'num_blocks' if there's none. */
+NMD_ASSEMBLY_API size_t _nmd_x86_cfg_find_block(const nmd_x86_cfg* cfg, size_t offset)
+{
+	size_t low = 0, high = cfg->num_blocks;
+	while (low < high)
+	{
+		const size_t middle = low + (high - low) / 2;
+		if (cfg->block_offset[middle] < offset)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	return low < cfg->num_blocks && cfg->block_offset[low] == offset ? low : cfg->num_blocks;
+}
+
+/*
+Builds the control flow graph of the code reachable from one or more entry points. Returns the number of basic blocks, or zero if 'memory_size' is too small,
+'buffer_size' is not less than 4GiB or no entry point is in the buffer.
+Instructions are decoded recursively: conditional branches continue at both successors, unconditional branches at their target and returns, indirect branches
+and invalid instructions end the path. Targets of calls are traced as well(the block they start has the 'NMD_X86_CFG_BLOCK_FUNCTION' flag), but calls do not end blocks.
+Parameters:
+ - buffer           [in]  A pointer to a buffer containing encoded instructions.
+ - buffer_size      [in]  The buffer's size in bytes.
+ - runtime_address  [in]  The runtime address of the buffer's first byte. If it's 'NMD_X86_INVALID_RUNTIME_ADDRESS', offsets are used as runtime addresses.
+ - mode             [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - entry_points     [in]  A pointer to an array of runtime addresses where the code starts. Addresses outside the buffer are ignored.
+ - num_entry_points [in]  The number of elements in 'entry_points'.
+ - cfg              [out] A pointer to a variable of type 'nmd_x86_cfg' that receives the graph. Its arrays point to 'memory'.
+ - memory           [in]  A pointer to a memory block used by the function and to store the graph. 'NMD_X86_CFG_MEMORY_SIZE(buffer_size)' bytes are always enough.
+ - memory_size      [in]  The size of the memory block in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_cfg_build(const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, const uint64_t* entry_points, size_t num_entry_points, nmd_x86_cfg* cfg, void* memory, size_t memory_size)
+{
+	_nmd_x86_cfg_context context;
+	nmd_x86_light_instruction instruction;
+	size_t i, offset, padding, num_blocks = 0, num_edges = 0, block_end = 0;
+	uint8_t* arrays;
+	bool pending;
+
+	cfg->num_blocks = 0;
+	cfg->num_edges = 0;
+
+	padding = (4 - (((size_t)memory + buffer_size) & 3)) & 3; /* The arrays of 32-bit integers start at a 4-byte boundary. */
+	if ((uint64_t)buffer_size >= 0xffffffff || memory_size < buffer_size + padding)
+		return 0;
+
+	context.buffer = (const uint8_t*)buffer;
+	context.buffer_size = buffer_size;
+	context.base = runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? 0 : runtime_address;
+	context.mode = mode;
+	context.info = (uint8_t*)memory;
+	context.stack = (uint32_t*)(context.info + buffer_size + padding);
+	context.stack_size = 0;
+	context.stack_capacity = (memory_size - buffer_size - padding) / sizeof(uint32_t);
+
+	for (i = 0; i < buffer_size; i++)
+		context.info[i] = 0;
+
+	for (i = 0; i < num_entry_points; i++)
+		_nmd_x86_cfg_add_target(&context, entry_points[i], _NMD_X86_CFG_FUNCTION);
+
+	/* Trace every pending offset. When the stack was full, the sweep finds the offsets that were not pushed. */
+	do
+	{
+		while (context.stack_size)
+		{
+			offset = context.stack[--context.stack_size];
+			if (context.info[offset] & _NMD_X86_CFG_PENDING)
+				_nmd_x86_cfg_trace(&context, offset);
+		}
+
+		pending = false;
+		for (offset = 0; offset < buffer_size; offset++)
+		{
+			if (context.info[offset] & _NMD_X86_CFG_PENDING)
+				_nmd_x86_cfg_trace(&context, offset), pending = true;
+		}
+	} while (pending || context.stack_size);
+
+	/* Count the blocks. A block also ends before an offset that has no instruction. */
+	for (offset = 0; offset < buffer_size;)
+	{
+		const uint8_t info = context.info[offset];
+		if (!(info & _NMD_X86_CFG_LENGTH_MASK))
+		{
+			offset++;
+			continue;
+		}
+
+		if (offset != block_end || (info & _NMD_X86_CFG_LEADER))
+			num_blocks++;
+
+		offset += info & _NMD_X86_CFG_LENGTH_MASK;
+		block_end = (info & _NMD_X86_CFG_END) ? (size_t)-1 : offset;
+	}
+
+	if (!num_blocks)
+		return 0;
+
+	/* Each block has at most two successors */
+	arrays = (uint8_t*)context.stack;
+	if ((size_t)(memory_size - buffer_size - padding) < num_blocks * (4 * sizeof(uint32_t) + 1) + sizeof(uint32_t) + num_blocks * 2 * (sizeof(uint32_t) + 1))
+		return 0;
+
+	cfg->block_offset = (uint32_t*)arrays;
+	cfg->block_size = cfg->block_offset + num_blocks;
+	cfg->block_num_instructions = cfg->block_size + num_blocks;
+	cfg->block_first_edge = cfg->block_num_instructions + num_blocks;
+	cfg->edge_target = cfg->block_first_edge + num_blocks + 1;
+	cfg->block_flags = (uint8_t*)(cfg->edge_target + num_blocks * 2);
+	cfg->edge_type = cfg->block_flags + num_blocks;
+
+	/* Fill the blocks */
+	num_blocks = 0;
+	block_end = 0;
+	for (offset = 0; offset < buffer_size;)
+	{
+		const uint8_t info = context.info[offset];
+		if (!(info & _NMD_X86_CFG_LENGTH_MASK))
+		{
+			offset++;
+			continue;
+		}
+
+		if (offset != block_end || (info & _NMD_X86_CFG_LEADER))
+		{
+			cfg->block_offset[num_blocks] = (uint32_t)offset;
+			cfg->block_size[num_blocks] = 0;
+			cfg->block_num_instructions[num_blocks] = 0;
+			cfg->block_flags[num_blocks] = (info & _NMD_X86_CFG_FUNCTION) ? NMD_X86_CFG_BLOCK_FUNCTION : 0;
+			num_blocks++;
+		}
+
+		cfg->block_size[num_blocks - 1] += info & _NMD_X86_CFG_LENGTH_MASK;
+		cfg->block_num_instructions[num_blocks - 1]++;
+
+		offset += info & _NMD_X86_CFG_LENGTH_MASK;
+		block_end = (info & _NMD_X86_CFG_END) ? (size_t)-1 : offset;
+	}
+	cfg->num_blocks = num_blocks;
+
+	/* Compute the successors of each block from its last instruction */
+	for (i = 0; i < num_blocks; i++)
+	{
+		const size_t end = (size_t)cfg->block_offset[i] + cfg->block_size[i];
+		size_t last = cfg->block_offset[i], target;
+		bool falls_through = true;
+
+		cfg->block_first_edge[i] = (uint32_t)num_edges;
+		while (last + (context.info[last] & _NMD_X86_CFG_LENGTH_MASK) < end)
+			last += context.info[last] & _NMD_X86_CFG_LENGTH_MASK;
+
+		if (context.info[last] & _NMD_X86_CFG_END)
+		{
+			nmd_x86_decode_light(context.buffer + last, buffer_size - last, context.base + last, &instruction, mode, _NMD_X86_CFG_DECODER_FLAGS);
+			falls_through = (instruction.group & NMD_GROUP_CONDITIONAL_BRANCH) != 0;
+
+			if (instruction.group & NMD_GROUP_RET)
+				cfg->block_flags[i] |= NMD_X86_CFG_BLOCK_RETURN;
+			else if (!(instruction.flags & NMD_X86_LIGHT_FLAGS_BRANCH_TARGET))
+				cfg->block_flags[i] |= NMD_X86_CFG_BLOCK_INDIRECT_BRANCH;
+			else if (instruction.branch_target < context.base || instruction.branch_target - context.base >= buffer_size || (target = _nmd_x86_cfg_find_block(cfg, (size_t)(instruction.branch_target - context.base))) == num_blocks)
+				cfg->block_flags[i] |= NMD_X86_CFG_BLOCK_EXTERNAL_BRANCH;
+			else
+			{
+				cfg->edge_target[num_edges] = (uint32_t)target;
+				cfg->edge_type[num_edges++] = (uint8_t)(falls_through ? NMD_X86_CFG_EDGE_BRANCH_TAKEN : NMD_X86_CFG_EDGE_JUMP);
+			}
+		}
+
+		if (falls_through)
+		{
+			if (i + 1 < num_blocks && cfg->block_offset[i + 1] == end)
+			{
+				cfg->edge_target[num_edges] = (uint32_t)(i + 1);
+				cfg->edge_type[num_edges++] = NMD_X86_CFG_EDGE_FALLTHROUGH;
+			}
+			else
+				cfg->block_flags[i] |= NMD_X86_CFG_BLOCK_TRUNCATED;
+		}
+	}
+	cfg->block_first_edge[num_blocks] = (uint32_t)num_edges;
+	cfg->num_edges = num_edges;
+
+	return num_blocks;
+}
@@ -1,11 +1,27 @@
 #include "nmd_common.h"
 
+/* Returns true if the memory operand uses 16-bit addressing(e.g. '[bx+si]'). The address-size override prefix toggles between 16 and 32 bits outside 64-bit mode. */
+NMD_ASSEMBLY_API bool _nmd_has_16bit_addressing(const nmd_x86_instruction* instruction)
+{
+	return instruction->mode != NMD_X86_MODE_64 && (instruction->mode == NMD_X86_MODE_16) != (bool)(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE);
+}
+
 NMD_ASSEMBLY_API void _nmd_decode_operand_segment_reg(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
 {
 	if (instruction->segment_override)
 		operand->fields.reg = (uint8_t)(NMD_X86_REG_ES + _nmd_get_bit_index(instruction->segment_override));
+	else if (_nmd_has_16bit_addressing(instruction))
+	{
+		/* The default segment is SS if the base register is bp */
+		const uint8_t rm = instruction->modrm.fields.rm;
+		operand->fields.reg = (uint8_t)(rm == 0b010 || rm == 0b011 || (rm == 0b110 && instruction->modrm.fields.mod != 0b00) ? NMD_X86_REG_SS : NMD_X86_REG_DS);
+	}
 	else
-		operand->fields.reg = (uint8_t)(!(instruction->prefixes & NMD_X86_PREFIXES_REX_B) && (instruction->modrm.fields.rm == 0b100 || instruction->modrm.fields.rm == 0b101) ? NMD_X86_REG_SS : NMD_X86_REG_DS);
+	{
+		/* The default segment is SS if the base register is (e/r)sp or (e/r)bp */
+		const uint8_t base = instruction->has_sib ? instruction->sib.fields.base : instruction->modrm.fields.rm;
+		operand->fields.reg = (uint8_t)(!(instruction->prefixes & NMD_X86_PREFIXES_REX_B) && (base == 0b100 || (base == 0b101 && instruction->modrm.fields.mod != 0b00)) ? NMD_X86_REG_SS : NMD_X86_REG_DS);
+	}
 }
 
 /* Decodes a memory operand. modrm is assumed to be in the range [00,BF] */
@@ -14,7 +30,16 @@ NMD_ASSEMBLY_API void _nmd_decode_modrm_upper32(const nmd_x86_instruction* instr
     /* Set operand type */
 	operand->type = NMD_X86_OPERAND_TYPE_MEMORY;
 
-	if (instruction->has_sib) /* R/M is 0b100 */
+	if (_nmd_has_16bit_addressing(instruction))
+	{
+		static const uint8_t bases[8] = { NMD_X86_REG_BX, NMD_X86_REG_BX, NMD_X86_REG_BP, NMD_X86_REG_BP, NMD_X86_REG_SI, NMD_X86_REG_DI, NMD_X86_REG_BP, NMD_X86_REG_BX };
+		const uint8_t rm = instruction->modrm.fields.rm;
+		if (!(instruction->modrm.fields.mod == 0b00 && rm == 0b110)) /* disp16 */
+			operand->fields.mem.base = bases[rm];
+		if (rm < 0b100)
+			operand->fields.mem.index = (uint8_t)(rm % 2 ? NMD_X86_REG_DI : NMD_X86_REG_SI), operand->fields.mem.scale = 1;
+	}
+	else if (instruction->has_sib) /* R/M is 0b100 */
 	{
 		if (instruction->sib.fields.base == 0b101) /* Check if there is displacement */
 		{
@@ -32,27 +57,26 @@ NMD_ASSEMBLY_API void _nmd_decode_modrm_upper32(const nmd_x86_instruction* instr
 			operand->fields.mem.index = (uint8_t)NMD_X86_REG_R12;
 		}
         
-		operand->fields.mem.scale = instruction->sib.fields.scale;
+		if (operand->fields.mem.index)
+			operand->fields.mem.scale = (uint8_t)(1 << instruction->sib.fields.scale);
 	}
 	else if (!(instruction->modrm.fields.mod == 0b00 && instruction->modrm.fields.rm == 0b101))
 	{
-		if (instruction->mode == NMD_X86_MODE_16 && !(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE))
-		{
-			operand->fields.mem.base = NMD_X86_REG_BX;
-			operand->fields.mem.index = NMD_X86_REG_SI;
-		}
+		if ((instruction->prefixes & (NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE | NMD_X86_PREFIXES_REX_B)) == (NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE | NMD_X86_PREFIXES_REX_B) && instruction->mode == NMD_X86_MODE_64)
+			operand->fields.mem.base = (uint8_t)(NMD_X86_REG_R8D + instruction->modrm.fields.rm);
 		else
-		{
-			if ((instruction->prefixes & (NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE | NMD_X86_PREFIXES_REX_B)) == (NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE | NMD_X86_PREFIXES_REX_B) && instruction->mode == NMD_X86_MODE_64)
-				operand->fields.mem.base = (uint8_t)(NMD_X86_REG_R8D + instruction->modrm.fields.rm);
-			else
-				operand->fields.mem.base = (uint8_t)((instruction->mode == NMD_X86_MODE_64 && !(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE) ? (instruction->prefixes & NMD_X86_PREFIXES_REX_B ? NMD_X86_REG_R8 : NMD_X86_REG_RAX) : NMD_X86_REG_EAX) + instruction->modrm.fields.rm);
-		}
+			operand->fields.mem.base = (uint8_t)((instruction->mode == NMD_X86_MODE_64 && !(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE) ? (instruction->prefixes & NMD_X86_PREFIXES_REX_B ? NMD_X86_REG_R8 : NMD_X86_REG_RAX) : NMD_X86_REG_EAX) + instruction->modrm.fields.rm);
 	}
+	else if (instruction->mode == NMD_X86_MODE_64) /* RIP-relative */
+		operand->fields.mem.base = (uint8_t)(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE ? NMD_X86_REG_EIP : NMD_X86_REG_RIP);
 
 	_nmd_decode_operand_segment_reg(instruction, operand);
 
-	operand->fields.mem.disp = instruction->displacement;
+	/* The displacement is sign-extended, except the 16-bit absolute address(e.g. '[0xDDFE]') */
+	if (_nmd_has_16bit_addressing(instruction) && instruction->modrm.fields.mod == 0b00 && instruction->modrm.fields.rm == 0b110)
+		operand->fields.mem.disp = instruction->displacement;
+	else
+		operand->fields.mem.disp = _nmd_sign_extend(instruction->displacement, instruction->disp_mask);
 }
 
 NMD_ASSEMBLY_API void _nmd_decode_memory_operand(const nmd_x86_instruction* instruction, nmd_x86_operand* operand, uint8_t mod11base_reg)
@@ -61,9 +85,14 @@ NMD_ASSEMBLY_API void _nmd_decode_memory_operand(const nmd_x86_instruction* inst
 	{
 		operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
 		operand->fields.reg = mod11base_reg + instruction->modrm.fields.rm;
+		if (instruction->prefixes & NMD_X86_PREFIXES_REX_B)
+			operand->fields.reg = _nmd_extend_gpr(operand->fields.reg);
 	}
 	else
+	{
 		_nmd_decode_modrm_upper32(instruction, operand);
+		operand->fields.mem.size = (uint8_t)(mod11base_reg == NMD_X86_REG_AL ? 1 : (mod11base_reg == NMD_X86_REG_AX ? 2 : (mod11base_reg == NMD_X86_REG_EAX ? 4 : ((mod11base_reg == NMD_X86_REG_RAX || mod11base_reg == NMD_X86_REG_MM0) ? 8 : (mod11base_reg == NMD_X86_REG_XMM0 ? 16 : 0)))));
+	}
 }
 
 NMD_ASSEMBLY_API void _nmd_decode_operand_Eb(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
@@ -78,7 +107,7 @@ NMD_ASSEMBLY_API void _nmd_decode_operand_Ew(const nmd_x86_instruction* instruct
 
 NMD_ASSEMBLY_API void _nmd_decode_operand_Ev(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
 {
-	_nmd_decode_memory_operand(instruction, operand, (uint8_t)(instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? NMD_X86_REG_AX : NMD_X86_REG_EAX));
+	_nmd_decode_memory_operand(instruction, operand, (uint8_t)_NMD_GET_BY_MODE_OPSZPRFX_W64(instruction->mode, instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE, instruction->rex_w_prefix, NMD_X86_REG_AX, NMD_X86_REG_EAX, NMD_X86_REG_RAX));
 }
 
 NMD_ASSEMBLY_API void _nmd_decode_operand_Ey(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
@@ -100,6 +129,8 @@ NMD_ASSEMBLY_API void _nmd_decode_operand_Gb(const nmd_x86_instruction* instruct
 {
 	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
 	operand->fields.reg = NMD_X86_REG_AL + instruction->modrm.fields.reg;
+	if (instruction->prefixes & NMD_X86_PREFIXES_REX_R)
+		operand->fields.reg = _nmd_extend_gpr(operand->fields.reg);
 }
 
 NMD_ASSEMBLY_API void _nmd_decode_operand_Gd(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
@@ -117,10 +148,9 @@ NMD_ASSEMBLY_API void _nmd_decode_operand_Gw(const nmd_x86_instruction* instruct
 NMD_ASSEMBLY_API void _nmd_decode_operand_Gv(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
 {
 	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
-	if (instruction->prefixes & NMD_X86_PREFIXES_REX_B)
-		operand->fields.reg = (uint8_t)((!(instruction->prefixes & NMD_X86_PREFIXES_REX_W) ? NMD_X86_REG_R8D : NMD_X86_REG_R8) + instruction->modrm.fields.reg);
-	else
-		operand->fields.reg = (uint8_t)((instruction->rex_w_prefix ? NMD_X86_REG_RAX : (instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE && instruction->mode != NMD_X86_MODE_16 ? NMD_X86_REG_AX : NMD_X86_REG_EAX)) + instruction->modrm.fields.reg);
+	operand->fields.reg = (uint8_t)(_NMD_GET_BY_MODE_OPSZPRFX_W64(instruction->mode, instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE, instruction->rex_w_prefix, NMD_X86_REG_AX, NMD_X86_REG_EAX, NMD_X86_REG_RAX) + instruction->modrm.fields.reg);
+	if (instruction->prefixes & NMD_X86_PREFIXES_REX_R)
+		operand->fields.reg = _nmd_extend_gpr(operand->fields.reg);
 }
 
 NMD_ASSEMBLY_API void _nmd_decode_operand_Rv(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
@@ -192,48 +222,31 @@ NMD_ASSEMBLY_API bool _nmd_decode_modrm(const uint8_t** p_buffer, size_t* p_buff
 	
 	const bool address_prefix = (bool)(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE);
 
-	/* Check for 16-Bit Addressing Form */
-	if (instruction->mode == NMD_X86_MODE_16)
+	/* Check for 16-Bit Addressing Form. The address size prefix toggles between 16 and 32-bit addressing outside 64-bit mode */
+	if (instruction->mode != NMD_X86_MODE_64 && (instruction->mode == NMD_X86_MODE_16) != address_prefix)
 	{
-		if (instruction->modrm.fields.mod != 0b11)
-		{
-			if (instruction->modrm.fields.mod == 0b00)
-			{
-				if (instruction->modrm.fields.rm == 0b110)
-					instruction->disp_mask = NMD_X86_DISP16;
-			}
-			else
-				instruction->disp_mask = (uint8_t)(instruction->modrm.fields.mod == 0b01 ? NMD_X86_DISP8 : NMD_X86_DISP16);
-		}
+		/* Check for displacement */
+		if ((instruction->modrm.fields.mod == 0b00 && instruction->modrm.fields.rm == 0b110) || instruction->modrm.fields.mod == 0b10)
+			instruction->disp_mask = NMD_X86_DISP16;
+		else if (instruction->modrm.fields.mod == 0b01)
+			instruction->disp_mask = NMD_X86_DISP8;
 	}
 	else
 	{
-		/* Check for 16-Bit Addressing Form */
-		if (address_prefix && instruction->mode == NMD_X86_MODE_32)
+		/* Check for SIB byte */
+		if (instruction->modrm.modrm < 0xC0 && instruction->modrm.fields.rm == 0b100)
 		{
-			/* Check for displacement */
-			if ((instruction->modrm.fields.mod == 0b00 && instruction->modrm.fields.rm == 0b110) || instruction->modrm.fields.mod == 0b10)
-				instruction->disp_mask = NMD_X86_DISP16;
-			else if (instruction->modrm.fields.mod == 0b01)
-				instruction->disp_mask = NMD_X86_DISP8;
+			instruction->has_sib = true;
+			_NMD_READ_BYTE(*p_buffer, *p_buffer_size, instruction->sib.sib);
 		}
-		else /*if (!address_prefix || (address_prefix && **b >= 0x40) || (address_prefix && instruction->mode == NMD_X86_MODE_64)) */
-		{
-			/* Check for SIB byte */
-			if (instruction->modrm.modrm < 0xC0 && instruction->modrm.fields.rm == 0b100 && (!address_prefix || (address_prefix && instruction->mode == NMD_X86_MODE_64)))
-			{
-				instruction->has_sib = true;
-				_NMD_READ_BYTE(*p_buffer, *p_buffer_size, instruction->sib.sib);
-			}
 
-			/* Check for displacement */
-			if (instruction->modrm.fields.mod == 0b01) /* disp8 (ModR/M) */
-				instruction->disp_mask = NMD_X86_DISP8;
-			else if ((instruction->modrm.fields.mod == 0b00 && instruction->modrm.fields.rm == 0b101) || instruction->modrm.fields.mod == 0b10) /* disp16,32 (ModR/M) */
-				instruction->disp_mask = (uint8_t)(address_prefix && !(instruction->mode == NMD_X86_MODE_64 && instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE) ? NMD_X86_DISP16 : NMD_X86_DISP32);
-			else if (instruction->has_sib && instruction->sib.fields.base == 0b101) /* disp8,32 (SIB) */
-				instruction->disp_mask = (uint8_t)(instruction->modrm.fields.mod == 0b01 ? NMD_X86_DISP8 : NMD_X86_DISP32);
-		}
+		/* Check for displacement */
+		if (instruction->modrm.fields.mod == 0b01) /* disp8 (ModR/M) */
+			instruction->disp_mask = NMD_X86_DISP8;
+		else if ((instruction->modrm.fields.mod == 0b00 && instruction->modrm.fields.rm == 0b101) || instruction->modrm.fields.mod == 0b10) /* disp32 (ModR/M) */
+			instruction->disp_mask = NMD_X86_DISP32;
+		else if (instruction->has_sib && instruction->sib.fields.base == 0b101) /* disp8,32 (SIB) */
+			instruction->disp_mask = (uint8_t)(instruction->modrm.fields.mod == 0b01 ? NMD_X86_DISP8 : NMD_X86_DISP32);
 	}
 
 	/* Make sure we can read 'instruction->disp_mask' bytes from the buffer */
@@ -252,16 +265,367 @@ NMD_ASSEMBLY_API bool _nmd_decode_modrm(const uint8_t** p_buffer, size_t* p_buff
 	return true;
 }
 
+/* Adds 'reg' to the masks of 'registers'. 'action' is a mask of 'NMD_X86_OPERAND_ACTION'. */
+NMD_ASSEMBLY_API void _nmd_add_register_use(nmd_x86_register_use* registers, uint8_t reg, uint8_t action)
+{
+	uint32_t* read;
+	uint32_t* written;
+	uint32_t bit;
+
+	if (reg >= NMD_X86_REG_IP && reg <= NMD_X86_REG_RIP)
+		read = &registers->gpr_read, written = &registers->gpr_written, bit = NMD_X86_REGISTER_USE_IP;
+	else if (reg >= NMD_X86_REG_AL && reg <= NMD_X86_REG_R15D)
+	{
+		read = &registers->gpr_read, written = &registers->gpr_written;
+		if (reg >= NMD_X86_REG_AH && reg <= NMD_X86_REG_BH)
+			bit = 1u << (reg - NMD_X86_REG_AH);
+		else
+			bit = 1u << ((reg >= NMD_X86_REG_R8 ? 8 : 0) + reg % 8);
+
+		/* A write to an 8 or 16-bit register keeps the register's other bits. */
+		if (action & NMD_X86_OPERAND_ACTION_ANY_WRITE && (reg <= NMD_X86_REG_DI || (reg >= NMD_X86_REG_R8B && reg <= NMD_X86_REG_R15W)))
+			action |= NMD_X86_OPERAND_ACTION_READ;
+	}
+	else if (reg >= NMD_X86_REG_ES && reg <= NMD_X86_REG_GS)
+		read = &registers->gpr_read, written = &registers->gpr_written, bit = NMD_X86_REGISTER_USE_ES << (reg - NMD_X86_REG_ES);
+	else if (reg >= NMD_X86_REG_XMM0 && reg <= NMD_X86_REG_ZMM31)
+		read = &registers->vector_read, written = &registers->vector_written, bit = 1u << ((reg - NMD_X86_REG_XMM0) % 32);
+	else
+	{
+		read = &registers->other_read, written = &registers->other_written;
+		if (reg >= NMD_X86_REG_CR0 && reg <= NMD_X86_REG_CR15)
+			bit = NMD_X86_REGISTER_USE_CR;
+		else if (reg >= NMD_X86_REG_DR0 && reg <= NMD_X86_REG_DR15)
+			bit = NMD_X86_REGISTER_USE_DR;
+		else if (reg >= NMD_X86_REG_MM0 && reg <= NMD_X86_REG_MM7)
+			bit = NMD_X86_REGISTER_USE_MM0 << (reg - NMD_X86_REG_MM0);
+		else if (reg >= NMD_X86_REG_K0 && reg <= NMD_X86_REG_K7)
+			bit = NMD_X86_REGISTER_USE_K0 << (reg - NMD_X86_REG_K0);
+		else if (reg >= NMD_X86_REG_ST0 && reg <= NMD_X86_REG_ST7)
+			bit = NMD_X86_REGISTER_USE_ST0 << (reg - NMD_X86_REG_ST0);
+		else
+			return;
+	}
+
+	if (action & NMD_X86_OPERAND_ACTION_ANY_READ)
+		*read |= bit;
+	if (action & NMD_X86_OPERAND_ACTION_ANY_WRITE)
+		*written |= bit;
+}
+
+/* Adds the registers of a memory operand, which are read to compute the address. The segment register is not used by 'lea'. */
+NMD_ASSEMBLY_API void _nmd_add_memory_register_use(const nmd_x86_instruction* instruction, nmd_x86_register_use* registers, const nmd_x86_memory_operand* mem)
+{
+	_nmd_add_register_use(registers, mem->base, NMD_X86_OPERAND_ACTION_READ);
+	_nmd_add_register_use(registers, mem->index, NMD_X86_OPERAND_ACTION_READ);
+	if (instruction->id != NMD_X86_INSTRUCTION_LEA)
+		_nmd_add_register_use(registers, mem->segment, NMD_X86_OPERAND_ACTION_READ);
+}
+
 /*
-Decodes an instruction. Returns true if the instruction is valid, false otherwise.
+Gets the actions of the ModR/M.reg and ModR/M.rm registers of an instruction whose operands are not filled by the decoder. An action is 'NMD_X86_OPERAND_ACTION_NONE' if
+the field is not a register(e.g. ModR/M.reg of a group opcode). Only the destination is written. It's also assumed to be read, because some destinations are(e.g. 'shrd').
+*/
+NMD_ASSEMBLY_API void _nmd_get_modrm_actions(const nmd_x86_instruction* instruction, uint8_t* reg_action, uint8_t* rm_action)
+{
+	const uint8_t op = instruction->opcode, reg = instruction->modrm.fields.reg;
+
+	/* The destination is usually ModR/M.reg */
+	*reg_action = NMD_X86_OPERAND_ACTION_READWRITE;
+	*rm_action = NMD_X86_OPERAND_ACTION_READ;
+
+	if (instruction->encoding == NMD_X86_ENCODING_VEX)
+	{
+		const uint8_t map = instruction->vex.vex[0] == 0xc5 ? 1 : instruction->vex.m_mmmm;
+		if (map == 1 && ((op >= 0x71 && op <= 0x73) || op == 0xae)) /* Groups('vpsrlw xmm,xmm,imm8', 'vldmxcsr') */
+			*reg_action = NMD_X86_OPERAND_ACTION_NONE;
+		else if (map == 1 && (op == 0x11 || op == 0x29 || op == 0x7f || op == 0xd6 || (op == 0x7e && instruction->vex.pp != 0b10))) /* Stores('vmovups xmm/m128,xmm', 'vmovd r/m32,xmm') */
+			*reg_action = NMD_X86_OPERAND_ACTION_READ, *rm_action = NMD_X86_OPERAND_ACTION_READWRITE;
+		else if (map == 1 && (op == 0x13 || op == 0x17 || op == 0x2b || op == 0xe7)) /* Stores to memory('vmovlps m64,xmm', 'vmovntps m128,xmm') */
+			*reg_action = NMD_X86_OPERAND_ACTION_READ;
+		else if (map == 2 && (op == 0x2e || op == 0x2f || op == 0x8e)) /* 'vmaskmovps m128,xmm,xmm', 'vpmaskmovd m128,xmm,xmm' */
+			*reg_action = NMD_X86_OPERAND_ACTION_READ;
+		else if (map == 2 && op == 0xf3) /* Group('blsr r32,r/m32') */
+			*reg_action = NMD_X86_OPERAND_ACTION_NONE;
+		else if (map == 3 && ((op >= 0x14 && op <= 0x17) || op == 0x19 || op == 0x1d || op == 0x39)) /* 'vpextrb r/m8,xmm,imm8', 'vextractf128 xmm/m128,ymm,imm8', 'vcvtps2ph xmm/m64,xmm,imm8' */
+			*reg_action = NMD_X86_OPERAND_ACTION_READ, *rm_action = NMD_X86_OPERAND_ACTION_READWRITE;
+	}
+	else if (instruction->opcode_map == NMD_X86_OPCODE_MAP_DEFAULT && op >= 0xd8 && op <= 0xdf)
+	{
+		/* x87 instruction. ModR/M.reg is part of the opcode and ModR/M.rm is 'st(i)', which is only written by 'fxch', 'ffree', 'fst', 'fstp' and the DC and DE
+		   arithmetic forms(e.g. 'fadd st(i),st(0)'), except 'fcompp' */
+		*reg_action = NMD_X86_OPERAND_ACTION_NONE;
+		if ((op == 0xd9 && reg == 1) || (op == 0xdd && reg <= 3) || op == 0xdc || (op == 0xde && reg != 3))
+			*rm_action = NMD_X86_OPERAND_ACTION_READWRITE;
+	}
+	else if (instruction->opcode_map == NMD_X86_OPCODE_MAP_0F)
+	{
+		if (op == 0x00) /* Group('sldt r/m16' and 'str r/m16' write ModR/M.rm, 'lldt', 'ltr', 'verr' and 'verw' read it) */
+			*reg_action = NMD_X86_OPERAND_ACTION_NONE, *rm_action = (uint8_t)(reg <= 1 ? NMD_X86_OPERAND_ACTION_READWRITE : NMD_X86_OPERAND_ACTION_READ);
+		else if (op == 0xba) /* Group('bt r/m,imm8' reads ModR/M.rm, 'bts', 'btr' and 'btc' write it) */
+			*reg_action = NMD_X86_OPERAND_ACTION_NONE, *rm_action = (uint8_t)(reg >= 5 ? NMD_X86_OPERAND_ACTION_READWRITE : NMD_X86_OPERAND_ACTION_READ);
+		else if (op == 0xc7) /* Group('rdrand r', 'rdseed r', 'cmpxchg8b m64') */
+			*reg_action = NMD_X86_OPERAND_ACTION_NONE, *rm_action = NMD_X86_OPERAND_ACTION_READWRITE;
+		else if (op == 0x0d || (op >= 0x18 && op <= 0x1f) || op == 0xa3 || op == 0xb9 || op == 0xff) /* Hints('prefetchw', 'nop r/m'), 'bt r/m,r', 'ud1' and 'ud0' write nothing */
+			*reg_action = NMD_X86_OPERAND_ACTION_READ;
+		else if (op == 0xa4 || op == 0xa5 || op == 0xab || op == 0xac || op == 0xad || op == 0xb0 || op == 0xb1 || op == 0xb3 || op == 0xbb) /* 'shld', 'shrd', 'bts', 'btr', 'btc' and 'cmpxchg' write ModR/M.rm */
+			*reg_action = NMD_X86_OPERAND_ACTION_READ, *rm_action = NMD_X86_OPERAND_ACTION_READWRITE;
+		else if (op == 0xc0 || op == 0xc1) /* 'xadd' writes both */
+			*rm_action = NMD_X86_OPERAND_ACTION_READWRITE;
+	}
+}
+
+/*
+Adds the registers of the ModR/M byte of an instruction whose operands are not filled by the decoder(e.g. VEX instructions).
+The operands' actions are unknown, see _nmd_get_modrm_actions(). 'vex.vvvv' is assumed to be read.
+*/
+NMD_ASSEMBLY_API void _nmd_add_modrm_register_use(const nmd_x86_instruction* instruction, nmd_x86_register_use* registers)
+{
+	const bool vex = instruction->encoding == NMD_X86_ENCODING_VEX;
+	uint8_t reg_action, rm_action;
+	_nmd_get_modrm_actions(instruction, &reg_action, &rm_action);
+
+	if (!vex && instruction->opcode_map == NMD_X86_OPCODE_MAP_DEFAULT && instruction->opcode >= 0xd8 && instruction->opcode <= 0xdf)
+	{
+		/* x87 instruction. */
+		if (instruction->modrm.fields.mod == 0b11)
+			_nmd_add_register_use(registers, (uint8_t)(NMD_X86_REG_ST0 + instruction->modrm.fields.rm), rm_action);
+	}
+	else
+	{
+		/* The registers of legacy instructions are general purpose registers, except in the 0F38h and 0F3Ah maps(SSE). 'r8'-'r15' follow 'rax'-'rdi' like 'xmm8'-'xmm15' follow 'xmm0'-'xmm7'. */
+		const uint8_t base_reg = (uint8_t)(vex || ((instruction->opcode_map == NMD_X86_OPCODE_MAP_0F38 || instruction->opcode_map == NMD_X86_OPCODE_MAP_0F3A) && instruction->opcode < 0xf0) ? NMD_X86_REG_XMM0 : NMD_X86_REG_RAX);
+		const bool extend_reg = vex ? (instruction->mode == NMD_X86_MODE_64 && !instruction->vex.R) : (instruction->prefixes & NMD_X86_PREFIXES_REX_R) != 0;
+		const bool extend_rm = vex ? (instruction->mode == NMD_X86_MODE_64 && instruction->vex.vex[0] == 0xc4 && !instruction->vex.B) : (instruction->prefixes & NMD_X86_PREFIXES_REX_B) != 0;
+
+		if (reg_action)
+			_nmd_add_register_use(registers, (uint8_t)(base_reg + (extend_reg ? 8 : 0) + instruction->modrm.fields.reg), reg_action);
+		if (instruction->modrm.fields.mod == 0b11)
+			_nmd_add_register_use(registers, (uint8_t)(base_reg + (extend_rm ? 8 : 0) + instruction->modrm.fields.rm), rm_action);
+	}
+
+	if (vex)
+		_nmd_add_register_use(registers, (uint8_t)(NMD_X86_REG_XMM0 + ((15 - instruction->vex.vvvv) & (instruction->mode == NMD_X86_MODE_64 ? 15 : 7))), NMD_X86_OPERAND_ACTION_READ);
+
+	if (instruction->modrm.fields.mod != 0b11)
+	{
+		nmd_x86_operand operand;
+		operand.fields.mem.base = operand.fields.mem.index = 0;
+		_nmd_decode_modrm_upper32(instruction, &operand);
+
+		/* The REX prefix is not used by VEX instructions, the registers are extended by 'vex.B' and 'vex.X'. */
+		if (vex && instruction->mode == NMD_X86_MODE_64 && instruction->vex.vex[0] == 0xc4)
+		{
+			if (!instruction->vex.B && operand.fields.mem.base >= NMD_X86_REG_EAX && operand.fields.mem.base <= NMD_X86_REG_RDI)
+				operand.fields.mem.base = _nmd_extend_gpr(operand.fields.mem.base);
+			if (!instruction->vex.X && operand.fields.mem.index >= NMD_X86_REG_EAX && operand.fields.mem.index <= NMD_X86_REG_RDI)
+				operand.fields.mem.index = _nmd_extend_gpr(operand.fields.mem.index);
+		}
+
+		_nmd_add_memory_register_use(instruction, registers, &operand.fields.mem);
+	}
+}
+
+/* Returns the mask of the segment register used by the source operand of a string instruction. */
+NMD_ASSEMBLY_API uint32_t _nmd_get_string_source_segment(const nmd_x86_instruction* instruction)
+{
+	return instruction->segment_override ? (uint32_t)NMD_X86_REGISTER_USE_ES << _nmd_get_bit_index(instruction->segment_override) : (uint32_t)NMD_X86_REGISTER_USE_DS;
+}
+
+/* Adds the registers used by the instruction that are not in its operands(e.g. 'rdx' of 'mul ecx' and 'rsi'/'rdi'/'rcx' of 'rep movsb'). */
+NMD_ASSEMBLY_API void _nmd_add_implicit_register_use(const nmd_x86_instruction* instruction, nmd_x86_register_use* registers)
+{
+	uint32_t read = 0, written = 0;
+
+	switch (instruction->id)
+	{
+	case NMD_X86_INSTRUCTION_IMUL:
+		if (instruction->num_operands != 1)
+			break;
+		/* fall through */
+	case NMD_X86_INSTRUCTION_MUL:
+		read = NMD_X86_REGISTER_USE_RAX;
+		written = instruction->opcode == 0xf6 ? NMD_X86_REGISTER_USE_RAX : (NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RDX);
+		break;
+	case NMD_X86_INSTRUCTION_DIV:
+	case NMD_X86_INSTRUCTION_IDIV:
+		read = written = instruction->opcode == 0xf6 ? NMD_X86_REGISTER_USE_RAX : (NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RDX);
+		break;
+	case NMD_X86_INSTRUCTION_STOSB: case NMD_X86_INSTRUCTION_STOSW: case NMD_X86_INSTRUCTION_STOSD: case NMD_X86_INSTRUCTION_STOSQ:
+		read = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RDI | NMD_X86_REGISTER_USE_ES;
+		written = NMD_X86_REGISTER_USE_RDI;
+		break;
+	case NMD_X86_INSTRUCTION_LODSB: case NMD_X86_INSTRUCTION_LODSW: case NMD_X86_INSTRUCTION_LODSD: case NMD_X86_INSTRUCTION_LODSQ:
+		read = NMD_X86_REGISTER_USE_RSI | _nmd_get_string_source_segment(instruction);
+		written = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RSI;
+		break;
+	case NMD_X86_INSTRUCTION_MOVSB: case NMD_X86_INSTRUCTION_MOVSW: case NMD_X86_INSTRUCTION_MOVSD: case NMD_X86_INSTRUCTION_MOVSQ:
+	case NMD_X86_INSTRUCTION_CMPSB: case NMD_X86_INSTRUCTION_CMPSW: case NMD_X86_INSTRUCTION_CMPSD: case NMD_X86_INSTRUCTION_CMPSQ:
+		/* 'movsd' and 'cmpsd' are also SSE instructions. */
+		if (instruction->opcode_map != NMD_X86_OPCODE_MAP_DEFAULT)
+			return;
+		read = NMD_X86_REGISTER_USE_RSI | NMD_X86_REGISTER_USE_RDI | NMD_X86_REGISTER_USE_ES | _nmd_get_string_source_segment(instruction);
+		written = NMD_X86_REGISTER_USE_RSI | NMD_X86_REGISTER_USE_RDI;
+		break;
+	case NMD_X86_INSTRUCTION_SCASB: case NMD_X86_INSTRUCTION_SCASW: case NMD_X86_INSTRUCTION_SCASD: case NMD_X86_INSTRUCTION_SCASQ:
+		read = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RDI | NMD_X86_REGISTER_USE_ES;
+		written = NMD_X86_REGISTER_USE_RDI;
+		break;
+	case NMD_X86_INSTRUCTION_INSB: case NMD_X86_INSTRUCTION_INSW: case NMD_X86_INSTRUCTION_INSD:
+		read = NMD_X86_REGISTER_USE_RDX | NMD_X86_REGISTER_USE_RDI | NMD_X86_REGISTER_USE_ES;
+		written = NMD_X86_REGISTER_USE_RDI;
+		break;
+	case NMD_X86_INSTRUCTION_OUTSB: case NMD_X86_INSTRUCTION_OUTSW: case NMD_X86_INSTRUCTION_OUTSD:
+		read = NMD_X86_REGISTER_USE_RDX | NMD_X86_REGISTER_USE_RSI | _nmd_get_string_source_segment(instruction);
+		written = NMD_X86_REGISTER_USE_RSI;
+		break;
+	case NMD_X86_INSTRUCTION_LOOP: case NMD_X86_INSTRUCTION_LOOPE: case NMD_X86_INSTRUCTION_LOOPNE:
+		read = written = NMD_X86_REGISTER_USE_RCX;
+		break;
+	case NMD_X86_INSTRUCTION_JCXZ: case NMD_X86_INSTRUCTION_JECXZ: case NMD_X86_INSTRUCTION_JRCXZ:
+		read = NMD_X86_REGISTER_USE_RCX;
+		break;
+	case NMD_X86_INSTRUCTION_CMPXCHG:
+		read = written = NMD_X86_REGISTER_USE_RAX;
+		break;
+	case NMD_X86_INSTRUCTION_CMPXCHG8B:
+	case NMD_X86_INSTRUCTION_CMPXCHG16B:
+		read = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RCX | NMD_X86_REGISTER_USE_RDX | NMD_X86_REGISTER_USE_RBX;
+		written = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RDX;
+		break;
+	case NMD_X86_INSTRUCTION_RDTSCP:
+		written = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RCX | NMD_X86_REGISTER_USE_RDX;
+		break;
+	case NMD_X86_INSTRUCTION_XGETBV:
+	case NMD_X86_INSTRUCTION_RDPMC:
+		read = NMD_X86_REGISTER_USE_RCX;
+		written = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RDX;
+		break;
+	case NMD_X86_INSTRUCTION_XSETBV:
+		read = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RCX | NMD_X86_REGISTER_USE_RDX;
+		break;
+	case NMD_X86_INSTRUCTION_MONITOR:
+		read = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RCX | NMD_X86_REGISTER_USE_RDX;
+		break;
+	case NMD_X86_INSTRUCTION_MWAIT:
+		read = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RCX;
+		break;
+	case NMD_X86_INSTRUCTION_ENTER:
+		read = written = NMD_X86_REGISTER_USE_RSP | NMD_X86_REGISTER_USE_RBP;
+		break;
+	case NMD_X86_INSTRUCTION_SWAPGS:
+		read = written = NMD_X86_REGISTER_USE_GS;
+		break;
+	}
+
+	/* String instructions use the direction flag, and 'rcx' if they have a repeat prefix. */
+	if (instruction->opcode_map == NMD_X86_OPCODE_MAP_DEFAULT && ((instruction->opcode >= 0xa4 && instruction->opcode <= 0xa7) || (instruction->opcode >= 0xaa && instruction->opcode <= 0xaf) || (instruction->opcode >= 0x6c && instruction->opcode <= 0x6f)))
+	{
+		registers->flags_read |= NMD_X86_EFLAGS_DF;
+		if (instruction->prefixes & (NMD_X86_PREFIXES_REPEAT | NMD_X86_PREFIXES_REPEAT_NOT_ZERO))
+		{
+			read |= NMD_X86_REGISTER_USE_RCX, written |= NMD_X86_REGISTER_USE_RCX;
+			if (instruction->opcode == 0xa6 || instruction->opcode == 0xa7 || instruction->opcode == 0xae || instruction->opcode == 0xaf)
+				registers->flags_read |= NMD_X86_EFLAGS_ZF;
+		}
+	}
+
+	/* Every branch writes the instruction pointer, relative branches also read it. */
+	if (instruction->group & (NMD_GROUP_JUMP | NMD_GROUP_CALL | NMD_GROUP_RET | NMD_GROUP_INT))
+	{
+		written |= NMD_X86_REGISTER_USE_IP;
+		if (instruction->group & NMD_GROUP_RELATIVE_ADDRESSING)
+			read |= NMD_X86_REGISTER_USE_IP;
+	}
+
+	registers->gpr_read |= read;
+	registers->gpr_written |= written;
+}
+
+/*
+Computes the registers and cpu flags read and written by an instruction. This is the function used by the decoder to fill the 'registers' variable
+if 'NMD_X86_DECODER_FLAGS_REGISTERS' is set. The masks are complete if the instruction was decoded with 'NMD_X86_DECODER_FLAGS_INSTRUCTION_ID',
+'NMD_X86_DECODER_FLAGS_CPU_FLAGS', 'NMD_X86_DECODER_FLAGS_OPERANDS' and 'NMD_X86_DECODER_FLAGS_GROUP'.
 Parameters:
- - buffer      [in]  A pointer to a buffer containing an encoded instruction.
- - buffer_size [in]  The size of the buffer in bytes.
- - instruction [out] A pointer to a variable of type 'nmd_x86_instruction' that receives information about the instruction.
- - mode        [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
- - flags       [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use. If uncertain, use 'NMD_X86_DECODER_FLAGS_MINIMAL'.
+ - instruction [in]  A pointer to a variable of type 'nmd_x86_instruction' describing the instruction.
+ - registers   [out] A pointer to a variable of type 'nmd_x86_register_use' that receives the masks.
 */
-NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_size, nmd_x86_instruction* instruction, NMD_X86_MODE mode, uint32_t flags)
+NMD_ASSEMBLY_API void nmd_x86_get_register_use(const nmd_x86_instruction* instruction, nmd_x86_register_use* registers)
+{
+	size_t i;
+
+	registers->gpr_read = registers->gpr_written = 0;
+	registers->vector_read = registers->vector_written = 0;
+	registers->other_read = registers->other_written = 0;
+	registers->flags_read = instruction->tested_flags.eflags;
+	registers->flags_written = instruction->modified_flags.eflags | instruction->set_flags.eflags | instruction->cleared_flags.eflags | instruction->undefined_flags.eflags;
+
+	for (i = 0; i < instruction->num_operands; i++)
+	{
+		const nmd_x86_operand* operand = &instruction->operands[i];
+		if (operand->type == NMD_X86_OPERAND_TYPE_REGISTER)
+			_nmd_add_register_use(registers, operand->fields.reg, operand->action);
+		else if (operand->type == NMD_X86_OPERAND_TYPE_MEMORY)
+			_nmd_add_memory_register_use(instruction, registers, &operand->fields.mem);
+	}
+
+	if (!instruction->num_operands && instruction->has_modrm && instruction->id != NMD_X86_INSTRUCTION_NOP)
+		_nmd_add_modrm_register_use(instruction, registers);
+
+	_nmd_add_implicit_register_use(instruction, registers);
+}
+
+/* Sets the bytes in the range ['begin', 'end') of 'instruction' to zero. */
+#define _NMD_CLEAR_INSTRUCTION_RANGE(instruction, begin, end) do { uint8_t* _p = (uint8_t*)(instruction) + (begin); uint8_t* const _end = (uint8_t*)(instruction) + (end); for (; _p < _end; _p++) *_p = 0x00; } while (0)
+
+/* All zeros. Copying it as a whole lets the compiler emit one block copy instead of a byte loop. */
+static const nmd_x86_instruction _nmd_empty_instruction = { 0 };
+
+/* Clears the variables of 'instruction' used by the decoder. 'buffer', the operands, the cpu flags and 'registers' are only cleared if required by 'flags'. */
+NMD_ASSEMBLY_API void _nmd_clear_instruction(nmd_x86_instruction* instruction, uint32_t flags)
+{
+	size_t i;
+
+	if ((flags & (NMD_X86_DECODER_FLAGS_OPERANDS | NMD_X86_DECODER_FLAGS_CPU_FLAGS)) == (NMD_X86_DECODER_FLAGS_OPERANDS | NMD_X86_DECODER_FLAGS_CPU_FLAGS))
+	{
+		*instruction = _nmd_empty_instruction;
+		return;
+	}
+
+	_NMD_CLEAR_INSTRUCTION_RANGE(instruction, 0, _NMD_OFFSETOF(nmd_x86_instruction, buffer));
+
+	if (flags & NMD_X86_DECODER_FLAGS_OPERANDS)
+	{
+		for (i = 0; i < NMD_X86_MAXIMUM_NUM_OPERANDS; i++)
+			instruction->operands[i] = _nmd_empty_instruction.operands[i];
+	}
+
+	instruction->modrm.modrm = instruction->sib.sib = 0;
+	instruction->imm_mask = instruction->disp_mask = 0;
+	instruction->immediate = 0;
+	instruction->displacement = 0;
+	instruction->opcode_map = instruction->encoding = 0;
+	_NMD_CLEAR_INSTRUCTION_RANGE(instruction, _NMD_OFFSETOF(nmd_x86_instruction, vex), _NMD_OFFSETOF(nmd_x86_instruction, modified_flags));
+
+	if (flags & NMD_X86_DECODER_FLAGS_CPU_FLAGS)
+	{
+		instruction->modified_flags.eflags = instruction->tested_flags.eflags = instruction->set_flags.eflags = 0;
+		instruction->cleared_flags.eflags = instruction->undefined_flags.eflags = 0;
+	}
+
+	instruction->rex = instruction->segment_override = 0;
+	instruction->simd_prefix = 0;
+	if (flags & NMD_X86_DECODER_FLAGS_REGISTERS)
+		instruction->registers = _nmd_empty_instruction.registers;
+	instruction->source = 0;
+}
+
+/*
+Decodes an instruction assuming 'instruction' was already cleared by the caller(see _nmd_clear_instruction()).
+'buffer_size' must not be greater than 15(NMD_X86_MAXIMUM_INSTRUCTION_LENGTH).
+This function is always inlined, so every caller that passes constants as 'mode' and 'flags'(see NMD_X86_DEFINE_DECODER()) gets its own specialized decoder.
+*/
+_NMD_FORCE_INLINE bool _nmd_decode_instruction_inline(const void* const buffer, size_t buffer_size, nmd_x86_instruction* instruction, NMD_X86_MODE mode, uint32_t flags)
 {
 	/* Security considerations for memory safety:
 	The contents of 'buffer' should be considered untrusted and decoded carefully.
@@ -273,10 +637,7 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 	Helper macros: _NMD_READ_BYTE()
 	*/
 	
-	/* Clear 'instruction' */
-	size_t i = 0;
-	for (; i < sizeof(nmd_x86_instruction); i++)
-		((uint8_t*)(instruction))[i] = 0x00;
+	size_t i;
 
 	/* Set mode */
 	instruction->mode = (uint8_t)mode;
@@ -284,10 +645,6 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 	/* Set buffer iterator */
 	const uint8_t* b = (const uint8_t*)buffer;
 	
-	/*  Clamp 'buffer_size' to 15. We will only read up to 15 bytes(NMD_X86_MAXIMUM_INSTRUCTION_LENGTH) */
-	if (buffer_size > 15)
-		buffer_size = 15;
-	
 	/* Decode legacy and REX prefixes */
 	for (; buffer_size > 0; b++, buffer_size--)
 	{
@@ -317,6 +674,7 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 					instruction->prefixes = instruction->prefixes | NMD_X86_PREFIXES_REX_X;
 				if (*b & 0b0100) /* Bit position 2 */
 					instruction->prefixes = instruction->prefixes | NMD_X86_PREFIXES_REX_R;
+				instruction->rex_w_prefix = false;
 				if (*b & 0b1000) /* Bit position 3 */
 				{
 					instruction->prefixes = instruction->prefixes | NMD_X86_PREFIXES_REX_W;
@@ -333,6 +691,15 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 	/* Calculate the number of prefixes based on how much the iterator moved */
 	instruction->num_prefixes = (uint8_t)((ptrdiff_t)(b)-(ptrdiff_t)(buffer));
 
+	/* A REX prefix is ignored if it's not the last prefix */
+	if (instruction->has_rex && _NMD_R(b[-1]) != 4)
+	{
+		instruction->has_rex = false;
+		instruction->rex = 0;
+		instruction->rex_w_prefix = false;
+		instruction->prefixes = (instruction->prefixes & ~(NMD_X86_PREFIXES_REX_B | NMD_X86_PREFIXES_REX_X | NMD_X86_PREFIXES_REX_R | NMD_X86_PREFIXES_REX_W));
+	}
+
 	/* Assume the instruction uses legacy encoding. It is most likely the case */
 	instruction->encoding = NMD_X86_ENCODING_LEGACY;
 
@@ -633,8 +1000,8 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 			instruction->opcode = op;
 			instruction->opcode_map = NMD_X86_OPCODE_MAP_0F;
 			
-			/* Check for ModR/M, SIB and displacement */
-			if (op >= 0x20 && op <= 0x23 && buffer_size == 2)
+			/* Check for ModR/M, SIB and displacement. 'mov' to/from control and debug registers ignores the 'mod' field, the operand is always a register */
+			if (op >= 0x20 && op <= 0x23)
 			{
 				instruction->has_modrm = true;
 				_NMD_READ_BYTE(b, buffer_size, instruction->modrm.modrm);
@@ -1326,6 +1693,7 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 							instruction->operands[2].type = NMD_X86_OPERAND_TYPE_REGISTER;
 							instruction->operands[2].fields.reg = NMD_X86_REG_CL;
 						}
+						instruction->operands[2].action = NMD_X86_OPERAND_ACTION_READ;
 					}
 
 					instruction->operands[0].action = NMD_X86_OPERAND_ACTION_READWRITE;
@@ -1497,8 +1865,8 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 		instruction->opcode = op;
 		instruction->opcode_map = NMD_X86_OPCODE_MAP_DEFAULT;
 
-		/* Check for ModR/M, SIB and displacement. */
-		if (_NMD_R(op) == 8 || _nmd_find_byte(_nmd_op1_modrm, sizeof(_nmd_op1_modrm), op) || (_NMD_R(op) < 4 && (_NMD_C(op) < 4 || (_NMD_C(op) >= 8 && _NMD_C(op) < 0xC))) || (_NMD_R(op) == 0xD && _NMD_C(op) >= 8) /* FIXME: We should not access the buffer directly from here || (remaining_size > 1 && ((nmd_x86_modrm*)(b + 1))->fields.mod != 0b11 && (op == 0xc4 || op == 0xc5 || op == 0x62)) */)
+		/* Check for ModR/M, SIB and displacement. Outside 64-bit mode 0x62 is BOUND unless ModR/M.mod is 0b11, which makes it an EVEX prefix. */
+		if (_NMD_R(op) == 8 || _nmd_find_byte(_nmd_op1_modrm, sizeof(_nmd_op1_modrm), op) || (_NMD_R(op) < 4 && (_NMD_C(op) < 4 || (_NMD_C(op) >= 8 && _NMD_C(op) < 0xC))) || (_NMD_R(op) == 0xD && _NMD_C(op) >= 8) || (op == 0x62 && mode != NMD_X86_MODE_64 && buffer_size && (*b >> 6) != 0b11) /* FIXME: We should not access the buffer directly from here || (remaining_size > 1 && ((nmd_x86_modrm*)(b + 1))->fields.mod != 0b11 && (op == 0xc4 || op == 0xc5)) */)
 		{
 			if (!_nmd_decode_modrm(&b, &buffer_size, instruction))
 				return false;
@@ -1565,7 +1933,7 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 				}
 				else /* 0xc5 */
 				{
-					instruction->vex.vvvv = (uint8_t)(byte1 & 0b01111000);
+					instruction->vex.vvvv = (uint8_t)((byte1 & 0b01111000) >> 3);
 					instruction->vex.L = byte1 & 0b00000100;
 					instruction->vex.pp = (uint8_t)(byte1 & 0b00000011);
 
@@ -1618,7 +1986,8 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 					}
 					else if (op == 0x62)
 					{
-						if (mode == NMD_X86_MODE_64)
+						/* EVEX is not supported */
+						if (!instruction->has_modrm)
 							return false;
 					}
 					else if (op == 0x8d)
@@ -1729,7 +2098,7 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 						instruction->id = (uint16_t)((_NMD_C(op) < 8) ? NMD_X86_INSTRUCTION_PUSH : NMD_X86_INSTRUCTION_POP);
 					else if (_NMD_R(op) < 4 && (op % 8 < 6))
 						instruction->id = (NMD_X86_INSTRUCTION_ADD + (_NMD_R(op) << 1) + (_NMD_C(op) >= 8 ? 1 : 0));
-					else if (op >= 0x80 && op <= 0x84)
+					else if (op >= 0x80 && op <= 0x83)
 						instruction->id = NMD_X86_INSTRUCTION_ADD + modrm.fields.reg;
 					else if (op == 0xe8)
 						instruction->id = NMD_X86_INSTRUCTION_CALL;
@@ -2242,7 +2611,7 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 					else if (op == 0x6a || op == 0x68) /* push imm8,push imm32/imm16 */
 					{
 						instruction->num_operands = 3;
-						_NMD_SET_IMM_OPERAND(instruction->operands[0], false, NMD_X86_OPERAND_ACTION_READ, instruction->immediate);
+						_NMD_SET_IMM_OPERAND(instruction->operands[0], false, NMD_X86_OPERAND_ACTION_READ, op == 0x6a ? (int8_t)instruction->immediate : instruction->immediate);
 						_NMD_SET_REG_OPERAND(instruction->operands[1], true, NMD_X86_OPERAND_ACTION_READWRITE, _NMD_GET_GPR(NMD_X86_REG_SP));
 						_NMD_SET_MEM_OPERAND(instruction->operands[2], true, NMD_X86_OPERAND_ACTION_WRITE, NMD_X86_REG_SS, _NMD_GET_GPR(NMD_X86_REG_SP), NMD_X86_REG_NONE, 0, 0);
 					}
@@ -2270,7 +2639,7 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 						_NMD_SET_REG_OPERAND(instruction->operands[2], true, NMD_X86_OPERAND_ACTION_READWRITE, _NMD_GET_GPR(NMD_X86_REG_SP));
 						_NMD_SET_MEM_OPERAND(instruction->operands[3], true, NMD_X86_OPERAND_ACTION_WRITE, NMD_X86_REG_SS, _NMD_GET_GPR(NMD_X86_REG_SP), NMD_X86_REG_NONE, 0, 0);
 					}
-                    else if (_NMD_R(op) < 4 && _NMD_C(op) < 6) /* add,adc,and,xor,or,sbb,sub,cmp Eb,Gb / Ev,Gv / Gb,Eb / Gv,Ev / AL,lb / rAX,lz */
+                    else if (_NMD_R(op) < 4 && op % 8 < 6) /* add,adc,and,xor,or,sbb,sub,cmp Eb,Gb / Ev,Gv / Gb,Eb / Gv,Ev / AL,lb / rAX,lz */
 					{
                         /*
                         if (op % 8 == 0)
@@ -2301,9 +2670,10 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 							if (op % 8 == 4)
 								instruction->operands[0].fields.reg = NMD_X86_REG_AL;
 							else
-								instruction->operands[0].fields.reg = (uint8_t)(instruction->rex_w_prefix ? NMD_X86_REG_RAX : (instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? NMD_X86_REG_AX : NMD_X86_REG_EAX));
+								instruction->operands[0].fields.reg = (uint8_t)_NMD_GET_BY_MODE_OPSZPRFX_W64(mode, opszprfx, instruction->rex_w_prefix, NMD_X86_REG_AX, NMD_X86_REG_EAX, NMD_X86_REG_RAX);
 
 							instruction->operands[1].type = NMD_X86_OPERAND_TYPE_IMMEDIATE;
+							instruction->operands[1].fields.imm = _nmd_sign_extend(instruction->immediate, instruction->imm_mask);
 						}
 
 						instruction->operands[0].action = instruction->operands[1].action = NMD_X86_OPERAND_ACTION_READ;
@@ -2328,7 +2698,13 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 					else if (op == 0xff && modrm.fields.reg == 6) /* push mem */
 					{
 						instruction->num_operands = 3;
-						_NMD_SET_MEM_OPERAND(instruction->operands[0], false, NMD_X86_OPERAND_ACTION_READ, NMD_X86_REG_DS, (instruction->prefixes& NMD_X86_PREFIXES_REX_B ? (opszprfx ? NMD_X86_REG_R8W : NMD_X86_REG_R8) : (opszprfx ? (instruction->mode == NMD_X86_MODE_16 ? NMD_X86_REG_EAX : NMD_X86_REG_AX) : (NMD_X86_REG_AX + (instruction->mode >> 2) * 8))) + modrm.fields.rm, NMD_X86_REG_NONE, 0, 0);
+						if (modrm.fields.mod == 0b11)
+							_NMD_SET_REG_OPERAND(instruction->operands[0], false, NMD_X86_OPERAND_ACTION_READ, (instruction->prefixes & NMD_X86_PREFIXES_REX_B ? (opszprfx ? NMD_X86_REG_R8W : NMD_X86_REG_R8) : (opszprfx ? (instruction->mode == NMD_X86_MODE_16 ? NMD_X86_REG_EAX : NMD_X86_REG_AX) : (NMD_X86_REG_AX + (instruction->mode >> 2) * 8))) + modrm.fields.rm)
+						else
+						{
+							_nmd_decode_modrm_upper32(instruction, &instruction->operands[0]);
+							instruction->operands[0].action = NMD_X86_OPERAND_ACTION_READ;
+						}
 						_NMD_SET_REG_OPERAND(instruction->operands[1], true, NMD_X86_OPERAND_ACTION_READWRITE, _NMD_GET_GPR(NMD_X86_REG_SP));
 						_NMD_SET_MEM_OPERAND(instruction->operands[2], true, NMD_X86_OPERAND_ACTION_WRITE, NMD_X86_REG_SS, _NMD_GET_GPR(NMD_X86_REG_SP), NMD_X86_REG_NONE, 0, 0);
 
@@ -2447,11 +2823,11 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
                         }
                         else
                         {
-                            _nmd_decode_modrm_upper32(instruction, &instruction->operands[0]);
+                            _nmd_decode_operand_Ev(instruction, &instruction->operands[0]);
                             instruction->operands[0].is_implicit = false;
                             instruction->operands[0].action = NMD_X86_OPERAND_ACTION_WRITE;
                         }
-                        _NMD_SET_IMM_OPERAND(instruction->operands[1], false, NMD_X86_OPERAND_ACTION_READ, instruction->immediate);						
+                        _NMD_SET_IMM_OPERAND(instruction->operands[1], false, NMD_X86_OPERAND_ACTION_READ, _nmd_sign_extend(instruction->immediate, instruction->imm_mask));						
                     }
 					else if (op >= 0x84 && op <= 0x8b)
 					{
@@ -2482,15 +2858,10 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 							_nmd_decode_operand_Ev(instruction, &instruction->operands[0]);
 						instruction->operands[0].action = NMD_X86_OPERAND_ACTION_READWRITE;
 						instruction->operands[1].type = NMD_X86_OPERAND_TYPE_IMMEDIATE;
+						instruction->operands[1].fields.imm = _nmd_sign_extend(instruction->immediate, instruction->imm_mask);
 					}
 					else if (_NMD_R(op) == 7 || op == 0x9a || op == 0xcd || op == 0xd4 || op == 0xd5)
 						instruction->operands[0].type = NMD_X86_OPERAND_TYPE_IMMEDIATE;
-					else if (op == 0x90 && instruction->prefixes & NMD_X86_PREFIXES_REX_B)
-					{
-						instruction->operands[0].type = instruction->operands[1].type = NMD_X86_OPERAND_TYPE_REGISTER;
-						instruction->operands[0].fields.reg = (uint8_t)(instruction->prefixes & NMD_X86_PREFIXES_REX_W ? NMD_X86_REG_R8 : NMD_X86_REG_R8D);
-						instruction->operands[1].fields.reg = (uint8_t)(instruction->prefixes & NMD_X86_PREFIXES_REX_W ? NMD_X86_REG_RAX : NMD_X86_REG_EAX);
-					}
 					else if (_NMD_R(op) == 5)
 					{
 						instruction->operands[0].type = NMD_X86_OPERAND_TYPE_REGISTER;
@@ -2565,12 +2936,14 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 						_nmd_decode_operand_Ev(instruction, &instruction->operands[0]);
 						instruction->operands[0].action = NMD_X86_OPERAND_ACTION_WRITE;
 					}
-					else if (op >= 0x91 && op <= 0x97)
+					else if ((op >= 0x91 && op <= 0x97) || (op == 0x90 && instruction->prefixes & NMD_X86_PREFIXES_REX_B)) /* xchg reg,(e/r)ax */
 					{
-						_nmd_decode_operand_Gv(instruction, &instruction->operands[0]);
-						instruction->operands[0].fields.reg = instruction->operands[0].fields.reg + _NMD_C(op);
-						instruction->operands[1].type = NMD_X86_OPERAND_TYPE_REGISTER;
-						instruction->operands[1].fields.reg = (uint8_t)(instruction->rex_w_prefix ? NMD_X86_REG_RAX : (instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE && mode != NMD_X86_MODE_16 ? NMD_X86_REG_AX : NMD_X86_REG_EAX));
+						const bool operand16 = opszprfx != (mode == NMD_X86_MODE_16);
+						const bool rexB = instruction->prefixes & NMD_X86_PREFIXES_REX_B;
+						instruction->num_operands = 2;
+						instruction->operands[0].type = instruction->operands[1].type = NMD_X86_OPERAND_TYPE_REGISTER;
+						instruction->operands[0].fields.reg = (uint8_t)((instruction->rex_w_prefix ? (rexB ? NMD_X86_REG_R8 : NMD_X86_REG_RAX) : (operand16 ? (rexB ? NMD_X86_REG_R8W : NMD_X86_REG_AX) : (rexB ? NMD_X86_REG_R8D : NMD_X86_REG_EAX))) + op % 8);
+						instruction->operands[1].fields.reg = (uint8_t)(instruction->rex_w_prefix ? NMD_X86_REG_RAX : (operand16 ? NMD_X86_REG_AX : NMD_X86_REG_EAX));
 						instruction->operands[0].action = instruction->operands[1].action = NMD_X86_OPERAND_ACTION_READWRITE;
 					}
 					else if (op >= 0xa0 && op <= 0xa3)
@@ -2578,11 +2951,8 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 						instruction->operands[op < 0xa2 ? 0 : 1].type = NMD_X86_OPERAND_TYPE_REGISTER;
 						instruction->operands[op < 0xa2 ? 0 : 1].fields.reg = (uint8_t)(op % 2 == 0 ? NMD_X86_REG_AL : (instruction->rex_w_prefix ? NMD_X86_REG_RAX : ((instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE && mode != NMD_X86_MODE_16) || (mode == NMD_X86_MODE_16 && !(instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)) ? NMD_X86_REG_AX : NMD_X86_REG_EAX)));
 						instruction->operands[op < 0xa2 ? 1 : 0].type = NMD_X86_OPERAND_TYPE_MEMORY;
-						
-						/* FIXME: We should not access the buffer from here
-						instruction->operands[op < 0xa2 ? 1 : 0].fields.mem.disp = (mode == NMD_X86_MODE_64) ? *(uint64_t*)(b + 1) : *(uint32_t*)(b + 1);
-						*/
-						
+						instruction->operands[op < 0xa2 ? 1 : 0].fields.mem.disp = _nmd_sign_extend(instruction->immediate, instruction->imm_mask); /* The moffs is decoded as the immediate */
+						instruction->operands[op < 0xa2 ? 1 : 0].fields.mem.size = (uint8_t)(op % 2 == 0 ? 1 : (instruction->operands[op < 0xa2 ? 0 : 1].fields.reg == NMD_X86_REG_AX ? 2 : (instruction->operands[op < 0xa2 ? 0 : 1].fields.reg == NMD_X86_REG_EAX ? 4 : 8)));
 						_nmd_decode_operand_segment_reg(instruction, &instruction->operands[op < 0xa2 ? 1 : 0]);
 						instruction->operands[0].action = NMD_X86_OPERAND_ACTION_WRITE;
 						instruction->operands[1].action = NMD_X86_OPERAND_ACTION_READ;
@@ -2603,6 +2973,7 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 								_nmd_decode_operand_Ev(instruction, &instruction->operands[0]);
 						}
 						instruction->operands[op >= 0xc6 && instruction->modrm.fields.reg ? 0 : 1].type = NMD_X86_OPERAND_TYPE_IMMEDIATE;
+						instruction->operands[op >= 0xc6 && instruction->modrm.fields.reg ? 0 : 1].fields.imm = op == 0xc6 ? _nmd_sign_extend(instruction->immediate, 1) : (int64_t)instruction->immediate;
 						instruction->operands[0].action = (uint8_t)(op <= 0xc1 ? NMD_X86_OPERAND_ACTION_READWRITE : NMD_X86_OPERAND_ACTION_WRITE);
 					}					
 					else if (op == 0xc4 || op == 0xc5)
@@ -2639,6 +3010,7 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 							instruction->operands[1].fields.reg = NMD_X86_REG_CL;
 						}
 						instruction->operands[0].action = NMD_X86_OPERAND_ACTION_READWRITE;
+						instruction->operands[1].action = NMD_X86_OPERAND_ACTION_READ;
 					}
 					else if (op >= 0xd8 && op <= 0xdf)
 					{
@@ -2688,15 +3060,23 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 							instruction->operands[op % 8 <= 5 ? 1 : 0].action = NMD_X86_OPERAND_ACTION_READ;
 						}
 					}
-					else if (op == 0xf6 || op == 0xfe)
+					else if (op == 0xf6 || op == 0xfe || op == 0xf7 || op == 0xff)
 					{
-						_nmd_decode_operand_Eb(instruction, &instruction->operands[0]);
-						instruction->operands[0].action = (uint8_t)(op == 0xfe && instruction->modrm.fields.reg >= 0b010 ? NMD_X86_OPERAND_ACTION_READ : NMD_X86_OPERAND_ACTION_READWRITE);
-					}
-					else if (op == 0xf7 || op == 0xff)
-					{
-						_nmd_decode_operand_Ev(instruction, &instruction->operands[0]);
-						instruction->operands[0].action = (uint8_t)(op == 0xff && instruction->modrm.fields.reg >= 0b010 ? NMD_X86_OPERAND_ACTION_READ : NMD_X86_OPERAND_ACTION_READWRITE);
+						if (op % 2 == 0)
+							_nmd_decode_operand_Eb(instruction, &instruction->operands[0]);
+						else
+							_nmd_decode_operand_Ev(instruction, &instruction->operands[0]);
+						instruction->operands[0].action = (uint8_t)((op >= 0xfe && instruction->modrm.fields.reg >= 0b010) || (op <= 0xf7 && instruction->modrm.fields.reg >= 0b100) ? NMD_X86_OPERAND_ACTION_READ : NMD_X86_OPERAND_ACTION_READWRITE);
+						if (!instruction->num_operands)
+							instruction->num_operands = 1;
+
+						/* test Eb,Ib / test Ev,Iz */
+						if (op <= 0xf7 && instruction->modrm.fields.reg <= 0b001)
+						{
+							instruction->num_operands = 2;
+							instruction->operands[0].action = NMD_X86_OPERAND_ACTION_READ;
+							_NMD_SET_IMM_OPERAND(instruction->operands[1], false, NMD_X86_OPERAND_ACTION_READ, _nmd_sign_extend(instruction->immediate, instruction->imm_mask));
+						}
 					}
 				}
 #endif /* NMD_ASSEMBLY_DISABLE_DECODER_OPERANDS */
@@ -2712,10 +3092,351 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 	}
 
 	instruction->length = (uint8_t)((ptrdiff_t)(b) - (ptrdiff_t)(buffer));
-	for (i = 0; i < instruction->length; i++)
-		instruction->buffer[i] = ((const uint8_t* const)(buffer))[i];
+	if (flags & NMD_X86_DECODER_FLAGS_ZERO_COPY)
+		instruction->source = (const uint8_t*)buffer;
+	else
+	{
+		for (i = 0; i < instruction->length; i++)
+			instruction->buffer[i] = ((const uint8_t* const)(buffer))[i];
+	}
+
+#ifndef NMD_ASSEMBLY_DISABLE_DECODER_REGISTERS
+	if (flags & NMD_X86_DECODER_FLAGS_REGISTERS)
+		nmd_x86_get_register_use(instruction, &instruction->registers);
+#endif /* NMD_ASSEMBLY_DISABLE_DECODER_REGISTERS */
 
 	instruction->valid = true;
 
 	return true;
-}
\ No newline at end of file
+}
+
+/* The generic decoder used by every function of the library. */
+NMD_ASSEMBLY_API bool _nmd_decode_instruction(const void* const buffer, size_t buffer_size, nmd_x86_instruction* instruction, NMD_X86_MODE mode, uint32_t flags)
+{
+	return _nmd_decode_instruction_inline(buffer, buffer_size, instruction, mode, flags);
+}
+
+/*
+Decodes an instruction. Returns true if the instruction is valid, false otherwise.
+Parameters:
+ - buffer      [in]  A pointer to a buffer containing an encoded instruction.
+ - buffer_size [in]  The size of the buffer in bytes.
+ - instruction [out] A pointer to a variable of type 'nmd_x86_instruction' that receives information about the instruction.
+ - mode        [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags       [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use. If uncertain, use 'NMD_X86_DECODER_FLAGS_MINIMAL'.
+*/
+NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_size, nmd_x86_instruction* instruction, NMD_X86_MODE mode, uint32_t flags)
+{
+	/* Clear 'instruction' */
+	size_t i = 0;
+	for (; i < sizeof(nmd_x86_instruction); i++)
+		((uint8_t*)(instruction))[i] = 0x00;
+
+	/*  Clamp 'buffer_size' to 15. We will only read up to 15 bytes(NMD_X86_MAXIMUM_INSTRUCTION_LENGTH) */
+	if (buffer_size > 15)
+		buffer_size = 15;
+
+	return _nmd_decode_instruction(buffer, buffer_size, instruction, mode, flags);
+}
+
+/*
+Decodes consecutive instructions until the end of the buffer, an invalid instruction or the end of the output array is reached. Returns the number of instructions decoded.
+Parameters:
+ - buffer           [in]      A pointer to a buffer containing encoded instructions.
+ - buffer_size      [in]      The buffer's size in bytes.
+ - runtime_address  [in]      The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - mode             [in]      The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags            [in]      A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use. If uncertain, use 'NMD_X86_DECODER_FLAGS_MINIMAL'.
+ - instructions     [out]     A pointer to an array of 'nmd_x86_instruction' that receives the decoded instructions.
+ - num_instructions [in]      The number of elements in 'instructions'.
+ - info             [out/opt] A pointer to a variable of type 'nmd_x86_buffer_info' that receives where and why the function stopped. This parameter may be null.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_decode_buffer(const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags, nmd_x86_instruction* instructions, size_t num_instructions, nmd_x86_buffer_info* info)
+{
+	const uint8_t* b = (const uint8_t*)buffer;
+	const uint8_t* const end = b + buffer_size;
+	uint8_t status = NMD_X86_BUFFER_STATUS_END;
+	size_t count = 0;
+
+	while (b < end)
+	{
+		if (count == num_instructions)
+		{
+			status = NMD_X86_BUFFER_STATUS_OUTPUT_FULL;
+			break;
+		}
+
+		_nmd_clear_instruction(&instructions[count], flags);
+		if (!_nmd_decode_instruction(b, _NMD_MIN((size_t)(end - b), NMD_X86_MAXIMUM_INSTRUCTION_LENGTH), &instructions[count], mode, flags))
+		{
+			status = NMD_X86_BUFFER_STATUS_INVALID;
+			break;
+		}
+
+		b += instructions[count++].length;
+	}
+
+	if (info)
+	{
+		info->offset = (size_t)(b - (const uint8_t*)buffer);
+		info->runtime_address = runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? NMD_X86_INVALID_RUNTIME_ADDRESS : runtime_address + info->offset;
+		info->status = status;
+	}
+
+	return count;
+}
+
+/* Fills the memory operand summary of 'light'. 'instruction' must have the variables used by _nmd_decode_modrm_upper32() set. */
+NMD_ASSEMBLY_API void _nmd_set_light_memory_operand(const nmd_x86_instruction* instruction, nmd_x86_light_instruction* light)
+{
+	nmd_x86_operand operand;
+	if (!instruction->has_modrm || instruction->modrm.fields.mod == 0b11)
+	{
+		light->displacement = 0;
+		light->segment = light->base = light->index = light->scale = 0;
+		return;
+	}
+
+	operand.fields.mem.base = operand.fields.mem.index = operand.fields.mem.scale = 0;
+	_nmd_decode_modrm_upper32(instruction, &operand);
+
+	light->flags |= NMD_X86_LIGHT_FLAGS_MEMORY_OPERAND;
+	light->segment = operand.fields.mem.segment;
+	light->base = operand.fields.mem.base;
+	light->index = operand.fields.mem.index;
+	light->scale = operand.fields.mem.scale;
+	if (instruction->mode == NMD_X86_MODE_64 && !instruction->has_sib && instruction->modrm.fields.mod == 0b00 && instruction->modrm.fields.rm == 0b101)
+		light->base = (uint8_t)(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE ? NMD_X86_REG_EIP : NMD_X86_REG_RIP);
+
+	light->displacement = (int32_t)operand.fields.mem.disp;
+}
+
+/* Sets the branch target of 'light' if 'group' describes a relative branch. 'light->length' must be set. */
+NMD_ASSEMBLY_API void _nmd_set_light_branch_target(nmd_x86_light_instruction* light, uint8_t group, uint64_t immediate, size_t imm_size, uint64_t runtime_address, NMD_X86_MODE mode)
+{
+	int64_t relative;
+	if (!(group & NMD_GROUP_RELATIVE_ADDRESSING) || !(group & NMD_GROUP_BRANCH) || imm_size == 0 || imm_size > 4)
+	{
+		light->branch_target = 0;
+		return;
+	}
+
+	relative = imm_size == 1 ? (int8_t)immediate : (imm_size == 2 ? (int16_t)immediate : (int32_t)immediate);
+	light->flags |= NMD_X86_LIGHT_FLAGS_BRANCH_TARGET;
+	if (runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS)
+		light->branch_target = (uint64_t)(relative + light->length);
+	else
+	{
+		light->branch_target = runtime_address + light->length + (uint64_t)relative;
+		if (mode == NMD_X86_MODE_16)
+			light->branch_target = (uint16_t)light->branch_target;
+		else if (mode == NMD_X86_MODE_32)
+			light->branch_target = (uint32_t)light->branch_target;
+	}
+}
+
+/* Decodes an instruction using nmd_x86_decode() and converts it to a 'nmd_x86_light_instruction'. */
+NMD_ASSEMBLY_API bool _nmd_decode_light_fallback(const void* buffer, size_t buffer_size, uint64_t runtime_address, nmd_x86_light_instruction* light, NMD_X86_MODE mode, uint32_t flags)
+{
+	nmd_x86_instruction instruction;
+	if (!nmd_x86_decode(buffer, buffer_size, &instruction, mode, (flags | NMD_X86_DECODER_FLAGS_GROUP) & ~(NMD_X86_DECODER_FLAGS_OPERANDS | NMD_X86_DECODER_FLAGS_CPU_FLAGS | NMD_X86_DECODER_FLAGS_REGISTERS)))
+		return false;
+
+	light->length = instruction.length;
+	light->id = instruction.id;
+	light->opcode = instruction.opcode;
+	light->opcode_map = instruction.opcode_map;
+	light->group = (uint8_t)(flags & NMD_X86_DECODER_FLAGS_GROUP ? instruction.group : 0);
+	light->flags = (uint8_t)((instruction.prefixes & NMD_X86_PREFIXES_LOCK ? NMD_X86_LIGHT_FLAGS_LOCK : 0) | (instruction.prefixes & (NMD_X86_PREFIXES_REPEAT | NMD_X86_PREFIXES_REPEAT_NOT_ZERO) ? NMD_X86_LIGHT_FLAGS_REPEAT : 0));
+	_nmd_set_light_memory_operand(&instruction, light);
+	_nmd_set_light_branch_target(light, instruction.group, instruction.immediate, instruction.imm_mask, runtime_address, mode);
+
+	return true;
+}
+
+/*
+Decodes an instruction into a compact record. Returns true if the instruction is valid, false otherwise.
+The instruction is decoded using the opcode tables in 'nmd_x86_opcode_tables.c'. If the tables can't describe the instruction(or it has a lock prefix) nmd_x86_decode() is used instead.
+Parameters:
+ - buffer          [in]  A pointer to a buffer containing an encoded instruction.
+ - buffer_size     [in]  The buffer's size in bytes.
+ - runtime_address [in]  The instruction's runtime address used to compute 'branch_target'. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - instruction     [out] A pointer to a variable of type 'nmd_x86_light_instruction' that receives information about the instruction.
+ - mode            [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags           [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use. 'NMD_X86_DECODER_FLAGS_OPERANDS', 'NMD_X86_DECODER_FLAGS_CPU_FLAGS' and 'NMD_X86_DECODER_FLAGS_REGISTERS' are ignored.
+*/
+NMD_ASSEMBLY_API bool nmd_x86_decode_light(const void* buffer, size_t buffer_size, uint64_t runtime_address, nmd_x86_light_instruction* instruction, NMD_X86_MODE mode, uint32_t flags)
+{
+	/* Only the variables used by _nmd_decode_modrm() and _nmd_decode_modrm_upper32() are set. */
+	nmd_x86_instruction modrm_instruction;
+	const _nmd_x86_opcode_info* info;
+	const uint8_t* b = (const uint8_t*)buffer;
+	const size_t original_buffer_size = buffer_size;
+	uint16_t prefixes = 0;
+	uint8_t segment_override = 0;
+	uint8_t op, opcode_map = NMD_X86_OPCODE_MAP_DEFAULT;
+	uint64_t immediate = 0;
+	size_t imm_size, i;
+
+#ifdef NMD_ASSEMBLY_DISABLE_DECODER_VALIDITY_CHECK
+	flags &= ~NMD_X86_DECODER_FLAGS_VALIDITY_CHECK;
+#endif /* NMD_ASSEMBLY_DISABLE_DECODER_VALIDITY_CHECK */
+#ifdef NMD_ASSEMBLY_DISABLE_DECODER_INSTRUCTION_ID
+	flags &= ~NMD_X86_DECODER_FLAGS_INSTRUCTION_ID;
+#endif /* NMD_ASSEMBLY_DISABLE_DECODER_INSTRUCTION_ID */
+#ifdef NMD_ASSEMBLY_DISABLE_DECODER_GROUP
+	flags &= ~NMD_X86_DECODER_FLAGS_GROUP;
+#endif /* NMD_ASSEMBLY_DISABLE_DECODER_GROUP */
+
+	/*  Clamp 'buffer_size' to 15. We will only read up to 15 bytes(NMD_X86_MAXIMUM_INSTRUCTION_LENGTH) */
+	if (buffer_size > 15)
+		buffer_size = 15;
+
+	/* Decode legacy and REX prefixes the same way nmd_x86_decode() does */
+	for (; buffer_size > 0; b++, buffer_size--)
+	{
+		switch (*b)
+		{
+		case 0xF0: prefixes |= NMD_X86_PREFIXES_LOCK; continue;
+		case 0xF2: prefixes |= NMD_X86_PREFIXES_REPEAT_NOT_ZERO; continue;
+		case 0xF3: prefixes |= NMD_X86_PREFIXES_REPEAT; continue;
+		case 0x2E: prefixes |= (segment_override = NMD_X86_PREFIXES_CS_SEGMENT_OVERRIDE); continue;
+		case 0x36: prefixes |= (segment_override = NMD_X86_PREFIXES_SS_SEGMENT_OVERRIDE); continue;
+		case 0x3E: prefixes |= (segment_override = NMD_X86_PREFIXES_DS_SEGMENT_OVERRIDE); continue;
+		case 0x26: prefixes |= (segment_override = NMD_X86_PREFIXES_ES_SEGMENT_OVERRIDE); continue;
+		case 0x64: prefixes |= (segment_override = NMD_X86_PREFIXES_FS_SEGMENT_OVERRIDE); continue;
+		case 0x65: prefixes |= (segment_override = NMD_X86_PREFIXES_GS_SEGMENT_OVERRIDE); continue;
+		case 0x66: prefixes |= NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE; continue;
+		case 0x67: prefixes |= NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE; continue;
+		default:
+			if (mode == NMD_X86_MODE_64 && _NMD_R(*b) == 4) /* REX prefixes [0x40,0x4f] */
+			{
+				prefixes = (uint16_t)((prefixes & ~(NMD_X86_PREFIXES_REX_B | NMD_X86_PREFIXES_REX_X | NMD_X86_PREFIXES_REX_R | NMD_X86_PREFIXES_REX_W)) |
+					(*b & 0b0001 ? NMD_X86_PREFIXES_REX_B : 0) | (*b & 0b0010 ? NMD_X86_PREFIXES_REX_X : 0) | (*b & 0b0100 ? NMD_X86_PREFIXES_REX_R : 0) | (*b & 0b1000 ? NMD_X86_PREFIXES_REX_W : 0));
+				continue;
+			}
+		}
+
+		break;
+	}
+
+	/* A REX prefix is ignored if it's not the last prefix */
+	if (b != (const uint8_t*)buffer && (mode != NMD_X86_MODE_64 || _NMD_R(b[-1]) != 4))
+		prefixes = (uint16_t)(prefixes & ~(NMD_X86_PREFIXES_REX_B | NMD_X86_PREFIXES_REX_X | NMD_X86_PREFIXES_REX_R | NMD_X86_PREFIXES_REX_W));
+
+	/* The lock prefix's validity depends on the opcode and the ModR/M byte, let the full decoder handle it */
+	if (prefixes & NMD_X86_PREFIXES_LOCK)
+		return _nmd_decode_light_fallback(buffer, original_buffer_size, runtime_address, instruction, mode, flags);
+
+	/* Look up the opcode's properties */
+	_NMD_READ_BYTE(b, buffer_size, op);
+	if (op == 0x0F)
+	{
+		_NMD_READ_BYTE(b, buffer_size, op);
+		opcode_map = NMD_X86_OPCODE_MAP_0F;
+		info = &_nmd_x86_op2_info[mode >> 2][op];
+	}
+	else
+		info = &_nmd_x86_op1_info[mode >> 2][op];
+
+	if ((info->flags & _NMD_X86_OPCODE_FALLBACK) == _NMD_X86_OPCODE_FALLBACK)
+		return _nmd_decode_light_fallback(buffer, original_buffer_size, runtime_address, instruction, mode, flags);
+
+	/* Decode ModR/M, SIB and displacement */
+	modrm_instruction.has_modrm = false;
+	if (info->flags & _NMD_X86_OPCODE_MODRM)
+	{
+		modrm_instruction.mode = (uint8_t)mode;
+		modrm_instruction.prefixes = prefixes;
+		modrm_instruction.segment_override = segment_override;
+		modrm_instruction.has_sib = false;
+		modrm_instruction.disp_mask = NMD_X86_DISP_NONE;
+		modrm_instruction.displacement = 0;
+		if (!_nmd_decode_modrm(&b, &buffer_size, &modrm_instruction))
+			return false;
+
+		if (info->flags & _NMD_X86_OPCODE_EXTENSION)
+		{
+			info = &_nmd_x86_opcode_extensions[info->id][modrm_instruction.modrm.fields.reg];
+			if ((info->flags & _NMD_X86_OPCODE_FALLBACK) == _NMD_X86_OPCODE_FALLBACK)
+				return _nmd_decode_light_fallback(buffer, original_buffer_size, runtime_address, instruction, mode, flags);
+		}
+
+		if (info->flags & (modrm_instruction.modrm.fields.mod == 0b11 ? _NMD_X86_OPCODE_INVALID_REG : _NMD_X86_OPCODE_INVALID_MEM))
+		{
+			if (flags & NMD_X86_DECODER_FLAGS_VALIDITY_CHECK)
+				return false;
+
+			/* The tables only describe valid forms */
+			return _nmd_decode_light_fallback(buffer, original_buffer_size, runtime_address, instruction, mode, flags);
+		}
+	}
+
+	/* Determine the immediate's size */
+	imm_size = _nmd_x86_get_imm_size((uint8_t)(info->flags & _NMD_X86_OPCODE_IMM_MASK), mode, (prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE) != 0, (prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE) != 0, (prefixes & NMD_X86_PREFIXES_REX_W) != 0);
+
+	/* Make sure we can read 'imm_size' bytes from the buffer */
+	if (buffer_size < imm_size)
+		return false;
+
+	for (i = 0; i < imm_size; i++)
+		((uint8_t*)(&immediate))[i] = b[i];
+	b += imm_size;
+
+	instruction->length = (uint8_t)((ptrdiff_t)(b) - (ptrdiff_t)(buffer));
+	instruction->id = (uint16_t)(flags & NMD_X86_DECODER_FLAGS_INSTRUCTION_ID ? info->id : 0);
+	instruction->opcode = op;
+	instruction->opcode_map = opcode_map;
+	instruction->group = (uint8_t)(flags & NMD_X86_DECODER_FLAGS_GROUP ? info->group : 0);
+	instruction->flags = (uint8_t)(prefixes & (NMD_X86_PREFIXES_REPEAT | NMD_X86_PREFIXES_REPEAT_NOT_ZERO) ? NMD_X86_LIGHT_FLAGS_REPEAT : 0);
+	_nmd_set_light_memory_operand(&modrm_instruction, instruction);
+	_nmd_set_light_branch_target(instruction, info->group, immediate, imm_size, runtime_address, mode);
+
+	return true;
+}
+
+/*
+Same as nmd_x86_decode_buffer(), but the instructions are decoded by nmd_x86_decode_light(). Returns the number of instructions decoded.
+Parameters:
+ - buffer           [in]      A pointer to a buffer containing encoded instructions.
+ - buffer_size      [in]      The buffer's size in bytes.
+ - runtime_address  [in]      The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - mode             [in]      The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags            [in]      A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+ - instructions     [out]     A pointer to an array of 'nmd_x86_light_instruction' that receives the decoded instructions.
+ - num_instructions [in]      The number of elements in 'instructions'.
+ - info             [out/opt] A pointer to a variable of type 'nmd_x86_buffer_info' that receives where and why the function stopped. This parameter may be null.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_decode_buffer_light(const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags, nmd_x86_light_instruction* instructions, size_t num_instructions, nmd_x86_buffer_info* info)
+{
+	const uint8_t* b = (const uint8_t*)buffer;
+	const uint8_t* const end = b + buffer_size;
+	uint8_t status = NMD_X86_BUFFER_STATUS_END;
+	size_t count = 0;
+
+	while (b < end)
+	{
+		if (count == num_instructions)
+		{
+			status = NMD_X86_BUFFER_STATUS_OUTPUT_FULL;
+			break;
+		}
+
+		if (!nmd_x86_decode_light(b, (size_t)(end - b), runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? NMD_X86_INVALID_RUNTIME_ADDRESS : runtime_address + (size_t)(b - (const uint8_t*)buffer), &instructions[count], mode, flags))
+		{
+			status = NMD_X86_BUFFER_STATUS_INVALID;
+			break;
+		}
+
+		b += instructions[count++].length;
+	}
+
+	if (info)
+	{
+		info->offset = (size_t)(b - (const uint8_t*)buffer);
+		info->runtime_address = runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? NMD_X86_INVALID_RUNTIME_ADDRESS : runtime_address + info->offset;
+		info->status = status;
+	}
+
+	return count;
+}
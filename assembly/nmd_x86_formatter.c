@@ -14,38 +14,68 @@ NMD_ASSEMBLY_API void _nmd_append_string(_nmd_string_info* const si, const char*
 		*si->buffer++ = *source++;
 }
 
+/* Appends the instruction's mnemonic from '_nmd_x86_mnemonics' with a fixed-size copy, or 'fallback' if the id has no entry(e.g. the id was not filled). */
+NMD_ASSEMBLY_API void _nmd_append_mnemonic(_nmd_string_info* const si, const char* fallback)
+{
+	const char* const mnemonic = _nmd_x86_mnemonics + _nmd_x86_mnemonic_offsets[si->instruction->id];
+	size_t i = 0;
+	if (!mnemonic[0])
+	{
+		_nmd_append_string(si, fallback);
+		return;
+	}
+
+	for (; i < 16; i++)
+		si->buffer[i] = mnemonic[i + 1];
+	si->buffer += mnemonic[0];
+}
+
+/* Appends a number without loops that depend on its value, other than one iteration per two decimal digits. */
 NMD_ASSEMBLY_API void _nmd_append_number(_nmd_string_info* const si, uint64_t n)
 {
-	size_t buffer_offset;
+	char* p;
+	size_t num_digits = 1, i;
 	if (si->flags & NMD_X86_FORMAT_FLAGS_HEX)
 	{
-		size_t num_digits = _NMD_GET_NUM_DIGITS_HEX(n);
-		buffer_offset = num_digits;
-
+		const char* const digits = _nmd_hex_digits[si->flags & NMD_X86_FORMAT_FLAGS_HEX_LOWERCASE ? 1 : 0];
 		const bool condition = n > 9 || si->flags & NMD_X86_FORMAT_FLAGS_ENFORCE_HEX_ID;
+
+		/* Count the significant nibbles using comparisons instead of divisions */
+		for (i = 4; i < 64; i += 4)
+			num_digits += (size_t)((n >> i) != 0);
+
 		if (si->flags & NMD_X86_FORMAT_FLAGS_0X_PREFIX && condition)
 			*si->buffer++ = '0', *si->buffer++ = 'x';
 
-		const uint8_t base_char = (uint8_t)(si->flags & NMD_X86_FORMAT_FLAGS_HEX_LOWERCASE ? 0x57 : 0x37);
-		do {
-			size_t num = n % 16;
-			*(si->buffer + --num_digits) = (char)((num > 9 ? base_char : '0') + num);
-		} while ((n /= 16) > 0);
+		p = si->buffer += num_digits;
+		for (i = 0; i < num_digits; i++, n >>= 4)
+			*--p = digits[n & 0xf];
 
 		if (si->flags & NMD_X86_FORMAT_FLAGS_H_SUFFIX && condition)
-			*(si->buffer + buffer_offset++) = 'h';
+			*si->buffer++ = 'h';
 	}
 	else
 	{
-		size_t num_digits = _NMD_GET_NUM_DIGITS(n);
-		buffer_offset = num_digits + 1;
+		for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_powers_of_ten); i++)
+			num_digits += (size_t)(n >= _nmd_powers_of_ten[i]);
 
-		do {
-			*(si->buffer + --num_digits) = (char)('0' + n % 10);
-		} while ((n /= 10) > 0);
-	}
+		/* Write two digits at a time from right to left */
+		p = si->buffer += num_digits;
+		for (; n >= 100; n /= 100)
+		{
+			const size_t pair = (size_t)(n % 100) * 2;
+			*--p = _nmd_decimal_digit_pairs[pair + 1];
+			*--p = _nmd_decimal_digit_pairs[pair];
+		}
 
-	si->buffer += buffer_offset;
+		if (n >= 10)
+		{
+			*--p = _nmd_decimal_digit_pairs[n * 2 + 1];
+			*--p = _nmd_decimal_digit_pairs[n * 2];
+		}
+		else
+			*--p = (char)('0' + n);
+	}
 }
 
 NMD_ASSEMBLY_API void _nmd_append_signed_number(_nmd_string_info* const si, int64_t n, bool show_positive_sign)
@@ -228,7 +258,7 @@ NMD_ASSEMBLY_API void _nmd_append_modrm32_upper(_nmd_string_info* const si)
 			else
 				_nmd_append_number(si, (uint64_t)((int64_t)(si->runtime_address + si->instruction->length) + (int64_t)((int32_t)si->instruction->displacement)));
 		}
-		else if (si->instruction->modrm.fields.mod == 0b00 && ((si->instruction->sib.fields.base == 0b101 && si->instruction->sib.fields.index == 0b100) || si->instruction->modrm.fields.rm == 0b101) && *(si->buffer - 1) == '[')
+		else if (si->instruction->modrm.fields.mod == 0b00 && ((si->instruction->sib.fields.base == 0b101 && si->instruction->sib.fields.index == 0b100) || (si->instruction->modrm.fields.rm == 0b101 && si->instruction->mode != NMD_X86_MODE_64)) && *(si->buffer - 1) == '[') /* In 64-bit mode 'rm' 0b101 is relative to rip */
 			_nmd_append_number(si, si->instruction->mode == NMD_X86_MODE_64 ? 0xFFFFFFFF00000000 | si->instruction->displacement : si->instruction->displacement);
 		else
 		{
@@ -466,7 +496,13 @@ NMD_ASSEMBLY_API char* _nmd_format_operand_to_att(char* operand, _nmd_string_inf
 		if (segment_reg)
 		{
 			if (segment_reg == operand + 2)
+			{
+				/* Inserting the '%' character moves the rest of the string to the right. */
 				_nmd_insert_char(operand, '%'), si->buffer++, operand += 4;
+				memory_operand++, operand_end++;
+				if (next_operand)
+					next_operand++;
+			}
 			else
 			{
 				*operand++ = '%';
@@ -572,20 +608,13 @@ NMD_ASSEMBLY_API char* _nmd_format_operand_to_att(char* operand, _nmd_string_inf
 }
 #endif /* NMD_ASSEMBLY_DISABLE_FORMATTER_ATT_SYNTAX */
 
-/*
-Formats an instruction. This function may cause a crash if you modify 'instruction' manually.
-Parameters:
- - instruction     [in]  A pointer to a variable of type 'nmd_x86_instruction' describing the instruction to be formatted.
- - buffer          [out] A pointer to buffer that receives the string. The buffer's recommended size is 128 bytes.
- - runtime_address [in]  The instruction's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
- - flags           [in]  A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the function should format the instruction. If uncertain, use 'NMD_X86_FORMAT_FLAGS_DEFAULT'.
-*/
-NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, char* buffer, uint64_t runtime_address, uint32_t flags)
+/* Formats an instruction into 'buffer', which must have at least 'NMD_X86_FORMATTER_MAX_LENGTH' bytes. Returns the length of the string excluding the null character. */
+NMD_ASSEMBLY_API size_t _nmd_x86_format(const nmd_x86_instruction* instruction, char* buffer, uint64_t runtime_address, uint32_t flags)
 {
 	if (!instruction->valid)
 	{
 		buffer[0] = '\0';
-		return;
+		return 0;
 	}
 
 	_nmd_string_info si;
@@ -597,13 +626,12 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 #ifndef NMD_ASSEMBLY_DISABLE_FORMATTER_BYTES
 	if (flags & NMD_X86_FORMAT_FLAGS_BYTES)
 	{
+		const uint8_t* const bytes = instruction->source ? instruction->source : instruction->buffer;
 		size_t i = 0;
 		for (; i < instruction->length; i++)
 		{
-			uint8_t num = instruction->buffer[i] >> 4;
-			*si.buffer++ = (char)((num > 9 ? 0x37 : '0') + num);
-			num = instruction->buffer[i] & 0xf;
-			*si.buffer++ = (char)((num > 9 ? 0x37 : '0') + num);
+			*si.buffer++ = _nmd_hex_digits[0][bytes[i] >> 4];
+			*si.buffer++ = _nmd_hex_digits[0][bytes[i] & 0xf];
 			*si.buffer++ = ' ';
 		}
 
@@ -615,15 +643,20 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 
 	const uint8_t op = instruction->opcode;
 
-	if (instruction->prefixes & (NMD_X86_PREFIXES_REPEAT | NMD_X86_PREFIXES_REPEAT_NOT_ZERO) && (instruction->prefixes & NMD_X86_PREFIXES_LOCK || ((op == 0x86 || op == 0x87) && instruction->modrm.fields.mod != 0b11)))
-		_nmd_append_string(&si, instruction->repeat_prefix ? "xrelease " : "xacquire ");
-	else if (instruction->prefixes & NMD_X86_PREFIXES_REPEAT_NOT_ZERO && (instruction->opcode_size == 1 && (op == 0xc2 || op == 0xc3 || op == 0xe8 || op == 0xe9 || _NMD_R(op) == 7 || (op == 0xff && (instruction->modrm.fields.reg == 0b010 || instruction->modrm.fields.reg == 0b100)))))
-		_nmd_append_string(&si, "bnd ");
+	/* Most instructions have none of these prefixes, so the opcode checks are skipped with a single test */
+	if (instruction->prefixes & (NMD_X86_PREFIXES_REPEAT | NMD_X86_PREFIXES_REPEAT_NOT_ZERO | NMD_X86_PREFIXES_LOCK))
+	{
+		if (instruction->prefixes & (NMD_X86_PREFIXES_REPEAT | NMD_X86_PREFIXES_REPEAT_NOT_ZERO) && (instruction->prefixes & NMD_X86_PREFIXES_LOCK || ((op == 0x86 || op == 0x87) && instruction->modrm.fields.mod != 0b11)))
+			_nmd_append_string(&si, instruction->repeat_prefix ? "xrelease " : "xacquire ");
+		else if (instruction->prefixes & NMD_X86_PREFIXES_REPEAT_NOT_ZERO && (instruction->opcode_size == 1 && (op == 0xc2 || op == 0xc3 || op == 0xe8 || op == 0xe9 || _NMD_R(op) == 7 || (op == 0xff && (instruction->modrm.fields.reg == 0b010 || instruction->modrm.fields.reg == 0b100)))))
+			_nmd_append_string(&si, "bnd ");
 
-	if (instruction->prefixes & NMD_X86_PREFIXES_LOCK)
-		_nmd_append_string(&si, "lock ");
+		if (instruction->prefixes & NMD_X86_PREFIXES_LOCK)
+			_nmd_append_string(&si, "lock ");
+	}
 
 	const bool opszprfx = instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE;
+	const bool operand16 = opszprfx != (instruction->mode == NMD_X86_MODE_16); /* The operand-size override prefix toggles between 16 and 32 bits */
 
 	if (instruction->opcode_map == NMD_X86_OPCODE_MAP_DEFAULT)
 	{
@@ -771,7 +804,7 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 			case 0xb7: mnemonic = "pmulhrw"; break;
 			case 0xbb: mnemonic = "pswapd"; break;
 			case 0xbf: mnemonic = "pavgusb"; break;
-			default: return;
+			default: buffer[0] = '\0'; return 0;
 			}
 
 			_nmd_append_string(&si, mnemonic);
@@ -789,7 +822,8 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 			{
 				if (op >= 0x88 && op <= 0x8c) /* mov [88,8c] */
 				{
-					_nmd_append_string(&si, "mov ");
+					_nmd_append_mnemonic(&si, "mov");
+					*si.buffer++ = ' ';
 					if (op == 0x8b)
 					{
 						_nmd_append_Gv(&si);
@@ -840,16 +874,19 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 				}
 				else if (op == 0xff) /* Opcode extensions Group 5 */
 				{
-					_nmd_append_string(&si, _nmd_opcode_extensions_grp5[instruction->modrm.fields.reg]);
+					if (instruction->modrm.fields.reg == 0b011 || instruction->modrm.fields.reg == 0b101)
+						_nmd_append_string(&si, _nmd_opcode_extensions_grp5[instruction->modrm.fields.reg]);
+					else
+						_nmd_append_mnemonic(&si, _nmd_opcode_extensions_grp5[instruction->modrm.fields.reg]);
 					*si.buffer++ = ' ';
 					if (instruction->modrm.fields.mod == 0b11)
-						_nmd_append_string(&si, (si.instruction->rex_w_prefix ? _nmd_reg64 : (opszprfx ? _nmd_reg16 : _nmd_reg32))[si.instruction->modrm.fields.rm]);
+						_nmd_append_string(&si, (si.instruction->rex_w_prefix ? _nmd_reg64 : (operand16 ? _nmd_reg16 : _nmd_reg32))[si.instruction->modrm.fields.rm]);
 					else
-						_nmd_append_modrm_upper(&si, (instruction->modrm.fields.reg == 0b011 || instruction->modrm.fields.reg == 0b101) ? "fword" : (instruction->mode == NMD_X86_MODE_64 && ((instruction->modrm.fields.reg >= 0b010 && instruction->modrm.fields.reg <= 0b110) || (instruction->prefixes & NMD_X86_PREFIXES_REX_W && instruction->modrm.fields.reg <= 0b010)) ? "qword" : (opszprfx ? "word" : "dword")));
+						_nmd_append_modrm_upper(&si, (instruction->modrm.fields.reg == 0b011 || instruction->modrm.fields.reg == 0b101) ? "fword" : (instruction->mode == NMD_X86_MODE_64 && ((instruction->modrm.fields.reg >= 0b010 && instruction->modrm.fields.reg <= 0b110) || (instruction->prefixes & NMD_X86_PREFIXES_REX_W && instruction->modrm.fields.reg <= 0b010)) ? "qword" : (operand16 ? "word" : "dword")));
 				}
 				else if (_NMD_R(op) < 4 && (_NMD_C(op) < 6 || (_NMD_C(op) >= 8 && _NMD_C(op) < 0xE))) /* add,adc,and,xor,or,sbb,sub,cmp */
 				{
-					_nmd_append_string(&si, _nmd_op1_opcode_map_mnemonics[_NMD_R((_NMD_C(op) > 6 ? op + 0x40 : op))]);
+					_nmd_append_mnemonic(&si, _nmd_op1_opcode_map_mnemonics[_NMD_R((_NMD_C(op) > 6 ? op + 0x40 : op))]);
 					*si.buffer++ = ' ';
 
 					switch (op % 8)
@@ -879,7 +916,7 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 						_nmd_append_number(&si, instruction->immediate);
 						break;
 					case 5:
-						_nmd_append_string(&si, instruction->rex_w_prefix ? "rax" : (opszprfx ? "ax" : "eax"));
+						_nmd_append_string(&si, instruction->rex_w_prefix ? "rax" : (operand16 ? "ax" : "eax"));
 						*si.buffer++ = ',';
 						_nmd_append_number(&si, instruction->immediate);
 						break;
@@ -887,12 +924,13 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 				}
 				else if (_NMD_R(op) == 4 || _NMD_R(op) == 5) /* inc,dec,push,pop [0x40, 0x5f] */
 				{
-					_nmd_append_string(&si, _NMD_C(op) < 8 ? (_NMD_R(op) == 4 ? "inc " : "push ") : (_NMD_R(op) == 4 ? "dec " : "pop "));
+					_nmd_append_mnemonic(&si, _NMD_C(op) < 8 ? (_NMD_R(op) == 4 ? "inc" : "push") : (_NMD_R(op) == 4 ? "dec" : "pop"));
+					*si.buffer++ = ' ';
 					_nmd_append_string(&si, (instruction->prefixes & NMD_X86_PREFIXES_REX_B ? (opszprfx ? _nmd_regrxw : _nmd_regrx) : (opszprfx ? (instruction->mode == NMD_X86_MODE_16 ? _nmd_reg32 : _nmd_reg16) : ((instruction->mode == NMD_X86_MODE_32 ? _nmd_reg32 : (instruction->mode == NMD_X86_MODE_64 ? _nmd_reg64 : _nmd_reg16)))))[op % 8]);
 				}
 				else if (op >= 0x80 && op < 0x84) /* add,adc,and,xor,or,sbb,sub,cmp [80,83] */
 				{
-					_nmd_append_string(&si, _nmd_opcode_extensions_grp1[instruction->modrm.fields.reg]);
+					_nmd_append_mnemonic(&si, _nmd_opcode_extensions_grp1[instruction->modrm.fields.reg]);
 					*si.buffer++ = ' ';
 					if (op == 0x80 || op == 0x82)
 						_nmd_append_Eb(&si);
@@ -911,7 +949,8 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 				}
 				else if (op == 0xe8 || op == 0xe9 || op == 0xeb) /* call,jmp */
 				{
-					_nmd_append_string(&si, op == 0xe8 ? "call " : "jmp ");
+					_nmd_append_mnemonic(&si, op == 0xe8 ? "call" : "jmp");
+					*si.buffer++ = ' ';
 					if (op == 0xeb)
 						_nmd_append_relative_address8(&si);
 					else
@@ -919,7 +958,8 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 				}
 				else if (op >= 0xA0 && op < 0xA4) /* mov [a0, a4] */
 				{
-					_nmd_append_string(&si, "mov ");
+					_nmd_append_mnemonic(&si, "mov");
+					*si.buffer++ = ' ';
 					if (op == 0xa0)
 					{
 						_nmd_append_string(&si, "al,");
@@ -930,8 +970,8 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 					}
 					else if (op == 0xa1)
 					{
-						_nmd_append_string(&si, instruction->rex_w_prefix ? "rax," : (opszprfx ? "ax," : "eax,"));
-						_nmd_append_modrm_memory_prefix(&si, instruction->rex_w_prefix ? "qword" : (opszprfx ? "word" : "dword"));
+						_nmd_append_string(&si, instruction->rex_w_prefix ? "rax," : (operand16 ? "ax," : "eax,"));
+						_nmd_append_modrm_memory_prefix(&si, instruction->rex_w_prefix ? "qword" : (operand16 ? "word" : "dword"));
 						*si.buffer++ = '[';
 						_nmd_append_number(&si, (instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE || instruction->mode == NMD_X86_MODE_16 ? 0xFFFF : 0xFFFFFFFFFFFFFFFF) & instruction->immediate);
 						*si.buffer++ = ']';
@@ -945,34 +985,41 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 					}
 					else if (op == 0xa3)
 					{
-						_nmd_append_modrm_memory_prefix(&si, instruction->rex_w_prefix ? "qword" : (opszprfx ? "word" : "dword"));
+						_nmd_append_modrm_memory_prefix(&si, instruction->rex_w_prefix ? "qword" : (operand16 ? "word" : "dword"));
 						*si.buffer++ = '[';
 						_nmd_append_number(&si, (instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE || instruction->mode == NMD_X86_MODE_16 ? 0xFFFF : 0xFFFFFFFFFFFFFFFF) & instruction->immediate);
 						_nmd_append_string(&si, "],");
-						_nmd_append_string(&si, instruction->rex_w_prefix ? "rax" : (opszprfx ? "ax" : "eax"));
+						_nmd_append_string(&si, instruction->rex_w_prefix ? "rax" : (operand16 ? "ax" : "eax"));
 					}
 				}
 				else if(op == 0xcc) /* int3 */
 					_nmd_append_string(&si, "int3");
 				else if (op == 0x8d) /* lea */
 				{
-					_nmd_append_string(&si, "lea ");
+					_nmd_append_mnemonic(&si, "lea");
+					*si.buffer++ = ' ';
 					_nmd_append_Gv(&si);
 					*si.buffer++ = ',';
 					_nmd_append_modrm_upper_without_address_specifier(&si);
 				}
 				else if (op == 0x8f) /* pop */
 				{
-					_nmd_append_string(&si, "pop ");
+					_nmd_append_mnemonic(&si, "pop");
+					*si.buffer++ = ' ';
 					if (instruction->modrm.fields.mod == 0b11)
-						_nmd_append_string(&si, (opszprfx ? _nmd_reg16 : _nmd_reg32)[instruction->modrm.fields.rm]);
+						_nmd_append_string(&si, (operand16 ? _nmd_reg16 : _nmd_reg32)[instruction->modrm.fields.rm]);
 					else
-						_nmd_append_modrm_upper(&si, instruction->mode == NMD_X86_MODE_64 && !(instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE) ? "qword" : (opszprfx ? "word" : "dword"));
+						_nmd_append_modrm_upper(&si, instruction->mode == NMD_X86_MODE_64 && !(instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE) ? "qword" : (operand16 ? "word" : "dword"));
 				}
 				else if (_NMD_R(op) == 7) /* conditional jump [70,7f]*/
 				{
-					*si.buffer++ = 'j';
-					_nmd_append_string(&si, _nmd_condition_suffixes[_NMD_C(op)]);
+					if (_nmd_x86_mnemonic_offsets[instruction->id])
+						_nmd_append_mnemonic(&si, 0);
+					else
+					{
+						*si.buffer++ = 'j';
+						_nmd_append_string(&si, _nmd_condition_suffixes[_NMD_C(op)]);
+					}
 					*si.buffer++ = ' ';
 					_nmd_append_relative_address8(&si);
 				}
@@ -983,7 +1030,7 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 				}
 				else if (op == 0xa9) /* test */
 				{
-					_nmd_append_string(&si, instruction->rex_w_prefix ? "test rax" : (opszprfx ? "test ax" : "test eax"));
+					_nmd_append_string(&si, instruction->rex_w_prefix ? "test rax" : (operand16 ? "test ax" : "test eax"));
 					*si.buffer++ = ',';
 					_nmd_append_number(&si, instruction->immediate);
 				}
@@ -1004,7 +1051,7 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 					if (instruction->prefixes & NMD_X86_PREFIXES_REX_B)
 						_nmd_append_string(&si, _nmd_regrx[op % 8]), * si.buffer++ = _NMD_C(op) < 8 ? 'b' : 'd';
 					else
-						_nmd_append_string(&si, (_NMD_C(op) < 8 ? (instruction->has_rex ? _nmd_reg8_x64 : _nmd_reg8) : (instruction->rex_w_prefix ? _nmd_reg64 : (opszprfx ? _nmd_reg16 : _nmd_reg32)))[op % 8]);
+						_nmd_append_string(&si, (_NMD_C(op) < 8 ? (instruction->has_rex ? _nmd_reg8_x64 : _nmd_reg8) : (instruction->rex_w_prefix ? _nmd_reg64 : (operand16 ? _nmd_reg16 : _nmd_reg32)))[op % 8]);
 					*si.buffer++ = ',';
 					_nmd_append_number(&si, instruction->immediate);
 				}
@@ -1078,8 +1125,8 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 							*si.buffer++ = 'd';
 					}
 					else
-						_nmd_append_string(&si, (instruction->prefixes & NMD_X86_PREFIXES_REX_W ? _nmd_reg64 : (opszprfx ? _nmd_reg16 : _nmd_reg32))[_NMD_C(op)]);
-					_nmd_append_string(&si, (instruction->prefixes & NMD_X86_PREFIXES_REX_W ? ",rax" : (opszprfx ? ",ax" : ",eax")));
+						_nmd_append_string(&si, (instruction->prefixes & NMD_X86_PREFIXES_REX_W ? _nmd_reg64 : (operand16 ? _nmd_reg16 : _nmd_reg32))[_NMD_C(op)]);
+					_nmd_append_string(&si, (instruction->prefixes & NMD_X86_PREFIXES_REX_W ? ",rax" : (operand16 ? ",ax" : ",eax")));
 				}
 				else if (op == 0x9A)
 				{
@@ -1447,7 +1494,7 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 				else if (op == 0xe4 || op == 0xe5)
 				{
 					_nmd_append_string(&si, "in ");
-					_nmd_append_string(&si, op == 0xe4 ? "al" : (opszprfx ? "ax" : "eax"));
+					_nmd_append_string(&si, op == 0xe4 ? "al" : (operand16 ? "ax" : "eax"));
 					*si.buffer++ = ',';
 					_nmd_append_number(&si, instruction->immediate);
 				}
@@ -1456,18 +1503,18 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 					_nmd_append_string(&si, "out ");
 					_nmd_append_number(&si, instruction->immediate);
 					*si.buffer++ = ',';
-					_nmd_append_string(&si, op == 0xe6 ? "al" : (opszprfx ? "ax" : "eax"));
+					_nmd_append_string(&si, op == 0xe6 ? "al" : (operand16 ? "ax" : "eax"));
 				}				
 				else if (op == 0xec || op == 0xed)
 				{
 					_nmd_append_string(&si, "in ");
-					_nmd_append_string(&si, op == 0xec ? "al" : (opszprfx ? "ax" : "eax"));
+					_nmd_append_string(&si, op == 0xec ? "al" : (operand16 ? "ax" : "eax"));
 					_nmd_append_string(&si, ",dx");
 				}
 				else if (op == 0xee || op == 0xef)
 				{
 					_nmd_append_string(&si, "out dx,");
-					_nmd_append_string(&si, op == 0xee ? "al" : (opszprfx ? "ax" : "eax"));
+					_nmd_append_string(&si, op == 0xee ? "al" : (operand16 ? "ax" : "eax"));
 				}
 				else if (op == 0x62)
 				{
@@ -1551,7 +1598,7 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 					case 0xfb: str = "sti"; break;
 					case 0xfc: str = "cld"; break;
 					case 0xfd: str = "std"; break;
-					default: return;
+					default: buffer[0] = '\0'; return 0;
 					}
 					_nmd_append_string(&si, str);
 				}
@@ -1848,7 +1895,7 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 			_nmd_append_Gv(&si);
 			*si.buffer++ = ',';
 			if (si.instruction->modrm.fields.mod == 0b11)
-				_nmd_append_string(&si, (opszprfx ? _nmd_reg16 : _nmd_reg32)[si.instruction->modrm.fields.rm]);
+				_nmd_append_string(&si, (operand16 ? _nmd_reg16 : _nmd_reg32)[si.instruction->modrm.fields.rm]);
 			else
 				_nmd_append_modrm_upper(&si, "word");
 		}
@@ -2767,7 +2814,7 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 			case 0xa8: str = "push gs"; break;
 			case 0xa9: str = "pop gs"; break;
 			case 0xaa: str = "rsm"; break;
-			default: return;
+			default: buffer[0] = '\0'; return 0;
 			}
 			_nmd_append_string(&si, str);
 		}
@@ -3038,8 +3085,9 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 			if (memory_operand)
 			{
 				/* If the memory operand has pointer size. */
-				char* tmp2 = (char*)memory_operand - (*(memory_operand - 1) == ':' ? 7 : 4);
-				if (_nmd_strstr(tmp2, "ptr") == tmp2)
+				const size_t ptr_offset = *(memory_operand - 1) == ':' ? 7 : 4;
+				char* tmp2 = (char*)memory_operand - ((size_t)(memory_operand - buffer) >= ptr_offset ? ptr_offset : 0);
+				if ((size_t)(memory_operand - buffer) >= ptr_offset && _nmd_strstr(tmp2, "ptr") == tmp2)
 				{
 					/* Find the ' '(space) that is after two ' '(spaces). */
 					tmp2 -= 2;
@@ -3086,12 +3134,13 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 			}
 
 			/* Memory operands change the mnemonic string(e.g. 'mov eax, dword ptr [ebx]' -> 'movl (%ebx), %eax'). */
-			if (memory_operand && !_nmd_strstr(first_operand_const - 4, "lea"))
+			/* The mnemonic may be shorter than the searched strings(e.g. 'bt'), so the search must not start before the buffer. */
+			if (memory_operand && !_nmd_strstr(first_operand_const - 4 < buffer ? buffer : first_operand_const - 4, "lea"))
 			{
 				const char* r_char = _nmd_strchr(first_operand_const, 'r');
 				const char* e_char = _nmd_strchr(first_operand_const, 'e');
-				const char* call_str = _nmd_strstr(first_operand_const - 5, "call");
-				const char* jmp_str = _nmd_strstr(first_operand_const - 4, "jmp");
+				const char* call_str = _nmd_strstr(first_operand_const - 5 < buffer ? buffer : first_operand_const - 5, "call");
+				const char* jmp_str = _nmd_strstr(first_operand_const - 4 < buffer ? buffer : first_operand_const - 4, "jmp");
 				_nmd_insert_char(first_operand_const, (instruction->mode == NMD_X86_MODE_64 && ((r_char && *(r_char - 1) == '%') || call_str || jmp_str)) ? 'q' : (instruction->mode == NMD_X86_MODE_32 && ((e_char && *(e_char - 1) == '%') || call_str || jmp_str) ? 'l' : 'b'));
 				si.buffer++;
 			}
@@ -3156,4 +3205,119 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 #endif /* NMD_ASSEMBLY_DISABLE_FORMATTER_OPERATOR_SPACES */
 
 	*si.buffer = '\0';
-}
\ No newline at end of file
+
+	return string_length;
+}
+
+/*
+Formats an instruction. This function may cause a crash if you modify 'instruction' manually.
+Parameters:
+ - instruction     [in]  A pointer to a variable of type 'nmd_x86_instruction' describing the instruction to be formatted.
+ - buffer          [out] A pointer to buffer that receives the string. It should have at least 'NMD_X86_FORMATTER_MAX_LENGTH' bytes.
+ - runtime_address [in]  The instruction's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - flags           [in]  A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the function should format the instruction. If uncertain, use 'NMD_X86_FORMAT_FLAGS_DEFAULT'.
+*/
+NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, char* buffer, uint64_t runtime_address, uint32_t flags)
+{
+	_nmd_x86_format(instruction, buffer, runtime_address, flags);
+}
+
+/*
+Formats an instruction. Returns the length of the string(excluding the null character), or zero if the instruction is invalid or 'buffer_size' is too small.
+Parameters:
+ - instruction     [in]  A pointer to a variable of type 'nmd_x86_instruction' describing the instruction to be formatted.
+ - buffer          [out] A pointer to buffer that receives the string.
+ - buffer_size     [in]  The buffer's size in bytes. If it's smaller than 'NMD_X86_FORMATTER_MAX_LENGTH' the string is formatted in a temporary buffer and then copied.
+ - runtime_address [in]  The instruction's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - flags           [in]  A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the function should format the instruction. If uncertain, use 'NMD_X86_FORMAT_FLAGS_DEFAULT'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_format_ex(const nmd_x86_instruction* instruction, char* buffer, size_t buffer_size, uint64_t runtime_address, uint32_t flags)
+{
+	char temp[NMD_X86_FORMATTER_MAX_LENGTH];
+	size_t length, i;
+
+	if (buffer_size >= NMD_X86_FORMATTER_MAX_LENGTH)
+		return _nmd_x86_format(instruction, buffer, runtime_address, flags);
+
+	length = _nmd_x86_format(instruction, temp, runtime_address, flags);
+	if (length >= buffer_size)
+	{
+		if (buffer_size)
+			buffer[0] = '\0';
+		return 0;
+	}
+
+	for (i = 0; i <= length; i++)
+		buffer[i] = temp[i];
+
+	return length;
+}
+
+/*
+Formats consecutive instructions into a single buffer, one line per instruction. Lines are separated by the '\n'(new line) character. Returns the number of instructions formatted.
+Parameters:
+ - instructions     [in]      A pointer to an array of 'nmd_x86_instruction', usually filled by nmd_x86_decode_buffer().
+ - num_instructions [in]      The number of instructions in the array.
+ - runtime_address  [in]      The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - flags            [in]      A mask of 'NMD_X86_FORMAT_FLAGS_XXX'. If 'NMD_X86_FORMAT_FLAGS_ADDRESS' is set, each line starts with the instruction's runtime address.
+ - buffer           [out]     A pointer to a buffer that receives the lines.
+ - buffer_size      [in]      The buffer's size in bytes.
+ - lines            [out/opt] A pointer to an array of 'nmd_x86_text_line' with at least 'num_instructions' elements that receives the position of each line in 'buffer'. This parameter may be null.
+ - text_length      [out/opt] A pointer to a variable that receives the number of characters written to 'buffer'(excluding the null character). This parameter may be null.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_format_buffer(const nmd_x86_instruction* instructions, size_t num_instructions, uint64_t runtime_address, uint32_t flags, char* buffer, size_t buffer_size, nmd_x86_text_line* lines, size_t* text_length)
+{
+	const char* const digits = _nmd_hex_digits[(flags & (NMD_X86_FORMAT_FLAGS_HEX_LOWERCASE | NMD_X86_FORMAT_FLAGS_UPPERCASE)) == NMD_X86_FORMAT_FLAGS_HEX_LOWERCASE ? 1 : 0];
+	const uint32_t format_flags = flags & ~NMD_X86_FORMAT_FLAGS_ADDRESS;
+	size_t i = 0, offset = 0;
+
+	for (; i < num_instructions; i++)
+	{
+		const nmd_x86_instruction* const instruction = instructions + i;
+		size_t line_offset = offset, remaining, length;
+
+		if (!instruction->valid)
+			break;
+
+		if (flags & NMD_X86_FORMAT_FLAGS_ADDRESS && runtime_address != NMD_X86_INVALID_RUNTIME_ADDRESS)
+		{
+			int shift = instruction->mode * 8 - 4;
+
+			/* The address column has two hex digits per byte of the mode's address size followed by a space. */
+			if (buffer_size - offset <= (size_t)instruction->mode * 2 + 1)
+				break;
+
+			for (; shift >= 0; shift -= 4)
+				buffer[offset++] = digits[(runtime_address >> shift) & 0xf];
+			buffer[offset++] = ' ';
+		}
+
+		/* Leave room for the new line character. */
+		remaining = buffer_size - offset;
+		if (remaining < 2 || !(length = nmd_x86_format_ex(instruction, buffer + offset, remaining - 1, runtime_address, format_flags)))
+		{
+			offset = line_offset;
+			break;
+		}
+		offset += length;
+
+		if (lines)
+		{
+			lines[i].offset = line_offset;
+			lines[i].length = offset - line_offset;
+		}
+
+		buffer[offset++] = '\n';
+
+		if (runtime_address != NMD_X86_INVALID_RUNTIME_ADDRESS)
+			runtime_address += instruction->length;
+	}
+
+	if (offset < buffer_size)
+		buffer[offset] = '\0';
+
+	if (text_length)
+		*text_length = offset;
+
+	return i;
+}
@@ -7,45 +7,30 @@ NMD_ASSEMBLY_API bool _nmd_ldisasm_decode_modrm(const uint8_t** p_buffer, size_t
 	bool has_sib = false;
 	size_t disp_size = 0;
 
-	if (mode == NMD_X86_MODE_16)
+	/* The address size prefix toggles between 16 and 32-bit addressing outside 64-bit mode */
+	if (mode != NMD_X86_MODE_64 && (mode == NMD_X86_MODE_16) != address_prefix)
 	{
-		if (p_modrm->fields.mod != 0b11)
-		{
-			if (p_modrm->fields.mod == 0b00)
-			{
-				if (p_modrm->fields.rm == 0b110)
-					disp_size = 2;
-			}
-			else
-				disp_size = p_modrm->fields.mod == 0b01 ? 1 : 2;
-		}
+		if ((p_modrm->fields.mod == 0b00 && p_modrm->fields.rm == 0b110) || p_modrm->fields.mod == 0b10)
+			disp_size = 2;
+		else if (p_modrm->fields.mod == 0b01)
+			disp_size = 1;
 	}
 	else
 	{
-		if (address_prefix && mode == NMD_X86_MODE_32)
+		/* Check for SIB byte */
+		uint8_t sib = 0;
+		if (p_modrm->modrm < 0xC0 && p_modrm->fields.rm == 0b100)
 		{
-			if ((p_modrm->fields.mod == 0b00 && p_modrm->fields.rm == 0b110) || p_modrm->fields.mod == 0b10)
-				disp_size = 2;
-			else if (p_modrm->fields.mod == 0b01)
-				disp_size = 1;
+			has_sib = true;
+			_NMD_READ_BYTE(*p_buffer, *p_buffer_size, sib);
 		}
-		else
-		{
-			/* Check for SIB byte */
-			uint8_t sib = 0;
-			if (p_modrm->modrm < 0xC0 && p_modrm->fields.rm == 0b100 && (!address_prefix || (address_prefix && mode == NMD_X86_MODE_64)))
-			{
-				has_sib = true;
-                _NMD_READ_BYTE(*p_buffer, *p_buffer_size, sib);
-			}
 
-			if (p_modrm->fields.mod == 0b01) /* disp8 (ModR/M) */
-				disp_size = 1;
-			else if ((p_modrm->fields.mod == 0b00 && p_modrm->fields.rm == 0b101) || p_modrm->fields.mod == 0b10) /* disp16,32 (ModR/M) */
-				disp_size = (address_prefix && !(mode == NMD_X86_MODE_64 && address_prefix) ? 2 : 4);
-			else if (has_sib && (sib & 0b111) == 0b101) /* disp8,32 (SIB) */
-				disp_size = (p_modrm->fields.mod == 0b01 ? 1 : 4);
-		}
+		if (p_modrm->fields.mod == 0b01) /* disp8 (ModR/M) */
+			disp_size = 1;
+		else if ((p_modrm->fields.mod == 0b00 && p_modrm->fields.rm == 0b101) || p_modrm->fields.mod == 0b10) /* disp32 (ModR/M) */
+			disp_size = 4;
+		else if (has_sib && (sib & 0b111) == 0b101) /* disp8,32 (SIB) */
+			disp_size = (p_modrm->fields.mod == 0b01 ? 1 : 4);
 	}
     
     /* Make sure we can read 'instruction->disp_mask' bytes from the buffer */
@@ -60,18 +45,18 @@ NMD_ASSEMBLY_API bool _nmd_ldisasm_decode_modrm(const uint8_t** p_buffer, size_t
 }
 
 /*
+The branch-based length disassembler. nmd_x86_ldisasm() calls this function for the opcodes the tables can't describe.
 Returns the length of the instruction if it is valid, zero otherwise.
 Parameters:
  - buffer      [in] A pointer to a buffer containing an encoded instruction.
  - buffer_size [in] The size of the buffer in bytes.
  - mode        [in] The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
 */
-NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_size, const NMD_X86_MODE mode)
+NMD_ASSEMBLY_API size_t _nmd_ldisasm(const void* const buffer, size_t buffer_size, const NMD_X86_MODE mode)
 {
 	bool operand_prefix = false;
 	bool address_prefix = false;
 	bool repeat_prefix = false;
-	bool repeat_not_zero_prefix = false;
 	bool rexW = false;
 	bool lock_prefix = false;
 	uint16_t simd_prefix = NMD_X86_PREFIXES_NONE;
@@ -103,7 +88,7 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
 		switch (*b)
 		{
 		case 0xF0: lock_prefix = true; continue;
-		case 0xF2: repeat_not_zero_prefix = true, simd_prefix = NMD_X86_PREFIXES_REPEAT_NOT_ZERO; continue;
+		case 0xF2: simd_prefix = NMD_X86_PREFIXES_REPEAT_NOT_ZERO; continue;
 		case 0xF3: repeat_prefix = true, simd_prefix = NMD_X86_PREFIXES_REPEAT; continue;
 		case 0x2E: continue;
 		case 0x36: continue;
@@ -116,8 +101,7 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
 		default:
 			if (mode == NMD_X86_MODE_64 && _NMD_R(*b) == 4) /* REX prefixes [0x40,0x4f] */
 			{
-				if(_NMD_C(*b) & 0b1000)
-					rexW = true;
+				rexW = (_NMD_C(*b) & 0b1000) != 0;
 				continue;
 			}
 		}
@@ -127,6 +111,10 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
 
 	/* Calculate the number of prefixes based on how much the iterator moved */
 	const size_t num_prefixes = (uint8_t)((ptrdiff_t)(b)-(ptrdiff_t)(buffer));
+
+	/* A REX prefix is ignored if it's not the last prefix */
+	if (num_prefixes && _NMD_R(b[-1]) != 4)
+		rexW = false;
     
     /* Opcode byte. This variable is used because 'op' is simpler than 'instruction->opcode' */
 	uint8_t op;
@@ -292,12 +280,12 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
 				return 0;
 			else if (_NMD_R(op) == 5)
 			{
-				if ((op == 0x50 && modrm.fields.mod != 0b11) || (simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE && (op == 0x52 || op == 0x53)) || (simd_prefix == NMD_X86_PREFIXES_REPEAT && (op == 0x50 || (op >= 0x54 && op <= 0x57))) || (repeat_not_zero_prefix && (op == 0x50 || (op >= 0x52 && op <= 0x57) || op == 0x5b)))
+				if ((op == 0x50 && modrm.fields.mod != 0b11) || (simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE && (op == 0x52 || op == 0x53)) || (simd_prefix == NMD_X86_PREFIXES_REPEAT && (op == 0x50 || (op >= 0x54 && op <= 0x57))) || (simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO && (op == 0x50 || (op >= 0x52 && op <= 0x57) || op == 0x5b)))
 					return 0;
 			}
 			else if (_NMD_R(op) == 6)
 			{
-				if ((!(simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE || simd_prefix == NMD_X86_PREFIXES_REPEAT || simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO) && (op == 0x6c || op == 0x6d)) || (simd_prefix == NMD_X86_PREFIXES_REPEAT && op != 0x6f) || repeat_not_zero_prefix)
+				if ((!(simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE || simd_prefix == NMD_X86_PREFIXES_REPEAT || simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO) && (op == 0x6c || op == 0x6d)) || (simd_prefix == NMD_X86_PREFIXES_REPEAT && op != 0x6f) || simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO)
 					return 0;
 			}
 			else if (op == 0x78 || op == 0x79)
@@ -312,7 +300,7 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
 			}
 			else if (op == 0x7e || op == 0x7f)
 			{
-				if (repeat_not_zero_prefix)
+				if (simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO)
 					return 0;
 			}
 			else if (op >= 0x71 && op <= 0x73)
@@ -394,7 +382,7 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
 				imm_mask = _NMD_GET_BY_MODE_OPSZPRFX_F64(mode, operand_prefix, 2, 4, 4);
 			else if ((_NMD_R(op) == 7 && _NMD_C(op) < 4) || op == 0xA4 || op == 0xC2 || (op > 0xC3 && op <= 0xC6) || op == 0xBA || op == 0xAC) /* imm8 */
 				imm_mask = 1;
-			else if (op == 0x78 && (repeat_not_zero_prefix || operand_prefix)) /* imm8 + imm8 = "imm16" */
+			else if (op == 0x78 && (simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO || simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)) /* imm8 + imm8 = "imm16" */
 				imm_mask = 2;
             
             /* Make sure we can "read" 'imm_mask' bytes from the buffer */
@@ -410,8 +398,8 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
 	{
 		opcode_size = 1;
 
-		/* Check for ModR/M, SIB and displacement */
-		if (_NMD_R(op) == 8 || _nmd_find_byte(_nmd_op1_modrm, sizeof(_nmd_op1_modrm), op) || (_NMD_R(op) < 4 && (_NMD_C(op) < 4 || (_NMD_C(op) >= 8 && _NMD_C(op) < 0xC))) || (_NMD_R(op) == 0xD && _NMD_C(op) >= 8)/* || ((op == 0xc4 || op == 0xc5) && remaining_size > 1 && ((nmd_x86_modrm*)(b + 1))->fields.mod != 0b11)*/)
+		/* Check for ModR/M, SIB and displacement. Outside 64-bit mode 0x62 is BOUND unless ModR/M.mod is 0b11(EVEX) */
+		if (_NMD_R(op) == 8 || _nmd_find_byte(_nmd_op1_modrm, sizeof(_nmd_op1_modrm), op) || (_NMD_R(op) < 4 && (_NMD_C(op) < 4 || (_NMD_C(op) >= 8 && _NMD_C(op) < 0xC))) || (_NMD_R(op) == 0xD && _NMD_C(op) >= 8) || (op == 0x62 && mode != NMD_X86_MODE_64 && buffer_size && (*b >> 6) != 0b11)/* || ((op == 0xc4 || op == 0xc5) && remaining_size > 1 && ((nmd_x86_modrm*)(b + 1))->fields.mod != 0b11)*/)
 		{
 			if (!_nmd_ldisasm_decode_modrm(&b, &buffer_size, address_prefix, mode, &modrm))
 				return 0;
@@ -451,7 +439,8 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
 		}
 		else if (op == 0x62)
 		{
-			if (mode == NMD_X86_MODE_64)
+			/* EVEX is not supported */
+			if (!has_modrm)
 				return 0;
 		}
 		else if (op == 0x8d)
@@ -522,6 +511,12 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
                     uint8_t imm;
                     _NMD_READ_BYTE(b, buffer_size, imm);
                 }
+
+#ifndef NMD_ASSEMBLY_DISABLE_LENGTH_DISASSEMBLER_VALIDITY_CHECK
+				/* Same check as the decoder's */
+				if (op == 0x0c && (byte1 & 0b00011111) != 3)
+					return 0;
+#endif /* NMD_ASSEMBLY_DISABLE_LENGTH_DISASSEMBLER_VALIDITY_CHECK */
 			}
 			else /* 0xc5 */
 			{
@@ -584,4 +579,179 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
 	}
 
 	return (size_t)((ptrdiff_t)(b) - (ptrdiff_t)(buffer));
-}
\ No newline at end of file
+}
+
+/* Scans the prefixes of an instruction one byte at a time. Returns the number of prefixes and stores the union of their classes('_NMD_X86_PREFIX_CLASS') in 'classes'. */
+NMD_ASSEMBLY_API size_t _nmd_ldisasm_scan_prefixes(const uint8_t* buffer, size_t buffer_size, NMD_X86_MODE mode, uint8_t* classes)
+{
+	const uint8_t prefix_mask = (uint8_t)(_NMD_X86_PREFIX_CLASS_LEGACY | (mode == NMD_X86_MODE_64 ? _NMD_X86_PREFIX_CLASS_REX : 0));
+	size_t i;
+
+	*classes = 0;
+	for (i = 0; i < buffer_size && (_nmd_x86_prefix_classes[buffer[i]] & prefix_mask); i++)
+		*classes |= _nmd_x86_prefix_classes[buffer[i]];
+
+	/* A REX prefix is ignored if it's not the last prefix */
+	if (i && !(_nmd_x86_prefix_classes[buffer[i - 1]] & _NMD_X86_PREFIX_CLASS_REX_W))
+		*classes &= ~_NMD_X86_PREFIX_CLASS_REX_W;
+
+	return i;
+}
+
+#ifdef NMD_ASSEMBLY_ENABLE_LENGTH_DISASSEMBLER_SSE2
+/* Same as _nmd_ldisasm_scan_prefixes(), but classifies 16 bytes at once using SSE2. 'buffer' must have at least 16 readable bytes. */
+NMD_ASSEMBLY_API size_t _nmd_ldisasm_scan_prefixes_sse2(const uint8_t* buffer, NMD_X86_MODE mode, uint8_t* classes)
+{
+	const __m128i bytes = _mm_loadu_si128((const __m128i*)buffer);
+	const __m128i operand_size = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(0x66));
+	const __m128i address_size = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(0x67));
+	const __m128i lock = _mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)0xf0));
+	const __m128i segment = _mm_or_si128(_mm_cmpeq_epi8(_mm_and_si128(bytes, _mm_set1_epi8((char)0xe7)), _mm_set1_epi8(0x26)), _mm_cmpeq_epi8(_mm_and_si128(bytes, _mm_set1_epi8((char)0xfe)), _mm_set1_epi8(0x64))); /* 26,2E,36,3E,64,65 */
+	const __m128i repeat = _mm_cmpeq_epi8(_mm_and_si128(bytes, _mm_set1_epi8((char)0xfe)), _mm_set1_epi8((char)0xf2)); /* F2,F3 */
+	const __m128i legacy = _mm_or_si128(_mm_or_si128(_mm_or_si128(operand_size, address_size), _mm_or_si128(lock, segment)), repeat);
+	__m128i rex = _mm_setzero_si128();
+	__m128i rex_w = _mm_setzero_si128();
+	uint32_t run;
+	size_t num_prefixes;
+
+	if (mode == NMD_X86_MODE_64)
+	{
+		rex = _mm_cmpeq_epi8(_mm_and_si128(bytes, _mm_set1_epi8((char)0xf0)), _mm_set1_epi8(0x40));
+		rex_w = _mm_cmpeq_epi8(_mm_and_si128(bytes, _mm_set1_epi8((char)0xf8)), _mm_set1_epi8(0x48));
+	}
+
+	/* The prefixes are the bytes before the first zero bit of the mask */
+	num_prefixes = _nmd_get_bit_index(~(uint32_t)_mm_movemask_epi8(_mm_or_si128(legacy, rex)));
+	run = ((uint32_t)1 << num_prefixes) - 1;
+
+	*classes = (uint8_t)(((uint32_t)_mm_movemask_epi8(legacy) & run ? _NMD_X86_PREFIX_CLASS_LEGACY : 0) |
+		((uint32_t)_mm_movemask_epi8(rex) & run ? _NMD_X86_PREFIX_CLASS_REX : 0) |
+		((uint32_t)_mm_movemask_epi8(operand_size) & run ? _NMD_X86_PREFIX_CLASS_OPERAND_SIZE : 0) |
+		((uint32_t)_mm_movemask_epi8(address_size) & run ? _NMD_X86_PREFIX_CLASS_ADDRESS_SIZE : 0) |
+		((uint32_t)_mm_movemask_epi8(lock) & run ? _NMD_X86_PREFIX_CLASS_LOCK : 0) |
+		(num_prefixes && ((uint32_t)_mm_movemask_epi8(rex_w) >> (num_prefixes - 1)) & 1 ? _NMD_X86_PREFIX_CLASS_REX_W : 0)); /* A REX prefix is ignored if it's not the last prefix */
+
+	return num_prefixes;
+}
+#endif /* NMD_ASSEMBLY_ENABLE_LENGTH_DISASSEMBLER_SSE2 */
+
+/*
+Returns the length of the instruction if it is valid, zero otherwise.
+The length is computed using the opcode tables in 'nmd_x86_opcode_tables.c'. Opcodes the tables can't describe(and instructions with a lock prefix) are handled by _nmd_ldisasm().
+Parameters:
+ - buffer      [in] A pointer to a buffer containing an encoded instruction.
+ - buffer_size [in] The size of the buffer in bytes.
+ - mode        [in] The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_size, const NMD_X86_MODE mode)
+{
+	const uint8_t* b = (const uint8_t*)buffer;
+	const size_t original_buffer_size = buffer_size;
+	uint8_t classes, flags, op;
+	size_t num_prefixes, imm_size;
+	nmd_x86_modrm modrm;
+
+	/*  Clamp 'buffer_size' to 15. We will only read up to 15 bytes(NMD_X86_MAXIMUM_INSTRUCTION_LENGTH) */
+	if (buffer_size > 15)
+		buffer_size = 15;
+
+	/* Classify legacy and REX prefixes */
+#ifdef NMD_ASSEMBLY_ENABLE_LENGTH_DISASSEMBLER_SSE2
+	if (original_buffer_size >= 16)
+		num_prefixes = _nmd_ldisasm_scan_prefixes_sse2(b, mode, &classes);
+	else
+#endif /* NMD_ASSEMBLY_ENABLE_LENGTH_DISASSEMBLER_SSE2 */
+		num_prefixes = _nmd_ldisasm_scan_prefixes(b, buffer_size, mode, &classes);
+
+	/* There must be at least one byte after the prefixes */
+	if (num_prefixes >= buffer_size)
+		return 0;
+
+	/* The lock prefix's validity depends on the opcode and the ModR/M byte */
+	if (classes & _NMD_X86_PREFIX_CLASS_LOCK)
+		return _nmd_ldisasm(buffer, original_buffer_size, mode);
+
+	b += num_prefixes;
+	buffer_size -= num_prefixes;
+
+	/* Look up the opcode's flags */
+	_NMD_READ_BYTE(b, buffer_size, op);
+	if (op == 0x0F)
+	{
+		_NMD_READ_BYTE(b, buffer_size, op);
+		flags = _nmd_x86_ldisasm_op2_flags[mode >> 2][op];
+	}
+	else
+		flags = _nmd_x86_ldisasm_op1_flags[mode >> 2][op];
+
+	if ((flags & _NMD_X86_OPCODE_FALLBACK) == _NMD_X86_OPCODE_FALLBACK)
+		return _nmd_ldisasm(buffer, original_buffer_size, mode);
+
+	/* Check for ModR/M, SIB and displacement */
+	if (flags & _NMD_X86_OPCODE_MODRM)
+	{
+		if (!_nmd_ldisasm_decode_modrm(&b, &buffer_size, (classes & _NMD_X86_PREFIX_CLASS_ADDRESS_SIZE) != 0, mode, &modrm))
+			return 0;
+
+		if (flags & (modrm.fields.mod == 0b11 ? _NMD_X86_OPCODE_INVALID_REG : _NMD_X86_OPCODE_INVALID_MEM))
+		{
+#ifndef NMD_ASSEMBLY_DISABLE_LENGTH_DISASSEMBLER_VALIDITY_CHECK
+			return 0;
+#else
+			return _nmd_ldisasm(buffer, original_buffer_size, mode);
+#endif /* NMD_ASSEMBLY_DISABLE_LENGTH_DISASSEMBLER_VALIDITY_CHECK */
+		}
+	}
+
+	/* Make sure we can "read" 'imm_size' bytes from the buffer */
+	imm_size = _nmd_x86_get_imm_size((uint8_t)(flags & _NMD_X86_OPCODE_IMM_MASK), mode, (classes & _NMD_X86_PREFIX_CLASS_OPERAND_SIZE) != 0, (classes & _NMD_X86_PREFIX_CLASS_ADDRESS_SIZE) != 0, (classes & _NMD_X86_PREFIX_CLASS_REX_W) != 0);
+	if (buffer_size < imm_size)
+		return 0;
+
+	return (size_t)((ptrdiff_t)(b + imm_size) - (ptrdiff_t)(buffer));
+}
+
+/*
+Computes the length of consecutive instructions until the end of the buffer, an invalid instruction or the end of the output array is reached. Returns the number of lengths written to 'lengths'.
+Parameters:
+ - buffer      [in]      A pointer to a buffer containing encoded instructions.
+ - buffer_size [in]      The buffer's size in bytes.
+ - mode        [in]      The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - lengths     [out]     A pointer to an array that receives the length of each instruction.
+ - num_lengths [in]      The number of elements in 'lengths'.
+ - info        [out/opt] A pointer to a variable of type 'nmd_x86_buffer_info' that receives where and why the function stopped. 'runtime_address' is set to 'NMD_X86_INVALID_RUNTIME_ADDRESS'. This parameter may be null.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_ldisasm_buffer(const void* buffer, size_t buffer_size, NMD_X86_MODE mode, uint8_t* lengths, size_t num_lengths, nmd_x86_buffer_info* info)
+{
+	const uint8_t* b = (const uint8_t*)buffer;
+	const uint8_t* const end = b + buffer_size;
+	uint8_t status = NMD_X86_BUFFER_STATUS_END;
+	size_t count = 0, length;
+
+	while (b < end)
+	{
+		if (count == num_lengths)
+		{
+			status = NMD_X86_BUFFER_STATUS_OUTPUT_FULL;
+			break;
+		}
+
+		if (!(length = nmd_x86_ldisasm(b, (size_t)(end - b), mode)))
+		{
+			status = NMD_X86_BUFFER_STATUS_INVALID;
+			break;
+		}
+
+		lengths[count++] = (uint8_t)length;
+		b += length;
+	}
+
+	if (info)
+	{
+		info->offset = (size_t)(b - (const uint8_t*)buffer);
+		info->runtime_address = NMD_X86_INVALID_RUNTIME_ADDRESS;
+		info->status = status;
+	}
+
+	return count;
+}
@@ -0,0 +1,596 @@
+/* This file is generated by 'generate_opcode_tables.c' from the decoder's logic. Do not edit it manually. */
+
+#include "nmd_common.h"
+
+/* Properties of the opcodes of the one byte opcode map. Indexed by [mode >> 2][opcode]. See '_nmd_x86_opcode_info'. */
+NMD_ASSEMBLY_API const _nmd_x86_opcode_info _nmd_x86_op1_info[3][256] = {
+	{ /* NMD_X86_MODE_16 */
+		/* 00 */ {   1,0x00,0x10}, {   1,0x00,0x10}, {   1,0x00,0x10}, {   1,0x00,0x10}, {   1,0x00,0x01}, {   1,0x00,0x05}, {  31,0x00,0x00}, { 697,0x00,0x00},
+		/* 08 */ {   2,0x00,0x10}, {   2,0x00,0x10}, {   2,0x00,0x10}, {   2,0x00,0x10}, {   2,0x00,0x01}, {   2,0x00,0x05}, {  31,0x00,0x00}, {   0,0x00,0x60},
+		/* 10 */ {   3,0x00,0x10}, {   3,0x00,0x10}, {   3,0x00,0x10}, {   3,0x00,0x10}, {   3,0x00,0x01}, {   3,0x00,0x05}, {  31,0x00,0x00}, { 697,0x00,0x00},
+		/* 18 */ {   4,0x00,0x10}, {   4,0x00,0x10}, {   4,0x00,0x10}, {   4,0x00,0x10}, {   4,0x00,0x01}, {   4,0x00,0x05}, {  31,0x00,0x00}, { 697,0x00,0x00},
+		/* 20 */ {   5,0x00,0x10}, {   5,0x00,0x10}, {   5,0x00,0x10}, {   5,0x00,0x10}, {   5,0x00,0x01}, {   5,0x00,0x05}, {   0,0x00,0x60}, { 432,0x00,0x00},
+		/* 28 */ {   6,0x00,0x10}, {   6,0x00,0x10}, {   6,0x00,0x10}, {   6,0x00,0x10}, {   6,0x00,0x01}, {   6,0x00,0x05}, {   0,0x00,0x60}, { 448,0x00,0x00},
+		/* 30 */ {   7,0x00,0x10}, {   7,0x00,0x10}, {   7,0x00,0x10}, {   7,0x00,0x10}, {   7,0x00,0x01}, {   7,0x00,0x05}, {   0,0x00,0x60}, {  15,0x00,0x00},
+		/* 38 */ {   8,0x00,0x10}, {   8,0x00,0x10}, {   8,0x00,0x10}, {   8,0x00,0x10}, {   8,0x00,0x01}, {   8,0x00,0x05}, {   0,0x00,0x60}, {  66,0x00,0x00},
+		/* 40 */ {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00},
+		/* 48 */ {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00},
+		/* 50 */ {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00},
+		/* 58 */ { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00},
+		/* 60 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 180,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 68 */ {  31,0x00,0x05}, {  22,0x00,0x15}, {  31,0x00,0x01}, {  22,0x00,0x11}, { 529,0x00,0x00}, {   0,0x00,0x60}, { 657,0x00,0x00}, {   0,0x00,0x60},
+		/* 70 */ {  32,0xa1,0x01}, {  33,0xa1,0x01}, {  34,0xa1,0x01}, {  35,0xa1,0x01}, {  36,0xa1,0x01}, {  37,0xa1,0x01}, {  38,0xa1,0x01}, {  39,0xa1,0x01},
+		/* 78 */ {  40,0xa1,0x01}, {  41,0xa1,0x01}, {  42,0xa1,0x01}, {  43,0xa1,0x01}, {  44,0xa1,0x01}, {  45,0xa1,0x01}, {  46,0xa1,0x01}, {  47,0xa1,0x01},
+		/* 80 */ {   0,0x00,0x90}, {   1,0x00,0x90}, {   0,0x00,0x90}, {   0,0x00,0x90}, {  17,0x00,0x10}, {  17,0x00,0x10}, {1316,0x00,0x10}, {1316,0x00,0x10},
+		/* 88 */ { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, {   2,0x00,0x90}, { 599,0x00,0x30}, {   3,0x00,0x90}, {   4,0x00,0x90},
+		/* 90 */ {   0,0x00,0x60}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00},
+		/* 98 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {  27,0x42,0x08}, {1312,0x00,0x00}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 727,0x00,0x00}, { 597,0x00,0x00},
+		/* A0 */ { 625,0x00,0x07}, { 625,0x00,0x07}, { 625,0x00,0x07}, { 625,0x00,0x07}, { 642,0x00,0x00}, {   0,0x00,0x60}, { 175,0x00,0x00}, {   0,0x00,0x60},
+		/* A8 */ {  17,0x00,0x01}, {  17,0x00,0x05}, { 741,0x00,0x00}, {   0,0x00,0x60}, { 602,0x00,0x00}, {   0,0x00,0x60}, { 730,0x00,0x00}, {   0,0x00,0x60},
+		/* B0 */ { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01},
+		/* B8 */ { 625,0x00,0x02}, { 625,0x00,0x02}, { 625,0x00,0x02}, { 625,0x00,0x02}, { 625,0x00,0x02}, { 625,0x00,0x02}, { 625,0x00,0x02}, { 625,0x00,0x02},
+		/* C0 */ {   5,0x00,0x90}, {   5,0x00,0x90}, {  70,0x04,0x02}, {  70,0x04,0x00}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   6,0x00,0x90}, {   7,0x00,0x90},
+		/* C8 */ {  71,0x00,0x03}, { 600,0x00,0x00}, { 606,0x04,0x02}, { 606,0x04,0x00}, { 533,0x08,0x00}, { 532,0x08,0x01}, { 534,0x08,0x00}, {   0,0x00,0x60},
+		/* D0 */ {   8,0x00,0x90}, {   8,0x00,0x90}, {   8,0x00,0x90}, {   8,0x00,0x90}, { 144,0x00,0x01}, { 145,0x00,0x01}, { 146,0x00,0x00}, { 147,0x00,0x00},
+		/* D8 */ {   9,0x00,0x90}, {  10,0x00,0x90}, {  11,0x00,0x90}, {  12,0x00,0x90}, {  13,0x00,0x90}, {  14,0x00,0x90}, {   0,0x00,0x60}, {  15,0x00,0x90},
+		/* E0 */ { 148,0xa0,0x01}, { 149,0xa0,0x01}, { 150,0xa0,0x01}, { 151,0xa1,0x01}, { 528,0x00,0x01}, { 528,0x00,0x01}, { 656,0x00,0x01}, { 656,0x00,0x01},
+		/* E8 */ {  27,0xc2,0x05}, {  29,0xc1,0x05}, {  30,0x41,0x08}, {  29,0xc1,0x01}, { 528,0x00,0x00}, { 528,0x00,0x00}, { 656,0x00,0x00}, { 656,0x00,0x00},
+		/* F0 */ {   0,0x00,0x60}, { 131,0x08,0x00}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 134,0x10,0x00}, { 135,0x00,0x00}, {  16,0x00,0x90}, {  17,0x00,0x90},
+		/* F8 */ { 138,0x00,0x00}, { 139,0x00,0x00}, { 140,0x00,0x00}, { 141,0x00,0x00}, { 142,0x00,0x00}, { 143,0x00,0x00}, {  18,0x00,0x90}, {  19,0x00,0x90}
+	},
+	{ /* NMD_X86_MODE_32 */
+		/* 00 */ {   1,0x00,0x10}, {   1,0x00,0x10}, {   1,0x00,0x10}, {   1,0x00,0x10}, {   1,0x00,0x01}, {   1,0x00,0x05}, {  31,0x00,0x00}, { 697,0x00,0x00},
+		/* 08 */ {   2,0x00,0x10}, {   2,0x00,0x10}, {   2,0x00,0x10}, {   2,0x00,0x10}, {   2,0x00,0x01}, {   2,0x00,0x05}, {  31,0x00,0x00}, {   0,0x00,0x60},
+		/* 10 */ {   3,0x00,0x10}, {   3,0x00,0x10}, {   3,0x00,0x10}, {   3,0x00,0x10}, {   3,0x00,0x01}, {   3,0x00,0x05}, {  31,0x00,0x00}, { 697,0x00,0x00},
+		/* 18 */ {   4,0x00,0x10}, {   4,0x00,0x10}, {   4,0x00,0x10}, {   4,0x00,0x10}, {   4,0x00,0x01}, {   4,0x00,0x05}, {  31,0x00,0x00}, { 697,0x00,0x00},
+		/* 20 */ {   5,0x00,0x10}, {   5,0x00,0x10}, {   5,0x00,0x10}, {   5,0x00,0x10}, {   5,0x00,0x01}, {   5,0x00,0x05}, {   0,0x00,0x60}, { 432,0x00,0x00},
+		/* 28 */ {   6,0x00,0x10}, {   6,0x00,0x10}, {   6,0x00,0x10}, {   6,0x00,0x10}, {   6,0x00,0x01}, {   6,0x00,0x05}, {   0,0x00,0x60}, { 448,0x00,0x00},
+		/* 30 */ {   7,0x00,0x10}, {   7,0x00,0x10}, {   7,0x00,0x10}, {   7,0x00,0x10}, {   7,0x00,0x01}, {   7,0x00,0x05}, {   0,0x00,0x60}, {  15,0x00,0x00},
+		/* 38 */ {   8,0x00,0x10}, {   8,0x00,0x10}, {   8,0x00,0x10}, {   8,0x00,0x10}, {   8,0x00,0x01}, {   8,0x00,0x05}, {   0,0x00,0x60}, {  66,0x00,0x00},
+		/* 40 */ {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00},
+		/* 48 */ {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00},
+		/* 50 */ {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00},
+		/* 58 */ { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00},
+		/* 60 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 180,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 68 */ {  31,0x00,0x05}, {  22,0x00,0x15}, {  31,0x00,0x01}, {  22,0x00,0x11}, { 529,0x00,0x00}, {   0,0x00,0x60}, { 657,0x00,0x00}, {   0,0x00,0x60},
+		/* 70 */ {  32,0xa1,0x01}, {  33,0xa1,0x01}, {  34,0xa1,0x01}, {  35,0xa1,0x01}, {  36,0xa1,0x01}, {  37,0xa1,0x01}, {  38,0xa1,0x01}, {  39,0xa1,0x01},
+		/* 78 */ {  40,0xa1,0x01}, {  41,0xa1,0x01}, {  42,0xa1,0x01}, {  43,0xa1,0x01}, {  44,0xa1,0x01}, {  45,0xa1,0x01}, {  46,0xa1,0x01}, {  47,0xa1,0x01},
+		/* 80 */ {   0,0x00,0x90}, {   1,0x00,0x90}, {   0,0x00,0x90}, {   0,0x00,0x90}, {  17,0x00,0x10}, {  17,0x00,0x10}, {1316,0x00,0x10}, {1316,0x00,0x10},
+		/* 88 */ { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, {   2,0x00,0x90}, { 599,0x00,0x30}, {   3,0x00,0x90}, {   4,0x00,0x90},
+		/* 90 */ {   0,0x00,0x60}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00},
+		/* 98 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {  27,0x42,0x08}, {1312,0x00,0x00}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 727,0x00,0x00}, { 597,0x00,0x00},
+		/* A0 */ { 625,0x00,0x07}, { 625,0x00,0x07}, { 625,0x00,0x07}, { 625,0x00,0x07}, { 642,0x00,0x00}, {   0,0x00,0x60}, { 175,0x00,0x00}, {   0,0x00,0x60},
+		/* A8 */ {  17,0x00,0x01}, {  17,0x00,0x05}, { 741,0x00,0x00}, {   0,0x00,0x60}, { 602,0x00,0x00}, {   0,0x00,0x60}, { 730,0x00,0x00}, {   0,0x00,0x60},
+		/* B0 */ { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01},
+		/* B8 */ { 625,0x00,0x05}, { 625,0x00,0x05}, { 625,0x00,0x05}, { 625,0x00,0x05}, { 625,0x00,0x05}, { 625,0x00,0x05}, { 625,0x00,0x05}, { 625,0x00,0x05},
+		/* C0 */ {   5,0x00,0x90}, {   5,0x00,0x90}, {  70,0x04,0x02}, {  70,0x04,0x00}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   6,0x00,0x90}, {   7,0x00,0x90},
+		/* C8 */ {  71,0x00,0x03}, { 600,0x00,0x00}, { 606,0x04,0x02}, { 606,0x04,0x00}, { 533,0x08,0x00}, { 532,0x08,0x01}, { 534,0x08,0x00}, {   0,0x00,0x60},
+		/* D0 */ {   8,0x00,0x90}, {   8,0x00,0x90}, {   8,0x00,0x90}, {   8,0x00,0x90}, { 144,0x00,0x01}, { 145,0x00,0x01}, { 146,0x00,0x00}, { 147,0x00,0x00},
+		/* D8 */ {   9,0x00,0x90}, {  10,0x00,0x90}, {  11,0x00,0x90}, {  12,0x00,0x90}, {  13,0x00,0x90}, {  14,0x00,0x90}, {   0,0x00,0x60}, {  15,0x00,0x90},
+		/* E0 */ { 148,0xa0,0x01}, { 149,0xa0,0x01}, { 150,0xa0,0x01}, { 151,0xa1,0x01}, { 528,0x00,0x01}, { 528,0x00,0x01}, { 656,0x00,0x01}, { 656,0x00,0x01},
+		/* E8 */ {  27,0xc2,0x05}, {  29,0xc1,0x05}, {  30,0x41,0x08}, {  29,0xc1,0x01}, { 528,0x00,0x00}, { 528,0x00,0x00}, { 656,0x00,0x00}, { 656,0x00,0x00},
+		/* F0 */ {   0,0x00,0x60}, { 131,0x08,0x00}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 134,0x10,0x00}, { 135,0x00,0x00}, {  16,0x00,0x90}, {  17,0x00,0x90},
+		/* F8 */ { 138,0x00,0x00}, { 139,0x00,0x00}, { 140,0x00,0x00}, { 141,0x00,0x00}, { 142,0x00,0x00}, { 143,0x00,0x00}, {  18,0x00,0x90}, {  19,0x00,0x90}
+	},
+	{ /* NMD_X86_MODE_64 */
+		/* 00 */ {   1,0x00,0x10}, {   1,0x00,0x10}, {   1,0x00,0x10}, {   1,0x00,0x10}, {   1,0x00,0x01}, {   1,0x00,0x05}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 08 */ {   2,0x00,0x10}, {   2,0x00,0x10}, {   2,0x00,0x10}, {   2,0x00,0x10}, {   2,0x00,0x01}, {   2,0x00,0x05}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 10 */ {   3,0x00,0x10}, {   3,0x00,0x10}, {   3,0x00,0x10}, {   3,0x00,0x10}, {   3,0x00,0x01}, {   3,0x00,0x05}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 18 */ {   4,0x00,0x10}, {   4,0x00,0x10}, {   4,0x00,0x10}, {   4,0x00,0x10}, {   4,0x00,0x01}, {   4,0x00,0x05}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 20 */ {   5,0x00,0x10}, {   5,0x00,0x10}, {   5,0x00,0x10}, {   5,0x00,0x10}, {   5,0x00,0x01}, {   5,0x00,0x05}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 28 */ {   6,0x00,0x10}, {   6,0x00,0x10}, {   6,0x00,0x10}, {   6,0x00,0x10}, {   6,0x00,0x01}, {   6,0x00,0x05}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 30 */ {   7,0x00,0x10}, {   7,0x00,0x10}, {   7,0x00,0x10}, {   7,0x00,0x10}, {   7,0x00,0x01}, {   7,0x00,0x05}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 38 */ {   8,0x00,0x10}, {   8,0x00,0x10}, {   8,0x00,0x10}, {   8,0x00,0x10}, {   8,0x00,0x01}, {   8,0x00,0x05}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 40 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 48 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 50 */ {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00},
+		/* 58 */ { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00},
+		/* 60 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 650,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 68 */ {  31,0x00,0x05}, {  22,0x00,0x15}, {  31,0x00,0x01}, {  22,0x00,0x11}, { 529,0x00,0x00}, {   0,0x00,0x60}, { 657,0x00,0x00}, {   0,0x00,0x60},
+		/* 70 */ {  32,0xa1,0x01}, {  33,0xa1,0x01}, {  34,0xa1,0x01}, {  35,0xa1,0x01}, {  36,0xa1,0x01}, {  37,0xa1,0x01}, {  38,0xa1,0x01}, {  39,0xa1,0x01},
+		/* 78 */ {  40,0xa1,0x01}, {  41,0xa1,0x01}, {  42,0xa1,0x01}, {  43,0xa1,0x01}, {  44,0xa1,0x01}, {  45,0xa1,0x01}, {  46,0xa1,0x01}, {  47,0xa1,0x01},
+		/* 80 */ {   0,0x00,0x90}, {   1,0x00,0x90}, {   0,0x00,0x60}, {   0,0x00,0x90}, {  17,0x00,0x10}, {  17,0x00,0x10}, {1316,0x00,0x10}, {1316,0x00,0x10},
+		/* 88 */ { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, {   2,0x00,0x90}, { 599,0x80,0x30}, {   3,0x00,0x90}, {   4,0x00,0x90},
+		/* 90 */ {   0,0x00,0x60}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00},
+		/* 98 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {1312,0x00,0x00}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 727,0x00,0x00}, { 597,0x00,0x00},
+		/* A0 */ { 625,0x00,0x07}, { 625,0x00,0x07}, { 625,0x00,0x07}, { 625,0x00,0x07}, { 642,0x00,0x00}, {   0,0x00,0x60}, { 175,0x00,0x00}, {   0,0x00,0x60},
+		/* A8 */ {  17,0x00,0x01}, {  17,0x00,0x05}, { 741,0x00,0x00}, {   0,0x00,0x60}, { 602,0x00,0x00}, {   0,0x00,0x60}, { 730,0x00,0x00}, {   0,0x00,0x60},
+		/* B0 */ { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01},
+		/* B8 */ { 625,0x00,0x06}, { 625,0x00,0x06}, { 625,0x00,0x06}, { 625,0x00,0x06}, { 625,0x00,0x06}, { 625,0x00,0x06}, { 625,0x00,0x06}, { 625,0x00,0x06},
+		/* C0 */ {   5,0x00,0x90}, {   5,0x00,0x90}, {  70,0x04,0x02}, {  70,0x04,0x00}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   6,0x00,0x90}, {   7,0x00,0x90},
+		/* C8 */ {  71,0x00,0x03}, { 600,0x00,0x00}, { 606,0x04,0x02}, { 606,0x04,0x00}, { 533,0x08,0x00}, { 532,0x08,0x01}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* D0 */ {   8,0x00,0x90}, {   8,0x00,0x90}, {   8,0x00,0x90}, {   8,0x00,0x90}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 147,0x00,0x00},
+		/* D8 */ {   9,0x00,0x90}, {  10,0x00,0x90}, {  11,0x00,0x90}, {  12,0x00,0x90}, {  13,0x00,0x90}, {  14,0x00,0x90}, {   0,0x00,0x60}, {  15,0x00,0x90},
+		/* E0 */ { 148,0xa0,0x01}, { 149,0xa0,0x01}, { 150,0xa0,0x01}, { 151,0xa1,0x01}, { 528,0x00,0x01}, { 528,0x00,0x01}, { 656,0x00,0x01}, { 656,0x00,0x01},
+		/* E8 */ {  27,0xc2,0x05}, {  29,0xc1,0x05}, {   0,0x00,0x60}, {  29,0xc1,0x01}, { 528,0x00,0x00}, { 528,0x00,0x00}, { 656,0x00,0x00}, { 656,0x00,0x00},
+		/* F0 */ {   0,0x00,0x60}, { 131,0x08,0x00}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 134,0x10,0x00}, { 135,0x00,0x00}, {  16,0x00,0x90}, {  17,0x00,0x90},
+		/* F8 */ { 138,0x00,0x00}, { 139,0x00,0x00}, { 140,0x00,0x00}, { 141,0x00,0x00}, { 142,0x00,0x00}, { 143,0x00,0x00}, {  18,0x00,0x90}, {  19,0x00,0x90}
+	}
+};
+
+/* Properties of the opcodes of the two byte(0F) opcode map. Indexed by [mode >> 2][opcode]. See '_nmd_x86_opcode_info'. */
+NMD_ASSEMBLY_API const _nmd_x86_opcode_info _nmd_x86_op2_info[3][256] = {
+	{ /* NMD_X86_MODE_16 */
+		/* 00 */ {  20,0x00,0x90}, {   0,0x00,0x60}, { 194,0x00,0x10}, { 195,0x00,0x10}, {   0,0x00,0x60}, { 197,0x00,0x00}, { 198,0x10,0x00}, { 199,0x00,0x00},
+		/* 08 */ { 200,0x10,0x00}, { 201,0x10,0x00}, {   0,0x00,0x60}, { 203,0x00,0x00}, {   0,0x00,0x60}, {   0,0x00,0x10}, { 205,0x00,0x00}, {   0,0x00,0x60},
+		/* 10 */ { 988,0x00,0x10}, { 989,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 18 */ {  21,0x00,0x90}, { 655,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 655,0x00,0x10}, { 655,0x00,0x10}, {  22,0x00,0x90}, { 655,0x00,0x10},
+		/* 20 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 28 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 30 */ { 206,0x10,0x00}, { 207,0x00,0x00}, { 208,0x10,0x00}, { 209,0x10,0x00}, { 210,0x00,0x00}, { 211,0x10,0x00}, {   0,0x00,0x60}, { 213,0x10,0x00},
+		/* 38 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 40 */ { 214,0x00,0x10}, { 215,0x00,0x10}, { 216,0x00,0x10}, { 217,0x00,0x10}, { 218,0x00,0x10}, { 219,0x00,0x10}, { 220,0x00,0x10}, { 221,0x00,0x10},
+		/* 48 */ { 222,0x00,0x10}, { 223,0x00,0x10}, { 224,0x00,0x10}, { 225,0x00,0x10}, { 226,0x00,0x10}, { 227,0x00,0x10}, { 228,0x00,0x10}, { 229,0x00,0x10},
+		/* 50 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 58 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 60 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 68 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 70 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 616,0x00,0x00},
+		/* 78 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 80 */ {  32,0xa1,0x05}, {  33,0xa1,0x05}, {  34,0xa1,0x05}, {  35,0xa1,0x05}, {  36,0xa1,0x05}, {  37,0xa1,0x05}, {  38,0xa1,0x05}, {  39,0xa1,0x05},
+		/* 88 */ {  40,0xa1,0x05}, {  41,0xa1,0x05}, {  42,0xa1,0x05}, {  43,0xa1,0x05}, {  44,0xa1,0x05}, {  45,0xa1,0x05}, {  46,0xa1,0x05}, {  47,0xa1,0x05},
+		/* 90 */ {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10},
+		/* 98 */ {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10},
+		/* A0 */ {  31,0x00,0x00}, { 697,0x00,0x00}, { 274,0x00,0x00}, { 275,0x00,0x10}, { 276,0x00,0x11}, { 277,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* A8 */ {  31,0x00,0x00}, { 697,0x00,0x00}, { 726,0x00,0x00}, { 252,0x00,0x10}, { 737,0x00,0x11}, { 737,0x00,0x10}, {   0,0x00,0x60}, {  22,0x00,0x10},
+		/* B0 */ { 388,0x00,0x10}, { 388,0x00,0x10}, {   0,0x00,0x60}, { 247,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 653,0x00,0x10}, { 653,0x00,0x10},
+		/* B8 */ {   0,0x00,0x60}, { 755,0x00,0x10}, {  23,0x00,0x90}, { 251,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 649,0x00,0x10}, { 649,0x00,0x10},
+		/* C0 */ { 607,0x00,0x10}, { 607,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 374,0x00,0x11}, {   0,0x00,0x60}, {   0,0x00,0x11}, {  24,0x00,0x90},
+		/* C8 */ { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00},
+		/* D0 */ {   0,0x00,0x60}, { 327,0x00,0x10}, { 328,0x00,0x10}, { 329,0x00,0x10}, { 330,0x00,0x10}, { 331,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* D8 */ { 334,0x00,0x10}, { 335,0x00,0x10}, { 336,0x00,0x10}, { 337,0x00,0x10}, { 338,0x00,0x10}, { 339,0x00,0x10}, { 340,0x00,0x10}, { 341,0x00,0x10},
+		/* E0 */ {   0,0x00,0x60}, { 343,0x00,0x10}, { 344,0x00,0x10}, { 345,0x00,0x10}, { 346,0x00,0x10}, { 347,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* E8 */ { 350,0x00,0x10}, { 351,0x00,0x10}, { 352,0x00,0x10}, { 353,0x00,0x10}, { 354,0x00,0x10}, { 355,0x00,0x10}, { 356,0x00,0x10}, { 357,0x00,0x10},
+		/* F0 */ {   0,0x00,0x60}, { 359,0x00,0x10}, { 360,0x00,0x10}, { 361,0x00,0x10}, { 362,0x00,0x10}, { 363,0x00,0x10}, { 364,0x00,0x10}, {   0,0x00,0x60},
+		/* F8 */ { 366,0x00,0x10}, { 367,0x00,0x10}, { 368,0x00,0x10}, { 369,0x00,0x10}, { 370,0x00,0x10}, { 371,0x00,0x10}, { 372,0x00,0x10}, {1505,0x00,0x10}
+	},
+	{ /* NMD_X86_MODE_32 */
+		/* 00 */ {  20,0x00,0x90}, {   0,0x00,0x60}, { 194,0x00,0x10}, { 195,0x00,0x10}, {   0,0x00,0x60}, { 197,0x00,0x00}, { 198,0x10,0x00}, { 199,0x00,0x00},
+		/* 08 */ { 200,0x10,0x00}, { 201,0x10,0x00}, {   0,0x00,0x60}, { 203,0x00,0x00}, {   0,0x00,0x60}, {   0,0x00,0x10}, { 205,0x00,0x00}, {   0,0x00,0x60},
+		/* 10 */ { 988,0x00,0x10}, { 989,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 18 */ {  21,0x00,0x90}, { 655,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 655,0x00,0x10}, { 655,0x00,0x10}, {  22,0x00,0x90}, { 655,0x00,0x10},
+		/* 20 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 28 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 30 */ { 206,0x10,0x00}, { 207,0x00,0x00}, { 208,0x10,0x00}, { 209,0x10,0x00}, { 210,0x00,0x00}, { 211,0x10,0x00}, {   0,0x00,0x60}, { 213,0x10,0x00},
+		/* 38 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 40 */ { 214,0x00,0x10}, { 215,0x00,0x10}, { 216,0x00,0x10}, { 217,0x00,0x10}, { 218,0x00,0x10}, { 219,0x00,0x10}, { 220,0x00,0x10}, { 221,0x00,0x10},
+		/* 48 */ { 222,0x00,0x10}, { 223,0x00,0x10}, { 224,0x00,0x10}, { 225,0x00,0x10}, { 226,0x00,0x10}, { 227,0x00,0x10}, { 228,0x00,0x10}, { 229,0x00,0x10},
+		/* 50 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 58 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 60 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 68 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 70 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 616,0x00,0x00},
+		/* 78 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 80 */ {  32,0xa1,0x05}, {  33,0xa1,0x05}, {  34,0xa1,0x05}, {  35,0xa1,0x05}, {  36,0xa1,0x05}, {  37,0xa1,0x05}, {  38,0xa1,0x05}, {  39,0xa1,0x05},
+		/* 88 */ {  40,0xa1,0x05}, {  41,0xa1,0x05}, {  42,0xa1,0x05}, {  43,0xa1,0x05}, {  44,0xa1,0x05}, {  45,0xa1,0x05}, {  46,0xa1,0x05}, {  47,0xa1,0x05},
+		/* 90 */ {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10},
+		/* 98 */ {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10},
+		/* A0 */ {  31,0x00,0x00}, { 697,0x00,0x00}, { 274,0x00,0x00}, { 275,0x00,0x10}, { 276,0x00,0x11}, { 277,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* A8 */ {  31,0x00,0x00}, { 697,0x00,0x00}, { 726,0x00,0x00}, { 252,0x00,0x10}, { 737,0x00,0x11}, { 737,0x00,0x10}, {   0,0x00,0x60}, {  22,0x00,0x10},
+		/* B0 */ { 388,0x00,0x10}, { 388,0x00,0x10}, {   0,0x00,0x60}, { 247,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 653,0x00,0x10}, { 653,0x00,0x10},
+		/* B8 */ {   0,0x00,0x60}, { 755,0x00,0x10}, {  23,0x00,0x90}, { 251,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 649,0x00,0x10}, { 649,0x00,0x10},
+		/* C0 */ { 607,0x00,0x10}, { 607,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 374,0x00,0x11}, {   0,0x00,0x60}, {   0,0x00,0x11}, {  24,0x00,0x90},
+		/* C8 */ { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00},
+		/* D0 */ {   0,0x00,0x60}, { 327,0x00,0x10}, { 328,0x00,0x10}, { 329,0x00,0x10}, { 330,0x00,0x10}, { 331,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* D8 */ { 334,0x00,0x10}, { 335,0x00,0x10}, { 336,0x00,0x10}, { 337,0x00,0x10}, { 338,0x00,0x10}, { 339,0x00,0x10}, { 340,0x00,0x10}, { 341,0x00,0x10},
+		/* E0 */ {   0,0x00,0x60}, { 343,0x00,0x10}, { 344,0x00,0x10}, { 345,0x00,0x10}, { 346,0x00,0x10}, { 347,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* E8 */ { 350,0x00,0x10}, { 351,0x00,0x10}, { 352,0x00,0x10}, { 353,0x00,0x10}, { 354,0x00,0x10}, { 355,0x00,0x10}, { 356,0x00,0x10}, { 357,0x00,0x10},
+		/* F0 */ {   0,0x00,0x60}, { 359,0x00,0x10}, { 360,0x00,0x10}, { 361,0x00,0x10}, { 362,0x00,0x10}, { 363,0x00,0x10}, { 364,0x00,0x10}, {   0,0x00,0x60},
+		/* F8 */ { 366,0x00,0x10}, { 367,0x00,0x10}, { 368,0x00,0x10}, { 369,0x00,0x10}, { 370,0x00,0x10}, { 371,0x00,0x10}, { 372,0x00,0x10}, {1505,0x00,0x10}
+	},
+	{ /* NMD_X86_MODE_64 */
+		/* 00 */ {  20,0x00,0x90}, {   0,0x00,0x60}, { 194,0x00,0x10}, { 195,0x00,0x10}, {   0,0x00,0x60}, { 197,0x00,0x00}, { 198,0x10,0x00}, { 199,0x00,0x00},
+		/* 08 */ { 200,0x10,0x00}, { 201,0x10,0x00}, {   0,0x00,0x60}, { 203,0x00,0x00}, {   0,0x00,0x60}, {   0,0x00,0x10}, { 205,0x00,0x00}, {   0,0x00,0x60},
+		/* 10 */ { 988,0x00,0x10}, { 989,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 18 */ {  21,0x00,0x90}, { 655,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 655,0x00,0x10}, { 655,0x00,0x10}, {  22,0x00,0x90}, { 655,0x00,0x10},
+		/* 20 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 28 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 30 */ { 206,0x10,0x00}, { 207,0x00,0x00}, { 208,0x10,0x00}, { 209,0x10,0x00}, { 210,0x00,0x00}, { 211,0x10,0x00}, {   0,0x00,0x60}, { 213,0x10,0x00},
+		/* 38 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 40 */ { 214,0x00,0x10}, { 215,0x00,0x10}, { 216,0x00,0x10}, { 217,0x00,0x10}, { 218,0x00,0x10}, { 219,0x00,0x10}, { 220,0x00,0x10}, { 221,0x00,0x10},
+		/* 48 */ { 222,0x00,0x10}, { 223,0x00,0x10}, { 224,0x00,0x10}, { 225,0x00,0x10}, { 226,0x00,0x10}, { 227,0x00,0x10}, { 228,0x00,0x10}, { 229,0x00,0x10},
+		/* 50 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 58 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 60 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 68 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 70 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 616,0x00,0x00},
+		/* 78 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 80 */ {  32,0xa1,0x04}, {  33,0xa1,0x04}, {  34,0xa1,0x04}, {  35,0xa1,0x04}, {  36,0xa1,0x04}, {  37,0xa1,0x04}, {  38,0xa1,0x04}, {  39,0xa1,0x04},
+		/* 88 */ {  40,0xa1,0x04}, {  41,0xa1,0x04}, {  42,0xa1,0x04}, {  43,0xa1,0x04}, {  44,0xa1,0x04}, {  45,0xa1,0x04}, {  46,0xa1,0x04}, {  47,0xa1,0x04},
+		/* 90 */ {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10},
+		/* 98 */ {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10},
+		/* A0 */ {  31,0x00,0x00}, { 697,0x00,0x00}, { 274,0x00,0x00}, { 275,0x00,0x10}, { 276,0x00,0x11}, { 277,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* A8 */ {  31,0x00,0x00}, { 697,0x00,0x00}, { 726,0x00,0x00}, { 252,0x00,0x10}, { 737,0x00,0x11}, { 737,0x00,0x10}, {   0,0x00,0x60}, {  22,0x00,0x10},
+		/* B0 */ { 388,0x00,0x10}, { 388,0x00,0x10}, {   0,0x00,0x60}, { 247,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 653,0x00,0x10}, { 653,0x00,0x10},
+		/* B8 */ {   0,0x00,0x60}, { 755,0x00,0x10}, {  23,0x00,0x90}, { 251,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 649,0x00,0x10}, { 649,0x00,0x10},
+		/* C0 */ { 607,0x00,0x10}, { 607,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 374,0x00,0x11}, {   0,0x00,0x60}, {   0,0x00,0x11}, {   0,0x00,0x60},
+		/* C8 */ { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00},
+		/* D0 */ {   0,0x00,0x60}, { 327,0x00,0x10}, { 328,0x00,0x10}, { 329,0x00,0x10}, { 330,0x00,0x10}, { 331,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* D8 */ { 334,0x00,0x10}, { 335,0x00,0x10}, { 336,0x00,0x10}, { 337,0x00,0x10}, { 338,0x00,0x10}, { 339,0x00,0x10}, { 340,0x00,0x10}, { 341,0x00,0x10},
+		/* E0 */ {   0,0x00,0x60}, { 343,0x00,0x10}, { 344,0x00,0x10}, { 345,0x00,0x10}, { 346,0x00,0x10}, { 347,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* E8 */ { 350,0x00,0x10}, { 351,0x00,0x10}, { 352,0x00,0x10}, { 353,0x00,0x10}, { 354,0x00,0x10}, { 355,0x00,0x10}, { 356,0x00,0x10}, { 357,0x00,0x10},
+		/* F0 */ {   0,0x00,0x60}, { 359,0x00,0x10}, { 360,0x00,0x10}, { 361,0x00,0x10}, { 362,0x00,0x10}, { 363,0x00,0x10}, { 364,0x00,0x10}, {   0,0x00,0x60},
+		/* F8 */ { 366,0x00,0x10}, { 367,0x00,0x10}, { 368,0x00,0x10}, { 369,0x00,0x10}, { 370,0x00,0x10}, { 371,0x00,0x10}, { 372,0x00,0x10}, {1505,0x00,0x10}
+	}
+};
+
+/* Properties of the opcodes whose properties depend on ModR/M.reg. Indexed by [_nmd_x86_opcode_info.id][ModR/M.reg]. */
+NMD_ASSEMBLY_API const _nmd_x86_opcode_info _nmd_x86_opcode_extensions[25][8] = {
+	{ {   1,0x00,0x11}, {   2,0x00,0x11}, {   3,0x00,0x11}, {   4,0x00,0x11}, {   5,0x00,0x11}, {   6,0x00,0x11}, {   7,0x00,0x11}, {   8,0x00,0x11} },
+	{ {   1,0x00,0x15}, {   2,0x00,0x15}, {   3,0x00,0x15}, {   4,0x00,0x15}, {   5,0x00,0x15}, {   6,0x00,0x15}, {   7,0x00,0x15}, {   8,0x00,0x15} },
+	{ { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60} },
+	{ { 625,0x00,0x10}, {   0,0x00,0x60}, { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60} },
+	{ { 697,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60} },
+	{ {   9,0x00,0x11}, {  10,0x00,0x11}, {  11,0x00,0x11}, {  12,0x00,0x11}, {  13,0x00,0x11}, {  14,0x00,0x11}, {  15,0x00,0x11}, {  16,0x00,0x11} },
+	{ { 625,0x00,0x11}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60} },
+	{ { 625,0x00,0x15}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60} },
+	{ {   9,0x00,0x10}, {  10,0x00,0x10}, {  11,0x00,0x10}, {  12,0x00,0x10}, {  13,0x00,0x10}, {  14,0x00,0x10}, {  15,0x00,0x10}, {  16,0x00,0x10} },
+	{ {   0,0x00,0x60}, {  49,0x00,0x10}, {   0,0x00,0x60}, {  51,0x00,0x10}, {   0,0x00,0x60}, {  53,0x00,0x10}, {   0,0x00,0x60}, {  55,0x00,0x10} },
+	{ {  56,0x00,0x10}, { 746,0x00,0x50}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60} },
+	{ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 100,0x00,0x30}, {   0,0x00,0x60}, { 102,0x00,0x30}, { 103,0x00,0x30} },
+	{ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 123,0x00,0x50}, {  59,0x00,0x30} },
+	{ {  48,0x00,0x10}, {  49,0x00,0x10}, {  50,0x00,0x10}, {  51,0x00,0x10}, {  52,0x00,0x10}, {   0,0x00,0x60}, {  54,0x00,0x10}, {   0,0x00,0x60} },
+	{ {   0,0x00,0x60}, {   0,0x00,0x60}, {  58,0x00,0x10}, {  59,0x00,0x10}, {   0,0x00,0x60}, { 753,0x00,0x50}, { 517,0x00,0x30}, { 514,0x00,0x30} },
+	{ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 111,0x00,0x30} },
+	{ {  17,0x00,0x11}, {  18,0x00,0x11}, {  19,0x00,0x10}, {  20,0x00,0x10}, {  21,0x00,0x10}, {  22,0x00,0x10}, {  23,0x00,0x10}, {  24,0x00,0x10} },
+	{ {  17,0x00,0x15}, {  18,0x00,0x10}, {  19,0x00,0x10}, {  20,0x00,0x10}, {  21,0x00,0x10}, {  22,0x00,0x10}, {  23,0x00,0x10}, {  24,0x00,0x10} },
+	{ {  25,0x00,0x10}, {  26,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60} },
+	{ {  25,0x00,0x10}, {  26,0x00,0x10}, {  27,0x42,0x10}, {  28,0x42,0x30}, {  29,0x41,0x10}, {  30,0x41,0x30}, {  31,0x00,0x10}, {   0,0x00,0x60} },
+	{ { 152,0x00,0x10}, { 153,0x00,0x10}, { 154,0x00,0x10}, { 155,0x00,0x10}, { 156,0x00,0x10}, { 157,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60} },
+	{ { 705,0x00,0x10}, { 706,0x00,0x10}, { 707,0x00,0x10}, { 708,0x00,0x10}, { 655,0x00,0x10}, { 655,0x00,0x10}, { 655,0x00,0x10}, { 655,0x00,0x10} },
+	{ { 655,0x00,0x10}, { 655,0x00,0x10}, { 655,0x00,0x10}, { 655,0x00,0x10}, { 655,0x00,0x10}, { 655,0x00,0x10}, { 655,0x00,0x10}, {   0,0x00,0x60} },
+	{ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 250,0x00,0x11}, { 252,0x00,0x11}, { 247,0x00,0x11}, { 251,0x00,0x11} },
+	{ {   0,0x00,0x60}, { 447,0x00,0x30}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60} }
+};
+
+/* Flags('_NMD_X86_OPCODE_FLAGS') of the opcodes of the one byte opcode map used by the table-driven length disassembler. Indexed by [mode >> 2][opcode]. */
+NMD_ASSEMBLY_API const uint8_t _nmd_x86_ldisasm_op1_flags[3][256] = {
+	{ /* NMD_X86_MODE_16 */
+		/* 00 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x00, 0x00, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x00, 0x60,
+		/* 10 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x00, 0x00, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x00, 0x00,
+		/* 20 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x00, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x00,
+		/* 30 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x00, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x00,
+		/* 40 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* 50 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* 60 */ 0x00, 0x00, 0x30, 0x10, 0x60, 0x60, 0x60, 0x60, 0x05, 0x15, 0x01, 0x11, 0x00, 0x00, 0x00, 0x00,
+		/* 70 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+		/* 80 */ 0x11, 0x15, 0x11, 0x11, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x30, 0x60, 0x60,
+		/* 90 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* A0 */ 0x07, 0x07, 0x07, 0x07, 0x00, 0x00, 0x00, 0x00, 0x01, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* B0 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02,
+		/* C0 */ 0x11, 0x11, 0x02, 0x00, 0x60, 0x60, 0x60, 0x60, 0x03, 0x00, 0x02, 0x00, 0x00, 0x01, 0x00, 0x00,
+		/* D0 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x01, 0x00, 0x00, 0x10, 0x60, 0x60, 0x60, 0x10, 0x60, 0x60, 0x60,
+		/* E0 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x05, 0x05, 0x08, 0x01, 0x00, 0x00, 0x00, 0x00,
+		/* F0 */ 0x60, 0x00, 0x60, 0x60, 0x00, 0x00, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x60
+	},
+	{ /* NMD_X86_MODE_32 */
+		/* 00 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x00, 0x00, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x00, 0x60,
+		/* 10 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x00, 0x00, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x00, 0x00,
+		/* 20 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x00, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x00,
+		/* 30 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x00, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x00,
+		/* 40 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* 50 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* 60 */ 0x00, 0x00, 0x30, 0x10, 0x60, 0x60, 0x60, 0x60, 0x05, 0x15, 0x01, 0x11, 0x00, 0x00, 0x00, 0x00,
+		/* 70 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+		/* 80 */ 0x11, 0x15, 0x11, 0x11, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x30, 0x60, 0x60,
+		/* 90 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* A0 */ 0x07, 0x07, 0x07, 0x07, 0x00, 0x00, 0x00, 0x00, 0x01, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* B0 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05,
+		/* C0 */ 0x11, 0x11, 0x02, 0x00, 0x60, 0x60, 0x60, 0x60, 0x03, 0x00, 0x02, 0x00, 0x00, 0x01, 0x00, 0x00,
+		/* D0 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x01, 0x00, 0x00, 0x10, 0x60, 0x60, 0x60, 0x10, 0x60, 0x60, 0x60,
+		/* E0 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x05, 0x05, 0x08, 0x01, 0x00, 0x00, 0x00, 0x00,
+		/* F0 */ 0x60, 0x00, 0x60, 0x60, 0x00, 0x00, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x60
+	},
+	{ /* NMD_X86_MODE_64 */
+		/* 00 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x60,
+		/* 10 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x60,
+		/* 20 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x60,
+		/* 30 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x60,
+		/* 40 */ 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 50 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* 60 */ 0x60, 0x60, 0x60, 0x10, 0x60, 0x60, 0x60, 0x60, 0x05, 0x15, 0x01, 0x11, 0x00, 0x00, 0x00, 0x00,
+		/* 70 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+		/* 80 */ 0x11, 0x15, 0x60, 0x11, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x30, 0x60, 0x60,
+		/* 90 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* A0 */ 0x07, 0x07, 0x07, 0x07, 0x00, 0x00, 0x00, 0x00, 0x01, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* B0 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* C0 */ 0x11, 0x11, 0x02, 0x00, 0x60, 0x60, 0x60, 0x60, 0x03, 0x00, 0x02, 0x00, 0x00, 0x01, 0x60, 0x00,
+		/* D0 */ 0x10, 0x10, 0x10, 0x10, 0x60, 0x60, 0x60, 0x00, 0x10, 0x60, 0x60, 0x60, 0x10, 0x60, 0x60, 0x60,
+		/* E0 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x05, 0x05, 0x60, 0x01, 0x00, 0x00, 0x00, 0x00,
+		/* F0 */ 0x60, 0x00, 0x60, 0x60, 0x00, 0x00, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x60
+	}
+};
+
+/* Flags('_NMD_X86_OPCODE_FLAGS') of the opcodes of the two byte(0F) opcode map used by the table-driven length disassembler. Indexed by [mode >> 2][opcode]. */
+NMD_ASSEMBLY_API const uint8_t _nmd_x86_ldisasm_op2_flags[3][256] = {
+	{ /* NMD_X86_MODE_16 */
+		/* 00 */ 0x60, 0x60, 0x10, 0x10, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x00, 0x60, 0x10, 0x00, 0x60,
+		/* 10 */ 0x10, 0x10, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x10, 0x10, 0x30, 0x30, 0x10, 0x10, 0x10, 0x10,
+		/* 20 */ 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x10, 0x60, 0x10, 0x10, 0x60, 0x60,
+		/* 30 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x00, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 40 */ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* 50 */ 0x60, 0x10, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x10, 0x10, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10,
+		/* 60 */ 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 70 */ 0x11, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x00, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 80 */ 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05,
+		/* 90 */ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* A0 */ 0x00, 0x00, 0x00, 0x10, 0x11, 0x10, 0x60, 0x60, 0x00, 0x00, 0x00, 0x10, 0x11, 0x10, 0x60, 0x10,
+		/* B0 */ 0x10, 0x10, 0x60, 0x10, 0x60, 0x60, 0x10, 0x10, 0x60, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* C0 */ 0x10, 0x10, 0x11, 0x60, 0x11, 0x60, 0x11, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* D0 */ 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* E0 */ 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* F0 */ 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+	},
+	{ /* NMD_X86_MODE_32 */
+		/* 00 */ 0x60, 0x60, 0x10, 0x10, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x00, 0x60, 0x10, 0x00, 0x60,
+		/* 10 */ 0x10, 0x10, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x10, 0x10, 0x30, 0x30, 0x10, 0x10, 0x10, 0x10,
+		/* 20 */ 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x10, 0x60, 0x10, 0x10, 0x60, 0x60,
+		/* 30 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x00, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 40 */ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* 50 */ 0x60, 0x10, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x10, 0x10, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10,
+		/* 60 */ 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 70 */ 0x11, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x00, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 80 */ 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05,
+		/* 90 */ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* A0 */ 0x00, 0x00, 0x00, 0x10, 0x11, 0x10, 0x60, 0x60, 0x00, 0x00, 0x00, 0x10, 0x11, 0x10, 0x60, 0x10,
+		/* B0 */ 0x10, 0x10, 0x60, 0x10, 0x60, 0x60, 0x10, 0x10, 0x60, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* C0 */ 0x10, 0x10, 0x11, 0x60, 0x11, 0x60, 0x11, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* D0 */ 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* E0 */ 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* F0 */ 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+	},
+	{ /* NMD_X86_MODE_64 */
+		/* 00 */ 0x60, 0x60, 0x10, 0x10, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x00, 0x60, 0x10, 0x00, 0x60,
+		/* 10 */ 0x10, 0x10, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x10, 0x10, 0x30, 0x30, 0x10, 0x10, 0x10, 0x10,
+		/* 20 */ 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x10, 0x60, 0x10, 0x10, 0x60, 0x60,
+		/* 30 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x00, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 40 */ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* 50 */ 0x60, 0x10, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x10, 0x10, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10,
+		/* 60 */ 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 70 */ 0x11, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x00, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 80 */ 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,
+		/* 90 */ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* A0 */ 0x00, 0x00, 0x00, 0x10, 0x11, 0x10, 0x60, 0x60, 0x00, 0x00, 0x00, 0x10, 0x11, 0x10, 0x60, 0x10,
+		/* B0 */ 0x10, 0x10, 0x60, 0x10, 0x60, 0x60, 0x10, 0x10, 0x60, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* C0 */ 0x10, 0x10, 0x11, 0x60, 0x11, 0x60, 0x11, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* D0 */ 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* E0 */ 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* F0 */ 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+	}
+};
+
+/* Length-prefixed mnemonics of the instructions as printed by the formatter, followed by 16 zero bytes so that '_nmd_append_mnemonic' can always copy 16 bytes. */
+NMD_ASSEMBLY_API const char _nmd_x86_mnemonics[2727] =
+	"\000" "\003" "add" "\002" "or" "\003" "adc" "\003" "sbb" "\003" "and" "\003" "sub" "\003" "xor"
+	"\003" "cmp" "\003" "rol" "\003" "ror" "\003" "rcl" "\003" "rcr" "\003" "shl" "\003" "shr" "\003" "sar"
+	"\004" "test" "\003" "not" "\003" "neg" "\003" "mul" "\004" "imul" "\003" "div" "\004" "idiv" "\003" "inc"
+	"\003" "dec" "\004" "call" "\003" "jmp" "\004" "push" "\002" "jo" "\003" "jno" "\002" "jb" "\003" "jnb"
+	"\002" "jz" "\003" "jnz" "\003" "jbe" "\002" "ja" "\002" "js" "\003" "jns" "\002" "jp" "\003" "jnp"
+	"\002" "jl" "\003" "jge" "\003" "jle" "\002" "jg" "\004" "fadd" "\004" "fcom" "\004" "fdiv" "\003" "fld"
+	"\003" "fst" "\004" "fstp" "\006" "fldenv" "\005" "fldcw" "\007" "fnstenv" "\006" "fnstcw" "\004" "fchs" "\004" "fabs"
+	"\003" "aas" "\004" "ftst" "\004" "fxam" "\003" "ret" "\005" "enter" "\004" "fld1" "\006" "fldl2t" "\006" "fldl2e"
+	"\005" "fldpi" "\006" "fldlg2" "\006" "fldln2" "\004" "fldz" "\004" "fnop" "\005" "f2xm1" "\005" "fyl2x" "\005" "fptan"
+	"\006" "fpatan" "\007" "fxtract" "\006" "fprem1" "\007" "fdecstp" "\007" "fincstp" "\005" "fprem" "\007" "fyl2xp1" "\005" "fsqrt"
+	"\007" "fsincos" "\007" "frndint" "\006" "fscale" "\004" "fsin" "\004" "fcos" "\005" "fiadd" "\005" "fimul" "\005" "ficom"
+	"\006" "ficomp" "\005" "fisub" "\006" "fisubr" "\005" "fidiv" "\006" "fidivr" "\004" "fild" "\006" "fisttp" "\004" "fist"
+	"\005" "fistp" "\004" "fbld" "\005" "fbstp" "\006" "fnclex" "\005" "fcomi" "\006" "movapd" "\005" "bndcn" "\004" "int1"
+	"\005" "lzcnt" "\010" "addsubpd" "\003" "hlt" "\003" "cmc" "\010" "addsubps" "\003" "clc" "\003" "stc" "\003" "cli"
+	"\003" "sti" "\003" "cld" "\003" "std" "\003" "aam" "\003" "aad" "\004" "salc" "\004" "xlat" "\006" "loopne"
+	"\005" "loope" "\004" "loop" "\004" "sldt" "\003" "str" "\004" "lldt" "\003" "ltr" "\004" "verr" "\004" "verw"
+	"\004" "sgdt" "\004" "sidt" "\004" "lgdt" "\004" "lidt" "\004" "smsw" "\010" "rstorssp" "\004" "lmsw" "\006" "invlpg"
+	"\005" "enclv" "\006" "vmcall" "\010" "vmlaunch" "\010" "vmresume" "\004" "clac" "\004" "stac" "\003" "cbw" "\005" "cmpsb"
+	"\005" "cmpsd" "\005" "encls" "\006" "xgetbv" "\006" "xsetbv" "\004" "arpl" "\006" "vmfunc" "\004" "xend" "\005" "xtest"
+	"\005" "enclu" "\005" "vmrun" "\007" "vmmcall" "\006" "vmload" "\006" "vmsave" "\004" "stgi" "\004" "clgi" "\006" "skinit"
+	"\007" "invlpga" "\003" "lar" "\003" "lsl" "\007" "syscall" "\004" "clts" "\006" "sysret" "\004" "invd" "\006" "wbinvd"
+	"\003" "ud2" "\005" "femms" "\005" "wrmsr" "\005" "rdtsc" "\005" "rdmsr" "\005" "rdpmc" "\010" "sysenter" "\007" "sysexit"
+	"\006" "getsec" "\005" "cmovo" "\006" "cmovno" "\005" "cmovb" "\006" "cmovnb" "\005" "cmovz" "\006" "cmovnz" "\006" "cmovbe"
+	"\005" "cmova" "\005" "cmovs" "\006" "cmovns" "\005" "cmovp" "\006" "cmovnp" "\005" "cmovl" "\006" "cmovge" "\006" "cmovle"
+	"\005" "cmovg" "\003" "lss" "\003" "btr" "\003" "lfs" "\003" "lgs" "\002" "bt" "\003" "btc" "\003" "bts"
+	"\005" "cpuid" "\004" "shld" "\005" "psrlw" "\005" "psrld" "\005" "psrlq" "\005" "paddq" "\006" "pmullw" "\010" "pmovmskb"
+	"\007" "psubusb" "\007" "psubusw" "\006" "pminub" "\004" "pand" "\007" "paddusb" "\007" "paddusw" "\006" "pmaxub" "\005" "pandn"
+	"\005" "pavgb" "\005" "psraw" "\005" "psrad" "\005" "pavgw" "\007" "pmulhuw" "\006" "pmulhw" "\003" "cqo" "\006" "psubsb"
+	"\006" "psubsw" "\006" "pminsw" "\003" "por" "\006" "paddsb" "\006" "paddsw" "\006" "pmaxsw" "\004" "pxor" "\005" "lddqu"
+	"\005" "psllq" "\007" "pmuludq" "\007" "pmaddwd" "\006" "psadbw" "\005" "bswap" "\005" "psubb" "\005" "psubw" "\005" "psubd"
+	"\005" "psubq" "\005" "paddb" "\005" "paddw" "\005" "paddd" "\006" "movnti" "\006" "pinsrw" "\006" "pextrw" "\007" "cmpxchg"
+	"\007" "pcmpeqb" "\007" "pcmpeqw" "\007" "pcmpeqd" "\010" "movmskps" "\006" "sqrtps" "\007" "rsqrtps" "\005" "rcpps" "\005" "andps"
+	"\006" "andnps" "\004" "orps" "\005" "xorps" "\005" "addps" "\005" "mulps" "\010" "cvtps2pd" "\010" "cvtdq2ps" "\005" "subps"
+	"\005" "minps" "\005" "divps" "\005" "maxps" "\010" "movmskpd" "\006" "sqrtpd" "\006" "bndldx" "\006" "bndstx" "\005" "andpd"
+	"\006" "andnpd" "\004" "orpd" "\005" "xorpd" "\005" "addpd" "\005" "mulpd" "\010" "cvtpd2ps" "\010" "cvtps2dq" "\005" "subpd"
+	"\005" "minpd" "\005" "divpd" "\005" "maxpd" "\006" "bndmov" "\006" "sqrtss" "\007" "rsqrtss" "\005" "rcpss" "\011" "cmpxchg8b"
+	"\003" "daa" "\003" "cwd" "\004" "insd" "\005" "addss" "\005" "mulss" "\010" "cvtss2sd" "\011" "cvttps2dq" "\005" "subss"
+	"\005" "minss" "\005" "divss" "\005" "maxss" "\005" "bndcl" "\006" "sqrtsd" "\005" "bndcu" "\005" "bndmk" "\003" "das"
+	"\004" "cwde" "\004" "insw" "\005" "addsd" "\005" "mulsd" "\010" "cvtsd2ss" "\006" "fcomip" "\005" "subsd" "\005" "minsd"
+	"\005" "divsd" "\005" "maxsd" "\011" "punpcklbw" "\011" "punpcklwd" "\011" "punpckldq" "\010" "packsswb" "\007" "pcmpgtb" "\007" "pcmpgtw"
+	"\007" "pcmpgtd" "\010" "packuswb" "\011" "punpckhbw" "\011" "punpckhwd" "\011" "punpckhdq" "\010" "packssdw" "\012" "punpcklqdq" "\012" "punpckhqdq"
+	"\005" "tzcnt" "\003" "cdq" "\004" "cdqe" "\010" "cvtdq2pd" "\010" "cvtpd2dq" "\010" "cvtsi2sd" "\010" "cvtsi2ss" "\011" "cvttpd2dq"
+	"\005" "extrq" "\006" "fcompp" "\005" "ffree" "\006" "fnstsw" "\006" "ffreep" "\006" "frstor" "\006" "fnsave" "\006" "movaps"
+	"\006" "haddpd" "\006" "haddps" "\006" "hsubpd" "\006" "hsubps" "\002" "in" "\004" "insb" "\007" "insertq" "\003" "int"
+	"\004" "int3" "\004" "into" "\004" "iret" "\005" "iretd" "\005" "iretq" "\004" "lahf" "\003" "lea" "\005" "leave"
+	"\005" "lodsb" "\005" "lodsd" "\004" "retf" "\004" "xadd" "\003" "bsr" "\012" "maskmovdqu" "\010" "cvtpd2pi" "\010" "cvtpi2pd"
+	"\010" "cvtpi2ps" "\010" "cvtps2pi" "\011" "cvttpd2pi" "\011" "cvttps2pi" "\004" "emms" "\010" "maskmovq" "\004" "movd" "\007" "movdq2q"
+	"\006" "movntq" "\007" "movq2dq" "\006" "pshufw" "\003" "mov" "\006" "movdqa" "\006" "movdqu" "\007" "movntdq" "\007" "movntpd"
+	"\005" "movsb" "\005" "movsd" "\005" "movsx" "\006" "movsxd" "\005" "movzx" "\003" "nop" "\003" "out" "\005" "outsb"
+	"\005" "outsd" "\005" "outsw" "\005" "pause" "\003" "pop" "\004" "popa" "\005" "popad" "\006" "popcnt" "\004" "popf"
+	"\005" "popfd" "\005" "popfq" "\006" "pshufd" "\007" "pshufhw" "\007" "pshuflw" "\006" "psrldq" "\005" "pusha" "\006" "pushad"
+	"\005" "pushf" "\006" "pushfd" "\006" "pushfq" "\006" "rdrand" "\006" "rdseed" "\003" "rsm" "\004" "sahf" "\005" "scasb"
+	"\005" "scasd" "\004" "shrd" "\005" "stosb" "\005" "stosd" "\007" "fstpnce" "\004" "fxch" "\006" "swapgs" "\003" "bsf"
+	"\007" "fucomip" "\007" "fucompp" "\006" "fucomp" "\005" "fucom" "\003" "ud1" "\007" "vmclear" "\007" "vmwrite" "\005" "vmxon"
+	"\005" "fwait" "\006" "xabort" "\006" "xbegin" "\004" "xchg" "\005" "cmpss" "\005" "cmpps" "\005" "cmppd" "\003" "ud0"
+	"\007" "endbr32" "\007" "endbr64";
+
+/* Offsets in '_nmd_x86_mnemonics' of the mnemonics of the instructions. Indexed by 'NMD_X86_INSTRUCTION'. */
+NMD_ASSEMBLY_API const uint16_t _nmd_x86_mnemonic_offsets[NMD_X86_INSTRUCTION_ENDBR64 + 1] = {
+	/*    0 */    0,    1,    5,    8,   12,   16,   20,   24,   28,   32,   36,   40,   44,   48,   52,    0,
+	/*   16 */   56,   60,   60,   65,   69,   73,   77,   82,   86,   91,   95,   99,   99,  104,  104,  108,
+	/*   32 */  113,  116,  120,  123,  127,  130,  134,  138,  141,  144,  148,  151,  155,  158,  162,  166,
+	/*   48 */  169,    0,  174,    0,    0,    0,  179,    0,  184,    0,  188,  192,  197,  204,  210,  218,
+	/*   64 */  225,  230,  235,    0,  239,  244,  249,  253,  259,  264,  271,  278,  284,  291,  298,  303,
+	/*   80 */  308,  314,  320,  326,  333,  341,  348,  356,  364,  370,  378,  384,  392,  400,  407,  412,
+	/*   96 */  417,  423,  429,  435,  442,  448,  455,  461,    0,    0,    0,    0,  468,  473,  480,  485,
+	/*  112 */  491,    0,  496,    0,    0,    0,    0,    0,  502,    0,    0,  509,    0,  515,  522,    0,
+	/*  128 */    0,    0,    0,  528,  533,  539,  548,  552,  556,    0,  565,  569,  573,  577,  581,  585,
+	/*  144 */  589,  593,  597,  602,  607,  614,  620,    0,  625,  630,  634,  639,  643,  648,  653,  658,
+	/*  160 */  663,  668,  673,  678,  687,  692,  699,  705,  712,  721,    0,    0,  730,  735,  740,  744,
+	/*  176 */  750,  756,  762,  769,  776,    0,  781,  788,  793,  799,  805,  811,  819,  826,  833,  838,
+	/*  192 */  843,  850,  858,  862,    0,  866,  874,  879,  886,  891,    0,  898,    0,  902,  908,  914,
+	/*  208 */  920,  926,  932,  941,    0,  949,  956,  962,  969,  975,  982,  988,  995, 1002, 1008, 1014,
+	/*  224 */ 1021, 1027, 1034, 1040, 1047, 1054,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  240 */    0,    0,    0,    0,    0,    0, 1060, 1064, 1068, 1072, 1076, 1079, 1083,    0,    0,    0,
+	/*  256 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  272 */    0,    0, 1087, 1076, 1093, 1093,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  288 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  304 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  320 */    0,    0,    0,    0,    0,    0,    0, 1098, 1104, 1110, 1116, 1122,    0, 1129, 1138, 1146,
+	/*  336 */ 1154, 1161, 1166, 1174, 1182, 1189, 1195, 1201, 1207, 1213, 1219, 1227, 1234,    0, 1238, 1245,
+	/*  352 */ 1252, 1259, 1263, 1270, 1277, 1284, 1289,    0,    0, 1295, 1301, 1309, 1317, 1324, 1330, 1336,
+	/*  368 */ 1342, 1348, 1354, 1360, 1366, 1372, 1379, 1386,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  384 */    0,    0,    0,    0, 1393,    0,    0,    0, 1401, 1409, 1417, 1425, 1434, 1441, 1449, 1455,
+	/*  400 */ 1461, 1468, 1473, 1479, 1485, 1491, 1500, 1509, 1515, 1521, 1527, 1533, 1542, 1549, 1556, 1563,
+	/*  416 */ 1569, 1576, 1581, 1587, 1593, 1599, 1608, 1617, 1623, 1629, 1635, 1641, 1648, 1655, 1663, 1669,
+	/*  432 */ 1679, 1683, 1687, 1692, 1698, 1704, 1713, 1723, 1729, 1735, 1741, 1747, 1753, 1760, 1766, 1669,
+	/*  448 */ 1772, 1776, 1781, 1786, 1792, 1798, 1807, 1814, 1820, 1826, 1832, 1838, 1848, 1858, 1868, 1877,
+	/*  464 */ 1885, 1893, 1901, 1910, 1920, 1930, 1940, 1949, 1960,    0,    0,    0,    0,    0,    0,    0,
+	/*  480 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0, 1971,    0, 1977, 1981,    0,
+	/*  496 */    0,    0,    0, 1986, 1995,    0, 2004, 2013,    0, 2022,    0,    0,    0,    0, 2032, 2038,
+	/*  512 */ 2045,    0, 2051, 2058, 2065, 2072,    0,    0,    0, 2079,    0,    0, 2086, 2093, 2100, 2107,
+	/*  528 */ 2114, 2117,    0, 2122, 2130, 2134, 2139, 2144, 2149, 2155,    0,    0,    0,    0,    0,    0,
+	/*  544 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  560 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  576 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  592 */    0,    0,    0,    0,    0, 2161,    0, 2166, 2170,    0, 2176,    0, 2182,    0, 2188, 2193,
+	/*  608 */ 2198, 2202, 2213, 2222, 2231, 2240, 2249, 2259, 2269, 2274, 2283, 2288, 2296, 2303,    0, 2311,
+	/*  624 */    0, 2318,    0,    0,    0, 2322, 2329,    0,    0,    0,    0,    0,    0, 2336, 2344,    0,
+	/*  640 */    0,    0, 2352,    0,    0,    0, 2358,    0,    0, 2364, 2370,    0,    0, 2377,    0, 2383,
+	/*  656 */ 2387, 2391, 2397, 2403, 2409,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  672 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  688 */    0,    0,    0,    0,    0,    0,    0,    0,    0, 2415, 2419, 2424, 2430, 2437, 2442, 2448,
+	/*  704 */    0,    0,    0,    0,    0, 2454, 2461, 2469,    0, 2477,    0,    0, 2484, 2490, 2497, 2503,
+	/*  720 */ 2510, 2517, 2524, 2524,    0,    0, 2531, 2535,    0,    0, 2540,    0, 2546,    0,    0,    0,
+	/*  736 */    0, 2552,    0,    0,    0, 2557,    0, 2563,    0, 2569, 2577, 2582,    0, 2589,    0, 2593,
+	/*  752 */ 2601, 2609, 2616, 2622,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  768 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  784 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  800 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  816 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  832 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  848 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  864 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  880 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  896 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  912 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  928 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  944 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0, 2626,    0,    0,    0,    0,
+	/*  960 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  976 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  992 */    0,    0,    0,    0,    0, 2634, 2642,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1008 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1024 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1040 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1056 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1072 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1088 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1104 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1120 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1136 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1152 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1168 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1184 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1200 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1216 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1232 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1248 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1264 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1280 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1296 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1312 */ 2648, 2654,    0, 2661, 2668,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1328 */    0,    0,    0,    0,    0,    0,    0,    0,    0, 2673,    0,    0,    0,    0,    0,    0,
+	/* 1344 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0, 2679,    0,    0,    0,    0,
+	/* 1360 */    0,    0,    0,    0, 2685,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1376 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1392 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1408 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1424 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1440 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1456 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1472 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1488 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1504 */    0, 2691, 2695, 2703
+};
+
+/* Classes('_NMD_X86_PREFIX_CLASS') of every byte. */
+NMD_ASSEMBLY_API const uint8_t _nmd_x86_prefix_classes[256] = {
+	/* 00 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 10 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 20 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00,
+	/* 30 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00,
+	/* 40 */ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30,
+	/* 50 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 60 */ 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x03, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 70 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 80 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 90 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* A0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* B0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* C0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* D0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* E0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* F0 */ 0x09, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+/* Perfect hash table of the assembler's mnemonics('_NMD_X86_ASM_MNEMONIC'). Indexed by the high-order bits of _nmd_hash_string(mnemonic, length, _nmd_x86_asm_mnemonic_hash_seed). */
+NMD_ASSEMBLY_API const uint32_t _nmd_x86_asm_mnemonic_hash_seed = 0x811cb731;
+NMD_ASSEMBLY_API const uint8_t _nmd_x86_asm_mnemonic_hash_table[1 << _NMD_X86_ASM_MNEMONIC_HASH_BITS] = {
+	/* 00 */ 0x38, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x48, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 10 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x31, 0x00, 0x00, 0x65, 0x00, 0x00, 0x00, 0x20, 0x00,
+	/* 20 */ 0x1b, 0x00, 0x00, 0x44, 0x35, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x43, 0x00, 0x00, 0x00, 0x00,
+	/* 30 */ 0x00, 0x00, 0x2b, 0x00, 0x0f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 40 */ 0x00, 0x00, 0x00, 0x0c, 0x00, 0x54, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x64, 0x00,
+	/* 50 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x00,
+	/* 60 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 70 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x51, 0x00,
+	/* 80 */ 0x4e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x29, 0x2e, 0x00, 0x39, 0x00, 0x00, 0x00,
+	/* 90 */ 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x53, 0x00, 0x00, 0x3b, 0x10, 0x00, 0x00, 0x52, 0x00, 0x5e,
+	/* A0 */ 0x22, 0x4b, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x50, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* B0 */ 0x00, 0x00, 0x00, 0x00, 0x16, 0x00, 0x00, 0x00, 0x4a, 0x00, 0x00, 0x00, 0x00, 0x3d, 0x00, 0x00,
+	/* C0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x0d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x41, 0x00, 0x1e, 0x00,
+	/* D0 */ 0x00, 0x2d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x32, 0x00, 0x00, 0x00,
+	/* E0 */ 0x00, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x5b, 0x00, 0x5c, 0x00, 0x05, 0x00, 0x34, 0x00, 0x00,
+	/* F0 */ 0x00, 0x36, 0x3c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46, 0x00, 0x00, 0x2f, 0x00, 0x00, 0x00,
+	/* 100 */ 0x00, 0x4f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x61, 0x15, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 110 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3a, 0x00, 0x00, 0x00,
+	/* 120 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 130 */ 0x28, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 140 */ 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x45, 0x49, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x19, 0x00,
+	/* 150 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x12, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 160 */ 0x00, 0x2c, 0x00, 0x00, 0x00, 0x30, 0x66, 0x4d, 0x0e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 170 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x47, 0x00,
+	/* 180 */ 0x58, 0x00, 0x00, 0x62, 0x00, 0x00, 0x1a, 0x00, 0x00, 0x1d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 190 */ 0x24, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0b, 0x00, 0x00, 0x00, 0x18, 0x06, 0x00, 0x00,
+	/* 1A0 */ 0x42, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x5d, 0x07, 0x5f, 0x00, 0x00, 0x26, 0x00,
+	/* 1B0 */ 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00, 0x00, 0x59, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x63,
+	/* 1C0 */ 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3e, 0x25, 0x27, 0x23, 0x00, 0x2a,
+	/* 1D0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x13, 0x00, 0x00, 0x00, 0x00, 0x5a, 0x00,
+	/* 1E0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x11, 0x17, 0x37, 0x00, 0x56, 0x00, 0x4c, 0x00, 0x00, 0x57, 0x00,
+	/* 1F0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0x33, 0x00, 0x00, 0x00, 0x00, 0x55, 0x00
+};
+
+/* Perfect hash table of the general-purpose and segment registers('NMD_X86_REG'). Indexed by the high-order bits of _nmd_hash_string(name, length, _nmd_x86_asm_reg_hash_seed). */
+NMD_ASSEMBLY_API const uint32_t _nmd_x86_asm_reg_hash_seed = 0x811da41f;
+NMD_ASSEMBLY_API const uint8_t _nmd_x86_asm_reg_hash_table[1 << _NMD_X86_ASM_REG_HASH_BITS] = {
+	/* 00 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x49, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 10 */ 0x00, 0x00, 0x00, 0x54, 0x00, 0x00, 0x21, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x33, 0x00,
+	/* 20 */ 0x00, 0x00, 0x2f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x25, 0x00, 0x17, 0x41, 0x00, 0x10, 0x00, 0x00,
+	/* 30 */ 0x00, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x13, 0x3f, 0x00, 0x1e,
+	/* 40 */ 0x00, 0x00, 0x00, 0x4c, 0x00, 0x00, 0x2a, 0x00, 0x35, 0x00, 0x00, 0x00, 0x00, 0x39, 0x00, 0x55,
+	/* 50 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x50, 0x27, 0x00, 0x00, 0x2c, 0x00, 0x00,
+	/* 60 */ 0x3b, 0x00, 0x00, 0x00, 0x2b, 0x00, 0x3e, 0x19, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 70 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x2e, 0x2d, 0x00, 0x1b, 0x53, 0x00,
+	/* 80 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x42,
+	/* 90 */ 0x20, 0x00, 0x00, 0x37, 0x22, 0x00, 0x11, 0x00, 0x00, 0x00, 0x29, 0x4d, 0x00, 0x00, 0x00, 0x00,
+	/* A0 */ 0x00, 0x00, 0x32, 0x3d, 0x00, 0x00, 0x00, 0x3c, 0x00, 0x51, 0x00, 0x00, 0x1a, 0x00, 0x00, 0x00,
+	/* B0 */ 0x00, 0x00, 0x31, 0x00, 0x00, 0x30, 0x00, 0x34, 0x48, 0x00, 0x40, 0x00, 0x4b, 0x00, 0x00, 0x00,
+	/* C0 */ 0x12, 0x00, 0x00, 0x00, 0x00, 0x16, 0x00, 0x00, 0x52, 0x00, 0x4a, 0x00, 0x00, 0x00, 0x15, 0x24,
+	/* D0 */ 0x26, 0x00, 0x00, 0x00, 0x00, 0x3a, 0x00, 0x43, 0x00, 0x00, 0x23, 0x00, 0x4e, 0x00, 0x00, 0x00,
+	/* E0 */ 0x00, 0x00, 0x00, 0x00, 0x1f, 0x44, 0x4f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x38, 0x00, 0x00, 0x00,
+	/* F0 */ 0x00, 0x47, 0x00, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1d, 0x45, 0x46, 0x28, 0x00, 0x00, 0x00
+};
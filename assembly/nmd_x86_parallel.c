@@ -0,0 +1,284 @@
+#include "nmd_common.h"
+
+#ifdef NMD_ASSEMBLY_ENABLE_THREADS
+
+/* The buffer is split in 'num_threads * _NMD_X86_CHUNKS_PER_THREAD' chunks, so threads that finish early take the remaining work. */
+#define _NMD_X86_CHUNKS_PER_THREAD 8
+#define _NMD_X86_MIN_CHUNK_SIZE 4096
+#define _NMD_X86_MAX_CHUNKS (NMD_ASSEMBLY_MAX_THREADS * _NMD_X86_CHUNKS_PER_THREAD)
+
+typedef struct _nmd_x86_chunk
+{
+	size_t count;             /* The number of valid instructions that start in the chunk. */
+	size_t exit;              /* The offset where the chunk's instruction stream leaves the chunk. It may be past the end of the chunk. */
+	size_t first_instruction; /* The index of the chunk's first instruction in the output array. */
+} _nmd_x86_chunk;
+
+typedef struct _nmd_x86_parallel_job
+{
+	const uint8_t* buffer;
+	size_t buffer_size;
+	NMD_X86_MODE mode;
+	uint32_t flags;
+	uint8_t* lengths;
+	nmd_x86_instruction* instructions; /* Null if only the lengths are computed. */
+	size_t num_instructions;
+	size_t chunk_size;
+	size_t num_chunks;
+	bool decode_pass; /* false: find the instruction boundaries of each chunk. true: decode the instructions of each chunk. */
+	volatile long next_chunk;
+	_nmd_x86_chunk chunks[_NMD_X86_MAX_CHUNKS];
+} _nmd_x86_parallel_job;
+
+/* Returns the index of the next chunk to be processed. */
+NMD_ASSEMBLY_API size_t _nmd_x86_take_chunk(_nmd_x86_parallel_job* job)
+{
+#ifdef _WIN32
+	return (size_t)(InterlockedIncrement(&job->next_chunk) - 1);
+#else
+	return (size_t)__sync_fetch_and_add(&job->next_chunk, 1);
+#endif /* _WIN32 */
+}
+
+/* Returns the length of the instruction at 'offset' if it is valid, zero otherwise. */
+NMD_ASSEMBLY_API size_t _nmd_x86_parallel_length(const _nmd_x86_parallel_job* job, size_t offset)
+{
+	if (job->instructions)
+	{
+		/* Use the same lengths as nmd_x86_decode() */
+		nmd_x86_light_instruction instruction;
+		return nmd_x86_decode_light(job->buffer + offset, job->buffer_size - offset, NMD_X86_INVALID_RUNTIME_ADDRESS, &instruction, job->mode, job->flags & ~(NMD_X86_DECODER_FLAGS_INSTRUCTION_ID | NMD_X86_DECODER_FLAGS_GROUP)) ? instruction.length : 0;
+	}
+	else
+		return nmd_x86_ldisasm(job->buffer + offset, job->buffer_size - offset, job->mode);
+}
+
+/*
+Follows the instruction stream that starts at 'offset' and writes the length of every instruction that starts in the chunk 'index'.
+If 'resync' is true the chunk was already scanned, and the function stops as soon as the stream reaches an instruction of the previous scan.
+Invalid instructions are skipped one byte at a time.
+*/
+NMD_ASSEMBLY_API void _nmd_x86_scan_chunk(_nmd_x86_parallel_job* job, size_t index, size_t offset, bool resync)
+{
+	_nmd_x86_chunk* const chunk = &job->chunks[index];
+	const size_t end = _NMD_MIN((index + 1) * job->chunk_size, job->buffer_size);
+	size_t length, i;
+
+	while (offset < end)
+	{
+		/* The streams converged, the rest of the chunk is already correct */
+		if (resync && job->lengths[offset])
+			return;
+
+		length = _nmd_x86_parallel_length(job, offset);
+		job->lengths[offset] = (uint8_t)length;
+		if (!length)
+		{
+			offset++;
+			continue;
+		}
+
+		chunk->count++;
+		for (i = offset + 1; i < offset + length && i < end; i++)
+		{
+			if (resync && job->lengths[i])
+				chunk->count--;
+			job->lengths[i] = 0;
+		}
+
+		offset += length;
+	}
+
+	chunk->exit = offset;
+}
+
+/* Makes the instruction stream of the chunk 'index' continue the stream of the previous chunk. */
+NMD_ASSEMBLY_API void _nmd_x86_resync_chunk(_nmd_x86_parallel_job* job, size_t index)
+{
+	_nmd_x86_chunk* const chunk = &job->chunks[index];
+	const size_t begin = index * job->chunk_size;
+	const size_t end = _NMD_MIN(begin + job->chunk_size, job->buffer_size);
+	const size_t exit = job->chunks[index - 1].exit;
+	size_t offset;
+
+	if (exit == begin)
+		return;
+
+	/* These bytes belong to the last instruction of the previous chunk */
+	for (offset = begin; offset < exit && offset < end; offset++)
+	{
+		if (job->lengths[offset])
+			chunk->count--;
+		job->lengths[offset] = 0;
+	}
+
+	_nmd_x86_scan_chunk(job, index, exit, true);
+}
+
+/* Decodes the instructions that start in the chunk 'index' into the output array. */
+NMD_ASSEMBLY_API void _nmd_x86_decode_chunk(_nmd_x86_parallel_job* job, size_t index)
+{
+	const size_t end = _NMD_MIN((index + 1) * job->chunk_size, job->buffer_size);
+	size_t offset = index ? job->chunks[index - 1].exit : 0;
+	size_t i = job->chunks[index].first_instruction;
+
+	for (; offset < end && i < job->num_instructions; offset += job->lengths[offset] ? job->lengths[offset] : 1)
+	{
+		if (job->lengths[offset])
+			nmd_x86_decode(job->buffer + offset, job->buffer_size - offset, &job->instructions[i++], job->mode, job->flags);
+	}
+}
+
+NMD_ASSEMBLY_API void _nmd_x86_parallel_worker(_nmd_x86_parallel_job* job)
+{
+	size_t index;
+	while ((index = _nmd_x86_take_chunk(job)) < job->num_chunks)
+	{
+		if (job->decode_pass)
+			_nmd_x86_decode_chunk(job, index);
+		else
+		{
+			job->chunks[index].count = 0;
+			_nmd_x86_scan_chunk(job, index, index * job->chunk_size, false);
+		}
+	}
+}
+
+#ifdef _WIN32
+NMD_ASSEMBLY_API DWORD WINAPI _nmd_x86_thread_proc(LPVOID job)
+#else
+NMD_ASSEMBLY_API void* _nmd_x86_thread_proc(void* job)
+#endif /* _WIN32 */
+{
+	_nmd_x86_parallel_worker((_nmd_x86_parallel_job*)job);
+	return 0;
+}
+
+/* Runs _nmd_x86_parallel_worker() on 'num_threads' threads, including the calling thread. If a thread can't be created its work is done by the other threads. */
+NMD_ASSEMBLY_API void _nmd_x86_run_parallel(_nmd_x86_parallel_job* job, size_t num_threads)
+{
+#ifdef _WIN32
+	HANDLE threads[NMD_ASSEMBLY_MAX_THREADS];
+#else
+	pthread_t threads[NMD_ASSEMBLY_MAX_THREADS];
+#endif /* _WIN32 */
+	size_t i, num_created = 0;
+
+	job->next_chunk = 0;
+	for (i = 1; i < num_threads; i++, num_created++)
+	{
+#ifdef _WIN32
+		if (!(threads[num_created] = CreateThread(0, 0, _nmd_x86_thread_proc, job, 0, 0)))
+			break;
+#else
+		if (pthread_create(&threads[num_created], 0, _nmd_x86_thread_proc, job))
+			break;
+#endif /* _WIN32 */
+	}
+
+	_nmd_x86_parallel_worker(job);
+
+	for (i = 0; i < num_created; i++)
+	{
+#ifdef _WIN32
+		WaitForSingleObject(threads[i], INFINITE);
+		CloseHandle(threads[i]);
+#else
+		pthread_join(threads[i], 0);
+#endif /* _WIN32 */
+	}
+}
+
+/* Splits the buffer in chunks, finds the instruction boundaries of every chunk in parallel, resynchronizes the boundaries at the seams and optionally decodes the instructions in parallel. */
+NMD_ASSEMBLY_API size_t _nmd_x86_parallel(_nmd_x86_parallel_job* job, size_t num_threads)
+{
+	size_t i, num_valid = 0;
+
+	if (num_threads == 0)
+		num_threads = 1;
+	else if (num_threads > NMD_ASSEMBLY_MAX_THREADS)
+		num_threads = NMD_ASSEMBLY_MAX_THREADS;
+
+	job->chunk_size = _NMD_MAX((job->buffer_size + num_threads * _NMD_X86_CHUNKS_PER_THREAD - 1) / (num_threads * _NMD_X86_CHUNKS_PER_THREAD), _NMD_X86_MIN_CHUNK_SIZE);
+	job->num_chunks = (job->buffer_size + job->chunk_size - 1) / job->chunk_size;
+	if (job->num_chunks == 0)
+		return 0;
+
+	num_threads = _NMD_MIN(num_threads, job->num_chunks);
+
+	/* Each chunk is decoded as if an instruction started at its first byte */
+	job->decode_pass = false;
+	_nmd_x86_run_parallel(job, num_threads);
+
+	/* The stream of a chunk usually converges with the stream of the previous chunk after a few instructions, so this is cheap */
+	for (i = 1; i < job->num_chunks; i++)
+		_nmd_x86_resync_chunk(job, i);
+
+	for (i = 0; i < job->num_chunks; i++)
+	{
+		job->chunks[i].first_instruction = num_valid;
+		num_valid += job->chunks[i].count;
+	}
+
+	if (job->instructions && job->num_instructions)
+	{
+		job->decode_pass = true;
+		_nmd_x86_run_parallel(job, num_threads);
+	}
+
+	return num_valid;
+}
+
+/*
+Computes the instruction boundaries of a buffer using multiple threads. The result is the same as a linear sweep that starts at the first byte and skips invalid instructions one byte at a time.
+Returns the number of valid instructions.
+Parameters:
+ - buffer      [in]  A pointer to a buffer containing encoded instructions.
+ - buffer_size [in]  The buffer's size in bytes.
+ - mode        [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - lengths     [out] A pointer to an array of 'buffer_size' elements. 'lengths[i]' receives the length of the instruction at offset 'i' if one starts there, zero otherwise.
+                     Walk the array with 'i += lengths[i] ? lengths[i] : 1': a zero at a visited offset is an invalid byte.
+ - num_threads [in]  The number of threads to use, including the calling thread. It's clamped to 'NMD_ASSEMBLY_MAX_THREADS'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_ldisasm_parallel(const void* buffer, size_t buffer_size, NMD_X86_MODE mode, uint8_t* lengths, size_t num_threads)
+{
+	_nmd_x86_parallel_job job;
+	job.buffer = (const uint8_t*)buffer;
+	job.buffer_size = buffer_size;
+	job.mode = mode;
+	job.flags = 0;
+	job.lengths = lengths;
+	job.instructions = 0;
+	job.num_instructions = 0;
+
+	return _nmd_x86_parallel(&job, num_threads);
+}
+
+/*
+Decodes every instruction of a buffer using multiple threads. The boundaries are computed the same way nmd_x86_ldisasm_parallel() does, but using the decoder's lengths.
+The instructions are written in address order. Returns the number of valid instructions, which may be greater than 'num_instructions'.
+Parameters:
+ - buffer           [in]  A pointer to a buffer containing encoded instructions.
+ - buffer_size      [in]  The buffer's size in bytes.
+ - mode             [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags            [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+ - lengths          [out] A pointer to an array of 'buffer_size' elements that receives the instruction boundaries. See nmd_x86_ldisasm_parallel().
+ - instructions     [out] A pointer to an array of 'nmd_x86_instruction' that receives the decoded instructions.
+ - num_instructions [in]  The number of elements in 'instructions'.
+ - num_threads      [in]  The number of threads to use, including the calling thread. It's clamped to 'NMD_ASSEMBLY_MAX_THREADS'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_decode_parallel(const void* buffer, size_t buffer_size, NMD_X86_MODE mode, uint32_t flags, uint8_t* lengths, nmd_x86_instruction* instructions, size_t num_instructions, size_t num_threads)
+{
+	_nmd_x86_parallel_job job;
+	job.buffer = (const uint8_t*)buffer;
+	job.buffer_size = buffer_size;
+	job.mode = mode;
+	job.flags = flags;
+	job.lengths = lengths;
+	job.instructions = instructions;
+	job.num_instructions = num_instructions;
+
+	return _nmd_x86_parallel(&job, num_threads);
+}
+
+#endif /* NMD_ASSEMBLY_ENABLE_THREADS */
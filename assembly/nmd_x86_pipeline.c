@@ -0,0 +1,555 @@
+#include "nmd_common.h"
+
+#ifdef NMD_ASSEMBLY_ENABLE_THREADS
+
+#ifdef _WIN32
+#define _NMD_MEMORY_BARRIER() MemoryBarrier()
+#define _NMD_YIELD() SwitchToThread()
+#else
+#define _NMD_MEMORY_BARRIER() __sync_synchronize()
+#define _NMD_YIELD() sched_yield()
+#endif /* _WIN32 */
+
+/* The indices of a ring are in different cache lines, so the producer and the consumer don't invalidate each other's line on every update. */
+#define _NMD_X86_CACHE_LINE_SIZE 64
+
+/* The maximum number of items a stage processes before it publishes them to the next stage. */
+#define _NMD_X86_PIPELINE_BATCH_SIZE 64
+
+enum _NMD_X86_PIPELINE_STAGE
+{
+	_NMD_X86_PIPELINE_STAGE_LDISASM = 0, /* Splits the blocks of code in instructions using nmd_x86_ldisasm(). */
+	_NMD_X86_PIPELINE_STAGE_DECODE,      /* Decodes the instructions using the decoder. */
+	_NMD_X86_PIPELINE_STAGE_FORMAT,      /* Formats the instructions using the formatter. */
+	_NMD_X86_PIPELINE_NUM_STAGES
+};
+
+/* A single-producer/single-consumer lock-free ring buffer. 'head' is only written by the producer and 'tail' is only written by the consumer. */
+typedef struct _nmd_x86_ring
+{
+	volatile size_t head; /* The number of items written by the producer. */
+	uint8_t padding0[_NMD_X86_CACHE_LINE_SIZE - sizeof(size_t)];
+	volatile size_t tail; /* The number of items read by the consumer. */
+	uint8_t padding1[_NMD_X86_CACHE_LINE_SIZE - sizeof(size_t)];
+	uint8_t* items;
+	size_t item_size;
+	size_t mask; /* The ring's capacity minus one. The capacity is a power of two. */
+} _nmd_x86_ring;
+
+/* A block of code pushed by nmd_x86_pipeline_push(). */
+typedef struct _nmd_x86_pipeline_block
+{
+	uint64_t runtime_address;
+	uint32_t size;
+	uint32_t continued; /* Non-zero if the block continues the instruction stream of the previous block. */
+	uint8_t bytes[NMD_X86_PIPELINE_BLOCK_SIZE];
+} _nmd_x86_pipeline_block;
+
+/* An instruction found by the ldisasm stage. */
+typedef struct _nmd_x86_pipeline_bytes
+{
+	uint64_t runtime_address;
+	uint8_t length;
+	uint8_t bytes[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH];
+} _nmd_x86_pipeline_bytes;
+
+/* An instruction decoded by the decode stage. */
+typedef struct _nmd_x86_pipeline_instruction
+{
+	uint64_t runtime_address;
+	nmd_x86_instruction instruction;
+} _nmd_x86_pipeline_instruction;
+
+typedef struct _nmd_x86_pipeline_state
+{
+	_nmd_x86_ring rings[_NMD_X86_PIPELINE_NUM_STAGES + 1]; /* rings[i] is the input of stage 'i', the last ring holds the formatted lines. */
+	volatile long done[_NMD_X86_PIPELINE_NUM_STAGES];      /* done[i] is non-zero after stage 'i' processed every item and exited. */
+	volatile long closed;                                  /* Non-zero after nmd_x86_pipeline_close(). */
+	volatile long abort;                                   /* Non-zero after nmd_x86_pipeline_stop(), the stages exit as soon as possible. */
+	NMD_X86_MODE mode;
+	uint32_t decoder_flags;
+	uint32_t format_flags;
+	uint64_t next_address; /* The address after the last block pushed. Only used by the producer. */
+	size_t num_threads;
+#ifdef _WIN32
+	HANDLE threads[_NMD_X86_PIPELINE_NUM_STAGES];
+#else
+	pthread_t threads[_NMD_X86_PIPELINE_NUM_STAGES];
+#endif /* _WIN32 */
+} _nmd_x86_pipeline_state;
+
+typedef struct _nmd_x86_pipeline_stage
+{
+	_nmd_x86_pipeline_state* state;
+	size_t index;
+} _nmd_x86_pipeline_stage;
+
+/* Returns a pointer to the item 'index' of 'ring'. */
+NMD_ASSEMBLY_API void* _nmd_x86_ring_item(const _nmd_x86_ring* ring, size_t index)
+{
+	return ring->items + (index & ring->mask) * ring->item_size;
+}
+
+/* Returns the number of items the consumer can read. The items' contents are visible after the call. */
+NMD_ASSEMBLY_API size_t _nmd_x86_ring_num_items(const _nmd_x86_ring* ring)
+{
+	const size_t num_items = ring->head - ring->tail;
+	_NMD_MEMORY_BARRIER();
+	return num_items;
+}
+
+/* Makes the items in ['ring->head', 'head') visible to the consumer. */
+NMD_ASSEMBLY_API void _nmd_x86_ring_publish(_nmd_x86_ring* ring, size_t head)
+{
+	_NMD_MEMORY_BARRIER();
+	ring->head = head;
+}
+
+/* Releases the items in ['ring->tail', 'tail') to the producer. */
+NMD_ASSEMBLY_API void _nmd_x86_ring_release(_nmd_x86_ring* ring, size_t tail)
+{
+	_NMD_MEMORY_BARRIER();
+	ring->tail = tail;
+}
+
+/* Waits until the item 'head' of 'ring' can be written by the producer, publishing the items before it while waiting. Returns false if the pipeline was stopped. */
+NMD_ASSEMBLY_API bool _nmd_x86_ring_wait(_nmd_x86_pipeline_state* state, _nmd_x86_ring* ring, size_t head)
+{
+	if (head - ring->tail <= ring->mask)
+		return true;
+
+	_nmd_x86_ring_publish(ring, head);
+	while (head - ring->tail > ring->mask)
+	{
+		if (state->abort)
+			return false;
+		_NMD_YIELD();
+	}
+	_NMD_MEMORY_BARRIER();
+
+	return true;
+}
+
+/*
+Waits until stage 'index' has items to process. Returns the number of items, or zero if the previous stage(or the producer) finished and every item was processed.
+'done' is read before the ring, so no item published before the previous stage finished is missed.
+*/
+NMD_ASSEMBLY_API size_t _nmd_x86_pipeline_wait(_nmd_x86_pipeline_state* state, size_t index)
+{
+	for (;;)
+	{
+		const bool finished = index ? state->done[index - 1] != 0 : state->closed != 0;
+		size_t num_items;
+		_NMD_MEMORY_BARRIER();
+
+		if (state->abort)
+			return 0;
+		if ((num_items = _nmd_x86_ring_num_items(&state->rings[index])))
+			return num_items;
+		if (finished)
+			return 0;
+
+		_NMD_YIELD();
+	}
+}
+
+/* Writes the instruction at 'runtime_address' to the item 'head' of the decode stage's ring. Returns false if the pipeline was stopped. */
+NMD_ASSEMBLY_API bool _nmd_x86_pipeline_emit(_nmd_x86_pipeline_state* state, size_t head, uint64_t runtime_address, const uint8_t* bytes, size_t length)
+{
+	_nmd_x86_ring* const ring = &state->rings[_NMD_X86_PIPELINE_STAGE_DECODE];
+	_nmd_x86_pipeline_bytes* item;
+	size_t i;
+
+	if (!_nmd_x86_ring_wait(state, ring, head))
+		return false;
+
+	item = (_nmd_x86_pipeline_bytes*)_nmd_x86_ring_item(ring, head);
+	item->runtime_address = runtime_address;
+	item->length = (uint8_t)length;
+	for (i = 0; i < length; i++)
+		item->bytes[i] = bytes[i];
+
+	return true;
+}
+
+/* Returns 'runtime_address + offset', or 'NMD_X86_INVALID_RUNTIME_ADDRESS' if 'runtime_address' is invalid. */
+NMD_ASSEMBLY_API uint64_t _nmd_x86_pipeline_address(uint64_t runtime_address, size_t offset)
+{
+	return runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? NMD_X86_INVALID_RUNTIME_ADDRESS : runtime_address + offset;
+}
+
+/*
+Splits the blocks of code in instructions. An instruction may continue in the next block: if nmd_x86_ldisasm() fails less than 15 bytes before the end of a
+block, the rest of the block is kept and decoded again with the first bytes of the next block. Invalid instructions are skipped one byte at a time.
+*/
+NMD_ASSEMBLY_API void _nmd_x86_pipeline_ldisasm_stage(_nmd_x86_pipeline_state* state)
+{
+	_nmd_x86_ring* const input = &state->rings[_NMD_X86_PIPELINE_STAGE_LDISASM];
+	_nmd_x86_ring* const output = &state->rings[_NMD_X86_PIPELINE_STAGE_DECODE];
+	uint8_t carry[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH * 2]; /* The bytes at the end of the previous block, followed by the first bytes of the current block. */
+	size_t carry_size = 0, head = output->head, tail = input->tail, num_blocks, length, offset, i;
+	uint64_t carry_address = NMD_X86_INVALID_RUNTIME_ADDRESS;
+
+	while ((num_blocks = _nmd_x86_pipeline_wait(state, _NMD_X86_PIPELINE_STAGE_LDISASM)))
+	{
+		for (; num_blocks; num_blocks--, tail++)
+		{
+			const _nmd_x86_pipeline_block* const block = (const _nmd_x86_pipeline_block*)_nmd_x86_ring_item(input, tail);
+			offset = 0;
+
+			/* Decode the kept bytes, with the first bytes of this block if the stream continues here */
+			while (carry_size)
+			{
+				const size_t num_new_bytes = block->continued ? _NMD_MIN((size_t)block->size, sizeof(carry) - carry_size) : 0;
+				if (block->continued && carry_size + num_new_bytes < NMD_X86_MAXIMUM_INSTRUCTION_LENGTH && num_new_bytes == block->size)
+				{
+					/* The block is too small to complete the instruction, keep it as well */
+					for (i = 0; i < num_new_bytes; i++)
+						carry[carry_size++] = block->bytes[i];
+					offset = block->size;
+					break;
+				}
+
+				for (i = 0; i < num_new_bytes; i++)
+					carry[carry_size + i] = block->bytes[i];
+
+				length = nmd_x86_ldisasm(carry, carry_size + num_new_bytes, state->mode);
+				if (length)
+				{
+					if (!_nmd_x86_pipeline_emit(state, head++, carry_address, carry, length))
+						return;
+				}
+				else
+					length = 1;
+
+				if (length >= carry_size)
+				{
+					offset = block->continued ? length - carry_size : 0;
+					carry_size = 0;
+				}
+				else
+				{
+					carry_size -= length;
+					for (i = 0; i < carry_size; i++)
+						carry[i] = carry[i + length];
+					carry_address = _nmd_x86_pipeline_address(carry_address, length);
+				}
+			}
+
+			while (offset < block->size)
+			{
+				const size_t remaining = block->size - offset;
+				if ((length = nmd_x86_ldisasm(block->bytes + offset, remaining, state->mode)))
+				{
+					if (!_nmd_x86_pipeline_emit(state, head++, _nmd_x86_pipeline_address(block->runtime_address, offset), block->bytes + offset, length))
+						return;
+					offset += length;
+				}
+				else if (remaining < NMD_X86_MAXIMUM_INSTRUCTION_LENGTH)
+				{
+					/* The instruction may continue in the next block */
+					for (carry_size = 0; carry_size < remaining; carry_size++)
+						carry[carry_size] = block->bytes[offset + carry_size];
+					carry_address = _nmd_x86_pipeline_address(block->runtime_address, offset);
+					break;
+				}
+				else
+					offset++;
+			}
+		}
+
+		_nmd_x86_ring_release(input, tail);
+		_nmd_x86_ring_publish(output, head);
+	}
+
+	/* No block follows the kept bytes */
+	for (offset = 0; offset < carry_size && !state->abort; offset += length ? length : 1)
+	{
+		if ((length = nmd_x86_ldisasm(carry + offset, carry_size - offset, state->mode)) && !_nmd_x86_pipeline_emit(state, head++, _nmd_x86_pipeline_address(carry_address, offset), carry + offset, length))
+			return;
+	}
+	_nmd_x86_ring_publish(output, head);
+}
+
+/* Decodes the instructions found by the ldisasm stage. Instructions the decoder considers invalid are dropped. */
+NMD_ASSEMBLY_API void _nmd_x86_pipeline_decode_stage(_nmd_x86_pipeline_state* state)
+{
+	_nmd_x86_ring* const input = &state->rings[_NMD_X86_PIPELINE_STAGE_DECODE];
+	_nmd_x86_ring* const output = &state->rings[_NMD_X86_PIPELINE_STAGE_FORMAT];
+	size_t head = output->head, tail = input->tail, num_items;
+
+	while ((num_items = _nmd_x86_pipeline_wait(state, _NMD_X86_PIPELINE_STAGE_DECODE)))
+	{
+		for (num_items = _NMD_MIN(num_items, _NMD_X86_PIPELINE_BATCH_SIZE); num_items; num_items--, tail++)
+		{
+			const _nmd_x86_pipeline_bytes* const bytes = (const _nmd_x86_pipeline_bytes*)_nmd_x86_ring_item(input, tail);
+			_nmd_x86_pipeline_instruction* item;
+
+			if (!_nmd_x86_ring_wait(state, output, head))
+				return;
+
+			item = (_nmd_x86_pipeline_instruction*)_nmd_x86_ring_item(output, head);
+			_nmd_clear_instruction(&item->instruction, state->decoder_flags);
+			if (_nmd_decode_instruction(bytes->bytes, bytes->length, &item->instruction, state->mode, state->decoder_flags & ~NMD_X86_DECODER_FLAGS_ZERO_COPY))
+			{
+				item->runtime_address = bytes->runtime_address;
+				head++;
+			}
+		}
+
+		_nmd_x86_ring_release(input, tail);
+		_nmd_x86_ring_publish(output, head);
+	}
+}
+
+/* Formats the decoded instructions into the output ring. */
+NMD_ASSEMBLY_API void _nmd_x86_pipeline_format_stage(_nmd_x86_pipeline_state* state)
+{
+	_nmd_x86_ring* const input = &state->rings[_NMD_X86_PIPELINE_STAGE_FORMAT];
+	_nmd_x86_ring* const output = &state->rings[_NMD_X86_PIPELINE_NUM_STAGES];
+	size_t head = output->head, tail = input->tail, num_items;
+
+	while ((num_items = _nmd_x86_pipeline_wait(state, _NMD_X86_PIPELINE_STAGE_FORMAT)))
+	{
+		for (num_items = _NMD_MIN(num_items, _NMD_X86_PIPELINE_BATCH_SIZE); num_items; num_items--, tail++)
+		{
+			const _nmd_x86_pipeline_instruction* const item = (const _nmd_x86_pipeline_instruction*)_nmd_x86_ring_item(input, tail);
+			nmd_x86_pipeline_line* line;
+
+			if (!_nmd_x86_ring_wait(state, output, head))
+				return;
+
+			line = (nmd_x86_pipeline_line*)_nmd_x86_ring_item(output, head++);
+			line->runtime_address = item->runtime_address;
+			line->length = _nmd_x86_format(&item->instruction, line->string, item->runtime_address, state->format_flags);
+		}
+
+		_nmd_x86_ring_release(input, tail);
+		_nmd_x86_ring_publish(output, head);
+	}
+}
+
+#ifdef _WIN32
+NMD_ASSEMBLY_API DWORD WINAPI _nmd_x86_pipeline_thread_proc(LPVOID parameter)
+#else
+NMD_ASSEMBLY_API void* _nmd_x86_pipeline_thread_proc(void* parameter)
+#endif /* _WIN32 */
+{
+	_nmd_x86_pipeline_stage* const stage = (_nmd_x86_pipeline_stage*)parameter;
+	_nmd_x86_pipeline_state* const state = stage->state;
+	const size_t index = stage->index;
+
+	if (index == _NMD_X86_PIPELINE_STAGE_LDISASM)
+		_nmd_x86_pipeline_ldisasm_stage(state);
+	else if (index == _NMD_X86_PIPELINE_STAGE_DECODE)
+		_nmd_x86_pipeline_decode_stage(state);
+	else
+		_nmd_x86_pipeline_format_stage(state);
+
+	_NMD_MEMORY_BARRIER();
+	state->done[index] = 1;
+
+	return 0;
+}
+
+/* Returns the size in bytes of the items of each ring, rounded up to 8 bytes. */
+NMD_ASSEMBLY_API size_t _nmd_x86_pipeline_item_size(size_t ring)
+{
+	const size_t sizes[_NMD_X86_PIPELINE_NUM_STAGES + 1] = { sizeof(_nmd_x86_pipeline_block), sizeof(_nmd_x86_pipeline_bytes), sizeof(_nmd_x86_pipeline_instruction), sizeof(nmd_x86_pipeline_line) };
+	return (sizes[ring] + 7) & ~(size_t)7;
+}
+
+/*
+Starts a pipeline that splits blocks of code in instructions, decodes them and formats them on three threads(one per stage). The stages are connected by
+single-producer/single-consumer lock-free ring buffers stored in a memory block provided by the caller, no memory is allocated.
+Returns the capacity of each ring in items(a power of two), or zero if the block is too small for rings of 16 items or a thread can't be created.
+Use 'NMD_X86_PIPELINE_MEMORY_SIZE()' to compute the block's size. Idle stages yield their time slice, call nmd_x86_pipeline_stop() when the pipeline is not needed anymore.
+Parameters:
+ - pipeline      [out] A pointer to a variable of type 'nmd_x86_pipeline'.
+ - mode          [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - decoder_flags [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+ - format_flags  [in]  A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the instructions are formatted.
+ - memory        [in]  A pointer to the memory block. It must stay valid until nmd_x86_pipeline_stop() returns.
+ - memory_size   [in]  The size of the memory block in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_pipeline_start(nmd_x86_pipeline* pipeline, NMD_X86_MODE mode, uint32_t decoder_flags, uint32_t format_flags, void* memory, size_t memory_size)
+{
+	const size_t padding = (_NMD_X86_CACHE_LINE_SIZE - ((size_t)memory & (_NMD_X86_CACHE_LINE_SIZE - 1))) & (_NMD_X86_CACHE_LINE_SIZE - 1);
+	const size_t header_size = (sizeof(_nmd_x86_pipeline_state) + sizeof(_nmd_x86_pipeline_stage) * _NMD_X86_PIPELINE_NUM_STAGES + _NMD_X86_CACHE_LINE_SIZE - 1) & ~(size_t)(_NMD_X86_CACHE_LINE_SIZE - 1);
+	size_t capacity = 16, items_size = 0, i;
+	_nmd_x86_pipeline_state* state;
+	_nmd_x86_pipeline_stage* stages;
+	uint8_t* items;
+
+	pipeline->state = 0;
+	pipeline->capacity = 0;
+
+	for (i = 0; i <= _NMD_X86_PIPELINE_NUM_STAGES; i++)
+		items_size += _nmd_x86_pipeline_item_size(i);
+
+	if (memory_size < padding + header_size || (memory_size - padding - header_size) / items_size < capacity)
+		return 0;
+	while (capacity * 2 <= (memory_size - padding - header_size) / items_size)
+		capacity *= 2;
+
+	state = (_nmd_x86_pipeline_state*)((uint8_t*)memory + padding);
+	stages = (_nmd_x86_pipeline_stage*)(state + 1);
+	items = (uint8_t*)state + header_size;
+	for (i = 0; i <= _NMD_X86_PIPELINE_NUM_STAGES; i++)
+	{
+		state->rings[i].head = state->rings[i].tail = 0;
+		state->rings[i].items = items;
+		state->rings[i].item_size = _nmd_x86_pipeline_item_size(i);
+		state->rings[i].mask = capacity - 1;
+		items += capacity * state->rings[i].item_size;
+	}
+
+	for (i = 0; i < _NMD_X86_PIPELINE_NUM_STAGES; i++)
+		state->done[i] = 0;
+	state->closed = 0;
+	state->abort = 0;
+	state->mode = mode;
+	state->decoder_flags = decoder_flags;
+	state->format_flags = format_flags;
+	state->next_address = NMD_X86_INVALID_RUNTIME_ADDRESS;
+	_NMD_MEMORY_BARRIER();
+
+	for (state->num_threads = 0; state->num_threads < _NMD_X86_PIPELINE_NUM_STAGES; state->num_threads++)
+	{
+		_nmd_x86_pipeline_stage* const stage = &stages[state->num_threads];
+		stage->state = state;
+		stage->index = state->num_threads;
+#ifdef _WIN32
+		if (!(state->threads[state->num_threads] = CreateThread(0, 0, _nmd_x86_pipeline_thread_proc, stage, 0, 0)))
+			break;
+#else
+		if (pthread_create(&state->threads[state->num_threads], 0, _nmd_x86_pipeline_thread_proc, stage))
+			break;
+#endif /* _WIN32 */
+	}
+
+	pipeline->state = state;
+	if (state->num_threads < _NMD_X86_PIPELINE_NUM_STAGES)
+	{
+		nmd_x86_pipeline_stop(pipeline);
+		return 0;
+	}
+
+	return pipeline->capacity = capacity;
+}
+
+/*
+Queues a block of code. Returns the number of bytes queued, which is less than 'buffer_size' if the input ring is full. The bytes are copied, so 'buffer'
+can be reused after the call. Blocks whose runtime addresses are contiguous form a single instruction stream, so an instruction may be split between them.
+This function must not be called by more than one thread at a time.
+Parameters:
+ - pipeline        [in] A pointer to a pipeline started by nmd_x86_pipeline_start().
+ - buffer          [in] A pointer to a buffer containing encoded instructions.
+ - buffer_size     [in] The buffer's size in bytes.
+ - runtime_address [in] The runtime address of the buffer's first byte. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_pipeline_push(nmd_x86_pipeline* pipeline, const void* buffer, size_t buffer_size, uint64_t runtime_address)
+{
+	_nmd_x86_pipeline_state* const state = (_nmd_x86_pipeline_state*)pipeline->state;
+	_nmd_x86_ring* const ring = &state->rings[_NMD_X86_PIPELINE_STAGE_LDISASM];
+	const uint8_t* b = (const uint8_t*)buffer;
+	size_t head = ring->head, offset = 0, i;
+
+	if (state->closed)
+		return 0;
+
+	while (offset < buffer_size && head - ring->tail <= ring->mask)
+	{
+		_nmd_x86_pipeline_block* const block = (_nmd_x86_pipeline_block*)_nmd_x86_ring_item(ring, head++);
+		const uint64_t address = _nmd_x86_pipeline_address(runtime_address, offset);
+
+		block->runtime_address = address;
+		block->size = (uint32_t)_NMD_MIN(buffer_size - offset, NMD_X86_PIPELINE_BLOCK_SIZE);
+		block->continued = offset || (address != NMD_X86_INVALID_RUNTIME_ADDRESS && address == state->next_address);
+		for (i = 0; i < block->size; i++)
+			block->bytes[i] = b[offset + i];
+
+		offset += block->size;
+		state->next_address = _nmd_x86_pipeline_address(address, block->size);
+	}
+
+	_nmd_x86_ring_publish(ring, head);
+
+	return offset;
+}
+
+/*
+Copies up to 'num_lines' formatted instructions to 'lines' in the order they were pushed. Returns the number of lines copied, which is zero if no line is ready.
+Invalid instructions are skipped one byte at a time, so they produce no lines. This function must not be called by more than one thread at a time.
+Parameters:
+ - pipeline  [in]  A pointer to a pipeline started by nmd_x86_pipeline_start().
+ - lines     [out] A pointer to an array of 'nmd_x86_pipeline_line' that receives the lines.
+ - num_lines [in]  The number of elements in 'lines'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_pipeline_pop(nmd_x86_pipeline* pipeline, nmd_x86_pipeline_line* lines, size_t num_lines)
+{
+	_nmd_x86_pipeline_state* const state = (_nmd_x86_pipeline_state*)pipeline->state;
+	_nmd_x86_ring* const ring = &state->rings[_NMD_X86_PIPELINE_NUM_STAGES];
+	const size_t num_items = _nmd_x86_ring_num_items(ring);
+	const size_t num_popped = _NMD_MIN(num_items, num_lines);
+	size_t tail = ring->tail, i, j;
+
+	for (i = 0; i < num_popped; i++, tail++)
+	{
+		const nmd_x86_pipeline_line* const line = (const nmd_x86_pipeline_line*)_nmd_x86_ring_item(ring, tail);
+		lines[i].runtime_address = line->runtime_address;
+		lines[i].length = line->length;
+		for (j = 0; j <= line->length; j++)
+			lines[i].string[j] = line->string[j];
+	}
+
+	_nmd_x86_ring_release(ring, tail);
+
+	return num_popped;
+}
+
+/* Marks the end of the input. The stages process the queued bytes and exit, nmd_x86_pipeline_finished() returns true after the last line was popped. */
+NMD_ASSEMBLY_API void nmd_x86_pipeline_close(nmd_x86_pipeline* pipeline)
+{
+	_nmd_x86_pipeline_state* const state = (_nmd_x86_pipeline_state*)pipeline->state;
+	_NMD_MEMORY_BARRIER();
+	state->closed = 1;
+}
+
+/* Returns true if the pipeline was closed, every stage exited and every line was popped. */
+NMD_ASSEMBLY_API bool nmd_x86_pipeline_finished(nmd_x86_pipeline* pipeline)
+{
+	_nmd_x86_pipeline_state* const state = (_nmd_x86_pipeline_state*)pipeline->state;
+	const bool done = state->done[_NMD_X86_PIPELINE_NUM_STAGES - 1] != 0;
+	_NMD_MEMORY_BARRIER();
+	return done && !_nmd_x86_ring_num_items(&state->rings[_NMD_X86_PIPELINE_NUM_STAGES]);
+}
+
+/* Stops the pipeline and waits for its threads to exit. The queued bytes and lines that were not popped are discarded. The memory block can be reused after the call. */
+NMD_ASSEMBLY_API void nmd_x86_pipeline_stop(nmd_x86_pipeline* pipeline)
+{
+	_nmd_x86_pipeline_state* const state = (_nmd_x86_pipeline_state*)pipeline->state;
+	size_t i;
+
+	if (!state)
+		return;
+
+	state->closed = 1;
+	state->abort = 1;
+	_NMD_MEMORY_BARRIER();
+
+	for (i = 0; i < state->num_threads; i++)
+	{
+#ifdef _WIN32
+		WaitForSingleObject(state->threads[i], INFINITE);
+		CloseHandle(state->threads[i]);
+#else
+		pthread_join(state->threads[i], 0);
+#endif /* _WIN32 */
+	}
+
+	pipeline->state = 0;
+	pipeline->capacity = 0;
+}
+
+#endif /* NMD_ASSEMBLY_ENABLE_THREADS */
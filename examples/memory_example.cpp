@@ -0,0 +1,35 @@
+#define NMD_MEMORY_IMPLEMENTATION
+#include "../platform_specific/nmd_memory.h"
+#include <stdio.h>
+
+typedef int(__stdcall* message_box_w)(HWND, LPCWSTR, LPCWSTR, UINT);
+message_box_w original_message_box_w;
+
+int __stdcall message_box_w_detour(HWND h_wnd, LPCWSTR text, LPCWSTR caption, UINT type)
+{
+	return original_message_box_w(h_wnd, L"Hooked", caption, type);
+}
+
+int main()
+{
+	/* Find the first 'call rel32' followed by 'test eax, eax' in the executable */
+	const HMODULE h_module = GetModuleHandleW(0);
+	uint8_t* const start = (uint8_t*)h_module;
+	uint8_t* const end = start + nmd_get_module_size(h_module);
+	uint8_t* matches[16];
+	nmd_pattern compiled;
+
+	if (!nmd_pattern_compile(&compiled, "\xe8\x00\x00\x00\x00\x85\xc0", "x????xx"))
+		return 1;
+
+	printf("first match: %p\n", (void*)nmd_pattern_scan_range_ex(&compiled, start, end, (uint32_t)-1));
+	printf("number of matches: %u\n", (unsigned)nmd_pattern_scan_process((HANDLE)-1, &compiled, start, end, (uint32_t)-1, 4, matches, 16));
+
+	/* Replace the text of every message box */
+	void* const target = (void*)GetProcAddress(LoadLibraryW(L"user32.dll"), "MessageBoxW");
+	if (!nmd_hook(target, (void*)message_box_w_detour, &original_message_box_w))
+		return 1;
+
+	MessageBoxW(0, L"Not hooked", L"nmd_memory", MB_OK);
+	nmd_unhook(target);
+}
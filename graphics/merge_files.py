@@ -9,6 +9,7 @@ file_names = [
     'stb_truetype.h',
     'nmd_graphics.c',
     'nmd_drawlist.c',
+    'nmd_glyph_cache.c',
     'nmd_gui.c',
     'nmd_renderer_d3d9.cpp',
     'nmd_renderer_d3d11.cpp',
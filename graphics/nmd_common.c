@@ -12,3 +12,10 @@
 #define NMD_CIRCLE_AUTO_SEGMENT_CALC(radius, max_error) NMD_CLAMP(NMD_2PI / NMD_ACOS(((radius) - max_error) / (radius)), NMD_CIRCLE_AUTO_SEGMENT_MIN, NMD_CIRCLE_AUTO_SEGMENT_MAX)
 
 #define _NMD_OFFSETOF(TYPE, NAME) (&((TYPE*)0)->NAME)
+
+/* Used by stb_truetype */
+void* _nmd_alloc(size_t size);
+void _nmd_free(void* ptr);
+
+/* Used by nmd_destroy_context() */
+void _nmd_id_map_free(nmd_id_map* map);
@@ -17,7 +17,27 @@
 
 #define _NMD_OFFSETOF(TYPE, NAME) (&((TYPE*)0)->NAME)
 
-extern nmd_context _nmd_context;
+extern NMD_THREAD_LOCAL nmd_context* _nmd_context;
+
+void* _nmd_alloc(size_t size);
+void _nmd_free(void* ptr);
+
+void* _nmd_frame_alloc(size_t size);
+void* _nmd_frame_realloc(void* ptr, size_t size, size_t new_size);
+void _nmd_frame_release(void* ptr, size_t size);
+
+bool _nmd_split_draw_command();
+bool _nmd_reserve(size_t num_new_vertices, size_t num_new_indices);
+bool _nmd_reserve_draw_commands(size_t num_new_draw_commands);
+
+void _nmd_id_map_free(nmd_id_map* map);
+
+void _nmd_profile(const char* zone, bool begin);
+
+uint32_t _nmd_begin_render_state();
+void _nmd_end_render_state(uint32_t restored, bool known_host_state);
+bool _nmd_render_state_texture_changed(nmd_tex_id texture);
+bool _nmd_render_state_scissor_changed(const nmd_rect* clip_rect);
 extern const uint8_t nmd_karla_ttf_regular[14824];
 
 #endif /* NMD_COMMON_H */
\ No newline at end of file
@@ -2,34 +2,37 @@
 
 bool _nmd_reserve(size_t num_new_vertices, size_t num_new_indices)
 {
+    /* Indices are relative to the base vertex of the draw command, so a new one is started when they would not fit in 'nmd_index' */
+    if (_nmd_context->draw_list.num_vertices + num_new_vertices - _nmd_context->draw_list.vertex_offset > ((size_t)1 << (8 * sizeof(nmd_index))) && _nmd_context->draw_list.num_vertices > _nmd_context->draw_list.vertex_offset)
+    {
+        if (!_nmd_split_draw_command())
+            return false;
+    }
+
     /* Check vertices */
-    size_t future_size = (_nmd_context.draw_list.num_vertices + num_new_vertices) * sizeof(nmd_vertex);
-    if (future_size > _nmd_context.draw_list.vertices_capacity)
+    size_t future_size = (_nmd_context->draw_list.num_vertices + num_new_vertices) * sizeof(nmd_vertex);
+    if (future_size > _nmd_context->draw_list.vertices_capacity)
     {
-        const size_t new_capacity = NMD_MAX(_nmd_context.draw_list.vertices_capacity * 2, future_size);
-        void* mem = NMD_MALLOC(new_capacity);
+        const size_t new_capacity = NMD_MAX(_nmd_context->draw_list.vertices_capacity * 2, future_size);
+        void* mem = _nmd_frame_realloc(_nmd_context->draw_list.vertices, _nmd_context->draw_list.vertices_capacity, new_capacity);
         if (!mem)
             return false;
-        NMD_MEMCPY(mem, _nmd_context.draw_list.vertices, _nmd_context.draw_list.vertices_capacity);
-        NMD_FREE(_nmd_context.draw_list.vertices);
 
-        _nmd_context.draw_list.vertices = (nmd_vertex*)mem;
-        _nmd_context.draw_list.vertices_capacity = new_capacity;
+        _nmd_context->draw_list.vertices = (nmd_vertex*)mem;
+        _nmd_context->draw_list.vertices_capacity = new_capacity;
     }
 
     /* Check indices */
-    future_size = (_nmd_context.draw_list.num_indices + num_new_indices) * sizeof(nmd_index);
-    if (future_size > _nmd_context.draw_list.indices_capacity)
+    future_size = (_nmd_context->draw_list.num_indices + num_new_indices) * sizeof(nmd_index);
+    if (future_size > _nmd_context->draw_list.indices_capacity)
     {
-        const size_t new_capacity = NMD_MAX(_nmd_context.draw_list.indices_capacity * 2, future_size);
-        void* mem = NMD_MALLOC(new_capacity);
+        const size_t new_capacity = NMD_MAX(_nmd_context->draw_list.indices_capacity * 2, future_size);
+        void* mem = _nmd_frame_realloc(_nmd_context->draw_list.indices, _nmd_context->draw_list.indices_capacity, new_capacity);
         if (!mem)
             return false;
-        NMD_MEMCPY(mem, _nmd_context.draw_list.indices, _nmd_context.draw_list.indices_capacity);
-        NMD_FREE(_nmd_context.draw_list.indices);
 
-        _nmd_context.draw_list.indices = (nmd_index*)mem;
-        _nmd_context.draw_list.indices_capacity = new_capacity;
+        _nmd_context->draw_list.indices = (nmd_index*)mem;
+        _nmd_context->draw_list.indices_capacity = new_capacity;
     }
 
     return true;
@@ -37,26 +40,468 @@ bool _nmd_reserve(size_t num_new_vertices, size_t num_new_indices)
 
 bool _nmd_reserve_points(size_t num_new_points)
 {
-    const size_t future_size = (_nmd_context.draw_list.num_points + num_new_points) * sizeof(nmd_vec2);
-    if (future_size > _nmd_context.draw_list.path_capacity)
+    const size_t future_size = (_nmd_context->draw_list.num_points + num_new_points) * sizeof(nmd_vec2);
+    if (future_size > _nmd_context->draw_list.path_capacity)
     {
-        const size_t new_capacity = NMD_MAX(_nmd_context.draw_list.path_capacity * 2, future_size);
-        void* mem = NMD_MALLOC(new_capacity);
+        const size_t new_capacity = NMD_MAX(_nmd_context->draw_list.path_capacity * 2, future_size);
+        void* mem = _nmd_frame_realloc(_nmd_context->draw_list.path, _nmd_context->draw_list.path_capacity, new_capacity);
         if (!mem)
             return false;
-        NMD_MEMCPY(mem, _nmd_context.draw_list.path, _nmd_context.draw_list.path_capacity);
-        NMD_FREE(_nmd_context.draw_list.path);
 
-        _nmd_context.draw_list.path = (nmd_vec2*)mem;
-        _nmd_context.draw_list.path_capacity = new_capacity;
+        _nmd_context->draw_list.path = (nmd_vec2*)mem;
+        _nmd_context->draw_list.path_capacity = new_capacity;
+    }
+
+    return true;
+}
+
+/*
+Appends geometry to the draw list of the current context. The unaccounted vertices and indices are pushed first like nmd_push_draw_command(0) does.
+The appended draw commands keep their base vertices(moved by the number of vertices in the draw list), so the indices are copied as they are.
+The vertices and clip rects are translated by('x', 'y'). The draw commands that use 'blank_tex_id' use the blank texture of the draw list.
+*/
+bool _nmd_append_geometry(const nmd_vertex* vertices, size_t num_vertices, const nmd_index* indices, size_t num_indices, const nmd_draw_command* draw_commands, size_t num_draw_commands, nmd_tex_id blank_tex_id, float x, float y)
+{
+    nmd_drawlist* const dst = &_nmd_context->draw_list;
+    const bool translate = x != 0.0f || y != 0.0f;
+
+    nmd_push_draw_command(0);
+
+    dst->vertex_offset = dst->num_vertices;
+    if (!_nmd_reserve(num_vertices, num_indices) || !_nmd_reserve_draw_commands(num_draw_commands))
+        return false;
+
+    if (translate)
+    {
+        nmd_vertex* vertex = dst->vertices + dst->num_vertices;
+        for (size_t i = 0; i < num_vertices; i++, vertex++)
+        {
+            *vertex = vertices[i];
+            vertex->pos.x += x;
+            vertex->pos.y += y;
+        }
+    }
+    else
+        NMD_MEMCPY(dst->vertices + dst->num_vertices, vertices, num_vertices * sizeof(nmd_vertex));
+    NMD_MEMCPY(dst->indices + dst->num_indices, indices, num_indices * sizeof(nmd_index));
+
+    for (size_t i = 0; i < num_draw_commands; i++)
+    {
+        nmd_draw_command* command = &dst->draw_commands[dst->num_draw_commands++];
+        *command = draw_commands[i];
+        command->vertex_offset += dst->num_vertices;
+        if (command->user_texture_id == blank_tex_id)
+            command->user_texture_id = dst->blank_tex_id;
+        if (translate && command->rect.p1.x != -1.0f)
+        {
+            command->rect.p0.x += x, command->rect.p0.y += y;
+            command->rect.p1.x += x, command->rect.p1.y += y;
+        }
+    }
+
+    dst->num_vertices += num_vertices;
+    dst->num_indices += num_indices;
+    dst->num_accounted_vertices = dst->num_vertices;
+    dst->num_accounted_indices = dst->num_indices;
+    dst->vertex_offset = dst->num_vertices;
+
+    return true;
+}
+
+/*
+Appends the draw commands, vertices and indices of 'draw_list' to the draw list of the current context, so draw lists recorded by other contexts(e.g. on worker threads)
+are rendered by one render call. The geometry of 'draw_list' must be in draw commands(nmd_end_frame() was called) and it must not be modified while it's appended.
+The unaccounted vertices and indices of the current draw list are pushed first like nmd_push_draw_command(0) does. The draw commands that use the blank texture
+of 'draw_list' use the blank texture of the current draw list. Returns false if memory could not be allocated.
+*/
+bool nmd_append_draw_list(const nmd_drawlist* draw_list)
+{
+    if (draw_list == &_nmd_context->draw_list)
+        return false;
+
+    /* The draw commands whose texture was not set by a push are not appended */
+    return _nmd_append_geometry(draw_list->vertices, draw_list->num_accounted_vertices, draw_list->indices, draw_list->num_accounted_indices,
+        draw_list->draw_commands, draw_list->num_draw_commands - draw_list->num_pending_draw_commands, draw_list->blank_tex_id, 0.0f, 0.0f);
+}
+
+/* Returns the retained geometry recorded under 'key', or a null pointer if there's none. */
+nmd_retained_geometry* _nmd_find_retained(uint32_t key)
+{
+    for (size_t i = 0; i < _nmd_context->retained.num_entries; i++)
+    {
+        if (_nmd_context->retained.entries[i].key == key)
+            return &_nmd_context->retained.entries[i];
     }
 
+    return 0;
+}
+
+/*
+If geometry was recorded under 'key' and it was not invalidated, it's appended to the draw list and false is returned. Otherwise the geometry added until
+nmd_end_retained() is recorded under 'key' and true is returned, so the caller only tessellates it when it changed:
+    if (nmd_begin_retained(key))
+    {
+        nmd_add_rect_filled(...);
+        nmd_add_text(...);
+        nmd_end_retained();
+    }
+The unaccounted vertices and indices are pushed first like nmd_push_draw_command(0) does. Recording can't be nested.
+*/
+bool nmd_begin_retained(uint32_t key)
+{
+    nmd_retained* const retained = &_nmd_context->retained;
+    nmd_retained_geometry* geometry = _nmd_find_retained(key);
+    if (geometry && geometry->valid)
+    {
+        _nmd_append_geometry(geometry->vertices, geometry->num_vertices, geometry->indices, geometry->num_indices, geometry->draw_commands, geometry->num_draw_commands, _nmd_context->draw_list.blank_tex_id, 0.0f, 0.0f);
+        return false;
+    }
+
+    if (retained->recording)
+        return false;
+
+    if (!geometry)
+    {
+        /* Check if we need to resize the buffer */
+        if (retained->num_entries == retained->capacity)
+        {
+            const size_t new_capacity = NMD_MAX(retained->capacity * 2, NMD_RETAINED_BUFFER_INITIAL_SIZE);
+            void* mem = _nmd_alloc(new_capacity * sizeof(nmd_retained_geometry));
+            if (!mem)
+                return false;
+            if (retained->entries)
+                NMD_MEMCPY(mem, retained->entries, retained->num_entries * sizeof(nmd_retained_geometry));
+            _nmd_free(retained->entries);
+
+            retained->entries = (nmd_retained_geometry*)mem;
+            retained->capacity = new_capacity;
+        }
+
+        geometry = &retained->entries[retained->num_entries++];
+        NMD_MEMSET(geometry, 0, sizeof(nmd_retained_geometry));
+        geometry->key = key;
+    }
+
+    /* The recorded draw commands start at a new base vertex, so their indices don't depend on the geometry added before */
+    nmd_push_draw_command(0);
+    _nmd_split_draw_command();
+
+    retained->recording = geometry;
+    retained->first_vertex = _nmd_context->draw_list.num_vertices;
+    retained->first_index = _nmd_context->draw_list.num_indices;
+    retained->first_draw_command = _nmd_context->draw_list.num_draw_commands;
+
     return true;
 }
 
+/* Ends the recording started by nmd_begin_retained(). The unaccounted vertices and indices are pushed like nmd_push_draw_command(0) does. */
+void nmd_end_retained()
+{
+    nmd_retained* const retained = &_nmd_context->retained;
+    nmd_retained_geometry* const geometry = retained->recording;
+    if (!geometry)
+        return;
+
+    retained->recording = 0;
+    nmd_push_draw_command(0);
+
+    const nmd_drawlist* const draw_list = &_nmd_context->draw_list;
+    const size_t num_vertices = draw_list->num_vertices - retained->first_vertex;
+    const size_t num_indices = draw_list->num_indices - retained->first_index;
+    const size_t num_draw_commands = draw_list->num_draw_commands - retained->first_draw_command;
+
+    /* The three arrays share one block, which is reused when the geometry is recorded again */
+    const size_t vertices_size = num_vertices * sizeof(nmd_vertex);
+    const size_t draw_commands_size = num_draw_commands * sizeof(nmd_draw_command);
+    const size_t size = vertices_size + draw_commands_size + num_indices * sizeof(nmd_index);
+    if (size > geometry->block_size)
+    {
+        _nmd_free(geometry->block);
+        geometry->block = _nmd_alloc(size);
+        geometry->block_size = geometry->block ? size : 0;
+        if (!geometry->block)
+        {
+            geometry->valid = false;
+            return;
+        }
+    }
+
+    geometry->vertices = (nmd_vertex*)geometry->block;
+    geometry->draw_commands = (nmd_draw_command*)((uint8_t*)geometry->block + vertices_size);
+    geometry->indices = (nmd_index*)((uint8_t*)geometry->block + vertices_size + draw_commands_size);
+    geometry->num_vertices = num_vertices;
+    geometry->num_indices = num_indices;
+    geometry->num_draw_commands = num_draw_commands;
+
+    NMD_MEMCPY(geometry->vertices, draw_list->vertices + retained->first_vertex, vertices_size);
+    NMD_MEMCPY(geometry->indices, draw_list->indices + retained->first_index, num_indices * sizeof(nmd_index));
+    NMD_MEMCPY(geometry->draw_commands, draw_list->draw_commands + retained->first_draw_command, draw_commands_size);
+
+    /* The base vertices are stored relative to the first vertex */
+    for (size_t i = 0; i < num_draw_commands; i++)
+        geometry->draw_commands[i].vertex_offset -= retained->first_vertex;
+
+    geometry->valid = true;
+}
+
+/* Appends the geometry recorded under 'key' translated by('x', 'y'). Returns false if there's no valid geometry for 'key' or memory could not be allocated. */
+bool nmd_add_retained(uint32_t key, float x, float y)
+{
+    const nmd_retained_geometry* const geometry = _nmd_find_retained(key);
+    if (!geometry || !geometry->valid)
+        return false;
+
+    return _nmd_append_geometry(geometry->vertices, geometry->num_vertices, geometry->indices, geometry->num_indices, geometry->draw_commands, geometry->num_draw_commands, _nmd_context->draw_list.blank_tex_id, x, y);
+}
+
+/* Invalidates the geometry recorded under 'key', so the next nmd_begin_retained() with this key records it again. The memory is kept for the next recording. */
+void nmd_invalidate_retained(uint32_t key)
+{
+    nmd_retained_geometry* const geometry = _nmd_find_retained(key);
+    if (geometry)
+        geometry->valid = false;
+}
+
+/* Frees the memory of all retained geometry. */
+void nmd_free_retained()
+{
+    nmd_retained* const retained = &_nmd_context->retained;
+    for (size_t i = 0; i < retained->num_entries; i++)
+        _nmd_free(retained->entries[i].block);
+    _nmd_free(retained->entries);
+    NMD_MEMSET(retained, 0, sizeof(nmd_retained));
+}
+
 #define NMD_NORMALIZE2F_OVER_ZERO(VX,VY) { float d2 = VX*VX + VY*VY; if (d2 > 0.0f) { float inv_len = 1.0f / NMD_SQRT(d2); VX *= inv_len; VY *= inv_len; } }
 #define NMD_FIXNORMAL2F(VX,VY) { float d2 = VX*VX + VY*VY; if (d2 < 0.5f) d2 = 0.5f; float inv_lensq = 1.0f / d2; VX *= inv_lensq; VY *= inv_lensq; }
 
+/*
+Four-wide float vectors used by the tessellation kernels. A vector holds two points as (x0, y0, x1, y1), so the 'nmd_vec2' arrays
+are processed without deinterleaving. The NEON mapping uses AArch64 intrinsics(vdivq_f32(), vsqrtq_f32(), vzip1q_f32()).
+*/
+#if defined(NMD_GRAPHICS_ENABLE_SSE2)
+#define _NMD_GRAPHICS_SIMD
+typedef __m128 _nmd_v4;
+#define _NMD_V4_LOAD(p) _mm_loadu_ps(p)
+#define _NMD_V4_LOAD_LO_HI(lo, hi) _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(lo)), (const __m64*)(hi))
+#define _NMD_V4_STORE(p, v) _mm_storeu_ps(p, v)
+#define _NMD_V4_STORE_LO(p, v) _mm_storel_pi((__m64*)(p), v)
+#define _NMD_V4_STORE_HI(p, v) _mm_storeh_pi((__m64*)(p), v)
+#define _NMD_V4_SET1(f) _mm_set1_ps(f)
+#define _NMD_V4_ADD(a, b) _mm_add_ps(a, b)
+#define _NMD_V4_SUB(a, b) _mm_sub_ps(a, b)
+#define _NMD_V4_MUL(a, b) _mm_mul_ps(a, b)
+#define _NMD_V4_DIV(a, b) _mm_div_ps(a, b)
+#define _NMD_V4_MIN(a, b) _mm_min_ps(a, b)
+#define _NMD_V4_MAX(a, b) _mm_max_ps(a, b)
+#define _NMD_V4_SQRT(a) _mm_sqrt_ps(a)
+#define _NMD_V4_SWAP_PAIRS(a) _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1))
+#define _NMD_V4_ZIP_LO(a, b) _mm_unpacklo_ps(a, b)
+#define _NMD_V4_ZIP_HI(a, b) _mm_unpackhi_ps(a, b)
+#define _NMD_V4_SELECT_GT(a, b, t, f) _mm_or_ps(_mm_and_ps(_mm_cmpgt_ps(a, b), t), _mm_andnot_ps(_mm_cmpgt_ps(a, b), f))
+#elif defined(NMD_GRAPHICS_ENABLE_NEON)
+#define _NMD_GRAPHICS_SIMD
+typedef float32x4_t _nmd_v4;
+#define _NMD_V4_LOAD(p) vld1q_f32(p)
+#define _NMD_V4_LOAD_LO_HI(lo, hi) vcombine_f32(vld1_f32(lo), vld1_f32(hi))
+#define _NMD_V4_STORE(p, v) vst1q_f32(p, v)
+#define _NMD_V4_STORE_LO(p, v) vst1_f32(p, vget_low_f32(v))
+#define _NMD_V4_STORE_HI(p, v) vst1_f32(p, vget_high_f32(v))
+#define _NMD_V4_SET1(f) vdupq_n_f32(f)
+#define _NMD_V4_ADD(a, b) vaddq_f32(a, b)
+#define _NMD_V4_SUB(a, b) vsubq_f32(a, b)
+#define _NMD_V4_MUL(a, b) vmulq_f32(a, b)
+#define _NMD_V4_DIV(a, b) vdivq_f32(a, b)
+#define _NMD_V4_MIN(a, b) vminq_f32(a, b)
+#define _NMD_V4_MAX(a, b) vmaxq_f32(a, b)
+#define _NMD_V4_SQRT(a) vsqrtq_f32(a)
+#define _NMD_V4_SWAP_PAIRS(a) vrev64q_f32(a)
+#define _NMD_V4_ZIP_LO(a, b) vzip1q_f32(a, b)
+#define _NMD_V4_ZIP_HI(a, b) vzip2q_f32(a, b)
+#define _NMD_V4_SELECT_GT(a, b, t, f) vbslq_f32(vcgtq_f32(a, b), t, f)
+#endif /* NMD_GRAPHICS_ENABLE_SSE2 */
+
+/*
+Computes the unit normal of each segment of a polyline. 'normals[i]' is the normal of the segment from 'points[i]' to the next point.
+If 'closed' is false, the last normal is a copy of the previous one. 'num_points' must be at least two.
+*/
+void _nmd_compute_normals(const nmd_vec2* points, size_t num_points, bool closed, nmd_vec2* normals)
+{
+    size_t i = 0;
+
+#ifdef _NMD_GRAPHICS_SIMD
+    const _nmd_v4 zero = _NMD_V4_SET1(0.0f);
+    const _nmd_v4 one = _NMD_V4_SET1(1.0f);
+    const float sign_xy[4] = { 1.0f, -1.0f, 1.0f, -1.0f };
+    const _nmd_v4 sign = _NMD_V4_LOAD(sign_xy);
+
+    /* The normal of (dx, dy) is (dy, -dx), so the squared lengths and the normals are computed by swapping the components of each point */
+    for (; i + 2 < num_points; i += 2)
+    {
+        const _nmd_v4 d = _NMD_V4_SUB(_NMD_V4_LOAD(&points[i + 1].x), _NMD_V4_LOAD(&points[i].x));
+        const _nmd_v4 d_sq = _NMD_V4_MUL(d, d);
+        const _nmd_v4 len_sq = _NMD_V4_ADD(d_sq, _NMD_V4_SWAP_PAIRS(d_sq));
+        const _nmd_v4 inv_len = _NMD_V4_SELECT_GT(len_sq, zero, _NMD_V4_DIV(one, _NMD_V4_SQRT(len_sq)), one);
+        _NMD_V4_STORE(&normals[i].x, _NMD_V4_MUL(_NMD_V4_MUL(_NMD_V4_SWAP_PAIRS(d), inv_len), sign));
+    }
+#endif /* _NMD_GRAPHICS_SIMD */
+
+    for (; i + 1 < num_points; i++)
+    {
+        float dx = points[i + 1].x - points[i].x;
+        float dy = points[i + 1].y - points[i].y;
+        NMD_NORMALIZE2F_OVER_ZERO(dx, dy);
+        normals[i].x = dy;
+        normals[i].y = -dx;
+    }
+
+    if (closed)
+    {
+        float dx = points[0].x - points[num_points - 1].x;
+        float dy = points[0].y - points[num_points - 1].y;
+        NMD_NORMALIZE2F_OVER_ZERO(dx, dy);
+        normals[num_points - 1].x = dy;
+        normals[num_points - 1].y = -dx;
+    }
+    else
+        normals[num_points - 1] = normals[num_points - 2];
+}
+
+/* Averages two normals and scales the result by its inverse squared length, which is limited to 'max_inv_length_sq' so sharp corners don't create long spikes. */
+void _nmd_miter(const nmd_vec2* n0, const nmd_vec2* n1, float max_inv_length_sq, nmd_vec2* miter)
+{
+    const float dm_x = (n0->x + n1->x) * 0.5f;
+    const float dm_y = (n0->y + n1->y) * 0.5f;
+    const float length_sq = dm_x * dm_x + dm_y * dm_y;
+    const float scale = length_sq * max_inv_length_sq > 1.0f ? 1.0f / length_sq : max_inv_length_sq;
+    miter->x = dm_x * scale;
+    miter->y = dm_y * scale;
+}
+
+/*
+Computes the miter of each point of a polyline from the normals of the two segments that meet at it(see _nmd_miter()).
+If 'closed' is false, the miter of the first point is the normal of the first segment.
+*/
+void _nmd_compute_miters(const nmd_vec2* normals, size_t num_points, bool closed, float max_inv_length_sq, nmd_vec2* miters)
+{
+    size_t i = 1;
+
+    if (closed)
+        _nmd_miter(&normals[num_points - 1], &normals[0], max_inv_length_sq, &miters[0]);
+    else
+        miters[0] = normals[0];
+
+#ifdef _NMD_GRAPHICS_SIMD
+    const _nmd_v4 half = _NMD_V4_SET1(0.5f);
+    const _nmd_v4 one = _NMD_V4_SET1(1.0f);
+    const _nmd_v4 max_scale = _NMD_V4_SET1(max_inv_length_sq);
+    for (; i + 2 <= num_points; i += 2)
+    {
+        const _nmd_v4 dm = _NMD_V4_MUL(_NMD_V4_ADD(_NMD_V4_LOAD(&normals[i - 1].x), _NMD_V4_LOAD(&normals[i].x)), half);
+        const _nmd_v4 dm_sq = _NMD_V4_MUL(dm, dm);
+        const _nmd_v4 length_sq = _NMD_V4_ADD(dm_sq, _NMD_V4_SWAP_PAIRS(dm_sq));
+        _NMD_V4_STORE(&miters[i].x, _NMD_V4_MUL(dm, _NMD_V4_MIN(_NMD_V4_DIV(one, length_sq), max_scale)));
+    }
+#endif /* _NMD_GRAPHICS_SIMD */
+
+    for (; i < num_points; i++)
+        _nmd_miter(&normals[i - 1], &normals[i], max_inv_length_sq, &miters[i]);
+}
+
+/*
+Adds 'num_offsets' vertices for each point, the vertex 'j' of the point 'i' is at 'points[i] + miters[i] * offsets[j]' and has the color 'colors[j]'.
+The vertices must have been reserved.
+*/
+void _nmd_add_miter_vertices(const nmd_vec2* points, const nmd_vec2* miters, size_t num_points, const float* offsets, const nmd_color* colors, size_t num_offsets)
+{
+    nmd_vertex* vertices = _nmd_context->draw_list.vertices + _nmd_context->draw_list.num_vertices;
+    size_t i = 0, j;
+
+#ifdef _NMD_GRAPHICS_SIMD
+    for (; i + 2 <= num_points; i += 2)
+    {
+        const _nmd_v4 p = _NMD_V4_LOAD(&points[i].x);
+        const _nmd_v4 m = _NMD_V4_LOAD(&miters[i].x);
+        for (j = 0; j < num_offsets; j++)
+        {
+            const _nmd_v4 pos = _NMD_V4_ADD(p, _NMD_V4_MUL(m, _NMD_V4_SET1(offsets[j])));
+            _NMD_V4_STORE_LO(&vertices[j].pos.x, pos);
+            _NMD_V4_STORE_HI(&vertices[num_offsets + j].pos.x, pos);
+            vertices[j].color = colors[j];
+            vertices[num_offsets + j].color = colors[j];
+        }
+        vertices += num_offsets * 2;
+    }
+#endif /* _NMD_GRAPHICS_SIMD */
+
+    for (; i < num_points; i++)
+    {
+        for (j = 0; j < num_offsets; j++)
+        {
+            vertices[j].pos.x = points[i].x + miters[i].x * offsets[j];
+            vertices[j].pos.y = points[i].y + miters[i].y * offsets[j];
+            vertices[j].color = colors[j];
+        }
+        vertices += num_offsets;
+    }
+
+    _nmd_context->draw_list.num_vertices = vertices - _nmd_context->draw_list.vertices;
+}
+
+/* Writes the 'num_segments + 1' points of an arc to 'path'. 'num_segments' must be at least one. */
+void _nmd_arc_points(nmd_vec2* path, float x0, float y0, float radius, float start_angle, float end_angle, size_t num_segments)
+{
+    size_t i = 0;
+
+#ifdef _NMD_GRAPHICS_SIMD
+    /*
+    Four points per iteration. The cosines and sines of four consecutive angles are rotated by four steps(a complex multiplication),
+    they're computed again every 64 iterations so the rounding error doesn't accumulate.
+    */
+    if (num_segments >= 7)
+    {
+        const float step = (end_angle - start_angle) / num_segments;
+        const _nmd_v4 cos_step4 = _NMD_V4_SET1(NMD_COS(step * 4));
+        const _nmd_v4 sin_step4 = _NMD_V4_SET1(NMD_SIN(step * 4));
+        const _nmd_v4 center_x = _NMD_V4_SET1(x0);
+        const _nmd_v4 center_y = _NMD_V4_SET1(y0);
+        const _nmd_v4 r = _NMD_V4_SET1(radius);
+        _nmd_v4 c = _NMD_V4_SET1(0.0f), s = c;
+        for (; i + 4 <= num_segments + 1; i += 4)
+        {
+            if (i % 256 == 0)
+            {
+                float cosines[4], sines[4];
+                for (size_t k = 0; k < 4; k++)
+                {
+                    const float angle = start_angle + ((i + k) / (float)num_segments) * (end_angle - start_angle);
+                    cosines[k] = NMD_COS(angle);
+                    sines[k] = NMD_SIN(angle);
+                }
+                c = _NMD_V4_LOAD(cosines);
+                s = _NMD_V4_LOAD(sines);
+            }
+
+            const _nmd_v4 x = _NMD_V4_ADD(center_x, _NMD_V4_MUL(c, r));
+            const _nmd_v4 y = _NMD_V4_ADD(center_y, _NMD_V4_MUL(s, r));
+            _NMD_V4_STORE(&path[i].x, _NMD_V4_ZIP_LO(x, y));
+            _NMD_V4_STORE(&path[i + 2].x, _NMD_V4_ZIP_HI(x, y));
+
+            const _nmd_v4 next_c = _NMD_V4_SUB(_NMD_V4_MUL(c, cos_step4), _NMD_V4_MUL(s, sin_step4));
+            s = _NMD_V4_ADD(_NMD_V4_MUL(s, cos_step4), _NMD_V4_MUL(c, sin_step4));
+            c = next_c;
+        }
+    }
+#endif /* _NMD_GRAPHICS_SIMD */
+
+    for (; i <= num_segments; i++)
+    {
+        const float angle = start_angle + (i / (float)num_segments) * (end_angle - start_angle);
+        path[i].x = x0 + NMD_COS(angle) * radius;
+        path[i].y = y0 + NMD_SIN(angle) * radius;
+    }
+}
+
 void nmd_add_polyline(const nmd_vec2* points, size_t num_points, nmd_color color, bool closed, float thickness)
 {
     const size_t num_segments = closed ? num_points : num_points - 1;
@@ -69,7 +514,7 @@ void nmd_add_polyline(const nmd_vec2* points, size_t num_points, nmd_color color
     col_trans = color;
     col_trans.a = 0;
 
-    if (_nmd_context.draw_list.line_anti_aliasing)
+    if (_nmd_context->draw_list.line_anti_aliasing)
     {
         const float AA_SIZE = 1.0f;
 
@@ -80,185 +525,52 @@ void nmd_add_polyline(const nmd_vec2* points, size_t num_points, nmd_color color
         if (!_nmd_reserve(vtx_count, idx_count))
             return;
 
-        size_t size;
-        nmd_vec2* normals, * temp;
+        nmd_vec2* normals, * miters;
 #ifdef NMD_GRAPHICS_AVOID_ALLOCA
-        normals = (nmd_vec2*)NMD_MALLOC(sizeof(nmd_vec2) * ((thick_line) ? 5 : 3) * num_points);
+        normals = (nmd_vec2*)_nmd_frame_alloc(sizeof(nmd_vec2) * 2 * num_points);
+        if (!normals)
+            return;
 #else
-        normals = (nmd_vec2*)NMD_ALLOCA(sizeof(nmd_vec2) * ((thick_line) ? 5 : 3) * num_points);
+        normals = (nmd_vec2*)NMD_ALLOCA(sizeof(nmd_vec2) * 2 * num_points);
 #endif
 
-        temp = normals + num_points;
+        miters = normals + num_points;
 
-        /* Calculate normals */
-        for (i1 = 0; i1 < num_segments; ++i1) {
-            const int i2 = (i1 + 1) == num_points ? 0 : i1 + 1;
-            float dx = points[i2].x - points[i1].x;
-            float dy = points[i2].y - points[i1].y;
-            NMD_NORMALIZE2F_OVER_ZERO(dx, dy);
-            normals[i1].x = dy;
-            normals[i1].y = -dx;
-        }
-
-        if (!closed)
-            normals[num_points - 1] = normals[num_points - 2];
+        _nmd_compute_normals(points, num_points, closed, normals);
+        _nmd_compute_miters(normals, num_points, closed, 100.0f, miters);
 
         if (!thick_line) {
-            size_t idx1, i;
-            if (!closed) {
-                nmd_vec2 d;
-
-                temp[0].x = points[0].x + normals[0].x * AA_SIZE;
-                temp[0].y = points[0].y + normals[0].y * AA_SIZE;
-
-                temp[1].x = points[0].x - normals[0].x * AA_SIZE;
-                temp[1].y = points[0].y - normals[0].y * AA_SIZE;
-
-                d.x = normals[num_points - 1].x * AA_SIZE;
-                d.y = normals[num_points - 1].y * AA_SIZE;
-
-                temp[(num_points - 1) * 2 + 0].x = points[num_points - 1].x + d.x;
-                temp[(num_points - 1) * 2 + 0].y = points[num_points - 1].y + d.y;
-
-                temp[(num_points - 1) * 2 + 1].x = points[num_points - 1].x - d.x;
-                temp[(num_points - 1) * 2 + 1].y = points[num_points - 1].y - d.y;
-            }
-
-            /* Fill elements */
-            idx1 = _nmd_context.draw_list.num_vertices;
+            /* Add indices */
+            size_t idx1 = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
             for (i1 = 0; i1 < num_segments; i1++) {
-                nmd_vec2 dm;
-                float dmr2;
-                size_t i2 = ((i1 + 1) == num_points) ? 0 : (i1 + 1);
-                size_t idx2 = ((i1 + 1) == num_points) ? _nmd_context.draw_list.num_vertices : (idx1 + 3);
-
-                /* Average normals */
-                dm.x = (normals[i1].x + normals[i2].x) * 0.5f;
-                dm.y = (normals[i1].y + normals[i2].y) * 0.5f;
-
-                dmr2 = dm.x * dm.x + dm.y * dm.y;
-                if (dmr2 > 0.000001f) {
-                    float scale = 1.0f / dmr2;
-
-                    scale = NMD_MIN(100.0f, scale);
-
-                    dm.x = dm.x * scale;
-                    dm.y = dm.y * scale;
-                }
-
-                dm.x = dm.x * AA_SIZE;
-                dm.y = dm.y * AA_SIZE;
-
-                temp[i2 * 2 + 0].x = points[i2].x + dm.x;
-                temp[i2 * 2 + 0].y = points[i2].y + dm.y;
-
-                temp[i2 * 2 + 1].x = points[i2].x - dm.x;
-                temp[i2 * 2 + 1].y = points[i2].y - dm.y;
+                size_t idx2 = ((i1 + 1) == num_points) ? (_nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset) : (idx1 + 3);
 
-                nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
+                nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
                 indices[0]  = idx2 + 0; indices[1]  = idx1 + 0;
                 indices[2]  = idx1 + 2; indices[3]  = idx1 + 2;
                 indices[4]  = idx2 + 2; indices[5]  = idx2 + 0;
                 indices[6]  = idx2 + 1; indices[7]  = idx1 + 1;
                 indices[8]  = idx1 + 0; indices[9]  = idx1 + 0;
                 indices[10] = idx2 + 0; indices[11] = idx2 + 1;
-                _nmd_context.draw_list.num_indices += 12;
+                _nmd_context->draw_list.num_indices += 12;
 
                 idx1 = idx2;
             }
 
-            /* Fill vertices */
-            for (i = 0; i < num_points; ++i) {
-                nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
-                vertices[0].pos = points[i];       vertices[0].color = color;
-                vertices[1].pos = temp[i * 2 + 0]; vertices[1].color = col_trans;
-                vertices[2].pos = temp[i * 2 + 1]; vertices[2].color = col_trans;
-                _nmd_context.draw_list.num_vertices += 3;
-            }
+            /* Add vertices: the point and the two edges of the anti-aliasing fringe */
+            const float offsets[3] = { 0.0f, AA_SIZE, -AA_SIZE };
+            const nmd_color colors[3] = { color, col_trans, col_trans };
+            _nmd_add_miter_vertices(points, miters, num_points, offsets, colors, 3);
         }
         else {
-            size_t idx1, i;
             const float half_inner_thickness = (thickness - AA_SIZE) * 0.5f;
-            if (!closed) {
-                nmd_vec2 d1;
-                d1.x = normals[0].x * (half_inner_thickness + AA_SIZE);
-                d1.y = normals[0].y * (half_inner_thickness + AA_SIZE);
-
-                nmd_vec2 d2;
-                d2.x = normals[0].x * half_inner_thickness;
-                d2.y = normals[0].y * half_inner_thickness;
         
-                temp[0].x = points[0].x + d1.x;
-                temp[0].y = points[0].y + d1.y;
-
-                temp[1].x = points[0].x + d2.x;
-                temp[1].y = points[0].y + d2.y;
-
-                temp[2].x = points[0].x - d2.x;
-                temp[2].y = points[0].y - d2.y;
-
-                temp[3].x = points[0].x - d1.x;
-                temp[3].y = points[0].y - d1.y;
-        
-                d1.x = normals[num_points - 1].x * (half_inner_thickness + AA_SIZE);
-                d1.y = normals[num_points - 1].y * (half_inner_thickness + AA_SIZE);
-
-                d2.x = normals[num_points - 1].x * half_inner_thickness;
-                d2.y = normals[num_points - 1].y * half_inner_thickness;
-        
-                temp[(num_points - 1) * 4 + 0].x = points[num_points - 1].x + d1.x;
-                temp[(num_points - 1) * 4 + 0].y = points[num_points - 1].y + d1.y;
-
-                temp[(num_points - 1) * 4 + 1].x = points[num_points - 1].x + d2.x;
-                temp[(num_points - 1) * 4 + 1].y = points[num_points - 1].y + d2.y;
-
-                temp[(num_points - 1) * 4 + 2].x = points[num_points - 1].x - d2.x;
-                temp[(num_points - 1) * 4 + 2].y = points[num_points - 1].y - d2.y;
-
-                temp[(num_points - 1) * 4 + 3].x = points[num_points - 1].x - d1.x;
-                temp[(num_points - 1) * 4 + 3].y = points[num_points - 1].y - d1.y;
-            }
-        
-            /* Add all elements */
-            idx1 = _nmd_context.draw_list.num_vertices;
+            /* Add indices */
+            size_t idx1 = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
             for (i1 = 0; i1 < num_segments; ++i1) {
-                nmd_vec2 dm_out, dm_in;
-                const size_t i2 = ((i1 + 1) == num_points) ? 0 : (i1 + 1);
-                size_t idx2 = ((i1 + 1) == num_points) ? _nmd_context.draw_list.num_vertices : (idx1 + 4);
-        
-                /* Average normals */
-                nmd_vec2 dm;
-                dm.x = (normals[i1].x + normals[i2].x) * 0.5f;
-                dm.y = (normals[i1].y + normals[i2].y) * 0.5f;
-
-                float dmr2 = dm.x * dm.x + dm.y * dm.y;
-                if (dmr2 > 0.000001f) {
-                    float scale = 1.0f / dmr2;
-                    scale = NMD_MIN(100.0f, scale);
-                    dm.x = dm.x * scale;
-                    dm.y = dm.y * scale;
-                }
+                size_t idx2 = ((i1 + 1) == num_points) ? (_nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset) : (idx1 + 4);
         
-                dm_out.x = dm.x * ((half_inner_thickness)+AA_SIZE);
-                dm_out.y = dm.y * ((half_inner_thickness)+AA_SIZE);
-
-                dm_in.x = dm.x * half_inner_thickness;
-                dm_in.y = dm.y * half_inner_thickness;
-
-
-                temp[i2 * 4 + 0].x = points[i2].x + dm_out.x;
-                temp[i2 * 4 + 0].y = points[i2].y + dm_out.y;
-
-                temp[i2 * 4 + 1].x = points[i2].x + dm_in.x;
-                temp[i2 * 4 + 1].y = points[i2].y + dm_in.y;
-
-                temp[i2 * 4 + 2].x = points[i2].x - dm_in.x;
-                temp[i2 * 4 + 2].y = points[i2].y - dm_in.y;
-
-                temp[i2 * 4 + 3].x = points[i2].x - dm_out.x;
-                temp[i2 * 4 + 3].y = points[i2].y - dm_out.y;
-        
-                nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
+                nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
                 indices[0]  = idx2 + 1; indices[1]  = idx1 + 1;
                 indices[2]  = idx1 + 2; indices[3]  = idx1 + 2;
                 indices[4]  = idx2 + 2; indices[5]  = idx2 + 1;
@@ -268,24 +580,19 @@ void nmd_add_polyline(const nmd_vec2* points, size_t num_points, nmd_color color
                 indices[12] = idx2 + 2; indices[13] = idx1 + 2;
                 indices[14] = idx1 + 3; indices[15] = idx1 + 3;
                 indices[16] = idx2 + 3; indices[17] = idx2 + 2;
-                _nmd_context.draw_list.num_indices += 18;
+                _nmd_context->draw_list.num_indices += 18;
 
                 idx1 = idx2;                
             }
         
-            /* Add vertices */
-            for (i = 0; i < num_points; i++) {
-                nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
-                vertices[0].pos = temp[i * 4 + 0]; vertices[0].color = col_trans;
-                vertices[1].pos = temp[i * 4 + 1]; vertices[1].color = color;
-                vertices[2].pos = temp[i * 4 + 2]; vertices[2].color = color;
-                vertices[3].pos = temp[i * 4 + 3]; vertices[3].color = col_trans;
-                _nmd_context.draw_list.num_vertices += 4;
-            }
+            /* Add vertices: the outer and inner edges on both sides of the line */
+            const float offsets[4] = { half_inner_thickness + AA_SIZE, half_inner_thickness, -half_inner_thickness, -(half_inner_thickness + AA_SIZE) };
+            const nmd_color colors[4] = { col_trans, color, color, col_trans };
+            _nmd_add_miter_vertices(points, miters, num_points, offsets, colors, 4);
         }
 
 #ifdef NMD_GRAPHICS_AVOID_ALLOCA
-        NMD_FREE(normals);
+        _nmd_frame_release(normals, sizeof(nmd_vec2) * 2 * num_points);
 #endif /* NMD_GRAPHICS_AVOID_ALLOCA*/
     }
     else /* Non anti-alised */
@@ -309,19 +616,19 @@ void nmd_add_polyline(const nmd_vec2* points, size_t num_points, nmd_color color
             dx *= (thickness * 0.5f);
             dy *= (thickness * 0.5f);
 
-            const size_t offset = _nmd_context.draw_list.num_vertices;
+            const size_t offset = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
 
-            nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
+            nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
             indices[0] = offset + 0; indices[1] = offset + 1; indices[2] = offset + 2;
             indices[3] = offset + 0; indices[4] = offset + 2; indices[5] = offset + 3;
-            _nmd_context.draw_list.num_indices += 6;
+            _nmd_context->draw_list.num_indices += 6;
 
-            nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
+            nmd_vertex* vertices = _nmd_context->draw_list.vertices + _nmd_context->draw_list.num_vertices;
             vertices[0].pos.x = p0->x + dy; vertices[0].pos.y = p0->y - dx; vertices[0].color = color;
             vertices[1].pos.x = p1->x + dy; vertices[1].pos.y = p1->y - dx; vertices[1].color = color;
             vertices[2].pos.x = p1->x - dy; vertices[2].pos.y = p1->y + dx; vertices[2].color = color;
             vertices[3].pos.x = p0->x - dy; vertices[3].pos.y = p0->y + dx; vertices[3].color = color;
-            _nmd_context.draw_list.num_vertices += 4;
+            _nmd_context->draw_list.num_vertices += 4;
         }
     }
 }
@@ -331,25 +638,25 @@ void nmd_path_to(float x0, float y0)
     if (!_nmd_reserve_points(1))
         return;
 
-    _nmd_context.draw_list.path[_nmd_context.draw_list.num_points].x = x0;
-    _nmd_context.draw_list.path[_nmd_context.draw_list.num_points].y = y0;
-    _nmd_context.draw_list.num_points++;
+    _nmd_context->draw_list.path[_nmd_context->draw_list.num_points].x = x0;
+    _nmd_context->draw_list.path[_nmd_context->draw_list.num_points].y = y0;
+    _nmd_context->draw_list.num_points++;
 }
 
 void nmd_path_fill_convex(nmd_color color)
 {
-    nmd_add_convex_polygon_filled(_nmd_context.draw_list.path, _nmd_context.draw_list.num_points, color);
+    nmd_add_convex_polygon_filled(_nmd_context->draw_list.path, _nmd_context->draw_list.num_points, color);
 
     /* Clear points in 'path' */
-    _nmd_context.draw_list.num_points = 0;
+    _nmd_context->draw_list.num_points = 0;
 }
 
 void nmd_path_stroke(nmd_color color, bool closed, float thickness)
 {
-    nmd_add_polyline(_nmd_context.draw_list.path, _nmd_context.draw_list.num_points, color, closed, thickness);
+    nmd_add_polyline(_nmd_context->draw_list.path, _nmd_context->draw_list.num_points, color, closed, thickness);
 
     /* Clear points in 'path' */
-    _nmd_context.draw_list.num_points = 0;
+    _nmd_context->draw_list.num_points = 0;
 }
 
 /*
@@ -399,28 +706,37 @@ void _nmd_shade_verts_linear_uv(int vert_start_idx, int vert_end_idx, float x0,
     const float scale_x = size_x != 0.0f ? (uv_size_x / size_x) : 0.0f;
     const float scale_y = size_y != 0.0f ? (uv_size_y / size_y) : 0.0f;
 
-    nmd_vertex* vert_start = _nmd_context.draw_list.vertices + vert_start_idx;
-    nmd_vertex* vert_end = _nmd_context.draw_list.vertices + vert_end_idx;
-    if (clamp)
+    nmd_vertex* vertex = _nmd_context->draw_list.vertices + vert_start_idx;
+    nmd_vertex* vert_end = _nmd_context->draw_list.vertices + vert_end_idx;
+
+    const float min_x = clamp ? NMD_MIN(uv_x0, uv_x1) : -3.402823466e+38f;
+    const float min_y = clamp ? NMD_MIN(uv_y0, uv_y1) : -3.402823466e+38f;
+    const float max_x = clamp ? NMD_MAX(uv_x0, uv_x1) : 3.402823466e+38f;
+    const float max_y = clamp ? NMD_MAX(uv_y0, uv_y1) : 3.402823466e+38f;
+
+#ifdef _NMD_GRAPHICS_SIMD
+    /* Two vertices per iteration */
+    const float constants[5][4] = { { x0, y0, x0, y0 }, { uv_x0, uv_y0, uv_x0, uv_y0 }, { scale_x, scale_y, scale_x, scale_y }, { min_x, min_y, min_x, min_y }, { max_x, max_y, max_x, max_y } };
+    const _nmd_v4 pos0 = _NMD_V4_LOAD(constants[0]);
+    const _nmd_v4 uv0 = _NMD_V4_LOAD(constants[1]);
+    const _nmd_v4 scale = _NMD_V4_LOAD(constants[2]);
+    const _nmd_v4 uv_min = _NMD_V4_LOAD(constants[3]);
+    const _nmd_v4 uv_max = _NMD_V4_LOAD(constants[4]);
+    for (; vertex + 2 <= vert_end; vertex += 2)
     {
-        const float min_x = NMD_MIN(uv_x0, uv_x1);
-        const float min_y = NMD_MIN(uv_y0, uv_y1);
-
-        const float max_x = NMD_MAX(uv_x0, uv_x1);
-        const float max_y = NMD_MAX(uv_y1, uv_y1);
-        for (nmd_vertex* vertex = vert_start; vertex < vert_end; ++vertex)
-        {
-            vertex->uv.x = NMD_CLAMP(uv_x0 + (vertex->pos.x - x0) * scale_x, min_x, max_x);
-            vertex->uv.y = NMD_CLAMP(uv_y0 + (vertex->pos.y - y0) * scale_y, min_x, max_x);
-        }
+        const _nmd_v4 pos = _NMD_V4_LOAD_LO_HI(&vertex[0].pos.x, &vertex[1].pos.x);
+        const _nmd_v4 uv = _NMD_V4_MIN(_NMD_V4_MAX(_NMD_V4_ADD(uv0, _NMD_V4_MUL(_NMD_V4_SUB(pos, pos0), scale)), uv_min), uv_max);
+        _NMD_V4_STORE_LO(&vertex[0].uv.x, uv);
+        _NMD_V4_STORE_HI(&vertex[1].uv.x, uv);
     }
-    else
+#endif /* _NMD_GRAPHICS_SIMD */
+
+    for (; vertex < vert_end; ++vertex)
     {
-        for (nmd_vertex* vertex = vert_start; vertex < vert_end; ++vertex)
-        {
-            vertex->uv.x = uv_x0 + (vertex->pos.x - x0) * scale_x;
-            vertex->uv.y = uv_y0 + (vertex->pos.y - y0) * scale_y;
-        }
+        const float u = uv_x0 + (vertex->pos.x - x0) * scale_x;
+        const float v = uv_y0 + (vertex->pos.y - y0) * scale_y;
+        vertex->uv.x = NMD_CLAMP(u, min_x, max_x);
+        vertex->uv.y = NMD_CLAMP(v, min_y, max_y);
     }
 }
 
@@ -449,19 +765,19 @@ void nmd_add_rect_filled(float x0, float y0, float x1, float y1, nmd_color color
         if (!_nmd_reserve(4, 6))
             return;
 
-        const size_t offset = _nmd_context.draw_list.num_vertices;
+        const size_t offset = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
 
-        nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
+        nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
         indices[0] = offset + 0; indices[1] = offset + 1; indices[2] = offset + 2;
         indices[3] = offset + 0; indices[4] = offset + 2; indices[5] = offset + 3;
-        _nmd_context.draw_list.num_indices += 6;
+        _nmd_context->draw_list.num_indices += 6;
 
-        nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
+        nmd_vertex* vertices = _nmd_context->draw_list.vertices + _nmd_context->draw_list.num_vertices;
         vertices[0].pos.x = x0; vertices[0].pos.y = y0; vertices[0].color = color;
         vertices[1].pos.x = x1; vertices[1].pos.y = y0; vertices[1].color = color;
         vertices[2].pos.x = x1; vertices[2].pos.y = y1; vertices[2].color = color;
         vertices[3].pos.x = x0; vertices[3].pos.y = y1; vertices[3].color = color;
-        _nmd_context.draw_list.num_vertices += 4;
+        _nmd_context->draw_list.num_vertices += 4;
     }
 }
 
@@ -470,19 +786,19 @@ void nmd_add_rect_filled_multi_color(float x0, float y0, float x1, float y1, nmd
     if (!_nmd_reserve(4, 6))
         return;
 
-    const size_t offset = _nmd_context.draw_list.num_vertices;
+    const size_t offset = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
 
-    nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
+    nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
     indices[0] = offset + 0; indices[1] = offset + 1; indices[2] = offset + 2;
     indices[3] = offset + 0; indices[4] = offset + 2; indices[5] = offset + 3;
-    _nmd_context.draw_list.num_indices += 6;
+    _nmd_context->draw_list.num_indices += 6;
 
-    nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
+    nmd_vertex* vertices = _nmd_context->draw_list.vertices + _nmd_context->draw_list.num_vertices;
     vertices[0].pos.x = x0; vertices[0].pos.y = y0; vertices[0].color = color_upper_left;
     vertices[1].pos.x = x1; vertices[1].pos.y = y0; vertices[1].color = color_upper_right;
     vertices[2].pos.x = x1; vertices[2].pos.y = y1; vertices[2].color = color_bottom_right;
     vertices[3].pos.x = x0; vertices[3].pos.y = y1; vertices[3].color = color_bottom_left;
-    _nmd_context.draw_list.num_vertices += 4;
+    _nmd_context->draw_list.num_vertices += 4;
 }
 
 void nmd_add_quad(float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3, nmd_color color, float thickness)
@@ -541,7 +857,7 @@ void nmd_add_circle(float x0, float y0, float radius, nmd_color color, size_t nu
         return;
 
     if (num_segments == 0)
-        num_segments = (radius - 1 < 64) ? _nmd_context.draw_list.cached_circle_segment_counts64[(int)radius - 1] : NMD_CIRCLE_AUTO_SEGMENT_CALC(radius, 1.6f);
+        num_segments = (radius - 1 < 64) ? _nmd_context->draw_list.cached_circle_segment_counts64[(int)radius - 1] : NMD_CIRCLE_AUTO_SEGMENT_CALC(radius, 1.6f);
     else
         num_segments = NMD_CLAMP(num_segments, 3, NMD_CIRCLE_AUTO_SEGMENT_MAX);
 
@@ -559,7 +875,7 @@ void nmd_add_circle_filled(float x0, float y0, float radius, nmd_color color, si
         return;
 
     if (num_segments <= 0)
-        num_segments = (radius - 1 < 64) ? _nmd_context.draw_list.cached_circle_segment_counts64[(int)radius - 1] : NMD_CIRCLE_AUTO_SEGMENT_CALC(radius, 1.6f);
+        num_segments = (radius - 1 < 64) ? _nmd_context->draw_list.cached_circle_segment_counts64[(int)radius - 1] : NMD_CIRCLE_AUTO_SEGMENT_CALC(radius, 1.6f);
     else
         num_segments = NMD_CLAMP(num_segments, 3, NMD_CIRCLE_AUTO_SEGMENT_MAX);
 
@@ -615,10 +931,10 @@ void nmd_path_rect(float x0, float y0, float x1, float y1, float rounding, uint3
 
 void nmd_path_arc_to(float x0, float y0, float radius, float start_angle, float end_angle, size_t num_segments, bool start_at_center)
 {
-    if (!_nmd_reserve_points((start_at_center ? 1 : 0) + num_segments))
+    if (!num_segments || !_nmd_reserve_points((start_at_center ? 1 : 0) + num_segments + 1))
         return;
 
-    nmd_vec2* path = _nmd_context.draw_list.path + _nmd_context.draw_list.num_points;
+    nmd_vec2* path = _nmd_context->draw_list.path + _nmd_context->draw_list.num_points;
 
     if (start_at_center)
     {
@@ -626,22 +942,17 @@ void nmd_path_arc_to(float x0, float y0, float radius, float start_angle, float
         path++;
     }
 
-    for (size_t i = 0; i <= num_segments; i++)
-    {
-        const float angle = start_angle + (i / (float)num_segments) * (end_angle - start_angle);
-        path[i].x = x0 + NMD_COS(angle) * radius;
-        path[i].y = y0 + NMD_SIN(angle) * radius;
-    }
+    _nmd_arc_points(path, x0, y0, radius, start_angle, end_angle, num_segments);
 
-    _nmd_context.draw_list.num_points = (start_at_center ? 1 : 0) + num_segments + 1;
+    _nmd_context->draw_list.num_points += (start_at_center ? 1 : 0) + num_segments + 1;
 }
 
 void nmd_path_arc_to_cached(float x0, float y0, float radius, size_t start_angle_of12, size_t end_angle_of12, bool start_at_center)
 {
-    if (!_nmd_reserve_points((start_at_center ? 1 : 0) + (end_angle_of12 - start_angle_of12)))
+    if (!_nmd_reserve_points((start_at_center ? 1 : 0) + (end_angle_of12 - start_angle_of12) + 1))
         return;
 
-    nmd_vec2* path = _nmd_context.draw_list.path + _nmd_context.draw_list.num_points;
+    nmd_vec2* path = _nmd_context->draw_list.path + _nmd_context->draw_list.num_points;
 
     if (start_at_center)
     {
@@ -651,13 +962,13 @@ void nmd_path_arc_to_cached(float x0, float y0, float radius, size_t start_angle
 
     for (size_t angle = start_angle_of12; angle <= end_angle_of12; angle++)
     {
-        const nmd_vec2* point = &_nmd_context.draw_list.cached_circle_vertices12[angle % 12];
+        const nmd_vec2* point = &_nmd_context->draw_list.cached_circle_vertices12[angle % 12];
         path->x = x0 + point->x * radius;
         path->y = y0 + point->y * radius;
         path++;
     }
 
-    _nmd_context.draw_list.num_points = path - _nmd_context.draw_list.path;
+    _nmd_context->draw_list.num_points = path - _nmd_context->draw_list.path;
 }
 
 /*
@@ -677,36 +988,36 @@ void DrawList::PathBezierCurveTo(const nmd_vec2& p2, const nmd_vec2& p3, const n
 
 void nmd_prim_rect_uv(float x0, float y0, float x1, float y1, float uv_x0, float uv_y0, float uv_x1, float uv_y1, nmd_color color)
 {
-    const size_t offset = _nmd_context.draw_list.num_vertices;
+    const size_t offset = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
 
-    nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
+    nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
     indices[0] = offset + 0; indices[1] = offset + 1; indices[2] = offset + 2;
     indices[3] = offset + 0; indices[4] = offset + 2; indices[5] = offset + 3;
-    _nmd_context.draw_list.num_indices += 6;
+    _nmd_context->draw_list.num_indices += 6;
 
-    nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
+    nmd_vertex* vertices = _nmd_context->draw_list.vertices + _nmd_context->draw_list.num_vertices;
     vertices[0].pos.x = x0; vertices[0].pos.y = y0; vertices[0].uv.x = uv_x0; vertices[0].uv.y = uv_y0; vertices[0].color = color;
     vertices[1].pos.x = x1; vertices[1].pos.y = y0; vertices[1].uv.x = uv_x1; vertices[1].uv.y = uv_y0; vertices[1].color = color;
     vertices[2].pos.x = x1; vertices[2].pos.y = y1; vertices[2].uv.x = uv_x1; vertices[2].uv.y = uv_y1; vertices[2].color = color;
     vertices[3].pos.x = x0; vertices[3].pos.y = y1; vertices[3].uv.x = uv_x0; vertices[3].uv.y = uv_y1; vertices[3].color = color;
-    _nmd_context.draw_list.num_vertices += 4;
+    _nmd_context->draw_list.num_vertices += 4;
 }
 
 void nmd_prim_quad_uv(float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3, float uv_x0, float uv_y0, float uv_x1, float uv_y1, float uv_x2, float uv_y2, float uv_x3, float uv_y3, nmd_color color)
 {
-    const size_t offset = _nmd_context.draw_list.num_vertices;
+    const size_t offset = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
 
-    nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
+    nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
     indices[0] = offset + 0; indices[1] = offset + 1; indices[2] = offset + 2;
     indices[3] = offset + 0; indices[4] = offset + 2; indices[5] = offset + 3;
-    _nmd_context.draw_list.num_indices += 6;
+    _nmd_context->draw_list.num_indices += 6;
 
-    nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
+    nmd_vertex* vertices = _nmd_context->draw_list.vertices + _nmd_context->draw_list.num_vertices;
     vertices[0].pos.x = x0; vertices[0].pos.y = y0; vertices[0].uv.x = uv_x0; vertices[0].uv.y = uv_y0; vertices[0].color = color;
     vertices[1].pos.x = x1; vertices[1].pos.y = y1; vertices[1].uv.x = uv_x1; vertices[1].uv.y = uv_y1; vertices[1].color = color;
     vertices[2].pos.x = x2; vertices[2].pos.y = y2; vertices[2].uv.x = uv_x2; vertices[2].uv.y = uv_y2; vertices[2].color = color;
     vertices[3].pos.x = x3; vertices[3].pos.y = y3; vertices[3].uv.x = uv_x3; vertices[3].uv.y = uv_y3; vertices[3].color = color;
-    _nmd_context.draw_list.num_vertices += 4;
+    _nmd_context->draw_list.num_vertices += 4;
 }
 
 void nmd_add_line(float x0, float y0, float x1, float y1, nmd_color color, float thickness)
@@ -724,7 +1035,7 @@ void nmd_add_convex_polygon_filled(const nmd_vec2* points, size_t num_points, nm
     if (num_points < 3)
         return;
 
-    if (_nmd_context.draw_list.fill_anti_aliasing)
+    if (_nmd_context->draw_list.fill_anti_aliasing)
     {
         /* Anti-aliased fill */
         const float AA_SIZE = 1.0f;
@@ -737,60 +1048,45 @@ void nmd_add_convex_polygon_filled(const nmd_vec2* points, size_t num_points, nm
             return;
 
         /* Add indexes for fill */
-        unsigned int vtx_inner_idx = _nmd_context.draw_list.num_vertices;
-        unsigned int vtx_outer_idx = _nmd_context.draw_list.num_vertices + 1;
-        nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
+        unsigned int vtx_inner_idx = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
+        unsigned int vtx_outer_idx = vtx_inner_idx + 1;
+        nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
         for (int i = 2; i < num_points; i++)
         {
             indices[0] = vtx_inner_idx; indices[1] = vtx_inner_idx + ((i - 1) << 1); indices[2] = vtx_inner_idx + (i << 1);
             indices += 3;
         }
 
-        /* Compute normals */
-#ifdef NMD_GRAPHICS_AVOID_ALLOCA
-        nmd_vec2* temp_normals = (nmd_vec2*)NMD_MALLOC(num_points * sizeof(nmd_vec2));
-#else
-        nmd_vec2* temp_normals = (nmd_vec2*)NMD_ALLOCA(num_points * sizeof(nmd_vec2));
-#endif
-
-        for (int i0 = num_points - 1, i1 = 0; i1 < num_points; i0 = i1++)
-        {
-            const nmd_vec2* p0 = &points[i0];
-            const nmd_vec2* p1 = &points[i1];
-            float dx = p1->x - p0->x;
-            float dy = p1->y - p0->y;
-            NMD_NORMALIZE2F_OVER_ZERO(dx, dy);
-            temp_normals[i0].x = dy;
-            temp_normals[i0].y = -dx;
-        }
-
-        nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
+        /* Add indexes for fringes */
         for (int i0 = num_points - 1, i1 = 0; i1 < num_points; i0 = i1++)
         {
-            /* Average normals */
-            const nmd_vec2* n0 = &temp_normals[i0];
-            const nmd_vec2* n1 = &temp_normals[i1];
-            float dm_x = (n0->x + n1->x) * 0.5f;
-            float dm_y = (n0->y + n1->y) * 0.5f;
-            NMD_FIXNORMAL2F(dm_x, dm_y);
-            dm_x *= AA_SIZE * 0.5f;
-            dm_y *= AA_SIZE * 0.5f;
-
-            /* Add vertices */
-            vertices[0].pos.x = (points[i1].x - dm_x); vertices[0].pos.y = (points[i1].y - dm_y); vertices[0].color = color;
-            vertices[1].pos.x = (points[i1].x + dm_x); vertices[1].pos.y = (points[i1].y + dm_y); vertices[1].color = col_trans;
-            vertices += 2;
-
-            /* Add indexes for fringes */
             indices[0] = vtx_inner_idx + (i1 << 1); indices[1] = vtx_inner_idx + (i0 << 1); indices[2] = vtx_outer_idx + (i0 << 1);
             indices[3] = vtx_outer_idx + (i0 << 1); indices[4] = vtx_outer_idx + (i1 << 1); indices[5] = vtx_inner_idx + (i1 << 1);
             indices += 6;
         }
-        _nmd_context.draw_list.num_vertices = vertices - _nmd_context.draw_list.vertices;
-        _nmd_context.draw_list.num_indices = indices - _nmd_context.draw_list.indices;
+        _nmd_context->draw_list.num_indices = indices - _nmd_context->draw_list.indices;
+
+        /* Compute normals */
+#ifdef NMD_GRAPHICS_AVOID_ALLOCA
+        nmd_vec2* temp_normals = (nmd_vec2*)_nmd_frame_alloc(2 * num_points * sizeof(nmd_vec2));
+        if (!temp_normals)
+            return;
+#else
+        nmd_vec2* temp_normals = (nmd_vec2*)NMD_ALLOCA(2 * num_points * sizeof(nmd_vec2));
+#endif
+        nmd_vec2* miters = temp_normals + num_points;
+
+        /* The inverse squared length of the averaged normals is limited to 2(the length to 0.5) */
+        _nmd_compute_normals(points, num_points, true, temp_normals);
+        _nmd_compute_miters(temp_normals, num_points, true, 2.0f, miters);
+
+        /* Add vertices: the inner edge and the outer edge of the anti-aliasing fringe */
+        const float offsets[2] = { -AA_SIZE * 0.5f, AA_SIZE * 0.5f };
+        const nmd_color colors[2] = { color, col_trans };
+        _nmd_add_miter_vertices(points, miters, num_points, offsets, colors, 2);
 
 #ifdef NMD_GRAPHICS_AVOID_ALLOCA
-        NMD_FREE(temp_normals);
+        _nmd_frame_release(temp_normals, 2 * num_points * sizeof(nmd_vec2));
 #endif /* NMD_GRAPHICS_AVOID_ALLOCA */
     }
     else
@@ -798,16 +1094,16 @@ void nmd_add_convex_polygon_filled(const nmd_vec2* points, size_t num_points, nm
         if (!_nmd_reserve(num_points, (num_points - 2) * 3))
             return;
 
-        const size_t offset = _nmd_context.draw_list.num_vertices;
-        nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
+        const size_t offset = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
+        nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
         for (size_t i = 2; i < num_points; i++)
             indices[(i - 2) * 3 + 0] = offset, indices[(i - 2) * 3 + 1] = offset + (i - 1), indices[(i - 2) * 3 + 2] = offset + i;
-        _nmd_context.draw_list.num_indices += (num_points - 2) * 3;
+        _nmd_context->draw_list.num_indices += (num_points - 2) * 3;
 
-        nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
+        nmd_vertex* vertices = _nmd_context->draw_list.vertices + _nmd_context->draw_list.num_vertices;
         for (size_t i = 0; i < num_points; i++)
             vertices[i].pos.x = points[i].x, vertices[i].pos.y = points[i].y, vertices[i].color = color;
-        _nmd_context.draw_list.num_vertices += num_points;
+        _nmd_context->draw_list.num_vertices += num_points;
     }
 }
 
@@ -1008,7 +1304,7 @@ void DrawList::AddBezierCurve(const nmd_vec2& p1, const nmd_vec2& p2, const nmd_
 }
 void nmd_add_text(float x, float y, const char* text, nmd_color color)
 {
-    nmd_add_text(_nmd_context.draw_list.defaultFont, x, y, text, color);
+    nmd_add_text(_nmd_context->draw_list.defaultFont, x, y, text, color);
 }
 */
 
@@ -1030,19 +1326,19 @@ void nmd_add_text(const nmd_atlas* font, float x, float y, const char* text, con
     {
         stbtt_GetBakedQuad((stbtt_bakedchar*)font->baked_chars, 512, 512, *text - 32, &x, &y, &q, 1);
 
-        const size_t offset = _nmd_context.draw_list.num_vertices;
+        const size_t offset = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
 
-        nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
+        nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
         indices[0] = offset + 0; indices[1] = offset + 1; indices[2] = offset + 2;
         indices[3] = offset + 0; indices[4] = offset + 2; indices[5] = offset + 3;
-        _nmd_context.draw_list.num_indices += 6;
+        _nmd_context->draw_list.num_indices += 6;
         
-        nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
+        nmd_vertex* vertices = _nmd_context->draw_list.vertices + _nmd_context->draw_list.num_vertices;
         vertices[0].pos.x = q.x0; vertices[0].pos.y = q.y0; vertices[0].uv.x = q.s0; vertices[0].uv.y = q.t0; vertices[0].color = color;
         vertices[1].pos.x = q.x1; vertices[1].pos.y = q.y0; vertices[1].uv.x = q.s1; vertices[1].uv.y = q.t0; vertices[1].color = color;
         vertices[2].pos.x = q.x1; vertices[2].pos.y = q.y1; vertices[2].uv.x = q.s1; vertices[2].uv.y = q.t1; vertices[2].color = color;
         vertices[3].pos.x = q.x0; vertices[3].pos.y = q.y1; vertices[3].uv.x = q.s0; vertices[3].uv.y = q.t1; vertices[3].color = color;
-        _nmd_context.draw_list.num_vertices += 4;
+        _nmd_context->draw_list.num_vertices += 4;
     }
 
     nmd_push_texture_draw_command(font->font_id, 0);
@@ -1072,6 +1368,9 @@ void nmd_add_image_uv(nmd_tex_id user_texture_id, float x0, float y0, float x1,
     if (!color.a)
         return;
 
+    if (!_nmd_reserve(4, 6))
+        return;
+
     nmd_push_draw_command(0);
 
     nmd_prim_rect_uv(x0, y0, x1, y1, uv_x0, uv_y0, uv_x1, uv_y1, color);
@@ -1089,6 +1388,9 @@ void nmd_add_image_quad_uv(nmd_tex_id user_texture_id, float x0, float y0, float
     if (!color.a)
         return;
 
+    if (!_nmd_reserve(4, 6))
+        return;
+
     nmd_push_draw_command(0);
 
     nmd_prim_quad_uv(x0, y0, x1, y1, x2, y2, x3, y3, uv_x0, uv_y0, uv_x1, uv_y1, uv_x2, uv_y2, uv_x3, uv_y3, color);
@@ -1112,10 +1414,10 @@ void nmd_add_image_rounded_uv(nmd_tex_id user_texture_id, float x0, float y0, fl
     {
         nmd_push_draw_command(0);
 
-        const int vert_start_idx = _nmd_context.draw_list.num_vertices;
+        const int vert_start_idx = _nmd_context->draw_list.num_vertices;
         nmd_path_rect(x0, y0, x1, y1, rounding, corner_flags);
         nmd_path_fill_convex(color);
-        const int vert_end_idx = _nmd_context.draw_list.num_vertices;
+        const int vert_end_idx = _nmd_context->draw_list.num_vertices;
 
         _nmd_shade_verts_linear_uv(vert_start_idx, vert_end_idx, x0, y0, x1, y1, uv_x0, uv_y0, uv_x1, uv_y1, true);
 
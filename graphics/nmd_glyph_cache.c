@@ -0,0 +1,607 @@
+#include "nmd_common.h"
+
+/* The number of pixels between glyphs in a page, so bilinear filtering doesn't sample the neighbours */
+#define _NMD_GLYPH_PADDING 1
+
+void nmd_glyph_cache_init(nmd_glyph_cache* cache, int page_size, nmd_tex_id(*create_texture)(void* pixels, int width, int height), void (*update_texture)(nmd_tex_id texture, const void* pixels, int x, int y, int width, int height, int pitch))
+{
+    NMD_MEMSET(cache, 0, sizeof(nmd_glyph_cache));
+    cache->page_size = page_size > 0 ? page_size : NMD_GLYPH_PAGE_SIZE;
+    cache->create_texture = create_texture;
+    cache->update_texture = update_texture;
+    cache->next_font_id = 1;
+}
+
+void nmd_glyph_cache_destroy(nmd_glyph_cache* cache)
+{
+    for (size_t i = 0; i < cache->num_pages; i++)
+    {
+        _nmd_free(cache->pages[i].pixels);
+        _nmd_free(cache->pages[i].skyline);
+    }
+    _nmd_free(cache->pages);
+    _nmd_free(cache->glyphs);
+    _nmd_free(cache->layouts);
+    _nmd_free(cache->quads);
+    _nmd_free(cache->text);
+    NMD_MEMSET(cache, 0, sizeof(nmd_glyph_cache));
+}
+
+void _nmd_clear_layouts(nmd_glyph_cache* cache)
+{
+    if (cache->layouts)
+        NMD_MEMSET(cache->layouts, 0, cache->layouts_capacity * sizeof(nmd_text_layout));
+    cache->num_layouts = 0;
+    cache->num_quads = 0;
+    cache->text_length = 0;
+}
+
+/* Resets the skyline of a page, so the whole page is free */
+void _nmd_reset_glyph_page(nmd_glyph_cache* cache, nmd_glyph_page* page)
+{
+    page->skyline[0].x = 0;
+    page->skyline[0].y = 0;
+    page->skyline[0].width = cache->page_size;
+    page->num_nodes = 1;
+}
+
+void nmd_glyph_cache_clear(nmd_glyph_cache* cache)
+{
+    for (size_t i = 0; i < cache->num_pages; i++)
+    {
+        nmd_glyph_page* page = &cache->pages[i];
+        _nmd_reset_glyph_page(cache, page);
+
+        /* White like a new page, only the alpha is rasterized */
+        for (size_t j = 0; j < (size_t)(cache->page_size * cache->page_size); j++)
+            page->pixels[j] = nmd_rgba(255, 255, 255, 0);
+        page->dirty_x0 = page->dirty_y0 = 0;
+        page->dirty_x1 = page->dirty_y1 = cache->page_size;
+    }
+
+    if (cache->glyphs)
+        NMD_MEMSET(cache->glyphs, 0, cache->glyphs_capacity * sizeof(nmd_glyph));
+    cache->num_glyphs = 0;
+
+    _nmd_clear_layouts(cache);
+}
+
+void nmd_glyph_cache_upload(nmd_glyph_cache* cache)
+{
+    for (size_t i = 0; i < cache->num_pages; i++)
+    {
+        nmd_glyph_page* page = &cache->pages[i];
+        if (page->dirty_x0 >= page->dirty_x1)
+            continue;
+
+        if (cache->update_texture && page->texture)
+            cache->update_texture(page->texture, page->pixels + page->dirty_y0 * cache->page_size + page->dirty_x0, page->dirty_x0, page->dirty_y0, page->dirty_x1 - page->dirty_x0, page->dirty_y1 - page->dirty_y0, cache->page_size * sizeof(nmd_color));
+
+        page->dirty_x0 = page->dirty_y0 = cache->page_size;
+        page->dirty_x1 = page->dirty_y1 = 0;
+    }
+}
+
+/* Adds a page to the glyph cache and creates its texture. Returns a null pointer if memory could not be allocated. */
+nmd_glyph_page* _nmd_add_glyph_page(nmd_glyph_cache* cache)
+{
+    if (cache->num_pages == cache->pages_capacity)
+    {
+        const size_t new_capacity = NMD_MAX(cache->pages_capacity * 2, 4);
+        void* mem = _nmd_alloc(new_capacity * sizeof(nmd_glyph_page));
+        if (!mem)
+            return 0;
+        if (cache->pages)
+            NMD_MEMCPY(mem, cache->pages, cache->num_pages * sizeof(nmd_glyph_page));
+        _nmd_free(cache->pages);
+
+        cache->pages = (nmd_glyph_page*)mem;
+        cache->pages_capacity = new_capacity;
+    }
+
+    nmd_glyph_page* page = &cache->pages[cache->num_pages];
+    NMD_MEMSET(page, 0, sizeof(nmd_glyph_page));
+    page->pixels = (nmd_color*)_nmd_alloc(cache->page_size * cache->page_size * sizeof(nmd_color));
+    page->skyline = (nmd_skyline_node*)_nmd_alloc(cache->page_size * sizeof(nmd_skyline_node));
+    if (!page->pixels || !page->skyline)
+    {
+        _nmd_free(page->pixels);
+        _nmd_free(page->skyline);
+        return 0;
+    }
+
+    /* The pixels are white so the texture can be sampled like the baked atlas, only the alpha is rasterized */
+    for (size_t i = 0; i < (size_t)(cache->page_size * cache->page_size); i++)
+        page->pixels[i] = nmd_rgba(255, 255, 255, 0);
+    page->texture = cache->create_texture ? cache->create_texture(page->pixels, cache->page_size, cache->page_size) : 0;
+    page->dirty_x0 = page->dirty_y0 = cache->page_size;
+    page->dirty_x1 = page->dirty_y1 = 0;
+    _nmd_reset_glyph_page(cache, page);
+
+    cache->num_pages++;
+    return page;
+}
+
+/* Moves the nodes of the skyline from index 'from' to the end, so they start at index 'to' */
+void _nmd_move_skyline_nodes(nmd_glyph_page* page, size_t from, size_t to)
+{
+    const size_t num_moved = page->num_nodes - from;
+    if (to < from)
+    {
+        for (size_t i = 0; i < num_moved; i++)
+            page->skyline[to + i] = page->skyline[from + i];
+    }
+    else
+    {
+        for (size_t i = num_moved; i > 0; i--)
+            page->skyline[to + i - 1] = page->skyline[from + i - 1];
+    }
+    page->num_nodes = to + num_moved;
+}
+
+/*
+Finds the lowest position of the skyline where a 'width' x 'height' rectangle fits(the leftmost one if there're several) and adds the rectangle to the skyline.
+Returns false if the rectangle doesn't fit in the page.
+*/
+bool _nmd_skyline_pack(nmd_glyph_cache* cache, nmd_glyph_page* page, int width, int height, int* x_out, int* y_out)
+{
+    size_t best = (size_t)-1;
+    int best_y = cache->page_size, best_waste = 0;
+
+    for (size_t i = 0; i < page->num_nodes; i++)
+    {
+        const int x = page->skyline[i].x;
+        if (x + width > cache->page_size)
+            break;
+
+        /* The rectangle rests on the highest node under it */
+        int y = 0, covered = 0;
+        size_t j = i;
+        for (; covered < width; j++)
+        {
+            y = NMD_MAX(y, page->skyline[j].y);
+            covered += page->skyline[j].width;
+        }
+
+        if (y + height > cache->page_size)
+            continue;
+
+        /* Prefer the lowest position, then the one that wastes less area under the rectangle */
+        int waste = 0;
+        for (size_t k = i; k < j; k++)
+            waste += (y - page->skyline[k].y) * page->skyline[k].width;
+        if (y < best_y || (y == best_y && waste < best_waste))
+        {
+            best = i;
+            best_y = y;
+            best_waste = waste;
+        }
+    }
+
+    if (best == (size_t)-1)
+        return false;
+
+    /* The new node replaces the nodes under the rectangle, the last one may be partially covered */
+    const int x = page->skyline[best].x;
+    size_t end = best;
+    while (end < page->num_nodes && page->skyline[end].x + page->skyline[end].width <= x + width)
+        end++;
+
+    nmd_skyline_node remainder;
+    const bool has_remainder = end < page->num_nodes && page->skyline[end].x < x + width;
+    if (has_remainder)
+    {
+        remainder.x = x + width;
+        remainder.y = page->skyline[end].y;
+        remainder.width = page->skyline[end].x + page->skyline[end].width - (x + width);
+        end++;
+    }
+
+    const size_t num_new_nodes = has_remainder ? 2 : 1;
+    _nmd_move_skyline_nodes(page, end, best + num_new_nodes);
+
+    page->skyline[best].x = x;
+    page->skyline[best].y = best_y + height;
+    page->skyline[best].width = width;
+    if (has_remainder)
+        page->skyline[best + 1] = remainder;
+
+    /* Merge neighbours at the same height */
+    for (size_t i = (best > 0 ? best - 1 : 0); i + 1 < page->num_nodes && i <= best + 1;)
+    {
+        if (page->skyline[i].y == page->skyline[i + 1].y)
+        {
+            page->skyline[i].width += page->skyline[i + 1].width;
+            _nmd_move_skyline_nodes(page, i + 2, i + 1);
+        }
+        else
+            i++;
+    }
+
+    *x_out = x;
+    *y_out = best_y;
+    return true;
+}
+
+uint32_t _nmd_hash_glyph(uint32_t font_id, float size, uint32_t codepoint)
+{
+    uint32_t size_bits;
+    NMD_MEMCPY(&size_bits, &size, sizeof(size_bits));
+    uint32_t hash = font_id * 0x9E3779B1u ^ size_bits * 0x85EBCA77u ^ codepoint * 0xC2B2AE3Du;
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6Du;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+/* Rasterizes a glyph into a page. 'glyph' has the key fields set. */
+void _nmd_rasterize_glyph(const nmd_font* font, nmd_glyph* glyph)
+{
+    nmd_glyph_cache* const cache = font->cache;
+    const stbtt_fontinfo* const info = (const stbtt_fontinfo*)font->info;
+    const float scale = stbtt_ScaleForPixelHeight(info, glyph->size);
+    const int glyph_index = stbtt_FindGlyphIndex(info, glyph->codepoint);
+
+    int advance, left_side_bearing;
+    stbtt_GetGlyphHMetrics(info, glyph_index, &advance, &left_side_bearing);
+    glyph->advance = advance * scale;
+
+    int x0, y0, x1, y1;
+    stbtt_GetGlyphBitmapBox(info, glyph_index, scale, scale, &x0, &y0, &x1, &y1);
+    const int width = x1 - x0, height = y1 - y0;
+    glyph->texture = 0;
+    if (width <= 0 || height <= 0 || width + _NMD_GLYPH_PADDING > cache->page_size || height + _NMD_GLYPH_PADDING > cache->page_size)
+        return;
+
+    /* The glyph is packed in the last page, a new one is added when it's full */
+    nmd_glyph_page* page = cache->num_pages ? &cache->pages[cache->num_pages - 1] : 0;
+    int x, y;
+    if (!page || !_nmd_skyline_pack(cache, page, width + _NMD_GLYPH_PADDING, height + _NMD_GLYPH_PADDING, &x, &y))
+    {
+        if (!(page = _nmd_add_glyph_page(cache)) || !_nmd_skyline_pack(cache, page, width + _NMD_GLYPH_PADDING, height + _NMD_GLYPH_PADDING, &x, &y))
+            return;
+    }
+
+    /* Rasterize the coverage in temporary memory and store it in the alpha channel */
+    uint8_t* coverage = (uint8_t*)_nmd_frame_alloc(width * height);
+    if (!coverage)
+        return;
+    stbtt_MakeGlyphBitmap(info, coverage, width, height, width, scale, scale, glyph_index);
+    for (int row = 0; row < height; row++)
+    {
+        nmd_color* pixels = page->pixels + (y + row) * cache->page_size + x;
+        for (int column = 0; column < width; column++)
+            pixels[column].a = coverage[row * width + column];
+    }
+    _nmd_frame_release(coverage, width * height);
+
+    page->dirty_x0 = NMD_MIN(page->dirty_x0, x);
+    page->dirty_y0 = NMD_MIN(page->dirty_y0, y);
+    page->dirty_x1 = NMD_MAX(page->dirty_x1, x + width);
+    page->dirty_y1 = NMD_MAX(page->dirty_y1, y + height);
+
+    glyph->texture = page->texture;
+    glyph->x0 = (float)x0, glyph->y0 = (float)y0;
+    glyph->x1 = (float)x1, glyph->y1 = (float)y1;
+    glyph->u0 = x / (float)cache->page_size, glyph->v0 = y / (float)cache->page_size;
+    glyph->u1 = (x + width) / (float)cache->page_size, glyph->v1 = (y + height) / (float)cache->page_size;
+}
+
+/* Returns the glyph of 'codepoint' at 'size' pixels, it's rasterized if it's not in the cache. Returns a null pointer if memory could not be allocated. */
+const nmd_glyph* _nmd_get_glyph(const nmd_font* font, float size, uint32_t codepoint)
+{
+    nmd_glyph_cache* const cache = font->cache;
+
+    /* Keep the load factor under 70% */
+    if ((cache->num_glyphs + 1) * 10 > cache->glyphs_capacity * 7)
+    {
+        const size_t new_capacity = NMD_MAX(cache->glyphs_capacity * 2, 256);
+        nmd_glyph* glyphs = (nmd_glyph*)_nmd_alloc(new_capacity * sizeof(nmd_glyph));
+        if (!glyphs)
+            return 0;
+        NMD_MEMSET(glyphs, 0, new_capacity * sizeof(nmd_glyph));
+
+        for (size_t i = 0; i < cache->glyphs_capacity; i++)
+        {
+            const nmd_glyph* glyph = &cache->glyphs[i];
+            if (!glyph->font_id)
+                continue;
+
+            size_t slot = _nmd_hash_glyph(glyph->font_id, glyph->size, glyph->codepoint) & (new_capacity - 1);
+            while (glyphs[slot].font_id)
+                slot = (slot + 1) & (new_capacity - 1);
+            glyphs[slot] = *glyph;
+        }
+
+        _nmd_free(cache->glyphs);
+        cache->glyphs = glyphs;
+        cache->glyphs_capacity = new_capacity;
+    }
+
+    size_t slot = _nmd_hash_glyph(font->id, size, codepoint) & (cache->glyphs_capacity - 1);
+    for (; cache->glyphs[slot].font_id; slot = (slot + 1) & (cache->glyphs_capacity - 1))
+    {
+        const nmd_glyph* glyph = &cache->glyphs[slot];
+        if (glyph->font_id == font->id && glyph->codepoint == codepoint && glyph->size == size)
+            return glyph;
+    }
+
+    nmd_glyph* glyph = &cache->glyphs[slot];
+    glyph->font_id = font->id;
+    glyph->codepoint = codepoint;
+    glyph->size = size;
+    _nmd_rasterize_glyph(font, glyph);
+    cache->num_glyphs++;
+
+    return glyph;
+}
+
+/* Decodes the UTF-8 character at '*text' and advances '*text'. Invalid sequences are decoded as U+FFFD one byte at a time. */
+uint32_t _nmd_decode_utf8(const char** text, const char* text_end)
+{
+    const uint8_t* s = (const uint8_t*)*text;
+    const size_t available = (const uint8_t*)text_end - s;
+    uint32_t codepoint;
+    size_t length;
+
+    if (s[0] < 0x80)
+        codepoint = s[0], length = 1;
+    else if ((s[0] & 0xe0) == 0xc0)
+        codepoint = s[0] & 0x1f, length = 2;
+    else if ((s[0] & 0xf0) == 0xe0)
+        codepoint = s[0] & 0x0f, length = 3;
+    else if ((s[0] & 0xf8) == 0xf0)
+        codepoint = s[0] & 0x07, length = 4;
+    else
+        length = 0;
+
+    if (!length || length > available)
+    {
+        (*text)++;
+        return 0xfffd;
+    }
+
+    for (size_t i = 1; i < length; i++)
+    {
+        if ((s[i] & 0xc0) != 0x80)
+        {
+            (*text)++;
+            return 0xfffd;
+        }
+        codepoint = (codepoint << 6) | (s[i] & 0x3f);
+    }
+
+    *text += length;
+    return codepoint;
+}
+
+uint64_t _nmd_hash_text(const char* text, size_t length)
+{
+    /* FNV-1a */
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < length; i++)
+        hash = (hash ^ (uint8_t)text[i]) * 0x100000001b3ull;
+    return hash;
+}
+
+/*
+Returns the layout of a string, the string is laid out if it's not in the cache. Returns a null pointer if memory could not be allocated.
+The returned pointer and the quads are valid until the next layout is added.
+*/
+const nmd_text_layout* _nmd_get_text_layout(const nmd_font* font, float size, const char* text, const char* text_end)
+{
+    nmd_glyph_cache* const cache = font->cache;
+    const size_t length = text_end - text;
+    const uint64_t hash = _nmd_hash_text(text, length);
+
+    if (cache->layouts)
+    {
+        size_t slot = (size_t)(hash ^ font->id) & (cache->layouts_capacity - 1);
+        for (; cache->layouts[slot].font_id; slot = (slot + 1) & (cache->layouts_capacity - 1))
+        {
+            const nmd_text_layout* layout = &cache->layouts[slot];
+            if (layout->hash == hash && layout->length == length && layout->font_id == font->id && layout->size == size && NMD_MEMCMP(cache->text + layout->first_char, text, length) == 0)
+                return layout;
+        }
+    }
+
+    /* Every byte needs at most one quad. When the cache is full, the layouts are discarded */
+    if (cache->text_length + length > NMD_TEXT_LAYOUT_CACHE_SIZE)
+        _nmd_clear_layouts(cache);
+
+    /* Keep the load factor under 70% */
+    if ((cache->num_layouts + 1) * 10 > cache->layouts_capacity * 7)
+    {
+        const size_t new_capacity = NMD_MAX(cache->layouts_capacity * 2, 256);
+        nmd_text_layout* layouts = (nmd_text_layout*)_nmd_alloc(new_capacity * sizeof(nmd_text_layout));
+        if (!layouts)
+            return 0;
+        NMD_MEMSET(layouts, 0, new_capacity * sizeof(nmd_text_layout));
+
+        for (size_t i = 0; i < cache->layouts_capacity; i++)
+        {
+            const nmd_text_layout* layout = &cache->layouts[i];
+            if (!layout->font_id)
+                continue;
+
+            size_t slot = (size_t)(layout->hash ^ layout->font_id) & (new_capacity - 1);
+            while (layouts[slot].font_id)
+                slot = (slot + 1) & (new_capacity - 1);
+            layouts[slot] = *layout;
+        }
+
+        _nmd_free(cache->layouts);
+        cache->layouts = layouts;
+        cache->layouts_capacity = new_capacity;
+    }
+
+    if (cache->num_quads + length > cache->quads_capacity)
+    {
+        const size_t new_capacity = NMD_MAX(NMD_MAX(cache->quads_capacity * 2, cache->num_quads + length), 1024);
+        void* mem = _nmd_alloc(new_capacity * sizeof(nmd_glyph_quad));
+        if (!mem)
+            return 0;
+        if (cache->quads)
+            NMD_MEMCPY(mem, cache->quads, cache->num_quads * sizeof(nmd_glyph_quad));
+        _nmd_free(cache->quads);
+
+        cache->quads = (nmd_glyph_quad*)mem;
+        cache->quads_capacity = new_capacity;
+    }
+
+    if (cache->text_length + length > cache->text_capacity)
+    {
+        const size_t new_capacity = NMD_MAX(NMD_MAX(cache->text_capacity * 2, cache->text_length + length), 4096);
+        void* mem = _nmd_alloc(new_capacity);
+        if (!mem)
+            return 0;
+        if (cache->text)
+            NMD_MEMCPY(mem, cache->text, cache->text_length);
+        _nmd_free(cache->text);
+
+        cache->text = (char*)mem;
+        cache->text_capacity = new_capacity;
+    }
+
+    /* Keep the bytes, a hit must match the string and not only its hash */
+    const size_t first_char = cache->text_length;
+    if (length)
+        NMD_MEMCPY(cache->text + first_char, text, length);
+    cache->text_length += length;
+
+    /* Lay out the string at the origin. The quads are snapped to pixels like stbtt_GetBakedQuad() does */
+    const stbtt_fontinfo* const info = (const stbtt_fontinfo*)font->info;
+    const float scale = stbtt_ScaleForPixelHeight(info, size);
+    const size_t first_quad = cache->num_quads;
+    float pen_x = 0.0f;
+    while (text < text_end)
+    {
+        const nmd_glyph* glyph = _nmd_get_glyph(font, size, _nmd_decode_utf8(&text, text_end));
+        if (!glyph)
+            return 0;
+
+        if (glyph->texture)
+        {
+            nmd_glyph_quad* quad = &cache->quads[cache->num_quads++];
+            const float x = (float)(int)(pen_x + glyph->x0 + 0.5f);
+            quad->x0 = x;
+            quad->y0 = glyph->y0;
+            quad->x1 = x + glyph->x1 - glyph->x0;
+            quad->y1 = glyph->y1;
+            quad->u0 = glyph->u0, quad->v0 = glyph->v0;
+            quad->u1 = glyph->u1, quad->v1 = glyph->v1;
+            quad->texture = glyph->texture;
+        }
+
+        pen_x += glyph->advance;
+    }
+
+    size_t slot = (size_t)(hash ^ font->id) & (cache->layouts_capacity - 1);
+    while (cache->layouts[slot].font_id)
+        slot = (slot + 1) & (cache->layouts_capacity - 1);
+
+    nmd_text_layout* layout = &cache->layouts[slot];
+    layout->hash = hash;
+    layout->length = length;
+    layout->first_char = first_char;
+    layout->font_id = font->id;
+    layout->size = size;
+    layout->first_quad = first_quad;
+    layout->num_quads = cache->num_quads - first_quad;
+    layout->text_size.x = pen_x;
+    layout->text_size.y = (font->ascent - font->descent) * scale;
+    cache->num_layouts++;
+
+    return layout;
+}
+
+bool nmd_font_init(nmd_font* font, nmd_glyph_cache* cache, const void* font_data)
+{
+    NMD_MEMSET(font, 0, sizeof(nmd_font));
+
+    stbtt_fontinfo* info = (stbtt_fontinfo*)_nmd_alloc(sizeof(stbtt_fontinfo));
+    if (!info)
+        return false;
+
+    if (!stbtt_InitFont(info, (const unsigned char*)font_data, stbtt_GetFontOffsetForIndex((const unsigned char*)font_data, 0)))
+    {
+        _nmd_free(info);
+        return false;
+    }
+
+    int line_gap;
+    stbtt_GetFontVMetrics(info, &font->ascent, &font->descent, &line_gap);
+
+    font->cache = cache;
+    font->data = font_data;
+    font->info = info;
+    font->id = cache->next_font_id++;
+
+    return true;
+}
+
+void nmd_font_destroy(nmd_font* font)
+{
+    _nmd_free(font->info);
+    NMD_MEMSET(font, 0, sizeof(nmd_font));
+}
+
+void nmd_add_text_cached(const nmd_font* font, float size, float x, float y, const char* text, const char* text_end, nmd_color color)
+{
+    if (!color.a)
+        return;
+
+    if (!text_end)
+        text_end = text + NMD_STRLEN(text);
+
+    const nmd_text_layout* layout = _nmd_get_text_layout(font, size, text, text_end);
+    if (!layout || !layout->num_quads || !_nmd_reserve(layout->num_quads * 4, layout->num_quads * 6))
+        return;
+
+    nmd_push_draw_command(0);
+
+    /* The quads were snapped to pixels at the origin, so the position is snapped too */
+    x = (float)(int)(x + 0.5f);
+    y = (float)(int)(y + 0.5f);
+
+    const nmd_glyph_quad* quad = font->cache->quads + layout->first_quad;
+    const nmd_glyph_quad* const quads_end = quad + layout->num_quads;
+    nmd_tex_id texture = quad->texture;
+    for (; quad < quads_end; quad++)
+    {
+        /* The glyphs of a string may be in different pages */
+        if (quad->texture != texture)
+        {
+            nmd_push_texture_draw_command(texture, 0);
+            texture = quad->texture;
+        }
+
+        const size_t offset = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
+
+        nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
+        indices[0] = offset + 0; indices[1] = offset + 1; indices[2] = offset + 2;
+        indices[3] = offset + 0; indices[4] = offset + 2; indices[5] = offset + 3;
+        _nmd_context->draw_list.num_indices += 6;
+
+        nmd_vertex* vertices = _nmd_context->draw_list.vertices + _nmd_context->draw_list.num_vertices;
+        vertices[0].pos.x = x + quad->x0; vertices[0].pos.y = y + quad->y0; vertices[0].uv.x = quad->u0; vertices[0].uv.y = quad->v0; vertices[0].color = color;
+        vertices[1].pos.x = x + quad->x1; vertices[1].pos.y = y + quad->y0; vertices[1].uv.x = quad->u1; vertices[1].uv.y = quad->v0; vertices[1].color = color;
+        vertices[2].pos.x = x + quad->x1; vertices[2].pos.y = y + quad->y1; vertices[2].uv.x = quad->u1; vertices[2].uv.y = quad->v1; vertices[2].color = color;
+        vertices[3].pos.x = x + quad->x0; vertices[3].pos.y = y + quad->y1; vertices[3].uv.x = quad->u0; vertices[3].uv.y = quad->v1; vertices[3].color = color;
+        _nmd_context->draw_list.num_vertices += 4;
+    }
+
+    nmd_push_texture_draw_command(texture, 0);
+}
+
+void nmd_get_text_size_cached(const nmd_font* font, float size, const char* text, const char* text_end, nmd_vec2* size_out)
+{
+    if (!text_end)
+        text_end = text + NMD_STRLEN(text);
+
+    const nmd_text_layout* layout = _nmd_get_text_layout(font, size, text, text_end);
+    if (layout)
+        *size_out = layout->text_size;
+    else
+        size_out->x = size_out->y = 0.0f;
+}
@@ -1,7 +1,7 @@
 #include "nmd_common.h"
 
-nmd_context _nmd_context;
-bool _nmd_initialized = false;
+nmd_context _nmd_default_context;
+NMD_THREAD_LOCAL nmd_context* _nmd_context = &_nmd_default_context;
 
 nmd_color nmd_rgb(uint8_t r, uint8_t g, uint8_t b)
 {
@@ -19,99 +19,460 @@ nmd_color nmd_rgba(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
     return color;
 }
 
+/* Returns the current context of the calling thread. */
 nmd_context* nmd_get_context()
 {
-    return &_nmd_context;
+    return _nmd_context;
 }
 
 /*
-Creates one or more draw commands for the unaccounted vertices and indices.
-Parameters:
- clip_rect [opt/in] A pointer to a rect that specifies the clip area. This parameter can be null.
+Makes 'context' the current context of the calling thread. All functions of the library(except the ones that take a context) use the current context.
+If 'context' is null, the default context is used, which is also the current context of threads that didn't call this function.
 */
-void nmd_push_draw_command(const nmd_rect* clip_rect)
+void nmd_set_context(nmd_context* context)
 {
-    /* Calculate the number of vertices and indices present in draw commands */
-    size_t num_accounted_vertices = 0, num_accounted_indices = 0;
-    size_t i = 0;
-    for (; i < _nmd_context.draw_list.num_draw_commands; i++)
+    if (!context)
+        context = &_nmd_default_context;
+
+    /* The renderers may have rendered another context, so the render state they set is not known */
+    if (context != _nmd_context)
     {
-        num_accounted_vertices += _nmd_context.draw_list.draw_commands[i].num_vertices;
-        num_accounted_indices += _nmd_context.draw_list.draw_commands[i].num_indices;
+        _nmd_context = context;
+        _nmd_context->render_state.known = NMD_RENDER_STATE_NONE;
     }
+}
+
+/*
+Specifies the allocator used for all memory. If 'allocator' is null, the default allocator(NMD_MALLOC()/NMD_FREE()) is used.
+This function must be called before any other function of the library allocates memory, because memory is freed by the allocator that is set when it's freed.
+*/
+void nmd_set_allocator(const nmd_allocator* allocator)
+{
+    if (allocator)
+        _nmd_context->allocator = *allocator;
+    else
+        NMD_MEMSET(&_nmd_context->allocator, 0, sizeof(nmd_allocator));
+}
 
-    /* Calculate the number of vertices and indices NOT present in draw commands */
-    size_t num_unaccounted_indices = _nmd_context.draw_list.num_indices - num_accounted_indices;
+void nmd_set_profiler(nmd_profiler profiler, void* user_data)
+{
+    _nmd_context->profiler = profiler;
+    _nmd_context->profiler_user_data = user_data;
+}
+
+/* Calls the profiler of the context, if any, when the function 'zone' begins('begin' is true) or ends */
+void _nmd_profile(const char* zone, bool begin)
+{
+    if (_nmd_context->profiler)
+        _nmd_context->profiler(zone, begin, _nmd_context->profiler_user_data);
+}
+
+/* Allocates memory with the allocator of the context. Returns a null pointer if the allocation fails. */
+void* _nmd_alloc(size_t size)
+{
+    if (_nmd_context->allocator.alloc)
+        return _nmd_context->allocator.alloc(_nmd_context->allocator.user_data, size);
+
+#ifndef NMD_GRAPHICS_DISABLE_DEFAULT_ALLOCATOR
+    return NMD_MALLOC(size);
+#else
+    return 0;
+#endif /* NMD_GRAPHICS_DISABLE_DEFAULT_ALLOCATOR */
+}
+
+/* Frees memory allocated by _nmd_alloc(). 'ptr' may be null. */
+void _nmd_free(void* ptr)
+{
+    if (!ptr)
+        return;
 
-    /* Create draw commands until all vertices and indices are present in draw commands */
-    while (num_unaccounted_indices > 0)
+    if (_nmd_context->allocator.alloc)
+        _nmd_context->allocator.free(_nmd_context->allocator.user_data, ptr);
+#ifndef NMD_GRAPHICS_DISABLE_DEFAULT_ALLOCATOR
+    else
+        NMD_FREE(ptr);
+#endif /* NMD_GRAPHICS_DISABLE_DEFAULT_ALLOCATOR */
+}
+
+#define _NMD_FRAME_ALIGN(size) (((size) + (NMD_FRAME_ARENA_ALIGNMENT - 1)) & ~(size_t)(NMD_FRAME_ARENA_ALIGNMENT - 1))
+
+/*
+Specifies the memory of the frame arena, which is never resized. If 'memory' is null, the arena's memory is allocated by the allocator.
+Allocations that don't fit in the arena are made by the allocator, so 'size' should be at least 'nmd_get_context()->frame_arena.high_water' bytes.
+The memory must stay valid until nmd_set_frame_memory() is called again and the next nmd_new_frame() returns.
+*/
+void nmd_set_frame_memory(void* memory, size_t size)
+{
+    nmd_frame_arena* const arena = &_nmd_context->frame_arena;
+
+    /* The buffers are still in the arena's memory until the next frame, so the arena's block is freed by _nmd_reset_frame_arena() */
+    if (memory)
     {
-        /* If the number of unaccounted indices is less than the maximum number of indices that can be hold by 'nmd_index'(usually 2^16) */
-        if (num_unaccounted_indices < (1 << (8 * sizeof(nmd_index))))
-        {
-            /* Add draw command */
-            _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].num_vertices = _nmd_context.draw_list.num_vertices - num_accounted_vertices;
-            _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].num_indices = _nmd_context.draw_list.num_indices - num_accounted_indices;
-            _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].user_texture_id = _nmd_context.draw_list.blank_tex_id;
-            if (clip_rect)
-                _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].rect = *clip_rect;
-            else
-                _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].rect.p1.x = -1.0f;
-
-            _nmd_context.draw_list.num_draw_commands++;
-            return;
-        }
-        else
+        /* The allocations start at an aligned address */
+        const size_t padding = (NMD_FRAME_ARENA_ALIGNMENT - ((size_t)memory & (NMD_FRAME_ARENA_ALIGNMENT - 1))) & (NMD_FRAME_ARENA_ALIGNMENT - 1);
+        arena->memory = (uint8_t*)memory + padding;
+        arena->size = size > padding ? (size - padding) & ~(size_t)(NMD_FRAME_ARENA_ALIGNMENT - 1) : 0;
+        arena->used = 0;
+        arena->unused = 0;
+        arena->user_memory = true;
+    }
+    else if (arena->user_memory)
+    {
+        arena->memory = 0;
+        arena->size = 0;
+        arena->used = 0;
+        arena->unused = 0;
+        arena->user_memory = false;
+    }
+}
+
+/*
+Allocates memory in the frame arena. The memory is valid until the next call to nmd_new_frame().
+When the arena is full, the memory is allocated by the allocator. Returns a null pointer if the allocation fails.
+*/
+void* _nmd_frame_alloc(size_t size)
+{
+    nmd_frame_arena* const arena = &_nmd_context->frame_arena;
+    void* ptr;
+
+    size = _NMD_FRAME_ALIGN(size);
+    if (arena->size - arena->used >= size)
+    {
+        ptr = arena->memory + arena->used;
+        arena->used += size;
+    }
+    else
+    {
+        /* The overflow blocks are linked by a pointer before the allocation */
+        uint8_t* block = (uint8_t*)_nmd_alloc(NMD_FRAME_ARENA_ALIGNMENT + size);
+        if (!block)
+            return 0;
+
+        *(void**)block = arena->overflow;
+        arena->overflow = block;
+        arena->overflow_size += NMD_FRAME_ARENA_ALIGNMENT + size;
+        ptr = block + NMD_FRAME_ARENA_ALIGNMENT;
+    }
+
+    arena->high_water = NMD_MAX(arena->high_water, arena->used + arena->overflow_size - arena->unused);
+
+    return ptr;
+}
+
+/*
+Grows a buffer of 'size' bytes allocated by _nmd_frame_alloc() to 'new_size' bytes. Returns the pointer to the buffer, or a null pointer if the allocation fails,
+in which case 'ptr' is still valid. If the buffer is the last allocation in the arena and there's enough space, it grows in place, otherwise it's copied.
+*/
+void* _nmd_frame_realloc(void* ptr, size_t size, size_t new_size)
+{
+    nmd_frame_arena* const arena = &_nmd_context->frame_arena;
+    if (arena->memory && (uint8_t*)ptr + _NMD_FRAME_ALIGN(size) == arena->memory + arena->used && arena->size - (arena->used - _NMD_FRAME_ALIGN(size)) >= _NMD_FRAME_ALIGN(new_size))
+    {
+        arena->used += _NMD_FRAME_ALIGN(new_size) - _NMD_FRAME_ALIGN(size);
+        arena->high_water = NMD_MAX(arena->high_water, arena->used + arena->overflow_size - arena->unused);
+        return ptr;
+    }
+
+    void* mem = _nmd_frame_alloc(new_size);
+    if (!mem)
+        return 0;
+    NMD_MEMCPY(mem, ptr, size);
+    arena->unused += _NMD_FRAME_ALIGN(size);
+    _nmd_context->stats.num_reallocations++;
+
+    return mem;
+}
+
+/* Releases temporary memory allocated by _nmd_frame_alloc(). The memory is reused by the next allocation if it's the last one in the arena, otherwise it's freed by nmd_new_frame(). */
+void _nmd_frame_release(void* ptr, size_t size)
+{
+    nmd_frame_arena* const arena = &_nmd_context->frame_arena;
+    if (arena->memory && (uint8_t*)ptr + _NMD_FRAME_ALIGN(size) == arena->memory + arena->used)
+        arena->used -= _NMD_FRAME_ALIGN(size);
+    else
+        arena->unused += _NMD_FRAME_ALIGN(size);
+}
+
+/*
+Frees the memory of the previous frame and allocates the buffers of the draw list in the frame arena with their previous capacities. If the arena is not provided
+by the application, it's resized to the high-water mark first, so the buffers and the temporary memory of a frame like the previous ones fit in it.
+*/
+void _nmd_reset_frame_arena()
+{
+    nmd_frame_arena* const arena = &_nmd_context->frame_arena;
+    nmd_drawlist* const draw_list = &_nmd_context->draw_list;
+
+    while (arena->overflow)
+    {
+        void* next = *(void**)arena->overflow;
+        _nmd_free(arena->overflow);
+        arena->overflow = next;
+    }
+    arena->overflow_size = 0;
+    arena->used = 0;
+    arena->unused = 0;
+
+    if (arena->user_memory)
+    {
+        _nmd_free(arena->block);
+        arena->block = 0;
+    }
+    else
+    {
+        const size_t buffers_size = _NMD_FRAME_ALIGN(draw_list->path_capacity) + _NMD_FRAME_ALIGN(draw_list->draw_commands_capacity) + _NMD_FRAME_ALIGN(draw_list->indices_capacity) + _NMD_FRAME_ALIGN(draw_list->vertices_capacity);
+        const size_t size = _NMD_FRAME_ALIGN(NMD_MAX(arena->high_water, buffers_size));
+        if (size > arena->size || !arena->block)
         {
-            size_t num_indices = (1 << (8 * sizeof(nmd_index)));
-            nmd_index last_index = _nmd_context.draw_list.indices[num_indices - 1];
-
-            bool is_last_index_referenced = false;
-            do
-            {
-                for (size_t i = num_indices; i < num_unaccounted_indices; i++)
-                {
-                    if (_nmd_context.draw_list.indices[i] == last_index)
-                    {
-                        is_last_index_referenced = true;
-                        num_indices -= 3;
-                        last_index = _nmd_context.draw_list.indices[num_indices - 1];
-                        break;
-                    }
-                }
-            } while (is_last_index_referenced);
-
-            _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].num_vertices = last_index + 1;
-            _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].num_indices = num_indices;
-            _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].user_texture_id = _nmd_context.draw_list.blank_tex_id;
-
-            _nmd_context.draw_list.num_draw_commands++;
-
-            num_unaccounted_indices -= num_indices;
+            _nmd_free(arena->block);
+            arena->block = _nmd_alloc(NMD_FRAME_ARENA_ALIGNMENT - 1 + size);
+            arena->memory = arena->block ? (uint8_t*)_NMD_FRAME_ALIGN((size_t)arena->block) : 0;
+            arena->size = arena->block ? size : 0;
         }
     }
+
+    /* The vertex buffer usually grows the most, so it's the last one */
+    draw_list->path = (nmd_vec2*)_nmd_frame_alloc(draw_list->path_capacity);
+    draw_list->path_capacity = draw_list->path ? draw_list->path_capacity : 0;
+
+    draw_list->draw_commands = (nmd_draw_command*)_nmd_frame_alloc(draw_list->draw_commands_capacity);
+    draw_list->draw_commands_capacity = draw_list->draw_commands ? draw_list->draw_commands_capacity : 0;
+
+    draw_list->indices = (nmd_index*)_nmd_frame_alloc(draw_list->indices_capacity);
+    draw_list->indices_capacity = draw_list->indices ? draw_list->indices_capacity : 0;
+
+    draw_list->vertices = (nmd_vertex*)_nmd_frame_alloc(draw_list->vertices_capacity);
+    draw_list->vertices_capacity = draw_list->vertices ? draw_list->vertices_capacity : 0;
 }
 
-void nmd_push_texture_draw_command(nmd_tex_id user_texture_id, const nmd_rect* clip_rect)
+/*
+Initializes a context. The context uses the allocator, the render state settings, the blank texture and the default atlas of the current context, so the textures
+created by the renderers can be used by the draw lists of all contexts. A context can also be zero-initialized, in which case it uses the default settings and has no textures.
+*/
+void nmd_init_context(nmd_context* context)
 {
-    size_t num_accounted_vertices = 0, num_accounted_indices = 0;
-    size_t i = 0;
-    for (; i < _nmd_context.draw_list.num_draw_commands; i++)
+    NMD_MEMSET(context, 0, sizeof(nmd_context));
+    context->allocator = _nmd_context->allocator;
+    context->render_state.skip_backup = _nmd_context->render_state.skip_backup;
+    context->render_state.known_host_state = _nmd_context->render_state.known_host_state;
+    context->draw_list.blank_tex_id = _nmd_context->draw_list.blank_tex_id;
+    context->draw_list.default_atlas = _nmd_context->draw_list.default_atlas;
+    context->profiler = _nmd_context->profiler;
+    context->profiler_user_data = _nmd_context->profiler_user_data;
+}
+
+/* Frees the memory allocated by a context(the frame arena, the windows, the widget state and the retained geometry). The context can be used again after calling nmd_init_context(). */
+void nmd_destroy_context(nmd_context* context)
+{
+    nmd_context* const current_context = _nmd_context;
+    _nmd_context = context;
+
+    while (context->frame_arena.overflow)
     {
-        num_accounted_vertices += _nmd_context.draw_list.draw_commands[i].num_vertices;
-        num_accounted_indices += _nmd_context.draw_list.draw_commands[i].num_indices;
+        void* next = *(void**)context->frame_arena.overflow;
+        _nmd_free(context->frame_arena.overflow);
+        context->frame_arena.overflow = next;
     }
+    _nmd_free(context->frame_arena.block);
+    _nmd_free(context->gui.windows);
+    _nmd_id_map_free(&context->gui.window_map);
+    _nmd_id_map_free(&context->gui.state_map);
+    nmd_free_retained();
+    NMD_MEMSET(&context->frame_arena, 0, sizeof(nmd_frame_arena));
+    NMD_MEMSET(&context->draw_list, 0, sizeof(nmd_drawlist));
+    context->gui.windows = 0;
+    context->gui.num_windows = 0;
+    context->gui.windows_capacity = 0;
+    context->initialized = false;
+
+    _nmd_context = current_context != context ? current_context : &_nmd_default_context;
+}
 
-    const size_t num_unaccounted_indices = _nmd_context.draw_list.num_indices - num_accounted_indices;
+/* Specifies the categories of render state('NMD_RENDER_STATE_XXX') the renderers back up before rendering and restore after. The default is 'NMD_RENDER_STATE_ALL'. */
+void nmd_set_render_state_backup(uint32_t state_mask)
+{
+    _nmd_context->render_state.skip_backup = NMD_RENDER_STATE_ALL & ~state_mask;
+}
 
-    _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].num_vertices = _nmd_context.draw_list.num_vertices - num_accounted_vertices;
-    _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].num_indices = num_unaccounted_indices;
-    _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].user_texture_id = user_texture_id;
+/*
+Enables or disables the known host state mode. In this mode the renderers assume the render state they set is kept between frames,
+so they only set the categories that were restored or passed to nmd_invalidate_render_state() since the previous frame.
+*/
+void nmd_set_known_host_state(bool enable)
+{
+    _nmd_context->render_state.known_host_state = enable;
+    if (!enable)
+        _nmd_context->render_state.known = NMD_RENDER_STATE_NONE;
+}
+
+/* Tells the renderers the application changed the categories of render state('NMD_RENDER_STATE_XXX') in 'state_mask', so they're set again by the next render call. */
+void nmd_invalidate_render_state(uint32_t state_mask)
+{
+    _nmd_context->render_state.known &= ~state_mask;
+}
+
+/*
+Returns the categories of render state the renderer must set before drawing. The texture and the scissor
+are set by the draw commands, so they're only known after _nmd_render_state_texture_changed() and _nmd_render_state_scissor_changed().
+*/
+uint32_t _nmd_begin_render_state()
+{
+    const uint32_t state = NMD_RENDER_STATE_ALL & ~_nmd_context->render_state.known;
+    _nmd_context->render_state.known |= state & ~(NMD_RENDER_STATE_TEXTURE | NMD_RENDER_STATE_SCISSOR);
+    return state;
+}
+
+/* Must be called after drawing. 'restored' are the categories that were restored. If 'known_host_state' is false, every category is set again by the next frame. */
+void _nmd_end_render_state(uint32_t restored, bool known_host_state)
+{
+    _nmd_context->render_state.known = known_host_state ? (_nmd_context->render_state.known & ~restored) : NMD_RENDER_STATE_NONE;
+}
+
+/* Returns true if 'texture' is not the texture bound by the renderer, in which case the renderer must bind it. */
+bool _nmd_render_state_texture_changed(nmd_tex_id texture)
+{
+    if ((_nmd_context->render_state.known & NMD_RENDER_STATE_TEXTURE) && _nmd_context->render_state.texture == texture)
+        return false;
+
+    _nmd_context->render_state.texture = texture;
+    _nmd_context->render_state.known |= NMD_RENDER_STATE_TEXTURE;
+    _nmd_context->stats.num_texture_binds++;
+    return true;
+}
+
+/* Returns true if the scissor set by the renderer is not the one of 'clip_rect'(the clip rect of a draw command), in which case the renderer must set it. */
+bool _nmd_render_state_scissor_changed(const nmd_rect* clip_rect)
+{
+    nmd_rect* const scissor = &_nmd_context->render_state.scissor;
+    if (_nmd_context->render_state.known & NMD_RENDER_STATE_SCISSOR)
+    {
+        /* 'p1.x' is -1 if the command has no clip rect, the other coordinates are not used in that case */
+        if (clip_rect->p1.x == -1.0f ? scissor->p1.x == -1.0f : (scissor->p0.x == clip_rect->p0.x && scissor->p0.y == clip_rect->p0.y && scissor->p1.x == clip_rect->p1.x && scissor->p1.y == clip_rect->p1.y))
+            return false;
+    }
+
+    *scissor = *clip_rect;
+    _nmd_context->render_state.known |= NMD_RENDER_STATE_SCISSOR;
+    return true;
+}
+
+bool _nmd_reserve_draw_commands(size_t num_new_draw_commands)
+{
+    const size_t future_size = (_nmd_context->draw_list.num_draw_commands + num_new_draw_commands) * sizeof(nmd_draw_command);
+    if (future_size > _nmd_context->draw_list.draw_commands_capacity)
+    {
+        const size_t new_capacity = NMD_MAX(_nmd_context->draw_list.draw_commands_capacity * 2, future_size);
+        void* mem = _nmd_frame_realloc(_nmd_context->draw_list.draw_commands, _nmd_context->draw_list.draw_commands_capacity, new_capacity);
+        if (!mem)
+            return false;
+
+        _nmd_context->draw_list.draw_commands = (nmd_draw_command*)mem;
+        _nmd_context->draw_list.draw_commands_capacity = new_capacity;
+    }
+
+    return true;
+}
+
+/* Returns true if the clip rects of two draw commands are the same. */
+bool _nmd_is_same_clip_rect(const nmd_rect* a, const nmd_rect* b)
+{
+    if (a->p1.x == -1.0f || b->p1.x == -1.0f)
+        return a->p1.x == b->p1.x;
+
+    return a->p0.x == b->p0.x && a->p0.y == b->p0.y && a->p1.x == b->p1.x && a->p1.y == b->p1.y;
+}
+
+/*
+Creates a draw command for the unaccounted vertices and indices whose texture and clip rect are set by the next push, so the vertices
+that follow start at a new base vertex. Called by _nmd_reserve() when the indices relative to the current base vertex would not fit in 'nmd_index'.
+*/
+bool _nmd_split_draw_command()
+{
+    if (_nmd_context->draw_list.num_indices > _nmd_context->draw_list.num_accounted_indices)
+    {
+        if (!_nmd_reserve_draw_commands(1))
+            return false;
+
+        nmd_draw_command* command = &_nmd_context->draw_list.draw_commands[_nmd_context->draw_list.num_draw_commands++];
+        command->num_vertices = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.num_accounted_vertices;
+        command->num_indices = _nmd_context->draw_list.num_indices - _nmd_context->draw_list.num_accounted_indices;
+        command->vertex_offset = _nmd_context->draw_list.vertex_offset;
+        _nmd_context->draw_list.num_pending_draw_commands++;
+    }
+
+    _nmd_context->draw_list.num_accounted_vertices = _nmd_context->draw_list.num_vertices;
+    _nmd_context->draw_list.num_accounted_indices = _nmd_context->draw_list.num_indices;
+    _nmd_context->draw_list.vertex_offset = _nmd_context->draw_list.num_vertices;
+
+    return true;
+}
+
+/*
+Creates a draw command for the unaccounted vertices and indices. If the last draw command has the same texture, clip rect
+and base vertex, it's extended instead, so consecutive shapes that use the same texture are rendered by one draw call.
+*/
+void _nmd_push_draw_command(nmd_tex_id user_texture_id, const nmd_rect* clip_rect)
+{
+    nmd_rect rect;
     if (clip_rect)
-        _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].rect = *clip_rect;
+        rect = *clip_rect;
+    else
+        rect.p0.x = rect.p0.y = rect.p1.y = 0.0f, rect.p1.x = -1.0f;
+
+    /* The commands created by _nmd_split_draw_command() belong to this push */
+    for (; _nmd_context->draw_list.num_pending_draw_commands > 0; _nmd_context->draw_list.num_pending_draw_commands--)
+    {
+        nmd_draw_command* command = &_nmd_context->draw_list.draw_commands[_nmd_context->draw_list.num_draw_commands - _nmd_context->draw_list.num_pending_draw_commands];
+        command->user_texture_id = user_texture_id;
+        command->rect = rect;
+    }
+
+    const size_t num_unaccounted_vertices = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.num_accounted_vertices;
+    const size_t num_unaccounted_indices = _nmd_context->draw_list.num_indices - _nmd_context->draw_list.num_accounted_indices;
+    if (!num_unaccounted_indices)
+        return;
+
+    nmd_draw_command* command = _nmd_context->draw_list.num_draw_commands ? &_nmd_context->draw_list.draw_commands[_nmd_context->draw_list.num_draw_commands - 1] : 0;
+    if (command && command->user_texture_id == user_texture_id && command->vertex_offset == _nmd_context->draw_list.vertex_offset && _nmd_is_same_clip_rect(&command->rect, &rect))
+    {
+        command->num_vertices += num_unaccounted_vertices;
+        command->num_indices += num_unaccounted_indices;
+    }
     else
-        _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].rect.p1.x = -1.0f;
-    _nmd_context.draw_list.num_draw_commands++;
+    {
+        if (!_nmd_reserve_draw_commands(1))
+            return;
+
+        command = &_nmd_context->draw_list.draw_commands[_nmd_context->draw_list.num_draw_commands++];
+        command->num_vertices = num_unaccounted_vertices;
+        command->num_indices = num_unaccounted_indices;
+        command->vertex_offset = _nmd_context->draw_list.vertex_offset;
+        command->user_texture_id = user_texture_id;
+        command->rect = rect;
+    }
+
+    _nmd_context->draw_list.num_accounted_vertices = _nmd_context->draw_list.num_vertices;
+    _nmd_context->draw_list.num_accounted_indices = _nmd_context->draw_list.num_indices;
+}
+
+/*
+Creates a draw command for the unaccounted vertices and indices. If the last draw command has the same texture and clip rect, it's extended instead.
+Parameters:
+ clip_rect [opt/in] A pointer to a rect that specifies the clip area. This parameter can be null.
+*/
+void nmd_push_draw_command(const nmd_rect* clip_rect)
+{
+    _nmd_push_draw_command(_nmd_context->draw_list.blank_tex_id, clip_rect);
+}
+
+/*
+Same as nmd_push_draw_command(), but the draw command uses the texture 'user_texture_id'.
+Parameters:
+ user_texture_id [in]     The texture of the draw command.
+ clip_rect       [opt/in] A pointer to a rect that specifies the clip area. This parameter can be null.
+*/
+void nmd_push_texture_draw_command(nmd_tex_id user_texture_id, const nmd_rect* clip_rect)
+{
+    _nmd_push_draw_command(user_texture_id, clip_rect);
 }
 
 void _nmd_calculate_circle_segments(float max_error)
@@ -119,79 +480,96 @@ void _nmd_calculate_circle_segments(float max_error)
     for (size_t i = 0; i < 64; i++)
     {
         const uint8_t segment_count = NMD_CIRCLE_AUTO_SEGMENT_CALC(i + 1.0f, max_error);
-        _nmd_context.draw_list.cached_circle_segment_counts64[i] = NMD_MIN(segment_count, 255);
+        _nmd_context->draw_list.cached_circle_segment_counts64[i] = NMD_MIN(segment_count, 255);
     }
 }
 
 #ifdef _WIN32
 void nmd_win32_set_hwnd(HWND hWnd)
 {
-    _nmd_context.hWnd = hWnd;
+    _nmd_context->hWnd = hWnd;
 }
 #endif /* _WIN32*/
 
 /* Starts a new empty scene/frame. Internally this function clears all vertices, indices and command buffers. */
 void nmd_new_frame()
 {
-    if (!_nmd_initialized)
+    _nmd_profile("nmd_new_frame", true);
+
+    if (!_nmd_context->initialized)
     {
-        _nmd_initialized = true;
+        _nmd_context->initialized = true;
 
-        _nmd_context.draw_list.line_anti_aliasing = true;
-        _nmd_context.draw_list.fill_anti_aliasing = true;
+        _nmd_context->draw_list.line_anti_aliasing = true;
+        _nmd_context->draw_list.fill_anti_aliasing = true;
 
         for (size_t i = 0; i < 12; i++)
         {
             const float angle = (i / 12.0f) * NMD_2PI;
-            _nmd_context.draw_list.cached_circle_vertices12[i].x = NMD_COS(angle);
-            _nmd_context.draw_list.cached_circle_vertices12[i].y = NMD_SIN(angle);
+            _nmd_context->draw_list.cached_circle_vertices12[i].x = NMD_COS(angle);
+            _nmd_context->draw_list.cached_circle_vertices12[i].y = NMD_SIN(angle);
         }
         
         _nmd_calculate_circle_segments(1.6f);
 
-        /* Allocate buffers */
-        _nmd_context.draw_list.path = (nmd_vec2*)NMD_MALLOC(NMD_PATH_BUFFER_INITIAL_SIZE * sizeof(nmd_vec2));
-        _nmd_context.draw_list.path_capacity = NMD_PATH_BUFFER_INITIAL_SIZE * sizeof(nmd_vec2);
-
-        _nmd_context.draw_list.vertices = (nmd_vertex*)NMD_MALLOC(NMD_VERTEX_BUFFER_INITIAL_SIZE * sizeof(nmd_vertex));
-        _nmd_context.draw_list.vertices_capacity = NMD_VERTEX_BUFFER_INITIAL_SIZE * sizeof(nmd_vertex);
-
-        _nmd_context.draw_list.indices = (nmd_index*)NMD_MALLOC(NMD_INDEX_BUFFER_INITIAL_SIZE * sizeof(nmd_index));
-        _nmd_context.draw_list.indices_capacity = NMD_INDEX_BUFFER_INITIAL_SIZE * sizeof(nmd_index);
-
-        _nmd_context.draw_list.draw_commands = (nmd_draw_command*)NMD_MALLOC(NMD_DRAW_COMMANDS_BUFFER_INITIAL_SIZE * sizeof(nmd_draw_command));
-        _nmd_context.draw_list.draw_commands_capacity = NMD_DRAW_COMMANDS_BUFFER_INITIAL_SIZE * sizeof(nmd_draw_command);
-
-        _nmd_context.gui.num_windows = 0;
-        _nmd_context.gui.windows = (nmd_window*)NMD_MALLOC(NMD_WINDOWS_BUFFER_INITIAL_SIZE * sizeof(nmd_window));
-        _nmd_context.gui.windows_capacity = NMD_WINDOWS_BUFFER_INITIAL_SIZE;
-        _nmd_context.gui.window = 0;
-        _nmd_context.gui.window_pos.x = 60;
-        _nmd_context.gui.window_pos.y = 60;
+        /* The buffers are allocated in the frame arena by _nmd_reset_frame_arena() */
+        _nmd_context->draw_list.path_capacity = NMD_PATH_BUFFER_INITIAL_SIZE * sizeof(nmd_vec2);
+        _nmd_context->draw_list.vertices_capacity = NMD_VERTEX_BUFFER_INITIAL_SIZE * sizeof(nmd_vertex);
+        _nmd_context->draw_list.indices_capacity = NMD_INDEX_BUFFER_INITIAL_SIZE * sizeof(nmd_index);
+        _nmd_context->draw_list.draw_commands_capacity = NMD_DRAW_COMMANDS_BUFFER_INITIAL_SIZE * sizeof(nmd_draw_command);
+
+        _nmd_context->gui.num_windows = 0;
+        _nmd_context->gui.windows = (nmd_window*)_nmd_alloc(NMD_WINDOWS_BUFFER_INITIAL_SIZE * sizeof(nmd_window));
+        _nmd_context->gui.windows_capacity = _nmd_context->gui.windows ? NMD_WINDOWS_BUFFER_INITIAL_SIZE : 0;
+        _nmd_context->gui.window = 0;
+        _nmd_context->gui.window_pos.x = 60;
+        _nmd_context->gui.window_pos.y = 60;
     }
 
-    _nmd_context.draw_list.num_vertices = 0;
-    _nmd_context.draw_list.num_indices = 0;
-    _nmd_context.draw_list.num_draw_commands = 0;
+    NMD_MEMSET(&_nmd_context->stats, 0, sizeof(nmd_frame_stats));
+    _nmd_reset_frame_arena();
+
+    _nmd_context->draw_list.num_points = 0;
+    _nmd_context->draw_list.num_vertices = 0;
+    _nmd_context->draw_list.num_indices = 0;
+    _nmd_context->draw_list.num_draw_commands = 0;
+    _nmd_context->draw_list.num_accounted_vertices = 0;
+    _nmd_context->draw_list.num_accounted_indices = 0;
+    _nmd_context->draw_list.vertex_offset = 0;
+    _nmd_context->draw_list.num_pending_draw_commands = 0;
 
 #ifdef _WIN32
     POINT point;
-    if (_nmd_context.hWnd && GetCursorPos(&point) && ScreenToClient(_nmd_context.hWnd, &point))
+    if (_nmd_context->hWnd && GetCursorPos(&point) && ScreenToClient(_nmd_context->hWnd, &point))
     {
-        _nmd_context.io.mouse_pos.x = point.x;
-        _nmd_context.io.mouse_pos.y = point.y;
+        _nmd_context->io.mouse_pos.x = point.x;
+        _nmd_context->io.mouse_pos.y = point.y;
     }
 #endif /* _WIN32 */
+
+    _nmd_profile("nmd_new_frame", false);
 }
 
 /* "Ends" a frame. Wrapper around nmd_push_draw_command(). */
 void nmd_end_frame()
 {
+    _nmd_profile("nmd_end_frame", true);
+
     /* Clears the mouse released state because it should only be used once */
     for (size_t i = 0; i < 5; i++)
-        _nmd_context.io.mouse_released[i] = false;
+        _nmd_context->io.mouse_released[i] = false;
+
+    /* Release the held widget even if it wasn't added this frame */
+    if (!_nmd_context->io.mouse_down[0])
+        _nmd_context->gui.active_id = 0;
 
     nmd_push_draw_command(0);
+
+    _nmd_context->stats.num_vertices = _nmd_context->draw_list.num_vertices;
+    _nmd_context->stats.num_indices = _nmd_context->draw_list.num_indices;
+    _nmd_context->stats.num_draw_commands = _nmd_context->draw_list.num_draw_commands;
+
+    _nmd_profile("nmd_end_frame", false);
 }
 
 bool nmd_bake_font_from_memory(const void* font_data, nmd_atlas* atlas, float size)
@@ -199,9 +577,19 @@ bool nmd_bake_font_from_memory(const void* font_data, nmd_atlas* atlas, float si
     atlas->width = 512;
     atlas->height = 512;
 
-    atlas->pixels8 = (uint8_t*)NMD_MALLOC(atlas->width * atlas->height);
-    atlas->pixels32 = (nmd_color*)NMD_MALLOC(atlas->width * atlas->height * 4);
-    atlas->baked_chars = NMD_MALLOC(sizeof(stbtt_bakedchar) * 96);
+    atlas->pixels8 = (uint8_t*)_nmd_alloc(atlas->width * atlas->height);
+    atlas->pixels32 = (nmd_color*)_nmd_alloc(atlas->width * atlas->height * 4);
+    atlas->baked_chars = _nmd_alloc(sizeof(stbtt_bakedchar) * 96);
+    if (!atlas->pixels8 || !atlas->pixels32 || !atlas->baked_chars)
+    {
+        _nmd_free(atlas->pixels8);
+        _nmd_free(atlas->pixels32);
+        _nmd_free(atlas->baked_chars);
+        atlas->pixels8 = 0;
+        atlas->pixels32 = 0;
+        atlas->baked_chars = 0;
+        return false;
+    }
 
     stbtt_BakeFontBitmap((const unsigned char*)font_data, 0, size, atlas->pixels8, atlas->width, atlas->height, 0x20, 96, (stbtt_bakedchar*)atlas->baked_chars);
 
@@ -225,14 +613,16 @@ bool nmd_bake_font(const char* font_path, nmd_atlas* atlas, float size)
     fseek(f, 0L, SEEK_SET);
 
     /* Allocate and read file */
-    void* font_data = NMD_MALLOC(file_size);    
-    fread(font_data, 1, file_size, f);
-
-    ret = nmd_bake_font_from_memory(font_data, atlas, size);
+    void* font_data = _nmd_alloc(file_size);
+    if (font_data)
+    {
+        fread(font_data, 1, file_size, f);
+        ret = nmd_bake_font_from_memory(font_data, atlas, size);
+    }
     
     /* Close and free file */
     fclose(f);
-    NMD_FREE(font_data);
+    _nmd_free(font_data);
 #endif
 
     return ret;
@@ -21,7 +21,11 @@ OpenGL Usage:
  You MUST call nmd_opengl_render() to issue draw calls that render the data in the drawlist.
  You may call nmd_opengl_create_texture() if a helper function for texture creation is desired.
  You may define the 'NMD_GRAPHICS_OPENGL_DONT_BACKUP_RENDER_STATE' macro if you don't mind the library overriding the render state.
- You may define the 'NMD_GRAPHICS_OPENGL_OPTIMIZE_RENDER_STATE' macro so the render state only changes when necessary. Note that this option may only be used if this library is the only component that uses OpenGL.
+ You may define the 'NMD_GRAPHICS_OPENGL_OPTIMIZE_RENDER_STATE' macro so the render state only changes when necessary(the known host state mode, see 'Render state'). Note that this option may only be used if this library is the only component that uses OpenGL
+ or if the other components call nmd_invalidate_render_state() when they change the render state.
+ You may define the 'NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS' macro so only the vertices and indices that changed since the previous frame are uploaded. The vertex and index buffers
+ are persistently mapped rings of 'NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT' segments synchronized with fences if glBufferStorage() is available(OpenGL 4.4 or 'GL_ARB_buffer_storage'),
+ otherwise the changed range is uploaded with glBufferSubData() and the buffer is orphaned when most of it changed. A copy of the previous frame is kept in memory to find what changed.
 
 D3D9 Usage:
  You MUST define the 'NMD_GRAPHICS_D3D9' macro once project-wise(compiler dependent) or for every include statement that you'll use any of the following functions.
@@ -30,7 +34,8 @@ D3D9 Usage:
  You MUST call nmd_d3d9_render() to issue draw calls that render the data in the drawlist.
  You may call nmd_d3d9_create_texture() if a helper function for texture creation is desired.
  You may define the 'NMD_GRAPHICS_D3D9_DONT_BACKUP_RENDER_STATE' macro if you don't mind the library overriding the render state.
- You may define the 'NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE' macro so the render state only changes when necessary. Note that this option may only be used if this library is the only component that uses Direct3D 9.
+ You may define the 'NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE' macro so the render state only changes when necessary(the known host state mode, see 'Render state'). Note that this option may only be used if this library is the only component that uses Direct3D 9
+ or if the other components call nmd_invalidate_render_state() when they change the render state.
 
 D3D11 Usage:
  You MUST define the 'NMD_GRAPHICS_D3D11' macro once project-wise(compiler dependent) or for every include statement that you'll use any of the following functions.
@@ -39,24 +44,93 @@ D3D11 Usage:
  You MUST call nmd_d3d11_render() to issue draw calls that render the data in the drawlist.
  You may call nmd_d3d11_create_texture() if a helper function for texture creation is desired.
  You may define the 'NMD_GRAPHICS_D3D11_DONT_BACKUP_RENDER_STATE' macro if you don't mind the library overriding the render state.
- You may define the 'NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE' macro so the render state only changes when necessary. Note that this option may only be used if this library is the only component that uses Direct3D 11.
+ You may define the 'NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE' macro so the render state only changes when necessary(the known host state mode, see 'Render state'). Note that this option may only be used if this library is the only component that uses Direct3D 11
+ or if the other components call nmd_invalidate_render_state() when they change the render state.
+
+Render state:
+ The renderers group the render state they use in the categories of the 'NMD_RENDER_STATE' enum. By default every category is backed up before rendering and restored after,
+ which requires querying the state of the graphics API every frame.
+ You may call nmd_set_render_state_backup() to specify which categories are backed up and restored, the other ones are left as the library set them.
+ You may call nmd_set_known_host_state(true) if the application tells the library which categories it changed since the previous frame by calling nmd_invalidate_render_state().
+ In this mode the renderers only set the categories that were restored or invalidated, otherwise every category is set every frame.
+ The 'NMD_GRAPHICS_XXX_OPTIMIZE_RENDER_STATE' macros enable this mode for a renderer at compile time, the 'NMD_GRAPHICS_XXX_DONT_BACKUP_RENDER_STATE' macros remove the backup code.
+ The texture and the scissor rectangle are only set when they differ from the ones of the previous draw command.
 
 Internals:
-The 'nmd_context'(acessible by nmd_get_context()) global variable holds the state of the entire library, it
+The current 'nmd_context'(acessible by nmd_get_context()) holds the state of the entire library, it
 contains a 'nmd_drawlist' variable which holds the vertex, index and command buffers. Each command buffer
 translate to a call to a rendering's API draw function. Shapes can be rendered in the drawlist by calling
 functions like nmd_add_line() and nmd_add_filled_rect().
 
+Contexts and threads:
+ Each thread has a current context, which is the default context until nmd_set_context() is called. You may create more contexts with nmd_init_context() to drive several windows
+ or to record geometry on worker threads: each thread calls nmd_set_context() with its own context and records a frame(nmd_new_frame(), primitives, nmd_end_frame()) into its draw list.
+ The thread that renders then calls nmd_append_draw_list() with the draw list of each context, in the order they should be drawn, and renders its own draw list.
+ A context must not be used by two threads at the same time. Contexts that record geometry in parallel should not share an allocator that is not thread-safe.
+ Free a context with nmd_destroy_context().
+
+Retained geometry:
+ Geometry that doesn't change between frames(e.g. static panels and labels) can be recorded once and appended to the draw list by later frames with a copy:
+    if (nmd_begin_retained(key))
+    {
+        nmd_add_rect_filled(...);
+        nmd_end_retained();
+    }
+ nmd_begin_retained() appends the recorded geometry and returns false when it's valid. nmd_add_retained() appends it at another position, nmd_invalidate_retained()
+ makes the next nmd_begin_retained() record it again. With 'NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS', geometry that is appended at the same place every frame is not uploaded again.
+
+Memory:
+ The library allocates memory through the allocator of the context, which uses NMD_MALLOC()/NMD_FREE() by default. You may call nmd_set_allocator() to specify your own allocator,
+ it must be called before any other function of the library allocates memory(e.g. before nmd_bake_font() and the first nmd_new_frame()).
+ The vertex, index, draw command and path buffers are allocated in a linear frame arena that is reset by nmd_new_frame(), so growing a buffer in a frame doesn't free memory
+ and the buffer at the top of the arena grows in place. When the arena is full the memory is allocated by the allocator and freed by the next nmd_new_frame(), which also
+ resizes the arena to the high-water mark(the largest amount of memory used by a frame), so a frame that doesn't need more memory than the previous ones doesn't allocate memory.
+ You may call nmd_set_frame_memory() to provide the arena's memory, it's never resized in this case. The high-water mark is 'nmd_get_context()->frame_arena.high_water'.
+
+Profiling:
+ 'nmd_get_context()->stats' holds counters of the current frame: nmd_new_frame() resets them, nmd_end_frame() sets the number of vertices, indices and draw commands
+ and the number of buffers that were copied because they could not grow in place, and the renderers add the number of textures they bound. Read them after rendering.
+ To time the library, pass a function to nmd_set_profiler(). It's called when nmd_new_frame(), nmd_end_frame() and the nmd_xxx_render() functions begin and end:
+    void profile(const char* zone, bool begin, void* user_data) { ... }
+    nmd_set_profiler(profile, user_data);
+ 'tests/graphics_benchmark.c' measures the time per frame of synthetic scenes of primitives, text and widgets.
+
 Fixed width integer types:
 By default the library includes <stdint.h> and <stddef.h> to include int types.
 If these header-files are not available in your environment you may define the 'NMD_DEFINE_INT_TYPES' macro so the library will define them.
 By defining the 'NMD_IGNORE_INT_TYPES' macro, the library will neither include nor define int types.
 
-Define the 'NMD_GRAPHICS_DISABLE_DEFAULT_ALLOCATOR' macro to tell the library not to include default allocators.
+Define the 'NMD_GRAPHICS_DISABLE_DEFAULT_ALLOCATOR' macro to tell the library not to include default allocators. In this case you MUST call nmd_set_allocator(), or nmd_set_frame_memory() if memory is only needed for the draw list's buffers.
 Define the 'NMD_GRAPHICS_DISABLE_FILE_IO' macro to tell the library not to support file operations for fonts.
-Define the 'NMD_GRAPHICS_AVOID_ALLOCA' macro to tell the library to use malloc/free instead of alloca
+Define the 'NMD_GRAPHICS_AVOID_ALLOCA' macro to tell the library to allocate temporary memory in the frame arena instead of using alloca
+SIMD tessellation:
+The normals and miters of polylines and anti-aliased fills, the vertices of their outlines, the points of arcs(circles, ngons) and the UVs of rounded images are computed
+by kernels that process several points at once when one of the following macros is defined, otherwise by scalar code:
+ - 'NMD_GRAPHICS_ENABLE_SSE2': Uses SSE2 intrinsics. This macro includes <emmintrin.h>.
+ - 'NMD_GRAPHICS_ENABLE_NEON': Uses NEON intrinsics(AArch64 only). This macro includes <arm_neon.h>.
+The points may differ from the scalar code by about a thousandth of a pixel, because the points of arcs are rotated instead of computed by NMD_COS()/NMD_SIN() for each point.
+
+Glyph cache:
+ nmd_bake_font() bakes the ASCII characters of one size into a fixed atlas. For Unicode text and several sizes, initialize a 'nmd_glyph_cache' with the renderer's
+ texture functions and a 'nmd_font' for each font face, then use nmd_add_text_cached() and nmd_get_text_size_cached():
+    nmd_glyph_cache_init(&cache, 0, nmd_opengl_create_texture, nmd_opengl_update_texture);
+    nmd_font_init(&font, &cache, font_data);
+    ...
+    nmd_add_text_cached(&font, 18.0f, x, y, "Hello", 0, NMD_COLOR_WHITE);
+    nmd_glyph_cache_upload(&cache);
+    nmd_opengl_render();
+ Glyphs are rasterized the first time they're used and only the rectangles that changed are uploaded. The textures are created when the text is added, so the graphics
+ API must be usable on that thread. A glyph cache is not thread-safe, contexts that record text on different threads should use different caches.
+
+Widget IDs:
+ Windows and widgets are identified by the hash of their name combined with the IDs on the ID stack. nmd_begin() puts the window's ID at the bottom of the stack, so widgets
+ with the same label in different windows have different IDs. Use nmd_push_id()/nmd_push_id_int() and nmd_pop_id() to tell apart widgets with the same label in a window(e.g. in a loop).
+ Windows are looked up in a hash map, and state that must persist between frames can be stored per ID with nmd_set_state_int()/nmd_set_state_float():
+    const uint32_t id = nmd_get_id("scroll");
+    nmd_set_state_float(id, nmd_get_state_float(id, 0.0f) + delta);
+
 Default fonts:
-The 'Karla' true type font in included by default. Define the 'NMD_GRAPHICS_DISABLE_DEFAULT_FONT' macro to remove the font at compile time.
+The 'Karla'' true type font in included by default. Define the 'NMD_GRAPHICS_DISABLE_DEFAULT_FONT' macro to remove the font at compile time.
 
 NOTE: A big part of this library's code has been derived from Imgui's and Nuklear's code. Huge credit to both projects.
 
@@ -113,7 +187,7 @@ Credits:
  #endif /* NMD_DEFINE_INT_TYPES */
 #endif /* _NMD_DEFINE_INT_TYPES */
 
-#ifndef NMD_MALLOC
+#if !defined(NMD_MALLOC) && !defined(NMD_GRAPHICS_DISABLE_DEFAULT_ALLOCATOR)
 #include <stdlib.h>
 #define NMD_MALLOC malloc
 #define NMD_FREE free
@@ -129,6 +203,11 @@ Credits:
 #define NMD_MEMCPY memcpy
 #endif /* NMD_MEMCPY */
 
+#ifndef NMD_MEMCMP
+#include <string.h>
+#define NMD_MEMCMP memcmp
+#endif /* NMD_MEMCMP */
+
 #ifndef NMD_STRLEN
 #include <string.h>
 #define NMD_STRLEN strlen
@@ -136,11 +215,21 @@ Credits:
 
 #ifndef NMD_GRAPHICS_AVOID_ALLOCA
     #ifndef NMD_ALLOCA
+    #ifdef _WIN32
     #include <malloc.h>
+    #else
+    #include <alloca.h>
+    #endif /* _WIN32 */
     #define NMD_ALLOCA alloca
     #endif /* NMD_ALLOCA */
 #endif /* NMD_GRAPHICS_AVOID_ALLOCA */
 
+#ifdef NMD_GRAPHICS_ENABLE_SSE2
+#include <emmintrin.h>
+#elif defined(NMD_GRAPHICS_ENABLE_NEON)
+#include <arm_neon.h>
+#endif /* NMD_GRAPHICS_ENABLE_SSE2 */
+
 #ifndef NMD_SPRINTF
 #include <stdio.h>
 #define NMD_SPRINTF sprintf
@@ -151,6 +240,9 @@ Credits:
 #define NMD_VSPRINTF vsprintf
 #endif /* NMD_VSPRINTF */
 
+/* nmd_text() takes a variable number of arguments */
+#include <stdarg.h>
+
 #ifndef NMD_SQRT
 #include <math.h>
 #define NMD_SQRT sqrt
@@ -171,12 +263,27 @@ Credits:
 #define NMD_SIN sin
 #endif /* NMD_SIN */
 
-#define STBTT_malloc(x,u) ((void)(u),NMD_MALLOC(x))
-#define STBTT_free(x,u) ((void)(u),NMD_FREE(x))
+#define STBTT_malloc(x,u) ((void)(u),_nmd_alloc(x))
+#define STBTT_free(x,u) ((void)(u),_nmd_free(x))
 #define STBTT_strlen(x) NMD_STRLEN(x)
 #define STBTT_memcpy NMD_MEMCPY
 #define STBTT_memset NMD_MEMSET
 
+/* The storage class of the pointer to the current context, so each thread has its own current context */
+#ifndef NMD_THREAD_LOCAL
+    #if defined(__cplusplus) && __cplusplus >= 201103L
+    #define NMD_THREAD_LOCAL thread_local
+    #elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+    #define NMD_THREAD_LOCAL _Thread_local
+    #elif defined(_MSC_VER)
+    #define NMD_THREAD_LOCAL __declspec(thread)
+    #elif defined(__GNUC__) || defined(__clang__)
+    #define NMD_THREAD_LOCAL __thread
+    #else
+    #define NMD_THREAD_LOCAL
+    #endif
+#endif /* NMD_THREAD_LOCAL */
+
 /* The number of points the buffer intially supports */
 #ifndef NMD_PATH_BUFFER_INITIAL_SIZE
 #define NMD_PATH_BUFFER_INITIAL_SIZE 32
@@ -202,6 +309,41 @@ Credits:
 #define NMD_WINDOWS_BUFFER_INITIAL_SIZE 4
 #endif /* NMD_WINDOWS_BUFFER_INITIAL_SIZE */
 
+/* The number of entries the window and widget state hash maps intially support. Must be a power of two */
+#ifndef NMD_ID_MAP_INITIAL_SIZE
+#define NMD_ID_MAP_INITIAL_SIZE 16
+#endif /* NMD_ID_MAP_INITIAL_SIZE */
+
+/* The maximum depth of the ID stack. IDs pushed beyond it are ignored */
+#ifndef NMD_ID_STACK_SIZE
+#define NMD_ID_STACK_SIZE 32
+#endif /* NMD_ID_STACK_SIZE */
+
+/* The number of retained geometry entries the buffer intially supports */
+#ifndef NMD_RETAINED_BUFFER_INITIAL_SIZE
+#define NMD_RETAINED_BUFFER_INITIAL_SIZE 8
+#endif /* NMD_RETAINED_BUFFER_INITIAL_SIZE */
+
+/* The width and height in pixels of the pages of a glyph cache when nmd_glyph_cache_init() is called with zero */
+#ifndef NMD_GLYPH_PAGE_SIZE
+#define NMD_GLYPH_PAGE_SIZE 1024
+#endif /* NMD_GLYPH_PAGE_SIZE */
+
+/* The number of bytes of laid out strings a glyph cache keeps(each byte needs at most one quad). When it's exceeded, the layouts are discarded */
+#ifndef NMD_TEXT_LAYOUT_CACHE_SIZE
+#define NMD_TEXT_LAYOUT_CACHE_SIZE 65536
+#endif /* NMD_TEXT_LAYOUT_CACHE_SIZE */
+
+/* The alignment in bytes of the allocations in the frame arena */
+#ifndef NMD_FRAME_ARENA_ALIGNMENT
+#define NMD_FRAME_ARENA_ALIGNMENT 16
+#endif /* NMD_FRAME_ARENA_ALIGNMENT */
+
+/* The number of frames the GPU may be rendering while the next one is recorded when 'NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS' is defined */
+#ifndef NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT
+#define NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT 3
+#endif /* NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT */
+
 #ifdef _WIN32
 #include <Windows.h>
 LRESULT nmd_win32_wnd_proc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
@@ -214,6 +356,7 @@ typedef void* nmd_tex_id;
 bool nmd_opengl_resize(int width, int height);
 void nmd_opengl_render();
 nmd_tex_id nmd_opengl_create_texture(void* pixels, int width, int height);
+void nmd_opengl_update_texture(nmd_tex_id texture, const void* pixels, int x, int y, int width, int height, int pitch);
 #endif /* NMD_GRAPHICS_OPENGL */
 
 #ifdef NMD_GRAPHICS_D3D9
@@ -222,6 +365,7 @@ void nmd_d3d9_set_device(LPDIRECT3DDEVICE9 pDevice);
 void nmd_d3d9_resize(int width, int height);
 void nmd_d3d9_render();
 nmd_tex_id nmd_d3d9_create_texture(void* pixels, int width, int height);
+void nmd_d3d9_update_texture(nmd_tex_id texture, const void* pixels, int x, int y, int width, int height, int pitch);
 #endif /* NMD_GRAPHICS_D3D9 */
 
 #ifdef NMD_GRAPHICS_D3D11
@@ -231,6 +375,7 @@ bool nmd_d3d11_resize(int width, int height);
 void nmd_d3d11_render();
 void nmd_d3d11_delete_objects();
 nmd_tex_id nmd_d3d11_create_texture(void* pixels, int width, int height);
+void nmd_d3d11_update_texture(nmd_tex_id texture, const void* pixels, int x, int y, int width, int height, int pitch);
 #endif /* NMD_GRAPHICS_D3D11 */
 
 enum NMD_CORNER
@@ -250,6 +395,22 @@ enum NMD_CORNER
     NMD_CORNER_ALL          = (1 << 5) - 1
 };
 
+/* The categories of render state set by the renderers. See nmd_set_render_state_backup(), nmd_set_known_host_state() and nmd_invalidate_render_state(). */
+enum NMD_RENDER_STATE
+{
+    NMD_RENDER_STATE_NONE       = 0,
+    NMD_RENDER_STATE_SHADERS    = (1 << 0), /* The program/shaders and their constant buffers. */
+    NMD_RENDER_STATE_TEXTURE    = (1 << 1), /* The texture bound to the first unit/stage and the texture stage states. */
+    NMD_RENDER_STATE_SAMPLER    = (1 << 2), /* The sampler of the first unit/stage. */
+    NMD_RENDER_STATE_BUFFERS    = (1 << 3), /* The vertex and index buffers, the vertex layout and the primitive topology. */
+    NMD_RENDER_STATE_BLEND      = (1 << 4), /* Alpha blending. */
+    NMD_RENDER_STATE_RASTERIZER = (1 << 5), /* Face culling, depth testing, the scissor test and the fill mode. */
+    NMD_RENDER_STATE_VIEWPORT   = (1 << 6), /* The viewport and the projection matrix. */
+    NMD_RENDER_STATE_SCISSOR    = (1 << 7), /* The scissor rectangle. */
+
+    NMD_RENDER_STATE_ALL        = (1 << 8) - 1
+};
+
 typedef struct
 {
     float x, y;
@@ -268,13 +429,12 @@ typedef struct
 
 typedef struct
 {
-    /* 'num_vertices' has the type 'nmd_index' because the number of vertices is always less or equal the number of indices. */
-    nmd_index num_vertices; 
-
-    nmd_index num_indices;
+    size_t num_vertices; /* The number of vertices added by the command. */
+    size_t num_indices;
+    size_t vertex_offset; /* The indices are relative to this vertex(the base vertex of the draw call), so a command can use more than 'nmd_index' can address. */
     nmd_tex_id user_texture_id;
 
-    nmd_rect rect;
+    nmd_rect rect; /* The clip rect. 'p1.x' is -1 if the command has no clip rect. */
     
 } nmd_draw_command;
 
@@ -301,6 +461,98 @@ typedef struct
     nmd_tex_id font_id;
 } nmd_atlas;
 
+/* A node of the skyline of a glyph page: the segment of 'width' pixels at 'x' is used up to 'y' */
+typedef struct
+{
+    int x, y, width;
+} nmd_skyline_node;
+
+/* A texture of the glyph cache */
+typedef struct
+{
+    nmd_tex_id texture; /* The texture created by the glyph cache's 'create_texture' callback */
+    nmd_color* pixels; /* The pixels of the texture('page_size' x 'page_size') */
+    nmd_skyline_node* skyline; /* The skyline used to pack the glyphs, sorted by 'x' */
+    size_t num_nodes; /* The number of nodes in the 'skyline' array */
+    int dirty_x0, dirty_y0, dirty_x1, dirty_y1; /* The rectangle of pixels that changed since the last upload. It's empty if 'dirty_x0' >= 'dirty_x1' */
+} nmd_glyph_page;
+
+/* A glyph rasterized in the glyph cache. An entry of the glyph hash table is empty if 'font_id' is zero */
+typedef struct
+{
+    uint32_t font_id;
+    uint32_t codepoint;
+    float size;
+    nmd_tex_id texture; /* The texture of the page the glyph is in. It's null if the glyph has no pixels(e.g. space) */
+    float x0, y0, x1, y1; /* The quad relative to the pen position on the baseline */
+    float u0, v0, u1, v1;
+    float advance;
+} nmd_glyph;
+
+/* A quad of a laid out string */
+typedef struct
+{
+    float x0, y0, x1, y1; /* The quad relative to the position of the string */
+    float u0, v0, u1, v1;
+    nmd_tex_id texture;
+} nmd_glyph_quad;
+
+/* The quads of a laid out string. An entry of the layout hash table is empty if 'font_id' is zero */
+typedef struct
+{
+    uint64_t hash; /* The hash of the string */
+    size_t length; /* The length of the string in bytes */
+    size_t first_char; /* The index of the string's first byte in the glyph cache's 'text' array, so a hash collision is not taken as a match */
+    uint32_t font_id;
+    float size;
+    size_t first_quad; /* The index of the first quad in the glyph cache's 'quads' array */
+    size_t num_quads;
+    nmd_vec2 text_size; /* The size returned by nmd_get_text_size_cached() */
+} nmd_text_layout;
+
+/*
+Rasterizes glyphs on demand and packs them in textures('pages') with a skyline packer. A new page is added when a glyph doesn't fit in the existing ones.
+Laid out strings are cached by(string, font, size), so a string that is measured and drawn or drawn every frame is only laid out once.
+*/
+typedef struct
+{
+    int page_size; /* The width and height of the pages in pixels */
+    nmd_tex_id (*create_texture)(void* pixels, int width, int height); /* Creates the texture of a page(e.g. nmd_opengl_create_texture) */
+    void (*update_texture)(nmd_tex_id texture, const void* pixels, int x, int y, int width, int height, int pitch); /* Updates a rectangle of a texture(e.g. nmd_opengl_update_texture) */
+
+    nmd_glyph_page* pages;
+    size_t num_pages;
+    size_t pages_capacity;
+
+    nmd_glyph* glyphs; /* A hash table of glyphs */
+    size_t num_glyphs;
+    size_t glyphs_capacity; /* The number of entries in the 'glyphs' table, a power of two */
+
+    nmd_text_layout* layouts; /* A hash table of laid out strings */
+    size_t num_layouts;
+    size_t layouts_capacity; /* The number of entries in the 'layouts' table, a power of two */
+
+    nmd_glyph_quad* quads; /* The quads of the laid out strings */
+    size_t num_quads;
+    size_t quads_capacity;
+
+    char* text; /* The bytes of the laid out strings */
+    size_t text_length;
+    size_t text_capacity;
+
+    uint32_t next_font_id;
+} nmd_glyph_cache;
+
+/* A font face whose glyphs are rasterized by a glyph cache at any size. */
+typedef struct
+{
+    nmd_glyph_cache* cache;
+    const void* data; /* The TrueType data. It must stay valid while the font is used */
+    void* info; /* internal */
+    uint32_t id; /* Identifies the font in the glyph cache */
+    int ascent, descent; /* Unscaled vertical metrics */
+} nmd_font;
+
 typedef struct
 {
     bool line_anti_aliasing; /* If true, all lines will have AA applied to them. */
@@ -326,6 +578,11 @@ typedef struct
     size_t num_draw_commands; /* number of draw commands in the 'draw_commands' buffer. */
     size_t draw_commands_capacity; /* size of the 'draw_commands' buffer in bytes. */
 
+    size_t num_accounted_vertices; /* number of vertices in draw commands. */
+    size_t num_accounted_indices; /* number of indices in draw commands. */
+    size_t vertex_offset; /* the vertex new indices are relative to. */
+    size_t num_pending_draw_commands; /* number of draw commands at the end of the buffer whose texture and clip rect are set by the next push. */
+
     nmd_atlas default_atlas;
     nmd_tex_id blank_tex_id;
 
@@ -370,21 +627,124 @@ typedef struct
     nmd_vec2 window_move_delta; /* The delta pos between the top left corner of the window being moved and the mouse's position when it was pressed*/
 } nmd_io;
 
+/* An entry of a 'nmd_id_map'. The entry is empty if 'key' is zero */
+typedef struct
+{
+    uint32_t key;
+    union
+    {
+        int i;
+        float f;
+        size_t index;
+    } value;
+} nmd_id_map_entry;
+
+/* A hash map with open addressing(linear probing) from IDs to values */
+typedef struct
+{
+    nmd_id_map_entry* entries; /* An array of 'capacity' entries */
+    size_t num_entries; /* The number of entries that are not empty */
+    size_t capacity; /* The capacity of the 'entries' array. It's a power of two */
+} nmd_id_map;
+
 typedef struct
 {
     nmd_window* window; /* The current window being accessed */
     nmd_window* windows; /* An array of windows */
     size_t num_windows; /* The number of windows in the 'windows' array */
     size_t windows_capacity; /* The capacity of the 'windows' array */
+    nmd_id_map window_map; /* Maps window IDs to indices of the 'windows' array */
+    nmd_id_map state_map; /* Maps widget IDs to the state set by nmd_set_state_int()/nmd_set_state_float() */
+    uint32_t id_stack[NMD_ID_STACK_SIZE]; /* The seeds of the IDs computed by nmd_get_id() */
+    size_t id_stack_size; /* The number of IDs pushed on the ID stack, it may be bigger than NMD_ID_STACK_SIZE */
+    uint32_t active_id; /* The ID of the widget held by the mouse, zero if none */
     nmd_vec2 window_pos; /* The window's initial position */
     char fmt_buffer[1024]; /* temporary buffer */
 } nmd_gui;
 
+/* Geometry recorded by nmd_begin_retained()/nmd_end_retained() that is appended to the draw list instead of being tessellated again. */
+typedef struct
+{
+    uint32_t key; /* The key the geometry was recorded under */
+    bool valid; /* False if the geometry was invalidated and must be recorded again */
+    void* block; /* The memory of the vertices, indices and draw commands, allocated by the allocator */
+    size_t block_size; /* The size of 'block' in bytes */
+    nmd_vertex* vertices;
+    size_t num_vertices;
+    nmd_index* indices;
+    size_t num_indices;
+    nmd_draw_command* draw_commands; /* The draw commands. 'vertex_offset' is relative to the first vertex */
+    size_t num_draw_commands;
+} nmd_retained_geometry;
+
+typedef struct
+{
+    nmd_retained_geometry* entries; /* An array of retained geometry */
+    size_t num_entries; /* The number of entries in the 'entries' array */
+    size_t capacity; /* The capacity of the 'entries' array */
+    nmd_retained_geometry* recording; /* The geometry being recorded, or a null pointer */
+    size_t first_vertex; /* The first vertex in the draw list of the geometry being recorded */
+    size_t first_index; /* The first index in the draw list of the geometry being recorded */
+    size_t first_draw_command; /* The first draw command in the draw list of the geometry being recorded */
+} nmd_retained;
+
+typedef struct
+{
+    uint32_t known; /* The categories('NMD_RENDER_STATE_XXX') that still have the state set by the renderer. */
+    uint32_t skip_backup; /* The categories that are not backed up and restored by the renderer. */
+    bool known_host_state; /* If true, the application calls nmd_invalidate_render_state() when it changes the render state. */
+    nmd_tex_id texture; /* The texture bound by the renderer if 'known' has 'NMD_RENDER_STATE_TEXTURE'. */
+    nmd_rect scissor; /* The clip rect of the scissor set by the renderer if 'known' has 'NMD_RENDER_STATE_SCISSOR'. */
+} nmd_render_state;
+
+/* Allocates and frees memory. 'user_data' is passed to both functions. */
+typedef struct
+{
+    void* (*alloc)(void* user_data, size_t size); /* Returns a pointer to a block of 'size' bytes, or a null pointer if the allocation fails. */
+    void (*free)(void* user_data, void* ptr); /* Frees a block returned by 'alloc'. */
+    void* user_data;
+} nmd_allocator;
+
+/* A linear allocator for the memory used by one frame. nmd_new_frame() frees all of it at once. */
+typedef struct
+{
+    void* block; /* The block allocated by the allocator, or a null pointer if the memory is provided by the application. */
+    uint8_t* memory; /* The arena's memory, aligned to 'NMD_FRAME_ARENA_ALIGNMENT'. */
+    size_t size; /* The size of 'memory' in bytes. */
+    size_t used; /* The number of bytes of 'memory' used by the current frame. */
+    void* overflow; /* The blocks allocated by the allocator when 'memory' was full. They're freed by nmd_new_frame(). */
+    size_t overflow_size; /* The number of bytes in the 'overflow' blocks. */
+    size_t unused; /* The number of bytes of the buffers that were moved when they grew and of the released temporary memory that could not be reused. */
+    size_t high_water; /* The largest number of bytes in use at the same time by a frame, including the 'overflow' blocks. */
+    bool user_memory; /* True if 'memory' was provided by nmd_set_frame_memory(). */
+} nmd_frame_arena;
+
+/* Counters of a frame. See 'Profiling' at the top of the file. */
+typedef struct
+{
+    size_t num_vertices; /* The number of vertices in the draw list */
+    size_t num_indices; /* The number of indices in the draw list */
+    size_t num_draw_commands; /* The number of draw commands in the draw list */
+    size_t num_reallocations; /* The number of buffers in the frame arena that were copied because they could not grow in place */
+    size_t num_texture_binds; /* The number of textures bound by the renderers */
+} nmd_frame_stats;
+
+/* Called with 'begin' true when a profiled function(e.g. "nmd_new_frame") begins and with 'begin' false when it ends. 'user_data' is the pointer passed to nmd_set_profiler(). */
+typedef void (*nmd_profiler)(const char* zone, bool begin, void* user_data);
+
 typedef struct
 {
+    nmd_allocator allocator; /* The allocator used for all memory. If 'alloc' is null, the default allocator(NMD_MALLOC()/NMD_FREE()) is used */
+    nmd_frame_arena frame_arena; /* The memory of the draw list's buffers */
     nmd_drawlist draw_list; /* Vertices, indices, draw commands */
+    nmd_render_state render_state; /* The render state tracked by the renderers */
     nmd_io io; /* IO data */
     nmd_gui gui; /* Windows, gui related data */
+    nmd_retained retained; /* Retained geometry */
+    bool initialized; /* True if the context was initialized by nmd_new_frame() */
+    nmd_frame_stats stats; /* Counters of the current frame */
+    nmd_profiler profiler; /* The function set by nmd_set_profiler(), or a null pointer */
+    void* profiler_user_data; /* The 'user_data' passed to 'profiler' */
 
 #ifdef _WIN32
     HWND hWnd;
@@ -455,8 +815,76 @@ void nmd_prim_quad_uv(float x0, float y0, float x1, float y1, float x2, float y2
 nmd_color nmd_rgb(uint8_t r, uint8_t g, uint8_t b);
 nmd_color nmd_rgba(uint8_t r, uint8_t g, uint8_t b, uint8_t a);
 
+/* Returns the current context of the calling thread. */
 nmd_context* nmd_get_context();
 
+/*
+Makes 'context' the current context of the calling thread. All functions of the library use the current context.
+If 'context' is null, the default context is used, which is also the current context of threads that didn't call this function.
+*/
+void nmd_set_context(nmd_context* context);
+
+/*
+Initializes a context. The context uses the allocator, the render state settings, the blank texture and the default atlas of the current context, so the textures
+created by the renderers can be used by the draw lists of all contexts.
+*/
+void nmd_init_context(nmd_context* context);
+
+/* Frees the memory allocated by a context. The context can be used again after calling nmd_init_context(). */
+void nmd_destroy_context(nmd_context* context);
+
+/*
+Appends the draw commands, vertices and indices of 'draw_list' to the draw list of the current context, so draw lists recorded by other contexts(e.g. on worker threads)
+are rendered by one render call. nmd_end_frame() must have been called for 'draw_list'. Returns false if memory could not be allocated.
+*/
+bool nmd_append_draw_list(const nmd_drawlist* draw_list);
+
+/*
+If geometry was recorded under 'key' and it was not invalidated, it's appended to the draw list and false is returned.
+Otherwise the geometry added until nmd_end_retained() is recorded under 'key' and true is returned. Recording can't be nested.
+*/
+bool nmd_begin_retained(uint32_t key);
+
+/* Ends the recording started by nmd_begin_retained(). */
+void nmd_end_retained();
+
+/* Appends the geometry recorded under 'key' translated by('x', 'y'). Returns false if there's no valid geometry for 'key' or memory could not be allocated. */
+bool nmd_add_retained(uint32_t key, float x, float y);
+
+/* Invalidates the geometry recorded under 'key', so the next nmd_begin_retained() with this key records it again. */
+void nmd_invalidate_retained(uint32_t key);
+
+/* Frees the memory of all retained geometry. */
+void nmd_free_retained();
+
+/*
+Specifies the allocator used for all memory. If 'allocator' is null, the default allocator(NMD_MALLOC()/NMD_FREE()) is used.
+This function must be called before any other function of the library allocates memory, because memory is freed by the allocator that is set when it's freed.
+*/
+void nmd_set_allocator(const nmd_allocator* allocator);
+
+/* Sets the function called when nmd_new_frame(), nmd_end_frame() and the nmd_xxx_render() functions begin and end. 'profiler' may be null to stop profiling. */
+void nmd_set_profiler(nmd_profiler profiler, void* user_data);
+
+/*
+Specifies the memory of the frame arena, which is never resized. If 'memory' is null, the arena's memory is allocated by the allocator.
+Allocations that don't fit in the arena are made by the allocator, so 'size' should be at least 'nmd_get_context()->frame_arena.high_water' bytes.
+The memory must stay valid until nmd_set_frame_memory() is called again and the next nmd_new_frame() returns.
+*/
+void nmd_set_frame_memory(void* memory, size_t size);
+
+/* Specifies the categories of render state('NMD_RENDER_STATE_XXX') the renderers back up before rendering and restore after. The default is 'NMD_RENDER_STATE_ALL'. */
+void nmd_set_render_state_backup(uint32_t state_mask);
+
+/*
+Enables or disables the known host state mode. In this mode the renderers assume the render state they set is kept between frames,
+so they only set the categories that were restored or passed to nmd_invalidate_render_state() since the previous frame.
+*/
+void nmd_set_known_host_state(bool enable);
+
+/* Tells the renderers the application changed the categories of render state('NMD_RENDER_STATE_XXX') in 'state_mask', so they're set again by the next render call. */
+void nmd_invalidate_render_state(uint32_t state_mask);
+
 /* Specifies the begin of the window. Widgets can be added after calling this function. Returns true if the window is not minimized */
 bool nmd_begin(const char* window_name);
 
@@ -475,6 +903,30 @@ bool nmd_checkbox(const char* label, bool* checked);
 /* Adds a float slider widget. Returns true if the value changes. */
 bool nmd_slider_float(const char* label, float* value, float min_value, float max_value);
 
+/* Returns the ID of 'str' combined with the ID at the top of the ID stack. The ID is never zero. */
+uint32_t nmd_get_id(const char* str);
+
+/* Pushes the ID of 'str' on the ID stack, so widgets added until nmd_pop_id() have different IDs than widgets with the same label outside. */
+void nmd_push_id(const char* str);
+
+/* Pushes the ID of the integer 'id' on the ID stack. */
+void nmd_push_id_int(int id);
+
+/* Pops the ID pushed by the last nmd_push_id()/nmd_push_id_int(). */
+void nmd_pop_id();
+
+/* Returns the integer stored under 'id' by nmd_set_state_int(), or 'default_value' if there's none. */
+int nmd_get_state_int(uint32_t id, int default_value);
+
+/* Stores an integer under 'id' that persists between frames. */
+void nmd_set_state_int(uint32_t id, int value);
+
+/* Returns the float stored under 'id' by nmd_set_state_float(), or 'default_value' if there's none. */
+float nmd_get_state_float(uint32_t id, float default_value);
+
+/* Stores a float under 'id' that persists between frames. */
+void nmd_set_state_float(uint32_t id, float value);
+
 /* Starts a new empty scene/frame. Internally this function clears all vertices, indices and command buffers. */
 void nmd_new_frame();
 
@@ -482,18 +934,51 @@ void nmd_new_frame();
 void nmd_end_frame();
 
 /*
-Creates one or more draw commands for the unaccounted vertices and indices.
+Creates a draw command for the unaccounted vertices and indices. If the last draw command has the same texture and clip rect, it's extended instead.
 Parameters:
  clip_rect [opt/in] A pointer to a rect that specifies the clip area. This parameter can be null.
 */
 void nmd_push_draw_command(const nmd_rect* clip_rect);
 
+/*
+Same as nmd_push_draw_command(), but the draw command uses the texture 'user_texture_id'.
+Parameters:
+ user_texture_id [in]     The texture of the draw command.
+ clip_rect       [opt/in] A pointer to a rect that specifies the clip area. This parameter can be null.
+*/
 void nmd_push_texture_draw_command(nmd_tex_id user_texture_id, const nmd_rect* clip_rect);
 
 bool nmd_bake_font_from_memory(const void* font_data, nmd_atlas* atlas, float size);
 
 bool nmd_bake_font(const char* font_path, nmd_atlas* atlas, float size);
 
+/*
+Initializes a glyph cache. 'page_size' is the width and height of the textures, or zero for 'NMD_GLYPH_PAGE_SIZE'. The textures are created by 'create_texture'
+when a page is added, and the rectangles that changed are uploaded by 'update_texture' when nmd_glyph_cache_upload() is called.
+*/
+void nmd_glyph_cache_init(nmd_glyph_cache* cache, int page_size, nmd_tex_id(*create_texture)(void* pixels, int width, int height), void (*update_texture)(nmd_tex_id texture, const void* pixels, int x, int y, int width, int height, int pitch));
+
+/* Frees the memory of a glyph cache. The textures are not released. */
+void nmd_glyph_cache_destroy(nmd_glyph_cache* cache);
+
+/* Removes all glyphs and laid out strings. The pages are kept and reused. */
+void nmd_glyph_cache_clear(nmd_glyph_cache* cache);
+
+/* Uploads the pixels that changed since the last call. Call it before rendering the draw list. */
+void nmd_glyph_cache_upload(nmd_glyph_cache* cache);
+
+/* Initializes a font from TrueType data. The data must stay valid while the font is used. Returns false if the data is not a valid font. */
+bool nmd_font_init(nmd_font* font, nmd_glyph_cache* cache, const void* font_data);
+
+/* Frees the memory of a font. */
+void nmd_font_destroy(nmd_font* font);
+
+/* Adds UTF-8 text of 'size' pixels. 'y' is the baseline. The glyphs are rasterized by the font's glyph cache the first time they're used. */
+void nmd_add_text_cached(const nmd_font* font, float size, float x, float y, const char* text, const char* text_end, nmd_color color);
+
+/* Returns the width of UTF-8 text(the advance of the pen) and the height of a line of 'size' pixels. */
+void nmd_get_text_size_cached(const nmd_font* font, float size, const char* text, const char* text_end, nmd_vec2* size_out);
+
 #define NMD_COLOR_BLACK                 nmd_rgb(  0,   0,   0)
 #define NMD_COLOR_WHITE                 nmd_rgb(255, 255, 255)
 #define NMD_COLOR_RED                   nmd_rgb(255,   0,   0)
@@ -3,10 +3,10 @@
 #ifdef _WIN32
 LRESULT nmd_win32_wnd_proc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 {
-    if (!_nmd_context.hWnd && uMsg == WM_MOUSEMOVE)
+    if (!_nmd_context->hWnd && uMsg == WM_MOUSEMOVE)
     {
-        _nmd_context.io.mouse_pos.x = ((int)(short)LOWORD(lParam));
-        _nmd_context.io.mouse_pos.y = ((int)(short)HIWORD(lParam));
+        _nmd_context->io.mouse_pos.x = ((int)(short)LOWORD(lParam));
+        _nmd_context->io.mouse_pos.y = ((int)(short)HIWORD(lParam));
     }
 
 	/* Handle raw input */
@@ -22,21 +22,21 @@ LRESULT nmd_win32_wnd_proc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
                 {
                     if (ri.data.mouse.usFlags == MOUSE_MOVE_RELATIVE)
                     {
-                        _nmd_context.io.mouse_pos.x += (float)ri.data.mouse.lLastX;
-                        _nmd_context.io.mouse_pos.y += (float)ri.data.mouse.lLastY;
+                        _nmd_context->io.mouse_pos.x += (float)ri.data.mouse.lLastX;
+                        _nmd_context->io.mouse_pos.y += (float)ri.data.mouse.lLastY;
 
                         if (ri.data.mouse.usButtonFlags & RI_MOUSE_LEFT_BUTTON_DOWN)
-                            _nmd_context.io.mouse_down[0] = true, _nmd_context.io.mouse_clicked_pos[0] = _nmd_context.io.mouse_pos;
+                            _nmd_context->io.mouse_down[0] = true, _nmd_context->io.mouse_clicked_pos[0] = _nmd_context->io.mouse_pos;
                         else if (ri.data.mouse.usButtonFlags & RI_MOUSE_LEFT_BUTTON_UP)
-                            _nmd_context.io.mouse_down[0] = false, _nmd_context.io.mouse_released[0] = true;
+                            _nmd_context->io.mouse_down[0] = false, _nmd_context->io.mouse_released[0] = true;
                         if (ri.data.mouse.usButtonFlags & RI_MOUSE_RIGHT_BUTTON_DOWN)
-                            _nmd_context.io.mouse_down[1] = true, _nmd_context.io.mouse_clicked_pos[1] = _nmd_context.io.mouse_pos;
+                            _nmd_context->io.mouse_down[1] = true, _nmd_context->io.mouse_clicked_pos[1] = _nmd_context->io.mouse_pos;
                         else if (ri.data.mouse.usButtonFlags & RI_MOUSE_RIGHT_BUTTON_UP)
-                            _nmd_context.io.mouse_down[1] = false, _nmd_context.io.mouse_released[1] = true;
+                            _nmd_context->io.mouse_down[1] = false, _nmd_context->io.mouse_released[1] = true;
                         if (ri.data.mouse.usButtonFlags & RI_MOUSE_MIDDLE_BUTTON_DOWN)
-                            _nmd_context.io.mouse_down[2] = true, _nmd_context.io.mouse_clicked_pos[2] = _nmd_context.io.mouse_pos;
+                            _nmd_context->io.mouse_down[2] = true, _nmd_context->io.mouse_clicked_pos[2] = _nmd_context->io.mouse_pos;
                         else if (ri.data.mouse.usButtonFlags & RI_MOUSE_MIDDLE_BUTTON_UP)
-                            _nmd_context.io.mouse_down[2] = false, _nmd_context.io.mouse_released[2] = true;
+                            _nmd_context->io.mouse_down[2] = false, _nmd_context->io.mouse_released[2] = true;
                     }
                 }
             }
@@ -49,105 +49,231 @@ LRESULT nmd_win32_wnd_proc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
     case WM_KEYDOWN:
     case WM_SYSKEYDOWN:
         if(wParam < 256)
-            _nmd_context.io.keys_down[wParam] = true;
+            _nmd_context->io.keys_down[wParam] = true;
         return 0;
     case WM_KEYUP:
     case WM_SYSKEYUP:
         if (wParam < 256)
-            _nmd_context.io.keys_down[wParam] = false;
+            _nmd_context->io.keys_down[wParam] = false;
         return 0;
 
     /* Handle mouse buttons */
-    case WM_LBUTTONDOWN: _nmd_context.io.mouse_down[0] = true; _nmd_context.io.mouse_clicked_pos[0] = _nmd_context.io.mouse_pos; return 0;
-    case WM_LBUTTONUP: _nmd_context.io.mouse_down[0] = false; _nmd_context.io.mouse_released[0] = true; return 0;
+    case WM_LBUTTONDOWN: _nmd_context->io.mouse_down[0] = true; _nmd_context->io.mouse_clicked_pos[0] = _nmd_context->io.mouse_pos; return 0;
+    case WM_LBUTTONUP: _nmd_context->io.mouse_down[0] = false; _nmd_context->io.mouse_released[0] = true; return 0;
 
-    case WM_RBUTTONDOWN: _nmd_context.io.mouse_down[1] = true; _nmd_context.io.mouse_clicked_pos[1] = _nmd_context.io.mouse_pos; return 0;
-    case WM_RBUTTONUP: _nmd_context.io.mouse_down[1] = false; _nmd_context.io.mouse_released[1] = true; return 0;
+    case WM_RBUTTONDOWN: _nmd_context->io.mouse_down[1] = true; _nmd_context->io.mouse_clicked_pos[1] = _nmd_context->io.mouse_pos; return 0;
+    case WM_RBUTTONUP: _nmd_context->io.mouse_down[1] = false; _nmd_context->io.mouse_released[1] = true; return 0;
 
-    case WM_MBUTTONDOWN: _nmd_context.io.mouse_down[2] = true; _nmd_context.io.mouse_clicked_pos[2] = _nmd_context.io.mouse_pos; return 0;
-    case WM_MBUTTONUP: _nmd_context.io.mouse_down[2] = false;  _nmd_context.io.mouse_released[2] = true; return 0;
+    case WM_MBUTTONDOWN: _nmd_context->io.mouse_down[2] = true; _nmd_context->io.mouse_clicked_pos[2] = _nmd_context->io.mouse_pos; return 0;
+    case WM_MBUTTONUP: _nmd_context->io.mouse_down[2] = false;  _nmd_context->io.mouse_released[2] = true; return 0;
 
-    case WM_XBUTTONDOWN: _nmd_context.io.mouse_down[GET_XBUTTON_WPARAM(wParam) == XBUTTON1 ? 3 : 4] = true; return 0;
-    case WM_XBUTTONUP: _nmd_context.io.mouse_down[GET_XBUTTON_WPARAM(wParam) == XBUTTON1 ? 3 : 4] = false; return 0;
+    case WM_XBUTTONDOWN: _nmd_context->io.mouse_down[GET_XBUTTON_WPARAM(wParam) == XBUTTON1 ? 3 : 4] = true; return 0;
+    case WM_XBUTTONUP: _nmd_context->io.mouse_down[GET_XBUTTON_WPARAM(wParam) == XBUTTON1 ? 3 : 4] = false; return 0;
     }
 
     return 0;
 }
 #endif /* _WIN32 */
 
-/* This is a very simple hash function which takes a string and returns a 32-bit number which should be unique for the string */
-uint32_t _nmd_hash_string_to_uint32(const char* string)
+/* Hashes 'size' bytes with FNV-1a starting from 'seed', then mixes the bits so the low bits used by the hash maps are well distributed. Never returns zero. */
+uint32_t _nmd_hash_data(const void* data, size_t size, uint32_t seed)
 {
-    if (!*string)
-        return 0;
+    uint32_t hash = 0x811C9DC5 ^ seed;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ ((const uint8_t*)data)[i]) * 0x01000193;
+
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6B;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35;
+    hash ^= hash >> 16;
+
+    /* Zero marks empty entries in hash maps */
+    return hash ? hash : 1;
+}
 
-    /* Starting hash */
-    uint32_t hash = 0xDEADC0DE + *string;
+uint32_t _nmd_hash_string(const char* string, uint32_t seed)
+{
+    return _nmd_hash_data(string, NMD_STRLEN(string), seed);
+}
 
-    /* This 2-byte pointer is used to constantly shift between different parts of 'hash' */
-    uint16_t* p;
+/* Returns the entry of 'key' in 'map' or a null pointer if there's none */
+nmd_id_map_entry* _nmd_id_map_find(const nmd_id_map* map, uint32_t key)
+{
+    if (!map->entries)
+        return 0;
 
-    for (size_t i = 1; string[i]; i++)
+    for (size_t i = key & (map->capacity - 1); map->entries[i].key; i = (i + 1) & (map->capacity - 1))
     {
-        /*
-        If 'i' modulo 3 is 0, then point to the first and second bytes of 'hash'
-        If 'i' modulo 3 is 1, then point to the second and third bytes of 'hash'
-        If 'i' modulo 3 is 2, then point to the third and fourth bytes of 'hash'
-        */
-        p = (uint16_t*)((uint8_t*)&hash+(i%3));
-
-        /* Do some random XOR between the two bytes pointed by 'p' and string[i] and string[i -1] */
-        *p = *p ^ ((string[i - 1] << 8) | string[i]);
+        if (map->entries[i].key == key)
+            return map->entries + i;
     }
 
-    return hash;
+    return 0;
 }
 
-/* Iterates through all windows in the global context and return the window that has the ID equal to 'window_hash' */
-nmd_window* _nmd_find_window_by_hash(uint32_t window_hash)
+/* Returns the entry of 'key' in 'map', it's added with a zeroed value if there's none. Returns a null pointer if memory could not be allocated. */
+nmd_id_map_entry* _nmd_id_map_insert(nmd_id_map* map, uint32_t key)
 {
-    for (size_t i = 0; i < _nmd_context.gui.num_windows; i++)
+    nmd_id_map_entry* entry = _nmd_id_map_find(map, key);
+    if (entry)
+        return entry;
+
+    /* Keep the load factor under 70% */
+    if ((map->num_entries + 1) * 10 > map->capacity * 7)
     {
-        if (_nmd_context.gui.windows[i].id == window_hash)
-            return _nmd_context.gui.windows + i;
+        const size_t new_capacity = NMD_MAX(map->capacity * 2, NMD_ID_MAP_INITIAL_SIZE);
+        nmd_id_map_entry* entries = (nmd_id_map_entry*)_nmd_alloc(new_capacity * sizeof(nmd_id_map_entry));
+        if (!entries)
+            return 0;
+        NMD_MEMSET(entries, 0, new_capacity * sizeof(nmd_id_map_entry));
+
+        for (size_t i = 0; i < map->capacity; i++)
+        {
+            if (!map->entries[i].key)
+                continue;
+
+            size_t j = map->entries[i].key & (new_capacity - 1);
+            while (entries[j].key)
+                j = (j + 1) & (new_capacity - 1);
+            entries[j] = map->entries[i];
+        }
+
+        _nmd_free(map->entries);
+        map->entries = entries;
+        map->capacity = new_capacity;
     }
 
-    return 0;
+    size_t i = key & (map->capacity - 1);
+    while (map->entries[i].key)
+        i = (i + 1) & (map->capacity - 1);
+
+    entry = map->entries + i;
+    entry->key = key;
+    map->num_entries++;
+
+    return entry;
+}
+
+/* Frees the entries of 'map' */
+void _nmd_id_map_free(nmd_id_map* map)
+{
+    _nmd_free(map->entries);
+    map->entries = 0;
+    map->num_entries = 0;
+    map->capacity = 0;
+}
+
+/* Returns the window that has the ID equal to 'window_hash' or a null pointer if there's none */
+nmd_window* _nmd_find_window_by_hash(uint32_t window_hash)
+{
+    const nmd_id_map_entry* entry = _nmd_id_map_find(&_nmd_context->gui.window_map, window_hash);
+    return entry ? _nmd_context->gui.windows + entry->value.index : 0;
 }
 
 /* Helper function. Wrapper around '_nmd_find_window_by_hash' but it takes a string */
 nmd_window* _nmd_find_window_by_name(const char* window_name)
 {
-    return _nmd_find_window_by_hash(_nmd_hash_string_to_uint32(window_name));
+    return _nmd_find_window_by_hash(_nmd_hash_string(window_name, 0));
+}
+
+/* Returns the ID at the top of the ID stack, or zero if the stack is empty */
+uint32_t _nmd_get_id_seed()
+{
+    const size_t size = _nmd_context->gui.id_stack_size;
+    return size ? _nmd_context->gui.id_stack[NMD_MIN(size, NMD_ID_STACK_SIZE) - 1] : 0;
+}
+
+void _nmd_push_id(uint32_t id)
+{
+    if (_nmd_context->gui.id_stack_size < NMD_ID_STACK_SIZE)
+        _nmd_context->gui.id_stack[_nmd_context->gui.id_stack_size] = id;
+    _nmd_context->gui.id_stack_size++;
+}
+
+uint32_t nmd_get_id(const char* str)
+{
+    return _nmd_hash_string(str, _nmd_get_id_seed());
+}
+
+void nmd_push_id(const char* str)
+{
+    _nmd_push_id(nmd_get_id(str));
+}
+
+void nmd_push_id_int(int id)
+{
+    _nmd_push_id(_nmd_hash_data(&id, sizeof(id), _nmd_get_id_seed()));
+}
+
+void nmd_pop_id()
+{
+    if (_nmd_context->gui.id_stack_size)
+        _nmd_context->gui.id_stack_size--;
+}
+
+int nmd_get_state_int(uint32_t id, int default_value)
+{
+    const nmd_id_map_entry* entry = _nmd_id_map_find(&_nmd_context->gui.state_map, id);
+    return entry ? entry->value.i : default_value;
+}
+
+void nmd_set_state_int(uint32_t id, int value)
+{
+    nmd_id_map_entry* entry = _nmd_id_map_insert(&_nmd_context->gui.state_map, id);
+    if (entry)
+        entry->value.i = value;
+}
+
+float nmd_get_state_float(uint32_t id, float default_value)
+{
+    const nmd_id_map_entry* entry = _nmd_id_map_find(&_nmd_context->gui.state_map, id);
+    return entry ? entry->value.f : default_value;
+}
+
+void nmd_set_state_float(uint32_t id, float value)
+{
+    nmd_id_map_entry* entry = _nmd_id_map_insert(&_nmd_context->gui.state_map, id);
+    if (entry)
+        entry->value.f = value;
 }
 
 /* Specifies the beginning of the window. Widgets can be added after calling this function. Returns true if the window is not minimized */
 bool nmd_begin(const char* window_name)
 {
-    nmd_window* window = _nmd_find_window_by_name(window_name);
+    const uint32_t window_id = _nmd_hash_string(window_name, 0);
+    nmd_window* window = _nmd_find_window_by_hash(window_id);
     if (!window)
     {
         /* Add window */
 
         /* Check if we need to resize the buffer */
-        if (_nmd_context.gui.num_windows == _nmd_context.gui.windows_capacity)
+        if (_nmd_context->gui.num_windows == _nmd_context->gui.windows_capacity)
         {
-            _nmd_context.gui.windows_capacity *= 2;
-            void* mem = NMD_MALLOC(_nmd_context.gui.windows_capacity);
+            const size_t new_capacity = NMD_MAX(_nmd_context->gui.windows_capacity * 2, NMD_WINDOWS_BUFFER_INITIAL_SIZE);
+            void* mem = _nmd_alloc(new_capacity * sizeof(nmd_window));
             if (!mem)
                 return false;
-            NMD_MEMCPY(mem, _nmd_context.gui.windows, _nmd_context.gui.num_windows);
-            NMD_FREE(_nmd_context.gui.windows);
+            NMD_MEMCPY(mem, _nmd_context->gui.windows, _nmd_context->gui.num_windows * sizeof(nmd_window));
+            _nmd_free(_nmd_context->gui.windows);
+
+            _nmd_context->gui.windows = (nmd_window*)mem;
+            _nmd_context->gui.windows_capacity = new_capacity;
         }
 
-        window = &_nmd_context.gui.windows[_nmd_context.gui.num_windows++];
-        window->id = _nmd_hash_string_to_uint32(window_name);
-        window->rect.p0 = _nmd_context.gui.window_pos;
+        nmd_id_map_entry* entry = _nmd_id_map_insert(&_nmd_context->gui.window_map, window_id);
+        if (!entry)
+            return false;
+        entry->value.index = _nmd_context->gui.num_windows;
+
+        window = &_nmd_context->gui.windows[_nmd_context->gui.num_windows++];
+        window->id = window_id;
+        window->rect.p0 = _nmd_context->gui.window_pos;
         window->rect.p1.x = window->rect.p0.x + 250;
         window->rect.p1.y = window->rect.p0.y + 230;
         window->visible = true;
         window->collapsed = false;
-        window->allow_close = _nmd_context.gui.num_windows == 0 ? false : true;
+        window->allow_close = _nmd_context->gui.num_windows == 0 ? false : true;
         window->allow_collapse = true;
         window->allow_move_title_bar = true;
         window->allow_move_body = true;
@@ -155,21 +281,25 @@ bool nmd_begin(const char* window_name)
         window->moving = false;
     }
 
-    _nmd_context.gui.window = window;
+    _nmd_context->gui.window = window;
+
+    /* The window's ID is the seed of the IDs of its widgets */
+    _nmd_context->gui.id_stack_size = 0;
+    _nmd_push_id(window_id);
 
     if (!window->visible)
         return false;
 
     if (window->moving)
     {
-        if (_nmd_context.io.mouse_down[0])
+        if (_nmd_context->io.mouse_down[0])
         {
             /* Move window */
             const int width = window->rect.p1.x - window->rect.p0.x;
             const int height = window->rect.p1.y - window->rect.p0.y;
 
-            window->rect.p0.x = _nmd_context.io.mouse_pos.x - _nmd_context.io.window_move_delta.x;
-            window->rect.p0.y = _nmd_context.io.mouse_pos.y - _nmd_context.io.window_move_delta.y;
+            window->rect.p0.x = _nmd_context->io.mouse_pos.x - _nmd_context->io.window_move_delta.x;
+            window->rect.p0.y = _nmd_context->io.mouse_pos.y - _nmd_context->io.window_move_delta.y;
             window->rect.p1.x = window->rect.p0.x + width;
             window->rect.p1.y = window->rect.p0.y + height;
         }
@@ -181,43 +311,43 @@ bool nmd_begin(const char* window_name)
     nmd_add_rect_filled(window->rect.p0.x, window->rect.p0.y, window->rect.p1.x, window->rect.p0.y + 18.0f, NMD_COLOR_GUI_MAIN, 5.0f, window->collapsed ? NMD_CORNER_ALL : NMD_CORNER_TOP);
     
     /* Add window name */
-    nmd_add_text(&_nmd_context.draw_list.default_atlas, window->rect.p0.x + (window->allow_collapse ? 20 : 0), window->rect.p0.y + 13, window_name, 0, NMD_COLOR_WHITE);
+    nmd_add_text(&_nmd_context->draw_list.default_atlas, window->rect.p0.x + (window->allow_collapse ? 20 : 0), window->rect.p0.y + 13, window_name, 0, NMD_COLOR_WHITE);
 
     /* Check if window can be collapsed and if the mouse is over the collapse/expand triangle */
-    if (window->allow_collapse && _nmd_context.io.mouse_pos.x >= window->rect.p0.x + 1 && _nmd_context.io.mouse_pos.x < window->rect.p0.x + 17 && _nmd_context.io.mouse_pos.y >= window->rect.p0.y + 1 && _nmd_context.io.mouse_pos.y < window->rect.p0.y + 17)
+    if (window->allow_collapse && _nmd_context->io.mouse_pos.x >= window->rect.p0.x + 1 && _nmd_context->io.mouse_pos.x < window->rect.p0.x + 17 && _nmd_context->io.mouse_pos.y >= window->rect.p0.y + 1 && _nmd_context->io.mouse_pos.y < window->rect.p0.y + 17)
     {
         /* Check if we properly clicked the triangle */
-        if (_nmd_context.io.mouse_released[0])
+        if (_nmd_context->io.mouse_released[0])
         {
-            if (_nmd_context.io.mouse_clicked_pos[0].x >= window->rect.p0.x + 1 && _nmd_context.io.mouse_clicked_pos[0].x < window->rect.p0.x + 17 && _nmd_context.io.mouse_clicked_pos[0].y >= window->rect.p0.y + 1 && _nmd_context.io.mouse_clicked_pos[0].y < window->rect.p0.y + 17)
+            if (_nmd_context->io.mouse_clicked_pos[0].x >= window->rect.p0.x + 1 && _nmd_context->io.mouse_clicked_pos[0].x < window->rect.p0.x + 17 && _nmd_context->io.mouse_clicked_pos[0].y >= window->rect.p0.y + 1 && _nmd_context->io.mouse_clicked_pos[0].y < window->rect.p0.y + 17)
                 window->collapsed = !window->collapsed;
         }
         
         /* Add filled circle behind triangle */
-        nmd_add_circle_filled(window->rect.p0.x + 9.0f, window->rect.p0.y + 9.0f, 7.5f, _nmd_context.io.mouse_down[0] ? NMD_COLOR_GUI_PRESSED : NMD_COLOR_GUI_HOVER, 12);
+        nmd_add_circle_filled(window->rect.p0.x + 9.0f, window->rect.p0.y + 9.0f, 7.5f, _nmd_context->io.mouse_down[0] ? NMD_COLOR_GUI_PRESSED : NMD_COLOR_GUI_HOVER, 12);
     } 
     /* Check if the window can be closed and if the mouse is over the close button */
-    else if (window->allow_close && _nmd_context.io.mouse_pos.x >= window->rect.p1.x - 17 && _nmd_context.io.mouse_pos.x < window->rect.p1.x - 1 && _nmd_context.io.mouse_pos.y >= window->rect.p0.y + 1 && _nmd_context.io.mouse_pos.y < window->rect.p0.y + 17)
+    else if (window->allow_close && _nmd_context->io.mouse_pos.x >= window->rect.p1.x - 17 && _nmd_context->io.mouse_pos.x < window->rect.p1.x - 1 && _nmd_context->io.mouse_pos.y >= window->rect.p0.y + 1 && _nmd_context->io.mouse_pos.y < window->rect.p0.y + 17)
     {
         /* Check if we properly clicked the close button */
-        if (_nmd_context.io.mouse_released[0])
+        if (_nmd_context->io.mouse_released[0])
         {
-            if (_nmd_context.io.mouse_clicked_pos[0].x >= window->rect.p1.x - 10 && _nmd_context.io.mouse_clicked_pos[0].x < window->rect.p1.x - 1 && _nmd_context.io.mouse_clicked_pos[0].y >= window->rect.p0.y + 1 && _nmd_context.io.mouse_clicked_pos[0].y < window->rect.p0.y + 17)
+            if (_nmd_context->io.mouse_clicked_pos[0].x >= window->rect.p1.x - 10 && _nmd_context->io.mouse_clicked_pos[0].x < window->rect.p1.x - 1 && _nmd_context->io.mouse_clicked_pos[0].y >= window->rect.p0.y + 1 && _nmd_context->io.mouse_clicked_pos[0].y < window->rect.p0.y + 17)
                 window->visible = false;
         }
 
         /* Add filled circle behind triangle */
-        nmd_add_circle_filled(window->rect.p1.x - 9.5f, window->rect.p0.y + 9.0f, 7.5f, _nmd_context.io.mouse_down[0] ? NMD_COLOR_GUI_PRESSED : NMD_COLOR_GUI_HOVER, 12);
+        nmd_add_circle_filled(window->rect.p1.x - 9.5f, window->rect.p0.y + 9.0f, 7.5f, _nmd_context->io.mouse_down[0] ? NMD_COLOR_GUI_PRESSED : NMD_COLOR_GUI_HOVER, 12);
     }
     /* Check if the window's title bar can be dragged and if the mouse is over the title bar */
-    else if (window->allow_move_title_bar && _nmd_context.io.mouse_pos.x >= window->rect.p0.x && _nmd_context.io.mouse_pos.x < window->rect.p1.x && _nmd_context.io.mouse_pos.y >= window->rect.p0.y && _nmd_context.io.mouse_pos.y < window->rect.p0.y + 18.0f && !window->moving)
+    else if (window->allow_move_title_bar && _nmd_context->io.mouse_pos.x >= window->rect.p0.x && _nmd_context->io.mouse_pos.x < window->rect.p1.x && _nmd_context->io.mouse_pos.y >= window->rect.p0.y && _nmd_context->io.mouse_pos.y < window->rect.p0.y + 18.0f && !window->moving)
     {
         /* Determine if the window is being moved */
-        window->moving = _nmd_context.io.mouse_down[0];
+        window->moving = _nmd_context->io.mouse_down[0];
         if (window->moving)
         {
-            _nmd_context.io.window_move_delta.x = _nmd_context.io.mouse_pos.x - window->rect.p0.x;
-            _nmd_context.io.window_move_delta.y = _nmd_context.io.mouse_pos.y - window->rect.p0.y;
+            _nmd_context->io.window_move_delta.x = _nmd_context->io.mouse_pos.x - window->rect.p0.x;
+            _nmd_context->io.window_move_delta.y = _nmd_context->io.mouse_pos.y - window->rect.p0.y;
         }
     }
     
@@ -255,22 +385,23 @@ bool nmd_begin(const char* window_name)
 /* Specifies the end of the window. Widgets won't be added after calling this function */
 void nmd_end()
 {
-    _nmd_context.gui.window = 0;
+    _nmd_context->gui.window = 0;
+    _nmd_context->gui.id_stack_size = 0;
 }
 
 void nmd_text(const char* fmt, ...)
 {
     /* Make sure we can draw this widget */
-    nmd_window* window = _nmd_context.gui.window;
+    nmd_window* window = _nmd_context->gui.window;
     if (!window->visible || window->collapsed)
         return;
 
     va_list args;
     va_start(args, fmt);
-    const int size = NMD_VSPRINTF(_nmd_context.gui.fmt_buffer, fmt, args);
+    const int size = NMD_VSPRINTF(_nmd_context->gui.fmt_buffer, fmt, args);
     va_end(args);
 
-    nmd_add_text(&_nmd_context.draw_list.default_atlas, window->rect.p0.x + 6, window->y_offset + 10, _nmd_context.gui.fmt_buffer, _nmd_context.gui.fmt_buffer + size, NMD_COLOR_WHITE);
+    nmd_add_text(&_nmd_context->draw_list.default_atlas, window->rect.p0.x + 6, window->y_offset + 10, _nmd_context->gui.fmt_buffer, _nmd_context->gui.fmt_buffer + size, NMD_COLOR_WHITE);
 
     window->y_offset += 10 + 5;
 }
@@ -278,21 +409,21 @@ void nmd_text(const char* fmt, ...)
 bool nmd_button(const char* label)
 {
     /* Make sure we can draw this widget */
-    nmd_window* window = _nmd_context.gui.window;
+    nmd_window* window = _nmd_context->gui.window;
     if (!window->visible || window->collapsed)
         return false;
 
     nmd_vec2 size;
-    nmd_get_text_size(&_nmd_context.draw_list.default_atlas, label, 0, &size);
+    nmd_get_text_size(&_nmd_context->draw_list.default_atlas, label, 0, &size);
 
-    const bool is_mouse_hovering = _nmd_context.io.mouse_pos.x >= window->rect.p0.x + 6 && _nmd_context.io.mouse_pos.x < window->rect.p0.x + 6 + size.x + 8 && _nmd_context.io.mouse_pos.y >= window->y_offset && _nmd_context.io.mouse_pos.y < window->y_offset + 16;
+    const bool is_mouse_hovering = _nmd_context->io.mouse_pos.x >= window->rect.p0.x + 6 && _nmd_context->io.mouse_pos.x < window->rect.p0.x + 6 + size.x + 8 && _nmd_context->io.mouse_pos.y >= window->y_offset && _nmd_context->io.mouse_pos.y < window->y_offset + 16;
 
-    const bool clicked_button = is_mouse_hovering && _nmd_context.io.mouse_released[0] && _nmd_context.io.mouse_clicked_pos[0].x >= window->rect.p0.x + 6 && _nmd_context.io.mouse_clicked_pos[0].x < window->rect.p0.x + 6 + size.x + 8 && _nmd_context.io.mouse_clicked_pos[0].y >= window->y_offset && _nmd_context.io.mouse_clicked_pos[0].y < window->y_offset + 16;
+    const bool clicked_button = is_mouse_hovering && _nmd_context->io.mouse_released[0] && _nmd_context->io.mouse_clicked_pos[0].x >= window->rect.p0.x + 6 && _nmd_context->io.mouse_clicked_pos[0].x < window->rect.p0.x + 6 + size.x + 8 && _nmd_context->io.mouse_clicked_pos[0].y >= window->y_offset && _nmd_context->io.mouse_clicked_pos[0].y < window->y_offset + 16;
 
     /* Add background filled rect */
     nmd_add_rect_filled(window->rect.p0.x + 6, window->y_offset, window->rect.p0.x + 6 + size.x + 8, window->y_offset + 16, is_mouse_hovering ? NMD_COLOR_GUI_BUTTON_HOVER : NMD_COLOR_GUI_BUTTON_BACKGROUND, 0, 0);
     
-    nmd_add_text(&_nmd_context.draw_list.default_atlas, window->rect.p0.x + 6 + 4, window->y_offset + 11, label, 0, NMD_COLOR_WHITE);
+    nmd_add_text(&_nmd_context->draw_list.default_atlas, window->rect.p0.x + 6 + 4, window->y_offset + 11, label, 0, NMD_COLOR_WHITE);
 
     window->y_offset += 16 + 5;
 
@@ -302,15 +433,15 @@ bool nmd_button(const char* label)
 bool nmd_checkbox(const char* label, bool* checked)
 {
     /* Make sure we can draw this widget */
-    nmd_window* window = _nmd_context.gui.window;
+    nmd_window* window = _nmd_context->gui.window;
     if (!window->visible || window->collapsed)
         return false;
 
-    const bool is_mouse_hovering = _nmd_context.io.mouse_pos.x >= window->rect.p0.x + 6 && _nmd_context.io.mouse_pos.x < window->rect.p0.x + 6 + 16 && _nmd_context.io.mouse_pos.y >= window->y_offset && _nmd_context.io.mouse_pos.y < window->y_offset + 16;
+    const bool is_mouse_hovering = _nmd_context->io.mouse_pos.x >= window->rect.p0.x + 6 && _nmd_context->io.mouse_pos.x < window->rect.p0.x + 6 + 16 && _nmd_context->io.mouse_pos.y >= window->y_offset && _nmd_context->io.mouse_pos.y < window->y_offset + 16;
     
     bool state_changed = false;
 
-    if (is_mouse_hovering && _nmd_context.io.mouse_released[0] && _nmd_context.io.mouse_clicked_pos[0].x >= window->rect.p0.x + 6 && _nmd_context.io.mouse_clicked_pos[0].x < window->rect.p0.x + 6 + 16 && _nmd_context.io.mouse_clicked_pos[0].y >= window->y_offset && _nmd_context.io.mouse_clicked_pos[0].y < window->y_offset + 16)
+    if (is_mouse_hovering && _nmd_context->io.mouse_released[0] && _nmd_context->io.mouse_clicked_pos[0].x >= window->rect.p0.x + 6 && _nmd_context->io.mouse_clicked_pos[0].x < window->rect.p0.x + 6 + 16 && _nmd_context->io.mouse_clicked_pos[0].y >= window->y_offset && _nmd_context->io.mouse_clicked_pos[0].y < window->y_offset + 16)
     {
         *checked = !*checked;
         state_changed = true;
@@ -325,7 +456,7 @@ bool nmd_checkbox(const char* label, bool* checked)
 
     window->y_offset += 16 + 4;
 
-    nmd_add_text(&_nmd_context.draw_list.default_atlas, window->rect.p0.x + 6 + 16 + 4, window->y_offset - 9, label, 0, NMD_COLOR_WHITE);
+    nmd_add_text(&_nmd_context->draw_list.default_atlas, window->rect.p0.x + 6 + 16 + 4, window->y_offset - 9, label, 0, NMD_COLOR_WHITE);
 
     return state_changed;
 }
@@ -334,7 +465,7 @@ bool nmd_checkbox(const char* label, bool* checked)
 bool nmd_slider_float(const char* label, float* value, float min_value, float max_value)
 {
     /* Make sure we can draw this widget */
-    nmd_window* window = _nmd_context.gui.window;
+    nmd_window* window = _nmd_context->gui.window;
     if (!window->visible || window->collapsed || *value < min_value || *value > max_value)
         return false;
 
@@ -342,25 +473,35 @@ bool nmd_slider_float(const char* label, float* value, float min_value, float ma
 
     bool value_changed = false;
 
+    /* The slider is held from the moment the mouse is pressed on it until it's released */
+    const uint32_t id = nmd_get_id(label);
+    if (!_nmd_context->io.mouse_down[0])
+    {
+        if (_nmd_context->gui.active_id == id)
+            _nmd_context->gui.active_id = 0;
+    }
+    else if (!_nmd_context->gui.active_id && _nmd_context->io.mouse_clicked_pos[0].x >= window->rect.p0.x + 6 && _nmd_context->io.mouse_clicked_pos[0].x < window->rect.p0.x + 6 + _NMD_SLIDER_WIDTH && _nmd_context->io.mouse_clicked_pos[0].y >= window->y_offset && _nmd_context->io.mouse_clicked_pos[0].y < window->y_offset + 16)
+        _nmd_context->gui.active_id = id;
+
     /* Check if the user is sliding the slider */
-    if (_nmd_context.io.mouse_down[0] && _nmd_context.io.mouse_clicked_pos[0].x >= window->rect.p0.x + 6 && _nmd_context.io.mouse_clicked_pos[0].x < window->rect.p0.x + 6 + _NMD_SLIDER_WIDTH && _nmd_context.io.mouse_clicked_pos[0].y >= window->y_offset && _nmd_context.io.mouse_clicked_pos[0].y < window->y_offset + 16)
+    if (_nmd_context->gui.active_id == id)
     {
         const float last_value = *value;
 
         /* Calculte the new offset */
-        if (_nmd_context.io.mouse_pos.x < window->rect.p0.x + 6 + 6)
+        if (_nmd_context->io.mouse_pos.x < window->rect.p0.x + 6 + 6)
         {
             offset = 0;
             *value = min_value;
         }
-        else if (_nmd_context.io.mouse_pos.x >= window->rect.p0.x + 6 + _NMD_SLIDER_WIDTH - 6)
+        else if (_nmd_context->io.mouse_pos.x >= window->rect.p0.x + 6 + _NMD_SLIDER_WIDTH - 6)
         {
             offset = _NMD_SLIDER_WIDTH - 12;
             *value = max_value;
         }
         else
         {
-            offset = _nmd_context.io.mouse_pos.x - (window->rect.p0.x + 6) - 6;
+            offset = _nmd_context->io.mouse_pos.x - (window->rect.p0.x + 6) - 6;
             *value = (offset / (_NMD_SLIDER_WIDTH -6)) * (max_value - min_value) + min_value;
         }
 
@@ -376,7 +517,7 @@ bool nmd_slider_float(const char* label, float* value, float min_value, float ma
     }
     //offset = (*value / max_value) * (120-12) - min_value;
 
-    const bool is_mouse_hovering = _nmd_context.io.mouse_pos.x >= window->rect.p0.x + 6 && _nmd_context.io.mouse_pos.x < window->rect.p0.x + 6 + _NMD_SLIDER_WIDTH && _nmd_context.io.mouse_pos.y >= window->y_offset && _nmd_context.io.mouse_pos.y < window->y_offset + 16;
+    const bool is_mouse_hovering = _nmd_context->io.mouse_pos.x >= window->rect.p0.x + 6 && _nmd_context->io.mouse_pos.x < window->rect.p0.x + 6 + _NMD_SLIDER_WIDTH && _nmd_context->io.mouse_pos.y >= window->y_offset && _nmd_context->io.mouse_pos.y < window->y_offset + 16;
 
     /* Add background filled rect */
     nmd_add_rect_filled(window->rect.p0.x + 6, window->y_offset, window->rect.p0.x + 6 + _NMD_SLIDER_WIDTH, window->y_offset + 16, is_mouse_hovering ? NMD_COLOR_GUI_WIDGET_HOVER : NMD_COLOR_GUI_WIDGET_BACKGROUND, 0, 0);
@@ -385,11 +526,11 @@ bool nmd_slider_float(const char* label, float* value, float min_value, float ma
     nmd_add_rect_filled(window->rect.p0.x + 6 + 2 + offset, window->y_offset + 2, window->rect.p0.x + 6 + 2 + offset + 8, window->y_offset + 16 - 2, NMD_COLOR_GUI_ACTIVE, 0, 0);
 
     /* Add value text */
-    const int size = NMD_SPRINTF(_nmd_context.gui.fmt_buffer, "%.3f", *value);
-    nmd_add_text(&_nmd_context.draw_list.default_atlas, window->rect.p0.x + 6 + (_NMD_SLIDER_WIDTH/2-15), window->y_offset + 12, _nmd_context.gui.fmt_buffer, _nmd_context.gui.fmt_buffer + size, NMD_COLOR_WHITE);
+    const int size = NMD_SPRINTF(_nmd_context->gui.fmt_buffer, "%.3f", *value);
+    nmd_add_text(&_nmd_context->draw_list.default_atlas, window->rect.p0.x + 6 + (_NMD_SLIDER_WIDTH/2-15), window->y_offset + 12, _nmd_context->gui.fmt_buffer, _nmd_context->gui.fmt_buffer + size, NMD_COLOR_WHITE);
 
     /* Add label text */
-    nmd_add_text(&_nmd_context.draw_list.default_atlas, window->rect.p0.x + 6 + _NMD_SLIDER_WIDTH + 4, window->y_offset + 12, label, 0, NMD_COLOR_WHITE);
+    nmd_add_text(&_nmd_context->draw_list.default_atlas, window->rect.p0.x + 6 + _NMD_SLIDER_WIDTH + 4, window->y_offset + 12, label, 0, NMD_COLOR_WHITE);
 
     window->y_offset += 16 + 5;
 
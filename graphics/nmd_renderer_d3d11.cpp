@@ -28,6 +28,7 @@ void nmd_d3d11_set_device_context(ID3D11DeviceContext* device_context)
 {
     _nmd_d3d11.device_context = device_context;
     _nmd_d3d11.device_context->GetDevice(&_nmd_d3d11.device);
+    nmd_invalidate_render_state(NMD_RENDER_STATE_ALL);
 }
 
 nmd_tex_id nmd_d3d11_create_texture(void* pixels, int width, int height)
@@ -69,6 +70,26 @@ nmd_tex_id nmd_d3d11_create_texture(void* pixels, int width, int height)
     return failed ? 0 : (nmd_tex_id)shader_resource_view;
 }
 
+void nmd_d3d11_update_texture(nmd_tex_id texture, const void* pixels, int x, int y, int width, int height, int pitch)
+{
+    if (!_nmd_d3d11.device_context)
+        return;
+
+    ID3D11Resource* resource;
+    ((ID3D11ShaderResourceView*)texture)->GetResource(&resource);
+
+    D3D11_BOX box;
+    box.left = x;
+    box.top = y;
+    box.front = 0;
+    box.right = x + width;
+    box.bottom = y + height;
+    box.back = 1;
+    _nmd_d3d11.device_context->UpdateSubresource(resource, 0, &box, pixels, pitch, 0);
+
+    resource->Release();
+}
+
 bool _nmd_d3d11_create_objects()
 {
     _nmd_d3d11.viewport.MinDepth = 0.0f;
@@ -201,17 +222,17 @@ bool _nmd_d3d11_create_objects()
     depth_stencil_desc.BackFace = depth_stencil_desc.FrontFace;
     _nmd_d3d11.device->CreateDepthStencilState(&depth_stencil_desc, &_nmd_d3d11.depth_stencil_state);
 
-    if (!_nmd_context.draw_list.default_atlas.font_id)
+    if (!_nmd_context->draw_list.default_atlas.font_id)
     {
-        if (!nmd_bake_font_from_memory(nmd_karla_ttf_regular, &_nmd_context.draw_list.default_atlas, 14.0f))
+        if (!nmd_bake_font_from_memory(nmd_karla_ttf_regular, &_nmd_context->draw_list.default_atlas, 14.0f))
             return false;
 
         /* Upload texture to graphics system */
-        if (!(_nmd_context.draw_list.default_atlas.font_id = nmd_d3d11_create_texture(_nmd_context.draw_list.default_atlas.pixels32, 512, 512)))
+        if (!(_nmd_context->draw_list.default_atlas.font_id = nmd_d3d11_create_texture(_nmd_context->draw_list.default_atlas.pixels32, 512, 512)))
             return false;
 
         uint32_t tmp = 0xffffffff;
-        if (!(_nmd_context.draw_list.blank_tex_id = nmd_d3d11_create_texture(&tmp, 1, 1)))
+        if (!(_nmd_context->draw_list.blank_tex_id = nmd_d3d11_create_texture(&tmp, 1, 1)))
             return false;
     }
     
@@ -269,6 +290,8 @@ void nmd_d3d11_delete_objects()
     _nmd_d3d11.device->Release();
 
     _nmd_d3d11.device = 0;
+
+    nmd_invalidate_render_state(NMD_RENDER_STATE_ALL);
 }
 
 bool nmd_d3d11_resize(int width, int height)
@@ -298,47 +321,67 @@ bool nmd_d3d11_resize(int width, int height)
     _nmd_d3d11.viewport.Width = width;
     _nmd_d3d11.viewport.Height = height;
 
+    /* The scissor of draw commands without a clip rect covers the viewport */
+    nmd_invalidate_render_state(NMD_RENDER_STATE_VIEWPORT | NMD_RENDER_STATE_SCISSOR);
+
     return true;
 }
 
-void _nmd_d3d11_set_render_state()
+/* Sets the categories of render state in 'state'(a mask of 'NMD_RENDER_STATE_XXX'). */
+void _nmd_d3d11_set_render_state(uint32_t state)
 {
-    if (!_nmd_d3d11.font_sampler && !_nmd_d3d11_create_objects())
-        return;
+    if (state & NMD_RENDER_STATE_BUFFERS)
+    {
+        unsigned int stride = sizeof(nmd_vertex);
+        unsigned int offset = 0;
+        _nmd_d3d11.device_context->IASetInputLayout(_nmd_d3d11.input_layout);
+        _nmd_d3d11.device_context->IASetVertexBuffers(0, 1, &_nmd_d3d11.vertex_buffer, &stride, &offset);
+        _nmd_d3d11.device_context->IASetIndexBuffer(_nmd_d3d11.index_buffer, sizeof(nmd_index) == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, 0);
+        _nmd_d3d11.device_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    }
 
-    unsigned int stride = sizeof(nmd_vertex);
-    unsigned int offset = 0;
-    _nmd_d3d11.device_context->IASetInputLayout(_nmd_d3d11.input_layout);
-    _nmd_d3d11.device_context->IASetVertexBuffers(0, 1, &_nmd_d3d11.vertex_buffer, &stride, &offset);
-    _nmd_d3d11.device_context->IASetIndexBuffer(_nmd_d3d11.index_buffer, sizeof(nmd_index) == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, 0);
-    _nmd_d3d11.device_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    _nmd_d3d11.device_context->VSSetShader(_nmd_d3d11.vertex_shader, NULL, 0);
-    _nmd_d3d11.device_context->VSSetConstantBuffers(0, 1, &_nmd_d3d11.const_buffer);
-    _nmd_d3d11.device_context->PSSetShader(_nmd_d3d11.pixel_shader, NULL, 0);
-    _nmd_d3d11.device_context->PSSetSamplers(0, 1, &_nmd_d3d11.font_sampler);
-    _nmd_d3d11.device_context->GSSetShader(NULL, NULL, 0);
-    _nmd_d3d11.device_context->HSSetShader(NULL, NULL, 0);
-    _nmd_d3d11.device_context->DSSetShader(NULL, NULL, 0);
-    _nmd_d3d11.device_context->CSSetShader(NULL, NULL, 0);
-    _nmd_d3d11.device_context->RSSetViewports(1, &_nmd_d3d11.viewport);
-    const float blend_factor[4] = { 0.f, 0.f, 0.f, 0.f };
-    _nmd_d3d11.device_context->OMSetBlendState(_nmd_d3d11.blend_state, blend_factor, 0xffffffff);
-    _nmd_d3d11.device_context->OMSetDepthStencilState(_nmd_d3d11.depth_stencil_state, 0);
-    _nmd_d3d11.device_context->RSSetState(_nmd_d3d11.rasterizer_state);
+    if (state & NMD_RENDER_STATE_SHADERS)
+    {
+        _nmd_d3d11.device_context->VSSetShader(_nmd_d3d11.vertex_shader, NULL, 0);
+        _nmd_d3d11.device_context->VSSetConstantBuffers(0, 1, &_nmd_d3d11.const_buffer);
+        _nmd_d3d11.device_context->PSSetShader(_nmd_d3d11.pixel_shader, NULL, 0);
+        _nmd_d3d11.device_context->GSSetShader(NULL, NULL, 0);
+        _nmd_d3d11.device_context->HSSetShader(NULL, NULL, 0);
+        _nmd_d3d11.device_context->DSSetShader(NULL, NULL, 0);
+        _nmd_d3d11.device_context->CSSetShader(NULL, NULL, 0);
+    }
+
+    if (state & NMD_RENDER_STATE_SAMPLER)
+        _nmd_d3d11.device_context->PSSetSamplers(0, 1, &_nmd_d3d11.font_sampler);
+
+    if (state & NMD_RENDER_STATE_VIEWPORT)
+        _nmd_d3d11.device_context->RSSetViewports(1, &_nmd_d3d11.viewport);
+
+    if (state & NMD_RENDER_STATE_BLEND)
+    {
+        const float blend_factor[4] = { 0.f, 0.f, 0.f, 0.f };
+        _nmd_d3d11.device_context->OMSetBlendState(_nmd_d3d11.blend_state, blend_factor, 0xffffffff);
+    }
+
+    if (state & NMD_RENDER_STATE_RASTERIZER)
+    {
+        _nmd_d3d11.device_context->OMSetDepthStencilState(_nmd_d3d11.depth_stencil_state, 0);
+        _nmd_d3d11.device_context->RSSetState(_nmd_d3d11.rasterizer_state);
+    }
 }
 
-void nmd_d3d11_render()
+void _nmd_d3d11_render()
 {
     if (!_nmd_d3d11.font_sampler && !_nmd_d3d11_create_objects())
         return;
 
     /* Create/Recreate vertex/index buffers if needed */
-    if (!_nmd_d3d11.vertex_buffer || _nmd_d3d11.vertex_buffer_size < _nmd_context.draw_list.num_vertices)
+    if (!_nmd_d3d11.vertex_buffer || _nmd_d3d11.vertex_buffer_size < _nmd_context->draw_list.num_vertices)
     {
         if (_nmd_d3d11.vertex_buffer)
             _nmd_d3d11.vertex_buffer->Release();
 
-        _nmd_d3d11.vertex_buffer_size = _nmd_context.draw_list.num_vertices + NMD_VERTEX_BUFFER_INITIAL_SIZE;
+        _nmd_d3d11.vertex_buffer_size = _nmd_context->draw_list.num_vertices + NMD_VERTEX_BUFFER_INITIAL_SIZE;
 
         D3D11_BUFFER_DESC desc;
         NMD_MEMSET(&desc, 0, sizeof(desc));
@@ -350,17 +393,15 @@ void nmd_d3d11_render()
         if (FAILED(_nmd_d3d11.device->CreateBuffer(&desc, NULL, &_nmd_d3d11.vertex_buffer)))
             return;
 
-#ifdef NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE
-        _nmd_d3d11_set_render_state();
-#endif /* NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE */
+        nmd_invalidate_render_state(NMD_RENDER_STATE_BUFFERS);
     }
 
-    if (!_nmd_d3d11.index_buffer || _nmd_d3d11.index_buffer_size < _nmd_context.draw_list.num_indices)
+    if (!_nmd_d3d11.index_buffer || _nmd_d3d11.index_buffer_size < _nmd_context->draw_list.num_indices)
     {
         if (_nmd_d3d11.index_buffer)
             _nmd_d3d11.index_buffer->Release();
 
-        _nmd_d3d11.index_buffer_size = _nmd_context.draw_list.num_indices + NMD_INDEX_BUFFER_INITIAL_SIZE;
+        _nmd_d3d11.index_buffer_size = _nmd_context->draw_list.num_indices + NMD_INDEX_BUFFER_INITIAL_SIZE;
 
         D3D11_BUFFER_DESC desc;
         NMD_MEMSET(&desc, 0, sizeof(desc));
@@ -371,25 +412,23 @@ void nmd_d3d11_render()
         if (FAILED(_nmd_d3d11.device->CreateBuffer(&desc, NULL, &_nmd_d3d11.index_buffer)))
             return;
 
-#ifdef NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE
-        _nmd_d3d11_set_render_state();
-#endif /* NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE */
+        nmd_invalidate_render_state(NMD_RENDER_STATE_BUFFERS);
     }
 
     /* Copy vertices and indices and to the GPU */
     D3D11_MAPPED_SUBRESOURCE mapped_resource;
     if (_nmd_d3d11.device_context->Map(_nmd_d3d11.vertex_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped_resource) != S_OK)
         return;
-    NMD_MEMCPY(mapped_resource.pData, _nmd_context.draw_list.vertices, _nmd_context.draw_list.num_vertices * sizeof(nmd_vertex));
+    NMD_MEMCPY(mapped_resource.pData, _nmd_context->draw_list.vertices, _nmd_context->draw_list.num_vertices * sizeof(nmd_vertex));
     _nmd_d3d11.device_context->Unmap(_nmd_d3d11.vertex_buffer, 0);
 
     if (_nmd_d3d11.device_context->Map(_nmd_d3d11.index_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped_resource) != S_OK)
         return;
-    NMD_MEMCPY(mapped_resource.pData, _nmd_context.draw_list.indices, _nmd_context.draw_list.num_indices * sizeof(nmd_index));
+    NMD_MEMCPY(mapped_resource.pData, _nmd_context->draw_list.indices, _nmd_context->draw_list.num_indices * sizeof(nmd_index));
     _nmd_d3d11.device_context->Unmap(_nmd_d3d11.index_buffer, 0);
 
 #ifndef NMD_GRAPHICS_D3D11_DONT_BACKUP_RENDER_STATE
-    /* Backup the current render state */
+    /* Backup the categories of the current render state that are restored */
     struct
     {
         UINT ScissorRectsCount, ViewportsCount;
@@ -414,73 +453,133 @@ void nmd_d3d11_render()
         DXGI_FORMAT IndexBufferFormat;
         ID3D11InputLayout* InputLayout;
     } old;
-    old.ScissorRectsCount = old.ViewportsCount = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
-    _nmd_d3d11.device_context->RSGetScissorRects(&old.ScissorRectsCount, old.ScissorRects);
-    _nmd_d3d11.device_context->RSGetViewports(&old.ViewportsCount, old.Viewports);
-    _nmd_d3d11.device_context->RSGetState(&old.RS);
-    _nmd_d3d11.device_context->OMGetBlendState(&old.BlendState, old.BlendFactor, &old.SampleMask);
-    _nmd_d3d11.device_context->OMGetDepthStencilState(&old.DepthStencilState, &old.StencilRef);
-    _nmd_d3d11.device_context->PSGetShaderResources(0, 1, &old.PSShaderResource);
-    _nmd_d3d11.device_context->PSGetSamplers(0, 1, &old.PSSampler);
-    old.PSInstancesCount = old.VSInstancesCount = old.GSInstancesCount = 128;
-    _nmd_d3d11.device_context->PSGetShader(&old.PS, old.PSInstances, &old.PSInstancesCount);
-    _nmd_d3d11.device_context->VSGetShader(&old.VS, old.VSInstances, &old.VSInstancesCount);
-    _nmd_d3d11.device_context->VSGetConstantBuffers(0, 1, &old.VSConstantBuffer);
-    _nmd_d3d11.device_context->GSGetShader(&old.GS, old.GSInstances, &old.GSInstancesCount);
-    _nmd_d3d11.device_context->IAGetPrimitiveTopology(&old.PrimitiveTopology);
-    _nmd_d3d11.device_context->IAGetIndexBuffer(&old.IndexBuffer, &old.IndexBufferFormat, &old.IndexBufferOffset);
-    _nmd_d3d11.device_context->IAGetVertexBuffers(0, 1, &old.VertexBuffer, &old.VertexBufferStride, &old.VertexBufferOffset);
-    _nmd_d3d11.device_context->IAGetInputLayout(&old.InputLayout);
+    const uint32_t backup = NMD_RENDER_STATE_ALL & ~_nmd_context->render_state.skip_backup;
+    NMD_MEMSET(&old, 0, sizeof(old));
+    if (backup & NMD_RENDER_STATE_SCISSOR)
+    {
+        old.ScissorRectsCount = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+        _nmd_d3d11.device_context->RSGetScissorRects(&old.ScissorRectsCount, old.ScissorRects);
+    }
+    if (backup & NMD_RENDER_STATE_VIEWPORT)
+    {
+        old.ViewportsCount = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+        _nmd_d3d11.device_context->RSGetViewports(&old.ViewportsCount, old.Viewports);
+    }
+    if (backup & NMD_RENDER_STATE_RASTERIZER)
+    {
+        _nmd_d3d11.device_context->RSGetState(&old.RS);
+        _nmd_d3d11.device_context->OMGetDepthStencilState(&old.DepthStencilState, &old.StencilRef);
+    }
+    if (backup & NMD_RENDER_STATE_BLEND)
+        _nmd_d3d11.device_context->OMGetBlendState(&old.BlendState, old.BlendFactor, &old.SampleMask);
+    if (backup & NMD_RENDER_STATE_TEXTURE)
+        _nmd_d3d11.device_context->PSGetShaderResources(0, 1, &old.PSShaderResource);
+    if (backup & NMD_RENDER_STATE_SAMPLER)
+        _nmd_d3d11.device_context->PSGetSamplers(0, 1, &old.PSSampler);
+    if (backup & NMD_RENDER_STATE_SHADERS)
+    {
+        old.PSInstancesCount = old.VSInstancesCount = old.GSInstancesCount = 128;
+        _nmd_d3d11.device_context->PSGetShader(&old.PS, old.PSInstances, &old.PSInstancesCount);
+        _nmd_d3d11.device_context->VSGetShader(&old.VS, old.VSInstances, &old.VSInstancesCount);
+        _nmd_d3d11.device_context->VSGetConstantBuffers(0, 1, &old.VSConstantBuffer);
+        _nmd_d3d11.device_context->GSGetShader(&old.GS, old.GSInstances, &old.GSInstancesCount);
+    }
+    if (backup & NMD_RENDER_STATE_BUFFERS)
+    {
+        _nmd_d3d11.device_context->IAGetPrimitiveTopology(&old.PrimitiveTopology);
+        _nmd_d3d11.device_context->IAGetIndexBuffer(&old.IndexBuffer, &old.IndexBufferFormat, &old.IndexBufferOffset);
+        _nmd_d3d11.device_context->IAGetVertexBuffers(0, 1, &old.VertexBuffer, &old.VertexBufferStride, &old.VertexBufferOffset);
+        _nmd_d3d11.device_context->IAGetInputLayout(&old.InputLayout);
+    }
+#else
+    const uint32_t backup = NMD_RENDER_STATE_NONE;
 #endif /* NMD_GRAPHICS_D3D11_DONT_BACKUP_RENDER_STATE */
 
-#ifndef NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE
     /* Set render state */
-    _nmd_d3d11_set_render_state();
-#endif /* NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE */
+    _nmd_d3d11_set_render_state(_nmd_begin_render_state());
 
     /* Render draw commands */
     size_t index_offset = 0;
-    for (int i = 0; i < _nmd_context.draw_list.num_draw_commands; i++)
+    for (size_t i = 0; i < _nmd_context->draw_list.num_draw_commands; i++)
     {
-        /* Apply scissor rectangle */
-        D3D11_RECT r;
-        if (_nmd_context.draw_list.draw_commands[i].rect.p1.x == -1.0f)
-            r = { (LONG)_nmd_d3d11.viewport.TopLeftX, (LONG)_nmd_d3d11.viewport.TopLeftY, (LONG)_nmd_d3d11.viewport.Width, (LONG)_nmd_d3d11.viewport.Height };
-        else
-            r = { (LONG)_nmd_context.draw_list.draw_commands[i].rect.p0.x, (LONG)_nmd_context.draw_list.draw_commands[i].rect.p0.y, (LONG)_nmd_context.draw_list.draw_commands[i].rect.p1.x, (LONG)_nmd_context.draw_list.draw_commands[i].rect.p1.y };
-        _nmd_d3d11.device_context->RSSetScissorRects(1, &r);
-
-        /* Set texture */
-        ID3D11ShaderResourceView* texture_srv = (ID3D11ShaderResourceView*)_nmd_context.draw_list.draw_commands[i].user_texture_id;
-        _nmd_d3d11.device_context->PSSetShaderResources(0, 1, &texture_srv);
+        /* Apply scissor rectangle if it changed */
+        if (_nmd_render_state_scissor_changed(&_nmd_context->draw_list.draw_commands[i].rect))
+        {
+            D3D11_RECT r;
+            if (_nmd_context->draw_list.draw_commands[i].rect.p1.x == -1.0f)
+                r = { (LONG)_nmd_d3d11.viewport.TopLeftX, (LONG)_nmd_d3d11.viewport.TopLeftY, (LONG)_nmd_d3d11.viewport.Width, (LONG)_nmd_d3d11.viewport.Height };
+            else
+                r = { (LONG)_nmd_context->draw_list.draw_commands[i].rect.p0.x, (LONG)_nmd_context->draw_list.draw_commands[i].rect.p0.y, (LONG)_nmd_context->draw_list.draw_commands[i].rect.p1.x, (LONG)_nmd_context->draw_list.draw_commands[i].rect.p1.y };
+            _nmd_d3d11.device_context->RSSetScissorRects(1, &r);
+        }
+
+        /* Set texture if it changed */
+        if (_nmd_render_state_texture_changed(_nmd_context->draw_list.draw_commands[i].user_texture_id))
+        {
+            ID3D11ShaderResourceView* texture_srv = (ID3D11ShaderResourceView*)_nmd_context->draw_list.draw_commands[i].user_texture_id;
+            _nmd_d3d11.device_context->PSSetShaderResources(0, 1, &texture_srv);
+        }
 
         /* Issue draw call */
-        _nmd_d3d11.device_context->DrawIndexed(_nmd_context.draw_list.draw_commands[i].num_indices, index_offset, 0);
+        _nmd_d3d11.device_context->DrawIndexed((UINT)_nmd_context->draw_list.draw_commands[i].num_indices, (UINT)index_offset, (INT)_nmd_context->draw_list.draw_commands[i].vertex_offset);
 
         /* Update offset */
-        index_offset += _nmd_context.draw_list.draw_commands[i].num_indices;
+        index_offset += _nmd_context->draw_list.draw_commands[i].num_indices;
     }
 
 #ifndef NMD_GRAPHICS_D3D11_DONT_BACKUP_RENDER_STATE
-    /* Restore previous render state */
-    _nmd_d3d11.device_context->RSSetScissorRects(old.ScissorRectsCount, old.ScissorRects);
-    _nmd_d3d11.device_context->RSSetViewports(old.ViewportsCount, old.Viewports);
-    _nmd_d3d11.device_context->RSSetState(old.RS); if (old.RS) old.RS->Release();
-    _nmd_d3d11.device_context->OMSetBlendState(old.BlendState, old.BlendFactor, old.SampleMask); if (old.BlendState) old.BlendState->Release();
-    _nmd_d3d11.device_context->OMSetDepthStencilState(old.DepthStencilState, old.StencilRef); if (old.DepthStencilState) old.DepthStencilState->Release();
-    _nmd_d3d11.device_context->PSSetShaderResources(0, 1, &old.PSShaderResource); if (old.PSShaderResource) old.PSShaderResource->Release();
-    _nmd_d3d11.device_context->PSSetSamplers(0, 1, &old.PSSampler); if (old.PSSampler) old.PSSampler->Release();
-    _nmd_d3d11.device_context->PSSetShader(old.PS, old.PSInstances, old.PSInstancesCount); if (old.PS) old.PS->Release();
-    for (UINT i = 0; i < old.PSInstancesCount; i++) if (old.PSInstances[i]) old.PSInstances[i]->Release();
-    _nmd_d3d11.device_context->VSSetShader(old.VS, old.VSInstances, old.VSInstancesCount); if (old.VS) old.VS->Release();
-    _nmd_d3d11.device_context->VSSetConstantBuffers(0, 1, &old.VSConstantBuffer); if (old.VSConstantBuffer) old.VSConstantBuffer->Release();
-    _nmd_d3d11.device_context->GSSetShader(old.GS, old.GSInstances, old.GSInstancesCount); if (old.GS) old.GS->Release();
-    for (UINT i = 0; i < old.VSInstancesCount; i++) if (old.VSInstances[i]) old.VSInstances[i]->Release();
-    _nmd_d3d11.device_context->IASetPrimitiveTopology(old.PrimitiveTopology);
-    _nmd_d3d11.device_context->IASetIndexBuffer(old.IndexBuffer, old.IndexBufferFormat, old.IndexBufferOffset); if (old.IndexBuffer) old.IndexBuffer->Release();
-    _nmd_d3d11.device_context->IASetVertexBuffers(0, 1, &old.VertexBuffer, &old.VertexBufferStride, &old.VertexBufferOffset); if (old.VertexBuffer) old.VertexBuffer->Release();
-    _nmd_d3d11.device_context->IASetInputLayout(old.InputLayout); if (old.InputLayout) old.InputLayout->Release();
+    /* Restore the categories of the previous render state that were backed up */
+    if (backup & NMD_RENDER_STATE_SCISSOR)
+        _nmd_d3d11.device_context->RSSetScissorRects(old.ScissorRectsCount, old.ScissorRects);
+    if (backup & NMD_RENDER_STATE_VIEWPORT)
+        _nmd_d3d11.device_context->RSSetViewports(old.ViewportsCount, old.Viewports);
+    if (backup & NMD_RENDER_STATE_RASTERIZER)
+    {
+        _nmd_d3d11.device_context->RSSetState(old.RS); if (old.RS) old.RS->Release();
+        _nmd_d3d11.device_context->OMSetDepthStencilState(old.DepthStencilState, old.StencilRef); if (old.DepthStencilState) old.DepthStencilState->Release();
+    }
+    if (backup & NMD_RENDER_STATE_BLEND)
+    {
+        _nmd_d3d11.device_context->OMSetBlendState(old.BlendState, old.BlendFactor, old.SampleMask); if (old.BlendState) old.BlendState->Release();
+    }
+    if (backup & NMD_RENDER_STATE_TEXTURE)
+    {
+        _nmd_d3d11.device_context->PSSetShaderResources(0, 1, &old.PSShaderResource); if (old.PSShaderResource) old.PSShaderResource->Release();
+    }
+    if (backup & NMD_RENDER_STATE_SAMPLER)
+    {
+        _nmd_d3d11.device_context->PSSetSamplers(0, 1, &old.PSSampler); if (old.PSSampler) old.PSSampler->Release();
+    }
+    if (backup & NMD_RENDER_STATE_SHADERS)
+    {
+        _nmd_d3d11.device_context->PSSetShader(old.PS, old.PSInstances, old.PSInstancesCount); if (old.PS) old.PS->Release();
+        for (UINT i = 0; i < old.PSInstancesCount; i++) if (old.PSInstances[i]) old.PSInstances[i]->Release();
+        _nmd_d3d11.device_context->VSSetShader(old.VS, old.VSInstances, old.VSInstancesCount); if (old.VS) old.VS->Release();
+        _nmd_d3d11.device_context->VSSetConstantBuffers(0, 1, &old.VSConstantBuffer); if (old.VSConstantBuffer) old.VSConstantBuffer->Release();
+        _nmd_d3d11.device_context->GSSetShader(old.GS, old.GSInstances, old.GSInstancesCount); if (old.GS) old.GS->Release();
+        for (UINT i = 0; i < old.VSInstancesCount; i++) if (old.VSInstances[i]) old.VSInstances[i]->Release();
+    }
+    if (backup & NMD_RENDER_STATE_BUFFERS)
+    {
+        _nmd_d3d11.device_context->IASetPrimitiveTopology(old.PrimitiveTopology);
+        _nmd_d3d11.device_context->IASetIndexBuffer(old.IndexBuffer, old.IndexBufferFormat, old.IndexBufferOffset); if (old.IndexBuffer) old.IndexBuffer->Release();
+        _nmd_d3d11.device_context->IASetVertexBuffers(0, 1, &old.VertexBuffer, &old.VertexBufferStride, &old.VertexBufferOffset); if (old.VertexBuffer) old.VertexBuffer->Release();
+        _nmd_d3d11.device_context->IASetInputLayout(old.InputLayout); if (old.InputLayout) old.InputLayout->Release();
+    }
 #endif /* NMD_GRAPHICS_D3D11_DONT_BACKUP_RENDER_STATE */
+
+#ifdef NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE
+    _nmd_end_render_state(backup, true);
+#else
+    _nmd_end_render_state(backup, _nmd_context->render_state.known_host_state);
+#endif /* NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE */
+}
+
+void nmd_d3d11_render()
+{
+    _nmd_profile("nmd_d3d11_render", true);
+    _nmd_d3d11_render();
+    _nmd_profile("nmd_d3d11_render", false);
 }
 
-#endif /* NMD_GRAPHICS_D3D11 */
+#endif /* NMD_GRAPHICS_D3D11 */
\ No newline at end of file
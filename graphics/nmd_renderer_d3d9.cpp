@@ -24,6 +24,7 @@ typedef struct
 void nmd_d3d9_set_device(LPDIRECT3DDEVICE9 p_d3d9_device)
 {
     _nmd_d3d9.device = p_d3d9_device;
+    nmd_invalidate_render_state(NMD_RENDER_STATE_ALL);
 
     _nmd_d3d9.viewport.X;
     _nmd_d3d9.viewport.Y = 0;
@@ -31,11 +32,14 @@ void nmd_d3d9_set_device(LPDIRECT3DDEVICE9 p_d3d9_device)
     _nmd_d3d9.viewport.MaxZ = 1.0f;
 
     int width = 16, height = 16;
-    unsigned char* pixels = (unsigned char*)NMD_MALLOC(width * height * 4);
+    unsigned char* pixels = (unsigned char*)_nmd_alloc(width * height * 4);
+    if (!pixels)
+        return;
     
     NMD_MEMSET(pixels, 0xff, width * height * 4);
 
-    _nmd_context.draw_list.default_atlas.font_id = nmd_d3d9_create_texture(pixels, width, height);
+    _nmd_context->draw_list.default_atlas.font_id = nmd_d3d9_create_texture(pixels, width, height);
+    _nmd_free(pixels);
 }
 
 nmd_tex_id nmd_d3d9_create_texture(void* pixels, int width, int height)
@@ -56,6 +60,19 @@ nmd_tex_id nmd_d3d9_create_texture(void* pixels, int width, int height)
     return (nmd_tex_id)texture;
 }
 
+void nmd_d3d9_update_texture(nmd_tex_id texture, const void* pixels, int x, int y, int width, int height, int pitch)
+{
+    RECT rect = { x, y, x + width, y + height };
+    D3DLOCKED_RECT tex_locked_rect;
+    if (((IDirect3DTexture9*)texture)->LockRect(0, &tex_locked_rect, &rect, 0) != D3D_OK)
+        return;
+
+    for (int row = 0; row < height; row++)
+        NMD_MEMCPY((unsigned char*)tex_locked_rect.pBits + tex_locked_rect.Pitch * row, (const unsigned char*)pixels + pitch * row, (width * 4));
+
+    ((IDirect3DTexture9*)texture)->UnlockRect(0);
+}
+
 void nmd_d3d9_resize(int width, int height)
 {
     const float L = 0.0f;
@@ -72,42 +89,73 @@ void nmd_d3d9_resize(int width, int height)
 
     _nmd_d3d9.viewport.Width = width;
     _nmd_d3d9.viewport.Height = height;
+
+    /* The scissor of draw commands without a clip rect covers the viewport */
+    nmd_invalidate_render_state(NMD_RENDER_STATE_VIEWPORT | NMD_RENDER_STATE_SCISSOR);
 }
 
-void _nmd_d3d9_set_render_state()
+/* Sets the categories of render state in 'state'(a mask of 'NMD_RENDER_STATE_XXX'). */
+void _nmd_d3d9_set_render_state(uint32_t state)
 {
-    _nmd_d3d9.device->SetStreamSource(0, _nmd_d3d9.vb, 0, sizeof(_nmd_d3d9_custom_vertex));
-    _nmd_d3d9.device->SetIndices(_nmd_d3d9.ib);
-    _nmd_d3d9.device->SetFVF(_NMD_D3D9_CUSTOM_VERTEX_FVF);
-    _nmd_d3d9.device->SetTransform(D3DTS_PROJECTION, &_nmd_d3d9.proj);
-    _nmd_d3d9.device->SetViewport(&_nmd_d3d9.viewport);
-    _nmd_d3d9.device->SetPixelShader(NULL);
-    _nmd_d3d9.device->SetVertexShader(NULL);
-    _nmd_d3d9.device->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
-    _nmd_d3d9.device->SetRenderState(D3DRS_LIGHTING, false);
-    _nmd_d3d9.device->SetRenderState(D3DRS_ZENABLE, false);
-    _nmd_d3d9.device->SetRenderState(D3DRS_ALPHABLENDENABLE, true);
-    _nmd_d3d9.device->SetRenderState(D3DRS_ALPHATESTENABLE, false);
-    _nmd_d3d9.device->SetRenderState(D3DRS_BLENDOP, D3DBLENDOP_ADD);
-    _nmd_d3d9.device->SetRenderState(D3DRS_SRCBLEND, D3DBLEND_SRCALPHA);
-    _nmd_d3d9.device->SetRenderState(D3DRS_DESTBLEND, D3DBLEND_INVSRCALPHA);
-    _nmd_d3d9.device->SetRenderState(D3DRS_SCISSORTESTENABLE, true);
-    _nmd_d3d9.device->SetRenderState(D3DRS_SHADEMODE, D3DSHADE_GOURAUD);
-    _nmd_d3d9.device->SetRenderState(D3DRS_FOGENABLE, false);
-    _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_COLOROP, D3DTOP_MODULATE);
-    _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_COLORARG1, D3DTA_TEXTURE);
-    _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_COLORARG2, D3DTA_DIFFUSE);
-    _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_ALPHAOP, D3DTOP_MODULATE);
-    _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_ALPHAARG1, D3DTA_TEXTURE);
-    _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_ALPHAARG2, D3DTA_DIFFUSE);
-    _nmd_d3d9.device->SetSamplerState(0, D3DSAMP_MINFILTER, D3DTEXF_LINEAR);
-    _nmd_d3d9.device->SetSamplerState(0, D3DSAMP_MAGFILTER, D3DTEXF_LINEAR);
+    if (state & NMD_RENDER_STATE_BUFFERS)
+    {
+        _nmd_d3d9.device->SetStreamSource(0, _nmd_d3d9.vb, 0, sizeof(_nmd_d3d9_custom_vertex));
+        _nmd_d3d9.device->SetIndices(_nmd_d3d9.ib);
+        _nmd_d3d9.device->SetFVF(_NMD_D3D9_CUSTOM_VERTEX_FVF);
+    }
+
+    if (state & NMD_RENDER_STATE_VIEWPORT)
+    {
+        _nmd_d3d9.device->SetTransform(D3DTS_PROJECTION, &_nmd_d3d9.proj);
+        _nmd_d3d9.device->SetViewport(&_nmd_d3d9.viewport);
+    }
+
+    if (state & NMD_RENDER_STATE_SHADERS)
+    {
+        _nmd_d3d9.device->SetPixelShader(NULL);
+        _nmd_d3d9.device->SetVertexShader(NULL);
+    }
+
+    if (state & NMD_RENDER_STATE_RASTERIZER)
+    {
+        _nmd_d3d9.device->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
+        _nmd_d3d9.device->SetRenderState(D3DRS_LIGHTING, false);
+        _nmd_d3d9.device->SetRenderState(D3DRS_ZENABLE, false);
+        _nmd_d3d9.device->SetRenderState(D3DRS_SCISSORTESTENABLE, true);
+        _nmd_d3d9.device->SetRenderState(D3DRS_SHADEMODE, D3DSHADE_GOURAUD);
+        _nmd_d3d9.device->SetRenderState(D3DRS_FOGENABLE, false);
+    }
+
+    if (state & NMD_RENDER_STATE_BLEND)
+    {
+        _nmd_d3d9.device->SetRenderState(D3DRS_ALPHABLENDENABLE, true);
+        _nmd_d3d9.device->SetRenderState(D3DRS_ALPHATESTENABLE, false);
+        _nmd_d3d9.device->SetRenderState(D3DRS_BLENDOP, D3DBLENDOP_ADD);
+        _nmd_d3d9.device->SetRenderState(D3DRS_SRCBLEND, D3DBLEND_SRCALPHA);
+        _nmd_d3d9.device->SetRenderState(D3DRS_DESTBLEND, D3DBLEND_INVSRCALPHA);
+    }
+
+    if (state & NMD_RENDER_STATE_TEXTURE)
+    {
+        _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_COLOROP, D3DTOP_MODULATE);
+        _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_COLORARG1, D3DTA_TEXTURE);
+        _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_COLORARG2, D3DTA_DIFFUSE);
+        _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_ALPHAOP, D3DTOP_MODULATE);
+        _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_ALPHAARG1, D3DTA_TEXTURE);
+        _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_ALPHAARG2, D3DTA_DIFFUSE);
+    }
+
+    if (state & NMD_RENDER_STATE_SAMPLER)
+    {
+        _nmd_d3d9.device->SetSamplerState(0, D3DSAMP_MINFILTER, D3DTEXF_LINEAR);
+        _nmd_d3d9.device->SetSamplerState(0, D3DSAMP_MAGFILTER, D3DTEXF_LINEAR);
+    }
 }
 
-void nmd_d3d9_render()
+void _nmd_d3d9_render()
 {
     /* Create/recreate vertex buffer if it doesn't exist or more space is needed */
-    if (!_nmd_d3d9.vb || _nmd_d3d9.vb_size < _nmd_context.draw_list.num_vertices)
+    if (!_nmd_d3d9.vb || _nmd_d3d9.vb_size < _nmd_context->draw_list.num_vertices)
     {
         if (_nmd_d3d9.vb)
         {
@@ -115,17 +163,15 @@ void nmd_d3d9_render()
             _nmd_d3d9.vb = 0;
         }
 
-        _nmd_d3d9.vb_size = _nmd_context.draw_list.num_vertices + NMD_VERTEX_BUFFER_INITIAL_SIZE;
+        _nmd_d3d9.vb_size = _nmd_context->draw_list.num_vertices + NMD_VERTEX_BUFFER_INITIAL_SIZE;
         if (_nmd_d3d9.device->CreateVertexBuffer(_nmd_d3d9.vb_size * sizeof(_nmd_d3d9_custom_vertex), D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, _NMD_D3D9_CUSTOM_VERTEX_FVF, D3DPOOL_DEFAULT, &_nmd_d3d9.vb, NULL) != D3D_OK)
             return;
 
-#ifdef NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE
-        _nmd_d3d9_set_render_state();
-#endif /* NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE */
+        nmd_invalidate_render_state(NMD_RENDER_STATE_BUFFERS);
     }
 
     /* Create/recreate index buffer if it doesn't exist or more space is needed */
-    if (!_nmd_d3d9.ib || _nmd_d3d9.ib_size < _nmd_context.draw_list.num_indices)
+    if (!_nmd_d3d9.ib || _nmd_d3d9.ib_size < _nmd_context->draw_list.num_indices)
     {
         if (_nmd_d3d9.ib)
         {
@@ -133,87 +179,115 @@ void nmd_d3d9_render()
             _nmd_d3d9.ib = 0;
         }
 
-        _nmd_d3d9.ib_size = _nmd_context.draw_list.num_indices + NMD_INDEX_BUFFER_INITIAL_SIZE;
+        _nmd_d3d9.ib_size = _nmd_context->draw_list.num_indices + NMD_INDEX_BUFFER_INITIAL_SIZE;
         if (_nmd_d3d9.device->CreateIndexBuffer(_nmd_d3d9.ib_size * sizeof(nmd_index), D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, sizeof(nmd_index) == 2 ? D3DFMT_INDEX16 : D3DFMT_INDEX32, D3DPOOL_DEFAULT, &_nmd_d3d9.ib, NULL) < 0)
             return;
 
-#ifdef NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE
-        _nmd_d3d9_set_render_state();
-#endif /* NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE */
+        nmd_invalidate_render_state(NMD_RENDER_STATE_BUFFERS);
     }
 
     /* Copy vertices to the gpu */
     _nmd_d3d9_custom_vertex* p_vertices = 0;
-    if (_nmd_d3d9.vb->Lock(0, (UINT)(_nmd_context.draw_list.num_vertices * sizeof(_nmd_d3d9_custom_vertex)), (void**)&p_vertices, D3DLOCK_DISCARD) != D3D_OK)
+    if (_nmd_d3d9.vb->Lock(0, (UINT)(_nmd_context->draw_list.num_vertices * sizeof(_nmd_d3d9_custom_vertex)), (void**)&p_vertices, D3DLOCK_DISCARD) != D3D_OK)
         return;
     size_t i = 0;
-    for (; i < _nmd_context.draw_list.num_vertices; i++)
+    for (; i < _nmd_context->draw_list.num_vertices; i++)
     {
-        p_vertices[i].pos[0] = _nmd_context.draw_list.vertices[i].pos.x;
-        p_vertices[i].pos[1] = _nmd_context.draw_list.vertices[i].pos.y;
+        p_vertices[i].pos[0] = _nmd_context->draw_list.vertices[i].pos.x;
+        p_vertices[i].pos[1] = _nmd_context->draw_list.vertices[i].pos.y;
         p_vertices[i].pos[2] = 0.0f;
 
-        p_vertices[i].uv[0] = _nmd_context.draw_list.vertices[i].uv.x;
-        p_vertices[i].uv[1] = _nmd_context.draw_list.vertices[i].uv.y;
+        p_vertices[i].uv[0] = _nmd_context->draw_list.vertices[i].uv.x;
+        p_vertices[i].uv[1] = _nmd_context->draw_list.vertices[i].uv.y;
 
-        const nmd_color color = _nmd_context.draw_list.vertices[i].color;
+        const nmd_color color = _nmd_context->draw_list.vertices[i].color;
         p_vertices[i].color = D3DCOLOR_RGBA(color.r, color.g, color.b, color.a);
     }
     _nmd_d3d9.vb->Unlock();
 
     /* Copy indices to the gpu */
     nmd_index* p_indices = 0;
-    if (_nmd_d3d9.ib->Lock(0, (UINT)(_nmd_context.draw_list.num_indices * sizeof(nmd_index)), (void**)&p_indices, D3DLOCK_DISCARD) != D3D_OK)
+    if (_nmd_d3d9.ib->Lock(0, (UINT)(_nmd_context->draw_list.num_indices * sizeof(nmd_index)), (void**)&p_indices, D3DLOCK_DISCARD) != D3D_OK)
         return;
-    NMD_MEMCPY(p_indices, _nmd_context.draw_list.indices, _nmd_context.draw_list.num_indices * sizeof(nmd_index));
+    NMD_MEMCPY(p_indices, _nmd_context->draw_list.indices, _nmd_context->draw_list.num_indices * sizeof(nmd_index));
     _nmd_d3d9.ib->Unlock();
     
-#ifndef NMD_GRAPHICS_D3D9_DONT_BACKUP_RENDER_STATE
+#ifdef NMD_GRAPHICS_D3D9_DONT_BACKUP_RENDER_STATE
+    const uint32_t backup = NMD_RENDER_STATE_NONE;
+#else
+    /* A state block captures every category, so all of them are restored if any category is backed up */
+    const uint32_t backup = (NMD_RENDER_STATE_ALL & ~_nmd_context->render_state.skip_backup) ? NMD_RENDER_STATE_ALL : NMD_RENDER_STATE_NONE;
+
     /* Backup the current render state */
     IDirect3DStateBlock9* d3d9_state_block = NULL;
-    if (_nmd_d3d9.device->CreateStateBlock(D3DSBT_ALL, &d3d9_state_block) < 0)
-        return;
     D3DMATRIX last_world, last_view, last_projection;
-    _nmd_d3d9.device->GetTransform(D3DTS_WORLD, &last_world);
-    _nmd_d3d9.device->GetTransform(D3DTS_VIEW, &last_view);
-    _nmd_d3d9.device->GetTransform(D3DTS_PROJECTION, &last_projection);
+    if (backup)
+    {
+        if (_nmd_d3d9.device->CreateStateBlock(D3DSBT_ALL, &d3d9_state_block) < 0)
+            return;
+        _nmd_d3d9.device->GetTransform(D3DTS_WORLD, &last_world);
+        _nmd_d3d9.device->GetTransform(D3DTS_VIEW, &last_view);
+        _nmd_d3d9.device->GetTransform(D3DTS_PROJECTION, &last_projection);
+    }
 #endif /* NMD_GRAPHICS_D3D9_DONT_BACKUP_RENDER_STATE */
 
-#ifndef NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE
     /* Set render state */
-    _nmd_d3d9_set_render_state();
-#endif /* NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE */
+    _nmd_d3d9_set_render_state(_nmd_begin_render_state());
     
     /* Render draw commands */
-    size_t index_offset = 0;
-    for (i = 0; i < _nmd_context.draw_list.num_draw_commands; i++)
+    size_t index_offset = 0, vertex_start = 0;
+    for (i = 0; i < _nmd_context->draw_list.num_draw_commands; i++)
     {
-        /* Apply scissor rectangle */
-        RECT r;
-        if (_nmd_context.draw_list.draw_commands[i].rect.p1.x == -1.0f)
-            r = { (LONG)_nmd_d3d9.viewport.X, (LONG)_nmd_d3d9.viewport.Y, (LONG)_nmd_d3d9.viewport.Width, (LONG)_nmd_d3d9.viewport.Height };
-        else
-            r = { (LONG)_nmd_context.draw_list.draw_commands[i].rect.p0.x, (LONG)_nmd_context.draw_list.draw_commands[i].rect.p0.y, (LONG)_nmd_context.draw_list.draw_commands[i].rect.p1.x, (LONG)_nmd_context.draw_list.draw_commands[i].rect.p1.y };
-        _nmd_d3d9.device->SetScissorRect(&r);
+        /* Apply scissor rectangle if it changed */
+        if (_nmd_render_state_scissor_changed(&_nmd_context->draw_list.draw_commands[i].rect))
+        {
+            RECT r;
+            if (_nmd_context->draw_list.draw_commands[i].rect.p1.x == -1.0f)
+                r = { (LONG)_nmd_d3d9.viewport.X, (LONG)_nmd_d3d9.viewport.Y, (LONG)_nmd_d3d9.viewport.Width, (LONG)_nmd_d3d9.viewport.Height };
+            else
+                r = { (LONG)_nmd_context->draw_list.draw_commands[i].rect.p0.x, (LONG)_nmd_context->draw_list.draw_commands[i].rect.p0.y, (LONG)_nmd_context->draw_list.draw_commands[i].rect.p1.x, (LONG)_nmd_context->draw_list.draw_commands[i].rect.p1.y };
+            _nmd_d3d9.device->SetScissorRect(&r);
+        }
         
-        /* Set texture */
-        const LPDIRECT3DTEXTURE9 texture = (LPDIRECT3DTEXTURE9)_nmd_context.draw_list.draw_commands[i].user_texture_id;
-        _nmd_d3d9.device->SetTexture(0, texture);
+        /* Set texture if it changed */
+        if (_nmd_render_state_texture_changed(_nmd_context->draw_list.draw_commands[i].user_texture_id))
+            _nmd_d3d9.device->SetTexture(0, (LPDIRECT3DTEXTURE9)_nmd_context->draw_list.draw_commands[i].user_texture_id);
 
         /* Issue draw calls */
-        _nmd_d3d9.device->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, 0, 0, (UINT)_nmd_context.draw_list.draw_commands[i].num_vertices, index_offset, _nmd_context.draw_list.draw_commands[i].num_indices / 3);
+        /* The indices are relative to the base vertex, and so is the range of vertices used by the command */
+        const size_t base_vertex = _nmd_context->draw_list.draw_commands[i].vertex_offset;
+        vertex_start = NMD_MAX(vertex_start, base_vertex);
+        _nmd_d3d9.device->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, (INT)base_vertex, (UINT)(vertex_start - base_vertex), (UINT)_nmd_context->draw_list.draw_commands[i].num_vertices, (UINT)index_offset, (UINT)(_nmd_context->draw_list.draw_commands[i].num_indices / 3));
         
         /* Update offsets */
-        index_offset += _nmd_context.draw_list.draw_commands[i].num_indices;
+        index_offset += _nmd_context->draw_list.draw_commands[i].num_indices;
+        vertex_start += _nmd_context->draw_list.draw_commands[i].num_vertices;
     }
 
 #ifndef NMD_GRAPHICS_D3D9_DONT_BACKUP_RENDER_STATE
     /* Restore previous render state */
-    _nmd_d3d9.device->SetTransform(D3DTS_WORLD, &last_world);
-    _nmd_d3d9.device->SetTransform(D3DTS_VIEW, &last_view);
-    _nmd_d3d9.device->SetTransform(D3DTS_PROJECTION, &last_projection);
-    d3d9_state_block->Apply();
-    d3d9_state_block->Release();
+    if (backup)
+    {
+        _nmd_d3d9.device->SetTransform(D3DTS_WORLD, &last_world);
+        _nmd_d3d9.device->SetTransform(D3DTS_VIEW, &last_view);
+        _nmd_d3d9.device->SetTransform(D3DTS_PROJECTION, &last_projection);
+        d3d9_state_block->Apply();
+        d3d9_state_block->Release();
+    }
 #endif /* NMD_GRAPHICS_D3D9_DONT_BACKUP_RENDER_STATE */
+
+#ifdef NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE
+    _nmd_end_render_state(backup, true);
+#else
+    _nmd_end_render_state(backup, _nmd_context->render_state.known_host_state);
+#endif /* NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE */
+}
+
+void nmd_d3d9_render()
+{
+    _nmd_profile("nmd_d3d9_render", true);
+    _nmd_d3d9_render();
+    _nmd_profile("nmd_d3d9_render", false);
 }
-#endif /* NMD_GRAPHICS_D3D9 */
+
+#endif /* NMD_GRAPHICS_D3D9 */
\ No newline at end of file
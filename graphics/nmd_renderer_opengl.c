@@ -1,5 +1,33 @@
 #include "nmd_common.h"
 #ifdef NMD_GRAPHICS_OPENGL
+
+#ifdef NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS
+
+/* Persistent mapping needs glBufferStorage(), which is in the headers since OpenGL 4.4 */
+#ifdef GL_MAP_PERSISTENT_BIT
+#define _NMD_OPENGL_BUFFER_STORAGE
+#endif /* GL_MAP_PERSISTENT_BIT */
+
+/* The granularity in bytes of the ranges that are compared and uploaded. */
+#define _NMD_OPENGL_DIRTY_BLOCK_SIZE 256
+
+typedef struct
+{
+    size_t begin, end; /* The range is empty if 'begin' >= 'end'. */
+} _nmd_opengl_range;
+
+typedef struct
+{
+    GLuint buffer;
+    GLenum target; /* 'GL_ARRAY_BUFFER' or 'GL_ELEMENT_ARRAY_BUFFER' */
+    uint8_t* mapped; /* The persistently mapped storage of 'NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT' segments or null. */
+    size_t capacity; /* The size of a segment in bytes. */
+    uint8_t* shadow; /* A copy of the data of the previous frame. */
+    size_t shadow_size, shadow_capacity;
+    _nmd_opengl_range pending[NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT]; /* The bytes of each segment that are outdated. */
+} _nmd_opengl_stream;
+#endif /* NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS */
+
 struct
 {
     GLuint vbo, vao, ebo;
@@ -7,6 +35,14 @@ struct
     GLuint uniform_tex, uniform_proj, attrib_pos, attrib_uv, attrib_color;
     GLsizei width, height;
     GLfloat ortho[4][4];
+#ifdef NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS
+    _nmd_opengl_stream vertex_stream, index_stream;
+    bool persistent; /* True if the buffers are persistently mapped, otherwise they're updated with glBufferSubData(). */
+    size_t segment; /* The segment used by the current frame. */
+#ifdef _NMD_OPENGL_BUFFER_STORAGE
+    GLsync fences[NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT]; /* Signaled when the GPU is done with the segment */
+#endif /* _NMD_OPENGL_BUFFER_STORAGE */
+#endif /* NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS */
 } _nmd_opengl;
 bool _nmd_opengl_initialized = false;
 
@@ -32,6 +68,25 @@ nmd_tex_id nmd_opengl_create_texture(void* pixels, int width, int height)
     return texture;
 }
 
+void nmd_opengl_update_texture(nmd_tex_id texture, const void* pixels, int x, int y, int width, int height, int pitch)
+{
+    GLint last_texture;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
+    glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)texture);
+
+#ifdef GL_UNPACK_ROW_LENGTH
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#else
+    /* The row length can't be set, so the rows are uploaded one at a time */
+    for (int row = 0; row < height; row++)
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y + row, width, 1, GL_RGBA, GL_UNSIGNED_BYTE, (const uint8_t*)pixels + pitch * row);
+#endif
+
+    glBindTexture(GL_TEXTURE_2D, last_texture);
+}
+
 #ifdef __APPLE__
     #define _NMD_OPENGL_SHADER_VERSION "#version 150\n"
 #else
@@ -122,10 +177,39 @@ bool _nmd_opengl_create_objects()
     glGenBuffers(1, &_nmd_opengl.vbo);
     glGenBuffers(1, &_nmd_opengl.ebo);
 
+#ifdef NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS
+    _nmd_opengl.vertex_stream.buffer = _nmd_opengl.vbo;
+    _nmd_opengl.vertex_stream.target = GL_ARRAY_BUFFER;
+    _nmd_opengl.index_stream.buffer = _nmd_opengl.ebo;
+    _nmd_opengl.index_stream.target = GL_ELEMENT_ARRAY_BUFFER;
+
+#ifdef _NMD_OPENGL_BUFFER_STORAGE
+    /* glBufferStorage() is core since OpenGL 4.4 */
+    GLint major_version = 0, minor_version = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major_version);
+    glGetIntegerv(GL_MINOR_VERSION, &minor_version);
+    _nmd_opengl.persistent = major_version > 4 || (major_version == 4 && minor_version >= 4);
+    if (!_nmd_opengl.persistent)
+    {
+        GLint num_extensions = 0, i = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
+        for (; i < num_extensions && !_nmd_opengl.persistent; i++)
+        {
+            const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+            _nmd_opengl.persistent = extension && NMD_STRLEN(extension) == 21 && !NMD_MEMCMP(extension, "GL_ARB_buffer_storage", 21);
+        }
+    }
+#endif /* _NMD_OPENGL_BUFFER_STORAGE */
+#endif /* NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS */
+
     int width = 16, height = 16;
-    char* pixels = malloc(width * height * 4);
-    NMD_MEMSET(pixels, 255, width * height * 4);
-    _nmd_context.draw_list.font = nmd_opengl_create_texture(pixels, width, height);
+    char* pixels = (char*)_nmd_alloc(width * height * 4);
+    if (pixels)
+    {
+        NMD_MEMSET(pixels, 255, width * height * 4);
+        _nmd_context->draw_list.blank_tex_id = nmd_opengl_create_texture(pixels, width, height);
+        _nmd_free(pixels);
+    }
 
     /* Restore modified GL state */
     glBindTexture(GL_TEXTURE_2D, last_texture);
@@ -143,43 +227,222 @@ bool nmd_opengl_resize(int width, int height)
         return false;
 
     glViewport(0, 0, (GLsizei)width, (GLsizei)height);
-    _nmd_opengl.ortho[0][0] /= (GLfloat)width;
-    _nmd_opengl.ortho[1][1] /= (GLfloat)height;
+    _nmd_opengl.ortho[0][0] = 2.0f / (GLfloat)width;
+    _nmd_opengl.ortho[1][1] = -2.0f / (GLfloat)height;
 
     _nmd_opengl.width = width;
     _nmd_opengl.height = height;
 
+    /* The scissor of draw commands without a clip rect covers the viewport */
+    nmd_invalidate_render_state(NMD_RENDER_STATE_VIEWPORT | NMD_RENDER_STATE_SCISSOR);
+
     return true;
 }
 
-void _nmd_opengl_set_render_state()
+#ifdef NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS
+/* Compares 'data' with the data of the previous frame and adds the blocks that changed to the pending range of every segment. */
+bool _nmd_opengl_stream_update(_nmd_opengl_stream* stream, const void* data, size_t size)
 {
-    // Setup render state: alpha-blending enabled, no face culling, no depth testing, scissor enabled, polygon fill
-    glEnable(GL_BLEND);
-    glBlendEquation(GL_FUNC_ADD);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDisable(GL_CULL_FACE);
-    glDisable(GL_DEPTH_TEST);
-    glEnable(GL_SCISSOR_TEST);
-#ifdef GL_POLYGON_MODE
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-#endif
+    const uint8_t* const bytes = (const uint8_t*)data;
+    const size_t common_size = NMD_MIN(size, stream->shadow_size);
+    size_t begin = 0, end = 0, i = 0;
 
-    // Support for GL 4.5 rarely used glClipControl(GL_UPPER_LEFT)
-    bool clip_origin_lower_left = true;
-#if defined(GL_CLIP_ORIGIN) && !defined(__APPLE__)
-    GLenum current_clip_origin = 0; glGetIntegerv(GL_CLIP_ORIGIN, (GLint*)&current_clip_origin);
-    if (current_clip_origin == GL_UPPER_LEFT)
-        clip_origin_lower_left = false;
-#endif
+    /* Find the first and the last block that changed. Everything after the data of the previous frame is new */
+    while (begin < common_size && !NMD_MEMCMP(bytes + begin, stream->shadow + begin, NMD_MIN(_NMD_OPENGL_DIRTY_BLOCK_SIZE, common_size - begin)))
+        begin += _NMD_OPENGL_DIRTY_BLOCK_SIZE;
+
+    if (size > stream->shadow_size)
+        end = size;
+    else if (begin < common_size)
+    {
+        end = common_size;
+        while (end > begin)
+        {
+            const size_t block_begin = NMD_MAX(begin, end - NMD_MIN(end, _NMD_OPENGL_DIRTY_BLOCK_SIZE));
+            if (NMD_MEMCMP(bytes + block_begin, stream->shadow + block_begin, end - block_begin))
+                break;
+            end = block_begin;
+        }
+    }
+
+    /* The last block compared may be shorter */
+    begin = NMD_MIN(begin, common_size);
+    if (begin >= end)
+    {
+        stream->shadow_size = size;
+        return true;
+    }
+
+    /* Update the copy of the data */
+    if (size > stream->shadow_capacity)
+    {
+        const size_t new_capacity = NMD_MAX(stream->shadow_capacity * 2, size);
+        uint8_t* mem = (uint8_t*)_nmd_alloc(new_capacity);
+        if (!mem)
+            return false;
+        NMD_MEMCPY(mem, stream->shadow, stream->shadow_size);
+        _nmd_free(stream->shadow);
+
+        stream->shadow = mem;
+        stream->shadow_capacity = new_capacity;
+    }
+    NMD_MEMCPY(stream->shadow + begin, bytes + begin, end - begin);
+    stream->shadow_size = size;
+
+    for (; i < NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT; i++)
+    {
+        if (stream->pending[i].begin >= stream->pending[i].end)
+            stream->pending[i].begin = begin, stream->pending[i].end = end;
+        else
+        {
+            stream->pending[i].begin = NMD_MIN(stream->pending[i].begin, begin);
+            stream->pending[i].end = NMD_MAX(stream->pending[i].end, end);
+        }
+    }
+
+    return true;
+}
+
+/* Writes the pending range of the current segment to the GPU, growing the buffer if necessary. Returns false if the buffer could not be grown. */
+bool _nmd_opengl_stream_upload(_nmd_opengl_stream* stream, const void* data, size_t size)
+{
+    _nmd_opengl_range* const pending = &stream->pending[_nmd_opengl.segment];
+    bool grown = false;
+    size_t i = 0;
+
+    if (size > stream->capacity)
+    {
+        /* The contents of every segment are lost */
+        stream->capacity = NMD_MAX(stream->capacity * 2, size);
+        for (; i < NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT; i++)
+            stream->pending[i].begin = 0, stream->pending[i].end = (size_t)-1;
+        grown = true;
+    }
+
+    pending->end = NMD_MIN(pending->end, size);
+
+#ifdef _NMD_OPENGL_BUFFER_STORAGE
+    if (_nmd_opengl.persistent)
+    {
+        if (grown)
+        {
+            /* The storage of a buffer is immutable, so a new buffer is created */
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glDeleteBuffers(1, &stream->buffer);
+            glGenBuffers(1, &stream->buffer);
+            nmd_invalidate_render_state(NMD_RENDER_STATE_BUFFERS);
+            glBindBuffer(stream->target, stream->buffer);
+            glBufferStorage(stream->target, (GLsizeiptr)(stream->capacity * NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT), 0, flags);
+            if (!(stream->mapped = (uint8_t*)glMapBufferRange(stream->target, 0, (GLsizeiptr)(stream->capacity * NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT), flags)))
+            {
+                stream->capacity = 0;
+                return false;
+            }
+        }
+
+        if (pending->begin < pending->end)
+            NMD_MEMCPY(stream->mapped + _nmd_opengl.segment * stream->capacity + pending->begin, (const uint8_t*)data + pending->begin, pending->end - pending->begin);
+    }
+    else
+#endif /* _NMD_OPENGL_BUFFER_STORAGE */
+    {
+        glBindBuffer(stream->target, stream->buffer);
+
+        /* If most of the buffer changed it's orphaned, so the driver doesn't wait for the previous frame */
+        if (grown || pending->end - pending->begin > size / 2)
+        {
+            glBufferData(stream->target, (GLsizeiptr)stream->capacity, 0, GL_DYNAMIC_DRAW);
+            pending->begin = 0;
+            pending->end = size;
+        }
+
+        if (pending->begin < pending->end)
+            glBufferSubData(stream->target, (GLintptr)pending->begin, (GLsizeiptr)(pending->end - pending->begin), (const GLvoid*)((const uint8_t*)data + pending->begin));
+    }
+
+    pending->begin = pending->end = 0;
+
+    return true;
+}
+
+/* Uploads the vertices and indices of the draw list that changed since the segment was last used. Returns false if the buffers could not be grown. */
+bool _nmd_opengl_upload()
+{
+#ifdef _NMD_OPENGL_BUFFER_STORAGE
+    if (_nmd_opengl.persistent)
+    {
+        /* Wait until the GPU is done with the segment, which was used 'NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT' frames ago */
+        _nmd_opengl.segment = (_nmd_opengl.segment + 1) % NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT;
+        GLsync* const fence = &_nmd_opengl.fences[_nmd_opengl.segment];
+        if (*fence)
+        {
+            while (glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED);
+            glDeleteSync(*fence);
+            *fence = 0;
+        }
+    }
+#endif /* _NMD_OPENGL_BUFFER_STORAGE */
+
+    const size_t vertices_size = _nmd_context->draw_list.num_vertices * sizeof(nmd_vertex);
+    const size_t indices_size = _nmd_context->draw_list.num_indices * sizeof(nmd_index);
+
+    return _nmd_opengl_stream_update(&_nmd_opengl.vertex_stream, _nmd_context->draw_list.vertices, vertices_size) &&
+           _nmd_opengl_stream_update(&_nmd_opengl.index_stream, _nmd_context->draw_list.indices, indices_size) &&
+           _nmd_opengl_stream_upload(&_nmd_opengl.vertex_stream, _nmd_context->draw_list.vertices, vertices_size) &&
+           _nmd_opengl_stream_upload(&_nmd_opengl.index_stream, _nmd_context->draw_list.indices, indices_size);
+}
+#endif /* NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS */
+
+/* Points the vertex attributes to the vertex 'first_vertex' of the vertex buffer. Used for the base vertex of draw commands when glDrawElementsBaseVertex() is not available. */
+void _nmd_opengl_set_vertex_attributes(size_t first_vertex)
+{
+    const size_t offset = first_vertex * sizeof(nmd_vertex);
+    glVertexAttribPointer(_nmd_opengl.attrib_pos, 2, GL_FLOAT, GL_FALSE, sizeof(nmd_vertex), (GLvoid*)(offset + (size_t)_NMD_OFFSETOF(nmd_vertex, pos)));
+    glVertexAttribPointer(_nmd_opengl.attrib_uv, 2, GL_FLOAT, GL_FALSE, sizeof(nmd_vertex), (GLvoid*)(offset + (size_t)_NMD_OFFSETOF(nmd_vertex, uv)));
+    glVertexAttribPointer(_nmd_opengl.attrib_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(nmd_vertex), (GLvoid*)(offset + (size_t)_NMD_OFFSETOF(nmd_vertex, color)));
+}
+
+/* Sets the categories of render state in 'state'(a mask of 'NMD_RENDER_STATE_XXX'). */
+void _nmd_opengl_set_render_state(uint32_t state)
+{
+    if (state & NMD_RENDER_STATE_SHADERS)
+    {
+        glUseProgram(_nmd_opengl.program);
+        glUniform1i(_nmd_opengl.uniform_tex, 0);
+    }
+
+    if (state & NMD_RENDER_STATE_TEXTURE)
+        glActiveTexture(GL_TEXTURE0);
 
-    glViewport(0, 0, (GLsizei)_nmd_opengl.width, (GLsizei)_nmd_opengl.height);
-    glUseProgram(_nmd_opengl.program);
-    glUniform1i(_nmd_opengl.uniform_tex, 0);
-    glUniformMatrix4fv(_nmd_opengl.uniform_proj, 1, GL_FALSE, &_nmd_opengl.ortho[0][0]);
 #ifdef GL_SAMPLER_BINDING
-    glBindSampler(0, 0); // We use combined texture/sampler state. Applications using GL 3.3 may set that otherwise.
+    if (state & NMD_RENDER_STATE_SAMPLER)
+        glBindSampler(0, 0); // We use combined texture/sampler state. Applications using GL 3.3 may set that otherwise.
+#endif
+
+    // Setup render state: alpha-blending enabled, no face culling, no depth testing, scissor enabled, polygon fill
+    if (state & NMD_RENDER_STATE_BLEND)
+    {
+        glEnable(GL_BLEND);
+        glBlendEquation(GL_FUNC_ADD);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    if (state & NMD_RENDER_STATE_RASTERIZER)
+    {
+        glDisable(GL_CULL_FACE);
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_SCISSOR_TEST);
+#ifdef GL_POLYGON_MODE
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 #endif
+    }
+
+    /* The projection matrix is a uniform of the program, which is bound at this point */
+    if (state & NMD_RENDER_STATE_VIEWPORT)
+    {
+        glViewport(0, 0, (GLsizei)_nmd_opengl.width, (GLsizei)_nmd_opengl.height);
+        glUniformMatrix4fv(_nmd_opengl.uniform_proj, 1, GL_FALSE, &_nmd_opengl.ortho[0][0]);
+    }
 
 //    (void)vertex_array_object;
 //#ifndef IMGUI_IMPL_OPENGL_ES2
@@ -187,103 +450,214 @@ void _nmd_opengl_set_render_state()
 //#endif
 
     // Bind vertex/index buffers and setup attributes for ImDrawVert
-    glBindBuffer(GL_ARRAY_BUFFER, _nmd_opengl.vbo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _nmd_opengl.ebo);
-    glEnableVertexAttribArray(_nmd_opengl.attrib_pos);
-    glEnableVertexAttribArray(_nmd_opengl.attrib_uv);
-    glEnableVertexAttribArray(_nmd_opengl.attrib_color);
-    glVertexAttribPointer(_nmd_opengl.attrib_pos, 2, GL_FLOAT, GL_FALSE, sizeof(nmd_vertex), (GLvoid*)_NMD_OFFSETOF(nmd_vertex, pos));
-    glVertexAttribPointer(_nmd_opengl.attrib_uv, 2, GL_FLOAT, GL_FALSE, sizeof(nmd_vertex), (GLvoid*)_NMD_OFFSETOF(nmd_vertex, uv));
-    glVertexAttribPointer(_nmd_opengl.attrib_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(nmd_vertex), (GLvoid*)_NMD_OFFSETOF(nmd_vertex, color));
+    if (state & NMD_RENDER_STATE_BUFFERS)
+    {
+#ifdef NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS
+        /* The buffers are recreated when they grow */
+        _nmd_opengl.vbo = _nmd_opengl.vertex_stream.buffer;
+        _nmd_opengl.ebo = _nmd_opengl.index_stream.buffer;
+#endif /* NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS */
+        glBindBuffer(GL_ARRAY_BUFFER, _nmd_opengl.vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _nmd_opengl.ebo);
+        glEnableVertexAttribArray(_nmd_opengl.attrib_pos);
+        glEnableVertexAttribArray(_nmd_opengl.attrib_uv);
+        glEnableVertexAttribArray(_nmd_opengl.attrib_color);
+        _nmd_opengl_set_vertex_attributes(0);
+    }
 }
 
-void nmd_opengl_render()
+void _nmd_opengl_render()
 {
     if (!_nmd_opengl_create_objects())
-        return false;
+        return;
 
-#ifndef NMD_GRAPHICS_OPENGL_DONT_BACKUP_RENDER_STATE
-    /* Backup the current render state */
-    GLenum last_active_texture; glGetIntegerv(GL_ACTIVE_TEXTURE, (GLint*)&last_active_texture);
-    glActiveTexture(GL_TEXTURE0);
-    GLuint last_program; glGetIntegerv(GL_CURRENT_PROGRAM, (GLint*)&last_program);
-    GLuint last_texture; glGetIntegerv(GL_TEXTURE_BINDING_2D, (GLint*)&last_texture);
+#ifdef NMD_GRAPHICS_OPENGL_DONT_BACKUP_RENDER_STATE
+    const uint32_t backup = NMD_RENDER_STATE_NONE;
+#else
+    const uint32_t backup = NMD_RENDER_STATE_ALL & ~_nmd_context->render_state.skip_backup;
+
+    /* Backup the categories of the current render state that are restored */
+    GLenum last_active_texture = GL_TEXTURE0;
+    GLuint last_program = 0, last_texture = 0, last_array_buffer = 0;
+    if (backup & NMD_RENDER_STATE_SHADERS)
+        glGetIntegerv(GL_CURRENT_PROGRAM, (GLint*)&last_program);
+    if (backup & NMD_RENDER_STATE_TEXTURE)
+    {
+        glGetIntegerv(GL_ACTIVE_TEXTURE, (GLint*)&last_active_texture);
+        glActiveTexture(GL_TEXTURE0);
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, (GLint*)&last_texture);
+    }
 #ifdef GL_SAMPLER_BINDING
-    GLuint last_sampler; glGetIntegerv(GL_SAMPLER_BINDING, (GLint*)&last_sampler);
+    GLuint last_sampler = 0;
+    if (backup & NMD_RENDER_STATE_SAMPLER)
+        glGetIntegerv(GL_SAMPLER_BINDING, (GLint*)&last_sampler);
 #endif
-    GLuint last_array_buffer; glGetIntegerv(GL_ARRAY_BUFFER_BINDING, (GLint*)&last_array_buffer);
 #ifndef IMGUI_IMPL_OPENGL_ES2
-    GLuint last_vertex_array_object; glGetIntegerv(GL_VERTEX_ARRAY_BINDING, (GLint*)&last_vertex_array_object);
+    GLuint last_vertex_array_object = 0;
 #endif
+    if (backup & NMD_RENDER_STATE_BUFFERS)
+    {
+        glGetIntegerv(GL_ARRAY_BUFFER_BINDING, (GLint*)&last_array_buffer);
+#ifndef IMGUI_IMPL_OPENGL_ES2
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, (GLint*)&last_vertex_array_object);
+#endif
+    }
+    GLenum last_blend_src_rgb = 0, last_blend_dst_rgb = 0, last_blend_src_alpha = 0, last_blend_dst_alpha = 0, last_blend_equation_rgb = 0, last_blend_equation_alpha = 0;
+    GLboolean last_enable_blend = GL_FALSE;
+    if (backup & NMD_RENDER_STATE_BLEND)
+    {
+        glGetIntegerv(GL_BLEND_SRC_RGB, (GLint*)&last_blend_src_rgb);
+        glGetIntegerv(GL_BLEND_DST_RGB, (GLint*)&last_blend_dst_rgb);
+        glGetIntegerv(GL_BLEND_SRC_ALPHA, (GLint*)&last_blend_src_alpha);
+        glGetIntegerv(GL_BLEND_DST_ALPHA, (GLint*)&last_blend_dst_alpha);
+        glGetIntegerv(GL_BLEND_EQUATION_RGB, (GLint*)&last_blend_equation_rgb);
+        glGetIntegerv(GL_BLEND_EQUATION_ALPHA, (GLint*)&last_blend_equation_alpha);
+        last_enable_blend = glIsEnabled(GL_BLEND);
+    }
+#ifdef GL_POLYGON_MODE
+    GLint last_polygon_mode[2] = { GL_FILL, GL_FILL };
+#endif
+    GLboolean last_enable_cull_face = GL_FALSE, last_enable_depth_test = GL_FALSE, last_enable_scissor_test = GL_FALSE;
+    if (backup & NMD_RENDER_STATE_RASTERIZER)
+    {
 #ifdef GL_POLYGON_MODE
-    GLint last_polygon_mode[2]; glGetIntegerv(GL_POLYGON_MODE, last_polygon_mode);
+        glGetIntegerv(GL_POLYGON_MODE, last_polygon_mode);
 #endif
-    GLint last_viewport[4]; glGetIntegerv(GL_VIEWPORT, last_viewport);
-    GLint last_scissor_box[4]; glGetIntegerv(GL_SCISSOR_BOX, last_scissor_box);
-    GLenum last_blend_src_rgb; glGetIntegerv(GL_BLEND_SRC_RGB, (GLint*)&last_blend_src_rgb);
-    GLenum last_blend_dst_rgb; glGetIntegerv(GL_BLEND_DST_RGB, (GLint*)&last_blend_dst_rgb);
-    GLenum last_blend_src_alpha; glGetIntegerv(GL_BLEND_SRC_ALPHA, (GLint*)&last_blend_src_alpha);
-    GLenum last_blend_dst_alpha; glGetIntegerv(GL_BLEND_DST_ALPHA, (GLint*)&last_blend_dst_alpha);
-    GLenum last_blend_equation_rgb; glGetIntegerv(GL_BLEND_EQUATION_RGB, (GLint*)&last_blend_equation_rgb);
-    GLenum last_blend_equation_alpha; glGetIntegerv(GL_BLEND_EQUATION_ALPHA, (GLint*)&last_blend_equation_alpha);
-    GLboolean last_enable_blend = glIsEnabled(GL_BLEND);
-    GLboolean last_enable_cull_face = glIsEnabled(GL_CULL_FACE);
-    GLboolean last_enable_depth_test = glIsEnabled(GL_DEPTH_TEST);
-    GLboolean last_enable_scissor_test = glIsEnabled(GL_SCISSOR_TEST);
+        last_enable_cull_face = glIsEnabled(GL_CULL_FACE);
+        last_enable_depth_test = glIsEnabled(GL_DEPTH_TEST);
+        last_enable_scissor_test = glIsEnabled(GL_SCISSOR_TEST);
+    }
+    GLint last_viewport[4], last_scissor_box[4];
+    if (backup & NMD_RENDER_STATE_VIEWPORT)
+        glGetIntegerv(GL_VIEWPORT, last_viewport);
+    if (backup & NMD_RENDER_STATE_SCISSOR)
+        glGetIntegerv(GL_SCISSOR_BOX, last_scissor_box);
 #endif /* NMD_GRAPHICS_OPENGL_DONT_BACKUP_RENDER_STATE */
 
+#ifdef NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS
+    /* Copy the vertices and indices that changed to the GPU */
+    const bool uploaded = _nmd_opengl_upload();
+
     /* Set render state */
-    _nmd_opengl_set_render_state();
+    _nmd_opengl_set_render_state(_nmd_begin_render_state());
+
+    /* The offsets of the current segment */
+    const GLint base_vertex = (GLint)(_nmd_opengl.segment * (_nmd_opengl.vertex_stream.capacity / sizeof(nmd_vertex)));
+    size_t index_offset = _nmd_opengl.segment * (_nmd_opengl.index_stream.capacity / sizeof(nmd_index));
+    size_t i = uploaded ? 0 : _nmd_context->draw_list.num_draw_commands;
+#else
+    /* Set render state */
+    _nmd_opengl_set_render_state(_nmd_begin_render_state());
 
     /* Copy vertices and indices and to the GPU */
-    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)_nmd_context.draw_list.num_vertices * (int)sizeof(nmd_vertex), (const GLvoid*)_nmd_context.draw_list.vertices, GL_STREAM_DRAW);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)_nmd_context.draw_list.num_indices * (int)sizeof(nmd_index), (const GLvoid*)_nmd_context.draw_list.indices, GL_STREAM_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)_nmd_context->draw_list.num_vertices * (int)sizeof(nmd_vertex), (const GLvoid*)_nmd_context->draw_list.vertices, GL_STREAM_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)_nmd_context->draw_list.num_indices * (int)sizeof(nmd_index), (const GLvoid*)_nmd_context->draw_list.indices, GL_STREAM_DRAW);
 
-    /* Render command buffers */
     size_t i = 0;
     size_t index_offset = 0;
-    for (; i < _nmd_context.draw_list.num_draw_commands; i++)
+#endif /* NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS */
+    size_t vertex_offset = 0; /* The vertex the attributes point to */
+
+    /* Render command buffers */
+    for (; i < _nmd_context->draw_list.num_draw_commands; i++)
     {
-        /* Apply scissor rectangle */
-        if (_nmd_context.draw_list.draw_commands[i].rect.p1.x == -1.0f)
-            glScissor(0, 0, (GLsizei)_nmd_opengl.width, (GLsizei)_nmd_opengl.height);
-        else
-            glScissor((GLint)_nmd_context.draw_list.draw_commands[i].rect.p0.x, (GLint)_nmd_context.draw_list.draw_commands[i].rect.p0.y, (GLsizei)_nmd_context.draw_list.draw_commands[i].rect.p1.x, (GLsizei)_nmd_context.draw_list.draw_commands[i].rect.p1.y);
+        /* Apply scissor rectangle if it changed */
+        if (_nmd_render_state_scissor_changed(&_nmd_context->draw_list.draw_commands[i].rect))
+        {
+            if (_nmd_context->draw_list.draw_commands[i].rect.p1.x == -1.0f)
+                glScissor(0, 0, (GLsizei)_nmd_opengl.width, (GLsizei)_nmd_opengl.height);
+            else
+                glScissor((GLint)_nmd_context->draw_list.draw_commands[i].rect.p0.x, (GLint)_nmd_context->draw_list.draw_commands[i].rect.p0.y, (GLsizei)_nmd_context->draw_list.draw_commands[i].rect.p1.x, (GLsizei)_nmd_context->draw_list.draw_commands[i].rect.p1.y);
+        }
         
-        /* Set texture */
-        glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)_nmd_context.draw_list.draw_commands[i].user_texture_id);
+        /* Set texture if it changed */
+        if (_nmd_render_state_texture_changed(_nmd_context->draw_list.draw_commands[i].user_texture_id))
+            glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)_nmd_context->draw_list.draw_commands[i].user_texture_id);
 
         /* Issue draw call */
-        glDrawElements(GL_TRIANGLES, (GLsizei)_nmd_context.draw_list.draw_commands[i].num_indices, sizeof(nmd_index) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(index_offset * sizeof(nmd_index)));
+#ifdef _NMD_OPENGL_BUFFER_STORAGE
+        if (_nmd_opengl.persistent)
+            glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)_nmd_context->draw_list.draw_commands[i].num_indices, sizeof(nmd_index) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(index_offset * sizeof(nmd_index)), base_vertex + (GLint)_nmd_context->draw_list.draw_commands[i].vertex_offset);
+        else
+#endif /* _NMD_OPENGL_BUFFER_STORAGE */
+        {
+            /* The base vertex only changes every 64K vertices, so the attributes are moved instead of requiring glDrawElementsBaseVertex() */
+            if (vertex_offset != _nmd_context->draw_list.draw_commands[i].vertex_offset)
+            {
+                vertex_offset = _nmd_context->draw_list.draw_commands[i].vertex_offset;
+                _nmd_opengl_set_vertex_attributes(vertex_offset);
+            }
+
+            glDrawElements(GL_TRIANGLES, (GLsizei)_nmd_context->draw_list.draw_commands[i].num_indices, sizeof(nmd_index) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(index_offset * sizeof(nmd_index)));
+        }
         
         /* Update offset */
-        index_offset += _nmd_context.draw_list.draw_commands[i].num_indices;
+        index_offset += _nmd_context->draw_list.draw_commands[i].num_indices;
     }
 
+    /* The render state cache expects the attributes to point to the first vertex */
+    if (vertex_offset)
+        _nmd_opengl_set_vertex_attributes(0);
+
+#ifdef _NMD_OPENGL_BUFFER_STORAGE
+    /* The segment can be written again when the GPU is done with these draw calls */
+    if (_nmd_opengl.persistent)
+        _nmd_opengl.fences[_nmd_opengl.segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif /* _NMD_OPENGL_BUFFER_STORAGE */
+
 #ifndef NMD_GRAPHICS_OPENGL_DONT_BACKUP_RENDER_STATE
-    /* Restore previous render state */
-    glUseProgram(last_program);
-    glBindTexture(GL_TEXTURE_2D, last_texture);
+    /* Restore the categories of the previous render state that were backed up */
+    if (backup & NMD_RENDER_STATE_SHADERS)
+        glUseProgram(last_program);
+    if (backup & NMD_RENDER_STATE_TEXTURE)
+    {
+        glBindTexture(GL_TEXTURE_2D, last_texture);
+        glActiveTexture(last_active_texture);
+    }
 #ifdef GL_SAMPLER_BINDING
-    glBindSampler(0, last_sampler);
+    if (backup & NMD_RENDER_STATE_SAMPLER)
+        glBindSampler(0, last_sampler);
 #endif
-    glActiveTexture(last_active_texture);
+    if (backup & NMD_RENDER_STATE_BUFFERS)
+    {
 #ifndef IMGUI_IMPL_OPENGL_ES2
-    glBindVertexArray(last_vertex_array_object);
+        glBindVertexArray(last_vertex_array_object);
 #endif
-    glBindBuffer(GL_ARRAY_BUFFER, last_array_buffer);
-    glBlendEquationSeparate(last_blend_equation_rgb, last_blend_equation_alpha);
-    glBlendFuncSeparate(last_blend_src_rgb, last_blend_dst_rgb, last_blend_src_alpha, last_blend_dst_alpha);
-    if (last_enable_blend) glEnable(GL_BLEND); else glDisable(GL_BLEND);
-    if (last_enable_cull_face) glEnable(GL_CULL_FACE); else glDisable(GL_CULL_FACE);
-    if (last_enable_depth_test) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
-    if (last_enable_scissor_test) glEnable(GL_SCISSOR_TEST); else glDisable(GL_SCISSOR_TEST);
+        glBindBuffer(GL_ARRAY_BUFFER, last_array_buffer);
+    }
+    if (backup & NMD_RENDER_STATE_BLEND)
+    {
+        glBlendEquationSeparate(last_blend_equation_rgb, last_blend_equation_alpha);
+        glBlendFuncSeparate(last_blend_src_rgb, last_blend_dst_rgb, last_blend_src_alpha, last_blend_dst_alpha);
+        if (last_enable_blend) glEnable(GL_BLEND); else glDisable(GL_BLEND);
+    }
+    if (backup & NMD_RENDER_STATE_RASTERIZER)
+    {
+        if (last_enable_cull_face) glEnable(GL_CULL_FACE); else glDisable(GL_CULL_FACE);
+        if (last_enable_depth_test) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
+        if (last_enable_scissor_test) glEnable(GL_SCISSOR_TEST); else glDisable(GL_SCISSOR_TEST);
 #ifdef GL_POLYGON_MODE
-    glPolygonMode(GL_FRONT_AND_BACK, (GLenum)last_polygon_mode[0]);
+        glPolygonMode(GL_FRONT_AND_BACK, (GLenum)last_polygon_mode[0]);
 #endif
-    glViewport(last_viewport[0], last_viewport[1], (GLsizei)last_viewport[2], (GLsizei)last_viewport[3]);
-    glScissor(last_scissor_box[0], last_scissor_box[1], (GLsizei)last_scissor_box[2], (GLsizei)last_scissor_box[3]);
+    }
+    if (backup & NMD_RENDER_STATE_VIEWPORT)
+        glViewport(last_viewport[0], last_viewport[1], (GLsizei)last_viewport[2], (GLsizei)last_viewport[3]);
+    if (backup & NMD_RENDER_STATE_SCISSOR)
+        glScissor(last_scissor_box[0], last_scissor_box[1], (GLsizei)last_scissor_box[2], (GLsizei)last_scissor_box[3]);
 #endif /* NMD_GRAPHICS_OPENGL_DONT_BACKUP_RENDER_STATE */
+
+#ifdef NMD_GRAPHICS_OPENGL_OPTIMIZE_RENDER_STATE
+    _nmd_end_render_state(backup, true);
+#else
+    _nmd_end_render_state(backup, _nmd_context->render_state.known_host_state);
+#endif /* NMD_GRAPHICS_OPENGL_OPTIMIZE_RENDER_STATE */
+}
+
+void nmd_opengl_render()
+{
+    _nmd_profile("nmd_opengl_render", true);
+    _nmd_opengl_render();
+    _nmd_profile("nmd_opengl_render", false);
 }
 
-#endif /* NMD_GRAPHICS_OPENGL */
+#endif /* NMD_GRAPHICS_OPENGL */
\ No newline at end of file
@@ -18,10 +18,14 @@ Interfaces(i.e the functions you call from your application):
      - string          [in]         A pointer to a string that represents one or more instructions in assembly language.
      - buffer          [out]        A pointer to a buffer that receives the encoded instructions.
      - buffer_size     [in]         The size of the buffer in bytes.
-     - runtime_address [in]         The instruction's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+     - runtime_address [in]         The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
      - mode            [in]         The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
      - count           [in/out/opt] A pointer to a variable that on input is the maximum number of instructions that can be parsed(or zero for unlimited instructions), and on output is the number of instructions parsed. This parameter may be zero.
     size_t nmd_x86_assemble(const char* string, void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, size_t* const count);
+    - Same as nmd_x86_assemble(), but the instruction is described by a variable of type 'nmd_x86_instruction'(e.g. filled by nmd_x86_decode()) instead of a string.
+      size_t nmd_x86_encode(const nmd_x86_instruction* instruction, void* buffer, size_t buffer_size);
+    - Same as nmd_x86_assemble(), but the instructions may define and refer to labels('loop: dec ecx' 'jnz loop'). The shortest branch encodings are chosen.
+      size_t nmd_x86_assemble_block(const char* string, void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, void* arena, size_t arena_size);
 
  - The disassembler is composed of a decoder and a formatter implemented by these two functions respectively:
 	- Decodes an instruction. Returns true if the instruction is valid, false otherwise.
@@ -33,14 +37,66 @@ Interfaces(i.e the functions you call from your application):
        - flags       [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use. If uncertain, use 'NMD_X86_DECODER_FLAGS_MINIMAL'.
       bool nmd_x86_decode(const void* buffer, size_t buffer_size, nmd_x86_instruction* instruction, NMD_X86_MODE mode, uint32_t flags);
 
+    - Decodes consecutive instructions until the end of the buffer, an invalid instruction or the end of the output array is reached. Returns the number of instructions decoded.
+      Parameters:
+       - buffer           [in]      A pointer to a buffer containing encoded instructions.
+       - buffer_size      [in]      The buffer's size in bytes.
+       - runtime_address  [in]      The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+       - mode             [in]      The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+       - flags            [in]      A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+       - instructions     [out]     A pointer to an array of 'nmd_x86_instruction' that receives the decoded instructions.
+       - num_instructions [in]      The number of elements in 'instructions'.
+       - info             [out/opt] A pointer to a variable of type 'nmd_x86_buffer_info' that receives where and why the function stopped. This parameter may be null.
+      size_t nmd_x86_decode_buffer(const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags, nmd_x86_instruction* instructions, size_t num_instructions, nmd_x86_buffer_info* info);
+
+    - Decodes an instruction into a compact(24 bytes) record using precomputed opcode tables. Returns true if the instruction is valid, false otherwise.
+      Parameters:
+       - buffer          [in]  A pointer to a buffer containing an encoded instruction.
+       - buffer_size     [in]  The buffer's size in bytes.
+       - runtime_address [in]  The instruction's runtime address used to compute 'branch_target'. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+       - instruction     [out] A pointer to a variable of type 'nmd_x86_light_instruction' that receives information about the instruction.
+       - mode            [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+       - flags           [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX'. 'NMD_X86_DECODER_FLAGS_OPERANDS', 'NMD_X86_DECODER_FLAGS_CPU_FLAGS' and 'NMD_X86_DECODER_FLAGS_REGISTERS' are ignored.
+      bool nmd_x86_decode_light(const void* buffer, size_t buffer_size, uint64_t runtime_address, nmd_x86_light_instruction* instruction, NMD_X86_MODE mode, uint32_t flags);
+
+    - Same as nmd_x86_decode_buffer(), but fills an array of 'nmd_x86_light_instruction'.
+      size_t nmd_x86_decode_buffer_light(const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags, nmd_x86_light_instruction* instructions, size_t num_instructions, nmd_x86_buffer_info* info);
+
+    - Computes the registers and cpu flags read and written by an instruction as fixed-width masks. The decoder fills 'instruction->registers' the same way if 'NMD_X86_DECODER_FLAGS_REGISTERS' is set.
+      void nmd_x86_get_register_use(const nmd_x86_instruction* instruction, nmd_x86_register_use* registers);
+
     - Formats an instruction. This function may access invalid memory(thus causing a crash) if you modify 'instruction' manually.
       Parameters:
        - instruction     [in]  A pointer to a variable of type 'nmd_x86_instruction' describing the instruction to be formatted.
-       - buffer          [out] A pointer to buffer that receives the string. The buffer's recommended size is 128 bytes.
+       - buffer          [out] A pointer to buffer that receives the string. It should have at least 'NMD_X86_FORMATTER_MAX_LENGTH' bytes.
        - runtime_address [in]  The instruction's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
        - flags           [in]  A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the function should format the instruction. If uncertain, use 'NMD_X86_FORMAT_FLAGS_DEFAULT'.
       void nmd_x86_format(const nmd_x86_instruction* instruction, char buffer[], uint64_t runtime_address, uint32_t flags);
 
+    - Same as nmd_x86_format(), but takes the buffer's size and returns the length of the string(excluding the null character), or zero if the instruction
+      is invalid or the string does not fit in the buffer. If 'buffer_size' is at least 'NMD_X86_FORMATTER_MAX_LENGTH' the string is formatted in place.
+      size_t nmd_x86_format_ex(const nmd_x86_instruction* instruction, char* buffer, size_t buffer_size, uint64_t runtime_address, uint32_t flags);
+
+    - Formats consecutive instructions into a single buffer, one line per instruction, and optionally returns the position of each line.
+      Lines are separated by '\n'. If 'NMD_X86_FORMAT_FLAGS_ADDRESS' is set each line starts with the instruction's runtime address.
+      size_t nmd_x86_format_buffer(const nmd_x86_instruction* instructions, size_t num_instructions, uint64_t runtime_address, uint32_t flags, char* buffer, size_t buffer_size, nmd_x86_text_line* lines, size_t* text_length);
+
+ - The decode cache keeps decoded and formatted instructions in a memory block provided by the caller, so code that is disassembled repeatedly(e.g. around
+   a debugger's program counter) is only decoded once:
+    - Initializes a cache. Returns the number of entries.
+      size_t nmd_x86_cache_init(nmd_x86_cache* cache, void* memory, size_t memory_size);
+    - Same as nmd_x86_decode(), but the instruction is looked up in the cache first. Returns a pointer to the instruction or a null pointer if it's invalid.
+      const nmd_x86_instruction* nmd_x86_cache_decode(nmd_x86_cache* cache, const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags);
+    - Same as nmd_x86_cache_decode(), but returns the formatted instruction.
+      const char* nmd_x86_cache_format(nmd_x86_cache* cache, const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t decoder_flags, uint32_t format_flags);
+    - Removes the instructions that overlap a range of memory(e.g. self-modifying code), or every instruction.
+      size_t nmd_x86_cache_invalidate(nmd_x86_cache* cache, uint64_t runtime_address, size_t size);
+      void nmd_x86_cache_clear(nmd_x86_cache* cache);
+
+ - The control flow graph builder finds the basic blocks reachable from one or more entry points and the edges between them. The graph is stored as
+   struct of arrays in a memory block provided by the caller. Returns the number of blocks.
+    size_t nmd_x86_cfg_build(const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, const uint64_t* entry_points, size_t num_entry_points, nmd_x86_cfg* cfg, void* memory, size_t memory_size);
+
  - The length disassembler is implemented by the following function:
     Returns the length of the instruction if it is valid, zero otherwise.
     Parameters:
@@ -49,6 +105,38 @@ Interfaces(i.e the functions you call from your application):
      - mode        [in] The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
     size_t nmd_x86_ldisasm(const void* buffer, size_t buffer_size, NMD_X86_MODE mode);
 
+ - The length of consecutive instructions is computed by the following function:
+    Computes the length of consecutive instructions until the end of the buffer, an invalid instruction or the end of the output array is reached. Returns the number of lengths written to 'lengths'.
+    Parameters:
+     - buffer      [in]      A pointer to a buffer containing encoded instructions.
+     - buffer_size [in]      The buffer's size in bytes.
+     - mode        [in]      The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+     - lengths     [out]     A pointer to an array that receives the length of each instruction.
+     - num_lengths [in]      The number of elements in 'lengths'.
+     - info        [out/opt] A pointer to a variable of type 'nmd_x86_buffer_info' that receives where and why the function stopped. This parameter may be null.
+    size_t nmd_x86_ldisasm_buffer(const void* buffer, size_t buffer_size, NMD_X86_MODE mode, uint8_t* lengths, size_t num_lengths, nmd_x86_buffer_info* info);
+
+ - Multithreaded disassembly(only available if 'NMD_ASSEMBLY_ENABLE_THREADS' is defined) is implemented by the following functions:
+    - Computes the instruction boundaries of a buffer using multiple threads. Returns the number of valid instructions.
+      The buffer is split in chunks which are decoded concurrently as if an instruction started at the first byte of each chunk. Afterwards the instruction
+      stream of every chunk is resynchronized with the stream of the previous chunk(decoding from where the previous chunk's stream left off until both
+      streams reach the same instruction), so the result is identical to a linear sweep that skips invalid instructions one byte at a time.
+      'lengths' must have 'buffer_size' elements. 'lengths[i]' is the length of the instruction at offset 'i' if one starts there, zero otherwise.
+      size_t nmd_x86_ldisasm_parallel(const void* buffer, size_t buffer_size, NMD_X86_MODE mode, uint8_t* lengths, size_t num_threads);
+
+    - Decodes every instruction of a buffer using multiple threads. The instruction boundaries are computed with the decoder's lengths and the instructions are written in address order.
+      size_t nmd_x86_decode_parallel(const void* buffer, size_t buffer_size, NMD_X86_MODE mode, uint32_t flags, uint8_t* lengths, nmd_x86_instruction* instructions, size_t num_instructions, size_t num_threads);
+
+    - Disassembles a stream of code on three threads: nmd_x86_ldisasm() splits the code in instructions, the decoder decodes them and the formatter formats
+      them. The stages run concurrently and are connected by single-producer/single-consumer lock-free ring buffers stored in a memory block provided by the caller.
+      Code is pushed in blocks and the formatted instructions are popped in batches, both functions never block.
+      size_t nmd_x86_pipeline_start(nmd_x86_pipeline* pipeline, NMD_X86_MODE mode, uint32_t decoder_flags, uint32_t format_flags, void* memory, size_t memory_size);
+      size_t nmd_x86_pipeline_push(nmd_x86_pipeline* pipeline, const void* buffer, size_t buffer_size, uint64_t runtime_address);
+      size_t nmd_x86_pipeline_pop(nmd_x86_pipeline* pipeline, nmd_x86_pipeline_line* lines, size_t num_lines);
+      void nmd_x86_pipeline_close(nmd_x86_pipeline* pipeline);
+      bool nmd_x86_pipeline_finished(nmd_x86_pipeline* pipeline);
+      void nmd_x86_pipeline_stop(nmd_x86_pipeline* pipeline);
+
 Enabling and disabling features of the decoder at compile-time:
 To dynamically choose which features are used by the decoder, use the 'flags' parameter of nmd_x86_decode(). The less features specified in the mask, the
 faster the decoder runs. By default all features are available, some can be completely disabled at compile time(thus reducing code size and increasing code speed) by defining
@@ -61,6 +149,14 @@ the following macros:
  - 'NMD_ASSEMBLY_DISABLE_DECODER_VEX': the decoder does not support VEX instructions.
  - 'NMD_ASSEMBLY_DISABLE_DECODER_EVEX': the decoder does not support EVEX instructions.
  - 'NMD_ASSEMBLY_DISABLE_DECODER_3DNOW': the decoder does not support 3DNow! instructions.
+ - 'NMD_ASSEMBLY_DISABLE_DECODER_REGISTERS': the decoder does not fill the 'registers' variable.
+
+These macros apply to every call of the decoder. To use a decoder with fixed mode and features next to the generic one, define a specialized decoder in the
+source file that defines 'NMD_ASSEMBLY_IMPLEMENTATION'(after the include statement). The compiler removes the code of the modes and features that are not used:
+NMD_X86_DEFINE_DECODER(nmd_x86_decode_64_minimal, NMD_X86_MODE_64, NMD_X86_DECODER_FLAGS_MINIMAL)
+NMD_X86_DEFINE_DECODER(nmd_x86_decode_32_full, NMD_X86_MODE_32, NMD_X86_DECODER_FLAGS_ALL)
+Other source files may declare them with 'NMD_X86_DECLARE_DECODER(nmd_x86_decode_64_minimal);'. They're called like nmd_x86_decode() without the last two parameters:
+bool nmd_x86_decode_64_minimal(const void* buffer, size_t buffer_size, nmd_x86_instruction* instruction);
 
 Enabling and disabling features of the formatter at compile-time:
 To dynamically choose which features are used by the formatter, use the 'flags' parameter of nmd_x86_format(). The less features specified in the mask, the
@@ -81,6 +177,11 @@ Use the following macros to disable features at compile-time:
  - 'NMD_ASSEMBLY_DISABLE_LENGTH_DISASSEMBLER_VALIDITY_CHECK': the length disassembler does not check if the instruction is invalid.
  - 'NMD_ASSEMBLY_DISABLE_LENGTH_DISASSEMBLER_VEX': the length disassembler does not support VEX instructions.
  - 'NMD_ASSEMBLY_DISABLE_LENGTH_DISASSEMBLER_3DNOW': the length disassembler does not support 3DNow! instructions.
+ - 'NMD_ASSEMBLY_ENABLE_LENGTH_DISASSEMBLER_SSE2': the length disassembler classifies prefixes using SSE2 intrinsics when at least 16 bytes are available. This macro includes <emmintrin.h>.
+
+Multithreading:
+Threads are not used by default. Define the 'NMD_ASSEMBLY_ENABLE_THREADS' macro to enable nmd_x86_ldisasm_parallel(), nmd_x86_decode_parallel() and the pipeline. This macro includes
+<windows.h> on Windows and <pthread.h> and <sched.h> elsewhere(link with '-pthread'). No memory is allocated, the maximum number of threads is 'NMD_ASSEMBLY_MAX_THREADS'(64 by default).
 
 Fixed width integer types:
 By default the library includes <stdint.h> and <stddef.h> to include int types.
@@ -193,10 +294,30 @@ Contributors(This may not be a complete list):
 #define NMD_X86_FORMATTER_NUM_PADDING_BYTES 10
 #endif /* NMD_X86_FORMATTER_NUM_PADDING_BYTES */
 
+/* The size of the buffer the formatter needs to write any instruction in place(including the null character). */
+#define NMD_X86_FORMATTER_MAX_LENGTH 256
+
 #define NMD_X86_INVALID_RUNTIME_ADDRESS ((uint64_t)(-1))
 #define NMD_X86_MAXIMUM_INSTRUCTION_LENGTH 15
 #define NMD_X86_MAXIMUM_NUM_OPERANDS 10
 
+/* The size of the arena nmd_x86_assemble_block() needs for a block of 'num_lines' lines and 'string_length' characters. */
+#define NMD_X86_ASSEMBLE_BLOCK_ARENA_SIZE(num_lines, string_length) ((num_lines) * 64 + (string_length) + 8)
+
+/* The size of the string stored with each instruction of the decode cache(including the null character). Longer strings are not cached. */
+#ifndef NMD_X86_CACHE_STRING_SIZE
+#define NMD_X86_CACHE_STRING_SIZE 128
+#endif /* NMD_X86_CACHE_STRING_SIZE */
+
+/* The number of entries of each bucket of the decode cache. An instruction may be stored in any entry of the bucket of its runtime address. */
+#define NMD_X86_CACHE_BUCKET_SIZE 4
+
+/* The size of the memory block nmd_x86_cache_init() needs for 'num_entries' entries. */
+#define NMD_X86_CACHE_MEMORY_SIZE(num_entries) ((num_entries) * (sizeof(nmd_x86_cache_key) + sizeof(nmd_x86_cache_entry)) + 8)
+
+/* The size of the memory block nmd_x86_cfg_build() needs in the worst case(every instruction is a block) for a buffer of 'buffer_size' bytes. */
+#define NMD_X86_CFG_MEMORY_SIZE(buffer_size) ((buffer_size) * 28 + 8)
+
 /* Define the api macro to potentially change functions's attributes. */
 #ifndef NMD_ASSEMBLY_API
 #ifdef NMD_ASSEMBLY_PRIVATE
@@ -225,6 +346,7 @@ enum NMD_X86_FORMATTER_FLAGS
 	NMD_X86_FORMAT_FLAGS_SCALE_ONE                 = (1 << 13), /* If set, scale one is displayed. E.g. add byte ptr [eax+eax*1], al. */
 	NMD_X86_FORMAT_FLAGS_BYTES                     = (1 << 14), /* The instruction's bytes are displayed before the instructions. */
 	NMD_X86_FORMAT_FLAGS_ATT_SYNTAX                = (1 << 15), /* AT&T syntax is used instead of Intel's. */
+	NMD_X86_FORMAT_FLAGS_ADDRESS                   = (1 << 16), /* The instruction's runtime address is displayed at the start of the line. Only used by nmd_x86_format_buffer(). */
 
 	/* The formatter's default formatting style. */
 	NMD_X86_FORMAT_FLAGS_DEFAULT  = (NMD_X86_FORMAT_FLAGS_HEX | NMD_X86_FORMAT_FLAGS_H_SUFFIX | NMD_X86_FORMAT_FLAGS_ONLY_SEGMENT_OVERRIDE | NMD_X86_FORMAT_FLAGS_SIGNED_NUMBER_MEMORY_VIEW | NMD_X86_FORMAT_FLAGS_SIGNED_NUMBER_HINT_DEC),
@@ -241,10 +363,16 @@ enum NMD_X86_DECODER_FLAGS
 	NMD_X86_DECODER_FLAGS_EVEX           = (1 << 6), /* The decoder parses EVEX instructions. */
 	NMD_X86_DECODER_FLAGS_3DNOW          = (1 << 7), /* The decoder parses 3DNow! instructions. */
 
+	/* This feature makes every call noticeably slower, so it's opt-in and not part of 'NMD_X86_DECODER_FLAGS_ALL'. */
+	NMD_X86_DECODER_FLAGS_REGISTERS      = (1 << 8), /* The decoder fills the 'registers' variable. The masks are complete if 'NMD_X86_DECODER_FLAGS_INSTRUCTION_ID', 'NMD_X86_DECODER_FLAGS_CPU_FLAGS', 'NMD_X86_DECODER_FLAGS_OPERANDS' and 'NMD_X86_DECODER_FLAGS_GROUP' are also set. */
+
+	/* This is not a feature, so it's not part of 'NMD_X86_DECODER_FLAGS_ALL'. */
+	NMD_X86_DECODER_FLAGS_ZERO_COPY      = (1 << 9), /* The decoder does not copy the instruction's bytes to 'buffer', 'source' points to them instead. The decoded buffer must stay valid while the instruction is used. */
+
 	/* These are not actual features, but rather masks of features. */
 	NMD_X86_DECODER_FLAGS_NONE    = 0,
 	NMD_X86_DECODER_FLAGS_MINIMAL = (NMD_X86_DECODER_FLAGS_VALIDITY_CHECK | NMD_X86_DECODER_FLAGS_VEX | NMD_X86_DECODER_FLAGS_EVEX), /* Mask that specifies minimal features to provide acurate results in any environment. */
-	NMD_X86_DECODER_FLAGS_ALL     = (1 << 8) - 1, /* Mask that specifies all features. */
+	NMD_X86_DECODER_FLAGS_ALL     = (1 << 8) - 1, /* Mask that specifies all features except 'NMD_X86_DECODER_FLAGS_REGISTERS'. */
 };
 
 enum NMD_X86_PREFIXES
@@ -2248,6 +2376,7 @@ typedef struct nmd_x86_memory_operand
 	uint8_t base;        /* The base register. A member of 'NMD_X86_REG'. */
 	uint8_t index;       /* The index register. A member of 'NMD_X86_REG'. */
 	uint8_t scale;       /* Scale(1, 2, 4 or 8). */
+	uint8_t size;        /* The size of the operand in bytes(e.g. 1 for 'byte ptr [eax]'), or zero if unknown. */
 	int64_t disp;        /* Displacement. */
 } nmd_x86_memory_operand;
 
@@ -2366,6 +2495,61 @@ enum NMD_X86_FPU_FLAGS
 	NMD_X86_FPU_FLAGS_C3 = (1 << 14)
 };
 
+/* Bits of the masks of 'nmd_x86_register_use'. Every size of a register(e.g. 'al', 'ah', 'ax', 'eax' and 'rax') has the same bit. */
+enum NMD_X86_REGISTER_USE
+{
+	/* Bits of 'gpr_read' and 'gpr_written'. */
+	NMD_X86_REGISTER_USE_RAX = (1 << 0),
+	NMD_X86_REGISTER_USE_RCX = (1 << 1),
+	NMD_X86_REGISTER_USE_RDX = (1 << 2),
+	NMD_X86_REGISTER_USE_RBX = (1 << 3),
+	NMD_X86_REGISTER_USE_RSP = (1 << 4),
+	NMD_X86_REGISTER_USE_RBP = (1 << 5),
+	NMD_X86_REGISTER_USE_RSI = (1 << 6),
+	NMD_X86_REGISTER_USE_RDI = (1 << 7),
+	NMD_X86_REGISTER_USE_R8  = (1 << 8),
+	NMD_X86_REGISTER_USE_R9  = (1 << 9),
+	NMD_X86_REGISTER_USE_R10 = (1 << 10),
+	NMD_X86_REGISTER_USE_R11 = (1 << 11),
+	NMD_X86_REGISTER_USE_R12 = (1 << 12),
+	NMD_X86_REGISTER_USE_R13 = (1 << 13),
+	NMD_X86_REGISTER_USE_R14 = (1 << 14),
+	NMD_X86_REGISTER_USE_R15 = (1 << 15),
+	NMD_X86_REGISTER_USE_IP  = (1 << 16), /* The instruction pointer(ip, eip or rip). */
+	NMD_X86_REGISTER_USE_ES  = (1 << 17),
+	NMD_X86_REGISTER_USE_CS  = (1 << 18),
+	NMD_X86_REGISTER_USE_SS  = (1 << 19),
+	NMD_X86_REGISTER_USE_DS  = (1 << 20),
+	NMD_X86_REGISTER_USE_FS  = (1 << 21),
+	NMD_X86_REGISTER_USE_GS  = (1 << 22),
+
+	/* Bits of 'other_read' and 'other_written'. 'mmN' is 'NMD_X86_REGISTER_USE_MM0 << N', the same applies to 'kN' and 'st(N)'. */
+	NMD_X86_REGISTER_USE_MM0 = (1 << 0),
+	NMD_X86_REGISTER_USE_K0  = (1 << 8),
+	NMD_X86_REGISTER_USE_ST0 = (1 << 16),
+	NMD_X86_REGISTER_USE_CR  = (1 << 24), /* Any control register. */
+	NMD_X86_REGISTER_USE_DR  = (1 << 25), /* Any debug register. */
+};
+
+/*
+Registers and cpu flags read and written by an instruction, as fixed-width masks that can be combined with bitwise operations(e.g. for liveness or taint analysis).
+Registers read through a memory operand(base, index and segment) are included in the read masks. A write to an 8 or 16-bit general purpose register keeps the
+register's other bits, so the register is also in the read mask. Conditional reads and writes(e.g. 'cmovz') are included as reads and writes.
+For instructions whose operands are not filled by the decoder(e.g. VEX instructions), only the destination register of the ModR/M byte is in the write masks,
+and it's also in the read masks because it's not known if it's read.
+*/
+typedef struct nmd_x86_register_use
+{
+	uint32_t gpr_read;       /* General purpose, instruction pointer and segment registers read by the instruction. A mask of 'NMD_X86_REGISTER_USE_XXX'. */
+	uint32_t gpr_written;    /* General purpose, instruction pointer and segment registers written by the instruction. A mask of 'NMD_X86_REGISTER_USE_XXX'. */
+	uint32_t vector_read;    /* Vector registers read by the instruction. Bit 'N' is xmmN, ymmN or zmmN. */
+	uint32_t vector_written; /* Vector registers written by the instruction. Bit 'N' is xmmN, ymmN or zmmN. */
+	uint32_t other_read;     /* MMX, mask, x87, control and debug registers read by the instruction. A mask of 'NMD_X86_REGISTER_USE_XXX'. */
+	uint32_t other_written;  /* MMX, mask, x87, control and debug registers written by the instruction. A mask of 'NMD_X86_REGISTER_USE_XXX'. */
+	uint32_t flags_read;     /* Cpu flags read by the instruction. A mask of 'NMD_X86_EFLAGS', or 'NMD_X86_FPU_FLAGS' for x87 instructions(like 'tested_flags'). */
+	uint32_t flags_written;  /* Cpu flags written by the instruction(modified, set, cleared or undefined). A mask of 'NMD_X86_EFLAGS', or 'NMD_X86_FPU_FLAGS' for x87 instructions. */
+} nmd_x86_register_use;
+
 typedef struct nmd_x86_instruction
 {
 	bool valid : 1;                                         /* If true, the instruction is valid. */
@@ -2383,7 +2567,7 @@ typedef struct nmd_x86_instruction
 	uint8_t num_prefixes;                                   /* Number of prefixes. */
 	uint8_t num_operands;                                   /* The number of operands. */
 	uint8_t group;                                          /* The instruction's group(e.g. jmp, prvileged...). A member of 'NMD_GROUP'. */
-	uint8_t buffer[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH];     /* A buffer containing the full instruction. */
+	uint8_t buffer[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH];     /* A buffer containing the full instruction. Not filled if 'source' is not null. */
 	nmd_x86_operand operands[NMD_X86_MAXIMUM_NUM_OPERANDS]; /* Operands. */
 	nmd_x86_modrm modrm;                                    /* The Mod/RM byte. Check 'flags.fields.has_modrm'. */
 	nmd_x86_sib sib;                                        /* The SIB byte. Check 'flags.fields.has_sib'. */
@@ -2402,8 +2586,35 @@ typedef struct nmd_x86_instruction
 	uint8_t rex;                                            /* REX prefix. */
 	uint8_t segment_override;                               /* The segment override prefix closest to the opcode. A member of 'NMD_X86_PREFIXES'. */
 	uint16_t simd_prefix;                                   /* One of these prefixes that is the closest to the opcode: NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE, NMD_X86_PREFIXES_LOCK, NMD_X86_PREFIXES_REPEAT_NOT_ZERO, NMD_X86_PREFIXES_REPEAT, or NMD_X86_PREFIXES_NONE. The prefixes are specified as members of the 'NMD_X86_PREFIXES' enum. */
+	nmd_x86_register_use registers;                         /* Registers and cpu flags read and written by the instruction. Check 'NMD_X86_DECODER_FLAGS_REGISTERS'. */
+	const uint8_t* source;                                  /* A pointer to the instruction's bytes in the decoded buffer if 'NMD_X86_DECODER_FLAGS_ZERO_COPY' was set, null otherwise. */
 } nmd_x86_instruction;
 
+enum NMD_X86_LIGHT_FLAGS
+{
+	NMD_X86_LIGHT_FLAGS_MEMORY_OPERAND = (1 << 0), /* The instruction has a ModR/M memory operand described by 'segment', 'base', 'index', 'scale' and 'displacement'. */
+	NMD_X86_LIGHT_FLAGS_BRANCH_TARGET  = (1 << 1), /* The instruction is a relative branch whose target is 'branch_target'. */
+	NMD_X86_LIGHT_FLAGS_LOCK           = (1 << 2), /* The instruction has a lock prefix. */
+	NMD_X86_LIGHT_FLAGS_REPEAT         = (1 << 3), /* The instruction has a repeat(F3h) or repeat not zero(F2h) prefix. */
+};
+
+/* A compact description of an instruction filled by nmd_x86_decode_light(). */
+typedef struct nmd_x86_light_instruction
+{
+	uint64_t branch_target; /* The branch's target. Check 'flags'. Relative to the instruction's address if no runtime address was specified. */
+	int32_t displacement;   /* The memory operand's displacement(sign extended, except 16-bit absolute addresses like '[0xDDFE]'). */
+	uint16_t id;            /* The instruction's identifier. A member of 'NMD_X86_INSTRUCTION'. */
+	uint8_t length;         /* The instruction's length in bytes. */
+	uint8_t opcode;         /* Opcode byte. */
+	uint8_t opcode_map;     /* The instruction's opcode map. A member of 'NMD_X86_OPCODE_MAP'. */
+	uint8_t group;          /* The instruction's group(e.g. jmp, prvileged...). A member of 'NMD_GROUP'. */
+	uint8_t flags;          /* A mask of 'NMD_X86_LIGHT_FLAGS'. */
+	uint8_t segment;        /* The memory operand's segment register. A member of 'NMD_X86_REG'. */
+	uint8_t base;           /* The memory operand's base register(NMD_X86_REG_RIP/NMD_X86_REG_EIP if it's relative to the instruction pointer). A member of 'NMD_X86_REG'. */
+	uint8_t index;          /* The memory operand's index register. A member of 'NMD_X86_REG'. */
+	uint8_t scale;          /* The memory operand's scale(1, 2, 4 or 8, zero if there's no index register). */
+} nmd_x86_light_instruction;
+
 typedef union nmd_x86_register
 {
 	int8_t  h8;
@@ -2420,18 +2631,144 @@ typedef union nmd_x86_register_512
 	uint64_t zmm0[8];
 } nmd_x86_register_512;
 
+/* Specifies why a function that processes a whole buffer(e.g. nmd_x86_decode_buffer()) stopped. */
+enum NMD_X86_BUFFER_STATUS
+{
+	NMD_X86_BUFFER_STATUS_END = 0,     /* Every instruction in the buffer was processed. */
+	NMD_X86_BUFFER_STATUS_INVALID,     /* The bytes at 'offset' do not form a valid instruction(or the buffer ends in the middle of an instruction). */
+	NMD_X86_BUFFER_STATUS_OUTPUT_FULL, /* The output array is full. The instruction at 'offset' was not processed. */
+};
+
+typedef struct nmd_x86_buffer_info
+{
+	size_t offset;            /* The offset in bytes relative to the start of the buffer where the function stopped. */
+	uint64_t runtime_address; /* The runtime address where the function stopped, or 'NMD_X86_INVALID_RUNTIME_ADDRESS' if no runtime address was specified. */
+	uint8_t status;           /* The reason the function stopped. A member of 'NMD_X86_BUFFER_STATUS'. */
+} nmd_x86_buffer_info;
+
+typedef struct nmd_x86_text_line
+{
+	size_t offset; /* The offset of the line's first character relative to the start of the output buffer. */
+	size_t length; /* The number of characters in the line, excluding the new line character. */
+} nmd_x86_text_line;
+
+/* The part of a decode cache entry that is compared on lookups. Keys are stored apart from the entries so a lookup only touches one entry. */
+typedef struct nmd_x86_cache_key
+{
+	uint64_t runtime_address; /* The instruction's runtime address. */
+	uint32_t flags;           /* The decoder flags used to decode the instruction. */
+	uint8_t mode;             /* The instruction's mode. A member of 'NMD_X86_MODE'. */
+	uint8_t length;           /* The instruction's length in bytes, or zero if the entry is empty. */
+} nmd_x86_cache_key;
+
+typedef struct nmd_x86_cache_entry
+{
+	nmd_x86_instruction instruction;         /* The decoded instruction. 'instruction.buffer' is compared with the bytes in memory on every lookup. */
+	uint32_t format_flags;                   /* The flags used to format 'string'. */
+	size_t string_length;                    /* The length of 'string', or zero if the instruction was not formatted yet. */
+	char string[NMD_X86_CACHE_STRING_SIZE];  /* The formatted instruction. */
+} nmd_x86_cache_entry;
+
+/* Properties of a basic block built by nmd_x86_cfg_build(). */
+enum NMD_X86_CFG_BLOCK_FLAGS
+{
+	NMD_X86_CFG_BLOCK_FUNCTION        = (1 << 0), /* The block starts at an entry point or at the target of a call. */
+	NMD_X86_CFG_BLOCK_RETURN          = (1 << 1), /* The block ends with a return. */
+	NMD_X86_CFG_BLOCK_INDIRECT_BRANCH = (1 << 2), /* The block ends with a branch whose target is not known(e.g. 'jmp rax'). */
+	NMD_X86_CFG_BLOCK_EXTERNAL_BRANCH = (1 << 3), /* The block ends with a branch whose target is not an instruction of the buffer. */
+	NMD_X86_CFG_BLOCK_TRUNCATED       = (1 << 4), /* The execution continues after the block, but the next bytes are not a valid instruction or the buffer ends. */
+};
+
+/* The type of an edge between two basic blocks. */
+enum NMD_X86_CFG_EDGE
+{
+	NMD_X86_CFG_EDGE_FALLTHROUGH = 0, /* The target block follows the source block(e.g. the condition of a conditional branch is false). */
+	NMD_X86_CFG_EDGE_BRANCH_TAKEN,    /* The condition of the conditional branch that ends the source block is true. */
+	NMD_X86_CFG_EDGE_JUMP,            /* The unconditional branch that ends the source block. */
+};
+
+/* A control flow graph built by nmd_x86_cfg_build(). Blocks and edges are stored as struct of arrays. Its arrays point to the memory block passed to nmd_x86_cfg_build(). */
+typedef struct nmd_x86_cfg
+{
+	size_t num_blocks;                /* The number of basic blocks. */
+	size_t num_edges;                 /* The number of edges. */
+
+	/* Basic blocks sorted by offset('num_blocks' elements). */
+	uint32_t* block_offset;           /* The offset of the block's first instruction relative to the start of the buffer. */
+	uint32_t* block_size;             /* The block's size in bytes. */
+	uint32_t* block_num_instructions; /* The number of instructions of the block. */
+	uint32_t* block_first_edge;       /* The successors of block 'i' are the edges in the range [block_first_edge[i], block_first_edge[i + 1]). This array has 'num_blocks + 1' elements. */
+	uint8_t* block_flags;             /* A mask of 'NMD_X86_CFG_BLOCK_FLAGS'. */
+
+	/* Edges sorted by source block('num_edges' elements). */
+	uint32_t* edge_target;            /* The index of the target block. */
+	uint8_t* edge_type;               /* The edge's type. A member of 'NMD_X86_CFG_EDGE'. */
+} nmd_x86_cfg;
+
+/* A decode cache. It's initialized by nmd_x86_cache_init() and it does not own any memory. It must not be used by more than one thread at the same time. */
+typedef struct nmd_x86_cache
+{
+	nmd_x86_cache_key* keys;
+	nmd_x86_cache_entry* entries;
+	size_t num_buckets; /* The number of buckets. It's a power of two. */
+	size_t num_hits;    /* The number of lookups that found the instruction. */
+	size_t num_misses;  /* The number of lookups that had to decode the instruction. */
+	uint32_t next_victim;
+} nmd_x86_cache;
+
 /*
 Assembles one or more instructions from a string. Returns the number of bytes written to the buffer on success, zero otherwise. Instructions can be separated using the '\n'(new line) character.
 Parameters:
  - string          [in]         A pointer to a string that represents one or more instructions in assembly language.
  - buffer          [out]        A pointer to a buffer that receives the encoded instructions.
  - buffer_size     [in]         The size of the buffer in bytes.
- - runtime_address [in]         The instruction's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - runtime_address [in]         The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
  - mode            [in]         The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
  - count           [in/out/opt] A pointer to a variable that on input is the maximum number of instructions that can be parsed, and on output the number of instructions parsed. This parameter may be null.
 */
 NMD_ASSEMBLY_API size_t nmd_x86_assemble(const char* string, void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, size_t* count);
 
+/*
+Encodes an instruction from a structured description instead of a string. Returns the number of bytes written to the buffer on success, zero otherwise.
+The description follows the decoder's conventions, so instructions filled by nmd_x86_decode() with 'NMD_X86_DECODER_FLAGS_OPERANDS' can be encoded again:
+ - 'mode' and 'id' select the instruction. Only the explicit operands(the ones whose 'is_implicit' is false) are used, the other variables are ignored
+   except 'prefixes', from which only 'NMD_X86_PREFIXES_LOCK' and 'NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE' are used, 'opcode' and 'opcode_map', which are only used
+   to reject far branches, 'length', see below, and 'has_rex', which makes the registers 'NMD_X86_REG_AH' to 'NMD_X86_REG_BH' mean 'spl', 'bpl', 'sil' and 'dil'
+   like in the decoder. 'ah' to 'bh' can't be used with registers that require a REX prefix.
+ - 16-bit addressing(e.g. '[bx+si]' or a 16-bit displacement) and far pointers('call ptr16:32') can't be encoded.
+ - The operand size is given by the register operands(e.g. 'ax' selects 16-bit operands), or else by the 'size' of the memory operand(a dword if zero).
+ - The immediate of a relative branch(e.g. 'jmp', 'jz' and 'call') is the displacement from the end of the instruction, whose length is 'length'.
+   The shortest encoding that reaches the same target is used and the displacement is adjusted to its length. If 'length' is zero, the displacement is
+   relative to the end of the new encoding instead.
+Supported instructions: instructions without explicit operands known by nmd_x86_assemble(), 'add', 'or', 'adc', 'sbb', 'and', 'sub', 'xor', 'cmp' and 'mov'
+(r/m,reg reg,mem r/m,imm), 'lea', 'inc', 'dec', 'push', 'pop'(reg, segment register, imm), 'jmp', 'call', 'jcc'(rel), 'ret', 'retf'(imm16) and 'int'(imm8).
+Parameters:
+ - instruction [in]  A pointer to a variable of type 'nmd_x86_instruction' that describes the instruction.
+ - buffer      [out] A pointer to a buffer that receives the encoded instruction.
+ - buffer_size [in]  The size of the buffer in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_encode(const nmd_x86_instruction* instruction, void* buffer, size_t buffer_size);
+
+/*
+Assembles a block of instructions separated by the '\n'(new line) character, which may define and refer to labels. Returns the number of bytes written to the buffer on success, zero otherwise.
+ - A label is defined by an identifier followed by ':' at the start of a line, e.g. 'loop:' or 'loop: dec ecx'. Labels are case insensitive and can be referred to before they are defined.
+ - The operand of 'jmp', 'call' and conditional jumps may be a label. The shortest encoding of 'jmp' and conditional jumps is chosen by iterative relaxation: every branch
+   starts with an 8-bit displacement and only the ones whose target is out of range grow, until no branch has to grow.
+ - Empty lines are ignored. The address of each instruction is the runtime address of the block plus its offset, so a number used as the operand of a branch is an address
+   (or, without a runtime address, a displacement relative to the start of the instruction, same as in nmd_x86_assemble()).
+The instructions are assembled directly to the buffer and moved when a branch before them grows, so the buffer must have room for the whole block. The symbol table and the
+per-instruction information are stored in the arena, see 'NMD_X86_ASSEMBLE_BLOCK_ARENA_SIZE'.
+Parameters:
+ - string          [in]  A pointer to a string that represents a block of instructions in assembly language.
+ - buffer          [out] A pointer to a buffer that receives the encoded instructions.
+ - buffer_size     [in]  The size of the buffer in bytes.
+ - runtime_address [in]  The block's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - mode            [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - arena           [in]  A pointer to memory used by the assembler.
+ - arena_size      [in]  The size of the arena in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_assemble_block(const char* string, void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, void* arena, size_t arena_size);
+
 /*
 Decodes an instruction. Returns true if the instruction is valid, false otherwise.
 Parameters:
@@ -2443,16 +2780,182 @@ Parameters:
 */
 NMD_ASSEMBLY_API bool nmd_x86_decode(const void* buffer, size_t buffer_size, nmd_x86_instruction* instruction, NMD_X86_MODE mode, uint32_t flags);
 
+/*
+Decodes consecutive instructions until the end of the buffer, an invalid instruction or the end of the output array is reached. Returns the number of instructions decoded.
+This is faster than calling nmd_x86_decode() in a loop because only the variables selected by 'flags' are cleared: 'buffer' is only filled up to 'length' bytes,
+'operands' is left unspecified if 'NMD_X86_DECODER_FLAGS_OPERANDS' is not set, the cpu flags are left unspecified if 'NMD_X86_DECODER_FLAGS_CPU_FLAGS' is not set
+and 'registers' is left unspecified if 'NMD_X86_DECODER_FLAGS_REGISTERS' is not set.
+With 'NMD_X86_DECODER_FLAGS_ZERO_COPY' the bytes are not copied at all, which suits buffers that outlive the instructions(e.g. memory-mapped files).
+Parameters:
+ - buffer           [in]      A pointer to a buffer containing encoded instructions.
+ - buffer_size      [in]      The buffer's size in bytes.
+ - runtime_address  [in]      The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - mode             [in]      The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags            [in]      A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use. If uncertain, use 'NMD_X86_DECODER_FLAGS_MINIMAL'.
+ - instructions     [out]     A pointer to an array of 'nmd_x86_instruction' that receives the decoded instructions.
+ - num_instructions [in]      The number of elements in 'instructions'.
+ - info             [out/opt] A pointer to a variable of type 'nmd_x86_buffer_info' that receives where and why the function stopped. This parameter may be null.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_decode_buffer(const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags, nmd_x86_instruction* instructions, size_t num_instructions, nmd_x86_buffer_info* info);
+
+/*
+Defines a decoder named 'name' whose mode and flags are constants, so the compiler removes the code of the modes and features that are not used.
+The decoder has the same parameters as nmd_x86_decode() except 'mode' and 'flags'. Like nmd_x86_decode_buffer(), it only clears the variables
+of 'instruction' required by 'flags'. This macro must be used in the source file that defines 'NMD_ASSEMBLY_IMPLEMENTATION', after the include statement.
+Example: NMD_X86_DEFINE_DECODER(nmd_x86_decode_64_minimal, NMD_X86_MODE_64, NMD_X86_DECODER_FLAGS_MINIMAL)
+*/
+#define NMD_X86_DEFINE_DECODER(name, mode, flags) \
+	NMD_ASSEMBLY_API bool name(const void* buffer, size_t buffer_size, nmd_x86_instruction* instruction) \
+	{ \
+		_nmd_clear_instruction(instruction, (flags)); \
+		return _nmd_decode_instruction_inline(buffer, buffer_size > NMD_X86_MAXIMUM_INSTRUCTION_LENGTH ? NMD_X86_MAXIMUM_INSTRUCTION_LENGTH : buffer_size, instruction, (mode), (flags)); \
+	}
+
+/* Declares a decoder defined by NMD_X86_DEFINE_DECODER(). */
+#define NMD_X86_DECLARE_DECODER(name) NMD_ASSEMBLY_API bool name(const void* buffer, size_t buffer_size, nmd_x86_instruction* instruction)
+
+/*
+Decodes an instruction into a compact record. Returns true if the instruction is valid, false otherwise.
+Most instructions are decoded using precomputed opcode tables, the rest(e.g. SSE, VEX and FPU instructions) are decoded by nmd_x86_decode().
+Both paths give the same results with the same flags.
+Parameters:
+ - buffer          [in]  A pointer to a buffer containing an encoded instruction.
+ - buffer_size     [in]  The buffer's size in bytes.
+ - runtime_address [in]  The instruction's runtime address used to compute 'branch_target'. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - instruction     [out] A pointer to a variable of type 'nmd_x86_light_instruction' that receives information about the instruction.
+ - mode            [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags           [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use. 'NMD_X86_DECODER_FLAGS_OPERANDS', 'NMD_X86_DECODER_FLAGS_CPU_FLAGS' and 'NMD_X86_DECODER_FLAGS_REGISTERS' are ignored.
+*/
+NMD_ASSEMBLY_API bool nmd_x86_decode_light(const void* buffer, size_t buffer_size, uint64_t runtime_address, nmd_x86_light_instruction* instruction, NMD_X86_MODE mode, uint32_t flags);
+
+/*
+Same as nmd_x86_decode_buffer(), but the instructions are decoded by nmd_x86_decode_light(). Returns the number of instructions decoded.
+Parameters:
+ - buffer           [in]      A pointer to a buffer containing encoded instructions.
+ - buffer_size      [in]      The buffer's size in bytes.
+ - runtime_address  [in]      The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - mode             [in]      The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags            [in]      A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+ - instructions     [out]     A pointer to an array of 'nmd_x86_light_instruction' that receives the decoded instructions.
+ - num_instructions [in]      The number of elements in 'instructions'.
+ - info             [out/opt] A pointer to a variable of type 'nmd_x86_buffer_info' that receives where and why the function stopped. This parameter may be null.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_decode_buffer_light(const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags, nmd_x86_light_instruction* instructions, size_t num_instructions, nmd_x86_buffer_info* info);
+
+/*
+Computes the registers and cpu flags read and written by an instruction. This is the function used by the decoder to fill the 'registers' variable
+if 'NMD_X86_DECODER_FLAGS_REGISTERS' is set. The masks are complete if the instruction was decoded with 'NMD_X86_DECODER_FLAGS_INSTRUCTION_ID',
+'NMD_X86_DECODER_FLAGS_CPU_FLAGS', 'NMD_X86_DECODER_FLAGS_OPERANDS' and 'NMD_X86_DECODER_FLAGS_GROUP'.
+Parameters:
+ - instruction [in]  A pointer to a variable of type 'nmd_x86_instruction' describing the instruction.
+ - registers   [out] A pointer to a variable of type 'nmd_x86_register_use' that receives the masks.
+*/
+NMD_ASSEMBLY_API void nmd_x86_get_register_use(const nmd_x86_instruction* instruction, nmd_x86_register_use* registers);
+
 /*
 Formats an instruction. This function may cause a crash if you modify 'instruction' manually.
 Parameters:
  - instruction     [in]  A pointer to a variable of type 'nmd_x86_instruction' describing the instruction to be formatted.
- - buffer          [out] A pointer to buffer that receives the string. The buffer's recommended size is 128 bytes.
+ - buffer          [out] A pointer to buffer that receives the string. It should have at least 'NMD_X86_FORMATTER_MAX_LENGTH' bytes.
  - runtime_address [in]  The instruction's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
  - flags           [in]  A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the function should format the instruction. If uncertain, use 'NMD_X86_FORMAT_FLAGS_DEFAULT'.
 */
 NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, char* buffer, uint64_t runtime_address, uint32_t flags);
 
+/*
+Formats an instruction. Returns the length of the string(excluding the null character), or zero if the instruction is invalid or 'buffer_size' is too small.
+Parameters:
+ - instruction     [in]  A pointer to a variable of type 'nmd_x86_instruction' describing the instruction to be formatted.
+ - buffer          [out] A pointer to buffer that receives the string.
+ - buffer_size     [in]  The buffer's size in bytes. If it's smaller than 'NMD_X86_FORMATTER_MAX_LENGTH' the string is formatted in a temporary buffer and then copied.
+ - runtime_address [in]  The instruction's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - flags           [in]  A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the function should format the instruction. If uncertain, use 'NMD_X86_FORMAT_FLAGS_DEFAULT'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_format_ex(const nmd_x86_instruction* instruction, char* buffer, size_t buffer_size, uint64_t runtime_address, uint32_t flags);
+
+/*
+Formats consecutive instructions into a single buffer, one line per instruction. Lines are separated by the '\n'(new line) character. Returns the number of instructions formatted.
+The function stops at the first invalid instruction or when the next line does not fit in the buffer. The text is null-terminated if there's room for the null character.
+Parameters:
+ - instructions     [in]      A pointer to an array of 'nmd_x86_instruction', usually filled by nmd_x86_decode_buffer().
+ - num_instructions [in]      The number of instructions in the array.
+ - runtime_address  [in]      The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - flags            [in]      A mask of 'NMD_X86_FORMAT_FLAGS_XXX'. If 'NMD_X86_FORMAT_FLAGS_ADDRESS' is set, each line starts with the instruction's runtime address.
+ - buffer           [out]     A pointer to a buffer that receives the lines.
+ - buffer_size      [in]      The buffer's size in bytes.
+ - lines            [out/opt] A pointer to an array of 'nmd_x86_text_line' with at least 'num_instructions' elements that receives the position of each line in 'buffer'. This parameter may be null.
+ - text_length      [out/opt] A pointer to a variable that receives the number of characters written to 'buffer'(excluding the null character). This parameter may be null.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_format_buffer(const nmd_x86_instruction* instructions, size_t num_instructions, uint64_t runtime_address, uint32_t flags, char* buffer, size_t buffer_size, nmd_x86_text_line* lines, size_t* text_length);
+
+/*
+Initializes a decode cache in a memory block provided by the caller. Returns the number of entries of the cache, or zero if the block is too small for one bucket.
+The number of entries is the largest power of two times 'NMD_X86_CACHE_BUCKET_SIZE' that fits in the block. Use 'NMD_X86_CACHE_MEMORY_SIZE()' to compute the block's size.
+Parameters:
+ - cache       [out] A pointer to a variable of type 'nmd_x86_cache'.
+ - memory      [in]  A pointer to the memory block. It must stay valid while the cache is used.
+ - memory_size [in]  The size of the memory block in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_cache_init(nmd_x86_cache* cache, void* memory, size_t memory_size);
+
+/*
+Same as nmd_x86_decode(), but the instruction is looked up in the cache first. Returns a pointer to the decoded instruction, or a null pointer if the instruction is invalid.
+Instructions are looked up by runtime address, mode and flags, and the cached instruction's bytes are compared with the bytes in 'buffer', so an instruction that
+was modified is decoded again even if it was not invalidated. The pointer is valid until the next call that modifies the cache.
+Parameters:
+ - cache           [in/out] A pointer to a cache initialized by nmd_x86_cache_init().
+ - buffer          [in]     A pointer to a buffer containing an encoded instruction.
+ - buffer_size     [in]     The buffer's size in bytes.
+ - runtime_address [in]     The instruction's runtime address. This is the key of the cache, so 'NMD_X86_INVALID_RUNTIME_ADDRESS' only caches a few instructions.
+ - mode            [in]     The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags           [in]     A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+*/
+NMD_ASSEMBLY_API const nmd_x86_instruction* nmd_x86_cache_decode(nmd_x86_cache* cache, const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags);
+
+/*
+Same as nmd_x86_cache_decode(), but returns the formatted instruction, which is also cached. Returns a null pointer if the instruction is invalid or its string
+does not fit in 'NMD_X86_CACHE_STRING_SIZE' bytes. The pointer is valid until the next call that modifies the cache.
+Parameters:
+ - cache           [in/out] A pointer to a cache initialized by nmd_x86_cache_init().
+ - buffer          [in]     A pointer to a buffer containing an encoded instruction.
+ - buffer_size     [in]     The buffer's size in bytes.
+ - runtime_address [in]     The instruction's runtime address.
+ - mode            [in]     The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - decoder_flags   [in]     A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+ - format_flags    [in]     A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the instruction is formatted.
+*/
+NMD_ASSEMBLY_API const char* nmd_x86_cache_format(nmd_x86_cache* cache, const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t decoder_flags, uint32_t format_flags);
+
+/*
+Removes every cached instruction that overlaps a range of memory(e.g. after the code was patched). Returns the number of instructions removed.
+Parameters:
+ - cache           [in/out] A pointer to a cache initialized by nmd_x86_cache_init().
+ - runtime_address [in]     The runtime address of the range's first byte.
+ - size            [in]     The range's size in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_cache_invalidate(nmd_x86_cache* cache, uint64_t runtime_address, size_t size);
+
+/* Removes every cached instruction and resets the cache's counters. */
+NMD_ASSEMBLY_API void nmd_x86_cache_clear(nmd_x86_cache* cache);
+
+/*
+Builds the control flow graph of the code reachable from one or more entry points. Returns the number of basic blocks, or zero if 'memory_size' is too small,
+'buffer_size' is not less than 4GiB or no entry point is in the buffer.
+Instructions are decoded recursively: conditional branches continue at both successors, unconditional branches at their target and returns, indirect branches
+and invalid instructions end the path. Targets of calls are traced as well(the block they start has the 'NMD_X86_CFG_BLOCK_FUNCTION' flag), but calls do not end blocks.
+Parameters:
+ - buffer           [in]  A pointer to a buffer containing encoded instructions.
+ - buffer_size      [in]  The buffer's size in bytes.
+ - runtime_address  [in]  The runtime address of the buffer's first byte. If it's 'NMD_X86_INVALID_RUNTIME_ADDRESS', offsets are used as runtime addresses.
+ - mode             [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - entry_points     [in]  A pointer to an array of runtime addresses where the code starts. Addresses outside the buffer are ignored.
+ - num_entry_points [in]  The number of elements in 'entry_points'.
+ - cfg              [out] A pointer to a variable of type 'nmd_x86_cfg' that receives the graph. Its arrays point to 'memory'.
+ - memory           [in]  A pointer to a memory block used by the function and to store the graph. 'NMD_X86_CFG_MEMORY_SIZE(buffer_size)' bytes are always enough.
+ - memory_size      [in]  The size of the memory block in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_cfg_build(const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, const uint64_t* entry_points, size_t num_entry_points, nmd_x86_cfg* cfg, void* memory, size_t memory_size);
+
 /*
 Returns the instruction's length if it's valid, zero otherwise.
 Parameters:
@@ -2462,11 +2965,140 @@ Parameters:
 */
 NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* buffer, size_t buffer_size, NMD_X86_MODE mode);
 
+/*
+Computes the length of consecutive instructions until the end of the buffer, an invalid instruction or the end of the output array is reached. Returns the number of lengths written to 'lengths'.
+Parameters:
+ - buffer      [in]      A pointer to a buffer containing encoded instructions.
+ - buffer_size [in]      The buffer's size in bytes.
+ - mode        [in]      The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - lengths     [out]     A pointer to an array that receives the length of each instruction.
+ - num_lengths [in]      The number of elements in 'lengths'.
+ - info        [out/opt] A pointer to a variable of type 'nmd_x86_buffer_info' that receives where and why the function stopped. This parameter may be null.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_ldisasm_buffer(const void* buffer, size_t buffer_size, NMD_X86_MODE mode, uint8_t* lengths, size_t num_lengths, nmd_x86_buffer_info* info);
+
+#ifdef NMD_ASSEMBLY_ENABLE_THREADS
+
+#ifndef NMD_ASSEMBLY_MAX_THREADS
+#define NMD_ASSEMBLY_MAX_THREADS 64
+#endif /* NMD_ASSEMBLY_MAX_THREADS */
+
+/*
+Computes the instruction boundaries of a buffer using multiple threads. The result is the same as a linear sweep that starts at the first byte and skips invalid instructions one byte at a time.
+Returns the number of valid instructions.
+Parameters:
+ - buffer      [in]  A pointer to a buffer containing encoded instructions.
+ - buffer_size [in]  The buffer's size in bytes.
+ - mode        [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - lengths     [out] A pointer to an array of 'buffer_size' elements. 'lengths[i]' receives the length of the instruction at offset 'i' if one starts there, zero otherwise.
+ - num_threads [in]  The number of threads to use, including the calling thread. It's clamped to 'NMD_ASSEMBLY_MAX_THREADS'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_ldisasm_parallel(const void* buffer, size_t buffer_size, NMD_X86_MODE mode, uint8_t* lengths, size_t num_threads);
+
+/*
+Decodes every instruction of a buffer using multiple threads. The instructions are written in address order. Returns the number of valid instructions, which may be greater than 'num_instructions'.
+Parameters:
+ - buffer           [in]  A pointer to a buffer containing encoded instructions.
+ - buffer_size      [in]  The buffer's size in bytes.
+ - mode             [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags            [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+ - lengths          [out] A pointer to an array of 'buffer_size' elements that receives the instruction boundaries. See nmd_x86_ldisasm_parallel().
+ - instructions     [out] A pointer to an array of 'nmd_x86_instruction' that receives the decoded instructions.
+ - num_instructions [in]  The number of elements in 'instructions'.
+ - num_threads      [in]  The number of threads to use, including the calling thread. It's clamped to 'NMD_ASSEMBLY_MAX_THREADS'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_decode_parallel(const void* buffer, size_t buffer_size, NMD_X86_MODE mode, uint32_t flags, uint8_t* lengths, nmd_x86_instruction* instructions, size_t num_instructions, size_t num_threads);
+
+/* The maximum number of bytes of a block of code queued by nmd_x86_pipeline_push(). Larger buffers are split in several blocks. It must be a multiple of eight. */
+#ifndef NMD_X86_PIPELINE_BLOCK_SIZE
+#define NMD_X86_PIPELINE_BLOCK_SIZE 256
+#endif /* NMD_X86_PIPELINE_BLOCK_SIZE */
+
+/* The number of bytes reserved for the pipeline's private state in the memory block. */
+#define NMD_X86_PIPELINE_STATE_SIZE 1024
+
+/* The size in bytes of a memory block for a pipeline whose rings hold 'capacity' items each('capacity' should be a power of two). */
+#define NMD_X86_PIPELINE_MEMORY_SIZE(capacity) ((capacity) * (NMD_X86_PIPELINE_BLOCK_SIZE + 16 + 24 + 8 + sizeof(nmd_x86_instruction) + sizeof(nmd_x86_pipeline_line)) + NMD_X86_PIPELINE_STATE_SIZE)
+
+typedef struct nmd_x86_pipeline_line
+{
+	uint64_t runtime_address;                   /* The instruction's runtime address. */
+	size_t length;                              /* The string's length in bytes, excluding the null terminator. */
+	char string[NMD_X86_FORMATTER_MAX_LENGTH]; /* The formatted instruction. */
+} nmd_x86_pipeline_line;
+
+typedef struct nmd_x86_pipeline
+{
+	void* state;     /* The pipeline's private state, stored in the memory block. */
+	size_t capacity; /* The number of items each ring holds. */
+} nmd_x86_pipeline;
+
+/*
+Starts a pipeline that splits blocks of code in instructions, decodes them and formats them on three threads(one per stage). The stages are connected by
+single-producer/single-consumer lock-free ring buffers stored in a memory block provided by the caller, no memory is allocated.
+Returns the capacity of each ring in items(a power of two), or zero if the block is too small for rings of 16 items or a thread can't be created.
+Use 'NMD_X86_PIPELINE_MEMORY_SIZE()' to compute the block's size. Idle stages yield their time slice, call nmd_x86_pipeline_stop() when the pipeline is not needed anymore.
+Parameters:
+ - pipeline      [out] A pointer to a variable of type 'nmd_x86_pipeline'.
+ - mode          [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - decoder_flags [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+ - format_flags  [in]  A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the instructions are formatted.
+ - memory        [in]  A pointer to the memory block. It must stay valid until nmd_x86_pipeline_stop() returns.
+ - memory_size   [in]  The size of the memory block in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_pipeline_start(nmd_x86_pipeline* pipeline, NMD_X86_MODE mode, uint32_t decoder_flags, uint32_t format_flags, void* memory, size_t memory_size);
+
+/*
+Queues a block of code. Returns the number of bytes queued, which is less than 'buffer_size' if the input ring is full. The bytes are copied, so 'buffer'
+can be reused after the call. Blocks whose runtime addresses are contiguous form a single instruction stream, so an instruction may be split between them.
+This function must not be called by more than one thread at a time.
+Parameters:
+ - pipeline        [in] A pointer to a pipeline started by nmd_x86_pipeline_start().
+ - buffer          [in] A pointer to a buffer containing encoded instructions.
+ - buffer_size     [in] The buffer's size in bytes.
+ - runtime_address [in] The runtime address of the buffer's first byte. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_pipeline_push(nmd_x86_pipeline* pipeline, const void* buffer, size_t buffer_size, uint64_t runtime_address);
+
+/*
+Copies up to 'num_lines' formatted instructions to 'lines' in the order they were pushed. Returns the number of lines copied, which is zero if no line is ready.
+Invalid instructions are skipped one byte at a time, so they produce no lines. This function must not be called by more than one thread at a time.
+Parameters:
+ - pipeline  [in]  A pointer to a pipeline started by nmd_x86_pipeline_start().
+ - lines     [out] A pointer to an array of 'nmd_x86_pipeline_line' that receives the lines.
+ - num_lines [in]  The number of elements in 'lines'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_pipeline_pop(nmd_x86_pipeline* pipeline, nmd_x86_pipeline_line* lines, size_t num_lines);
+
+/* Marks the end of the input. The stages process the queued bytes and exit, nmd_x86_pipeline_finished() returns true after the last line was popped. */
+NMD_ASSEMBLY_API void nmd_x86_pipeline_close(nmd_x86_pipeline* pipeline);
+
+/* Returns true if the pipeline was closed, every stage exited and every line was popped. */
+NMD_ASSEMBLY_API bool nmd_x86_pipeline_finished(nmd_x86_pipeline* pipeline);
+
+/* Stops the pipeline and waits for its threads to exit. The queued bytes and lines that were not popped are discarded. The memory block can be reused after the call. */
+NMD_ASSEMBLY_API void nmd_x86_pipeline_stop(nmd_x86_pipeline* pipeline);
+
+#endif /* NMD_ASSEMBLY_ENABLE_THREADS */
+
 #endif /* NMD_ASSEMBLY_H */
 
 
 #ifdef NMD_ASSEMBLY_IMPLEMENTATION
 
+#ifdef NMD_ASSEMBLY_ENABLE_LENGTH_DISASSEMBLER_SSE2
+#include <emmintrin.h>
+#endif /* NMD_ASSEMBLY_ENABLE_LENGTH_DISASSEMBLER_SSE2 */
+
+#ifdef NMD_ASSEMBLY_ENABLE_THREADS
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif /* _WIN32 */
+#endif /* NMD_ASSEMBLY_ENABLE_THREADS */
+
 /* Four high-order bits of an opcode to index a row of the opcode table */
 #define _NMD_R(b) ((b) >> 4)
 
@@ -2475,6 +3107,19 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* buffer, size_t buffer_size,
 
 #define _NMD_NUM_ELEMENTS(arr) (sizeof(arr) / sizeof((arr)[0]))
 
+#define _NMD_OFFSETOF(type, member) ((size_t)&(((type*)0)->member))
+
+/* Marks a function that must be inlined in every caller(e.g. so constant arguments remove dead branches). */
+#ifndef _NMD_FORCE_INLINE
+#if defined(_MSC_VER)
+#define _NMD_FORCE_INLINE static __forceinline
+#elif defined(__GNUC__) || defined(__clang__)
+#define _NMD_FORCE_INLINE static __inline__ __attribute__((always_inline))
+#else
+#define _NMD_FORCE_INLINE static
+#endif
+#endif /* _NMD_FORCE_INLINE */
+
 #ifndef _NMD_IS_UPPERCASE
 #define _NMD_IS_UPPERCASE(c) ((c) >= 'A' && (c) <= 'Z')
 #define _NMD_IS_LOWERCASE(c) ((c) >= 'a' && (c) <= 'z')
@@ -2497,6 +3142,55 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* buffer, size_t buffer_size,
 /* Make sure we can read a byte, read a byte, increment the buffer and decrement the buffer's size */
 #define _NMD_READ_BYTE(buffer_, buffer_size_, var_) { if ((buffer_size_) < sizeof(uint8_t)) { return false; } var_ = *((uint8_t*)(buffer_)); buffer_ = ((uint8_t*)(buffer_)) + sizeof(uint8_t); (buffer_size_) -= sizeof(uint8_t); }
 
+/* Immediate size of an opcode. Stored in the low-order bits of '_nmd_x86_opcode_info.flags'. */
+enum _NMD_X86_OPCODE_IMM
+{
+	_NMD_X86_OPCODE_IMM_NONE = 0,
+	_NMD_X86_OPCODE_IMM8,
+	_NMD_X86_OPCODE_IMM16,
+	_NMD_X86_OPCODE_IMM24,     /* imm16 + imm8(enter). */
+	_NMD_X86_OPCODE_IMM32,
+	_NMD_X86_OPCODE_IMMZ,      /* imm16 or imm32 depending on the operand size. */
+	_NMD_X86_OPCODE_IMMV,      /* imm16, imm32 or imm64 depending on the operand size and REX.W(mov r,imm). */
+	_NMD_X86_OPCODE_IMM_MOFFS, /* moffs16, moffs32 or moffs64 depending on the address size. */
+	_NMD_X86_OPCODE_IMM_FAR,   /* ptr16:16 or ptr16:32. */
+};
+
+enum _NMD_X86_OPCODE_FLAGS
+{
+	_NMD_X86_OPCODE_IMM_MASK    = 0x0f,       /* Mask of a member of '_NMD_X86_OPCODE_IMM'. */
+	_NMD_X86_OPCODE_MODRM       = (1 << 4),   /* The opcode has a ModR/M byte. */
+	_NMD_X86_OPCODE_INVALID_REG = (1 << 5),   /* The opcode is invalid if ModR/M.mod is 0b11. */
+	_NMD_X86_OPCODE_INVALID_MEM = (1 << 6),   /* The opcode is invalid if ModR/M.mod is not 0b11. */
+	_NMD_X86_OPCODE_EXTENSION   = (1 << 7),   /* The properties depend on ModR/M.reg. 'id' is the index of a row in '_nmd_x86_opcode_extensions'. */
+
+	/* The properties cannot be described by the tables(e.g. they depend on prefixes), the full decoder must be used instead. */
+	_NMD_X86_OPCODE_FALLBACK    = (_NMD_X86_OPCODE_INVALID_REG | _NMD_X86_OPCODE_INVALID_MEM)
+};
+
+/* Properties of an opcode used by the table-driven decoder. The tables are generated by 'generate_opcode_tables.c'. */
+typedef struct _nmd_x86_opcode_info
+{
+	uint16_t id;   /* The instruction's id. A member of 'NMD_X86_INSTRUCTION'. */
+	uint8_t group; /* The instruction's group. A member of 'NMD_GROUP'. */
+	uint8_t flags; /* A mask of '_NMD_X86_OPCODE_FLAGS'. */
+} _nmd_x86_opcode_info;
+
+/* Classes of a prefix byte used by the table-driven length disassembler. See '_nmd_x86_prefix_classes'. */
+enum _NMD_X86_PREFIX_CLASS
+{
+	_NMD_X86_PREFIX_CLASS_LEGACY       = (1 << 0), /* A legacy prefix. */
+	_NMD_X86_PREFIX_CLASS_OPERAND_SIZE = (1 << 1), /* 0x66 */
+	_NMD_X86_PREFIX_CLASS_ADDRESS_SIZE = (1 << 2), /* 0x67 */
+	_NMD_X86_PREFIX_CLASS_LOCK         = (1 << 3), /* 0xF0 */
+	_NMD_X86_PREFIX_CLASS_REX          = (1 << 4), /* A REX prefix. Only a prefix in 64-bit mode. */
+	_NMD_X86_PREFIX_CLASS_REX_W        = (1 << 5)  /* A REX prefix with the W bit set. */
+};
+
+/* The number of bits of a hash used to index the assembler's perfect hash tables('_nmd_x86_asm_mnemonic_hash_table' and '_nmd_x86_asm_reg_hash_table'). */
+#define _NMD_X86_ASM_MNEMONIC_HASH_BITS 9
+#define _NMD_X86_ASM_REG_HASH_BITS 8
+
 NMD_ASSEMBLY_API const char* const _nmd_reg8[] = { "al", "cl", "dl", "bl", "ah", "ch", "dh", "bh" };
 NMD_ASSEMBLY_API const char* const _nmd_reg8_x64[] = { "al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil" };
 NMD_ASSEMBLY_API const char* const _nmd_reg16[] = { "ax", "cx", "dx", "bx", "sp", "bp", "si", "di" };
@@ -2510,6 +3204,10 @@ NMD_ASSEMBLY_API const char* const _nmd_segment_reg[] = { "es", "cs", "ss", "ds"
 
 NMD_ASSEMBLY_API const char* const _nmd_condition_suffixes[] = { "o", "no", "b", "nb", "z", "nz", "be", "a", "s", "ns", "p", "np", "l", "ge", "le", "g" };
 
+NMD_ASSEMBLY_API const char _nmd_hex_digits[2][16] = { { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' }, { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' } };
+NMD_ASSEMBLY_API const char _nmd_decimal_digit_pairs[] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+NMD_ASSEMBLY_API const uint64_t _nmd_powers_of_ten[19] = { 0xA, 0x64, 0x3E8, 0x2710, 0x186A0, 0xF4240, 0x989680, 0x5F5E100, 0x3B9ACA00, 0x2540BE400, 0x174876E800, 0xE8D4A51000, 0x9184E72A000, 0x5AF3107A4000, 0x38D7EA4C68000, 0x2386F26FC10000, 0x16345785D8A0000, 0xDE0B6B3A7640000, 0x8AC7230489E80000 }; /* 10^1 to 10^19 */
+
 NMD_ASSEMBLY_API const char* const _nmd_op1_opcode_map_mnemonics[] = { "add", "adc", "and", "xor", "or", "sbb", "sub", "cmp" };
 NMD_ASSEMBLY_API const char* const _nmd_opcode_extensions_grp1[] = { "add", "or", "adc", "sbb", "and", "sub", "xor", "cmp" };
 NMD_ASSEMBLY_API const char* const _nmd_opcode_extensions_grp2[] = { "rol", "ror", "rcl", "rcr", "shl", "shr", "shl", "sar" };
@@ -2696,6 +3394,49 @@ NMD_ASSEMBLY_API size_t _nmd_get_bit_index(uint32_t mask)
 	return i;
 }
 
+/* Sign-extends the first 'size' bytes of 'value'. */
+NMD_ASSEMBLY_API int64_t _nmd_sign_extend(uint64_t value, size_t size)
+{
+	switch (size)
+	{
+	case 1:  return (int8_t)value;
+	case 2:  return (int16_t)value;
+	case 4:  return (int32_t)value;
+	default: return (int64_t)value;
+	}
+}
+
+/* Returns the general-purpose register selected when a REX prefix extends 'reg'(e.g. 'r9d' for 'ecx'). Other registers are returned unchanged. */
+NMD_ASSEMBLY_API uint8_t _nmd_extend_gpr(uint8_t reg)
+{
+	if (reg >= NMD_X86_REG_AL && reg <= NMD_X86_REG_BH)
+		return (uint8_t)(NMD_X86_REG_R8B + reg % 8);
+	else if (reg >= NMD_X86_REG_AX && reg <= NMD_X86_REG_DI)
+		return (uint8_t)(NMD_X86_REG_R8W + reg % 8);
+	else if (reg >= NMD_X86_REG_EAX && reg <= NMD_X86_REG_EDI)
+		return (uint8_t)(NMD_X86_REG_R8D + reg % 8);
+	else if (reg >= NMD_X86_REG_RAX && reg <= NMD_X86_REG_RDI)
+		return (uint8_t)(NMD_X86_REG_R8 + reg % 8);
+	return reg;
+}
+
+/* Returns the size in bytes of an immediate of type 'imm'(a member of '_NMD_X86_OPCODE_IMM'). */
+NMD_ASSEMBLY_API size_t _nmd_x86_get_imm_size(uint8_t imm, NMD_X86_MODE mode, bool operand_size_prefix, bool address_size_prefix, bool rex_w_prefix)
+{
+	switch (imm)
+	{
+	case _NMD_X86_OPCODE_IMM8:      return 1;
+	case _NMD_X86_OPCODE_IMM16:     return 2;
+	case _NMD_X86_OPCODE_IMM24:     return 3;
+	case _NMD_X86_OPCODE_IMM32:     return 4;
+	case _NMD_X86_OPCODE_IMMZ:      return (mode == NMD_X86_MODE_16) == operand_size_prefix ? 4 : 2;
+	case _NMD_X86_OPCODE_IMMV:      return rex_w_prefix ? 8 : (operand_size_prefix || mode == NMD_X86_MODE_16 ? 2 : 4);
+	case _NMD_X86_OPCODE_IMM_MOFFS: return mode == NMD_X86_MODE_64 ? (address_size_prefix ? 4 : 8) : (address_size_prefix ? 2 : 4);
+	case _NMD_X86_OPCODE_IMM_FAR:   return operand_size_prefix ? 4 : 6;
+	default:                        return 0;
+	}
+}
+
 NMD_ASSEMBLY_API size_t _nmd_assembly_get_num_digits_hex(uint64_t n)
 {
 	if (n == 0)
@@ -2721,6 +3462,604 @@ NMD_ASSEMBLY_API size_t _nmd_assembly_get_num_digits(uint64_t n)
 }
 
 
+/* This file is generated by 'generate_opcode_tables.c' from the decoder's logic. Do not edit it manually. */
+
+
+
+/* Properties of the opcodes of the one byte opcode map. Indexed by [mode >> 2][opcode]. See '_nmd_x86_opcode_info'. */
+NMD_ASSEMBLY_API const _nmd_x86_opcode_info _nmd_x86_op1_info[3][256] = {
+	{ /* NMD_X86_MODE_16 */
+		/* 00 */ {   1,0x00,0x10}, {   1,0x00,0x10}, {   1,0x00,0x10}, {   1,0x00,0x10}, {   1,0x00,0x01}, {   1,0x00,0x05}, {  31,0x00,0x00}, { 697,0x00,0x00},
+		/* 08 */ {   2,0x00,0x10}, {   2,0x00,0x10}, {   2,0x00,0x10}, {   2,0x00,0x10}, {   2,0x00,0x01}, {   2,0x00,0x05}, {  31,0x00,0x00}, {   0,0x00,0x60},
+		/* 10 */ {   3,0x00,0x10}, {   3,0x00,0x10}, {   3,0x00,0x10}, {   3,0x00,0x10}, {   3,0x00,0x01}, {   3,0x00,0x05}, {  31,0x00,0x00}, { 697,0x00,0x00},
+		/* 18 */ {   4,0x00,0x10}, {   4,0x00,0x10}, {   4,0x00,0x10}, {   4,0x00,0x10}, {   4,0x00,0x01}, {   4,0x00,0x05}, {  31,0x00,0x00}, { 697,0x00,0x00},
+		/* 20 */ {   5,0x00,0x10}, {   5,0x00,0x10}, {   5,0x00,0x10}, {   5,0x00,0x10}, {   5,0x00,0x01}, {   5,0x00,0x05}, {   0,0x00,0x60}, { 432,0x00,0x00},
+		/* 28 */ {   6,0x00,0x10}, {   6,0x00,0x10}, {   6,0x00,0x10}, {   6,0x00,0x10}, {   6,0x00,0x01}, {   6,0x00,0x05}, {   0,0x00,0x60}, { 448,0x00,0x00},
+		/* 30 */ {   7,0x00,0x10}, {   7,0x00,0x10}, {   7,0x00,0x10}, {   7,0x00,0x10}, {   7,0x00,0x01}, {   7,0x00,0x05}, {   0,0x00,0x60}, {  15,0x00,0x00},
+		/* 38 */ {   8,0x00,0x10}, {   8,0x00,0x10}, {   8,0x00,0x10}, {   8,0x00,0x10}, {   8,0x00,0x01}, {   8,0x00,0x05}, {   0,0x00,0x60}, {  66,0x00,0x00},
+		/* 40 */ {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00},
+		/* 48 */ {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00},
+		/* 50 */ {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00},
+		/* 58 */ { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00},
+		/* 60 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 180,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 68 */ {  31,0x00,0x05}, {  22,0x00,0x15}, {  31,0x00,0x01}, {  22,0x00,0x11}, { 529,0x00,0x00}, {   0,0x00,0x60}, { 657,0x00,0x00}, {   0,0x00,0x60},
+		/* 70 */ {  32,0xa1,0x01}, {  33,0xa1,0x01}, {  34,0xa1,0x01}, {  35,0xa1,0x01}, {  36,0xa1,0x01}, {  37,0xa1,0x01}, {  38,0xa1,0x01}, {  39,0xa1,0x01},
+		/* 78 */ {  40,0xa1,0x01}, {  41,0xa1,0x01}, {  42,0xa1,0x01}, {  43,0xa1,0x01}, {  44,0xa1,0x01}, {  45,0xa1,0x01}, {  46,0xa1,0x01}, {  47,0xa1,0x01},
+		/* 80 */ {   0,0x00,0x90}, {   1,0x00,0x90}, {   0,0x00,0x90}, {   0,0x00,0x90}, {  17,0x00,0x10}, {  17,0x00,0x10}, {1316,0x00,0x10}, {1316,0x00,0x10},
+		/* 88 */ { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, {   2,0x00,0x90}, { 599,0x00,0x30}, {   3,0x00,0x90}, {   4,0x00,0x90},
+		/* 90 */ {   0,0x00,0x60}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00},
+		/* 98 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {  27,0x42,0x08}, {1312,0x00,0x00}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 727,0x00,0x00}, { 597,0x00,0x00},
+		/* A0 */ { 625,0x00,0x07}, { 625,0x00,0x07}, { 625,0x00,0x07}, { 625,0x00,0x07}, { 642,0x00,0x00}, {   0,0x00,0x60}, { 175,0x00,0x00}, {   0,0x00,0x60},
+		/* A8 */ {  17,0x00,0x01}, {  17,0x00,0x05}, { 741,0x00,0x00}, {   0,0x00,0x60}, { 602,0x00,0x00}, {   0,0x00,0x60}, { 730,0x00,0x00}, {   0,0x00,0x60},
+		/* B0 */ { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01},
+		/* B8 */ { 625,0x00,0x02}, { 625,0x00,0x02}, { 625,0x00,0x02}, { 625,0x00,0x02}, { 625,0x00,0x02}, { 625,0x00,0x02}, { 625,0x00,0x02}, { 625,0x00,0x02},
+		/* C0 */ {   5,0x00,0x90}, {   5,0x00,0x90}, {  70,0x04,0x02}, {  70,0x04,0x00}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   6,0x00,0x90}, {   7,0x00,0x90},
+		/* C8 */ {  71,0x00,0x03}, { 600,0x00,0x00}, { 606,0x04,0x02}, { 606,0x04,0x00}, { 533,0x08,0x00}, { 532,0x08,0x01}, { 534,0x08,0x00}, {   0,0x00,0x60},
+		/* D0 */ {   8,0x00,0x90}, {   8,0x00,0x90}, {   8,0x00,0x90}, {   8,0x00,0x90}, { 144,0x00,0x01}, { 145,0x00,0x01}, { 146,0x00,0x00}, { 147,0x00,0x00},
+		/* D8 */ {   9,0x00,0x90}, {  10,0x00,0x90}, {  11,0x00,0x90}, {  12,0x00,0x90}, {  13,0x00,0x90}, {  14,0x00,0x90}, {   0,0x00,0x60}, {  15,0x00,0x90},
+		/* E0 */ { 148,0xa0,0x01}, { 149,0xa0,0x01}, { 150,0xa0,0x01}, { 151,0xa1,0x01}, { 528,0x00,0x01}, { 528,0x00,0x01}, { 656,0x00,0x01}, { 656,0x00,0x01},
+		/* E8 */ {  27,0xc2,0x05}, {  29,0xc1,0x05}, {  30,0x41,0x08}, {  29,0xc1,0x01}, { 528,0x00,0x00}, { 528,0x00,0x00}, { 656,0x00,0x00}, { 656,0x00,0x00},
+		/* F0 */ {   0,0x00,0x60}, { 131,0x08,0x00}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 134,0x10,0x00}, { 135,0x00,0x00}, {  16,0x00,0x90}, {  17,0x00,0x90},
+		/* F8 */ { 138,0x00,0x00}, { 139,0x00,0x00}, { 140,0x00,0x00}, { 141,0x00,0x00}, { 142,0x00,0x00}, { 143,0x00,0x00}, {  18,0x00,0x90}, {  19,0x00,0x90}
+	},
+	{ /* NMD_X86_MODE_32 */
+		/* 00 */ {   1,0x00,0x10}, {   1,0x00,0x10}, {   1,0x00,0x10}, {   1,0x00,0x10}, {   1,0x00,0x01}, {   1,0x00,0x05}, {  31,0x00,0x00}, { 697,0x00,0x00},
+		/* 08 */ {   2,0x00,0x10}, {   2,0x00,0x10}, {   2,0x00,0x10}, {   2,0x00,0x10}, {   2,0x00,0x01}, {   2,0x00,0x05}, {  31,0x00,0x00}, {   0,0x00,0x60},
+		/* 10 */ {   3,0x00,0x10}, {   3,0x00,0x10}, {   3,0x00,0x10}, {   3,0x00,0x10}, {   3,0x00,0x01}, {   3,0x00,0x05}, {  31,0x00,0x00}, { 697,0x00,0x00},
+		/* 18 */ {   4,0x00,0x10}, {   4,0x00,0x10}, {   4,0x00,0x10}, {   4,0x00,0x10}, {   4,0x00,0x01}, {   4,0x00,0x05}, {  31,0x00,0x00}, { 697,0x00,0x00},
+		/* 20 */ {   5,0x00,0x10}, {   5,0x00,0x10}, {   5,0x00,0x10}, {   5,0x00,0x10}, {   5,0x00,0x01}, {   5,0x00,0x05}, {   0,0x00,0x60}, { 432,0x00,0x00},
+		/* 28 */ {   6,0x00,0x10}, {   6,0x00,0x10}, {   6,0x00,0x10}, {   6,0x00,0x10}, {   6,0x00,0x01}, {   6,0x00,0x05}, {   0,0x00,0x60}, { 448,0x00,0x00},
+		/* 30 */ {   7,0x00,0x10}, {   7,0x00,0x10}, {   7,0x00,0x10}, {   7,0x00,0x10}, {   7,0x00,0x01}, {   7,0x00,0x05}, {   0,0x00,0x60}, {  15,0x00,0x00},
+		/* 38 */ {   8,0x00,0x10}, {   8,0x00,0x10}, {   8,0x00,0x10}, {   8,0x00,0x10}, {   8,0x00,0x01}, {   8,0x00,0x05}, {   0,0x00,0x60}, {  66,0x00,0x00},
+		/* 40 */ {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00}, {  25,0x00,0x00},
+		/* 48 */ {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00}, {  26,0x00,0x00},
+		/* 50 */ {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00},
+		/* 58 */ { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00},
+		/* 60 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 180,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 68 */ {  31,0x00,0x05}, {  22,0x00,0x15}, {  31,0x00,0x01}, {  22,0x00,0x11}, { 529,0x00,0x00}, {   0,0x00,0x60}, { 657,0x00,0x00}, {   0,0x00,0x60},
+		/* 70 */ {  32,0xa1,0x01}, {  33,0xa1,0x01}, {  34,0xa1,0x01}, {  35,0xa1,0x01}, {  36,0xa1,0x01}, {  37,0xa1,0x01}, {  38,0xa1,0x01}, {  39,0xa1,0x01},
+		/* 78 */ {  40,0xa1,0x01}, {  41,0xa1,0x01}, {  42,0xa1,0x01}, {  43,0xa1,0x01}, {  44,0xa1,0x01}, {  45,0xa1,0x01}, {  46,0xa1,0x01}, {  47,0xa1,0x01},
+		/* 80 */ {   0,0x00,0x90}, {   1,0x00,0x90}, {   0,0x00,0x90}, {   0,0x00,0x90}, {  17,0x00,0x10}, {  17,0x00,0x10}, {1316,0x00,0x10}, {1316,0x00,0x10},
+		/* 88 */ { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, {   2,0x00,0x90}, { 599,0x00,0x30}, {   3,0x00,0x90}, {   4,0x00,0x90},
+		/* 90 */ {   0,0x00,0x60}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00},
+		/* 98 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {  27,0x42,0x08}, {1312,0x00,0x00}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 727,0x00,0x00}, { 597,0x00,0x00},
+		/* A0 */ { 625,0x00,0x07}, { 625,0x00,0x07}, { 625,0x00,0x07}, { 625,0x00,0x07}, { 642,0x00,0x00}, {   0,0x00,0x60}, { 175,0x00,0x00}, {   0,0x00,0x60},
+		/* A8 */ {  17,0x00,0x01}, {  17,0x00,0x05}, { 741,0x00,0x00}, {   0,0x00,0x60}, { 602,0x00,0x00}, {   0,0x00,0x60}, { 730,0x00,0x00}, {   0,0x00,0x60},
+		/* B0 */ { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01},
+		/* B8 */ { 625,0x00,0x05}, { 625,0x00,0x05}, { 625,0x00,0x05}, { 625,0x00,0x05}, { 625,0x00,0x05}, { 625,0x00,0x05}, { 625,0x00,0x05}, { 625,0x00,0x05},
+		/* C0 */ {   5,0x00,0x90}, {   5,0x00,0x90}, {  70,0x04,0x02}, {  70,0x04,0x00}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   6,0x00,0x90}, {   7,0x00,0x90},
+		/* C8 */ {  71,0x00,0x03}, { 600,0x00,0x00}, { 606,0x04,0x02}, { 606,0x04,0x00}, { 533,0x08,0x00}, { 532,0x08,0x01}, { 534,0x08,0x00}, {   0,0x00,0x60},
+		/* D0 */ {   8,0x00,0x90}, {   8,0x00,0x90}, {   8,0x00,0x90}, {   8,0x00,0x90}, { 144,0x00,0x01}, { 145,0x00,0x01}, { 146,0x00,0x00}, { 147,0x00,0x00},
+		/* D8 */ {   9,0x00,0x90}, {  10,0x00,0x90}, {  11,0x00,0x90}, {  12,0x00,0x90}, {  13,0x00,0x90}, {  14,0x00,0x90}, {   0,0x00,0x60}, {  15,0x00,0x90},
+		/* E0 */ { 148,0xa0,0x01}, { 149,0xa0,0x01}, { 150,0xa0,0x01}, { 151,0xa1,0x01}, { 528,0x00,0x01}, { 528,0x00,0x01}, { 656,0x00,0x01}, { 656,0x00,0x01},
+		/* E8 */ {  27,0xc2,0x05}, {  29,0xc1,0x05}, {  30,0x41,0x08}, {  29,0xc1,0x01}, { 528,0x00,0x00}, { 528,0x00,0x00}, { 656,0x00,0x00}, { 656,0x00,0x00},
+		/* F0 */ {   0,0x00,0x60}, { 131,0x08,0x00}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 134,0x10,0x00}, { 135,0x00,0x00}, {  16,0x00,0x90}, {  17,0x00,0x90},
+		/* F8 */ { 138,0x00,0x00}, { 139,0x00,0x00}, { 140,0x00,0x00}, { 141,0x00,0x00}, { 142,0x00,0x00}, { 143,0x00,0x00}, {  18,0x00,0x90}, {  19,0x00,0x90}
+	},
+	{ /* NMD_X86_MODE_64 */
+		/* 00 */ {   1,0x00,0x10}, {   1,0x00,0x10}, {   1,0x00,0x10}, {   1,0x00,0x10}, {   1,0x00,0x01}, {   1,0x00,0x05}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 08 */ {   2,0x00,0x10}, {   2,0x00,0x10}, {   2,0x00,0x10}, {   2,0x00,0x10}, {   2,0x00,0x01}, {   2,0x00,0x05}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 10 */ {   3,0x00,0x10}, {   3,0x00,0x10}, {   3,0x00,0x10}, {   3,0x00,0x10}, {   3,0x00,0x01}, {   3,0x00,0x05}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 18 */ {   4,0x00,0x10}, {   4,0x00,0x10}, {   4,0x00,0x10}, {   4,0x00,0x10}, {   4,0x00,0x01}, {   4,0x00,0x05}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 20 */ {   5,0x00,0x10}, {   5,0x00,0x10}, {   5,0x00,0x10}, {   5,0x00,0x10}, {   5,0x00,0x01}, {   5,0x00,0x05}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 28 */ {   6,0x00,0x10}, {   6,0x00,0x10}, {   6,0x00,0x10}, {   6,0x00,0x10}, {   6,0x00,0x01}, {   6,0x00,0x05}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 30 */ {   7,0x00,0x10}, {   7,0x00,0x10}, {   7,0x00,0x10}, {   7,0x00,0x10}, {   7,0x00,0x01}, {   7,0x00,0x05}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 38 */ {   8,0x00,0x10}, {   8,0x00,0x10}, {   8,0x00,0x10}, {   8,0x00,0x10}, {   8,0x00,0x01}, {   8,0x00,0x05}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 40 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 48 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 50 */ {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00}, {  31,0x00,0x00},
+		/* 58 */ { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00}, { 697,0x00,0x00},
+		/* 60 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 650,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 68 */ {  31,0x00,0x05}, {  22,0x00,0x15}, {  31,0x00,0x01}, {  22,0x00,0x11}, { 529,0x00,0x00}, {   0,0x00,0x60}, { 657,0x00,0x00}, {   0,0x00,0x60},
+		/* 70 */ {  32,0xa1,0x01}, {  33,0xa1,0x01}, {  34,0xa1,0x01}, {  35,0xa1,0x01}, {  36,0xa1,0x01}, {  37,0xa1,0x01}, {  38,0xa1,0x01}, {  39,0xa1,0x01},
+		/* 78 */ {  40,0xa1,0x01}, {  41,0xa1,0x01}, {  42,0xa1,0x01}, {  43,0xa1,0x01}, {  44,0xa1,0x01}, {  45,0xa1,0x01}, {  46,0xa1,0x01}, {  47,0xa1,0x01},
+		/* 80 */ {   0,0x00,0x90}, {   1,0x00,0x90}, {   0,0x00,0x60}, {   0,0x00,0x90}, {  17,0x00,0x10}, {  17,0x00,0x10}, {1316,0x00,0x10}, {1316,0x00,0x10},
+		/* 88 */ { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, {   2,0x00,0x90}, { 599,0x80,0x30}, {   3,0x00,0x90}, {   4,0x00,0x90},
+		/* 90 */ {   0,0x00,0x60}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00}, {1316,0x00,0x00},
+		/* 98 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {1312,0x00,0x00}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 727,0x00,0x00}, { 597,0x00,0x00},
+		/* A0 */ { 625,0x00,0x07}, { 625,0x00,0x07}, { 625,0x00,0x07}, { 625,0x00,0x07}, { 642,0x00,0x00}, {   0,0x00,0x60}, { 175,0x00,0x00}, {   0,0x00,0x60},
+		/* A8 */ {  17,0x00,0x01}, {  17,0x00,0x05}, { 741,0x00,0x00}, {   0,0x00,0x60}, { 602,0x00,0x00}, {   0,0x00,0x60}, { 730,0x00,0x00}, {   0,0x00,0x60},
+		/* B0 */ { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01}, { 625,0x00,0x01},
+		/* B8 */ { 625,0x00,0x06}, { 625,0x00,0x06}, { 625,0x00,0x06}, { 625,0x00,0x06}, { 625,0x00,0x06}, { 625,0x00,0x06}, { 625,0x00,0x06}, { 625,0x00,0x06},
+		/* C0 */ {   5,0x00,0x90}, {   5,0x00,0x90}, {  70,0x04,0x02}, {  70,0x04,0x00}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   6,0x00,0x90}, {   7,0x00,0x90},
+		/* C8 */ {  71,0x00,0x03}, { 600,0x00,0x00}, { 606,0x04,0x02}, { 606,0x04,0x00}, { 533,0x08,0x00}, { 532,0x08,0x01}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* D0 */ {   8,0x00,0x90}, {   8,0x00,0x90}, {   8,0x00,0x90}, {   8,0x00,0x90}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 147,0x00,0x00},
+		/* D8 */ {   9,0x00,0x90}, {  10,0x00,0x90}, {  11,0x00,0x90}, {  12,0x00,0x90}, {  13,0x00,0x90}, {  14,0x00,0x90}, {   0,0x00,0x60}, {  15,0x00,0x90},
+		/* E0 */ { 148,0xa0,0x01}, { 149,0xa0,0x01}, { 150,0xa0,0x01}, { 151,0xa1,0x01}, { 528,0x00,0x01}, { 528,0x00,0x01}, { 656,0x00,0x01}, { 656,0x00,0x01},
+		/* E8 */ {  27,0xc2,0x05}, {  29,0xc1,0x05}, {   0,0x00,0x60}, {  29,0xc1,0x01}, { 528,0x00,0x00}, { 528,0x00,0x00}, { 656,0x00,0x00}, { 656,0x00,0x00},
+		/* F0 */ {   0,0x00,0x60}, { 131,0x08,0x00}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 134,0x10,0x00}, { 135,0x00,0x00}, {  16,0x00,0x90}, {  17,0x00,0x90},
+		/* F8 */ { 138,0x00,0x00}, { 139,0x00,0x00}, { 140,0x00,0x00}, { 141,0x00,0x00}, { 142,0x00,0x00}, { 143,0x00,0x00}, {  18,0x00,0x90}, {  19,0x00,0x90}
+	}
+};
+
+/* Properties of the opcodes of the two byte(0F) opcode map. Indexed by [mode >> 2][opcode]. See '_nmd_x86_opcode_info'. */
+NMD_ASSEMBLY_API const _nmd_x86_opcode_info _nmd_x86_op2_info[3][256] = {
+	{ /* NMD_X86_MODE_16 */
+		/* 00 */ {  20,0x00,0x90}, {   0,0x00,0x60}, { 194,0x00,0x10}, { 195,0x00,0x10}, {   0,0x00,0x60}, { 197,0x00,0x00}, { 198,0x10,0x00}, { 199,0x00,0x00},
+		/* 08 */ { 200,0x10,0x00}, { 201,0x10,0x00}, {   0,0x00,0x60}, { 203,0x00,0x00}, {   0,0x00,0x60}, {   0,0x00,0x10}, { 205,0x00,0x00}, {   0,0x00,0x60},
+		/* 10 */ { 988,0x00,0x10}, { 989,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 18 */ {  21,0x00,0x90}, { 655,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 655,0x00,0x10}, { 655,0x00,0x10}, {  22,0x00,0x90}, { 655,0x00,0x10},
+		/* 20 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 28 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 30 */ { 206,0x10,0x00}, { 207,0x00,0x00}, { 208,0x10,0x00}, { 209,0x10,0x00}, { 210,0x00,0x00}, { 211,0x10,0x00}, {   0,0x00,0x60}, { 213,0x10,0x00},
+		/* 38 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 40 */ { 214,0x00,0x10}, { 215,0x00,0x10}, { 216,0x00,0x10}, { 217,0x00,0x10}, { 218,0x00,0x10}, { 219,0x00,0x10}, { 220,0x00,0x10}, { 221,0x00,0x10},
+		/* 48 */ { 222,0x00,0x10}, { 223,0x00,0x10}, { 224,0x00,0x10}, { 225,0x00,0x10}, { 226,0x00,0x10}, { 227,0x00,0x10}, { 228,0x00,0x10}, { 229,0x00,0x10},
+		/* 50 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 58 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 60 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 68 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 70 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 616,0x00,0x00},
+		/* 78 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 80 */ {  32,0xa1,0x05}, {  33,0xa1,0x05}, {  34,0xa1,0x05}, {  35,0xa1,0x05}, {  36,0xa1,0x05}, {  37,0xa1,0x05}, {  38,0xa1,0x05}, {  39,0xa1,0x05},
+		/* 88 */ {  40,0xa1,0x05}, {  41,0xa1,0x05}, {  42,0xa1,0x05}, {  43,0xa1,0x05}, {  44,0xa1,0x05}, {  45,0xa1,0x05}, {  46,0xa1,0x05}, {  47,0xa1,0x05},
+		/* 90 */ {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10},
+		/* 98 */ {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10},
+		/* A0 */ {  31,0x00,0x00}, { 697,0x00,0x00}, { 274,0x00,0x00}, { 275,0x00,0x10}, { 276,0x00,0x11}, { 277,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* A8 */ {  31,0x00,0x00}, { 697,0x00,0x00}, { 726,0x00,0x00}, { 252,0x00,0x10}, { 737,0x00,0x11}, { 737,0x00,0x10}, {   0,0x00,0x60}, {  22,0x00,0x10},
+		/* B0 */ { 388,0x00,0x10}, { 388,0x00,0x10}, {   0,0x00,0x60}, { 247,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 653,0x00,0x10}, { 653,0x00,0x10},
+		/* B8 */ {   0,0x00,0x60}, { 755,0x00,0x10}, {  23,0x00,0x90}, { 251,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 649,0x00,0x10}, { 649,0x00,0x10},
+		/* C0 */ { 607,0x00,0x10}, { 607,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 374,0x00,0x11}, {   0,0x00,0x60}, {   0,0x00,0x11}, {  24,0x00,0x90},
+		/* C8 */ { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00},
+		/* D0 */ {   0,0x00,0x60}, { 327,0x00,0x10}, { 328,0x00,0x10}, { 329,0x00,0x10}, { 330,0x00,0x10}, { 331,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* D8 */ { 334,0x00,0x10}, { 335,0x00,0x10}, { 336,0x00,0x10}, { 337,0x00,0x10}, { 338,0x00,0x10}, { 339,0x00,0x10}, { 340,0x00,0x10}, { 341,0x00,0x10},
+		/* E0 */ {   0,0x00,0x60}, { 343,0x00,0x10}, { 344,0x00,0x10}, { 345,0x00,0x10}, { 346,0x00,0x10}, { 347,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* E8 */ { 350,0x00,0x10}, { 351,0x00,0x10}, { 352,0x00,0x10}, { 353,0x00,0x10}, { 354,0x00,0x10}, { 355,0x00,0x10}, { 356,0x00,0x10}, { 357,0x00,0x10},
+		/* F0 */ {   0,0x00,0x60}, { 359,0x00,0x10}, { 360,0x00,0x10}, { 361,0x00,0x10}, { 362,0x00,0x10}, { 363,0x00,0x10}, { 364,0x00,0x10}, {   0,0x00,0x60},
+		/* F8 */ { 366,0x00,0x10}, { 367,0x00,0x10}, { 368,0x00,0x10}, { 369,0x00,0x10}, { 370,0x00,0x10}, { 371,0x00,0x10}, { 372,0x00,0x10}, {1505,0x00,0x10}
+	},
+	{ /* NMD_X86_MODE_32 */
+		/* 00 */ {  20,0x00,0x90}, {   0,0x00,0x60}, { 194,0x00,0x10}, { 195,0x00,0x10}, {   0,0x00,0x60}, { 197,0x00,0x00}, { 198,0x10,0x00}, { 199,0x00,0x00},
+		/* 08 */ { 200,0x10,0x00}, { 201,0x10,0x00}, {   0,0x00,0x60}, { 203,0x00,0x00}, {   0,0x00,0x60}, {   0,0x00,0x10}, { 205,0x00,0x00}, {   0,0x00,0x60},
+		/* 10 */ { 988,0x00,0x10}, { 989,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 18 */ {  21,0x00,0x90}, { 655,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 655,0x00,0x10}, { 655,0x00,0x10}, {  22,0x00,0x90}, { 655,0x00,0x10},
+		/* 20 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 28 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 30 */ { 206,0x10,0x00}, { 207,0x00,0x00}, { 208,0x10,0x00}, { 209,0x10,0x00}, { 210,0x00,0x00}, { 211,0x10,0x00}, {   0,0x00,0x60}, { 213,0x10,0x00},
+		/* 38 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 40 */ { 214,0x00,0x10}, { 215,0x00,0x10}, { 216,0x00,0x10}, { 217,0x00,0x10}, { 218,0x00,0x10}, { 219,0x00,0x10}, { 220,0x00,0x10}, { 221,0x00,0x10},
+		/* 48 */ { 222,0x00,0x10}, { 223,0x00,0x10}, { 224,0x00,0x10}, { 225,0x00,0x10}, { 226,0x00,0x10}, { 227,0x00,0x10}, { 228,0x00,0x10}, { 229,0x00,0x10},
+		/* 50 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 58 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 60 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 68 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 70 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 616,0x00,0x00},
+		/* 78 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 80 */ {  32,0xa1,0x05}, {  33,0xa1,0x05}, {  34,0xa1,0x05}, {  35,0xa1,0x05}, {  36,0xa1,0x05}, {  37,0xa1,0x05}, {  38,0xa1,0x05}, {  39,0xa1,0x05},
+		/* 88 */ {  40,0xa1,0x05}, {  41,0xa1,0x05}, {  42,0xa1,0x05}, {  43,0xa1,0x05}, {  44,0xa1,0x05}, {  45,0xa1,0x05}, {  46,0xa1,0x05}, {  47,0xa1,0x05},
+		/* 90 */ {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10},
+		/* 98 */ {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10},
+		/* A0 */ {  31,0x00,0x00}, { 697,0x00,0x00}, { 274,0x00,0x00}, { 275,0x00,0x10}, { 276,0x00,0x11}, { 277,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* A8 */ {  31,0x00,0x00}, { 697,0x00,0x00}, { 726,0x00,0x00}, { 252,0x00,0x10}, { 737,0x00,0x11}, { 737,0x00,0x10}, {   0,0x00,0x60}, {  22,0x00,0x10},
+		/* B0 */ { 388,0x00,0x10}, { 388,0x00,0x10}, {   0,0x00,0x60}, { 247,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 653,0x00,0x10}, { 653,0x00,0x10},
+		/* B8 */ {   0,0x00,0x60}, { 755,0x00,0x10}, {  23,0x00,0x90}, { 251,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 649,0x00,0x10}, { 649,0x00,0x10},
+		/* C0 */ { 607,0x00,0x10}, { 607,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 374,0x00,0x11}, {   0,0x00,0x60}, {   0,0x00,0x11}, {  24,0x00,0x90},
+		/* C8 */ { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00},
+		/* D0 */ {   0,0x00,0x60}, { 327,0x00,0x10}, { 328,0x00,0x10}, { 329,0x00,0x10}, { 330,0x00,0x10}, { 331,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* D8 */ { 334,0x00,0x10}, { 335,0x00,0x10}, { 336,0x00,0x10}, { 337,0x00,0x10}, { 338,0x00,0x10}, { 339,0x00,0x10}, { 340,0x00,0x10}, { 341,0x00,0x10},
+		/* E0 */ {   0,0x00,0x60}, { 343,0x00,0x10}, { 344,0x00,0x10}, { 345,0x00,0x10}, { 346,0x00,0x10}, { 347,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* E8 */ { 350,0x00,0x10}, { 351,0x00,0x10}, { 352,0x00,0x10}, { 353,0x00,0x10}, { 354,0x00,0x10}, { 355,0x00,0x10}, { 356,0x00,0x10}, { 357,0x00,0x10},
+		/* F0 */ {   0,0x00,0x60}, { 359,0x00,0x10}, { 360,0x00,0x10}, { 361,0x00,0x10}, { 362,0x00,0x10}, { 363,0x00,0x10}, { 364,0x00,0x10}, {   0,0x00,0x60},
+		/* F8 */ { 366,0x00,0x10}, { 367,0x00,0x10}, { 368,0x00,0x10}, { 369,0x00,0x10}, { 370,0x00,0x10}, { 371,0x00,0x10}, { 372,0x00,0x10}, {1505,0x00,0x10}
+	},
+	{ /* NMD_X86_MODE_64 */
+		/* 00 */ {  20,0x00,0x90}, {   0,0x00,0x60}, { 194,0x00,0x10}, { 195,0x00,0x10}, {   0,0x00,0x60}, { 197,0x00,0x00}, { 198,0x10,0x00}, { 199,0x00,0x00},
+		/* 08 */ { 200,0x10,0x00}, { 201,0x10,0x00}, {   0,0x00,0x60}, { 203,0x00,0x00}, {   0,0x00,0x60}, {   0,0x00,0x10}, { 205,0x00,0x00}, {   0,0x00,0x60},
+		/* 10 */ { 988,0x00,0x10}, { 989,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 18 */ {  21,0x00,0x90}, { 655,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 655,0x00,0x10}, { 655,0x00,0x10}, {  22,0x00,0x90}, { 655,0x00,0x10},
+		/* 20 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 28 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 30 */ { 206,0x10,0x00}, { 207,0x00,0x00}, { 208,0x10,0x00}, { 209,0x10,0x00}, { 210,0x00,0x00}, { 211,0x10,0x00}, {   0,0x00,0x60}, { 213,0x10,0x00},
+		/* 38 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 40 */ { 214,0x00,0x10}, { 215,0x00,0x10}, { 216,0x00,0x10}, { 217,0x00,0x10}, { 218,0x00,0x10}, { 219,0x00,0x10}, { 220,0x00,0x10}, { 221,0x00,0x10},
+		/* 48 */ { 222,0x00,0x10}, { 223,0x00,0x10}, { 224,0x00,0x10}, { 225,0x00,0x10}, { 226,0x00,0x10}, { 227,0x00,0x10}, { 228,0x00,0x10}, { 229,0x00,0x10},
+		/* 50 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 58 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 60 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 68 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 70 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 616,0x00,0x00},
+		/* 78 */ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* 80 */ {  32,0xa1,0x04}, {  33,0xa1,0x04}, {  34,0xa1,0x04}, {  35,0xa1,0x04}, {  36,0xa1,0x04}, {  37,0xa1,0x04}, {  38,0xa1,0x04}, {  39,0xa1,0x04},
+		/* 88 */ {  40,0xa1,0x04}, {  41,0xa1,0x04}, {  42,0xa1,0x04}, {  43,0xa1,0x04}, {  44,0xa1,0x04}, {  45,0xa1,0x04}, {  46,0xa1,0x04}, {  47,0xa1,0x04},
+		/* 90 */ {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10},
+		/* 98 */ {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10}, {   0,0x00,0x10},
+		/* A0 */ {  31,0x00,0x00}, { 697,0x00,0x00}, { 274,0x00,0x00}, { 275,0x00,0x10}, { 276,0x00,0x11}, { 277,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* A8 */ {  31,0x00,0x00}, { 697,0x00,0x00}, { 726,0x00,0x00}, { 252,0x00,0x10}, { 737,0x00,0x11}, { 737,0x00,0x10}, {   0,0x00,0x60}, {  22,0x00,0x10},
+		/* B0 */ { 388,0x00,0x10}, { 388,0x00,0x10}, {   0,0x00,0x60}, { 247,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 653,0x00,0x10}, { 653,0x00,0x10},
+		/* B8 */ {   0,0x00,0x60}, { 755,0x00,0x10}, {  23,0x00,0x90}, { 251,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 649,0x00,0x10}, { 649,0x00,0x10},
+		/* C0 */ { 607,0x00,0x10}, { 607,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 374,0x00,0x11}, {   0,0x00,0x60}, {   0,0x00,0x11}, {   0,0x00,0x60},
+		/* C8 */ { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00}, { 365,0x00,0x00},
+		/* D0 */ {   0,0x00,0x60}, { 327,0x00,0x10}, { 328,0x00,0x10}, { 329,0x00,0x10}, { 330,0x00,0x10}, { 331,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* D8 */ { 334,0x00,0x10}, { 335,0x00,0x10}, { 336,0x00,0x10}, { 337,0x00,0x10}, { 338,0x00,0x10}, { 339,0x00,0x10}, { 340,0x00,0x10}, { 341,0x00,0x10},
+		/* E0 */ {   0,0x00,0x60}, { 343,0x00,0x10}, { 344,0x00,0x10}, { 345,0x00,0x10}, { 346,0x00,0x10}, { 347,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60},
+		/* E8 */ { 350,0x00,0x10}, { 351,0x00,0x10}, { 352,0x00,0x10}, { 353,0x00,0x10}, { 354,0x00,0x10}, { 355,0x00,0x10}, { 356,0x00,0x10}, { 357,0x00,0x10},
+		/* F0 */ {   0,0x00,0x60}, { 359,0x00,0x10}, { 360,0x00,0x10}, { 361,0x00,0x10}, { 362,0x00,0x10}, { 363,0x00,0x10}, { 364,0x00,0x10}, {   0,0x00,0x60},
+		/* F8 */ { 366,0x00,0x10}, { 367,0x00,0x10}, { 368,0x00,0x10}, { 369,0x00,0x10}, { 370,0x00,0x10}, { 371,0x00,0x10}, { 372,0x00,0x10}, {1505,0x00,0x10}
+	}
+};
+
+/* Properties of the opcodes whose properties depend on ModR/M.reg. Indexed by [_nmd_x86_opcode_info.id][ModR/M.reg]. */
+NMD_ASSEMBLY_API const _nmd_x86_opcode_info _nmd_x86_opcode_extensions[25][8] = {
+	{ {   1,0x00,0x11}, {   2,0x00,0x11}, {   3,0x00,0x11}, {   4,0x00,0x11}, {   5,0x00,0x11}, {   6,0x00,0x11}, {   7,0x00,0x11}, {   8,0x00,0x11} },
+	{ {   1,0x00,0x15}, {   2,0x00,0x15}, {   3,0x00,0x15}, {   4,0x00,0x15}, {   5,0x00,0x15}, {   6,0x00,0x15}, {   7,0x00,0x15}, {   8,0x00,0x15} },
+	{ { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60} },
+	{ { 625,0x00,0x10}, {   0,0x00,0x60}, { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, { 625,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60} },
+	{ { 697,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60} },
+	{ {   9,0x00,0x11}, {  10,0x00,0x11}, {  11,0x00,0x11}, {  12,0x00,0x11}, {  13,0x00,0x11}, {  14,0x00,0x11}, {  15,0x00,0x11}, {  16,0x00,0x11} },
+	{ { 625,0x00,0x11}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60} },
+	{ { 625,0x00,0x15}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60} },
+	{ {   9,0x00,0x10}, {  10,0x00,0x10}, {  11,0x00,0x10}, {  12,0x00,0x10}, {  13,0x00,0x10}, {  14,0x00,0x10}, {  15,0x00,0x10}, {  16,0x00,0x10} },
+	{ {   0,0x00,0x60}, {  49,0x00,0x10}, {   0,0x00,0x60}, {  51,0x00,0x10}, {   0,0x00,0x60}, {  53,0x00,0x10}, {   0,0x00,0x60}, {  55,0x00,0x10} },
+	{ {  56,0x00,0x10}, { 746,0x00,0x50}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60} },
+	{ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 100,0x00,0x30}, {   0,0x00,0x60}, { 102,0x00,0x30}, { 103,0x00,0x30} },
+	{ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 123,0x00,0x50}, {  59,0x00,0x30} },
+	{ {  48,0x00,0x10}, {  49,0x00,0x10}, {  50,0x00,0x10}, {  51,0x00,0x10}, {  52,0x00,0x10}, {   0,0x00,0x60}, {  54,0x00,0x10}, {   0,0x00,0x60} },
+	{ {   0,0x00,0x60}, {   0,0x00,0x60}, {  58,0x00,0x10}, {  59,0x00,0x10}, {   0,0x00,0x60}, { 753,0x00,0x50}, { 517,0x00,0x30}, { 514,0x00,0x30} },
+	{ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 111,0x00,0x30} },
+	{ {  17,0x00,0x11}, {  18,0x00,0x11}, {  19,0x00,0x10}, {  20,0x00,0x10}, {  21,0x00,0x10}, {  22,0x00,0x10}, {  23,0x00,0x10}, {  24,0x00,0x10} },
+	{ {  17,0x00,0x15}, {  18,0x00,0x10}, {  19,0x00,0x10}, {  20,0x00,0x10}, {  21,0x00,0x10}, {  22,0x00,0x10}, {  23,0x00,0x10}, {  24,0x00,0x10} },
+	{ {  25,0x00,0x10}, {  26,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60} },
+	{ {  25,0x00,0x10}, {  26,0x00,0x10}, {  27,0x42,0x10}, {  28,0x42,0x30}, {  29,0x41,0x10}, {  30,0x41,0x30}, {  31,0x00,0x10}, {   0,0x00,0x60} },
+	{ { 152,0x00,0x10}, { 153,0x00,0x10}, { 154,0x00,0x10}, { 155,0x00,0x10}, { 156,0x00,0x10}, { 157,0x00,0x10}, {   0,0x00,0x60}, {   0,0x00,0x60} },
+	{ { 705,0x00,0x10}, { 706,0x00,0x10}, { 707,0x00,0x10}, { 708,0x00,0x10}, { 655,0x00,0x10}, { 655,0x00,0x10}, { 655,0x00,0x10}, { 655,0x00,0x10} },
+	{ { 655,0x00,0x10}, { 655,0x00,0x10}, { 655,0x00,0x10}, { 655,0x00,0x10}, { 655,0x00,0x10}, { 655,0x00,0x10}, { 655,0x00,0x10}, {   0,0x00,0x60} },
+	{ {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, { 250,0x00,0x11}, { 252,0x00,0x11}, { 247,0x00,0x11}, { 251,0x00,0x11} },
+	{ {   0,0x00,0x60}, { 447,0x00,0x30}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60}, {   0,0x00,0x60} }
+};
+
+/* Flags('_NMD_X86_OPCODE_FLAGS') of the opcodes of the one byte opcode map used by the table-driven length disassembler. Indexed by [mode >> 2][opcode]. */
+NMD_ASSEMBLY_API const uint8_t _nmd_x86_ldisasm_op1_flags[3][256] = {
+	{ /* NMD_X86_MODE_16 */
+		/* 00 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x00, 0x00, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x00, 0x60,
+		/* 10 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x00, 0x00, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x00, 0x00,
+		/* 20 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x00, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x00,
+		/* 30 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x00, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x00,
+		/* 40 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* 50 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* 60 */ 0x00, 0x00, 0x30, 0x10, 0x60, 0x60, 0x60, 0x60, 0x05, 0x15, 0x01, 0x11, 0x00, 0x00, 0x00, 0x00,
+		/* 70 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+		/* 80 */ 0x11, 0x15, 0x11, 0x11, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x30, 0x60, 0x60,
+		/* 90 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* A0 */ 0x07, 0x07, 0x07, 0x07, 0x00, 0x00, 0x00, 0x00, 0x01, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* B0 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02,
+		/* C0 */ 0x11, 0x11, 0x02, 0x00, 0x60, 0x60, 0x60, 0x60, 0x03, 0x00, 0x02, 0x00, 0x00, 0x01, 0x00, 0x00,
+		/* D0 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x01, 0x00, 0x00, 0x10, 0x60, 0x60, 0x60, 0x10, 0x60, 0x60, 0x60,
+		/* E0 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x05, 0x05, 0x08, 0x01, 0x00, 0x00, 0x00, 0x00,
+		/* F0 */ 0x60, 0x00, 0x60, 0x60, 0x00, 0x00, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x60
+	},
+	{ /* NMD_X86_MODE_32 */
+		/* 00 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x00, 0x00, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x00, 0x60,
+		/* 10 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x00, 0x00, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x00, 0x00,
+		/* 20 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x00, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x00,
+		/* 30 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x00, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x00,
+		/* 40 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* 50 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* 60 */ 0x00, 0x00, 0x30, 0x10, 0x60, 0x60, 0x60, 0x60, 0x05, 0x15, 0x01, 0x11, 0x00, 0x00, 0x00, 0x00,
+		/* 70 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+		/* 80 */ 0x11, 0x15, 0x11, 0x11, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x30, 0x60, 0x60,
+		/* 90 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* A0 */ 0x07, 0x07, 0x07, 0x07, 0x00, 0x00, 0x00, 0x00, 0x01, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* B0 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05,
+		/* C0 */ 0x11, 0x11, 0x02, 0x00, 0x60, 0x60, 0x60, 0x60, 0x03, 0x00, 0x02, 0x00, 0x00, 0x01, 0x00, 0x00,
+		/* D0 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x01, 0x00, 0x00, 0x10, 0x60, 0x60, 0x60, 0x10, 0x60, 0x60, 0x60,
+		/* E0 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x05, 0x05, 0x08, 0x01, 0x00, 0x00, 0x00, 0x00,
+		/* F0 */ 0x60, 0x00, 0x60, 0x60, 0x00, 0x00, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x60
+	},
+	{ /* NMD_X86_MODE_64 */
+		/* 00 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x60,
+		/* 10 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x60,
+		/* 20 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x60,
+		/* 30 */ 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x01, 0x05, 0x60, 0x60,
+		/* 40 */ 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 50 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* 60 */ 0x60, 0x60, 0x60, 0x10, 0x60, 0x60, 0x60, 0x60, 0x05, 0x15, 0x01, 0x11, 0x00, 0x00, 0x00, 0x00,
+		/* 70 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+		/* 80 */ 0x11, 0x15, 0x60, 0x11, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x30, 0x60, 0x60,
+		/* 90 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* A0 */ 0x07, 0x07, 0x07, 0x07, 0x00, 0x00, 0x00, 0x00, 0x01, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* B0 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* C0 */ 0x11, 0x11, 0x02, 0x00, 0x60, 0x60, 0x60, 0x60, 0x03, 0x00, 0x02, 0x00, 0x00, 0x01, 0x60, 0x00,
+		/* D0 */ 0x10, 0x10, 0x10, 0x10, 0x60, 0x60, 0x60, 0x00, 0x10, 0x60, 0x60, 0x60, 0x10, 0x60, 0x60, 0x60,
+		/* E0 */ 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x05, 0x05, 0x60, 0x01, 0x00, 0x00, 0x00, 0x00,
+		/* F0 */ 0x60, 0x00, 0x60, 0x60, 0x00, 0x00, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x60
+	}
+};
+
+/* Flags('_NMD_X86_OPCODE_FLAGS') of the opcodes of the two byte(0F) opcode map used by the table-driven length disassembler. Indexed by [mode >> 2][opcode]. */
+NMD_ASSEMBLY_API const uint8_t _nmd_x86_ldisasm_op2_flags[3][256] = {
+	{ /* NMD_X86_MODE_16 */
+		/* 00 */ 0x60, 0x60, 0x10, 0x10, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x00, 0x60, 0x10, 0x00, 0x60,
+		/* 10 */ 0x10, 0x10, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x10, 0x10, 0x30, 0x30, 0x10, 0x10, 0x10, 0x10,
+		/* 20 */ 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x10, 0x60, 0x10, 0x10, 0x60, 0x60,
+		/* 30 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x00, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 40 */ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* 50 */ 0x60, 0x10, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x10, 0x10, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10,
+		/* 60 */ 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 70 */ 0x11, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x00, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 80 */ 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05,
+		/* 90 */ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* A0 */ 0x00, 0x00, 0x00, 0x10, 0x11, 0x10, 0x60, 0x60, 0x00, 0x00, 0x00, 0x10, 0x11, 0x10, 0x60, 0x10,
+		/* B0 */ 0x10, 0x10, 0x60, 0x10, 0x60, 0x60, 0x10, 0x10, 0x60, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* C0 */ 0x10, 0x10, 0x11, 0x60, 0x11, 0x60, 0x11, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* D0 */ 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* E0 */ 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* F0 */ 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+	},
+	{ /* NMD_X86_MODE_32 */
+		/* 00 */ 0x60, 0x60, 0x10, 0x10, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x00, 0x60, 0x10, 0x00, 0x60,
+		/* 10 */ 0x10, 0x10, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x10, 0x10, 0x30, 0x30, 0x10, 0x10, 0x10, 0x10,
+		/* 20 */ 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x10, 0x60, 0x10, 0x10, 0x60, 0x60,
+		/* 30 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x00, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 40 */ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* 50 */ 0x60, 0x10, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x10, 0x10, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10,
+		/* 60 */ 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 70 */ 0x11, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x00, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 80 */ 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05, 0x05,
+		/* 90 */ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* A0 */ 0x00, 0x00, 0x00, 0x10, 0x11, 0x10, 0x60, 0x60, 0x00, 0x00, 0x00, 0x10, 0x11, 0x10, 0x60, 0x10,
+		/* B0 */ 0x10, 0x10, 0x60, 0x10, 0x60, 0x60, 0x10, 0x10, 0x60, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* C0 */ 0x10, 0x10, 0x11, 0x60, 0x11, 0x60, 0x11, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* D0 */ 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* E0 */ 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* F0 */ 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+	},
+	{ /* NMD_X86_MODE_64 */
+		/* 00 */ 0x60, 0x60, 0x10, 0x10, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x00, 0x60, 0x10, 0x00, 0x60,
+		/* 10 */ 0x10, 0x10, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x10, 0x10, 0x30, 0x30, 0x10, 0x10, 0x10, 0x10,
+		/* 20 */ 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x10, 0x60, 0x10, 0x10, 0x60, 0x60,
+		/* 30 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x00, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 40 */ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* 50 */ 0x60, 0x10, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x10, 0x10, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10,
+		/* 60 */ 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 70 */ 0x11, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x00, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60, 0x60,
+		/* 80 */ 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,
+		/* 90 */ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* A0 */ 0x00, 0x00, 0x00, 0x10, 0x11, 0x10, 0x60, 0x60, 0x00, 0x00, 0x00, 0x10, 0x11, 0x10, 0x60, 0x10,
+		/* B0 */ 0x10, 0x10, 0x60, 0x10, 0x60, 0x60, 0x10, 0x10, 0x60, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* C0 */ 0x10, 0x10, 0x11, 0x60, 0x11, 0x60, 0x11, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		/* D0 */ 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* E0 */ 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		/* F0 */ 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x60, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+	}
+};
+
+/* Length-prefixed mnemonics of the instructions as printed by the formatter, followed by 16 zero bytes so that '_nmd_append_mnemonic' can always copy 16 bytes. */
+NMD_ASSEMBLY_API const char _nmd_x86_mnemonics[2727] =
+	"\000" "\003" "add" "\002" "or" "\003" "adc" "\003" "sbb" "\003" "and" "\003" "sub" "\003" "xor"
+	"\003" "cmp" "\003" "rol" "\003" "ror" "\003" "rcl" "\003" "rcr" "\003" "shl" "\003" "shr" "\003" "sar"
+	"\004" "test" "\003" "not" "\003" "neg" "\003" "mul" "\004" "imul" "\003" "div" "\004" "idiv" "\003" "inc"
+	"\003" "dec" "\004" "call" "\003" "jmp" "\004" "push" "\002" "jo" "\003" "jno" "\002" "jb" "\003" "jnb"
+	"\002" "jz" "\003" "jnz" "\003" "jbe" "\002" "ja" "\002" "js" "\003" "jns" "\002" "jp" "\003" "jnp"
+	"\002" "jl" "\003" "jge" "\003" "jle" "\002" "jg" "\004" "fadd" "\004" "fcom" "\004" "fdiv" "\003" "fld"
+	"\003" "fst" "\004" "fstp" "\006" "fldenv" "\005" "fldcw" "\007" "fnstenv" "\006" "fnstcw" "\004" "fchs" "\004" "fabs"
+	"\003" "aas" "\004" "ftst" "\004" "fxam" "\003" "ret" "\005" "enter" "\004" "fld1" "\006" "fldl2t" "\006" "fldl2e"
+	"\005" "fldpi" "\006" "fldlg2" "\006" "fldln2" "\004" "fldz" "\004" "fnop" "\005" "f2xm1" "\005" "fyl2x" "\005" "fptan"
+	"\006" "fpatan" "\007" "fxtract" "\006" "fprem1" "\007" "fdecstp" "\007" "fincstp" "\005" "fprem" "\007" "fyl2xp1" "\005" "fsqrt"
+	"\007" "fsincos" "\007" "frndint" "\006" "fscale" "\004" "fsin" "\004" "fcos" "\005" "fiadd" "\005" "fimul" "\005" "ficom"
+	"\006" "ficomp" "\005" "fisub" "\006" "fisubr" "\005" "fidiv" "\006" "fidivr" "\004" "fild" "\006" "fisttp" "\004" "fist"
+	"\005" "fistp" "\004" "fbld" "\005" "fbstp" "\006" "fnclex" "\005" "fcomi" "\006" "movapd" "\005" "bndcn" "\004" "int1"
+	"\005" "lzcnt" "\010" "addsubpd" "\003" "hlt" "\003" "cmc" "\010" "addsubps" "\003" "clc" "\003" "stc" "\003" "cli"
+	"\003" "sti" "\003" "cld" "\003" "std" "\003" "aam" "\003" "aad" "\004" "salc" "\004" "xlat" "\006" "loopne"
+	"\005" "loope" "\004" "loop" "\004" "sldt" "\003" "str" "\004" "lldt" "\003" "ltr" "\004" "verr" "\004" "verw"
+	"\004" "sgdt" "\004" "sidt" "\004" "lgdt" "\004" "lidt" "\004" "smsw" "\010" "rstorssp" "\004" "lmsw" "\006" "invlpg"
+	"\005" "enclv" "\006" "vmcall" "\010" "vmlaunch" "\010" "vmresume" "\004" "clac" "\004" "stac" "\003" "cbw" "\005" "cmpsb"
+	"\005" "cmpsd" "\005" "encls" "\006" "xgetbv" "\006" "xsetbv" "\004" "arpl" "\006" "vmfunc" "\004" "xend" "\005" "xtest"
+	"\005" "enclu" "\005" "vmrun" "\007" "vmmcall" "\006" "vmload" "\006" "vmsave" "\004" "stgi" "\004" "clgi" "\006" "skinit"
+	"\007" "invlpga" "\003" "lar" "\003" "lsl" "\007" "syscall" "\004" "clts" "\006" "sysret" "\004" "invd" "\006" "wbinvd"
+	"\003" "ud2" "\005" "femms" "\005" "wrmsr" "\005" "rdtsc" "\005" "rdmsr" "\005" "rdpmc" "\010" "sysenter" "\007" "sysexit"
+	"\006" "getsec" "\005" "cmovo" "\006" "cmovno" "\005" "cmovb" "\006" "cmovnb" "\005" "cmovz" "\006" "cmovnz" "\006" "cmovbe"
+	"\005" "cmova" "\005" "cmovs" "\006" "cmovns" "\005" "cmovp" "\006" "cmovnp" "\005" "cmovl" "\006" "cmovge" "\006" "cmovle"
+	"\005" "cmovg" "\003" "lss" "\003" "btr" "\003" "lfs" "\003" "lgs" "\002" "bt" "\003" "btc" "\003" "bts"
+	"\005" "cpuid" "\004" "shld" "\005" "psrlw" "\005" "psrld" "\005" "psrlq" "\005" "paddq" "\006" "pmullw" "\010" "pmovmskb"
+	"\007" "psubusb" "\007" "psubusw" "\006" "pminub" "\004" "pand" "\007" "paddusb" "\007" "paddusw" "\006" "pmaxub" "\005" "pandn"
+	"\005" "pavgb" "\005" "psraw" "\005" "psrad" "\005" "pavgw" "\007" "pmulhuw" "\006" "pmulhw" "\003" "cqo" "\006" "psubsb"
+	"\006" "psubsw" "\006" "pminsw" "\003" "por" "\006" "paddsb" "\006" "paddsw" "\006" "pmaxsw" "\004" "pxor" "\005" "lddqu"
+	"\005" "psllq" "\007" "pmuludq" "\007" "pmaddwd" "\006" "psadbw" "\005" "bswap" "\005" "psubb" "\005" "psubw" "\005" "psubd"
+	"\005" "psubq" "\005" "paddb" "\005" "paddw" "\005" "paddd" "\006" "movnti" "\006" "pinsrw" "\006" "pextrw" "\007" "cmpxchg"
+	"\007" "pcmpeqb" "\007" "pcmpeqw" "\007" "pcmpeqd" "\010" "movmskps" "\006" "sqrtps" "\007" "rsqrtps" "\005" "rcpps" "\005" "andps"
+	"\006" "andnps" "\004" "orps" "\005" "xorps" "\005" "addps" "\005" "mulps" "\010" "cvtps2pd" "\010" "cvtdq2ps" "\005" "subps"
+	"\005" "minps" "\005" "divps" "\005" "maxps" "\010" "movmskpd" "\006" "sqrtpd" "\006" "bndldx" "\006" "bndstx" "\005" "andpd"
+	"\006" "andnpd" "\004" "orpd" "\005" "xorpd" "\005" "addpd" "\005" "mulpd" "\010" "cvtpd2ps" "\010" "cvtps2dq" "\005" "subpd"
+	"\005" "minpd" "\005" "divpd" "\005" "maxpd" "\006" "bndmov" "\006" "sqrtss" "\007" "rsqrtss" "\005" "rcpss" "\011" "cmpxchg8b"
+	"\003" "daa" "\003" "cwd" "\004" "insd" "\005" "addss" "\005" "mulss" "\010" "cvtss2sd" "\011" "cvttps2dq" "\005" "subss"
+	"\005" "minss" "\005" "divss" "\005" "maxss" "\005" "bndcl" "\006" "sqrtsd" "\005" "bndcu" "\005" "bndmk" "\003" "das"
+	"\004" "cwde" "\004" "insw" "\005" "addsd" "\005" "mulsd" "\010" "cvtsd2ss" "\006" "fcomip" "\005" "subsd" "\005" "minsd"
+	"\005" "divsd" "\005" "maxsd" "\011" "punpcklbw" "\011" "punpcklwd" "\011" "punpckldq" "\010" "packsswb" "\007" "pcmpgtb" "\007" "pcmpgtw"
+	"\007" "pcmpgtd" "\010" "packuswb" "\011" "punpckhbw" "\011" "punpckhwd" "\011" "punpckhdq" "\010" "packssdw" "\012" "punpcklqdq" "\012" "punpckhqdq"
+	"\005" "tzcnt" "\003" "cdq" "\004" "cdqe" "\010" "cvtdq2pd" "\010" "cvtpd2dq" "\010" "cvtsi2sd" "\010" "cvtsi2ss" "\011" "cvttpd2dq"
+	"\005" "extrq" "\006" "fcompp" "\005" "ffree" "\006" "fnstsw" "\006" "ffreep" "\006" "frstor" "\006" "fnsave" "\006" "movaps"
+	"\006" "haddpd" "\006" "haddps" "\006" "hsubpd" "\006" "hsubps" "\002" "in" "\004" "insb" "\007" "insertq" "\003" "int"
+	"\004" "int3" "\004" "into" "\004" "iret" "\005" "iretd" "\005" "iretq" "\004" "lahf" "\003" "lea" "\005" "leave"
+	"\005" "lodsb" "\005" "lodsd" "\004" "retf" "\004" "xadd" "\003" "bsr" "\012" "maskmovdqu" "\010" "cvtpd2pi" "\010" "cvtpi2pd"
+	"\010" "cvtpi2ps" "\010" "cvtps2pi" "\011" "cvttpd2pi" "\011" "cvttps2pi" "\004" "emms" "\010" "maskmovq" "\004" "movd" "\007" "movdq2q"
+	"\006" "movntq" "\007" "movq2dq" "\006" "pshufw" "\003" "mov" "\006" "movdqa" "\006" "movdqu" "\007" "movntdq" "\007" "movntpd"
+	"\005" "movsb" "\005" "movsd" "\005" "movsx" "\006" "movsxd" "\005" "movzx" "\003" "nop" "\003" "out" "\005" "outsb"
+	"\005" "outsd" "\005" "outsw" "\005" "pause" "\003" "pop" "\004" "popa" "\005" "popad" "\006" "popcnt" "\004" "popf"
+	"\005" "popfd" "\005" "popfq" "\006" "pshufd" "\007" "pshufhw" "\007" "pshuflw" "\006" "psrldq" "\005" "pusha" "\006" "pushad"
+	"\005" "pushf" "\006" "pushfd" "\006" "pushfq" "\006" "rdrand" "\006" "rdseed" "\003" "rsm" "\004" "sahf" "\005" "scasb"
+	"\005" "scasd" "\004" "shrd" "\005" "stosb" "\005" "stosd" "\007" "fstpnce" "\004" "fxch" "\006" "swapgs" "\003" "bsf"
+	"\007" "fucomip" "\007" "fucompp" "\006" "fucomp" "\005" "fucom" "\003" "ud1" "\007" "vmclear" "\007" "vmwrite" "\005" "vmxon"
+	"\005" "fwait" "\006" "xabort" "\006" "xbegin" "\004" "xchg" "\005" "cmpss" "\005" "cmpps" "\005" "cmppd" "\003" "ud0"
+	"\007" "endbr32" "\007" "endbr64";
+
+/* Offsets in '_nmd_x86_mnemonics' of the mnemonics of the instructions. Indexed by 'NMD_X86_INSTRUCTION'. */
+NMD_ASSEMBLY_API const uint16_t _nmd_x86_mnemonic_offsets[NMD_X86_INSTRUCTION_ENDBR64 + 1] = {
+	/*    0 */    0,    1,    5,    8,   12,   16,   20,   24,   28,   32,   36,   40,   44,   48,   52,    0,
+	/*   16 */   56,   60,   60,   65,   69,   73,   77,   82,   86,   91,   95,   99,   99,  104,  104,  108,
+	/*   32 */  113,  116,  120,  123,  127,  130,  134,  138,  141,  144,  148,  151,  155,  158,  162,  166,
+	/*   48 */  169,    0,  174,    0,    0,    0,  179,    0,  184,    0,  188,  192,  197,  204,  210,  218,
+	/*   64 */  225,  230,  235,    0,  239,  244,  249,  253,  259,  264,  271,  278,  284,  291,  298,  303,
+	/*   80 */  308,  314,  320,  326,  333,  341,  348,  356,  364,  370,  378,  384,  392,  400,  407,  412,
+	/*   96 */  417,  423,  429,  435,  442,  448,  455,  461,    0,    0,    0,    0,  468,  473,  480,  485,
+	/*  112 */  491,    0,  496,    0,    0,    0,    0,    0,  502,    0,    0,  509,    0,  515,  522,    0,
+	/*  128 */    0,    0,    0,  528,  533,  539,  548,  552,  556,    0,  565,  569,  573,  577,  581,  585,
+	/*  144 */  589,  593,  597,  602,  607,  614,  620,    0,  625,  630,  634,  639,  643,  648,  653,  658,
+	/*  160 */  663,  668,  673,  678,  687,  692,  699,  705,  712,  721,    0,    0,  730,  735,  740,  744,
+	/*  176 */  750,  756,  762,  769,  776,    0,  781,  788,  793,  799,  805,  811,  819,  826,  833,  838,
+	/*  192 */  843,  850,  858,  862,    0,  866,  874,  879,  886,  891,    0,  898,    0,  902,  908,  914,
+	/*  208 */  920,  926,  932,  941,    0,  949,  956,  962,  969,  975,  982,  988,  995, 1002, 1008, 1014,
+	/*  224 */ 1021, 1027, 1034, 1040, 1047, 1054,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  240 */    0,    0,    0,    0,    0,    0, 1060, 1064, 1068, 1072, 1076, 1079, 1083,    0,    0,    0,
+	/*  256 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  272 */    0,    0, 1087, 1076, 1093, 1093,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  288 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  304 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  320 */    0,    0,    0,    0,    0,    0,    0, 1098, 1104, 1110, 1116, 1122,    0, 1129, 1138, 1146,
+	/*  336 */ 1154, 1161, 1166, 1174, 1182, 1189, 1195, 1201, 1207, 1213, 1219, 1227, 1234,    0, 1238, 1245,
+	/*  352 */ 1252, 1259, 1263, 1270, 1277, 1284, 1289,    0,    0, 1295, 1301, 1309, 1317, 1324, 1330, 1336,
+	/*  368 */ 1342, 1348, 1354, 1360, 1366, 1372, 1379, 1386,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  384 */    0,    0,    0,    0, 1393,    0,    0,    0, 1401, 1409, 1417, 1425, 1434, 1441, 1449, 1455,
+	/*  400 */ 1461, 1468, 1473, 1479, 1485, 1491, 1500, 1509, 1515, 1521, 1527, 1533, 1542, 1549, 1556, 1563,
+	/*  416 */ 1569, 1576, 1581, 1587, 1593, 1599, 1608, 1617, 1623, 1629, 1635, 1641, 1648, 1655, 1663, 1669,
+	/*  432 */ 1679, 1683, 1687, 1692, 1698, 1704, 1713, 1723, 1729, 1735, 1741, 1747, 1753, 1760, 1766, 1669,
+	/*  448 */ 1772, 1776, 1781, 1786, 1792, 1798, 1807, 1814, 1820, 1826, 1832, 1838, 1848, 1858, 1868, 1877,
+	/*  464 */ 1885, 1893, 1901, 1910, 1920, 1930, 1940, 1949, 1960,    0,    0,    0,    0,    0,    0,    0,
+	/*  480 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0, 1971,    0, 1977, 1981,    0,
+	/*  496 */    0,    0,    0, 1986, 1995,    0, 2004, 2013,    0, 2022,    0,    0,    0,    0, 2032, 2038,
+	/*  512 */ 2045,    0, 2051, 2058, 2065, 2072,    0,    0,    0, 2079,    0,    0, 2086, 2093, 2100, 2107,
+	/*  528 */ 2114, 2117,    0, 2122, 2130, 2134, 2139, 2144, 2149, 2155,    0,    0,    0,    0,    0,    0,
+	/*  544 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  560 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  576 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  592 */    0,    0,    0,    0,    0, 2161,    0, 2166, 2170,    0, 2176,    0, 2182,    0, 2188, 2193,
+	/*  608 */ 2198, 2202, 2213, 2222, 2231, 2240, 2249, 2259, 2269, 2274, 2283, 2288, 2296, 2303,    0, 2311,
+	/*  624 */    0, 2318,    0,    0,    0, 2322, 2329,    0,    0,    0,    0,    0,    0, 2336, 2344,    0,
+	/*  640 */    0,    0, 2352,    0,    0,    0, 2358,    0,    0, 2364, 2370,    0,    0, 2377,    0, 2383,
+	/*  656 */ 2387, 2391, 2397, 2403, 2409,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  672 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  688 */    0,    0,    0,    0,    0,    0,    0,    0,    0, 2415, 2419, 2424, 2430, 2437, 2442, 2448,
+	/*  704 */    0,    0,    0,    0,    0, 2454, 2461, 2469,    0, 2477,    0,    0, 2484, 2490, 2497, 2503,
+	/*  720 */ 2510, 2517, 2524, 2524,    0,    0, 2531, 2535,    0,    0, 2540,    0, 2546,    0,    0,    0,
+	/*  736 */    0, 2552,    0,    0,    0, 2557,    0, 2563,    0, 2569, 2577, 2582,    0, 2589,    0, 2593,
+	/*  752 */ 2601, 2609, 2616, 2622,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  768 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  784 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  800 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  816 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  832 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  848 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  864 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  880 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  896 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  912 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  928 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  944 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0, 2626,    0,    0,    0,    0,
+	/*  960 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  976 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/*  992 */    0,    0,    0,    0,    0, 2634, 2642,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1008 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1024 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1040 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1056 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1072 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1088 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1104 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1120 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1136 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1152 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1168 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1184 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1200 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1216 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1232 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1248 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1264 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1280 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1296 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1312 */ 2648, 2654,    0, 2661, 2668,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1328 */    0,    0,    0,    0,    0,    0,    0,    0,    0, 2673,    0,    0,    0,    0,    0,    0,
+	/* 1344 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0, 2679,    0,    0,    0,    0,
+	/* 1360 */    0,    0,    0,    0, 2685,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1376 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1392 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1408 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1424 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1440 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1456 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1472 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1488 */    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+	/* 1504 */    0, 2691, 2695, 2703
+};
+
+/* Classes('_NMD_X86_PREFIX_CLASS') of every byte. */
+NMD_ASSEMBLY_API const uint8_t _nmd_x86_prefix_classes[256] = {
+	/* 00 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 10 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 20 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00,
+	/* 30 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00,
+	/* 40 */ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30,
+	/* 50 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 60 */ 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x03, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 70 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 80 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 90 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* A0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* B0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* C0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* D0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* E0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* F0 */ 0x09, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+/* Perfect hash table of the assembler's mnemonics('_NMD_X86_ASM_MNEMONIC'). Indexed by the high-order bits of _nmd_hash_string(mnemonic, length, _nmd_x86_asm_mnemonic_hash_seed). */
+NMD_ASSEMBLY_API const uint32_t _nmd_x86_asm_mnemonic_hash_seed = 0x811cb731;
+NMD_ASSEMBLY_API const uint8_t _nmd_x86_asm_mnemonic_hash_table[1 << _NMD_X86_ASM_MNEMONIC_HASH_BITS] = {
+	/* 00 */ 0x38, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x48, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 10 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x31, 0x00, 0x00, 0x65, 0x00, 0x00, 0x00, 0x20, 0x00,
+	/* 20 */ 0x1b, 0x00, 0x00, 0x44, 0x35, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x43, 0x00, 0x00, 0x00, 0x00,
+	/* 30 */ 0x00, 0x00, 0x2b, 0x00, 0x0f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 40 */ 0x00, 0x00, 0x00, 0x0c, 0x00, 0x54, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x64, 0x00,
+	/* 50 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x00,
+	/* 60 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 70 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x51, 0x00,
+	/* 80 */ 0x4e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x29, 0x2e, 0x00, 0x39, 0x00, 0x00, 0x00,
+	/* 90 */ 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x53, 0x00, 0x00, 0x3b, 0x10, 0x00, 0x00, 0x52, 0x00, 0x5e,
+	/* A0 */ 0x22, 0x4b, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x50, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* B0 */ 0x00, 0x00, 0x00, 0x00, 0x16, 0x00, 0x00, 0x00, 0x4a, 0x00, 0x00, 0x00, 0x00, 0x3d, 0x00, 0x00,
+	/* C0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f, 0x0d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x41, 0x00, 0x1e, 0x00,
+	/* D0 */ 0x00, 0x2d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x32, 0x00, 0x00, 0x00,
+	/* E0 */ 0x00, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x5b, 0x00, 0x5c, 0x00, 0x05, 0x00, 0x34, 0x00, 0x00,
+	/* F0 */ 0x00, 0x36, 0x3c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46, 0x00, 0x00, 0x2f, 0x00, 0x00, 0x00,
+	/* 100 */ 0x00, 0x4f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x61, 0x15, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 110 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3a, 0x00, 0x00, 0x00,
+	/* 120 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 130 */ 0x28, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 140 */ 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x45, 0x49, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x19, 0x00,
+	/* 150 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x12, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 160 */ 0x00, 0x2c, 0x00, 0x00, 0x00, 0x30, 0x66, 0x4d, 0x0e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 170 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x47, 0x00,
+	/* 180 */ 0x58, 0x00, 0x00, 0x62, 0x00, 0x00, 0x1a, 0x00, 0x00, 0x1d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 190 */ 0x24, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0b, 0x00, 0x00, 0x00, 0x18, 0x06, 0x00, 0x00,
+	/* 1A0 */ 0x42, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x5d, 0x07, 0x5f, 0x00, 0x00, 0x26, 0x00,
+	/* 1B0 */ 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00, 0x00, 0x59, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x63,
+	/* 1C0 */ 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3e, 0x25, 0x27, 0x23, 0x00, 0x2a,
+	/* 1D0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x13, 0x00, 0x00, 0x00, 0x00, 0x5a, 0x00,
+	/* 1E0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x11, 0x17, 0x37, 0x00, 0x56, 0x00, 0x4c, 0x00, 0x00, 0x57, 0x00,
+	/* 1F0 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0x33, 0x00, 0x00, 0x00, 0x00, 0x55, 0x00
+};
+
+/* Perfect hash table of the general-purpose and segment registers('NMD_X86_REG'). Indexed by the high-order bits of _nmd_hash_string(name, length, _nmd_x86_asm_reg_hash_seed). */
+NMD_ASSEMBLY_API const uint32_t _nmd_x86_asm_reg_hash_seed = 0x811da41f;
+NMD_ASSEMBLY_API const uint8_t _nmd_x86_asm_reg_hash_table[1 << _NMD_X86_ASM_REG_HASH_BITS] = {
+	/* 00 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x49, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 10 */ 0x00, 0x00, 0x00, 0x54, 0x00, 0x00, 0x21, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x33, 0x00,
+	/* 20 */ 0x00, 0x00, 0x2f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x25, 0x00, 0x17, 0x41, 0x00, 0x10, 0x00, 0x00,
+	/* 30 */ 0x00, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x13, 0x3f, 0x00, 0x1e,
+	/* 40 */ 0x00, 0x00, 0x00, 0x4c, 0x00, 0x00, 0x2a, 0x00, 0x35, 0x00, 0x00, 0x00, 0x00, 0x39, 0x00, 0x55,
+	/* 50 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x50, 0x27, 0x00, 0x00, 0x2c, 0x00, 0x00,
+	/* 60 */ 0x3b, 0x00, 0x00, 0x00, 0x2b, 0x00, 0x3e, 0x19, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* 70 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x2e, 0x2d, 0x00, 0x1b, 0x53, 0x00,
+	/* 80 */ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x42,
+	/* 90 */ 0x20, 0x00, 0x00, 0x37, 0x22, 0x00, 0x11, 0x00, 0x00, 0x00, 0x29, 0x4d, 0x00, 0x00, 0x00, 0x00,
+	/* A0 */ 0x00, 0x00, 0x32, 0x3d, 0x00, 0x00, 0x00, 0x3c, 0x00, 0x51, 0x00, 0x00, 0x1a, 0x00, 0x00, 0x00,
+	/* B0 */ 0x00, 0x00, 0x31, 0x00, 0x00, 0x30, 0x00, 0x34, 0x48, 0x00, 0x40, 0x00, 0x4b, 0x00, 0x00, 0x00,
+	/* C0 */ 0x12, 0x00, 0x00, 0x00, 0x00, 0x16, 0x00, 0x00, 0x52, 0x00, 0x4a, 0x00, 0x00, 0x00, 0x15, 0x24,
+	/* D0 */ 0x26, 0x00, 0x00, 0x00, 0x00, 0x3a, 0x00, 0x43, 0x00, 0x00, 0x23, 0x00, 0x4e, 0x00, 0x00, 0x00,
+	/* E0 */ 0x00, 0x00, 0x00, 0x00, 0x1f, 0x44, 0x4f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x38, 0x00, 0x00, 0x00,
+	/* F0 */ 0x00, 0x47, 0x00, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1d, 0x45, 0x46, 0x28, 0x00, 0x00, 0x00
+};
+
+
 typedef struct _nmd_assemble_info
 {
 	char* s; /* string */
@@ -2737,58 +4076,127 @@ enum _NMD_NUMBER_BASE
 	_NMD_NUMBER_BASE_BINARY = 2
 };
 
-NMD_ASSEMBLY_API size_t _nmd_assemble_reg(_nmd_assemble_info* ai, uint8_t base_byte)
+/*
+Mnemonics(and prefixes) known by the assembler. The order of some ranges matters:
+ - The instructions from 'INT3' to 'STD' are encoded by a single opcode byte('_nmd_x86_asm_op1_bytes') and the ones from 'SYSCALL' to 'RSM' by 0x0F plus a byte('_nmd_x86_asm_op2_bytes').
+ - The instructions from 'ADD' to 'CMP' are in the same order as '_nmd_op1_opcode_map_mnemonics'.
+ - The instructions from 'JO' to 'JG' are in the same order as '_nmd_condition_suffixes'.
+*/
+enum _NMD_X86_ASM_MNEMONIC
 {
-	uint8_t i = 0;
-	if (ai->mode == NMD_X86_MODE_64)
-	{
-		for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg64); i++)
-		{
-			if (_nmd_strcmp(ai->s, _nmd_reg64[i]))
-			{
-				ai->b[0] = base_byte + i;
-				return 1;
-			}
-		}
+	_NMD_X86_ASM_MNEMONIC_NONE = 0,
 
-		for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_regrx); i++)
-		{
-			if (_nmd_strcmp(ai->s, _nmd_regrx[i]))
-			{
-				ai->b[0] = 0x41;
-				ai->b[1] = base_byte + i;
-				return 2;
-			}
-		}
-	}
-	else if (ai->mode == NMD_X86_MODE_32)
-	{
-		for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg32); i++)
-		{
-			if (_nmd_strcmp(ai->s, _nmd_reg32[i]))
-			{
-				ai->b[0] = base_byte + i;
-				return 1;
-			}
-		}
-	}	
+	_NMD_X86_ASM_MNEMONIC_LOCK, _NMD_X86_ASM_MNEMONIC_REP, _NMD_X86_ASM_MNEMONIC_REPE, _NMD_X86_ASM_MNEMONIC_REPZ, _NMD_X86_ASM_MNEMONIC_REPNE, _NMD_X86_ASM_MNEMONIC_REPNZ,
 
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg16); i++)
-	{
-		if (_nmd_strcmp(ai->s, _nmd_reg16[i]))
-		{
-			ai->b[0] = 0x66;
-			ai->b[1] = base_byte + i;
-			return 2;
-		}
-	}
+	_NMD_X86_ASM_MNEMONIC_INT3, _NMD_X86_ASM_MNEMONIC_NOP, _NMD_X86_ASM_MNEMONIC_RET, _NMD_X86_ASM_MNEMONIC_RETF, _NMD_X86_ASM_MNEMONIC_LEAVE, _NMD_X86_ASM_MNEMONIC_INT1,
+	_NMD_X86_ASM_MNEMONIC_DAA, _NMD_X86_ASM_MNEMONIC_AAA, _NMD_X86_ASM_MNEMONIC_DAS, _NMD_X86_ASM_MNEMONIC_AAS, _NMD_X86_ASM_MNEMONIC_XLAT, _NMD_X86_ASM_MNEMONIC_FWAIT,
+	_NMD_X86_ASM_MNEMONIC_HLT, _NMD_X86_ASM_MNEMONIC_CMC, _NMD_X86_ASM_MNEMONIC_CLC, _NMD_X86_ASM_MNEMONIC_SAHF, _NMD_X86_ASM_MNEMONIC_LAHF, _NMD_X86_ASM_MNEMONIC_INTO,
+	_NMD_X86_ASM_MNEMONIC_SALC, _NMD_X86_ASM_MNEMONIC_SLC, _NMD_X86_ASM_MNEMONIC_STC, _NMD_X86_ASM_MNEMONIC_CLI, _NMD_X86_ASM_MNEMONIC_STI, _NMD_X86_ASM_MNEMONIC_CLD,
+	_NMD_X86_ASM_MNEMONIC_STD,
 
-	return 0;
+	_NMD_X86_ASM_MNEMONIC_SYSCALL, _NMD_X86_ASM_MNEMONIC_CLTS, _NMD_X86_ASM_MNEMONIC_SYSRET, _NMD_X86_ASM_MNEMONIC_INVD, _NMD_X86_ASM_MNEMONIC_WBINVD, _NMD_X86_ASM_MNEMONIC_UD2,
+	_NMD_X86_ASM_MNEMONIC_FEMMS, _NMD_X86_ASM_MNEMONIC_WRMSR, _NMD_X86_ASM_MNEMONIC_RDTSC, _NMD_X86_ASM_MNEMONIC_RDMSR, _NMD_X86_ASM_MNEMONIC_RDPMC, _NMD_X86_ASM_MNEMONIC_SYSENTER,
+	_NMD_X86_ASM_MNEMONIC_SYSEXIT, _NMD_X86_ASM_MNEMONIC_GETSEC, _NMD_X86_ASM_MNEMONIC_EMMS, _NMD_X86_ASM_MNEMONIC_CPUID, _NMD_X86_ASM_MNEMONIC_RSM,
+
+	_NMD_X86_ASM_MNEMONIC_ADD, _NMD_X86_ASM_MNEMONIC_ADC, _NMD_X86_ASM_MNEMONIC_AND, _NMD_X86_ASM_MNEMONIC_XOR, _NMD_X86_ASM_MNEMONIC_OR, _NMD_X86_ASM_MNEMONIC_SBB,
+	_NMD_X86_ASM_MNEMONIC_SUB, _NMD_X86_ASM_MNEMONIC_CMP,
+
+	_NMD_X86_ASM_MNEMONIC_JO, _NMD_X86_ASM_MNEMONIC_JNO, _NMD_X86_ASM_MNEMONIC_JB, _NMD_X86_ASM_MNEMONIC_JNB, _NMD_X86_ASM_MNEMONIC_JZ, _NMD_X86_ASM_MNEMONIC_JNZ,
+	_NMD_X86_ASM_MNEMONIC_JBE, _NMD_X86_ASM_MNEMONIC_JA, _NMD_X86_ASM_MNEMONIC_JS, _NMD_X86_ASM_MNEMONIC_JNS, _NMD_X86_ASM_MNEMONIC_JP, _NMD_X86_ASM_MNEMONIC_JNP,
+	_NMD_X86_ASM_MNEMONIC_JL, _NMD_X86_ASM_MNEMONIC_JGE, _NMD_X86_ASM_MNEMONIC_JLE, _NMD_X86_ASM_MNEMONIC_JG,
+
+	_NMD_X86_ASM_MNEMONIC_MOV, _NMD_X86_ASM_MNEMONIC_PUSH, _NMD_X86_ASM_MNEMONIC_POP, _NMD_X86_ASM_MNEMONIC_XCHG, _NMD_X86_ASM_MNEMONIC_INC, _NMD_X86_ASM_MNEMONIC_DEC,
+	_NMD_X86_ASM_MNEMONIC_JMP, _NMD_X86_ASM_MNEMONIC_CALL, _NMD_X86_ASM_MNEMONIC_INT, _NMD_X86_ASM_MNEMONIC_EMIT,
+
+	_NMD_X86_ASM_MNEMONIC_PUSHF, _NMD_X86_ASM_MNEMONIC_POPF, _NMD_X86_ASM_MNEMONIC_PUSHFD, _NMD_X86_ASM_MNEMONIC_POPFD, _NMD_X86_ASM_MNEMONIC_PUSHFQ, _NMD_X86_ASM_MNEMONIC_POPFQ,
+	_NMD_X86_ASM_MNEMONIC_PUSHA, _NMD_X86_ASM_MNEMONIC_PUSHAD, _NMD_X86_ASM_MNEMONIC_POPA, _NMD_X86_ASM_MNEMONIC_POPAD, _NMD_X86_ASM_MNEMONIC_IRET, _NMD_X86_ASM_MNEMONIC_IRETD,
+	_NMD_X86_ASM_MNEMONIC_IRETQ, _NMD_X86_ASM_MNEMONIC_PAUSE, _NMD_X86_ASM_MNEMONIC_CBW, _NMD_X86_ASM_MNEMONIC_CWDE, _NMD_X86_ASM_MNEMONIC_CDQE, _NMD_X86_ASM_MNEMONIC_CWD,
+	_NMD_X86_ASM_MNEMONIC_CDQ, _NMD_X86_ASM_MNEMONIC_CQO,
+
+	_NMD_X86_ASM_MNEMONIC_NUM
+};
+
+/* The names of the members of '_NMD_X86_ASM_MNEMONIC'. */
+NMD_ASSEMBLY_API const char* const _nmd_x86_asm_mnemonics[] = {
+	"",
+	"lock", "rep", "repe", "repz", "repne", "repnz",
+	"int3", "nop", "ret", "retf", "leave", "int1", "daa", "aaa", "das", "aas", "xlat", "fwait", "hlt", "cmc", "clc", "sahf", "lahf", "into", "salc", "slc", "stc", "cli", "sti", "cld", "std",
+	"syscall", "clts", "sysret", "invd", "wbinvd", "ud2", "femms", "wrmsr", "rdtsc", "rdmsr", "rdpmc", "sysenter", "sysexit", "getsec", "emms", "cpuid", "rsm",
+	"add", "adc", "and", "xor", "or", "sbb", "sub", "cmp",
+	"jo", "jno", "jb", "jnb", "jz", "jnz", "jbe", "ja", "js", "jns", "jp", "jnp", "jl", "jge", "jle", "jg",
+	"mov", "push", "pop", "xchg", "inc", "dec", "jmp", "call", "int", "emit",
+	"pushf", "popf", "pushfd", "popfd", "pushfq", "popfq", "pusha", "pushad", "popa", "popad", "iret", "iretd", "iretq", "pause", "cbw", "cwde", "cdqe", "cwd", "cdq", "cqo"
+};
+
+NMD_ASSEMBLY_API const uint8_t _nmd_x86_asm_op1_bytes[] = { 0xcc, 0x90, 0xc3, 0xcb, 0xc9, 0xf1, 0x27, 0x37, 0x2f, 0x3f, 0xd7, 0x9b, 0xf4, 0xf5, 0xf8, 0x9e, 0x9f, 0xce, 0xd6, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd };
+NMD_ASSEMBLY_API const uint8_t _nmd_x86_asm_op2_bytes[] = { 0x05, 0x06, 0x07, 0x08, 0x09, 0x0b, 0x0e, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x37, 0x77, 0xa2, 0xaa };
+
+/*
+Hashes the first 'length' characters of 's'(FNV-1a using 'seed' as the offset basis). The hash tables are indexed by the high-order bits of the result,
+which are mixed at the end because FNV-1a alone leaves them almost equal for short names that differ in a single character(e.g. 'r8w' and 'r9w').
+*/
+NMD_ASSEMBLY_API uint32_t _nmd_hash_string(const char* s, size_t length, uint32_t seed)
+{
+	size_t i = 0;
+	for (; i < length; i++)
+		seed = (seed ^ (uint8_t)s[i]) * 16777619;
+
+	seed ^= seed >> 16;
+	seed *= 0x85ebca6b;
+	seed ^= seed >> 13;
+	return seed;
 }
 
-NMD_ASSEMBLY_API uint8_t _nmd_encode_segment_reg(NMD_X86_REG segment_reg)
+/* Returns the number of characters of the token(a sequence of lowercase letters and digits) at 's'. */
+NMD_ASSEMBLY_API size_t _nmd_get_token_length(const char* s)
 {
-	switch (segment_reg)
+	const char* const start = s;
+	while (_NMD_IS_LOWERCASE(*s) || _NMD_IS_DECIMAL_NUMBER(*s))
+		s++;
+
+	return (size_t)(s - start);
+}
+
+/* Returns true if the first 'length' characters of 's' are exactly 'name'. */
+NMD_ASSEMBLY_API bool _nmd_token_equals(const char* name, const char* s, size_t length)
+{
+	size_t i = 0;
+	for (; i < length; i++)
+	{
+		if (name[i] != s[i])
+			return false;
+	}
+
+	return name[length] == '\0';
+}
+
+/* Returns the name of a general-purpose or segment register(from 'NMD_X86_REG_AL' to 'NMD_X86_REG_GS'), or a null pointer if 'reg' is not one of them. */
+NMD_ASSEMBLY_API const char* _nmd_get_asm_reg_name(uint8_t reg)
+{
+	static const char* const* const names[] = { _nmd_reg8, _nmd_reg16, _nmd_reg32, _nmd_reg64, _nmd_regrx, _nmd_regrxb, _nmd_regrxw, _nmd_regrxd, _nmd_segment_reg };
+	if (reg < NMD_X86_REG_AL || reg > NMD_X86_REG_GS)
+		return 0;
+
+	return names[(reg - NMD_X86_REG_AL) / 8][reg % 8];
+}
+
+/* Returns the mnemonic('_NMD_X86_ASM_MNEMONIC') whose name is the first 'length' characters of 's', or '_NMD_X86_ASM_MNEMONIC_NONE'. */
+NMD_ASSEMBLY_API uint8_t _nmd_find_asm_mnemonic(const char* s, size_t length)
+{
+	const uint8_t mnemonic = _nmd_x86_asm_mnemonic_hash_table[_nmd_hash_string(s, length, _nmd_x86_asm_mnemonic_hash_seed) >> (32 - _NMD_X86_ASM_MNEMONIC_HASH_BITS)];
+	return mnemonic && _nmd_token_equals(_nmd_x86_asm_mnemonics[mnemonic], s, length) ? mnemonic : (uint8_t)_NMD_X86_ASM_MNEMONIC_NONE;
+}
+
+/* Returns the register whose name is the first 'length' characters of 's', or 'NMD_X86_REG_NONE'. Only general-purpose and segment registers are recognized. */
+NMD_ASSEMBLY_API NMD_X86_REG _nmd_find_asm_reg(const char* s, size_t length)
+{
+	const uint8_t reg = _nmd_x86_asm_reg_hash_table[_nmd_hash_string(s, length, _nmd_x86_asm_reg_hash_seed) >> (32 - _NMD_X86_ASM_REG_HASH_BITS)];
+	return reg && _nmd_token_equals(_nmd_get_asm_reg_name(reg), s, length) ? (NMD_X86_REG)reg : NMD_X86_REG_NONE;
+}
+
+NMD_ASSEMBLY_API uint8_t _nmd_encode_segment_reg(NMD_X86_REG segment_reg)
+{
+	switch (segment_reg)
 	{
 	case NMD_X86_REG_ES: return 0x26;
 	case NMD_X86_REG_CS: return 0x2e;
@@ -2873,7 +4281,8 @@ NMD_ASSEMBLY_API size_t _nmd_parse_number(const char* string, int64_t* p_num)
 	if (num_digits == 0)
 		return 0;
 
-	int64_t num = 0;
+	/* Accumulated as unsigned, numbers up to 2^64-1 overflow a signed integer */
+	uint64_t num = 0;
 	for (i = 0; i < num_digits; i++)
 	{
 		const char c = s[i];
@@ -2887,9 +4296,9 @@ NMD_ASSEMBLY_API size_t _nmd_parse_number(const char* string, int64_t* p_num)
 			/* Return false if number is greater than 2^64-1 */
 			if ( num_digits > 16 && i >= 15)
 			{
-				if ((base == _NMD_NUMBER_BASE_DECIMAL && (uint64_t)num >= (uint64_t)1844674407370955162) || /* ceiling((2^64-1) / 10) */
-					(base == _NMD_NUMBER_BASE_HEXADECIMAL && (uint64_t)num >= (uint64_t)1152921504606846976) || /* *ceiling((2^64-1) / 16) */
-					(base == _NMD_NUMBER_BASE_BINARY && (uint64_t)num >= (uint64_t)9223372036854775808U)) /* ceiling((2^64-1) / 2) */
+				if ((base == _NMD_NUMBER_BASE_DECIMAL && num >= (uint64_t)1844674407370955162) || /* ceiling((2^64-1) / 10) */
+					(base == _NMD_NUMBER_BASE_HEXADECIMAL && num >= (uint64_t)1152921504606846976) || /* *ceiling((2^64-1) / 16) */
+					(base == _NMD_NUMBER_BASE_BINARY && num >= (uint64_t)9223372036854775808U)) /* ceiling((2^64-1) / 2) */
 				{
 					return 0;
 				}
@@ -2900,9 +4309,9 @@ NMD_ASSEMBLY_API size_t _nmd_parse_number(const char* string, int64_t* p_num)
 	}
 
 	if (is_negative)
-		num *= -1;
+		num = ~num + 1;
 
-	*p_num = num;
+	*p_num = (int64_t)num;
 
 	size_t offset = 0;
 
@@ -2916,206 +4325,116 @@ NMD_ASSEMBLY_API size_t _nmd_parse_number(const char* string, int64_t* p_num)
 	
 	return offset + num_digits;
 }
+/* Parses a number that takes the rest of the string. Registers that look like numbers(e.g. 'ah' and 'ch' with the 'h' suffix) are not numbers. */
+NMD_ASSEMBLY_API bool _nmd_parse_immediate(const char* string, int64_t* p_num)
+{
+	const size_t num_digits = _nmd_parse_number(string, p_num);
+	return num_digits && string[num_digits] == '\0' && !_nmd_find_asm_reg(string, num_digits);
+}
 
 NMD_ASSEMBLY_API size_t _nmd_append_prefix_by_reg_size(uint8_t* b, const char* s, size_t* num_prefixes, size_t* index)
 {
-	size_t i;
-	
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg32); i++)
-	{
-		if (_nmd_strcmp(s, _nmd_reg32[i]))
-		{
-			*num_prefixes = 0;
-			*index = i;
-			return 4;
-		}
-	}
+	const size_t length = _nmd_get_token_length(s);
+	const NMD_X86_REG reg = s[length] == '\0' ? _nmd_find_asm_reg(s, length) : NMD_X86_REG_NONE;
 
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg8); i++)
-	{
-		if (_nmd_strcmp(s, _nmd_reg8[i]))
-		{
-			*num_prefixes = 0;
-			*index = i;
-			return 1;
-		}
-	}
+	*num_prefixes = 0;
+	*index = reg % 8;
 
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg16); i++)
+	if (reg >= NMD_X86_REG_EAX && reg <= NMD_X86_REG_EDI)
+		return 4;
+	else if (reg >= NMD_X86_REG_AL && reg <= NMD_X86_REG_BH)
+		return 1;
+	else if (reg >= NMD_X86_REG_AX && reg <= NMD_X86_REG_DI)
 	{
-		if (_nmd_strcmp(s, _nmd_reg16[i]))
-		{
-			b[0] = 0x66;
-			*num_prefixes = 1;
-			*index = i;
-			return 2;
-		}
-	}	
-
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg64); i++)
+		b[(*num_prefixes)++] = 0x66;
+		return 2;
+	}
+	else if (reg >= NMD_X86_REG_RAX && reg <= NMD_X86_REG_RDI)
 	{
-		if (_nmd_strcmp(s, _nmd_reg64[i]))
-		{
-			b[0] = 0x48;
-			*num_prefixes = 1;
-			*index = i;
-			return 8;
-		}
+		b[(*num_prefixes)++] = 0x48;
+		return 8;
 	}
-
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_regrx); i++)
+	else if (reg >= NMD_X86_REG_R8 && reg <= NMD_X86_REG_R15)
 	{
-		if (_nmd_strcmp(s, _nmd_regrx[i]))
-		{
-			b[0] = 0x49;
-			*num_prefixes = 1;
-			*index = i;
-			return 8;
-		}
+		b[(*num_prefixes)++] = 0x49;
+		return 8;
 	}
-
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_regrxd); i++)
+	else if (reg >= NMD_X86_REG_R8D && reg <= NMD_X86_REG_R15D)
 	{
-		if (_nmd_strcmp(s, _nmd_regrxd[i]))
-		{
-			b[0] = 0x41;
-			*num_prefixes = 1;
-			*index = i;
-			return 4;
-		}
+		b[(*num_prefixes)++] = 0x41;
+		return 4;
 	}
-
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_regrxw); i++)
+	else if (reg >= NMD_X86_REG_R8W && reg <= NMD_X86_REG_R15W)
 	{
-		if (_nmd_strcmp(s, _nmd_regrxw[i]))
-		{
-			b[0] = 0x66;
-			b[1] = 0x41;
-			*num_prefixes = 2;
-			*index = i;
-			return 2;
-		}
+		b[(*num_prefixes)++] = 0x66;
+		b[(*num_prefixes)++] = 0x41;
+		return 2;
 	}
-
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_regrxb); i++)
+	else if (reg >= NMD_X86_REG_R8B && reg <= NMD_X86_REG_R15B)
 	{
-		if (_nmd_strcmp(s, _nmd_regrxb[i]))
-		{
-			b[0] = 0x41;
-			*num_prefixes = 1;
-			*index = i;
-			return 1;
-		}
+		b[(*num_prefixes)++] = 0x41;
+		return 1;
 	}
 
 	return 0;
 }
 
+/* Parses a register from 'first_reg' to 'last_reg'. 'string' is advanced past the register only if it's parsed. */
+NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_reg_range(const char** string, NMD_X86_REG first_reg, NMD_X86_REG last_reg)
+{
+	const size_t length = _nmd_get_token_length(*string);
+	const NMD_X86_REG reg = _nmd_find_asm_reg(*string, length);
+	if (reg < first_reg || reg > last_reg)
+		return NMD_X86_REG_NONE;
+
+	*string += length;
+	return reg;
+}
+
 NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_reg8(const char** string)
 {
-	const char* s = *string;
-	size_t i;
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg8); i++)
-	{
-		if (_nmd_strstr_ex(s, _nmd_reg8[i], string) == s)
-			return (NMD_X86_REG)(NMD_X86_REG_AL + i);
-	}
-	return NMD_X86_REG_NONE;
+	return _nmd_parse_reg_range(string, NMD_X86_REG_AL, NMD_X86_REG_BH);
 }
 
 NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_reg16(const char** string)
 {
-	const char* s = *string;
-	size_t i;
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg16); i++)
-	{
-		if (_nmd_strstr_ex(s, _nmd_reg16[i], string) == s)
-			return (NMD_X86_REG)(NMD_X86_REG_AX + i);
-	}
-	return NMD_X86_REG_NONE;
+	return _nmd_parse_reg_range(string, NMD_X86_REG_AX, NMD_X86_REG_DI);
 }
 
 NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_reg32(const char** string)
 {
-	const char* s = *string;
-	size_t i;
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg32); i++)
-	{
-		if (_nmd_strstr_ex(s, _nmd_reg32[i], string) == s)
-			return (NMD_X86_REG)(NMD_X86_REG_EAX + i);
-	}
-	return NMD_X86_REG_NONE;
+	return _nmd_parse_reg_range(string, NMD_X86_REG_EAX, NMD_X86_REG_EDI);
 }
 
 NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_reg64(const char** string)
 {
-	const char* s = *string;
-	size_t i;
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg64); i++)
-	{
-		if (_nmd_strstr_ex(s, _nmd_reg64[i], string) == s)
-			return (NMD_X86_REG)(NMD_X86_REG_RAX + i);
-	}
-	return NMD_X86_REG_NONE;
+	return _nmd_parse_reg_range(string, NMD_X86_REG_RAX, NMD_X86_REG_RDI);
 }
 
 NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_regrxb(const char** string)
 {
-	const char* s = *string;
-	size_t i;
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_regrxb); i++)
-	{
-		if (_nmd_strstr_ex(s, _nmd_regrxb[i], string) == s)
-			return (NMD_X86_REG)(NMD_X86_REG_R8B + i);
-	}
-	return NMD_X86_REG_NONE;
+	return _nmd_parse_reg_range(string, NMD_X86_REG_R8B, NMD_X86_REG_R15B);
 }
 
 NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_regrxw(const char** string)
 {
-	const char* s = *string;
-	size_t i;
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_regrxw); i++)
-	{
-		if (_nmd_strstr_ex(s, _nmd_regrxw[i], string) == s)
-			return (NMD_X86_REG)(NMD_X86_REG_R8W + i);
-	}
-	return NMD_X86_REG_NONE;
+	return _nmd_parse_reg_range(string, NMD_X86_REG_R8W, NMD_X86_REG_R15W);
 }
 
 NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_regrxd(const char** string)
 {
-	const char* s = *string;
-	size_t i;
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_regrxd); i++)
-	{
-		if (_nmd_strstr_ex(s, _nmd_regrxd[i], string) == s)
-			return (NMD_X86_REG)(NMD_X86_REG_R8D + i);
-	}
-	return NMD_X86_REG_NONE;
+	return _nmd_parse_reg_range(string, NMD_X86_REG_R8D, NMD_X86_REG_R15D);
 }
 
 NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_regrx(const char** string)
 {
-	const char* s = *string;
-	size_t i;
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_regrx); i++)
-	{
-		if (_nmd_strstr_ex(s, _nmd_regrx[i], string) == s)
-			return (NMD_X86_REG)(NMD_X86_REG_R8 + i);
-	}
-	return NMD_X86_REG_NONE;
+	return _nmd_parse_reg_range(string, NMD_X86_REG_R8, NMD_X86_REG_R15);
 }
 
-/* Parses a register */
+/* Parses a general-purpose register */
 NMD_ASSEMBLY_API NMD_X86_REG _nmd_parse_reg(const char** string)
 {
-    NMD_X86_REG reg;
-    if(!(reg = _nmd_parse_reg8(string)) && !(reg = _nmd_parse_reg16(string)) && !(reg = _nmd_parse_reg32(string)) && !(reg = _nmd_parse_reg64(string)) &&
-    !(reg = _nmd_parse_regrxb(string)) && !(reg = _nmd_parse_regrxw(string)) && !(reg = _nmd_parse_regrxd(string)) && !(reg = _nmd_parse_regrx(string)))
-    { }
-    
-    return reg;
+	return _nmd_parse_reg_range(string, NMD_X86_REG_AL, NMD_X86_REG_R15D);
 }
 
 /* 
@@ -3158,20 +4477,9 @@ NMD_ASSEMBLY_API bool _nmd_parse_memory_operand(const char** string, nmd_x86_mem
 	}
 
 	/* Check for a segment register */
-	size_t i = 0;
-	operand->segment = NMD_X86_REG_NONE;
-	for (; i < _NMD_NUM_ELEMENTS(_nmd_segment_reg); i++)
-	{
-		if (_nmd_strstr(s, _nmd_segment_reg[i]) == s)
-		{
-			if (s[2] != ':')
-				return false;
-
-			s += 3;
-			operand->segment = (uint8_t)(NMD_X86_REG_ES + i);
-			break;
-		}
-	}
+	operand->segment = (uint8_t)_nmd_parse_reg_range(&s, NMD_X86_REG_ES, NMD_X86_REG_GS);
+	if (operand->segment && *s++ != ':')
+		return false;
 
 	/* Check for the actual memory operand expression. If this check fails, this is not a memory operand */
 	if (s[0] == '[')
@@ -3191,6 +4499,7 @@ NMD_ASSEMBLY_API bool _nmd_parse_memory_operand(const char** string, nmd_x86_mem
 	bool add = false;
 	bool sub = false;
 	bool multiply = false;
+	bool scaled = false;
 	bool is_register = false;
 	while (true)
 	{
@@ -3199,27 +4508,27 @@ NMD_ASSEMBLY_API bool _nmd_parse_memory_operand(const char** string, nmd_x86_mem
 		nor multiplication because these are not valid for registers(only addition is).
 		*/
 		bool parsed_element = false;
-		if (!sub && !multiply)
+		NMD_X86_REG reg;
+		if (!sub && !multiply && (reg = _nmd_parse_reg32(&s)))
 		{
-			for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_reg32); i++)
+			if (add)
 			{
-				const char* tmp;
-				if (_nmd_strstr_ex(s, _nmd_reg32[i], &tmp) == s)
+				/* '[index*scale+base]' */
+				if (operand->index && operand->base)
+					return false;
+				else if (operand->index)
+					operand->base = (uint8_t)reg;
+				else
 				{
-					s = tmp;
-					if (add)
-					{
-						operand->index = (uint8_t)(NMD_X86_REG_EAX + i);
-						operand->scale = 1;
-						add = false;
-					}
-					else
-						operand->base = (uint8_t)(NMD_X86_REG_EAX + i);
-					parsed_element = true;
-					is_register = true;
-					break;
+					operand->index = (uint8_t)reg;
+					operand->scale = 1;
 				}
+				add = false;
 			}
+			else
+				operand->base = (uint8_t)reg;
+			parsed_element = true;
+			is_register = true;
 		}
 
 		int64_t num;
@@ -3243,7 +4552,15 @@ NMD_ASSEMBLY_API bool _nmd_parse_memory_operand(const char** string, nmd_x86_mem
 				if (!is_register || (num != 1 && num != 2 && num != 4 && num != 8))
 					return false;
 
+				/* The scaled register is the index, even if it was parsed first('[eax*8+disp]') */
+				if (!operand->index)
+				{
+					operand->index = operand->base;
+					operand->base = 0;
+				}
 				operand->scale = (uint8_t)num;
+				multiply = false;
+				scaled = true;
 			}
 			else
 				operand->disp = num;
@@ -3261,7 +4578,7 @@ NMD_ASSEMBLY_API bool _nmd_parse_memory_operand(const char** string, nmd_x86_mem
 		else if (s[0] == '*')
 		{
 			/* There cannot be more than one '*' operator. */
-			if (multiply)
+			if (multiply || scaled)
 				return false;
 
 			multiply = true;
@@ -3278,786 +4595,664 @@ NMD_ASSEMBLY_API bool _nmd_parse_memory_operand(const char** string, nmd_x86_mem
 	return true;
 }
 
-NMD_ASSEMBLY_API size_t _nmd_assemble_mem_reg(uint8_t* buffer, nmd_x86_memory_operand* mem, uint8_t opcode, uint8_t modrm_reg)
+/* Returns the size in bytes of a general-purpose register, or zero if 'reg' is not a general-purpose register. */
+NMD_ASSEMBLY_API size_t _nmd_get_gpr_size(NMD_X86_REG reg)
+{
+	static const uint8_t sizes[] = { 1, 2, 4, 8, 8, 1, 2, 4 };
+	return reg >= NMD_X86_REG_AL && reg <= NMD_X86_REG_R15D ? sizes[(reg - NMD_X86_REG_AL) / 8] : 0;
+}
+
+/* Returns the ModR/M encoding of a general-purpose register. Bit 3 is set for 'r8' to 'r15'(the bit stored in the REX prefix). */
+NMD_ASSEMBLY_API uint8_t _nmd_get_gpr_index(NMD_X86_REG reg)
+{
+	return (uint8_t)(reg % 8 + (reg >= NMD_X86_REG_R8 ? 8 : 0));
+}
+
+/* What the byte registers whose identifiers are 'NMD_X86_REG_AH' to 'NMD_X86_REG_BH' mean in an instruction. */
+enum _NMD_BYTE_REGS
+{
+	_NMD_BYTE_REGS_NONE = 0, /* The instruction doesn't use them. */
+	_NMD_BYTE_REGS_HIGH,     /* 'ah', 'ch', 'dh' and 'bh', which can't be encoded with a REX prefix. */
+	_NMD_BYTE_REGS_REX       /* 'spl', 'bpl', 'sil' and 'dil', which require a REX prefix(the decoder sets 'has_rex'). */
+};
+
+/*
+Appends the operand size prefix and the REX prefix required by an instruction whose operand size is 'size' bytes. 'rex' is a mask of the R, X and B bits of the REX prefix.
+'byte_regs' is a member of '_NMD_BYTE_REGS'. Returns false if the combination is not valid in 'mode'.
+*/
+NMD_ASSEMBLY_API bool _nmd_append_operand_size_prefixes(uint8_t* buffer, size_t* offset, NMD_X86_MODE mode, size_t size, uint8_t rex, uint8_t byte_regs)
+{
+	if ((size == 2 && mode != NMD_X86_MODE_16) || (size == 4 && mode == NMD_X86_MODE_16))
+		buffer[(*offset)++] = 0x66;
+
+	if (size == 8)
+		rex |= 0x08; /* REX.W */
+	if (byte_regs == _NMD_BYTE_REGS_REX)
+		rex |= 0x40;
+
+	if (rex)
+	{
+		if (mode != NMD_X86_MODE_64 || byte_regs == _NMD_BYTE_REGS_HIGH)
+			return false;
+
+		buffer[(*offset)++] = 0x40 | rex;
+	}
+
+	return true;
+}
+
+/* Returns true if 'reg' is 'ah', 'ch', 'dh' or 'bh', which can't be encoded with a REX prefix. */
+NMD_ASSEMBLY_API bool _nmd_is_high_byte_reg(uint8_t reg)
+{
+	return reg >= NMD_X86_REG_AH && reg <= NMD_X86_REG_BH;
+}
+
+/*
+Assembles an instruction with an opcode byte followed by a ModR/M byte whose r/m field describes 'mem'. Returns the number of bytes written, or zero if the operand can't be encoded.
+Parameters:
+ - buffer       [out] A pointer to a buffer that receives the instruction.
+ - mode         [in]  The architecture mode.
+ - mem          [in]  The memory operand. The base and index registers(if any) are 32-bit or 64-bit registers, the base may also be 'rip' or 'eip' in 64-bit mode.
+ - opcode       [in]  The opcode byte.
+ - modrm_reg    [in]  The value of the ModR/M.reg field, see _nmd_get_gpr_index(). Bit 3 is encoded in REX.R.
+ - operand_size [in]  The operand size in bytes, used to choose the operand size and REX.W prefixes.
+ - byte_regs    [in]  A member of '_NMD_BYTE_REGS' that tells what 'modrm_reg' means if it's the index of 'ah', 'ch', 'dh' or 'bh'.
+*/
+NMD_ASSEMBLY_API size_t _nmd_assemble_mem_reg(uint8_t* buffer, NMD_X86_MODE mode, const nmd_x86_memory_operand* mem, uint8_t opcode, uint8_t modrm_reg, size_t operand_size, uint8_t byte_regs)
 {
 	size_t offset = 0;
-	
+	nmd_x86_modrm modrm;
+	nmd_x86_sib sib;
+	bool has_sib = false;
+	size_t disp_size = 0;
+	const bool is_rip_relative = mem->base == NMD_X86_REG_RIP || mem->base == NMD_X86_REG_EIP;
+	const uint8_t base = is_rip_relative ? 0 : _nmd_get_gpr_index((NMD_X86_REG)mem->base), index = _nmd_get_gpr_index((NMD_X86_REG)mem->index);
+	const size_t address_size = is_rip_relative ? (mem->base == NMD_X86_REG_RIP ? 8 : 4) : _nmd_get_gpr_size((NMD_X86_REG)(mem->base ? mem->base : mem->index));
+
+	/* The registers must be 32-bit(or 64-bit in 64-bit mode) registers of the same size. ESP(and RSP) can't be an index register */
+	if ((mem->base && !is_rip_relative && _nmd_get_gpr_size((NMD_X86_REG)mem->base) != address_size) || (mem->index && (_nmd_get_gpr_size((NMD_X86_REG)mem->index) != address_size || index == 0b100 || is_rip_relative)) ||
+		(address_size && address_size != 4 && address_size != 8) || (address_size == 8 && mode != NMD_X86_MODE_64) || (is_rip_relative && mode != NMD_X86_MODE_64))
+		return 0;
+
+	/* The scale is 1, 2, 4 or 8(zero means 1). The displacement has 32 bits(sign-extended in 64-bit mode without registers) */
+	if ((mem->scale & (mem->scale - 1)) || mem->scale > 8 || mem->disp < -(int64_t)0x80000000 || mem->disp > ((mode == NMD_X86_MODE_64 && (!mem->base || is_rip_relative) && !mem->index) ? 0x7fffffff : 0xffffffff))
+		return 0;
+
 	/* Assemble segment register if required */
-	if (mem->segment && mem->segment != ((mem->base == NMD_X86_REG_ESP || mem->index == NMD_X86_REG_ESP) ? NMD_X86_REG_SS : NMD_X86_REG_DS))
+	if (mem->segment && mem->segment != ((mem->base == NMD_X86_REG_ESP || mem->base == NMD_X86_REG_EBP || mem->base == NMD_X86_REG_RSP || mem->base == NMD_X86_REG_RBP) ? NMD_X86_REG_SS : NMD_X86_REG_DS))
 		buffer[offset++] = _nmd_encode_segment_reg((NMD_X86_REG)mem->segment);
 
+	/* The address size prefix selects 32-bit addressing in 16-bit mode and 32-bit registers in 64-bit mode */
+	if (mode == NMD_X86_MODE_16 || (mode == NMD_X86_MODE_64 && address_size == 4))
+		buffer[offset++] = 0x67;
+
+	if (!_nmd_append_operand_size_prefixes(buffer, &offset, mode, operand_size, (modrm_reg & 8 ? 0x04 : 0) | (index & 8 ? 0x02 : 0) | (base & 8 ? 0x01 : 0), byte_regs))
+		return 0;
+
 	buffer[offset++] = opcode;
 
-	nmd_x86_modrm modrm;
-	modrm.fields.reg = modrm_reg;
+	modrm.fields.reg = modrm_reg % 8;
 	modrm.fields.mod = 0;
 
-	if (mem->index != NMD_X86_REG_NONE && mem->base != NMD_X86_REG_NONE)
+	if (is_rip_relative)
 	{
-		modrm.fields.rm = 0b100;
-		nmd_x86_sib sib;
-		sib.fields.scale = (uint8_t)_nmd_get_bit_index(mem->scale);
-		sib.fields.base = mem->base - NMD_X86_REG_EAX;
-		sib.fields.index = mem->index - NMD_X86_REG_EAX;
-
-		const size_t next_offset = offset;
-		if (mem->disp != 0)
-		{
-			if (mem->disp >= -128 && mem->disp <= 127)
-			{
-				modrm.fields.mod = 1;
-				*(int8_t*)(buffer + offset + 2) = (int8_t)mem->disp;
-				offset++;
-			}
-			else
-			{
-				modrm.fields.mod = 2;
-				*(int32_t*)(buffer + offset + 2) = (int32_t)mem->disp;
-				offset += 4;
-			}
-		}
-
-		buffer[next_offset] = modrm.modrm;
-		buffer[next_offset + 1] = sib.sib;
-		offset += 2;
-
-		return offset;
+		/* ModR/M.rm=0b101 without a displacement means RIP-relative in 64-bit mode */
+		modrm.fields.rm = 0b101;
+		disp_size = 4;
 	}
-	else if (mem->base != NMD_X86_REG_NONE)
+	else if (mem->index || base % 8 == 0b100 || (!mem->base && mode == NMD_X86_MODE_64))
 	{
-		modrm.fields.rm = mem->base - NMD_X86_REG_EAX;
-		const size_t next_offset = offset;
-		if (mem->disp != 0)
-		{
-			if (mem->disp >= -128 && mem->disp <= 127)
-			{
-				modrm.fields.mod = 1;
-				*(int8_t*)(buffer + offset + 1) = (int8_t)mem->disp;
-				offset++;
-			}
-			else
-			{
-				modrm.fields.mod = 2;
-				*(int32_t*)(buffer + offset + 1) = (int32_t)mem->disp;
-				offset += 4;
-			}
-		}
-		buffer[next_offset] = modrm.modrm;
-		offset++;
+		/* SIB byte. Without a base register(and in 64-bit mode without any register, because ModR/M.rm=0b101 means RIP-relative) base=0b101 means disp32 */
+		modrm.fields.rm = 0b100;
+		has_sib = true;
+		sib.fields.scale = mem->index && mem->scale ? (uint8_t)_nmd_get_bit_index(mem->scale) : 0;
+		sib.fields.index = mem->index ? index % 8 : 0b100;
+		sib.fields.base = mem->base ? base % 8 : 0b101;
 	}
 	else
+		modrm.fields.rm = mem->base ? base % 8 : 0b101;
+
+	if (!mem->base)
+		disp_size = 4;
+	else if (!is_rip_relative && (mem->disp != 0 || base % 8 == 0b101)) /* [ebp] must be encoded as [ebp+0] */
 	{
-		modrm.fields.rm = 0b101;
-		buffer[offset++] = modrm.modrm;
-		*(int32_t*)(buffer + offset) = (int32_t)mem->disp;
-		offset += 4;
+		disp_size = mem->disp >= -128 && mem->disp <= 127 ? 1 : 4;
+		modrm.fields.mod = disp_size == 1 ? 1 : 2;
 	}
 
+	buffer[offset++] = modrm.modrm;
+	if (has_sib)
+		buffer[offset++] = sib.sib;
+
+	if (disp_size == 1)
+		*(int8_t*)(buffer + offset) = (int8_t)mem->disp;
+	else if (disp_size == 4)
+		*(int32_t*)(buffer + offset) = (int32_t)mem->disp;
+
+	return offset + disp_size;
+}
+
+/*
+Same as _nmd_assemble_mem_reg(), but the r/m field describes 'rm', which is either a memory operand or a general-purpose register of 'operand_size' bytes.
+If 'byte_regs' is '_NMD_BYTE_REGS_NONE', an 'rm' whose identifier is the one of 'ah' to 'bh' is a high byte register.
+*/
+NMD_ASSEMBLY_API size_t _nmd_assemble_rm_reg(uint8_t* buffer, NMD_X86_MODE mode, const nmd_x86_operand* rm, uint8_t opcode, uint8_t modrm_reg, size_t operand_size, uint8_t byte_regs)
+{
+	size_t offset = 0;
+	uint8_t index;
+
+	if (rm->type == NMD_X86_OPERAND_TYPE_MEMORY)
+		return _nmd_assemble_mem_reg(buffer, mode, &rm->fields.mem, opcode, modrm_reg, operand_size, byte_regs);
+	else if (rm->type != NMD_X86_OPERAND_TYPE_REGISTER || _nmd_get_gpr_size((NMD_X86_REG)rm->fields.reg) != operand_size)
+		return 0;
+
+	index = _nmd_get_gpr_index((NMD_X86_REG)rm->fields.reg);
+	if (!_nmd_append_operand_size_prefixes(buffer, &offset, mode, operand_size, (modrm_reg & 8 ? 0x04 : 0) | (index & 8 ? 0x01 : 0), (byte_regs == _NMD_BYTE_REGS_NONE && _nmd_is_high_byte_reg(rm->fields.reg)) ? (uint8_t)_NMD_BYTE_REGS_HIGH : byte_regs))
+		return 0;
+
+	buffer[offset++] = opcode;
+	buffer[offset++] = (uint8_t)(0b11000000 | ((modrm_reg % 8) << 3) | (index % 8));
 	return offset;
 }
 
-NMD_ASSEMBLY_API size_t _nmd_assemble_single(_nmd_assemble_info* ai)
+/* Returns the length of a relative branch. 'mnemonic' is '_NMD_X86_ASM_MNEMONIC_JMP', '_NMD_X86_ASM_MNEMONIC_CALL' or a conditional jump. */
+NMD_ASSEMBLY_API size_t _nmd_get_relative_branch_length(NMD_X86_MODE mode, uint8_t mnemonic, bool is_short)
 {
-    const char* s;
-    int64_t num;
-    size_t num_digits;
-    NMD_X86_REG reg, reg2;
-	size_t i = 0;
+	if (is_short)
+		return 2;
 
-	/* Parse prefixes */
-	bool lock_prefix = false, repeat_prefix = false, repeat_zero_prefix = false, repeat_not_zero_prefix = false;
-	if (_nmd_strstr(ai->s, "lock ") == ai->s)
-		lock_prefix = true, ai->s += 5;
-	else if (_nmd_strstr(ai->s, "rep ") == ai->s)
-		repeat_prefix = true, ai->s += 4;
-	else if (_nmd_strstr(ai->s, "repe ") == ai->s || _nmd_strstr(ai->s, "repz ") == ai->s)
-		repeat_zero_prefix = true, ai->s += 5;
-	else if (_nmd_strstr(ai->s, "repne ") == ai->s || _nmd_strstr(ai->s, "repnz ") == ai->s)
-		repeat_not_zero_prefix = true, ai->s += 6;
-	
-	if (_nmd_strstr(ai->s, "xacquire ") == ai->s)
+	return (mode == NMD_X86_MODE_16 ? 1 : 0) + (mnemonic >= _NMD_X86_ASM_MNEMONIC_JO && mnemonic <= _NMD_X86_ASM_MNEMONIC_JG ? 2 : 1) + 4;
+}
+
+/*
+Assembles a relative branch('jmp', 'call' or a conditional jump) to the address 'delta' bytes after the start of the instruction. The short form has an 8-bit displacement
+and doesn't exist for 'call', the long form has a 32-bit displacement(and the operand size prefix in 16-bit mode). Returns the number of bytes written, or zero if the displacement doesn't fit.
+*/
+NMD_ASSEMBLY_API size_t _nmd_assemble_relative_branch(uint8_t* b, NMD_X86_MODE mode, uint8_t mnemonic, int64_t delta, bool is_short)
+{
+	const bool is_conditional = mnemonic >= _NMD_X86_ASM_MNEMONIC_JO && mnemonic <= _NMD_X86_ASM_MNEMONIC_JG;
+	const size_t length = _nmd_get_relative_branch_length(mode, mnemonic, is_short);
+	const int64_t disp = delta - (int64_t)length;
+	size_t offset = 0;
+
+	if (is_short)
 	{
+		if (mnemonic == _NMD_X86_ASM_MNEMONIC_CALL || disp < -0x80 || disp > 0x7f)
+			return 0;
 
+		b[0] = (uint8_t)(is_conditional ? 0x70 + (mnemonic - _NMD_X86_ASM_MNEMONIC_JO) : 0xeb);
+		b[1] = (uint8_t)disp;
+		return 2;
 	}
-	else if (_nmd_strstr(ai->s, "xrelease ") == ai->s)
+	else if (disp < -(int64_t)0x80000000 || disp > 0x7fffffff)
+		return 0;
+
+	if (mode == NMD_X86_MODE_16)
+		b[offset++] = 0x66;
+
+	if (is_conditional)
 	{
+		b[offset++] = 0x0f;
+		b[offset++] = (uint8_t)(0x80 + (mnemonic - _NMD_X86_ASM_MNEMONIC_JO));
+	}
+	else
+		b[offset++] = (uint8_t)(mnemonic == _NMD_X86_ASM_MNEMONIC_JMP ? 0xe9 : 0xe8);
+
+	*(int32_t*)(b + offset) = (int32_t)disp;
+	return length;
+}
 
+/* Assembles an instruction without operands. Returns the number of bytes written, or zero if 'mnemonic'(a member of '_NMD_X86_ASM_MNEMONIC') requires operands or is not valid in 'mode'. */
+NMD_ASSEMBLY_API size_t _nmd_assemble_without_operands(uint8_t* b, NMD_X86_MODE mode, uint8_t mnemonic)
+{
+	if (mnemonic >= _NMD_X86_ASM_MNEMONIC_INT3 && mnemonic <= _NMD_X86_ASM_MNEMONIC_STD)
+	{
+		b[0] = _nmd_x86_asm_op1_bytes[mnemonic - _NMD_X86_ASM_MNEMONIC_INT3];
+		return 1;
+	}
+	else if (mnemonic >= _NMD_X86_ASM_MNEMONIC_SYSCALL && mnemonic <= _NMD_X86_ASM_MNEMONIC_RSM)
+	{
+		b[0] = 0x0f;
+		b[1] = _nmd_x86_asm_op2_bytes[mnemonic - _NMD_X86_ASM_MNEMONIC_SYSCALL];
+		return 2;
 	}
 
-	/* Parse opcodes */
-	if (ai->mode == NMD_X86_MODE_64) /* Only x86-64. */
+	switch (mnemonic)
+	{
+	case _NMD_X86_ASM_MNEMONIC_PUSHFQ:
+	case _NMD_X86_ASM_MNEMONIC_POPFQ:
+		if (mode != NMD_X86_MODE_64)
+			return 0;
+		b[0] = mnemonic == _NMD_X86_ASM_MNEMONIC_PUSHFQ ? 0x9c : 0x9d;
+		return 1;
+	case _NMD_X86_ASM_MNEMONIC_IRETQ:
+	case _NMD_X86_ASM_MNEMONIC_CDQE:
+	case _NMD_X86_ASM_MNEMONIC_CQO:
+		if (mode != NMD_X86_MODE_64)
+			return 0;
+		b[0] = 0x48;
+		b[1] = mnemonic == _NMD_X86_ASM_MNEMONIC_IRETQ ? 0xcf : (mnemonic == _NMD_X86_ASM_MNEMONIC_CDQE ? 0x98 : 0x99);
+		return 2;
+	case _NMD_X86_ASM_MNEMONIC_PUSHAD:
+	case _NMD_X86_ASM_MNEMONIC_POPAD:
+	case _NMD_X86_ASM_MNEMONIC_PUSHFD:
+	case _NMD_X86_ASM_MNEMONIC_POPFD:
+	case _NMD_X86_ASM_MNEMONIC_PUSHA:
+	case _NMD_X86_ASM_MNEMONIC_POPA:
 	{
-		if (_nmd_strstr(ai->s, "mov "))
+		/* The 32-bit forms need the operand size prefix in 16-bit mode and the 16-bit forms need it in 32-bit mode */
+		const bool is_32bit_form = mnemonic == _NMD_X86_ASM_MNEMONIC_PUSHAD || mnemonic == _NMD_X86_ASM_MNEMONIC_POPAD || mnemonic == _NMD_X86_ASM_MNEMONIC_PUSHFD || mnemonic == _NMD_X86_ASM_MNEMONIC_POPFD;
+		size_t offset = 0;
+		if (mode == NMD_X86_MODE_64)
+			return 0;
+		if ((mode == NMD_X86_MODE_16) == is_32bit_form)
+			b[offset++] = 0x66;
+		switch (mnemonic)
 		{
-			const char* s = ai->s + 4;
-			if ((reg = _nmd_parse_regrxb((const char**)&s)))
-			{
-				ai->b[0] = 0x41;
-				ai->b[1] = 0xb0 + (reg - NMD_X86_REG_R8B);
-
-				if (*s++ != ',')
-					return 0;
-
-				if ((num_digits = _nmd_parse_number(s, &num)))
-				{
-					ai->b[2] = (uint8_t)num;
-					return 3;
-				}
-			}
+		case _NMD_X86_ASM_MNEMONIC_PUSHAD: case _NMD_X86_ASM_MNEMONIC_PUSHA: b[offset++] = 0x60; break;
+		case _NMD_X86_ASM_MNEMONIC_POPAD: case _NMD_X86_ASM_MNEMONIC_POPA: b[offset++] = 0x61; break;
+		case _NMD_X86_ASM_MNEMONIC_PUSHFD: b[offset++] = 0x9c; break;
+		default: b[offset++] = 0x9d; break;
 		}
-		else if (_nmd_strstr(ai->s, "push ") == ai->s || _nmd_strstr(ai->s, "pop ") == ai->s)
+		return offset;
+	}
+	case _NMD_X86_ASM_MNEMONIC_PUSHF:
+	case _NMD_X86_ASM_MNEMONIC_POPF:
+	case _NMD_X86_ASM_MNEMONIC_IRET:
+	case _NMD_X86_ASM_MNEMONIC_CBW:
+	case _NMD_X86_ASM_MNEMONIC_CWD:
+	{
+		/* 16-bit forms */
+		size_t offset = 0;
+		if (mode != NMD_X86_MODE_16)
+			b[offset++] = 0x66;
+		switch (mnemonic)
 		{
-			const bool is_push = ai->s[1] == 'u';
-			s = ai->s + (is_push ? 5 : 4);
-			if (((reg = _nmd_parse_reg64(&s))) && !*s)
-			{
-				ai->b[0] = (is_push ? 0x50 : 0x58) + reg % 8;
-				return 1;
-			}
-			else if ((reg = _nmd_parse_regrxw(&s)) && !*s)
-			{
-				ai->b[0] = 0x66;
-				ai->b[1] = 0x41;
-				ai->b[2] = (is_push ? 0x50 : 0x58) + reg % 8;
-				return 3;
-			}
-			else if (((reg = _nmd_parse_regrx(&s))) && !*s)
-			{
-				ai->b[0] = 0x41;
-				ai->b[1] = (is_push ? 0x50 : 0x58) + reg % 8;
-				return 2;
-			}
+		case _NMD_X86_ASM_MNEMONIC_PUSHF: b[offset++] = 0x9c; break;
+		case _NMD_X86_ASM_MNEMONIC_POPF: b[offset++] = 0x9d; break;
+		case _NMD_X86_ASM_MNEMONIC_IRET: b[offset++] = 0xcf; break;
+		case _NMD_X86_ASM_MNEMONIC_CBW: b[offset++] = 0x98; break;
+		default: b[offset++] = 0x99; break;
 		}
-		else if (_nmd_strstr(ai->s, "mov ") == ai->s)
-		{
-			ai->s += 4;
-			if ((reg = _nmd_parse_reg8((const char**)&ai->s)))
-			{
-				ai->b[0] = 0xb0 + reg % 8;
+		return offset;
+	}
+	case _NMD_X86_ASM_MNEMONIC_IRETD:
+	case _NMD_X86_ASM_MNEMONIC_CWDE:
+	case _NMD_X86_ASM_MNEMONIC_CDQ:
+	{
+		/* 32-bit forms */
+		size_t offset = 0;
+		if (mode == NMD_X86_MODE_16)
+			b[offset++] = 0x66;
+		b[offset++] = mnemonic == _NMD_X86_ASM_MNEMONIC_IRETD ? 0xcf : (mnemonic == _NMD_X86_ASM_MNEMONIC_CWDE ? 0x98 : 0x99);
+		return offset;
+	}
+	case _NMD_X86_ASM_MNEMONIC_PAUSE:
+		b[0] = 0xf3;
+		b[1] = 0x90;
+		return 2;
+	}
 
-				if (*ai->s++ != ',')
-					return 0;
+	return 0;
+}
 
-				if ((num_digits = _nmd_parse_number(ai->s, &num)))
-				{
-					ai->b[1] = (uint8_t)num;
-					return 2;
-				}
-			}
-		}
-		else if (_nmd_strcmp(ai->s, "xchg r8,rax") || _nmd_strcmp(ai->s, "xchg rax,r8"))
-		{
-			ai->b[0] = 0x49;
-			ai->b[1] = 0x90;
-			return 2;
-		}
-		else if (_nmd_strcmp(ai->s, "xchg r8d,eax") || _nmd_strcmp(ai->s, "xchg eax,r8d"))
-		{
-			ai->b[0] = 0x41;
-			ai->b[1] = 0x90;
-			return 2;
-		}
-		else if (_nmd_strcmp(ai->s, "pushfq"))
-		{
-			ai->b[0] = 0x9c;
-			return 1;
-		}
-		else if (_nmd_strcmp(ai->s, "popfq"))
-		{
-			ai->b[0] = 0x9d;
-			return 1;
-		}
-		else if (_nmd_strcmp(ai->s, "iretq"))
-		{
-			ai->b[0] = 0x48;
-			ai->b[1] = 0xcf;
-			return 2;
-		}
-		else if (_nmd_strcmp(ai->s, "cdqe"))
+/* Assembles the instruction whose mnemonic is the first 'length' characters of 'ai->s'. Prefixes were already parsed by _nmd_assemble_single(). */
+NMD_ASSEMBLY_API size_t _nmd_assemble_instruction(_nmd_assemble_info* ai, uint8_t mnemonic, size_t length)
+{
+	const char* s;
+	int64_t num;
+	size_t num_digits;
+	NMD_X86_REG reg, reg2;
+	size_t i = 0;
+
+	if (!mnemonic || (ai->s[length] != ' ' && ai->s[length] != '\0'))
+		return 0;
+
+	/* Make 'ai->s' point to the operands. It's an empty string if the instruction has no operands */
+	ai->s += ai->s[length] == ' ' ? length + 1 : length;
+
+	if (!*ai->s)
+		return _nmd_assemble_without_operands(ai->b, ai->mode, mnemonic);
+
+	/* Parse 'add', 'adc', 'and', 'xor', 'or', 'sbb', 'sub' and 'cmp' . Opcodes in first "4 rows"/[80, 83] */
+	if (mnemonic >= _NMD_X86_ASM_MNEMONIC_ADD && mnemonic <= _NMD_X86_ASM_MNEMONIC_CMP)
+	{
+		i = mnemonic - _NMD_X86_ASM_MNEMONIC_ADD;
+		const uint8_t base_opcode = (i % 4) * 0x10 + (i >= 4 ? 8 : 0);
+
+		nmd_x86_memory_operand memory_operand;
+		size_t pointer_size, offset = 0, size;
+		if (_nmd_parse_memory_operand((const char**)&ai->s, &memory_operand, &pointer_size)) /* Colum 00,01,08,09 */
 		{
-			ai->b[0] = 0x48;
-			ai->b[1] = 0x98;
-			return 2;
+			if (*ai->s++ != ',' || !(reg = _nmd_parse_reg((const char**)&ai->s)) || *ai->s)
+				return 0;
+
+			size = _nmd_get_gpr_size(reg);
+			if (pointer_size && pointer_size != size)
+				return 0;
+
+			return _nmd_assemble_mem_reg(ai->b, ai->mode, &memory_operand, base_opcode + (size == 1 ? 0 : 1), _nmd_get_gpr_index(reg), size, _nmd_is_high_byte_reg(reg) ? _NMD_BYTE_REGS_HIGH : _NMD_BYTE_REGS_NONE);
 		}
-		else if (_nmd_strcmp(ai->s, "cqo"))
+		else if (_nmd_strstr_ex(ai->s, "al,", &s) == ai->s && _nmd_parse_immediate(s, &num)) /* column 04,0C */
 		{
-			ai->b[0] = 0x48;
-			ai->b[1] = 0x99;
+			if (num < -0x80 || num > 0xff)
+				return 0;
+
+			ai->b[0] = base_opcode + 4;
+			ai->b[1] = (int8_t)num;
 			return 2;
 		}
-	}
-	else /* x86-16 / x86-32 */
-	{
-		if (_nmd_strstr(ai->s, "inc ") || _nmd_strstr(ai->s, "dec "))
+		else if ((_nmd_strstr_ex(ai->s, "eax,", &s) == ai->s || _nmd_strstr_ex(ai->s, "ax,", &s) == ai->s || _nmd_strstr_ex(ai->s, "rax,", &s) == ai->s) && _nmd_parse_immediate(s, &num)) /* column 05,0D */
 		{
-			const bool is_inc = ai->s[0] == 'i';
-			s = ai->s + 4;
-			int offset = 0;
-			if (((reg = _nmd_parse_reg32(&s))) && !*s)
+			size = ai->s[0] == 'e' ? 4 : (ai->s[0] == 'r' ? 8 : 2);
+			if (!_nmd_append_operand_size_prefixes(ai->b, &offset, ai->mode, size, 0, _NMD_BYTE_REGS_NONE))
+				return 0;
+
+			/* A sign-extended 8-bit immediate is shorter(83 /r), the same choice nmd_x86_encode() makes */
+			if (num >= -0x80 && num <= 0x7f)
 			{
-				if (ai->mode == NMD_X86_MODE_16)
-					ai->b[offset++] = 0x66;
+				ai->b[offset++] = 0x83;
+				ai->b[offset++] = (uint8_t)(0b11000000 | base_opcode); /* ModR/M.reg is the opcode's row */
+				ai->b[offset++] = (uint8_t)num;
+				return offset;
 			}
-			else if (((reg = _nmd_parse_reg16(&s))) && !*s)
+
+			ai->b[offset++] = base_opcode + 5;
+
+			if (size == 2)
 			{
-				if (ai->mode == NMD_X86_MODE_32)
-					ai->b[offset++] = 0x66;
+				if (num < -0x8000 || num > 0xffff)
+					return 0;
+
+				*(int16_t*)(ai->b + offset) = (int16_t)num;
+				return offset + 2;
 			}
 			else
-				return 0;
+			{
+				/* The 64-bit form sign-extends the 32-bit immediate */
+				if (num < -(int64_t)0x80000000 || num > (size == 8 ? 0x7fffffff : 0xffffffff))
+					return 0;
 
-			ai->b[offset++] = (is_inc ? 0x40 : 0x48) + reg % 8;
-			return offset;
+				*(int32_t*)(ai->b + offset) = (int32_t)num;
+				return offset + 4;
+			}
 		}
-		else if (_nmd_strstr(ai->s, "push ") == ai->s || _nmd_strstr(ai->s, "pop ") == ai->s)
+		else if ((reg = _nmd_parse_reg((const char**)&ai->s)) && *ai->s++ == ',') /* column 00-04,08-0B */
 		{
-			const bool is_push = ai->s[1] == 'u';
-			s = ai->s + (is_push ? 5 : 4);
-			if (((reg = _nmd_parse_reg32(&s))) && !*s)
+			if (_nmd_parse_memory_operand((const char**)&ai->s, &memory_operand, &pointer_size)) /* column 02,03,0A,0B */
 			{
-				if (ai->mode == NMD_X86_MODE_16)
-				{
-					ai->b[0] = 0x66;
-					ai->b[1] = (is_push ? 0x50 : 0x58) + reg % 8;
-					return 2;
-				}
-				else
-				{
-					ai->b[0] = (is_push ? 0x50 : 0x58) + reg % 8;
-					return 1;
-				}
+				return 0;
+			}
+			else /* 00,01,08,09 */
+			{
+				if (!(reg2 = _nmd_parse_reg((const char**)&ai->s)) || *ai->s)
+					return 0;
+
+				size = _nmd_get_gpr_size(reg);
+				if (size != _nmd_get_gpr_size(reg2))
+					return 0;
+
+				const uint8_t index = _nmd_get_gpr_index(reg), index2 = _nmd_get_gpr_index(reg2);
+				if (!_nmd_append_operand_size_prefixes(ai->b, &offset, ai->mode, size, (index2 & 8 ? 0x04 : 0) | (index & 8 ? 0x01 : 0), (_nmd_is_high_byte_reg(reg) || _nmd_is_high_byte_reg(reg2)) ? _NMD_BYTE_REGS_HIGH : _NMD_BYTE_REGS_NONE))
+					return 0;
+
+				ai->b[offset++] = base_opcode + (size == 1 ? 0 : 1);
+
+				/* mod = 0b11, reg = reg2, rm = reg */
+				ai->b[offset++] = 0b11000000 | ((index2 % 8) << 3) | (index % 8);
+
+				return offset;
 			}
 		}
-		else if (_nmd_strcmp(ai->s, "pushad"))
+
+		return 0;
+	}
+
+	/* Parse conditional jumps. The shortest encoding is used */
+	if (mnemonic >= _NMD_X86_ASM_MNEMONIC_JO && mnemonic <= _NMD_X86_ASM_MNEMONIC_JG)
+	{
+		if (!_nmd_parse_immediate(ai->s, &num))
+			return 0;
+
+		const int64_t delta = (ai->runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? num : num - (int64_t)ai->runtime_address);
+		length = _nmd_assemble_relative_branch(ai->b, ai->mode, mnemonic, delta, true);
+		return length ? length : _nmd_assemble_relative_branch(ai->b, ai->mode, mnemonic, delta, false);
+	}
+
+	switch (mnemonic)
+	{
+	case _NMD_X86_ASM_MNEMONIC_MOV:
+		s = ai->s;
+		if (ai->mode == NMD_X86_MODE_64 && (reg = _nmd_parse_regrxb(&s)))
 		{
-			if (ai->mode == NMD_X86_MODE_16)
+			ai->b[0] = 0x41;
+			ai->b[1] = 0xb0 + (reg - NMD_X86_REG_R8B);
+
+			if (*s++ != ',')
+				return 0;
+
+			if (_nmd_parse_immediate(s, &num))
 			{
-				ai->b[0] = 0x66;
-				ai->b[1] = 0x60;
-				return 2;
+				ai->b[2] = (uint8_t)num;
+				return 3;
 			}
-			else
+			return 0;
+		}
+		else if ((reg = _nmd_parse_reg8(&s)))
+		{
+			ai->b[0] = 0xb0 + (reg - NMD_X86_REG_AL);
+
+			if (*s++ != ',')
+				return 0;
+
+			if (_nmd_parse_immediate(s, &num))
 			{
-				ai->b[0] = 0x60;
-				return 1;
+				ai->b[1] = (uint8_t)num;
+				return 2;
 			}
 		}
-		else if (_nmd_strcmp(ai->s, "pusha"))
+		return 0;
+
+	case _NMD_X86_ASM_MNEMONIC_PUSH:
+	case _NMD_X86_ASM_MNEMONIC_POP:
+	{
+		const bool is_push = mnemonic == _NMD_X86_ASM_MNEMONIC_PUSH;
+		s = ai->s;
+		if (ai->mode == NMD_X86_MODE_64)
 		{
-			if (ai->mode == NMD_X86_MODE_16)
+			if ((reg = _nmd_parse_reg64(&s)) && !*s)
 			{
-				ai->b[0] = 0x60;
+				ai->b[0] = (is_push ? 0x50 : 0x58) + reg % 8;
 				return 1;
 			}
-			else
+			else if ((reg = _nmd_parse_regrxw(&s)) && !*s)
 			{
 				ai->b[0] = 0x66;
-				ai->b[1] = 0x60;
+				ai->b[1] = 0x41;
+				ai->b[2] = (is_push ? 0x50 : 0x58) + reg % 8;
+				return 3;
+			}
+			else if ((reg = _nmd_parse_regrx(&s)) && !*s)
+			{
+				ai->b[0] = 0x41;
+				ai->b[1] = (is_push ? 0x50 : 0x58) + reg % 8;
 				return 2;
 			}
 		}
-		else if (_nmd_strcmp(ai->s, "popad"))
+		else if ((reg = _nmd_parse_reg32(&s)) && !*s)
 		{
 			if (ai->mode == NMD_X86_MODE_16)
 			{
 				ai->b[0] = 0x66;
-				ai->b[1] = 0x61;
+				ai->b[1] = (is_push ? 0x50 : 0x58) + reg % 8;
 				return 2;
 			}
 			else
 			{
-				ai->b[0] = 0x61;
+				ai->b[0] = (is_push ? 0x50 : 0x58) + reg % 8;
 				return 1;
 			}
 		}
-		else if (_nmd_strcmp(ai->s, "popa"))
+
+		s = ai->s;
+		if ((reg = _nmd_parse_reg_range(&s, NMD_X86_REG_ES, NMD_X86_REG_GS)) && !*s)
 		{
-			if (ai->mode == NMD_X86_MODE_16)
+			if (reg == NMD_X86_REG_FS || reg == NMD_X86_REG_GS)
 			{
-				ai->b[0] = 0x61;
-				return 1;
+				ai->b[0] = 0x0f;
+				ai->b[1] = (reg == NMD_X86_REG_FS ? 0xa0 : 0xa8) + (is_push ? 0 : 1);
+				return 2;
 			}
-			else
+			else if (is_push || reg != NMD_X86_REG_CS)
 			{
-				ai->b[0] = 0x66;
-				ai->b[1] = 0x61;
-				return 2;
+				ai->b[0] = 0x06 + (uint8_t)(reg - NMD_X86_REG_ES) * 8 + (is_push ? 0 : 1);
+				return 1;
 			}
+			return 0;
 		}
-		else if (_nmd_strcmp(ai->s, "pushfd"))
+
+		if ((reg = _nmd_parse_reg16((const char**)&ai->s)))
 		{
 			if (ai->mode == NMD_X86_MODE_16)
 			{
-				ai->b[0] = 0x66;
-				ai->b[1] = 0x9c;
-				return 2;
+				ai->b[0] = (is_push ? 0x50 : 0x58) + reg % 8;
+				return 1;
 			}
 			else
 			{
-				ai->b[0] = 0x9c;
-				return 1;
+				ai->b[0] = 0x66;
+				ai->b[1] = (is_push ? 0x50 : 0x58) + reg % 8;
+				return 2;
 			}
 		}
-		else if (_nmd_strcmp(ai->s, "popfd"))
+		else if (is_push && _nmd_parse_immediate(ai->s, &num))
 		{
-			if (ai->mode == NMD_X86_MODE_16)
+			if (num >= -(1 << 7) && num <= (1 << 7) - 1)
 			{
-				ai->b[0] = 0x66;
-				ai->b[1] = 0x9d;
+				ai->b[0] = 0x6a;
+				*(int8_t*)(ai->b + 1) = (int8_t)num;
 				return 2;
 			}
 			else
 			{
-				ai->b[0] = 0x9d;
-				return 1;
+				size_t offset = 0;
+				if (ai->mode == NMD_X86_MODE_16)
+					ai->b[offset++] = 0x66;
+				ai->b[offset++] = 0x68;
+				*(int32_t*)(ai->b + offset) = (int32_t)num;
+				return offset + 4;
 			}
 		}
+		return 0;
 	}
 
-	typedef struct _nmd_string_byte_pair { const char* s; uint8_t b; } _nmd_string_byte_pair;
-
-	const _nmd_string_byte_pair single_byte_op1[] = {
-		{ "int3",    0xcc },
-		{ "nop",     0x90 },
-		{ "ret",     0xc3 },
-		{ "retf",    0xcb },
-		{ "ret far", 0xcb },
-		{ "leave",   0xc9 },
-		{ "int1",    0xf1 },
-		{ "push es", 0x06 },
-		{ "push ss", 0x16 },
-		{ "push ds", 0x1e },
-		{ "push cs", 0x0e },
-		{ "pop es",  0x07 },
-		{ "pop ss",  0x17 },
-		{ "pop ds",  0x1f },
-		{ "daa",     0x27 },
-		{ "aaa",     0x37 },
-		{ "das",     0x2f },
-		{ "aas",     0x3f },
-		{ "xlat",    0xd7 },
-		{ "fwait",   0x9b },
-		{ "hlt",     0xf4 },
-		{ "cmc",     0xf5 },
-		{ "clc",     0xf8 },
-		{ "sahf",    0x9e },
-		{ "lahf",    0x9f },
-		{ "into",    0xce },
-		{ "salc",    0xd6 },
-		{ "slc",     0xf8 },
-		{ "stc",     0xf9 },
-		{ "cli",     0xfa },
-		{ "sti",     0xfb },
-		{ "cld",     0xfc },
-		{ "std",     0xfd },
-	};
-	for (i = 0; i < _NMD_NUM_ELEMENTS(single_byte_op1); i++)
-	{
-		if (_nmd_strcmp(ai->s, single_byte_op1[i].s))
-		{
-			ai->b[0] = single_byte_op1[i].b;
-			return 1;
+	case _NMD_X86_ASM_MNEMONIC_XCHG:
+		if (ai->mode != NMD_X86_MODE_64)
+			return 0;
+		else if (_nmd_strcmp(ai->s, "r8,rax") || _nmd_strcmp(ai->s, "rax,r8"))
+		{
+			ai->b[0] = 0x49;
+			ai->b[1] = 0x90;
+			return 2;
 		}
-	}
-
-	const _nmd_string_byte_pair single_byte_op2[] = {
-		{ "syscall",  0x05 },
-		{ "clts",     0x06 },
-		{ "sysret",   0x07 },
-		{ "invd",     0x08 },
-		{ "wbinvd",   0x09 },
-		{ "ud2",      0x0b },
-		{ "femms",    0x0e },
-		{ "wrmsr",    0x30 },
-		{ "rdtsc",    0x31 },
-		{ "rdmsr",    0x32 },
-		{ "rdpmc",    0x33 },
-		{ "sysenter", 0x34 },
-		{ "sysexit",  0x35 },
-		{ "getsec",   0x37 },
-		{ "emms",     0x77 },
-		{ "push fs",  0xa0 },
-		{ "pop fs",   0xa1 },
-		{ "cpuid",    0xa2 },
-		{ "push gs",  0xa8 },
-		{ "pop gs",   0xa9 },
-		{ "rsm",      0xaa }
-	};
-	for (i = 0; i < _NMD_NUM_ELEMENTS(single_byte_op2); i++)
-	{
-		if (_nmd_strcmp(ai->s, single_byte_op2[i].s))
-		{
-			ai->b[0] = 0x0f;
-			ai->b[1] = single_byte_op2[i].b;
+		else if (_nmd_strcmp(ai->s, "r8d,eax") || _nmd_strcmp(ai->s, "eax,r8d"))
+		{
+			ai->b[0] = 0x41;
+			ai->b[1] = 0x90;
 			return 2;
 		}
-	}
-	
-	/* Parse 'add', 'adc', 'and', 'xor', 'or', 'sbb', 'sub' and 'cmp' . Opcodes in first "4 rows"/[80, 83] */
-	for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_op1_opcode_map_mnemonics); i++)
+		return 0;
+
+	case _NMD_X86_ASM_MNEMONIC_INC:
+	case _NMD_X86_ASM_MNEMONIC_DEC:
 	{
-		if (_nmd_strstr(ai->s, _nmd_op1_opcode_map_mnemonics[i]) == ai->s)
+		const bool is_inc = mnemonic == _NMD_X86_ASM_MNEMONIC_INC;
+		if (ai->mode != NMD_X86_MODE_64)
 		{
-			const uint8_t base_opcode = (i % 4) * 0x10 + (i >= 4 ? 8 : 0);
-			ai->s += 4;
-            
-			nmd_x86_memory_operand memory_operand;
-			size_t pointer_size;
-			if (_nmd_parse_memory_operand((const char**)&ai->s, &memory_operand, &pointer_size)) /* Colum 00,01,08,09 */
-			{                
-				if (*ai->s++ != ',' || !(reg = _nmd_parse_reg((const char**)&ai->s)))
-					return 0;
-                
-				return _nmd_assemble_mem_reg(ai->b, &memory_operand, base_opcode, reg % 8);
-
-				/*
-				size_t offset = 0;
-				if (memory_operand.segment && memory_operand.segment != ((memory_operand.base == NMD_X86_REG_ESP || memory_operand.index == NMD_X86_REG_ESP) ? NMD_X86_REG_SS : NMD_X86_REG_DS))
-					ai->b[offset++] = _nmd_encode_segment_reg((NMD_X86_REG)memory_operand.segment);
-				
-				if (pointer_size == 1)
-				{
-					ai->b[offset++] = base_opcode + 0;
-				
-					if (*ai->s++ != ',')
-						return 0;
-				
-					NMD_X86_REG reg = _nmd_parse_reg(&ai->s);
-				
-					nmd_x86_modrm modrm;
-					modrm.fields.mod = 0;
-					modrm.fields.reg = (reg - 1) % 8;
-					modrm.fields.rm = (memory_operand.base - 1) % 8;
-				
-					ai->b[offset++] = modrm.modrm;
-				
-					return offset;
-				}
-				*/
-			}
-            else if (_nmd_strstr_ex(ai->s, "al,", &s) == ai->s && (num_digits = _nmd_parse_number(s, &num)) && *(s + num_digits) == '\0') /* column 04,0C */
+			s = ai->s;
+			int offset = 0;
+			if (((reg = _nmd_parse_reg32(&s))) && !*s)
 			{
-				if (num < -0x80 || num > 0xff)
-					return 0;
-
-				ai->b[0] = base_opcode + 4;
-				ai->b[1] = (int8_t)num;
-				return 2;
+				if (ai->mode == NMD_X86_MODE_16)
+					ai->b[offset++] = 0x66;
+				ai->b[offset++] = (is_inc ? 0x40 : 0x48) + reg % 8;
+				return offset;
 			}
-			else if ((_nmd_strstr_ex(ai->s, "eax,", &s) == ai->s || _nmd_strstr_ex(ai->s, "ax,", &s) == ai->s || _nmd_strstr_ex(ai->s, "rax,", &s) == ai->s) && _nmd_parse_number(s, &num)) /* column 05,0D */
+			else if (((reg = _nmd_parse_reg16(&s))) && !*s)
 			{
-				const bool is_eax = ai->s[0] == 'e';
-				const bool is_ax = ai->s[1] == 'x';
-
-				if (is_eax)
-				{
-					if (num < -(int64_t)0x80000000 || num > 0xffffffff)
-						return 0;
-
-					ai->b[0] = base_opcode + 5;
-					*(int32_t*)(ai->b + 1) = (int32_t)num;
-					return 5;
-				}
-				else if (!is_eax)
-				{
-					if (ai->mode != NMD_X86_MODE_64 && !is_ax)
-						return 0;
-
-					ai->b[0] = is_ax ? 0x66 : 0x48;
-					ai->b[1] = base_opcode + 5;
+				if (ai->mode == NMD_X86_MODE_32)
+					ai->b[offset++] = 0x66;
+				ai->b[offset++] = (is_inc ? 0x40 : 0x48) + reg % 8;
+				return offset;
+			}
+		}
 
-					if (is_ax)
-					{
-						if (num < -0x8000 || num > 0xffff)
-							return 0;
+		const char* tmp = ai->s;
+		nmd_x86_memory_operand memory_operand;
+		size_t size;
+		if (_nmd_parse_memory_operand(&tmp, &memory_operand, &size))
+		{
+			if (*tmp)
+				return 0;
 
-						*(int16_t*)(ai->b + 2) = (int16_t)num;
-						return 4;
-					}
-					else
-					{
-						if (num < -(int64_t)0x80000000 || num > 0xffffffff)
-							return 0;
+			/* The operand is a dword if the pointer size is not specified */
+			return _nmd_assemble_mem_reg(ai->b, ai->mode, &memory_operand, size == 1 ? 0xfe : 0xff, is_inc ? 0 : 1, size ? size : 4, _NMD_BYTE_REGS_NONE);
+		}
 
-						*(int32_t*)(ai->b + 2) = (int32_t)num;
-						return 6;
-					}
-				}
-			}
-            else if ((reg = _nmd_parse_reg((const char**)&ai->s)) && *ai->s++ == ',') /* column 00-04,08-0B */
-            {
-                if(_nmd_parse_memory_operand((const char**)&ai->s, &memory_operand, &pointer_size)) /* column 02,03,0A,0B */
-                {
-                    return 0;
-                }
-                else /* 00,01,08,09 */
-                {
-                    if(!(reg2 = _nmd_parse_reg((const char**)&ai->s)))
-                        return 0;
-                    
-                    ai->b[0] = base_opcode;
-                    
-                    /* mod = 0b11, reg = reg2, rm = reg */
-                    ai->b[1] = 0b11000000 | ((reg2 % 8) << 3) | (reg % 8);
-                    
-                    return 2;
-                }
-            }
+		size_t num_prefixes, index;
+		size = _nmd_append_prefix_by_reg_size(ai->b, ai->s, &num_prefixes, &index);
+		if (size > 0)
+		{
+			/* Only 8-bit registers reach here in 16-bit and 32-bit mode, the other prefixes are REX prefixes */
+			if (ai->mode != NMD_X86_MODE_64 && num_prefixes)
+				return 0;
 
-			return 0;
+			ai->b[num_prefixes + 0] = size == 1 ? 0xfe : 0xff;
+			ai->b[num_prefixes + 1] = 0xc0 + (is_inc ? 0 : 8) + (uint8_t)index;
+			return num_prefixes + 2;
 		}
+		return 0;
 	}
 
-	if (_nmd_strstr(ai->s, "jmp ") == ai->s)
-	{
-		if (!(num_digits = _nmd_parse_number(ai->s + 4, &num)) && ai->s[4 + num_digits] == '\0')
+	case _NMD_X86_ASM_MNEMONIC_JMP:
+	case _NMD_X86_ASM_MNEMONIC_CALL:
+		if (!_nmd_parse_immediate(ai->s, &num))
 			return 0;
+		return _nmd_assemble_relative_branch(ai->b, ai->mode, mnemonic, ai->runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? num : num - (int64_t)ai->runtime_address, false);
 
-		size_t offset = 0;
-		if (ai->mode == NMD_X86_MODE_16)
-			ai->b[offset++] = 0x66;
-		ai->b[offset++] = 0xe9;
-		const int64_t size = (int64_t)offset + 4;
-		*(uint32_t*)(ai->b + offset) = (uint32_t)((ai->runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS) ? (num - size) : (ai->runtime_address + size + num));
-		return size;
-	}
-	else if (ai->s[0] == 'j')
+	case _NMD_X86_ASM_MNEMONIC_RET:
+	case _NMD_X86_ASM_MNEMONIC_RETF:
 	{
-		char* s = ai->s;
-		while (true)
+		const bool is_far = mnemonic == _NMD_X86_ASM_MNEMONIC_RETF;
+		if (!is_far && _nmd_strcmp(ai->s, "far"))
 		{
-			if (*s == ' ')
-			{
-				*s = '\0';
-				break;
-			}
-			else if (*s == '\0')
-				return 0;
-
-			s++;
-		}
-
-		for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_condition_suffixes); i++)
-		{
-			if (_nmd_strcmp(ai->s + 1, _nmd_condition_suffixes[i]))
-			{
-				if (!(num_digits = _nmd_parse_number(s + 1, &num)))
-					return 0;
-
-				const int64_t delta = (ai->runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? num : num - ai->runtime_address);
-				if (delta >= -(1 << 7) + 2 && delta <= (1 << 7) - 1 + 2)
-				{
-					ai->b[0] = 0x70 + (uint8_t)i;
-					*(int8_t*)(ai->b + 1) = (int8_t)(delta - 2);
-					return 2;
-				}
-				else if (delta >= -((int64_t)1 << 31) + 6 && delta <= ((int64_t)1 << 31) - 1 + 6)
-				{
-					size_t offset = 0;
-					if (ai->mode == NMD_X86_MODE_16)
-						ai->b[offset++] = 0x66;
-
-					ai->b[offset++] = 0x0f;
-					ai->b[offset++] = 0x80 + (uint8_t)i;
-					*(int32_t*)(ai->b + offset) = (int32_t)(delta - (offset+4));
-					return offset + 4;
-				}
-			}
-		}
-	}
-	else if (_nmd_strstr(ai->s, "inc ") == ai->s || _nmd_strstr(ai->s, "dec ") == ai->s)
-	{
-		const char* tmp = ai->s + 4;
-		nmd_x86_memory_operand memory_operand;
-		size_t size;
-		if (_nmd_parse_memory_operand(&tmp, &memory_operand, &size))
-		{
-			size_t offset = 0;
-			if (memory_operand.segment && memory_operand.segment != ((memory_operand.base == NMD_X86_REG_ESP || memory_operand.index == NMD_X86_REG_ESP) ? NMD_X86_REG_SS : NMD_X86_REG_DS))
-				ai->b[offset++] = _nmd_encode_segment_reg((NMD_X86_REG)memory_operand.segment);
-
-			ai->b[offset++] = size == 1 ? 0xfe : 0xff;
-
-			nmd_x86_modrm modrm;
-			modrm.fields.reg = ai->s[0] == 'i' ? 0 : 8;
-			modrm.fields.mod = 0;
-
-			if (memory_operand.index != NMD_X86_REG_NONE && memory_operand.base != NMD_X86_REG_NONE)
-			{
-				modrm.fields.rm = 0b100;
-				nmd_x86_sib sib;
-				sib.fields.scale = (uint8_t)_nmd_get_bit_index(memory_operand.scale);
-				sib.fields.base = memory_operand.base - NMD_X86_REG_EAX;
-				sib.fields.index = memory_operand.index - NMD_X86_REG_EAX;
-
-				const size_t next_offset = offset;
-				if (memory_operand.disp != 0)
-				{
-					if (memory_operand.disp >= -128 && memory_operand.disp <= 127)
-					{
-						modrm.fields.mod = 1;
-						*(int8_t*)(ai->b + offset + 2) = (int8_t)memory_operand.disp;
-						offset++;
-					}
-					else
-					{
-						modrm.fields.mod = 2;
-						*(int32_t*)(ai->b + offset + 2) = (int32_t)memory_operand.disp;
-						offset += 4;
-					}
-				}
-
-				ai->b[next_offset] = modrm.modrm;
-				ai->b[next_offset + 1] = sib.sib;
-				offset += 2;
-
-				return offset;
-			}
-			else if (memory_operand.base != NMD_X86_REG_NONE)
-			{
-				modrm.fields.rm = memory_operand.base - NMD_X86_REG_EAX;
-				const size_t next_offset = offset;
-				if (memory_operand.disp != 0)
-				{
-					if (memory_operand.disp >= -128 && memory_operand.disp <= 127)
-					{
-						modrm.fields.mod = 1;
-						*(int8_t*)(ai->b + offset + 1) = (int8_t)memory_operand.disp;
-						offset++;
-					}
-					else
-					{
-						modrm.fields.mod = 2;
-						*(int32_t*)(ai->b + offset + 1) = (int32_t)memory_operand.disp;
-						offset += 4;
-					}
-				}
-				ai->b[next_offset] = modrm.modrm;
-				offset++;
-			}
-			else
-			{
-				modrm.fields.rm = 0b101;
-				ai->b[offset++] = modrm.modrm;
-				*(int32_t*)(ai->b + offset) = (int32_t)memory_operand.disp;
-				offset += 4;
-			}
-
-			return offset;
-		}
-
-		size_t num_prefixes, index;
-		size = _nmd_append_prefix_by_reg_size(ai->b, ai->s + 4, &num_prefixes, &index);
-		if (size > 0)
-		{
-			if (ai->mode == NMD_X86_MODE_64)
-			{
-				ai->b[num_prefixes + 0] = size == 1 ? 0xfe : 0xff;
-				ai->b[num_prefixes + 1] = 0xc0 + (ai->s[0] == 'i' ? 0 : 8) + (uint8_t)index;
-				return num_prefixes + 2;
-			}
-			else
-			{
-				if (size == 1)
-				{
-					ai->b[0] = 0xfe;
-					ai->b[1] = 0xc0 + (ai->s[0] == 'i' ? 0 : 8) + (uint8_t)index;
-					return 2;
-				}
-				else
-				{
-					ai->b[num_prefixes + 0] = (ai->s[0] == 'i' ? 0x40 : 0x48) + (uint8_t)index;
-					return num_prefixes + 1;
-				}
-			}
-		}
-	}
-	else if (_nmd_strstr(ai->s, "call ") == ai->s)
-	{
-		if ((num_digits = _nmd_parse_number(ai->s + 5, &num)))
-		{
-			ai->b[0] = 0xe8;
-			if(ai->runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS)
-				*(int32_t*)(ai->b + 1) = (int32_t)(num - 5);
-			else
-				*(int32_t*)(ai->b + 1) = (int32_t)(num - (ai->runtime_address + 5));
-			return 5;
-		}
-	}
-	else if (_nmd_strstr(ai->s, "push ") == ai->s || _nmd_strstr(ai->s, "pop ") == ai->s)
-	{
-		const bool is_push = ai->s[1] == 'u';
-		ai->s += is_push ? 5 : 4;
-		NMD_X86_REG reg;
-		if ((reg = _nmd_parse_reg16((const char**)&ai->s)))
-		{
-			if (ai->mode == NMD_X86_MODE_16)
-			{
-				ai->b[0] = (is_push ? 0x50 : 0x58) + reg % 8;
-				return 1;
-			}
-			else
-			{
-				ai->b[0] = 0x66;
-				ai->b[1] = (is_push ? 0x50 : 0x58) + reg % 8;
-				return 2;
-			}
-		}
-		else if (is_push && (num_digits = _nmd_parse_number(ai->s, &num)) && ai->s[num_digits] == '\0')
-		{
-			if (num >= -(1 << 7) && num <= (1 << 7) - 1)
-			{
-				ai->b[0] = 0x6a;
-				*(int8_t*)(ai->b + 1) = (int8_t)num;
-				return 2;
-			}
-			else
-			{
-				size_t offset = 0;
-				if (ai->mode == NMD_X86_MODE_16)
-					ai->b[offset++] = 0x66;
-				ai->b[offset++] = 0x68;
-				*(int32_t*)(ai->b + offset) = (int32_t)num;
-				return offset + 4;
-			}
-		}
-	}
-	else if (_nmd_strstr(ai->s, "mov ") == ai->s)
-	{
-		ai->s += 4;
-		const NMD_X86_REG reg = _nmd_parse_reg8((const char**)&ai->s);
-		if (reg)
-		{
-			ai->b[0] = 0xb0 + (reg - NMD_X86_REG_AL);
-			
-			if (*ai->s++ != ',')
-				return 0;
-            
-			if ((num_digits = _nmd_parse_number(ai->s, &num)))
-			{
-				ai->b[1] = (uint8_t)num;
-				return 2;
-			}
+			ai->b[0] = 0xcb;
+			return 1;
 		}
-	}
-	else if (_nmd_strstr(ai->s, "ret ") == ai->s || _nmd_strstr(ai->s, "retf ") == ai->s)
-	{
-		const bool is_far = ai->s[3] == 'f';
-		ai->s += is_far ? 5 : 4;
-        
-		if ((num_digits = _nmd_parse_number(ai->s, &num)) && ai->s[num_digits] == '\0')
+		else if (_nmd_parse_immediate(ai->s, &num))
 		{
 			ai->b[0] = is_far ? 0xca : 0xc2;
 			*(uint16_t*)(ai->b + 1) = (uint16_t)num;
 			return 3;
 		}
+		return 0;
 	}
-	else if (_nmd_strstr(ai->s, "emit ") == ai->s)
+
+	case _NMD_X86_ASM_MNEMONIC_INT:
+		if (_nmd_parse_immediate(ai->s, &num))
+		{
+			ai->b[0] = 0xcd;
+			ai->b[1] = (uint8_t)num;
+			return 2;
+		}
+		return 0;
+
+	case _NMD_X86_ASM_MNEMONIC_EMIT:
 	{
-		size_t offset = 5;
+		size_t offset = 0;
 		while ((num_digits = _nmd_parse_number(ai->s + offset, &num)))
 		{
-			if (num < 0 || num > 0xff)
+			if (num < 0 || num > 0xff || i == NMD_X86_MAXIMUM_INSTRUCTION_LENGTH)
 				return 0;
 
 			ai->b[i++] = (uint8_t)num;
@@ -4068,124 +5263,97 @@ NMD_ASSEMBLY_API size_t _nmd_assemble_single(_nmd_assemble_info* ai)
 		}
 		return i;
 	}
-	else if (_nmd_strcmp(ai->s, "pushf"))
-	{
-		if (ai->mode == NMD_X86_MODE_16)
-		{
-			ai->b[0] = 0x9c;
-			return 1;
-		}
-		else
-		{
-			ai->b[0] = 0x66;
-			ai->b[1] = 0x9c;
-			return 2;
-		}
-	}
-	else if (_nmd_strcmp(ai->s, "popf"))
-	{
-		if (ai->mode == NMD_X86_MODE_16)
-		{
-			ai->b[0] = 0x9d;
-			return 1;
-		}
-		else
-		{
-			ai->b[0] = 0x66;
-			ai->b[1] = 0x9d;
-			return 2;
-		}
-	}
-	else if (_nmd_strcmp(ai->s, "pause"))
-	{
-		ai->b[0] = 0xf3;
-		ai->b[1] = 0x90;
-		return 2;
-	}
-	else if (_nmd_strcmp(ai->s, "iret"))
-	{
-		if (ai->mode == NMD_X86_MODE_16)
-		{
-			ai->b[0] = 0xcf;
-			return 1;
-		}
-		else
-		{
-			ai->b[0] = 0x66;
-			ai->b[1] = 0xcf;
-			return 2;
-		}
 	}
-	else if (_nmd_strcmp(ai->s, "iretd"))
+
+	return 0;
+}
+
+/* Assembles a single instruction, which may have the 'lock' prefix and one of the 'rep', 'repe', 'repz', 'repne' and 'repnz' prefixes. Returns zero on failure. */
+NMD_ASSEMBLY_API size_t _nmd_assemble_single(_nmd_assemble_info* ai)
+{
+	uint8_t* const b = ai->b;
+	const uint64_t runtime_address = ai->runtime_address;
+	bool has_lock = false, has_repeat = false;
+	size_t length;
+	uint8_t mnemonic;
+
+	/* Encode the prefixes in the order they are written */
+	while (true)
 	{
-		if (ai->mode == NMD_X86_MODE_16)
+		length = _nmd_get_token_length(ai->s);
+		mnemonic = _nmd_find_asm_mnemonic(ai->s, length);
+		if (mnemonic < _NMD_X86_ASM_MNEMONIC_LOCK || mnemonic > _NMD_X86_ASM_MNEMONIC_REPNZ || ai->s[length] != ' ')
+			break;
+
+		if (mnemonic == _NMD_X86_ASM_MNEMONIC_LOCK)
 		{
-			ai->b[0] = 0x66;
-			ai->b[1] = 0xcf;
-			return 2;
+			if (has_lock)
+				return 0;
+			has_lock = true;
+			*ai->b++ = 0xf0;
 		}
 		else
 		{
-			ai->b[0] = 0xcf;
-			return 1;
-		}
-	}
-	else if (_nmd_strcmp(ai->s, "pushf"))
-	{
-		ai->b[0] = 0x66;
-		ai->b[1] = 0x9c;
-		return 2;
-	}
-	else if (_nmd_strcmp(ai->s, "popf"))
-	{
-		ai->b[0] = 0x66;
-		ai->b[1] = 0x9d;
-		return 2;
-	}
-	else if (_nmd_strcmp(ai->s, "cwde"))
-	{
-		int offset = 0;
-		if (ai->mode == NMD_X86_MODE_16)
-			ai->b[offset++] = 0x66;
-		ai->b[offset++] = 0x98;
-		return offset;
-	}
-	else if (_nmd_strstr(ai->s, "int ") == ai->s)
-	{
-		ai->s += 4;
-		if ((num_digits = _nmd_parse_number(ai->s, &num)) && ai->s[num_digits] == '\0')
-		{
-			ai->b[0] = 0xcd;
-			ai->b[1] = (uint8_t)num;
-			return 2;
+			if (has_repeat)
+				return 0;
+			has_repeat = true;
+			*ai->b++ = mnemonic >= _NMD_X86_ASM_MNEMONIC_REPNE ? 0xf2 : 0xf3;
 		}
+
+		ai->s += length + 1;
 	}
-	else if (_nmd_strcmp(ai->s, "cbw"))
-	{
-		int offset = 0;
-		if (ai->mode != NMD_X86_MODE_16)
-			ai->b[offset++] = 0x66;
-		ai->b[offset++] = 0x98;
-		return offset;
-	}
-	else if (_nmd_strcmp(ai->s, "cdq"))
-	{
-		int offset = 0;
-		if (ai->mode == NMD_X86_MODE_16)
-			ai->b[offset++] = 0x66;
-		ai->b[offset++] = 0x99;
-		return offset;
-	}
-	else if (_nmd_strcmp(ai->s, "cwd"))
+
+	/* Relative branches are relative to the end of the instruction, prefixes included */
+	if (runtime_address != NMD_X86_INVALID_RUNTIME_ADDRESS)
+		ai->runtime_address += (size_t)(ai->b - b);
+
+	length = _nmd_assemble_instruction(ai, mnemonic, length);
+	if (length)
+		length += (size_t)(ai->b - b);
+
+	ai->b = b;
+	ai->runtime_address = runtime_address;
+	return length;
+}
+
+
+/*
+Copies the instruction at '*string' to 'parsed_string' converting it to lowercase and removing unwanted spaces, then makes '*string' point to the next instruction.
+Instructions are separated by the '\n'(new line) character. Returns the length of the parsed string, or (size_t)(-1) if it would have more than 255 characters.
+*/
+NMD_ASSEMBLY_API size_t _nmd_parse_line(const char** string, char* parsed_string)
+{
+	const char* s = *string;
+	char prev_c = ' '; /* Leading spaces are skipped */
+	size_t length = 0;
+
+	while (*s && *s != '\n')
 	{
-		int offset = 0;
-		if (ai->mode != NMD_X86_MODE_16)
-			ai->b[offset++] = 0x66;
-		ai->b[offset++] = 0x99;
-		return offset;
+		const char c = *s++;
+
+		/* Ignore(skip) the current character if it's a space and the previous character is one of the following: ' ', '+', '*', '[' */
+		if (c == ' ' && (prev_c == ' ' || prev_c == '+' || prev_c == '*' || prev_c == '['))
+			continue;
+
+		/* The maximum length is 255 */
+		if (length >= 255)
+			return (size_t)(-1);
+
+		parsed_string[length++] = _NMD_TOLOWER(c);
+		prev_c = c;
 	}
 
-	return 0;
+	/* Skip the instruction separator character */
+	if (*s /* == '\n' */)
+		s++;
+
+	/* If the last character is a space, remove it. */
+	if (length > 0 && parsed_string[length - 1] == ' ')
+		length--;
+
+	parsed_string[length] = '\0';
+	*string = s;
+	return length;
 }
 
 /*
@@ -4194,7 +5362,7 @@ Parameters:
  - string          [in]         A pointer to a string that represents one or more instructions in assembly language.
  - buffer          [out]        A pointer to a buffer that receives the encoded instructions.
  - buffer_size     [in]         The size of the buffer in bytes.
- - runtime_address [in]         The instruction's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - runtime_address [in]         The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
  - mode            [in]         The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
  - count           [in/out/opt] A pointer to a variable that on input is the maximum number of instructions that can be parsed, and on output the number of instructions parsed. This parameter may be null.
 */
@@ -4210,65 +5378,21 @@ NMD_ASSEMBLY_API size_t nmd_x86_assemble(const char* string, void* buffer, size_
 	uint8_t temp_buffer[15]; /* The assembling takes place on this buffer instead of the user's buffer because the assembler doesn't check the buffer size. If it assembled directly to the user's buffer it could access bad memory */
 	uint8_t* b = (uint8_t*)buffer;
 	size_t remaining_size;
-	size_t length = 0;
 
 	_nmd_assemble_info ai;
-	ai.s = parsed_string;
 	ai.mode = mode;
 	ai.runtime_address = runtime_address;
 	ai.b = temp_buffer;
-	
-	/* Parse the first character of the string because the loop just ahead accesses `string-1` which could be bad memory if we didn't do this */
-	if (*string == ' ')
-		string++;
-	else
-	{
-		parsed_string[0] = *string++;
-		length++;
-	}
 
 	while (*string && num_instructions < num_max_instructions)
 	{
 		remaining_size = buffer_end - b;
-				
-		/* Copy 'string' to 'parsed_string' converting it to lowercase and removing unwanted spaces. If the instruction separator character '\n' is found, stop. */
-		char c = *string; /* Current character */
-		char prev_c = *(string - 1); /* Previous character */
-		while (c && c != '\n')
-		{
-			/* Ignore(skip) the current character if it's a space and the previous character is one of the following: ' ', '+', '*', '[' */
-			if (c == ' ' && (prev_c == ' ' || prev_c == '+' || prev_c == '*' || prev_c == '['))
-			{
-				c = *++string;
-				continue;
-			}
-
-			/* Append character */
-			parsed_string[length++] = _NMD_TOLOWER(c);
-
-			/* The maximum length is 255 */
-			if (length >= 256)
-				return 0;
-
-			/* Set previous character */
-			prev_c = c;
-
-			/* Get the next character */
-			c = *++string;
-		}
-
-		/* This check is only ever true if *string == '\n', that is the instruction separator character */
-		if (*string /* == '\n' */)
-			string++; /* Go forward by one character so 'string' points to the next instruction */
-
-		/* If the last character is a space, remove it. */
-		if (length > 0 && parsed_string[length - 1] == ' ')
-			length--;
 
-		/* After all of the string manipulation, place the null character */
-		parsed_string[length] = '\0';
+		if (_nmd_parse_line(&string, parsed_string) == (size_t)(-1))
+			return 0;
 
 		/* Try to assemble the instruction */
+		ai.s = parsed_string;
 		const size_t num_bytes = _nmd_assemble_single(&ai);
 		if (num_bytes == 0 || num_bytes > remaining_size)
 			return 0;
@@ -4279,10 +5403,11 @@ NMD_ASSEMBLY_API size_t nmd_x86_assemble(const char* string, void* buffer, size_
 			b[i] = temp_buffer[i];
 		b += num_bytes;
 
-		num_instructions++;
+		/* The next instruction starts where this one ends */
+		if (ai.runtime_address != NMD_X86_INVALID_RUNTIME_ADDRESS)
+			ai.runtime_address += num_bytes;
 
-		/* Reset length in case there's another instruction */
-		length = 0;
+		num_instructions++;
 	}
 
 	if (count)
@@ -4292,489 +5417,1475 @@ NMD_ASSEMBLY_API size_t nmd_x86_assemble(const char* string, void* buffer, size_
 	return (size_t)((ptrdiff_t)b - (ptrdiff_t)buffer);
 }
 
-
-NMD_ASSEMBLY_API void _nmd_decode_operand_segment_reg(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+/* Returns the assembler's mnemonic('_NMD_X86_ASM_MNEMONIC') of an instruction without explicit operands identified by 'id'(a member of 'NMD_X86_INSTRUCTION'), or '_NMD_X86_ASM_MNEMONIC_NONE'. */
+NMD_ASSEMBLY_API uint8_t _nmd_get_asm_mnemonic_without_operands(uint16_t id)
 {
-	if (instruction->segment_override)
-		operand->fields.reg = (uint8_t)(NMD_X86_REG_ES + _nmd_get_bit_index(instruction->segment_override));
-	else
-		operand->fields.reg = (uint8_t)(!(instruction->prefixes & NMD_X86_PREFIXES_REX_B) && (instruction->modrm.fields.rm == 0b100 || instruction->modrm.fields.rm == 0b101) ? NMD_X86_REG_SS : NMD_X86_REG_DS);
+#define _NMD_ASM_MNEMONIC_CASE(name) case NMD_X86_INSTRUCTION_##name: return _NMD_X86_ASM_MNEMONIC_##name;
+	switch (id)
+	{
+	_NMD_ASM_MNEMONIC_CASE(INT3) _NMD_ASM_MNEMONIC_CASE(NOP) _NMD_ASM_MNEMONIC_CASE(RET) _NMD_ASM_MNEMONIC_CASE(RETF) _NMD_ASM_MNEMONIC_CASE(LEAVE) _NMD_ASM_MNEMONIC_CASE(INT1)
+	_NMD_ASM_MNEMONIC_CASE(DAA) _NMD_ASM_MNEMONIC_CASE(AAA) _NMD_ASM_MNEMONIC_CASE(DAS) _NMD_ASM_MNEMONIC_CASE(AAS) _NMD_ASM_MNEMONIC_CASE(XLAT) _NMD_ASM_MNEMONIC_CASE(FWAIT)
+	_NMD_ASM_MNEMONIC_CASE(HLT) _NMD_ASM_MNEMONIC_CASE(CMC) _NMD_ASM_MNEMONIC_CASE(CLC) _NMD_ASM_MNEMONIC_CASE(SAHF) _NMD_ASM_MNEMONIC_CASE(LAHF) _NMD_ASM_MNEMONIC_CASE(INTO)
+	_NMD_ASM_MNEMONIC_CASE(SALC) _NMD_ASM_MNEMONIC_CASE(STC) _NMD_ASM_MNEMONIC_CASE(CLI) _NMD_ASM_MNEMONIC_CASE(STI) _NMD_ASM_MNEMONIC_CASE(CLD) _NMD_ASM_MNEMONIC_CASE(STD)
+	_NMD_ASM_MNEMONIC_CASE(SYSCALL) _NMD_ASM_MNEMONIC_CASE(CLTS) _NMD_ASM_MNEMONIC_CASE(SYSRET) _NMD_ASM_MNEMONIC_CASE(INVD) _NMD_ASM_MNEMONIC_CASE(WBINVD) _NMD_ASM_MNEMONIC_CASE(UD2)
+	_NMD_ASM_MNEMONIC_CASE(FEMMS) _NMD_ASM_MNEMONIC_CASE(WRMSR) _NMD_ASM_MNEMONIC_CASE(RDTSC) _NMD_ASM_MNEMONIC_CASE(RDMSR) _NMD_ASM_MNEMONIC_CASE(RDPMC) _NMD_ASM_MNEMONIC_CASE(SYSENTER)
+	_NMD_ASM_MNEMONIC_CASE(SYSEXIT) _NMD_ASM_MNEMONIC_CASE(GETSEC) _NMD_ASM_MNEMONIC_CASE(EMMS) _NMD_ASM_MNEMONIC_CASE(CPUID) _NMD_ASM_MNEMONIC_CASE(RSM)
+	_NMD_ASM_MNEMONIC_CASE(PUSHF) _NMD_ASM_MNEMONIC_CASE(POPF) _NMD_ASM_MNEMONIC_CASE(PUSHFD) _NMD_ASM_MNEMONIC_CASE(POPFD) _NMD_ASM_MNEMONIC_CASE(PUSHFQ) _NMD_ASM_MNEMONIC_CASE(POPFQ)
+	_NMD_ASM_MNEMONIC_CASE(PUSHA) _NMD_ASM_MNEMONIC_CASE(PUSHAD) _NMD_ASM_MNEMONIC_CASE(POPA) _NMD_ASM_MNEMONIC_CASE(POPAD) _NMD_ASM_MNEMONIC_CASE(IRET) _NMD_ASM_MNEMONIC_CASE(IRETD)
+	_NMD_ASM_MNEMONIC_CASE(IRETQ) _NMD_ASM_MNEMONIC_CASE(PAUSE) _NMD_ASM_MNEMONIC_CASE(CBW) _NMD_ASM_MNEMONIC_CASE(CWDE) _NMD_ASM_MNEMONIC_CASE(CDQE) _NMD_ASM_MNEMONIC_CASE(CWD)
+	_NMD_ASM_MNEMONIC_CASE(CDQ) _NMD_ASM_MNEMONIC_CASE(CQO)
+	default: return _NMD_X86_ASM_MNEMONIC_NONE;
+	}
+#undef _NMD_ASM_MNEMONIC_CASE
 }
 
-/* Decodes a memory operand. modrm is assumed to be in the range [00,BF] */
-NMD_ASSEMBLY_API void _nmd_decode_modrm_upper32(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+/*
+Converts 'imm' to an immediate of 'size' bytes, which is returned sign-extended in 'p_imm'. Immediates smaller than 8 bytes may be either sign-extended
+or zero-extended(e.g. -1 and 0xff are the same byte), 8-byte immediates are taken as they are. Returns false if 'imm' doesn't fit in 'size' bytes.
+*/
+NMD_ASSEMBLY_API bool _nmd_get_sized_immediate(int64_t imm, size_t size, int64_t* p_imm)
 {
-    /* Set operand type */
-	operand->type = NMD_X86_OPERAND_TYPE_MEMORY;
+	if (size < 8)
+	{
+		const int64_t mask = ((int64_t)1 << (size * 8)) - 1;
+		if (imm < -(mask / 2) - 1 || imm > mask)
+			return false;
+		imm = _nmd_sign_extend((uint64_t)imm, size);
+	}
+
+	*p_imm = imm;
+	return true;
+}
+
+/* Appends an immediate of 'size' bytes. */
+NMD_ASSEMBLY_API size_t _nmd_append_immediate(uint8_t* buffer, int64_t imm, size_t size)
+{
+	size_t i = 0;
+	for (; i < size; i++)
+		buffer[i] = (uint8_t)((uint64_t)imm >> (i * 8));
+	return size;
+}
 
-	if (instruction->has_sib) /* R/M is 0b100 */
+/* Encodes an instruction described by 'instruction' to 'b', which must have at least 'NMD_X86_MAXIMUM_INSTRUCTION_LENGTH' bytes. Returns the number of bytes written, zero on failure. */
+NMD_ASSEMBLY_API size_t _nmd_encode(const nmd_x86_instruction* instruction, uint8_t* b)
+{
+	const NMD_X86_MODE mode = (NMD_X86_MODE)instruction->mode;
+	const nmd_x86_operand* operands[2] = { 0, 0 };
+	const nmd_x86_operand* reg_operand = 0;
+	const nmd_x86_operand* rm_operand = 0;
+	size_t num_operands = 0, offset = 0, size = 0, length, i;
+	int64_t imm;
+	uint8_t reg = 0, index, byte_regs = _NMD_BYTE_REGS_NONE;
+
+	/* Only the explicit operands describe the instruction */
+	for (i = 0; i < instruction->num_operands && i < NMD_X86_MAXIMUM_NUM_OPERANDS; i++)
 	{
-		if (instruction->sib.fields.base == 0b101) /* Check if there is displacement */
+		if (instruction->operands[i].is_implicit)
+			continue;
+		else if (num_operands == 2)
+			return 0;
+
+		operands[num_operands++] = &instruction->operands[i];
+	}
+
+	/* The operand size is the size of the first register operand. If no register operand exists, it's the size of the memory operand(a dword if unknown) */
+	for (i = 0; i < num_operands; i++)
+	{
+		if (operands[i]->type == NMD_X86_OPERAND_TYPE_REGISTER && !reg_operand)
 		{
-			if (instruction->modrm.fields.mod != 0b00)
-				operand->fields.mem.base = (uint8_t)(instruction->mode == NMD_X86_MODE_64 && !(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE) ? (instruction->prefixes & NMD_X86_PREFIXES_REX_B ? NMD_X86_REG_R13 : NMD_X86_REG_RBP) : NMD_X86_REG_EBP);
+			reg_operand = operands[i];
+			reg = operands[i]->fields.reg;
+			size = _nmd_get_gpr_size((NMD_X86_REG)reg);
+		}
+		else if (operands[i]->type == NMD_X86_OPERAND_TYPE_MEMORY)
+			rm_operand = operands[i];
+
+		/* The decoder describes 'spl', 'bpl', 'sil' and 'dil' as 'ah' to 'bh' in an instruction with a REX prefix */
+		if (operands[i]->type == NMD_X86_OPERAND_TYPE_REGISTER && _nmd_is_high_byte_reg(operands[i]->fields.reg))
+			byte_regs = instruction->has_rex ? _NMD_BYTE_REGS_REX : _NMD_BYTE_REGS_HIGH;
+	}
+	if (!reg_operand && rm_operand)
+		size = rm_operand->fields.mem.size ? rm_operand->fields.mem.size : 4;
+	index = _nmd_get_gpr_index((NMD_X86_REG)reg);
+
+	/* 16-bit addressing can't be encoded. Registers such as '[bx+si]' are rejected when the operand is encoded, an operand without registers('[di]' is decoded as one) is
+	   a 16-bit displacement in 16-bit mode without the address size prefix and in 32-bit mode with it */
+	if (rm_operand && !rm_operand->fields.mem.base && !rm_operand->fields.mem.index && mode != NMD_X86_MODE_64 && (mode == NMD_X86_MODE_16) != !!(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE))
+		return 0;
+
+	/* The operand of a far branch('call ptr16:32'(9A)) is a pointer, not a displacement */
+	if (instruction->opcode_map == NMD_X86_OPCODE_MAP_DEFAULT && instruction->opcode == 0x9a)
+		return 0;
+
+	if (instruction->prefixes & NMD_X86_PREFIXES_LOCK)
+		b[offset++] = 0xf0;
+
+	/* Instructions without explicit operands */
+	if (num_operands == 0)
+	{
+		length = _nmd_assemble_without_operands(b + offset, mode, _nmd_get_asm_mnemonic_without_operands(instruction->id));
+		return length ? offset + length : 0;
+	}
+
+	switch (instruction->id)
+	{
+	case NMD_X86_INSTRUCTION_ADD:
+	case NMD_X86_INSTRUCTION_OR:
+	case NMD_X86_INSTRUCTION_ADC:
+	case NMD_X86_INSTRUCTION_SBB:
+	case NMD_X86_INSTRUCTION_AND:
+	case NMD_X86_INSTRUCTION_SUB:
+	case NMD_X86_INSTRUCTION_XOR:
+	case NMD_X86_INSTRUCTION_CMP:
+	case NMD_X86_INSTRUCTION_MOV:
+	{
+		/* The identifiers from 'add' to 'cmp' are in the same order as the opcodes('add' is 00, 'or' is 08...) */
+		const bool is_mov = instruction->id == NMD_X86_INSTRUCTION_MOV;
+		const uint8_t alu = (uint8_t)(instruction->id - NMD_X86_INSTRUCTION_ADD);
+		if (num_operands != 2 || !size)
+			return 0;
+
+		if (operands[1]->type == NMD_X86_OPERAND_TYPE_IMMEDIATE)
+		{
+			/* The immediate of a 64-bit operand is a sign-extended 32-bit immediate, except for 'mov reg,imm64' */
+			if (!_nmd_get_sized_immediate(operands[1]->fields.imm, size, &imm))
+				return 0;
+
+			if (operands[0]->type == NMD_X86_OPERAND_TYPE_REGISTER && (is_mov ? (size < 8 || imm < -(int64_t)0x80000000 || imm > 0x7fffffff) : (index == 0 && !(size > 1 && imm >= -0x80 && imm <= 0x7f))))
+			{
+				/* 'mov reg,imm'(B0-BF) or 'op al/ax/eax/rax,imm'(04,05,0C,0D...) */
+				if (!_nmd_append_operand_size_prefixes(b, &offset, mode, size, index & 8 ? 0x01 : 0, byte_regs))
+					return 0;
+				b[offset++] = (uint8_t)(is_mov ? (size == 1 ? 0xb0 : 0xb8) + index % 8 : alu * 8 + (size == 1 ? 4 : 5));
+				return offset + _nmd_append_immediate(b + offset, imm, (is_mov || size < 4) ? size : 4);
+			}
+			else
+			{
+				/* 'op r/m,imm'(80,81,83) or 'mov r/m,imm'(C6,C7) */
+				const bool imm8 = !is_mov && size > 1 && imm >= -0x80 && imm <= 0x7f;
+				if (size == 8 && (imm < -(int64_t)0x80000000 || imm > 0x7fffffff))
+					return 0;
+				if (!(length = _nmd_assemble_rm_reg(b + offset, mode, operands[0], (uint8_t)(is_mov ? (size == 1 ? 0xc6 : 0xc7) : (size == 1 ? 0x80 : (imm8 ? 0x83 : 0x81))), is_mov ? 0 : alu, size, byte_regs)))
+					return 0;
+				offset += length;
+				return offset + _nmd_append_immediate(b + offset, imm, (size == 1 || imm8) ? 1 : (size == 2 ? 2 : 4));
+			}
 		}
+		else if (operands[1]->type == NMD_X86_OPERAND_TYPE_REGISTER && _nmd_get_gpr_size((NMD_X86_REG)operands[1]->fields.reg) == size) /* 'op r/m,reg'(00,01,08,09...,88,89) */
+			length = _nmd_assemble_rm_reg(b + offset, mode, operands[0], (uint8_t)((is_mov ? 0x88 : alu * 8) + (size > 1)), _nmd_get_gpr_index((NMD_X86_REG)operands[1]->fields.reg), size, byte_regs);
+		else if (operands[0]->type == NMD_X86_OPERAND_TYPE_REGISTER && operands[1]->type == NMD_X86_OPERAND_TYPE_MEMORY) /* 'op reg,mem'(02,03,0A,0B...,8A,8B) */
+			length = _nmd_assemble_mem_reg(b + offset, mode, &operands[1]->fields.mem, (uint8_t)((is_mov ? 0x8a : alu * 8 + 2) + (size > 1)), index, size, byte_regs);
 		else
-			operand->fields.mem.base = (uint8_t)((instruction->mode == NMD_X86_MODE_64 && !(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE) ? (instruction->prefixes & NMD_X86_PREFIXES_REX_B ? NMD_X86_REG_R8 : NMD_X86_REG_RAX) : NMD_X86_REG_EAX) + instruction->sib.fields.base);
+			return 0;
 
-		if (instruction->sib.fields.index != 0b100)
-			operand->fields.mem.index = (uint8_t)((instruction->mode == NMD_X86_MODE_64 && !(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE) ? (instruction->prefixes & NMD_X86_PREFIXES_REX_X ? NMD_X86_REG_R8 : NMD_X86_REG_RAX) : NMD_X86_REG_EAX) + instruction->sib.fields.index);
+		return length ? offset + length : 0;
+	}
 
-		if (instruction->prefixes & NMD_X86_PREFIXES_REX_X && instruction->sib.fields.index == 0b100)
+	case NMD_X86_INSTRUCTION_LEA:
+		if (num_operands != 2 || operands[0]->type != NMD_X86_OPERAND_TYPE_REGISTER || operands[1]->type != NMD_X86_OPERAND_TYPE_MEMORY || size < 2)
+			return 0;
+		length = _nmd_assemble_mem_reg(b + offset, mode, &operands[1]->fields.mem, 0x8d, index, size, _NMD_BYTE_REGS_NONE);
+		return length ? offset + length : 0;
+
+	case NMD_X86_INSTRUCTION_INC:
+	case NMD_X86_INSTRUCTION_DEC:
+	{
+		const bool is_inc = instruction->id == NMD_X86_INSTRUCTION_INC;
+		if (num_operands != 1 || !size)
+			return 0;
+
+		/* The short forms(40-4F) are REX prefixes in 64-bit mode */
+		if (reg_operand && mode != NMD_X86_MODE_64 && size > 1)
 		{
-			operand->fields.mem.index = (uint8_t)NMD_X86_REG_R12;
+			if (!_nmd_append_operand_size_prefixes(b, &offset, mode, size, 0, _NMD_BYTE_REGS_NONE))
+				return 0;
+			b[offset++] = (uint8_t)((is_inc ? 0x40 : 0x48) + index);
+			return offset;
 		}
-        
-		operand->fields.mem.scale = instruction->sib.fields.scale;
+
+		length = _nmd_assemble_rm_reg(b + offset, mode, operands[0], (uint8_t)(size == 1 ? 0xfe : 0xff), is_inc ? 0 : 1, size, byte_regs);
+		return length ? offset + length : 0;
 	}
-	else if (!(instruction->modrm.fields.mod == 0b00 && instruction->modrm.fields.rm == 0b101))
+
+	case NMD_X86_INSTRUCTION_PUSH:
+	case NMD_X86_INSTRUCTION_POP:
 	{
-		if (instruction->mode == NMD_X86_MODE_16 && !(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE))
+		const bool is_push = instruction->id == NMD_X86_INSTRUCTION_PUSH;
+		if (num_operands != 1)
+			return 0;
+
+		if (operands[0]->type == NMD_X86_OPERAND_TYPE_IMMEDIATE)
 		{
-			operand->fields.mem.base = NMD_X86_REG_BX;
-			operand->fields.mem.index = NMD_X86_REG_SI;
+			/* The operand size is the default one. In 64-bit mode the immediate is sign-extended */
+			size = mode == NMD_X86_MODE_16 ? 2 : 4;
+			if (!is_push || !_nmd_get_sized_immediate(operands[0]->fields.imm, mode == NMD_X86_MODE_64 ? 8 : size, &imm) || imm < -(int64_t)0x80000000 || imm > 0x7fffffff)
+				return 0;
+
+			b[offset++] = (uint8_t)(imm >= -0x80 && imm <= 0x7f ? 0x6a : 0x68);
+			return offset + _nmd_append_immediate(b + offset, imm, b[offset - 1] == 0x6a ? 1 : size);
 		}
-		else
+		else if (reg >= NMD_X86_REG_ES && reg <= NMD_X86_REG_GS)
 		{
-			if ((instruction->prefixes & (NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE | NMD_X86_PREFIXES_REX_B)) == (NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE | NMD_X86_PREFIXES_REX_B) && instruction->mode == NMD_X86_MODE_64)
-				operand->fields.mem.base = (uint8_t)(NMD_X86_REG_R8D + instruction->modrm.fields.rm);
-			else
-				operand->fields.mem.base = (uint8_t)((instruction->mode == NMD_X86_MODE_64 && !(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE) ? (instruction->prefixes & NMD_X86_PREFIXES_REX_B ? NMD_X86_REG_R8 : NMD_X86_REG_RAX) : NMD_X86_REG_EAX) + instruction->modrm.fields.rm);
+			if (reg == NMD_X86_REG_FS || reg == NMD_X86_REG_GS)
+			{
+				b[offset++] = 0x0f;
+				b[offset++] = (uint8_t)((reg == NMD_X86_REG_FS ? 0xa0 : 0xa8) + (is_push ? 0 : 1));
+				return offset;
+			}
+			else if (mode == NMD_X86_MODE_64 || (!is_push && reg == NMD_X86_REG_CS))
+				return 0;
+
+			b[offset++] = (uint8_t)(0x06 + (reg - NMD_X86_REG_ES) * 8 + (is_push ? 0 : 1));
+			return offset;
+		}
+		else if (reg_operand)
+		{
+			/* 32-bit registers can't be pushed in 64-bit mode, 64-bit registers can only be pushed in 64-bit mode */
+			if (size == 1 || (size == 8) != (mode == NMD_X86_MODE_64) || (size == 4 && mode == NMD_X86_MODE_64) || ((index & 8) && mode != NMD_X86_MODE_64))
+				return 0;
+
+			if ((size == 2) != (mode == NMD_X86_MODE_16))
+				b[offset++] = 0x66;
+			if (index & 8)
+				b[offset++] = 0x41;
+			b[offset++] = (uint8_t)((is_push ? 0x50 : 0x58) + index % 8);
+			return offset;
 		}
+		return 0;
 	}
 
-	_nmd_decode_operand_segment_reg(instruction, operand);
+	case NMD_X86_INSTRUCTION_JMP:
+	case NMD_X86_INSTRUCTION_CALL:
+	case NMD_X86_INSTRUCTION_JO: case NMD_X86_INSTRUCTION_JNO: case NMD_X86_INSTRUCTION_JB: case NMD_X86_INSTRUCTION_JNB:
+	case NMD_X86_INSTRUCTION_JZ: case NMD_X86_INSTRUCTION_JNZ: case NMD_X86_INSTRUCTION_JBE: case NMD_X86_INSTRUCTION_JA:
+	case NMD_X86_INSTRUCTION_JS: case NMD_X86_INSTRUCTION_JNS: case NMD_X86_INSTRUCTION_JP: case NMD_X86_INSTRUCTION_JNP:
+	case NMD_X86_INSTRUCTION_JL: case NMD_X86_INSTRUCTION_JGE: case NMD_X86_INSTRUCTION_JLE: case NMD_X86_INSTRUCTION_JG:
+	{
+		/* The immediate is the displacement relative to the end of the instruction, as filled by the decoder. If 'length' is set, the displacement is
+		   adjusted to the length of the new encoding so the target stays the same, otherwise it's relative to the end of the new encoding */
+		const size_t rel_size = mode == NMD_X86_MODE_16 ? 2 : 4;
+		const size_t long_length = offset + (instruction->id == NMD_X86_INSTRUCTION_JMP || instruction->id == NMD_X86_INSTRUCTION_CALL ? 1 : 2) + rel_size;
+		int64_t short_imm;
+		if (num_operands != 1 || operands[0]->type != NMD_X86_OPERAND_TYPE_IMMEDIATE)
+			return 0;
 
-	operand->fields.mem.disp = instruction->displacement;
-}
+		short_imm = instruction->length ? operands[0]->fields.imm + instruction->length - (int64_t)(offset + 2) : operands[0]->fields.imm;
+		if (instruction->id != NMD_X86_INSTRUCTION_CALL && short_imm >= -0x80 && short_imm <= 0x7f)
+		{
+			b[offset++] = (uint8_t)(instruction->id == NMD_X86_INSTRUCTION_JMP ? 0xeb : 0x70 + (instruction->id - NMD_X86_INSTRUCTION_JO));
+			b[offset++] = (uint8_t)short_imm;
+			return offset;
+		}
 
-NMD_ASSEMBLY_API void _nmd_decode_memory_operand(const nmd_x86_instruction* instruction, nmd_x86_operand* operand, uint8_t mod11base_reg)
-{
-	if (instruction->modrm.fields.mod == 0b11)
-	{
-		operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
-		operand->fields.reg = mod11base_reg + instruction->modrm.fields.rm;
+		imm = instruction->length ? operands[0]->fields.imm + instruction->length - (int64_t)long_length : operands[0]->fields.imm;
+		if (rel_size == 2 ? (imm < -0x8000 || imm > 0x7fff) : (imm < -(int64_t)0x80000000 || imm > 0x7fffffff))
+			return 0;
+
+		if (instruction->id == NMD_X86_INSTRUCTION_JMP || instruction->id == NMD_X86_INSTRUCTION_CALL)
+			b[offset++] = (uint8_t)(instruction->id == NMD_X86_INSTRUCTION_JMP ? 0xe9 : 0xe8);
+		else
+		{
+			b[offset++] = 0x0f;
+			b[offset++] = (uint8_t)(0x80 + (instruction->id - NMD_X86_INSTRUCTION_JO));
+		}
+		return offset + _nmd_append_immediate(b + offset, imm, rel_size);
 	}
-	else
-		_nmd_decode_modrm_upper32(instruction, operand);
-}
 
-NMD_ASSEMBLY_API void _nmd_decode_operand_Eb(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
-{
-	_nmd_decode_memory_operand(instruction, operand, NMD_X86_REG_AL);
-}
+	case NMD_X86_INSTRUCTION_RET:
+	case NMD_X86_INSTRUCTION_RETF:
+		if (num_operands != 1 || operands[0]->type != NMD_X86_OPERAND_TYPE_IMMEDIATE || !_nmd_get_sized_immediate(operands[0]->fields.imm, 2, &imm))
+			return 0;
+		b[offset++] = (uint8_t)(instruction->id == NMD_X86_INSTRUCTION_RET ? 0xc2 : 0xca);
+		return offset + _nmd_append_immediate(b + offset, imm, 2);
 
-NMD_ASSEMBLY_API void _nmd_decode_operand_Ew(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
-{
-	_nmd_decode_memory_operand(instruction, operand, NMD_X86_REG_AX);
-}
+	case NMD_X86_INSTRUCTION_INT:
+		if (num_operands != 1 || operands[0]->type != NMD_X86_OPERAND_TYPE_IMMEDIATE || !_nmd_get_sized_immediate(operands[0]->fields.imm, 1, &imm))
+			return 0;
+		b[offset++] = 0xcd;
+		b[offset++] = (uint8_t)imm;
+		return offset;
+	}
 
-NMD_ASSEMBLY_API void _nmd_decode_operand_Ev(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
-{
-	_nmd_decode_memory_operand(instruction, operand, (uint8_t)(instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? NMD_X86_REG_AX : NMD_X86_REG_EAX));
+	return 0;
 }
 
-NMD_ASSEMBLY_API void _nmd_decode_operand_Ey(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+/*
+Encodes an instruction from a structured description instead of a string. Returns the number of bytes written to the buffer on success, zero otherwise.
+The description follows the decoder's conventions, so instructions filled by nmd_x86_decode() with 'NMD_X86_DECODER_FLAGS_OPERANDS' can be encoded again:
+ - 'mode' and 'id' select the instruction. Only the explicit operands(the ones whose 'is_implicit' is false) are used, the other variables are ignored
+   except 'prefixes', from which only 'NMD_X86_PREFIXES_LOCK' and 'NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE' are used, 'opcode' and 'opcode_map', which are only used
+   to reject far branches, 'length', see below, and 'has_rex', which makes the registers 'NMD_X86_REG_AH' to 'NMD_X86_REG_BH' mean 'spl', 'bpl', 'sil' and 'dil'
+   like in the decoder. 'ah' to 'bh' can't be used with registers that require a REX prefix.
+ - 16-bit addressing(e.g. '[bx+si]' or a 16-bit displacement) and far pointers('call ptr16:32') can't be encoded.
+ - The operand size is given by the register operands(e.g. 'ax' selects 16-bit operands), or else by the 'size' of the memory operand(a dword if zero).
+ - The immediate of a relative branch(e.g. 'jmp', 'jz' and 'call') is the displacement from the end of the instruction, whose length is 'length'.
+   The shortest encoding that reaches the same target is used and the displacement is adjusted to its length. If 'length' is zero, the displacement is
+   relative to the end of the new encoding instead.
+Supported instructions: instructions without explicit operands known by nmd_x86_assemble(), 'add', 'or', 'adc', 'sbb', 'and', 'sub', 'xor', 'cmp' and 'mov'
+(r/m,reg reg,mem r/m,imm), 'lea', 'inc', 'dec', 'push', 'pop'(reg, segment register, imm), 'jmp', 'call', 'jcc'(rel), 'ret', 'retf'(imm16) and 'int'(imm8).
+Parameters:
+ - instruction [in]  A pointer to a variable of type 'nmd_x86_instruction' that describes the instruction.
+ - buffer      [out] A pointer to a buffer that receives the encoded instruction.
+ - buffer_size [in]  The size of the buffer in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_encode(const nmd_x86_instruction* instruction, void* buffer, size_t buffer_size)
 {
-	_nmd_decode_memory_operand(instruction, operand, (uint8_t)(instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? NMD_X86_REG_AX : NMD_X86_REG_EAX));
-}
+	uint8_t temp_buffer[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH];
+	size_t length, i = 0;
 
-NMD_ASSEMBLY_API void _nmd_decode_operand_Qq(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
-{
-	_nmd_decode_memory_operand(instruction, operand, NMD_X86_REG_MM0);
-}
+	/* The encoder doesn't check the buffer size, so small buffers receive a copy of the instruction */
+	if (buffer_size >= NMD_X86_MAXIMUM_INSTRUCTION_LENGTH)
+		return _nmd_encode(instruction, (uint8_t*)buffer);
 
-NMD_ASSEMBLY_API void _nmd_decode_operand_Wdq(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
-{
-	_nmd_decode_memory_operand(instruction, operand, NMD_X86_REG_XMM0);
-}
+	length = _nmd_encode(instruction, temp_buffer);
+	if (length == 0 || length > buffer_size)
+		return 0;
 
-NMD_ASSEMBLY_API void _nmd_decode_operand_Gb(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
-{
-	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
-	operand->fields.reg = NMD_X86_REG_AL + instruction->modrm.fields.reg;
-}
+	for (; i < length; i++)
+		((uint8_t*)buffer)[i] = temp_buffer[i];
 
-NMD_ASSEMBLY_API void _nmd_decode_operand_Gd(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
-{
-	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
-	operand->fields.reg = NMD_X86_REG_EAX + instruction->modrm.fields.reg;
+	return length;
 }
 
-NMD_ASSEMBLY_API void _nmd_decode_operand_Gw(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+/* The kinds of elements recorded by nmd_x86_assemble_block(). */
+enum _NMD_BLOCK_ITEM
 {
-	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
-	operand->fields.reg = NMD_X86_REG_AX + instruction->modrm.fields.reg;
-}
+	_NMD_BLOCK_ITEM_INSTRUCTION = 0, /* An instruction assembled while parsing, whose bytes don't depend on its address. */
+	_NMD_BLOCK_ITEM_LABEL,           /* A label. Its length is zero. */
+	_NMD_BLOCK_ITEM_BRANCH,          /* A relative branch to an address. */
+	_NMD_BLOCK_ITEM_BRANCH_TO_LABEL  /* A relative branch to a label, or to an address if the name is also a number(e.g. 'beef') and no such label is defined. */
+};
 
-NMD_ASSEMBLY_API void _nmd_decode_operand_Gv(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+/* An element of the block. The elements are stored at the start of the arena. */
+typedef struct _nmd_block_item
 {
-	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
-	if (instruction->prefixes & NMD_X86_PREFIXES_REX_B)
-		operand->fields.reg = (uint8_t)((!(instruction->prefixes & NMD_X86_PREFIXES_REX_W) ? NMD_X86_REG_R8D : NMD_X86_REG_R8) + instruction->modrm.fields.reg);
-	else
-		operand->fields.reg = (uint8_t)((instruction->rex_w_prefix ? NMD_X86_REG_RAX : (instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE && instruction->mode != NMD_X86_MODE_16 ? NMD_X86_REG_AX : NMD_X86_REG_EAX)) + instruction->modrm.fields.reg);
-}
-
-NMD_ASSEMBLY_API void _nmd_decode_operand_Rv(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+	int64_t target;      /* The target of a branch: the label's index or the address(the offset relative to the instruction if the runtime address is invalid). */
+	uint32_t offset;     /* The offset of the element relative to the start of the block. */
+	uint32_t name;       /* The offset of the name of a label(or the label a branch refers to) relative to the start of the arena. */
+	uint8_t type;        /* A member of '_NMD_BLOCK_ITEM'. */
+	uint8_t length;      /* The length of the instruction in bytes. */
+	uint8_t mnemonic;    /* The mnemonic('_NMD_X86_ASM_MNEMONIC') of a branch. */
+	bool is_number;      /* True if the name of the label a branch refers to is also a number, stored in 'target' until the labels are resolved. */
+	uint16_t name_length; /* The number of characters of the name. */
+} _nmd_block_item;
+
+/* Returns the number of characters of the identifier(a letter, '_' or '.' followed by letters, digits, '_' or '.') at 's'. */
+NMD_ASSEMBLY_API size_t _nmd_get_identifier_length(const char* s)
 {
-	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
-	if (instruction->prefixes & NMD_X86_PREFIXES_REX_R)
-		operand->fields.reg = (uint8_t)((!(instruction->prefixes & NMD_X86_PREFIXES_REX_W) ? NMD_X86_REG_R8D : NMD_X86_REG_R8) + instruction->modrm.fields.rm);
-	else
-		operand->fields.reg = (uint8_t)((instruction->rex_w_prefix ? NMD_X86_REG_RAX : ((instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE && instruction->mode != NMD_X86_MODE_16) || (instruction->mode == NMD_X86_MODE_16 && !(instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)) ? NMD_X86_REG_AX : NMD_X86_REG_EAX)) + instruction->modrm.fields.rm);
+	size_t i = 0;
+	for (; _NMD_IS_LOWERCASE(s[i]) || s[i] == '_' || s[i] == '.' || (i > 0 && _NMD_IS_DECIMAL_NUMBER(s[i])); i++);
+	return i;
 }
 
-NMD_ASSEMBLY_API void _nmd_decode_operand_Gy(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+/* Returns true if the elements 'a' and 'b' have the same name. */
+NMD_ASSEMBLY_API bool _nmd_block_names_equal(const char* arena, const _nmd_block_item* a, const _nmd_block_item* b)
 {
-	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
-	operand->fields.reg = (uint8_t)((instruction->mode == NMD_X86_MODE_64 ? NMD_X86_REG_RAX : NMD_X86_REG_EAX) + instruction->modrm.fields.reg);
-}
+	size_t i = 0;
+	if (a->name_length != b->name_length)
+		return false;
 
-NMD_ASSEMBLY_API void _nmd_decode_operand_Pq(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
-{
-	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
-	operand->fields.reg = NMD_X86_REG_MM0 + instruction->modrm.fields.reg;
-}
+	for (; i < a->name_length; i++)
+	{
+		if (arena[a->name + i] != arena[b->name + i])
+			return false;
+	}
 
-NMD_ASSEMBLY_API void _nmd_decode_operand_Nq(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
-{
-	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
-	operand->fields.reg = NMD_X86_REG_MM0 + instruction->modrm.fields.rm;
+	return true;
 }
 
-NMD_ASSEMBLY_API void _nmd_decode_operand_Vdq(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+/* Returns the address of the target of the branch 'item' given the runtime address of the block(zero if it's invalid). The block's offsets must be up to date. */
+NMD_ASSEMBLY_API int64_t _nmd_get_block_branch_target(const _nmd_block_item* items, const _nmd_block_item* item, uint64_t runtime_address)
 {
-	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
-	operand->fields.reg = NMD_X86_REG_XMM0 + instruction->modrm.fields.reg;
+	if (item->type == _NMD_BLOCK_ITEM_BRANCH_TO_LABEL)
+		return (int64_t)((runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? 0 : runtime_address) + items[item->target].offset);
+	else if (runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS)
+		return (int64_t)item->offset + item->target;
+	else
+		return item->target;
 }
 
-NMD_ASSEMBLY_API void _nmd_decode_operand_Udq(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+/*
+Assembles a block of instructions separated by the '\n'(new line) character, which may define and refer to labels. Returns the number of bytes written to the buffer on success, zero otherwise.
+ - A label is defined by an identifier followed by ':' at the start of a line, e.g. 'loop:' or 'loop: dec ecx'. Labels are case insensitive and can be referred to before they are defined.
+ - The operand of 'jmp', 'call' and conditional jumps may be a label. A label whose name is also a hexadecimal number(e.g. 'beef') takes precedence over the number. The shortest encoding of 'jmp' and conditional jumps is chosen by iterative relaxation: every branch
+   starts with an 8-bit displacement and only the ones whose target is out of range grow, until no branch has to grow.
+ - Empty lines are ignored. The address of each instruction is the runtime address of the block plus its offset, so a number used as the operand of a branch is an address
+   (or, without a runtime address, a displacement relative to the start of the instruction, same as in nmd_x86_assemble()).
+The instructions are assembled directly to the buffer and moved when a branch before them grows, so the buffer must have room for the whole block. The symbol table and the
+per-instruction information are stored in the arena, see 'NMD_X86_ASSEMBLE_BLOCK_ARENA_SIZE'.
+Parameters:
+ - string          [in]  A pointer to a string that represents a block of instructions in assembly language.
+ - buffer          [out] A pointer to a buffer that receives the encoded instructions.
+ - buffer_size     [in]  The size of the buffer in bytes.
+ - runtime_address [in]  The block's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - mode            [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - arena           [in]  A pointer to memory used by the assembler.
+ - arena_size      [in]  The size of the arena in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_assemble_block(const char* string, void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, void* arena, size_t arena_size)
 {
-	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
-	operand->fields.reg = NMD_X86_REG_XMM0 + instruction->modrm.fields.rm;
-}
+	/* The elements grow from the start of the arena(aligned to eight bytes) and the names from its end */
+	const size_t alignment = (8 - (size_t)((ptrdiff_t)arena % 8)) % 8;
+	_nmd_block_item* const items = (_nmd_block_item*)((char*)arena + alignment);
+	char* names = (char*)arena + arena_size;
+	uint8_t* const b = (uint8_t*)buffer;
+	size_t num_items = 0, num_labels = 0, num_slots = 1, size = 0, length, i, j;
+	uint8_t temp_buffer[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH];
+	char parsed_string[256];
+	uint32_t* slots;
+	bool has_grown;
 
-NMD_ASSEMBLY_API void _nmd_decode_conditional_flag(nmd_x86_instruction* instruction, const uint8_t condition)
-{
-	switch (condition)
-	{
-		case 0x0: instruction->tested_flags.fields.OF = 1; break;                                                                             /* Jump if overflow (OF=1) */
-		case 0x1: instruction->tested_flags.fields.OF = 1; break;                                                                             /* Jump if not overflow (OF=0) */
-		case 0x2: instruction->tested_flags.fields.CF = 1; break;                                                                             /* Jump if not above or equal (CF=1) */
-		case 0x3: instruction->tested_flags.fields.CF = 1; break;                                                                             /* Jump if not below (CF=0) */
-		case 0x4: instruction->tested_flags.fields.ZF = 1; break;                                                                             /* Jump if equal (ZF=1) */
-		case 0x5: instruction->tested_flags.fields.ZF = 1; break;                                                                             /* Jump if not equal (ZF=0) */
-		case 0x6: instruction->tested_flags.fields.CF = instruction->tested_flags.fields.ZF = 1; break;                                       /* Jump if not above (CF=1 or ZF=1) */
-		case 0x7: instruction->tested_flags.fields.CF = instruction->tested_flags.fields.ZF = 1; break;                                       /* Jump if not below or equal (CF=0 and ZF=0) */
-		case 0x8: instruction->tested_flags.fields.SF = 1; break;                                                                             /* Jump if sign (SF=1) */
-		case 0x9: instruction->tested_flags.fields.SF = 1; break;                                                                             /* Jump if not sign (SF=0) */
-		case 0xa: instruction->tested_flags.fields.PF = 1; break;                                                                             /* Jump if parity/parity even (PF=1) */
-		case 0xb: instruction->tested_flags.fields.PF = 1; break;                                                                             /* Jump if parity odd (PF=0) */
-		case 0xc: instruction->tested_flags.fields.SF = instruction->tested_flags.fields.OF = 1; break;                                       /* Jump if not greater or equal (SF != OF) */
-		case 0xd: instruction->tested_flags.fields.SF = instruction->tested_flags.fields.OF = 1; break;                                       /* Jump if not less (SF=OF) */
-		case 0xe: instruction->tested_flags.fields.ZF = instruction->tested_flags.fields.SF = instruction->tested_flags.fields.OF = 1; break; /* Jump if not greater (ZF=1 or SF != OF) */
-		case 0xf: instruction->tested_flags.fields.ZF = instruction->tested_flags.fields.SF = instruction->tested_flags.fields.OF = 1; break; /* Jump if not less or equal (ZF=0 and SF=OF) */
-	}
-}
+	_nmd_assemble_info ai;
+	ai.mode = mode;
+	ai.runtime_address = NMD_X86_INVALID_RUNTIME_ADDRESS; /* Instructions that depend on their address are assembled later */
 
-NMD_ASSEMBLY_API bool _nmd_decode_modrm(const uint8_t** p_buffer, size_t* p_buffer_size, nmd_x86_instruction* const instruction)
-{
-	instruction->has_modrm = true;
-	_NMD_READ_BYTE(*p_buffer, *p_buffer_size, instruction->modrm.modrm);
-	
-	const bool address_prefix = (bool)(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE);
+	if (arena_size < alignment)
+		return 0;
 
-	/* Check for 16-Bit Addressing Form */
-	if (instruction->mode == NMD_X86_MODE_16)
+	/* Parse the block. Instructions are assembled right away, one after the other. Branches don't take space yet */
+	while (*string)
 	{
-		if (instruction->modrm.fields.mod != 0b11)
+		if (_nmd_parse_line(&string, parsed_string) == (size_t)(-1))
+			return 0;
+
+		char* s = parsed_string;
+		while (*s)
 		{
-			if (instruction->modrm.fields.mod == 0b00)
+			_nmd_block_item* const item = items + num_items;
+			if ((char*)(item + 1) > names)
+				return 0;
+
+			item->offset = (uint32_t)size;
+			item->length = 0;
+			item->name_length = 0;
+			item->is_number = false;
+
+			/* Labels */
+			length = _nmd_get_identifier_length(s);
+			if (length && s[length] == ':')
 			{
-				if (instruction->modrm.fields.rm == 0b110)
-					instruction->disp_mask = NMD_X86_DISP16;
+				if ((size_t)(names - (char*)(item + 1)) < length)
+					return 0;
+
+				names -= length;
+				for (i = 0; i < length; i++)
+					names[i] = s[i];
+
+				item->type = _NMD_BLOCK_ITEM_LABEL;
+				item->name = (uint32_t)(names - (char*)arena);
+				item->name_length = (uint16_t)length;
+				num_items++;
+				num_labels++;
+
+				s += length + 1;
+				if (*s == ' ')
+					s++;
+				continue;
 			}
-			else
-				instruction->disp_mask = (uint8_t)(instruction->modrm.fields.mod == 0b01 ? NMD_X86_DISP8 : NMD_X86_DISP16);
-		}
-	}
-	else
-	{
-		/* Check for 16-Bit Addressing Form */
-		if (address_prefix && instruction->mode == NMD_X86_MODE_32)
-		{
-			/* Check for displacement */
-			if ((instruction->modrm.fields.mod == 0b00 && instruction->modrm.fields.rm == 0b110) || instruction->modrm.fields.mod == 0b10)
-				instruction->disp_mask = NMD_X86_DISP16;
-			else if (instruction->modrm.fields.mod == 0b01)
-				instruction->disp_mask = NMD_X86_DISP8;
-		}
-		else /*if (!address_prefix || (address_prefix && **b >= 0x40) || (address_prefix && instruction->mode == NMD_X86_MODE_64)) */
-		{
-			/* Check for SIB byte */
-			if (instruction->modrm.modrm < 0xC0 && instruction->modrm.fields.rm == 0b100 && (!address_prefix || (address_prefix && instruction->mode == NMD_X86_MODE_64)))
+
+			/* Relative branches to labels or addresses. An identifier that is also a number(e.g. 'beef') refers to a label if one with that name is defined */
+			length = _nmd_get_token_length(s);
+			item->mnemonic = _nmd_find_asm_mnemonic(s, length);
+			if ((item->mnemonic == _NMD_X86_ASM_MNEMONIC_JMP || item->mnemonic == _NMD_X86_ASM_MNEMONIC_CALL || (item->mnemonic >= _NMD_X86_ASM_MNEMONIC_JO && item->mnemonic <= _NMD_X86_ASM_MNEMONIC_JG)) && s[length] == ' ')
 			{
-				instruction->has_sib = true;
-				_NMD_READ_BYTE(*p_buffer, *p_buffer_size, instruction->sib.sib);
-			}
+				const char* const operand = s + length + 1;
+				item->is_number = _nmd_parse_immediate(operand, &item->target);
 
-			/* Check for displacement */
-			if (instruction->modrm.fields.mod == 0b01) /* disp8 (ModR/M) */
-				instruction->disp_mask = NMD_X86_DISP8;
-			else if ((instruction->modrm.fields.mod == 0b00 && instruction->modrm.fields.rm == 0b101) || instruction->modrm.fields.mod == 0b10) /* disp16,32 (ModR/M) */
-				instruction->disp_mask = (uint8_t)(address_prefix && !(instruction->mode == NMD_X86_MODE_64 && instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE) ? NMD_X86_DISP16 : NMD_X86_DISP32);
-			else if (instruction->has_sib && instruction->sib.fields.base == 0b101) /* disp8,32 (SIB) */
-				instruction->disp_mask = (uint8_t)(instruction->modrm.fields.mod == 0b01 ? NMD_X86_DISP8 : NMD_X86_DISP32);
-		}
-	}
+				length = _nmd_get_identifier_length(operand);
+				if (length && !operand[length] && !_nmd_find_asm_reg(operand, length))
+				{
+					if ((size_t)(names - (char*)(item + 1)) < length)
+						return 0;
 
-	/* Make sure we can read 'instruction->disp_mask' bytes from the buffer */
-	if (*p_buffer_size < instruction->disp_mask)
-		return false;
-	
-	/* Copy 'instruction->disp_mask' bytes from the buffer */
-	size_t i = 0;
-	for (; i < (size_t)instruction->disp_mask; i++)
-		((uint8_t*)(&instruction->displacement))[i] = (*p_buffer)[i];
-	
-	/* Increment the buffer and decrement the buffer's size */
-	*p_buffer += instruction->disp_mask;
-	*p_buffer_size -= instruction->disp_mask;
-
-	return true;
-}
-
-/*
-Decodes an instruction. Returns true if the instruction is valid, false otherwise.
-Parameters:
- - buffer      [in]  A pointer to a buffer containing an encoded instruction.
- - buffer_size [in]  The size of the buffer in bytes.
- - instruction [out] A pointer to a variable of type 'nmd_x86_instruction' that receives information about the instruction.
- - mode        [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
- - flags       [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use. If uncertain, use 'NMD_X86_DECODER_FLAGS_MINIMAL'.
-*/
-NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_size, nmd_x86_instruction* instruction, NMD_X86_MODE mode, uint32_t flags)
-{
-	/* Security considerations for memory safety:
-	The contents of 'buffer' should be considered untrusted and decoded carefully.
-	
-	'buffer' should always point to the start of the buffer. We use the 'b'
-	buffer iterator to read data from the buffer, however before accessing it
-	make sure to check 'buffer_size' to see if we can safely access it. Then,
-	after reading data from the buffer we increment 'b' and decrement 'buffer_size'.
-	Helper macros: _NMD_READ_BYTE()
-	*/
-	
-	/* Clear 'instruction' */
-	size_t i = 0;
-	for (; i < sizeof(nmd_x86_instruction); i++)
-		((uint8_t*)(instruction))[i] = 0x00;
-
-	/* Set mode */
-	instruction->mode = (uint8_t)mode;
-
-	/* Set buffer iterator */
-	const uint8_t* b = (const uint8_t*)buffer;
-	
-	/*  Clamp 'buffer_size' to 15. We will only read up to 15 bytes(NMD_X86_MAXIMUM_INSTRUCTION_LENGTH) */
-	if (buffer_size > 15)
-		buffer_size = 15;
-	
-	/* Decode legacy and REX prefixes */
-	for (; buffer_size > 0; b++, buffer_size--)
-	{
-		switch (*b)
-		{
-		case 0xF0: instruction->prefixes = (instruction->prefixes | (instruction->simd_prefix = NMD_X86_PREFIXES_LOCK)); continue;
-		case 0xF2: instruction->prefixes = (instruction->prefixes | (instruction->simd_prefix = NMD_X86_PREFIXES_REPEAT_NOT_ZERO)), instruction->repeat_prefix = false; continue;
-		case 0xF3: instruction->prefixes = (instruction->prefixes | (instruction->simd_prefix = NMD_X86_PREFIXES_REPEAT)), instruction->repeat_prefix = true; continue;
-		case 0x2E: instruction->prefixes = (instruction->prefixes | (instruction->segment_override = NMD_X86_PREFIXES_CS_SEGMENT_OVERRIDE)); continue;
-		case 0x36: instruction->prefixes = (instruction->prefixes | (instruction->segment_override = NMD_X86_PREFIXES_SS_SEGMENT_OVERRIDE)); continue;
-		case 0x3E: instruction->prefixes = (instruction->prefixes | (instruction->segment_override = NMD_X86_PREFIXES_DS_SEGMENT_OVERRIDE)); continue;
-		case 0x26: instruction->prefixes = (instruction->prefixes | (instruction->segment_override = NMD_X86_PREFIXES_ES_SEGMENT_OVERRIDE)); continue;
-		case 0x64: instruction->prefixes = (instruction->prefixes | (instruction->segment_override = NMD_X86_PREFIXES_FS_SEGMENT_OVERRIDE)); continue;
-		case 0x65: instruction->prefixes = (instruction->prefixes | (instruction->segment_override = NMD_X86_PREFIXES_GS_SEGMENT_OVERRIDE)); continue;
-		case 0x66: instruction->prefixes = (instruction->prefixes | (instruction->simd_prefix = NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)), instruction->rex_w_prefix = false; continue;
-		case 0x67: instruction->prefixes = (instruction->prefixes | NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE); continue;
-		default:
-			if (mode == NMD_X86_MODE_64 && _NMD_R(*b) == 4) /* REX prefixes [0x40,0x4f] */
-			{
-				instruction->has_rex = true;
-				instruction->rex = *b;
-				instruction->prefixes = (instruction->prefixes & ~(NMD_X86_PREFIXES_REX_B | NMD_X86_PREFIXES_REX_X | NMD_X86_PREFIXES_REX_R | NMD_X86_PREFIXES_REX_W));
+					names -= length;
+					for (i = 0; i < length; i++)
+						names[i] = operand[i];
 
-				if (*b & 0b0001) /* Bit position 0 */
-					instruction->prefixes = instruction->prefixes | NMD_X86_PREFIXES_REX_B;
-				if (*b & 0b0010) /* Bit position 1 */
-					instruction->prefixes = instruction->prefixes | NMD_X86_PREFIXES_REX_X;
-				if (*b & 0b0100) /* Bit position 2 */
-					instruction->prefixes = instruction->prefixes | NMD_X86_PREFIXES_REX_R;
-				if (*b & 0b1000) /* Bit position 3 */
+					item->type = _NMD_BLOCK_ITEM_BRANCH_TO_LABEL;
+					item->name = (uint32_t)(names - (char*)arena);
+					item->name_length = (uint16_t)length;
+					num_items++;
+					break;
+				}
+				else if (item->is_number)
 				{
-					instruction->prefixes = instruction->prefixes | NMD_X86_PREFIXES_REX_W;
-					instruction->rex_w_prefix = true;
+					item->type = _NMD_BLOCK_ITEM_BRANCH;
+					num_items++;
+					break;
 				}
+			}
 
-				continue;
+			/* Other instructions. The assembler doesn't check the buffer size, so it only assembles directly to the buffer if it has enough space */
+			ai.s = s;
+			ai.b = buffer_size - size >= NMD_X86_MAXIMUM_INSTRUCTION_LENGTH ? b + size : temp_buffer;
+			if (!(length = _nmd_assemble_single(&ai)) || length > buffer_size - size)
+				return 0;
+
+			if (ai.b == temp_buffer)
+			{
+				for (i = 0; i < length; i++)
+					b[size + i] = temp_buffer[i];
 			}
+
+			item->type = _NMD_BLOCK_ITEM_INSTRUCTION;
+			item->length = (uint8_t)length;
+			size += length;
+			num_items++;
+			break;
 		}
+	}
 
-		break;
+	/* Build the symbol table, a hash table of label indices(plus one, zero means an empty slot) placed after the elements */
+	while (num_slots < num_labels * 2)
+		num_slots *= 2;
+	slots = (uint32_t*)(items + num_items);
+	if ((char*)(slots + num_slots) > names)
+		return 0;
+	for (i = 0; i < num_slots; i++)
+		slots[i] = 0;
+
+	for (i = 0; i < num_items; i++)
+	{
+		if (items[i].type != _NMD_BLOCK_ITEM_LABEL)
+			continue;
+
+		for (j = _nmd_hash_string((char*)arena + items[i].name, items[i].name_length, 2166136261) & (num_slots - 1); slots[j]; j = (j + 1) & (num_slots - 1))
+		{
+			/* A label can only be defined once */
+			if (_nmd_block_names_equal((const char*)arena, items + slots[j] - 1, items + i))
+				return 0;
+		}
+		slots[j] = (uint32_t)(i + 1);
 	}
 
-	/* Calculate the number of prefixes based on how much the iterator moved */
-	instruction->num_prefixes = (uint8_t)((ptrdiff_t)(b)-(ptrdiff_t)(buffer));
+	/* Resolve the labels branches refer to */
+	for (i = 0; i < num_items; i++)
+	{
+		if (items[i].type != _NMD_BLOCK_ITEM_BRANCH_TO_LABEL)
+			continue;
 
-	/* Assume the instruction uses legacy encoding. It is most likely the case */
-	instruction->encoding = NMD_X86_ENCODING_LEGACY;
+		for (j = _nmd_hash_string((char*)arena + items[i].name, items[i].name_length, 2166136261) & (num_slots - 1); slots[j]; j = (j + 1) & (num_slots - 1))
+		{
+			if (_nmd_block_names_equal((const char*)arena, items + slots[j] - 1, items + i))
+				break;
+		}
 
-	/* Opcode byte. This variable is used because 'op' is simpler than 'instruction->opcode' */
-	uint8_t op;
-	_NMD_READ_BYTE(b, buffer_size, op);
+		if (slots[j])
+			items[i].target = slots[j] - 1;
+		else if (items[i].is_number)
+			items[i].type = _NMD_BLOCK_ITEM_BRANCH; /* Not a label, the address was parsed already */
+		else
+			return 0; /* Undefined label */
+	}
 
-	if (op == 0x0F) /* 2 or 3 byte opcode */
+	/* Relaxation. 'call' has no short form */
+	for (i = 0; i < num_items; i++)
 	{
-		_NMD_READ_BYTE(b, buffer_size, op);
+		if (items[i].type == _NMD_BLOCK_ITEM_BRANCH || items[i].type == _NMD_BLOCK_ITEM_BRANCH_TO_LABEL)
+			items[i].length = (uint8_t)_nmd_get_relative_branch_length(mode, items[i].mnemonic, items[i].mnemonic != _NMD_X86_ASM_MNEMONIC_CALL);
+	}
 
-		if (op == 0x38 || op == 0x3A) /* 3 byte opcode */
+	do
+	{
+		size_t offset = 0;
+		for (i = 0; i < num_items; i++)
 		{
-			instruction->opcode_size = 3;
-			instruction->opcode_map = (uint8_t)(op == 0x38 ? NMD_X86_OPCODE_MAP_0F38 : NMD_X86_OPCODE_MAP_0F3A);
-            
-			_NMD_READ_BYTE(b, buffer_size, op);
-			instruction->opcode = op;
+			items[i].offset = (uint32_t)offset;
+			offset += items[i].length;
+		}
 
-			if (!_nmd_decode_modrm(&b, &buffer_size, instruction))
-				return false;
+		if (offset > buffer_size || offset > 0xffffffff)
+			return 0;
 
-			const nmd_x86_modrm modrm = instruction->modrm;
-			if (instruction->opcode_map == NMD_X86_OPCODE_MAP_0F38)
+		has_grown = false;
+		for (i = 0; i < num_items; i++)
+		{
+			if ((items[i].type == _NMD_BLOCK_ITEM_BRANCH || items[i].type == _NMD_BLOCK_ITEM_BRANCH_TO_LABEL) && items[i].length == 2)
 			{
-#ifndef NMD_ASSEMBLY_DISABLE_DECODER_VALIDITY_CHECK
-				if (flags & NMD_X86_DECODER_FLAGS_VALIDITY_CHECK)
+				const int64_t disp = _nmd_get_block_branch_target(items, items + i, runtime_address) - (int64_t)((runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? 0 : runtime_address) + items[i].offset) - 2;
+				if (disp < -0x80 || disp > 0x7f)
 				{
-					/* Check if the instruction is invalid. */
-					if (op == 0x36)
-					{
-						return false;
-					}
-					else if (op <= 0xb || (op >= 0x1c && op <= 0x1e))
-					{
-						if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT || instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO)
-							return false;
-					}
-					else if (op >= 0xc8 && op <= 0xcd)
-					{
-						if (instruction->simd_prefix)
-							return false;
-					}
-					else if (op == 0x10 || op == 0x14 || op == 0x15 || op == 0x17 || (op >= 0x20 && op <= 0x25) || op == 0x28 || op == 0x29 || op == 0x2b || _NMD_R(op) == 3 || op == 0x40 || op == 0x41 || op == 0xcf || (op >= 0xdb && op <= 0xdf))
-					{
-						if (instruction->simd_prefix != NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
-							return false;
-					}
-					else if (op == 0x2a || (op >= 0x80 && op <= 0x82))
-					{
-						if (modrm.fields.mod == 0b11 || instruction->simd_prefix != NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
-							return false;
-					}
-					else if (op == 0xf0 || op == 0xf1)
-					{
-						if (modrm.fields.mod == 0b11 && (instruction->simd_prefix == NMD_X86_PREFIXES_NONE || instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE))
-							return false;
-						else if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT)
-							return false;
-					}
-					else if (op == 0xf5 || op == 0xf8)
-					{
-						if (instruction->simd_prefix != NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE || modrm.fields.mod == 0b11)
-							return false;
-					}
-					else if (op == 0xf6)
-					{
-						if (instruction->simd_prefix == NMD_X86_PREFIXES_NONE && modrm.fields.mod == 0b11)
-							return false;
-						else if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO)
-							return false;
-					}
-					else if (op == 0xf9)
-					{
-						if (instruction->simd_prefix != NMD_X86_PREFIXES_NONE || modrm.fields.mod == 0b11)
-							return false;
-					}
-					else
-						return false;
+					items[i].length = (uint8_t)_nmd_get_relative_branch_length(mode, items[i].mnemonic, false);
+					has_grown = true;
 				}
-#endif /* NMD_ASSEMBLY_DISABLE_DECODER_VALIDITY_CHECK */
+			}
+		}
+	} while (has_grown);
 
-#ifndef NMD_ASSEMBLY_DISABLE_DECODER_INSTRUCTION_ID
-				if (flags & NMD_X86_DECODER_FLAGS_INSTRUCTION_ID)
-				{
-					if (_NMD_R(op) == 0x00)
-						instruction->id = NMD_X86_INSTRUCTION_PSHUFB + op;
-					else if (op >= 0x1c && op <= 0x1e)
-						instruction->id = NMD_X86_INSTRUCTION_PABSB + (op - 0x1c);
-					else if (_NMD_R(op) == 2)
-						instruction->id = NMD_X86_INSTRUCTION_PMOVSXBW + _NMD_C(op);
-					else if (_NMD_R(op) == 3)
-						instruction->id = NMD_X86_INSTRUCTION_PMOVZXBW + _NMD_C(op);
-					else if (_NMD_R(op) == 8)
-						instruction->id = NMD_X86_INSTRUCTION_INVEPT + _NMD_C(op);
-					else if (_NMD_R(op) == 0xc)
-						instruction->id = NMD_X86_INSTRUCTION_SHA1NEXTE + (_NMD_C(op) - 8);
-					else if (_NMD_R(op) == 0xd)
-						instruction->id = NMD_X86_INSTRUCTION_AESIMC + (_NMD_C(op) - 0xb);
-					else
-					{
-						switch (op)
-						{
-						case 0x10: instruction->id = NMD_X86_INSTRUCTION_PBLENDVB; break;
-						case 0x14: instruction->id = NMD_X86_INSTRUCTION_BLENDVPS; break;
-						case 0x15: instruction->id = NMD_X86_INSTRUCTION_BLENDVPD; break;
-						case 0x17: instruction->id = NMD_X86_INSTRUCTION_PTEST; break;
-						case 0x40: instruction->id = NMD_X86_INSTRUCTION_PMULLD; break;
-						case 0x41: instruction->id = NMD_X86_INSTRUCTION_PHMINPOSUW; break;
-						case 0xf0: case 0xf1: instruction->id = (uint16_t)((instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE || instruction->simd_prefix == 0x00) ? NMD_X86_INSTRUCTION_MOVBE : NMD_X86_INSTRUCTION_CRC32); break;
-						case 0xf6: instruction->id = (uint16_t)(instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? NMD_X86_INSTRUCTION_ADCX : NMD_X86_INSTRUCTION_ADOX); break;
-						}
-					}
-				}
-#endif /* NMD_ASSEMBLY_DISABLE_DECODER_INSTRUCTION_ID */
-				
-#ifndef NMD_ASSEMBLY_DISABLE_DECODER_CPU_FLAGS
-				if (flags & NMD_X86_DECODER_FLAGS_CPU_FLAGS)
-				{
-					if (op == 0x80 || op == 0x81) /* invept,invvpid */
-					{
-						instruction->modified_flags.eflags = NMD_X86_EFLAGS_CF | NMD_X86_EFLAGS_ZF;
-						instruction->cleared_flags.eflags = NMD_X86_EFLAGS_PF | NMD_X86_EFLAGS_AF | NMD_X86_EFLAGS_SF | NMD_X86_EFLAGS_OF;
-					}
-					else if (op == 0xf6)
-					{
-						if (instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE) /* adcx */
-							instruction->modified_flags.eflags = instruction->tested_flags.eflags = NMD_X86_EFLAGS_CF;
-						if (instruction->prefixes & NMD_X86_PREFIXES_REPEAT) /* adox */
-							instruction->modified_flags.eflags = instruction->tested_flags.eflags = NMD_X86_EFLAGS_OF;
-					}
-				}
-#endif /* NMD_ASSEMBLY_DISABLE_DECODER_CPU_FLAGS */
+	/*
+	Move the instructions to their final offsets and assemble the branches. The instructions were assembled one after the other, so their final offsets are greater or equal
+	and moving them from the last to the first one never overwrites bytes that haven't been moved yet.
+	*/
+	for (i = num_items; i-- > 0;)
+	{
+		_nmd_block_item* const item = items + i;
+		if (item->type == _NMD_BLOCK_ITEM_INSTRUCTION)
+		{
+			size -= item->length;
+			for (j = item->length; j-- > 0;)
+				b[item->offset + j] = b[size + j];
+		}
+		else if (item->type != _NMD_BLOCK_ITEM_LABEL)
+		{
+			const int64_t delta = _nmd_get_block_branch_target(items, item, runtime_address) - (int64_t)((runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? 0 : runtime_address) + item->offset);
+			if (!_nmd_assemble_relative_branch(b + item->offset, mode, item->mnemonic, delta, item->length == 2))
+				return 0;
+		}
+	}
 
-#ifndef NMD_ASSEMBLY_DISABLE_DECODER_OPERANDS
-				if (flags & NMD_X86_DECODER_FLAGS_OPERANDS)
-				{
-					instruction->num_operands = 2;
-					instruction->operands[0].action = NMD_X86_OPERAND_ACTION_READWRITE;
-					instruction->operands[1].action = NMD_X86_OPERAND_ACTION_READ;
+	return num_items ? items[num_items - 1].offset + items[num_items - 1].length : 0;
+}
 
-					if (_NMD_R(op) == 0 || (op >= 0x1c && op <= 0x1e))
-					{
-						_nmd_decode_operand_Pq(instruction, &instruction->operands[0]);
-						_nmd_decode_operand_Qq(instruction, &instruction->operands[1]);
-					}
-					else if (_NMD_R(op) == 8)
-					{
-						_nmd_decode_operand_Gy(instruction, &instruction->operands[0]);
+
+/* Returns true if the memory operand uses 16-bit addressing(e.g. '[bx+si]'). The address-size override prefix toggles between 16 and 32 bits outside 64-bit mode. */
+NMD_ASSEMBLY_API bool _nmd_has_16bit_addressing(const nmd_x86_instruction* instruction)
+{
+	return instruction->mode != NMD_X86_MODE_64 && (instruction->mode == NMD_X86_MODE_16) != (bool)(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE);
+}
+
+NMD_ASSEMBLY_API void _nmd_decode_operand_segment_reg(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+{
+	if (instruction->segment_override)
+		operand->fields.reg = (uint8_t)(NMD_X86_REG_ES + _nmd_get_bit_index(instruction->segment_override));
+	else if (_nmd_has_16bit_addressing(instruction))
+	{
+		/* The default segment is SS if the base register is bp */
+		const uint8_t rm = instruction->modrm.fields.rm;
+		operand->fields.reg = (uint8_t)(rm == 0b010 || rm == 0b011 || (rm == 0b110 && instruction->modrm.fields.mod != 0b00) ? NMD_X86_REG_SS : NMD_X86_REG_DS);
+	}
+	else
+	{
+		/* The default segment is SS if the base register is (e/r)sp or (e/r)bp */
+		const uint8_t base = instruction->has_sib ? instruction->sib.fields.base : instruction->modrm.fields.rm;
+		operand->fields.reg = (uint8_t)(!(instruction->prefixes & NMD_X86_PREFIXES_REX_B) && (base == 0b100 || (base == 0b101 && instruction->modrm.fields.mod != 0b00)) ? NMD_X86_REG_SS : NMD_X86_REG_DS);
+	}
+}
+
+/* Decodes a memory operand. modrm is assumed to be in the range [00,BF] */
+NMD_ASSEMBLY_API void _nmd_decode_modrm_upper32(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+{
+    /* Set operand type */
+	operand->type = NMD_X86_OPERAND_TYPE_MEMORY;
+
+	if (_nmd_has_16bit_addressing(instruction))
+	{
+		static const uint8_t bases[8] = { NMD_X86_REG_BX, NMD_X86_REG_BX, NMD_X86_REG_BP, NMD_X86_REG_BP, NMD_X86_REG_SI, NMD_X86_REG_DI, NMD_X86_REG_BP, NMD_X86_REG_BX };
+		const uint8_t rm = instruction->modrm.fields.rm;
+		if (!(instruction->modrm.fields.mod == 0b00 && rm == 0b110)) /* disp16 */
+			operand->fields.mem.base = bases[rm];
+		if (rm < 0b100)
+			operand->fields.mem.index = (uint8_t)(rm % 2 ? NMD_X86_REG_DI : NMD_X86_REG_SI), operand->fields.mem.scale = 1;
+	}
+	else if (instruction->has_sib) /* R/M is 0b100 */
+	{
+		if (instruction->sib.fields.base == 0b101) /* Check if there is displacement */
+		{
+			if (instruction->modrm.fields.mod != 0b00)
+				operand->fields.mem.base = (uint8_t)(instruction->mode == NMD_X86_MODE_64 && !(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE) ? (instruction->prefixes & NMD_X86_PREFIXES_REX_B ? NMD_X86_REG_R13 : NMD_X86_REG_RBP) : NMD_X86_REG_EBP);
+		}
+		else
+			operand->fields.mem.base = (uint8_t)((instruction->mode == NMD_X86_MODE_64 && !(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE) ? (instruction->prefixes & NMD_X86_PREFIXES_REX_B ? NMD_X86_REG_R8 : NMD_X86_REG_RAX) : NMD_X86_REG_EAX) + instruction->sib.fields.base);
+
+		if (instruction->sib.fields.index != 0b100)
+			operand->fields.mem.index = (uint8_t)((instruction->mode == NMD_X86_MODE_64 && !(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE) ? (instruction->prefixes & NMD_X86_PREFIXES_REX_X ? NMD_X86_REG_R8 : NMD_X86_REG_RAX) : NMD_X86_REG_EAX) + instruction->sib.fields.index);
+
+		if (instruction->prefixes & NMD_X86_PREFIXES_REX_X && instruction->sib.fields.index == 0b100)
+		{
+			operand->fields.mem.index = (uint8_t)NMD_X86_REG_R12;
+		}
+        
+		if (operand->fields.mem.index)
+			operand->fields.mem.scale = (uint8_t)(1 << instruction->sib.fields.scale);
+	}
+	else if (!(instruction->modrm.fields.mod == 0b00 && instruction->modrm.fields.rm == 0b101))
+	{
+		if ((instruction->prefixes & (NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE | NMD_X86_PREFIXES_REX_B)) == (NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE | NMD_X86_PREFIXES_REX_B) && instruction->mode == NMD_X86_MODE_64)
+			operand->fields.mem.base = (uint8_t)(NMD_X86_REG_R8D + instruction->modrm.fields.rm);
+		else
+			operand->fields.mem.base = (uint8_t)((instruction->mode == NMD_X86_MODE_64 && !(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE) ? (instruction->prefixes & NMD_X86_PREFIXES_REX_B ? NMD_X86_REG_R8 : NMD_X86_REG_RAX) : NMD_X86_REG_EAX) + instruction->modrm.fields.rm);
+	}
+	else if (instruction->mode == NMD_X86_MODE_64) /* RIP-relative */
+		operand->fields.mem.base = (uint8_t)(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE ? NMD_X86_REG_EIP : NMD_X86_REG_RIP);
+
+	_nmd_decode_operand_segment_reg(instruction, operand);
+
+	/* The displacement is sign-extended, except the 16-bit absolute address(e.g. '[0xDDFE]') */
+	if (_nmd_has_16bit_addressing(instruction) && instruction->modrm.fields.mod == 0b00 && instruction->modrm.fields.rm == 0b110)
+		operand->fields.mem.disp = instruction->displacement;
+	else
+		operand->fields.mem.disp = _nmd_sign_extend(instruction->displacement, instruction->disp_mask);
+}
+
+NMD_ASSEMBLY_API void _nmd_decode_memory_operand(const nmd_x86_instruction* instruction, nmd_x86_operand* operand, uint8_t mod11base_reg)
+{
+	if (instruction->modrm.fields.mod == 0b11)
+	{
+		operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
+		operand->fields.reg = mod11base_reg + instruction->modrm.fields.rm;
+		if (instruction->prefixes & NMD_X86_PREFIXES_REX_B)
+			operand->fields.reg = _nmd_extend_gpr(operand->fields.reg);
+	}
+	else
+	{
+		_nmd_decode_modrm_upper32(instruction, operand);
+		operand->fields.mem.size = (uint8_t)(mod11base_reg == NMD_X86_REG_AL ? 1 : (mod11base_reg == NMD_X86_REG_AX ? 2 : (mod11base_reg == NMD_X86_REG_EAX ? 4 : ((mod11base_reg == NMD_X86_REG_RAX || mod11base_reg == NMD_X86_REG_MM0) ? 8 : (mod11base_reg == NMD_X86_REG_XMM0 ? 16 : 0)))));
+	}
+}
+
+NMD_ASSEMBLY_API void _nmd_decode_operand_Eb(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+{
+	_nmd_decode_memory_operand(instruction, operand, NMD_X86_REG_AL);
+}
+
+NMD_ASSEMBLY_API void _nmd_decode_operand_Ew(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+{
+	_nmd_decode_memory_operand(instruction, operand, NMD_X86_REG_AX);
+}
+
+NMD_ASSEMBLY_API void _nmd_decode_operand_Ev(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+{
+	_nmd_decode_memory_operand(instruction, operand, (uint8_t)_NMD_GET_BY_MODE_OPSZPRFX_W64(instruction->mode, instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE, instruction->rex_w_prefix, NMD_X86_REG_AX, NMD_X86_REG_EAX, NMD_X86_REG_RAX));
+}
+
+NMD_ASSEMBLY_API void _nmd_decode_operand_Ey(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+{
+	_nmd_decode_memory_operand(instruction, operand, (uint8_t)(instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? NMD_X86_REG_AX : NMD_X86_REG_EAX));
+}
+
+NMD_ASSEMBLY_API void _nmd_decode_operand_Qq(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+{
+	_nmd_decode_memory_operand(instruction, operand, NMD_X86_REG_MM0);
+}
+
+NMD_ASSEMBLY_API void _nmd_decode_operand_Wdq(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+{
+	_nmd_decode_memory_operand(instruction, operand, NMD_X86_REG_XMM0);
+}
+
+NMD_ASSEMBLY_API void _nmd_decode_operand_Gb(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+{
+	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
+	operand->fields.reg = NMD_X86_REG_AL + instruction->modrm.fields.reg;
+	if (instruction->prefixes & NMD_X86_PREFIXES_REX_R)
+		operand->fields.reg = _nmd_extend_gpr(operand->fields.reg);
+}
+
+NMD_ASSEMBLY_API void _nmd_decode_operand_Gd(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+{
+	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
+	operand->fields.reg = NMD_X86_REG_EAX + instruction->modrm.fields.reg;
+}
+
+NMD_ASSEMBLY_API void _nmd_decode_operand_Gw(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+{
+	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
+	operand->fields.reg = NMD_X86_REG_AX + instruction->modrm.fields.reg;
+}
+
+NMD_ASSEMBLY_API void _nmd_decode_operand_Gv(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+{
+	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
+	operand->fields.reg = (uint8_t)(_NMD_GET_BY_MODE_OPSZPRFX_W64(instruction->mode, instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE, instruction->rex_w_prefix, NMD_X86_REG_AX, NMD_X86_REG_EAX, NMD_X86_REG_RAX) + instruction->modrm.fields.reg);
+	if (instruction->prefixes & NMD_X86_PREFIXES_REX_R)
+		operand->fields.reg = _nmd_extend_gpr(operand->fields.reg);
+}
+
+NMD_ASSEMBLY_API void _nmd_decode_operand_Rv(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+{
+	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
+	if (instruction->prefixes & NMD_X86_PREFIXES_REX_R)
+		operand->fields.reg = (uint8_t)((!(instruction->prefixes & NMD_X86_PREFIXES_REX_W) ? NMD_X86_REG_R8D : NMD_X86_REG_R8) + instruction->modrm.fields.rm);
+	else
+		operand->fields.reg = (uint8_t)((instruction->rex_w_prefix ? NMD_X86_REG_RAX : ((instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE && instruction->mode != NMD_X86_MODE_16) || (instruction->mode == NMD_X86_MODE_16 && !(instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)) ? NMD_X86_REG_AX : NMD_X86_REG_EAX)) + instruction->modrm.fields.rm);
+}
+
+NMD_ASSEMBLY_API void _nmd_decode_operand_Gy(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+{
+	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
+	operand->fields.reg = (uint8_t)((instruction->mode == NMD_X86_MODE_64 ? NMD_X86_REG_RAX : NMD_X86_REG_EAX) + instruction->modrm.fields.reg);
+}
+
+NMD_ASSEMBLY_API void _nmd_decode_operand_Pq(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+{
+	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
+	operand->fields.reg = NMD_X86_REG_MM0 + instruction->modrm.fields.reg;
+}
+
+NMD_ASSEMBLY_API void _nmd_decode_operand_Nq(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+{
+	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
+	operand->fields.reg = NMD_X86_REG_MM0 + instruction->modrm.fields.rm;
+}
+
+NMD_ASSEMBLY_API void _nmd_decode_operand_Vdq(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+{
+	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
+	operand->fields.reg = NMD_X86_REG_XMM0 + instruction->modrm.fields.reg;
+}
+
+NMD_ASSEMBLY_API void _nmd_decode_operand_Udq(const nmd_x86_instruction* instruction, nmd_x86_operand* operand)
+{
+	operand->type = NMD_X86_OPERAND_TYPE_REGISTER;
+	operand->fields.reg = NMD_X86_REG_XMM0 + instruction->modrm.fields.rm;
+}
+
+NMD_ASSEMBLY_API void _nmd_decode_conditional_flag(nmd_x86_instruction* instruction, const uint8_t condition)
+{
+	switch (condition)
+	{
+		case 0x0: instruction->tested_flags.fields.OF = 1; break;                                                                             /* Jump if overflow (OF=1) */
+		case 0x1: instruction->tested_flags.fields.OF = 1; break;                                                                             /* Jump if not overflow (OF=0) */
+		case 0x2: instruction->tested_flags.fields.CF = 1; break;                                                                             /* Jump if not above or equal (CF=1) */
+		case 0x3: instruction->tested_flags.fields.CF = 1; break;                                                                             /* Jump if not below (CF=0) */
+		case 0x4: instruction->tested_flags.fields.ZF = 1; break;                                                                             /* Jump if equal (ZF=1) */
+		case 0x5: instruction->tested_flags.fields.ZF = 1; break;                                                                             /* Jump if not equal (ZF=0) */
+		case 0x6: instruction->tested_flags.fields.CF = instruction->tested_flags.fields.ZF = 1; break;                                       /* Jump if not above (CF=1 or ZF=1) */
+		case 0x7: instruction->tested_flags.fields.CF = instruction->tested_flags.fields.ZF = 1; break;                                       /* Jump if not below or equal (CF=0 and ZF=0) */
+		case 0x8: instruction->tested_flags.fields.SF = 1; break;                                                                             /* Jump if sign (SF=1) */
+		case 0x9: instruction->tested_flags.fields.SF = 1; break;                                                                             /* Jump if not sign (SF=0) */
+		case 0xa: instruction->tested_flags.fields.PF = 1; break;                                                                             /* Jump if parity/parity even (PF=1) */
+		case 0xb: instruction->tested_flags.fields.PF = 1; break;                                                                             /* Jump if parity odd (PF=0) */
+		case 0xc: instruction->tested_flags.fields.SF = instruction->tested_flags.fields.OF = 1; break;                                       /* Jump if not greater or equal (SF != OF) */
+		case 0xd: instruction->tested_flags.fields.SF = instruction->tested_flags.fields.OF = 1; break;                                       /* Jump if not less (SF=OF) */
+		case 0xe: instruction->tested_flags.fields.ZF = instruction->tested_flags.fields.SF = instruction->tested_flags.fields.OF = 1; break; /* Jump if not greater (ZF=1 or SF != OF) */
+		case 0xf: instruction->tested_flags.fields.ZF = instruction->tested_flags.fields.SF = instruction->tested_flags.fields.OF = 1; break; /* Jump if not less or equal (ZF=0 and SF=OF) */
+	}
+}
+
+NMD_ASSEMBLY_API bool _nmd_decode_modrm(const uint8_t** p_buffer, size_t* p_buffer_size, nmd_x86_instruction* const instruction)
+{
+	instruction->has_modrm = true;
+	_NMD_READ_BYTE(*p_buffer, *p_buffer_size, instruction->modrm.modrm);
+	
+	const bool address_prefix = (bool)(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE);
+
+	/* Check for 16-Bit Addressing Form. The address size prefix toggles between 16 and 32-bit addressing outside 64-bit mode */
+	if (instruction->mode != NMD_X86_MODE_64 && (instruction->mode == NMD_X86_MODE_16) != address_prefix)
+	{
+		/* Check for displacement */
+		if ((instruction->modrm.fields.mod == 0b00 && instruction->modrm.fields.rm == 0b110) || instruction->modrm.fields.mod == 0b10)
+			instruction->disp_mask = NMD_X86_DISP16;
+		else if (instruction->modrm.fields.mod == 0b01)
+			instruction->disp_mask = NMD_X86_DISP8;
+	}
+	else
+	{
+		/* Check for SIB byte */
+		if (instruction->modrm.modrm < 0xC0 && instruction->modrm.fields.rm == 0b100)
+		{
+			instruction->has_sib = true;
+			_NMD_READ_BYTE(*p_buffer, *p_buffer_size, instruction->sib.sib);
+		}
+
+		/* Check for displacement */
+		if (instruction->modrm.fields.mod == 0b01) /* disp8 (ModR/M) */
+			instruction->disp_mask = NMD_X86_DISP8;
+		else if ((instruction->modrm.fields.mod == 0b00 && instruction->modrm.fields.rm == 0b101) || instruction->modrm.fields.mod == 0b10) /* disp32 (ModR/M) */
+			instruction->disp_mask = NMD_X86_DISP32;
+		else if (instruction->has_sib && instruction->sib.fields.base == 0b101) /* disp8,32 (SIB) */
+			instruction->disp_mask = (uint8_t)(instruction->modrm.fields.mod == 0b01 ? NMD_X86_DISP8 : NMD_X86_DISP32);
+	}
+
+	/* Make sure we can read 'instruction->disp_mask' bytes from the buffer */
+	if (*p_buffer_size < instruction->disp_mask)
+		return false;
+	
+	/* Copy 'instruction->disp_mask' bytes from the buffer */
+	size_t i = 0;
+	for (; i < (size_t)instruction->disp_mask; i++)
+		((uint8_t*)(&instruction->displacement))[i] = (*p_buffer)[i];
+	
+	/* Increment the buffer and decrement the buffer's size */
+	*p_buffer += instruction->disp_mask;
+	*p_buffer_size -= instruction->disp_mask;
+
+	return true;
+}
+
+/* Adds 'reg' to the masks of 'registers'. 'action' is a mask of 'NMD_X86_OPERAND_ACTION'. */
+NMD_ASSEMBLY_API void _nmd_add_register_use(nmd_x86_register_use* registers, uint8_t reg, uint8_t action)
+{
+	uint32_t* read;
+	uint32_t* written;
+	uint32_t bit;
+
+	if (reg >= NMD_X86_REG_IP && reg <= NMD_X86_REG_RIP)
+		read = &registers->gpr_read, written = &registers->gpr_written, bit = NMD_X86_REGISTER_USE_IP;
+	else if (reg >= NMD_X86_REG_AL && reg <= NMD_X86_REG_R15D)
+	{
+		read = &registers->gpr_read, written = &registers->gpr_written;
+		if (reg >= NMD_X86_REG_AH && reg <= NMD_X86_REG_BH)
+			bit = 1u << (reg - NMD_X86_REG_AH);
+		else
+			bit = 1u << ((reg >= NMD_X86_REG_R8 ? 8 : 0) + reg % 8);
+
+		/* A write to an 8 or 16-bit register keeps the register's other bits. */
+		if (action & NMD_X86_OPERAND_ACTION_ANY_WRITE && (reg <= NMD_X86_REG_DI || (reg >= NMD_X86_REG_R8B && reg <= NMD_X86_REG_R15W)))
+			action |= NMD_X86_OPERAND_ACTION_READ;
+	}
+	else if (reg >= NMD_X86_REG_ES && reg <= NMD_X86_REG_GS)
+		read = &registers->gpr_read, written = &registers->gpr_written, bit = NMD_X86_REGISTER_USE_ES << (reg - NMD_X86_REG_ES);
+	else if (reg >= NMD_X86_REG_XMM0 && reg <= NMD_X86_REG_ZMM31)
+		read = &registers->vector_read, written = &registers->vector_written, bit = 1u << ((reg - NMD_X86_REG_XMM0) % 32);
+	else
+	{
+		read = &registers->other_read, written = &registers->other_written;
+		if (reg >= NMD_X86_REG_CR0 && reg <= NMD_X86_REG_CR15)
+			bit = NMD_X86_REGISTER_USE_CR;
+		else if (reg >= NMD_X86_REG_DR0 && reg <= NMD_X86_REG_DR15)
+			bit = NMD_X86_REGISTER_USE_DR;
+		else if (reg >= NMD_X86_REG_MM0 && reg <= NMD_X86_REG_MM7)
+			bit = NMD_X86_REGISTER_USE_MM0 << (reg - NMD_X86_REG_MM0);
+		else if (reg >= NMD_X86_REG_K0 && reg <= NMD_X86_REG_K7)
+			bit = NMD_X86_REGISTER_USE_K0 << (reg - NMD_X86_REG_K0);
+		else if (reg >= NMD_X86_REG_ST0 && reg <= NMD_X86_REG_ST7)
+			bit = NMD_X86_REGISTER_USE_ST0 << (reg - NMD_X86_REG_ST0);
+		else
+			return;
+	}
+
+	if (action & NMD_X86_OPERAND_ACTION_ANY_READ)
+		*read |= bit;
+	if (action & NMD_X86_OPERAND_ACTION_ANY_WRITE)
+		*written |= bit;
+}
+
+/* Adds the registers of a memory operand, which are read to compute the address. The segment register is not used by 'lea'. */
+NMD_ASSEMBLY_API void _nmd_add_memory_register_use(const nmd_x86_instruction* instruction, nmd_x86_register_use* registers, const nmd_x86_memory_operand* mem)
+{
+	_nmd_add_register_use(registers, mem->base, NMD_X86_OPERAND_ACTION_READ);
+	_nmd_add_register_use(registers, mem->index, NMD_X86_OPERAND_ACTION_READ);
+	if (instruction->id != NMD_X86_INSTRUCTION_LEA)
+		_nmd_add_register_use(registers, mem->segment, NMD_X86_OPERAND_ACTION_READ);
+}
+
+/*
+Gets the actions of the ModR/M.reg and ModR/M.rm registers of an instruction whose operands are not filled by the decoder. An action is 'NMD_X86_OPERAND_ACTION_NONE' if
+the field is not a register(e.g. ModR/M.reg of a group opcode). Only the destination is written. It's also assumed to be read, because some destinations are(e.g. 'shrd').
+*/
+NMD_ASSEMBLY_API void _nmd_get_modrm_actions(const nmd_x86_instruction* instruction, uint8_t* reg_action, uint8_t* rm_action)
+{
+	const uint8_t op = instruction->opcode, reg = instruction->modrm.fields.reg;
+
+	/* The destination is usually ModR/M.reg */
+	*reg_action = NMD_X86_OPERAND_ACTION_READWRITE;
+	*rm_action = NMD_X86_OPERAND_ACTION_READ;
+
+	if (instruction->encoding == NMD_X86_ENCODING_VEX)
+	{
+		const uint8_t map = instruction->vex.vex[0] == 0xc5 ? 1 : instruction->vex.m_mmmm;
+		if (map == 1 && ((op >= 0x71 && op <= 0x73) || op == 0xae)) /* Groups('vpsrlw xmm,xmm,imm8', 'vldmxcsr') */
+			*reg_action = NMD_X86_OPERAND_ACTION_NONE;
+		else if (map == 1 && (op == 0x11 || op == 0x29 || op == 0x7f || op == 0xd6 || (op == 0x7e && instruction->vex.pp != 0b10))) /* Stores('vmovups xmm/m128,xmm', 'vmovd r/m32,xmm') */
+			*reg_action = NMD_X86_OPERAND_ACTION_READ, *rm_action = NMD_X86_OPERAND_ACTION_READWRITE;
+		else if (map == 1 && (op == 0x13 || op == 0x17 || op == 0x2b || op == 0xe7)) /* Stores to memory('vmovlps m64,xmm', 'vmovntps m128,xmm') */
+			*reg_action = NMD_X86_OPERAND_ACTION_READ;
+		else if (map == 2 && (op == 0x2e || op == 0x2f || op == 0x8e)) /* 'vmaskmovps m128,xmm,xmm', 'vpmaskmovd m128,xmm,xmm' */
+			*reg_action = NMD_X86_OPERAND_ACTION_READ;
+		else if (map == 2 && op == 0xf3) /* Group('blsr r32,r/m32') */
+			*reg_action = NMD_X86_OPERAND_ACTION_NONE;
+		else if (map == 3 && ((op >= 0x14 && op <= 0x17) || op == 0x19 || op == 0x1d || op == 0x39)) /* 'vpextrb r/m8,xmm,imm8', 'vextractf128 xmm/m128,ymm,imm8', 'vcvtps2ph xmm/m64,xmm,imm8' */
+			*reg_action = NMD_X86_OPERAND_ACTION_READ, *rm_action = NMD_X86_OPERAND_ACTION_READWRITE;
+	}
+	else if (instruction->opcode_map == NMD_X86_OPCODE_MAP_DEFAULT && op >= 0xd8 && op <= 0xdf)
+	{
+		/* x87 instruction. ModR/M.reg is part of the opcode and ModR/M.rm is 'st(i)', which is only written by 'fxch', 'ffree', 'fst', 'fstp' and the DC and DE
+		   arithmetic forms(e.g. 'fadd st(i),st(0)'), except 'fcompp' */
+		*reg_action = NMD_X86_OPERAND_ACTION_NONE;
+		if ((op == 0xd9 && reg == 1) || (op == 0xdd && reg <= 3) || op == 0xdc || (op == 0xde && reg != 3))
+			*rm_action = NMD_X86_OPERAND_ACTION_READWRITE;
+	}
+	else if (instruction->opcode_map == NMD_X86_OPCODE_MAP_0F)
+	{
+		if (op == 0x00) /* Group('sldt r/m16' and 'str r/m16' write ModR/M.rm, 'lldt', 'ltr', 'verr' and 'verw' read it) */
+			*reg_action = NMD_X86_OPERAND_ACTION_NONE, *rm_action = (uint8_t)(reg <= 1 ? NMD_X86_OPERAND_ACTION_READWRITE : NMD_X86_OPERAND_ACTION_READ);
+		else if (op == 0xba) /* Group('bt r/m,imm8' reads ModR/M.rm, 'bts', 'btr' and 'btc' write it) */
+			*reg_action = NMD_X86_OPERAND_ACTION_NONE, *rm_action = (uint8_t)(reg >= 5 ? NMD_X86_OPERAND_ACTION_READWRITE : NMD_X86_OPERAND_ACTION_READ);
+		else if (op == 0xc7) /* Group('rdrand r', 'rdseed r', 'cmpxchg8b m64') */
+			*reg_action = NMD_X86_OPERAND_ACTION_NONE, *rm_action = NMD_X86_OPERAND_ACTION_READWRITE;
+		else if (op == 0x0d || (op >= 0x18 && op <= 0x1f) || op == 0xa3 || op == 0xb9 || op == 0xff) /* Hints('prefetchw', 'nop r/m'), 'bt r/m,r', 'ud1' and 'ud0' write nothing */
+			*reg_action = NMD_X86_OPERAND_ACTION_READ;
+		else if (op == 0xa4 || op == 0xa5 || op == 0xab || op == 0xac || op == 0xad || op == 0xb0 || op == 0xb1 || op == 0xb3 || op == 0xbb) /* 'shld', 'shrd', 'bts', 'btr', 'btc' and 'cmpxchg' write ModR/M.rm */
+			*reg_action = NMD_X86_OPERAND_ACTION_READ, *rm_action = NMD_X86_OPERAND_ACTION_READWRITE;
+		else if (op == 0xc0 || op == 0xc1) /* 'xadd' writes both */
+			*rm_action = NMD_X86_OPERAND_ACTION_READWRITE;
+	}
+}
+
+/*
+Adds the registers of the ModR/M byte of an instruction whose operands are not filled by the decoder(e.g. VEX instructions).
+The operands' actions are unknown, see _nmd_get_modrm_actions(). 'vex.vvvv' is assumed to be read.
+*/
+NMD_ASSEMBLY_API void _nmd_add_modrm_register_use(const nmd_x86_instruction* instruction, nmd_x86_register_use* registers)
+{
+	const bool vex = instruction->encoding == NMD_X86_ENCODING_VEX;
+	uint8_t reg_action, rm_action;
+	_nmd_get_modrm_actions(instruction, &reg_action, &rm_action);
+
+	if (!vex && instruction->opcode_map == NMD_X86_OPCODE_MAP_DEFAULT && instruction->opcode >= 0xd8 && instruction->opcode <= 0xdf)
+	{
+		/* x87 instruction. */
+		if (instruction->modrm.fields.mod == 0b11)
+			_nmd_add_register_use(registers, (uint8_t)(NMD_X86_REG_ST0 + instruction->modrm.fields.rm), rm_action);
+	}
+	else
+	{
+		/* The registers of legacy instructions are general purpose registers, except in the 0F38h and 0F3Ah maps(SSE). 'r8'-'r15' follow 'rax'-'rdi' like 'xmm8'-'xmm15' follow 'xmm0'-'xmm7'. */
+		const uint8_t base_reg = (uint8_t)(vex || ((instruction->opcode_map == NMD_X86_OPCODE_MAP_0F38 || instruction->opcode_map == NMD_X86_OPCODE_MAP_0F3A) && instruction->opcode < 0xf0) ? NMD_X86_REG_XMM0 : NMD_X86_REG_RAX);
+		const bool extend_reg = vex ? (instruction->mode == NMD_X86_MODE_64 && !instruction->vex.R) : (instruction->prefixes & NMD_X86_PREFIXES_REX_R) != 0;
+		const bool extend_rm = vex ? (instruction->mode == NMD_X86_MODE_64 && instruction->vex.vex[0] == 0xc4 && !instruction->vex.B) : (instruction->prefixes & NMD_X86_PREFIXES_REX_B) != 0;
+
+		if (reg_action)
+			_nmd_add_register_use(registers, (uint8_t)(base_reg + (extend_reg ? 8 : 0) + instruction->modrm.fields.reg), reg_action);
+		if (instruction->modrm.fields.mod == 0b11)
+			_nmd_add_register_use(registers, (uint8_t)(base_reg + (extend_rm ? 8 : 0) + instruction->modrm.fields.rm), rm_action);
+	}
+
+	if (vex)
+		_nmd_add_register_use(registers, (uint8_t)(NMD_X86_REG_XMM0 + ((15 - instruction->vex.vvvv) & (instruction->mode == NMD_X86_MODE_64 ? 15 : 7))), NMD_X86_OPERAND_ACTION_READ);
+
+	if (instruction->modrm.fields.mod != 0b11)
+	{
+		nmd_x86_operand operand;
+		operand.fields.mem.base = operand.fields.mem.index = 0;
+		_nmd_decode_modrm_upper32(instruction, &operand);
+
+		/* The REX prefix is not used by VEX instructions, the registers are extended by 'vex.B' and 'vex.X'. */
+		if (vex && instruction->mode == NMD_X86_MODE_64 && instruction->vex.vex[0] == 0xc4)
+		{
+			if (!instruction->vex.B && operand.fields.mem.base >= NMD_X86_REG_EAX && operand.fields.mem.base <= NMD_X86_REG_RDI)
+				operand.fields.mem.base = _nmd_extend_gpr(operand.fields.mem.base);
+			if (!instruction->vex.X && operand.fields.mem.index >= NMD_X86_REG_EAX && operand.fields.mem.index <= NMD_X86_REG_RDI)
+				operand.fields.mem.index = _nmd_extend_gpr(operand.fields.mem.index);
+		}
+
+		_nmd_add_memory_register_use(instruction, registers, &operand.fields.mem);
+	}
+}
+
+/* Returns the mask of the segment register used by the source operand of a string instruction. */
+NMD_ASSEMBLY_API uint32_t _nmd_get_string_source_segment(const nmd_x86_instruction* instruction)
+{
+	return instruction->segment_override ? (uint32_t)NMD_X86_REGISTER_USE_ES << _nmd_get_bit_index(instruction->segment_override) : (uint32_t)NMD_X86_REGISTER_USE_DS;
+}
+
+/* Adds the registers used by the instruction that are not in its operands(e.g. 'rdx' of 'mul ecx' and 'rsi'/'rdi'/'rcx' of 'rep movsb'). */
+NMD_ASSEMBLY_API void _nmd_add_implicit_register_use(const nmd_x86_instruction* instruction, nmd_x86_register_use* registers)
+{
+	uint32_t read = 0, written = 0;
+
+	switch (instruction->id)
+	{
+	case NMD_X86_INSTRUCTION_IMUL:
+		if (instruction->num_operands != 1)
+			break;
+		/* fall through */
+	case NMD_X86_INSTRUCTION_MUL:
+		read = NMD_X86_REGISTER_USE_RAX;
+		written = instruction->opcode == 0xf6 ? NMD_X86_REGISTER_USE_RAX : (NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RDX);
+		break;
+	case NMD_X86_INSTRUCTION_DIV:
+	case NMD_X86_INSTRUCTION_IDIV:
+		read = written = instruction->opcode == 0xf6 ? NMD_X86_REGISTER_USE_RAX : (NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RDX);
+		break;
+	case NMD_X86_INSTRUCTION_STOSB: case NMD_X86_INSTRUCTION_STOSW: case NMD_X86_INSTRUCTION_STOSD: case NMD_X86_INSTRUCTION_STOSQ:
+		read = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RDI | NMD_X86_REGISTER_USE_ES;
+		written = NMD_X86_REGISTER_USE_RDI;
+		break;
+	case NMD_X86_INSTRUCTION_LODSB: case NMD_X86_INSTRUCTION_LODSW: case NMD_X86_INSTRUCTION_LODSD: case NMD_X86_INSTRUCTION_LODSQ:
+		read = NMD_X86_REGISTER_USE_RSI | _nmd_get_string_source_segment(instruction);
+		written = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RSI;
+		break;
+	case NMD_X86_INSTRUCTION_MOVSB: case NMD_X86_INSTRUCTION_MOVSW: case NMD_X86_INSTRUCTION_MOVSD: case NMD_X86_INSTRUCTION_MOVSQ:
+	case NMD_X86_INSTRUCTION_CMPSB: case NMD_X86_INSTRUCTION_CMPSW: case NMD_X86_INSTRUCTION_CMPSD: case NMD_X86_INSTRUCTION_CMPSQ:
+		/* 'movsd' and 'cmpsd' are also SSE instructions. */
+		if (instruction->opcode_map != NMD_X86_OPCODE_MAP_DEFAULT)
+			return;
+		read = NMD_X86_REGISTER_USE_RSI | NMD_X86_REGISTER_USE_RDI | NMD_X86_REGISTER_USE_ES | _nmd_get_string_source_segment(instruction);
+		written = NMD_X86_REGISTER_USE_RSI | NMD_X86_REGISTER_USE_RDI;
+		break;
+	case NMD_X86_INSTRUCTION_SCASB: case NMD_X86_INSTRUCTION_SCASW: case NMD_X86_INSTRUCTION_SCASD: case NMD_X86_INSTRUCTION_SCASQ:
+		read = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RDI | NMD_X86_REGISTER_USE_ES;
+		written = NMD_X86_REGISTER_USE_RDI;
+		break;
+	case NMD_X86_INSTRUCTION_INSB: case NMD_X86_INSTRUCTION_INSW: case NMD_X86_INSTRUCTION_INSD:
+		read = NMD_X86_REGISTER_USE_RDX | NMD_X86_REGISTER_USE_RDI | NMD_X86_REGISTER_USE_ES;
+		written = NMD_X86_REGISTER_USE_RDI;
+		break;
+	case NMD_X86_INSTRUCTION_OUTSB: case NMD_X86_INSTRUCTION_OUTSW: case NMD_X86_INSTRUCTION_OUTSD:
+		read = NMD_X86_REGISTER_USE_RDX | NMD_X86_REGISTER_USE_RSI | _nmd_get_string_source_segment(instruction);
+		written = NMD_X86_REGISTER_USE_RSI;
+		break;
+	case NMD_X86_INSTRUCTION_LOOP: case NMD_X86_INSTRUCTION_LOOPE: case NMD_X86_INSTRUCTION_LOOPNE:
+		read = written = NMD_X86_REGISTER_USE_RCX;
+		break;
+	case NMD_X86_INSTRUCTION_JCXZ: case NMD_X86_INSTRUCTION_JECXZ: case NMD_X86_INSTRUCTION_JRCXZ:
+		read = NMD_X86_REGISTER_USE_RCX;
+		break;
+	case NMD_X86_INSTRUCTION_CMPXCHG:
+		read = written = NMD_X86_REGISTER_USE_RAX;
+		break;
+	case NMD_X86_INSTRUCTION_CMPXCHG8B:
+	case NMD_X86_INSTRUCTION_CMPXCHG16B:
+		read = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RCX | NMD_X86_REGISTER_USE_RDX | NMD_X86_REGISTER_USE_RBX;
+		written = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RDX;
+		break;
+	case NMD_X86_INSTRUCTION_RDTSCP:
+		written = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RCX | NMD_X86_REGISTER_USE_RDX;
+		break;
+	case NMD_X86_INSTRUCTION_XGETBV:
+	case NMD_X86_INSTRUCTION_RDPMC:
+		read = NMD_X86_REGISTER_USE_RCX;
+		written = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RDX;
+		break;
+	case NMD_X86_INSTRUCTION_XSETBV:
+		read = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RCX | NMD_X86_REGISTER_USE_RDX;
+		break;
+	case NMD_X86_INSTRUCTION_MONITOR:
+		read = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RCX | NMD_X86_REGISTER_USE_RDX;
+		break;
+	case NMD_X86_INSTRUCTION_MWAIT:
+		read = NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RCX;
+		break;
+	case NMD_X86_INSTRUCTION_ENTER:
+		read = written = NMD_X86_REGISTER_USE_RSP | NMD_X86_REGISTER_USE_RBP;
+		break;
+	case NMD_X86_INSTRUCTION_SWAPGS:
+		read = written = NMD_X86_REGISTER_USE_GS;
+		break;
+	}
+
+	/* String instructions use the direction flag, and 'rcx' if they have a repeat prefix. */
+	if (instruction->opcode_map == NMD_X86_OPCODE_MAP_DEFAULT && ((instruction->opcode >= 0xa4 && instruction->opcode <= 0xa7) || (instruction->opcode >= 0xaa && instruction->opcode <= 0xaf) || (instruction->opcode >= 0x6c && instruction->opcode <= 0x6f)))
+	{
+		registers->flags_read |= NMD_X86_EFLAGS_DF;
+		if (instruction->prefixes & (NMD_X86_PREFIXES_REPEAT | NMD_X86_PREFIXES_REPEAT_NOT_ZERO))
+		{
+			read |= NMD_X86_REGISTER_USE_RCX, written |= NMD_X86_REGISTER_USE_RCX;
+			if (instruction->opcode == 0xa6 || instruction->opcode == 0xa7 || instruction->opcode == 0xae || instruction->opcode == 0xaf)
+				registers->flags_read |= NMD_X86_EFLAGS_ZF;
+		}
+	}
+
+	/* Every branch writes the instruction pointer, relative branches also read it. */
+	if (instruction->group & (NMD_GROUP_JUMP | NMD_GROUP_CALL | NMD_GROUP_RET | NMD_GROUP_INT))
+	{
+		written |= NMD_X86_REGISTER_USE_IP;
+		if (instruction->group & NMD_GROUP_RELATIVE_ADDRESSING)
+			read |= NMD_X86_REGISTER_USE_IP;
+	}
+
+	registers->gpr_read |= read;
+	registers->gpr_written |= written;
+}
+
+/*
+Computes the registers and cpu flags read and written by an instruction. This is the function used by the decoder to fill the 'registers' variable
+if 'NMD_X86_DECODER_FLAGS_REGISTERS' is set. The masks are complete if the instruction was decoded with 'NMD_X86_DECODER_FLAGS_INSTRUCTION_ID',
+'NMD_X86_DECODER_FLAGS_CPU_FLAGS', 'NMD_X86_DECODER_FLAGS_OPERANDS' and 'NMD_X86_DECODER_FLAGS_GROUP'.
+Parameters:
+ - instruction [in]  A pointer to a variable of type 'nmd_x86_instruction' describing the instruction.
+ - registers   [out] A pointer to a variable of type 'nmd_x86_register_use' that receives the masks.
+*/
+NMD_ASSEMBLY_API void nmd_x86_get_register_use(const nmd_x86_instruction* instruction, nmd_x86_register_use* registers)
+{
+	size_t i;
+
+	registers->gpr_read = registers->gpr_written = 0;
+	registers->vector_read = registers->vector_written = 0;
+	registers->other_read = registers->other_written = 0;
+	registers->flags_read = instruction->tested_flags.eflags;
+	registers->flags_written = instruction->modified_flags.eflags | instruction->set_flags.eflags | instruction->cleared_flags.eflags | instruction->undefined_flags.eflags;
+
+	for (i = 0; i < instruction->num_operands; i++)
+	{
+		const nmd_x86_operand* operand = &instruction->operands[i];
+		if (operand->type == NMD_X86_OPERAND_TYPE_REGISTER)
+			_nmd_add_register_use(registers, operand->fields.reg, operand->action);
+		else if (operand->type == NMD_X86_OPERAND_TYPE_MEMORY)
+			_nmd_add_memory_register_use(instruction, registers, &operand->fields.mem);
+	}
+
+	if (!instruction->num_operands && instruction->has_modrm && instruction->id != NMD_X86_INSTRUCTION_NOP)
+		_nmd_add_modrm_register_use(instruction, registers);
+
+	_nmd_add_implicit_register_use(instruction, registers);
+}
+
+/* Sets the bytes in the range ['begin', 'end') of 'instruction' to zero. */
+#define _NMD_CLEAR_INSTRUCTION_RANGE(instruction, begin, end) do { uint8_t* _p = (uint8_t*)(instruction) + (begin); uint8_t* const _end = (uint8_t*)(instruction) + (end); for (; _p < _end; _p++) *_p = 0x00; } while (0)
+
+/* All zeros. Copying it as a whole lets the compiler emit one block copy instead of a byte loop. */
+static const nmd_x86_instruction _nmd_empty_instruction = { 0 };
+
+/* Clears the variables of 'instruction' used by the decoder. 'buffer', the operands, the cpu flags and 'registers' are only cleared if required by 'flags'. */
+NMD_ASSEMBLY_API void _nmd_clear_instruction(nmd_x86_instruction* instruction, uint32_t flags)
+{
+	size_t i;
+
+	if ((flags & (NMD_X86_DECODER_FLAGS_OPERANDS | NMD_X86_DECODER_FLAGS_CPU_FLAGS)) == (NMD_X86_DECODER_FLAGS_OPERANDS | NMD_X86_DECODER_FLAGS_CPU_FLAGS))
+	{
+		*instruction = _nmd_empty_instruction;
+		return;
+	}
+
+	_NMD_CLEAR_INSTRUCTION_RANGE(instruction, 0, _NMD_OFFSETOF(nmd_x86_instruction, buffer));
+
+	if (flags & NMD_X86_DECODER_FLAGS_OPERANDS)
+	{
+		for (i = 0; i < NMD_X86_MAXIMUM_NUM_OPERANDS; i++)
+			instruction->operands[i] = _nmd_empty_instruction.operands[i];
+	}
+
+	instruction->modrm.modrm = instruction->sib.sib = 0;
+	instruction->imm_mask = instruction->disp_mask = 0;
+	instruction->immediate = 0;
+	instruction->displacement = 0;
+	instruction->opcode_map = instruction->encoding = 0;
+	_NMD_CLEAR_INSTRUCTION_RANGE(instruction, _NMD_OFFSETOF(nmd_x86_instruction, vex), _NMD_OFFSETOF(nmd_x86_instruction, modified_flags));
+
+	if (flags & NMD_X86_DECODER_FLAGS_CPU_FLAGS)
+	{
+		instruction->modified_flags.eflags = instruction->tested_flags.eflags = instruction->set_flags.eflags = 0;
+		instruction->cleared_flags.eflags = instruction->undefined_flags.eflags = 0;
+	}
+
+	instruction->rex = instruction->segment_override = 0;
+	instruction->simd_prefix = 0;
+	if (flags & NMD_X86_DECODER_FLAGS_REGISTERS)
+		instruction->registers = _nmd_empty_instruction.registers;
+	instruction->source = 0;
+}
+
+/*
+Decodes an instruction assuming 'instruction' was already cleared by the caller(see _nmd_clear_instruction()).
+'buffer_size' must not be greater than 15(NMD_X86_MAXIMUM_INSTRUCTION_LENGTH).
+This function is always inlined, so every caller that passes constants as 'mode' and 'flags'(see NMD_X86_DEFINE_DECODER()) gets its own specialized decoder.
+*/
+_NMD_FORCE_INLINE bool _nmd_decode_instruction_inline(const void* const buffer, size_t buffer_size, nmd_x86_instruction* instruction, NMD_X86_MODE mode, uint32_t flags)
+{
+	/* Security considerations for memory safety:
+	The contents of 'buffer' should be considered untrusted and decoded carefully.
+	
+	'buffer' should always point to the start of the buffer. We use the 'b'
+	buffer iterator to read data from the buffer, however before accessing it
+	make sure to check 'buffer_size' to see if we can safely access it. Then,
+	after reading data from the buffer we increment 'b' and decrement 'buffer_size'.
+	Helper macros: _NMD_READ_BYTE()
+	*/
+	
+	size_t i;
+
+	/* Set mode */
+	instruction->mode = (uint8_t)mode;
+
+	/* Set buffer iterator */
+	const uint8_t* b = (const uint8_t*)buffer;
+	
+	/* Decode legacy and REX prefixes */
+	for (; buffer_size > 0; b++, buffer_size--)
+	{
+		switch (*b)
+		{
+		case 0xF0: instruction->prefixes = (instruction->prefixes | (instruction->simd_prefix = NMD_X86_PREFIXES_LOCK)); continue;
+		case 0xF2: instruction->prefixes = (instruction->prefixes | (instruction->simd_prefix = NMD_X86_PREFIXES_REPEAT_NOT_ZERO)), instruction->repeat_prefix = false; continue;
+		case 0xF3: instruction->prefixes = (instruction->prefixes | (instruction->simd_prefix = NMD_X86_PREFIXES_REPEAT)), instruction->repeat_prefix = true; continue;
+		case 0x2E: instruction->prefixes = (instruction->prefixes | (instruction->segment_override = NMD_X86_PREFIXES_CS_SEGMENT_OVERRIDE)); continue;
+		case 0x36: instruction->prefixes = (instruction->prefixes | (instruction->segment_override = NMD_X86_PREFIXES_SS_SEGMENT_OVERRIDE)); continue;
+		case 0x3E: instruction->prefixes = (instruction->prefixes | (instruction->segment_override = NMD_X86_PREFIXES_DS_SEGMENT_OVERRIDE)); continue;
+		case 0x26: instruction->prefixes = (instruction->prefixes | (instruction->segment_override = NMD_X86_PREFIXES_ES_SEGMENT_OVERRIDE)); continue;
+		case 0x64: instruction->prefixes = (instruction->prefixes | (instruction->segment_override = NMD_X86_PREFIXES_FS_SEGMENT_OVERRIDE)); continue;
+		case 0x65: instruction->prefixes = (instruction->prefixes | (instruction->segment_override = NMD_X86_PREFIXES_GS_SEGMENT_OVERRIDE)); continue;
+		case 0x66: instruction->prefixes = (instruction->prefixes | (instruction->simd_prefix = NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)), instruction->rex_w_prefix = false; continue;
+		case 0x67: instruction->prefixes = (instruction->prefixes | NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE); continue;
+		default:
+			if (mode == NMD_X86_MODE_64 && _NMD_R(*b) == 4) /* REX prefixes [0x40,0x4f] */
+			{
+				instruction->has_rex = true;
+				instruction->rex = *b;
+				instruction->prefixes = (instruction->prefixes & ~(NMD_X86_PREFIXES_REX_B | NMD_X86_PREFIXES_REX_X | NMD_X86_PREFIXES_REX_R | NMD_X86_PREFIXES_REX_W));
+
+				if (*b & 0b0001) /* Bit position 0 */
+					instruction->prefixes = instruction->prefixes | NMD_X86_PREFIXES_REX_B;
+				if (*b & 0b0010) /* Bit position 1 */
+					instruction->prefixes = instruction->prefixes | NMD_X86_PREFIXES_REX_X;
+				if (*b & 0b0100) /* Bit position 2 */
+					instruction->prefixes = instruction->prefixes | NMD_X86_PREFIXES_REX_R;
+				instruction->rex_w_prefix = false;
+				if (*b & 0b1000) /* Bit position 3 */
+				{
+					instruction->prefixes = instruction->prefixes | NMD_X86_PREFIXES_REX_W;
+					instruction->rex_w_prefix = true;
+				}
+
+				continue;
+			}
+		}
+
+		break;
+	}
+
+	/* Calculate the number of prefixes based on how much the iterator moved */
+	instruction->num_prefixes = (uint8_t)((ptrdiff_t)(b)-(ptrdiff_t)(buffer));
+
+	/* A REX prefix is ignored if it's not the last prefix */
+	if (instruction->has_rex && _NMD_R(b[-1]) != 4)
+	{
+		instruction->has_rex = false;
+		instruction->rex = 0;
+		instruction->rex_w_prefix = false;
+		instruction->prefixes = (instruction->prefixes & ~(NMD_X86_PREFIXES_REX_B | NMD_X86_PREFIXES_REX_X | NMD_X86_PREFIXES_REX_R | NMD_X86_PREFIXES_REX_W));
+	}
+
+	/* Assume the instruction uses legacy encoding. It is most likely the case */
+	instruction->encoding = NMD_X86_ENCODING_LEGACY;
+
+	/* Opcode byte. This variable is used because 'op' is simpler than 'instruction->opcode' */
+	uint8_t op;
+	_NMD_READ_BYTE(b, buffer_size, op);
+
+	if (op == 0x0F) /* 2 or 3 byte opcode */
+	{
+		_NMD_READ_BYTE(b, buffer_size, op);
+
+		if (op == 0x38 || op == 0x3A) /* 3 byte opcode */
+		{
+			instruction->opcode_size = 3;
+			instruction->opcode_map = (uint8_t)(op == 0x38 ? NMD_X86_OPCODE_MAP_0F38 : NMD_X86_OPCODE_MAP_0F3A);
+            
+			_NMD_READ_BYTE(b, buffer_size, op);
+			instruction->opcode = op;
+
+			if (!_nmd_decode_modrm(&b, &buffer_size, instruction))
+				return false;
+
+			const nmd_x86_modrm modrm = instruction->modrm;
+			if (instruction->opcode_map == NMD_X86_OPCODE_MAP_0F38)
+			{
+#ifndef NMD_ASSEMBLY_DISABLE_DECODER_VALIDITY_CHECK
+				if (flags & NMD_X86_DECODER_FLAGS_VALIDITY_CHECK)
+				{
+					/* Check if the instruction is invalid. */
+					if (op == 0x36)
+					{
+						return false;
+					}
+					else if (op <= 0xb || (op >= 0x1c && op <= 0x1e))
+					{
+						if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT || instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO)
+							return false;
+					}
+					else if (op >= 0xc8 && op <= 0xcd)
+					{
+						if (instruction->simd_prefix)
+							return false;
+					}
+					else if (op == 0x10 || op == 0x14 || op == 0x15 || op == 0x17 || (op >= 0x20 && op <= 0x25) || op == 0x28 || op == 0x29 || op == 0x2b || _NMD_R(op) == 3 || op == 0x40 || op == 0x41 || op == 0xcf || (op >= 0xdb && op <= 0xdf))
+					{
+						if (instruction->simd_prefix != NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
+							return false;
+					}
+					else if (op == 0x2a || (op >= 0x80 && op <= 0x82))
+					{
+						if (modrm.fields.mod == 0b11 || instruction->simd_prefix != NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
+							return false;
+					}
+					else if (op == 0xf0 || op == 0xf1)
+					{
+						if (modrm.fields.mod == 0b11 && (instruction->simd_prefix == NMD_X86_PREFIXES_NONE || instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE))
+							return false;
+						else if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT)
+							return false;
+					}
+					else if (op == 0xf5 || op == 0xf8)
+					{
+						if (instruction->simd_prefix != NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE || modrm.fields.mod == 0b11)
+							return false;
+					}
+					else if (op == 0xf6)
+					{
+						if (instruction->simd_prefix == NMD_X86_PREFIXES_NONE && modrm.fields.mod == 0b11)
+							return false;
+						else if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO)
+							return false;
+					}
+					else if (op == 0xf9)
+					{
+						if (instruction->simd_prefix != NMD_X86_PREFIXES_NONE || modrm.fields.mod == 0b11)
+							return false;
+					}
+					else
+						return false;
+				}
+#endif /* NMD_ASSEMBLY_DISABLE_DECODER_VALIDITY_CHECK */
+
+#ifndef NMD_ASSEMBLY_DISABLE_DECODER_INSTRUCTION_ID
+				if (flags & NMD_X86_DECODER_FLAGS_INSTRUCTION_ID)
+				{
+					if (_NMD_R(op) == 0x00)
+						instruction->id = NMD_X86_INSTRUCTION_PSHUFB + op;
+					else if (op >= 0x1c && op <= 0x1e)
+						instruction->id = NMD_X86_INSTRUCTION_PABSB + (op - 0x1c);
+					else if (_NMD_R(op) == 2)
+						instruction->id = NMD_X86_INSTRUCTION_PMOVSXBW + _NMD_C(op);
+					else if (_NMD_R(op) == 3)
+						instruction->id = NMD_X86_INSTRUCTION_PMOVZXBW + _NMD_C(op);
+					else if (_NMD_R(op) == 8)
+						instruction->id = NMD_X86_INSTRUCTION_INVEPT + _NMD_C(op);
+					else if (_NMD_R(op) == 0xc)
+						instruction->id = NMD_X86_INSTRUCTION_SHA1NEXTE + (_NMD_C(op) - 8);
+					else if (_NMD_R(op) == 0xd)
+						instruction->id = NMD_X86_INSTRUCTION_AESIMC + (_NMD_C(op) - 0xb);
+					else
+					{
+						switch (op)
+						{
+						case 0x10: instruction->id = NMD_X86_INSTRUCTION_PBLENDVB; break;
+						case 0x14: instruction->id = NMD_X86_INSTRUCTION_BLENDVPS; break;
+						case 0x15: instruction->id = NMD_X86_INSTRUCTION_BLENDVPD; break;
+						case 0x17: instruction->id = NMD_X86_INSTRUCTION_PTEST; break;
+						case 0x40: instruction->id = NMD_X86_INSTRUCTION_PMULLD; break;
+						case 0x41: instruction->id = NMD_X86_INSTRUCTION_PHMINPOSUW; break;
+						case 0xf0: case 0xf1: instruction->id = (uint16_t)((instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE || instruction->simd_prefix == 0x00) ? NMD_X86_INSTRUCTION_MOVBE : NMD_X86_INSTRUCTION_CRC32); break;
+						case 0xf6: instruction->id = (uint16_t)(instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? NMD_X86_INSTRUCTION_ADCX : NMD_X86_INSTRUCTION_ADOX); break;
+						}
+					}
+				}
+#endif /* NMD_ASSEMBLY_DISABLE_DECODER_INSTRUCTION_ID */
+				
+#ifndef NMD_ASSEMBLY_DISABLE_DECODER_CPU_FLAGS
+				if (flags & NMD_X86_DECODER_FLAGS_CPU_FLAGS)
+				{
+					if (op == 0x80 || op == 0x81) /* invept,invvpid */
+					{
+						instruction->modified_flags.eflags = NMD_X86_EFLAGS_CF | NMD_X86_EFLAGS_ZF;
+						instruction->cleared_flags.eflags = NMD_X86_EFLAGS_PF | NMD_X86_EFLAGS_AF | NMD_X86_EFLAGS_SF | NMD_X86_EFLAGS_OF;
+					}
+					else if (op == 0xf6)
+					{
+						if (instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE) /* adcx */
+							instruction->modified_flags.eflags = instruction->tested_flags.eflags = NMD_X86_EFLAGS_CF;
+						if (instruction->prefixes & NMD_X86_PREFIXES_REPEAT) /* adox */
+							instruction->modified_flags.eflags = instruction->tested_flags.eflags = NMD_X86_EFLAGS_OF;
+					}
+				}
+#endif /* NMD_ASSEMBLY_DISABLE_DECODER_CPU_FLAGS */
+
+#ifndef NMD_ASSEMBLY_DISABLE_DECODER_OPERANDS
+				if (flags & NMD_X86_DECODER_FLAGS_OPERANDS)
+				{
+					instruction->num_operands = 2;
+					instruction->operands[0].action = NMD_X86_OPERAND_ACTION_READWRITE;
+					instruction->operands[1].action = NMD_X86_OPERAND_ACTION_READ;
+
+					if (_NMD_R(op) == 0 || (op >= 0x1c && op <= 0x1e))
+					{
+						_nmd_decode_operand_Pq(instruction, &instruction->operands[0]);
+						_nmd_decode_operand_Qq(instruction, &instruction->operands[1]);
+					}
+					else if (_NMD_R(op) == 8)
+					{
+						_nmd_decode_operand_Gy(instruction, &instruction->operands[0]);
 						_nmd_decode_modrm_upper32(instruction, &instruction->operands[1]);
 					}
 					else if (_NMD_R(op) >= 1 && _NMD_R(op) <= 0xe)
@@ -4926,8 +7037,8 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 			instruction->opcode = op;
 			instruction->opcode_map = NMD_X86_OPCODE_MAP_0F;
 			
-			/* Check for ModR/M, SIB and displacement */
-			if (op >= 0x20 && op <= 0x23 && buffer_size == 2)
+			/* Check for ModR/M, SIB and displacement. 'mov' to/from control and debug registers ignores the 'mod' field, the operand is always a register */
+			if (op >= 0x20 && op <= 0x23)
 			{
 				instruction->has_modrm = true;
 				_NMD_READ_BYTE(b, buffer_size, instruction->modrm.modrm);
@@ -5619,6 +7730,7 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 							instruction->operands[2].type = NMD_X86_OPERAND_TYPE_REGISTER;
 							instruction->operands[2].fields.reg = NMD_X86_REG_CL;
 						}
+						instruction->operands[2].action = NMD_X86_OPERAND_ACTION_READ;
 					}
 
 					instruction->operands[0].action = NMD_X86_OPERAND_ACTION_READWRITE;
@@ -5790,8 +7902,8 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 		instruction->opcode = op;
 		instruction->opcode_map = NMD_X86_OPCODE_MAP_DEFAULT;
 
-		/* Check for ModR/M, SIB and displacement. */
-		if (_NMD_R(op) == 8 || _nmd_find_byte(_nmd_op1_modrm, sizeof(_nmd_op1_modrm), op) || (_NMD_R(op) < 4 && (_NMD_C(op) < 4 || (_NMD_C(op) >= 8 && _NMD_C(op) < 0xC))) || (_NMD_R(op) == 0xD && _NMD_C(op) >= 8) /* FIXME: We should not access the buffer directly from here || (remaining_size > 1 && ((nmd_x86_modrm*)(b + 1))->fields.mod != 0b11 && (op == 0xc4 || op == 0xc5 || op == 0x62)) */)
+		/* Check for ModR/M, SIB and displacement. Outside 64-bit mode 0x62 is BOUND unless ModR/M.mod is 0b11, which makes it an EVEX prefix. */
+		if (_NMD_R(op) == 8 || _nmd_find_byte(_nmd_op1_modrm, sizeof(_nmd_op1_modrm), op) || (_NMD_R(op) < 4 && (_NMD_C(op) < 4 || (_NMD_C(op) >= 8 && _NMD_C(op) < 0xC))) || (_NMD_R(op) == 0xD && _NMD_C(op) >= 8) || (op == 0x62 && mode != NMD_X86_MODE_64 && buffer_size && (*b >> 6) != 0b11) /* FIXME: We should not access the buffer directly from here || (remaining_size > 1 && ((nmd_x86_modrm*)(b + 1))->fields.mod != 0b11 && (op == 0xc4 || op == 0xc5)) */)
 		{
 			if (!_nmd_decode_modrm(&b, &buffer_size, instruction))
 				return false;
@@ -5858,7 +7970,7 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 				}
 				else /* 0xc5 */
 				{
-					instruction->vex.vvvv = (uint8_t)(byte1 & 0b01111000);
+					instruction->vex.vvvv = (uint8_t)((byte1 & 0b01111000) >> 3);
 					instruction->vex.L = byte1 & 0b00000100;
 					instruction->vex.pp = (uint8_t)(byte1 & 0b00000011);
 
@@ -5911,7 +8023,8 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 					}
 					else if (op == 0x62)
 					{
-						if (mode == NMD_X86_MODE_64)
+						/* EVEX is not supported */
+						if (!instruction->has_modrm)
 							return false;
 					}
 					else if (op == 0x8d)
@@ -6022,7 +8135,7 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 						instruction->id = (uint16_t)((_NMD_C(op) < 8) ? NMD_X86_INSTRUCTION_PUSH : NMD_X86_INSTRUCTION_POP);
 					else if (_NMD_R(op) < 4 && (op % 8 < 6))
 						instruction->id = (NMD_X86_INSTRUCTION_ADD + (_NMD_R(op) << 1) + (_NMD_C(op) >= 8 ? 1 : 0));
-					else if (op >= 0x80 && op <= 0x84)
+					else if (op >= 0x80 && op <= 0x83)
 						instruction->id = NMD_X86_INSTRUCTION_ADD + modrm.fields.reg;
 					else if (op == 0xe8)
 						instruction->id = NMD_X86_INSTRUCTION_CALL;
@@ -6535,7 +8648,7 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 					else if (op == 0x6a || op == 0x68) /* push imm8,push imm32/imm16 */
 					{
 						instruction->num_operands = 3;
-						_NMD_SET_IMM_OPERAND(instruction->operands[0], false, NMD_X86_OPERAND_ACTION_READ, instruction->immediate);
+						_NMD_SET_IMM_OPERAND(instruction->operands[0], false, NMD_X86_OPERAND_ACTION_READ, op == 0x6a ? (int8_t)instruction->immediate : instruction->immediate);
 						_NMD_SET_REG_OPERAND(instruction->operands[1], true, NMD_X86_OPERAND_ACTION_READWRITE, _NMD_GET_GPR(NMD_X86_REG_SP));
 						_NMD_SET_MEM_OPERAND(instruction->operands[2], true, NMD_X86_OPERAND_ACTION_WRITE, NMD_X86_REG_SS, _NMD_GET_GPR(NMD_X86_REG_SP), NMD_X86_REG_NONE, 0, 0);
 					}
@@ -6563,7 +8676,7 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 						_NMD_SET_REG_OPERAND(instruction->operands[2], true, NMD_X86_OPERAND_ACTION_READWRITE, _NMD_GET_GPR(NMD_X86_REG_SP));
 						_NMD_SET_MEM_OPERAND(instruction->operands[3], true, NMD_X86_OPERAND_ACTION_WRITE, NMD_X86_REG_SS, _NMD_GET_GPR(NMD_X86_REG_SP), NMD_X86_REG_NONE, 0, 0);
 					}
-                    else if (_NMD_R(op) < 4 && _NMD_C(op) < 6) /* add,adc,and,xor,or,sbb,sub,cmp Eb,Gb / Ev,Gv / Gb,Eb / Gv,Ev / AL,lb / rAX,lz */
+                    else if (_NMD_R(op) < 4 && op % 8 < 6) /* add,adc,and,xor,or,sbb,sub,cmp Eb,Gb / Ev,Gv / Gb,Eb / Gv,Ev / AL,lb / rAX,lz */
 					{
                         /*
                         if (op % 8 == 0)
@@ -6594,9 +8707,10 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 							if (op % 8 == 4)
 								instruction->operands[0].fields.reg = NMD_X86_REG_AL;
 							else
-								instruction->operands[0].fields.reg = (uint8_t)(instruction->rex_w_prefix ? NMD_X86_REG_RAX : (instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? NMD_X86_REG_AX : NMD_X86_REG_EAX));
+								instruction->operands[0].fields.reg = (uint8_t)_NMD_GET_BY_MODE_OPSZPRFX_W64(mode, opszprfx, instruction->rex_w_prefix, NMD_X86_REG_AX, NMD_X86_REG_EAX, NMD_X86_REG_RAX);
 
 							instruction->operands[1].type = NMD_X86_OPERAND_TYPE_IMMEDIATE;
+							instruction->operands[1].fields.imm = _nmd_sign_extend(instruction->immediate, instruction->imm_mask);
 						}
 
 						instruction->operands[0].action = instruction->operands[1].action = NMD_X86_OPERAND_ACTION_READ;
@@ -6621,7 +8735,13 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 					else if (op == 0xff && modrm.fields.reg == 6) /* push mem */
 					{
 						instruction->num_operands = 3;
-						_NMD_SET_MEM_OPERAND(instruction->operands[0], false, NMD_X86_OPERAND_ACTION_READ, NMD_X86_REG_DS, (instruction->prefixes& NMD_X86_PREFIXES_REX_B ? (opszprfx ? NMD_X86_REG_R8W : NMD_X86_REG_R8) : (opszprfx ? (instruction->mode == NMD_X86_MODE_16 ? NMD_X86_REG_EAX : NMD_X86_REG_AX) : (NMD_X86_REG_AX + (instruction->mode >> 2) * 8))) + modrm.fields.rm, NMD_X86_REG_NONE, 0, 0);
+						if (modrm.fields.mod == 0b11)
+							_NMD_SET_REG_OPERAND(instruction->operands[0], false, NMD_X86_OPERAND_ACTION_READ, (instruction->prefixes & NMD_X86_PREFIXES_REX_B ? (opszprfx ? NMD_X86_REG_R8W : NMD_X86_REG_R8) : (opszprfx ? (instruction->mode == NMD_X86_MODE_16 ? NMD_X86_REG_EAX : NMD_X86_REG_AX) : (NMD_X86_REG_AX + (instruction->mode >> 2) * 8))) + modrm.fields.rm)
+						else
+						{
+							_nmd_decode_modrm_upper32(instruction, &instruction->operands[0]);
+							instruction->operands[0].action = NMD_X86_OPERAND_ACTION_READ;
+						}
 						_NMD_SET_REG_OPERAND(instruction->operands[1], true, NMD_X86_OPERAND_ACTION_READWRITE, _NMD_GET_GPR(NMD_X86_REG_SP));
 						_NMD_SET_MEM_OPERAND(instruction->operands[2], true, NMD_X86_OPERAND_ACTION_WRITE, NMD_X86_REG_SS, _NMD_GET_GPR(NMD_X86_REG_SP), NMD_X86_REG_NONE, 0, 0);
 
@@ -6740,11 +8860,11 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
                         }
                         else
                         {
-                            _nmd_decode_modrm_upper32(instruction, &instruction->operands[0]);
+                            _nmd_decode_operand_Ev(instruction, &instruction->operands[0]);
                             instruction->operands[0].is_implicit = false;
                             instruction->operands[0].action = NMD_X86_OPERAND_ACTION_WRITE;
                         }
-                        _NMD_SET_IMM_OPERAND(instruction->operands[1], false, NMD_X86_OPERAND_ACTION_READ, instruction->immediate);						
+                        _NMD_SET_IMM_OPERAND(instruction->operands[1], false, NMD_X86_OPERAND_ACTION_READ, _nmd_sign_extend(instruction->immediate, instruction->imm_mask));						
                     }
 					else if (op >= 0x84 && op <= 0x8b)
 					{
@@ -6775,15 +8895,10 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 							_nmd_decode_operand_Ev(instruction, &instruction->operands[0]);
 						instruction->operands[0].action = NMD_X86_OPERAND_ACTION_READWRITE;
 						instruction->operands[1].type = NMD_X86_OPERAND_TYPE_IMMEDIATE;
+						instruction->operands[1].fields.imm = _nmd_sign_extend(instruction->immediate, instruction->imm_mask);
 					}
 					else if (_NMD_R(op) == 7 || op == 0x9a || op == 0xcd || op == 0xd4 || op == 0xd5)
 						instruction->operands[0].type = NMD_X86_OPERAND_TYPE_IMMEDIATE;
-					else if (op == 0x90 && instruction->prefixes & NMD_X86_PREFIXES_REX_B)
-					{
-						instruction->operands[0].type = instruction->operands[1].type = NMD_X86_OPERAND_TYPE_REGISTER;
-						instruction->operands[0].fields.reg = (uint8_t)(instruction->prefixes & NMD_X86_PREFIXES_REX_W ? NMD_X86_REG_R8 : NMD_X86_REG_R8D);
-						instruction->operands[1].fields.reg = (uint8_t)(instruction->prefixes & NMD_X86_PREFIXES_REX_W ? NMD_X86_REG_RAX : NMD_X86_REG_EAX);
-					}
 					else if (_NMD_R(op) == 5)
 					{
 						instruction->operands[0].type = NMD_X86_OPERAND_TYPE_REGISTER;
@@ -6858,12 +8973,14 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 						_nmd_decode_operand_Ev(instruction, &instruction->operands[0]);
 						instruction->operands[0].action = NMD_X86_OPERAND_ACTION_WRITE;
 					}
-					else if (op >= 0x91 && op <= 0x97)
+					else if ((op >= 0x91 && op <= 0x97) || (op == 0x90 && instruction->prefixes & NMD_X86_PREFIXES_REX_B)) /* xchg reg,(e/r)ax */
 					{
-						_nmd_decode_operand_Gv(instruction, &instruction->operands[0]);
-						instruction->operands[0].fields.reg = instruction->operands[0].fields.reg + _NMD_C(op);
-						instruction->operands[1].type = NMD_X86_OPERAND_TYPE_REGISTER;
-						instruction->operands[1].fields.reg = (uint8_t)(instruction->rex_w_prefix ? NMD_X86_REG_RAX : (instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE && mode != NMD_X86_MODE_16 ? NMD_X86_REG_AX : NMD_X86_REG_EAX));
+						const bool operand16 = opszprfx != (mode == NMD_X86_MODE_16);
+						const bool rexB = instruction->prefixes & NMD_X86_PREFIXES_REX_B;
+						instruction->num_operands = 2;
+						instruction->operands[0].type = instruction->operands[1].type = NMD_X86_OPERAND_TYPE_REGISTER;
+						instruction->operands[0].fields.reg = (uint8_t)((instruction->rex_w_prefix ? (rexB ? NMD_X86_REG_R8 : NMD_X86_REG_RAX) : (operand16 ? (rexB ? NMD_X86_REG_R8W : NMD_X86_REG_AX) : (rexB ? NMD_X86_REG_R8D : NMD_X86_REG_EAX))) + op % 8);
+						instruction->operands[1].fields.reg = (uint8_t)(instruction->rex_w_prefix ? NMD_X86_REG_RAX : (operand16 ? NMD_X86_REG_AX : NMD_X86_REG_EAX));
 						instruction->operands[0].action = instruction->operands[1].action = NMD_X86_OPERAND_ACTION_READWRITE;
 					}
 					else if (op >= 0xa0 && op <= 0xa3)
@@ -6871,11 +8988,8 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 						instruction->operands[op < 0xa2 ? 0 : 1].type = NMD_X86_OPERAND_TYPE_REGISTER;
 						instruction->operands[op < 0xa2 ? 0 : 1].fields.reg = (uint8_t)(op % 2 == 0 ? NMD_X86_REG_AL : (instruction->rex_w_prefix ? NMD_X86_REG_RAX : ((instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE && mode != NMD_X86_MODE_16) || (mode == NMD_X86_MODE_16 && !(instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)) ? NMD_X86_REG_AX : NMD_X86_REG_EAX)));
 						instruction->operands[op < 0xa2 ? 1 : 0].type = NMD_X86_OPERAND_TYPE_MEMORY;
-						
-						/* FIXME: We should not access the buffer from here
-						instruction->operands[op < 0xa2 ? 1 : 0].fields.mem.disp = (mode == NMD_X86_MODE_64) ? *(uint64_t*)(b + 1) : *(uint32_t*)(b + 1);
-						*/
-						
+						instruction->operands[op < 0xa2 ? 1 : 0].fields.mem.disp = _nmd_sign_extend(instruction->immediate, instruction->imm_mask); /* The moffs is decoded as the immediate */
+						instruction->operands[op < 0xa2 ? 1 : 0].fields.mem.size = (uint8_t)(op % 2 == 0 ? 1 : (instruction->operands[op < 0xa2 ? 0 : 1].fields.reg == NMD_X86_REG_AX ? 2 : (instruction->operands[op < 0xa2 ? 0 : 1].fields.reg == NMD_X86_REG_EAX ? 4 : 8)));
 						_nmd_decode_operand_segment_reg(instruction, &instruction->operands[op < 0xa2 ? 1 : 0]);
 						instruction->operands[0].action = NMD_X86_OPERAND_ACTION_WRITE;
 						instruction->operands[1].action = NMD_X86_OPERAND_ACTION_READ;
@@ -6896,6 +9010,7 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 								_nmd_decode_operand_Ev(instruction, &instruction->operands[0]);
 						}
 						instruction->operands[op >= 0xc6 && instruction->modrm.fields.reg ? 0 : 1].type = NMD_X86_OPERAND_TYPE_IMMEDIATE;
+						instruction->operands[op >= 0xc6 && instruction->modrm.fields.reg ? 0 : 1].fields.imm = op == 0xc6 ? _nmd_sign_extend(instruction->immediate, 1) : (int64_t)instruction->immediate;
 						instruction->operands[0].action = (uint8_t)(op <= 0xc1 ? NMD_X86_OPERAND_ACTION_READWRITE : NMD_X86_OPERAND_ACTION_WRITE);
 					}					
 					else if (op == 0xc4 || op == 0xc5)
@@ -6932,6 +9047,7 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 							instruction->operands[1].fields.reg = NMD_X86_REG_CL;
 						}
 						instruction->operands[0].action = NMD_X86_OPERAND_ACTION_READWRITE;
+						instruction->operands[1].action = NMD_X86_OPERAND_ACTION_READ;
 					}
 					else if (op >= 0xd8 && op <= 0xdf)
 					{
@@ -6981,15 +9097,23 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 							instruction->operands[op % 8 <= 5 ? 1 : 0].action = NMD_X86_OPERAND_ACTION_READ;
 						}
 					}
-					else if (op == 0xf6 || op == 0xfe)
+					else if (op == 0xf6 || op == 0xfe || op == 0xf7 || op == 0xff)
 					{
-						_nmd_decode_operand_Eb(instruction, &instruction->operands[0]);
-						instruction->operands[0].action = (uint8_t)(op == 0xfe && instruction->modrm.fields.reg >= 0b010 ? NMD_X86_OPERAND_ACTION_READ : NMD_X86_OPERAND_ACTION_READWRITE);
-					}
-					else if (op == 0xf7 || op == 0xff)
-					{
-						_nmd_decode_operand_Ev(instruction, &instruction->operands[0]);
-						instruction->operands[0].action = (uint8_t)(op == 0xff && instruction->modrm.fields.reg >= 0b010 ? NMD_X86_OPERAND_ACTION_READ : NMD_X86_OPERAND_ACTION_READWRITE);
+						if (op % 2 == 0)
+							_nmd_decode_operand_Eb(instruction, &instruction->operands[0]);
+						else
+							_nmd_decode_operand_Ev(instruction, &instruction->operands[0]);
+						instruction->operands[0].action = (uint8_t)((op >= 0xfe && instruction->modrm.fields.reg >= 0b010) || (op <= 0xf7 && instruction->modrm.fields.reg >= 0b100) ? NMD_X86_OPERAND_ACTION_READ : NMD_X86_OPERAND_ACTION_READWRITE);
+						if (!instruction->num_operands)
+							instruction->num_operands = 1;
+
+						/* test Eb,Ib / test Ev,Iz */
+						if (op <= 0xf7 && instruction->modrm.fields.reg <= 0b001)
+						{
+							instruction->num_operands = 2;
+							instruction->operands[0].action = NMD_X86_OPERAND_ACTION_READ;
+							_NMD_SET_IMM_OPERAND(instruction->operands[1], false, NMD_X86_OPERAND_ACTION_READ, _nmd_sign_extend(instruction->immediate, instruction->imm_mask));
+						}
 					}
 				}
 #endif /* NMD_ASSEMBLY_DISABLE_DECODER_OPERANDS */
@@ -7005,60 +9129,387 @@ NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_siz
 	}
 
 	instruction->length = (uint8_t)((ptrdiff_t)(b) - (ptrdiff_t)(buffer));
-	for (i = 0; i < instruction->length; i++)
-		instruction->buffer[i] = ((const uint8_t* const)(buffer))[i];
+	if (flags & NMD_X86_DECODER_FLAGS_ZERO_COPY)
+		instruction->source = (const uint8_t*)buffer;
+	else
+	{
+		for (i = 0; i < instruction->length; i++)
+			instruction->buffer[i] = ((const uint8_t* const)(buffer))[i];
+	}
+
+#ifndef NMD_ASSEMBLY_DISABLE_DECODER_REGISTERS
+	if (flags & NMD_X86_DECODER_FLAGS_REGISTERS)
+		nmd_x86_get_register_use(instruction, &instruction->registers);
+#endif /* NMD_ASSEMBLY_DISABLE_DECODER_REGISTERS */
 
 	instruction->valid = true;
 
 	return true;
 }
 
-NMD_ASSEMBLY_API bool _nmd_ldisasm_decode_modrm(const uint8_t** p_buffer, size_t* p_buffer_size, bool address_prefix, NMD_X86_MODE mode, nmd_x86_modrm* p_modrm)
+/* The generic decoder used by every function of the library. */
+NMD_ASSEMBLY_API bool _nmd_decode_instruction(const void* const buffer, size_t buffer_size, nmd_x86_instruction* instruction, NMD_X86_MODE mode, uint32_t flags)
 {
-	_NMD_READ_BYTE(*p_buffer, *p_buffer_size, (*p_modrm).modrm);
-    
-	bool has_sib = false;
-	size_t disp_size = 0;
+	return _nmd_decode_instruction_inline(buffer, buffer_size, instruction, mode, flags);
+}
 
-	if (mode == NMD_X86_MODE_16)
+/*
+Decodes an instruction. Returns true if the instruction is valid, false otherwise.
+Parameters:
+ - buffer      [in]  A pointer to a buffer containing an encoded instruction.
+ - buffer_size [in]  The size of the buffer in bytes.
+ - instruction [out] A pointer to a variable of type 'nmd_x86_instruction' that receives information about the instruction.
+ - mode        [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags       [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use. If uncertain, use 'NMD_X86_DECODER_FLAGS_MINIMAL'.
+*/
+NMD_ASSEMBLY_API bool nmd_x86_decode(const void* const buffer, size_t buffer_size, nmd_x86_instruction* instruction, NMD_X86_MODE mode, uint32_t flags)
+{
+	/* Clear 'instruction' */
+	size_t i = 0;
+	for (; i < sizeof(nmd_x86_instruction); i++)
+		((uint8_t*)(instruction))[i] = 0x00;
+
+	/*  Clamp 'buffer_size' to 15. We will only read up to 15 bytes(NMD_X86_MAXIMUM_INSTRUCTION_LENGTH) */
+	if (buffer_size > 15)
+		buffer_size = 15;
+
+	return _nmd_decode_instruction(buffer, buffer_size, instruction, mode, flags);
+}
+
+/*
+Decodes consecutive instructions until the end of the buffer, an invalid instruction or the end of the output array is reached. Returns the number of instructions decoded.
+Parameters:
+ - buffer           [in]      A pointer to a buffer containing encoded instructions.
+ - buffer_size      [in]      The buffer's size in bytes.
+ - runtime_address  [in]      The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - mode             [in]      The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags            [in]      A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use. If uncertain, use 'NMD_X86_DECODER_FLAGS_MINIMAL'.
+ - instructions     [out]     A pointer to an array of 'nmd_x86_instruction' that receives the decoded instructions.
+ - num_instructions [in]      The number of elements in 'instructions'.
+ - info             [out/opt] A pointer to a variable of type 'nmd_x86_buffer_info' that receives where and why the function stopped. This parameter may be null.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_decode_buffer(const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags, nmd_x86_instruction* instructions, size_t num_instructions, nmd_x86_buffer_info* info)
+{
+	const uint8_t* b = (const uint8_t*)buffer;
+	const uint8_t* const end = b + buffer_size;
+	uint8_t status = NMD_X86_BUFFER_STATUS_END;
+	size_t count = 0;
+
+	while (b < end)
+	{
+		if (count == num_instructions)
+		{
+			status = NMD_X86_BUFFER_STATUS_OUTPUT_FULL;
+			break;
+		}
+
+		_nmd_clear_instruction(&instructions[count], flags);
+		if (!_nmd_decode_instruction(b, _NMD_MIN((size_t)(end - b), NMD_X86_MAXIMUM_INSTRUCTION_LENGTH), &instructions[count], mode, flags))
+		{
+			status = NMD_X86_BUFFER_STATUS_INVALID;
+			break;
+		}
+
+		b += instructions[count++].length;
+	}
+
+	if (info)
+	{
+		info->offset = (size_t)(b - (const uint8_t*)buffer);
+		info->runtime_address = runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? NMD_X86_INVALID_RUNTIME_ADDRESS : runtime_address + info->offset;
+		info->status = status;
+	}
+
+	return count;
+}
+
+/* Fills the memory operand summary of 'light'. 'instruction' must have the variables used by _nmd_decode_modrm_upper32() set. */
+NMD_ASSEMBLY_API void _nmd_set_light_memory_operand(const nmd_x86_instruction* instruction, nmd_x86_light_instruction* light)
+{
+	nmd_x86_operand operand;
+	if (!instruction->has_modrm || instruction->modrm.fields.mod == 0b11)
+	{
+		light->displacement = 0;
+		light->segment = light->base = light->index = light->scale = 0;
+		return;
+	}
+
+	operand.fields.mem.base = operand.fields.mem.index = operand.fields.mem.scale = 0;
+	_nmd_decode_modrm_upper32(instruction, &operand);
+
+	light->flags |= NMD_X86_LIGHT_FLAGS_MEMORY_OPERAND;
+	light->segment = operand.fields.mem.segment;
+	light->base = operand.fields.mem.base;
+	light->index = operand.fields.mem.index;
+	light->scale = operand.fields.mem.scale;
+	if (instruction->mode == NMD_X86_MODE_64 && !instruction->has_sib && instruction->modrm.fields.mod == 0b00 && instruction->modrm.fields.rm == 0b101)
+		light->base = (uint8_t)(instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE ? NMD_X86_REG_EIP : NMD_X86_REG_RIP);
+
+	light->displacement = (int32_t)operand.fields.mem.disp;
+}
+
+/* Sets the branch target of 'light' if 'group' describes a relative branch. 'light->length' must be set. */
+NMD_ASSEMBLY_API void _nmd_set_light_branch_target(nmd_x86_light_instruction* light, uint8_t group, uint64_t immediate, size_t imm_size, uint64_t runtime_address, NMD_X86_MODE mode)
+{
+	int64_t relative;
+	if (!(group & NMD_GROUP_RELATIVE_ADDRESSING) || !(group & NMD_GROUP_BRANCH) || imm_size == 0 || imm_size > 4)
+	{
+		light->branch_target = 0;
+		return;
+	}
+
+	relative = imm_size == 1 ? (int8_t)immediate : (imm_size == 2 ? (int16_t)immediate : (int32_t)immediate);
+	light->flags |= NMD_X86_LIGHT_FLAGS_BRANCH_TARGET;
+	if (runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS)
+		light->branch_target = (uint64_t)(relative + light->length);
+	else
+	{
+		light->branch_target = runtime_address + light->length + (uint64_t)relative;
+		if (mode == NMD_X86_MODE_16)
+			light->branch_target = (uint16_t)light->branch_target;
+		else if (mode == NMD_X86_MODE_32)
+			light->branch_target = (uint32_t)light->branch_target;
+	}
+}
+
+/* Decodes an instruction using nmd_x86_decode() and converts it to a 'nmd_x86_light_instruction'. */
+NMD_ASSEMBLY_API bool _nmd_decode_light_fallback(const void* buffer, size_t buffer_size, uint64_t runtime_address, nmd_x86_light_instruction* light, NMD_X86_MODE mode, uint32_t flags)
+{
+	nmd_x86_instruction instruction;
+	if (!nmd_x86_decode(buffer, buffer_size, &instruction, mode, (flags | NMD_X86_DECODER_FLAGS_GROUP) & ~(NMD_X86_DECODER_FLAGS_OPERANDS | NMD_X86_DECODER_FLAGS_CPU_FLAGS | NMD_X86_DECODER_FLAGS_REGISTERS)))
+		return false;
+
+	light->length = instruction.length;
+	light->id = instruction.id;
+	light->opcode = instruction.opcode;
+	light->opcode_map = instruction.opcode_map;
+	light->group = (uint8_t)(flags & NMD_X86_DECODER_FLAGS_GROUP ? instruction.group : 0);
+	light->flags = (uint8_t)((instruction.prefixes & NMD_X86_PREFIXES_LOCK ? NMD_X86_LIGHT_FLAGS_LOCK : 0) | (instruction.prefixes & (NMD_X86_PREFIXES_REPEAT | NMD_X86_PREFIXES_REPEAT_NOT_ZERO) ? NMD_X86_LIGHT_FLAGS_REPEAT : 0));
+	_nmd_set_light_memory_operand(&instruction, light);
+	_nmd_set_light_branch_target(light, instruction.group, instruction.immediate, instruction.imm_mask, runtime_address, mode);
+
+	return true;
+}
+
+/*
+Decodes an instruction into a compact record. Returns true if the instruction is valid, false otherwise.
+The instruction is decoded using the opcode tables in 'nmd_x86_opcode_tables.c'. If the tables can't describe the instruction(or it has a lock prefix) nmd_x86_decode() is used instead.
+Parameters:
+ - buffer          [in]  A pointer to a buffer containing an encoded instruction.
+ - buffer_size     [in]  The buffer's size in bytes.
+ - runtime_address [in]  The instruction's runtime address used to compute 'branch_target'. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - instruction     [out] A pointer to a variable of type 'nmd_x86_light_instruction' that receives information about the instruction.
+ - mode            [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags           [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use. 'NMD_X86_DECODER_FLAGS_OPERANDS', 'NMD_X86_DECODER_FLAGS_CPU_FLAGS' and 'NMD_X86_DECODER_FLAGS_REGISTERS' are ignored.
+*/
+NMD_ASSEMBLY_API bool nmd_x86_decode_light(const void* buffer, size_t buffer_size, uint64_t runtime_address, nmd_x86_light_instruction* instruction, NMD_X86_MODE mode, uint32_t flags)
+{
+	/* Only the variables used by _nmd_decode_modrm() and _nmd_decode_modrm_upper32() are set. */
+	nmd_x86_instruction modrm_instruction;
+	const _nmd_x86_opcode_info* info;
+	const uint8_t* b = (const uint8_t*)buffer;
+	const size_t original_buffer_size = buffer_size;
+	uint16_t prefixes = 0;
+	uint8_t segment_override = 0;
+	uint8_t op, opcode_map = NMD_X86_OPCODE_MAP_DEFAULT;
+	uint64_t immediate = 0;
+	size_t imm_size, i;
+
+#ifdef NMD_ASSEMBLY_DISABLE_DECODER_VALIDITY_CHECK
+	flags &= ~NMD_X86_DECODER_FLAGS_VALIDITY_CHECK;
+#endif /* NMD_ASSEMBLY_DISABLE_DECODER_VALIDITY_CHECK */
+#ifdef NMD_ASSEMBLY_DISABLE_DECODER_INSTRUCTION_ID
+	flags &= ~NMD_X86_DECODER_FLAGS_INSTRUCTION_ID;
+#endif /* NMD_ASSEMBLY_DISABLE_DECODER_INSTRUCTION_ID */
+#ifdef NMD_ASSEMBLY_DISABLE_DECODER_GROUP
+	flags &= ~NMD_X86_DECODER_FLAGS_GROUP;
+#endif /* NMD_ASSEMBLY_DISABLE_DECODER_GROUP */
+
+	/*  Clamp 'buffer_size' to 15. We will only read up to 15 bytes(NMD_X86_MAXIMUM_INSTRUCTION_LENGTH) */
+	if (buffer_size > 15)
+		buffer_size = 15;
+
+	/* Decode legacy and REX prefixes the same way nmd_x86_decode() does */
+	for (; buffer_size > 0; b++, buffer_size--)
 	{
-		if (p_modrm->fields.mod != 0b11)
+		switch (*b)
 		{
-			if (p_modrm->fields.mod == 0b00)
+		case 0xF0: prefixes |= NMD_X86_PREFIXES_LOCK; continue;
+		case 0xF2: prefixes |= NMD_X86_PREFIXES_REPEAT_NOT_ZERO; continue;
+		case 0xF3: prefixes |= NMD_X86_PREFIXES_REPEAT; continue;
+		case 0x2E: prefixes |= (segment_override = NMD_X86_PREFIXES_CS_SEGMENT_OVERRIDE); continue;
+		case 0x36: prefixes |= (segment_override = NMD_X86_PREFIXES_SS_SEGMENT_OVERRIDE); continue;
+		case 0x3E: prefixes |= (segment_override = NMD_X86_PREFIXES_DS_SEGMENT_OVERRIDE); continue;
+		case 0x26: prefixes |= (segment_override = NMD_X86_PREFIXES_ES_SEGMENT_OVERRIDE); continue;
+		case 0x64: prefixes |= (segment_override = NMD_X86_PREFIXES_FS_SEGMENT_OVERRIDE); continue;
+		case 0x65: prefixes |= (segment_override = NMD_X86_PREFIXES_GS_SEGMENT_OVERRIDE); continue;
+		case 0x66: prefixes |= NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE; continue;
+		case 0x67: prefixes |= NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE; continue;
+		default:
+			if (mode == NMD_X86_MODE_64 && _NMD_R(*b) == 4) /* REX prefixes [0x40,0x4f] */
 			{
-				if (p_modrm->fields.rm == 0b110)
-					disp_size = 2;
+				prefixes = (uint16_t)((prefixes & ~(NMD_X86_PREFIXES_REX_B | NMD_X86_PREFIXES_REX_X | NMD_X86_PREFIXES_REX_R | NMD_X86_PREFIXES_REX_W)) |
+					(*b & 0b0001 ? NMD_X86_PREFIXES_REX_B : 0) | (*b & 0b0010 ? NMD_X86_PREFIXES_REX_X : 0) | (*b & 0b0100 ? NMD_X86_PREFIXES_REX_R : 0) | (*b & 0b1000 ? NMD_X86_PREFIXES_REX_W : 0));
+				continue;
 			}
-			else
-				disp_size = p_modrm->fields.mod == 0b01 ? 1 : 2;
 		}
+
+		break;
+	}
+
+	/* A REX prefix is ignored if it's not the last prefix */
+	if (b != (const uint8_t*)buffer && (mode != NMD_X86_MODE_64 || _NMD_R(b[-1]) != 4))
+		prefixes = (uint16_t)(prefixes & ~(NMD_X86_PREFIXES_REX_B | NMD_X86_PREFIXES_REX_X | NMD_X86_PREFIXES_REX_R | NMD_X86_PREFIXES_REX_W));
+
+	/* The lock prefix's validity depends on the opcode and the ModR/M byte, let the full decoder handle it */
+	if (prefixes & NMD_X86_PREFIXES_LOCK)
+		return _nmd_decode_light_fallback(buffer, original_buffer_size, runtime_address, instruction, mode, flags);
+
+	/* Look up the opcode's properties */
+	_NMD_READ_BYTE(b, buffer_size, op);
+	if (op == 0x0F)
+	{
+		_NMD_READ_BYTE(b, buffer_size, op);
+		opcode_map = NMD_X86_OPCODE_MAP_0F;
+		info = &_nmd_x86_op2_info[mode >> 2][op];
 	}
 	else
+		info = &_nmd_x86_op1_info[mode >> 2][op];
+
+	if ((info->flags & _NMD_X86_OPCODE_FALLBACK) == _NMD_X86_OPCODE_FALLBACK)
+		return _nmd_decode_light_fallback(buffer, original_buffer_size, runtime_address, instruction, mode, flags);
+
+	/* Decode ModR/M, SIB and displacement */
+	modrm_instruction.has_modrm = false;
+	if (info->flags & _NMD_X86_OPCODE_MODRM)
 	{
-		if (address_prefix && mode == NMD_X86_MODE_32)
+		modrm_instruction.mode = (uint8_t)mode;
+		modrm_instruction.prefixes = prefixes;
+		modrm_instruction.segment_override = segment_override;
+		modrm_instruction.has_sib = false;
+		modrm_instruction.disp_mask = NMD_X86_DISP_NONE;
+		modrm_instruction.displacement = 0;
+		if (!_nmd_decode_modrm(&b, &buffer_size, &modrm_instruction))
+			return false;
+
+		if (info->flags & _NMD_X86_OPCODE_EXTENSION)
 		{
-			if ((p_modrm->fields.mod == 0b00 && p_modrm->fields.rm == 0b110) || p_modrm->fields.mod == 0b10)
-				disp_size = 2;
-			else if (p_modrm->fields.mod == 0b01)
-				disp_size = 1;
+			info = &_nmd_x86_opcode_extensions[info->id][modrm_instruction.modrm.fields.reg];
+			if ((info->flags & _NMD_X86_OPCODE_FALLBACK) == _NMD_X86_OPCODE_FALLBACK)
+				return _nmd_decode_light_fallback(buffer, original_buffer_size, runtime_address, instruction, mode, flags);
 		}
-		else
+
+		if (info->flags & (modrm_instruction.modrm.fields.mod == 0b11 ? _NMD_X86_OPCODE_INVALID_REG : _NMD_X86_OPCODE_INVALID_MEM))
 		{
-			/* Check for SIB byte */
-			uint8_t sib = 0;
-			if (p_modrm->modrm < 0xC0 && p_modrm->fields.rm == 0b100 && (!address_prefix || (address_prefix && mode == NMD_X86_MODE_64)))
-			{
-				has_sib = true;
-                _NMD_READ_BYTE(*p_buffer, *p_buffer_size, sib);
-			}
+			if (flags & NMD_X86_DECODER_FLAGS_VALIDITY_CHECK)
+				return false;
+
+			/* The tables only describe valid forms */
+			return _nmd_decode_light_fallback(buffer, original_buffer_size, runtime_address, instruction, mode, flags);
+		}
+	}
+
+	/* Determine the immediate's size */
+	imm_size = _nmd_x86_get_imm_size((uint8_t)(info->flags & _NMD_X86_OPCODE_IMM_MASK), mode, (prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE) != 0, (prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE) != 0, (prefixes & NMD_X86_PREFIXES_REX_W) != 0);
+
+	/* Make sure we can read 'imm_size' bytes from the buffer */
+	if (buffer_size < imm_size)
+		return false;
+
+	for (i = 0; i < imm_size; i++)
+		((uint8_t*)(&immediate))[i] = b[i];
+	b += imm_size;
+
+	instruction->length = (uint8_t)((ptrdiff_t)(b) - (ptrdiff_t)(buffer));
+	instruction->id = (uint16_t)(flags & NMD_X86_DECODER_FLAGS_INSTRUCTION_ID ? info->id : 0);
+	instruction->opcode = op;
+	instruction->opcode_map = opcode_map;
+	instruction->group = (uint8_t)(flags & NMD_X86_DECODER_FLAGS_GROUP ? info->group : 0);
+	instruction->flags = (uint8_t)(prefixes & (NMD_X86_PREFIXES_REPEAT | NMD_X86_PREFIXES_REPEAT_NOT_ZERO) ? NMD_X86_LIGHT_FLAGS_REPEAT : 0);
+	_nmd_set_light_memory_operand(&modrm_instruction, instruction);
+	_nmd_set_light_branch_target(instruction, info->group, immediate, imm_size, runtime_address, mode);
 
-			if (p_modrm->fields.mod == 0b01) /* disp8 (ModR/M) */
-				disp_size = 1;
-			else if ((p_modrm->fields.mod == 0b00 && p_modrm->fields.rm == 0b101) || p_modrm->fields.mod == 0b10) /* disp16,32 (ModR/M) */
-				disp_size = (address_prefix && !(mode == NMD_X86_MODE_64 && address_prefix) ? 2 : 4);
-			else if (has_sib && (sib & 0b111) == 0b101) /* disp8,32 (SIB) */
-				disp_size = (p_modrm->fields.mod == 0b01 ? 1 : 4);
+	return true;
+}
+
+/*
+Same as nmd_x86_decode_buffer(), but the instructions are decoded by nmd_x86_decode_light(). Returns the number of instructions decoded.
+Parameters:
+ - buffer           [in]      A pointer to a buffer containing encoded instructions.
+ - buffer_size      [in]      The buffer's size in bytes.
+ - runtime_address  [in]      The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - mode             [in]      The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags            [in]      A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+ - instructions     [out]     A pointer to an array of 'nmd_x86_light_instruction' that receives the decoded instructions.
+ - num_instructions [in]      The number of elements in 'instructions'.
+ - info             [out/opt] A pointer to a variable of type 'nmd_x86_buffer_info' that receives where and why the function stopped. This parameter may be null.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_decode_buffer_light(const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags, nmd_x86_light_instruction* instructions, size_t num_instructions, nmd_x86_buffer_info* info)
+{
+	const uint8_t* b = (const uint8_t*)buffer;
+	const uint8_t* const end = b + buffer_size;
+	uint8_t status = NMD_X86_BUFFER_STATUS_END;
+	size_t count = 0;
+
+	while (b < end)
+	{
+		if (count == num_instructions)
+		{
+			status = NMD_X86_BUFFER_STATUS_OUTPUT_FULL;
+			break;
+		}
+
+		if (!nmd_x86_decode_light(b, (size_t)(end - b), runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? NMD_X86_INVALID_RUNTIME_ADDRESS : runtime_address + (size_t)(b - (const uint8_t*)buffer), &instructions[count], mode, flags))
+		{
+			status = NMD_X86_BUFFER_STATUS_INVALID;
+			break;
+		}
+
+		b += instructions[count++].length;
+	}
+
+	if (info)
+	{
+		info->offset = (size_t)(b - (const uint8_t*)buffer);
+		info->runtime_address = runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? NMD_X86_INVALID_RUNTIME_ADDRESS : runtime_address + info->offset;
+		info->status = status;
+	}
+
+	return count;
+}
+
+
+NMD_ASSEMBLY_API bool _nmd_ldisasm_decode_modrm(const uint8_t** p_buffer, size_t* p_buffer_size, bool address_prefix, NMD_X86_MODE mode, nmd_x86_modrm* p_modrm)
+{
+	_NMD_READ_BYTE(*p_buffer, *p_buffer_size, (*p_modrm).modrm);
+    
+	bool has_sib = false;
+	size_t disp_size = 0;
+
+	/* The address size prefix toggles between 16 and 32-bit addressing outside 64-bit mode */
+	if (mode != NMD_X86_MODE_64 && (mode == NMD_X86_MODE_16) != address_prefix)
+	{
+		if ((p_modrm->fields.mod == 0b00 && p_modrm->fields.rm == 0b110) || p_modrm->fields.mod == 0b10)
+			disp_size = 2;
+		else if (p_modrm->fields.mod == 0b01)
+			disp_size = 1;
+	}
+	else
+	{
+		/* Check for SIB byte */
+		uint8_t sib = 0;
+		if (p_modrm->modrm < 0xC0 && p_modrm->fields.rm == 0b100)
+		{
+			has_sib = true;
+			_NMD_READ_BYTE(*p_buffer, *p_buffer_size, sib);
 		}
+
+		if (p_modrm->fields.mod == 0b01) /* disp8 (ModR/M) */
+			disp_size = 1;
+		else if ((p_modrm->fields.mod == 0b00 && p_modrm->fields.rm == 0b101) || p_modrm->fields.mod == 0b10) /* disp32 (ModR/M) */
+			disp_size = 4;
+		else if (has_sib && (sib & 0b111) == 0b101) /* disp8,32 (SIB) */
+			disp_size = (p_modrm->fields.mod == 0b01 ? 1 : 4);
 	}
     
     /* Make sure we can read 'instruction->disp_mask' bytes from the buffer */
@@ -7073,18 +9524,18 @@ NMD_ASSEMBLY_API bool _nmd_ldisasm_decode_modrm(const uint8_t** p_buffer, size_t
 }
 
 /*
+The branch-based length disassembler. nmd_x86_ldisasm() calls this function for the opcodes the tables can't describe.
 Returns the length of the instruction if it is valid, zero otherwise.
 Parameters:
  - buffer      [in] A pointer to a buffer containing an encoded instruction.
  - buffer_size [in] The size of the buffer in bytes.
  - mode        [in] The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
 */
-NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_size, const NMD_X86_MODE mode)
+NMD_ASSEMBLY_API size_t _nmd_ldisasm(const void* const buffer, size_t buffer_size, const NMD_X86_MODE mode)
 {
 	bool operand_prefix = false;
 	bool address_prefix = false;
 	bool repeat_prefix = false;
-	bool repeat_not_zero_prefix = false;
 	bool rexW = false;
 	bool lock_prefix = false;
 	uint16_t simd_prefix = NMD_X86_PREFIXES_NONE;
@@ -7116,7 +9567,7 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
 		switch (*b)
 		{
 		case 0xF0: lock_prefix = true; continue;
-		case 0xF2: repeat_not_zero_prefix = true, simd_prefix = NMD_X86_PREFIXES_REPEAT_NOT_ZERO; continue;
+		case 0xF2: simd_prefix = NMD_X86_PREFIXES_REPEAT_NOT_ZERO; continue;
 		case 0xF3: repeat_prefix = true, simd_prefix = NMD_X86_PREFIXES_REPEAT; continue;
 		case 0x2E: continue;
 		case 0x36: continue;
@@ -7129,8 +9580,7 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
 		default:
 			if (mode == NMD_X86_MODE_64 && _NMD_R(*b) == 4) /* REX prefixes [0x40,0x4f] */
 			{
-				if(_NMD_C(*b) & 0b1000)
-					rexW = true;
+				rexW = (_NMD_C(*b) & 0b1000) != 0;
 				continue;
 			}
 		}
@@ -7140,6 +9590,10 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
 
 	/* Calculate the number of prefixes based on how much the iterator moved */
 	const size_t num_prefixes = (uint8_t)((ptrdiff_t)(b)-(ptrdiff_t)(buffer));
+
+	/* A REX prefix is ignored if it's not the last prefix */
+	if (num_prefixes && _NMD_R(b[-1]) != 4)
+		rexW = false;
     
     /* Opcode byte. This variable is used because 'op' is simpler than 'instruction->opcode' */
 	uint8_t op;
@@ -7305,12 +9759,12 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
 				return 0;
 			else if (_NMD_R(op) == 5)
 			{
-				if ((op == 0x50 && modrm.fields.mod != 0b11) || (simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE && (op == 0x52 || op == 0x53)) || (simd_prefix == NMD_X86_PREFIXES_REPEAT && (op == 0x50 || (op >= 0x54 && op <= 0x57))) || (repeat_not_zero_prefix && (op == 0x50 || (op >= 0x52 && op <= 0x57) || op == 0x5b)))
+				if ((op == 0x50 && modrm.fields.mod != 0b11) || (simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE && (op == 0x52 || op == 0x53)) || (simd_prefix == NMD_X86_PREFIXES_REPEAT && (op == 0x50 || (op >= 0x54 && op <= 0x57))) || (simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO && (op == 0x50 || (op >= 0x52 && op <= 0x57) || op == 0x5b)))
 					return 0;
 			}
 			else if (_NMD_R(op) == 6)
 			{
-				if ((!(simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE || simd_prefix == NMD_X86_PREFIXES_REPEAT || simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO) && (op == 0x6c || op == 0x6d)) || (simd_prefix == NMD_X86_PREFIXES_REPEAT && op != 0x6f) || repeat_not_zero_prefix)
+				if ((!(simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE || simd_prefix == NMD_X86_PREFIXES_REPEAT || simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO) && (op == 0x6c || op == 0x6d)) || (simd_prefix == NMD_X86_PREFIXES_REPEAT && op != 0x6f) || simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO)
 					return 0;
 			}
 			else if (op == 0x78 || op == 0x79)
@@ -7325,7 +9779,7 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
 			}
 			else if (op == 0x7e || op == 0x7f)
 			{
-				if (repeat_not_zero_prefix)
+				if (simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO)
 					return 0;
 			}
 			else if (op >= 0x71 && op <= 0x73)
@@ -7407,7 +9861,7 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
 				imm_mask = _NMD_GET_BY_MODE_OPSZPRFX_F64(mode, operand_prefix, 2, 4, 4);
 			else if ((_NMD_R(op) == 7 && _NMD_C(op) < 4) || op == 0xA4 || op == 0xC2 || (op > 0xC3 && op <= 0xC6) || op == 0xBA || op == 0xAC) /* imm8 */
 				imm_mask = 1;
-			else if (op == 0x78 && (repeat_not_zero_prefix || operand_prefix)) /* imm8 + imm8 = "imm16" */
+			else if (op == 0x78 && (simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO || simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)) /* imm8 + imm8 = "imm16" */
 				imm_mask = 2;
             
             /* Make sure we can "read" 'imm_mask' bytes from the buffer */
@@ -7423,8 +9877,8 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
 	{
 		opcode_size = 1;
 
-		/* Check for ModR/M, SIB and displacement */
-		if (_NMD_R(op) == 8 || _nmd_find_byte(_nmd_op1_modrm, sizeof(_nmd_op1_modrm), op) || (_NMD_R(op) < 4 && (_NMD_C(op) < 4 || (_NMD_C(op) >= 8 && _NMD_C(op) < 0xC))) || (_NMD_R(op) == 0xD && _NMD_C(op) >= 8)/* || ((op == 0xc4 || op == 0xc5) && remaining_size > 1 && ((nmd_x86_modrm*)(b + 1))->fields.mod != 0b11)*/)
+		/* Check for ModR/M, SIB and displacement. Outside 64-bit mode 0x62 is BOUND unless ModR/M.mod is 0b11(EVEX) */
+		if (_NMD_R(op) == 8 || _nmd_find_byte(_nmd_op1_modrm, sizeof(_nmd_op1_modrm), op) || (_NMD_R(op) < 4 && (_NMD_C(op) < 4 || (_NMD_C(op) >= 8 && _NMD_C(op) < 0xC))) || (_NMD_R(op) == 0xD && _NMD_C(op) >= 8) || (op == 0x62 && mode != NMD_X86_MODE_64 && buffer_size && (*b >> 6) != 0b11)/* || ((op == 0xc4 || op == 0xc5) && remaining_size > 1 && ((nmd_x86_modrm*)(b + 1))->fields.mod != 0b11)*/)
 		{
 			if (!_nmd_ldisasm_decode_modrm(&b, &buffer_size, address_prefix, mode, &modrm))
 				return 0;
@@ -7464,7 +9918,8 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
 		}
 		else if (op == 0x62)
 		{
-			if (mode == NMD_X86_MODE_64)
+			/* EVEX is not supported */
+			if (!has_modrm)
 				return 0;
 		}
 		else if (op == 0x8d)
@@ -7535,6 +9990,12 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
                     uint8_t imm;
                     _NMD_READ_BYTE(b, buffer_size, imm);
                 }
+
+#ifndef NMD_ASSEMBLY_DISABLE_LENGTH_DISASSEMBLER_VALIDITY_CHECK
+				/* Same check as the decoder's */
+				if (op == 0x0c && (byte1 & 0b00011111) != 3)
+					return 0;
+#endif /* NMD_ASSEMBLY_DISABLE_LENGTH_DISASSEMBLER_VALIDITY_CHECK */
 			}
 			else /* 0xc5 */
 			{
@@ -7596,9 +10057,185 @@ NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_
 			return 0;
 	}
 
-	return (size_t)((ptrdiff_t)(b) - (ptrdiff_t)(buffer));
+	return (size_t)((ptrdiff_t)(b) - (ptrdiff_t)(buffer));
+}
+
+/* Scans the prefixes of an instruction one byte at a time. Returns the number of prefixes and stores the union of their classes('_NMD_X86_PREFIX_CLASS') in 'classes'. */
+NMD_ASSEMBLY_API size_t _nmd_ldisasm_scan_prefixes(const uint8_t* buffer, size_t buffer_size, NMD_X86_MODE mode, uint8_t* classes)
+{
+	const uint8_t prefix_mask = (uint8_t)(_NMD_X86_PREFIX_CLASS_LEGACY | (mode == NMD_X86_MODE_64 ? _NMD_X86_PREFIX_CLASS_REX : 0));
+	size_t i;
+
+	*classes = 0;
+	for (i = 0; i < buffer_size && (_nmd_x86_prefix_classes[buffer[i]] & prefix_mask); i++)
+		*classes |= _nmd_x86_prefix_classes[buffer[i]];
+
+	/* A REX prefix is ignored if it's not the last prefix */
+	if (i && !(_nmd_x86_prefix_classes[buffer[i - 1]] & _NMD_X86_PREFIX_CLASS_REX_W))
+		*classes &= ~_NMD_X86_PREFIX_CLASS_REX_W;
+
+	return i;
+}
+
+#ifdef NMD_ASSEMBLY_ENABLE_LENGTH_DISASSEMBLER_SSE2
+/* Same as _nmd_ldisasm_scan_prefixes(), but classifies 16 bytes at once using SSE2. 'buffer' must have at least 16 readable bytes. */
+NMD_ASSEMBLY_API size_t _nmd_ldisasm_scan_prefixes_sse2(const uint8_t* buffer, NMD_X86_MODE mode, uint8_t* classes)
+{
+	const __m128i bytes = _mm_loadu_si128((const __m128i*)buffer);
+	const __m128i operand_size = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(0x66));
+	const __m128i address_size = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(0x67));
+	const __m128i lock = _mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)0xf0));
+	const __m128i segment = _mm_or_si128(_mm_cmpeq_epi8(_mm_and_si128(bytes, _mm_set1_epi8((char)0xe7)), _mm_set1_epi8(0x26)), _mm_cmpeq_epi8(_mm_and_si128(bytes, _mm_set1_epi8((char)0xfe)), _mm_set1_epi8(0x64))); /* 26,2E,36,3E,64,65 */
+	const __m128i repeat = _mm_cmpeq_epi8(_mm_and_si128(bytes, _mm_set1_epi8((char)0xfe)), _mm_set1_epi8((char)0xf2)); /* F2,F3 */
+	const __m128i legacy = _mm_or_si128(_mm_or_si128(_mm_or_si128(operand_size, address_size), _mm_or_si128(lock, segment)), repeat);
+	__m128i rex = _mm_setzero_si128();
+	__m128i rex_w = _mm_setzero_si128();
+	uint32_t run;
+	size_t num_prefixes;
+
+	if (mode == NMD_X86_MODE_64)
+	{
+		rex = _mm_cmpeq_epi8(_mm_and_si128(bytes, _mm_set1_epi8((char)0xf0)), _mm_set1_epi8(0x40));
+		rex_w = _mm_cmpeq_epi8(_mm_and_si128(bytes, _mm_set1_epi8((char)0xf8)), _mm_set1_epi8(0x48));
+	}
+
+	/* The prefixes are the bytes before the first zero bit of the mask */
+	num_prefixes = _nmd_get_bit_index(~(uint32_t)_mm_movemask_epi8(_mm_or_si128(legacy, rex)));
+	run = ((uint32_t)1 << num_prefixes) - 1;
+
+	*classes = (uint8_t)(((uint32_t)_mm_movemask_epi8(legacy) & run ? _NMD_X86_PREFIX_CLASS_LEGACY : 0) |
+		((uint32_t)_mm_movemask_epi8(rex) & run ? _NMD_X86_PREFIX_CLASS_REX : 0) |
+		((uint32_t)_mm_movemask_epi8(operand_size) & run ? _NMD_X86_PREFIX_CLASS_OPERAND_SIZE : 0) |
+		((uint32_t)_mm_movemask_epi8(address_size) & run ? _NMD_X86_PREFIX_CLASS_ADDRESS_SIZE : 0) |
+		((uint32_t)_mm_movemask_epi8(lock) & run ? _NMD_X86_PREFIX_CLASS_LOCK : 0) |
+		(num_prefixes && ((uint32_t)_mm_movemask_epi8(rex_w) >> (num_prefixes - 1)) & 1 ? _NMD_X86_PREFIX_CLASS_REX_W : 0)); /* A REX prefix is ignored if it's not the last prefix */
+
+	return num_prefixes;
+}
+#endif /* NMD_ASSEMBLY_ENABLE_LENGTH_DISASSEMBLER_SSE2 */
+
+/*
+Returns the length of the instruction if it is valid, zero otherwise.
+The length is computed using the opcode tables in 'nmd_x86_opcode_tables.c'. Opcodes the tables can't describe(and instructions with a lock prefix) are handled by _nmd_ldisasm().
+Parameters:
+ - buffer      [in] A pointer to a buffer containing an encoded instruction.
+ - buffer_size [in] The size of the buffer in bytes.
+ - mode        [in] The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_ldisasm(const void* const buffer, size_t buffer_size, const NMD_X86_MODE mode)
+{
+	const uint8_t* b = (const uint8_t*)buffer;
+	const size_t original_buffer_size = buffer_size;
+	uint8_t classes, flags, op;
+	size_t num_prefixes, imm_size;
+	nmd_x86_modrm modrm;
+
+	/*  Clamp 'buffer_size' to 15. We will only read up to 15 bytes(NMD_X86_MAXIMUM_INSTRUCTION_LENGTH) */
+	if (buffer_size > 15)
+		buffer_size = 15;
+
+	/* Classify legacy and REX prefixes */
+#ifdef NMD_ASSEMBLY_ENABLE_LENGTH_DISASSEMBLER_SSE2
+	if (original_buffer_size >= 16)
+		num_prefixes = _nmd_ldisasm_scan_prefixes_sse2(b, mode, &classes);
+	else
+#endif /* NMD_ASSEMBLY_ENABLE_LENGTH_DISASSEMBLER_SSE2 */
+		num_prefixes = _nmd_ldisasm_scan_prefixes(b, buffer_size, mode, &classes);
+
+	/* There must be at least one byte after the prefixes */
+	if (num_prefixes >= buffer_size)
+		return 0;
+
+	/* The lock prefix's validity depends on the opcode and the ModR/M byte */
+	if (classes & _NMD_X86_PREFIX_CLASS_LOCK)
+		return _nmd_ldisasm(buffer, original_buffer_size, mode);
+
+	b += num_prefixes;
+	buffer_size -= num_prefixes;
+
+	/* Look up the opcode's flags */
+	_NMD_READ_BYTE(b, buffer_size, op);
+	if (op == 0x0F)
+	{
+		_NMD_READ_BYTE(b, buffer_size, op);
+		flags = _nmd_x86_ldisasm_op2_flags[mode >> 2][op];
+	}
+	else
+		flags = _nmd_x86_ldisasm_op1_flags[mode >> 2][op];
+
+	if ((flags & _NMD_X86_OPCODE_FALLBACK) == _NMD_X86_OPCODE_FALLBACK)
+		return _nmd_ldisasm(buffer, original_buffer_size, mode);
+
+	/* Check for ModR/M, SIB and displacement */
+	if (flags & _NMD_X86_OPCODE_MODRM)
+	{
+		if (!_nmd_ldisasm_decode_modrm(&b, &buffer_size, (classes & _NMD_X86_PREFIX_CLASS_ADDRESS_SIZE) != 0, mode, &modrm))
+			return 0;
+
+		if (flags & (modrm.fields.mod == 0b11 ? _NMD_X86_OPCODE_INVALID_REG : _NMD_X86_OPCODE_INVALID_MEM))
+		{
+#ifndef NMD_ASSEMBLY_DISABLE_LENGTH_DISASSEMBLER_VALIDITY_CHECK
+			return 0;
+#else
+			return _nmd_ldisasm(buffer, original_buffer_size, mode);
+#endif /* NMD_ASSEMBLY_DISABLE_LENGTH_DISASSEMBLER_VALIDITY_CHECK */
+		}
+	}
+
+	/* Make sure we can "read" 'imm_size' bytes from the buffer */
+	imm_size = _nmd_x86_get_imm_size((uint8_t)(flags & _NMD_X86_OPCODE_IMM_MASK), mode, (classes & _NMD_X86_PREFIX_CLASS_OPERAND_SIZE) != 0, (classes & _NMD_X86_PREFIX_CLASS_ADDRESS_SIZE) != 0, (classes & _NMD_X86_PREFIX_CLASS_REX_W) != 0);
+	if (buffer_size < imm_size)
+		return 0;
+
+	return (size_t)((ptrdiff_t)(b + imm_size) - (ptrdiff_t)(buffer));
+}
+
+/*
+Computes the length of consecutive instructions until the end of the buffer, an invalid instruction or the end of the output array is reached. Returns the number of lengths written to 'lengths'.
+Parameters:
+ - buffer      [in]      A pointer to a buffer containing encoded instructions.
+ - buffer_size [in]      The buffer's size in bytes.
+ - mode        [in]      The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - lengths     [out]     A pointer to an array that receives the length of each instruction.
+ - num_lengths [in]      The number of elements in 'lengths'.
+ - info        [out/opt] A pointer to a variable of type 'nmd_x86_buffer_info' that receives where and why the function stopped. 'runtime_address' is set to 'NMD_X86_INVALID_RUNTIME_ADDRESS'. This parameter may be null.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_ldisasm_buffer(const void* buffer, size_t buffer_size, NMD_X86_MODE mode, uint8_t* lengths, size_t num_lengths, nmd_x86_buffer_info* info)
+{
+	const uint8_t* b = (const uint8_t*)buffer;
+	const uint8_t* const end = b + buffer_size;
+	uint8_t status = NMD_X86_BUFFER_STATUS_END;
+	size_t count = 0, length;
+
+	while (b < end)
+	{
+		if (count == num_lengths)
+		{
+			status = NMD_X86_BUFFER_STATUS_OUTPUT_FULL;
+			break;
+		}
+
+		if (!(length = nmd_x86_ldisasm(b, (size_t)(end - b), mode)))
+		{
+			status = NMD_X86_BUFFER_STATUS_INVALID;
+			break;
+		}
+
+		lengths[count++] = (uint8_t)length;
+		b += length;
+	}
+
+	if (info)
+	{
+		info->offset = (size_t)(b - (const uint8_t*)buffer);
+		info->runtime_address = NMD_X86_INVALID_RUNTIME_ADDRESS;
+		info->status = status;
+	}
+
+	return count;
 }
 
+
 typedef struct
 {
 	char* buffer;
@@ -7613,38 +10250,68 @@ NMD_ASSEMBLY_API void _nmd_append_string(_nmd_string_info* const si, const char*
 		*si->buffer++ = *source++;
 }
 
+/* Appends the instruction's mnemonic from '_nmd_x86_mnemonics' with a fixed-size copy, or 'fallback' if the id has no entry(e.g. the id was not filled). */
+NMD_ASSEMBLY_API void _nmd_append_mnemonic(_nmd_string_info* const si, const char* fallback)
+{
+	const char* const mnemonic = _nmd_x86_mnemonics + _nmd_x86_mnemonic_offsets[si->instruction->id];
+	size_t i = 0;
+	if (!mnemonic[0])
+	{
+		_nmd_append_string(si, fallback);
+		return;
+	}
+
+	for (; i < 16; i++)
+		si->buffer[i] = mnemonic[i + 1];
+	si->buffer += mnemonic[0];
+}
+
+/* Appends a number without loops that depend on its value, other than one iteration per two decimal digits. */
 NMD_ASSEMBLY_API void _nmd_append_number(_nmd_string_info* const si, uint64_t n)
 {
-	size_t buffer_offset;
+	char* p;
+	size_t num_digits = 1, i;
 	if (si->flags & NMD_X86_FORMAT_FLAGS_HEX)
 	{
-		size_t num_digits = _NMD_GET_NUM_DIGITS_HEX(n);
-		buffer_offset = num_digits;
-
+		const char* const digits = _nmd_hex_digits[si->flags & NMD_X86_FORMAT_FLAGS_HEX_LOWERCASE ? 1 : 0];
 		const bool condition = n > 9 || si->flags & NMD_X86_FORMAT_FLAGS_ENFORCE_HEX_ID;
+
+		/* Count the significant nibbles using comparisons instead of divisions */
+		for (i = 4; i < 64; i += 4)
+			num_digits += (size_t)((n >> i) != 0);
+
 		if (si->flags & NMD_X86_FORMAT_FLAGS_0X_PREFIX && condition)
 			*si->buffer++ = '0', *si->buffer++ = 'x';
 
-		const uint8_t base_char = (uint8_t)(si->flags & NMD_X86_FORMAT_FLAGS_HEX_LOWERCASE ? 0x57 : 0x37);
-		do {
-			size_t num = n % 16;
-			*(si->buffer + --num_digits) = (char)((num > 9 ? base_char : '0') + num);
-		} while ((n /= 16) > 0);
+		p = si->buffer += num_digits;
+		for (i = 0; i < num_digits; i++, n >>= 4)
+			*--p = digits[n & 0xf];
 
 		if (si->flags & NMD_X86_FORMAT_FLAGS_H_SUFFIX && condition)
-			*(si->buffer + buffer_offset++) = 'h';
+			*si->buffer++ = 'h';
 	}
 	else
 	{
-		size_t num_digits = _NMD_GET_NUM_DIGITS(n);
-		buffer_offset = num_digits + 1;
+		for (i = 0; i < _NMD_NUM_ELEMENTS(_nmd_powers_of_ten); i++)
+			num_digits += (size_t)(n >= _nmd_powers_of_ten[i]);
 
-		do {
-			*(si->buffer + --num_digits) = (char)('0' + n % 10);
-		} while ((n /= 10) > 0);
-	}
+		/* Write two digits at a time from right to left */
+		p = si->buffer += num_digits;
+		for (; n >= 100; n /= 100)
+		{
+			const size_t pair = (size_t)(n % 100) * 2;
+			*--p = _nmd_decimal_digit_pairs[pair + 1];
+			*--p = _nmd_decimal_digit_pairs[pair];
+		}
 
-	si->buffer += buffer_offset;
+		if (n >= 10)
+		{
+			*--p = _nmd_decimal_digit_pairs[n * 2 + 1];
+			*--p = _nmd_decimal_digit_pairs[n * 2];
+		}
+		else
+			*--p = (char)('0' + n);
+	}
 }
 
 NMD_ASSEMBLY_API void _nmd_append_signed_number(_nmd_string_info* const si, int64_t n, bool show_positive_sign)
@@ -7827,7 +10494,7 @@ NMD_ASSEMBLY_API void _nmd_append_modrm32_upper(_nmd_string_info* const si)
 			else
 				_nmd_append_number(si, (uint64_t)((int64_t)(si->runtime_address + si->instruction->length) + (int64_t)((int32_t)si->instruction->displacement)));
 		}
-		else if (si->instruction->modrm.fields.mod == 0b00 && ((si->instruction->sib.fields.base == 0b101 && si->instruction->sib.fields.index == 0b100) || si->instruction->modrm.fields.rm == 0b101) && *(si->buffer - 1) == '[')
+		else if (si->instruction->modrm.fields.mod == 0b00 && ((si->instruction->sib.fields.base == 0b101 && si->instruction->sib.fields.index == 0b100) || (si->instruction->modrm.fields.rm == 0b101 && si->instruction->mode != NMD_X86_MODE_64)) && *(si->buffer - 1) == '[') /* In 64-bit mode 'rm' 0b101 is relative to rip */
 			_nmd_append_number(si, si->instruction->mode == NMD_X86_MODE_64 ? 0xFFFFFFFF00000000 | si->instruction->displacement : si->instruction->displacement);
 		else
 		{
@@ -8065,7 +10732,13 @@ NMD_ASSEMBLY_API char* _nmd_format_operand_to_att(char* operand, _nmd_string_inf
 		if (segment_reg)
 		{
 			if (segment_reg == operand + 2)
+			{
+				/* Inserting the '%' character moves the rest of the string to the right. */
 				_nmd_insert_char(operand, '%'), si->buffer++, operand += 4;
+				memory_operand++, operand_end++;
+				if (next_operand)
+					next_operand++;
+			}
 			else
 			{
 				*operand++ = '%';
@@ -8171,20 +10844,13 @@ NMD_ASSEMBLY_API char* _nmd_format_operand_to_att(char* operand, _nmd_string_inf
 }
 #endif /* NMD_ASSEMBLY_DISABLE_FORMATTER_ATT_SYNTAX */
 
-/*
-Formats an instruction. This function may cause a crash if you modify 'instruction' manually.
-Parameters:
- - instruction     [in]  A pointer to a variable of type 'nmd_x86_instruction' describing the instruction to be formatted.
- - buffer          [out] A pointer to buffer that receives the string. The buffer's recommended size is 128 bytes.
- - runtime_address [in]  The instruction's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
- - flags           [in]  A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the function should format the instruction. If uncertain, use 'NMD_X86_FORMAT_FLAGS_DEFAULT'.
-*/
-NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, char* buffer, uint64_t runtime_address, uint32_t flags)
+/* Formats an instruction into 'buffer', which must have at least 'NMD_X86_FORMATTER_MAX_LENGTH' bytes. Returns the length of the string excluding the null character. */
+NMD_ASSEMBLY_API size_t _nmd_x86_format(const nmd_x86_instruction* instruction, char* buffer, uint64_t runtime_address, uint32_t flags)
 {
 	if (!instruction->valid)
 	{
 		buffer[0] = '\0';
-		return;
+		return 0;
 	}
 
 	_nmd_string_info si;
@@ -8196,13 +10862,12 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 #ifndef NMD_ASSEMBLY_DISABLE_FORMATTER_BYTES
 	if (flags & NMD_X86_FORMAT_FLAGS_BYTES)
 	{
+		const uint8_t* const bytes = instruction->source ? instruction->source : instruction->buffer;
 		size_t i = 0;
 		for (; i < instruction->length; i++)
 		{
-			uint8_t num = instruction->buffer[i] >> 4;
-			*si.buffer++ = (char)((num > 9 ? 0x37 : '0') + num);
-			num = instruction->buffer[i] & 0xf;
-			*si.buffer++ = (char)((num > 9 ? 0x37 : '0') + num);
+			*si.buffer++ = _nmd_hex_digits[0][bytes[i] >> 4];
+			*si.buffer++ = _nmd_hex_digits[0][bytes[i] & 0xf];
 			*si.buffer++ = ' ';
 		}
 
@@ -8214,15 +10879,20 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 
 	const uint8_t op = instruction->opcode;
 
-	if (instruction->prefixes & (NMD_X86_PREFIXES_REPEAT | NMD_X86_PREFIXES_REPEAT_NOT_ZERO) && (instruction->prefixes & NMD_X86_PREFIXES_LOCK || ((op == 0x86 || op == 0x87) && instruction->modrm.fields.mod != 0b11)))
-		_nmd_append_string(&si, instruction->repeat_prefix ? "xrelease " : "xacquire ");
-	else if (instruction->prefixes & NMD_X86_PREFIXES_REPEAT_NOT_ZERO && (instruction->opcode_size == 1 && (op == 0xc2 || op == 0xc3 || op == 0xe8 || op == 0xe9 || _NMD_R(op) == 7 || (op == 0xff && (instruction->modrm.fields.reg == 0b010 || instruction->modrm.fields.reg == 0b100)))))
-		_nmd_append_string(&si, "bnd ");
+	/* Most instructions have none of these prefixes, so the opcode checks are skipped with a single test */
+	if (instruction->prefixes & (NMD_X86_PREFIXES_REPEAT | NMD_X86_PREFIXES_REPEAT_NOT_ZERO | NMD_X86_PREFIXES_LOCK))
+	{
+		if (instruction->prefixes & (NMD_X86_PREFIXES_REPEAT | NMD_X86_PREFIXES_REPEAT_NOT_ZERO) && (instruction->prefixes & NMD_X86_PREFIXES_LOCK || ((op == 0x86 || op == 0x87) && instruction->modrm.fields.mod != 0b11)))
+			_nmd_append_string(&si, instruction->repeat_prefix ? "xrelease " : "xacquire ");
+		else if (instruction->prefixes & NMD_X86_PREFIXES_REPEAT_NOT_ZERO && (instruction->opcode_size == 1 && (op == 0xc2 || op == 0xc3 || op == 0xe8 || op == 0xe9 || _NMD_R(op) == 7 || (op == 0xff && (instruction->modrm.fields.reg == 0b010 || instruction->modrm.fields.reg == 0b100)))))
+			_nmd_append_string(&si, "bnd ");
 
-	if (instruction->prefixes & NMD_X86_PREFIXES_LOCK)
-		_nmd_append_string(&si, "lock ");
+		if (instruction->prefixes & NMD_X86_PREFIXES_LOCK)
+			_nmd_append_string(&si, "lock ");
+	}
 
 	const bool opszprfx = instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE;
+	const bool operand16 = opszprfx != (instruction->mode == NMD_X86_MODE_16); /* The operand-size override prefix toggles between 16 and 32 bits */
 
 	if (instruction->opcode_map == NMD_X86_OPCODE_MAP_DEFAULT)
 	{
@@ -8370,7 +11040,7 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 			case 0xb7: mnemonic = "pmulhrw"; break;
 			case 0xbb: mnemonic = "pswapd"; break;
 			case 0xbf: mnemonic = "pavgusb"; break;
-			default: return;
+			default: buffer[0] = '\0'; return 0;
 			}
 
 			_nmd_append_string(&si, mnemonic);
@@ -8388,7 +11058,8 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 			{
 				if (op >= 0x88 && op <= 0x8c) /* mov [88,8c] */
 				{
-					_nmd_append_string(&si, "mov ");
+					_nmd_append_mnemonic(&si, "mov");
+					*si.buffer++ = ' ';
 					if (op == 0x8b)
 					{
 						_nmd_append_Gv(&si);
@@ -8439,16 +11110,19 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 				}
 				else if (op == 0xff) /* Opcode extensions Group 5 */
 				{
-					_nmd_append_string(&si, _nmd_opcode_extensions_grp5[instruction->modrm.fields.reg]);
+					if (instruction->modrm.fields.reg == 0b011 || instruction->modrm.fields.reg == 0b101)
+						_nmd_append_string(&si, _nmd_opcode_extensions_grp5[instruction->modrm.fields.reg]);
+					else
+						_nmd_append_mnemonic(&si, _nmd_opcode_extensions_grp5[instruction->modrm.fields.reg]);
 					*si.buffer++ = ' ';
 					if (instruction->modrm.fields.mod == 0b11)
-						_nmd_append_string(&si, (si.instruction->rex_w_prefix ? _nmd_reg64 : (opszprfx ? _nmd_reg16 : _nmd_reg32))[si.instruction->modrm.fields.rm]);
+						_nmd_append_string(&si, (si.instruction->rex_w_prefix ? _nmd_reg64 : (operand16 ? _nmd_reg16 : _nmd_reg32))[si.instruction->modrm.fields.rm]);
 					else
-						_nmd_append_modrm_upper(&si, (instruction->modrm.fields.reg == 0b011 || instruction->modrm.fields.reg == 0b101) ? "fword" : (instruction->mode == NMD_X86_MODE_64 && ((instruction->modrm.fields.reg >= 0b010 && instruction->modrm.fields.reg <= 0b110) || (instruction->prefixes & NMD_X86_PREFIXES_REX_W && instruction->modrm.fields.reg <= 0b010)) ? "qword" : (opszprfx ? "word" : "dword")));
+						_nmd_append_modrm_upper(&si, (instruction->modrm.fields.reg == 0b011 || instruction->modrm.fields.reg == 0b101) ? "fword" : (instruction->mode == NMD_X86_MODE_64 && ((instruction->modrm.fields.reg >= 0b010 && instruction->modrm.fields.reg <= 0b110) || (instruction->prefixes & NMD_X86_PREFIXES_REX_W && instruction->modrm.fields.reg <= 0b010)) ? "qword" : (operand16 ? "word" : "dword")));
 				}
 				else if (_NMD_R(op) < 4 && (_NMD_C(op) < 6 || (_NMD_C(op) >= 8 && _NMD_C(op) < 0xE))) /* add,adc,and,xor,or,sbb,sub,cmp */
 				{
-					_nmd_append_string(&si, _nmd_op1_opcode_map_mnemonics[_NMD_R((_NMD_C(op) > 6 ? op + 0x40 : op))]);
+					_nmd_append_mnemonic(&si, _nmd_op1_opcode_map_mnemonics[_NMD_R((_NMD_C(op) > 6 ? op + 0x40 : op))]);
 					*si.buffer++ = ' ';
 
 					switch (op % 8)
@@ -8478,7 +11152,7 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 						_nmd_append_number(&si, instruction->immediate);
 						break;
 					case 5:
-						_nmd_append_string(&si, instruction->rex_w_prefix ? "rax" : (opszprfx ? "ax" : "eax"));
+						_nmd_append_string(&si, instruction->rex_w_prefix ? "rax" : (operand16 ? "ax" : "eax"));
 						*si.buffer++ = ',';
 						_nmd_append_number(&si, instruction->immediate);
 						break;
@@ -8486,12 +11160,13 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 				}
 				else if (_NMD_R(op) == 4 || _NMD_R(op) == 5) /* inc,dec,push,pop [0x40, 0x5f] */
 				{
-					_nmd_append_string(&si, _NMD_C(op) < 8 ? (_NMD_R(op) == 4 ? "inc " : "push ") : (_NMD_R(op) == 4 ? "dec " : "pop "));
+					_nmd_append_mnemonic(&si, _NMD_C(op) < 8 ? (_NMD_R(op) == 4 ? "inc" : "push") : (_NMD_R(op) == 4 ? "dec" : "pop"));
+					*si.buffer++ = ' ';
 					_nmd_append_string(&si, (instruction->prefixes & NMD_X86_PREFIXES_REX_B ? (opszprfx ? _nmd_regrxw : _nmd_regrx) : (opszprfx ? (instruction->mode == NMD_X86_MODE_16 ? _nmd_reg32 : _nmd_reg16) : ((instruction->mode == NMD_X86_MODE_32 ? _nmd_reg32 : (instruction->mode == NMD_X86_MODE_64 ? _nmd_reg64 : _nmd_reg16)))))[op % 8]);
 				}
 				else if (op >= 0x80 && op < 0x84) /* add,adc,and,xor,or,sbb,sub,cmp [80,83] */
 				{
-					_nmd_append_string(&si, _nmd_opcode_extensions_grp1[instruction->modrm.fields.reg]);
+					_nmd_append_mnemonic(&si, _nmd_opcode_extensions_grp1[instruction->modrm.fields.reg]);
 					*si.buffer++ = ' ';
 					if (op == 0x80 || op == 0x82)
 						_nmd_append_Eb(&si);
@@ -8510,7 +11185,8 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 				}
 				else if (op == 0xe8 || op == 0xe9 || op == 0xeb) /* call,jmp */
 				{
-					_nmd_append_string(&si, op == 0xe8 ? "call " : "jmp ");
+					_nmd_append_mnemonic(&si, op == 0xe8 ? "call" : "jmp");
+					*si.buffer++ = ' ';
 					if (op == 0xeb)
 						_nmd_append_relative_address8(&si);
 					else
@@ -8518,7 +11194,8 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 				}
 				else if (op >= 0xA0 && op < 0xA4) /* mov [a0, a4] */
 				{
-					_nmd_append_string(&si, "mov ");
+					_nmd_append_mnemonic(&si, "mov");
+					*si.buffer++ = ' ';
 					if (op == 0xa0)
 					{
 						_nmd_append_string(&si, "al,");
@@ -8529,8 +11206,8 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 					}
 					else if (op == 0xa1)
 					{
-						_nmd_append_string(&si, instruction->rex_w_prefix ? "rax," : (opszprfx ? "ax," : "eax,"));
-						_nmd_append_modrm_memory_prefix(&si, instruction->rex_w_prefix ? "qword" : (opszprfx ? "word" : "dword"));
+						_nmd_append_string(&si, instruction->rex_w_prefix ? "rax," : (operand16 ? "ax," : "eax,"));
+						_nmd_append_modrm_memory_prefix(&si, instruction->rex_w_prefix ? "qword" : (operand16 ? "word" : "dword"));
 						*si.buffer++ = '[';
 						_nmd_append_number(&si, (instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE || instruction->mode == NMD_X86_MODE_16 ? 0xFFFF : 0xFFFFFFFFFFFFFFFF) & instruction->immediate);
 						*si.buffer++ = ']';
@@ -8544,34 +11221,41 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 					}
 					else if (op == 0xa3)
 					{
-						_nmd_append_modrm_memory_prefix(&si, instruction->rex_w_prefix ? "qword" : (opszprfx ? "word" : "dword"));
+						_nmd_append_modrm_memory_prefix(&si, instruction->rex_w_prefix ? "qword" : (operand16 ? "word" : "dword"));
 						*si.buffer++ = '[';
 						_nmd_append_number(&si, (instruction->prefixes & NMD_X86_PREFIXES_ADDRESS_SIZE_OVERRIDE || instruction->mode == NMD_X86_MODE_16 ? 0xFFFF : 0xFFFFFFFFFFFFFFFF) & instruction->immediate);
 						_nmd_append_string(&si, "],");
-						_nmd_append_string(&si, instruction->rex_w_prefix ? "rax" : (opszprfx ? "ax" : "eax"));
+						_nmd_append_string(&si, instruction->rex_w_prefix ? "rax" : (operand16 ? "ax" : "eax"));
 					}
 				}
 				else if(op == 0xcc) /* int3 */
 					_nmd_append_string(&si, "int3");
 				else if (op == 0x8d) /* lea */
 				{
-					_nmd_append_string(&si, "lea ");
+					_nmd_append_mnemonic(&si, "lea");
+					*si.buffer++ = ' ';
 					_nmd_append_Gv(&si);
 					*si.buffer++ = ',';
 					_nmd_append_modrm_upper_without_address_specifier(&si);
 				}
 				else if (op == 0x8f) /* pop */
 				{
-					_nmd_append_string(&si, "pop ");
+					_nmd_append_mnemonic(&si, "pop");
+					*si.buffer++ = ' ';
 					if (instruction->modrm.fields.mod == 0b11)
-						_nmd_append_string(&si, (opszprfx ? _nmd_reg16 : _nmd_reg32)[instruction->modrm.fields.rm]);
+						_nmd_append_string(&si, (operand16 ? _nmd_reg16 : _nmd_reg32)[instruction->modrm.fields.rm]);
 					else
-						_nmd_append_modrm_upper(&si, instruction->mode == NMD_X86_MODE_64 && !(instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE) ? "qword" : (opszprfx ? "word" : "dword"));
+						_nmd_append_modrm_upper(&si, instruction->mode == NMD_X86_MODE_64 && !(instruction->prefixes & NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE) ? "qword" : (operand16 ? "word" : "dword"));
 				}
 				else if (_NMD_R(op) == 7) /* conditional jump [70,7f]*/
 				{
-					*si.buffer++ = 'j';
-					_nmd_append_string(&si, _nmd_condition_suffixes[_NMD_C(op)]);
+					if (_nmd_x86_mnemonic_offsets[instruction->id])
+						_nmd_append_mnemonic(&si, 0);
+					else
+					{
+						*si.buffer++ = 'j';
+						_nmd_append_string(&si, _nmd_condition_suffixes[_NMD_C(op)]);
+					}
 					*si.buffer++ = ' ';
 					_nmd_append_relative_address8(&si);
 				}
@@ -8582,7 +11266,7 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 				}
 				else if (op == 0xa9) /* test */
 				{
-					_nmd_append_string(&si, instruction->rex_w_prefix ? "test rax" : (opszprfx ? "test ax" : "test eax"));
+					_nmd_append_string(&si, instruction->rex_w_prefix ? "test rax" : (operand16 ? "test ax" : "test eax"));
 					*si.buffer++ = ',';
 					_nmd_append_number(&si, instruction->immediate);
 				}
@@ -8603,7 +11287,7 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 					if (instruction->prefixes & NMD_X86_PREFIXES_REX_B)
 						_nmd_append_string(&si, _nmd_regrx[op % 8]), * si.buffer++ = _NMD_C(op) < 8 ? 'b' : 'd';
 					else
-						_nmd_append_string(&si, (_NMD_C(op) < 8 ? (instruction->has_rex ? _nmd_reg8_x64 : _nmd_reg8) : (instruction->rex_w_prefix ? _nmd_reg64 : (opszprfx ? _nmd_reg16 : _nmd_reg32)))[op % 8]);
+						_nmd_append_string(&si, (_NMD_C(op) < 8 ? (instruction->has_rex ? _nmd_reg8_x64 : _nmd_reg8) : (instruction->rex_w_prefix ? _nmd_reg64 : (operand16 ? _nmd_reg16 : _nmd_reg32)))[op % 8]);
 					*si.buffer++ = ',';
 					_nmd_append_number(&si, instruction->immediate);
 				}
@@ -8677,8 +11361,8 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 							*si.buffer++ = 'd';
 					}
 					else
-						_nmd_append_string(&si, (instruction->prefixes & NMD_X86_PREFIXES_REX_W ? _nmd_reg64 : (opszprfx ? _nmd_reg16 : _nmd_reg32))[_NMD_C(op)]);
-					_nmd_append_string(&si, (instruction->prefixes & NMD_X86_PREFIXES_REX_W ? ",rax" : (opszprfx ? ",ax" : ",eax")));
+						_nmd_append_string(&si, (instruction->prefixes & NMD_X86_PREFIXES_REX_W ? _nmd_reg64 : (operand16 ? _nmd_reg16 : _nmd_reg32))[_NMD_C(op)]);
+					_nmd_append_string(&si, (instruction->prefixes & NMD_X86_PREFIXES_REX_W ? ",rax" : (operand16 ? ",ax" : ",eax")));
 				}
 				else if (op == 0x9A)
 				{
@@ -9046,7 +11730,7 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 				else if (op == 0xe4 || op == 0xe5)
 				{
 					_nmd_append_string(&si, "in ");
-					_nmd_append_string(&si, op == 0xe4 ? "al" : (opszprfx ? "ax" : "eax"));
+					_nmd_append_string(&si, op == 0xe4 ? "al" : (operand16 ? "ax" : "eax"));
 					*si.buffer++ = ',';
 					_nmd_append_number(&si, instruction->immediate);
 				}
@@ -9055,18 +11739,18 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 					_nmd_append_string(&si, "out ");
 					_nmd_append_number(&si, instruction->immediate);
 					*si.buffer++ = ',';
-					_nmd_append_string(&si, op == 0xe6 ? "al" : (opszprfx ? "ax" : "eax"));
+					_nmd_append_string(&si, op == 0xe6 ? "al" : (operand16 ? "ax" : "eax"));
 				}				
 				else if (op == 0xec || op == 0xed)
 				{
 					_nmd_append_string(&si, "in ");
-					_nmd_append_string(&si, op == 0xec ? "al" : (opszprfx ? "ax" : "eax"));
+					_nmd_append_string(&si, op == 0xec ? "al" : (operand16 ? "ax" : "eax"));
 					_nmd_append_string(&si, ",dx");
 				}
 				else if (op == 0xee || op == 0xef)
 				{
 					_nmd_append_string(&si, "out dx,");
-					_nmd_append_string(&si, op == 0xee ? "al" : (opszprfx ? "ax" : "eax"));
+					_nmd_append_string(&si, op == 0xee ? "al" : (operand16 ? "ax" : "eax"));
 				}
 				else if (op == 0x62)
 				{
@@ -9150,7 +11834,7 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 					case 0xfb: str = "sti"; break;
 					case 0xfc: str = "cld"; break;
 					case 0xfd: str = "std"; break;
-					default: return;
+					default: buffer[0] = '\0'; return 0;
 					}
 					_nmd_append_string(&si, str);
 				}
@@ -9447,7 +12131,7 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 			_nmd_append_Gv(&si);
 			*si.buffer++ = ',';
 			if (si.instruction->modrm.fields.mod == 0b11)
-				_nmd_append_string(&si, (opszprfx ? _nmd_reg16 : _nmd_reg32)[si.instruction->modrm.fields.rm]);
+				_nmd_append_string(&si, (operand16 ? _nmd_reg16 : _nmd_reg32)[si.instruction->modrm.fields.rm]);
 			else
 				_nmd_append_modrm_upper(&si, "word");
 		}
@@ -9784,72 +12468,380 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 			}
 			else if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO)
 			{
-				const char* prefixF2_mnemonics[] = { 0, "sqrtsd", 0, 0, 0, 0, 0, 0, "addsd", "mulsd", "cvtsd2ss", 0, "subsd", "minsd", "divsd", "maxsd" };
-
-				_nmd_append_string(&si, prefixF2_mnemonics[op % 0x10]);
-				*si.buffer++ = ' ';
-				_nmd_append_Vdq(&si);
-				*si.buffer++ = ',';
-				if (si.instruction->modrm.fields.mod == 0b11)
-					_nmd_append_string(&si, "xmm"), * si.buffer++ = (char)('0' + si.instruction->modrm.fields.rm);
+				const char* prefixF2_mnemonics[] = { 0, "sqrtsd", 0, 0, 0, 0, 0, 0, "addsd", "mulsd", "cvtsd2ss", 0, "subsd", "minsd", "divsd", "maxsd" };
+
+				_nmd_append_string(&si, prefixF2_mnemonics[op % 0x10]);
+				*si.buffer++ = ' ';
+				_nmd_append_Vdq(&si);
+				*si.buffer++ = ',';
+				if (si.instruction->modrm.fields.mod == 0b11)
+					_nmd_append_string(&si, "xmm"), * si.buffer++ = (char)('0' + si.instruction->modrm.fields.rm);
+				else
+					_nmd_append_modrm_upper(&si, "qword");
+			}
+			else
+			{
+				const char* no_prefix_mnemonics[] = { "movmskps", "sqrtps", "rsqrtps", "rcpps", "andps", "andnps", "orps", "xorps", "addps", "mulps", "cvtps2pd",  "cvtdq2ps", "subps", "minps", "divps", "maxps" };
+
+				_nmd_append_string(&si, no_prefix_mnemonics[op % 0x10]);
+				*si.buffer++ = ' ';
+				if (op == 0x50)
+				{
+					_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.reg]);
+					*si.buffer++ = ',';
+					_nmd_append_Udq(&si);
+				}
+				else
+				{
+					_nmd_append_Vdq(&si);
+					*si.buffer++ = ',';
+					if (si.instruction->modrm.fields.mod == 0b11)
+						_nmd_append_string(&si, "xmm"), * si.buffer++ = (char)('0' + si.instruction->modrm.fields.rm);
+					else
+						_nmd_append_modrm_upper(&si, op == 0x5a ? "qword" : "xmmword");
+				}
+			}
+		}		
+		else if (op == 0x70)
+		{
+			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "pshufd" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "pshufhw" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO ? "pshuflw" : "pshufw")));
+			*si.buffer++ = ' ';
+			if (!(instruction->prefixes & (NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE | NMD_X86_PREFIXES_REPEAT | NMD_X86_PREFIXES_REPEAT_NOT_ZERO)))
+			{
+				_nmd_append_Pq(&si);
+				*si.buffer++ = ',';
+				_nmd_append_Qq(&si);
+			}
+			else
+			{
+				_nmd_append_Vdq(&si);
+				*si.buffer++ = ',';
+				_nmd_append_W(&si);
+			}
+
+			*si.buffer++ = ',';
+			_nmd_append_number(&si, instruction->immediate);
+		}
+		else if (op >= 0x71 && op <= 0x73)
+		{
+			if (instruction->modrm.fields.reg % 2 == 1)
+				_nmd_append_string(&si, instruction->modrm.fields.reg == 0b111 ? "pslldq" : "psrldq");
+			else
+			{
+				const char* mnemonics[] = { "psrl", "psra", "psll" };
+				_nmd_append_string(&si, mnemonics[(instruction->modrm.fields.reg >> 1) - 1]);
+				*si.buffer++ = op == 0x71 ? 'w' : (op == 0x72 ? 'd' : 'q');
+			}
+
+			*si.buffer++ = ' ';
+			if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
+				_nmd_append_Udq(&si);
+			else
+				_nmd_append_Nq(&si);
+			*si.buffer++ = ',';
+			_nmd_append_number(&si, instruction->immediate);
+		}
+		else if (op == 0x78)
+		{
+			if (!instruction->simd_prefix)
+			{
+				_nmd_append_string(&si, "vmread ");
+				_nmd_append_Ey(&si);
+				*si.buffer++ = ',';
+				_nmd_append_Gy(&si);
+			}
+			else
+			{
+				if(instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
+					_nmd_append_string(&si, "extrq ");
+				else
+				{ 
+					_nmd_append_string(&si, "insertq ");
+					_nmd_append_Vdq(&si);
+					*si.buffer++ = ',';
+				}
+				_nmd_append_Udq(&si);
+				*si.buffer++ = ',';
+				_nmd_append_number(&si, instruction->immediate & 0x00FF);
+				*si.buffer++ = ',';
+				_nmd_append_number(&si, (instruction->immediate & 0xFF00) >> 8);
+			}
+		}
+		else if (op == 0x79)
+		{
+			if (!instruction->simd_prefix)
+			{
+				_nmd_append_string(&si, "vmwrite ");
+				_nmd_append_Gy(&si);
+				*si.buffer++ = ',';
+				_nmd_append_Ey(&si);
+			}
+			else
+			{
+				_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "extrq " : "insertq ");
+				_nmd_append_Vdq(&si);
+				*si.buffer++ = ',';
+				_nmd_append_Udq(&si);
+			}
+
+		}
+		else if (op == 0x7c || op == 0x7d)
+		{
+			_nmd_append_string(&si, op == 0x7c ? "haddp" : "hsubp");
+			*si.buffer++ = instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? 'd' : 's';
+			*si.buffer++ = ' ';
+			_nmd_append_Vdq(&si);
+			*si.buffer++ = ',';
+			_nmd_append_W(&si);
+		}
+		else if (op == 0x7e)
+		{
+			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "movq " : "movd ");
+			if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT)
+			{
+				_nmd_append_Vdq(&si);
+				*si.buffer++ = ',';
+				if (si.instruction->modrm.fields.mod == 0b11)
+					_nmd_append_Udq(&si);
+				else
+					_nmd_append_modrm_upper(&si, "qword");
+			}
+			else
+			{
+				if (si.instruction->modrm.fields.mod == 0b11)
+					_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.rm]);
+				else
+					_nmd_append_modrm_upper(&si, "dword");
+				*si.buffer++ = ',';
+				if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
+					_nmd_append_Vdq(&si);
+				else
+					_nmd_append_Pq(&si);
+			}
+		}
+		else if (op == 0x7f)
+		{
+			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "movdqu" : (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "movdqa" : "movq"));
+			*si.buffer++ = ' ';
+			if (instruction->prefixes & (NMD_X86_PREFIXES_REPEAT | NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE))
+			{
+				_nmd_append_W(&si);
+				*si.buffer++ = ',';
+				_nmd_append_Vdq(&si);
+			}
+			else
+			{
+				if (si.instruction->modrm.fields.mod == 0b11)
+					_nmd_append_Nq(&si);
+				else
+					_nmd_append_modrm_upper(&si, "qword");
+				*si.buffer++ = ',';
+				_nmd_append_Pq(&si);
+			}
+		}		
+		else if (_NMD_R(op) == 9)
+		{
+			_nmd_append_string(&si, "set");
+			_nmd_append_string(&si, _nmd_condition_suffixes[_NMD_C(op)]);
+			*si.buffer++ = ' ';
+			_nmd_append_Eb(&si);
+		}
+		else if ((_NMD_R(op) == 0xA || _NMD_R(op) == 0xB) && op % 8 == 3)
+		{
+			_nmd_append_string(&si, op == 0xa3 ? "bt" : (op == 0xb3 ? "btr" : (op == 0xab ? "bts" : "btc")));
+			*si.buffer++ = ' ';
+			_nmd_append_Ev(&si);
+			*si.buffer++ = ',';
+			_nmd_append_Gv(&si);
+		}
+		else if (_NMD_R(op) == 0xA && (op % 8 == 4 || op % 8 == 5))
+		{
+			_nmd_append_string(&si, op > 0xA8 ? "shrd" : "shld");
+			*si.buffer++ = ' ';
+			_nmd_append_Ev(&si);
+			*si.buffer++ = ',';
+			_nmd_append_Gv(&si);
+			*si.buffer++ = ',';
+			if (op % 8 == 4)
+				_nmd_append_number(&si, instruction->immediate);
+			else
+				_nmd_append_string(&si, "cl");
+		}
+		else if (op == 0xb4 || op == 0xb5)
+		{
+			_nmd_append_string(&si, op == 0xb4 ? "lfs " : "lgs ");
+			_nmd_append_Gv(&si);
+			*si.buffer++ = ',';
+			_nmd_append_modrm_upper(&si, "fword");
+		}
+		else if (op == 0xbc || op == 0xbd)
+		{
+			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? (op == 0xbc ? "tzcnt" : "lzcnt") : (op == 0xbc ? "bsf" : "bsr"));
+			*si.buffer++ = ' ';
+			_nmd_append_Gv(&si);
+			*si.buffer++ = ',';
+			_nmd_append_Ev(&si);
+		}
+		else if (op == 0xa6)
+		{
+			const char* mnemonics[] = { "montmul", "xsha1", "xsha256" };
+			_nmd_append_string(&si, mnemonics[instruction->modrm.fields.reg]);
+		}
+		else if (op == 0xa7)
+		{
+			const char* mnemonics[] = { "xstorerng", "xcryptecb", "xcryptcbc", "xcryptctr", "xcryptcfb", "xcryptofb" };
+			_nmd_append_string(&si, mnemonics[instruction->modrm.fields.reg]);
+		}
+		else if (op == 0xae)
+		{
+			if (instruction->modrm.fields.mod == 0b11)
+			{
+				if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
+					_nmd_append_string(&si, "pcommit");
+				else if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT)
+				{
+					_nmd_append_string(&si, "incsspd ");
+					_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.rm]);
+				}
 				else
-					_nmd_append_modrm_upper(&si, "qword");
+				{
+					const char* mnemonics[] = { "rdfsbase", "rdgsbase", "wrfsbase", "wrgsbase", 0, "lfence", "mfence", "sfence" };
+					_nmd_append_string(&si, mnemonics[instruction->modrm.fields.reg]);
+				}
 			}
 			else
 			{
-				const char* no_prefix_mnemonics[] = { "movmskps", "sqrtps", "rsqrtps", "rcpps", "andps", "andnps", "orps", "xorps", "addps", "mulps", "cvtps2pd",  "cvtdq2ps", "subps", "minps", "divps", "maxps" };
-
-				_nmd_append_string(&si, no_prefix_mnemonics[op % 0x10]);
-				*si.buffer++ = ' ';
-				if (op == 0x50)
+				if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
 				{
-					_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.reg]);
-					*si.buffer++ = ',';
-					_nmd_append_Udq(&si);
+					_nmd_append_string(&si, instruction->modrm.fields.reg == 0b110 ? "clwb " : "clflushopt ");
+					_nmd_append_modrm_upper(&si, "byte");
+				}
+				else if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT)
+				{
+					_nmd_append_string(&si, instruction->modrm.fields.reg == 0b100 ? "ptwrite " : "clrssbsy ");
+					_nmd_append_modrm_upper(&si, instruction->modrm.fields.reg == 0b100 ? "dword" : "qword");
 				}
 				else
 				{
-					_nmd_append_Vdq(&si);
-					*si.buffer++ = ',';
-					if (si.instruction->modrm.fields.mod == 0b11)
-						_nmd_append_string(&si, "xmm"), * si.buffer++ = (char)('0' + si.instruction->modrm.fields.rm);
-					else
-						_nmd_append_modrm_upper(&si, op == 0x5a ? "qword" : "xmmword");
+					const char* mnemonics[] = { "fxsave", "fxrstor", "ldmxcsr", "stmxcsr", "xsave", "xrstor", "xsaveopt", "clflush" };
+					_nmd_append_string(&si, mnemonics[instruction->modrm.fields.reg]);
+					*si.buffer++ = ' ';
+					_nmd_append_modrm_upper(&si, "dword");
 				}
 			}
-		}		
-		else if (op == 0x70)
+		}
+		else if (op == 0xaf)
 		{
-			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "pshufd" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "pshufhw" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO ? "pshuflw" : "pshufw")));
-			*si.buffer++ = ' ';
-			if (!(instruction->prefixes & (NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE | NMD_X86_PREFIXES_REPEAT | NMD_X86_PREFIXES_REPEAT_NOT_ZERO)))
+			_nmd_append_string(&si, "imul ");
+			_nmd_append_Gv(&si);
+			*si.buffer++ = ',';
+			_nmd_append_Ev(&si);
+		}
+		else if (op == 0xb0 || op == 0xb1)
+		{
+			_nmd_append_string(&si, "cmpxchg ");
+			if (op == 0xb0)
 			{
-				_nmd_append_Pq(&si);
+				_nmd_append_Eb(&si);
 				*si.buffer++ = ',';
-				_nmd_append_Qq(&si);
+				_nmd_append_Gb(&si);
 			}
 			else
 			{
-				_nmd_append_Vdq(&si);
+				_nmd_append_Ev(&si);
 				*si.buffer++ = ',';
-				_nmd_append_W(&si);
+				_nmd_append_Gv(&si);
 			}
-
+		}
+		else if (op == 0xb2)
+		{
+			_nmd_append_string(&si, "lss ");
+			_nmd_append_Gv(&si);
+			*si.buffer++ = ',';
+			_nmd_append_modrm_upper(&si, "fword");
+		}
+		else if (_NMD_R(op) == 0xb && (op % 8) >= 6)
+		{
+			_nmd_append_string(&si, op > 0xb8 ? "movsx " : "movzx ");
+			_nmd_append_Gv(&si);
+			*si.buffer++ = ',';
+			if ((op % 8) == 6)
+				_nmd_append_Eb(&si);
+			else
+				_nmd_append_Ew(&si);
+		}
+		else if (op == 0xb8)
+		{
+			_nmd_append_string(&si, "popcnt ");
+			_nmd_append_Gv(&si);
+			*si.buffer++ = ',';
+			_nmd_append_Ev(&si);
+		}
+		else if (op == 0xba)
+		{
+			const char* mnemonics[] = { "bt","bts","btr","btc" };
+			_nmd_append_string(&si, mnemonics[instruction->modrm.fields.reg - 4]);
+			*si.buffer++ = ' ';
+			_nmd_append_Ev(&si);
 			*si.buffer++ = ',';
 			_nmd_append_number(&si, instruction->immediate);
 		}
-		else if (op >= 0x71 && op <= 0x73)
+		else if (op == 0xc0 || op == 0xc1)
 		{
-			if (instruction->modrm.fields.reg % 2 == 1)
-				_nmd_append_string(&si, instruction->modrm.fields.reg == 0b111 ? "pslldq" : "psrldq");
+			_nmd_append_string(&si, "xadd ");
+			if (op == 0xc0)
+			{
+				_nmd_append_Eb(&si);
+				*si.buffer++ = ',';
+				_nmd_append_Gb(&si);
+			}
 			else
 			{
-				const char* mnemonics[] = { "psrl", "psra", "psll" };
-				_nmd_append_string(&si, mnemonics[(instruction->modrm.fields.reg >> 1) - 1]);
-				*si.buffer++ = op == 0x71 ? 'w' : (op == 0x72 ? 'd' : 'q');
+				_nmd_append_Ev(&si);
+				*si.buffer++ = ',';
+				_nmd_append_Gv(&si);
 			}
-
+		}
+		else if (op == 0xc2)
+		{
+			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "cmppd" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "cmpss" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO ? "cmpsd" : "cmpps")));
 			*si.buffer++ = ' ';
+			_nmd_append_Vdq(&si);
+			*si.buffer++ = ',';
+			if (si.instruction->modrm.fields.mod == 0b11)
+				_nmd_append_Udq(&si);
+			else
+				_nmd_append_modrm_upper(&si, instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "dword" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO ? "qword" : "xmmword"));
+			*si.buffer++ = ',';
+			_nmd_append_number(&si, instruction->immediate);
+		}
+		else if (op == 0xc3)
+		{
+			_nmd_append_string(&si, "movnti ");
+			_nmd_append_modrm_upper(&si, "dword");
+			*si.buffer++ = ',';
+			_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.reg]);
+		}
+		else if (op == 0xc4)
+		{
+			_nmd_append_string(&si, "pinsrw ");
+			if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
+				_nmd_append_Vdq(&si);
+			else
+				_nmd_append_Pq(&si);
+			*si.buffer++ = ',';
+			if (si.instruction->modrm.fields.mod == 0b11)
+				_nmd_append_string(&si, _nmd_reg32[si.instruction->modrm.fields.rm]);
+			else
+				_nmd_append_modrm_upper(&si, "word");
+			*si.buffer++ = ',';
+			_nmd_append_number(&si, instruction->immediate);
+		}
+		else if (op == 0xc5)
+		{
+			_nmd_append_string(&si, "pextrw ");
+			_nmd_append_string(&si, _nmd_reg32[si.instruction->modrm.fields.reg]);
+			*si.buffer++ = ',';
 			if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
 				_nmd_append_Udq(&si);
 			else
@@ -9857,904 +12849,2036 @@ NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, cha
 			*si.buffer++ = ',';
 			_nmd_append_number(&si, instruction->immediate);
 		}
-		else if (op == 0x78)
+		else if (op == 0xc6)
 		{
-			if (!instruction->simd_prefix)
+			_nmd_append_string(&si, "shufp");
+			*si.buffer++ = instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? 'd' : 's';
+			*si.buffer++ = ' ';
+			_nmd_append_Vdq(&si);
+			*si.buffer++ = ',';
+			_nmd_append_W(&si);
+			*si.buffer++ = ',';
+			_nmd_append_number(&si, instruction->immediate);
+		}
+		else if (op == 0xC7)
+		{
+			if (instruction->modrm.fields.reg == 0b001)
+			{
+				_nmd_append_string(&si, "cmpxchg8b ");
+				_nmd_append_modrm_upper(&si, "qword");
+			}
+			else if (instruction->modrm.fields.reg <= 0b101)
+			{
+				const char* mnemonics[] = { "xrstors", "xsavec", "xsaves" };
+				_nmd_append_string(&si, mnemonics[instruction->modrm.fields.reg - 3]);
+				*si.buffer++ = ' ';
+				_nmd_append_Eb(&si);
+			}
+			else if (instruction->modrm.fields.reg == 0b110)
+			{
+				if (instruction->modrm.fields.mod == 0b11)
+				{
+					_nmd_append_string(&si, "rdrand ");
+					_nmd_append_Rv(&si);
+				}
+				else
+				{
+					_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "vmclear" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "vmxon" : "vmptrld"));
+					*si.buffer++ = ' ';
+					_nmd_append_modrm_upper(&si, "qword");
+				}
+			}
+			else /* reg == 0b111 */
+			{
+				if (instruction->modrm.fields.mod == 0b11)
+				{
+					_nmd_append_string(&si, "rdseed ");
+					_nmd_append_Rv(&si);
+				}
+				else
+				{
+					_nmd_append_string(&si, "vmptrst ");
+					_nmd_append_modrm_upper(&si, "qword");
+				}
+			}
+		}
+		else if (op >= 0xc8 && op <= 0xcf)
+		{
+			_nmd_append_string(&si, "bswap ");
+			_nmd_append_string(&si, (opszprfx ? _nmd_reg16 : _nmd_reg32)[op % 8]);
+		}
+		else if (op == 0xd0)
+		{
+			_nmd_append_string(&si, "addsubp");
+			*si.buffer++ = instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? 'd' : 's';
+			*si.buffer++ = ' ';
+			_nmd_append_Vdq(&si);
+			*si.buffer++ = ',';
+			_nmd_append_W(&si);
+		}
+		else if (op == 0xd6)
+		{
+			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "movq" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "movq2dq" : "movdq2q"));
+			*si.buffer++ = ' ';
+			if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT)
+			{
+				_nmd_append_Vdq(&si);
+				*si.buffer++ = ',';
+				_nmd_append_Nq(&si);
+			}
+			else if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO)
 			{
-				_nmd_append_string(&si, "vmread ");
-				_nmd_append_Ey(&si);
+				_nmd_append_Pq(&si);
 				*si.buffer++ = ',';
-				_nmd_append_Gy(&si);
+				_nmd_append_Udq(&si);
 			}
 			else
 			{
-				if(instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
-					_nmd_append_string(&si, "extrq ");
+				if (si.instruction->modrm.fields.mod == 0b11)
+					_nmd_append_Udq(&si);
 				else
-				{ 
-					_nmd_append_string(&si, "insertq ");
-					_nmd_append_Vdq(&si);
-					*si.buffer++ = ',';
-				}
-				_nmd_append_Udq(&si);
-				*si.buffer++ = ',';
-				_nmd_append_number(&si, instruction->immediate & 0x00FF);
+					_nmd_append_modrm_upper(&si, "qword");
 				*si.buffer++ = ',';
-				_nmd_append_number(&si, (instruction->immediate & 0xFF00) >> 8);
+				_nmd_append_Vdq(&si);
 			}
 		}
-		else if (op == 0x79)
+		else if (op == 0xd7)
 		{
-			if (!instruction->simd_prefix)
-			{
-				_nmd_append_string(&si, "vmwrite ");
-				_nmd_append_Gy(&si);
-				*si.buffer++ = ',';
-				_nmd_append_Ey(&si);
-			}
+			_nmd_append_string(&si, "pmovmskb ");
+			_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.reg]);
+			*si.buffer++ = ',';
+			if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
+				_nmd_append_Udq(&si);
 			else
-			{
-				_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "extrq " : "insertq ");
-				_nmd_append_Vdq(&si);
-				*si.buffer++ = ',';
+				_nmd_append_Nq(&si);
+		}
+		else if (op == 0xe6)
+		{
+			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "cvttpd2dq" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "cvtdq2pd" : "cvtpd2dq"));
+			*si.buffer++ = ' ';
+			_nmd_append_Vdq(&si);
+			*si.buffer++ = ',';
+			if (si.instruction->modrm.fields.mod == 0b11)
 				_nmd_append_Udq(&si);
-			}
-
+			else
+				_nmd_append_modrm_upper(&si, instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "qword" : "xmmword");
 		}
-		else if (op == 0x7c || op == 0x7d)
+		else if (op == 0xe7)
 		{
-			_nmd_append_string(&si, op == 0x7c ? "haddp" : "hsubp");
-			*si.buffer++ = instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? 'd' : 's';
+			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "movntdq" : "movntq");
 			*si.buffer++ = ' ';
+			_nmd_append_modrm_upper(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "xmmword" : "qword");
+			*si.buffer++ = ',';
+			if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
+				_nmd_append_Vdq(&si);
+			else
+				_nmd_append_Pq(&si);
+		}
+		else if (op == 0xf0)
+		{
+			_nmd_append_string(&si, "lddqu ");
 			_nmd_append_Vdq(&si);
 			*si.buffer++ = ',';
-			_nmd_append_W(&si);
+			_nmd_append_modrm_upper(&si, "xmmword");
 		}
-		else if (op == 0x7e)
+		else if (op == 0xf7)
 		{
-			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "movq " : "movd ");
-			if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT)
+			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "maskmovdqu " : "maskmovq ");
+			if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
 			{
 				_nmd_append_Vdq(&si);
 				*si.buffer++ = ',';
-				if (si.instruction->modrm.fields.mod == 0b11)
-					_nmd_append_Udq(&si);
-				else
-					_nmd_append_modrm_upper(&si, "qword");
+				_nmd_append_Udq(&si);
 			}
 			else
 			{
-				if (si.instruction->modrm.fields.mod == 0b11)
-					_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.rm]);
-				else
-					_nmd_append_modrm_upper(&si, "dword");
+				_nmd_append_Pq(&si);
 				*si.buffer++ = ',';
-				if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
-					_nmd_append_Vdq(&si);
-				else
-					_nmd_append_Pq(&si);
+				_nmd_append_Nq(&si);
 			}
 		}
-		else if (op == 0x7f)
+		else if (op >= 0xd1 && op <= 0xfe)
 		{
-			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "movdqu" : (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "movdqa" : "movq"));
+			const char* mnemonics[] = { "srlw", "srld", "srlq", "addq", "mullw", 0, 0, "subusb", "subusw", "minub", "and", "addusb", "addusw", "maxub", "andn", "avgb", "sraw", "srad", "avgw", "mulhuw", "mulhw", 0, 0, "subsb", "subsw", "minsw", "or", "addsb", "addsw", "maxsw", "xor", 0, "sllw", "slld", "sllq", "muludq", "maddwd", "sadbw", 0, "subb", "subw", "subd", "subq", "addb", "addw", "addd" };
+			*si.buffer++ = 'p';
+			_nmd_append_string(&si, mnemonics[op - 0xd1]);
 			*si.buffer++ = ' ';
-			if (instruction->prefixes & (NMD_X86_PREFIXES_REPEAT | NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE))
+			if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
 			{
-				_nmd_append_W(&si);
-				*si.buffer++ = ',';
 				_nmd_append_Vdq(&si);
+				*si.buffer++ = ',';
+				_nmd_append_W(&si);
 			}
 			else
 			{
-				if (si.instruction->modrm.fields.mod == 0b11)
-					_nmd_append_Nq(&si);
-				else
-					_nmd_append_modrm_upper(&si, "qword");
-				*si.buffer++ = ',';
 				_nmd_append_Pq(&si);
+				*si.buffer++ = ',';
+				_nmd_append_Qq(&si);
 			}
-		}		
-		else if (_NMD_R(op) == 9)
-		{
-			_nmd_append_string(&si, "set");
-			_nmd_append_string(&si, _nmd_condition_suffixes[_NMD_C(op)]);
-			*si.buffer++ = ' ';
-			_nmd_append_Eb(&si);
 		}
-		else if ((_NMD_R(op) == 0xA || _NMD_R(op) == 0xB) && op % 8 == 3)
+		else if (op == 0xb9 || op == 0xff)
 		{
-			_nmd_append_string(&si, op == 0xa3 ? "bt" : (op == 0xb3 ? "btr" : (op == 0xab ? "bts" : "btc")));
-			*si.buffer++ = ' ';
-			_nmd_append_Ev(&si);
+			_nmd_append_string(&si, op == 0xb9 ? "ud1 " : "ud0 ");
+			_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.reg]);
 			*si.buffer++ = ',';
-			_nmd_append_Gv(&si);
+			if (instruction->modrm.fields.mod == 0b11)
+				_nmd_append_string(&si, (instruction->mode == NMD_X86_MODE_64 ? _nmd_reg64 : _nmd_reg32)[instruction->modrm.fields.rm]);
+			else
+				_nmd_append_modrm_upper(&si, "dword");
 		}
-		else if (_NMD_R(op) == 0xA && (op % 8 == 4 || op % 8 == 5))
+		else
 		{
-			_nmd_append_string(&si, op > 0xA8 ? "shrd" : "shld");
+			const char* str = 0;
+			switch (op)
+			{
+			case 0x31: str = "rdtsc"; break;
+			case 0x07: str = "sysret"; break;
+			case 0x06: str = "clts"; break;
+			case 0x08: str = "invd"; break;
+			case 0x09: str = "wbinvd"; break;
+			case 0x0b: str = "ud2"; break;
+			case 0x0e: str = "femms"; break;
+			case 0x30: str = "wrmsr"; break;
+			case 0x32: str = "rdmsr"; break;
+			case 0x33: str = "rdpmc"; break;
+			case 0x34: str = "sysenter"; break;
+			case 0x35: str = "sysexit"; break;
+			case 0x37: str = "getsec"; break;
+			case 0x77: str = "emms"; break;
+			case 0xa0: str = "push fs"; break;
+			case 0xa1: str = "pop fs"; break;
+			case 0xa8: str = "push gs"; break;
+			case 0xa9: str = "pop gs"; break;
+			case 0xaa: str = "rsm"; break;
+			default: buffer[0] = '\0'; return 0;
+			}
+			_nmd_append_string(&si, str);
+		}
+	}
+	else if (instruction->opcode_map == NMD_X86_OPCODE_MAP_0F38)
+	{
+		if ((_NMD_R(op) == 2 || _NMD_R(op) == 3) && _NMD_C(op) <= 5)
+		{
+			const char* mnemonics[] = { "pmovsxbw", "pmovsxbd", "pmovsxbq", "pmovsxwd", "pmovsxwq", "pmovsxdq" };
+			_nmd_append_string(&si, mnemonics[_NMD_C(op)]);
+			if (_NMD_R(op) == 3)
+				*(si.buffer - 4) = 'z';
 			*si.buffer++ = ' ';
-			_nmd_append_Ev(&si);
-			*si.buffer++ = ',';
-			_nmd_append_Gv(&si);
+			_nmd_append_Vdq(&si);
 			*si.buffer++ = ',';
-			if (op % 8 == 4)
-				_nmd_append_number(&si, instruction->immediate);
+			if (instruction->modrm.fields.mod == 0b11)
+				_nmd_append_Udq(&si);
 			else
-				_nmd_append_string(&si, "cl");
+				_nmd_append_modrm_upper(&si, _NMD_C(op) == 5 ? "qword" : (_NMD_C(op) % 3 == 0 ? "qword" : (_NMD_C(op) % 3 == 1 ? "dword" : "word")));
 		}
-		else if (op == 0xb4 || op == 0xb5)
+		else if (op >= 0x80 && op <= 0x83)
 		{
-			_nmd_append_string(&si, op == 0xb4 ? "lfs " : "lgs ");
-			_nmd_append_Gv(&si);
+			_nmd_append_string(&si, op == 0x80 ? "invept" : (op == 0x81 ? "invvpid" : "invpcid"));
+			*si.buffer++ = ' ';
+			_nmd_append_Gy(&si);
 			*si.buffer++ = ',';
-			_nmd_append_modrm_upper(&si, "fword");
+			_nmd_append_modrm_upper(&si, "xmmword");
 		}
-		else if (op == 0xbc || op == 0xbd)
+		else if (op >= 0xc8 && op <= 0xcd)
 		{
-			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? (op == 0xbc ? "tzcnt" : "lzcnt") : (op == 0xbc ? "bsf" : "bsr"));
+			const char* mnemonics[] = { "sha1nexte", "sha1msg1", "sha1msg2", "sha256rnds2", "sha256msg1", "sha256msg2" };
+			_nmd_append_string(&si, mnemonics[op - 0xc8]);
 			*si.buffer++ = ' ';
-			_nmd_append_Gv(&si);
+			_nmd_append_Vdq(&si);
 			*si.buffer++ = ',';
-			_nmd_append_Ev(&si);
-		}
-		else if (op == 0xa6)
-		{
-			const char* mnemonics[] = { "montmul", "xsha1", "xsha256" };
-			_nmd_append_string(&si, mnemonics[instruction->modrm.fields.reg]);
+			_nmd_append_W(&si);
 		}
-		else if (op == 0xa7)
+		else if (op == 0xcf)
 		{
-			const char* mnemonics[] = { "xstorerng", "xcryptecb", "xcryptcbc", "xcryptctr", "xcryptcfb", "xcryptofb" };
-			_nmd_append_string(&si, mnemonics[instruction->modrm.fields.reg]);
+			_nmd_append_string(&si, "gf2p8mulb ");
+			_nmd_append_Vdq(&si);
+			*si.buffer++ = ',';
+			_nmd_append_W(&si);
 		}
-		else if (op == 0xae)
+		else if (op == 0xf0 || op == 0xf1)
 		{
-			if (instruction->modrm.fields.mod == 0b11)
+			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO ? "crc32" : "movbe");
+			*si.buffer++ = ' ';
+			if (op == 0xf0)
 			{
-				if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
-					_nmd_append_string(&si, "pcommit");
-				else if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT)
+				if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO)
 				{
-					_nmd_append_string(&si, "incsspd ");
-					_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.rm]);
+					_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.reg]);
+					*si.buffer++ = ',';
+					_nmd_append_Eb(&si);
 				}
 				else
 				{
-					const char* mnemonics[] = { "rdfsbase", "rdgsbase", "wrfsbase", "wrgsbase", 0, "lfence", "mfence", "sfence" };
-					_nmd_append_string(&si, mnemonics[instruction->modrm.fields.reg]);
+					_nmd_append_Gv(&si);
+					*si.buffer++ = ',';
+					_nmd_append_Ev(&si);
 				}
 			}
 			else
 			{
-				if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
-				{
-					_nmd_append_string(&si, instruction->modrm.fields.reg == 0b110 ? "clwb " : "clflushopt ");
-					_nmd_append_modrm_upper(&si, "byte");
-				}
-				else if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT)
+				if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO)
 				{
-					_nmd_append_string(&si, instruction->modrm.fields.reg == 0b100 ? "ptwrite " : "clrssbsy ");
-					_nmd_append_modrm_upper(&si, instruction->modrm.fields.reg == 0b100 ? "dword" : "qword");
+					_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.reg]);
+					*si.buffer++ = ',';
+					if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
+						_nmd_append_Ew(&si);
+					else
+						_nmd_append_Ey(&si);
 				}
 				else
 				{
-					const char* mnemonics[] = { "fxsave", "fxrstor", "ldmxcsr", "stmxcsr", "xsave", "xrstor", "xsaveopt", "clflush" };
-					_nmd_append_string(&si, mnemonics[instruction->modrm.fields.reg]);
-					*si.buffer++ = ' ';
-					_nmd_append_modrm_upper(&si, "dword");
+					_nmd_append_Ev(&si);
+					*si.buffer++ = ',';
+					_nmd_append_Gv(&si);
 				}
 			}
 		}
-		else if (op == 0xaf)
-		{
-			_nmd_append_string(&si, "imul ");
-			_nmd_append_Gv(&si);
-			*si.buffer++ = ',';
-			_nmd_append_Ev(&si);
-		}
-		else if (op == 0xb0 || op == 0xb1)
+		else if (op == 0xf6)
 		{
-			_nmd_append_string(&si, "cmpxchg ");
-			if (op == 0xb0)
+			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "adcx" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "adox" : (instruction->rex_w_prefix ? "wrssq" : "wrssd")));
+			*si.buffer++ = ' ';
+			if (!instruction->simd_prefix)
 			{
-				_nmd_append_Eb(&si);
+				_nmd_append_Ey(&si);
 				*si.buffer++ = ',';
-				_nmd_append_Gb(&si);
+				_nmd_append_Gy(&si);
 			}
 			else
 			{
-				_nmd_append_Ev(&si);
+				_nmd_append_Gy(&si);
 				*si.buffer++ = ',';
-				_nmd_append_Gv(&si);
+				_nmd_append_Ey(&si);
 			}
 		}
-		else if (op == 0xb2)
-		{
-			_nmd_append_string(&si, "lss ");
-			_nmd_append_Gv(&si);
-			*si.buffer++ = ',';
-			_nmd_append_modrm_upper(&si, "fword");
-		}
-		else if (_NMD_R(op) == 0xb && (op % 8) >= 6)
+		else if (op == 0xf5)
 		{
-			_nmd_append_string(&si, op > 0xb8 ? "movsx " : "movzx ");
-			_nmd_append_Gv(&si);
+			_nmd_append_string(&si, instruction->rex_w_prefix ? "wrussq " : "wrussd ");
+			_nmd_append_modrm_upper(&si, instruction->rex_w_prefix ? "qword" : "dword");
 			*si.buffer++ = ',';
-			if ((op % 8) == 6)
-				_nmd_append_Eb(&si);
-			else
-				_nmd_append_Ew(&si);
+			_nmd_append_string(&si, (instruction->rex_w_prefix ? _nmd_reg64 : _nmd_reg32)[instruction->modrm.fields.reg]);
 		}
-		else if (op == 0xb8)
+		else if (op == 0xf8)
 		{
-			_nmd_append_string(&si, "popcnt ");
-			_nmd_append_Gv(&si);
+			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "movdir64b" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "enqcmd" : "enqcmds"));
+			*si.buffer++ = ' ';
+			_nmd_append_string(&si, (instruction->mode == NMD_X86_MODE_64 ? _nmd_reg64 : (instruction->mode == NMD_X86_MODE_16 ? _nmd_reg16 : _nmd_reg32))[instruction->modrm.fields.rm]);
 			*si.buffer++ = ',';
-			_nmd_append_Ev(&si);
+			_nmd_append_modrm_upper(&si, "zmmword");
 		}
-		else if (op == 0xba)
+		else if (op == 0xf9)
 		{
-			const char* mnemonics[] = { "bt","bts","btr","btc" };
-			_nmd_append_string(&si, mnemonics[instruction->modrm.fields.reg - 4]);
-			*si.buffer++ = ' ';
-			_nmd_append_Ev(&si);
+			_nmd_append_string(&si, "movdiri ");
+			_nmd_append_modrm_upper_without_address_specifier(&si);
 			*si.buffer++ = ',';
-			_nmd_append_number(&si, instruction->immediate);
+			_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.rm]);
 		}
-		else if (op == 0xc0 || op == 0xc1)
+		else
 		{
-			_nmd_append_string(&si, "xadd ");
-			if (op == 0xc0)
+			if (op == 0x40)
+				_nmd_append_string(&si, "pmulld");
+			else if (op == 0x41)
+				_nmd_append_string(&si, "phminposuw");
+			else if (op >= 0xdb && op <= 0xdf)
 			{
-				_nmd_append_Eb(&si);
-				*si.buffer++ = ',';
-				_nmd_append_Gb(&si);
+				const char* mnemonics[] = { "aesimc", "aesenc", "aesenclast", "aesdec", "aesdeclast" };
+				_nmd_append_string(&si, mnemonics[op - 0xdb]);
+			}
+			else if (op == 0x37)
+				_nmd_append_string(&si, "pcmpgtq");
+			else if (_NMD_R(op) == 2)
+			{
+				const char* mnemonics[] = { "pmuldq", "pcmpeqq", "movntdqa", "packusdw" };
+				_nmd_append_string(&si, mnemonics[_NMD_C(op) - 8]);
+			}
+			else if (_NMD_R(op) == 3)
+			{
+				const char* mnemonics[] = { "pminsb", "pminsd", "pminuw", "pminud", "pmaxsb", "pmaxsd", "pmaxuw", "pmaxud" };
+				_nmd_append_string(&si, mnemonics[_NMD_C(op) - 8]);
+			}
+			else if (op < 0x10)
+			{
+				const char* mnemonics[] = { "pshufb", "phaddw", "phaddd", "phaddsw", "pmaddubsw", "phsubw", "phsubd", "phsubsw", "psignb", "psignw", "psignd", "pmulhrsw", "permilpsv", "permilpdv", "testpsv", "testpdv" };
+				_nmd_append_string(&si, mnemonics[op]);
 			}
+			else if (op < 0x18)
+				_nmd_append_string(&si, op == 0x10 ? "pblendvb" : (op == 0x14 ? "blendvps" : (op == 0x15 ? "blendvpd" : "ptest")));
 			else
 			{
-				_nmd_append_Ev(&si);
-				*si.buffer++ = ',';
-				_nmd_append_Gv(&si);
+				_nmd_append_string(&si, "pabs");
+				*si.buffer++ = op == 0x1c ? 'b' : (op == 0x1d ? 'w' : 'd');
 			}
-		}
-		else if (op == 0xc2)
-		{
-			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "cmppd" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "cmpss" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO ? "cmpsd" : "cmpps")));
 			*si.buffer++ = ' ';
-			_nmd_append_Vdq(&si);
-			*si.buffer++ = ',';
-			if (si.instruction->modrm.fields.mod == 0b11)
-				_nmd_append_Udq(&si);
-			else
-				_nmd_append_modrm_upper(&si, instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "dword" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO ? "qword" : "xmmword"));
-			*si.buffer++ = ',';
-			_nmd_append_number(&si, instruction->immediate);
-		}
-		else if (op == 0xc3)
-		{
-			_nmd_append_string(&si, "movnti ");
-			_nmd_append_modrm_upper(&si, "dword");
-			*si.buffer++ = ',';
-			_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.reg]);
-		}
-		else if (op == 0xc4)
-		{
-			_nmd_append_string(&si, "pinsrw ");
 			if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
+			{
 				_nmd_append_Vdq(&si);
+				*si.buffer++ = ',';
+				_nmd_append_W(&si);
+			}
 			else
+			{
 				_nmd_append_Pq(&si);
-			*si.buffer++ = ',';
-			if (si.instruction->modrm.fields.mod == 0b11)
-				_nmd_append_string(&si, _nmd_reg32[si.instruction->modrm.fields.rm]);
-			else
-				_nmd_append_modrm_upper(&si, "word");
-			*si.buffer++ = ',';
-			_nmd_append_number(&si, instruction->immediate);
+				*si.buffer++ = ',';
+				_nmd_append_Qq(&si);
+			}
 		}
-		else if (op == 0xc5)
+
+	}
+	else if (instruction->opcode_map == NMD_X86_OPCODE_MAP_0F3A)
+	{
+		if (_NMD_R(op) == 1)
 		{
-			_nmd_append_string(&si, "pextrw ");
-			_nmd_append_string(&si, _nmd_reg32[si.instruction->modrm.fields.reg]);
-			*si.buffer++ = ',';
-			if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
-				_nmd_append_Udq(&si);
+			const char* mnemonics[] = { "pextrb", "pextrw", "pextrd", "extractps" };
+			_nmd_append_string(&si, mnemonics[op - 0x14]);
+			*si.buffer++ = ' ';
+			if (instruction->modrm.fields.mod == 0b11)
+				_nmd_append_string(&si, (si.instruction->rex_w_prefix ? _nmd_reg64 : _nmd_reg32)[instruction->modrm.fields.rm]);
 			else
-				_nmd_append_Nq(&si);
+			{
+				if (op == 0x14)
+					_nmd_append_modrm_upper(&si, "byte");
+				else if (op == 0x15)
+					_nmd_append_modrm_upper(&si, "word");
+				else if (op == 0x16)
+					_nmd_append_Ey(&si);
+				else
+					_nmd_append_modrm_upper(&si, "dword");
+			}
 			*si.buffer++ = ',';
-			_nmd_append_number(&si, instruction->immediate);
+			_nmd_append_Vdq(&si);
 		}
-		else if (op == 0xc6)
+		else if (_NMD_R(op) == 2)
 		{
-			_nmd_append_string(&si, "shufp");
-			*si.buffer++ = instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? 'd' : 's';
+			_nmd_append_string(&si, op == 0x20 ? "pinsrb" : (op == 0x21 ? "insertps" : "pinsrd"));
 			*si.buffer++ = ' ';
 			_nmd_append_Vdq(&si);
 			*si.buffer++ = ',';
-			_nmd_append_W(&si);
-			*si.buffer++ = ',';
-			_nmd_append_number(&si, instruction->immediate);
+			if (op == 0x20)
+			{
+				if (instruction->modrm.fields.mod == 0b11)
+					_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.rm]);
+				else
+					_nmd_append_modrm_upper(&si, "byte");
+			}
+			else if (op == 0x21)
+			{
+				if (instruction->modrm.fields.mod == 0b11)
+					_nmd_append_Udq(&si);
+				else
+					_nmd_append_modrm_upper(&si, "dword");
+			}
+			else
+				_nmd_append_Ey(&si);
 		}
-		else if (op == 0xC7)
+		else
 		{
-			if (instruction->modrm.fields.reg == 0b001)
+			if (op < 0x10)
 			{
-				_nmd_append_string(&si, "cmpxchg8b ");
-				_nmd_append_modrm_upper(&si, "qword");
+				const char* mnemonics[] = { "roundps", "roundpd", "roundss", "roundsd", "blendps", "blendpd", "pblendw", "palignr" };
+				_nmd_append_string(&si, mnemonics[op - 8]);
 			}
-			else if (instruction->modrm.fields.reg <= 0b101)
+			else if (_NMD_R(op) == 4)
 			{
-				const char* mnemonics[] = { "xrstors", "xsavec", "xsaves" };
-				_nmd_append_string(&si, mnemonics[instruction->modrm.fields.reg - 3]);
-				*si.buffer++ = ' ';
-				_nmd_append_Eb(&si);
+				const char* mnemonics[] = { "dpps", "dppd", "mpsadbw", 0, "pclmulqdq" };
+				_nmd_append_string(&si, mnemonics[_NMD_C(op)]);
 			}
-			else if (instruction->modrm.fields.reg == 0b110)
+			else if (_NMD_R(op) == 6)
+			{
+				const char* mnemonics[] = { "pcmpestrm", "pcmpestri", "pcmpistrm", "pcmpistri" };
+				_nmd_append_string(&si, mnemonics[_NMD_C(op)]);
+			}
+			else if (op > 0x80)
+				_nmd_append_string(&si, op == 0xcc ? "sha1rnds4" : (op == 0xce ? "gf2p8affineqb" : (op == 0xcf ? "gf2p8affineinvqb" : "aeskeygenassist")));
+			*si.buffer++ = ' ';
+			if (op == 0xf && !(instruction->prefixes & (NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE | NMD_X86_PREFIXES_REPEAT | NMD_X86_PREFIXES_REPEAT_NOT_ZERO)))
+			{
+				_nmd_append_Pq(&si);
+				*si.buffer++ = ',';
+				_nmd_append_Qq(&si);
+			}
+			else
+			{
+				_nmd_append_Vdq(&si);
+				*si.buffer++ = ',';
+				if (instruction->modrm.fields.mod == 0b11)
+					_nmd_append_string(&si, "xmm"), * si.buffer++ = (char)('0' + instruction->modrm.fields.rm);
+				else
+					_nmd_append_modrm_upper(&si, op == 0xa ? "dword" : (op == 0xb ? "qword" : "xmmword"));
+			}
+		}
+		*si.buffer++ = ',';
+		_nmd_append_number(&si, instruction->immediate);
+	}
+
+#ifndef NMD_ASSEMBLY_DISABLE_FORMATTER_ATT_SYNTAX
+	if (flags & NMD_X86_FORMAT_FLAGS_ATT_SYNTAX)
+	{
+		*si.buffer = '\0';
+		char* operand = (char*)_nmd_reverse_strchr(buffer, ' ');
+		if (operand && *(operand - 1) != ' ') /* If the instruction has a ' '(space character) and the left character of 'operand' is not ' '(space) the instruction has operands. */
+		{
+			/* If there is a memory operand. */
+			const char* memory_operand = _nmd_strchr(buffer, '[');
+			if (memory_operand)
+			{
+				/* If the memory operand has pointer size. */
+				const size_t ptr_offset = *(memory_operand - 1) == ':' ? 7 : 4;
+				char* tmp2 = (char*)memory_operand - ((size_t)(memory_operand - buffer) >= ptr_offset ? ptr_offset : 0);
+				if ((size_t)(memory_operand - buffer) >= ptr_offset && _nmd_strstr(tmp2, "ptr") == tmp2)
+				{
+					/* Find the ' '(space) that is after two ' '(spaces). */
+					tmp2 -= 2;
+					while (*tmp2 != ' ')
+						tmp2--;
+					operand = tmp2;
+				}
+			}
+
+			const char* const first_operand_const = operand;
+			char* first_operand = operand + 1;
+			char* second_operand = 0;
+			/* Convert each operand to AT&T syntax. */
+			do
+			{
+				operand++;
+				operand = _nmd_format_operand_to_att(operand, &si);
+				if (*operand == ',')
+					second_operand = operand;
+			} while (*operand);
+
+			/* Swap operands. */
+			if (second_operand) /* At least two operands. */
 			{
-				if (instruction->modrm.fields.mod == 0b11)
-				{
-					_nmd_append_string(&si, "rdrand ");
-					_nmd_append_Rv(&si);
-				}
-				else
-				{
-					_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "vmclear" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "vmxon" : "vmptrld"));
-					*si.buffer++ = ' ';
-					_nmd_append_modrm_upper(&si, "qword");
-				}
+				/* Copy first operand to 'tmp_buffer'. */
+				char tmp_buffer[64];
+				char* i = tmp_buffer;
+				char* j = first_operand;
+				for (; j < second_operand; i++, j++)
+					*i = *j;
+
+				*i = '\0';
+
+				/* Copy second operand to first operand. */
+				for (i = second_operand + 1; *i; first_operand++, i++)
+					*first_operand = *i;
+
+				*first_operand++ = ',';
+
+				/* 'first_operand' is now the second operand. */
+				/* Copy 'tmp_buffer' to second operand. */
+				for (i = tmp_buffer; *first_operand; i++, first_operand++)
+					*first_operand = *i;
 			}
-			else /* reg == 0b111 */
+
+			/* Memory operands change the mnemonic string(e.g. 'mov eax, dword ptr [ebx]' -> 'movl (%ebx), %eax'). */
+			/* The mnemonic may be shorter than the searched strings(e.g. 'bt'), so the search must not start before the buffer. */
+			if (memory_operand && !_nmd_strstr(first_operand_const - 4 < buffer ? buffer : first_operand_const - 4, "lea"))
 			{
-				if (instruction->modrm.fields.mod == 0b11)
-				{
-					_nmd_append_string(&si, "rdseed ");
-					_nmd_append_Rv(&si);
-				}
-				else
-				{
-					_nmd_append_string(&si, "vmptrst ");
-					_nmd_append_modrm_upper(&si, "qword");
-				}
+				const char* r_char = _nmd_strchr(first_operand_const, 'r');
+				const char* e_char = _nmd_strchr(first_operand_const, 'e');
+				const char* call_str = _nmd_strstr(first_operand_const - 5 < buffer ? buffer : first_operand_const - 5, "call");
+				const char* jmp_str = _nmd_strstr(first_operand_const - 4 < buffer ? buffer : first_operand_const - 4, "jmp");
+				_nmd_insert_char(first_operand_const, (instruction->mode == NMD_X86_MODE_64 && ((r_char && *(r_char - 1) == '%') || call_str || jmp_str)) ? 'q' : (instruction->mode == NMD_X86_MODE_32 && ((e_char && *(e_char - 1) == '%') || call_str || jmp_str) ? 'l' : 'b'));
+				si.buffer++;
 			}
 		}
-		else if (op >= 0xc8 && op <= 0xcf)
-		{
-			_nmd_append_string(&si, "bswap ");
-			_nmd_append_string(&si, (opszprfx ? _nmd_reg16 : _nmd_reg32)[op % 8]);
-		}
-		else if (op == 0xd0)
+	}
+#endif /* NMD_ASSEMBLY_DISABLE_FORMATTER_ATT_SYNTAX */
+
+	size_t string_length = si.buffer - buffer;
+#ifndef NMD_ASSEMBLY_DISABLE_FORMATTER_UPPERCASE
+	if (flags & NMD_X86_FORMAT_FLAGS_UPPERCASE)
+	{
+		size_t i = 0;
+		for (; i < string_length; i++)
 		{
-			_nmd_append_string(&si, "addsubp");
-			*si.buffer++ = instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? 'd' : 's';
-			*si.buffer++ = ' ';
-			_nmd_append_Vdq(&si);
-			*si.buffer++ = ',';
-			_nmd_append_W(&si);
+			if (_NMD_IS_LOWERCASE(buffer[i]))
+				buffer[i] -= 0x20; /* Capitalize letter. */
 		}
-		else if (op == 0xd6)
+	}
+#endif /* NMD_ASSEMBLY_DISABLE_FORMATTER_UPPERCASE */
+
+#ifndef NMD_ASSEMBLY_DISABLE_FORMATTER_COMMA_SPACES
+	if (flags & NMD_X86_FORMAT_FLAGS_COMMA_SPACES)
+	{
+		size_t i = 0;
+		for (; i < string_length; i++)
 		{
-			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "movq" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "movq2dq" : "movdq2q"));
-			*si.buffer++ = ' ';
-			if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT)
-			{
-				_nmd_append_Vdq(&si);
-				*si.buffer++ = ',';
-				_nmd_append_Nq(&si);
-			}
-			else if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO)
-			{
-				_nmd_append_Pq(&si);
-				*si.buffer++ = ',';
-				_nmd_append_Udq(&si);
-			}
-			else
+			if (buffer[i] == ',')
 			{
-				if (si.instruction->modrm.fields.mod == 0b11)
-					_nmd_append_Udq(&si);
-				else
-					_nmd_append_modrm_upper(&si, "qword");
-				*si.buffer++ = ',';
-				_nmd_append_Vdq(&si);
+				/* Move all characters after the comma one position to the right. */
+				size_t j = string_length;
+				for (; j > i; j--)
+					buffer[j] = buffer[j - 1];
+
+				buffer[i + 1] = ' ';
+				si.buffer++, string_length++;
 			}
 		}
-		else if (op == 0xd7)
+	}
+#endif /* NMD_ASSEMBLY_DISABLE_FORMATTER_COMMA_SPACES */
+
+#ifndef NMD_ASSEMBLY_DISABLE_FORMATTER_OPERATOR_SPACES
+	if (flags & NMD_X86_FORMAT_FLAGS_OPERATOR_SPACES)
+	{
+		size_t i = 0;
+		for (; i < string_length; i++)
 		{
-			_nmd_append_string(&si, "pmovmskb ");
-			_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.reg]);
-			*si.buffer++ = ',';
-			if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
-				_nmd_append_Udq(&si);
-			else
-				_nmd_append_Nq(&si);
+			if (buffer[i] == '+' || (buffer[i] == '-' && buffer[i - 1] != ' ' && buffer[i - 1] != '('))
+			{
+				/* Move all characters after the operator two positions to the right. */
+				size_t j = string_length + 1;
+				for (; j > i; j--)
+					buffer[j] = buffer[j - 2];
+
+				buffer[i + 1] = buffer[i];
+				buffer[i] = ' ';
+				buffer[i + 2] = ' ';
+				si.buffer += 2, string_length += 2;
+				i++;
+			}
 		}
-		else if (op == 0xe6)
+	}
+#endif /* NMD_ASSEMBLY_DISABLE_FORMATTER_OPERATOR_SPACES */
+
+	*si.buffer = '\0';
+
+	return string_length;
+}
+
+/*
+Formats an instruction. This function may cause a crash if you modify 'instruction' manually.
+Parameters:
+ - instruction     [in]  A pointer to a variable of type 'nmd_x86_instruction' describing the instruction to be formatted.
+ - buffer          [out] A pointer to buffer that receives the string. It should have at least 'NMD_X86_FORMATTER_MAX_LENGTH' bytes.
+ - runtime_address [in]  The instruction's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - flags           [in]  A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the function should format the instruction. If uncertain, use 'NMD_X86_FORMAT_FLAGS_DEFAULT'.
+*/
+NMD_ASSEMBLY_API void nmd_x86_format(const nmd_x86_instruction* instruction, char* buffer, uint64_t runtime_address, uint32_t flags)
+{
+	_nmd_x86_format(instruction, buffer, runtime_address, flags);
+}
+
+/*
+Formats an instruction. Returns the length of the string(excluding the null character), or zero if the instruction is invalid or 'buffer_size' is too small.
+Parameters:
+ - instruction     [in]  A pointer to a variable of type 'nmd_x86_instruction' describing the instruction to be formatted.
+ - buffer          [out] A pointer to buffer that receives the string.
+ - buffer_size     [in]  The buffer's size in bytes. If it's smaller than 'NMD_X86_FORMATTER_MAX_LENGTH' the string is formatted in a temporary buffer and then copied.
+ - runtime_address [in]  The instruction's runtime address. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - flags           [in]  A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the function should format the instruction. If uncertain, use 'NMD_X86_FORMAT_FLAGS_DEFAULT'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_format_ex(const nmd_x86_instruction* instruction, char* buffer, size_t buffer_size, uint64_t runtime_address, uint32_t flags)
+{
+	char temp[NMD_X86_FORMATTER_MAX_LENGTH];
+	size_t length, i;
+
+	if (buffer_size >= NMD_X86_FORMATTER_MAX_LENGTH)
+		return _nmd_x86_format(instruction, buffer, runtime_address, flags);
+
+	length = _nmd_x86_format(instruction, temp, runtime_address, flags);
+	if (length >= buffer_size)
+	{
+		if (buffer_size)
+			buffer[0] = '\0';
+		return 0;
+	}
+
+	for (i = 0; i <= length; i++)
+		buffer[i] = temp[i];
+
+	return length;
+}
+
+/*
+Formats consecutive instructions into a single buffer, one line per instruction. Lines are separated by the '\n'(new line) character. Returns the number of instructions formatted.
+Parameters:
+ - instructions     [in]      A pointer to an array of 'nmd_x86_instruction', usually filled by nmd_x86_decode_buffer().
+ - num_instructions [in]      The number of instructions in the array.
+ - runtime_address  [in]      The runtime address of the first instruction. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+ - flags            [in]      A mask of 'NMD_X86_FORMAT_FLAGS_XXX'. If 'NMD_X86_FORMAT_FLAGS_ADDRESS' is set, each line starts with the instruction's runtime address.
+ - buffer           [out]     A pointer to a buffer that receives the lines.
+ - buffer_size      [in]      The buffer's size in bytes.
+ - lines            [out/opt] A pointer to an array of 'nmd_x86_text_line' with at least 'num_instructions' elements that receives the position of each line in 'buffer'. This parameter may be null.
+ - text_length      [out/opt] A pointer to a variable that receives the number of characters written to 'buffer'(excluding the null character). This parameter may be null.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_format_buffer(const nmd_x86_instruction* instructions, size_t num_instructions, uint64_t runtime_address, uint32_t flags, char* buffer, size_t buffer_size, nmd_x86_text_line* lines, size_t* text_length)
+{
+	const char* const digits = _nmd_hex_digits[(flags & (NMD_X86_FORMAT_FLAGS_HEX_LOWERCASE | NMD_X86_FORMAT_FLAGS_UPPERCASE)) == NMD_X86_FORMAT_FLAGS_HEX_LOWERCASE ? 1 : 0];
+	const uint32_t format_flags = flags & ~NMD_X86_FORMAT_FLAGS_ADDRESS;
+	size_t i = 0, offset = 0;
+
+	for (; i < num_instructions; i++)
+	{
+		const nmd_x86_instruction* const instruction = instructions + i;
+		size_t line_offset = offset, remaining, length;
+
+		if (!instruction->valid)
+			break;
+
+		if (flags & NMD_X86_FORMAT_FLAGS_ADDRESS && runtime_address != NMD_X86_INVALID_RUNTIME_ADDRESS)
 		{
-			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "cvttpd2dq" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "cvtdq2pd" : "cvtpd2dq"));
-			*si.buffer++ = ' ';
-			_nmd_append_Vdq(&si);
-			*si.buffer++ = ',';
-			if (si.instruction->modrm.fields.mod == 0b11)
-				_nmd_append_Udq(&si);
-			else
-				_nmd_append_modrm_upper(&si, instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "qword" : "xmmword");
+			int shift = instruction->mode * 8 - 4;
+
+			/* The address column has two hex digits per byte of the mode's address size followed by a space. */
+			if (buffer_size - offset <= (size_t)instruction->mode * 2 + 1)
+				break;
+
+			for (; shift >= 0; shift -= 4)
+				buffer[offset++] = digits[(runtime_address >> shift) & 0xf];
+			buffer[offset++] = ' ';
 		}
-		else if (op == 0xe7)
+
+		/* Leave room for the new line character. */
+		remaining = buffer_size - offset;
+		if (remaining < 2 || !(length = nmd_x86_format_ex(instruction, buffer + offset, remaining - 1, runtime_address, format_flags)))
 		{
-			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "movntdq" : "movntq");
-			*si.buffer++ = ' ';
-			_nmd_append_modrm_upper(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "xmmword" : "qword");
-			*si.buffer++ = ',';
-			if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
-				_nmd_append_Vdq(&si);
-			else
-				_nmd_append_Pq(&si);
+			offset = line_offset;
+			break;
 		}
-		else if (op == 0xf0)
+		offset += length;
+
+		if (lines)
 		{
-			_nmd_append_string(&si, "lddqu ");
-			_nmd_append_Vdq(&si);
-			*si.buffer++ = ',';
-			_nmd_append_modrm_upper(&si, "xmmword");
+			lines[i].offset = line_offset;
+			lines[i].length = offset - line_offset;
 		}
-		else if (op == 0xf7)
+
+		buffer[offset++] = '\n';
+
+		if (runtime_address != NMD_X86_INVALID_RUNTIME_ADDRESS)
+			runtime_address += instruction->length;
+	}
+
+	if (offset < buffer_size)
+		buffer[offset] = '\0';
+
+	if (text_length)
+		*text_length = offset;
+
+	return i;
+}
+
+
+/* Returns the index of the bucket of 'runtime_address'(Fibonacci hashing, so consecutive addresses go to different buckets). */
+NMD_ASSEMBLY_API size_t _nmd_x86_cache_get_bucket(const nmd_x86_cache* cache, uint64_t runtime_address)
+{
+	return (size_t)((runtime_address * 0x9E3779B97F4A7C15) >> 32) & (cache->num_buckets - 1);
+}
+
+/*
+Initializes a decode cache in a memory block provided by the caller. Returns the number of entries of the cache, or zero if the block is too small for one bucket.
+The number of entries is the largest power of two times 'NMD_X86_CACHE_BUCKET_SIZE' that fits in the block. Use 'NMD_X86_CACHE_MEMORY_SIZE()' to compute the block's size.
+Parameters:
+ - cache       [out] A pointer to a variable of type 'nmd_x86_cache'.
+ - memory      [in]  A pointer to the memory block. It must stay valid while the cache is used.
+ - memory_size [in]  The size of the memory block in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_cache_init(nmd_x86_cache* cache, void* memory, size_t memory_size)
+{
+	const size_t bucket_size = NMD_X86_CACHE_BUCKET_SIZE * (sizeof(nmd_x86_cache_key) + sizeof(nmd_x86_cache_entry));
+	const size_t padding = (8 - ((size_t)memory & 7)) & 7; /* The keys start at an 8-byte boundary. */
+	size_t num_buckets = 1;
+
+	cache->num_buckets = 0;
+	if (memory_size < padding + bucket_size)
+		return 0;
+
+	memory_size -= padding;
+	while (num_buckets * 2 <= memory_size / bucket_size)
+		num_buckets *= 2;
+
+	cache->keys = (nmd_x86_cache_key*)((uint8_t*)memory + padding);
+	cache->entries = (nmd_x86_cache_entry*)(cache->keys + num_buckets * NMD_X86_CACHE_BUCKET_SIZE);
+	cache->num_buckets = num_buckets;
+	nmd_x86_cache_clear(cache);
+
+	return num_buckets * NMD_X86_CACHE_BUCKET_SIZE;
+}
+
+/* Returns the index of the entry of the instruction at 'runtime_address', decoding it if it's not in the cache. Returns '(size_t)-1' if the instruction is invalid. */
+NMD_ASSEMBLY_API size_t _nmd_x86_cache_lookup(nmd_x86_cache* cache, const uint8_t* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags)
+{
+	const size_t first = _nmd_x86_cache_get_bucket(cache, runtime_address) * NMD_X86_CACHE_BUCKET_SIZE;
+	size_t i, j, victim = (size_t)-1;
+
+	for (i = first; i < first + NMD_X86_CACHE_BUCKET_SIZE; i++)
+	{
+		const nmd_x86_cache_key* key = &cache->keys[i];
+		if (!key->length)
 		{
-			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "maskmovdqu " : "maskmovq ");
-			if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
-			{
-				_nmd_append_Vdq(&si);
-				*si.buffer++ = ',';
-				_nmd_append_Udq(&si);
-			}
-			else
-			{
-				_nmd_append_Pq(&si);
-				*si.buffer++ = ',';
-				_nmd_append_Nq(&si);
-			}
+			if (victim == (size_t)-1)
+				victim = i;
+			continue;
 		}
-		else if (op >= 0xd1 && op <= 0xfe)
+
+		if (key->runtime_address != runtime_address || key->mode != (uint8_t)mode || key->flags != flags)
+			continue;
+
+		/* The bytes in memory must still be the same, otherwise the code was modified and the instruction is decoded again in this entry. */
+		if (key->length <= buffer_size)
 		{
-			const char* mnemonics[] = { "srlw", "srld", "srlq", "addq", "mullw", 0, 0, "subusb", "subusw", "minub", "and", "addusb", "addusw", "maxub", "andn", "avgb", "sraw", "srad", "avgw", "mulhuw", "mulhw", 0, 0, "subsb", "subsw", "minsw", "or", "addsb", "addsw", "maxsw", "xor", 0, "sllw", "slld", "sllq", "muludq", "maddwd", "sadbw", 0, "subb", "subw", "subd", "subq", "addb", "addw", "addd" };
-			*si.buffer++ = 'p';
-			_nmd_append_string(&si, mnemonics[op - 0xd1]);
-			*si.buffer++ = ' ';
-			if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
+			const uint8_t* cached = cache->entries[i].instruction.buffer;
+			for (j = 0; j < key->length; j++)
 			{
-				_nmd_append_Vdq(&si);
-				*si.buffer++ = ',';
-				_nmd_append_W(&si);
+				if (cached[j] != buffer[j])
+					break;
 			}
-			else
+
+			if (j == key->length)
 			{
-				_nmd_append_Pq(&si);
-				*si.buffer++ = ',';
-				_nmd_append_Qq(&si);
+				cache->num_hits++;
+				return i;
 			}
 		}
-		else if (op == 0xb9 || op == 0xff)
+
+		victim = i;
+		break;
+	}
+
+	/* Every entry of the bucket is in use, so one is replaced in round-robin order. */
+	if (victim == (size_t)-1)
+		victim = first + (cache->next_victim++ % NMD_X86_CACHE_BUCKET_SIZE);
+
+	cache->num_misses++;
+	cache->keys[victim].length = 0;
+
+	/* The bytes are always copied, they're compared with memory on lookups. */
+	if (!nmd_x86_decode(buffer, buffer_size, &cache->entries[victim].instruction, mode, flags & ~NMD_X86_DECODER_FLAGS_ZERO_COPY))
+		return (size_t)-1;
+
+	cache->keys[victim].runtime_address = runtime_address;
+	cache->keys[victim].flags = flags;
+	cache->keys[victim].mode = (uint8_t)mode;
+	cache->keys[victim].length = cache->entries[victim].instruction.length;
+	cache->entries[victim].string_length = 0;
+
+	return victim;
+}
+
+/*
+Same as nmd_x86_decode(), but the instruction is looked up in the cache first. Returns a pointer to the decoded instruction, or a null pointer if the instruction is invalid.
+Instructions are looked up by runtime address, mode and flags, and the cached instruction's bytes are compared with the bytes in 'buffer', so an instruction that
+was modified is decoded again even if it was not invalidated. The pointer is valid until the next call that modifies the cache.
+Parameters:
+ - cache           [in/out] A pointer to a cache initialized by nmd_x86_cache_init().
+ - buffer          [in]     A pointer to a buffer containing an encoded instruction.
+ - buffer_size     [in]     The buffer's size in bytes.
+ - runtime_address [in]     The instruction's runtime address. This is the key of the cache, so 'NMD_X86_INVALID_RUNTIME_ADDRESS' only caches a few instructions.
+ - mode            [in]     The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags           [in]     A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+*/
+NMD_ASSEMBLY_API const nmd_x86_instruction* nmd_x86_cache_decode(nmd_x86_cache* cache, const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t flags)
+{
+	const size_t i = _nmd_x86_cache_lookup(cache, (const uint8_t*)buffer, buffer_size, runtime_address, mode, flags);
+	return i != (size_t)-1 ? &cache->entries[i].instruction : 0;
+}
+
+/*
+Same as nmd_x86_cache_decode(), but returns the formatted instruction, which is also cached. Returns a null pointer if the instruction is invalid or its string
+does not fit in 'NMD_X86_CACHE_STRING_SIZE' bytes. The pointer is valid until the next call that modifies the cache.
+Parameters:
+ - cache           [in/out] A pointer to a cache initialized by nmd_x86_cache_init().
+ - buffer          [in]     A pointer to a buffer containing an encoded instruction.
+ - buffer_size     [in]     The buffer's size in bytes.
+ - runtime_address [in]     The instruction's runtime address.
+ - mode            [in]     The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - decoder_flags   [in]     A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+ - format_flags    [in]     A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the instruction is formatted.
+*/
+NMD_ASSEMBLY_API const char* nmd_x86_cache_format(nmd_x86_cache* cache, const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, uint32_t decoder_flags, uint32_t format_flags)
+{
+	const size_t i = _nmd_x86_cache_lookup(cache, (const uint8_t*)buffer, buffer_size, runtime_address, mode, decoder_flags);
+	nmd_x86_cache_entry* entry;
+	if (i == (size_t)-1)
+		return 0;
+
+	entry = &cache->entries[i];
+	if (!entry->string_length || entry->format_flags != format_flags)
+	{
+		entry->format_flags = format_flags;
+		if (!(entry->string_length = nmd_x86_format_ex(&entry->instruction, entry->string, NMD_X86_CACHE_STRING_SIZE, runtime_address, format_flags)))
+			return 0;
+	}
+
+	return entry->string;
+}
+
+/*
+Removes every cached instruction that overlaps a range of memory(e.g. after the code was patched). Returns the number of instructions removed.
+Parameters:
+ - cache           [in/out] A pointer to a cache initialized by nmd_x86_cache_init().
+ - runtime_address [in]     The runtime address of the range's first byte.
+ - size            [in]     The range's size in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_cache_invalidate(nmd_x86_cache* cache, uint64_t runtime_address, size_t size)
+{
+	/* An instruction that overlaps the range starts at most 14 bytes before it. */
+	const uint64_t start = runtime_address >= NMD_X86_MAXIMUM_INSTRUCTION_LENGTH - 1 ? runtime_address - (NMD_X86_MAXIMUM_INSTRUCTION_LENGTH - 1) : 0;
+	const uint64_t end = runtime_address + size;
+	size_t num_removed = 0, i;
+
+	if (!size)
+		return 0;
+
+	if (end < runtime_address || end - start > cache->num_buckets)
+	{
+		/* The range is as large as the cache, so every entry is checked. */
+		for (i = 0; i < cache->num_buckets * NMD_X86_CACHE_BUCKET_SIZE; i++)
 		{
-			_nmd_append_string(&si, op == 0xb9 ? "ud1 " : "ud0 ");
-			_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.reg]);
-			*si.buffer++ = ',';
-			if (instruction->modrm.fields.mod == 0b11)
-				_nmd_append_string(&si, (instruction->mode == NMD_X86_MODE_64 ? _nmd_reg64 : _nmd_reg32)[instruction->modrm.fields.rm]);
-			else
-				_nmd_append_modrm_upper(&si, "dword");
+			nmd_x86_cache_key* key = &cache->keys[i];
+			if (key->length && key->runtime_address + key->length > runtime_address && (end < runtime_address || key->runtime_address < end))
+				key->length = 0, num_removed++;
 		}
-		else
+	}
+	else
+	{
+		/* Only the buckets of the addresses where an overlapping instruction may start are checked. */
+		uint64_t address;
+		for (address = start; address < end; address++)
 		{
-			const char* str = 0;
-			switch (op)
+			const size_t first = _nmd_x86_cache_get_bucket(cache, address) * NMD_X86_CACHE_BUCKET_SIZE;
+			for (i = first; i < first + NMD_X86_CACHE_BUCKET_SIZE; i++)
 			{
-			case 0x31: str = "rdtsc"; break;
-			case 0x07: str = "sysret"; break;
-			case 0x06: str = "clts"; break;
-			case 0x08: str = "invd"; break;
-			case 0x09: str = "wbinvd"; break;
-			case 0x0b: str = "ud2"; break;
-			case 0x0e: str = "femms"; break;
-			case 0x30: str = "wrmsr"; break;
-			case 0x32: str = "rdmsr"; break;
-			case 0x33: str = "rdpmc"; break;
-			case 0x34: str = "sysenter"; break;
-			case 0x35: str = "sysexit"; break;
-			case 0x37: str = "getsec"; break;
-			case 0x77: str = "emms"; break;
-			case 0xa0: str = "push fs"; break;
-			case 0xa1: str = "pop fs"; break;
-			case 0xa8: str = "push gs"; break;
-			case 0xa9: str = "pop gs"; break;
-			case 0xaa: str = "rsm"; break;
-			default: return;
+				nmd_x86_cache_key* key = &cache->keys[i];
+				if (key->length && key->runtime_address == address && address + key->length > runtime_address)
+					key->length = 0, num_removed++;
 			}
-			_nmd_append_string(&si, str);
 		}
 	}
-	else if (instruction->opcode_map == NMD_X86_OPCODE_MAP_0F38)
+
+	return num_removed;
+}
+
+/* Removes every cached instruction and resets the cache's counters. */
+NMD_ASSEMBLY_API void nmd_x86_cache_clear(nmd_x86_cache* cache)
+{
+	size_t i;
+	for (i = 0; i < cache->num_buckets * NMD_X86_CACHE_BUCKET_SIZE; i++)
+		cache->keys[i].length = 0;
+
+	cache->num_hits = 0;
+	cache->num_misses = 0;
+	cache->next_victim = 0;
+}
+
+
+/* Each byte of the buffer has a byte of information. The four low-order bits are the length of the instruction that starts there(zero if none). */
+#define _NMD_X86_CFG_LENGTH_MASK 0x0f
+#define _NMD_X86_CFG_LEADER      0x10 /* The instruction starts a block. */
+#define _NMD_X86_CFG_END         0x20 /* The instruction ends a block(branch or return). */
+#define _NMD_X86_CFG_PENDING     0x40 /* The offset must be traced. */
+#define _NMD_X86_CFG_FUNCTION    0x80 /* The offset is an entry point or the target of a call. */
+
+#define _NMD_X86_CFG_DECODER_FLAGS (NMD_X86_DECODER_FLAGS_VALIDITY_CHECK | NMD_X86_DECODER_FLAGS_GROUP | NMD_X86_DECODER_FLAGS_VEX | NMD_X86_DECODER_FLAGS_EVEX | NMD_X86_DECODER_FLAGS_3DNOW)
+
+typedef struct _nmd_x86_cfg_context
+{
+	const uint8_t* buffer;
+	size_t buffer_size;
+	uint64_t base; /* The runtime address of the first byte. */
+	NMD_X86_MODE mode;
+	uint8_t* info;
+	uint32_t* stack; /* Offsets to be traced. Offsets that do not fit are only marked as pending and found by a sweep. */
+	size_t stack_size;
+	size_t stack_capacity;
+} _nmd_x86_cfg_context;
+
+/* Marks the target of a branch as a block leader that must be traced. */
+NMD_ASSEMBLY_API void _nmd_x86_cfg_add_target(_nmd_x86_cfg_context* context, uint64_t target, uint8_t flags)
+{
+	size_t offset;
+	if (target < context->base || target - context->base >= context->buffer_size)
+		return;
+
+	offset = (size_t)(target - context->base);
+	if (context->info[offset] & _NMD_X86_CFG_LENGTH_MASK)
 	{
-		if ((_NMD_R(op) == 2 || _NMD_R(op) == 3) && _NMD_C(op) <= 5)
-		{
-			const char* mnemonics[] = { "pmovsxbw", "pmovsxbd", "pmovsxbq", "pmovsxwd", "pmovsxwq", "pmovsxdq" };
-			_nmd_append_string(&si, mnemonics[_NMD_C(op)]);
-			if (_NMD_R(op) == 3)
-				*(si.buffer - 4) = 'z';
-			*si.buffer++ = ' ';
-			_nmd_append_Vdq(&si);
-			*si.buffer++ = ',';
-			if (instruction->modrm.fields.mod == 0b11)
-				_nmd_append_Udq(&si);
-			else
-				_nmd_append_modrm_upper(&si, _NMD_C(op) == 5 ? "qword" : (_NMD_C(op) % 3 == 0 ? "qword" : (_NMD_C(op) % 3 == 1 ? "dword" : "word")));
-		}
-		else if (op >= 0x80 && op <= 0x83)
-		{
-			_nmd_append_string(&si, op == 0x80 ? "invept" : (op == 0x81 ? "invvpid" : "invpcid"));
-			*si.buffer++ = ' ';
-			_nmd_append_Gy(&si);
-			*si.buffer++ = ',';
-			_nmd_append_modrm_upper(&si, "xmmword");
-		}
-		else if (op >= 0xc8 && op <= 0xcd)
+		context->info[offset] |= _NMD_X86_CFG_LEADER | flags;
+		return;
+	}
+
+	if (context->info[offset] & _NMD_X86_CFG_PENDING)
+	{
+		context->info[offset] |= flags;
+		return;
+	}
+
+	context->info[offset] |= _NMD_X86_CFG_LEADER | _NMD_X86_CFG_PENDING | flags;
+	if (context->stack_size < context->stack_capacity)
+		context->stack[context->stack_size++] = (uint32_t)offset;
+}
+
+/* Decodes the instructions from 'offset' until a return, an unconditional branch, an invalid instruction or an instruction that was already decoded. */
+NMD_ASSEMBLY_API void _nmd_x86_cfg_trace(_nmd_x86_cfg_context* context, size_t offset)
+{
+	nmd_x86_light_instruction instruction;
+	context->info[offset] &= ~_NMD_X86_CFG_PENDING;
+
+	while (offset < context->buffer_size)
+	{
+		/* The stream merges with one that was already decoded, so the instruction has more than one predecessor. */
+		if (context->info[offset] & _NMD_X86_CFG_LENGTH_MASK)
 		{
-			const char* mnemonics[] = { "sha1nexte", "sha1msg1", "sha1msg2", "sha256rnds2", "sha256msg1", "sha256msg2" };
-			_nmd_append_string(&si, mnemonics[op - 0xc8]);
-			*si.buffer++ = ' ';
-			_nmd_append_Vdq(&si);
-			*si.buffer++ = ',';
-			_nmd_append_W(&si);
+			context->info[offset] |= _NMD_X86_CFG_LEADER;
+			return;
 		}
-		else if (op == 0xcf)
+
+		if (!nmd_x86_decode_light(context->buffer + offset, context->buffer_size - offset, context->base + offset, &instruction, context->mode, _NMD_X86_CFG_DECODER_FLAGS))
+			return;
+
+		context->info[offset] = (uint8_t)((context->info[offset] & ~_NMD_X86_CFG_PENDING) | instruction.length);
+
+		if (instruction.group & NMD_GROUP_CALL)
 		{
-			_nmd_append_string(&si, "gf2p8mulb ");
-			_nmd_append_Vdq(&si);
-			*si.buffer++ = ',';
-			_nmd_append_W(&si);
+			if (instruction.flags & NMD_X86_LIGHT_FLAGS_BRANCH_TARGET)
+				_nmd_x86_cfg_add_target(context, instruction.branch_target, _NMD_X86_CFG_FUNCTION);
 		}
-		else if (op == 0xf0 || op == 0xf1)
+		else if (instruction.group & (NMD_GROUP_BRANCH | NMD_GROUP_RET))
 		{
-			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO ? "crc32" : "movbe");
-			*si.buffer++ = ' ';
-			if (op == 0xf0)
-			{
-				if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO)
-				{
-					_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.reg]);
-					*si.buffer++ = ',';
-					_nmd_append_Eb(&si);
-				}
-				else
-				{
-					_nmd_append_Gv(&si);
-					*si.buffer++ = ',';
-					_nmd_append_Ev(&si);
-				}
-			}
-			else
-			{
-				if (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT_NOT_ZERO)
-				{
-					_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.reg]);
-					*si.buffer++ = ',';
-					if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
-						_nmd_append_Ew(&si);
-					else
-						_nmd_append_Ey(&si);
-				}
-				else
-				{
-					_nmd_append_Ev(&si);
-					*si.buffer++ = ',';
-					_nmd_append_Gv(&si);
-				}
-			}
+			context->info[offset] |= _NMD_X86_CFG_END;
+			if (instruction.flags & NMD_X86_LIGHT_FLAGS_BRANCH_TARGET)
+				_nmd_x86_cfg_add_target(context, instruction.branch_target, 0);
+
+			/* The instruction after a conditional branch starts a block, the ones after a return or an unconditional branch are not reachable from here. */
+			if (!(instruction.group & NMD_GROUP_CONDITIONAL_BRANCH))
+				return;
+
+			offset += instruction.length;
+			if (offset < context->buffer_size)
+				context->info[offset] |= _NMD_X86_CFG_LEADER;
+			continue;
 		}
-		else if (op == 0xf6)
+
+		offset += instruction.length;
+	}
+}
+
+/* Returns the index of the block that starts at 'offset', or 'num_blocks' if there's none. */
+NMD_ASSEMBLY_API size_t _nmd_x86_cfg_find_block(const nmd_x86_cfg* cfg, size_t offset)
+{
+	size_t low = 0, high = cfg->num_blocks;
+	while (low < high)
+	{
+		const size_t middle = low + (high - low) / 2;
+		if (cfg->block_offset[middle] < offset)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	return low < cfg->num_blocks && cfg->block_offset[low] == offset ? low : cfg->num_blocks;
+}
+
+/*
+Builds the control flow graph of the code reachable from one or more entry points. Returns the number of basic blocks, or zero if 'memory_size' is too small,
+'buffer_size' is not less than 4GiB or no entry point is in the buffer.
+Instructions are decoded recursively: conditional branches continue at both successors, unconditional branches at their target and returns, indirect branches
+and invalid instructions end the path. Targets of calls are traced as well(the block they start has the 'NMD_X86_CFG_BLOCK_FUNCTION' flag), but calls do not end blocks.
+Parameters:
+ - buffer           [in]  A pointer to a buffer containing encoded instructions.
+ - buffer_size      [in]  The buffer's size in bytes.
+ - runtime_address  [in]  The runtime address of the buffer's first byte. If it's 'NMD_X86_INVALID_RUNTIME_ADDRESS', offsets are used as runtime addresses.
+ - mode             [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - entry_points     [in]  A pointer to an array of runtime addresses where the code starts. Addresses outside the buffer are ignored.
+ - num_entry_points [in]  The number of elements in 'entry_points'.
+ - cfg              [out] A pointer to a variable of type 'nmd_x86_cfg' that receives the graph. Its arrays point to 'memory'.
+ - memory           [in]  A pointer to a memory block used by the function and to store the graph. 'NMD_X86_CFG_MEMORY_SIZE(buffer_size)' bytes are always enough.
+ - memory_size      [in]  The size of the memory block in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_cfg_build(const void* buffer, size_t buffer_size, uint64_t runtime_address, NMD_X86_MODE mode, const uint64_t* entry_points, size_t num_entry_points, nmd_x86_cfg* cfg, void* memory, size_t memory_size)
+{
+	_nmd_x86_cfg_context context;
+	nmd_x86_light_instruction instruction;
+	size_t i, offset, padding, num_blocks = 0, num_edges = 0, block_end = 0;
+	uint8_t* arrays;
+	bool pending;
+
+	cfg->num_blocks = 0;
+	cfg->num_edges = 0;
+
+	padding = (4 - (((size_t)memory + buffer_size) & 3)) & 3; /* The arrays of 32-bit integers start at a 4-byte boundary. */
+	if ((uint64_t)buffer_size >= 0xffffffff || memory_size < buffer_size + padding)
+		return 0;
+
+	context.buffer = (const uint8_t*)buffer;
+	context.buffer_size = buffer_size;
+	context.base = runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? 0 : runtime_address;
+	context.mode = mode;
+	context.info = (uint8_t*)memory;
+	context.stack = (uint32_t*)(context.info + buffer_size + padding);
+	context.stack_size = 0;
+	context.stack_capacity = (memory_size - buffer_size - padding) / sizeof(uint32_t);
+
+	for (i = 0; i < buffer_size; i++)
+		context.info[i] = 0;
+
+	for (i = 0; i < num_entry_points; i++)
+		_nmd_x86_cfg_add_target(&context, entry_points[i], _NMD_X86_CFG_FUNCTION);
+
+	/* Trace every pending offset. When the stack was full, the sweep finds the offsets that were not pushed. */
+	do
+	{
+		while (context.stack_size)
 		{
-			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "adcx" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "adox" : (instruction->rex_w_prefix ? "wrssq" : "wrssd")));
-			*si.buffer++ = ' ';
-			if (!instruction->simd_prefix)
-			{
-				_nmd_append_Ey(&si);
-				*si.buffer++ = ',';
-				_nmd_append_Gy(&si);
-			}
-			else
-			{
-				_nmd_append_Gy(&si);
-				*si.buffer++ = ',';
-				_nmd_append_Ey(&si);
-			}
+			offset = context.stack[--context.stack_size];
+			if (context.info[offset] & _NMD_X86_CFG_PENDING)
+				_nmd_x86_cfg_trace(&context, offset);
 		}
-		else if (op == 0xf5)
+
+		pending = false;
+		for (offset = 0; offset < buffer_size; offset++)
 		{
-			_nmd_append_string(&si, instruction->rex_w_prefix ? "wrussq " : "wrussd ");
-			_nmd_append_modrm_upper(&si, instruction->rex_w_prefix ? "qword" : "dword");
-			*si.buffer++ = ',';
-			_nmd_append_string(&si, (instruction->rex_w_prefix ? _nmd_reg64 : _nmd_reg32)[instruction->modrm.fields.reg]);
+			if (context.info[offset] & _NMD_X86_CFG_PENDING)
+				_nmd_x86_cfg_trace(&context, offset), pending = true;
 		}
-		else if (op == 0xf8)
+	} while (pending || context.stack_size);
+
+	/* Count the blocks. A block also ends before an offset that has no instruction. */
+	for (offset = 0; offset < buffer_size;)
+	{
+		const uint8_t info = context.info[offset];
+		if (!(info & _NMD_X86_CFG_LENGTH_MASK))
 		{
-			_nmd_append_string(&si, instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE ? "movdir64b" : (instruction->simd_prefix == NMD_X86_PREFIXES_REPEAT ? "enqcmd" : "enqcmds"));
-			*si.buffer++ = ' ';
-			_nmd_append_string(&si, (instruction->mode == NMD_X86_MODE_64 ? _nmd_reg64 : (instruction->mode == NMD_X86_MODE_16 ? _nmd_reg16 : _nmd_reg32))[instruction->modrm.fields.rm]);
-			*si.buffer++ = ',';
-			_nmd_append_modrm_upper(&si, "zmmword");
+			offset++;
+			continue;
 		}
-		else if (op == 0xf9)
+
+		if (offset != block_end || (info & _NMD_X86_CFG_LEADER))
+			num_blocks++;
+
+		offset += info & _NMD_X86_CFG_LENGTH_MASK;
+		block_end = (info & _NMD_X86_CFG_END) ? (size_t)-1 : offset;
+	}
+
+	if (!num_blocks)
+		return 0;
+
+	/* Each block has at most two successors */
+	arrays = (uint8_t*)context.stack;
+	if ((size_t)(memory_size - buffer_size - padding) < num_blocks * (4 * sizeof(uint32_t) + 1) + sizeof(uint32_t) + num_blocks * 2 * (sizeof(uint32_t) + 1))
+		return 0;
+
+	cfg->block_offset = (uint32_t*)arrays;
+	cfg->block_size = cfg->block_offset + num_blocks;
+	cfg->block_num_instructions = cfg->block_size + num_blocks;
+	cfg->block_first_edge = cfg->block_num_instructions + num_blocks;
+	cfg->edge_target = cfg->block_first_edge + num_blocks + 1;
+	cfg->block_flags = (uint8_t*)(cfg->edge_target + num_blocks * 2);
+	cfg->edge_type = cfg->block_flags + num_blocks;
+
+	/* Fill the blocks */
+	num_blocks = 0;
+	block_end = 0;
+	for (offset = 0; offset < buffer_size;)
+	{
+		const uint8_t info = context.info[offset];
+		if (!(info & _NMD_X86_CFG_LENGTH_MASK))
 		{
-			_nmd_append_string(&si, "movdiri ");
-			_nmd_append_modrm_upper_without_address_specifier(&si);
-			*si.buffer++ = ',';
-			_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.rm]);
+			offset++;
+			continue;
 		}
-		else
+
+		if (offset != block_end || (info & _NMD_X86_CFG_LEADER))
 		{
-			if (op == 0x40)
-				_nmd_append_string(&si, "pmulld");
-			else if (op == 0x41)
-				_nmd_append_string(&si, "phminposuw");
-			else if (op >= 0xdb && op <= 0xdf)
-			{
-				const char* mnemonics[] = { "aesimc", "aesenc", "aesenclast", "aesdec", "aesdeclast" };
-				_nmd_append_string(&si, mnemonics[op - 0xdb]);
-			}
-			else if (op == 0x37)
-				_nmd_append_string(&si, "pcmpgtq");
-			else if (_NMD_R(op) == 2)
-			{
-				const char* mnemonics[] = { "pmuldq", "pcmpeqq", "movntdqa", "packusdw" };
-				_nmd_append_string(&si, mnemonics[_NMD_C(op) - 8]);
-			}
-			else if (_NMD_R(op) == 3)
-			{
-				const char* mnemonics[] = { "pminsb", "pminsd", "pminuw", "pminud", "pmaxsb", "pmaxsd", "pmaxuw", "pmaxud" };
-				_nmd_append_string(&si, mnemonics[_NMD_C(op) - 8]);
-			}
-			else if (op < 0x10)
-			{
-				const char* mnemonics[] = { "pshufb", "phaddw", "phaddd", "phaddsw", "pmaddubsw", "phsubw", "phsubd", "phsubsw", "psignb", "psignw", "psignd", "pmulhrsw", "permilpsv", "permilpdv", "testpsv", "testpdv" };
-				_nmd_append_string(&si, mnemonics[op]);
-			}
-			else if (op < 0x18)
-				_nmd_append_string(&si, op == 0x10 ? "pblendvb" : (op == 0x14 ? "blendvps" : (op == 0x15 ? "blendvpd" : "ptest")));
+			cfg->block_offset[num_blocks] = (uint32_t)offset;
+			cfg->block_size[num_blocks] = 0;
+			cfg->block_num_instructions[num_blocks] = 0;
+			cfg->block_flags[num_blocks] = (info & _NMD_X86_CFG_FUNCTION) ? NMD_X86_CFG_BLOCK_FUNCTION : 0;
+			num_blocks++;
+		}
+
+		cfg->block_size[num_blocks - 1] += info & _NMD_X86_CFG_LENGTH_MASK;
+		cfg->block_num_instructions[num_blocks - 1]++;
+
+		offset += info & _NMD_X86_CFG_LENGTH_MASK;
+		block_end = (info & _NMD_X86_CFG_END) ? (size_t)-1 : offset;
+	}
+	cfg->num_blocks = num_blocks;
+
+	/* Compute the successors of each block from its last instruction */
+	for (i = 0; i < num_blocks; i++)
+	{
+		const size_t end = (size_t)cfg->block_offset[i] + cfg->block_size[i];
+		size_t last = cfg->block_offset[i], target;
+		bool falls_through = true;
+
+		cfg->block_first_edge[i] = (uint32_t)num_edges;
+		while (last + (context.info[last] & _NMD_X86_CFG_LENGTH_MASK) < end)
+			last += context.info[last] & _NMD_X86_CFG_LENGTH_MASK;
+
+		if (context.info[last] & _NMD_X86_CFG_END)
+		{
+			nmd_x86_decode_light(context.buffer + last, buffer_size - last, context.base + last, &instruction, mode, _NMD_X86_CFG_DECODER_FLAGS);
+			falls_through = (instruction.group & NMD_GROUP_CONDITIONAL_BRANCH) != 0;
+
+			if (instruction.group & NMD_GROUP_RET)
+				cfg->block_flags[i] |= NMD_X86_CFG_BLOCK_RETURN;
+			else if (!(instruction.flags & NMD_X86_LIGHT_FLAGS_BRANCH_TARGET))
+				cfg->block_flags[i] |= NMD_X86_CFG_BLOCK_INDIRECT_BRANCH;
+			else if (instruction.branch_target < context.base || instruction.branch_target - context.base >= buffer_size || (target = _nmd_x86_cfg_find_block(cfg, (size_t)(instruction.branch_target - context.base))) == num_blocks)
+				cfg->block_flags[i] |= NMD_X86_CFG_BLOCK_EXTERNAL_BRANCH;
 			else
 			{
-				_nmd_append_string(&si, "pabs");
-				*si.buffer++ = op == 0x1c ? 'b' : (op == 0x1d ? 'w' : 'd');
+				cfg->edge_target[num_edges] = (uint32_t)target;
+				cfg->edge_type[num_edges++] = (uint8_t)(falls_through ? NMD_X86_CFG_EDGE_BRANCH_TAKEN : NMD_X86_CFG_EDGE_JUMP);
 			}
-			*si.buffer++ = ' ';
-			if (instruction->simd_prefix == NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE)
+		}
+
+		if (falls_through)
+		{
+			if (i + 1 < num_blocks && cfg->block_offset[i + 1] == end)
 			{
-				_nmd_append_Vdq(&si);
-				*si.buffer++ = ',';
-				_nmd_append_W(&si);
+				cfg->edge_target[num_edges] = (uint32_t)(i + 1);
+				cfg->edge_type[num_edges++] = NMD_X86_CFG_EDGE_FALLTHROUGH;
 			}
 			else
-			{
-				_nmd_append_Pq(&si);
-				*si.buffer++ = ',';
-				_nmd_append_Qq(&si);
-			}
+				cfg->block_flags[i] |= NMD_X86_CFG_BLOCK_TRUNCATED;
 		}
+	}
+	cfg->block_first_edge[num_blocks] = (uint32_t)num_edges;
+	cfg->num_edges = num_edges;
+
+	return num_blocks;
+}
+
+
+#ifdef NMD_ASSEMBLY_ENABLE_THREADS
+
+/* The buffer is split in 'num_threads * _NMD_X86_CHUNKS_PER_THREAD' chunks, so threads that finish early take the remaining work. */
+#define _NMD_X86_CHUNKS_PER_THREAD 8
+#define _NMD_X86_MIN_CHUNK_SIZE 4096
+#define _NMD_X86_MAX_CHUNKS (NMD_ASSEMBLY_MAX_THREADS * _NMD_X86_CHUNKS_PER_THREAD)
+
+typedef struct _nmd_x86_chunk
+{
+	size_t count;             /* The number of valid instructions that start in the chunk. */
+	size_t exit;              /* The offset where the chunk's instruction stream leaves the chunk. It may be past the end of the chunk. */
+	size_t first_instruction; /* The index of the chunk's first instruction in the output array. */
+} _nmd_x86_chunk;
+
+typedef struct _nmd_x86_parallel_job
+{
+	const uint8_t* buffer;
+	size_t buffer_size;
+	NMD_X86_MODE mode;
+	uint32_t flags;
+	uint8_t* lengths;
+	nmd_x86_instruction* instructions; /* Null if only the lengths are computed. */
+	size_t num_instructions;
+	size_t chunk_size;
+	size_t num_chunks;
+	bool decode_pass; /* false: find the instruction boundaries of each chunk. true: decode the instructions of each chunk. */
+	volatile long next_chunk;
+	_nmd_x86_chunk chunks[_NMD_X86_MAX_CHUNKS];
+} _nmd_x86_parallel_job;
+
+/* Returns the index of the next chunk to be processed. */
+NMD_ASSEMBLY_API size_t _nmd_x86_take_chunk(_nmd_x86_parallel_job* job)
+{
+#ifdef _WIN32
+	return (size_t)(InterlockedIncrement(&job->next_chunk) - 1);
+#else
+	return (size_t)__sync_fetch_and_add(&job->next_chunk, 1);
+#endif /* _WIN32 */
+}
 
+/* Returns the length of the instruction at 'offset' if it is valid, zero otherwise. */
+NMD_ASSEMBLY_API size_t _nmd_x86_parallel_length(const _nmd_x86_parallel_job* job, size_t offset)
+{
+	if (job->instructions)
+	{
+		/* Use the same lengths as nmd_x86_decode() */
+		nmd_x86_light_instruction instruction;
+		return nmd_x86_decode_light(job->buffer + offset, job->buffer_size - offset, NMD_X86_INVALID_RUNTIME_ADDRESS, &instruction, job->mode, job->flags & ~(NMD_X86_DECODER_FLAGS_INSTRUCTION_ID | NMD_X86_DECODER_FLAGS_GROUP)) ? instruction.length : 0;
 	}
-	else if (instruction->opcode_map == NMD_X86_OPCODE_MAP_0F3A)
+	else
+		return nmd_x86_ldisasm(job->buffer + offset, job->buffer_size - offset, job->mode);
+}
+
+/*
+Follows the instruction stream that starts at 'offset' and writes the length of every instruction that starts in the chunk 'index'.
+If 'resync' is true the chunk was already scanned, and the function stops as soon as the stream reaches an instruction of the previous scan.
+Invalid instructions are skipped one byte at a time.
+*/
+NMD_ASSEMBLY_API void _nmd_x86_scan_chunk(_nmd_x86_parallel_job* job, size_t index, size_t offset, bool resync)
+{
+	_nmd_x86_chunk* const chunk = &job->chunks[index];
+	const size_t end = _NMD_MIN((index + 1) * job->chunk_size, job->buffer_size);
+	size_t length, i;
+
+	while (offset < end)
 	{
-		if (_NMD_R(op) == 1)
+		/* The streams converged, the rest of the chunk is already correct */
+		if (resync && job->lengths[offset])
+			return;
+
+		length = _nmd_x86_parallel_length(job, offset);
+		job->lengths[offset] = (uint8_t)length;
+		if (!length)
 		{
-			const char* mnemonics[] = { "pextrb", "pextrw", "pextrd", "extractps" };
-			_nmd_append_string(&si, mnemonics[op - 0x14]);
-			*si.buffer++ = ' ';
-			if (instruction->modrm.fields.mod == 0b11)
-				_nmd_append_string(&si, (si.instruction->rex_w_prefix ? _nmd_reg64 : _nmd_reg32)[instruction->modrm.fields.rm]);
-			else
-			{
-				if (op == 0x14)
-					_nmd_append_modrm_upper(&si, "byte");
-				else if (op == 0x15)
-					_nmd_append_modrm_upper(&si, "word");
-				else if (op == 0x16)
-					_nmd_append_Ey(&si);
-				else
-					_nmd_append_modrm_upper(&si, "dword");
-			}
-			*si.buffer++ = ',';
-			_nmd_append_Vdq(&si);
+			offset++;
+			continue;
 		}
-		else if (_NMD_R(op) == 2)
+
+		chunk->count++;
+		for (i = offset + 1; i < offset + length && i < end; i++)
+		{
+			if (resync && job->lengths[i])
+				chunk->count--;
+			job->lengths[i] = 0;
+		}
+
+		offset += length;
+	}
+
+	chunk->exit = offset;
+}
+
+/* Makes the instruction stream of the chunk 'index' continue the stream of the previous chunk. */
+NMD_ASSEMBLY_API void _nmd_x86_resync_chunk(_nmd_x86_parallel_job* job, size_t index)
+{
+	_nmd_x86_chunk* const chunk = &job->chunks[index];
+	const size_t begin = index * job->chunk_size;
+	const size_t end = _NMD_MIN(begin + job->chunk_size, job->buffer_size);
+	const size_t exit = job->chunks[index - 1].exit;
+	size_t offset;
+
+	if (exit == begin)
+		return;
+
+	/* These bytes belong to the last instruction of the previous chunk */
+	for (offset = begin; offset < exit && offset < end; offset++)
+	{
+		if (job->lengths[offset])
+			chunk->count--;
+		job->lengths[offset] = 0;
+	}
+
+	_nmd_x86_scan_chunk(job, index, exit, true);
+}
+
+/* Decodes the instructions that start in the chunk 'index' into the output array. */
+NMD_ASSEMBLY_API void _nmd_x86_decode_chunk(_nmd_x86_parallel_job* job, size_t index)
+{
+	const size_t end = _NMD_MIN((index + 1) * job->chunk_size, job->buffer_size);
+	size_t offset = index ? job->chunks[index - 1].exit : 0;
+	size_t i = job->chunks[index].first_instruction;
+
+	for (; offset < end && i < job->num_instructions; offset += job->lengths[offset] ? job->lengths[offset] : 1)
+	{
+		if (job->lengths[offset])
+			nmd_x86_decode(job->buffer + offset, job->buffer_size - offset, &job->instructions[i++], job->mode, job->flags);
+	}
+}
+
+NMD_ASSEMBLY_API void _nmd_x86_parallel_worker(_nmd_x86_parallel_job* job)
+{
+	size_t index;
+	while ((index = _nmd_x86_take_chunk(job)) < job->num_chunks)
+	{
+		if (job->decode_pass)
+			_nmd_x86_decode_chunk(job, index);
+		else
+		{
+			job->chunks[index].count = 0;
+			_nmd_x86_scan_chunk(job, index, index * job->chunk_size, false);
+		}
+	}
+}
+
+#ifdef _WIN32
+NMD_ASSEMBLY_API DWORD WINAPI _nmd_x86_thread_proc(LPVOID job)
+#else
+NMD_ASSEMBLY_API void* _nmd_x86_thread_proc(void* job)
+#endif /* _WIN32 */
+{
+	_nmd_x86_parallel_worker((_nmd_x86_parallel_job*)job);
+	return 0;
+}
+
+/* Runs _nmd_x86_parallel_worker() on 'num_threads' threads, including the calling thread. If a thread can't be created its work is done by the other threads. */
+NMD_ASSEMBLY_API void _nmd_x86_run_parallel(_nmd_x86_parallel_job* job, size_t num_threads)
+{
+#ifdef _WIN32
+	HANDLE threads[NMD_ASSEMBLY_MAX_THREADS];
+#else
+	pthread_t threads[NMD_ASSEMBLY_MAX_THREADS];
+#endif /* _WIN32 */
+	size_t i, num_created = 0;
+
+	job->next_chunk = 0;
+	for (i = 1; i < num_threads; i++, num_created++)
+	{
+#ifdef _WIN32
+		if (!(threads[num_created] = CreateThread(0, 0, _nmd_x86_thread_proc, job, 0, 0)))
+			break;
+#else
+		if (pthread_create(&threads[num_created], 0, _nmd_x86_thread_proc, job))
+			break;
+#endif /* _WIN32 */
+	}
+
+	_nmd_x86_parallel_worker(job);
+
+	for (i = 0; i < num_created; i++)
+	{
+#ifdef _WIN32
+		WaitForSingleObject(threads[i], INFINITE);
+		CloseHandle(threads[i]);
+#else
+		pthread_join(threads[i], 0);
+#endif /* _WIN32 */
+	}
+}
+
+/* Splits the buffer in chunks, finds the instruction boundaries of every chunk in parallel, resynchronizes the boundaries at the seams and optionally decodes the instructions in parallel. */
+NMD_ASSEMBLY_API size_t _nmd_x86_parallel(_nmd_x86_parallel_job* job, size_t num_threads)
+{
+	size_t i, num_valid = 0;
+
+	if (num_threads == 0)
+		num_threads = 1;
+	else if (num_threads > NMD_ASSEMBLY_MAX_THREADS)
+		num_threads = NMD_ASSEMBLY_MAX_THREADS;
+
+	job->chunk_size = _NMD_MAX((job->buffer_size + num_threads * _NMD_X86_CHUNKS_PER_THREAD - 1) / (num_threads * _NMD_X86_CHUNKS_PER_THREAD), _NMD_X86_MIN_CHUNK_SIZE);
+	job->num_chunks = (job->buffer_size + job->chunk_size - 1) / job->chunk_size;
+	if (job->num_chunks == 0)
+		return 0;
+
+	num_threads = _NMD_MIN(num_threads, job->num_chunks);
+
+	/* Each chunk is decoded as if an instruction started at its first byte */
+	job->decode_pass = false;
+	_nmd_x86_run_parallel(job, num_threads);
+
+	/* The stream of a chunk usually converges with the stream of the previous chunk after a few instructions, so this is cheap */
+	for (i = 1; i < job->num_chunks; i++)
+		_nmd_x86_resync_chunk(job, i);
+
+	for (i = 0; i < job->num_chunks; i++)
+	{
+		job->chunks[i].first_instruction = num_valid;
+		num_valid += job->chunks[i].count;
+	}
+
+	if (job->instructions && job->num_instructions)
+	{
+		job->decode_pass = true;
+		_nmd_x86_run_parallel(job, num_threads);
+	}
+
+	return num_valid;
+}
+
+/*
+Computes the instruction boundaries of a buffer using multiple threads. The result is the same as a linear sweep that starts at the first byte and skips invalid instructions one byte at a time.
+Returns the number of valid instructions.
+Parameters:
+ - buffer      [in]  A pointer to a buffer containing encoded instructions.
+ - buffer_size [in]  The buffer's size in bytes.
+ - mode        [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - lengths     [out] A pointer to an array of 'buffer_size' elements. 'lengths[i]' receives the length of the instruction at offset 'i' if one starts there, zero otherwise.
+                     Walk the array with 'i += lengths[i] ? lengths[i] : 1': a zero at a visited offset is an invalid byte.
+ - num_threads [in]  The number of threads to use, including the calling thread. It's clamped to 'NMD_ASSEMBLY_MAX_THREADS'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_ldisasm_parallel(const void* buffer, size_t buffer_size, NMD_X86_MODE mode, uint8_t* lengths, size_t num_threads)
+{
+	_nmd_x86_parallel_job job;
+	job.buffer = (const uint8_t*)buffer;
+	job.buffer_size = buffer_size;
+	job.mode = mode;
+	job.flags = 0;
+	job.lengths = lengths;
+	job.instructions = 0;
+	job.num_instructions = 0;
+
+	return _nmd_x86_parallel(&job, num_threads);
+}
+
+/*
+Decodes every instruction of a buffer using multiple threads. The boundaries are computed the same way nmd_x86_ldisasm_parallel() does, but using the decoder's lengths.
+The instructions are written in address order. Returns the number of valid instructions, which may be greater than 'num_instructions'.
+Parameters:
+ - buffer           [in]  A pointer to a buffer containing encoded instructions.
+ - buffer_size      [in]  The buffer's size in bytes.
+ - mode             [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - flags            [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+ - lengths          [out] A pointer to an array of 'buffer_size' elements that receives the instruction boundaries. See nmd_x86_ldisasm_parallel().
+ - instructions     [out] A pointer to an array of 'nmd_x86_instruction' that receives the decoded instructions.
+ - num_instructions [in]  The number of elements in 'instructions'.
+ - num_threads      [in]  The number of threads to use, including the calling thread. It's clamped to 'NMD_ASSEMBLY_MAX_THREADS'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_decode_parallel(const void* buffer, size_t buffer_size, NMD_X86_MODE mode, uint32_t flags, uint8_t* lengths, nmd_x86_instruction* instructions, size_t num_instructions, size_t num_threads)
+{
+	_nmd_x86_parallel_job job;
+	job.buffer = (const uint8_t*)buffer;
+	job.buffer_size = buffer_size;
+	job.mode = mode;
+	job.flags = flags;
+	job.lengths = lengths;
+	job.instructions = instructions;
+	job.num_instructions = num_instructions;
+
+	return _nmd_x86_parallel(&job, num_threads);
+}
+
+#endif /* NMD_ASSEMBLY_ENABLE_THREADS */
+
+
+#ifdef NMD_ASSEMBLY_ENABLE_THREADS
+
+#ifdef _WIN32
+#define _NMD_MEMORY_BARRIER() MemoryBarrier()
+#define _NMD_YIELD() SwitchToThread()
+#else
+#define _NMD_MEMORY_BARRIER() __sync_synchronize()
+#define _NMD_YIELD() sched_yield()
+#endif /* _WIN32 */
+
+/* The indices of a ring are in different cache lines, so the producer and the consumer don't invalidate each other's line on every update. */
+#define _NMD_X86_CACHE_LINE_SIZE 64
+
+/* The maximum number of items a stage processes before it publishes them to the next stage. */
+#define _NMD_X86_PIPELINE_BATCH_SIZE 64
+
+enum _NMD_X86_PIPELINE_STAGE
+{
+	_NMD_X86_PIPELINE_STAGE_LDISASM = 0, /* Splits the blocks of code in instructions using nmd_x86_ldisasm(). */
+	_NMD_X86_PIPELINE_STAGE_DECODE,      /* Decodes the instructions using the decoder. */
+	_NMD_X86_PIPELINE_STAGE_FORMAT,      /* Formats the instructions using the formatter. */
+	_NMD_X86_PIPELINE_NUM_STAGES
+};
+
+/* A single-producer/single-consumer lock-free ring buffer. 'head' is only written by the producer and 'tail' is only written by the consumer. */
+typedef struct _nmd_x86_ring
+{
+	volatile size_t head; /* The number of items written by the producer. */
+	uint8_t padding0[_NMD_X86_CACHE_LINE_SIZE - sizeof(size_t)];
+	volatile size_t tail; /* The number of items read by the consumer. */
+	uint8_t padding1[_NMD_X86_CACHE_LINE_SIZE - sizeof(size_t)];
+	uint8_t* items;
+	size_t item_size;
+	size_t mask; /* The ring's capacity minus one. The capacity is a power of two. */
+} _nmd_x86_ring;
+
+/* A block of code pushed by nmd_x86_pipeline_push(). */
+typedef struct _nmd_x86_pipeline_block
+{
+	uint64_t runtime_address;
+	uint32_t size;
+	uint32_t continued; /* Non-zero if the block continues the instruction stream of the previous block. */
+	uint8_t bytes[NMD_X86_PIPELINE_BLOCK_SIZE];
+} _nmd_x86_pipeline_block;
+
+/* An instruction found by the ldisasm stage. */
+typedef struct _nmd_x86_pipeline_bytes
+{
+	uint64_t runtime_address;
+	uint8_t length;
+	uint8_t bytes[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH];
+} _nmd_x86_pipeline_bytes;
+
+/* An instruction decoded by the decode stage. */
+typedef struct _nmd_x86_pipeline_instruction
+{
+	uint64_t runtime_address;
+	nmd_x86_instruction instruction;
+} _nmd_x86_pipeline_instruction;
+
+typedef struct _nmd_x86_pipeline_state
+{
+	_nmd_x86_ring rings[_NMD_X86_PIPELINE_NUM_STAGES + 1]; /* rings[i] is the input of stage 'i', the last ring holds the formatted lines. */
+	volatile long done[_NMD_X86_PIPELINE_NUM_STAGES];      /* done[i] is non-zero after stage 'i' processed every item and exited. */
+	volatile long closed;                                  /* Non-zero after nmd_x86_pipeline_close(). */
+	volatile long abort;                                   /* Non-zero after nmd_x86_pipeline_stop(), the stages exit as soon as possible. */
+	NMD_X86_MODE mode;
+	uint32_t decoder_flags;
+	uint32_t format_flags;
+	uint64_t next_address; /* The address after the last block pushed. Only used by the producer. */
+	size_t num_threads;
+#ifdef _WIN32
+	HANDLE threads[_NMD_X86_PIPELINE_NUM_STAGES];
+#else
+	pthread_t threads[_NMD_X86_PIPELINE_NUM_STAGES];
+#endif /* _WIN32 */
+} _nmd_x86_pipeline_state;
+
+typedef struct _nmd_x86_pipeline_stage
+{
+	_nmd_x86_pipeline_state* state;
+	size_t index;
+} _nmd_x86_pipeline_stage;
+
+/* Returns a pointer to the item 'index' of 'ring'. */
+NMD_ASSEMBLY_API void* _nmd_x86_ring_item(const _nmd_x86_ring* ring, size_t index)
+{
+	return ring->items + (index & ring->mask) * ring->item_size;
+}
+
+/* Returns the number of items the consumer can read. The items' contents are visible after the call. */
+NMD_ASSEMBLY_API size_t _nmd_x86_ring_num_items(const _nmd_x86_ring* ring)
+{
+	const size_t num_items = ring->head - ring->tail;
+	_NMD_MEMORY_BARRIER();
+	return num_items;
+}
+
+/* Makes the items in ['ring->head', 'head') visible to the consumer. */
+NMD_ASSEMBLY_API void _nmd_x86_ring_publish(_nmd_x86_ring* ring, size_t head)
+{
+	_NMD_MEMORY_BARRIER();
+	ring->head = head;
+}
+
+/* Releases the items in ['ring->tail', 'tail') to the producer. */
+NMD_ASSEMBLY_API void _nmd_x86_ring_release(_nmd_x86_ring* ring, size_t tail)
+{
+	_NMD_MEMORY_BARRIER();
+	ring->tail = tail;
+}
+
+/* Waits until the item 'head' of 'ring' can be written by the producer, publishing the items before it while waiting. Returns false if the pipeline was stopped. */
+NMD_ASSEMBLY_API bool _nmd_x86_ring_wait(_nmd_x86_pipeline_state* state, _nmd_x86_ring* ring, size_t head)
+{
+	if (head - ring->tail <= ring->mask)
+		return true;
+
+	_nmd_x86_ring_publish(ring, head);
+	while (head - ring->tail > ring->mask)
+	{
+		if (state->abort)
+			return false;
+		_NMD_YIELD();
+	}
+	_NMD_MEMORY_BARRIER();
+
+	return true;
+}
+
+/*
+Waits until stage 'index' has items to process. Returns the number of items, or zero if the previous stage(or the producer) finished and every item was processed.
+'done' is read before the ring, so no item published before the previous stage finished is missed.
+*/
+NMD_ASSEMBLY_API size_t _nmd_x86_pipeline_wait(_nmd_x86_pipeline_state* state, size_t index)
+{
+	for (;;)
+	{
+		const bool finished = index ? state->done[index - 1] != 0 : state->closed != 0;
+		size_t num_items;
+		_NMD_MEMORY_BARRIER();
+
+		if (state->abort)
+			return 0;
+		if ((num_items = _nmd_x86_ring_num_items(&state->rings[index])))
+			return num_items;
+		if (finished)
+			return 0;
+
+		_NMD_YIELD();
+	}
+}
+
+/* Writes the instruction at 'runtime_address' to the item 'head' of the decode stage's ring. Returns false if the pipeline was stopped. */
+NMD_ASSEMBLY_API bool _nmd_x86_pipeline_emit(_nmd_x86_pipeline_state* state, size_t head, uint64_t runtime_address, const uint8_t* bytes, size_t length)
+{
+	_nmd_x86_ring* const ring = &state->rings[_NMD_X86_PIPELINE_STAGE_DECODE];
+	_nmd_x86_pipeline_bytes* item;
+	size_t i;
+
+	if (!_nmd_x86_ring_wait(state, ring, head))
+		return false;
+
+	item = (_nmd_x86_pipeline_bytes*)_nmd_x86_ring_item(ring, head);
+	item->runtime_address = runtime_address;
+	item->length = (uint8_t)length;
+	for (i = 0; i < length; i++)
+		item->bytes[i] = bytes[i];
+
+	return true;
+}
+
+/* Returns 'runtime_address + offset', or 'NMD_X86_INVALID_RUNTIME_ADDRESS' if 'runtime_address' is invalid. */
+NMD_ASSEMBLY_API uint64_t _nmd_x86_pipeline_address(uint64_t runtime_address, size_t offset)
+{
+	return runtime_address == NMD_X86_INVALID_RUNTIME_ADDRESS ? NMD_X86_INVALID_RUNTIME_ADDRESS : runtime_address + offset;
+}
+
+/*
+Splits the blocks of code in instructions. An instruction may continue in the next block: if nmd_x86_ldisasm() fails less than 15 bytes before the end of a
+block, the rest of the block is kept and decoded again with the first bytes of the next block. Invalid instructions are skipped one byte at a time.
+*/
+NMD_ASSEMBLY_API void _nmd_x86_pipeline_ldisasm_stage(_nmd_x86_pipeline_state* state)
+{
+	_nmd_x86_ring* const input = &state->rings[_NMD_X86_PIPELINE_STAGE_LDISASM];
+	_nmd_x86_ring* const output = &state->rings[_NMD_X86_PIPELINE_STAGE_DECODE];
+	uint8_t carry[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH * 2]; /* The bytes at the end of the previous block, followed by the first bytes of the current block. */
+	size_t carry_size = 0, head = output->head, tail = input->tail, num_blocks, length, offset, i;
+	uint64_t carry_address = NMD_X86_INVALID_RUNTIME_ADDRESS;
+
+	while ((num_blocks = _nmd_x86_pipeline_wait(state, _NMD_X86_PIPELINE_STAGE_LDISASM)))
+	{
+		for (; num_blocks; num_blocks--, tail++)
 		{
-			_nmd_append_string(&si, op == 0x20 ? "pinsrb" : (op == 0x21 ? "insertps" : "pinsrd"));
-			*si.buffer++ = ' ';
-			_nmd_append_Vdq(&si);
-			*si.buffer++ = ',';
-			if (op == 0x20)
+			const _nmd_x86_pipeline_block* const block = (const _nmd_x86_pipeline_block*)_nmd_x86_ring_item(input, tail);
+			offset = 0;
+
+			/* Decode the kept bytes, with the first bytes of this block if the stream continues here */
+			while (carry_size)
 			{
-				if (instruction->modrm.fields.mod == 0b11)
-					_nmd_append_string(&si, _nmd_reg32[instruction->modrm.fields.rm]);
+				const size_t num_new_bytes = block->continued ? _NMD_MIN((size_t)block->size, sizeof(carry) - carry_size) : 0;
+				if (block->continued && carry_size + num_new_bytes < NMD_X86_MAXIMUM_INSTRUCTION_LENGTH && num_new_bytes == block->size)
+				{
+					/* The block is too small to complete the instruction, keep it as well */
+					for (i = 0; i < num_new_bytes; i++)
+						carry[carry_size++] = block->bytes[i];
+					offset = block->size;
+					break;
+				}
+
+				for (i = 0; i < num_new_bytes; i++)
+					carry[carry_size + i] = block->bytes[i];
+
+				length = nmd_x86_ldisasm(carry, carry_size + num_new_bytes, state->mode);
+				if (length)
+				{
+					if (!_nmd_x86_pipeline_emit(state, head++, carry_address, carry, length))
+						return;
+				}
 				else
-					_nmd_append_modrm_upper(&si, "byte");
+					length = 1;
+
+				if (length >= carry_size)
+				{
+					offset = block->continued ? length - carry_size : 0;
+					carry_size = 0;
+				}
+				else
+				{
+					carry_size -= length;
+					for (i = 0; i < carry_size; i++)
+						carry[i] = carry[i + length];
+					carry_address = _nmd_x86_pipeline_address(carry_address, length);
+				}
 			}
-			else if (op == 0x21)
+
+			while (offset < block->size)
 			{
-				if (instruction->modrm.fields.mod == 0b11)
-					_nmd_append_Udq(&si);
+				const size_t remaining = block->size - offset;
+				if ((length = nmd_x86_ldisasm(block->bytes + offset, remaining, state->mode)))
+				{
+					if (!_nmd_x86_pipeline_emit(state, head++, _nmd_x86_pipeline_address(block->runtime_address, offset), block->bytes + offset, length))
+						return;
+					offset += length;
+				}
+				else if (remaining < NMD_X86_MAXIMUM_INSTRUCTION_LENGTH)
+				{
+					/* The instruction may continue in the next block */
+					for (carry_size = 0; carry_size < remaining; carry_size++)
+						carry[carry_size] = block->bytes[offset + carry_size];
+					carry_address = _nmd_x86_pipeline_address(block->runtime_address, offset);
+					break;
+				}
 				else
-					_nmd_append_modrm_upper(&si, "dword");
+					offset++;
 			}
-			else
-				_nmd_append_Ey(&si);
 		}
-		else
+
+		_nmd_x86_ring_release(input, tail);
+		_nmd_x86_ring_publish(output, head);
+	}
+
+	/* No block follows the kept bytes */
+	for (offset = 0; offset < carry_size && !state->abort; offset += length ? length : 1)
+	{
+		if ((length = nmd_x86_ldisasm(carry + offset, carry_size - offset, state->mode)) && !_nmd_x86_pipeline_emit(state, head++, _nmd_x86_pipeline_address(carry_address, offset), carry + offset, length))
+			return;
+	}
+	_nmd_x86_ring_publish(output, head);
+}
+
+/* Decodes the instructions found by the ldisasm stage. Instructions the decoder considers invalid are dropped. */
+NMD_ASSEMBLY_API void _nmd_x86_pipeline_decode_stage(_nmd_x86_pipeline_state* state)
+{
+	_nmd_x86_ring* const input = &state->rings[_NMD_X86_PIPELINE_STAGE_DECODE];
+	_nmd_x86_ring* const output = &state->rings[_NMD_X86_PIPELINE_STAGE_FORMAT];
+	size_t head = output->head, tail = input->tail, num_items;
+
+	while ((num_items = _nmd_x86_pipeline_wait(state, _NMD_X86_PIPELINE_STAGE_DECODE)))
+	{
+		for (num_items = _NMD_MIN(num_items, _NMD_X86_PIPELINE_BATCH_SIZE); num_items; num_items--, tail++)
 		{
-			if (op < 0x10)
-			{
-				const char* mnemonics[] = { "roundps", "roundpd", "roundss", "roundsd", "blendps", "blendpd", "pblendw", "palignr" };
-				_nmd_append_string(&si, mnemonics[op - 8]);
-			}
-			else if (_NMD_R(op) == 4)
-			{
-				const char* mnemonics[] = { "dpps", "dppd", "mpsadbw", 0, "pclmulqdq" };
-				_nmd_append_string(&si, mnemonics[_NMD_C(op)]);
-			}
-			else if (_NMD_R(op) == 6)
-			{
-				const char* mnemonics[] = { "pcmpestrm", "pcmpestri", "pcmpistrm", "pcmpistri" };
-				_nmd_append_string(&si, mnemonics[_NMD_C(op)]);
-			}
-			else if (op > 0x80)
-				_nmd_append_string(&si, op == 0xcc ? "sha1rnds4" : (op == 0xce ? "gf2p8affineqb" : (op == 0xcf ? "gf2p8affineinvqb" : "aeskeygenassist")));
-			*si.buffer++ = ' ';
-			if (op == 0xf && !(instruction->prefixes & (NMD_X86_PREFIXES_OPERAND_SIZE_OVERRIDE | NMD_X86_PREFIXES_REPEAT | NMD_X86_PREFIXES_REPEAT_NOT_ZERO)))
-			{
-				_nmd_append_Pq(&si);
-				*si.buffer++ = ',';
-				_nmd_append_Qq(&si);
-			}
-			else
+			const _nmd_x86_pipeline_bytes* const bytes = (const _nmd_x86_pipeline_bytes*)_nmd_x86_ring_item(input, tail);
+			_nmd_x86_pipeline_instruction* item;
+
+			if (!_nmd_x86_ring_wait(state, output, head))
+				return;
+
+			item = (_nmd_x86_pipeline_instruction*)_nmd_x86_ring_item(output, head);
+			_nmd_clear_instruction(&item->instruction, state->decoder_flags);
+			if (_nmd_decode_instruction(bytes->bytes, bytes->length, &item->instruction, state->mode, state->decoder_flags & ~NMD_X86_DECODER_FLAGS_ZERO_COPY))
 			{
-				_nmd_append_Vdq(&si);
-				*si.buffer++ = ',';
-				if (instruction->modrm.fields.mod == 0b11)
-					_nmd_append_string(&si, "xmm"), * si.buffer++ = (char)('0' + instruction->modrm.fields.rm);
-				else
-					_nmd_append_modrm_upper(&si, op == 0xa ? "dword" : (op == 0xb ? "qword" : "xmmword"));
+				item->runtime_address = bytes->runtime_address;
+				head++;
 			}
 		}
-		*si.buffer++ = ',';
-		_nmd_append_number(&si, instruction->immediate);
+
+		_nmd_x86_ring_release(input, tail);
+		_nmd_x86_ring_publish(output, head);
 	}
+}
 
-#ifndef NMD_ASSEMBLY_DISABLE_FORMATTER_ATT_SYNTAX
-	if (flags & NMD_X86_FORMAT_FLAGS_ATT_SYNTAX)
+/* Formats the decoded instructions into the output ring. */
+NMD_ASSEMBLY_API void _nmd_x86_pipeline_format_stage(_nmd_x86_pipeline_state* state)
+{
+	_nmd_x86_ring* const input = &state->rings[_NMD_X86_PIPELINE_STAGE_FORMAT];
+	_nmd_x86_ring* const output = &state->rings[_NMD_X86_PIPELINE_NUM_STAGES];
+	size_t head = output->head, tail = input->tail, num_items;
+
+	while ((num_items = _nmd_x86_pipeline_wait(state, _NMD_X86_PIPELINE_STAGE_FORMAT)))
 	{
-		*si.buffer = '\0';
-		char* operand = (char*)_nmd_reverse_strchr(buffer, ' ');
-		if (operand && *(operand - 1) != ' ') /* If the instruction has a ' '(space character) and the left character of 'operand' is not ' '(space) the instruction has operands. */
+		for (num_items = _NMD_MIN(num_items, _NMD_X86_PIPELINE_BATCH_SIZE); num_items; num_items--, tail++)
 		{
-			/* If there is a memory operand. */
-			const char* memory_operand = _nmd_strchr(buffer, '[');
-			if (memory_operand)
-			{
-				/* If the memory operand has pointer size. */
-				char* tmp2 = (char*)memory_operand - (*(memory_operand - 1) == ':' ? 7 : 4);
-				if (_nmd_strstr(tmp2, "ptr") == tmp2)
-				{
-					/* Find the ' '(space) that is after two ' '(spaces). */
-					tmp2 -= 2;
-					while (*tmp2 != ' ')
-						tmp2--;
-					operand = tmp2;
-				}
-			}
+			const _nmd_x86_pipeline_instruction* const item = (const _nmd_x86_pipeline_instruction*)_nmd_x86_ring_item(input, tail);
+			nmd_x86_pipeline_line* line;
 
-			const char* const first_operand_const = operand;
-			char* first_operand = operand + 1;
-			char* second_operand = 0;
-			/* Convert each operand to AT&T syntax. */
-			do
-			{
-				operand++;
-				operand = _nmd_format_operand_to_att(operand, &si);
-				if (*operand == ',')
-					second_operand = operand;
-			} while (*operand);
+			if (!_nmd_x86_ring_wait(state, output, head))
+				return;
 
-			/* Swap operands. */
-			if (second_operand) /* At least two operands. */
-			{
-				/* Copy first operand to 'tmp_buffer'. */
-				char tmp_buffer[64];
-				char* i = tmp_buffer;
-				char* j = first_operand;
-				for (; j < second_operand; i++, j++)
-					*i = *j;
+			line = (nmd_x86_pipeline_line*)_nmd_x86_ring_item(output, head++);
+			line->runtime_address = item->runtime_address;
+			line->length = _nmd_x86_format(&item->instruction, line->string, item->runtime_address, state->format_flags);
+		}
 
-				*i = '\0';
+		_nmd_x86_ring_release(input, tail);
+		_nmd_x86_ring_publish(output, head);
+	}
+}
 
-				/* Copy second operand to first operand. */
-				for (i = second_operand + 1; *i; first_operand++, i++)
-					*first_operand = *i;
+#ifdef _WIN32
+NMD_ASSEMBLY_API DWORD WINAPI _nmd_x86_pipeline_thread_proc(LPVOID parameter)
+#else
+NMD_ASSEMBLY_API void* _nmd_x86_pipeline_thread_proc(void* parameter)
+#endif /* _WIN32 */
+{
+	_nmd_x86_pipeline_stage* const stage = (_nmd_x86_pipeline_stage*)parameter;
+	_nmd_x86_pipeline_state* const state = stage->state;
+	const size_t index = stage->index;
+
+	if (index == _NMD_X86_PIPELINE_STAGE_LDISASM)
+		_nmd_x86_pipeline_ldisasm_stage(state);
+	else if (index == _NMD_X86_PIPELINE_STAGE_DECODE)
+		_nmd_x86_pipeline_decode_stage(state);
+	else
+		_nmd_x86_pipeline_format_stage(state);
 
-				*first_operand++ = ',';
+	_NMD_MEMORY_BARRIER();
+	state->done[index] = 1;
 
-				/* 'first_operand' is now the second operand. */
-				/* Copy 'tmp_buffer' to second operand. */
-				for (i = tmp_buffer; *first_operand; i++, first_operand++)
-					*first_operand = *i;
-			}
+	return 0;
+}
 
-			/* Memory operands change the mnemonic string(e.g. 'mov eax, dword ptr [ebx]' -> 'movl (%ebx), %eax'). */
-			if (memory_operand && !_nmd_strstr(first_operand_const - 4, "lea"))
-			{
-				const char* r_char = _nmd_strchr(first_operand_const, 'r');
-				const char* e_char = _nmd_strchr(first_operand_const, 'e');
-				const char* call_str = _nmd_strstr(first_operand_const - 5, "call");
-				const char* jmp_str = _nmd_strstr(first_operand_const - 4, "jmp");
-				_nmd_insert_char(first_operand_const, (instruction->mode == NMD_X86_MODE_64 && ((r_char && *(r_char - 1) == '%') || call_str || jmp_str)) ? 'q' : (instruction->mode == NMD_X86_MODE_32 && ((e_char && *(e_char - 1) == '%') || call_str || jmp_str) ? 'l' : 'b'));
-				si.buffer++;
-			}
-		}
+/* Returns the size in bytes of the items of each ring, rounded up to 8 bytes. */
+NMD_ASSEMBLY_API size_t _nmd_x86_pipeline_item_size(size_t ring)
+{
+	const size_t sizes[_NMD_X86_PIPELINE_NUM_STAGES + 1] = { sizeof(_nmd_x86_pipeline_block), sizeof(_nmd_x86_pipeline_bytes), sizeof(_nmd_x86_pipeline_instruction), sizeof(nmd_x86_pipeline_line) };
+	return (sizes[ring] + 7) & ~(size_t)7;
+}
+
+/*
+Starts a pipeline that splits blocks of code in instructions, decodes them and formats them on three threads(one per stage). The stages are connected by
+single-producer/single-consumer lock-free ring buffers stored in a memory block provided by the caller, no memory is allocated.
+Returns the capacity of each ring in items(a power of two), or zero if the block is too small for rings of 16 items or a thread can't be created.
+Use 'NMD_X86_PIPELINE_MEMORY_SIZE()' to compute the block's size. Idle stages yield their time slice, call nmd_x86_pipeline_stop() when the pipeline is not needed anymore.
+Parameters:
+ - pipeline      [out] A pointer to a variable of type 'nmd_x86_pipeline'.
+ - mode          [in]  The architecture mode. 'NMD_X86_MODE_32', 'NMD_X86_MODE_64' or 'NMD_X86_MODE_16'.
+ - decoder_flags [in]  A mask of 'NMD_X86_DECODER_FLAGS_XXX' that specifies which features the decoder is allowed to use.
+ - format_flags  [in]  A mask of 'NMD_X86_FORMAT_FLAGS_XXX' that specifies how the instructions are formatted.
+ - memory        [in]  A pointer to the memory block. It must stay valid until nmd_x86_pipeline_stop() returns.
+ - memory_size   [in]  The size of the memory block in bytes.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_pipeline_start(nmd_x86_pipeline* pipeline, NMD_X86_MODE mode, uint32_t decoder_flags, uint32_t format_flags, void* memory, size_t memory_size)
+{
+	const size_t padding = (_NMD_X86_CACHE_LINE_SIZE - ((size_t)memory & (_NMD_X86_CACHE_LINE_SIZE - 1))) & (_NMD_X86_CACHE_LINE_SIZE - 1);
+	const size_t header_size = (sizeof(_nmd_x86_pipeline_state) + sizeof(_nmd_x86_pipeline_stage) * _NMD_X86_PIPELINE_NUM_STAGES + _NMD_X86_CACHE_LINE_SIZE - 1) & ~(size_t)(_NMD_X86_CACHE_LINE_SIZE - 1);
+	size_t capacity = 16, items_size = 0, i;
+	_nmd_x86_pipeline_state* state;
+	_nmd_x86_pipeline_stage* stages;
+	uint8_t* items;
+
+	pipeline->state = 0;
+	pipeline->capacity = 0;
+
+	for (i = 0; i <= _NMD_X86_PIPELINE_NUM_STAGES; i++)
+		items_size += _nmd_x86_pipeline_item_size(i);
+
+	if (memory_size < padding + header_size || (memory_size - padding - header_size) / items_size < capacity)
+		return 0;
+	while (capacity * 2 <= (memory_size - padding - header_size) / items_size)
+		capacity *= 2;
+
+	state = (_nmd_x86_pipeline_state*)((uint8_t*)memory + padding);
+	stages = (_nmd_x86_pipeline_stage*)(state + 1);
+	items = (uint8_t*)state + header_size;
+	for (i = 0; i <= _NMD_X86_PIPELINE_NUM_STAGES; i++)
+	{
+		state->rings[i].head = state->rings[i].tail = 0;
+		state->rings[i].items = items;
+		state->rings[i].item_size = _nmd_x86_pipeline_item_size(i);
+		state->rings[i].mask = capacity - 1;
+		items += capacity * state->rings[i].item_size;
 	}
-#endif /* NMD_ASSEMBLY_DISABLE_FORMATTER_ATT_SYNTAX */
 
-	size_t string_length = si.buffer - buffer;
-#ifndef NMD_ASSEMBLY_DISABLE_FORMATTER_UPPERCASE
-	if (flags & NMD_X86_FORMAT_FLAGS_UPPERCASE)
+	for (i = 0; i < _NMD_X86_PIPELINE_NUM_STAGES; i++)
+		state->done[i] = 0;
+	state->closed = 0;
+	state->abort = 0;
+	state->mode = mode;
+	state->decoder_flags = decoder_flags;
+	state->format_flags = format_flags;
+	state->next_address = NMD_X86_INVALID_RUNTIME_ADDRESS;
+	_NMD_MEMORY_BARRIER();
+
+	for (state->num_threads = 0; state->num_threads < _NMD_X86_PIPELINE_NUM_STAGES; state->num_threads++)
 	{
-		size_t i = 0;
-		for (; i < string_length; i++)
-		{
-			if (_NMD_IS_LOWERCASE(buffer[i]))
-				buffer[i] -= 0x20; /* Capitalize letter. */
-		}
+		_nmd_x86_pipeline_stage* const stage = &stages[state->num_threads];
+		stage->state = state;
+		stage->index = state->num_threads;
+#ifdef _WIN32
+		if (!(state->threads[state->num_threads] = CreateThread(0, 0, _nmd_x86_pipeline_thread_proc, stage, 0, 0)))
+			break;
+#else
+		if (pthread_create(&state->threads[state->num_threads], 0, _nmd_x86_pipeline_thread_proc, stage))
+			break;
+#endif /* _WIN32 */
 	}
-#endif /* NMD_ASSEMBLY_DISABLE_FORMATTER_UPPERCASE */
 
-#ifndef NMD_ASSEMBLY_DISABLE_FORMATTER_COMMA_SPACES
-	if (flags & NMD_X86_FORMAT_FLAGS_COMMA_SPACES)
+	pipeline->state = state;
+	if (state->num_threads < _NMD_X86_PIPELINE_NUM_STAGES)
 	{
-		size_t i = 0;
-		for (; i < string_length; i++)
-		{
-			if (buffer[i] == ',')
-			{
-				/* Move all characters after the comma one position to the right. */
-				size_t j = string_length;
-				for (; j > i; j--)
-					buffer[j] = buffer[j - 1];
+		nmd_x86_pipeline_stop(pipeline);
+		return 0;
+	}
 
-				buffer[i + 1] = ' ';
-				si.buffer++, string_length++;
-			}
-		}
+	return pipeline->capacity = capacity;
+}
+
+/*
+Queues a block of code. Returns the number of bytes queued, which is less than 'buffer_size' if the input ring is full. The bytes are copied, so 'buffer'
+can be reused after the call. Blocks whose runtime addresses are contiguous form a single instruction stream, so an instruction may be split between them.
+This function must not be called by more than one thread at a time.
+Parameters:
+ - pipeline        [in] A pointer to a pipeline started by nmd_x86_pipeline_start().
+ - buffer          [in] A pointer to a buffer containing encoded instructions.
+ - buffer_size     [in] The buffer's size in bytes.
+ - runtime_address [in] The runtime address of the buffer's first byte. You may use 'NMD_X86_INVALID_RUNTIME_ADDRESS'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_pipeline_push(nmd_x86_pipeline* pipeline, const void* buffer, size_t buffer_size, uint64_t runtime_address)
+{
+	_nmd_x86_pipeline_state* const state = (_nmd_x86_pipeline_state*)pipeline->state;
+	_nmd_x86_ring* const ring = &state->rings[_NMD_X86_PIPELINE_STAGE_LDISASM];
+	const uint8_t* b = (const uint8_t*)buffer;
+	size_t head = ring->head, offset = 0, i;
+
+	if (state->closed)
+		return 0;
+
+	while (offset < buffer_size && head - ring->tail <= ring->mask)
+	{
+		_nmd_x86_pipeline_block* const block = (_nmd_x86_pipeline_block*)_nmd_x86_ring_item(ring, head++);
+		const uint64_t address = _nmd_x86_pipeline_address(runtime_address, offset);
+
+		block->runtime_address = address;
+		block->size = (uint32_t)_NMD_MIN(buffer_size - offset, NMD_X86_PIPELINE_BLOCK_SIZE);
+		block->continued = offset || (address != NMD_X86_INVALID_RUNTIME_ADDRESS && address == state->next_address);
+		for (i = 0; i < block->size; i++)
+			block->bytes[i] = b[offset + i];
+
+		offset += block->size;
+		state->next_address = _nmd_x86_pipeline_address(address, block->size);
 	}
-#endif /* NMD_ASSEMBLY_DISABLE_FORMATTER_COMMA_SPACES */
 
-#ifndef NMD_ASSEMBLY_DISABLE_FORMATTER_OPERATOR_SPACES
-	if (flags & NMD_X86_FORMAT_FLAGS_OPERATOR_SPACES)
+	_nmd_x86_ring_publish(ring, head);
+
+	return offset;
+}
+
+/*
+Copies up to 'num_lines' formatted instructions to 'lines' in the order they were pushed. Returns the number of lines copied, which is zero if no line is ready.
+Invalid instructions are skipped one byte at a time, so they produce no lines. This function must not be called by more than one thread at a time.
+Parameters:
+ - pipeline  [in]  A pointer to a pipeline started by nmd_x86_pipeline_start().
+ - lines     [out] A pointer to an array of 'nmd_x86_pipeline_line' that receives the lines.
+ - num_lines [in]  The number of elements in 'lines'.
+*/
+NMD_ASSEMBLY_API size_t nmd_x86_pipeline_pop(nmd_x86_pipeline* pipeline, nmd_x86_pipeline_line* lines, size_t num_lines)
+{
+	_nmd_x86_pipeline_state* const state = (_nmd_x86_pipeline_state*)pipeline->state;
+	_nmd_x86_ring* const ring = &state->rings[_NMD_X86_PIPELINE_NUM_STAGES];
+	const size_t num_items = _nmd_x86_ring_num_items(ring);
+	const size_t num_popped = _NMD_MIN(num_items, num_lines);
+	size_t tail = ring->tail, i, j;
+
+	for (i = 0; i < num_popped; i++, tail++)
 	{
-		size_t i = 0;
-		for (; i < string_length; i++)
-		{
-			if (buffer[i] == '+' || (buffer[i] == '-' && buffer[i - 1] != ' ' && buffer[i - 1] != '('))
-			{
-				/* Move all characters after the operator two positions to the right. */
-				size_t j = string_length + 1;
-				for (; j > i; j--)
-					buffer[j] = buffer[j - 2];
+		const nmd_x86_pipeline_line* const line = (const nmd_x86_pipeline_line*)_nmd_x86_ring_item(ring, tail);
+		lines[i].runtime_address = line->runtime_address;
+		lines[i].length = line->length;
+		for (j = 0; j <= line->length; j++)
+			lines[i].string[j] = line->string[j];
+	}
 
-				buffer[i + 1] = buffer[i];
-				buffer[i] = ' ';
-				buffer[i + 2] = ' ';
-				si.buffer += 2, string_length += 2;
-				i++;
-			}
-		}
+	_nmd_x86_ring_release(ring, tail);
+
+	return num_popped;
+}
+
+/* Marks the end of the input. The stages process the queued bytes and exit, nmd_x86_pipeline_finished() returns true after the last line was popped. */
+NMD_ASSEMBLY_API void nmd_x86_pipeline_close(nmd_x86_pipeline* pipeline)
+{
+	_nmd_x86_pipeline_state* const state = (_nmd_x86_pipeline_state*)pipeline->state;
+	_NMD_MEMORY_BARRIER();
+	state->closed = 1;
+}
+
+/* Returns true if the pipeline was closed, every stage exited and every line was popped. */
+NMD_ASSEMBLY_API bool nmd_x86_pipeline_finished(nmd_x86_pipeline* pipeline)
+{
+	_nmd_x86_pipeline_state* const state = (_nmd_x86_pipeline_state*)pipeline->state;
+	const bool done = state->done[_NMD_X86_PIPELINE_NUM_STAGES - 1] != 0;
+	_NMD_MEMORY_BARRIER();
+	return done && !_nmd_x86_ring_num_items(&state->rings[_NMD_X86_PIPELINE_NUM_STAGES]);
+}
+
+/* Stops the pipeline and waits for its threads to exit. The queued bytes and lines that were not popped are discarded. The memory block can be reused after the call. */
+NMD_ASSEMBLY_API void nmd_x86_pipeline_stop(nmd_x86_pipeline* pipeline)
+{
+	_nmd_x86_pipeline_state* const state = (_nmd_x86_pipeline_state*)pipeline->state;
+	size_t i;
+
+	if (!state)
+		return;
+
+	state->closed = 1;
+	state->abort = 1;
+	_NMD_MEMORY_BARRIER();
+
+	for (i = 0; i < state->num_threads; i++)
+	{
+#ifdef _WIN32
+		WaitForSingleObject(state->threads[i], INFINITE);
+		CloseHandle(state->threads[i]);
+#else
+		pthread_join(state->threads[i], 0);
+#endif /* _WIN32 */
 	}
-#endif /* NMD_ASSEMBLY_DISABLE_FORMATTER_OPERATOR_SPACES */
 
-	*si.buffer = '\0';
+	pipeline->state = 0;
+	pipeline->capacity = 0;
 }
 
+#endif /* NMD_ASSEMBLY_ENABLE_THREADS */
+
+
 #endif /* NMD_ASSEMBLY_IMPLEMENTATION */
@@ -21,7 +21,11 @@ OpenGL Usage:
  You MUST call nmd_opengl_render() to issue draw calls that render the data in the drawlist.
  You may call nmd_opengl_create_texture() if a helper function for texture creation is desired.
  You may define the 'NMD_GRAPHICS_OPENGL_DONT_BACKUP_RENDER_STATE' macro if you don't mind the library overriding the render state.
- You may define the 'NMD_GRAPHICS_OPENGL_OPTIMIZE_RENDER_STATE' macro so the render state only changes when necessary. Note that this option may only be used if this library is the only component that uses OpenGL.
+ You may define the 'NMD_GRAPHICS_OPENGL_OPTIMIZE_RENDER_STATE' macro so the render state only changes when necessary(the known host state mode, see 'Render state'). Note that this option may only be used if this library is the only component that uses OpenGL
+ or if the other components call nmd_invalidate_render_state() when they change the render state.
+ You may define the 'NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS' macro so only the vertices and indices that changed since the previous frame are uploaded. The vertex and index buffers
+ are persistently mapped rings of 'NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT' segments synchronized with fences if glBufferStorage() is available(OpenGL 4.4 or 'GL_ARB_buffer_storage'),
+ otherwise the changed range is uploaded with glBufferSubData() and the buffer is orphaned when most of it changed. A copy of the previous frame is kept in memory to find what changed.
 
 D3D9 Usage:
  You MUST define the 'NMD_GRAPHICS_D3D9' macro once project-wise(compiler dependent) or for every include statement that you'll use any of the following functions.
@@ -30,7 +34,8 @@ D3D9 Usage:
  You MUST call nmd_d3d9_render() to issue draw calls that render the data in the drawlist.
  You may call nmd_d3d9_create_texture() if a helper function for texture creation is desired.
  You may define the 'NMD_GRAPHICS_D3D9_DONT_BACKUP_RENDER_STATE' macro if you don't mind the library overriding the render state.
- You may define the 'NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE' macro so the render state only changes when necessary. Note that this option may only be used if this library is the only component that uses Direct3D 9.
+ You may define the 'NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE' macro so the render state only changes when necessary(the known host state mode, see 'Render state'). Note that this option may only be used if this library is the only component that uses Direct3D 9
+ or if the other components call nmd_invalidate_render_state() when they change the render state.
 
 D3D11 Usage:
  You MUST define the 'NMD_GRAPHICS_D3D11' macro once project-wise(compiler dependent) or for every include statement that you'll use any of the following functions.
@@ -39,24 +44,93 @@ D3D11 Usage:
  You MUST call nmd_d3d11_render() to issue draw calls that render the data in the drawlist.
  You may call nmd_d3d11_create_texture() if a helper function for texture creation is desired.
  You may define the 'NMD_GRAPHICS_D3D11_DONT_BACKUP_RENDER_STATE' macro if you don't mind the library overriding the render state.
- You may define the 'NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE' macro so the render state only changes when necessary. Note that this option may only be used if this library is the only component that uses Direct3D 11.
+ You may define the 'NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE' macro so the render state only changes when necessary(the known host state mode, see 'Render state'). Note that this option may only be used if this library is the only component that uses Direct3D 11
+ or if the other components call nmd_invalidate_render_state() when they change the render state.
+
+Render state:
+ The renderers group the render state they use in the categories of the 'NMD_RENDER_STATE' enum. By default every category is backed up before rendering and restored after,
+ which requires querying the state of the graphics API every frame.
+ You may call nmd_set_render_state_backup() to specify which categories are backed up and restored, the other ones are left as the library set them.
+ You may call nmd_set_known_host_state(true) if the application tells the library which categories it changed since the previous frame by calling nmd_invalidate_render_state().
+ In this mode the renderers only set the categories that were restored or invalidated, otherwise every category is set every frame.
+ The 'NMD_GRAPHICS_XXX_OPTIMIZE_RENDER_STATE' macros enable this mode for a renderer at compile time, the 'NMD_GRAPHICS_XXX_DONT_BACKUP_RENDER_STATE' macros remove the backup code.
+ The texture and the scissor rectangle are only set when they differ from the ones of the previous draw command.
 
 Internals:
-The 'nmd_context'(acessible by nmd_get_context()) global variable holds the state of the entire library, it
+The current 'nmd_context'(acessible by nmd_get_context()) holds the state of the entire library, it
 contains a 'nmd_drawlist' variable which holds the vertex, index and command buffers. Each command buffer
 translate to a call to a rendering's API draw function. Shapes can be rendered in the drawlist by calling
 functions like nmd_add_line() and nmd_add_filled_rect().
 
+Contexts and threads:
+ Each thread has a current context, which is the default context until nmd_set_context() is called. You may create more contexts with nmd_init_context() to drive several windows
+ or to record geometry on worker threads: each thread calls nmd_set_context() with its own context and records a frame(nmd_new_frame(), primitives, nmd_end_frame()) into its draw list.
+ The thread that renders then calls nmd_append_draw_list() with the draw list of each context, in the order they should be drawn, and renders its own draw list.
+ A context must not be used by two threads at the same time. Contexts that record geometry in parallel should not share an allocator that is not thread-safe.
+ Free a context with nmd_destroy_context().
+
+Retained geometry:
+ Geometry that doesn't change between frames(e.g. static panels and labels) can be recorded once and appended to the draw list by later frames with a copy:
+    if (nmd_begin_retained(key))
+    {
+        nmd_add_rect_filled(...);
+        nmd_end_retained();
+    }
+ nmd_begin_retained() appends the recorded geometry and returns false when it's valid. nmd_add_retained() appends it at another position, nmd_invalidate_retained()
+ makes the next nmd_begin_retained() record it again. With 'NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS', geometry that is appended at the same place every frame is not uploaded again.
+
+Memory:
+ The library allocates memory through the allocator of the context, which uses NMD_MALLOC()/NMD_FREE() by default. You may call nmd_set_allocator() to specify your own allocator,
+ it must be called before any other function of the library allocates memory(e.g. before nmd_bake_font() and the first nmd_new_frame()).
+ The vertex, index, draw command and path buffers are allocated in a linear frame arena that is reset by nmd_new_frame(), so growing a buffer in a frame doesn't free memory
+ and the buffer at the top of the arena grows in place. When the arena is full the memory is allocated by the allocator and freed by the next nmd_new_frame(), which also
+ resizes the arena to the high-water mark(the largest amount of memory used by a frame), so a frame that doesn't need more memory than the previous ones doesn't allocate memory.
+ You may call nmd_set_frame_memory() to provide the arena's memory, it's never resized in this case. The high-water mark is 'nmd_get_context()->frame_arena.high_water'.
+
+Profiling:
+ 'nmd_get_context()->stats' holds counters of the current frame: nmd_new_frame() resets them, nmd_end_frame() sets the number of vertices, indices and draw commands
+ and the number of buffers that were copied because they could not grow in place, and the renderers add the number of textures they bound. Read them after rendering.
+ To time the library, pass a function to nmd_set_profiler(). It's called when nmd_new_frame(), nmd_end_frame() and the nmd_xxx_render() functions begin and end:
+    void profile(const char* zone, bool begin, void* user_data) { ... }
+    nmd_set_profiler(profile, user_data);
+ 'tests/graphics_benchmark.c' measures the time per frame of synthetic scenes of primitives, text and widgets.
+
 Fixed width integer types:
 By default the library includes <stdint.h> and <stddef.h> to include int types.
 If these header-files are not available in your environment you may define the 'NMD_DEFINE_INT_TYPES' macro so the library will define them.
 By defining the 'NMD_IGNORE_INT_TYPES' macro, the library will neither include nor define int types.
 
-Define the 'NMD_GRAPHICS_DISABLE_DEFAULT_ALLOCATOR' macro to tell the library not to include default allocators.
+Define the 'NMD_GRAPHICS_DISABLE_DEFAULT_ALLOCATOR' macro to tell the library not to include default allocators. In this case you MUST call nmd_set_allocator(), or nmd_set_frame_memory() if memory is only needed for the draw list's buffers.
 Define the 'NMD_GRAPHICS_DISABLE_FILE_IO' macro to tell the library not to support file operations for fonts.
-Define the 'NMD_GRAPHICS_AVOID_ALLOCA' macro to tell the library to use malloc/free instead of alloca
+Define the 'NMD_GRAPHICS_AVOID_ALLOCA' macro to tell the library to allocate temporary memory in the frame arena instead of using alloca
+SIMD tessellation:
+The normals and miters of polylines and anti-aliased fills, the vertices of their outlines, the points of arcs(circles, ngons) and the UVs of rounded images are computed
+by kernels that process several points at once when one of the following macros is defined, otherwise by scalar code:
+ - 'NMD_GRAPHICS_ENABLE_SSE2': Uses SSE2 intrinsics. This macro includes <emmintrin.h>.
+ - 'NMD_GRAPHICS_ENABLE_NEON': Uses NEON intrinsics(AArch64 only). This macro includes <arm_neon.h>.
+The points may differ from the scalar code by about a thousandth of a pixel, because the points of arcs are rotated instead of computed by NMD_COS()/NMD_SIN() for each point.
+
+Glyph cache:
+ nmd_bake_font() bakes the ASCII characters of one size into a fixed atlas. For Unicode text and several sizes, initialize a 'nmd_glyph_cache' with the renderer's
+ texture functions and a 'nmd_font' for each font face, then use nmd_add_text_cached() and nmd_get_text_size_cached():
+    nmd_glyph_cache_init(&cache, 0, nmd_opengl_create_texture, nmd_opengl_update_texture);
+    nmd_font_init(&font, &cache, font_data);
+    ...
+    nmd_add_text_cached(&font, 18.0f, x, y, "Hello", 0, NMD_COLOR_WHITE);
+    nmd_glyph_cache_upload(&cache);
+    nmd_opengl_render();
+ Glyphs are rasterized the first time they're used and only the rectangles that changed are uploaded. The textures are created when the text is added, so the graphics
+ API must be usable on that thread. A glyph cache is not thread-safe, contexts that record text on different threads should use different caches.
+
+Widget IDs:
+ Windows and widgets are identified by the hash of their name combined with the IDs on the ID stack. nmd_begin() puts the window's ID at the bottom of the stack, so widgets
+ with the same label in different windows have different IDs. Use nmd_push_id()/nmd_push_id_int() and nmd_pop_id() to tell apart widgets with the same label in a window(e.g. in a loop).
+ Windows are looked up in a hash map, and state that must persist between frames can be stored per ID with nmd_set_state_int()/nmd_set_state_float():
+    const uint32_t id = nmd_get_id("scroll");
+    nmd_set_state_float(id, nmd_get_state_float(id, 0.0f) + delta);
+
 Default fonts:
-The 'Karla' true type font in included by default. Define the 'NMD_GRAPHICS_DISABLE_DEFAULT_FONT' macro to remove the font at compile time.
+The 'Karla'' true type font in included by default. Define the 'NMD_GRAPHICS_DISABLE_DEFAULT_FONT' macro to remove the font at compile time.
 
 NOTE: A big part of this library's code has been derived from Imgui's and Nuklear's code. Huge credit to both projects.
 
@@ -113,7 +187,7 @@ Credits:
  #endif /* NMD_DEFINE_INT_TYPES */
 #endif /* _NMD_DEFINE_INT_TYPES */
 
-#ifndef NMD_MALLOC
+#if !defined(NMD_MALLOC) && !defined(NMD_GRAPHICS_DISABLE_DEFAULT_ALLOCATOR)
 #include <stdlib.h>
 #define NMD_MALLOC malloc
 #define NMD_FREE free
@@ -129,6 +203,11 @@ Credits:
 #define NMD_MEMCPY memcpy
 #endif /* NMD_MEMCPY */
 
+#ifndef NMD_MEMCMP
+#include <string.h>
+#define NMD_MEMCMP memcmp
+#endif /* NMD_MEMCMP */
+
 #ifndef NMD_STRLEN
 #include <string.h>
 #define NMD_STRLEN strlen
@@ -136,11 +215,21 @@ Credits:
 
 #ifndef NMD_GRAPHICS_AVOID_ALLOCA
     #ifndef NMD_ALLOCA
+    #ifdef _WIN32
     #include <malloc.h>
+    #else
+    #include <alloca.h>
+    #endif /* _WIN32 */
     #define NMD_ALLOCA alloca
     #endif /* NMD_ALLOCA */
 #endif /* NMD_GRAPHICS_AVOID_ALLOCA */
 
+#ifdef NMD_GRAPHICS_ENABLE_SSE2
+#include <emmintrin.h>
+#elif defined(NMD_GRAPHICS_ENABLE_NEON)
+#include <arm_neon.h>
+#endif /* NMD_GRAPHICS_ENABLE_SSE2 */
+
 #ifndef NMD_SPRINTF
 #include <stdio.h>
 #define NMD_SPRINTF sprintf
@@ -151,6 +240,9 @@ Credits:
 #define NMD_VSPRINTF vsprintf
 #endif /* NMD_VSPRINTF */
 
+/* nmd_text() takes a variable number of arguments */
+#include <stdarg.h>
+
 #ifndef NMD_SQRT
 #include <math.h>
 #define NMD_SQRT sqrt
@@ -171,12 +263,27 @@ Credits:
 #define NMD_SIN sin
 #endif /* NMD_SIN */
 
-#define STBTT_malloc(x,u) ((void)(u),NMD_MALLOC(x))
-#define STBTT_free(x,u) ((void)(u),NMD_FREE(x))
+#define STBTT_malloc(x,u) ((void)(u),_nmd_alloc(x))
+#define STBTT_free(x,u) ((void)(u),_nmd_free(x))
 #define STBTT_strlen(x) NMD_STRLEN(x)
 #define STBTT_memcpy NMD_MEMCPY
 #define STBTT_memset NMD_MEMSET
 
+/* The storage class of the pointer to the current context, so each thread has its own current context */
+#ifndef NMD_THREAD_LOCAL
+    #if defined(__cplusplus) && __cplusplus >= 201103L
+    #define NMD_THREAD_LOCAL thread_local
+    #elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+    #define NMD_THREAD_LOCAL _Thread_local
+    #elif defined(_MSC_VER)
+    #define NMD_THREAD_LOCAL __declspec(thread)
+    #elif defined(__GNUC__) || defined(__clang__)
+    #define NMD_THREAD_LOCAL __thread
+    #else
+    #define NMD_THREAD_LOCAL
+    #endif
+#endif /* NMD_THREAD_LOCAL */
+
 /* The number of points the buffer intially supports */
 #ifndef NMD_PATH_BUFFER_INITIAL_SIZE
 #define NMD_PATH_BUFFER_INITIAL_SIZE 32
@@ -202,6 +309,41 @@ Credits:
 #define NMD_WINDOWS_BUFFER_INITIAL_SIZE 4
 #endif /* NMD_WINDOWS_BUFFER_INITIAL_SIZE */
 
+/* The number of entries the window and widget state hash maps intially support. Must be a power of two */
+#ifndef NMD_ID_MAP_INITIAL_SIZE
+#define NMD_ID_MAP_INITIAL_SIZE 16
+#endif /* NMD_ID_MAP_INITIAL_SIZE */
+
+/* The maximum depth of the ID stack. IDs pushed beyond it are ignored */
+#ifndef NMD_ID_STACK_SIZE
+#define NMD_ID_STACK_SIZE 32
+#endif /* NMD_ID_STACK_SIZE */
+
+/* The number of retained geometry entries the buffer intially supports */
+#ifndef NMD_RETAINED_BUFFER_INITIAL_SIZE
+#define NMD_RETAINED_BUFFER_INITIAL_SIZE 8
+#endif /* NMD_RETAINED_BUFFER_INITIAL_SIZE */
+
+/* The width and height in pixels of the pages of a glyph cache when nmd_glyph_cache_init() is called with zero */
+#ifndef NMD_GLYPH_PAGE_SIZE
+#define NMD_GLYPH_PAGE_SIZE 1024
+#endif /* NMD_GLYPH_PAGE_SIZE */
+
+/* The number of bytes of laid out strings a glyph cache keeps(each byte needs at most one quad). When it's exceeded, the layouts are discarded */
+#ifndef NMD_TEXT_LAYOUT_CACHE_SIZE
+#define NMD_TEXT_LAYOUT_CACHE_SIZE 65536
+#endif /* NMD_TEXT_LAYOUT_CACHE_SIZE */
+
+/* The alignment in bytes of the allocations in the frame arena */
+#ifndef NMD_FRAME_ARENA_ALIGNMENT
+#define NMD_FRAME_ARENA_ALIGNMENT 16
+#endif /* NMD_FRAME_ARENA_ALIGNMENT */
+
+/* The number of frames the GPU may be rendering while the next one is recorded when 'NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS' is defined */
+#ifndef NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT
+#define NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT 3
+#endif /* NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT */
+
 #ifdef _WIN32
 #include <Windows.h>
 LRESULT nmd_win32_wnd_proc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
@@ -214,6 +356,7 @@ typedef void* nmd_tex_id;
 bool nmd_opengl_resize(int width, int height);
 void nmd_opengl_render();
 nmd_tex_id nmd_opengl_create_texture(void* pixels, int width, int height);
+void nmd_opengl_update_texture(nmd_tex_id texture, const void* pixels, int x, int y, int width, int height, int pitch);
 #endif /* NMD_GRAPHICS_OPENGL */
 
 #ifdef NMD_GRAPHICS_D3D9
@@ -222,6 +365,7 @@ void nmd_d3d9_set_device(LPDIRECT3DDEVICE9 pDevice);
 void nmd_d3d9_resize(int width, int height);
 void nmd_d3d9_render();
 nmd_tex_id nmd_d3d9_create_texture(void* pixels, int width, int height);
+void nmd_d3d9_update_texture(nmd_tex_id texture, const void* pixels, int x, int y, int width, int height, int pitch);
 #endif /* NMD_GRAPHICS_D3D9 */
 
 #ifdef NMD_GRAPHICS_D3D11
@@ -231,6 +375,7 @@ bool nmd_d3d11_resize(int width, int height);
 void nmd_d3d11_render();
 void nmd_d3d11_delete_objects();
 nmd_tex_id nmd_d3d11_create_texture(void* pixels, int width, int height);
+void nmd_d3d11_update_texture(nmd_tex_id texture, const void* pixels, int x, int y, int width, int height, int pitch);
 #endif /* NMD_GRAPHICS_D3D11 */
 
 enum NMD_CORNER
@@ -250,6 +395,22 @@ enum NMD_CORNER
     NMD_CORNER_ALL          = (1 << 5) - 1
 };
 
+/* The categories of render state set by the renderers. See nmd_set_render_state_backup(), nmd_set_known_host_state() and nmd_invalidate_render_state(). */
+enum NMD_RENDER_STATE
+{
+    NMD_RENDER_STATE_NONE       = 0,
+    NMD_RENDER_STATE_SHADERS    = (1 << 0), /* The program/shaders and their constant buffers. */
+    NMD_RENDER_STATE_TEXTURE    = (1 << 1), /* The texture bound to the first unit/stage and the texture stage states. */
+    NMD_RENDER_STATE_SAMPLER    = (1 << 2), /* The sampler of the first unit/stage. */
+    NMD_RENDER_STATE_BUFFERS    = (1 << 3), /* The vertex and index buffers, the vertex layout and the primitive topology. */
+    NMD_RENDER_STATE_BLEND      = (1 << 4), /* Alpha blending. */
+    NMD_RENDER_STATE_RASTERIZER = (1 << 5), /* Face culling, depth testing, the scissor test and the fill mode. */
+    NMD_RENDER_STATE_VIEWPORT   = (1 << 6), /* The viewport and the projection matrix. */
+    NMD_RENDER_STATE_SCISSOR    = (1 << 7), /* The scissor rectangle. */
+
+    NMD_RENDER_STATE_ALL        = (1 << 8) - 1
+};
+
 typedef struct
 {
     float x, y;
@@ -268,13 +429,12 @@ typedef struct
 
 typedef struct
 {
-    /* 'num_vertices' has the type 'nmd_index' because the number of vertices is always less or equal the number of indices. */
-    nmd_index num_vertices; 
-
-    nmd_index num_indices;
+    size_t num_vertices; /* The number of vertices added by the command. */
+    size_t num_indices;
+    size_t vertex_offset; /* The indices are relative to this vertex(the base vertex of the draw call), so a command can use more than 'nmd_index' can address. */
     nmd_tex_id user_texture_id;
 
-    nmd_rect rect;
+    nmd_rect rect; /* The clip rect. 'p1.x' is -1 if the command has no clip rect. */
     
 } nmd_draw_command;
 
@@ -301,6 +461,98 @@ typedef struct
     nmd_tex_id font_id;
 } nmd_atlas;
 
+/* A node of the skyline of a glyph page: the segment of 'width' pixels at 'x' is used up to 'y' */
+typedef struct
+{
+    int x, y, width;
+} nmd_skyline_node;
+
+/* A texture of the glyph cache */
+typedef struct
+{
+    nmd_tex_id texture; /* The texture created by the glyph cache's 'create_texture' callback */
+    nmd_color* pixels; /* The pixels of the texture('page_size' x 'page_size') */
+    nmd_skyline_node* skyline; /* The skyline used to pack the glyphs, sorted by 'x' */
+    size_t num_nodes; /* The number of nodes in the 'skyline' array */
+    int dirty_x0, dirty_y0, dirty_x1, dirty_y1; /* The rectangle of pixels that changed since the last upload. It's empty if 'dirty_x0' >= 'dirty_x1' */
+} nmd_glyph_page;
+
+/* A glyph rasterized in the glyph cache. An entry of the glyph hash table is empty if 'font_id' is zero */
+typedef struct
+{
+    uint32_t font_id;
+    uint32_t codepoint;
+    float size;
+    nmd_tex_id texture; /* The texture of the page the glyph is in. It's null if the glyph has no pixels(e.g. space) */
+    float x0, y0, x1, y1; /* The quad relative to the pen position on the baseline */
+    float u0, v0, u1, v1;
+    float advance;
+} nmd_glyph;
+
+/* A quad of a laid out string */
+typedef struct
+{
+    float x0, y0, x1, y1; /* The quad relative to the position of the string */
+    float u0, v0, u1, v1;
+    nmd_tex_id texture;
+} nmd_glyph_quad;
+
+/* The quads of a laid out string. An entry of the layout hash table is empty if 'font_id' is zero */
+typedef struct
+{
+    uint64_t hash; /* The hash of the string */
+    size_t length; /* The length of the string in bytes */
+    size_t first_char; /* The index of the string's first byte in the glyph cache's 'text' array, so a hash collision is not taken as a match */
+    uint32_t font_id;
+    float size;
+    size_t first_quad; /* The index of the first quad in the glyph cache's 'quads' array */
+    size_t num_quads;
+    nmd_vec2 text_size; /* The size returned by nmd_get_text_size_cached() */
+} nmd_text_layout;
+
+/*
+Rasterizes glyphs on demand and packs them in textures('pages') with a skyline packer. A new page is added when a glyph doesn't fit in the existing ones.
+Laid out strings are cached by(string, font, size), so a string that is measured and drawn or drawn every frame is only laid out once.
+*/
+typedef struct
+{
+    int page_size; /* The width and height of the pages in pixels */
+    nmd_tex_id (*create_texture)(void* pixels, int width, int height); /* Creates the texture of a page(e.g. nmd_opengl_create_texture) */
+    void (*update_texture)(nmd_tex_id texture, const void* pixels, int x, int y, int width, int height, int pitch); /* Updates a rectangle of a texture(e.g. nmd_opengl_update_texture) */
+
+    nmd_glyph_page* pages;
+    size_t num_pages;
+    size_t pages_capacity;
+
+    nmd_glyph* glyphs; /* A hash table of glyphs */
+    size_t num_glyphs;
+    size_t glyphs_capacity; /* The number of entries in the 'glyphs' table, a power of two */
+
+    nmd_text_layout* layouts; /* A hash table of laid out strings */
+    size_t num_layouts;
+    size_t layouts_capacity; /* The number of entries in the 'layouts' table, a power of two */
+
+    nmd_glyph_quad* quads; /* The quads of the laid out strings */
+    size_t num_quads;
+    size_t quads_capacity;
+
+    char* text; /* The bytes of the laid out strings */
+    size_t text_length;
+    size_t text_capacity;
+
+    uint32_t next_font_id;
+} nmd_glyph_cache;
+
+/* A font face whose glyphs are rasterized by a glyph cache at any size. */
+typedef struct
+{
+    nmd_glyph_cache* cache;
+    const void* data; /* The TrueType data. It must stay valid while the font is used */
+    void* info; /* internal */
+    uint32_t id; /* Identifies the font in the glyph cache */
+    int ascent, descent; /* Unscaled vertical metrics */
+} nmd_font;
+
 typedef struct
 {
     bool line_anti_aliasing; /* If true, all lines will have AA applied to them. */
@@ -326,6 +578,11 @@ typedef struct
     size_t num_draw_commands; /* number of draw commands in the 'draw_commands' buffer. */
     size_t draw_commands_capacity; /* size of the 'draw_commands' buffer in bytes. */
 
+    size_t num_accounted_vertices; /* number of vertices in draw commands. */
+    size_t num_accounted_indices; /* number of indices in draw commands. */
+    size_t vertex_offset; /* the vertex new indices are relative to. */
+    size_t num_pending_draw_commands; /* number of draw commands at the end of the buffer whose texture and clip rect are set by the next push. */
+
     nmd_atlas default_atlas;
     nmd_tex_id blank_tex_id;
 
@@ -370,21 +627,124 @@ typedef struct
     nmd_vec2 window_move_delta; /* The delta pos between the top left corner of the window being moved and the mouse's position when it was pressed*/
 } nmd_io;
 
+/* An entry of a 'nmd_id_map'. The entry is empty if 'key' is zero */
+typedef struct
+{
+    uint32_t key;
+    union
+    {
+        int i;
+        float f;
+        size_t index;
+    } value;
+} nmd_id_map_entry;
+
+/* A hash map with open addressing(linear probing) from IDs to values */
+typedef struct
+{
+    nmd_id_map_entry* entries; /* An array of 'capacity' entries */
+    size_t num_entries; /* The number of entries that are not empty */
+    size_t capacity; /* The capacity of the 'entries' array. It's a power of two */
+} nmd_id_map;
+
 typedef struct
 {
     nmd_window* window; /* The current window being accessed */
     nmd_window* windows; /* An array of windows */
     size_t num_windows; /* The number of windows in the 'windows' array */
     size_t windows_capacity; /* The capacity of the 'windows' array */
+    nmd_id_map window_map; /* Maps window IDs to indices of the 'windows' array */
+    nmd_id_map state_map; /* Maps widget IDs to the state set by nmd_set_state_int()/nmd_set_state_float() */
+    uint32_t id_stack[NMD_ID_STACK_SIZE]; /* The seeds of the IDs computed by nmd_get_id() */
+    size_t id_stack_size; /* The number of IDs pushed on the ID stack, it may be bigger than NMD_ID_STACK_SIZE */
+    uint32_t active_id; /* The ID of the widget held by the mouse, zero if none */
     nmd_vec2 window_pos; /* The window's initial position */
     char fmt_buffer[1024]; /* temporary buffer */
 } nmd_gui;
 
+/* Geometry recorded by nmd_begin_retained()/nmd_end_retained() that is appended to the draw list instead of being tessellated again. */
+typedef struct
+{
+    uint32_t key; /* The key the geometry was recorded under */
+    bool valid; /* False if the geometry was invalidated and must be recorded again */
+    void* block; /* The memory of the vertices, indices and draw commands, allocated by the allocator */
+    size_t block_size; /* The size of 'block' in bytes */
+    nmd_vertex* vertices;
+    size_t num_vertices;
+    nmd_index* indices;
+    size_t num_indices;
+    nmd_draw_command* draw_commands; /* The draw commands. 'vertex_offset' is relative to the first vertex */
+    size_t num_draw_commands;
+} nmd_retained_geometry;
+
+typedef struct
+{
+    nmd_retained_geometry* entries; /* An array of retained geometry */
+    size_t num_entries; /* The number of entries in the 'entries' array */
+    size_t capacity; /* The capacity of the 'entries' array */
+    nmd_retained_geometry* recording; /* The geometry being recorded, or a null pointer */
+    size_t first_vertex; /* The first vertex in the draw list of the geometry being recorded */
+    size_t first_index; /* The first index in the draw list of the geometry being recorded */
+    size_t first_draw_command; /* The first draw command in the draw list of the geometry being recorded */
+} nmd_retained;
+
+typedef struct
+{
+    uint32_t known; /* The categories('NMD_RENDER_STATE_XXX') that still have the state set by the renderer. */
+    uint32_t skip_backup; /* The categories that are not backed up and restored by the renderer. */
+    bool known_host_state; /* If true, the application calls nmd_invalidate_render_state() when it changes the render state. */
+    nmd_tex_id texture; /* The texture bound by the renderer if 'known' has 'NMD_RENDER_STATE_TEXTURE'. */
+    nmd_rect scissor; /* The clip rect of the scissor set by the renderer if 'known' has 'NMD_RENDER_STATE_SCISSOR'. */
+} nmd_render_state;
+
+/* Allocates and frees memory. 'user_data' is passed to both functions. */
+typedef struct
+{
+    void* (*alloc)(void* user_data, size_t size); /* Returns a pointer to a block of 'size' bytes, or a null pointer if the allocation fails. */
+    void (*free)(void* user_data, void* ptr); /* Frees a block returned by 'alloc'. */
+    void* user_data;
+} nmd_allocator;
+
+/* A linear allocator for the memory used by one frame. nmd_new_frame() frees all of it at once. */
+typedef struct
+{
+    void* block; /* The block allocated by the allocator, or a null pointer if the memory is provided by the application. */
+    uint8_t* memory; /* The arena's memory, aligned to 'NMD_FRAME_ARENA_ALIGNMENT'. */
+    size_t size; /* The size of 'memory' in bytes. */
+    size_t used; /* The number of bytes of 'memory' used by the current frame. */
+    void* overflow; /* The blocks allocated by the allocator when 'memory' was full. They're freed by nmd_new_frame(). */
+    size_t overflow_size; /* The number of bytes in the 'overflow' blocks. */
+    size_t unused; /* The number of bytes of the buffers that were moved when they grew and of the released temporary memory that could not be reused. */
+    size_t high_water; /* The largest number of bytes in use at the same time by a frame, including the 'overflow' blocks. */
+    bool user_memory; /* True if 'memory' was provided by nmd_set_frame_memory(). */
+} nmd_frame_arena;
+
+/* Counters of a frame. See 'Profiling' at the top of the file. */
+typedef struct
+{
+    size_t num_vertices; /* The number of vertices in the draw list */
+    size_t num_indices; /* The number of indices in the draw list */
+    size_t num_draw_commands; /* The number of draw commands in the draw list */
+    size_t num_reallocations; /* The number of buffers in the frame arena that were copied because they could not grow in place */
+    size_t num_texture_binds; /* The number of textures bound by the renderers */
+} nmd_frame_stats;
+
+/* Called with 'begin' true when a profiled function(e.g. "nmd_new_frame") begins and with 'begin' false when it ends. 'user_data' is the pointer passed to nmd_set_profiler(). */
+typedef void (*nmd_profiler)(const char* zone, bool begin, void* user_data);
+
 typedef struct
 {
+    nmd_allocator allocator; /* The allocator used for all memory. If 'alloc' is null, the default allocator(NMD_MALLOC()/NMD_FREE()) is used */
+    nmd_frame_arena frame_arena; /* The memory of the draw list's buffers */
     nmd_drawlist draw_list; /* Vertices, indices, draw commands */
+    nmd_render_state render_state; /* The render state tracked by the renderers */
     nmd_io io; /* IO data */
     nmd_gui gui; /* Windows, gui related data */
+    nmd_retained retained; /* Retained geometry */
+    bool initialized; /* True if the context was initialized by nmd_new_frame() */
+    nmd_frame_stats stats; /* Counters of the current frame */
+    nmd_profiler profiler; /* The function set by nmd_set_profiler(), or a null pointer */
+    void* profiler_user_data; /* The 'user_data' passed to 'profiler' */
 
 #ifdef _WIN32
     HWND hWnd;
@@ -455,8 +815,76 @@ void nmd_prim_quad_uv(float x0, float y0, float x1, float y1, float x2, float y2
 nmd_color nmd_rgb(uint8_t r, uint8_t g, uint8_t b);
 nmd_color nmd_rgba(uint8_t r, uint8_t g, uint8_t b, uint8_t a);
 
+/* Returns the current context of the calling thread. */
 nmd_context* nmd_get_context();
 
+/*
+Makes 'context' the current context of the calling thread. All functions of the library use the current context.
+If 'context' is null, the default context is used, which is also the current context of threads that didn't call this function.
+*/
+void nmd_set_context(nmd_context* context);
+
+/*
+Initializes a context. The context uses the allocator, the render state settings, the blank texture and the default atlas of the current context, so the textures
+created by the renderers can be used by the draw lists of all contexts.
+*/
+void nmd_init_context(nmd_context* context);
+
+/* Frees the memory allocated by a context. The context can be used again after calling nmd_init_context(). */
+void nmd_destroy_context(nmd_context* context);
+
+/*
+Appends the draw commands, vertices and indices of 'draw_list' to the draw list of the current context, so draw lists recorded by other contexts(e.g. on worker threads)
+are rendered by one render call. nmd_end_frame() must have been called for 'draw_list'. Returns false if memory could not be allocated.
+*/
+bool nmd_append_draw_list(const nmd_drawlist* draw_list);
+
+/*
+If geometry was recorded under 'key' and it was not invalidated, it's appended to the draw list and false is returned.
+Otherwise the geometry added until nmd_end_retained() is recorded under 'key' and true is returned. Recording can't be nested.
+*/
+bool nmd_begin_retained(uint32_t key);
+
+/* Ends the recording started by nmd_begin_retained(). */
+void nmd_end_retained();
+
+/* Appends the geometry recorded under 'key' translated by('x', 'y'). Returns false if there's no valid geometry for 'key' or memory could not be allocated. */
+bool nmd_add_retained(uint32_t key, float x, float y);
+
+/* Invalidates the geometry recorded under 'key', so the next nmd_begin_retained() with this key records it again. */
+void nmd_invalidate_retained(uint32_t key);
+
+/* Frees the memory of all retained geometry. */
+void nmd_free_retained();
+
+/*
+Specifies the allocator used for all memory. If 'allocator' is null, the default allocator(NMD_MALLOC()/NMD_FREE()) is used.
+This function must be called before any other function of the library allocates memory, because memory is freed by the allocator that is set when it's freed.
+*/
+void nmd_set_allocator(const nmd_allocator* allocator);
+
+/* Sets the function called when nmd_new_frame(), nmd_end_frame() and the nmd_xxx_render() functions begin and end. 'profiler' may be null to stop profiling. */
+void nmd_set_profiler(nmd_profiler profiler, void* user_data);
+
+/*
+Specifies the memory of the frame arena, which is never resized. If 'memory' is null, the arena's memory is allocated by the allocator.
+Allocations that don't fit in the arena are made by the allocator, so 'size' should be at least 'nmd_get_context()->frame_arena.high_water' bytes.
+The memory must stay valid until nmd_set_frame_memory() is called again and the next nmd_new_frame() returns.
+*/
+void nmd_set_frame_memory(void* memory, size_t size);
+
+/* Specifies the categories of render state('NMD_RENDER_STATE_XXX') the renderers back up before rendering and restore after. The default is 'NMD_RENDER_STATE_ALL'. */
+void nmd_set_render_state_backup(uint32_t state_mask);
+
+/*
+Enables or disables the known host state mode. In this mode the renderers assume the render state they set is kept between frames,
+so they only set the categories that were restored or passed to nmd_invalidate_render_state() since the previous frame.
+*/
+void nmd_set_known_host_state(bool enable);
+
+/* Tells the renderers the application changed the categories of render state('NMD_RENDER_STATE_XXX') in 'state_mask', so they're set again by the next render call. */
+void nmd_invalidate_render_state(uint32_t state_mask);
+
 /* Specifies the begin of the window. Widgets can be added after calling this function. Returns true if the window is not minimized */
 bool nmd_begin(const char* window_name);
 
@@ -475,6 +903,30 @@ bool nmd_checkbox(const char* label, bool* checked);
 /* Adds a float slider widget. Returns true if the value changes. */
 bool nmd_slider_float(const char* label, float* value, float min_value, float max_value);
 
+/* Returns the ID of 'str' combined with the ID at the top of the ID stack. The ID is never zero. */
+uint32_t nmd_get_id(const char* str);
+
+/* Pushes the ID of 'str' on the ID stack, so widgets added until nmd_pop_id() have different IDs than widgets with the same label outside. */
+void nmd_push_id(const char* str);
+
+/* Pushes the ID of the integer 'id' on the ID stack. */
+void nmd_push_id_int(int id);
+
+/* Pops the ID pushed by the last nmd_push_id()/nmd_push_id_int(). */
+void nmd_pop_id();
+
+/* Returns the integer stored under 'id' by nmd_set_state_int(), or 'default_value' if there's none. */
+int nmd_get_state_int(uint32_t id, int default_value);
+
+/* Stores an integer under 'id' that persists between frames. */
+void nmd_set_state_int(uint32_t id, int value);
+
+/* Returns the float stored under 'id' by nmd_set_state_float(), or 'default_value' if there's none. */
+float nmd_get_state_float(uint32_t id, float default_value);
+
+/* Stores a float under 'id' that persists between frames. */
+void nmd_set_state_float(uint32_t id, float value);
+
 /* Starts a new empty scene/frame. Internally this function clears all vertices, indices and command buffers. */
 void nmd_new_frame();
 
@@ -482,18 +934,51 @@ void nmd_new_frame();
 void nmd_end_frame();
 
 /*
-Creates one or more draw commands for the unaccounted vertices and indices.
+Creates a draw command for the unaccounted vertices and indices. If the last draw command has the same texture and clip rect, it's extended instead.
 Parameters:
  clip_rect [opt/in] A pointer to a rect that specifies the clip area. This parameter can be null.
 */
 void nmd_push_draw_command(const nmd_rect* clip_rect);
 
+/*
+Same as nmd_push_draw_command(), but the draw command uses the texture 'user_texture_id'.
+Parameters:
+ user_texture_id [in]     The texture of the draw command.
+ clip_rect       [opt/in] A pointer to a rect that specifies the clip area. This parameter can be null.
+*/
 void nmd_push_texture_draw_command(nmd_tex_id user_texture_id, const nmd_rect* clip_rect);
 
 bool nmd_bake_font_from_memory(const void* font_data, nmd_atlas* atlas, float size);
 
 bool nmd_bake_font(const char* font_path, nmd_atlas* atlas, float size);
 
+/*
+Initializes a glyph cache. 'page_size' is the width and height of the textures, or zero for 'NMD_GLYPH_PAGE_SIZE'. The textures are created by 'create_texture'
+when a page is added, and the rectangles that changed are uploaded by 'update_texture' when nmd_glyph_cache_upload() is called.
+*/
+void nmd_glyph_cache_init(nmd_glyph_cache* cache, int page_size, nmd_tex_id(*create_texture)(void* pixels, int width, int height), void (*update_texture)(nmd_tex_id texture, const void* pixels, int x, int y, int width, int height, int pitch));
+
+/* Frees the memory of a glyph cache. The textures are not released. */
+void nmd_glyph_cache_destroy(nmd_glyph_cache* cache);
+
+/* Removes all glyphs and laid out strings. The pages are kept and reused. */
+void nmd_glyph_cache_clear(nmd_glyph_cache* cache);
+
+/* Uploads the pixels that changed since the last call. Call it before rendering the draw list. */
+void nmd_glyph_cache_upload(nmd_glyph_cache* cache);
+
+/* Initializes a font from TrueType data. The data must stay valid while the font is used. Returns false if the data is not a valid font. */
+bool nmd_font_init(nmd_font* font, nmd_glyph_cache* cache, const void* font_data);
+
+/* Frees the memory of a font. */
+void nmd_font_destroy(nmd_font* font);
+
+/* Adds UTF-8 text of 'size' pixels. 'y' is the baseline. The glyphs are rasterized by the font's glyph cache the first time they're used. */
+void nmd_add_text_cached(const nmd_font* font, float size, float x, float y, const char* text, const char* text_end, nmd_color color);
+
+/* Returns the width of UTF-8 text(the advance of the pen) and the height of a line of 'size' pixels. */
+void nmd_get_text_size_cached(const nmd_font* font, float size, const char* text, const char* text_end, nmd_vec2* size_out);
+
 #define NMD_COLOR_BLACK                 nmd_rgb(  0,   0,   0)
 #define NMD_COLOR_WHITE                 nmd_rgb(255, 255, 255)
 #define NMD_COLOR_RED                   nmd_rgb(255,   0,   0)
@@ -537,6 +1022,13 @@ bool nmd_bake_font(const char* font_path, nmd_atlas* atlas, float size);
 
 #define _NMD_OFFSETOF(TYPE, NAME) (&((TYPE*)0)->NAME)
 
+/* Used by stb_truetype */
+void* _nmd_alloc(size_t size);
+void _nmd_free(void* ptr);
+
+/* Used by nmd_destroy_context() */
+void _nmd_id_map_free(nmd_id_map* map);
+
 
 #define STB_TRUETYPE_IMPLEMENTATION
 
@@ -5567,8 +6059,8 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 
-nmd_context _nmd_context;
-bool _nmd_initialized = false;
+nmd_context _nmd_default_context;
+NMD_THREAD_LOCAL nmd_context* _nmd_context = &_nmd_default_context;
 
 nmd_color nmd_rgb(uint8_t r, uint8_t g, uint8_t b)
 {
@@ -5586,205 +6078,593 @@ nmd_color nmd_rgba(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
     return color;
 }
 
+/* Returns the current context of the calling thread. */
 nmd_context* nmd_get_context()
 {
-    return &_nmd_context;
+    return _nmd_context;
 }
 
 /*
-Creates one or more draw commands for the unaccounted vertices and indices.
-Parameters:
- clip_rect [opt/in] A pointer to a rect that specifies the clip area. This parameter can be null.
+Makes 'context' the current context of the calling thread. All functions of the library(except the ones that take a context) use the current context.
+If 'context' is null, the default context is used, which is also the current context of threads that didn't call this function.
 */
-void nmd_push_draw_command(const nmd_rect* clip_rect)
+void nmd_set_context(nmd_context* context)
 {
-    /* Calculate the number of vertices and indices present in draw commands */
-    size_t num_accounted_vertices = 0, num_accounted_indices = 0;
-    size_t i = 0;
-    for (; i < _nmd_context.draw_list.num_draw_commands; i++)
+    if (!context)
+        context = &_nmd_default_context;
+
+    /* The renderers may have rendered another context, so the render state they set is not known */
+    if (context != _nmd_context)
     {
-        num_accounted_vertices += _nmd_context.draw_list.draw_commands[i].num_vertices;
-        num_accounted_indices += _nmd_context.draw_list.draw_commands[i].num_indices;
+        _nmd_context = context;
+        _nmd_context->render_state.known = NMD_RENDER_STATE_NONE;
     }
+}
 
-    /* Calculate the number of vertices and indices NOT present in draw commands */
-    size_t num_unaccounted_indices = _nmd_context.draw_list.num_indices - num_accounted_indices;
+/*
+Specifies the allocator used for all memory. If 'allocator' is null, the default allocator(NMD_MALLOC()/NMD_FREE()) is used.
+This function must be called before any other function of the library allocates memory, because memory is freed by the allocator that is set when it's freed.
+*/
+void nmd_set_allocator(const nmd_allocator* allocator)
+{
+    if (allocator)
+        _nmd_context->allocator = *allocator;
+    else
+        NMD_MEMSET(&_nmd_context->allocator, 0, sizeof(nmd_allocator));
+}
 
-    /* Create draw commands until all vertices and indices are present in draw commands */
-    while (num_unaccounted_indices > 0)
-    {
-        /* If the number of unaccounted indices is less than the maximum number of indices that can be hold by 'nmd_index'(usually 2^16) */
-        if (num_unaccounted_indices < (1 << (8 * sizeof(nmd_index))))
-        {
-            /* Add draw command */
-            _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].num_vertices = _nmd_context.draw_list.num_vertices - num_accounted_vertices;
-            _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].num_indices = _nmd_context.draw_list.num_indices - num_accounted_indices;
-            _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].user_texture_id = _nmd_context.draw_list.blank_tex_id;
-            if (clip_rect)
-                _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].rect = *clip_rect;
-            else
-                _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].rect.p1.x = -1.0f;
+void nmd_set_profiler(nmd_profiler profiler, void* user_data)
+{
+    _nmd_context->profiler = profiler;
+    _nmd_context->profiler_user_data = user_data;
+}
 
-            _nmd_context.draw_list.num_draw_commands++;
-            return;
-        }
-        else
-        {
-            size_t num_indices = (1 << (8 * sizeof(nmd_index)));
-            nmd_index last_index = _nmd_context.draw_list.indices[num_indices - 1];
+/* Calls the profiler of the context, if any, when the function 'zone' begins('begin' is true) or ends */
+void _nmd_profile(const char* zone, bool begin)
+{
+    if (_nmd_context->profiler)
+        _nmd_context->profiler(zone, begin, _nmd_context->profiler_user_data);
+}
 
-            bool is_last_index_referenced = false;
-            do
-            {
-                for (size_t i = num_indices; i < num_unaccounted_indices; i++)
-                {
-                    if (_nmd_context.draw_list.indices[i] == last_index)
-                    {
-                        is_last_index_referenced = true;
-                        num_indices -= 3;
-                        last_index = _nmd_context.draw_list.indices[num_indices - 1];
-                        break;
-                    }
-                }
-            } while (is_last_index_referenced);
+/* Allocates memory with the allocator of the context. Returns a null pointer if the allocation fails. */
+void* _nmd_alloc(size_t size)
+{
+    if (_nmd_context->allocator.alloc)
+        return _nmd_context->allocator.alloc(_nmd_context->allocator.user_data, size);
 
-            _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].num_vertices = last_index + 1;
-            _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].num_indices = num_indices;
-            _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].user_texture_id = _nmd_context.draw_list.blank_tex_id;
+#ifndef NMD_GRAPHICS_DISABLE_DEFAULT_ALLOCATOR
+    return NMD_MALLOC(size);
+#else
+    return 0;
+#endif /* NMD_GRAPHICS_DISABLE_DEFAULT_ALLOCATOR */
+}
 
-            _nmd_context.draw_list.num_draw_commands++;
+/* Frees memory allocated by _nmd_alloc(). 'ptr' may be null. */
+void _nmd_free(void* ptr)
+{
+    if (!ptr)
+        return;
 
-            num_unaccounted_indices -= num_indices;
-        }
-    }
+    if (_nmd_context->allocator.alloc)
+        _nmd_context->allocator.free(_nmd_context->allocator.user_data, ptr);
+#ifndef NMD_GRAPHICS_DISABLE_DEFAULT_ALLOCATOR
+    else
+        NMD_FREE(ptr);
+#endif /* NMD_GRAPHICS_DISABLE_DEFAULT_ALLOCATOR */
 }
 
-void nmd_push_texture_draw_command(nmd_tex_id user_texture_id, const nmd_rect* clip_rect)
+#define _NMD_FRAME_ALIGN(size) (((size) + (NMD_FRAME_ARENA_ALIGNMENT - 1)) & ~(size_t)(NMD_FRAME_ARENA_ALIGNMENT - 1))
+
+/*
+Specifies the memory of the frame arena, which is never resized. If 'memory' is null, the arena's memory is allocated by the allocator.
+Allocations that don't fit in the arena are made by the allocator, so 'size' should be at least 'nmd_get_context()->frame_arena.high_water' bytes.
+The memory must stay valid until nmd_set_frame_memory() is called again and the next nmd_new_frame() returns.
+*/
+void nmd_set_frame_memory(void* memory, size_t size)
 {
-    size_t num_accounted_vertices = 0, num_accounted_indices = 0;
-    size_t i = 0;
-    for (; i < _nmd_context.draw_list.num_draw_commands; i++)
+    nmd_frame_arena* const arena = &_nmd_context->frame_arena;
+
+    /* The buffers are still in the arena's memory until the next frame, so the arena's block is freed by _nmd_reset_frame_arena() */
+    if (memory)
     {
-        num_accounted_vertices += _nmd_context.draw_list.draw_commands[i].num_vertices;
-        num_accounted_indices += _nmd_context.draw_list.draw_commands[i].num_indices;
+        /* The allocations start at an aligned address */
+        const size_t padding = (NMD_FRAME_ARENA_ALIGNMENT - ((size_t)memory & (NMD_FRAME_ARENA_ALIGNMENT - 1))) & (NMD_FRAME_ARENA_ALIGNMENT - 1);
+        arena->memory = (uint8_t*)memory + padding;
+        arena->size = size > padding ? (size - padding) & ~(size_t)(NMD_FRAME_ARENA_ALIGNMENT - 1) : 0;
+        arena->used = 0;
+        arena->unused = 0;
+        arena->user_memory = true;
     }
+    else if (arena->user_memory)
+    {
+        arena->memory = 0;
+        arena->size = 0;
+        arena->used = 0;
+        arena->unused = 0;
+        arena->user_memory = false;
+    }
+}
 
-    const size_t num_unaccounted_indices = _nmd_context.draw_list.num_indices - num_accounted_indices;
+/*
+Allocates memory in the frame arena. The memory is valid until the next call to nmd_new_frame().
+When the arena is full, the memory is allocated by the allocator. Returns a null pointer if the allocation fails.
+*/
+void* _nmd_frame_alloc(size_t size)
+{
+    nmd_frame_arena* const arena = &_nmd_context->frame_arena;
+    void* ptr;
 
-    _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].num_vertices = _nmd_context.draw_list.num_vertices - num_accounted_vertices;
-    _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].num_indices = num_unaccounted_indices;
-    _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].user_texture_id = user_texture_id;
-    if (clip_rect)
-        _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].rect = *clip_rect;
+    size = _NMD_FRAME_ALIGN(size);
+    if (arena->size - arena->used >= size)
+    {
+        ptr = arena->memory + arena->used;
+        arena->used += size;
+    }
     else
-        _nmd_context.draw_list.draw_commands[_nmd_context.draw_list.num_draw_commands].rect.p1.x = -1.0f;
-    _nmd_context.draw_list.num_draw_commands++;
+    {
+        /* The overflow blocks are linked by a pointer before the allocation */
+        uint8_t* block = (uint8_t*)_nmd_alloc(NMD_FRAME_ARENA_ALIGNMENT + size);
+        if (!block)
+            return 0;
+
+        *(void**)block = arena->overflow;
+        arena->overflow = block;
+        arena->overflow_size += NMD_FRAME_ARENA_ALIGNMENT + size;
+        ptr = block + NMD_FRAME_ARENA_ALIGNMENT;
+    }
+
+    arena->high_water = NMD_MAX(arena->high_water, arena->used + arena->overflow_size - arena->unused);
+
+    return ptr;
 }
 
-void _nmd_calculate_circle_segments(float max_error)
+/*
+Grows a buffer of 'size' bytes allocated by _nmd_frame_alloc() to 'new_size' bytes. Returns the pointer to the buffer, or a null pointer if the allocation fails,
+in which case 'ptr' is still valid. If the buffer is the last allocation in the arena and there's enough space, it grows in place, otherwise it's copied.
+*/
+void* _nmd_frame_realloc(void* ptr, size_t size, size_t new_size)
 {
-    for (size_t i = 0; i < 64; i++)
+    nmd_frame_arena* const arena = &_nmd_context->frame_arena;
+    if (arena->memory && (uint8_t*)ptr + _NMD_FRAME_ALIGN(size) == arena->memory + arena->used && arena->size - (arena->used - _NMD_FRAME_ALIGN(size)) >= _NMD_FRAME_ALIGN(new_size))
     {
-        const uint8_t segment_count = NMD_CIRCLE_AUTO_SEGMENT_CALC(i + 1.0f, max_error);
-        _nmd_context.draw_list.cached_circle_segment_counts64[i] = NMD_MIN(segment_count, 255);
+        arena->used += _NMD_FRAME_ALIGN(new_size) - _NMD_FRAME_ALIGN(size);
+        arena->high_water = NMD_MAX(arena->high_water, arena->used + arena->overflow_size - arena->unused);
+        return ptr;
     }
+
+    void* mem = _nmd_frame_alloc(new_size);
+    if (!mem)
+        return 0;
+    NMD_MEMCPY(mem, ptr, size);
+    arena->unused += _NMD_FRAME_ALIGN(size);
+    _nmd_context->stats.num_reallocations++;
+
+    return mem;
 }
 
-#ifdef _WIN32
-void nmd_win32_set_hwnd(HWND hWnd)
+/* Releases temporary memory allocated by _nmd_frame_alloc(). The memory is reused by the next allocation if it's the last one in the arena, otherwise it's freed by nmd_new_frame(). */
+void _nmd_frame_release(void* ptr, size_t size)
 {
-    _nmd_context.hWnd = hWnd;
+    nmd_frame_arena* const arena = &_nmd_context->frame_arena;
+    if (arena->memory && (uint8_t*)ptr + _NMD_FRAME_ALIGN(size) == arena->memory + arena->used)
+        arena->used -= _NMD_FRAME_ALIGN(size);
+    else
+        arena->unused += _NMD_FRAME_ALIGN(size);
 }
-#endif /* _WIN32*/
 
-/* Starts a new empty scene/frame. Internally this function clears all vertices, indices and command buffers. */
-void nmd_new_frame()
+/*
+Frees the memory of the previous frame and allocates the buffers of the draw list in the frame arena with their previous capacities. If the arena is not provided
+by the application, it's resized to the high-water mark first, so the buffers and the temporary memory of a frame like the previous ones fit in it.
+*/
+void _nmd_reset_frame_arena()
 {
-    if (!_nmd_initialized)
-    {
-        _nmd_initialized = true;
+    nmd_frame_arena* const arena = &_nmd_context->frame_arena;
+    nmd_drawlist* const draw_list = &_nmd_context->draw_list;
 
-        _nmd_context.draw_list.line_anti_aliasing = true;
-        _nmd_context.draw_list.fill_anti_aliasing = true;
+    while (arena->overflow)
+    {
+        void* next = *(void**)arena->overflow;
+        _nmd_free(arena->overflow);
+        arena->overflow = next;
+    }
+    arena->overflow_size = 0;
+    arena->used = 0;
+    arena->unused = 0;
 
-        for (size_t i = 0; i < 12; i++)
+    if (arena->user_memory)
+    {
+        _nmd_free(arena->block);
+        arena->block = 0;
+    }
+    else
+    {
+        const size_t buffers_size = _NMD_FRAME_ALIGN(draw_list->path_capacity) + _NMD_FRAME_ALIGN(draw_list->draw_commands_capacity) + _NMD_FRAME_ALIGN(draw_list->indices_capacity) + _NMD_FRAME_ALIGN(draw_list->vertices_capacity);
+        const size_t size = _NMD_FRAME_ALIGN(NMD_MAX(arena->high_water, buffers_size));
+        if (size > arena->size || !arena->block)
         {
-            const float angle = (i / 12.0f) * NMD_2PI;
-            _nmd_context.draw_list.cached_circle_vertices12[i].x = NMD_COS(angle);
-            _nmd_context.draw_list.cached_circle_vertices12[i].y = NMD_SIN(angle);
+            _nmd_free(arena->block);
+            arena->block = _nmd_alloc(NMD_FRAME_ARENA_ALIGNMENT - 1 + size);
+            arena->memory = arena->block ? (uint8_t*)_NMD_FRAME_ALIGN((size_t)arena->block) : 0;
+            arena->size = arena->block ? size : 0;
         }
-        
-        _nmd_calculate_circle_segments(1.6f);
+    }
 
-        /* Allocate buffers */
-        _nmd_context.draw_list.path = (nmd_vec2*)NMD_MALLOC(NMD_PATH_BUFFER_INITIAL_SIZE * sizeof(nmd_vec2));
-        _nmd_context.draw_list.path_capacity = NMD_PATH_BUFFER_INITIAL_SIZE * sizeof(nmd_vec2);
+    /* The vertex buffer usually grows the most, so it's the last one */
+    draw_list->path = (nmd_vec2*)_nmd_frame_alloc(draw_list->path_capacity);
+    draw_list->path_capacity = draw_list->path ? draw_list->path_capacity : 0;
 
-        _nmd_context.draw_list.vertices = (nmd_vertex*)NMD_MALLOC(NMD_VERTEX_BUFFER_INITIAL_SIZE * sizeof(nmd_vertex));
-        _nmd_context.draw_list.vertices_capacity = NMD_VERTEX_BUFFER_INITIAL_SIZE * sizeof(nmd_vertex);
+    draw_list->draw_commands = (nmd_draw_command*)_nmd_frame_alloc(draw_list->draw_commands_capacity);
+    draw_list->draw_commands_capacity = draw_list->draw_commands ? draw_list->draw_commands_capacity : 0;
 
-        _nmd_context.draw_list.indices = (nmd_index*)NMD_MALLOC(NMD_INDEX_BUFFER_INITIAL_SIZE * sizeof(nmd_index));
-        _nmd_context.draw_list.indices_capacity = NMD_INDEX_BUFFER_INITIAL_SIZE * sizeof(nmd_index);
+    draw_list->indices = (nmd_index*)_nmd_frame_alloc(draw_list->indices_capacity);
+    draw_list->indices_capacity = draw_list->indices ? draw_list->indices_capacity : 0;
 
-        _nmd_context.draw_list.draw_commands = (nmd_draw_command*)NMD_MALLOC(NMD_DRAW_COMMANDS_BUFFER_INITIAL_SIZE * sizeof(nmd_draw_command));
-        _nmd_context.draw_list.draw_commands_capacity = NMD_DRAW_COMMANDS_BUFFER_INITIAL_SIZE * sizeof(nmd_draw_command);
+    draw_list->vertices = (nmd_vertex*)_nmd_frame_alloc(draw_list->vertices_capacity);
+    draw_list->vertices_capacity = draw_list->vertices ? draw_list->vertices_capacity : 0;
+}
 
-        _nmd_context.gui.num_windows = 0;
-        _nmd_context.gui.windows = (nmd_window*)NMD_MALLOC(NMD_WINDOWS_BUFFER_INITIAL_SIZE * sizeof(nmd_window));
-        _nmd_context.gui.windows_capacity = NMD_WINDOWS_BUFFER_INITIAL_SIZE;
-        _nmd_context.gui.window = 0;
-        _nmd_context.gui.window_pos.x = 60;
-        _nmd_context.gui.window_pos.y = 60;
-    }
+/*
+Initializes a context. The context uses the allocator, the render state settings, the blank texture and the default atlas of the current context, so the textures
+created by the renderers can be used by the draw lists of all contexts. A context can also be zero-initialized, in which case it uses the default settings and has no textures.
+*/
+void nmd_init_context(nmd_context* context)
+{
+    NMD_MEMSET(context, 0, sizeof(nmd_context));
+    context->allocator = _nmd_context->allocator;
+    context->render_state.skip_backup = _nmd_context->render_state.skip_backup;
+    context->render_state.known_host_state = _nmd_context->render_state.known_host_state;
+    context->draw_list.blank_tex_id = _nmd_context->draw_list.blank_tex_id;
+    context->draw_list.default_atlas = _nmd_context->draw_list.default_atlas;
+    context->profiler = _nmd_context->profiler;
+    context->profiler_user_data = _nmd_context->profiler_user_data;
+}
 
-    _nmd_context.draw_list.num_vertices = 0;
-    _nmd_context.draw_list.num_indices = 0;
-    _nmd_context.draw_list.num_draw_commands = 0;
+/* Frees the memory allocated by a context(the frame arena, the windows, the widget state and the retained geometry). The context can be used again after calling nmd_init_context(). */
+void nmd_destroy_context(nmd_context* context)
+{
+    nmd_context* const current_context = _nmd_context;
+    _nmd_context = context;
 
-#ifdef _WIN32
-    POINT point;
-    if (_nmd_context.hWnd && GetCursorPos(&point) && ScreenToClient(_nmd_context.hWnd, &point))
+    while (context->frame_arena.overflow)
     {
-        _nmd_context.io.mouse_pos.x = point.x;
-        _nmd_context.io.mouse_pos.y = point.y;
+        void* next = *(void**)context->frame_arena.overflow;
+        _nmd_free(context->frame_arena.overflow);
+        context->frame_arena.overflow = next;
     }
-#endif /* _WIN32 */
+    _nmd_free(context->frame_arena.block);
+    _nmd_free(context->gui.windows);
+    _nmd_id_map_free(&context->gui.window_map);
+    _nmd_id_map_free(&context->gui.state_map);
+    nmd_free_retained();
+    NMD_MEMSET(&context->frame_arena, 0, sizeof(nmd_frame_arena));
+    NMD_MEMSET(&context->draw_list, 0, sizeof(nmd_drawlist));
+    context->gui.windows = 0;
+    context->gui.num_windows = 0;
+    context->gui.windows_capacity = 0;
+    context->initialized = false;
+
+    _nmd_context = current_context != context ? current_context : &_nmd_default_context;
 }
 
-/* "Ends" a frame. Wrapper around nmd_push_draw_command(). */
-void nmd_end_frame()
+/* Specifies the categories of render state('NMD_RENDER_STATE_XXX') the renderers back up before rendering and restore after. The default is 'NMD_RENDER_STATE_ALL'. */
+void nmd_set_render_state_backup(uint32_t state_mask)
 {
-    /* Clears the mouse released state because it should only be used once */
-    for (size_t i = 0; i < 5; i++)
-        _nmd_context.io.mouse_released[i] = false;
+    _nmd_context->render_state.skip_backup = NMD_RENDER_STATE_ALL & ~state_mask;
+}
 
-    nmd_push_draw_command(0);
+/*
+Enables or disables the known host state mode. In this mode the renderers assume the render state they set is kept between frames,
+so they only set the categories that were restored or passed to nmd_invalidate_render_state() since the previous frame.
+*/
+void nmd_set_known_host_state(bool enable)
+{
+    _nmd_context->render_state.known_host_state = enable;
+    if (!enable)
+        _nmd_context->render_state.known = NMD_RENDER_STATE_NONE;
 }
 
-bool nmd_bake_font_from_memory(const void* font_data, nmd_atlas* atlas, float size)
+/* Tells the renderers the application changed the categories of render state('NMD_RENDER_STATE_XXX') in 'state_mask', so they're set again by the next render call. */
+void nmd_invalidate_render_state(uint32_t state_mask)
 {
-    atlas->width = 512;
-    atlas->height = 512;
+    _nmd_context->render_state.known &= ~state_mask;
+}
 
-    atlas->pixels8 = (uint8_t*)NMD_MALLOC(atlas->width * atlas->height);
-    atlas->pixels32 = (nmd_color*)NMD_MALLOC(atlas->width * atlas->height * 4);
-    atlas->baked_chars = NMD_MALLOC(sizeof(stbtt_bakedchar) * 96);
+/*
+Returns the categories of render state the renderer must set before drawing. The texture and the scissor
+are set by the draw commands, so they're only known after _nmd_render_state_texture_changed() and _nmd_render_state_scissor_changed().
+*/
+uint32_t _nmd_begin_render_state()
+{
+    const uint32_t state = NMD_RENDER_STATE_ALL & ~_nmd_context->render_state.known;
+    _nmd_context->render_state.known |= state & ~(NMD_RENDER_STATE_TEXTURE | NMD_RENDER_STATE_SCISSOR);
+    return state;
+}
 
-    stbtt_BakeFontBitmap((const unsigned char*)font_data, 0, size, atlas->pixels8, atlas->width, atlas->height, 0x20, 96, (stbtt_bakedchar*)atlas->baked_chars);
+/* Must be called after drawing. 'restored' are the categories that were restored. If 'known_host_state' is false, every category is set again by the next frame. */
+void _nmd_end_render_state(uint32_t restored, bool known_host_state)
+{
+    _nmd_context->render_state.known = known_host_state ? (_nmd_context->render_state.known & ~restored) : NMD_RENDER_STATE_NONE;
+}
 
-    size_t i = 0;
-    for (; i < atlas->width * atlas->height; i++)
-        atlas->pixels32[i] = nmd_rgba(255, 255, 255, atlas->pixels8[i]);
+/* Returns true if 'texture' is not the texture bound by the renderer, in which case the renderer must bind it. */
+bool _nmd_render_state_texture_changed(nmd_tex_id texture)
+{
+    if ((_nmd_context->render_state.known & NMD_RENDER_STATE_TEXTURE) && _nmd_context->render_state.texture == texture)
+        return false;
 
+    _nmd_context->render_state.texture = texture;
+    _nmd_context->render_state.known |= NMD_RENDER_STATE_TEXTURE;
+    _nmd_context->stats.num_texture_binds++;
     return true;
 }
 
-bool nmd_bake_font(const char* font_path, nmd_atlas* atlas, float size)
+/* Returns true if the scissor set by the renderer is not the one of 'clip_rect'(the clip rect of a draw command), in which case the renderer must set it. */
+bool _nmd_render_state_scissor_changed(const nmd_rect* clip_rect)
 {
-    bool ret = false;
+    nmd_rect* const scissor = &_nmd_context->render_state.scissor;
+    if (_nmd_context->render_state.known & NMD_RENDER_STATE_SCISSOR)
+    {
+        /* 'p1.x' is -1 if the command has no clip rect, the other coordinates are not used in that case */
+        if (clip_rect->p1.x == -1.0f ? scissor->p1.x == -1.0f : (scissor->p0.x == clip_rect->p0.x && scissor->p0.y == clip_rect->p0.y && scissor->p1.x == clip_rect->p1.x && scissor->p1.y == clip_rect->p1.y))
+            return false;
+    }
 
-#ifndef NMD_GRAPHICS_DISABLE_FILE_IO
-    FILE* f = fopen(font_path, "rb");
+    *scissor = *clip_rect;
+    _nmd_context->render_state.known |= NMD_RENDER_STATE_SCISSOR;
+    return true;
+}
+
+bool _nmd_reserve_draw_commands(size_t num_new_draw_commands)
+{
+    const size_t future_size = (_nmd_context->draw_list.num_draw_commands + num_new_draw_commands) * sizeof(nmd_draw_command);
+    if (future_size > _nmd_context->draw_list.draw_commands_capacity)
+    {
+        const size_t new_capacity = NMD_MAX(_nmd_context->draw_list.draw_commands_capacity * 2, future_size);
+        void* mem = _nmd_frame_realloc(_nmd_context->draw_list.draw_commands, _nmd_context->draw_list.draw_commands_capacity, new_capacity);
+        if (!mem)
+            return false;
+
+        _nmd_context->draw_list.draw_commands = (nmd_draw_command*)mem;
+        _nmd_context->draw_list.draw_commands_capacity = new_capacity;
+    }
+
+    return true;
+}
+
+/* Returns true if the clip rects of two draw commands are the same. */
+bool _nmd_is_same_clip_rect(const nmd_rect* a, const nmd_rect* b)
+{
+    if (a->p1.x == -1.0f || b->p1.x == -1.0f)
+        return a->p1.x == b->p1.x;
+
+    return a->p0.x == b->p0.x && a->p0.y == b->p0.y && a->p1.x == b->p1.x && a->p1.y == b->p1.y;
+}
+
+/*
+Creates a draw command for the unaccounted vertices and indices whose texture and clip rect are set by the next push, so the vertices
+that follow start at a new base vertex. Called by _nmd_reserve() when the indices relative to the current base vertex would not fit in 'nmd_index'.
+*/
+bool _nmd_split_draw_command()
+{
+    if (_nmd_context->draw_list.num_indices > _nmd_context->draw_list.num_accounted_indices)
+    {
+        if (!_nmd_reserve_draw_commands(1))
+            return false;
+
+        nmd_draw_command* command = &_nmd_context->draw_list.draw_commands[_nmd_context->draw_list.num_draw_commands++];
+        command->num_vertices = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.num_accounted_vertices;
+        command->num_indices = _nmd_context->draw_list.num_indices - _nmd_context->draw_list.num_accounted_indices;
+        command->vertex_offset = _nmd_context->draw_list.vertex_offset;
+        _nmd_context->draw_list.num_pending_draw_commands++;
+    }
+
+    _nmd_context->draw_list.num_accounted_vertices = _nmd_context->draw_list.num_vertices;
+    _nmd_context->draw_list.num_accounted_indices = _nmd_context->draw_list.num_indices;
+    _nmd_context->draw_list.vertex_offset = _nmd_context->draw_list.num_vertices;
+
+    return true;
+}
+
+/*
+Creates a draw command for the unaccounted vertices and indices. If the last draw command has the same texture, clip rect
+and base vertex, it's extended instead, so consecutive shapes that use the same texture are rendered by one draw call.
+*/
+void _nmd_push_draw_command(nmd_tex_id user_texture_id, const nmd_rect* clip_rect)
+{
+    nmd_rect rect;
+    if (clip_rect)
+        rect = *clip_rect;
+    else
+        rect.p0.x = rect.p0.y = rect.p1.y = 0.0f, rect.p1.x = -1.0f;
+
+    /* The commands created by _nmd_split_draw_command() belong to this push */
+    for (; _nmd_context->draw_list.num_pending_draw_commands > 0; _nmd_context->draw_list.num_pending_draw_commands--)
+    {
+        nmd_draw_command* command = &_nmd_context->draw_list.draw_commands[_nmd_context->draw_list.num_draw_commands - _nmd_context->draw_list.num_pending_draw_commands];
+        command->user_texture_id = user_texture_id;
+        command->rect = rect;
+    }
+
+    const size_t num_unaccounted_vertices = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.num_accounted_vertices;
+    const size_t num_unaccounted_indices = _nmd_context->draw_list.num_indices - _nmd_context->draw_list.num_accounted_indices;
+    if (!num_unaccounted_indices)
+        return;
+
+    nmd_draw_command* command = _nmd_context->draw_list.num_draw_commands ? &_nmd_context->draw_list.draw_commands[_nmd_context->draw_list.num_draw_commands - 1] : 0;
+    if (command && command->user_texture_id == user_texture_id && command->vertex_offset == _nmd_context->draw_list.vertex_offset && _nmd_is_same_clip_rect(&command->rect, &rect))
+    {
+        command->num_vertices += num_unaccounted_vertices;
+        command->num_indices += num_unaccounted_indices;
+    }
+    else
+    {
+        if (!_nmd_reserve_draw_commands(1))
+            return;
+
+        command = &_nmd_context->draw_list.draw_commands[_nmd_context->draw_list.num_draw_commands++];
+        command->num_vertices = num_unaccounted_vertices;
+        command->num_indices = num_unaccounted_indices;
+        command->vertex_offset = _nmd_context->draw_list.vertex_offset;
+        command->user_texture_id = user_texture_id;
+        command->rect = rect;
+    }
+
+    _nmd_context->draw_list.num_accounted_vertices = _nmd_context->draw_list.num_vertices;
+    _nmd_context->draw_list.num_accounted_indices = _nmd_context->draw_list.num_indices;
+}
+
+/*
+Creates a draw command for the unaccounted vertices and indices. If the last draw command has the same texture and clip rect, it's extended instead.
+Parameters:
+ clip_rect [opt/in] A pointer to a rect that specifies the clip area. This parameter can be null.
+*/
+void nmd_push_draw_command(const nmd_rect* clip_rect)
+{
+    _nmd_push_draw_command(_nmd_context->draw_list.blank_tex_id, clip_rect);
+}
+
+/*
+Same as nmd_push_draw_command(), but the draw command uses the texture 'user_texture_id'.
+Parameters:
+ user_texture_id [in]     The texture of the draw command.
+ clip_rect       [opt/in] A pointer to a rect that specifies the clip area. This parameter can be null.
+*/
+void nmd_push_texture_draw_command(nmd_tex_id user_texture_id, const nmd_rect* clip_rect)
+{
+    _nmd_push_draw_command(user_texture_id, clip_rect);
+}
+
+void _nmd_calculate_circle_segments(float max_error)
+{
+    for (size_t i = 0; i < 64; i++)
+    {
+        const uint8_t segment_count = NMD_CIRCLE_AUTO_SEGMENT_CALC(i + 1.0f, max_error);
+        _nmd_context->draw_list.cached_circle_segment_counts64[i] = NMD_MIN(segment_count, 255);
+    }
+}
+
+#ifdef _WIN32
+void nmd_win32_set_hwnd(HWND hWnd)
+{
+    _nmd_context->hWnd = hWnd;
+}
+#endif /* _WIN32*/
+
+/* Starts a new empty scene/frame. Internally this function clears all vertices, indices and command buffers. */
+void nmd_new_frame()
+{
+    _nmd_profile("nmd_new_frame", true);
+
+    if (!_nmd_context->initialized)
+    {
+        _nmd_context->initialized = true;
+
+        _nmd_context->draw_list.line_anti_aliasing = true;
+        _nmd_context->draw_list.fill_anti_aliasing = true;
+
+        for (size_t i = 0; i < 12; i++)
+        {
+            const float angle = (i / 12.0f) * NMD_2PI;
+            _nmd_context->draw_list.cached_circle_vertices12[i].x = NMD_COS(angle);
+            _nmd_context->draw_list.cached_circle_vertices12[i].y = NMD_SIN(angle);
+        }
+        
+        _nmd_calculate_circle_segments(1.6f);
+
+        /* The buffers are allocated in the frame arena by _nmd_reset_frame_arena() */
+        _nmd_context->draw_list.path_capacity = NMD_PATH_BUFFER_INITIAL_SIZE * sizeof(nmd_vec2);
+        _nmd_context->draw_list.vertices_capacity = NMD_VERTEX_BUFFER_INITIAL_SIZE * sizeof(nmd_vertex);
+        _nmd_context->draw_list.indices_capacity = NMD_INDEX_BUFFER_INITIAL_SIZE * sizeof(nmd_index);
+        _nmd_context->draw_list.draw_commands_capacity = NMD_DRAW_COMMANDS_BUFFER_INITIAL_SIZE * sizeof(nmd_draw_command);
+
+        _nmd_context->gui.num_windows = 0;
+        _nmd_context->gui.windows = (nmd_window*)_nmd_alloc(NMD_WINDOWS_BUFFER_INITIAL_SIZE * sizeof(nmd_window));
+        _nmd_context->gui.windows_capacity = _nmd_context->gui.windows ? NMD_WINDOWS_BUFFER_INITIAL_SIZE : 0;
+        _nmd_context->gui.window = 0;
+        _nmd_context->gui.window_pos.x = 60;
+        _nmd_context->gui.window_pos.y = 60;
+    }
+
+    NMD_MEMSET(&_nmd_context->stats, 0, sizeof(nmd_frame_stats));
+    _nmd_reset_frame_arena();
+
+    _nmd_context->draw_list.num_points = 0;
+    _nmd_context->draw_list.num_vertices = 0;
+    _nmd_context->draw_list.num_indices = 0;
+    _nmd_context->draw_list.num_draw_commands = 0;
+    _nmd_context->draw_list.num_accounted_vertices = 0;
+    _nmd_context->draw_list.num_accounted_indices = 0;
+    _nmd_context->draw_list.vertex_offset = 0;
+    _nmd_context->draw_list.num_pending_draw_commands = 0;
+
+#ifdef _WIN32
+    POINT point;
+    if (_nmd_context->hWnd && GetCursorPos(&point) && ScreenToClient(_nmd_context->hWnd, &point))
+    {
+        _nmd_context->io.mouse_pos.x = point.x;
+        _nmd_context->io.mouse_pos.y = point.y;
+    }
+#endif /* _WIN32 */
+
+    _nmd_profile("nmd_new_frame", false);
+}
+
+/* "Ends" a frame. Wrapper around nmd_push_draw_command(). */
+void nmd_end_frame()
+{
+    _nmd_profile("nmd_end_frame", true);
+
+    /* Clears the mouse released state because it should only be used once */
+    for (size_t i = 0; i < 5; i++)
+        _nmd_context->io.mouse_released[i] = false;
+
+    /* Release the held widget even if it wasn't added this frame */
+    if (!_nmd_context->io.mouse_down[0])
+        _nmd_context->gui.active_id = 0;
+
+    nmd_push_draw_command(0);
+
+    _nmd_context->stats.num_vertices = _nmd_context->draw_list.num_vertices;
+    _nmd_context->stats.num_indices = _nmd_context->draw_list.num_indices;
+    _nmd_context->stats.num_draw_commands = _nmd_context->draw_list.num_draw_commands;
+
+    _nmd_profile("nmd_end_frame", false);
+}
+
+bool nmd_bake_font_from_memory(const void* font_data, nmd_atlas* atlas, float size)
+{
+    atlas->width = 512;
+    atlas->height = 512;
+
+    atlas->pixels8 = (uint8_t*)_nmd_alloc(atlas->width * atlas->height);
+    atlas->pixels32 = (nmd_color*)_nmd_alloc(atlas->width * atlas->height * 4);
+    atlas->baked_chars = _nmd_alloc(sizeof(stbtt_bakedchar) * 96);
+    if (!atlas->pixels8 || !atlas->pixels32 || !atlas->baked_chars)
+    {
+        _nmd_free(atlas->pixels8);
+        _nmd_free(atlas->pixels32);
+        _nmd_free(atlas->baked_chars);
+        atlas->pixels8 = 0;
+        atlas->pixels32 = 0;
+        atlas->baked_chars = 0;
+        return false;
+    }
+
+    stbtt_BakeFontBitmap((const unsigned char*)font_data, 0, size, atlas->pixels8, atlas->width, atlas->height, 0x20, 96, (stbtt_bakedchar*)atlas->baked_chars);
+
+    size_t i = 0;
+    for (; i < atlas->width * atlas->height; i++)
+        atlas->pixels32[i] = nmd_rgba(255, 255, 255, atlas->pixels8[i]);
+
+    return true;
+}
+
+bool nmd_bake_font(const char* font_path, nmd_atlas* atlas, float size)
+{
+    bool ret = false;
+
+#ifndef NMD_GRAPHICS_DISABLE_FILE_IO
+    FILE* f = fopen(font_path, "rb");
 
     /* Get file size*/
     fseek(f, 0L, SEEK_END);
@@ -5792,14 +6672,16 @@ bool nmd_bake_font(const char* font_path, nmd_atlas* atlas, float size)
     fseek(f, 0L, SEEK_SET);
 
     /* Allocate and read file */
-    void* font_data = NMD_MALLOC(file_size);    
-    fread(font_data, 1, file_size, f);
-
-    ret = nmd_bake_font_from_memory(font_data, atlas, size);
+    void* font_data = _nmd_alloc(file_size);
+    if (font_data)
+    {
+        fread(font_data, 1, file_size, f);
+        ret = nmd_bake_font_from_memory(font_data, atlas, size);
+    }
     
     /* Close and free file */
     fclose(f);
-    NMD_FREE(font_data);
+    _nmd_free(font_data);
 #endif
 
     return ret;
@@ -5894,34 +6776,37 @@ bool nmd_bake_font(const char* font_path, nmd_atlas* atlas, float size)
 
 bool _nmd_reserve(size_t num_new_vertices, size_t num_new_indices)
 {
+    /* Indices are relative to the base vertex of the draw command, so a new one is started when they would not fit in 'nmd_index' */
+    if (_nmd_context->draw_list.num_vertices + num_new_vertices - _nmd_context->draw_list.vertex_offset > ((size_t)1 << (8 * sizeof(nmd_index))) && _nmd_context->draw_list.num_vertices > _nmd_context->draw_list.vertex_offset)
+    {
+        if (!_nmd_split_draw_command())
+            return false;
+    }
+
     /* Check vertices */
-    size_t future_size = (_nmd_context.draw_list.num_vertices + num_new_vertices) * sizeof(nmd_vertex);
-    if (future_size > _nmd_context.draw_list.vertices_capacity)
+    size_t future_size = (_nmd_context->draw_list.num_vertices + num_new_vertices) * sizeof(nmd_vertex);
+    if (future_size > _nmd_context->draw_list.vertices_capacity)
     {
-        const size_t new_capacity = NMD_MAX(_nmd_context.draw_list.vertices_capacity * 2, future_size);
-        void* mem = NMD_MALLOC(new_capacity);
+        const size_t new_capacity = NMD_MAX(_nmd_context->draw_list.vertices_capacity * 2, future_size);
+        void* mem = _nmd_frame_realloc(_nmd_context->draw_list.vertices, _nmd_context->draw_list.vertices_capacity, new_capacity);
         if (!mem)
             return false;
-        NMD_MEMCPY(mem, _nmd_context.draw_list.vertices, _nmd_context.draw_list.vertices_capacity);
-        NMD_FREE(_nmd_context.draw_list.vertices);
 
-        _nmd_context.draw_list.vertices = (nmd_vertex*)mem;
-        _nmd_context.draw_list.vertices_capacity = new_capacity;
+        _nmd_context->draw_list.vertices = (nmd_vertex*)mem;
+        _nmd_context->draw_list.vertices_capacity = new_capacity;
     }
 
     /* Check indices */
-    future_size = (_nmd_context.draw_list.num_indices + num_new_indices) * sizeof(nmd_index);
-    if (future_size > _nmd_context.draw_list.indices_capacity)
+    future_size = (_nmd_context->draw_list.num_indices + num_new_indices) * sizeof(nmd_index);
+    if (future_size > _nmd_context->draw_list.indices_capacity)
     {
-        const size_t new_capacity = NMD_MAX(_nmd_context.draw_list.indices_capacity * 2, future_size);
-        void* mem = NMD_MALLOC(new_capacity);
+        const size_t new_capacity = NMD_MAX(_nmd_context->draw_list.indices_capacity * 2, future_size);
+        void* mem = _nmd_frame_realloc(_nmd_context->draw_list.indices, _nmd_context->draw_list.indices_capacity, new_capacity);
         if (!mem)
             return false;
-        NMD_MEMCPY(mem, _nmd_context.draw_list.indices, _nmd_context.draw_list.indices_capacity);
-        NMD_FREE(_nmd_context.draw_list.indices);
 
-        _nmd_context.draw_list.indices = (nmd_index*)mem;
-        _nmd_context.draw_list.indices_capacity = new_capacity;
+        _nmd_context->draw_list.indices = (nmd_index*)mem;
+        _nmd_context->draw_list.indices_capacity = new_capacity;
     }
 
     return true;
@@ -5929,26 +6814,468 @@ bool _nmd_reserve(size_t num_new_vertices, size_t num_new_indices)
 
 bool _nmd_reserve_points(size_t num_new_points)
 {
-    const size_t future_size = (_nmd_context.draw_list.num_points + num_new_points) * sizeof(nmd_vec2);
-    if (future_size > _nmd_context.draw_list.path_capacity)
+    const size_t future_size = (_nmd_context->draw_list.num_points + num_new_points) * sizeof(nmd_vec2);
+    if (future_size > _nmd_context->draw_list.path_capacity)
     {
-        const size_t new_capacity = NMD_MAX(_nmd_context.draw_list.path_capacity * 2, future_size);
-        void* mem = NMD_MALLOC(new_capacity);
+        const size_t new_capacity = NMD_MAX(_nmd_context->draw_list.path_capacity * 2, future_size);
+        void* mem = _nmd_frame_realloc(_nmd_context->draw_list.path, _nmd_context->draw_list.path_capacity, new_capacity);
         if (!mem)
             return false;
-        NMD_MEMCPY(mem, _nmd_context.draw_list.path, _nmd_context.draw_list.path_capacity);
-        NMD_FREE(_nmd_context.draw_list.path);
 
-        _nmd_context.draw_list.path = (nmd_vec2*)mem;
-        _nmd_context.draw_list.path_capacity = new_capacity;
+        _nmd_context->draw_list.path = (nmd_vec2*)mem;
+        _nmd_context->draw_list.path_capacity = new_capacity;
+    }
+
+    return true;
+}
+
+/*
+Appends geometry to the draw list of the current context. The unaccounted vertices and indices are pushed first like nmd_push_draw_command(0) does.
+The appended draw commands keep their base vertices(moved by the number of vertices in the draw list), so the indices are copied as they are.
+The vertices and clip rects are translated by('x', 'y'). The draw commands that use 'blank_tex_id' use the blank texture of the draw list.
+*/
+bool _nmd_append_geometry(const nmd_vertex* vertices, size_t num_vertices, const nmd_index* indices, size_t num_indices, const nmd_draw_command* draw_commands, size_t num_draw_commands, nmd_tex_id blank_tex_id, float x, float y)
+{
+    nmd_drawlist* const dst = &_nmd_context->draw_list;
+    const bool translate = x != 0.0f || y != 0.0f;
+
+    nmd_push_draw_command(0);
+
+    dst->vertex_offset = dst->num_vertices;
+    if (!_nmd_reserve(num_vertices, num_indices) || !_nmd_reserve_draw_commands(num_draw_commands))
+        return false;
+
+    if (translate)
+    {
+        nmd_vertex* vertex = dst->vertices + dst->num_vertices;
+        for (size_t i = 0; i < num_vertices; i++, vertex++)
+        {
+            *vertex = vertices[i];
+            vertex->pos.x += x;
+            vertex->pos.y += y;
+        }
+    }
+    else
+        NMD_MEMCPY(dst->vertices + dst->num_vertices, vertices, num_vertices * sizeof(nmd_vertex));
+    NMD_MEMCPY(dst->indices + dst->num_indices, indices, num_indices * sizeof(nmd_index));
+
+    for (size_t i = 0; i < num_draw_commands; i++)
+    {
+        nmd_draw_command* command = &dst->draw_commands[dst->num_draw_commands++];
+        *command = draw_commands[i];
+        command->vertex_offset += dst->num_vertices;
+        if (command->user_texture_id == blank_tex_id)
+            command->user_texture_id = dst->blank_tex_id;
+        if (translate && command->rect.p1.x != -1.0f)
+        {
+            command->rect.p0.x += x, command->rect.p0.y += y;
+            command->rect.p1.x += x, command->rect.p1.y += y;
+        }
+    }
+
+    dst->num_vertices += num_vertices;
+    dst->num_indices += num_indices;
+    dst->num_accounted_vertices = dst->num_vertices;
+    dst->num_accounted_indices = dst->num_indices;
+    dst->vertex_offset = dst->num_vertices;
+
+    return true;
+}
+
+/*
+Appends the draw commands, vertices and indices of 'draw_list' to the draw list of the current context, so draw lists recorded by other contexts(e.g. on worker threads)
+are rendered by one render call. The geometry of 'draw_list' must be in draw commands(nmd_end_frame() was called) and it must not be modified while it's appended.
+The unaccounted vertices and indices of the current draw list are pushed first like nmd_push_draw_command(0) does. The draw commands that use the blank texture
+of 'draw_list' use the blank texture of the current draw list. Returns false if memory could not be allocated.
+*/
+bool nmd_append_draw_list(const nmd_drawlist* draw_list)
+{
+    if (draw_list == &_nmd_context->draw_list)
+        return false;
+
+    /* The draw commands whose texture was not set by a push are not appended */
+    return _nmd_append_geometry(draw_list->vertices, draw_list->num_accounted_vertices, draw_list->indices, draw_list->num_accounted_indices,
+        draw_list->draw_commands, draw_list->num_draw_commands - draw_list->num_pending_draw_commands, draw_list->blank_tex_id, 0.0f, 0.0f);
+}
+
+/* Returns the retained geometry recorded under 'key', or a null pointer if there's none. */
+nmd_retained_geometry* _nmd_find_retained(uint32_t key)
+{
+    for (size_t i = 0; i < _nmd_context->retained.num_entries; i++)
+    {
+        if (_nmd_context->retained.entries[i].key == key)
+            return &_nmd_context->retained.entries[i];
+    }
+
+    return 0;
+}
+
+/*
+If geometry was recorded under 'key' and it was not invalidated, it's appended to the draw list and false is returned. Otherwise the geometry added until
+nmd_end_retained() is recorded under 'key' and true is returned, so the caller only tessellates it when it changed:
+    if (nmd_begin_retained(key))
+    {
+        nmd_add_rect_filled(...);
+        nmd_add_text(...);
+        nmd_end_retained();
+    }
+The unaccounted vertices and indices are pushed first like nmd_push_draw_command(0) does. Recording can't be nested.
+*/
+bool nmd_begin_retained(uint32_t key)
+{
+    nmd_retained* const retained = &_nmd_context->retained;
+    nmd_retained_geometry* geometry = _nmd_find_retained(key);
+    if (geometry && geometry->valid)
+    {
+        _nmd_append_geometry(geometry->vertices, geometry->num_vertices, geometry->indices, geometry->num_indices, geometry->draw_commands, geometry->num_draw_commands, _nmd_context->draw_list.blank_tex_id, 0.0f, 0.0f);
+        return false;
+    }
+
+    if (retained->recording)
+        return false;
+
+    if (!geometry)
+    {
+        /* Check if we need to resize the buffer */
+        if (retained->num_entries == retained->capacity)
+        {
+            const size_t new_capacity = NMD_MAX(retained->capacity * 2, NMD_RETAINED_BUFFER_INITIAL_SIZE);
+            void* mem = _nmd_alloc(new_capacity * sizeof(nmd_retained_geometry));
+            if (!mem)
+                return false;
+            if (retained->entries)
+                NMD_MEMCPY(mem, retained->entries, retained->num_entries * sizeof(nmd_retained_geometry));
+            _nmd_free(retained->entries);
+
+            retained->entries = (nmd_retained_geometry*)mem;
+            retained->capacity = new_capacity;
+        }
+
+        geometry = &retained->entries[retained->num_entries++];
+        NMD_MEMSET(geometry, 0, sizeof(nmd_retained_geometry));
+        geometry->key = key;
     }
 
+    /* The recorded draw commands start at a new base vertex, so their indices don't depend on the geometry added before */
+    nmd_push_draw_command(0);
+    _nmd_split_draw_command();
+
+    retained->recording = geometry;
+    retained->first_vertex = _nmd_context->draw_list.num_vertices;
+    retained->first_index = _nmd_context->draw_list.num_indices;
+    retained->first_draw_command = _nmd_context->draw_list.num_draw_commands;
+
     return true;
 }
 
+/* Ends the recording started by nmd_begin_retained(). The unaccounted vertices and indices are pushed like nmd_push_draw_command(0) does. */
+void nmd_end_retained()
+{
+    nmd_retained* const retained = &_nmd_context->retained;
+    nmd_retained_geometry* const geometry = retained->recording;
+    if (!geometry)
+        return;
+
+    retained->recording = 0;
+    nmd_push_draw_command(0);
+
+    const nmd_drawlist* const draw_list = &_nmd_context->draw_list;
+    const size_t num_vertices = draw_list->num_vertices - retained->first_vertex;
+    const size_t num_indices = draw_list->num_indices - retained->first_index;
+    const size_t num_draw_commands = draw_list->num_draw_commands - retained->first_draw_command;
+
+    /* The three arrays share one block, which is reused when the geometry is recorded again */
+    const size_t vertices_size = num_vertices * sizeof(nmd_vertex);
+    const size_t draw_commands_size = num_draw_commands * sizeof(nmd_draw_command);
+    const size_t size = vertices_size + draw_commands_size + num_indices * sizeof(nmd_index);
+    if (size > geometry->block_size)
+    {
+        _nmd_free(geometry->block);
+        geometry->block = _nmd_alloc(size);
+        geometry->block_size = geometry->block ? size : 0;
+        if (!geometry->block)
+        {
+            geometry->valid = false;
+            return;
+        }
+    }
+
+    geometry->vertices = (nmd_vertex*)geometry->block;
+    geometry->draw_commands = (nmd_draw_command*)((uint8_t*)geometry->block + vertices_size);
+    geometry->indices = (nmd_index*)((uint8_t*)geometry->block + vertices_size + draw_commands_size);
+    geometry->num_vertices = num_vertices;
+    geometry->num_indices = num_indices;
+    geometry->num_draw_commands = num_draw_commands;
+
+    NMD_MEMCPY(geometry->vertices, draw_list->vertices + retained->first_vertex, vertices_size);
+    NMD_MEMCPY(geometry->indices, draw_list->indices + retained->first_index, num_indices * sizeof(nmd_index));
+    NMD_MEMCPY(geometry->draw_commands, draw_list->draw_commands + retained->first_draw_command, draw_commands_size);
+
+    /* The base vertices are stored relative to the first vertex */
+    for (size_t i = 0; i < num_draw_commands; i++)
+        geometry->draw_commands[i].vertex_offset -= retained->first_vertex;
+
+    geometry->valid = true;
+}
+
+/* Appends the geometry recorded under 'key' translated by('x', 'y'). Returns false if there's no valid geometry for 'key' or memory could not be allocated. */
+bool nmd_add_retained(uint32_t key, float x, float y)
+{
+    const nmd_retained_geometry* const geometry = _nmd_find_retained(key);
+    if (!geometry || !geometry->valid)
+        return false;
+
+    return _nmd_append_geometry(geometry->vertices, geometry->num_vertices, geometry->indices, geometry->num_indices, geometry->draw_commands, geometry->num_draw_commands, _nmd_context->draw_list.blank_tex_id, x, y);
+}
+
+/* Invalidates the geometry recorded under 'key', so the next nmd_begin_retained() with this key records it again. The memory is kept for the next recording. */
+void nmd_invalidate_retained(uint32_t key)
+{
+    nmd_retained_geometry* const geometry = _nmd_find_retained(key);
+    if (geometry)
+        geometry->valid = false;
+}
+
+/* Frees the memory of all retained geometry. */
+void nmd_free_retained()
+{
+    nmd_retained* const retained = &_nmd_context->retained;
+    for (size_t i = 0; i < retained->num_entries; i++)
+        _nmd_free(retained->entries[i].block);
+    _nmd_free(retained->entries);
+    NMD_MEMSET(retained, 0, sizeof(nmd_retained));
+}
+
 #define NMD_NORMALIZE2F_OVER_ZERO(VX,VY) { float d2 = VX*VX + VY*VY; if (d2 > 0.0f) { float inv_len = 1.0f / NMD_SQRT(d2); VX *= inv_len; VY *= inv_len; } }
 #define NMD_FIXNORMAL2F(VX,VY) { float d2 = VX*VX + VY*VY; if (d2 < 0.5f) d2 = 0.5f; float inv_lensq = 1.0f / d2; VX *= inv_lensq; VY *= inv_lensq; }
 
+/*
+Four-wide float vectors used by the tessellation kernels. A vector holds two points as (x0, y0, x1, y1), so the 'nmd_vec2' arrays
+are processed without deinterleaving. The NEON mapping uses AArch64 intrinsics(vdivq_f32(), vsqrtq_f32(), vzip1q_f32()).
+*/
+#if defined(NMD_GRAPHICS_ENABLE_SSE2)
+#define _NMD_GRAPHICS_SIMD
+typedef __m128 _nmd_v4;
+#define _NMD_V4_LOAD(p) _mm_loadu_ps(p)
+#define _NMD_V4_LOAD_LO_HI(lo, hi) _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(lo)), (const __m64*)(hi))
+#define _NMD_V4_STORE(p, v) _mm_storeu_ps(p, v)
+#define _NMD_V4_STORE_LO(p, v) _mm_storel_pi((__m64*)(p), v)
+#define _NMD_V4_STORE_HI(p, v) _mm_storeh_pi((__m64*)(p), v)
+#define _NMD_V4_SET1(f) _mm_set1_ps(f)
+#define _NMD_V4_ADD(a, b) _mm_add_ps(a, b)
+#define _NMD_V4_SUB(a, b) _mm_sub_ps(a, b)
+#define _NMD_V4_MUL(a, b) _mm_mul_ps(a, b)
+#define _NMD_V4_DIV(a, b) _mm_div_ps(a, b)
+#define _NMD_V4_MIN(a, b) _mm_min_ps(a, b)
+#define _NMD_V4_MAX(a, b) _mm_max_ps(a, b)
+#define _NMD_V4_SQRT(a) _mm_sqrt_ps(a)
+#define _NMD_V4_SWAP_PAIRS(a) _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1))
+#define _NMD_V4_ZIP_LO(a, b) _mm_unpacklo_ps(a, b)
+#define _NMD_V4_ZIP_HI(a, b) _mm_unpackhi_ps(a, b)
+#define _NMD_V4_SELECT_GT(a, b, t, f) _mm_or_ps(_mm_and_ps(_mm_cmpgt_ps(a, b), t), _mm_andnot_ps(_mm_cmpgt_ps(a, b), f))
+#elif defined(NMD_GRAPHICS_ENABLE_NEON)
+#define _NMD_GRAPHICS_SIMD
+typedef float32x4_t _nmd_v4;
+#define _NMD_V4_LOAD(p) vld1q_f32(p)
+#define _NMD_V4_LOAD_LO_HI(lo, hi) vcombine_f32(vld1_f32(lo), vld1_f32(hi))
+#define _NMD_V4_STORE(p, v) vst1q_f32(p, v)
+#define _NMD_V4_STORE_LO(p, v) vst1_f32(p, vget_low_f32(v))
+#define _NMD_V4_STORE_HI(p, v) vst1_f32(p, vget_high_f32(v))
+#define _NMD_V4_SET1(f) vdupq_n_f32(f)
+#define _NMD_V4_ADD(a, b) vaddq_f32(a, b)
+#define _NMD_V4_SUB(a, b) vsubq_f32(a, b)
+#define _NMD_V4_MUL(a, b) vmulq_f32(a, b)
+#define _NMD_V4_DIV(a, b) vdivq_f32(a, b)
+#define _NMD_V4_MIN(a, b) vminq_f32(a, b)
+#define _NMD_V4_MAX(a, b) vmaxq_f32(a, b)
+#define _NMD_V4_SQRT(a) vsqrtq_f32(a)
+#define _NMD_V4_SWAP_PAIRS(a) vrev64q_f32(a)
+#define _NMD_V4_ZIP_LO(a, b) vzip1q_f32(a, b)
+#define _NMD_V4_ZIP_HI(a, b) vzip2q_f32(a, b)
+#define _NMD_V4_SELECT_GT(a, b, t, f) vbslq_f32(vcgtq_f32(a, b), t, f)
+#endif /* NMD_GRAPHICS_ENABLE_SSE2 */
+
+/*
+Computes the unit normal of each segment of a polyline. 'normals[i]' is the normal of the segment from 'points[i]' to the next point.
+If 'closed' is false, the last normal is a copy of the previous one. 'num_points' must be at least two.
+*/
+void _nmd_compute_normals(const nmd_vec2* points, size_t num_points, bool closed, nmd_vec2* normals)
+{
+    size_t i = 0;
+
+#ifdef _NMD_GRAPHICS_SIMD
+    const _nmd_v4 zero = _NMD_V4_SET1(0.0f);
+    const _nmd_v4 one = _NMD_V4_SET1(1.0f);
+    const float sign_xy[4] = { 1.0f, -1.0f, 1.0f, -1.0f };
+    const _nmd_v4 sign = _NMD_V4_LOAD(sign_xy);
+
+    /* The normal of (dx, dy) is (dy, -dx), so the squared lengths and the normals are computed by swapping the components of each point */
+    for (; i + 2 < num_points; i += 2)
+    {
+        const _nmd_v4 d = _NMD_V4_SUB(_NMD_V4_LOAD(&points[i + 1].x), _NMD_V4_LOAD(&points[i].x));
+        const _nmd_v4 d_sq = _NMD_V4_MUL(d, d);
+        const _nmd_v4 len_sq = _NMD_V4_ADD(d_sq, _NMD_V4_SWAP_PAIRS(d_sq));
+        const _nmd_v4 inv_len = _NMD_V4_SELECT_GT(len_sq, zero, _NMD_V4_DIV(one, _NMD_V4_SQRT(len_sq)), one);
+        _NMD_V4_STORE(&normals[i].x, _NMD_V4_MUL(_NMD_V4_MUL(_NMD_V4_SWAP_PAIRS(d), inv_len), sign));
+    }
+#endif /* _NMD_GRAPHICS_SIMD */
+
+    for (; i + 1 < num_points; i++)
+    {
+        float dx = points[i + 1].x - points[i].x;
+        float dy = points[i + 1].y - points[i].y;
+        NMD_NORMALIZE2F_OVER_ZERO(dx, dy);
+        normals[i].x = dy;
+        normals[i].y = -dx;
+    }
+
+    if (closed)
+    {
+        float dx = points[0].x - points[num_points - 1].x;
+        float dy = points[0].y - points[num_points - 1].y;
+        NMD_NORMALIZE2F_OVER_ZERO(dx, dy);
+        normals[num_points - 1].x = dy;
+        normals[num_points - 1].y = -dx;
+    }
+    else
+        normals[num_points - 1] = normals[num_points - 2];
+}
+
+/* Averages two normals and scales the result by its inverse squared length, which is limited to 'max_inv_length_sq' so sharp corners don't create long spikes. */
+void _nmd_miter(const nmd_vec2* n0, const nmd_vec2* n1, float max_inv_length_sq, nmd_vec2* miter)
+{
+    const float dm_x = (n0->x + n1->x) * 0.5f;
+    const float dm_y = (n0->y + n1->y) * 0.5f;
+    const float length_sq = dm_x * dm_x + dm_y * dm_y;
+    const float scale = length_sq * max_inv_length_sq > 1.0f ? 1.0f / length_sq : max_inv_length_sq;
+    miter->x = dm_x * scale;
+    miter->y = dm_y * scale;
+}
+
+/*
+Computes the miter of each point of a polyline from the normals of the two segments that meet at it(see _nmd_miter()).
+If 'closed' is false, the miter of the first point is the normal of the first segment.
+*/
+void _nmd_compute_miters(const nmd_vec2* normals, size_t num_points, bool closed, float max_inv_length_sq, nmd_vec2* miters)
+{
+    size_t i = 1;
+
+    if (closed)
+        _nmd_miter(&normals[num_points - 1], &normals[0], max_inv_length_sq, &miters[0]);
+    else
+        miters[0] = normals[0];
+
+#ifdef _NMD_GRAPHICS_SIMD
+    const _nmd_v4 half = _NMD_V4_SET1(0.5f);
+    const _nmd_v4 one = _NMD_V4_SET1(1.0f);
+    const _nmd_v4 max_scale = _NMD_V4_SET1(max_inv_length_sq);
+    for (; i + 2 <= num_points; i += 2)
+    {
+        const _nmd_v4 dm = _NMD_V4_MUL(_NMD_V4_ADD(_NMD_V4_LOAD(&normals[i - 1].x), _NMD_V4_LOAD(&normals[i].x)), half);
+        const _nmd_v4 dm_sq = _NMD_V4_MUL(dm, dm);
+        const _nmd_v4 length_sq = _NMD_V4_ADD(dm_sq, _NMD_V4_SWAP_PAIRS(dm_sq));
+        _NMD_V4_STORE(&miters[i].x, _NMD_V4_MUL(dm, _NMD_V4_MIN(_NMD_V4_DIV(one, length_sq), max_scale)));
+    }
+#endif /* _NMD_GRAPHICS_SIMD */
+
+    for (; i < num_points; i++)
+        _nmd_miter(&normals[i - 1], &normals[i], max_inv_length_sq, &miters[i]);
+}
+
+/*
+Adds 'num_offsets' vertices for each point, the vertex 'j' of the point 'i' is at 'points[i] + miters[i] * offsets[j]' and has the color 'colors[j]'.
+The vertices must have been reserved.
+*/
+void _nmd_add_miter_vertices(const nmd_vec2* points, const nmd_vec2* miters, size_t num_points, const float* offsets, const nmd_color* colors, size_t num_offsets)
+{
+    nmd_vertex* vertices = _nmd_context->draw_list.vertices + _nmd_context->draw_list.num_vertices;
+    size_t i = 0, j;
+
+#ifdef _NMD_GRAPHICS_SIMD
+    for (; i + 2 <= num_points; i += 2)
+    {
+        const _nmd_v4 p = _NMD_V4_LOAD(&points[i].x);
+        const _nmd_v4 m = _NMD_V4_LOAD(&miters[i].x);
+        for (j = 0; j < num_offsets; j++)
+        {
+            const _nmd_v4 pos = _NMD_V4_ADD(p, _NMD_V4_MUL(m, _NMD_V4_SET1(offsets[j])));
+            _NMD_V4_STORE_LO(&vertices[j].pos.x, pos);
+            _NMD_V4_STORE_HI(&vertices[num_offsets + j].pos.x, pos);
+            vertices[j].color = colors[j];
+            vertices[num_offsets + j].color = colors[j];
+        }
+        vertices += num_offsets * 2;
+    }
+#endif /* _NMD_GRAPHICS_SIMD */
+
+    for (; i < num_points; i++)
+    {
+        for (j = 0; j < num_offsets; j++)
+        {
+            vertices[j].pos.x = points[i].x + miters[i].x * offsets[j];
+            vertices[j].pos.y = points[i].y + miters[i].y * offsets[j];
+            vertices[j].color = colors[j];
+        }
+        vertices += num_offsets;
+    }
+
+    _nmd_context->draw_list.num_vertices = vertices - _nmd_context->draw_list.vertices;
+}
+
+/* Writes the 'num_segments + 1' points of an arc to 'path'. 'num_segments' must be at least one. */
+void _nmd_arc_points(nmd_vec2* path, float x0, float y0, float radius, float start_angle, float end_angle, size_t num_segments)
+{
+    size_t i = 0;
+
+#ifdef _NMD_GRAPHICS_SIMD
+    /*
+    Four points per iteration. The cosines and sines of four consecutive angles are rotated by four steps(a complex multiplication),
+    they're computed again every 64 iterations so the rounding error doesn't accumulate.
+    */
+    if (num_segments >= 7)
+    {
+        const float step = (end_angle - start_angle) / num_segments;
+        const _nmd_v4 cos_step4 = _NMD_V4_SET1(NMD_COS(step * 4));
+        const _nmd_v4 sin_step4 = _NMD_V4_SET1(NMD_SIN(step * 4));
+        const _nmd_v4 center_x = _NMD_V4_SET1(x0);
+        const _nmd_v4 center_y = _NMD_V4_SET1(y0);
+        const _nmd_v4 r = _NMD_V4_SET1(radius);
+        _nmd_v4 c = _NMD_V4_SET1(0.0f), s = c;
+        for (; i + 4 <= num_segments + 1; i += 4)
+        {
+            if (i % 256 == 0)
+            {
+                float cosines[4], sines[4];
+                for (size_t k = 0; k < 4; k++)
+                {
+                    const float angle = start_angle + ((i + k) / (float)num_segments) * (end_angle - start_angle);
+                    cosines[k] = NMD_COS(angle);
+                    sines[k] = NMD_SIN(angle);
+                }
+                c = _NMD_V4_LOAD(cosines);
+                s = _NMD_V4_LOAD(sines);
+            }
+
+            const _nmd_v4 x = _NMD_V4_ADD(center_x, _NMD_V4_MUL(c, r));
+            const _nmd_v4 y = _NMD_V4_ADD(center_y, _NMD_V4_MUL(s, r));
+            _NMD_V4_STORE(&path[i].x, _NMD_V4_ZIP_LO(x, y));
+            _NMD_V4_STORE(&path[i + 2].x, _NMD_V4_ZIP_HI(x, y));
+
+            const _nmd_v4 next_c = _NMD_V4_SUB(_NMD_V4_MUL(c, cos_step4), _NMD_V4_MUL(s, sin_step4));
+            s = _NMD_V4_ADD(_NMD_V4_MUL(s, cos_step4), _NMD_V4_MUL(c, sin_step4));
+            c = next_c;
+        }
+    }
+#endif /* _NMD_GRAPHICS_SIMD */
+
+    for (; i <= num_segments; i++)
+    {
+        const float angle = start_angle + (i / (float)num_segments) * (end_angle - start_angle);
+        path[i].x = x0 + NMD_COS(angle) * radius;
+        path[i].y = y0 + NMD_SIN(angle) * radius;
+    }
+}
+
 void nmd_add_polyline(const nmd_vec2* points, size_t num_points, nmd_color color, bool closed, float thickness)
 {
     const size_t num_segments = closed ? num_points : num_points - 1;
@@ -5961,7 +7288,7 @@ void nmd_add_polyline(const nmd_vec2* points, size_t num_points, nmd_color color
     col_trans = color;
     col_trans.a = 0;
 
-    if (_nmd_context.draw_list.line_anti_aliasing)
+    if (_nmd_context->draw_list.line_anti_aliasing)
     {
         const float AA_SIZE = 1.0f;
 
@@ -5972,185 +7299,52 @@ void nmd_add_polyline(const nmd_vec2* points, size_t num_points, nmd_color color
         if (!_nmd_reserve(vtx_count, idx_count))
             return;
 
-        size_t size;
-        nmd_vec2* normals, * temp;
+        nmd_vec2* normals, * miters;
 #ifdef NMD_GRAPHICS_AVOID_ALLOCA
-        normals = (nmd_vec2*)NMD_MALLOC(sizeof(nmd_vec2) * ((thick_line) ? 5 : 3) * num_points);
+        normals = (nmd_vec2*)_nmd_frame_alloc(sizeof(nmd_vec2) * 2 * num_points);
+        if (!normals)
+            return;
 #else
-        normals = (nmd_vec2*)NMD_ALLOCA(sizeof(nmd_vec2) * ((thick_line) ? 5 : 3) * num_points);
+        normals = (nmd_vec2*)NMD_ALLOCA(sizeof(nmd_vec2) * 2 * num_points);
 #endif
 
-        temp = normals + num_points;
+        miters = normals + num_points;
 
-        /* Calculate normals */
-        for (i1 = 0; i1 < num_segments; ++i1) {
-            const int i2 = (i1 + 1) == num_points ? 0 : i1 + 1;
-            float dx = points[i2].x - points[i1].x;
-            float dy = points[i2].y - points[i1].y;
-            NMD_NORMALIZE2F_OVER_ZERO(dx, dy);
-            normals[i1].x = dy;
-            normals[i1].y = -dx;
-        }
-
-        if (!closed)
-            normals[num_points - 1] = normals[num_points - 2];
+        _nmd_compute_normals(points, num_points, closed, normals);
+        _nmd_compute_miters(normals, num_points, closed, 100.0f, miters);
 
         if (!thick_line) {
-            size_t idx1, i;
-            if (!closed) {
-                nmd_vec2 d;
-
-                temp[0].x = points[0].x + normals[0].x * AA_SIZE;
-                temp[0].y = points[0].y + normals[0].y * AA_SIZE;
-
-                temp[1].x = points[0].x - normals[0].x * AA_SIZE;
-                temp[1].y = points[0].y - normals[0].y * AA_SIZE;
-
-                d.x = normals[num_points - 1].x * AA_SIZE;
-                d.y = normals[num_points - 1].y * AA_SIZE;
-
-                temp[(num_points - 1) * 2 + 0].x = points[num_points - 1].x + d.x;
-                temp[(num_points - 1) * 2 + 0].y = points[num_points - 1].y + d.y;
-
-                temp[(num_points - 1) * 2 + 1].x = points[num_points - 1].x - d.x;
-                temp[(num_points - 1) * 2 + 1].y = points[num_points - 1].y - d.y;
-            }
-
-            /* Fill elements */
-            idx1 = _nmd_context.draw_list.num_vertices;
+            /* Add indices */
+            size_t idx1 = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
             for (i1 = 0; i1 < num_segments; i1++) {
-                nmd_vec2 dm;
-                float dmr2;
-                size_t i2 = ((i1 + 1) == num_points) ? 0 : (i1 + 1);
-                size_t idx2 = ((i1 + 1) == num_points) ? _nmd_context.draw_list.num_vertices : (idx1 + 3);
-
-                /* Average normals */
-                dm.x = (normals[i1].x + normals[i2].x) * 0.5f;
-                dm.y = (normals[i1].y + normals[i2].y) * 0.5f;
-
-                dmr2 = dm.x * dm.x + dm.y * dm.y;
-                if (dmr2 > 0.000001f) {
-                    float scale = 1.0f / dmr2;
-
-                    scale = NMD_MIN(100.0f, scale);
-
-                    dm.x = dm.x * scale;
-                    dm.y = dm.y * scale;
-                }
-
-                dm.x = dm.x * AA_SIZE;
-                dm.y = dm.y * AA_SIZE;
-
-                temp[i2 * 2 + 0].x = points[i2].x + dm.x;
-                temp[i2 * 2 + 0].y = points[i2].y + dm.y;
+                size_t idx2 = ((i1 + 1) == num_points) ? (_nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset) : (idx1 + 3);
 
-                temp[i2 * 2 + 1].x = points[i2].x - dm.x;
-                temp[i2 * 2 + 1].y = points[i2].y - dm.y;
-
-                nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
+                nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
                 indices[0]  = idx2 + 0; indices[1]  = idx1 + 0;
                 indices[2]  = idx1 + 2; indices[3]  = idx1 + 2;
                 indices[4]  = idx2 + 2; indices[5]  = idx2 + 0;
                 indices[6]  = idx2 + 1; indices[7]  = idx1 + 1;
                 indices[8]  = idx1 + 0; indices[9]  = idx1 + 0;
                 indices[10] = idx2 + 0; indices[11] = idx2 + 1;
-                _nmd_context.draw_list.num_indices += 12;
+                _nmd_context->draw_list.num_indices += 12;
 
                 idx1 = idx2;
             }
 
-            /* Fill vertices */
-            for (i = 0; i < num_points; ++i) {
-                nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
-                vertices[0].pos = points[i];       vertices[0].color = color;
-                vertices[1].pos = temp[i * 2 + 0]; vertices[1].color = col_trans;
-                vertices[2].pos = temp[i * 2 + 1]; vertices[2].color = col_trans;
-                _nmd_context.draw_list.num_vertices += 3;
-            }
+            /* Add vertices: the point and the two edges of the anti-aliasing fringe */
+            const float offsets[3] = { 0.0f, AA_SIZE, -AA_SIZE };
+            const nmd_color colors[3] = { color, col_trans, col_trans };
+            _nmd_add_miter_vertices(points, miters, num_points, offsets, colors, 3);
         }
         else {
-            size_t idx1, i;
             const float half_inner_thickness = (thickness - AA_SIZE) * 0.5f;
-            if (!closed) {
-                nmd_vec2 d1;
-                d1.x = normals[0].x * (half_inner_thickness + AA_SIZE);
-                d1.y = normals[0].y * (half_inner_thickness + AA_SIZE);
-
-                nmd_vec2 d2;
-                d2.x = normals[0].x * half_inner_thickness;
-                d2.y = normals[0].y * half_inner_thickness;
-        
-                temp[0].x = points[0].x + d1.x;
-                temp[0].y = points[0].y + d1.y;
-
-                temp[1].x = points[0].x + d2.x;
-                temp[1].y = points[0].y + d2.y;
-
-                temp[2].x = points[0].x - d2.x;
-                temp[2].y = points[0].y - d2.y;
-
-                temp[3].x = points[0].x - d1.x;
-                temp[3].y = points[0].y - d1.y;
-        
-                d1.x = normals[num_points - 1].x * (half_inner_thickness + AA_SIZE);
-                d1.y = normals[num_points - 1].y * (half_inner_thickness + AA_SIZE);
-
-                d2.x = normals[num_points - 1].x * half_inner_thickness;
-                d2.y = normals[num_points - 1].y * half_inner_thickness;
-        
-                temp[(num_points - 1) * 4 + 0].x = points[num_points - 1].x + d1.x;
-                temp[(num_points - 1) * 4 + 0].y = points[num_points - 1].y + d1.y;
-
-                temp[(num_points - 1) * 4 + 1].x = points[num_points - 1].x + d2.x;
-                temp[(num_points - 1) * 4 + 1].y = points[num_points - 1].y + d2.y;
-
-                temp[(num_points - 1) * 4 + 2].x = points[num_points - 1].x - d2.x;
-                temp[(num_points - 1) * 4 + 2].y = points[num_points - 1].y - d2.y;
-
-                temp[(num_points - 1) * 4 + 3].x = points[num_points - 1].x - d1.x;
-                temp[(num_points - 1) * 4 + 3].y = points[num_points - 1].y - d1.y;
-            }
         
-            /* Add all elements */
-            idx1 = _nmd_context.draw_list.num_vertices;
+            /* Add indices */
+            size_t idx1 = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
             for (i1 = 0; i1 < num_segments; ++i1) {
-                nmd_vec2 dm_out, dm_in;
-                const size_t i2 = ((i1 + 1) == num_points) ? 0 : (i1 + 1);
-                size_t idx2 = ((i1 + 1) == num_points) ? _nmd_context.draw_list.num_vertices : (idx1 + 4);
-        
-                /* Average normals */
-                nmd_vec2 dm;
-                dm.x = (normals[i1].x + normals[i2].x) * 0.5f;
-                dm.y = (normals[i1].y + normals[i2].y) * 0.5f;
-
-                float dmr2 = dm.x * dm.x + dm.y * dm.y;
-                if (dmr2 > 0.000001f) {
-                    float scale = 1.0f / dmr2;
-                    scale = NMD_MIN(100.0f, scale);
-                    dm.x = dm.x * scale;
-                    dm.y = dm.y * scale;
-                }
-        
-                dm_out.x = dm.x * ((half_inner_thickness)+AA_SIZE);
-                dm_out.y = dm.y * ((half_inner_thickness)+AA_SIZE);
-
-                dm_in.x = dm.x * half_inner_thickness;
-                dm_in.y = dm.y * half_inner_thickness;
-
-
-                temp[i2 * 4 + 0].x = points[i2].x + dm_out.x;
-                temp[i2 * 4 + 0].y = points[i2].y + dm_out.y;
-
-                temp[i2 * 4 + 1].x = points[i2].x + dm_in.x;
-                temp[i2 * 4 + 1].y = points[i2].y + dm_in.y;
-
-                temp[i2 * 4 + 2].x = points[i2].x - dm_in.x;
-                temp[i2 * 4 + 2].y = points[i2].y - dm_in.y;
-
-                temp[i2 * 4 + 3].x = points[i2].x - dm_out.x;
-                temp[i2 * 4 + 3].y = points[i2].y - dm_out.y;
+                size_t idx2 = ((i1 + 1) == num_points) ? (_nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset) : (idx1 + 4);
         
-                nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
+                nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
                 indices[0]  = idx2 + 1; indices[1]  = idx1 + 1;
                 indices[2]  = idx1 + 2; indices[3]  = idx1 + 2;
                 indices[4]  = idx2 + 2; indices[5]  = idx2 + 1;
@@ -6160,24 +7354,19 @@ void nmd_add_polyline(const nmd_vec2* points, size_t num_points, nmd_color color
                 indices[12] = idx2 + 2; indices[13] = idx1 + 2;
                 indices[14] = idx1 + 3; indices[15] = idx1 + 3;
                 indices[16] = idx2 + 3; indices[17] = idx2 + 2;
-                _nmd_context.draw_list.num_indices += 18;
+                _nmd_context->draw_list.num_indices += 18;
 
                 idx1 = idx2;                
             }
         
-            /* Add vertices */
-            for (i = 0; i < num_points; i++) {
-                nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
-                vertices[0].pos = temp[i * 4 + 0]; vertices[0].color = col_trans;
-                vertices[1].pos = temp[i * 4 + 1]; vertices[1].color = color;
-                vertices[2].pos = temp[i * 4 + 2]; vertices[2].color = color;
-                vertices[3].pos = temp[i * 4 + 3]; vertices[3].color = col_trans;
-                _nmd_context.draw_list.num_vertices += 4;
-            }
+            /* Add vertices: the outer and inner edges on both sides of the line */
+            const float offsets[4] = { half_inner_thickness + AA_SIZE, half_inner_thickness, -half_inner_thickness, -(half_inner_thickness + AA_SIZE) };
+            const nmd_color colors[4] = { col_trans, color, color, col_trans };
+            _nmd_add_miter_vertices(points, miters, num_points, offsets, colors, 4);
         }
 
 #ifdef NMD_GRAPHICS_AVOID_ALLOCA
-        NMD_FREE(normals);
+        _nmd_frame_release(normals, sizeof(nmd_vec2) * 2 * num_points);
 #endif /* NMD_GRAPHICS_AVOID_ALLOCA*/
     }
     else /* Non anti-alised */
@@ -6201,19 +7390,19 @@ void nmd_add_polyline(const nmd_vec2* points, size_t num_points, nmd_color color
             dx *= (thickness * 0.5f);
             dy *= (thickness * 0.5f);
 
-            const size_t offset = _nmd_context.draw_list.num_vertices;
+            const size_t offset = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
 
-            nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
+            nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
             indices[0] = offset + 0; indices[1] = offset + 1; indices[2] = offset + 2;
             indices[3] = offset + 0; indices[4] = offset + 2; indices[5] = offset + 3;
-            _nmd_context.draw_list.num_indices += 6;
+            _nmd_context->draw_list.num_indices += 6;
 
-            nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
+            nmd_vertex* vertices = _nmd_context->draw_list.vertices + _nmd_context->draw_list.num_vertices;
             vertices[0].pos.x = p0->x + dy; vertices[0].pos.y = p0->y - dx; vertices[0].color = color;
             vertices[1].pos.x = p1->x + dy; vertices[1].pos.y = p1->y - dx; vertices[1].color = color;
             vertices[2].pos.x = p1->x - dy; vertices[2].pos.y = p1->y + dx; vertices[2].color = color;
             vertices[3].pos.x = p0->x - dy; vertices[3].pos.y = p0->y + dx; vertices[3].color = color;
-            _nmd_context.draw_list.num_vertices += 4;
+            _nmd_context->draw_list.num_vertices += 4;
         }
     }
 }
@@ -6223,25 +7412,25 @@ void nmd_path_to(float x0, float y0)
     if (!_nmd_reserve_points(1))
         return;
 
-    _nmd_context.draw_list.path[_nmd_context.draw_list.num_points].x = x0;
-    _nmd_context.draw_list.path[_nmd_context.draw_list.num_points].y = y0;
-    _nmd_context.draw_list.num_points++;
+    _nmd_context->draw_list.path[_nmd_context->draw_list.num_points].x = x0;
+    _nmd_context->draw_list.path[_nmd_context->draw_list.num_points].y = y0;
+    _nmd_context->draw_list.num_points++;
 }
 
 void nmd_path_fill_convex(nmd_color color)
 {
-    nmd_add_convex_polygon_filled(_nmd_context.draw_list.path, _nmd_context.draw_list.num_points, color);
+    nmd_add_convex_polygon_filled(_nmd_context->draw_list.path, _nmd_context->draw_list.num_points, color);
 
     /* Clear points in 'path' */
-    _nmd_context.draw_list.num_points = 0;
+    _nmd_context->draw_list.num_points = 0;
 }
 
 void nmd_path_stroke(nmd_color color, bool closed, float thickness)
 {
-    nmd_add_polyline(_nmd_context.draw_list.path, _nmd_context.draw_list.num_points, color, closed, thickness);
+    nmd_add_polyline(_nmd_context->draw_list.path, _nmd_context->draw_list.num_points, color, closed, thickness);
 
     /* Clear points in 'path' */
-    _nmd_context.draw_list.num_points = 0;
+    _nmd_context->draw_list.num_points = 0;
 }
 
 /*
@@ -6291,28 +7480,37 @@ void _nmd_shade_verts_linear_uv(int vert_start_idx, int vert_end_idx, float x0,
     const float scale_x = size_x != 0.0f ? (uv_size_x / size_x) : 0.0f;
     const float scale_y = size_y != 0.0f ? (uv_size_y / size_y) : 0.0f;
 
-    nmd_vertex* vert_start = _nmd_context.draw_list.vertices + vert_start_idx;
-    nmd_vertex* vert_end = _nmd_context.draw_list.vertices + vert_end_idx;
-    if (clamp)
+    nmd_vertex* vertex = _nmd_context->draw_list.vertices + vert_start_idx;
+    nmd_vertex* vert_end = _nmd_context->draw_list.vertices + vert_end_idx;
+
+    const float min_x = clamp ? NMD_MIN(uv_x0, uv_x1) : -3.402823466e+38f;
+    const float min_y = clamp ? NMD_MIN(uv_y0, uv_y1) : -3.402823466e+38f;
+    const float max_x = clamp ? NMD_MAX(uv_x0, uv_x1) : 3.402823466e+38f;
+    const float max_y = clamp ? NMD_MAX(uv_y0, uv_y1) : 3.402823466e+38f;
+
+#ifdef _NMD_GRAPHICS_SIMD
+    /* Two vertices per iteration */
+    const float constants[5][4] = { { x0, y0, x0, y0 }, { uv_x0, uv_y0, uv_x0, uv_y0 }, { scale_x, scale_y, scale_x, scale_y }, { min_x, min_y, min_x, min_y }, { max_x, max_y, max_x, max_y } };
+    const _nmd_v4 pos0 = _NMD_V4_LOAD(constants[0]);
+    const _nmd_v4 uv0 = _NMD_V4_LOAD(constants[1]);
+    const _nmd_v4 scale = _NMD_V4_LOAD(constants[2]);
+    const _nmd_v4 uv_min = _NMD_V4_LOAD(constants[3]);
+    const _nmd_v4 uv_max = _NMD_V4_LOAD(constants[4]);
+    for (; vertex + 2 <= vert_end; vertex += 2)
     {
-        const float min_x = NMD_MIN(uv_x0, uv_x1);
-        const float min_y = NMD_MIN(uv_y0, uv_y1);
-
-        const float max_x = NMD_MAX(uv_x0, uv_x1);
-        const float max_y = NMD_MAX(uv_y1, uv_y1);
-        for (nmd_vertex* vertex = vert_start; vertex < vert_end; ++vertex)
-        {
-            vertex->uv.x = NMD_CLAMP(uv_x0 + (vertex->pos.x - x0) * scale_x, min_x, max_x);
-            vertex->uv.y = NMD_CLAMP(uv_y0 + (vertex->pos.y - y0) * scale_y, min_x, max_x);
-        }
+        const _nmd_v4 pos = _NMD_V4_LOAD_LO_HI(&vertex[0].pos.x, &vertex[1].pos.x);
+        const _nmd_v4 uv = _NMD_V4_MIN(_NMD_V4_MAX(_NMD_V4_ADD(uv0, _NMD_V4_MUL(_NMD_V4_SUB(pos, pos0), scale)), uv_min), uv_max);
+        _NMD_V4_STORE_LO(&vertex[0].uv.x, uv);
+        _NMD_V4_STORE_HI(&vertex[1].uv.x, uv);
     }
-    else
+#endif /* _NMD_GRAPHICS_SIMD */
+
+    for (; vertex < vert_end; ++vertex)
     {
-        for (nmd_vertex* vertex = vert_start; vertex < vert_end; ++vertex)
-        {
-            vertex->uv.x = uv_x0 + (vertex->pos.x - x0) * scale_x;
-            vertex->uv.y = uv_y0 + (vertex->pos.y - y0) * scale_y;
-        }
+        const float u = uv_x0 + (vertex->pos.x - x0) * scale_x;
+        const float v = uv_y0 + (vertex->pos.y - y0) * scale_y;
+        vertex->uv.x = NMD_CLAMP(u, min_x, max_x);
+        vertex->uv.y = NMD_CLAMP(v, min_y, max_y);
     }
 }
 
@@ -6341,19 +7539,19 @@ void nmd_add_rect_filled(float x0, float y0, float x1, float y1, nmd_color color
         if (!_nmd_reserve(4, 6))
             return;
 
-        const size_t offset = _nmd_context.draw_list.num_vertices;
+        const size_t offset = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
 
-        nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
+        nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
         indices[0] = offset + 0; indices[1] = offset + 1; indices[2] = offset + 2;
         indices[3] = offset + 0; indices[4] = offset + 2; indices[5] = offset + 3;
-        _nmd_context.draw_list.num_indices += 6;
+        _nmd_context->draw_list.num_indices += 6;
 
-        nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
+        nmd_vertex* vertices = _nmd_context->draw_list.vertices + _nmd_context->draw_list.num_vertices;
         vertices[0].pos.x = x0; vertices[0].pos.y = y0; vertices[0].color = color;
         vertices[1].pos.x = x1; vertices[1].pos.y = y0; vertices[1].color = color;
         vertices[2].pos.x = x1; vertices[2].pos.y = y1; vertices[2].color = color;
         vertices[3].pos.x = x0; vertices[3].pos.y = y1; vertices[3].color = color;
-        _nmd_context.draw_list.num_vertices += 4;
+        _nmd_context->draw_list.num_vertices += 4;
     }
 }
 
@@ -6362,19 +7560,19 @@ void nmd_add_rect_filled_multi_color(float x0, float y0, float x1, float y1, nmd
     if (!_nmd_reserve(4, 6))
         return;
 
-    const size_t offset = _nmd_context.draw_list.num_vertices;
+    const size_t offset = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
 
-    nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
+    nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
     indices[0] = offset + 0; indices[1] = offset + 1; indices[2] = offset + 2;
     indices[3] = offset + 0; indices[4] = offset + 2; indices[5] = offset + 3;
-    _nmd_context.draw_list.num_indices += 6;
+    _nmd_context->draw_list.num_indices += 6;
 
-    nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
+    nmd_vertex* vertices = _nmd_context->draw_list.vertices + _nmd_context->draw_list.num_vertices;
     vertices[0].pos.x = x0; vertices[0].pos.y = y0; vertices[0].color = color_upper_left;
     vertices[1].pos.x = x1; vertices[1].pos.y = y0; vertices[1].color = color_upper_right;
     vertices[2].pos.x = x1; vertices[2].pos.y = y1; vertices[2].color = color_bottom_right;
     vertices[3].pos.x = x0; vertices[3].pos.y = y1; vertices[3].color = color_bottom_left;
-    _nmd_context.draw_list.num_vertices += 4;
+    _nmd_context->draw_list.num_vertices += 4;
 }
 
 void nmd_add_quad(float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3, nmd_color color, float thickness)
@@ -6433,7 +7631,7 @@ void nmd_add_circle(float x0, float y0, float radius, nmd_color color, size_t nu
         return;
 
     if (num_segments == 0)
-        num_segments = (radius - 1 < 64) ? _nmd_context.draw_list.cached_circle_segment_counts64[(int)radius - 1] : NMD_CIRCLE_AUTO_SEGMENT_CALC(radius, 1.6f);
+        num_segments = (radius - 1 < 64) ? _nmd_context->draw_list.cached_circle_segment_counts64[(int)radius - 1] : NMD_CIRCLE_AUTO_SEGMENT_CALC(radius, 1.6f);
     else
         num_segments = NMD_CLAMP(num_segments, 3, NMD_CIRCLE_AUTO_SEGMENT_MAX);
 
@@ -6451,7 +7649,7 @@ void nmd_add_circle_filled(float x0, float y0, float radius, nmd_color color, si
         return;
 
     if (num_segments <= 0)
-        num_segments = (radius - 1 < 64) ? _nmd_context.draw_list.cached_circle_segment_counts64[(int)radius - 1] : NMD_CIRCLE_AUTO_SEGMENT_CALC(radius, 1.6f);
+        num_segments = (radius - 1 < 64) ? _nmd_context->draw_list.cached_circle_segment_counts64[(int)radius - 1] : NMD_CIRCLE_AUTO_SEGMENT_CALC(radius, 1.6f);
     else
         num_segments = NMD_CLAMP(num_segments, 3, NMD_CIRCLE_AUTO_SEGMENT_MAX);
 
@@ -6507,10 +7705,10 @@ void nmd_path_rect(float x0, float y0, float x1, float y1, float rounding, uint3
 
 void nmd_path_arc_to(float x0, float y0, float radius, float start_angle, float end_angle, size_t num_segments, bool start_at_center)
 {
-    if (!_nmd_reserve_points((start_at_center ? 1 : 0) + num_segments))
+    if (!num_segments || !_nmd_reserve_points((start_at_center ? 1 : 0) + num_segments + 1))
         return;
 
-    nmd_vec2* path = _nmd_context.draw_list.path + _nmd_context.draw_list.num_points;
+    nmd_vec2* path = _nmd_context->draw_list.path + _nmd_context->draw_list.num_points;
 
     if (start_at_center)
     {
@@ -6518,22 +7716,17 @@ void nmd_path_arc_to(float x0, float y0, float radius, float start_angle, float
         path++;
     }
 
-    for (size_t i = 0; i <= num_segments; i++)
-    {
-        const float angle = start_angle + (i / (float)num_segments) * (end_angle - start_angle);
-        path[i].x = x0 + NMD_COS(angle) * radius;
-        path[i].y = y0 + NMD_SIN(angle) * radius;
-    }
+    _nmd_arc_points(path, x0, y0, radius, start_angle, end_angle, num_segments);
 
-    _nmd_context.draw_list.num_points = (start_at_center ? 1 : 0) + num_segments + 1;
+    _nmd_context->draw_list.num_points += (start_at_center ? 1 : 0) + num_segments + 1;
 }
 
 void nmd_path_arc_to_cached(float x0, float y0, float radius, size_t start_angle_of12, size_t end_angle_of12, bool start_at_center)
 {
-    if (!_nmd_reserve_points((start_at_center ? 1 : 0) + (end_angle_of12 - start_angle_of12)))
+    if (!_nmd_reserve_points((start_at_center ? 1 : 0) + (end_angle_of12 - start_angle_of12) + 1))
         return;
 
-    nmd_vec2* path = _nmd_context.draw_list.path + _nmd_context.draw_list.num_points;
+    nmd_vec2* path = _nmd_context->draw_list.path + _nmd_context->draw_list.num_points;
 
     if (start_at_center)
     {
@@ -6543,13 +7736,13 @@ void nmd_path_arc_to_cached(float x0, float y0, float radius, size_t start_angle
 
     for (size_t angle = start_angle_of12; angle <= end_angle_of12; angle++)
     {
-        const nmd_vec2* point = &_nmd_context.draw_list.cached_circle_vertices12[angle % 12];
+        const nmd_vec2* point = &_nmd_context->draw_list.cached_circle_vertices12[angle % 12];
         path->x = x0 + point->x * radius;
         path->y = y0 + point->y * radius;
         path++;
     }
 
-    _nmd_context.draw_list.num_points = path - _nmd_context.draw_list.path;
+    _nmd_context->draw_list.num_points = path - _nmd_context->draw_list.path;
 }
 
 /*
@@ -6569,36 +7762,36 @@ void DrawList::PathBezierCurveTo(const nmd_vec2& p2, const nmd_vec2& p3, const n
 
 void nmd_prim_rect_uv(float x0, float y0, float x1, float y1, float uv_x0, float uv_y0, float uv_x1, float uv_y1, nmd_color color)
 {
-    const size_t offset = _nmd_context.draw_list.num_vertices;
+    const size_t offset = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
 
-    nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
+    nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
     indices[0] = offset + 0; indices[1] = offset + 1; indices[2] = offset + 2;
     indices[3] = offset + 0; indices[4] = offset + 2; indices[5] = offset + 3;
-    _nmd_context.draw_list.num_indices += 6;
+    _nmd_context->draw_list.num_indices += 6;
 
-    nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
+    nmd_vertex* vertices = _nmd_context->draw_list.vertices + _nmd_context->draw_list.num_vertices;
     vertices[0].pos.x = x0; vertices[0].pos.y = y0; vertices[0].uv.x = uv_x0; vertices[0].uv.y = uv_y0; vertices[0].color = color;
     vertices[1].pos.x = x1; vertices[1].pos.y = y0; vertices[1].uv.x = uv_x1; vertices[1].uv.y = uv_y0; vertices[1].color = color;
     vertices[2].pos.x = x1; vertices[2].pos.y = y1; vertices[2].uv.x = uv_x1; vertices[2].uv.y = uv_y1; vertices[2].color = color;
     vertices[3].pos.x = x0; vertices[3].pos.y = y1; vertices[3].uv.x = uv_x0; vertices[3].uv.y = uv_y1; vertices[3].color = color;
-    _nmd_context.draw_list.num_vertices += 4;
+    _nmd_context->draw_list.num_vertices += 4;
 }
 
 void nmd_prim_quad_uv(float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3, float uv_x0, float uv_y0, float uv_x1, float uv_y1, float uv_x2, float uv_y2, float uv_x3, float uv_y3, nmd_color color)
 {
-    const size_t offset = _nmd_context.draw_list.num_vertices;
+    const size_t offset = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
 
-    nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
+    nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
     indices[0] = offset + 0; indices[1] = offset + 1; indices[2] = offset + 2;
     indices[3] = offset + 0; indices[4] = offset + 2; indices[5] = offset + 3;
-    _nmd_context.draw_list.num_indices += 6;
+    _nmd_context->draw_list.num_indices += 6;
 
-    nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
+    nmd_vertex* vertices = _nmd_context->draw_list.vertices + _nmd_context->draw_list.num_vertices;
     vertices[0].pos.x = x0; vertices[0].pos.y = y0; vertices[0].uv.x = uv_x0; vertices[0].uv.y = uv_y0; vertices[0].color = color;
     vertices[1].pos.x = x1; vertices[1].pos.y = y1; vertices[1].uv.x = uv_x1; vertices[1].uv.y = uv_y1; vertices[1].color = color;
     vertices[2].pos.x = x2; vertices[2].pos.y = y2; vertices[2].uv.x = uv_x2; vertices[2].uv.y = uv_y2; vertices[2].color = color;
     vertices[3].pos.x = x3; vertices[3].pos.y = y3; vertices[3].uv.x = uv_x3; vertices[3].uv.y = uv_y3; vertices[3].color = color;
-    _nmd_context.draw_list.num_vertices += 4;
+    _nmd_context->draw_list.num_vertices += 4;
 }
 
 void nmd_add_line(float x0, float y0, float x1, float y1, nmd_color color, float thickness)
@@ -6616,7 +7809,7 @@ void nmd_add_convex_polygon_filled(const nmd_vec2* points, size_t num_points, nm
     if (num_points < 3)
         return;
 
-    if (_nmd_context.draw_list.fill_anti_aliasing)
+    if (_nmd_context->draw_list.fill_anti_aliasing)
     {
         /* Anti-aliased fill */
         const float AA_SIZE = 1.0f;
@@ -6629,60 +7822,45 @@ void nmd_add_convex_polygon_filled(const nmd_vec2* points, size_t num_points, nm
             return;
 
         /* Add indexes for fill */
-        unsigned int vtx_inner_idx = _nmd_context.draw_list.num_vertices;
-        unsigned int vtx_outer_idx = _nmd_context.draw_list.num_vertices + 1;
-        nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
-        for (int i = 2; i < num_points; i++)
-        {
-            indices[0] = vtx_inner_idx; indices[1] = vtx_inner_idx + ((i - 1) << 1); indices[2] = vtx_inner_idx + (i << 1);
-            indices += 3;
-        }
-
-        /* Compute normals */
-#ifdef NMD_GRAPHICS_AVOID_ALLOCA
-        nmd_vec2* temp_normals = (nmd_vec2*)NMD_MALLOC(num_points * sizeof(nmd_vec2));
-#else
-        nmd_vec2* temp_normals = (nmd_vec2*)NMD_ALLOCA(num_points * sizeof(nmd_vec2));
-#endif
-
-        for (int i0 = num_points - 1, i1 = 0; i1 < num_points; i0 = i1++)
+        unsigned int vtx_inner_idx = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
+        unsigned int vtx_outer_idx = vtx_inner_idx + 1;
+        nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
+        for (int i = 2; i < num_points; i++)
         {
-            const nmd_vec2* p0 = &points[i0];
-            const nmd_vec2* p1 = &points[i1];
-            float dx = p1->x - p0->x;
-            float dy = p1->y - p0->y;
-            NMD_NORMALIZE2F_OVER_ZERO(dx, dy);
-            temp_normals[i0].x = dy;
-            temp_normals[i0].y = -dx;
+            indices[0] = vtx_inner_idx; indices[1] = vtx_inner_idx + ((i - 1) << 1); indices[2] = vtx_inner_idx + (i << 1);
+            indices += 3;
         }
 
-        nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
+        /* Add indexes for fringes */
         for (int i0 = num_points - 1, i1 = 0; i1 < num_points; i0 = i1++)
         {
-            /* Average normals */
-            const nmd_vec2* n0 = &temp_normals[i0];
-            const nmd_vec2* n1 = &temp_normals[i1];
-            float dm_x = (n0->x + n1->x) * 0.5f;
-            float dm_y = (n0->y + n1->y) * 0.5f;
-            NMD_FIXNORMAL2F(dm_x, dm_y);
-            dm_x *= AA_SIZE * 0.5f;
-            dm_y *= AA_SIZE * 0.5f;
-
-            /* Add vertices */
-            vertices[0].pos.x = (points[i1].x - dm_x); vertices[0].pos.y = (points[i1].y - dm_y); vertices[0].color = color;
-            vertices[1].pos.x = (points[i1].x + dm_x); vertices[1].pos.y = (points[i1].y + dm_y); vertices[1].color = col_trans;
-            vertices += 2;
-
-            /* Add indexes for fringes */
             indices[0] = vtx_inner_idx + (i1 << 1); indices[1] = vtx_inner_idx + (i0 << 1); indices[2] = vtx_outer_idx + (i0 << 1);
             indices[3] = vtx_outer_idx + (i0 << 1); indices[4] = vtx_outer_idx + (i1 << 1); indices[5] = vtx_inner_idx + (i1 << 1);
             indices += 6;
         }
-        _nmd_context.draw_list.num_vertices = vertices - _nmd_context.draw_list.vertices;
-        _nmd_context.draw_list.num_indices = indices - _nmd_context.draw_list.indices;
+        _nmd_context->draw_list.num_indices = indices - _nmd_context->draw_list.indices;
+
+        /* Compute normals */
+#ifdef NMD_GRAPHICS_AVOID_ALLOCA
+        nmd_vec2* temp_normals = (nmd_vec2*)_nmd_frame_alloc(2 * num_points * sizeof(nmd_vec2));
+        if (!temp_normals)
+            return;
+#else
+        nmd_vec2* temp_normals = (nmd_vec2*)NMD_ALLOCA(2 * num_points * sizeof(nmd_vec2));
+#endif
+        nmd_vec2* miters = temp_normals + num_points;
+
+        /* The inverse squared length of the averaged normals is limited to 2(the length to 0.5) */
+        _nmd_compute_normals(points, num_points, true, temp_normals);
+        _nmd_compute_miters(temp_normals, num_points, true, 2.0f, miters);
+
+        /* Add vertices: the inner edge and the outer edge of the anti-aliasing fringe */
+        const float offsets[2] = { -AA_SIZE * 0.5f, AA_SIZE * 0.5f };
+        const nmd_color colors[2] = { color, col_trans };
+        _nmd_add_miter_vertices(points, miters, num_points, offsets, colors, 2);
 
 #ifdef NMD_GRAPHICS_AVOID_ALLOCA
-        NMD_FREE(temp_normals);
+        _nmd_frame_release(temp_normals, 2 * num_points * sizeof(nmd_vec2));
 #endif /* NMD_GRAPHICS_AVOID_ALLOCA */
     }
     else
@@ -6690,16 +7868,16 @@ void nmd_add_convex_polygon_filled(const nmd_vec2* points, size_t num_points, nm
         if (!_nmd_reserve(num_points, (num_points - 2) * 3))
             return;
 
-        const size_t offset = _nmd_context.draw_list.num_vertices;
-        nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
+        const size_t offset = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
+        nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
         for (size_t i = 2; i < num_points; i++)
             indices[(i - 2) * 3 + 0] = offset, indices[(i - 2) * 3 + 1] = offset + (i - 1), indices[(i - 2) * 3 + 2] = offset + i;
-        _nmd_context.draw_list.num_indices += (num_points - 2) * 3;
+        _nmd_context->draw_list.num_indices += (num_points - 2) * 3;
 
-        nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
+        nmd_vertex* vertices = _nmd_context->draw_list.vertices + _nmd_context->draw_list.num_vertices;
         for (size_t i = 0; i < num_points; i++)
             vertices[i].pos.x = points[i].x, vertices[i].pos.y = points[i].y, vertices[i].color = color;
-        _nmd_context.draw_list.num_vertices += num_points;
+        _nmd_context->draw_list.num_vertices += num_points;
     }
 }
 
@@ -6886,143 +8064,756 @@ void nmd_add_dummy_text(float x, float y, const char* text, float height, nmd_co
         }
     }
 }
-#endif /* NMD_GRAPHICS_ENABLE_DUMMY_TEXT_API */
+#endif /* NMD_GRAPHICS_ENABLE_DUMMY_TEXT_API */
+
+/*
+void DrawList::AddBezierCurve(const nmd_vec2& p1, const nmd_vec2& p2, const nmd_vec2& p3, const nmd_vec2& p4, Color color, float thickness, size_t num_segments)
+{
+    if (!color.a)
+        return;
+
+    PathLineTo(p1);
+    PathBezierCurveTo(p2, p3, p4, num_segments);
+    PathStroke(color, false, thickness);
+}
+void nmd_add_text(float x, float y, const char* text, nmd_color color)
+{
+    nmd_add_text(_nmd_context->draw_list.defaultFont, x, y, text, color);
+}
+*/
+
+void nmd_add_text(const nmd_atlas* font, float x, float y, const char* text, const char* text_end, nmd_color color)
+{
+    if (!color.a)
+        return;
+
+    if (!text_end)
+        text_end = text + NMD_STRLEN(text);
+
+    if (!_nmd_reserve((text_end - text) * 4, (text_end - text) * 6))
+        return;
+
+    nmd_push_draw_command(0);
+
+    stbtt_aligned_quad q;
+    for(; text < text_end; text++)
+    {
+        stbtt_GetBakedQuad((stbtt_bakedchar*)font->baked_chars, 512, 512, *text - 32, &x, &y, &q, 1);
+
+        const size_t offset = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
+
+        nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
+        indices[0] = offset + 0; indices[1] = offset + 1; indices[2] = offset + 2;
+        indices[3] = offset + 0; indices[4] = offset + 2; indices[5] = offset + 3;
+        _nmd_context->draw_list.num_indices += 6;
+        
+        nmd_vertex* vertices = _nmd_context->draw_list.vertices + _nmd_context->draw_list.num_vertices;
+        vertices[0].pos.x = q.x0; vertices[0].pos.y = q.y0; vertices[0].uv.x = q.s0; vertices[0].uv.y = q.t0; vertices[0].color = color;
+        vertices[1].pos.x = q.x1; vertices[1].pos.y = q.y0; vertices[1].uv.x = q.s1; vertices[1].uv.y = q.t0; vertices[1].color = color;
+        vertices[2].pos.x = q.x1; vertices[2].pos.y = q.y1; vertices[2].uv.x = q.s1; vertices[2].uv.y = q.t1; vertices[2].color = color;
+        vertices[3].pos.x = q.x0; vertices[3].pos.y = q.y1; vertices[3].uv.x = q.s0; vertices[3].uv.y = q.t1; vertices[3].color = color;
+        _nmd_context->draw_list.num_vertices += 4;
+    }
+
+    nmd_push_texture_draw_command(font->font_id, 0);
+}
+
+void nmd_get_text_size(const nmd_atlas* font, const char* text, const char* text_end, nmd_vec2* size_out)
+{
+    if (!text_end)
+        text_end = text + NMD_STRLEN(text);
+    
+    stbtt_aligned_quad q;
+    float x = 0, y = 0;
+    for (; text < text_end; text++)
+        stbtt_GetBakedQuad((stbtt_bakedchar*)font->baked_chars, 512, 512, *text - 32, &x, &y, &q, 1);
+
+    size_out->x = q.x1;
+    size_out->y = q.y1 - q.y0;
+}
+
+void nmd_add_image(nmd_tex_id user_texture_id, float x0, float y0, float x1, float y1, nmd_color color)
+{
+    nmd_add_image_uv(user_texture_id, x0, y0, x1, y1, 0.0f, 0.0f, 1.0f, 1.0f, color);
+}
+
+void nmd_add_image_uv(nmd_tex_id user_texture_id, float x0, float y0, float x1, float y1, float uv_x0, float uv_y0, float uv_x1, float uv_y1, nmd_color color)
+{
+    if (!color.a)
+        return;
+
+    if (!_nmd_reserve(4, 6))
+        return;
+
+    nmd_push_draw_command(0);
+
+    nmd_prim_rect_uv(x0, y0, x1, y1, uv_x0, uv_y0, uv_x1, uv_y1, color);
+    
+    nmd_push_texture_draw_command(user_texture_id, 0);
+}
+
+void nmd_add_image_quad(nmd_tex_id user_texture_id, float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3, nmd_color color)
+{
+    nmd_add_image_quad_uv(user_texture_id, x0, y0, x1, y1, x2, y2, x3, y3, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f, color);
+}
+
+void nmd_add_image_quad_uv(nmd_tex_id user_texture_id, float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3, float uv_x0, float uv_y0, float uv_x1, float uv_y1, float uv_x2, float uv_y2, float uv_x3, float uv_y3, nmd_color color)
+{
+    if (!color.a)
+        return;
+
+    if (!_nmd_reserve(4, 6))
+        return;
+
+    nmd_push_draw_command(0);
+
+    nmd_prim_quad_uv(x0, y0, x1, y1, x2, y2, x3, y3, uv_x0, uv_y0, uv_x1, uv_y1, uv_x2, uv_y2, uv_x3, uv_y3, color);
+
+    nmd_push_texture_draw_command(user_texture_id, 0);
+}
+
+void nmd_add_image_rounded(nmd_tex_id user_texture_id, float x0, float y0, float x1, float y1, float rounding, uint32_t corner_flags, nmd_color color)
+{
+    nmd_add_image_rounded_uv(user_texture_id, x0, y0, x1, y1, rounding, corner_flags, 0.0f, 0.0f, 1.0f, 1.0f, color);
+}
+
+void nmd_add_image_rounded_uv(nmd_tex_id user_texture_id, float x0, float y0, float x1, float y1, float rounding, uint32_t corner_flags, float uv_x0, float uv_y0, float uv_x1, float uv_y1, nmd_color color)
+{
+    if (!color.a)
+        return;
+
+    if (rounding <= 0.0f || !corner_flags)
+        nmd_add_image_uv(user_texture_id, x0, y0, x1, y1, uv_x0, uv_y0, uv_x1, uv_y1, color);
+    else
+    {
+        nmd_push_draw_command(0);
+
+        const int vert_start_idx = _nmd_context->draw_list.num_vertices;
+        nmd_path_rect(x0, y0, x1, y1, rounding, corner_flags);
+        nmd_path_fill_convex(color);
+        const int vert_end_idx = _nmd_context->draw_list.num_vertices;
+
+        _nmd_shade_verts_linear_uv(vert_start_idx, vert_end_idx, x0, y0, x1, y1, uv_x0, uv_y0, uv_x1, uv_y1, true);
+
+        nmd_push_texture_draw_command(user_texture_id, 0);
+    }
+}
+
+
+/* The number of pixels between glyphs in a page, so bilinear filtering doesn't sample the neighbours */
+#define _NMD_GLYPH_PADDING 1
+
+void nmd_glyph_cache_init(nmd_glyph_cache* cache, int page_size, nmd_tex_id(*create_texture)(void* pixels, int width, int height), void (*update_texture)(nmd_tex_id texture, const void* pixels, int x, int y, int width, int height, int pitch))
+{
+    NMD_MEMSET(cache, 0, sizeof(nmd_glyph_cache));
+    cache->page_size = page_size > 0 ? page_size : NMD_GLYPH_PAGE_SIZE;
+    cache->create_texture = create_texture;
+    cache->update_texture = update_texture;
+    cache->next_font_id = 1;
+}
+
+void nmd_glyph_cache_destroy(nmd_glyph_cache* cache)
+{
+    for (size_t i = 0; i < cache->num_pages; i++)
+    {
+        _nmd_free(cache->pages[i].pixels);
+        _nmd_free(cache->pages[i].skyline);
+    }
+    _nmd_free(cache->pages);
+    _nmd_free(cache->glyphs);
+    _nmd_free(cache->layouts);
+    _nmd_free(cache->quads);
+    _nmd_free(cache->text);
+    NMD_MEMSET(cache, 0, sizeof(nmd_glyph_cache));
+}
+
+void _nmd_clear_layouts(nmd_glyph_cache* cache)
+{
+    if (cache->layouts)
+        NMD_MEMSET(cache->layouts, 0, cache->layouts_capacity * sizeof(nmd_text_layout));
+    cache->num_layouts = 0;
+    cache->num_quads = 0;
+    cache->text_length = 0;
+}
+
+/* Resets the skyline of a page, so the whole page is free */
+void _nmd_reset_glyph_page(nmd_glyph_cache* cache, nmd_glyph_page* page)
+{
+    page->skyline[0].x = 0;
+    page->skyline[0].y = 0;
+    page->skyline[0].width = cache->page_size;
+    page->num_nodes = 1;
+}
+
+void nmd_glyph_cache_clear(nmd_glyph_cache* cache)
+{
+    for (size_t i = 0; i < cache->num_pages; i++)
+    {
+        nmd_glyph_page* page = &cache->pages[i];
+        _nmd_reset_glyph_page(cache, page);
+
+        /* White like a new page, only the alpha is rasterized */
+        for (size_t j = 0; j < (size_t)(cache->page_size * cache->page_size); j++)
+            page->pixels[j] = nmd_rgba(255, 255, 255, 0);
+        page->dirty_x0 = page->dirty_y0 = 0;
+        page->dirty_x1 = page->dirty_y1 = cache->page_size;
+    }
+
+    if (cache->glyphs)
+        NMD_MEMSET(cache->glyphs, 0, cache->glyphs_capacity * sizeof(nmd_glyph));
+    cache->num_glyphs = 0;
+
+    _nmd_clear_layouts(cache);
+}
+
+void nmd_glyph_cache_upload(nmd_glyph_cache* cache)
+{
+    for (size_t i = 0; i < cache->num_pages; i++)
+    {
+        nmd_glyph_page* page = &cache->pages[i];
+        if (page->dirty_x0 >= page->dirty_x1)
+            continue;
+
+        if (cache->update_texture && page->texture)
+            cache->update_texture(page->texture, page->pixels + page->dirty_y0 * cache->page_size + page->dirty_x0, page->dirty_x0, page->dirty_y0, page->dirty_x1 - page->dirty_x0, page->dirty_y1 - page->dirty_y0, cache->page_size * sizeof(nmd_color));
+
+        page->dirty_x0 = page->dirty_y0 = cache->page_size;
+        page->dirty_x1 = page->dirty_y1 = 0;
+    }
+}
+
+/* Adds a page to the glyph cache and creates its texture. Returns a null pointer if memory could not be allocated. */
+nmd_glyph_page* _nmd_add_glyph_page(nmd_glyph_cache* cache)
+{
+    if (cache->num_pages == cache->pages_capacity)
+    {
+        const size_t new_capacity = NMD_MAX(cache->pages_capacity * 2, 4);
+        void* mem = _nmd_alloc(new_capacity * sizeof(nmd_glyph_page));
+        if (!mem)
+            return 0;
+        if (cache->pages)
+            NMD_MEMCPY(mem, cache->pages, cache->num_pages * sizeof(nmd_glyph_page));
+        _nmd_free(cache->pages);
+
+        cache->pages = (nmd_glyph_page*)mem;
+        cache->pages_capacity = new_capacity;
+    }
+
+    nmd_glyph_page* page = &cache->pages[cache->num_pages];
+    NMD_MEMSET(page, 0, sizeof(nmd_glyph_page));
+    page->pixels = (nmd_color*)_nmd_alloc(cache->page_size * cache->page_size * sizeof(nmd_color));
+    page->skyline = (nmd_skyline_node*)_nmd_alloc(cache->page_size * sizeof(nmd_skyline_node));
+    if (!page->pixels || !page->skyline)
+    {
+        _nmd_free(page->pixels);
+        _nmd_free(page->skyline);
+        return 0;
+    }
+
+    /* The pixels are white so the texture can be sampled like the baked atlas, only the alpha is rasterized */
+    for (size_t i = 0; i < (size_t)(cache->page_size * cache->page_size); i++)
+        page->pixels[i] = nmd_rgba(255, 255, 255, 0);
+    page->texture = cache->create_texture ? cache->create_texture(page->pixels, cache->page_size, cache->page_size) : 0;
+    page->dirty_x0 = page->dirty_y0 = cache->page_size;
+    page->dirty_x1 = page->dirty_y1 = 0;
+    _nmd_reset_glyph_page(cache, page);
+
+    cache->num_pages++;
+    return page;
+}
+
+/* Moves the nodes of the skyline from index 'from' to the end, so they start at index 'to' */
+void _nmd_move_skyline_nodes(nmd_glyph_page* page, size_t from, size_t to)
+{
+    const size_t num_moved = page->num_nodes - from;
+    if (to < from)
+    {
+        for (size_t i = 0; i < num_moved; i++)
+            page->skyline[to + i] = page->skyline[from + i];
+    }
+    else
+    {
+        for (size_t i = num_moved; i > 0; i--)
+            page->skyline[to + i - 1] = page->skyline[from + i - 1];
+    }
+    page->num_nodes = to + num_moved;
+}
+
+/*
+Finds the lowest position of the skyline where a 'width' x 'height' rectangle fits(the leftmost one if there're several) and adds the rectangle to the skyline.
+Returns false if the rectangle doesn't fit in the page.
+*/
+bool _nmd_skyline_pack(nmd_glyph_cache* cache, nmd_glyph_page* page, int width, int height, int* x_out, int* y_out)
+{
+    size_t best = (size_t)-1;
+    int best_y = cache->page_size, best_waste = 0;
+
+    for (size_t i = 0; i < page->num_nodes; i++)
+    {
+        const int x = page->skyline[i].x;
+        if (x + width > cache->page_size)
+            break;
+
+        /* The rectangle rests on the highest node under it */
+        int y = 0, covered = 0;
+        size_t j = i;
+        for (; covered < width; j++)
+        {
+            y = NMD_MAX(y, page->skyline[j].y);
+            covered += page->skyline[j].width;
+        }
+
+        if (y + height > cache->page_size)
+            continue;
+
+        /* Prefer the lowest position, then the one that wastes less area under the rectangle */
+        int waste = 0;
+        for (size_t k = i; k < j; k++)
+            waste += (y - page->skyline[k].y) * page->skyline[k].width;
+        if (y < best_y || (y == best_y && waste < best_waste))
+        {
+            best = i;
+            best_y = y;
+            best_waste = waste;
+        }
+    }
+
+    if (best == (size_t)-1)
+        return false;
+
+    /* The new node replaces the nodes under the rectangle, the last one may be partially covered */
+    const int x = page->skyline[best].x;
+    size_t end = best;
+    while (end < page->num_nodes && page->skyline[end].x + page->skyline[end].width <= x + width)
+        end++;
+
+    nmd_skyline_node remainder;
+    const bool has_remainder = end < page->num_nodes && page->skyline[end].x < x + width;
+    if (has_remainder)
+    {
+        remainder.x = x + width;
+        remainder.y = page->skyline[end].y;
+        remainder.width = page->skyline[end].x + page->skyline[end].width - (x + width);
+        end++;
+    }
+
+    const size_t num_new_nodes = has_remainder ? 2 : 1;
+    _nmd_move_skyline_nodes(page, end, best + num_new_nodes);
+
+    page->skyline[best].x = x;
+    page->skyline[best].y = best_y + height;
+    page->skyline[best].width = width;
+    if (has_remainder)
+        page->skyline[best + 1] = remainder;
+
+    /* Merge neighbours at the same height */
+    for (size_t i = (best > 0 ? best - 1 : 0); i + 1 < page->num_nodes && i <= best + 1;)
+    {
+        if (page->skyline[i].y == page->skyline[i + 1].y)
+        {
+            page->skyline[i].width += page->skyline[i + 1].width;
+            _nmd_move_skyline_nodes(page, i + 2, i + 1);
+        }
+        else
+            i++;
+    }
+
+    *x_out = x;
+    *y_out = best_y;
+    return true;
+}
+
+uint32_t _nmd_hash_glyph(uint32_t font_id, float size, uint32_t codepoint)
+{
+    uint32_t size_bits;
+    NMD_MEMCPY(&size_bits, &size, sizeof(size_bits));
+    uint32_t hash = font_id * 0x9E3779B1u ^ size_bits * 0x85EBCA77u ^ codepoint * 0xC2B2AE3Du;
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6Du;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+/* Rasterizes a glyph into a page. 'glyph' has the key fields set. */
+void _nmd_rasterize_glyph(const nmd_font* font, nmd_glyph* glyph)
+{
+    nmd_glyph_cache* const cache = font->cache;
+    const stbtt_fontinfo* const info = (const stbtt_fontinfo*)font->info;
+    const float scale = stbtt_ScaleForPixelHeight(info, glyph->size);
+    const int glyph_index = stbtt_FindGlyphIndex(info, glyph->codepoint);
+
+    int advance, left_side_bearing;
+    stbtt_GetGlyphHMetrics(info, glyph_index, &advance, &left_side_bearing);
+    glyph->advance = advance * scale;
+
+    int x0, y0, x1, y1;
+    stbtt_GetGlyphBitmapBox(info, glyph_index, scale, scale, &x0, &y0, &x1, &y1);
+    const int width = x1 - x0, height = y1 - y0;
+    glyph->texture = 0;
+    if (width <= 0 || height <= 0 || width + _NMD_GLYPH_PADDING > cache->page_size || height + _NMD_GLYPH_PADDING > cache->page_size)
+        return;
+
+    /* The glyph is packed in the last page, a new one is added when it's full */
+    nmd_glyph_page* page = cache->num_pages ? &cache->pages[cache->num_pages - 1] : 0;
+    int x, y;
+    if (!page || !_nmd_skyline_pack(cache, page, width + _NMD_GLYPH_PADDING, height + _NMD_GLYPH_PADDING, &x, &y))
+    {
+        if (!(page = _nmd_add_glyph_page(cache)) || !_nmd_skyline_pack(cache, page, width + _NMD_GLYPH_PADDING, height + _NMD_GLYPH_PADDING, &x, &y))
+            return;
+    }
+
+    /* Rasterize the coverage in temporary memory and store it in the alpha channel */
+    uint8_t* coverage = (uint8_t*)_nmd_frame_alloc(width * height);
+    if (!coverage)
+        return;
+    stbtt_MakeGlyphBitmap(info, coverage, width, height, width, scale, scale, glyph_index);
+    for (int row = 0; row < height; row++)
+    {
+        nmd_color* pixels = page->pixels + (y + row) * cache->page_size + x;
+        for (int column = 0; column < width; column++)
+            pixels[column].a = coverage[row * width + column];
+    }
+    _nmd_frame_release(coverage, width * height);
+
+    page->dirty_x0 = NMD_MIN(page->dirty_x0, x);
+    page->dirty_y0 = NMD_MIN(page->dirty_y0, y);
+    page->dirty_x1 = NMD_MAX(page->dirty_x1, x + width);
+    page->dirty_y1 = NMD_MAX(page->dirty_y1, y + height);
+
+    glyph->texture = page->texture;
+    glyph->x0 = (float)x0, glyph->y0 = (float)y0;
+    glyph->x1 = (float)x1, glyph->y1 = (float)y1;
+    glyph->u0 = x / (float)cache->page_size, glyph->v0 = y / (float)cache->page_size;
+    glyph->u1 = (x + width) / (float)cache->page_size, glyph->v1 = (y + height) / (float)cache->page_size;
+}
+
+/* Returns the glyph of 'codepoint' at 'size' pixels, it's rasterized if it's not in the cache. Returns a null pointer if memory could not be allocated. */
+const nmd_glyph* _nmd_get_glyph(const nmd_font* font, float size, uint32_t codepoint)
+{
+    nmd_glyph_cache* const cache = font->cache;
+
+    /* Keep the load factor under 70% */
+    if ((cache->num_glyphs + 1) * 10 > cache->glyphs_capacity * 7)
+    {
+        const size_t new_capacity = NMD_MAX(cache->glyphs_capacity * 2, 256);
+        nmd_glyph* glyphs = (nmd_glyph*)_nmd_alloc(new_capacity * sizeof(nmd_glyph));
+        if (!glyphs)
+            return 0;
+        NMD_MEMSET(glyphs, 0, new_capacity * sizeof(nmd_glyph));
+
+        for (size_t i = 0; i < cache->glyphs_capacity; i++)
+        {
+            const nmd_glyph* glyph = &cache->glyphs[i];
+            if (!glyph->font_id)
+                continue;
+
+            size_t slot = _nmd_hash_glyph(glyph->font_id, glyph->size, glyph->codepoint) & (new_capacity - 1);
+            while (glyphs[slot].font_id)
+                slot = (slot + 1) & (new_capacity - 1);
+            glyphs[slot] = *glyph;
+        }
+
+        _nmd_free(cache->glyphs);
+        cache->glyphs = glyphs;
+        cache->glyphs_capacity = new_capacity;
+    }
+
+    size_t slot = _nmd_hash_glyph(font->id, size, codepoint) & (cache->glyphs_capacity - 1);
+    for (; cache->glyphs[slot].font_id; slot = (slot + 1) & (cache->glyphs_capacity - 1))
+    {
+        const nmd_glyph* glyph = &cache->glyphs[slot];
+        if (glyph->font_id == font->id && glyph->codepoint == codepoint && glyph->size == size)
+            return glyph;
+    }
+
+    nmd_glyph* glyph = &cache->glyphs[slot];
+    glyph->font_id = font->id;
+    glyph->codepoint = codepoint;
+    glyph->size = size;
+    _nmd_rasterize_glyph(font, glyph);
+    cache->num_glyphs++;
+
+    return glyph;
+}
 
-/*
-void DrawList::AddBezierCurve(const nmd_vec2& p1, const nmd_vec2& p2, const nmd_vec2& p3, const nmd_vec2& p4, Color color, float thickness, size_t num_segments)
+/* Decodes the UTF-8 character at '*text' and advances '*text'. Invalid sequences are decoded as U+FFFD one byte at a time. */
+uint32_t _nmd_decode_utf8(const char** text, const char* text_end)
 {
-    if (!color.a)
-        return;
+    const uint8_t* s = (const uint8_t*)*text;
+    const size_t available = (const uint8_t*)text_end - s;
+    uint32_t codepoint;
+    size_t length;
 
-    PathLineTo(p1);
-    PathBezierCurveTo(p2, p3, p4, num_segments);
-    PathStroke(color, false, thickness);
+    if (s[0] < 0x80)
+        codepoint = s[0], length = 1;
+    else if ((s[0] & 0xe0) == 0xc0)
+        codepoint = s[0] & 0x1f, length = 2;
+    else if ((s[0] & 0xf0) == 0xe0)
+        codepoint = s[0] & 0x0f, length = 3;
+    else if ((s[0] & 0xf8) == 0xf0)
+        codepoint = s[0] & 0x07, length = 4;
+    else
+        length = 0;
+
+    if (!length || length > available)
+    {
+        (*text)++;
+        return 0xfffd;
+    }
+
+    for (size_t i = 1; i < length; i++)
+    {
+        if ((s[i] & 0xc0) != 0x80)
+        {
+            (*text)++;
+            return 0xfffd;
+        }
+        codepoint = (codepoint << 6) | (s[i] & 0x3f);
+    }
+
+    *text += length;
+    return codepoint;
 }
-void nmd_add_text(float x, float y, const char* text, nmd_color color)
+
+uint64_t _nmd_hash_text(const char* text, size_t length)
 {
-    nmd_add_text(_nmd_context.draw_list.defaultFont, x, y, text, color);
+    /* FNV-1a */
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < length; i++)
+        hash = (hash ^ (uint8_t)text[i]) * 0x100000001b3ull;
+    return hash;
 }
-*/
 
-void nmd_add_text(const nmd_atlas* font, float x, float y, const char* text, const char* text_end, nmd_color color)
+/*
+Returns the layout of a string, the string is laid out if it's not in the cache. Returns a null pointer if memory could not be allocated.
+The returned pointer and the quads are valid until the next layout is added.
+*/
+const nmd_text_layout* _nmd_get_text_layout(const nmd_font* font, float size, const char* text, const char* text_end)
 {
-    if (!color.a)
-        return;
+    nmd_glyph_cache* const cache = font->cache;
+    const size_t length = text_end - text;
+    const uint64_t hash = _nmd_hash_text(text, length);
 
-    if (!text_end)
-        text_end = text + NMD_STRLEN(text);
+    if (cache->layouts)
+    {
+        size_t slot = (size_t)(hash ^ font->id) & (cache->layouts_capacity - 1);
+        for (; cache->layouts[slot].font_id; slot = (slot + 1) & (cache->layouts_capacity - 1))
+        {
+            const nmd_text_layout* layout = &cache->layouts[slot];
+            if (layout->hash == hash && layout->length == length && layout->font_id == font->id && layout->size == size && NMD_MEMCMP(cache->text + layout->first_char, text, length) == 0)
+                return layout;
+        }
+    }
 
-    if (!_nmd_reserve((text_end - text) * 4, (text_end - text) * 6))
-        return;
+    /* Every byte needs at most one quad. When the cache is full, the layouts are discarded */
+    if (cache->text_length + length > NMD_TEXT_LAYOUT_CACHE_SIZE)
+        _nmd_clear_layouts(cache);
 
-    nmd_push_draw_command(0);
+    /* Keep the load factor under 70% */
+    if ((cache->num_layouts + 1) * 10 > cache->layouts_capacity * 7)
+    {
+        const size_t new_capacity = NMD_MAX(cache->layouts_capacity * 2, 256);
+        nmd_text_layout* layouts = (nmd_text_layout*)_nmd_alloc(new_capacity * sizeof(nmd_text_layout));
+        if (!layouts)
+            return 0;
+        NMD_MEMSET(layouts, 0, new_capacity * sizeof(nmd_text_layout));
 
-    stbtt_aligned_quad q;
-    for(; text < text_end; text++)
+        for (size_t i = 0; i < cache->layouts_capacity; i++)
+        {
+            const nmd_text_layout* layout = &cache->layouts[i];
+            if (!layout->font_id)
+                continue;
+
+            size_t slot = (size_t)(layout->hash ^ layout->font_id) & (new_capacity - 1);
+            while (layouts[slot].font_id)
+                slot = (slot + 1) & (new_capacity - 1);
+            layouts[slot] = *layout;
+        }
+
+        _nmd_free(cache->layouts);
+        cache->layouts = layouts;
+        cache->layouts_capacity = new_capacity;
+    }
+
+    if (cache->num_quads + length > cache->quads_capacity)
     {
-        stbtt_GetBakedQuad((stbtt_bakedchar*)font->baked_chars, 512, 512, *text - 32, &x, &y, &q, 1);
+        const size_t new_capacity = NMD_MAX(NMD_MAX(cache->quads_capacity * 2, cache->num_quads + length), 1024);
+        void* mem = _nmd_alloc(new_capacity * sizeof(nmd_glyph_quad));
+        if (!mem)
+            return 0;
+        if (cache->quads)
+            NMD_MEMCPY(mem, cache->quads, cache->num_quads * sizeof(nmd_glyph_quad));
+        _nmd_free(cache->quads);
 
-        const size_t offset = _nmd_context.draw_list.num_vertices;
+        cache->quads = (nmd_glyph_quad*)mem;
+        cache->quads_capacity = new_capacity;
+    }
 
-        nmd_index* indices = _nmd_context.draw_list.indices + _nmd_context.draw_list.num_indices;
-        indices[0] = offset + 0; indices[1] = offset + 1; indices[2] = offset + 2;
-        indices[3] = offset + 0; indices[4] = offset + 2; indices[5] = offset + 3;
-        _nmd_context.draw_list.num_indices += 6;
-        
-        nmd_vertex* vertices = _nmd_context.draw_list.vertices + _nmd_context.draw_list.num_vertices;
-        vertices[0].pos.x = q.x0; vertices[0].pos.y = q.y0; vertices[0].uv.x = q.s0; vertices[0].uv.y = q.t0; vertices[0].color = color;
-        vertices[1].pos.x = q.x1; vertices[1].pos.y = q.y0; vertices[1].uv.x = q.s1; vertices[1].uv.y = q.t0; vertices[1].color = color;
-        vertices[2].pos.x = q.x1; vertices[2].pos.y = q.y1; vertices[2].uv.x = q.s1; vertices[2].uv.y = q.t1; vertices[2].color = color;
-        vertices[3].pos.x = q.x0; vertices[3].pos.y = q.y1; vertices[3].uv.x = q.s0; vertices[3].uv.y = q.t1; vertices[3].color = color;
-        _nmd_context.draw_list.num_vertices += 4;
+    if (cache->text_length + length > cache->text_capacity)
+    {
+        const size_t new_capacity = NMD_MAX(NMD_MAX(cache->text_capacity * 2, cache->text_length + length), 4096);
+        void* mem = _nmd_alloc(new_capacity);
+        if (!mem)
+            return 0;
+        if (cache->text)
+            NMD_MEMCPY(mem, cache->text, cache->text_length);
+        _nmd_free(cache->text);
+
+        cache->text = (char*)mem;
+        cache->text_capacity = new_capacity;
     }
 
-    nmd_push_texture_draw_command(font->font_id, 0);
-}
+    /* Keep the bytes, a hit must match the string and not only its hash */
+    const size_t first_char = cache->text_length;
+    if (length)
+        NMD_MEMCPY(cache->text + first_char, text, length);
+    cache->text_length += length;
+
+    /* Lay out the string at the origin. The quads are snapped to pixels like stbtt_GetBakedQuad() does */
+    const stbtt_fontinfo* const info = (const stbtt_fontinfo*)font->info;
+    const float scale = stbtt_ScaleForPixelHeight(info, size);
+    const size_t first_quad = cache->num_quads;
+    float pen_x = 0.0f;
+    while (text < text_end)
+    {
+        const nmd_glyph* glyph = _nmd_get_glyph(font, size, _nmd_decode_utf8(&text, text_end));
+        if (!glyph)
+            return 0;
 
-void nmd_get_text_size(const nmd_atlas* font, const char* text, const char* text_end, nmd_vec2* size_out)
-{
-    if (!text_end)
-        text_end = text + NMD_STRLEN(text);
-    
-    stbtt_aligned_quad q;
-    float x = 0, y = 0;
-    for (; text < text_end; text++)
-        stbtt_GetBakedQuad((stbtt_bakedchar*)font->baked_chars, 512, 512, *text - 32, &x, &y, &q, 1);
+        if (glyph->texture)
+        {
+            nmd_glyph_quad* quad = &cache->quads[cache->num_quads++];
+            const float x = (float)(int)(pen_x + glyph->x0 + 0.5f);
+            quad->x0 = x;
+            quad->y0 = glyph->y0;
+            quad->x1 = x + glyph->x1 - glyph->x0;
+            quad->y1 = glyph->y1;
+            quad->u0 = glyph->u0, quad->v0 = glyph->v0;
+            quad->u1 = glyph->u1, quad->v1 = glyph->v1;
+            quad->texture = glyph->texture;
+        }
 
-    size_out->x = q.x1;
-    size_out->y = q.y1 - q.y0;
-}
+        pen_x += glyph->advance;
+    }
 
-void nmd_add_image(nmd_tex_id user_texture_id, float x0, float y0, float x1, float y1, nmd_color color)
-{
-    nmd_add_image_uv(user_texture_id, x0, y0, x1, y1, 0.0f, 0.0f, 1.0f, 1.0f, color);
+    size_t slot = (size_t)(hash ^ font->id) & (cache->layouts_capacity - 1);
+    while (cache->layouts[slot].font_id)
+        slot = (slot + 1) & (cache->layouts_capacity - 1);
+
+    nmd_text_layout* layout = &cache->layouts[slot];
+    layout->hash = hash;
+    layout->length = length;
+    layout->first_char = first_char;
+    layout->font_id = font->id;
+    layout->size = size;
+    layout->first_quad = first_quad;
+    layout->num_quads = cache->num_quads - first_quad;
+    layout->text_size.x = pen_x;
+    layout->text_size.y = (font->ascent - font->descent) * scale;
+    cache->num_layouts++;
+
+    return layout;
 }
 
-void nmd_add_image_uv(nmd_tex_id user_texture_id, float x0, float y0, float x1, float y1, float uv_x0, float uv_y0, float uv_x1, float uv_y1, nmd_color color)
+bool nmd_font_init(nmd_font* font, nmd_glyph_cache* cache, const void* font_data)
 {
-    if (!color.a)
-        return;
+    NMD_MEMSET(font, 0, sizeof(nmd_font));
 
-    nmd_push_draw_command(0);
+    stbtt_fontinfo* info = (stbtt_fontinfo*)_nmd_alloc(sizeof(stbtt_fontinfo));
+    if (!info)
+        return false;
 
-    nmd_prim_rect_uv(x0, y0, x1, y1, uv_x0, uv_y0, uv_x1, uv_y1, color);
-    
-    nmd_push_texture_draw_command(user_texture_id, 0);
+    if (!stbtt_InitFont(info, (const unsigned char*)font_data, stbtt_GetFontOffsetForIndex((const unsigned char*)font_data, 0)))
+    {
+        _nmd_free(info);
+        return false;
+    }
+
+    int line_gap;
+    stbtt_GetFontVMetrics(info, &font->ascent, &font->descent, &line_gap);
+
+    font->cache = cache;
+    font->data = font_data;
+    font->info = info;
+    font->id = cache->next_font_id++;
+
+    return true;
 }
 
-void nmd_add_image_quad(nmd_tex_id user_texture_id, float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3, nmd_color color)
+void nmd_font_destroy(nmd_font* font)
 {
-    nmd_add_image_quad_uv(user_texture_id, x0, y0, x1, y1, x2, y2, x3, y3, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f, color);
+    _nmd_free(font->info);
+    NMD_MEMSET(font, 0, sizeof(nmd_font));
 }
 
-void nmd_add_image_quad_uv(nmd_tex_id user_texture_id, float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3, float uv_x0, float uv_y0, float uv_x1, float uv_y1, float uv_x2, float uv_y2, float uv_x3, float uv_y3, nmd_color color)
+void nmd_add_text_cached(const nmd_font* font, float size, float x, float y, const char* text, const char* text_end, nmd_color color)
 {
     if (!color.a)
         return;
 
+    if (!text_end)
+        text_end = text + NMD_STRLEN(text);
+
+    const nmd_text_layout* layout = _nmd_get_text_layout(font, size, text, text_end);
+    if (!layout || !layout->num_quads || !_nmd_reserve(layout->num_quads * 4, layout->num_quads * 6))
+        return;
+
     nmd_push_draw_command(0);
 
-    nmd_prim_quad_uv(x0, y0, x1, y1, x2, y2, x3, y3, uv_x0, uv_y0, uv_x1, uv_y1, uv_x2, uv_y2, uv_x3, uv_y3, color);
+    /* The quads were snapped to pixels at the origin, so the position is snapped too */
+    x = (float)(int)(x + 0.5f);
+    y = (float)(int)(y + 0.5f);
 
-    nmd_push_texture_draw_command(user_texture_id, 0);
-}
+    const nmd_glyph_quad* quad = font->cache->quads + layout->first_quad;
+    const nmd_glyph_quad* const quads_end = quad + layout->num_quads;
+    nmd_tex_id texture = quad->texture;
+    for (; quad < quads_end; quad++)
+    {
+        /* The glyphs of a string may be in different pages */
+        if (quad->texture != texture)
+        {
+            nmd_push_texture_draw_command(texture, 0);
+            texture = quad->texture;
+        }
 
-void nmd_add_image_rounded(nmd_tex_id user_texture_id, float x0, float y0, float x1, float y1, float rounding, uint32_t corner_flags, nmd_color color)
-{
-    nmd_add_image_rounded_uv(user_texture_id, x0, y0, x1, y1, rounding, corner_flags, 0.0f, 0.0f, 1.0f, 1.0f, color);
+        const size_t offset = _nmd_context->draw_list.num_vertices - _nmd_context->draw_list.vertex_offset;
+
+        nmd_index* indices = _nmd_context->draw_list.indices + _nmd_context->draw_list.num_indices;
+        indices[0] = offset + 0; indices[1] = offset + 1; indices[2] = offset + 2;
+        indices[3] = offset + 0; indices[4] = offset + 2; indices[5] = offset + 3;
+        _nmd_context->draw_list.num_indices += 6;
+
+        nmd_vertex* vertices = _nmd_context->draw_list.vertices + _nmd_context->draw_list.num_vertices;
+        vertices[0].pos.x = x + quad->x0; vertices[0].pos.y = y + quad->y0; vertices[0].uv.x = quad->u0; vertices[0].uv.y = quad->v0; vertices[0].color = color;
+        vertices[1].pos.x = x + quad->x1; vertices[1].pos.y = y + quad->y0; vertices[1].uv.x = quad->u1; vertices[1].uv.y = quad->v0; vertices[1].color = color;
+        vertices[2].pos.x = x + quad->x1; vertices[2].pos.y = y + quad->y1; vertices[2].uv.x = quad->u1; vertices[2].uv.y = quad->v1; vertices[2].color = color;
+        vertices[3].pos.x = x + quad->x0; vertices[3].pos.y = y + quad->y1; vertices[3].uv.x = quad->u0; vertices[3].uv.y = quad->v1; vertices[3].color = color;
+        _nmd_context->draw_list.num_vertices += 4;
+    }
+
+    nmd_push_texture_draw_command(texture, 0);
 }
 
-void nmd_add_image_rounded_uv(nmd_tex_id user_texture_id, float x0, float y0, float x1, float y1, float rounding, uint32_t corner_flags, float uv_x0, float uv_y0, float uv_x1, float uv_y1, nmd_color color)
+void nmd_get_text_size_cached(const nmd_font* font, float size, const char* text, const char* text_end, nmd_vec2* size_out)
 {
-    if (!color.a)
-        return;
+    if (!text_end)
+        text_end = text + NMD_STRLEN(text);
 
-    if (rounding <= 0.0f || !corner_flags)
-        nmd_add_image_uv(user_texture_id, x0, y0, x1, y1, uv_x0, uv_y0, uv_x1, uv_y1, color);
+    const nmd_text_layout* layout = _nmd_get_text_layout(font, size, text, text_end);
+    if (layout)
+        *size_out = layout->text_size;
     else
-    {
-        nmd_push_draw_command(0);
-
-        const int vert_start_idx = _nmd_context.draw_list.num_vertices;
-        nmd_path_rect(x0, y0, x1, y1, rounding, corner_flags);
-        nmd_path_fill_convex(color);
-        const int vert_end_idx = _nmd_context.draw_list.num_vertices;
-
-        _nmd_shade_verts_linear_uv(vert_start_idx, vert_end_idx, x0, y0, x1, y1, uv_x0, uv_y0, uv_x1, uv_y1, true);
-
-        nmd_push_texture_draw_command(user_texture_id, 0);
-    }
+        size_out->x = size_out->y = 0.0f;
 }
 
 
 #ifdef _WIN32
 LRESULT nmd_win32_wnd_proc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 {
-    if (!_nmd_context.hWnd && uMsg == WM_MOUSEMOVE)
+    if (!_nmd_context->hWnd && uMsg == WM_MOUSEMOVE)
     {
-        _nmd_context.io.mouse_pos.x = ((int)(short)LOWORD(lParam));
-        _nmd_context.io.mouse_pos.y = ((int)(short)HIWORD(lParam));
+        _nmd_context->io.mouse_pos.x = ((int)(short)LOWORD(lParam));
+        _nmd_context->io.mouse_pos.y = ((int)(short)HIWORD(lParam));
     }
 
 	/* Handle raw input */
@@ -7038,21 +8829,21 @@ LRESULT nmd_win32_wnd_proc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
                 {
                     if (ri.data.mouse.usFlags == MOUSE_MOVE_RELATIVE)
                     {
-                        _nmd_context.io.mouse_pos.x += (float)ri.data.mouse.lLastX;
-                        _nmd_context.io.mouse_pos.y += (float)ri.data.mouse.lLastY;
+                        _nmd_context->io.mouse_pos.x += (float)ri.data.mouse.lLastX;
+                        _nmd_context->io.mouse_pos.y += (float)ri.data.mouse.lLastY;
 
                         if (ri.data.mouse.usButtonFlags & RI_MOUSE_LEFT_BUTTON_DOWN)
-                            _nmd_context.io.mouse_down[0] = true, _nmd_context.io.mouse_clicked_pos[0] = _nmd_context.io.mouse_pos;
+                            _nmd_context->io.mouse_down[0] = true, _nmd_context->io.mouse_clicked_pos[0] = _nmd_context->io.mouse_pos;
                         else if (ri.data.mouse.usButtonFlags & RI_MOUSE_LEFT_BUTTON_UP)
-                            _nmd_context.io.mouse_down[0] = false, _nmd_context.io.mouse_released[0] = true;
+                            _nmd_context->io.mouse_down[0] = false, _nmd_context->io.mouse_released[0] = true;
                         if (ri.data.mouse.usButtonFlags & RI_MOUSE_RIGHT_BUTTON_DOWN)
-                            _nmd_context.io.mouse_down[1] = true, _nmd_context.io.mouse_clicked_pos[1] = _nmd_context.io.mouse_pos;
+                            _nmd_context->io.mouse_down[1] = true, _nmd_context->io.mouse_clicked_pos[1] = _nmd_context->io.mouse_pos;
                         else if (ri.data.mouse.usButtonFlags & RI_MOUSE_RIGHT_BUTTON_UP)
-                            _nmd_context.io.mouse_down[1] = false, _nmd_context.io.mouse_released[1] = true;
+                            _nmd_context->io.mouse_down[1] = false, _nmd_context->io.mouse_released[1] = true;
                         if (ri.data.mouse.usButtonFlags & RI_MOUSE_MIDDLE_BUTTON_DOWN)
-                            _nmd_context.io.mouse_down[2] = true, _nmd_context.io.mouse_clicked_pos[2] = _nmd_context.io.mouse_pos;
+                            _nmd_context->io.mouse_down[2] = true, _nmd_context->io.mouse_clicked_pos[2] = _nmd_context->io.mouse_pos;
                         else if (ri.data.mouse.usButtonFlags & RI_MOUSE_MIDDLE_BUTTON_UP)
-                            _nmd_context.io.mouse_down[2] = false, _nmd_context.io.mouse_released[2] = true;
+                            _nmd_context->io.mouse_down[2] = false, _nmd_context->io.mouse_released[2] = true;
                     }
                 }
             }
@@ -7065,105 +8856,231 @@ LRESULT nmd_win32_wnd_proc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
     case WM_KEYDOWN:
     case WM_SYSKEYDOWN:
         if(wParam < 256)
-            _nmd_context.io.keys_down[wParam] = true;
+            _nmd_context->io.keys_down[wParam] = true;
         return 0;
     case WM_KEYUP:
     case WM_SYSKEYUP:
         if (wParam < 256)
-            _nmd_context.io.keys_down[wParam] = false;
+            _nmd_context->io.keys_down[wParam] = false;
         return 0;
 
     /* Handle mouse buttons */
-    case WM_LBUTTONDOWN: _nmd_context.io.mouse_down[0] = true; _nmd_context.io.mouse_clicked_pos[0] = _nmd_context.io.mouse_pos; return 0;
-    case WM_LBUTTONUP: _nmd_context.io.mouse_down[0] = false; _nmd_context.io.mouse_released[0] = true; return 0;
+    case WM_LBUTTONDOWN: _nmd_context->io.mouse_down[0] = true; _nmd_context->io.mouse_clicked_pos[0] = _nmd_context->io.mouse_pos; return 0;
+    case WM_LBUTTONUP: _nmd_context->io.mouse_down[0] = false; _nmd_context->io.mouse_released[0] = true; return 0;
 
-    case WM_RBUTTONDOWN: _nmd_context.io.mouse_down[1] = true; _nmd_context.io.mouse_clicked_pos[1] = _nmd_context.io.mouse_pos; return 0;
-    case WM_RBUTTONUP: _nmd_context.io.mouse_down[1] = false; _nmd_context.io.mouse_released[1] = true; return 0;
+    case WM_RBUTTONDOWN: _nmd_context->io.mouse_down[1] = true; _nmd_context->io.mouse_clicked_pos[1] = _nmd_context->io.mouse_pos; return 0;
+    case WM_RBUTTONUP: _nmd_context->io.mouse_down[1] = false; _nmd_context->io.mouse_released[1] = true; return 0;
 
-    case WM_MBUTTONDOWN: _nmd_context.io.mouse_down[2] = true; _nmd_context.io.mouse_clicked_pos[2] = _nmd_context.io.mouse_pos; return 0;
-    case WM_MBUTTONUP: _nmd_context.io.mouse_down[2] = false;  _nmd_context.io.mouse_released[2] = true; return 0;
+    case WM_MBUTTONDOWN: _nmd_context->io.mouse_down[2] = true; _nmd_context->io.mouse_clicked_pos[2] = _nmd_context->io.mouse_pos; return 0;
+    case WM_MBUTTONUP: _nmd_context->io.mouse_down[2] = false;  _nmd_context->io.mouse_released[2] = true; return 0;
 
-    case WM_XBUTTONDOWN: _nmd_context.io.mouse_down[GET_XBUTTON_WPARAM(wParam) == XBUTTON1 ? 3 : 4] = true; return 0;
-    case WM_XBUTTONUP: _nmd_context.io.mouse_down[GET_XBUTTON_WPARAM(wParam) == XBUTTON1 ? 3 : 4] = false; return 0;
+    case WM_XBUTTONDOWN: _nmd_context->io.mouse_down[GET_XBUTTON_WPARAM(wParam) == XBUTTON1 ? 3 : 4] = true; return 0;
+    case WM_XBUTTONUP: _nmd_context->io.mouse_down[GET_XBUTTON_WPARAM(wParam) == XBUTTON1 ? 3 : 4] = false; return 0;
     }
 
     return 0;
 }
 #endif /* _WIN32 */
 
-/* This is a very simple hash function which takes a string and returns a 32-bit number which should be unique for the string */
-uint32_t _nmd_hash_string_to_uint32(const char* string)
+/* Hashes 'size' bytes with FNV-1a starting from 'seed', then mixes the bits so the low bits used by the hash maps are well distributed. Never returns zero. */
+uint32_t _nmd_hash_data(const void* data, size_t size, uint32_t seed)
 {
-    if (!*string)
-        return 0;
+    uint32_t hash = 0x811C9DC5 ^ seed;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ ((const uint8_t*)data)[i]) * 0x01000193;
 
-    /* Starting hash */
-    uint32_t hash = 0xDEADC0DE + *string;
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6B;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35;
+    hash ^= hash >> 16;
 
-    /* This 2-byte pointer is used to constantly shift between different parts of 'hash' */
-    uint16_t* p;
+    /* Zero marks empty entries in hash maps */
+    return hash ? hash : 1;
+}
 
-    for (size_t i = 1; string[i]; i++)
-    {
-        /*
-        If 'i' modulo 3 is 0, then point to the first and second bytes of 'hash'
-        If 'i' modulo 3 is 1, then point to the second and third bytes of 'hash'
-        If 'i' modulo 3 is 2, then point to the third and fourth bytes of 'hash'
-        */
-        p = (uint16_t*)((uint8_t*)&hash+(i%3));
+uint32_t _nmd_hash_string(const char* string, uint32_t seed)
+{
+    return _nmd_hash_data(string, NMD_STRLEN(string), seed);
+}
+
+/* Returns the entry of 'key' in 'map' or a null pointer if there's none */
+nmd_id_map_entry* _nmd_id_map_find(const nmd_id_map* map, uint32_t key)
+{
+    if (!map->entries)
+        return 0;
 
-        /* Do some random XOR between the two bytes pointed by 'p' and string[i] and string[i -1] */
-        *p = *p ^ ((string[i - 1] << 8) | string[i]);
+    for (size_t i = key & (map->capacity - 1); map->entries[i].key; i = (i + 1) & (map->capacity - 1))
+    {
+        if (map->entries[i].key == key)
+            return map->entries + i;
     }
 
-    return hash;
+    return 0;
 }
 
-/* Iterates through all windows in the global context and return the window that has the ID equal to 'window_hash' */
-nmd_window* _nmd_find_window_by_hash(uint32_t window_hash)
+/* Returns the entry of 'key' in 'map', it's added with a zeroed value if there's none. Returns a null pointer if memory could not be allocated. */
+nmd_id_map_entry* _nmd_id_map_insert(nmd_id_map* map, uint32_t key)
 {
-    for (size_t i = 0; i < _nmd_context.gui.num_windows; i++)
+    nmd_id_map_entry* entry = _nmd_id_map_find(map, key);
+    if (entry)
+        return entry;
+
+    /* Keep the load factor under 70% */
+    if ((map->num_entries + 1) * 10 > map->capacity * 7)
     {
-        if (_nmd_context.gui.windows[i].id == window_hash)
-            return _nmd_context.gui.windows + i;
+        const size_t new_capacity = NMD_MAX(map->capacity * 2, NMD_ID_MAP_INITIAL_SIZE);
+        nmd_id_map_entry* entries = (nmd_id_map_entry*)_nmd_alloc(new_capacity * sizeof(nmd_id_map_entry));
+        if (!entries)
+            return 0;
+        NMD_MEMSET(entries, 0, new_capacity * sizeof(nmd_id_map_entry));
+
+        for (size_t i = 0; i < map->capacity; i++)
+        {
+            if (!map->entries[i].key)
+                continue;
+
+            size_t j = map->entries[i].key & (new_capacity - 1);
+            while (entries[j].key)
+                j = (j + 1) & (new_capacity - 1);
+            entries[j] = map->entries[i];
+        }
+
+        _nmd_free(map->entries);
+        map->entries = entries;
+        map->capacity = new_capacity;
     }
 
-    return 0;
+    size_t i = key & (map->capacity - 1);
+    while (map->entries[i].key)
+        i = (i + 1) & (map->capacity - 1);
+
+    entry = map->entries + i;
+    entry->key = key;
+    map->num_entries++;
+
+    return entry;
+}
+
+/* Frees the entries of 'map' */
+void _nmd_id_map_free(nmd_id_map* map)
+{
+    _nmd_free(map->entries);
+    map->entries = 0;
+    map->num_entries = 0;
+    map->capacity = 0;
+}
+
+/* Returns the window that has the ID equal to 'window_hash' or a null pointer if there's none */
+nmd_window* _nmd_find_window_by_hash(uint32_t window_hash)
+{
+    const nmd_id_map_entry* entry = _nmd_id_map_find(&_nmd_context->gui.window_map, window_hash);
+    return entry ? _nmd_context->gui.windows + entry->value.index : 0;
 }
 
 /* Helper function. Wrapper around '_nmd_find_window_by_hash' but it takes a string */
 nmd_window* _nmd_find_window_by_name(const char* window_name)
 {
-    return _nmd_find_window_by_hash(_nmd_hash_string_to_uint32(window_name));
+    return _nmd_find_window_by_hash(_nmd_hash_string(window_name, 0));
+}
+
+/* Returns the ID at the top of the ID stack, or zero if the stack is empty */
+uint32_t _nmd_get_id_seed()
+{
+    const size_t size = _nmd_context->gui.id_stack_size;
+    return size ? _nmd_context->gui.id_stack[NMD_MIN(size, NMD_ID_STACK_SIZE) - 1] : 0;
+}
+
+void _nmd_push_id(uint32_t id)
+{
+    if (_nmd_context->gui.id_stack_size < NMD_ID_STACK_SIZE)
+        _nmd_context->gui.id_stack[_nmd_context->gui.id_stack_size] = id;
+    _nmd_context->gui.id_stack_size++;
+}
+
+uint32_t nmd_get_id(const char* str)
+{
+    return _nmd_hash_string(str, _nmd_get_id_seed());
+}
+
+void nmd_push_id(const char* str)
+{
+    _nmd_push_id(nmd_get_id(str));
+}
+
+void nmd_push_id_int(int id)
+{
+    _nmd_push_id(_nmd_hash_data(&id, sizeof(id), _nmd_get_id_seed()));
+}
+
+void nmd_pop_id()
+{
+    if (_nmd_context->gui.id_stack_size)
+        _nmd_context->gui.id_stack_size--;
+}
+
+int nmd_get_state_int(uint32_t id, int default_value)
+{
+    const nmd_id_map_entry* entry = _nmd_id_map_find(&_nmd_context->gui.state_map, id);
+    return entry ? entry->value.i : default_value;
+}
+
+void nmd_set_state_int(uint32_t id, int value)
+{
+    nmd_id_map_entry* entry = _nmd_id_map_insert(&_nmd_context->gui.state_map, id);
+    if (entry)
+        entry->value.i = value;
+}
+
+float nmd_get_state_float(uint32_t id, float default_value)
+{
+    const nmd_id_map_entry* entry = _nmd_id_map_find(&_nmd_context->gui.state_map, id);
+    return entry ? entry->value.f : default_value;
+}
+
+void nmd_set_state_float(uint32_t id, float value)
+{
+    nmd_id_map_entry* entry = _nmd_id_map_insert(&_nmd_context->gui.state_map, id);
+    if (entry)
+        entry->value.f = value;
 }
 
 /* Specifies the beginning of the window. Widgets can be added after calling this function. Returns true if the window is not minimized */
 bool nmd_begin(const char* window_name)
 {
-    nmd_window* window = _nmd_find_window_by_name(window_name);
+    const uint32_t window_id = _nmd_hash_string(window_name, 0);
+    nmd_window* window = _nmd_find_window_by_hash(window_id);
     if (!window)
     {
         /* Add window */
 
         /* Check if we need to resize the buffer */
-        if (_nmd_context.gui.num_windows == _nmd_context.gui.windows_capacity)
+        if (_nmd_context->gui.num_windows == _nmd_context->gui.windows_capacity)
         {
-            _nmd_context.gui.windows_capacity *= 2;
-            void* mem = NMD_MALLOC(_nmd_context.gui.windows_capacity);
+            const size_t new_capacity = NMD_MAX(_nmd_context->gui.windows_capacity * 2, NMD_WINDOWS_BUFFER_INITIAL_SIZE);
+            void* mem = _nmd_alloc(new_capacity * sizeof(nmd_window));
             if (!mem)
                 return false;
-            NMD_MEMCPY(mem, _nmd_context.gui.windows, _nmd_context.gui.num_windows);
-            NMD_FREE(_nmd_context.gui.windows);
+            NMD_MEMCPY(mem, _nmd_context->gui.windows, _nmd_context->gui.num_windows * sizeof(nmd_window));
+            _nmd_free(_nmd_context->gui.windows);
+
+            _nmd_context->gui.windows = (nmd_window*)mem;
+            _nmd_context->gui.windows_capacity = new_capacity;
         }
 
-        window = &_nmd_context.gui.windows[_nmd_context.gui.num_windows++];
-        window->id = _nmd_hash_string_to_uint32(window_name);
-        window->rect.p0 = _nmd_context.gui.window_pos;
+        nmd_id_map_entry* entry = _nmd_id_map_insert(&_nmd_context->gui.window_map, window_id);
+        if (!entry)
+            return false;
+        entry->value.index = _nmd_context->gui.num_windows;
+
+        window = &_nmd_context->gui.windows[_nmd_context->gui.num_windows++];
+        window->id = window_id;
+        window->rect.p0 = _nmd_context->gui.window_pos;
         window->rect.p1.x = window->rect.p0.x + 250;
         window->rect.p1.y = window->rect.p0.y + 230;
         window->visible = true;
         window->collapsed = false;
-        window->allow_close = _nmd_context.gui.num_windows == 0 ? false : true;
+        window->allow_close = _nmd_context->gui.num_windows == 0 ? false : true;
         window->allow_collapse = true;
         window->allow_move_title_bar = true;
         window->allow_move_body = true;
@@ -7171,21 +9088,25 @@ bool nmd_begin(const char* window_name)
         window->moving = false;
     }
 
-    _nmd_context.gui.window = window;
+    _nmd_context->gui.window = window;
+
+    /* The window's ID is the seed of the IDs of its widgets */
+    _nmd_context->gui.id_stack_size = 0;
+    _nmd_push_id(window_id);
 
     if (!window->visible)
         return false;
 
     if (window->moving)
     {
-        if (_nmd_context.io.mouse_down[0])
+        if (_nmd_context->io.mouse_down[0])
         {
             /* Move window */
             const int width = window->rect.p1.x - window->rect.p0.x;
             const int height = window->rect.p1.y - window->rect.p0.y;
 
-            window->rect.p0.x = _nmd_context.io.mouse_pos.x - _nmd_context.io.window_move_delta.x;
-            window->rect.p0.y = _nmd_context.io.mouse_pos.y - _nmd_context.io.window_move_delta.y;
+            window->rect.p0.x = _nmd_context->io.mouse_pos.x - _nmd_context->io.window_move_delta.x;
+            window->rect.p0.y = _nmd_context->io.mouse_pos.y - _nmd_context->io.window_move_delta.y;
             window->rect.p1.x = window->rect.p0.x + width;
             window->rect.p1.y = window->rect.p0.y + height;
         }
@@ -7197,43 +9118,43 @@ bool nmd_begin(const char* window_name)
     nmd_add_rect_filled(window->rect.p0.x, window->rect.p0.y, window->rect.p1.x, window->rect.p0.y + 18.0f, NMD_COLOR_GUI_MAIN, 5.0f, window->collapsed ? NMD_CORNER_ALL : NMD_CORNER_TOP);
     
     /* Add window name */
-    nmd_add_text(&_nmd_context.draw_list.default_atlas, window->rect.p0.x + (window->allow_collapse ? 20 : 0), window->rect.p0.y + 13, window_name, 0, NMD_COLOR_WHITE);
+    nmd_add_text(&_nmd_context->draw_list.default_atlas, window->rect.p0.x + (window->allow_collapse ? 20 : 0), window->rect.p0.y + 13, window_name, 0, NMD_COLOR_WHITE);
 
     /* Check if window can be collapsed and if the mouse is over the collapse/expand triangle */
-    if (window->allow_collapse && _nmd_context.io.mouse_pos.x >= window->rect.p0.x + 1 && _nmd_context.io.mouse_pos.x < window->rect.p0.x + 17 && _nmd_context.io.mouse_pos.y >= window->rect.p0.y + 1 && _nmd_context.io.mouse_pos.y < window->rect.p0.y + 17)
+    if (window->allow_collapse && _nmd_context->io.mouse_pos.x >= window->rect.p0.x + 1 && _nmd_context->io.mouse_pos.x < window->rect.p0.x + 17 && _nmd_context->io.mouse_pos.y >= window->rect.p0.y + 1 && _nmd_context->io.mouse_pos.y < window->rect.p0.y + 17)
     {
         /* Check if we properly clicked the triangle */
-        if (_nmd_context.io.mouse_released[0])
+        if (_nmd_context->io.mouse_released[0])
         {
-            if (_nmd_context.io.mouse_clicked_pos[0].x >= window->rect.p0.x + 1 && _nmd_context.io.mouse_clicked_pos[0].x < window->rect.p0.x + 17 && _nmd_context.io.mouse_clicked_pos[0].y >= window->rect.p0.y + 1 && _nmd_context.io.mouse_clicked_pos[0].y < window->rect.p0.y + 17)
+            if (_nmd_context->io.mouse_clicked_pos[0].x >= window->rect.p0.x + 1 && _nmd_context->io.mouse_clicked_pos[0].x < window->rect.p0.x + 17 && _nmd_context->io.mouse_clicked_pos[0].y >= window->rect.p0.y + 1 && _nmd_context->io.mouse_clicked_pos[0].y < window->rect.p0.y + 17)
                 window->collapsed = !window->collapsed;
         }
         
         /* Add filled circle behind triangle */
-        nmd_add_circle_filled(window->rect.p0.x + 9.0f, window->rect.p0.y + 9.0f, 7.5f, _nmd_context.io.mouse_down[0] ? NMD_COLOR_GUI_PRESSED : NMD_COLOR_GUI_HOVER, 12);
+        nmd_add_circle_filled(window->rect.p0.x + 9.0f, window->rect.p0.y + 9.0f, 7.5f, _nmd_context->io.mouse_down[0] ? NMD_COLOR_GUI_PRESSED : NMD_COLOR_GUI_HOVER, 12);
     } 
     /* Check if the window can be closed and if the mouse is over the close button */
-    else if (window->allow_close && _nmd_context.io.mouse_pos.x >= window->rect.p1.x - 17 && _nmd_context.io.mouse_pos.x < window->rect.p1.x - 1 && _nmd_context.io.mouse_pos.y >= window->rect.p0.y + 1 && _nmd_context.io.mouse_pos.y < window->rect.p0.y + 17)
+    else if (window->allow_close && _nmd_context->io.mouse_pos.x >= window->rect.p1.x - 17 && _nmd_context->io.mouse_pos.x < window->rect.p1.x - 1 && _nmd_context->io.mouse_pos.y >= window->rect.p0.y + 1 && _nmd_context->io.mouse_pos.y < window->rect.p0.y + 17)
     {
         /* Check if we properly clicked the close button */
-        if (_nmd_context.io.mouse_released[0])
+        if (_nmd_context->io.mouse_released[0])
         {
-            if (_nmd_context.io.mouse_clicked_pos[0].x >= window->rect.p1.x - 10 && _nmd_context.io.mouse_clicked_pos[0].x < window->rect.p1.x - 1 && _nmd_context.io.mouse_clicked_pos[0].y >= window->rect.p0.y + 1 && _nmd_context.io.mouse_clicked_pos[0].y < window->rect.p0.y + 17)
+            if (_nmd_context->io.mouse_clicked_pos[0].x >= window->rect.p1.x - 10 && _nmd_context->io.mouse_clicked_pos[0].x < window->rect.p1.x - 1 && _nmd_context->io.mouse_clicked_pos[0].y >= window->rect.p0.y + 1 && _nmd_context->io.mouse_clicked_pos[0].y < window->rect.p0.y + 17)
                 window->visible = false;
         }
 
         /* Add filled circle behind triangle */
-        nmd_add_circle_filled(window->rect.p1.x - 9.5f, window->rect.p0.y + 9.0f, 7.5f, _nmd_context.io.mouse_down[0] ? NMD_COLOR_GUI_PRESSED : NMD_COLOR_GUI_HOVER, 12);
+        nmd_add_circle_filled(window->rect.p1.x - 9.5f, window->rect.p0.y + 9.0f, 7.5f, _nmd_context->io.mouse_down[0] ? NMD_COLOR_GUI_PRESSED : NMD_COLOR_GUI_HOVER, 12);
     }
     /* Check if the window's title bar can be dragged and if the mouse is over the title bar */
-    else if (window->allow_move_title_bar && _nmd_context.io.mouse_pos.x >= window->rect.p0.x && _nmd_context.io.mouse_pos.x < window->rect.p1.x && _nmd_context.io.mouse_pos.y >= window->rect.p0.y && _nmd_context.io.mouse_pos.y < window->rect.p0.y + 18.0f && !window->moving)
+    else if (window->allow_move_title_bar && _nmd_context->io.mouse_pos.x >= window->rect.p0.x && _nmd_context->io.mouse_pos.x < window->rect.p1.x && _nmd_context->io.mouse_pos.y >= window->rect.p0.y && _nmd_context->io.mouse_pos.y < window->rect.p0.y + 18.0f && !window->moving)
     {
         /* Determine if the window is being moved */
-        window->moving = _nmd_context.io.mouse_down[0];
+        window->moving = _nmd_context->io.mouse_down[0];
         if (window->moving)
         {
-            _nmd_context.io.window_move_delta.x = _nmd_context.io.mouse_pos.x - window->rect.p0.x;
-            _nmd_context.io.window_move_delta.y = _nmd_context.io.mouse_pos.y - window->rect.p0.y;
+            _nmd_context->io.window_move_delta.x = _nmd_context->io.mouse_pos.x - window->rect.p0.x;
+            _nmd_context->io.window_move_delta.y = _nmd_context->io.mouse_pos.y - window->rect.p0.y;
         }
     }
     
@@ -7271,22 +9192,23 @@ bool nmd_begin(const char* window_name)
 /* Specifies the end of the window. Widgets won't be added after calling this function */
 void nmd_end()
 {
-    _nmd_context.gui.window = 0;
+    _nmd_context->gui.window = 0;
+    _nmd_context->gui.id_stack_size = 0;
 }
 
 void nmd_text(const char* fmt, ...)
 {
     /* Make sure we can draw this widget */
-    nmd_window* window = _nmd_context.gui.window;
+    nmd_window* window = _nmd_context->gui.window;
     if (!window->visible || window->collapsed)
         return;
 
     va_list args;
     va_start(args, fmt);
-    const int size = NMD_VSPRINTF(_nmd_context.gui.fmt_buffer, fmt, args);
+    const int size = NMD_VSPRINTF(_nmd_context->gui.fmt_buffer, fmt, args);
     va_end(args);
 
-    nmd_add_text(&_nmd_context.draw_list.default_atlas, window->rect.p0.x + 6, window->y_offset + 10, _nmd_context.gui.fmt_buffer, _nmd_context.gui.fmt_buffer + size, NMD_COLOR_WHITE);
+    nmd_add_text(&_nmd_context->draw_list.default_atlas, window->rect.p0.x + 6, window->y_offset + 10, _nmd_context->gui.fmt_buffer, _nmd_context->gui.fmt_buffer + size, NMD_COLOR_WHITE);
 
     window->y_offset += 10 + 5;
 }
@@ -7294,21 +9216,21 @@ void nmd_text(const char* fmt, ...)
 bool nmd_button(const char* label)
 {
     /* Make sure we can draw this widget */
-    nmd_window* window = _nmd_context.gui.window;
+    nmd_window* window = _nmd_context->gui.window;
     if (!window->visible || window->collapsed)
         return false;
 
     nmd_vec2 size;
-    nmd_get_text_size(&_nmd_context.draw_list.default_atlas, label, 0, &size);
+    nmd_get_text_size(&_nmd_context->draw_list.default_atlas, label, 0, &size);
 
-    const bool is_mouse_hovering = _nmd_context.io.mouse_pos.x >= window->rect.p0.x + 6 && _nmd_context.io.mouse_pos.x < window->rect.p0.x + 6 + size.x + 8 && _nmd_context.io.mouse_pos.y >= window->y_offset && _nmd_context.io.mouse_pos.y < window->y_offset + 16;
+    const bool is_mouse_hovering = _nmd_context->io.mouse_pos.x >= window->rect.p0.x + 6 && _nmd_context->io.mouse_pos.x < window->rect.p0.x + 6 + size.x + 8 && _nmd_context->io.mouse_pos.y >= window->y_offset && _nmd_context->io.mouse_pos.y < window->y_offset + 16;
 
-    const bool clicked_button = is_mouse_hovering && _nmd_context.io.mouse_released[0] && _nmd_context.io.mouse_clicked_pos[0].x >= window->rect.p0.x + 6 && _nmd_context.io.mouse_clicked_pos[0].x < window->rect.p0.x + 6 + size.x + 8 && _nmd_context.io.mouse_clicked_pos[0].y >= window->y_offset && _nmd_context.io.mouse_clicked_pos[0].y < window->y_offset + 16;
+    const bool clicked_button = is_mouse_hovering && _nmd_context->io.mouse_released[0] && _nmd_context->io.mouse_clicked_pos[0].x >= window->rect.p0.x + 6 && _nmd_context->io.mouse_clicked_pos[0].x < window->rect.p0.x + 6 + size.x + 8 && _nmd_context->io.mouse_clicked_pos[0].y >= window->y_offset && _nmd_context->io.mouse_clicked_pos[0].y < window->y_offset + 16;
 
     /* Add background filled rect */
     nmd_add_rect_filled(window->rect.p0.x + 6, window->y_offset, window->rect.p0.x + 6 + size.x + 8, window->y_offset + 16, is_mouse_hovering ? NMD_COLOR_GUI_BUTTON_HOVER : NMD_COLOR_GUI_BUTTON_BACKGROUND, 0, 0);
     
-    nmd_add_text(&_nmd_context.draw_list.default_atlas, window->rect.p0.x + 6 + 4, window->y_offset + 11, label, 0, NMD_COLOR_WHITE);
+    nmd_add_text(&_nmd_context->draw_list.default_atlas, window->rect.p0.x + 6 + 4, window->y_offset + 11, label, 0, NMD_COLOR_WHITE);
 
     window->y_offset += 16 + 5;
 
@@ -7318,15 +9240,15 @@ bool nmd_button(const char* label)
 bool nmd_checkbox(const char* label, bool* checked)
 {
     /* Make sure we can draw this widget */
-    nmd_window* window = _nmd_context.gui.window;
+    nmd_window* window = _nmd_context->gui.window;
     if (!window->visible || window->collapsed)
         return false;
 
-    const bool is_mouse_hovering = _nmd_context.io.mouse_pos.x >= window->rect.p0.x + 6 && _nmd_context.io.mouse_pos.x < window->rect.p0.x + 6 + 16 && _nmd_context.io.mouse_pos.y >= window->y_offset && _nmd_context.io.mouse_pos.y < window->y_offset + 16;
+    const bool is_mouse_hovering = _nmd_context->io.mouse_pos.x >= window->rect.p0.x + 6 && _nmd_context->io.mouse_pos.x < window->rect.p0.x + 6 + 16 && _nmd_context->io.mouse_pos.y >= window->y_offset && _nmd_context->io.mouse_pos.y < window->y_offset + 16;
     
     bool state_changed = false;
 
-    if (is_mouse_hovering && _nmd_context.io.mouse_released[0] && _nmd_context.io.mouse_clicked_pos[0].x >= window->rect.p0.x + 6 && _nmd_context.io.mouse_clicked_pos[0].x < window->rect.p0.x + 6 + 16 && _nmd_context.io.mouse_clicked_pos[0].y >= window->y_offset && _nmd_context.io.mouse_clicked_pos[0].y < window->y_offset + 16)
+    if (is_mouse_hovering && _nmd_context->io.mouse_released[0] && _nmd_context->io.mouse_clicked_pos[0].x >= window->rect.p0.x + 6 && _nmd_context->io.mouse_clicked_pos[0].x < window->rect.p0.x + 6 + 16 && _nmd_context->io.mouse_clicked_pos[0].y >= window->y_offset && _nmd_context->io.mouse_clicked_pos[0].y < window->y_offset + 16)
     {
         *checked = !*checked;
         state_changed = true;
@@ -7341,7 +9263,7 @@ bool nmd_checkbox(const char* label, bool* checked)
 
     window->y_offset += 16 + 4;
 
-    nmd_add_text(&_nmd_context.draw_list.default_atlas, window->rect.p0.x + 6 + 16 + 4, window->y_offset - 9, label, 0, NMD_COLOR_WHITE);
+    nmd_add_text(&_nmd_context->draw_list.default_atlas, window->rect.p0.x + 6 + 16 + 4, window->y_offset - 9, label, 0, NMD_COLOR_WHITE);
 
     return state_changed;
 }
@@ -7350,7 +9272,7 @@ bool nmd_checkbox(const char* label, bool* checked)
 bool nmd_slider_float(const char* label, float* value, float min_value, float max_value)
 {
     /* Make sure we can draw this widget */
-    nmd_window* window = _nmd_context.gui.window;
+    nmd_window* window = _nmd_context->gui.window;
     if (!window->visible || window->collapsed || *value < min_value || *value > max_value)
         return false;
 
@@ -7358,25 +9280,35 @@ bool nmd_slider_float(const char* label, float* value, float min_value, float ma
 
     bool value_changed = false;
 
+    /* The slider is held from the moment the mouse is pressed on it until it's released */
+    const uint32_t id = nmd_get_id(label);
+    if (!_nmd_context->io.mouse_down[0])
+    {
+        if (_nmd_context->gui.active_id == id)
+            _nmd_context->gui.active_id = 0;
+    }
+    else if (!_nmd_context->gui.active_id && _nmd_context->io.mouse_clicked_pos[0].x >= window->rect.p0.x + 6 && _nmd_context->io.mouse_clicked_pos[0].x < window->rect.p0.x + 6 + _NMD_SLIDER_WIDTH && _nmd_context->io.mouse_clicked_pos[0].y >= window->y_offset && _nmd_context->io.mouse_clicked_pos[0].y < window->y_offset + 16)
+        _nmd_context->gui.active_id = id;
+
     /* Check if the user is sliding the slider */
-    if (_nmd_context.io.mouse_down[0] && _nmd_context.io.mouse_clicked_pos[0].x >= window->rect.p0.x + 6 && _nmd_context.io.mouse_clicked_pos[0].x < window->rect.p0.x + 6 + _NMD_SLIDER_WIDTH && _nmd_context.io.mouse_clicked_pos[0].y >= window->y_offset && _nmd_context.io.mouse_clicked_pos[0].y < window->y_offset + 16)
+    if (_nmd_context->gui.active_id == id)
     {
         const float last_value = *value;
 
         /* Calculte the new offset */
-        if (_nmd_context.io.mouse_pos.x < window->rect.p0.x + 6 + 6)
+        if (_nmd_context->io.mouse_pos.x < window->rect.p0.x + 6 + 6)
         {
             offset = 0;
             *value = min_value;
         }
-        else if (_nmd_context.io.mouse_pos.x >= window->rect.p0.x + 6 + _NMD_SLIDER_WIDTH - 6)
+        else if (_nmd_context->io.mouse_pos.x >= window->rect.p0.x + 6 + _NMD_SLIDER_WIDTH - 6)
         {
             offset = _NMD_SLIDER_WIDTH - 12;
             *value = max_value;
         }
         else
         {
-            offset = _nmd_context.io.mouse_pos.x - (window->rect.p0.x + 6) - 6;
+            offset = _nmd_context->io.mouse_pos.x - (window->rect.p0.x + 6) - 6;
             *value = (offset / (_NMD_SLIDER_WIDTH -6)) * (max_value - min_value) + min_value;
         }
 
@@ -7392,7 +9324,7 @@ bool nmd_slider_float(const char* label, float* value, float min_value, float ma
     }
     //offset = (*value / max_value) * (120-12) - min_value;
 
-    const bool is_mouse_hovering = _nmd_context.io.mouse_pos.x >= window->rect.p0.x + 6 && _nmd_context.io.mouse_pos.x < window->rect.p0.x + 6 + _NMD_SLIDER_WIDTH && _nmd_context.io.mouse_pos.y >= window->y_offset && _nmd_context.io.mouse_pos.y < window->y_offset + 16;
+    const bool is_mouse_hovering = _nmd_context->io.mouse_pos.x >= window->rect.p0.x + 6 && _nmd_context->io.mouse_pos.x < window->rect.p0.x + 6 + _NMD_SLIDER_WIDTH && _nmd_context->io.mouse_pos.y >= window->y_offset && _nmd_context->io.mouse_pos.y < window->y_offset + 16;
 
     /* Add background filled rect */
     nmd_add_rect_filled(window->rect.p0.x + 6, window->y_offset, window->rect.p0.x + 6 + _NMD_SLIDER_WIDTH, window->y_offset + 16, is_mouse_hovering ? NMD_COLOR_GUI_WIDGET_HOVER : NMD_COLOR_GUI_WIDGET_BACKGROUND, 0, 0);
@@ -7401,11 +9333,11 @@ bool nmd_slider_float(const char* label, float* value, float min_value, float ma
     nmd_add_rect_filled(window->rect.p0.x + 6 + 2 + offset, window->y_offset + 2, window->rect.p0.x + 6 + 2 + offset + 8, window->y_offset + 16 - 2, NMD_COLOR_GUI_ACTIVE, 0, 0);
 
     /* Add value text */
-    const int size = NMD_SPRINTF(_nmd_context.gui.fmt_buffer, "%.3f", *value);
-    nmd_add_text(&_nmd_context.draw_list.default_atlas, window->rect.p0.x + 6 + (_NMD_SLIDER_WIDTH/2-15), window->y_offset + 12, _nmd_context.gui.fmt_buffer, _nmd_context.gui.fmt_buffer + size, NMD_COLOR_WHITE);
+    const int size = NMD_SPRINTF(_nmd_context->gui.fmt_buffer, "%.3f", *value);
+    nmd_add_text(&_nmd_context->draw_list.default_atlas, window->rect.p0.x + 6 + (_NMD_SLIDER_WIDTH/2-15), window->y_offset + 12, _nmd_context->gui.fmt_buffer, _nmd_context->gui.fmt_buffer + size, NMD_COLOR_WHITE);
 
     /* Add label text */
-    nmd_add_text(&_nmd_context.draw_list.default_atlas, window->rect.p0.x + 6 + _NMD_SLIDER_WIDTH + 4, window->y_offset + 12, label, 0, NMD_COLOR_WHITE);
+    nmd_add_text(&_nmd_context->draw_list.default_atlas, window->rect.p0.x + 6 + _NMD_SLIDER_WIDTH + 4, window->y_offset + 12, label, 0, NMD_COLOR_WHITE);
 
     window->y_offset += 16 + 5;
 
@@ -7436,6 +9368,7 @@ typedef struct
 void nmd_d3d9_set_device(LPDIRECT3DDEVICE9 p_d3d9_device)
 {
     _nmd_d3d9.device = p_d3d9_device;
+    nmd_invalidate_render_state(NMD_RENDER_STATE_ALL);
 
     _nmd_d3d9.viewport.X;
     _nmd_d3d9.viewport.Y = 0;
@@ -7443,11 +9376,14 @@ void nmd_d3d9_set_device(LPDIRECT3DDEVICE9 p_d3d9_device)
     _nmd_d3d9.viewport.MaxZ = 1.0f;
 
     int width = 16, height = 16;
-    unsigned char* pixels = (unsigned char*)NMD_MALLOC(width * height * 4);
+    unsigned char* pixels = (unsigned char*)_nmd_alloc(width * height * 4);
+    if (!pixels)
+        return;
     
     NMD_MEMSET(pixels, 0xff, width * height * 4);
 
-    _nmd_context.draw_list.default_atlas.font_id = nmd_d3d9_create_texture(pixels, width, height);
+    _nmd_context->draw_list.default_atlas.font_id = nmd_d3d9_create_texture(pixels, width, height);
+    _nmd_free(pixels);
 }
 
 nmd_tex_id nmd_d3d9_create_texture(void* pixels, int width, int height)
@@ -7468,6 +9404,19 @@ nmd_tex_id nmd_d3d9_create_texture(void* pixels, int width, int height)
     return (nmd_tex_id)texture;
 }
 
+void nmd_d3d9_update_texture(nmd_tex_id texture, const void* pixels, int x, int y, int width, int height, int pitch)
+{
+    RECT rect = { x, y, x + width, y + height };
+    D3DLOCKED_RECT tex_locked_rect;
+    if (((IDirect3DTexture9*)texture)->LockRect(0, &tex_locked_rect, &rect, 0) != D3D_OK)
+        return;
+
+    for (int row = 0; row < height; row++)
+        NMD_MEMCPY((unsigned char*)tex_locked_rect.pBits + tex_locked_rect.Pitch * row, (const unsigned char*)pixels + pitch * row, (width * 4));
+
+    ((IDirect3DTexture9*)texture)->UnlockRect(0);
+}
+
 void nmd_d3d9_resize(int width, int height)
 {
     const float L = 0.0f;
@@ -7484,42 +9433,73 @@ void nmd_d3d9_resize(int width, int height)
 
     _nmd_d3d9.viewport.Width = width;
     _nmd_d3d9.viewport.Height = height;
+
+    /* The scissor of draw commands without a clip rect covers the viewport */
+    nmd_invalidate_render_state(NMD_RENDER_STATE_VIEWPORT | NMD_RENDER_STATE_SCISSOR);
 }
 
-void _nmd_d3d9_set_render_state()
-{
-    _nmd_d3d9.device->SetStreamSource(0, _nmd_d3d9.vb, 0, sizeof(_nmd_d3d9_custom_vertex));
-    _nmd_d3d9.device->SetIndices(_nmd_d3d9.ib);
-    _nmd_d3d9.device->SetFVF(_NMD_D3D9_CUSTOM_VERTEX_FVF);
-    _nmd_d3d9.device->SetTransform(D3DTS_PROJECTION, &_nmd_d3d9.proj);
-    _nmd_d3d9.device->SetViewport(&_nmd_d3d9.viewport);
-    _nmd_d3d9.device->SetPixelShader(NULL);
-    _nmd_d3d9.device->SetVertexShader(NULL);
-    _nmd_d3d9.device->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
-    _nmd_d3d9.device->SetRenderState(D3DRS_LIGHTING, false);
-    _nmd_d3d9.device->SetRenderState(D3DRS_ZENABLE, false);
-    _nmd_d3d9.device->SetRenderState(D3DRS_ALPHABLENDENABLE, true);
-    _nmd_d3d9.device->SetRenderState(D3DRS_ALPHATESTENABLE, false);
-    _nmd_d3d9.device->SetRenderState(D3DRS_BLENDOP, D3DBLENDOP_ADD);
-    _nmd_d3d9.device->SetRenderState(D3DRS_SRCBLEND, D3DBLEND_SRCALPHA);
-    _nmd_d3d9.device->SetRenderState(D3DRS_DESTBLEND, D3DBLEND_INVSRCALPHA);
-    _nmd_d3d9.device->SetRenderState(D3DRS_SCISSORTESTENABLE, true);
-    _nmd_d3d9.device->SetRenderState(D3DRS_SHADEMODE, D3DSHADE_GOURAUD);
-    _nmd_d3d9.device->SetRenderState(D3DRS_FOGENABLE, false);
-    _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_COLOROP, D3DTOP_MODULATE);
-    _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_COLORARG1, D3DTA_TEXTURE);
-    _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_COLORARG2, D3DTA_DIFFUSE);
-    _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_ALPHAOP, D3DTOP_MODULATE);
-    _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_ALPHAARG1, D3DTA_TEXTURE);
-    _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_ALPHAARG2, D3DTA_DIFFUSE);
-    _nmd_d3d9.device->SetSamplerState(0, D3DSAMP_MINFILTER, D3DTEXF_LINEAR);
-    _nmd_d3d9.device->SetSamplerState(0, D3DSAMP_MAGFILTER, D3DTEXF_LINEAR);
+/* Sets the categories of render state in 'state'(a mask of 'NMD_RENDER_STATE_XXX'). */
+void _nmd_d3d9_set_render_state(uint32_t state)
+{
+    if (state & NMD_RENDER_STATE_BUFFERS)
+    {
+        _nmd_d3d9.device->SetStreamSource(0, _nmd_d3d9.vb, 0, sizeof(_nmd_d3d9_custom_vertex));
+        _nmd_d3d9.device->SetIndices(_nmd_d3d9.ib);
+        _nmd_d3d9.device->SetFVF(_NMD_D3D9_CUSTOM_VERTEX_FVF);
+    }
+
+    if (state & NMD_RENDER_STATE_VIEWPORT)
+    {
+        _nmd_d3d9.device->SetTransform(D3DTS_PROJECTION, &_nmd_d3d9.proj);
+        _nmd_d3d9.device->SetViewport(&_nmd_d3d9.viewport);
+    }
+
+    if (state & NMD_RENDER_STATE_SHADERS)
+    {
+        _nmd_d3d9.device->SetPixelShader(NULL);
+        _nmd_d3d9.device->SetVertexShader(NULL);
+    }
+
+    if (state & NMD_RENDER_STATE_RASTERIZER)
+    {
+        _nmd_d3d9.device->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
+        _nmd_d3d9.device->SetRenderState(D3DRS_LIGHTING, false);
+        _nmd_d3d9.device->SetRenderState(D3DRS_ZENABLE, false);
+        _nmd_d3d9.device->SetRenderState(D3DRS_SCISSORTESTENABLE, true);
+        _nmd_d3d9.device->SetRenderState(D3DRS_SHADEMODE, D3DSHADE_GOURAUD);
+        _nmd_d3d9.device->SetRenderState(D3DRS_FOGENABLE, false);
+    }
+
+    if (state & NMD_RENDER_STATE_BLEND)
+    {
+        _nmd_d3d9.device->SetRenderState(D3DRS_ALPHABLENDENABLE, true);
+        _nmd_d3d9.device->SetRenderState(D3DRS_ALPHATESTENABLE, false);
+        _nmd_d3d9.device->SetRenderState(D3DRS_BLENDOP, D3DBLENDOP_ADD);
+        _nmd_d3d9.device->SetRenderState(D3DRS_SRCBLEND, D3DBLEND_SRCALPHA);
+        _nmd_d3d9.device->SetRenderState(D3DRS_DESTBLEND, D3DBLEND_INVSRCALPHA);
+    }
+
+    if (state & NMD_RENDER_STATE_TEXTURE)
+    {
+        _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_COLOROP, D3DTOP_MODULATE);
+        _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_COLORARG1, D3DTA_TEXTURE);
+        _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_COLORARG2, D3DTA_DIFFUSE);
+        _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_ALPHAOP, D3DTOP_MODULATE);
+        _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_ALPHAARG1, D3DTA_TEXTURE);
+        _nmd_d3d9.device->SetTextureStageState(0, D3DTSS_ALPHAARG2, D3DTA_DIFFUSE);
+    }
+
+    if (state & NMD_RENDER_STATE_SAMPLER)
+    {
+        _nmd_d3d9.device->SetSamplerState(0, D3DSAMP_MINFILTER, D3DTEXF_LINEAR);
+        _nmd_d3d9.device->SetSamplerState(0, D3DSAMP_MAGFILTER, D3DTEXF_LINEAR);
+    }
 }
 
-void nmd_d3d9_render()
+void _nmd_d3d9_render()
 {
     /* Create/recreate vertex buffer if it doesn't exist or more space is needed */
-    if (!_nmd_d3d9.vb || _nmd_d3d9.vb_size < _nmd_context.draw_list.num_vertices)
+    if (!_nmd_d3d9.vb || _nmd_d3d9.vb_size < _nmd_context->draw_list.num_vertices)
     {
         if (_nmd_d3d9.vb)
         {
@@ -7527,17 +9507,15 @@ void nmd_d3d9_render()
             _nmd_d3d9.vb = 0;
         }
 
-        _nmd_d3d9.vb_size = _nmd_context.draw_list.num_vertices + NMD_VERTEX_BUFFER_INITIAL_SIZE;
+        _nmd_d3d9.vb_size = _nmd_context->draw_list.num_vertices + NMD_VERTEX_BUFFER_INITIAL_SIZE;
         if (_nmd_d3d9.device->CreateVertexBuffer(_nmd_d3d9.vb_size * sizeof(_nmd_d3d9_custom_vertex), D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, _NMD_D3D9_CUSTOM_VERTEX_FVF, D3DPOOL_DEFAULT, &_nmd_d3d9.vb, NULL) != D3D_OK)
             return;
 
-#ifdef NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE
-        _nmd_d3d9_set_render_state();
-#endif /* NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE */
+        nmd_invalidate_render_state(NMD_RENDER_STATE_BUFFERS);
     }
 
     /* Create/recreate index buffer if it doesn't exist or more space is needed */
-    if (!_nmd_d3d9.ib || _nmd_d3d9.ib_size < _nmd_context.draw_list.num_indices)
+    if (!_nmd_d3d9.ib || _nmd_d3d9.ib_size < _nmd_context->draw_list.num_indices)
     {
         if (_nmd_d3d9.ib)
         {
@@ -7545,91 +9523,118 @@ void nmd_d3d9_render()
             _nmd_d3d9.ib = 0;
         }
 
-        _nmd_d3d9.ib_size = _nmd_context.draw_list.num_indices + NMD_INDEX_BUFFER_INITIAL_SIZE;
+        _nmd_d3d9.ib_size = _nmd_context->draw_list.num_indices + NMD_INDEX_BUFFER_INITIAL_SIZE;
         if (_nmd_d3d9.device->CreateIndexBuffer(_nmd_d3d9.ib_size * sizeof(nmd_index), D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, sizeof(nmd_index) == 2 ? D3DFMT_INDEX16 : D3DFMT_INDEX32, D3DPOOL_DEFAULT, &_nmd_d3d9.ib, NULL) < 0)
             return;
 
-#ifdef NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE
-        _nmd_d3d9_set_render_state();
-#endif /* NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE */
+        nmd_invalidate_render_state(NMD_RENDER_STATE_BUFFERS);
     }
 
     /* Copy vertices to the gpu */
     _nmd_d3d9_custom_vertex* p_vertices = 0;
-    if (_nmd_d3d9.vb->Lock(0, (UINT)(_nmd_context.draw_list.num_vertices * sizeof(_nmd_d3d9_custom_vertex)), (void**)&p_vertices, D3DLOCK_DISCARD) != D3D_OK)
+    if (_nmd_d3d9.vb->Lock(0, (UINT)(_nmd_context->draw_list.num_vertices * sizeof(_nmd_d3d9_custom_vertex)), (void**)&p_vertices, D3DLOCK_DISCARD) != D3D_OK)
         return;
     size_t i = 0;
-    for (; i < _nmd_context.draw_list.num_vertices; i++)
+    for (; i < _nmd_context->draw_list.num_vertices; i++)
     {
-        p_vertices[i].pos[0] = _nmd_context.draw_list.vertices[i].pos.x;
-        p_vertices[i].pos[1] = _nmd_context.draw_list.vertices[i].pos.y;
+        p_vertices[i].pos[0] = _nmd_context->draw_list.vertices[i].pos.x;
+        p_vertices[i].pos[1] = _nmd_context->draw_list.vertices[i].pos.y;
         p_vertices[i].pos[2] = 0.0f;
 
-        p_vertices[i].uv[0] = _nmd_context.draw_list.vertices[i].uv.x;
-        p_vertices[i].uv[1] = _nmd_context.draw_list.vertices[i].uv.y;
+        p_vertices[i].uv[0] = _nmd_context->draw_list.vertices[i].uv.x;
+        p_vertices[i].uv[1] = _nmd_context->draw_list.vertices[i].uv.y;
 
-        const nmd_color color = _nmd_context.draw_list.vertices[i].color;
+        const nmd_color color = _nmd_context->draw_list.vertices[i].color;
         p_vertices[i].color = D3DCOLOR_RGBA(color.r, color.g, color.b, color.a);
     }
     _nmd_d3d9.vb->Unlock();
 
     /* Copy indices to the gpu */
     nmd_index* p_indices = 0;
-    if (_nmd_d3d9.ib->Lock(0, (UINT)(_nmd_context.draw_list.num_indices * sizeof(nmd_index)), (void**)&p_indices, D3DLOCK_DISCARD) != D3D_OK)
+    if (_nmd_d3d9.ib->Lock(0, (UINT)(_nmd_context->draw_list.num_indices * sizeof(nmd_index)), (void**)&p_indices, D3DLOCK_DISCARD) != D3D_OK)
         return;
-    NMD_MEMCPY(p_indices, _nmd_context.draw_list.indices, _nmd_context.draw_list.num_indices * sizeof(nmd_index));
+    NMD_MEMCPY(p_indices, _nmd_context->draw_list.indices, _nmd_context->draw_list.num_indices * sizeof(nmd_index));
     _nmd_d3d9.ib->Unlock();
     
-#ifndef NMD_GRAPHICS_D3D9_DONT_BACKUP_RENDER_STATE
+#ifdef NMD_GRAPHICS_D3D9_DONT_BACKUP_RENDER_STATE
+    const uint32_t backup = NMD_RENDER_STATE_NONE;
+#else
+    /* A state block captures every category, so all of them are restored if any category is backed up */
+    const uint32_t backup = (NMD_RENDER_STATE_ALL & ~_nmd_context->render_state.skip_backup) ? NMD_RENDER_STATE_ALL : NMD_RENDER_STATE_NONE;
+
     /* Backup the current render state */
     IDirect3DStateBlock9* d3d9_state_block = NULL;
-    if (_nmd_d3d9.device->CreateStateBlock(D3DSBT_ALL, &d3d9_state_block) < 0)
-        return;
     D3DMATRIX last_world, last_view, last_projection;
-    _nmd_d3d9.device->GetTransform(D3DTS_WORLD, &last_world);
-    _nmd_d3d9.device->GetTransform(D3DTS_VIEW, &last_view);
-    _nmd_d3d9.device->GetTransform(D3DTS_PROJECTION, &last_projection);
+    if (backup)
+    {
+        if (_nmd_d3d9.device->CreateStateBlock(D3DSBT_ALL, &d3d9_state_block) < 0)
+            return;
+        _nmd_d3d9.device->GetTransform(D3DTS_WORLD, &last_world);
+        _nmd_d3d9.device->GetTransform(D3DTS_VIEW, &last_view);
+        _nmd_d3d9.device->GetTransform(D3DTS_PROJECTION, &last_projection);
+    }
 #endif /* NMD_GRAPHICS_D3D9_DONT_BACKUP_RENDER_STATE */
 
-#ifndef NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE
     /* Set render state */
-    _nmd_d3d9_set_render_state();
-#endif /* NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE */
+    _nmd_d3d9_set_render_state(_nmd_begin_render_state());
     
     /* Render draw commands */
-    size_t index_offset = 0;
-    for (i = 0; i < _nmd_context.draw_list.num_draw_commands; i++)
+    size_t index_offset = 0, vertex_start = 0;
+    for (i = 0; i < _nmd_context->draw_list.num_draw_commands; i++)
     {
-        /* Apply scissor rectangle */
-        RECT r;
-        if (_nmd_context.draw_list.draw_commands[i].rect.p1.x == -1.0f)
-            r = { (LONG)_nmd_d3d9.viewport.X, (LONG)_nmd_d3d9.viewport.Y, (LONG)_nmd_d3d9.viewport.Width, (LONG)_nmd_d3d9.viewport.Height };
-        else
-            r = { (LONG)_nmd_context.draw_list.draw_commands[i].rect.p0.x, (LONG)_nmd_context.draw_list.draw_commands[i].rect.p0.y, (LONG)_nmd_context.draw_list.draw_commands[i].rect.p1.x, (LONG)_nmd_context.draw_list.draw_commands[i].rect.p1.y };
-        _nmd_d3d9.device->SetScissorRect(&r);
+        /* Apply scissor rectangle if it changed */
+        if (_nmd_render_state_scissor_changed(&_nmd_context->draw_list.draw_commands[i].rect))
+        {
+            RECT r;
+            if (_nmd_context->draw_list.draw_commands[i].rect.p1.x == -1.0f)
+                r = { (LONG)_nmd_d3d9.viewport.X, (LONG)_nmd_d3d9.viewport.Y, (LONG)_nmd_d3d9.viewport.Width, (LONG)_nmd_d3d9.viewport.Height };
+            else
+                r = { (LONG)_nmd_context->draw_list.draw_commands[i].rect.p0.x, (LONG)_nmd_context->draw_list.draw_commands[i].rect.p0.y, (LONG)_nmd_context->draw_list.draw_commands[i].rect.p1.x, (LONG)_nmd_context->draw_list.draw_commands[i].rect.p1.y };
+            _nmd_d3d9.device->SetScissorRect(&r);
+        }
         
-        /* Set texture */
-        const LPDIRECT3DTEXTURE9 texture = (LPDIRECT3DTEXTURE9)_nmd_context.draw_list.draw_commands[i].user_texture_id;
-        _nmd_d3d9.device->SetTexture(0, texture);
+        /* Set texture if it changed */
+        if (_nmd_render_state_texture_changed(_nmd_context->draw_list.draw_commands[i].user_texture_id))
+            _nmd_d3d9.device->SetTexture(0, (LPDIRECT3DTEXTURE9)_nmd_context->draw_list.draw_commands[i].user_texture_id);
 
         /* Issue draw calls */
-        _nmd_d3d9.device->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, 0, 0, (UINT)_nmd_context.draw_list.draw_commands[i].num_vertices, index_offset, _nmd_context.draw_list.draw_commands[i].num_indices / 3);
+        /* The indices are relative to the base vertex, and so is the range of vertices used by the command */
+        const size_t base_vertex = _nmd_context->draw_list.draw_commands[i].vertex_offset;
+        vertex_start = NMD_MAX(vertex_start, base_vertex);
+        _nmd_d3d9.device->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, (INT)base_vertex, (UINT)(vertex_start - base_vertex), (UINT)_nmd_context->draw_list.draw_commands[i].num_vertices, (UINT)index_offset, (UINT)(_nmd_context->draw_list.draw_commands[i].num_indices / 3));
         
         /* Update offsets */
-        index_offset += _nmd_context.draw_list.draw_commands[i].num_indices;
+        index_offset += _nmd_context->draw_list.draw_commands[i].num_indices;
+        vertex_start += _nmd_context->draw_list.draw_commands[i].num_vertices;
     }
 
 #ifndef NMD_GRAPHICS_D3D9_DONT_BACKUP_RENDER_STATE
     /* Restore previous render state */
-    _nmd_d3d9.device->SetTransform(D3DTS_WORLD, &last_world);
-    _nmd_d3d9.device->SetTransform(D3DTS_VIEW, &last_view);
-    _nmd_d3d9.device->SetTransform(D3DTS_PROJECTION, &last_projection);
-    d3d9_state_block->Apply();
-    d3d9_state_block->Release();
+    if (backup)
+    {
+        _nmd_d3d9.device->SetTransform(D3DTS_WORLD, &last_world);
+        _nmd_d3d9.device->SetTransform(D3DTS_VIEW, &last_view);
+        _nmd_d3d9.device->SetTransform(D3DTS_PROJECTION, &last_projection);
+        d3d9_state_block->Apply();
+        d3d9_state_block->Release();
+    }
 #endif /* NMD_GRAPHICS_D3D9_DONT_BACKUP_RENDER_STATE */
+
+#ifdef NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE
+    _nmd_end_render_state(backup, true);
+#else
+    _nmd_end_render_state(backup, _nmd_context->render_state.known_host_state);
+#endif /* NMD_GRAPHICS_D3D9_OPTIMIZE_RENDER_STATE */
+}
+
+void nmd_d3d9_render()
+{
+    _nmd_profile("nmd_d3d9_render", true);
+    _nmd_d3d9_render();
+    _nmd_profile("nmd_d3d9_render", false);
 }
-#endif /* NMD_GRAPHICS_D3D9 */
 
+#endif /* NMD_GRAPHICS_D3D9 */
 
 #ifdef NMD_GRAPHICS_D3D11
 
@@ -7659,6 +9664,7 @@ void nmd_d3d11_set_device_context(ID3D11DeviceContext* device_context)
 {
     _nmd_d3d11.device_context = device_context;
     _nmd_d3d11.device_context->GetDevice(&_nmd_d3d11.device);
+    nmd_invalidate_render_state(NMD_RENDER_STATE_ALL);
 }
 
 nmd_tex_id nmd_d3d11_create_texture(void* pixels, int width, int height)
@@ -7700,6 +9706,26 @@ nmd_tex_id nmd_d3d11_create_texture(void* pixels, int width, int height)
     return failed ? 0 : (nmd_tex_id)shader_resource_view;
 }
 
+void nmd_d3d11_update_texture(nmd_tex_id texture, const void* pixels, int x, int y, int width, int height, int pitch)
+{
+    if (!_nmd_d3d11.device_context)
+        return;
+
+    ID3D11Resource* resource;
+    ((ID3D11ShaderResourceView*)texture)->GetResource(&resource);
+
+    D3D11_BOX box;
+    box.left = x;
+    box.top = y;
+    box.front = 0;
+    box.right = x + width;
+    box.bottom = y + height;
+    box.back = 1;
+    _nmd_d3d11.device_context->UpdateSubresource(resource, 0, &box, pixels, pitch, 0);
+
+    resource->Release();
+}
+
 bool _nmd_d3d11_create_objects()
 {
     _nmd_d3d11.viewport.MinDepth = 0.0f;
@@ -7832,17 +9858,17 @@ bool _nmd_d3d11_create_objects()
     depth_stencil_desc.BackFace = depth_stencil_desc.FrontFace;
     _nmd_d3d11.device->CreateDepthStencilState(&depth_stencil_desc, &_nmd_d3d11.depth_stencil_state);
 
-    if (!_nmd_context.draw_list.default_atlas.font_id)
+    if (!_nmd_context->draw_list.default_atlas.font_id)
     {
-        if (!nmd_bake_font_from_memory(nmd_karla_ttf_regular, &_nmd_context.draw_list.default_atlas, 14.0f))
+        if (!nmd_bake_font_from_memory(nmd_karla_ttf_regular, &_nmd_context->draw_list.default_atlas, 14.0f))
             return false;
 
         /* Upload texture to graphics system */
-        if (!(_nmd_context.draw_list.default_atlas.font_id = nmd_d3d11_create_texture(_nmd_context.draw_list.default_atlas.pixels32, 512, 512)))
+        if (!(_nmd_context->draw_list.default_atlas.font_id = nmd_d3d11_create_texture(_nmd_context->draw_list.default_atlas.pixels32, 512, 512)))
             return false;
 
         uint32_t tmp = 0xffffffff;
-        if (!(_nmd_context.draw_list.blank_tex_id = nmd_d3d11_create_texture(&tmp, 1, 1)))
+        if (!(_nmd_context->draw_list.blank_tex_id = nmd_d3d11_create_texture(&tmp, 1, 1)))
             return false;
     }
     
@@ -7900,6 +9926,8 @@ void nmd_d3d11_delete_objects()
     _nmd_d3d11.device->Release();
 
     _nmd_d3d11.device = 0;
+
+    nmd_invalidate_render_state(NMD_RENDER_STATE_ALL);
 }
 
 bool nmd_d3d11_resize(int width, int height)
@@ -7929,47 +9957,67 @@ bool nmd_d3d11_resize(int width, int height)
     _nmd_d3d11.viewport.Width = width;
     _nmd_d3d11.viewport.Height = height;
 
+    /* The scissor of draw commands without a clip rect covers the viewport */
+    nmd_invalidate_render_state(NMD_RENDER_STATE_VIEWPORT | NMD_RENDER_STATE_SCISSOR);
+
     return true;
 }
 
-void _nmd_d3d11_set_render_state()
+/* Sets the categories of render state in 'state'(a mask of 'NMD_RENDER_STATE_XXX'). */
+void _nmd_d3d11_set_render_state(uint32_t state)
 {
-    if (!_nmd_d3d11.font_sampler && !_nmd_d3d11_create_objects())
-        return;
+    if (state & NMD_RENDER_STATE_BUFFERS)
+    {
+        unsigned int stride = sizeof(nmd_vertex);
+        unsigned int offset = 0;
+        _nmd_d3d11.device_context->IASetInputLayout(_nmd_d3d11.input_layout);
+        _nmd_d3d11.device_context->IASetVertexBuffers(0, 1, &_nmd_d3d11.vertex_buffer, &stride, &offset);
+        _nmd_d3d11.device_context->IASetIndexBuffer(_nmd_d3d11.index_buffer, sizeof(nmd_index) == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, 0);
+        _nmd_d3d11.device_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    }
+
+    if (state & NMD_RENDER_STATE_SHADERS)
+    {
+        _nmd_d3d11.device_context->VSSetShader(_nmd_d3d11.vertex_shader, NULL, 0);
+        _nmd_d3d11.device_context->VSSetConstantBuffers(0, 1, &_nmd_d3d11.const_buffer);
+        _nmd_d3d11.device_context->PSSetShader(_nmd_d3d11.pixel_shader, NULL, 0);
+        _nmd_d3d11.device_context->GSSetShader(NULL, NULL, 0);
+        _nmd_d3d11.device_context->HSSetShader(NULL, NULL, 0);
+        _nmd_d3d11.device_context->DSSetShader(NULL, NULL, 0);
+        _nmd_d3d11.device_context->CSSetShader(NULL, NULL, 0);
+    }
+
+    if (state & NMD_RENDER_STATE_SAMPLER)
+        _nmd_d3d11.device_context->PSSetSamplers(0, 1, &_nmd_d3d11.font_sampler);
 
-    unsigned int stride = sizeof(nmd_vertex);
-    unsigned int offset = 0;
-    _nmd_d3d11.device_context->IASetInputLayout(_nmd_d3d11.input_layout);
-    _nmd_d3d11.device_context->IASetVertexBuffers(0, 1, &_nmd_d3d11.vertex_buffer, &stride, &offset);
-    _nmd_d3d11.device_context->IASetIndexBuffer(_nmd_d3d11.index_buffer, sizeof(nmd_index) == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, 0);
-    _nmd_d3d11.device_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    _nmd_d3d11.device_context->VSSetShader(_nmd_d3d11.vertex_shader, NULL, 0);
-    _nmd_d3d11.device_context->VSSetConstantBuffers(0, 1, &_nmd_d3d11.const_buffer);
-    _nmd_d3d11.device_context->PSSetShader(_nmd_d3d11.pixel_shader, NULL, 0);
-    _nmd_d3d11.device_context->PSSetSamplers(0, 1, &_nmd_d3d11.font_sampler);
-    _nmd_d3d11.device_context->GSSetShader(NULL, NULL, 0);
-    _nmd_d3d11.device_context->HSSetShader(NULL, NULL, 0);
-    _nmd_d3d11.device_context->DSSetShader(NULL, NULL, 0);
-    _nmd_d3d11.device_context->CSSetShader(NULL, NULL, 0);
-    _nmd_d3d11.device_context->RSSetViewports(1, &_nmd_d3d11.viewport);
-    const float blend_factor[4] = { 0.f, 0.f, 0.f, 0.f };
-    _nmd_d3d11.device_context->OMSetBlendState(_nmd_d3d11.blend_state, blend_factor, 0xffffffff);
-    _nmd_d3d11.device_context->OMSetDepthStencilState(_nmd_d3d11.depth_stencil_state, 0);
-    _nmd_d3d11.device_context->RSSetState(_nmd_d3d11.rasterizer_state);
+    if (state & NMD_RENDER_STATE_VIEWPORT)
+        _nmd_d3d11.device_context->RSSetViewports(1, &_nmd_d3d11.viewport);
+
+    if (state & NMD_RENDER_STATE_BLEND)
+    {
+        const float blend_factor[4] = { 0.f, 0.f, 0.f, 0.f };
+        _nmd_d3d11.device_context->OMSetBlendState(_nmd_d3d11.blend_state, blend_factor, 0xffffffff);
+    }
+
+    if (state & NMD_RENDER_STATE_RASTERIZER)
+    {
+        _nmd_d3d11.device_context->OMSetDepthStencilState(_nmd_d3d11.depth_stencil_state, 0);
+        _nmd_d3d11.device_context->RSSetState(_nmd_d3d11.rasterizer_state);
+    }
 }
 
-void nmd_d3d11_render()
+void _nmd_d3d11_render()
 {
     if (!_nmd_d3d11.font_sampler && !_nmd_d3d11_create_objects())
         return;
 
     /* Create/Recreate vertex/index buffers if needed */
-    if (!_nmd_d3d11.vertex_buffer || _nmd_d3d11.vertex_buffer_size < _nmd_context.draw_list.num_vertices)
+    if (!_nmd_d3d11.vertex_buffer || _nmd_d3d11.vertex_buffer_size < _nmd_context->draw_list.num_vertices)
     {
         if (_nmd_d3d11.vertex_buffer)
             _nmd_d3d11.vertex_buffer->Release();
 
-        _nmd_d3d11.vertex_buffer_size = _nmd_context.draw_list.num_vertices + NMD_VERTEX_BUFFER_INITIAL_SIZE;
+        _nmd_d3d11.vertex_buffer_size = _nmd_context->draw_list.num_vertices + NMD_VERTEX_BUFFER_INITIAL_SIZE;
 
         D3D11_BUFFER_DESC desc;
         NMD_MEMSET(&desc, 0, sizeof(desc));
@@ -7981,17 +10029,15 @@ void nmd_d3d11_render()
         if (FAILED(_nmd_d3d11.device->CreateBuffer(&desc, NULL, &_nmd_d3d11.vertex_buffer)))
             return;
 
-#ifdef NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE
-        _nmd_d3d11_set_render_state();
-#endif /* NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE */
+        nmd_invalidate_render_state(NMD_RENDER_STATE_BUFFERS);
     }
 
-    if (!_nmd_d3d11.index_buffer || _nmd_d3d11.index_buffer_size < _nmd_context.draw_list.num_indices)
+    if (!_nmd_d3d11.index_buffer || _nmd_d3d11.index_buffer_size < _nmd_context->draw_list.num_indices)
     {
         if (_nmd_d3d11.index_buffer)
             _nmd_d3d11.index_buffer->Release();
 
-        _nmd_d3d11.index_buffer_size = _nmd_context.draw_list.num_indices + NMD_INDEX_BUFFER_INITIAL_SIZE;
+        _nmd_d3d11.index_buffer_size = _nmd_context->draw_list.num_indices + NMD_INDEX_BUFFER_INITIAL_SIZE;
 
         D3D11_BUFFER_DESC desc;
         NMD_MEMSET(&desc, 0, sizeof(desc));
@@ -8002,25 +10048,23 @@ void nmd_d3d11_render()
         if (FAILED(_nmd_d3d11.device->CreateBuffer(&desc, NULL, &_nmd_d3d11.index_buffer)))
             return;
 
-#ifdef NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE
-        _nmd_d3d11_set_render_state();
-#endif /* NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE */
+        nmd_invalidate_render_state(NMD_RENDER_STATE_BUFFERS);
     }
 
     /* Copy vertices and indices and to the GPU */
     D3D11_MAPPED_SUBRESOURCE mapped_resource;
     if (_nmd_d3d11.device_context->Map(_nmd_d3d11.vertex_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped_resource) != S_OK)
         return;
-    NMD_MEMCPY(mapped_resource.pData, _nmd_context.draw_list.vertices, _nmd_context.draw_list.num_vertices * sizeof(nmd_vertex));
+    NMD_MEMCPY(mapped_resource.pData, _nmd_context->draw_list.vertices, _nmd_context->draw_list.num_vertices * sizeof(nmd_vertex));
     _nmd_d3d11.device_context->Unmap(_nmd_d3d11.vertex_buffer, 0);
 
     if (_nmd_d3d11.device_context->Map(_nmd_d3d11.index_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped_resource) != S_OK)
         return;
-    NMD_MEMCPY(mapped_resource.pData, _nmd_context.draw_list.indices, _nmd_context.draw_list.num_indices * sizeof(nmd_index));
+    NMD_MEMCPY(mapped_resource.pData, _nmd_context->draw_list.indices, _nmd_context->draw_list.num_indices * sizeof(nmd_index));
     _nmd_d3d11.device_context->Unmap(_nmd_d3d11.index_buffer, 0);
 
 #ifndef NMD_GRAPHICS_D3D11_DONT_BACKUP_RENDER_STATE
-    /* Backup the current render state */
+    /* Backup the categories of the current render state that are restored */
     struct
     {
         UINT ScissorRectsCount, ViewportsCount;
@@ -8045,79 +10089,166 @@ void nmd_d3d11_render()
         DXGI_FORMAT IndexBufferFormat;
         ID3D11InputLayout* InputLayout;
     } old;
-    old.ScissorRectsCount = old.ViewportsCount = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
-    _nmd_d3d11.device_context->RSGetScissorRects(&old.ScissorRectsCount, old.ScissorRects);
-    _nmd_d3d11.device_context->RSGetViewports(&old.ViewportsCount, old.Viewports);
-    _nmd_d3d11.device_context->RSGetState(&old.RS);
-    _nmd_d3d11.device_context->OMGetBlendState(&old.BlendState, old.BlendFactor, &old.SampleMask);
-    _nmd_d3d11.device_context->OMGetDepthStencilState(&old.DepthStencilState, &old.StencilRef);
-    _nmd_d3d11.device_context->PSGetShaderResources(0, 1, &old.PSShaderResource);
-    _nmd_d3d11.device_context->PSGetSamplers(0, 1, &old.PSSampler);
-    old.PSInstancesCount = old.VSInstancesCount = old.GSInstancesCount = 128;
-    _nmd_d3d11.device_context->PSGetShader(&old.PS, old.PSInstances, &old.PSInstancesCount);
-    _nmd_d3d11.device_context->VSGetShader(&old.VS, old.VSInstances, &old.VSInstancesCount);
-    _nmd_d3d11.device_context->VSGetConstantBuffers(0, 1, &old.VSConstantBuffer);
-    _nmd_d3d11.device_context->GSGetShader(&old.GS, old.GSInstances, &old.GSInstancesCount);
-    _nmd_d3d11.device_context->IAGetPrimitiveTopology(&old.PrimitiveTopology);
-    _nmd_d3d11.device_context->IAGetIndexBuffer(&old.IndexBuffer, &old.IndexBufferFormat, &old.IndexBufferOffset);
-    _nmd_d3d11.device_context->IAGetVertexBuffers(0, 1, &old.VertexBuffer, &old.VertexBufferStride, &old.VertexBufferOffset);
-    _nmd_d3d11.device_context->IAGetInputLayout(&old.InputLayout);
+    const uint32_t backup = NMD_RENDER_STATE_ALL & ~_nmd_context->render_state.skip_backup;
+    NMD_MEMSET(&old, 0, sizeof(old));
+    if (backup & NMD_RENDER_STATE_SCISSOR)
+    {
+        old.ScissorRectsCount = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+        _nmd_d3d11.device_context->RSGetScissorRects(&old.ScissorRectsCount, old.ScissorRects);
+    }
+    if (backup & NMD_RENDER_STATE_VIEWPORT)
+    {
+        old.ViewportsCount = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+        _nmd_d3d11.device_context->RSGetViewports(&old.ViewportsCount, old.Viewports);
+    }
+    if (backup & NMD_RENDER_STATE_RASTERIZER)
+    {
+        _nmd_d3d11.device_context->RSGetState(&old.RS);
+        _nmd_d3d11.device_context->OMGetDepthStencilState(&old.DepthStencilState, &old.StencilRef);
+    }
+    if (backup & NMD_RENDER_STATE_BLEND)
+        _nmd_d3d11.device_context->OMGetBlendState(&old.BlendState, old.BlendFactor, &old.SampleMask);
+    if (backup & NMD_RENDER_STATE_TEXTURE)
+        _nmd_d3d11.device_context->PSGetShaderResources(0, 1, &old.PSShaderResource);
+    if (backup & NMD_RENDER_STATE_SAMPLER)
+        _nmd_d3d11.device_context->PSGetSamplers(0, 1, &old.PSSampler);
+    if (backup & NMD_RENDER_STATE_SHADERS)
+    {
+        old.PSInstancesCount = old.VSInstancesCount = old.GSInstancesCount = 128;
+        _nmd_d3d11.device_context->PSGetShader(&old.PS, old.PSInstances, &old.PSInstancesCount);
+        _nmd_d3d11.device_context->VSGetShader(&old.VS, old.VSInstances, &old.VSInstancesCount);
+        _nmd_d3d11.device_context->VSGetConstantBuffers(0, 1, &old.VSConstantBuffer);
+        _nmd_d3d11.device_context->GSGetShader(&old.GS, old.GSInstances, &old.GSInstancesCount);
+    }
+    if (backup & NMD_RENDER_STATE_BUFFERS)
+    {
+        _nmd_d3d11.device_context->IAGetPrimitiveTopology(&old.PrimitiveTopology);
+        _nmd_d3d11.device_context->IAGetIndexBuffer(&old.IndexBuffer, &old.IndexBufferFormat, &old.IndexBufferOffset);
+        _nmd_d3d11.device_context->IAGetVertexBuffers(0, 1, &old.VertexBuffer, &old.VertexBufferStride, &old.VertexBufferOffset);
+        _nmd_d3d11.device_context->IAGetInputLayout(&old.InputLayout);
+    }
+#else
+    const uint32_t backup = NMD_RENDER_STATE_NONE;
 #endif /* NMD_GRAPHICS_D3D11_DONT_BACKUP_RENDER_STATE */
 
-#ifndef NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE
     /* Set render state */
-    _nmd_d3d11_set_render_state();
-#endif /* NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE */
+    _nmd_d3d11_set_render_state(_nmd_begin_render_state());
 
     /* Render draw commands */
     size_t index_offset = 0;
-    for (int i = 0; i < _nmd_context.draw_list.num_draw_commands; i++)
+    for (size_t i = 0; i < _nmd_context->draw_list.num_draw_commands; i++)
     {
-        /* Apply scissor rectangle */
-        D3D11_RECT r;
-        if (_nmd_context.draw_list.draw_commands[i].rect.p1.x == -1.0f)
-            r = { (LONG)_nmd_d3d11.viewport.TopLeftX, (LONG)_nmd_d3d11.viewport.TopLeftY, (LONG)_nmd_d3d11.viewport.Width, (LONG)_nmd_d3d11.viewport.Height };
-        else
-            r = { (LONG)_nmd_context.draw_list.draw_commands[i].rect.p0.x, (LONG)_nmd_context.draw_list.draw_commands[i].rect.p0.y, (LONG)_nmd_context.draw_list.draw_commands[i].rect.p1.x, (LONG)_nmd_context.draw_list.draw_commands[i].rect.p1.y };
-        _nmd_d3d11.device_context->RSSetScissorRects(1, &r);
+        /* Apply scissor rectangle if it changed */
+        if (_nmd_render_state_scissor_changed(&_nmd_context->draw_list.draw_commands[i].rect))
+        {
+            D3D11_RECT r;
+            if (_nmd_context->draw_list.draw_commands[i].rect.p1.x == -1.0f)
+                r = { (LONG)_nmd_d3d11.viewport.TopLeftX, (LONG)_nmd_d3d11.viewport.TopLeftY, (LONG)_nmd_d3d11.viewport.Width, (LONG)_nmd_d3d11.viewport.Height };
+            else
+                r = { (LONG)_nmd_context->draw_list.draw_commands[i].rect.p0.x, (LONG)_nmd_context->draw_list.draw_commands[i].rect.p0.y, (LONG)_nmd_context->draw_list.draw_commands[i].rect.p1.x, (LONG)_nmd_context->draw_list.draw_commands[i].rect.p1.y };
+            _nmd_d3d11.device_context->RSSetScissorRects(1, &r);
+        }
 
-        /* Set texture */
-        ID3D11ShaderResourceView* texture_srv = (ID3D11ShaderResourceView*)_nmd_context.draw_list.draw_commands[i].user_texture_id;
-        _nmd_d3d11.device_context->PSSetShaderResources(0, 1, &texture_srv);
+        /* Set texture if it changed */
+        if (_nmd_render_state_texture_changed(_nmd_context->draw_list.draw_commands[i].user_texture_id))
+        {
+            ID3D11ShaderResourceView* texture_srv = (ID3D11ShaderResourceView*)_nmd_context->draw_list.draw_commands[i].user_texture_id;
+            _nmd_d3d11.device_context->PSSetShaderResources(0, 1, &texture_srv);
+        }
 
         /* Issue draw call */
-        _nmd_d3d11.device_context->DrawIndexed(_nmd_context.draw_list.draw_commands[i].num_indices, index_offset, 0);
+        _nmd_d3d11.device_context->DrawIndexed((UINT)_nmd_context->draw_list.draw_commands[i].num_indices, (UINT)index_offset, (INT)_nmd_context->draw_list.draw_commands[i].vertex_offset);
 
         /* Update offset */
-        index_offset += _nmd_context.draw_list.draw_commands[i].num_indices;
+        index_offset += _nmd_context->draw_list.draw_commands[i].num_indices;
     }
 
 #ifndef NMD_GRAPHICS_D3D11_DONT_BACKUP_RENDER_STATE
-    /* Restore previous render state */
-    _nmd_d3d11.device_context->RSSetScissorRects(old.ScissorRectsCount, old.ScissorRects);
-    _nmd_d3d11.device_context->RSSetViewports(old.ViewportsCount, old.Viewports);
-    _nmd_d3d11.device_context->RSSetState(old.RS); if (old.RS) old.RS->Release();
-    _nmd_d3d11.device_context->OMSetBlendState(old.BlendState, old.BlendFactor, old.SampleMask); if (old.BlendState) old.BlendState->Release();
-    _nmd_d3d11.device_context->OMSetDepthStencilState(old.DepthStencilState, old.StencilRef); if (old.DepthStencilState) old.DepthStencilState->Release();
-    _nmd_d3d11.device_context->PSSetShaderResources(0, 1, &old.PSShaderResource); if (old.PSShaderResource) old.PSShaderResource->Release();
-    _nmd_d3d11.device_context->PSSetSamplers(0, 1, &old.PSSampler); if (old.PSSampler) old.PSSampler->Release();
-    _nmd_d3d11.device_context->PSSetShader(old.PS, old.PSInstances, old.PSInstancesCount); if (old.PS) old.PS->Release();
-    for (UINT i = 0; i < old.PSInstancesCount; i++) if (old.PSInstances[i]) old.PSInstances[i]->Release();
-    _nmd_d3d11.device_context->VSSetShader(old.VS, old.VSInstances, old.VSInstancesCount); if (old.VS) old.VS->Release();
-    _nmd_d3d11.device_context->VSSetConstantBuffers(0, 1, &old.VSConstantBuffer); if (old.VSConstantBuffer) old.VSConstantBuffer->Release();
-    _nmd_d3d11.device_context->GSSetShader(old.GS, old.GSInstances, old.GSInstancesCount); if (old.GS) old.GS->Release();
-    for (UINT i = 0; i < old.VSInstancesCount; i++) if (old.VSInstances[i]) old.VSInstances[i]->Release();
-    _nmd_d3d11.device_context->IASetPrimitiveTopology(old.PrimitiveTopology);
-    _nmd_d3d11.device_context->IASetIndexBuffer(old.IndexBuffer, old.IndexBufferFormat, old.IndexBufferOffset); if (old.IndexBuffer) old.IndexBuffer->Release();
-    _nmd_d3d11.device_context->IASetVertexBuffers(0, 1, &old.VertexBuffer, &old.VertexBufferStride, &old.VertexBufferOffset); if (old.VertexBuffer) old.VertexBuffer->Release();
-    _nmd_d3d11.device_context->IASetInputLayout(old.InputLayout); if (old.InputLayout) old.InputLayout->Release();
+    /* Restore the categories of the previous render state that were backed up */
+    if (backup & NMD_RENDER_STATE_SCISSOR)
+        _nmd_d3d11.device_context->RSSetScissorRects(old.ScissorRectsCount, old.ScissorRects);
+    if (backup & NMD_RENDER_STATE_VIEWPORT)
+        _nmd_d3d11.device_context->RSSetViewports(old.ViewportsCount, old.Viewports);
+    if (backup & NMD_RENDER_STATE_RASTERIZER)
+    {
+        _nmd_d3d11.device_context->RSSetState(old.RS); if (old.RS) old.RS->Release();
+        _nmd_d3d11.device_context->OMSetDepthStencilState(old.DepthStencilState, old.StencilRef); if (old.DepthStencilState) old.DepthStencilState->Release();
+    }
+    if (backup & NMD_RENDER_STATE_BLEND)
+    {
+        _nmd_d3d11.device_context->OMSetBlendState(old.BlendState, old.BlendFactor, old.SampleMask); if (old.BlendState) old.BlendState->Release();
+    }
+    if (backup & NMD_RENDER_STATE_TEXTURE)
+    {
+        _nmd_d3d11.device_context->PSSetShaderResources(0, 1, &old.PSShaderResource); if (old.PSShaderResource) old.PSShaderResource->Release();
+    }
+    if (backup & NMD_RENDER_STATE_SAMPLER)
+    {
+        _nmd_d3d11.device_context->PSSetSamplers(0, 1, &old.PSSampler); if (old.PSSampler) old.PSSampler->Release();
+    }
+    if (backup & NMD_RENDER_STATE_SHADERS)
+    {
+        _nmd_d3d11.device_context->PSSetShader(old.PS, old.PSInstances, old.PSInstancesCount); if (old.PS) old.PS->Release();
+        for (UINT i = 0; i < old.PSInstancesCount; i++) if (old.PSInstances[i]) old.PSInstances[i]->Release();
+        _nmd_d3d11.device_context->VSSetShader(old.VS, old.VSInstances, old.VSInstancesCount); if (old.VS) old.VS->Release();
+        _nmd_d3d11.device_context->VSSetConstantBuffers(0, 1, &old.VSConstantBuffer); if (old.VSConstantBuffer) old.VSConstantBuffer->Release();
+        _nmd_d3d11.device_context->GSSetShader(old.GS, old.GSInstances, old.GSInstancesCount); if (old.GS) old.GS->Release();
+        for (UINT i = 0; i < old.VSInstancesCount; i++) if (old.VSInstances[i]) old.VSInstances[i]->Release();
+    }
+    if (backup & NMD_RENDER_STATE_BUFFERS)
+    {
+        _nmd_d3d11.device_context->IASetPrimitiveTopology(old.PrimitiveTopology);
+        _nmd_d3d11.device_context->IASetIndexBuffer(old.IndexBuffer, old.IndexBufferFormat, old.IndexBufferOffset); if (old.IndexBuffer) old.IndexBuffer->Release();
+        _nmd_d3d11.device_context->IASetVertexBuffers(0, 1, &old.VertexBuffer, &old.VertexBufferStride, &old.VertexBufferOffset); if (old.VertexBuffer) old.VertexBuffer->Release();
+        _nmd_d3d11.device_context->IASetInputLayout(old.InputLayout); if (old.InputLayout) old.InputLayout->Release();
+    }
 #endif /* NMD_GRAPHICS_D3D11_DONT_BACKUP_RENDER_STATE */
+
+#ifdef NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE
+    _nmd_end_render_state(backup, true);
+#else
+    _nmd_end_render_state(backup, _nmd_context->render_state.known_host_state);
+#endif /* NMD_GRAPHICS_D3D11_OPTIMIZE_RENDER_STATE */
 }
 
-#endif /* NMD_GRAPHICS_D3D11 */
+void nmd_d3d11_render()
+{
+    _nmd_profile("nmd_d3d11_render", true);
+    _nmd_d3d11_render();
+    _nmd_profile("nmd_d3d11_render", false);
+}
 
+#endif /* NMD_GRAPHICS_D3D11 */
 
 #ifdef NMD_GRAPHICS_OPENGL
+
+#ifdef NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS
+
+/* Persistent mapping needs glBufferStorage(), which is in the headers since OpenGL 4.4 */
+#ifdef GL_MAP_PERSISTENT_BIT
+#define _NMD_OPENGL_BUFFER_STORAGE
+#endif /* GL_MAP_PERSISTENT_BIT */
+
+/* The granularity in bytes of the ranges that are compared and uploaded. */
+#define _NMD_OPENGL_DIRTY_BLOCK_SIZE 256
+
+typedef struct
+{
+    size_t begin, end; /* The range is empty if 'begin' >= 'end'. */
+} _nmd_opengl_range;
+
+typedef struct
+{
+    GLuint buffer;
+    GLenum target; /* 'GL_ARRAY_BUFFER' or 'GL_ELEMENT_ARRAY_BUFFER' */
+    uint8_t* mapped; /* The persistently mapped storage of 'NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT' segments or null. */
+    size_t capacity; /* The size of a segment in bytes. */
+    uint8_t* shadow; /* A copy of the data of the previous frame. */
+    size_t shadow_size, shadow_capacity;
+    _nmd_opengl_range pending[NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT]; /* The bytes of each segment that are outdated. */
+} _nmd_opengl_stream;
+#endif /* NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS */
+
 struct
 {
     GLuint vbo, vao, ebo;
@@ -8125,6 +10256,14 @@ struct
     GLuint uniform_tex, uniform_proj, attrib_pos, attrib_uv, attrib_color;
     GLsizei width, height;
     GLfloat ortho[4][4];
+#ifdef NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS
+    _nmd_opengl_stream vertex_stream, index_stream;
+    bool persistent; /* True if the buffers are persistently mapped, otherwise they're updated with glBufferSubData(). */
+    size_t segment; /* The segment used by the current frame. */
+#ifdef _NMD_OPENGL_BUFFER_STORAGE
+    GLsync fences[NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT]; /* Signaled when the GPU is done with the segment */
+#endif /* _NMD_OPENGL_BUFFER_STORAGE */
+#endif /* NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS */
 } _nmd_opengl;
 bool _nmd_opengl_initialized = false;
 
@@ -8150,6 +10289,25 @@ nmd_tex_id nmd_opengl_create_texture(void* pixels, int width, int height)
     return texture;
 }
 
+void nmd_opengl_update_texture(nmd_tex_id texture, const void* pixels, int x, int y, int width, int height, int pitch)
+{
+    GLint last_texture;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
+    glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)texture);
+
+#ifdef GL_UNPACK_ROW_LENGTH
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#else
+    /* The row length can't be set, so the rows are uploaded one at a time */
+    for (int row = 0; row < height; row++)
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y + row, width, 1, GL_RGBA, GL_UNSIGNED_BYTE, (const uint8_t*)pixels + pitch * row);
+#endif
+
+    glBindTexture(GL_TEXTURE_2D, last_texture);
+}
+
 #ifdef __APPLE__
     #define _NMD_OPENGL_SHADER_VERSION "#version 150\n"
 #else
@@ -8240,10 +10398,39 @@ bool _nmd_opengl_create_objects()
     glGenBuffers(1, &_nmd_opengl.vbo);
     glGenBuffers(1, &_nmd_opengl.ebo);
 
+#ifdef NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS
+    _nmd_opengl.vertex_stream.buffer = _nmd_opengl.vbo;
+    _nmd_opengl.vertex_stream.target = GL_ARRAY_BUFFER;
+    _nmd_opengl.index_stream.buffer = _nmd_opengl.ebo;
+    _nmd_opengl.index_stream.target = GL_ELEMENT_ARRAY_BUFFER;
+
+#ifdef _NMD_OPENGL_BUFFER_STORAGE
+    /* glBufferStorage() is core since OpenGL 4.4 */
+    GLint major_version = 0, minor_version = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major_version);
+    glGetIntegerv(GL_MINOR_VERSION, &minor_version);
+    _nmd_opengl.persistent = major_version > 4 || (major_version == 4 && minor_version >= 4);
+    if (!_nmd_opengl.persistent)
+    {
+        GLint num_extensions = 0, i = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
+        for (; i < num_extensions && !_nmd_opengl.persistent; i++)
+        {
+            const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+            _nmd_opengl.persistent = extension && NMD_STRLEN(extension) == 21 && !NMD_MEMCMP(extension, "GL_ARB_buffer_storage", 21);
+        }
+    }
+#endif /* _NMD_OPENGL_BUFFER_STORAGE */
+#endif /* NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS */
+
     int width = 16, height = 16;
-    char* pixels = malloc(width * height * 4);
-    NMD_MEMSET(pixels, 255, width * height * 4);
-    _nmd_context.draw_list.font = nmd_opengl_create_texture(pixels, width, height);
+    char* pixels = (char*)_nmd_alloc(width * height * 4);
+    if (pixels)
+    {
+        NMD_MEMSET(pixels, 255, width * height * 4);
+        _nmd_context->draw_list.blank_tex_id = nmd_opengl_create_texture(pixels, width, height);
+        _nmd_free(pixels);
+    }
 
     /* Restore modified GL state */
     glBindTexture(GL_TEXTURE_2D, last_texture);
@@ -8261,43 +10448,222 @@ bool nmd_opengl_resize(int width, int height)
         return false;
 
     glViewport(0, 0, (GLsizei)width, (GLsizei)height);
-    _nmd_opengl.ortho[0][0] /= (GLfloat)width;
-    _nmd_opengl.ortho[1][1] /= (GLfloat)height;
+    _nmd_opengl.ortho[0][0] = 2.0f / (GLfloat)width;
+    _nmd_opengl.ortho[1][1] = -2.0f / (GLfloat)height;
 
     _nmd_opengl.width = width;
     _nmd_opengl.height = height;
 
+    /* The scissor of draw commands without a clip rect covers the viewport */
+    nmd_invalidate_render_state(NMD_RENDER_STATE_VIEWPORT | NMD_RENDER_STATE_SCISSOR);
+
     return true;
 }
 
-void _nmd_opengl_set_render_state()
+#ifdef NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS
+/* Compares 'data' with the data of the previous frame and adds the blocks that changed to the pending range of every segment. */
+bool _nmd_opengl_stream_update(_nmd_opengl_stream* stream, const void* data, size_t size)
 {
-    // Setup render state: alpha-blending enabled, no face culling, no depth testing, scissor enabled, polygon fill
-    glEnable(GL_BLEND);
-    glBlendEquation(GL_FUNC_ADD);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDisable(GL_CULL_FACE);
-    glDisable(GL_DEPTH_TEST);
-    glEnable(GL_SCISSOR_TEST);
-#ifdef GL_POLYGON_MODE
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-#endif
+    const uint8_t* const bytes = (const uint8_t*)data;
+    const size_t common_size = NMD_MIN(size, stream->shadow_size);
+    size_t begin = 0, end = 0, i = 0;
 
-    // Support for GL 4.5 rarely used glClipControl(GL_UPPER_LEFT)
-    bool clip_origin_lower_left = true;
-#if defined(GL_CLIP_ORIGIN) && !defined(__APPLE__)
-    GLenum current_clip_origin = 0; glGetIntegerv(GL_CLIP_ORIGIN, (GLint*)&current_clip_origin);
-    if (current_clip_origin == GL_UPPER_LEFT)
-        clip_origin_lower_left = false;
-#endif
+    /* Find the first and the last block that changed. Everything after the data of the previous frame is new */
+    while (begin < common_size && !NMD_MEMCMP(bytes + begin, stream->shadow + begin, NMD_MIN(_NMD_OPENGL_DIRTY_BLOCK_SIZE, common_size - begin)))
+        begin += _NMD_OPENGL_DIRTY_BLOCK_SIZE;
+
+    if (size > stream->shadow_size)
+        end = size;
+    else if (begin < common_size)
+    {
+        end = common_size;
+        while (end > begin)
+        {
+            const size_t block_begin = NMD_MAX(begin, end - NMD_MIN(end, _NMD_OPENGL_DIRTY_BLOCK_SIZE));
+            if (NMD_MEMCMP(bytes + block_begin, stream->shadow + block_begin, end - block_begin))
+                break;
+            end = block_begin;
+        }
+    }
+
+    /* The last block compared may be shorter */
+    begin = NMD_MIN(begin, common_size);
+    if (begin >= end)
+    {
+        stream->shadow_size = size;
+        return true;
+    }
+
+    /* Update the copy of the data */
+    if (size > stream->shadow_capacity)
+    {
+        const size_t new_capacity = NMD_MAX(stream->shadow_capacity * 2, size);
+        uint8_t* mem = (uint8_t*)_nmd_alloc(new_capacity);
+        if (!mem)
+            return false;
+        NMD_MEMCPY(mem, stream->shadow, stream->shadow_size);
+        _nmd_free(stream->shadow);
+
+        stream->shadow = mem;
+        stream->shadow_capacity = new_capacity;
+    }
+    NMD_MEMCPY(stream->shadow + begin, bytes + begin, end - begin);
+    stream->shadow_size = size;
+
+    for (; i < NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT; i++)
+    {
+        if (stream->pending[i].begin >= stream->pending[i].end)
+            stream->pending[i].begin = begin, stream->pending[i].end = end;
+        else
+        {
+            stream->pending[i].begin = NMD_MIN(stream->pending[i].begin, begin);
+            stream->pending[i].end = NMD_MAX(stream->pending[i].end, end);
+        }
+    }
+
+    return true;
+}
+
+/* Writes the pending range of the current segment to the GPU, growing the buffer if necessary. Returns false if the buffer could not be grown. */
+bool _nmd_opengl_stream_upload(_nmd_opengl_stream* stream, const void* data, size_t size)
+{
+    _nmd_opengl_range* const pending = &stream->pending[_nmd_opengl.segment];
+    bool grown = false;
+    size_t i = 0;
+
+    if (size > stream->capacity)
+    {
+        /* The contents of every segment are lost */
+        stream->capacity = NMD_MAX(stream->capacity * 2, size);
+        for (; i < NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT; i++)
+            stream->pending[i].begin = 0, stream->pending[i].end = (size_t)-1;
+        grown = true;
+    }
+
+    pending->end = NMD_MIN(pending->end, size);
+
+#ifdef _NMD_OPENGL_BUFFER_STORAGE
+    if (_nmd_opengl.persistent)
+    {
+        if (grown)
+        {
+            /* The storage of a buffer is immutable, so a new buffer is created */
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glDeleteBuffers(1, &stream->buffer);
+            glGenBuffers(1, &stream->buffer);
+            nmd_invalidate_render_state(NMD_RENDER_STATE_BUFFERS);
+            glBindBuffer(stream->target, stream->buffer);
+            glBufferStorage(stream->target, (GLsizeiptr)(stream->capacity * NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT), 0, flags);
+            if (!(stream->mapped = (uint8_t*)glMapBufferRange(stream->target, 0, (GLsizeiptr)(stream->capacity * NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT), flags)))
+            {
+                stream->capacity = 0;
+                return false;
+            }
+        }
+
+        if (pending->begin < pending->end)
+            NMD_MEMCPY(stream->mapped + _nmd_opengl.segment * stream->capacity + pending->begin, (const uint8_t*)data + pending->begin, pending->end - pending->begin);
+    }
+    else
+#endif /* _NMD_OPENGL_BUFFER_STORAGE */
+    {
+        glBindBuffer(stream->target, stream->buffer);
+
+        /* If most of the buffer changed it's orphaned, so the driver doesn't wait for the previous frame */
+        if (grown || pending->end - pending->begin > size / 2)
+        {
+            glBufferData(stream->target, (GLsizeiptr)stream->capacity, 0, GL_DYNAMIC_DRAW);
+            pending->begin = 0;
+            pending->end = size;
+        }
+
+        if (pending->begin < pending->end)
+            glBufferSubData(stream->target, (GLintptr)pending->begin, (GLsizeiptr)(pending->end - pending->begin), (const GLvoid*)((const uint8_t*)data + pending->begin));
+    }
+
+    pending->begin = pending->end = 0;
+
+    return true;
+}
+
+/* Uploads the vertices and indices of the draw list that changed since the segment was last used. Returns false if the buffers could not be grown. */
+bool _nmd_opengl_upload()
+{
+#ifdef _NMD_OPENGL_BUFFER_STORAGE
+    if (_nmd_opengl.persistent)
+    {
+        /* Wait until the GPU is done with the segment, which was used 'NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT' frames ago */
+        _nmd_opengl.segment = (_nmd_opengl.segment + 1) % NMD_GRAPHICS_OPENGL_FRAMES_IN_FLIGHT;
+        GLsync* const fence = &_nmd_opengl.fences[_nmd_opengl.segment];
+        if (*fence)
+        {
+            while (glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED);
+            glDeleteSync(*fence);
+            *fence = 0;
+        }
+    }
+#endif /* _NMD_OPENGL_BUFFER_STORAGE */
+
+    const size_t vertices_size = _nmd_context->draw_list.num_vertices * sizeof(nmd_vertex);
+    const size_t indices_size = _nmd_context->draw_list.num_indices * sizeof(nmd_index);
+
+    return _nmd_opengl_stream_update(&_nmd_opengl.vertex_stream, _nmd_context->draw_list.vertices, vertices_size) &&
+           _nmd_opengl_stream_update(&_nmd_opengl.index_stream, _nmd_context->draw_list.indices, indices_size) &&
+           _nmd_opengl_stream_upload(&_nmd_opengl.vertex_stream, _nmd_context->draw_list.vertices, vertices_size) &&
+           _nmd_opengl_stream_upload(&_nmd_opengl.index_stream, _nmd_context->draw_list.indices, indices_size);
+}
+#endif /* NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS */
+
+/* Points the vertex attributes to the vertex 'first_vertex' of the vertex buffer. Used for the base vertex of draw commands when glDrawElementsBaseVertex() is not available. */
+void _nmd_opengl_set_vertex_attributes(size_t first_vertex)
+{
+    const size_t offset = first_vertex * sizeof(nmd_vertex);
+    glVertexAttribPointer(_nmd_opengl.attrib_pos, 2, GL_FLOAT, GL_FALSE, sizeof(nmd_vertex), (GLvoid*)(offset + (size_t)_NMD_OFFSETOF(nmd_vertex, pos)));
+    glVertexAttribPointer(_nmd_opengl.attrib_uv, 2, GL_FLOAT, GL_FALSE, sizeof(nmd_vertex), (GLvoid*)(offset + (size_t)_NMD_OFFSETOF(nmd_vertex, uv)));
+    glVertexAttribPointer(_nmd_opengl.attrib_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(nmd_vertex), (GLvoid*)(offset + (size_t)_NMD_OFFSETOF(nmd_vertex, color)));
+}
+
+/* Sets the categories of render state in 'state'(a mask of 'NMD_RENDER_STATE_XXX'). */
+void _nmd_opengl_set_render_state(uint32_t state)
+{
+    if (state & NMD_RENDER_STATE_SHADERS)
+    {
+        glUseProgram(_nmd_opengl.program);
+        glUniform1i(_nmd_opengl.uniform_tex, 0);
+    }
+
+    if (state & NMD_RENDER_STATE_TEXTURE)
+        glActiveTexture(GL_TEXTURE0);
 
-    glViewport(0, 0, (GLsizei)_nmd_opengl.width, (GLsizei)_nmd_opengl.height);
-    glUseProgram(_nmd_opengl.program);
-    glUniform1i(_nmd_opengl.uniform_tex, 0);
-    glUniformMatrix4fv(_nmd_opengl.uniform_proj, 1, GL_FALSE, &_nmd_opengl.ortho[0][0]);
 #ifdef GL_SAMPLER_BINDING
-    glBindSampler(0, 0); // We use combined texture/sampler state. Applications using GL 3.3 may set that otherwise.
+    if (state & NMD_RENDER_STATE_SAMPLER)
+        glBindSampler(0, 0); // We use combined texture/sampler state. Applications using GL 3.3 may set that otherwise.
+#endif
+
+    // Setup render state: alpha-blending enabled, no face culling, no depth testing, scissor enabled, polygon fill
+    if (state & NMD_RENDER_STATE_BLEND)
+    {
+        glEnable(GL_BLEND);
+        glBlendEquation(GL_FUNC_ADD);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    if (state & NMD_RENDER_STATE_RASTERIZER)
+    {
+        glDisable(GL_CULL_FACE);
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_SCISSOR_TEST);
+#ifdef GL_POLYGON_MODE
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 #endif
+    }
+
+    /* The projection matrix is a uniform of the program, which is bound at this point */
+    if (state & NMD_RENDER_STATE_VIEWPORT)
+    {
+        glViewport(0, 0, (GLsizei)_nmd_opengl.width, (GLsizei)_nmd_opengl.height);
+        glUniformMatrix4fv(_nmd_opengl.uniform_proj, 1, GL_FALSE, &_nmd_opengl.ortho[0][0]);
+    }
 
 //    (void)vertex_array_object;
 //#ifndef IMGUI_IMPL_OPENGL_ES2
@@ -8305,106 +10671,216 @@ void _nmd_opengl_set_render_state()
 //#endif
 
     // Bind vertex/index buffers and setup attributes for ImDrawVert
-    glBindBuffer(GL_ARRAY_BUFFER, _nmd_opengl.vbo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _nmd_opengl.ebo);
-    glEnableVertexAttribArray(_nmd_opengl.attrib_pos);
-    glEnableVertexAttribArray(_nmd_opengl.attrib_uv);
-    glEnableVertexAttribArray(_nmd_opengl.attrib_color);
-    glVertexAttribPointer(_nmd_opengl.attrib_pos, 2, GL_FLOAT, GL_FALSE, sizeof(nmd_vertex), (GLvoid*)_NMD_OFFSETOF(nmd_vertex, pos));
-    glVertexAttribPointer(_nmd_opengl.attrib_uv, 2, GL_FLOAT, GL_FALSE, sizeof(nmd_vertex), (GLvoid*)_NMD_OFFSETOF(nmd_vertex, uv));
-    glVertexAttribPointer(_nmd_opengl.attrib_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(nmd_vertex), (GLvoid*)_NMD_OFFSETOF(nmd_vertex, color));
+    if (state & NMD_RENDER_STATE_BUFFERS)
+    {
+#ifdef NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS
+        /* The buffers are recreated when they grow */
+        _nmd_opengl.vbo = _nmd_opengl.vertex_stream.buffer;
+        _nmd_opengl.ebo = _nmd_opengl.index_stream.buffer;
+#endif /* NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS */
+        glBindBuffer(GL_ARRAY_BUFFER, _nmd_opengl.vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _nmd_opengl.ebo);
+        glEnableVertexAttribArray(_nmd_opengl.attrib_pos);
+        glEnableVertexAttribArray(_nmd_opengl.attrib_uv);
+        glEnableVertexAttribArray(_nmd_opengl.attrib_color);
+        _nmd_opengl_set_vertex_attributes(0);
+    }
 }
 
-void nmd_opengl_render()
+void _nmd_opengl_render()
 {
     if (!_nmd_opengl_create_objects())
-        return false;
+        return;
 
-#ifndef NMD_GRAPHICS_OPENGL_DONT_BACKUP_RENDER_STATE
-    /* Backup the current render state */
-    GLenum last_active_texture; glGetIntegerv(GL_ACTIVE_TEXTURE, (GLint*)&last_active_texture);
-    glActiveTexture(GL_TEXTURE0);
-    GLuint last_program; glGetIntegerv(GL_CURRENT_PROGRAM, (GLint*)&last_program);
-    GLuint last_texture; glGetIntegerv(GL_TEXTURE_BINDING_2D, (GLint*)&last_texture);
+#ifdef NMD_GRAPHICS_OPENGL_DONT_BACKUP_RENDER_STATE
+    const uint32_t backup = NMD_RENDER_STATE_NONE;
+#else
+    const uint32_t backup = NMD_RENDER_STATE_ALL & ~_nmd_context->render_state.skip_backup;
+
+    /* Backup the categories of the current render state that are restored */
+    GLenum last_active_texture = GL_TEXTURE0;
+    GLuint last_program = 0, last_texture = 0, last_array_buffer = 0;
+    if (backup & NMD_RENDER_STATE_SHADERS)
+        glGetIntegerv(GL_CURRENT_PROGRAM, (GLint*)&last_program);
+    if (backup & NMD_RENDER_STATE_TEXTURE)
+    {
+        glGetIntegerv(GL_ACTIVE_TEXTURE, (GLint*)&last_active_texture);
+        glActiveTexture(GL_TEXTURE0);
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, (GLint*)&last_texture);
+    }
 #ifdef GL_SAMPLER_BINDING
-    GLuint last_sampler; glGetIntegerv(GL_SAMPLER_BINDING, (GLint*)&last_sampler);
+    GLuint last_sampler = 0;
+    if (backup & NMD_RENDER_STATE_SAMPLER)
+        glGetIntegerv(GL_SAMPLER_BINDING, (GLint*)&last_sampler);
+#endif
+#ifndef IMGUI_IMPL_OPENGL_ES2
+    GLuint last_vertex_array_object = 0;
 #endif
-    GLuint last_array_buffer; glGetIntegerv(GL_ARRAY_BUFFER_BINDING, (GLint*)&last_array_buffer);
+    if (backup & NMD_RENDER_STATE_BUFFERS)
+    {
+        glGetIntegerv(GL_ARRAY_BUFFER_BINDING, (GLint*)&last_array_buffer);
 #ifndef IMGUI_IMPL_OPENGL_ES2
-    GLuint last_vertex_array_object; glGetIntegerv(GL_VERTEX_ARRAY_BINDING, (GLint*)&last_vertex_array_object);
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, (GLint*)&last_vertex_array_object);
+#endif
+    }
+    GLenum last_blend_src_rgb = 0, last_blend_dst_rgb = 0, last_blend_src_alpha = 0, last_blend_dst_alpha = 0, last_blend_equation_rgb = 0, last_blend_equation_alpha = 0;
+    GLboolean last_enable_blend = GL_FALSE;
+    if (backup & NMD_RENDER_STATE_BLEND)
+    {
+        glGetIntegerv(GL_BLEND_SRC_RGB, (GLint*)&last_blend_src_rgb);
+        glGetIntegerv(GL_BLEND_DST_RGB, (GLint*)&last_blend_dst_rgb);
+        glGetIntegerv(GL_BLEND_SRC_ALPHA, (GLint*)&last_blend_src_alpha);
+        glGetIntegerv(GL_BLEND_DST_ALPHA, (GLint*)&last_blend_dst_alpha);
+        glGetIntegerv(GL_BLEND_EQUATION_RGB, (GLint*)&last_blend_equation_rgb);
+        glGetIntegerv(GL_BLEND_EQUATION_ALPHA, (GLint*)&last_blend_equation_alpha);
+        last_enable_blend = glIsEnabled(GL_BLEND);
+    }
+#ifdef GL_POLYGON_MODE
+    GLint last_polygon_mode[2] = { GL_FILL, GL_FILL };
 #endif
+    GLboolean last_enable_cull_face = GL_FALSE, last_enable_depth_test = GL_FALSE, last_enable_scissor_test = GL_FALSE;
+    if (backup & NMD_RENDER_STATE_RASTERIZER)
+    {
 #ifdef GL_POLYGON_MODE
-    GLint last_polygon_mode[2]; glGetIntegerv(GL_POLYGON_MODE, last_polygon_mode);
+        glGetIntegerv(GL_POLYGON_MODE, last_polygon_mode);
 #endif
-    GLint last_viewport[4]; glGetIntegerv(GL_VIEWPORT, last_viewport);
-    GLint last_scissor_box[4]; glGetIntegerv(GL_SCISSOR_BOX, last_scissor_box);
-    GLenum last_blend_src_rgb; glGetIntegerv(GL_BLEND_SRC_RGB, (GLint*)&last_blend_src_rgb);
-    GLenum last_blend_dst_rgb; glGetIntegerv(GL_BLEND_DST_RGB, (GLint*)&last_blend_dst_rgb);
-    GLenum last_blend_src_alpha; glGetIntegerv(GL_BLEND_SRC_ALPHA, (GLint*)&last_blend_src_alpha);
-    GLenum last_blend_dst_alpha; glGetIntegerv(GL_BLEND_DST_ALPHA, (GLint*)&last_blend_dst_alpha);
-    GLenum last_blend_equation_rgb; glGetIntegerv(GL_BLEND_EQUATION_RGB, (GLint*)&last_blend_equation_rgb);
-    GLenum last_blend_equation_alpha; glGetIntegerv(GL_BLEND_EQUATION_ALPHA, (GLint*)&last_blend_equation_alpha);
-    GLboolean last_enable_blend = glIsEnabled(GL_BLEND);
-    GLboolean last_enable_cull_face = glIsEnabled(GL_CULL_FACE);
-    GLboolean last_enable_depth_test = glIsEnabled(GL_DEPTH_TEST);
-    GLboolean last_enable_scissor_test = glIsEnabled(GL_SCISSOR_TEST);
+        last_enable_cull_face = glIsEnabled(GL_CULL_FACE);
+        last_enable_depth_test = glIsEnabled(GL_DEPTH_TEST);
+        last_enable_scissor_test = glIsEnabled(GL_SCISSOR_TEST);
+    }
+    GLint last_viewport[4], last_scissor_box[4];
+    if (backup & NMD_RENDER_STATE_VIEWPORT)
+        glGetIntegerv(GL_VIEWPORT, last_viewport);
+    if (backup & NMD_RENDER_STATE_SCISSOR)
+        glGetIntegerv(GL_SCISSOR_BOX, last_scissor_box);
 #endif /* NMD_GRAPHICS_OPENGL_DONT_BACKUP_RENDER_STATE */
 
+#ifdef NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS
+    /* Copy the vertices and indices that changed to the GPU */
+    const bool uploaded = _nmd_opengl_upload();
+
     /* Set render state */
-    _nmd_opengl_set_render_state();
+    _nmd_opengl_set_render_state(_nmd_begin_render_state());
+
+    /* The offsets of the current segment */
+    const GLint base_vertex = (GLint)(_nmd_opengl.segment * (_nmd_opengl.vertex_stream.capacity / sizeof(nmd_vertex)));
+    size_t index_offset = _nmd_opengl.segment * (_nmd_opengl.index_stream.capacity / sizeof(nmd_index));
+    size_t i = uploaded ? 0 : _nmd_context->draw_list.num_draw_commands;
+#else
+    /* Set render state */
+    _nmd_opengl_set_render_state(_nmd_begin_render_state());
 
     /* Copy vertices and indices and to the GPU */
-    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)_nmd_context.draw_list.num_vertices * (int)sizeof(nmd_vertex), (const GLvoid*)_nmd_context.draw_list.vertices, GL_STREAM_DRAW);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)_nmd_context.draw_list.num_indices * (int)sizeof(nmd_index), (const GLvoid*)_nmd_context.draw_list.indices, GL_STREAM_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)_nmd_context->draw_list.num_vertices * (int)sizeof(nmd_vertex), (const GLvoid*)_nmd_context->draw_list.vertices, GL_STREAM_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)_nmd_context->draw_list.num_indices * (int)sizeof(nmd_index), (const GLvoid*)_nmd_context->draw_list.indices, GL_STREAM_DRAW);
 
-    /* Render command buffers */
     size_t i = 0;
     size_t index_offset = 0;
-    for (; i < _nmd_context.draw_list.num_draw_commands; i++)
+#endif /* NMD_GRAPHICS_OPENGL_PERSISTENT_BUFFERS */
+    size_t vertex_offset = 0; /* The vertex the attributes point to */
+
+    /* Render command buffers */
+    for (; i < _nmd_context->draw_list.num_draw_commands; i++)
     {
-        /* Apply scissor rectangle */
-        if (_nmd_context.draw_list.draw_commands[i].rect.p1.x == -1.0f)
-            glScissor(0, 0, (GLsizei)_nmd_opengl.width, (GLsizei)_nmd_opengl.height);
-        else
-            glScissor((GLint)_nmd_context.draw_list.draw_commands[i].rect.p0.x, (GLint)_nmd_context.draw_list.draw_commands[i].rect.p0.y, (GLsizei)_nmd_context.draw_list.draw_commands[i].rect.p1.x, (GLsizei)_nmd_context.draw_list.draw_commands[i].rect.p1.y);
+        /* Apply scissor rectangle if it changed */
+        if (_nmd_render_state_scissor_changed(&_nmd_context->draw_list.draw_commands[i].rect))
+        {
+            if (_nmd_context->draw_list.draw_commands[i].rect.p1.x == -1.0f)
+                glScissor(0, 0, (GLsizei)_nmd_opengl.width, (GLsizei)_nmd_opengl.height);
+            else
+                glScissor((GLint)_nmd_context->draw_list.draw_commands[i].rect.p0.x, (GLint)_nmd_context->draw_list.draw_commands[i].rect.p0.y, (GLsizei)_nmd_context->draw_list.draw_commands[i].rect.p1.x, (GLsizei)_nmd_context->draw_list.draw_commands[i].rect.p1.y);
+        }
         
-        /* Set texture */
-        glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)_nmd_context.draw_list.draw_commands[i].user_texture_id);
+        /* Set texture if it changed */
+        if (_nmd_render_state_texture_changed(_nmd_context->draw_list.draw_commands[i].user_texture_id))
+            glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)_nmd_context->draw_list.draw_commands[i].user_texture_id);
 
         /* Issue draw call */
-        glDrawElements(GL_TRIANGLES, (GLsizei)_nmd_context.draw_list.draw_commands[i].num_indices, sizeof(nmd_index) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(index_offset * sizeof(nmd_index)));
+#ifdef _NMD_OPENGL_BUFFER_STORAGE
+        if (_nmd_opengl.persistent)
+            glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)_nmd_context->draw_list.draw_commands[i].num_indices, sizeof(nmd_index) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(index_offset * sizeof(nmd_index)), base_vertex + (GLint)_nmd_context->draw_list.draw_commands[i].vertex_offset);
+        else
+#endif /* _NMD_OPENGL_BUFFER_STORAGE */
+        {
+            /* The base vertex only changes every 64K vertices, so the attributes are moved instead of requiring glDrawElementsBaseVertex() */
+            if (vertex_offset != _nmd_context->draw_list.draw_commands[i].vertex_offset)
+            {
+                vertex_offset = _nmd_context->draw_list.draw_commands[i].vertex_offset;
+                _nmd_opengl_set_vertex_attributes(vertex_offset);
+            }
+
+            glDrawElements(GL_TRIANGLES, (GLsizei)_nmd_context->draw_list.draw_commands[i].num_indices, sizeof(nmd_index) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void*)(intptr_t)(index_offset * sizeof(nmd_index)));
+        }
         
         /* Update offset */
-        index_offset += _nmd_context.draw_list.draw_commands[i].num_indices;
+        index_offset += _nmd_context->draw_list.draw_commands[i].num_indices;
     }
 
+    /* The render state cache expects the attributes to point to the first vertex */
+    if (vertex_offset)
+        _nmd_opengl_set_vertex_attributes(0);
+
+#ifdef _NMD_OPENGL_BUFFER_STORAGE
+    /* The segment can be written again when the GPU is done with these draw calls */
+    if (_nmd_opengl.persistent)
+        _nmd_opengl.fences[_nmd_opengl.segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif /* _NMD_OPENGL_BUFFER_STORAGE */
+
 #ifndef NMD_GRAPHICS_OPENGL_DONT_BACKUP_RENDER_STATE
-    /* Restore previous render state */
-    glUseProgram(last_program);
-    glBindTexture(GL_TEXTURE_2D, last_texture);
+    /* Restore the categories of the previous render state that were backed up */
+    if (backup & NMD_RENDER_STATE_SHADERS)
+        glUseProgram(last_program);
+    if (backup & NMD_RENDER_STATE_TEXTURE)
+    {
+        glBindTexture(GL_TEXTURE_2D, last_texture);
+        glActiveTexture(last_active_texture);
+    }
 #ifdef GL_SAMPLER_BINDING
-    glBindSampler(0, last_sampler);
+    if (backup & NMD_RENDER_STATE_SAMPLER)
+        glBindSampler(0, last_sampler);
 #endif
-    glActiveTexture(last_active_texture);
+    if (backup & NMD_RENDER_STATE_BUFFERS)
+    {
 #ifndef IMGUI_IMPL_OPENGL_ES2
-    glBindVertexArray(last_vertex_array_object);
+        glBindVertexArray(last_vertex_array_object);
 #endif
-    glBindBuffer(GL_ARRAY_BUFFER, last_array_buffer);
-    glBlendEquationSeparate(last_blend_equation_rgb, last_blend_equation_alpha);
-    glBlendFuncSeparate(last_blend_src_rgb, last_blend_dst_rgb, last_blend_src_alpha, last_blend_dst_alpha);
-    if (last_enable_blend) glEnable(GL_BLEND); else glDisable(GL_BLEND);
-    if (last_enable_cull_face) glEnable(GL_CULL_FACE); else glDisable(GL_CULL_FACE);
-    if (last_enable_depth_test) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
-    if (last_enable_scissor_test) glEnable(GL_SCISSOR_TEST); else glDisable(GL_SCISSOR_TEST);
+        glBindBuffer(GL_ARRAY_BUFFER, last_array_buffer);
+    }
+    if (backup & NMD_RENDER_STATE_BLEND)
+    {
+        glBlendEquationSeparate(last_blend_equation_rgb, last_blend_equation_alpha);
+        glBlendFuncSeparate(last_blend_src_rgb, last_blend_dst_rgb, last_blend_src_alpha, last_blend_dst_alpha);
+        if (last_enable_blend) glEnable(GL_BLEND); else glDisable(GL_BLEND);
+    }
+    if (backup & NMD_RENDER_STATE_RASTERIZER)
+    {
+        if (last_enable_cull_face) glEnable(GL_CULL_FACE); else glDisable(GL_CULL_FACE);
+        if (last_enable_depth_test) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
+        if (last_enable_scissor_test) glEnable(GL_SCISSOR_TEST); else glDisable(GL_SCISSOR_TEST);
 #ifdef GL_POLYGON_MODE
-    glPolygonMode(GL_FRONT_AND_BACK, (GLenum)last_polygon_mode[0]);
+        glPolygonMode(GL_FRONT_AND_BACK, (GLenum)last_polygon_mode[0]);
 #endif
-    glViewport(last_viewport[0], last_viewport[1], (GLsizei)last_viewport[2], (GLsizei)last_viewport[3]);
-    glScissor(last_scissor_box[0], last_scissor_box[1], (GLsizei)last_scissor_box[2], (GLsizei)last_scissor_box[3]);
+    }
+    if (backup & NMD_RENDER_STATE_VIEWPORT)
+        glViewport(last_viewport[0], last_viewport[1], (GLsizei)last_viewport[2], (GLsizei)last_viewport[3]);
+    if (backup & NMD_RENDER_STATE_SCISSOR)
+        glScissor(last_scissor_box[0], last_scissor_box[1], (GLsizei)last_scissor_box[2], (GLsizei)last_scissor_box[3]);
 #endif /* NMD_GRAPHICS_OPENGL_DONT_BACKUP_RENDER_STATE */
+
+#ifdef NMD_GRAPHICS_OPENGL_OPTIMIZE_RENDER_STATE
+    _nmd_end_render_state(backup, true);
+#else
+    _nmd_end_render_state(backup, _nmd_context->render_state.known_host_state);
+#endif /* NMD_GRAPHICS_OPENGL_OPTIMIZE_RENDER_STATE */
 }
 
-#endif /* NMD_GRAPHICS_OPENGL */
+void nmd_opengl_render()
+{
+    _nmd_profile("nmd_opengl_render", true);
+    _nmd_opengl_render();
+    _nmd_profile("nmd_opengl_render", false);
+}
 
+#endif /* NMD_GRAPHICS_OPENGL */
 
 #endif // NMD_GRAPHICS_IMPLEMENTATION
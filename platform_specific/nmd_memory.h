@@ -1,4 +1,6 @@
 /* This is a C89 memory library for Windows.
+The pattern functions that don't query memory(nmd_pattern_compile(), nmd_pattern_find() and the pattern sets except nmd_pattern_set_scan_range()) are
+portable, everything else is only compiled if '_WIN32' is defined.
 
 Features:
  - No libc
@@ -16,6 +18,20 @@ used by the syscall for the remaining parameters.
 
 nmd_get_module_handle(): Similar to GetModuleHandleW()
 nmd_get_proc_addr(): Similar to GetProcAddress()
+
+Pattern scanning:
+nmd_pattern_scan_range() compiles the pattern and scans the range. To scan several ranges for the same pattern, compile it once with nmd_pattern_compile()
+and use nmd_pattern_scan_range_ex(). To scan for many patterns in a single pass over memory, add them to a 'nmd_pattern_set' and use nmd_pattern_set_scan_range().
+nmd_pattern_scan_process() scans the committed memory of any process(including the current one) using several threads and returns every match.
+Candidates are found by searching for the pattern's rarest byte(the anchor, chosen using the byte frequencies of x86 machine code) instead of comparing
+the pattern at every offset. Define the following macros to search for candidates using SIMD instructions:
+ - 'NMD_MEMORY_ENABLE_SSE2': 16 offsets are filtered at once. This macro includes <emmintrin.h>.
+ - 'NMD_MEMORY_ENABLE_AVX2': 32 offsets are filtered at once(the code must be compiled with AVX2 enabled). This macro includes <immintrin.h> and implies 'NMD_MEMORY_ENABLE_SSE2'.
+
+Hooking:
+nmd_hook() hooks a single function. To install many hooks, fill an array of 'nmd_hook_entry' and use nmd_hook_batch(): every trampoline is built first,
+then each page is made writable once, all targets are patched and the instruction cache is flushed once. If any hook fails none is installed.
+Specify 'NMD_HOOK_BATCH_FLAGS_SUSPEND_THREADS' to suspend the other threads of the process while the targets are patched.
 */
 
 #ifndef NMD_MEMORY_H
@@ -71,7 +87,7 @@ typedef unsigned long long uint64_t;
 
 #endif /* NMD_MEMORY_DEFINE_INT_TYPES */
 
-
+#ifdef _WIN32
 #ifdef __clang__
     #define _NMD_NAKED __attribute__((naked))
 #else
@@ -83,7 +99,73 @@ typedef unsigned long long uint64_t;
 #endif /* __clang__ */
 
 #include <Windows.h>
+#endif /* _WIN32 */
+
+#ifdef NMD_MEMORY_ENABLE_AVX2
+#ifndef NMD_MEMORY_ENABLE_SSE2
+#define NMD_MEMORY_ENABLE_SSE2
+#endif /* NMD_MEMORY_ENABLE_SSE2 */
+#include <immintrin.h>
+#elif defined(NMD_MEMORY_ENABLE_SSE2)
+#include <emmintrin.h>
+#endif /* NMD_MEMORY_ENABLE_AVX2 */
+
+/* The maximum length of a compiled pattern. It must be a multiple of 16. */
+#ifndef NMD_PATTERN_MAX_LENGTH
+#define NMD_PATTERN_MAX_LENGTH 128
+#endif /* NMD_PATTERN_MAX_LENGTH */
+
+/* The maximum number of patterns of a 'nmd_pattern_set'(at most 64). */
+#ifndef NMD_PATTERN_SET_MAX_PATTERNS
+#define NMD_PATTERN_SET_MAX_PATTERNS 64
+#endif /* NMD_PATTERN_SET_MAX_PATTERNS */
+
+/* The number of bytes nmd_pattern_scan_process() reads and scans at once. */
+#ifndef NMD_PATTERN_SCAN_CHUNK_SIZE
+#define NMD_PATTERN_SCAN_CHUNK_SIZE (1024 * 1024)
+#endif /* NMD_PATTERN_SCAN_CHUNK_SIZE */
+
+/* The maximum number of threads used by nmd_pattern_scan_process(). */
+#ifndef NMD_MEMORY_MAX_THREADS
+#define NMD_MEMORY_MAX_THREADS 64
+#endif /* NMD_MEMORY_MAX_THREADS */
+
+/* The maximum number of threads nmd_hook_batch() can suspend when 'NMD_HOOK_BATCH_FLAGS_SUSPEND_THREADS' is specified. */
+#ifndef NMD_HOOK_BATCH_MAX_THREADS
+#define NMD_HOOK_BATCH_MAX_THREADS 1024
+#endif /* NMD_HOOK_BATCH_MAX_THREADS */
+
+typedef struct nmd_pattern
+{
+    uint8_t bytes[NMD_PATTERN_MAX_LENGTH]; /* The pattern's bytes. Wildcards are zero. */
+    uint8_t mask[NMD_PATTERN_MAX_LENGTH];  /* 0xff for bytes that must match, zero for wildcards and the bytes after the pattern. */
+    size_t length;                         /* The pattern's length in bytes. */
+    size_t anchor;                         /* The offset of the rarest byte that is not a wildcard. Candidates are found by searching for this byte. */
+    size_t anchor2;                        /* The offset of the second rarest byte that is not a wildcard, or 'anchor' if there's only one. */
+    const void* source;                    /* The pattern passed to nmd_pattern_compile(). It matches itself, so a match at this address is never returned. */
+} nmd_pattern;
+
+typedef struct nmd_pattern_set
+{
+    nmd_pattern patterns[NMD_PATTERN_SET_MAX_PATTERNS];
+    size_t num_patterns;
+    uint64_t anchors[256]; /* 'anchors[b]' has bit 'i' set if the anchor of 'patterns[i]' is the byte 'b'. */
+} nmd_pattern_set;
 
+typedef struct nmd_region
+{
+    uint8_t* base; /* The region's start address. */
+    size_t size;   /* The region's size in bytes. */
+} nmd_region;
+
+typedef struct nmd_hook_entry
+{
+    void* target;   /* The function to be hooked. */
+    void* detour;   /* The function to override the 'target'. */
+    void* original; /* An optional pointer to a variable that receives the address of the original function. */
+} nmd_hook_entry;
+
+#ifdef _WIN32
 typedef struct nmd_proc
 {
 	HANDLE h_process;
@@ -296,6 +378,12 @@ enum NMD_INJECTION_FLAGS
     NMD_INJECTION_FLAGS_EXCEPTIONS    = (1 << 5), /* Add support for exceptions */
 };
 
+enum NMD_HOOK_BATCH_FLAGS
+{
+    NMD_HOOK_BATCH_FLAGS_NONE            = 0,
+    NMD_HOOK_BATCH_FLAGS_SUSPEND_THREADS = (1 << 0), /* Suspend the other threads of the process while the targets are patched */
+};
+
 /* Returns the last error code set. */
 uint32_t nmd_get_error_code();
 
@@ -381,16 +469,121 @@ Parameters:
  - protection [in] The memory protection the page must match. Specify '-1' for any protection.
 */
 uint8_t* nmd_pattern_scan_range(const char* pattern, const char* mask, uint8_t* start, uint8_t* end, uint32_t protection);
+#endif /* _WIN32 */
+
+/* Compiles a pattern for nmd_pattern_find() and nmd_pattern_scan_range_ex(). Returns false if the pattern is empty, only has wildcards or is longer than 'NMD_PATTERN_MAX_LENGTH'.
+Parameters:
+ - compiled [out] A pointer to a variable of type 'nmd_pattern'.
+ - pattern  [in]  The pattern. e.g. "\x10\x20\x30\x40\x50".
+ - mask     [in]  The mask. e.g. "xxxxx", "x????xxxxx?xx".
+*/
+bool nmd_pattern_compile(nmd_pattern* compiled, const char* pattern, const char* mask);
+
+/* Returns the address of the first match of a compiled pattern in a readable buffer, or zero if there's none. The memory is not queried.
+Parameters:
+ - compiled [in] A pointer to a pattern compiled by nmd_pattern_compile().
+ - start    [in] The buffer's start address.
+ - end      [in] The buffer's end address.
+*/
+uint8_t* nmd_pattern_find(const nmd_pattern* compiled, const uint8_t* start, const uint8_t* end);
+
+#ifdef _WIN32
+/* Same as nmd_pattern_scan_range(), but the pattern is compiled. Consecutive readable regions are scanned as a single buffer.
+Parameters:
+ - compiled   [in] A pointer to a pattern compiled by nmd_pattern_compile().
+ - start      [in] The range's start address.
+ - end        [in] The range's end address.
+ - protection [in] The memory protection the page must match. Specify '-1' for any protection.
+*/
+uint8_t* nmd_pattern_scan_range_ex(const nmd_pattern* compiled, uint8_t* start, uint8_t* end, uint32_t protection);
+#endif /* _WIN32 */
+
+/* Initializes an empty pattern set.
+Parameters:
+ - set [out] A pointer to a variable of type 'nmd_pattern_set'.
+*/
+void nmd_pattern_set_init(nmd_pattern_set* set);
+
+/* Adds a pattern to a set. Returns the pattern's index, or -1 if the set is full or the pattern can't be compiled(see nmd_pattern_compile()).
+Parameters:
+ - set     [in/out] A pointer to a set initialized by nmd_pattern_set_init().
+ - pattern [in]     The pattern. e.g. "\x10\x20\x30\x40\x50".
+ - mask    [in]     The mask. e.g. "xxxxx", "x????xxxxx?xx".
+*/
+int nmd_pattern_set_add(nmd_pattern_set* set, const char* pattern, const char* mask);
+
+/* Searches a readable buffer for every pattern of a set in a single pass. Returns the number of patterns found, including the ones found by previous calls.
+Parameters:
+ - set     [in]     A pointer to a pattern set.
+ - start   [in]     The buffer's start address.
+ - end     [in]     The buffer's end address.
+ - matches [in/out] A pointer to an array of 'set->num_patterns' elements. Only the patterns whose element is zero are searched, 'matches[i]' receives
+                    the address of the first match of 'set->patterns[i]'. Initialize the array with zeros before the first call.
+*/
+size_t nmd_pattern_set_find(const nmd_pattern_set* set, const uint8_t* start, const uint8_t* end, uint8_t** matches);
+
+#ifdef _WIN32
+/* Same as nmd_pattern_set_find(), but scans a range of memory like nmd_pattern_scan_range_ex(). Each region is scanned once for every pattern.
+The scan stops when every pattern was found. Returns the number of patterns found.
+Parameters:
+ - set        [in]  A pointer to a pattern set.
+ - start      [in]  The range's start address.
+ - end        [in]  The range's end address.
+ - protection [in]  The memory protection the page must match. Specify '-1' for any protection.
+ - matches    [out] A pointer to an array of 'set->num_patterns' elements. 'matches[i]' receives the address of the first match of 'set->patterns[i]', or zero.
+*/
+size_t nmd_pattern_set_scan_range(const nmd_pattern_set* set, uint8_t* start, uint8_t* end, uint32_t protection, uint8_t** matches);
+
+/* Enumerates the committed memory regions of a process that are readable and match a protection. Consecutive regions are merged into one.
+Returns the number of regions, which may be larger than 'max_regions'(call it with 'max_regions' set to zero to count the regions).
+Parameters:
+ - h_process   [in]  A handle to the process with the 'PROCESS_QUERY_INFORMATION' access right.
+ - start       [in]  The range's start address.
+ - end         [in]  The range's end address.
+ - protection  [in]  The memory protection the region must match. Specify '-1' for any protection.
+ - regions     [out] A pointer to an array of 'max_regions' elements that receives the regions.
+ - max_regions [in]  The number of elements of 'regions'.
+*/
+size_t nmd_enumerate_regions(HANDLE h_process, uint8_t* start, uint8_t* end, uint32_t protection, nmd_region* regions, size_t max_regions);
+
+/* Scans the committed memory of a process for every match of a compiled pattern. Regions are split in chunks of 'NMD_PATTERN_SCAN_CHUNK_SIZE' bytes
+which are read with NtReadVirtualMemory() and scanned by a pool of threads, the calling thread included. Chunks overlap by the pattern's length minus one,
+so matches that cross a chunk boundary are found. In the current process the pattern passed to nmd_pattern_compile() and the compiled copy are skipped.
+Returns the number of matches, which may be larger than 'max_matches'(the matches are sorted by address, but if there are more than 'max_matches' the ones
+stored are not necessarily the first ones).
+Parameters:
+ - h_process   [in]  A handle to the process with the 'PROCESS_QUERY_INFORMATION' and 'PROCESS_VM_READ' access rights, or '(HANDLE)-1' for the current process.
+ - compiled    [in]  A pointer to a pattern compiled by nmd_pattern_compile().
+ - start       [in]  The range's start address.
+ - end         [in]  The range's end address.
+ - protection  [in]  The memory protection the region must match. Specify '-1' for any protection.
+ - num_threads [in]  The number of threads that scan the memory, at most 'NMD_MEMORY_MAX_THREADS'.
+ - matches     [out] A pointer to an array of 'max_matches' elements that receives the addresses of the matches.
+ - max_matches [in]  The number of elements of 'matches'.
+*/
+size_t nmd_pattern_scan_process(HANDLE h_process, const nmd_pattern* compiled, uint8_t* start, uint8_t* end, uint32_t protection, size_t num_threads, uint8_t** matches, size_t max_matches);
 
 /*
 Hooks a function. Returns true if successful, false otherwise.
 Parameters:
  - target   [in]      The function to be hooked.
  - detour   [in]      The function to override the 'target'.
- - original [out/opt] An optional pointer to a variable that recieves the address of the original function.
+ - original [out/opt] An optional pointer to a variable that recieves the address of the original function. It's set before 'target' is patched, and left unchanged on failure.
  */
 bool nmd_hook(void* target, void* detour, void* original);
 
+/*
+Installs several hooks at once. Returns true if every hook was installed, false otherwise(in which case no target was modified).
+The 'original' variables are set before the first target is patched, and they are restored if the function fails.
+Each page that contains a target is made writable once, and the instruction cache is flushed once after all targets are patched.
+The targets must not overlap.
+Parameters:
+ - hooks     [in] A pointer to an array of 'num_hooks' elements that describes the hooks.
+ - num_hooks [in] The number of elements of 'hooks'.
+ - flags     [in] A mask of flags(members of the NMD_HOOK_BATCH_FLAGS enum) which change the behaviour of the function.
+ */
+bool nmd_hook_batch(const nmd_hook_entry* hooks, size_t num_hooks, uint32_t flags);
+
 /* Iterates through all processes to find the process with a matching name. Returns the PID of the specified process, or zero if the operation failed.
 Parameters:
  - process_name [in] The wide-char process name.
@@ -419,9 +612,11 @@ Parameters:
  - flags     [in] A mask of flags(members of the NMD_INJECTION_FLAGS enum) which change the behaviour of the function.
 */
 uintptr_t nmd_inject_manual(HANDLE h_process, const void* dll, uint32_t flags);
+#endif /* _WIN32 */
 
 #ifdef NMD_MEMORY_IMPLEMENTATION
 
+#ifdef _WIN32
 uint32_t _nmd_error_code;
 
 /* Returns the last error code set. */
@@ -449,6 +644,8 @@ NMD_PPEB nmd_get_peb()
 #endif
 }
 
+#endif /* _WIN32 */
+
 size_t _nmd_strlen(const char* str)
 {
     size_t len = 0;
@@ -458,6 +655,7 @@ size_t _nmd_strlen(const char* str)
     return len;
 }
 
+#ifdef _WIN32
 size_t _nmd_strlenw(const wchar_t* str)
 {
     size_t len = 0;
@@ -589,6 +787,9 @@ extern "C" uint32_t __stdcall NtWriteVirtualMemory(HANDLE ProcessHandle, void* B
 extern "C" uint32_t __stdcall NtCreateThreadEx(HANDLE * pHandle, ACCESS_MASK DesiredAccess, void* pAttr, HANDLE hProc, void* pFunc, void* pArg, ULONG Flags, SIZE_T ZeroBits, SIZE_T StackSize, SIZE_T MaxStackSize, void* pAttrListOut);
 extern "C" uint32_t __stdcall NtWaitForSingleObject(HANDLE ObjectHandle, BOOLEAN Alertable, PLARGE_INTEGER TimeOut);
 extern "C" uint32_t __stdcall NtClose(HANDLE ObjectHandle);
+extern "C" uint32_t __stdcall NtGetNextThread(HANDLE ProcessHandle, HANDLE ThreadHandle, ACCESS_MASK DesiredAccess, ULONG HandleAttributes, ULONG Flags, PHANDLE NewThreadHandle);
+extern "C" uint32_t __stdcall NtSuspendThread(HANDLE ThreadHandle, PULONG PreviousSuspendCount);
+extern "C" uint32_t __stdcall NtResumeThread(HANDLE ThreadHandle, PULONG SuspendCount);
 extern "C" uint32_t __stdcall NtQueryInformationThread(HANDLE ThreadHandle, uint32_t ThreadInformationClass, PVOID ThreadInformation, ULONG ThreadInformationLength, PULONG ReturnLength);
 
 #define nmd_memset(ptr, value, num) { size_t _nmd_index = num-1; while(_nmd_index){((uint8_t*)ptr)[_nmd_index--] = value;}}
@@ -811,6 +1012,229 @@ void* nmd_read_multi_level_pointer(void* base, int32_t* offsets, size_t num_offs
     return base;
 }
 
+#endif /* _WIN32 */
+
+/* The frequency of each byte in x86 machine code(the logarithm of the number of occurrences in a compiler's code section, scaled to [0,255]).
+   Patterns are anchored at their least frequent byte, so fewer offsets are compared. */
+const uint8_t _nmd_pattern_byte_frequencies[256] = {
+    255, 214, 181, 178, 189, 180, 161, 166, 199, 163, 161, 155, 168, 154, 144, 225,
+    188, 158, 168, 163, 158, 154, 143, 134, 182, 134, 127, 127, 144, 140, 144, 197,
+    176, 140, 129, 130, 213, 139, 127, 133, 168, 173, 137, 135, 148, 138, 161, 136,
+    172, 193, 124, 124, 149, 146, 124, 133, 165, 177, 134, 148, 166, 161, 132, 134,
+    185, 209, 151, 166, 206, 189, 147, 162, 237, 196, 155, 144, 206, 173, 135, 142,
+    178, 150, 134, 169, 172, 170, 157, 163, 151, 126, 127, 166, 171, 173, 149, 147,
+    150, 119, 122, 154, 137, 141, 190, 122, 165, 123, 145, 137, 148, 132, 138, 149,
+    152, 124, 143, 150, 190, 181, 140, 150, 158, 133, 128, 146, 165, 148, 146, 154,
+    189, 168, 139, 209, 202, 204, 143, 157, 162, 227, 119, 217, 140, 198, 133, 132,
+    169, 122, 123, 152, 148, 146, 120, 128, 143, 120, 118, 118, 133, 126, 123, 128,
+    142, 120, 119, 132, 128, 121, 114, 124, 141, 119, 122, 133, 135, 121, 119, 132,
+    141, 122, 117, 127, 142, 129, 177, 138, 163, 146, 168, 142, 149, 144, 177, 165,
+    198, 176, 170, 180, 175, 163, 176, 183, 159, 168, 145, 129, 138, 140, 137, 140,
+    166, 151, 170, 152, 137, 142, 143, 139, 160, 136, 140, 156, 133, 133, 148, 173,
+    166, 153, 157, 137, 147, 142, 153, 154, 205, 196, 158, 174, 168, 162, 162, 170,
+    162, 145, 151, 158, 146, 148, 174, 167, 171, 167, 174, 162, 165, 169, 181, 234
+};
+
+bool nmd_pattern_compile(nmd_pattern* compiled, const char* pattern, const char* mask)
+{
+    const size_t length = _nmd_strlen(mask);
+    size_t i;
+
+    if (!length || length > NMD_PATTERN_MAX_LENGTH)
+        return false;
+
+    compiled->length = length;
+    compiled->source = pattern;
+    compiled->anchor = compiled->anchor2 = length;
+    for (i = 0; i < NMD_PATTERN_MAX_LENGTH; i++)
+    {
+        const bool is_byte = i < length && mask[i] != '?';
+        compiled->mask[i] = is_byte ? 0xff : 0x00;
+        compiled->bytes[i] = is_byte ? (uint8_t)pattern[i] : 0x00;
+        if (!is_byte)
+            continue;
+
+        /* Keep the two least frequent bytes */
+        if (compiled->anchor == length || _nmd_pattern_byte_frequencies[compiled->bytes[i]] < _nmd_pattern_byte_frequencies[compiled->bytes[compiled->anchor]])
+        {
+            compiled->anchor2 = compiled->anchor;
+            compiled->anchor = i;
+        }
+        else if (compiled->anchor2 == length || _nmd_pattern_byte_frequencies[compiled->bytes[i]] < _nmd_pattern_byte_frequencies[compiled->bytes[compiled->anchor2]])
+            compiled->anchor2 = i;
+    }
+
+    /* The pattern only has wildcards */
+    if (compiled->anchor == length)
+        return false;
+
+    if (compiled->anchor2 == length)
+        compiled->anchor2 = compiled->anchor;
+
+    return true;
+}
+
+/* Returns true if the pattern matches at 'address'. 'length' bytes must be readable(or the length rounded up to 16 bytes if 'NMD_MEMORY_ENABLE_SSE2' is defined and 'padded' is true). */
+bool _nmd_pattern_matches(const nmd_pattern* compiled, const uint8_t* address, bool padded)
+{
+    size_t i = 0;
+#ifdef NMD_MEMORY_ENABLE_SSE2
+    if (padded)
+    {
+        for (; i < compiled->length; i += 16)
+        {
+            const __m128i bytes = _mm_and_si128(_mm_loadu_si128((const __m128i*)(address + i)), _mm_loadu_si128((const __m128i*)(compiled->mask + i)));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_loadu_si128((const __m128i*)(compiled->bytes + i)))) != 0xffff)
+                return false;
+        }
+
+        return true;
+    }
+#else
+    (void)padded;
+#endif /* NMD_MEMORY_ENABLE_SSE2 */
+
+    for (; i < compiled->length; i++)
+    {
+        if ((address[i] & compiled->mask[i]) != compiled->bytes[i])
+            return false;
+    }
+
+    return true;
+}
+
+#ifdef NMD_MEMORY_ENABLE_SSE2
+/* Returns the index of the least significant bit set. 'mask' must not be zero. */
+size_t _nmd_pattern_bit_index(uint32_t mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (size_t)index;
+#elif defined(__GNUC__) || defined(__clang__)
+    return (size_t)__builtin_ctz(mask);
+#else
+    size_t index = 0;
+    for (; !(mask & 1); mask >>= 1)
+        index++;
+    return index;
+#endif /* _MSC_VER */
+}
+#endif /* NMD_MEMORY_ENABLE_SSE2 */
+
+uint8_t* nmd_pattern_find(const nmd_pattern* compiled, const uint8_t* start, const uint8_t* end)
+{
+    const uint8_t anchor_byte = compiled->bytes[compiled->anchor];
+    const uint8_t anchor2_byte = compiled->bytes[compiled->anchor2];
+    const uint8_t* last;
+
+    if (start >= end || (size_t)(end - start) < compiled->length)
+        return 0;
+
+    /* The last address where the pattern may start */
+    last = end - compiled->length;
+
+#ifdef NMD_MEMORY_ENABLE_SSE2
+    {
+        /* The candidates' bytes are loaded 16 bytes at a time, so the vectorized loops stop before the padded pattern may cross 'end' */
+        const size_t padded_length = (compiled->length + 15) & ~(size_t)15;
+#ifdef NMD_MEMORY_ENABLE_AVX2
+        if ((size_t)(end - start) >= padded_length + 31)
+        {
+            const __m256i anchor_bytes = _mm256_set1_epi8((char)anchor_byte);
+            const __m256i anchor2_bytes = _mm256_set1_epi8((char)anchor2_byte);
+            for (; start <= end - (padded_length + 31); start += 32)
+            {
+                const __m256i anchors = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(start + compiled->anchor)), anchor_bytes);
+                const __m256i anchors2 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(start + compiled->anchor2)), anchor2_bytes);
+                uint32_t candidates = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(anchors, anchors2));
+                for (; candidates; candidates &= candidates - 1)
+                {
+                    const uint8_t* const candidate = start + _nmd_pattern_bit_index(candidates);
+                    if (_nmd_pattern_matches(compiled, candidate, true))
+                        return (uint8_t*)candidate;
+                }
+            }
+        }
+#endif /* NMD_MEMORY_ENABLE_AVX2 */
+        if ((size_t)(end - start) >= padded_length + 15)
+        {
+            const __m128i anchor_bytes = _mm_set1_epi8((char)anchor_byte);
+            const __m128i anchor2_bytes = _mm_set1_epi8((char)anchor2_byte);
+            for (; start <= end - (padded_length + 15); start += 16)
+            {
+                const __m128i anchors = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(start + compiled->anchor)), anchor_bytes);
+                const __m128i anchors2 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(start + compiled->anchor2)), anchor2_bytes);
+                uint32_t candidates = (uint32_t)_mm_movemask_epi8(_mm_and_si128(anchors, anchors2));
+                for (; candidates; candidates &= candidates - 1)
+                {
+                    const uint8_t* const candidate = start + _nmd_pattern_bit_index(candidates);
+                    if (_nmd_pattern_matches(compiled, candidate, true))
+                        return (uint8_t*)candidate;
+                }
+            }
+        }
+    }
+#endif /* NMD_MEMORY_ENABLE_SSE2 */
+
+    /* Search for the anchor one byte at a time */
+    for (; start <= last; start++)
+    {
+        if (start[compiled->anchor] == anchor_byte && start[compiled->anchor2] == anchor2_byte && _nmd_pattern_matches(compiled, start, false))
+            return (uint8_t*)start;
+    }
+
+    return 0;
+}
+
+#ifdef _WIN32
+/* Calls 'scan' for every span of consecutive committed regions in the range whose protection matches 'protection'. Stops when 'scan' returns true. */
+void _nmd_pattern_for_each_span(uint8_t* start, uint8_t* end, uint32_t protection, bool(*scan)(void* context, uint8_t* start, uint8_t* end), void* context)
+{
+    MEMORY_BASIC_INFORMATION mbi;
+    uint8_t* span_start = start;
+    uint8_t* span_end = start;
+
+    while (span_end < end && !NtQueryVirtualMemory((void*)(-1), span_end, 0/*MemoryBasicInformation*/, &mbi, sizeof(mbi), 0))
+    {
+        uint8_t* const region_end = (uint8_t*)mbi.BaseAddress + mbi.RegionSize;
+        if (mbi.State == MEM_COMMIT && !(mbi.Protect & (PAGE_NOACCESS | PAGE_GUARD)) && (protection & mbi.Protect))
+        {
+            /* Consecutive readable regions are scanned as one span, so matches that cross a region boundary are found */
+            span_end = region_end;
+            continue;
+        }
+
+        if (span_end > span_start && scan(context, span_start, span_end < end ? span_end : end))
+            return;
+
+        span_start = span_end = region_end;
+    }
+
+    if (span_end > span_start)
+        scan(context, span_start, span_end < end ? span_end : end);
+}
+
+typedef struct _nmd_pattern_scan
+{
+    const nmd_pattern* compiled;
+    uint8_t* match;
+} _nmd_pattern_scan;
+
+bool _nmd_pattern_scan_span(void* context, uint8_t* start, uint8_t* end)
+{
+    _nmd_pattern_scan* const scan = (_nmd_pattern_scan*)context;
+    while ((scan->match = nmd_pattern_find(scan->compiled, start, end)))
+    {
+        /* The pattern and its compiled copy are never returned */
+        if (scan->match != (const uint8_t*)scan->compiled->source && scan->match != scan->compiled->bytes)
+            return true;
+        start = scan->match + 1;
+    }
+
+    return false;
+}
+
 /* Scans the specified memory range for a pattern.
 Parameters:
  - pattern    [in] The pattern. e.g. "\x10\x20\x30\x40\x50".
@@ -821,38 +1245,352 @@ Parameters:
 */
 uint8_t* nmd_pattern_scan_range(const char* pattern, const char* mask, uint8_t* start, uint8_t* end, uint32_t protection)
 {
-    MEMORY_BASIC_INFORMATION mbi;
-    const size_t mask_length = _nmd_strlen(mask);
-    size_t num_matches = 0;
-    
-    while (start < end && !NtQueryVirtualMemory((void*)(-1), start, 0/*MemoryBasicInformation*/, &mbi, sizeof(mbi), 0))
-    {        
-        if (mbi.Protect & (PAGE_NOACCESS | PAGE_GUARD) || !(protection & mbi.Protect))
+    nmd_pattern compiled;
+    _nmd_pattern_scan scan;
+
+    if (!nmd_pattern_compile(&compiled, pattern, mask))
+        return 0;
+
+    scan.compiled = &compiled;
+    scan.match = 0;
+    _nmd_pattern_for_each_span(start, end, protection, _nmd_pattern_scan_span, &scan);
+
+    return scan.match;
+}
+
+uint8_t* nmd_pattern_scan_range_ex(const nmd_pattern* compiled, uint8_t* start, uint8_t* end, uint32_t protection)
+{
+    _nmd_pattern_scan scan;
+    scan.compiled = compiled;
+    scan.match = 0;
+    _nmd_pattern_for_each_span(start, end, protection, _nmd_pattern_scan_span, &scan);
+
+    return scan.match;
+}
+
+#endif /* _WIN32 */
+
+void nmd_pattern_set_init(nmd_pattern_set* set)
+{
+    size_t i;
+    set->num_patterns = 0;
+    for (i = 0; i < 256; i++)
+        set->anchors[i] = 0;
+}
+
+int nmd_pattern_set_add(nmd_pattern_set* set, const char* pattern, const char* mask)
+{
+    nmd_pattern* compiled;
+    if (set->num_patterns >= NMD_PATTERN_SET_MAX_PATTERNS || set->num_patterns >= 64)
+        return -1;
+
+    compiled = &set->patterns[set->num_patterns];
+    if (!nmd_pattern_compile(compiled, pattern, mask))
+        return -1;
+
+    set->anchors[compiled->bytes[compiled->anchor]] |= (uint64_t)1 << set->num_patterns;
+
+    return (int)set->num_patterns++;
+}
+
+size_t nmd_pattern_set_find(const nmd_pattern_set* set, const uint8_t* start, const uint8_t* end, uint8_t** matches)
+{
+    uint64_t anchors[256];
+    size_t num_found = 0, i;
+    const uint8_t* b;
+
+    /* Only the patterns that were not found are searched */
+    for (i = 0; i < 256; i++)
+        anchors[i] = set->anchors[i];
+    for (i = 0; i < set->num_patterns; i++)
+    {
+        if (matches[i])
         {
-            start = (uint8_t*)mbi.BaseAddress + mbi.RegionSize;
-            num_matches = 0;
+            anchors[set->patterns[i].bytes[set->patterns[i].anchor]] &= ~((uint64_t)1 << i);
+            num_found++;
         }
-        else
+    }
+
+    /* Every byte is looked up in the table of anchors, the patterns anchored at that byte are compared */
+    for (b = start; b < end && num_found < set->num_patterns; b++)
+    {
+        uint64_t candidates = anchors[*b];
+        for (i = 0; candidates; candidates >>= 1, i++)
         {
-            const uint8_t* region_end = (uint8_t*)mbi.BaseAddress + mbi.RegionSize;
-            while (start < region_end)
+            const nmd_pattern* compiled;
+            const uint8_t* candidate;
+            if (!(candidates & 1))
+                continue;
+
+            compiled = &set->patterns[i];
+            if ((size_t)(b - start) < compiled->anchor || (size_t)(end - b) < compiled->length - compiled->anchor)
+                continue;
+
+            candidate = b - compiled->anchor;
+            if (candidate != compiled->bytes && candidate != (const uint8_t*)compiled->source && _nmd_pattern_matches(compiled, candidate, false))
             {
-                for (; num_matches < mask_length; num_matches++)
+                matches[i] = (uint8_t*)candidate;
+                anchors[*b] &= ~((uint64_t)1 << i);
+                num_found++;
+            }
+        }
+    }
+
+    return num_found;
+}
+
+#ifdef _WIN32
+typedef struct _nmd_pattern_set_scan
+{
+    const nmd_pattern_set* set;
+    uint8_t** matches;
+} _nmd_pattern_set_scan;
+
+bool _nmd_pattern_set_scan_span(void* context, uint8_t* start, uint8_t* end)
+{
+    _nmd_pattern_set_scan* const scan = (_nmd_pattern_set_scan*)context;
+    return nmd_pattern_set_find(scan->set, start, end, scan->matches) == scan->set->num_patterns;
+}
+
+size_t nmd_pattern_set_scan_range(const nmd_pattern_set* set, uint8_t* start, uint8_t* end, uint32_t protection, uint8_t** matches)
+{
+    _nmd_pattern_set_scan scan;
+    size_t num_found = 0, i;
+
+    for (i = 0; i < set->num_patterns; i++)
+        matches[i] = 0;
+
+    scan.set = set;
+    scan.matches = matches;
+    _nmd_pattern_for_each_span(start, end, protection, _nmd_pattern_set_scan_span, &scan);
+
+    for (i = 0; i < set->num_patterns; i++)
+        num_found += matches[i] ? 1 : 0;
+
+    return num_found;
+}
+
+
+typedef struct _nmd_pattern_scan_job
+{
+    HANDLE h_process;
+    const nmd_pattern* compiled;
+    const nmd_region* regions;
+    const size_t* first_chunks; /* 'first_chunks[i]' is the index of the first chunk of 'regions[i]', the last element is the number of chunks. */
+    size_t num_regions;
+    volatile LONG next_chunk;
+    volatile LONG num_matches;
+    uint8_t** matches;
+    size_t max_matches;
+} _nmd_pattern_scan_job;
+
+typedef struct _nmd_pattern_scan_worker
+{
+    _nmd_pattern_scan_job* job;
+    uint8_t* buffer; /* 'NMD_PATTERN_SCAN_CHUNK_SIZE + NMD_PATTERN_MAX_LENGTH' bytes. */
+} _nmd_pattern_scan_worker;
+
+/* Adds a match to the job. The matches are sorted after every worker finished. */
+void _nmd_pattern_scan_add_match(_nmd_pattern_scan_job* job, uint8_t* match)
+{
+    const LONG index = InterlockedIncrement(&job->num_matches) - 1;
+    if ((size_t)index < job->max_matches)
+        job->matches[index] = match;
+}
+
+/* Reads chunks and scans them until every chunk was taken. Chunks are read with 'length - 1' extra bytes, so matches that cross a chunk boundary are found. */
+DWORD WINAPI _nmd_pattern_scan_worker_proc(LPVOID parameter)
+{
+    _nmd_pattern_scan_worker* const worker = (_nmd_pattern_scan_worker*)parameter;
+    _nmd_pattern_scan_job* const job = worker->job;
+    size_t region = 0, chunk;
+
+    while ((chunk = (size_t)(InterlockedIncrement(&job->next_chunk) - 1)) < job->first_chunks[job->num_regions])
+    {
+        uint8_t* address;
+        size_t size, offset;
+        const uint8_t* match;
+        const uint8_t* b;
+
+        /* Chunks are taken in increasing order, so the region is found by advancing from the previous one */
+        while (chunk >= job->first_chunks[region + 1])
+            region++;
+
+        offset = (chunk - job->first_chunks[region]) * NMD_PATTERN_SCAN_CHUNK_SIZE;
+        address = job->regions[region].base + offset;
+        size = job->regions[region].size - offset;
+        if (size > NMD_PATTERN_SCAN_CHUNK_SIZE + job->compiled->length - 1)
+            size = NMD_PATTERN_SCAN_CHUNK_SIZE + job->compiled->length - 1;
+
+        /* The region may have been freed or protected after it was enumerated */
+        if (NtReadVirtualMemory(job->h_process, address, worker->buffer, (ULONG)size, 0))
+            continue;
+
+        /* Matches in the extra bytes belong to the next chunk. In the current process the pattern and its compiled copy are never returned. */
+        for (b = worker->buffer; (match = nmd_pattern_find(job->compiled, b, worker->buffer + size)) && (size_t)(match - worker->buffer) < NMD_PATTERN_SCAN_CHUNK_SIZE; b = match + 1)
+        {
+            uint8_t* const found = address + (match - worker->buffer);
+            if (job->h_process != (HANDLE)(-1) || (found != job->compiled->bytes && found != (const uint8_t*)job->compiled->source))
+                _nmd_pattern_scan_add_match(job, found);
+        }
+    }
+
+    return 0;
+}
+
+/* Sorts addresses in increasing order(heapsort, so no memory is needed). */
+void _nmd_sort_addresses(uint8_t** addresses, size_t num_addresses)
+{
+    size_t i, end;
+    for (i = num_addresses / 2; i-- > 0;)
+    {
+        size_t root = i;
+        while (root * 2 + 1 < num_addresses)
+        {
+            size_t child = root * 2 + 1;
+            uint8_t* temp;
+            if (child + 1 < num_addresses && addresses[child] < addresses[child + 1])
+                child++;
+            if (addresses[root] >= addresses[child])
+                break;
+            temp = addresses[root], addresses[root] = addresses[child], addresses[child] = temp;
+            root = child;
+        }
+    }
+
+    for (end = num_addresses; end > 1;)
+    {
+        size_t root = 0;
+        uint8_t* temp = addresses[0];
+        addresses[0] = addresses[--end], addresses[end] = temp;
+        while (root * 2 + 1 < end)
+        {
+            size_t child = root * 2 + 1;
+            if (child + 1 < end && addresses[child] < addresses[child + 1])
+                child++;
+            if (addresses[root] >= addresses[child])
+                break;
+            temp = addresses[root], addresses[root] = addresses[child], addresses[child] = temp;
+            root = child;
+        }
+    }
+}
+
+/* Same as nmd_enumerate_regions(), but skips the regions of the allocation at 'ignored'. */
+size_t _nmd_enumerate_regions(HANDLE h_process, uint8_t* start, uint8_t* end, uint32_t protection, nmd_region* regions, size_t max_regions, const void* ignored)
+{
+    MEMORY_BASIC_INFORMATION mbi;
+    size_t num_regions = 0;
+    uint8_t* address = start;
+    uint8_t* previous_end = 0;
+
+    while (address < end && !NtQueryVirtualMemory(h_process, address, 0/*MemoryBasicInformation*/, &mbi, sizeof(mbi), 0))
+    {
+        uint8_t* const region_end = (uint8_t*)mbi.BaseAddress + mbi.RegionSize;
+        if (mbi.State == MEM_COMMIT && !(mbi.Protect & (PAGE_NOACCESS | PAGE_GUARD)) && (protection & mbi.Protect) && (!ignored || mbi.AllocationBase != ignored))
+        {
+            uint8_t* const limit = region_end < end ? region_end : end;
+
+            /* Consecutive regions are merged, so matches that cross a region boundary are found */
+            if (num_regions && address == previous_end)
+            {
+                if (num_regions <= max_regions)
+                    regions[num_regions - 1].size += (size_t)(limit - address);
+            }
+            else
+            {
+                if (num_regions < max_regions)
                 {
-                    if (mask[num_matches] != '?' && ((uint8_t*)pattern)[num_matches] != start[num_matches])
-                        goto not_match;
+                    regions[num_regions].base = address;
+                    regions[num_regions].size = (size_t)(limit - address);
                 }
-
-                if (start != (uint8_t*)pattern)
-                    return start;
-            not_match:
-                num_matches = 0;
-                start++;
+                num_regions++;
             }
+
+            previous_end = limit;
         }
+
+        if (region_end <= address)
+            break;
+        address = region_end;
     }
 
-    return 0;
+    return num_regions;
+}
+
+size_t nmd_enumerate_regions(HANDLE h_process, uint8_t* start, uint8_t* end, uint32_t protection, nmd_region* regions, size_t max_regions)
+{
+    return _nmd_enumerate_regions(h_process, start, end, protection, regions, max_regions, 0);
+}
+
+size_t nmd_pattern_scan_process(HANDLE h_process, const nmd_pattern* compiled, uint8_t* start, uint8_t* end, uint32_t protection, size_t num_threads, uint8_t** matches, size_t max_matches)
+{
+    _nmd_pattern_scan_worker workers[NMD_MEMORY_MAX_THREADS];
+    HANDLE threads[NMD_MEMORY_MAX_THREADS];
+    _nmd_pattern_scan_job job;
+    void* memory = 0;
+    size_t memory_size, num_regions, num_created = 0, i;
+
+    /* The regions are counted first, so the list is allocated once */
+    if (!(num_regions = nmd_enumerate_regions(h_process, start, end, protection, 0, 0)))
+        return 0;
+
+    if (num_threads < 1)
+        num_threads = 1;
+    if (num_threads > NMD_MEMORY_MAX_THREADS)
+        num_threads = NMD_MEMORY_MAX_THREADS;
+
+    /* One allocation holds the region list, the index of the first chunk of each region and the buffers of the workers */
+    memory_size = ((num_regions * sizeof(nmd_region) + (num_regions + 1) * sizeof(size_t) + 15) & ~(size_t)15) + num_threads * (NMD_PATTERN_SCAN_CHUNK_SIZE + NMD_PATTERN_MAX_LENGTH);
+    if (NtAllocateVirtualMemory((void*)(-1), &memory, 0, &memory_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE))
+        return 0;
+
+    job.h_process = h_process;
+    job.compiled = compiled;
+    job.regions = (nmd_region*)memory;
+    job.first_chunks = (size_t*)((nmd_region*)memory + num_regions);
+    /* The allocation itself is not scanned */
+    job.num_regions = _nmd_enumerate_regions(h_process, start, end, protection, (nmd_region*)memory, num_regions, h_process == (HANDLE)(-1) ? memory : 0);
+    if (job.num_regions > num_regions)
+        job.num_regions = num_regions; /* More regions were committed after they were counted */
+    job.next_chunk = 0;
+    job.num_matches = 0;
+    job.matches = matches;
+    job.max_matches = max_matches;
+
+    /* Large regions are split in chunks of 'NMD_PATTERN_SCAN_CHUNK_SIZE' bytes */
+    ((size_t*)job.first_chunks)[0] = 0;
+    for (i = 0; i < job.num_regions; i++)
+        ((size_t*)job.first_chunks)[i + 1] = job.first_chunks[i] + (job.regions[i].size + NMD_PATTERN_SCAN_CHUNK_SIZE - 1) / NMD_PATTERN_SCAN_CHUNK_SIZE;
+
+    for (i = 0; i < num_threads; i++)
+    {
+        workers[i].job = &job;
+        workers[i].buffer = (uint8_t*)memory + ((num_regions * sizeof(nmd_region) + (num_regions + 1) * sizeof(size_t) + 15) & ~(size_t)15) + i * (NMD_PATTERN_SCAN_CHUNK_SIZE + NMD_PATTERN_MAX_LENGTH);
+    }
+
+    /* The calling thread is the first worker */
+    for (i = 1; i < num_threads; i++)
+    {
+        if (NtCreateThreadEx(&threads[num_created], THREAD_ALL_ACCESS, 0, (HANDLE)(-1), (void*)_nmd_pattern_scan_worker_proc, &workers[i], FALSE, 0, 0, 0, 0))
+            break;
+        num_created++;
+    }
+
+    _nmd_pattern_scan_worker_proc(&workers[0]);
+
+    for (i = 0; i < num_created; i++)
+    {
+        NtWaitForSingleObject(threads[i], FALSE, 0);
+        NtClose(threads[i]);
+    }
+
+    _nmd_sort_addresses(matches, (size_t)job.num_matches < max_matches ? (size_t)job.num_matches : max_matches);
+
+    memory_size = 0;
+    NtFreeVirtualMemory((void*)(-1), &memory, (PULONG)&memory_size, MEM_RELEASE);
+
+    return (size_t)job.num_matches;
 }
 
 #define _NMD_MEM_R (*b >> 4)
@@ -985,35 +1723,58 @@ void* _nmd_alloc_page_near(void* addr)
 _nmd_hook_data* _nmd_find_free_hook_data(_nmd_hook_page* hook_page, size_t size)
 {
     _nmd_hook_data* hook_data = (_nmd_hook_data*)((uint8_t*)hook_page + sizeof(_nmd_hook_page));
-    while (hook_data->type != _NMD_HOOK_DATA_TYPE_NONE || size > hook_data->size)
+
+    /* The last hook data ends at the end of the page */
+    while ((uintptr_t)hook_data & 0xfff)
     {
-        /* Check if we're parsed the whole page */
-        if (!((uintptr_t)hook_data & 0xfff))
-            return 0;
+        if (hook_data->type == _NMD_HOOK_DATA_TYPE_NONE && size <= hook_data->size)
+            return hook_data;
 
         hook_data = (_nmd_hook_data*)((uint8_t*)hook_data + sizeof(_nmd_hook_data) + hook_data->size);
     }
 
-    return hook_data;
+    return 0;
 }
 
-uint8_t* _nmd_alloc_hook_data_near(void* target, uint8_t type, size_t size)
+/* Allocates 'size' bytes from a free hook data, the remaining bytes are split into a new free hook data if they're enough for one. */
+uint8_t* _nmd_use_hook_data(_nmd_hook_data* hook_data, uint8_t type, size_t size)
 {
-    /* Allocate the first page if it does not exist */
-    if (!_nmd_first_hook_page)
+    const size_t remaining_bytes = hook_data->size - size;
+    if (remaining_bytes < 10 + sizeof(_nmd_hook_data))
+        size = hook_data->size;
+    else
     {
-        if (!(_nmd_first_hook_page = (_nmd_hook_page*)_nmd_alloc_page_near(target)))
-            return 0;
+        _nmd_hook_data* next_hook_data = (_nmd_hook_data*)((uint8_t*)hook_data + sizeof(_nmd_hook_data) + size);
+        next_hook_data->size = (uint16_t)(remaining_bytes - sizeof(_nmd_hook_data));
+        next_hook_data->type = _NMD_HOOK_DATA_TYPE_NONE;
+    }
 
-        _nmd_hook_data* hook_data = (_nmd_hook_data*)((uint8_t*)_nmd_first_hook_page + sizeof(_nmd_hook_page));
-        hook_data->size = size;
-        hook_data->type = type;
+    hook_data->size = (uint16_t)size;
+    hook_data->type = type;
+    return (uint8_t*)hook_data + sizeof(_nmd_hook_data);
+}
 
-        _nmd_hook_data* next_hook_data = (_nmd_hook_data*)((uint8_t*)hook_data + sizeof(_nmd_hook_data) + size);
-        next_hook_data->size = 0x1000 - (sizeof(_nmd_hook_page*) + sizeof(_nmd_hook_data) + size);
+/* Allocates a hook page near 'target' and allocates 'size' bytes from it. */
+uint8_t* _nmd_alloc_hook_page(_nmd_hook_page** hook_page, void* target, uint8_t type, size_t size)
+{
+    if (!(*hook_page = (_nmd_hook_page*)_nmd_alloc_page_near(target)))
+        return 0;
 
-        return (uint8_t*)hook_data + sizeof(_nmd_hook_data);
-    }
+    (*hook_page)->next = 0;
+
+    /* The whole page is a single free hook data */
+    _nmd_hook_data* hook_data = (_nmd_hook_data*)((uint8_t*)*hook_page + sizeof(_nmd_hook_page));
+    hook_data->size = (uint16_t)(0x1000 - (sizeof(_nmd_hook_page) + sizeof(_nmd_hook_data)));
+    hook_data->type = _NMD_HOOK_DATA_TYPE_NONE;
+
+    return _nmd_use_hook_data(hook_data, type, size);
+}
+
+uint8_t* _nmd_alloc_hook_data_near(void* target, uint8_t type, size_t size)
+{
+    /* Allocate the first page if it does not exist */
+    if (!_nmd_first_hook_page)
+        return _nmd_alloc_hook_page(&_nmd_first_hook_page, target, type, size);
 
     /* Parse existing hook pages */
     _nmd_hook_page* hook_page = _nmd_first_hook_page;
@@ -1024,38 +1785,12 @@ uint8_t* _nmd_alloc_hook_data_near(void* target, uint8_t type, size_t size)
         {
             _nmd_hook_data* hook_data = _nmd_find_free_hook_data(hook_page, size);
             if (hook_data)
-            {
-                uint32_t remaining_bytes = ((0x1000 - (((uintptr_t)hook_data + sizeof(_nmd_hook_data) + size) & 0xfff)) % 0x1000);
-
-                if (remaining_bytes < 10 + sizeof(_nmd_hook_data))
-                    size += remaining_bytes;
-                else
-                {
-                    _nmd_hook_data* next_hook_data = (_nmd_hook_data*)((uint8_t*)hook_data + sizeof(_nmd_hook_data) + size);
-                    next_hook_data->size = remaining_bytes - sizeof(_nmd_hook_data);
-                }
-
-                hook_data->size = size;
-
-                hook_data->type = type;
-                return (uint8_t*)hook_data + sizeof(_nmd_hook_data);
-            }
+                return _nmd_use_hook_data(hook_data, type, size);
         }
 
         /* Allocate a new hook page if this was the last one */
         if (!hook_page->next)
-        {
-            if ((hook_page->next = (_nmd_hook_page*)_nmd_alloc_page_near(target)))
-                return 0;
-            _nmd_hook_data* hook_data = (_nmd_hook_data*)((uint8_t*)hook_page->next + sizeof(_nmd_hook_page));
-            hook_data->size = size;
-            hook_data->type = type;
-
-            _nmd_hook_data* next_hook_data = (_nmd_hook_data*)((uint8_t*)hook_data + sizeof(_nmd_hook_data) + size);
-            next_hook_data->size = 0x1000 - (sizeof(_nmd_hook_page*) + sizeof(_nmd_hook_data) + size);
-            
-            return (uint8_t*)hook_data + sizeof(_nmd_hook_data);
-        }
+            return _nmd_alloc_hook_page(&hook_page->next, target, type, size);
 
         /* Go to the next hook page */
         hook_page = hook_page->next;
@@ -1072,31 +1807,40 @@ uint8_t* _nmd_alloc_absolute_jump(void* target)
     return _nmd_alloc_hook_data_near(target, _NMD_HOOK_DATA_TYPE_ABSOLUTE_JUMP, 12);
 }
 
-/*
-Hooks a function. Returns true if successful, false otherwise.
-Parameters:
- - target   [in]      The function to be hooked.
- - detour   [in]      The function to override the 'target'.
- - original [out/opt] An optional pointer to a variable that recieves the address of the original function.
- */
-bool nmd_hook(void* target, void* detour, void* original)
+typedef struct _nmd_hook_batch_item
+{
+    uint8_t* trampoline;
+    uint8_t* absolute_jump; /* Only used on x86-64 when the detour is too far from the target. */
+    size_t num_copy_bytes;
+    uint8_t patch[5]; /* The near jump that is written at the target. */
+} _nmd_hook_batch_item;
+
+/* Frees hook data allocated by _nmd_alloc_hook_data_near(). */
+void _nmd_free_hook_data(uint8_t* data)
 {
-    const ptrdiff_t delta = (uintptr_t)detour - ((uintptr_t)target + 5);
+    ((_nmd_hook_data*)(data - sizeof(_nmd_hook_data)))->type = _NMD_HOOK_DATA_TYPE_NONE;
+}
+
+/* Builds the trampoline of a hook and the jump that is written at the target, but does not modify the target. Returns true if successful, false otherwise. */
+bool _nmd_hook_prepare(void* target, void* detour, _nmd_hook_batch_item* item)
+{
+    uintptr_t destination = (uintptr_t)detour;
 
     /* Calculate the number of bytes to be copied to the trampoline */
-    size_t num_copy_bytes = 0;
+    item->num_copy_bytes = 0;
 #ifdef _WIN64
-    while(num_copy_bytes < 5)
-        num_copy_bytes += _nmd_mem_ldisasm((uint8_t*)target + num_copy_bytes, true);
+    while (item->num_copy_bytes < 5)
+        item->num_copy_bytes += _nmd_mem_ldisasm((uint8_t*)target + item->num_copy_bytes, true);
 #else
-    while (num_copy_bytes < 5)
-        num_copy_bytes += _nmd_mem_ldisasm((uint8_t*)target + num_copy_bytes, false);
+    while (item->num_copy_bytes < 5)
+        item->num_copy_bytes += _nmd_mem_ldisasm((uint8_t*)target + item->num_copy_bytes, false);
 #endif
 
-    uint8_t* trampoline = _nmd_alloc_trampoline(target, num_copy_bytes);
-    if (!trampoline)
+    item->absolute_jump = 0;
+    if (!(item->trampoline = _nmd_alloc_trampoline(target, item->num_copy_bytes)))
         return false;
-    
+
+    uint8_t* trampoline = item->trampoline;
     if (*(uint8_t*)target == 0xe9)
     {
         trampoline[0] = 0xe9;
@@ -1106,56 +1850,307 @@ bool nmd_hook(void* target, void* detour, void* original)
     {
         /* Copy original instructions */
         size_t i = 0;
-        for (; i < num_copy_bytes; i++)
+        for (; i < item->num_copy_bytes; i++)
             trampoline[i] = ((uint8_t*)target)[i];
     }
-    
-    /* Place near jump back to the original function */
-    trampoline[num_copy_bytes] = 0xE9;
-    *((int32_t*)(trampoline + num_copy_bytes + 1)) = (int32_t)(((uintptr_t)target + num_copy_bytes) - (uintptr_t)(trampoline + num_copy_bytes + 5));
-
-    /* Set 'original' */
-    if (original)
-        *(uint8_t**)original = trampoline;
 
-    uint32_t old_protection;
-    void* base_addr = target;
-    if (NtProtectVirtualMemory((void*)(-1), &base_addr, (uint32_t*)&num_copy_bytes, PAGE_EXECUTE_READWRITE, &old_protection))
-        return false;
+    /* Place near jump back to the original function */
+    trampoline[item->num_copy_bytes] = 0xE9;
+    *((int32_t*)(trampoline + item->num_copy_bytes + 1)) = (int32_t)(((uintptr_t)target + item->num_copy_bytes) - (uintptr_t)(trampoline + item->num_copy_bytes + 5));
 
 #ifdef _WIN64
     /* Check if 'target' and 'detour' are too far from each other */
+    const ptrdiff_t delta = destination - ((uintptr_t)target + 5);
     if (delta < -(ptrdiff_t)0x80000000 || delta > (ptrdiff_t)0x7fffffff)
     {
-        uint8_t* absolute_jump = _nmd_alloc_absolute_jump(target);
-        if (!absolute_jump)
+        if (!(item->absolute_jump = _nmd_alloc_absolute_jump(target)))
+        {
+            _nmd_free_hook_data(item->trampoline);
             return false;
+        }
 
         /* Absolute jump to 'detour' */
-        *(uint16_t*)(absolute_jump + 0) = 0xB848;
-        *(uint64_t*)(absolute_jump + 2) = (uint64_t)detour;
-        *(uint16_t*)(absolute_jump + 10) = 0xE0FF;
+        *(uint16_t*)(item->absolute_jump + 0) = 0xB848;
+        *(uint64_t*)(item->absolute_jump + 2) = (uint64_t)detour;
+        *(uint16_t*)(item->absolute_jump + 10) = 0xE0FF;
 
-        /* Near jump to the absolute jump */
-        *(uint8_t*)target = 0xE9;
-        *((int32_t*)((uint8_t*)target + 1)) = (int32_t)((uintptr_t)absolute_jump - ((uintptr_t)target + 5));
+        /* The target jumps to the absolute jump */
+        destination = (uintptr_t)item->absolute_jump;
     }
-    else
 #endif
+
+    item->patch[0] = 0xE9;
+    *(int32_t*)(item->patch + 1) = (int32_t)(destination - ((uintptr_t)target + 5));
+
+    return true;
+}
+
+/* Frees the trampoline and the absolute jump of a hook that was prepared but not installed. */
+void _nmd_hook_cancel(_nmd_hook_batch_item* item)
+{
+    _nmd_free_hook_data(item->trampoline);
+    if (item->absolute_jump)
+        _nmd_free_hook_data(item->absolute_jump);
+}
+
+/* Resumes and closes threads suspended by _nmd_suspend_threads(). */
+void _nmd_resume_threads(HANDLE* threads, size_t num_threads)
+{
+    size_t i = 0;
+    for (; i < num_threads; i++)
+    {
+        NtResumeThread(threads[i], 0);
+        NtClose(threads[i]);
+    }
+}
+
+/* Suspends every thread of the current process except the calling one. Returns the number of threads suspended, or '(size_t)-1' if there're more than
+'max_threads'(in which case no thread is left suspended). */
+size_t _nmd_suspend_threads(HANDLE* threads, size_t max_threads)
+{
+    const HANDLE current_thread_id = (HANDLE)(uintptr_t)GetCurrentThreadId();
+    HANDLE h_thread = 0, h_next_thread;
+    size_t num_threads = 0;
+    bool suspended = false;
+
+    while (!NtGetNextThread((HANDLE)(-1), h_thread, THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_SET_CONTEXT | THREAD_QUERY_INFORMATION, 0, 0, &h_next_thread))
+    {
+        /* The handles of suspended threads are kept until they're resumed */
+        if (h_thread && !suspended)
+            NtClose(h_thread);
+        h_thread = h_next_thread;
+        suspended = false;
+
+        /* Threads whose id can't be queried are not suspended, they may be the calling thread */
+        NMD_THREAD_BASIC_INFORMATION tbi;
+        if (NtQueryInformationThread(h_thread, 0/*ThreadBasicInformation*/, &tbi, sizeof(tbi), 0) || tbi.ClientId.UniqueThread == current_thread_id)
+            continue;
+
+        if (num_threads == max_threads)
+        {
+            NtClose(h_thread);
+            _nmd_resume_threads(threads, num_threads);
+            return (size_t)-1;
+        }
+
+        if (!NtSuspendThread(h_thread, 0))
+        {
+            threads[num_threads++] = h_thread;
+            suspended = true;
+        }
+    }
+
+    if (h_thread && !suspended)
+        NtClose(h_thread);
+
+    return num_threads;
+}
+
+/* Moves the instruction pointer of a suspended thread that is inside the bytes of a target that are about to be overwritten to the same instruction in the trampoline. */
+void _nmd_hook_move_thread(HANDLE h_thread, const nmd_hook_entry* hooks, const _nmd_hook_batch_item* items, size_t num_hooks)
+{
+    CONTEXT context;
+    context.ContextFlags = CONTEXT_CONTROL;
+    if (!GetThreadContext(h_thread, &context))
+        return;
+
+#ifdef _WIN64
+    const uintptr_t ip = (uintptr_t)context.Rip;
+#else
+    const uintptr_t ip = (uintptr_t)context.Eip;
+#endif
+
+    size_t i = 0;
+    for (; i < num_hooks; i++)
     {
-        /* Near jump to 'detour' */
-        *(uint8_t*)target = 0xE9;
-        *((int32_t*)((uint8_t*)target + 1)) = (int32_t)delta;
+        /* A thread at the target's first byte executes the new jump, so it's not moved */
+        const uintptr_t offset = ip - (uintptr_t)hooks[i].target;
+        if (offset > 0 && offset < items[i].num_copy_bytes)
+        {
+#ifdef _WIN64
+            context.Rip = (uintptr_t)items[i].trampoline + offset;
+#else
+            context.Eip = (uintptr_t)items[i].trampoline + offset;
+#endif
+            SetThreadContext(h_thread, &context);
+            return;
+        }
+    }
+}
+
+/*
+Hooks a function. Returns true if successful, false otherwise.
+Parameters:
+ - target   [in]      The function to be hooked.
+ - detour   [in]      The function to override the 'target'.
+ - original [out/opt] An optional pointer to a variable that recieves the address of the original function. It's set before 'target' is patched, and left unchanged on failure.
+ */
+bool nmd_hook(void* target, void* detour, void* original)
+{
+    _nmd_hook_batch_item item;
+    if (!_nmd_hook_prepare(target, detour, &item))
+        return false;
+
+    /* Set 'original' before the jump is written, a thread may enter the detour as soon as it is */
+    uint8_t* const previous_original = original ? *(uint8_t**)original : 0;
+    if (original)
+        *(uint8_t**)original = item.trampoline;
+
+    uint32_t old_protection;
+    void* base_addr = target;
+    size_t size = sizeof(item.patch);
+    if (NtProtectVirtualMemory((void*)(-1), &base_addr, (uint32_t*)&size, PAGE_EXECUTE_READWRITE, &old_protection))
+    {
+        if (original)
+            *(uint8_t**)original = previous_original;
+        _nmd_hook_cancel(&item);
+        return false;
     }
 
+    /* Near jump to 'detour' or to the absolute jump */
+    size_t i = 0;
+    for (; i < sizeof(item.patch); i++)
+        ((uint8_t*)target)[i] = item.patch[i];
+
     /* Restore protection */
     base_addr = target;
-    NtProtectVirtualMemory((void*)(-1), &base_addr, (uint32_t*)&num_copy_bytes, old_protection, &old_protection);
+    size = sizeof(item.patch);
+    NtProtectVirtualMemory((void*)(-1), &base_addr, (uint32_t*)&size, old_protection, &old_protection);
     FlushInstructionCache((HANDLE)(-1), target, 5);
 
     return true;
 }
 
+/*
+Installs several hooks at once. Returns true if every hook was installed, false otherwise(in which case no target was modified).
+The 'original' variables are set before the first target is patched, and they are restored if the function fails.
+Each page that contains a target is made writable once, and the instruction cache is flushed once after all targets are patched.
+The targets must not overlap.
+Parameters:
+ - hooks     [in] A pointer to an array of 'num_hooks' elements that describes the hooks.
+ - num_hooks [in] The number of elements of 'hooks'.
+ - flags     [in] A mask of flags(members of the NMD_HOOK_BATCH_FLAGS enum) which change the behaviour of the function.
+ */
+bool nmd_hook_batch(const nmd_hook_entry* hooks, size_t num_hooks, uint32_t flags)
+{
+    const size_t max_threads = (flags & NMD_HOOK_BATCH_FLAGS_SUSPEND_THREADS) ? NMD_HOOK_BATCH_MAX_THREADS : 0;
+    size_t num_prepared = 0, num_pages = 0, num_protected = 0, num_threads = 0, i, j;
+    uintptr_t flush_start = (uintptr_t)-1, flush_end = 0;
+    bool success = false;
+
+    if (!num_hooks)
+        return true;
+
+    /* One allocation holds the state of each hook, the pages they patch(a target may cross a page boundary), the previous values of the 'original' variables,
+       the suspended threads and the old protection of each page */
+    void* memory = 0;
+    size_t memory_size = num_hooks * (sizeof(_nmd_hook_batch_item) + 3 * sizeof(uint8_t*) + 2 * sizeof(uint32_t)) + max_threads * sizeof(HANDLE);
+    if (NtAllocateVirtualMemory((void*)(-1), &memory, 0, &memory_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE))
+        return false;
+
+    _nmd_hook_batch_item* const items = (_nmd_hook_batch_item*)memory;
+    uint8_t** const pages = (uint8_t**)(items + num_hooks);
+    uint8_t** const previous_originals = pages + 2 * num_hooks;
+    HANDLE* const threads = (HANDLE*)(previous_originals + num_hooks);
+    uint32_t* const protections = (uint32_t*)(threads + max_threads);
+
+    /* Build every trampoline before any target is modified */
+    for (; num_prepared < num_hooks; num_prepared++)
+    {
+        uint8_t* const target = (uint8_t*)hooks[num_prepared].target;
+        if (!_nmd_hook_prepare(target, hooks[num_prepared].detour, &items[num_prepared]))
+            break;
+
+        pages[num_pages++] = (uint8_t*)((uintptr_t)target & ~(uintptr_t)0xfff);
+        pages[num_pages++] = (uint8_t*)(((uintptr_t)target + sizeof(items->patch) - 1) & ~(uintptr_t)0xfff);
+
+        if ((uintptr_t)target < flush_start)
+            flush_start = (uintptr_t)target;
+        if ((uintptr_t)target + sizeof(items->patch) > flush_end)
+            flush_end = (uintptr_t)target + sizeof(items->patch);
+    }
+
+    if (num_prepared == num_hooks)
+    {
+        /* Remove duplicated pages, so each page is protected once */
+        _nmd_sort_addresses(pages, num_pages);
+        for (i = 0, j = 0; i < num_pages; i++)
+        {
+            if (!j || pages[i] != pages[j - 1])
+                pages[j++] = pages[i];
+        }
+        num_pages = j;
+
+        /* Set the 'original' variables before any jump is written, a thread may enter a detour as soon as its jump is */
+        for (i = 0; i < num_hooks; i++)
+        {
+            if (hooks[i].original)
+            {
+                previous_originals[i] = *(uint8_t**)hooks[i].original;
+                *(uint8_t**)hooks[i].original = items[i].trampoline;
+            }
+        }
+
+        if (!max_threads || (num_threads = _nmd_suspend_threads(threads, max_threads)) != (size_t)-1)
+        {
+            for (; num_protected < num_pages; num_protected++)
+            {
+                void* base_addr = pages[num_protected];
+                size_t size = 0x1000;
+                if (NtProtectVirtualMemory((void*)(-1), &base_addr, (uint32_t*)&size, PAGE_EXECUTE_READWRITE, &protections[num_protected]))
+                    break;
+            }
+
+            if (num_protected == num_pages)
+            {
+                for (i = 0; i < num_threads; i++)
+                    _nmd_hook_move_thread(threads[i], hooks, items, num_hooks);
+
+                /* Near jumps to the detours or to the absolute jumps */
+                for (i = 0; i < num_hooks; i++)
+                {
+                    for (j = 0; j < sizeof(items->patch); j++)
+                        ((uint8_t*)hooks[i].target)[j] = items[i].patch[j];
+                }
+
+                success = true;
+            }
+
+            /* Restore protection */
+            for (i = 0; i < num_protected; i++)
+            {
+                void* base_addr = pages[i];
+                size_t size = 0x1000;
+                uint32_t old_protection;
+                NtProtectVirtualMemory((void*)(-1), &base_addr, (uint32_t*)&size, protections[i], &old_protection);
+            }
+
+            if (success)
+                FlushInstructionCache((HANDLE)(-1), (void*)flush_start, flush_end - flush_start);
+
+            _nmd_resume_threads(threads, num_threads);
+        }
+
+        /* No target was modified, restore the 'original' variables in reverse order in case several hooks share one */
+        for (i = num_hooks; !success && i > 0; i--)
+        {
+            if (hooks[i - 1].original)
+                *(uint8_t**)hooks[i - 1].original = previous_originals[i - 1];
+        }
+    }
+
+    if (!success)
+    {
+        for (i = 0; i < num_prepared; i++)
+            _nmd_hook_cancel(&items[i]);
+    }
+
+    memory_size = 0;
+    NtFreeVirtualMemory((void*)(-1), &memory, (PULONG)&memory_size, MEM_RELEASE);
+
+    return success;
+}
+
 bool _nmd_unhook_page(void* target, _nmd_hook_page* hook_page)
 {
     _nmd_hook_data* hook_data = (_nmd_hook_data*)((uint8_t*)hook_page + sizeof(_nmd_hook_page));
@@ -1426,6 +2421,7 @@ _NMD_NAKED int64_t nmd_call_x86(size_t id, ...)
 {
 
 }
+#endif /* _WIN32 */
 
 #endif /* NMD_MEMORY_IMPLEMENTATION */
 
@@ -0,0 +1,529 @@
+/*
+Benchmark of nmd_assembly.h. Measures the throughput of the decoder(for several combinations of 'NMD_X86_DECODER_FLAGS_XXX'), the length disassembler,
+the formatter(for several combinations of 'NMD_X86_FORMAT_FLAGS_XXX'), the assembler and the encoder, and writes the results in JSON.
+
+Corpora:
+ - 'random32' and 'random64': pseudo-random bytes(the same bytes on every run).
+ - 'mixed64': a code section built from the checked-in instructions in 'assembly_benchmark_corpus.h'(legacy, VEX and EVEX instructions in compiler-like proportions).
+ - Every file passed in the command line(e.g. a code section extracted with 'objcopy -O binary --only-section=.text /usr/bin/gcc text.bin').
+
+Usage: assembly_benchmark [--json output.json] [--time seconds] [--compare baseline.json] [--threshold percent] [--mode 16|32|64] [file...]
+ - '--json'      writes the results to a file instead of stdout.
+ - '--time'      is the minimum duration of each measurement(0.25 seconds by default).
+ - '--compare'   compares the results with the results of a previous run. The exit code is 2 if any result is slower by more than '--threshold' percent(10 by default).
+ - '--mode'      is the architecture mode of the files that follow(64 by default).
+
+Build: gcc -std=c89 -O2 tests/assembly_benchmark.c -o assembly_benchmark
+*/
+#define NMD_ASSEMBLY_IMPLEMENTATION
+#include "../nmd_assembly.h"
+#include "assembly_benchmark_corpus.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCHMARK_MAX_CORPORA 16
+#define BENCHMARK_MAX_RESULTS 512
+#define BENCHMARK_SYNTHETIC_CORPUS_SIZE (1024 * 1024)
+#define BENCHMARK_MAX_FORMATTED_INSTRUCTIONS 65536
+#define BENCHMARK_MAX_ASSEMBLED_INSTRUCTIONS 8192
+
+typedef struct benchmark_corpus
+{
+	char name[64];
+	uint8_t* buffer;
+	size_t size;
+	NMD_X86_MODE mode;
+} benchmark_corpus;
+
+typedef struct benchmark_result
+{
+	char name[160];
+	const char* function;
+	const char* corpus;
+	uint32_t flags;
+	double instructions;
+	double bytes;
+	double seconds;
+} benchmark_result;
+
+typedef struct benchmark_flag
+{
+	const char* name;
+	uint32_t flag;
+} benchmark_flag;
+
+static const benchmark_flag decoder_flags[] = {
+	{ "VALIDITY_CHECK", NMD_X86_DECODER_FLAGS_VALIDITY_CHECK },
+	{ "INSTRUCTION_ID", NMD_X86_DECODER_FLAGS_INSTRUCTION_ID },
+	{ "CPU_FLAGS",      NMD_X86_DECODER_FLAGS_CPU_FLAGS },
+	{ "OPERANDS",       NMD_X86_DECODER_FLAGS_OPERANDS },
+	{ "GROUP",          NMD_X86_DECODER_FLAGS_GROUP },
+	{ "VEX",            NMD_X86_DECODER_FLAGS_VEX },
+	{ "EVEX",           NMD_X86_DECODER_FLAGS_EVEX },
+	{ "3DNOW",          NMD_X86_DECODER_FLAGS_3DNOW },
+	{ "REGISTERS",      NMD_X86_DECODER_FLAGS_REGISTERS }
+};
+
+static const benchmark_flag format_flags[] = {
+	{ "HEX",                       NMD_X86_FORMAT_FLAGS_HEX },
+	{ "POINTER_SIZE",              NMD_X86_FORMAT_FLAGS_POINTER_SIZE },
+	{ "ONLY_SEGMENT_OVERRIDE",     NMD_X86_FORMAT_FLAGS_ONLY_SEGMENT_OVERRIDE },
+	{ "COMMA_SPACES",              NMD_X86_FORMAT_FLAGS_COMMA_SPACES },
+	{ "OPERATOR_SPACES",           NMD_X86_FORMAT_FLAGS_OPERATOR_SPACES },
+	{ "UPPERCASE",                 NMD_X86_FORMAT_FLAGS_UPPERCASE },
+	{ "0X_PREFIX",                 NMD_X86_FORMAT_FLAGS_0X_PREFIX },
+	{ "H_SUFFIX",                  NMD_X86_FORMAT_FLAGS_H_SUFFIX },
+	{ "ENFORCE_HEX_ID",            NMD_X86_FORMAT_FLAGS_ENFORCE_HEX_ID },
+	{ "HEX_LOWERCASE",             NMD_X86_FORMAT_FLAGS_HEX_LOWERCASE },
+	{ "SIGNED_NUMBER_MEMORY_VIEW", NMD_X86_FORMAT_FLAGS_SIGNED_NUMBER_MEMORY_VIEW },
+	{ "SIGNED_NUMBER_HINT_HEX",    NMD_X86_FORMAT_FLAGS_SIGNED_NUMBER_HINT_HEX },
+	{ "SIGNED_NUMBER_HINT_DEC",    NMD_X86_FORMAT_FLAGS_SIGNED_NUMBER_HINT_DEC },
+	{ "SCALE_ONE",                 NMD_X86_FORMAT_FLAGS_SCALE_ONE },
+	{ "BYTES",                     NMD_X86_FORMAT_FLAGS_BYTES },
+	{ "ATT_SYNTAX",                NMD_X86_FORMAT_FLAGS_ATT_SYNTAX }
+};
+
+static benchmark_corpus corpora[BENCHMARK_MAX_CORPORA];
+static size_t num_corpora = 0;
+static benchmark_result results[BENCHMARK_MAX_RESULTS];
+static size_t num_results = 0;
+static double min_seconds = 0.25;
+static volatile size_t sink; /* Keeps the compiler from removing the measured code */
+
+static nmd_x86_instruction formatted_instructions[BENCHMARK_MAX_FORMATTED_INSTRUCTIONS];
+static nmd_x86_instruction assembled_instructions[BENCHMARK_MAX_ASSEMBLED_INSTRUCTIONS];
+static char assembled_strings[BENCHMARK_MAX_ASSEMBLED_INSTRUCTIONS][NMD_X86_FORMATTER_MAX_LENGTH];
+
+/* xorshift32, so the synthetic corpora are the same on every platform. */
+static uint32_t benchmark_random(uint32_t* state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+static benchmark_corpus* add_corpus(const char* name, size_t size, NMD_X86_MODE mode)
+{
+	benchmark_corpus* corpus;
+	if (num_corpora == BENCHMARK_MAX_CORPORA)
+		return 0;
+
+	corpus = &corpora[num_corpora];
+	if (!(corpus->buffer = (uint8_t*)malloc(size ? size : 1)))
+		return 0;
+
+	sprintf(corpus->name, "%.63s", name);
+	corpus->size = size;
+	corpus->mode = mode;
+	num_corpora++;
+	return corpus;
+}
+
+static void add_synthetic_corpora(void)
+{
+	benchmark_corpus* corpus;
+	uint32_t state = 0x2545f491;
+	size_t i, j;
+
+	if ((corpus = add_corpus("random32", BENCHMARK_SYNTHETIC_CORPUS_SIZE, NMD_X86_MODE_32)))
+	{
+		for (i = 0; i < corpus->size; i++)
+			corpus->buffer[i] = (uint8_t)benchmark_random(&state);
+	}
+
+	if ((corpus = add_corpus("random64", BENCHMARK_SYNTHETIC_CORPUS_SIZE, NMD_X86_MODE_64)))
+	{
+		for (i = 0; i < corpus->size; i++)
+			corpus->buffer[i] = (uint8_t)benchmark_random(&state);
+	}
+
+	/* Instructions are picked at random from the checked-in corpus, respecting their weights */
+	if ((corpus = add_corpus("mixed64", BENCHMARK_SYNTHETIC_CORPUS_SIZE, NMD_X86_MODE_64)))
+	{
+		size_t total_weight = 0;
+		for (i = 0; i < sizeof(benchmark_corpus_instructions) / sizeof(*benchmark_corpus_instructions); i++)
+			total_weight += benchmark_corpus_instructions[i].weight;
+
+		for (i = 0; ;)
+		{
+			const benchmark_corpus_instruction* instruction = benchmark_corpus_instructions;
+			size_t weight = benchmark_random(&state) % total_weight;
+			for (; weight >= instruction->weight; instruction++)
+				weight -= instruction->weight;
+
+			if (i + instruction->length > corpus->size)
+				break;
+
+			for (j = 0; j < instruction->length; j++)
+				corpus->buffer[i++] = instruction->bytes[j];
+		}
+		corpus->size = i;
+	}
+}
+
+static int add_file_corpus(const char* path, NMD_X86_MODE mode)
+{
+	benchmark_corpus* corpus;
+	const char* name = path;
+	FILE* file;
+	long size;
+
+	if (!(file = fopen(path, "rb")))
+		return 0;
+
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	/* The name of the corpus is the file's name */
+	if (strrchr(name, '/'))
+		name = strrchr(name, '/') + 1;
+	if (strrchr(name, '\\'))
+		name = strrchr(name, '\\') + 1;
+
+	if (size < 0 || !(corpus = add_corpus(name, (size_t)size, mode)) || fread(corpus->buffer, 1, (size_t)size, file) != (size_t)size)
+	{
+		fclose(file);
+		return 0;
+	}
+
+	fclose(file);
+	return 1;
+}
+
+static double get_seconds(void)
+{
+	return (double)clock() / CLOCKS_PER_SEC;
+}
+
+static benchmark_result* add_result(const char* function, const char* short_function, const benchmark_corpus* corpus, const char* flags_name, uint32_t flags)
+{
+	benchmark_result* result;
+	if (num_results == BENCHMARK_MAX_RESULTS)
+		return 0;
+
+	result = &results[num_results++];
+	sprintf(result->name, "%s/%s%s%.80s", short_function, corpus->name, flags_name ? "/" : "", flags_name ? flags_name : "");
+	result->function = function;
+	result->corpus = corpus->name;
+	result->flags = flags;
+	result->instructions = 0;
+	result->bytes = 0;
+	result->seconds = 0;
+	return result;
+}
+
+static void benchmark_decoder(const benchmark_corpus* corpus, const char* flags_name, uint32_t flags)
+{
+	benchmark_result* result = add_result("nmd_x86_decode", "decode", corpus, flags_name, flags);
+	nmd_x86_instruction instruction;
+	double start = get_seconds();
+	size_t offset, num_instructions;
+
+	if (!result)
+		return;
+
+	do
+	{
+		for (offset = 0, num_instructions = 0; offset < corpus->size;)
+		{
+			if (nmd_x86_decode(corpus->buffer + offset, corpus->size - offset, &instruction, corpus->mode, flags))
+			{
+				offset += instruction.length;
+				num_instructions++;
+			}
+			else
+				offset++;
+		}
+
+		result->instructions += (double)num_instructions;
+		result->bytes += (double)corpus->size;
+	} while ((result->seconds = get_seconds() - start) < min_seconds);
+}
+
+static void benchmark_ldisasm(const benchmark_corpus* corpus)
+{
+	benchmark_result* result = add_result("nmd_x86_ldisasm", "ldisasm", corpus, 0, 0);
+	double start = get_seconds();
+	size_t offset, length, num_instructions;
+
+	if (!result)
+		return;
+
+	do
+	{
+		for (offset = 0, num_instructions = 0; offset < corpus->size;)
+		{
+			if ((length = nmd_x86_ldisasm(corpus->buffer + offset, corpus->size - offset, corpus->mode)))
+			{
+				offset += length;
+				num_instructions++;
+			}
+			else
+				offset++;
+		}
+
+		result->instructions += (double)num_instructions;
+		result->bytes += (double)corpus->size;
+	} while ((result->seconds = get_seconds() - start) < min_seconds);
+}
+
+/* Formats the instructions decoded from the corpus, so only the formatter is measured. */
+static void benchmark_formatter(const benchmark_corpus* corpus, size_t num_instructions, size_t num_bytes, const char* flags_name, uint32_t flags)
+{
+	benchmark_result* result = add_result("nmd_x86_format", "format", corpus, flags_name, flags);
+	char buffer[NMD_X86_FORMATTER_MAX_LENGTH];
+	double start = get_seconds();
+	size_t i;
+
+	if (!result)
+		return;
+
+	do
+	{
+		for (i = 0; i < num_instructions; i++)
+		{
+			nmd_x86_format(&formatted_instructions[i], buffer, 0x401000, flags);
+			sink += (size_t)buffer[0];
+		}
+
+		result->instructions += (double)num_instructions;
+		result->bytes += (double)num_bytes;
+	} while ((result->seconds = get_seconds() - start) < min_seconds);
+}
+
+/* Assembles the formatted instructions the assembler supports, and encodes the same instructions with nmd_x86_encode(). */
+static void benchmark_assembler(const benchmark_corpus* corpus)
+{
+	benchmark_result* result;
+	nmd_x86_instruction instruction;
+	uint8_t buffer[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH];
+	size_t offset, i, num_instructions = 0, num_bytes = 0;
+	double start;
+
+	for (offset = 0; offset < corpus->size && num_instructions < BENCHMARK_MAX_ASSEMBLED_INSTRUCTIONS;)
+	{
+		if (!nmd_x86_decode(corpus->buffer + offset, corpus->size - offset, &instruction, corpus->mode, NMD_X86_DECODER_FLAGS_ALL))
+		{
+			offset++;
+			continue;
+		}
+
+		nmd_x86_format(&instruction, assembled_strings[num_instructions], NMD_X86_INVALID_RUNTIME_ADDRESS, NMD_X86_FORMAT_FLAGS_DEFAULT);
+		if (nmd_x86_assemble(assembled_strings[num_instructions], buffer, sizeof(buffer), NMD_X86_INVALID_RUNTIME_ADDRESS, corpus->mode, 0) && nmd_x86_encode(&instruction, buffer, sizeof(buffer)))
+		{
+			assembled_instructions[num_instructions++] = instruction;
+			num_bytes += instruction.length;
+		}
+
+		offset += instruction.length;
+	}
+
+	if (!num_instructions)
+		return;
+
+	if ((result = add_result("nmd_x86_assemble", "assemble", corpus, 0, 0)))
+	{
+		start = get_seconds();
+		do
+		{
+			for (i = 0; i < num_instructions; i++)
+				sink += nmd_x86_assemble(assembled_strings[i], buffer, sizeof(buffer), NMD_X86_INVALID_RUNTIME_ADDRESS, corpus->mode, 0);
+
+			result->instructions += (double)num_instructions;
+			result->bytes += (double)num_bytes;
+		} while ((result->seconds = get_seconds() - start) < min_seconds);
+	}
+
+	if ((result = add_result("nmd_x86_encode", "encode", corpus, 0, 0)))
+	{
+		start = get_seconds();
+		do
+		{
+			for (i = 0; i < num_instructions; i++)
+				sink += nmd_x86_encode(&assembled_instructions[i], buffer, sizeof(buffer));
+
+			result->instructions += (double)num_instructions;
+			result->bytes += (double)num_bytes;
+		} while ((result->seconds = get_seconds() - start) < min_seconds);
+	}
+}
+
+static void benchmark_corpus_all(const benchmark_corpus* corpus)
+{
+	char flags_name[96];
+	size_t i, offset, num_instructions = 0, num_bytes = 0;
+
+	benchmark_decoder(corpus, "NONE", NMD_X86_DECODER_FLAGS_NONE);
+	for (i = 0; i < sizeof(decoder_flags) / sizeof(*decoder_flags); i++)
+		benchmark_decoder(corpus, decoder_flags[i].name, decoder_flags[i].flag);
+	benchmark_decoder(corpus, "MINIMAL", NMD_X86_DECODER_FLAGS_MINIMAL);
+	benchmark_decoder(corpus, "ALL", NMD_X86_DECODER_FLAGS_ALL);
+	benchmark_decoder(corpus, "ALL|REGISTERS", NMD_X86_DECODER_FLAGS_ALL | NMD_X86_DECODER_FLAGS_REGISTERS);
+
+	benchmark_ldisasm(corpus);
+
+	for (offset = 0; offset < corpus->size && num_instructions < BENCHMARK_MAX_FORMATTED_INSTRUCTIONS;)
+	{
+		if (nmd_x86_decode(corpus->buffer + offset, corpus->size - offset, &formatted_instructions[num_instructions], corpus->mode, NMD_X86_DECODER_FLAGS_ALL))
+		{
+			offset += formatted_instructions[num_instructions].length;
+			num_bytes += formatted_instructions[num_instructions++].length;
+		}
+		else
+			offset++;
+	}
+
+	/* The default flags, then the default flags with each flag toggled */
+	benchmark_formatter(corpus, num_instructions, num_bytes, "DEFAULT", NMD_X86_FORMAT_FLAGS_DEFAULT);
+	for (i = 0; i < sizeof(format_flags) / sizeof(*format_flags); i++)
+	{
+		sprintf(flags_name, "DEFAULT%s%s", NMD_X86_FORMAT_FLAGS_DEFAULT & format_flags[i].flag ? "-" : "+", format_flags[i].name);
+		benchmark_formatter(corpus, num_instructions, num_bytes, flags_name, NMD_X86_FORMAT_FLAGS_DEFAULT ^ format_flags[i].flag);
+	}
+
+	benchmark_assembler(corpus);
+}
+
+static void write_string(FILE* file, const char* s)
+{
+	fputc('"', file);
+	for (; *s; s++)
+	{
+		if (*s == '"' || *s == '\\')
+			fputc('\\', file);
+		if ((unsigned char)*s >= 0x20)
+			fputc(*s, file);
+	}
+	fputc('"', file);
+}
+
+/* Every result is written in its own line, which is what compare_results() expects. */
+static void write_results(FILE* file)
+{
+	size_t i;
+	fprintf(file, "{\n  \"library\": \"nmd_assembly\",\n  \"clocks_per_second\": %.0f,\n  \"corpora\": [\n", (double)CLOCKS_PER_SEC);
+	for (i = 0; i < num_corpora; i++)
+	{
+		fprintf(file, "    { \"name\": ");
+		write_string(file, corpora[i].name);
+		fprintf(file, ", \"mode\": %d, \"bytes\": %lu }%s\n", corpora[i].mode == NMD_X86_MODE_16 ? 16 : (corpora[i].mode == NMD_X86_MODE_32 ? 32 : 64), (unsigned long)corpora[i].size, i + 1 < num_corpora ? "," : "");
+	}
+
+	fprintf(file, "  ],\n  \"results\": [\n");
+	for (i = 0; i < num_results; i++)
+	{
+		const benchmark_result* result = &results[i];
+		fprintf(file, "    { \"name\": ");
+		write_string(file, result->name);
+		fprintf(file, ", \"function\": \"%s\", \"corpus\": ", result->function);
+		write_string(file, result->corpus);
+		fprintf(file, ", \"flags\": %lu, \"instructions\": %.0f, \"bytes\": %.0f, \"seconds\": %.6f, \"instructions_per_second\": %.0f, \"bytes_per_second\": %.0f }%s\n",
+			(unsigned long)result->flags, result->instructions, result->bytes, result->seconds, result->seconds > 0 ? result->instructions / result->seconds : 0, result->seconds > 0 ? result->bytes / result->seconds : 0, i + 1 < num_results ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+}
+
+/* Returns the number of results slower than the baseline by more than 'threshold' percent, or -1 if the baseline can't be read. */
+static int compare_results(const char* path, double threshold)
+{
+	char line[1024];
+	int num_regressions = 0;
+	size_t i;
+	FILE* file;
+
+	if (!(file = fopen(path, "r")))
+		return -1;
+
+	while (fgets(line, sizeof(line), file))
+	{
+		const char* name = strstr(line, "{ \"name\": \"");
+		const char* ips = strstr(line, "\"instructions_per_second\": ");
+		const char* name_end;
+		double baseline, current;
+
+		if (!name || !ips || !(name_end = strchr(name + 11, '"')))
+			continue;
+
+		name += 11;
+		baseline = atof(ips + 27);
+		for (i = 0; i < num_results; i++)
+		{
+			if (strlen(results[i].name) != (size_t)(name_end - name) || strncmp(results[i].name, name, (size_t)(name_end - name)))
+				continue;
+
+			current = results[i].seconds > 0 ? results[i].instructions / results[i].seconds : 0;
+			if (baseline > 0 && current < baseline * (1.0 - threshold / 100.0))
+			{
+				fprintf(stderr, "regression: %s %.0f -> %.0f instructions/s (%.1f%%)\n", results[i].name, baseline, current, (current / baseline - 1.0) * 100.0);
+				num_regressions++;
+			}
+			break;
+		}
+	}
+
+	fclose(file);
+	return num_regressions;
+}
+
+int main(int argc, char** argv)
+{
+	const char* json_path = 0;
+	const char* baseline_path = 0;
+	double threshold = 10.0;
+	NMD_X86_MODE mode = NMD_X86_MODE_64;
+	FILE* output = stdout;
+	int i, num_regressions = 0;
+	size_t j;
+
+	add_synthetic_corpora();
+
+	for (i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--json") && i + 1 < argc)
+			json_path = argv[++i];
+		else if (!strcmp(argv[i], "--time") && i + 1 < argc)
+			min_seconds = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--compare") && i + 1 < argc)
+			baseline_path = argv[++i];
+		else if (!strcmp(argv[i], "--threshold") && i + 1 < argc)
+			threshold = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--mode") && i + 1 < argc)
+		{
+			i++;
+			mode = !strcmp(argv[i], "16") ? NMD_X86_MODE_16 : (!strcmp(argv[i], "32") ? NMD_X86_MODE_32 : NMD_X86_MODE_64);
+		}
+		else if (!add_file_corpus(argv[i], mode))
+		{
+			fprintf(stderr, "error: could not read '%s'\n", argv[i]);
+			return 1;
+		}
+	}
+
+	for (j = 0; j < num_corpora; j++)
+		benchmark_corpus_all(&corpora[j]);
+
+	if (json_path && !(output = fopen(json_path, "w")))
+	{
+		fprintf(stderr, "error: could not write '%s'\n", json_path);
+		return 1;
+	}
+
+	write_results(output);
+	if (output != stdout)
+		fclose(output);
+
+	if (baseline_path && (num_regressions = compare_results(baseline_path, threshold)) < 0)
+	{
+		fprintf(stderr, "error: could not read '%s'\n", baseline_path);
+		return 1;
+	}
+
+	for (j = 0; j < num_corpora; j++)
+		free(corpora[j].buffer);
+
+	return num_regressions ? 2 : 0;
+}
@@ -0,0 +1,83 @@
+/* Representative x86-64 instructions used to build the 'mixed64' corpus of assembly_benchmark.c. The weights roughly follow the
+   distribution of compiler generated code: mostly legacy integer instructions, followed by SSE, VEX(AVX/AVX2/FMA) and EVEX(AVX-512). */
+#ifndef ASSEMBLY_BENCHMARK_CORPUS_H
+#define ASSEMBLY_BENCHMARK_CORPUS_H
+
+typedef struct benchmark_corpus_instruction
+{
+	uint8_t bytes[15];
+	size_t length;
+	size_t weight;
+} benchmark_corpus_instruction;
+
+static const benchmark_corpus_instruction benchmark_corpus_instructions[] = {
+	/* Legacy */
+	{ { 0x55 }, 1, 12 },                                                 /* push rbp */
+	{ { 0x48, 0x89, 0xe5 }, 3, 12 },                                     /* mov rbp,rsp */
+	{ { 0x48, 0x83, 0xec, 0x20 }, 4, 12 },                               /* sub rsp,0x20 */
+	{ { 0x48, 0x8b, 0x45, 0xf8 }, 4, 12 },                               /* mov rax,qword ptr [rbp-0x8] */
+	{ { 0x89, 0x7d, 0xec }, 3, 12 },                                     /* mov dword ptr [rbp-0x14],edi */
+	{ { 0x8b, 0x45, 0xec }, 3, 12 },                                     /* mov eax,dword ptr [rbp-0x14] */
+	{ { 0x83, 0xc0, 0x01 }, 3, 12 },                                     /* add eax,0x1 */
+	{ { 0x48, 0x63, 0xd0 }, 3, 12 },                                     /* movsxd rdx,eax */
+	{ { 0x48, 0x8d, 0x14, 0x85, 0x00, 0x00, 0x00, 0x00 }, 8, 12 },       /* lea rdx,[rax*4+0x0] */
+	{ { 0x48, 0x01, 0xd0 }, 3, 12 },                                     /* add rax,rdx */
+	{ { 0x0f, 0xb6, 0x00 }, 3, 12 },                                     /* movzx eax,byte ptr [rax] */
+	{ { 0x84, 0xc0 }, 2, 12 },                                           /* test al,al */
+	{ { 0x74, 0x0a }, 2, 12 },                                           /* je 0xc */
+	{ { 0xe8, 0x10, 0x00, 0x00, 0x00 }, 5, 12 },                         /* call 0x15 */
+	{ { 0xc9 }, 1, 12 },                                                 /* leave */
+	{ { 0xc3 }, 1, 12 },                                                 /* ret */
+	{ { 0x0f, 0x1f, 0x44, 0x00, 0x00 }, 5, 12 },                         /* nop dword ptr [rax+rax*1+0x0] */
+	{ { 0x66, 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 }, 9, 12 }, /* nop word ptr [rax+rax*1+0x0] */
+	{ { 0xf3, 0x0f, 0x1e, 0xfa }, 4, 12 },                               /* endbr64 */
+	{ { 0x48, 0x85, 0xc0 }, 3, 12 },                                     /* test rax,rax */
+	{ { 0x0f, 0x84, 0x20, 0x01, 0x00, 0x00 }, 6,  4 },                   /* je 0x126 */
+	{ { 0x41, 0x57 }, 2,  4 },                                           /* push r15 */
+	{ { 0x4c, 0x8d, 0x3d, 0x10, 0x20, 0x00, 0x00 }, 7,  4 },             /* lea r15,[rip+0x2010] */
+	{ { 0xf3, 0x48, 0xab }, 3,  4 },                                     /* rep stos qword ptr es:[rdi],rax */
+	{ { 0x48, 0xc7, 0xc0, 0xff, 0xff, 0xff, 0xff }, 7,  4 },             /* mov rax,0xffffffffffffffff */
+	{ { 0x31, 0xc0 }, 2,  4 },                                           /* xor eax,eax */
+	{ { 0x0f, 0xaf, 0xc2 }, 3,  4 },                                     /* imul eax,edx */
+	{ { 0x48, 0xc1, 0xe8, 0x03 }, 4,  4 },                               /* shr rax,0x3 */
+	{ { 0xf7, 0xd8 }, 2,  4 },                                           /* neg eax */
+	{ { 0x99 }, 1,  4 },                                                 /* cdq */
+	{ { 0xf7, 0xf9 }, 2,  4 },                                           /* idiv ecx */
+	{ { 0x0f, 0x94, 0xc0 }, 3,  4 },                                     /* sete al */
+	{ { 0x0f, 0x4c, 0xc2 }, 3,  4 },                                     /* cmovl eax,edx */
+	{ { 0x66, 0x0f, 0xef, 0xc0 }, 4,  4 },                               /* pxor xmm0,xmm0 */
+	{ { 0xf2, 0x0f, 0x10, 0x05, 0x10, 0x00, 0x00, 0x00 }, 8,  4 },       /* movsd xmm0,qword ptr [rip+0x10] */
+	{ { 0x0f, 0x28, 0xc1 }, 3,  4 },                                     /* movaps xmm0,xmm1 */
+	{ { 0xf3, 0x0f, 0x7f, 0x07 }, 4,  4 },                               /* movdqu xmmword ptr [rdi],xmm0 */
+	{ { 0x66, 0x0f, 0x6f, 0x0e }, 4,  4 },                               /* movdqa xmm1,xmmword ptr [rsi] */
+	{ { 0x48, 0x8b, 0x04, 0xc8 }, 4,  4 },                               /* mov rax,qword ptr [rax+rcx*8] */
+	{ { 0x64, 0x48, 0x8b, 0x04, 0x25, 0x28, 0x00, 0x00, 0x00 }, 9,  4 }, /* mov rax,qword ptr fs:0x28 */
+	{ { 0xff, 0x24, 0xc5, 0x00, 0x10, 0x40, 0x00 }, 7,  4 },             /* jmp qword ptr [rax*8+0x401000] */
+	{ { 0xff, 0x15, 0x00, 0x10, 0x00, 0x00 }, 6,  4 },                   /* call qword ptr [rip+0x1000] */
+	{ { 0x0f, 0x05 }, 2,  4 },                                           /* syscall */
+	{ { 0xf0, 0x0f, 0xb1, 0x11 }, 4,  4 },                               /* lock cmpxchg dword ptr [rcx],edx */
+
+	/* VEX */
+	{ { 0xc5, 0xf8, 0x77 }, 3,  2 },                                     /* vzeroupper */
+	{ { 0xc5, 0xfd, 0x6f, 0x07 }, 4,  2 },                               /* vmovdqa ymm0,ymmword ptr [rdi] */
+	{ { 0xc5, 0xfd, 0xfe, 0xc1 }, 4,  2 },                               /* vpaddd ymm0,ymm0,ymm1 */
+	{ { 0xc4, 0xe2, 0x7d, 0x58, 0xc0 }, 5,  2 },                         /* vpbroadcastd ymm0,xmm0 */
+	{ { 0xc5, 0xfc, 0x28, 0xc8 }, 4,  2 },                               /* vmovaps ymm1,ymm0 */
+	{ { 0xc4, 0xe3, 0x7d, 0x19, 0xc1, 0x01 }, 6,  2 },                   /* vextractf128 xmm1,ymm0,0x1 */
+	{ { 0xc5, 0xf9, 0xd7, 0xc0 }, 4,  2 },                               /* vpmovmskb eax,xmm0 */
+	{ { 0xc4, 0xe2, 0x79, 0x18, 0x05, 0x00, 0x01, 0x00, 0x00 }, 9,  2 }, /* vbroadcastss xmm0,dword ptr [rip+0x100] */
+	{ { 0xc4, 0xe2, 0xf9, 0xa9, 0xc1 }, 5,  2 },                         /* vfmadd213sd xmm0,xmm0,xmm1 */
+	{ { 0xc5, 0xfa, 0x10, 0x07 }, 4,  2 },                               /* vmovss xmm0,dword ptr [rdi] */
+	{ { 0xc5, 0xfe, 0x7f, 0x44, 0x24, 0x20 }, 6,  2 },                   /* vmovdqu ymmword ptr [rsp+0x20],ymm0 */
+
+	/* EVEX */
+	{ { 0x62, 0xf1, 0x7d, 0x48, 0x6f, 0x07 }, 6,  1 },                   /* vmovdqa32 zmm0,zmmword ptr [rdi] */
+	{ { 0x62, 0xf1, 0x7d, 0x48, 0xfe, 0xc1 }, 6,  1 },                   /* vpaddd zmm0,zmm0,zmm1 */
+	{ { 0x62, 0xf2, 0x7d, 0x48, 0x58, 0xc0 }, 6,  1 },                   /* vpbroadcastd zmm0,xmm0 */
+	{ { 0x62, 0xf1, 0xfe, 0x48, 0x6f, 0x0e }, 6,  1 },                   /* vmovdqu64 zmm1,zmmword ptr [rsi] */
+	{ { 0x62, 0xf1, 0x7c, 0x48, 0x28, 0xc8 }, 6,  1 },                   /* vmovaps zmm1,zmm0 */
+	{ { 0x62, 0xf1, 0x7d, 0x48, 0x7f, 0x47, 0x01 }, 7,  1 },             /* vmovdqa32 zmmword ptr [rdi+0x40],zmm0 */
+	{ { 0x62, 0xf1, 0x74, 0x48, 0x58, 0xc2 }, 6,  1 }                    /* vaddps zmm0,zmm1,zmm2 */
+};
+
+#endif /* ASSEMBLY_BENCHMARK_CORPUS_H */
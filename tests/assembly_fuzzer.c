@@ -0,0 +1,415 @@
+/*
+Fuzzer of nmd_assembly.h. Every input is disassembled with a linear sweep and each step checks that:
+ - nmd_x86_ldisasm() and nmd_x86_decode() agree on the instruction's length and validity. Instructions only one of them accepts are counted.
+ - The length does not depend on the decoder's optional features(operands, instruction id, cpu flags, group and register use), nor on
+   the buffer's size past 15 bytes(define 'NMD_ASSEMBLY_ENABLE_LENGTH_DISASSEMBLER_SSE2' to compare the SSE2 prefix scan against the scalar one).
+ - decode -> format -> assemble -> decode -> format gives the same string. The assembler does not support every instruction the decoder does, so
+   strings it can't assemble are skipped. An instruction with the same id and operands that is formatted differently(a redundant prefix like 'ds:[eax]',
+   or the swapped operands of 'xchg') is an equivalent encoding, any other difference is a mismatch and is counted.
+ Use '--strict'(or define 'ASSEMBLY_FUZZER_STRICT') to treat the counted mismatches as failures, as the CI does.
+The input is also passed to nmd_x86_assemble() as a string, whose output must be valid code. A quarter of the generated inputs are text for this check.
+A failed check calls abort(), so libFuzzer and AFL record the input as a crash.
+
+Input: the first byte selects the mode(bits 0-1) and the decoder flags of the second decode(bits 2-7), the rest is the code.
+
+Usage: assembly_fuzzer [--time seconds] [--seed n] [--strict] [--verbose] [file...]
+ - Without files random inputs(random bytes, and mutations of the instructions in 'assembly_benchmark_corpus.h' as code and as text) are generated for '--time' seconds(10 by default).
+ - With files each file is checked once(e.g. to reproduce a crash, or as an AFL target with '@@'). '-' reads the standard input.
+ - '--verbose' prints every mismatch.
+ Both modes report the number of executions per second and of instructions per second, so changes to the decoder can be validated for speed as well.
+
+Build:
+ - Standalone: gcc -std=c89 -O2 tests/assembly_fuzzer.c -o assembly_fuzzer
+ - SSE2:       gcc -std=c89 -O2 -DNMD_ASSEMBLY_ENABLE_LENGTH_DISASSEMBLER_SSE2 tests/assembly_fuzzer.c -o assembly_fuzzer_sse2
+ - libFuzzer:  clang -g -O1 -fsanitize=fuzzer,address,undefined -DASSEMBLY_FUZZER_LIBFUZZER -DASSEMBLY_FUZZER_STRICT tests/assembly_fuzzer.c -o assembly_fuzzer
+ - AFL:        afl-clang-fast -O2 tests/assembly_fuzzer.c -o assembly_fuzzer && afl-fuzz -i seeds -o findings ./assembly_fuzzer @@
+*/
+#define NMD_ASSEMBLY_IMPLEMENTATION
+#include "../nmd_assembly.h"
+#include "assembly_benchmark_corpus.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FUZZER_MAX_INPUT_SIZE 4096
+#define FUZZER_MAX_GENERATED_SIZE 64
+#define FUZZER_MAX_GENERATED_TEXT_SIZE 256
+
+/* The round-trip strings have the '0x' prefix instead of the 'h' suffix, so numbers are never read as registers('Ah' is 'ah'), and pointer sizes, so the assembler does not guess the operand size. */
+#define FUZZER_FORMAT_FLAGS ((NMD_X86_FORMAT_FLAGS_DEFAULT & ~NMD_X86_FORMAT_FLAGS_H_SUFFIX) | NMD_X86_FORMAT_FLAGS_0X_PREFIX | NMD_X86_FORMAT_FLAGS_POINTER_SIZE)
+
+typedef struct fuzzer_stats
+{
+	double executions;
+	double instructions;
+	double bytes;
+	double validity_mismatches;  /* Instructions only one of the length disassembler and the decoder accepts. */
+	double roundtrips;           /* Instructions assembled back to the same string. */
+	double roundtrip_equivalents; /* Instructions assembled to an equivalent encoding that is formatted differently. */
+	double roundtrip_mismatches; /* Instructions assembled to a different instruction. */
+	double roundtrip_skipped;    /* Instructions the assembler does not support. */
+	double assembled_inputs;     /* Inputs accepted by nmd_x86_assemble() as text. */
+} fuzzer_stats;
+
+static const NMD_X86_MODE fuzzer_modes[4] = { NMD_X86_MODE_16, NMD_X86_MODE_32, NMD_X86_MODE_64, NMD_X86_MODE_64 };
+
+static fuzzer_stats stats;
+#ifdef ASSEMBLY_FUZZER_STRICT
+static int strict = 1;
+#else
+static int strict = 0;
+#endif /* ASSEMBLY_FUZZER_STRICT */
+static int verbose = 0;
+
+static void fuzzer_print_bytes(const char* message, const uint8_t* bytes, size_t size, NMD_X86_MODE mode)
+{
+	size_t i;
+	fprintf(stderr, "%s(mode %d):", message, mode == NMD_X86_MODE_16 ? 16 : (mode == NMD_X86_MODE_32 ? 32 : 64));
+	for (i = 0; i < size; i++)
+		fprintf(stderr, " %02x", bytes[i]);
+	fprintf(stderr, "\n");
+}
+
+static void fuzzer_fail(const char* message, const uint8_t* bytes, size_t size, NMD_X86_MODE mode)
+{
+	fuzzer_print_bytes(message, bytes, size, mode);
+	abort();
+}
+
+/* An index register with scale one and no base register is a base register('[eax*1+4]'(SIB) and '[eax+4]'). */
+static void fuzzer_get_base_and_index(const nmd_x86_memory_operand* mem, uint8_t* base, uint8_t* index)
+{
+	const int index_is_base = !mem->base && mem->scale == 1;
+	*base = index_is_base ? mem->index : mem->base;
+	*index = index_is_base ? NMD_X86_REG_NONE : mem->index;
+}
+
+static int fuzzer_operands_equal(const nmd_x86_operand* a, const nmd_x86_operand* b)
+{
+	if (a->type != b->type || a->is_implicit != b->is_implicit)
+		return 0;
+	else if (a->type == NMD_X86_OPERAND_TYPE_REGISTER)
+		return a->fields.reg == b->fields.reg;
+	else if (a->type == NMD_X86_OPERAND_TYPE_IMMEDIATE)
+		return a->fields.imm == b->fields.imm;
+	else if (a->type == NMD_X86_OPERAND_TYPE_MEMORY)
+	{
+		uint8_t base_a, index_a, base_b, index_b;
+		fuzzer_get_base_and_index(&a->fields.mem, &base_a, &index_a);
+		fuzzer_get_base_and_index(&b->fields.mem, &base_b, &index_b);
+		return a->fields.mem.segment == b->fields.mem.segment && base_a == base_b && index_a == index_b && (!index_a || a->fields.mem.scale == b->fields.mem.scale) && a->fields.mem.size == b->fields.mem.size && a->fields.mem.disp == b->fields.mem.disp;
+	}
+	return 1;
+}
+
+/*
+Returns true if the instructions have the same identifier and operands, so they only differ in their encoding:
+ - A redundant prefix, like a segment override of the default segment('ds:[eax]' and '[eax]'). The decoder always resolves the operands' segment.
+ - The operands of 'xchg' are swapped('xchg rax,r8'(4C 87 C0) and 'xchg r8,rax'(49 90)).
+The lock prefix and the repeat prefixes of instructions without ModR/M(e.g. 'rep movsb') must match.
+*/
+static int fuzzer_equivalent(const nmd_x86_instruction* a, const nmd_x86_instruction* b)
+{
+	const uint32_t prefixes = NMD_X86_PREFIXES_LOCK | (a->has_modrm ? 0 : NMD_X86_PREFIXES_REPEAT | NMD_X86_PREFIXES_REPEAT_NOT_ZERO);
+	size_t i;
+	if (a->id != b->id || a->num_operands != b->num_operands || (a->prefixes & prefixes) != (b->prefixes & prefixes))
+		return 0;
+
+	if (a->id == NMD_X86_INSTRUCTION_XCHG && a->num_operands == 2 && fuzzer_operands_equal(&a->operands[0], &b->operands[1]) && fuzzer_operands_equal(&a->operands[1], &b->operands[0]))
+		return 1;
+
+	for (i = 0; i < a->num_operands; i++)
+	{
+		if (!fuzzer_operands_equal(&a->operands[i], &b->operands[i]))
+			return 0;
+	}
+
+	return 1;
+}
+
+/* Checks that the formatted instruction is assembled to an instruction that is formatted to the same string, or to an equivalent encoding. */
+static void fuzzer_check_roundtrip(const nmd_x86_instruction* instruction, NMD_X86_MODE mode)
+{
+	char string[NMD_X86_FORMATTER_MAX_LENGTH], string2[NMD_X86_FORMATTER_MAX_LENGTH];
+	uint8_t buffer[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH];
+	nmd_x86_instruction instruction2;
+	size_t length;
+
+	nmd_x86_format(instruction, string, NMD_X86_INVALID_RUNTIME_ADDRESS, FUZZER_FORMAT_FLAGS);
+	if (!(length = nmd_x86_assemble(string, buffer, sizeof(buffer), NMD_X86_INVALID_RUNTIME_ADDRESS, mode, 0)))
+	{
+		stats.roundtrip_skipped++;
+		return;
+	}
+
+	string2[0] = '\0';
+	if (nmd_x86_decode(buffer, length, &instruction2, mode, NMD_X86_DECODER_FLAGS_ALL) && instruction2.length == length)
+	{
+		nmd_x86_format(&instruction2, string2, NMD_X86_INVALID_RUNTIME_ADDRESS, FUZZER_FORMAT_FLAGS);
+		if (!strcmp(string, string2))
+		{
+			stats.roundtrips++;
+			return;
+		}
+		else if (fuzzer_equivalent(instruction, &instruction2))
+		{
+			stats.roundtrip_equivalents++;
+			return;
+		}
+	}
+
+	stats.roundtrip_mismatches++;
+	if (verbose)
+	{
+		fprintf(stderr, "round-trip mismatch: '%s' -> '%s' ", string, string2);
+		fuzzer_print_bytes("", instruction->buffer, instruction->length, mode);
+	}
+	if (strict)
+		fuzzer_fail("round-trip mismatch", instruction->buffer, instruction->length, mode);
+}
+
+/* Checks the input as code and as text. */
+static void fuzzer_run(const uint8_t* data, size_t size)
+{
+	char text[FUZZER_MAX_INPUT_SIZE + 1];
+	uint8_t assembled[FUZZER_MAX_INPUT_SIZE];
+	nmd_x86_instruction instruction, instruction2;
+	NMD_X86_MODE mode;
+	uint32_t flags;
+	size_t offset, length;
+
+	stats.executions++;
+	if (!size)
+		return;
+
+	mode = fuzzer_modes[data[0] & 3];
+	flags = ((uint32_t)data[0] >> 2) & (NMD_X86_DECODER_FLAGS_ALL | NMD_X86_DECODER_FLAGS_REGISTERS);
+	data++, size--;
+	if (size > FUZZER_MAX_INPUT_SIZE)
+		size = FUZZER_MAX_INPUT_SIZE;
+
+	for (offset = 0; offset < size; offset += instruction.valid ? instruction.length : 1)
+	{
+		const uint8_t* const bytes = data + offset;
+		const size_t remaining = size - offset;
+
+		length = nmd_x86_ldisasm(bytes, remaining, mode);
+		nmd_x86_decode(bytes, remaining, &instruction, mode, NMD_X86_DECODER_FLAGS_ALL);
+
+		/* The length does not depend on the buffer's size past 15 bytes. With 16 or more bytes the prefixes may be classified by the SSE2 path, with 15 they're classified by the scalar one */
+		if (remaining > NMD_X86_MAXIMUM_INSTRUCTION_LENGTH && nmd_x86_ldisasm(bytes, NMD_X86_MAXIMUM_INSTRUCTION_LENGTH, mode) != length)
+			fuzzer_fail("the length depends on the buffer's size", bytes, NMD_X86_MAXIMUM_INSTRUCTION_LENGTH, mode);
+
+		/* The validity checks of the length disassembler and the decoder are not identical(e.g. the decoder does not support EVEX), so this is only counted by default */
+		if ((length != 0) != instruction.valid)
+		{
+			stats.validity_mismatches++;
+			if (verbose)
+				fuzzer_print_bytes(length ? "only ldisasm accepts" : "only the decoder accepts", bytes, length ? length : instruction.length, mode);
+			if (strict)
+				fuzzer_fail(length ? "only ldisasm accepts" : "only the decoder accepts", bytes, length ? length : instruction.length, mode);
+		}
+
+		if (!length || !instruction.valid)
+			continue;
+
+		if (length != instruction.length)
+			fuzzer_fail("ldisasm and the decoder disagree on the length", bytes, instruction.length, mode);
+
+		/* The length does not depend on the optional features of the decoder. The VEX, EVEX and 3DNow! flags change how the bytes are read, so they're always enabled. */
+		if (nmd_x86_decode(bytes, remaining, &instruction2, mode, flags | NMD_X86_DECODER_FLAGS_VALIDITY_CHECK | NMD_X86_DECODER_FLAGS_VEX | NMD_X86_DECODER_FLAGS_EVEX | NMD_X86_DECODER_FLAGS_3DNOW) && instruction2.length != instruction.length)
+			fuzzer_fail("the length depends on the decoder flags", bytes, instruction.length, mode);
+
+		stats.instructions++;
+		stats.bytes += instruction.length;
+		fuzzer_check_roundtrip(&instruction, mode);
+	}
+
+	/* The assembler's input is untrusted as well, and its output must be valid code */
+	memcpy(text, data, size);
+	text[size] = '\0';
+	if ((length = nmd_x86_assemble(text, assembled, sizeof(assembled), NMD_X86_INVALID_RUNTIME_ADDRESS, mode, 0)))
+	{
+		stats.assembled_inputs++;
+		for (offset = 0; offset < length; offset += instruction.length)
+		{
+			if (!nmd_x86_decode(assembled + offset, length - offset, &instruction, mode, NMD_X86_DECODER_FLAGS_MINIMAL))
+				fuzzer_fail("the assembler's output is not valid", assembled, length, mode);
+		}
+	}
+}
+
+#ifdef ASSEMBLY_FUZZER_LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	fuzzer_run(data, size);
+	return 0;
+}
+
+#else
+
+static void fuzzer_report(double seconds)
+{
+	if (seconds <= 0)
+		seconds = 1e-9;
+
+	printf("executions:           %.0f(%.0f/s)\n", stats.executions, stats.executions / seconds);
+	printf("instructions:         %.0f(%.0f/s, %.2f MB/s)\n", stats.instructions, stats.instructions / seconds, stats.bytes / seconds / (1024 * 1024));
+	printf("validity mismatches:  %.0f\n", stats.validity_mismatches);
+	printf("round-trips:          %.0f\n", stats.roundtrips);
+	printf("round-trip skipped:   %.0f\n", stats.roundtrip_skipped);
+	printf("round-trip equivalents:%.0f\n", stats.roundtrip_equivalents);
+	printf("round-trip mismatches:%.0f\n", stats.roundtrip_mismatches);
+	printf("assembled inputs:     %.0f\n", stats.assembled_inputs);
+}
+
+/* xorshift32, so the generated inputs are the same for the same seed on every platform. */
+static uint32_t fuzzer_random(uint32_t* state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+/* Generates text for the assembler: formatted corpus instructions separated by '\n' with a few characters replaced. Returns the input's size. */
+static size_t fuzzer_generate_text(uint8_t* input, uint32_t* state)
+{
+	static const char characters[] = "0123456789abcdefhx+-*[]:, \n";
+	const size_t num_corpus_instructions = sizeof(benchmark_corpus_instructions) / sizeof(benchmark_corpus_instruction);
+	const NMD_X86_MODE mode = fuzzer_modes[input[0] & 3];
+	char string[NMD_X86_FORMATTER_MAX_LENGTH];
+	nmd_x86_instruction instruction;
+	size_t size = 1, i;
+
+	while (fuzzer_random(state) % 4)
+	{
+		const benchmark_corpus_instruction* const corpus_instruction = &benchmark_corpus_instructions[fuzzer_random(state) % num_corpus_instructions];
+		if (!nmd_x86_decode(corpus_instruction->bytes, corpus_instruction->length, &instruction, mode, NMD_X86_DECODER_FLAGS_MINIMAL))
+			continue;
+
+		/* The default flags('h' suffix) are used as well, as that's what most users pass */
+		nmd_x86_format(&instruction, string, NMD_X86_INVALID_RUNTIME_ADDRESS, fuzzer_random(state) & 1 ? FUZZER_FORMAT_FLAGS : NMD_X86_FORMAT_FLAGS_DEFAULT);
+		if (size + strlen(string) + 1 > FUZZER_MAX_GENERATED_TEXT_SIZE)
+			break;
+
+		if (size > 1)
+			input[size++] = '\n';
+		for (i = 0; string[i]; i++)
+			input[size++] = (uint8_t)string[i];
+	}
+
+	for (i = fuzzer_random(state) % 4; i > 0 && size > 1; i--)
+		input[1 + fuzzer_random(state) % (size - 1)] = (uint8_t)characters[fuzzer_random(state) % (sizeof(characters) - 1)];
+
+	return size;
+}
+
+/* Generates random bytes, a sequence of corpus instructions with a few random mutations or text. Returns the input's size. */
+static size_t fuzzer_generate(uint8_t* input, uint32_t* state)
+{
+	const size_t num_corpus_instructions = sizeof(benchmark_corpus_instructions) / sizeof(benchmark_corpus_instruction);
+	size_t size = 1, i;
+
+	input[0] = (uint8_t)fuzzer_random(state);
+	if (fuzzer_random(state) % 4 == 0)
+		return fuzzer_generate_text(input, state);
+	else if (fuzzer_random(state) & 1)
+	{
+		const size_t num_bytes = fuzzer_random(state) % FUZZER_MAX_GENERATED_SIZE;
+		for (i = 0; i < num_bytes; i++)
+			input[size++] = (uint8_t)fuzzer_random(state);
+	}
+	else
+	{
+		while (size + NMD_X86_MAXIMUM_INSTRUCTION_LENGTH <= FUZZER_MAX_GENERATED_SIZE && fuzzer_random(state) % 8)
+		{
+			const benchmark_corpus_instruction* const corpus_instruction = &benchmark_corpus_instructions[fuzzer_random(state) % num_corpus_instructions];
+			for (i = 0; i < corpus_instruction->length; i++)
+				input[size++] = corpus_instruction->bytes[i];
+		}
+
+		for (i = fuzzer_random(state) % 4; i > 0 && size > 1; i--)
+			input[1 + fuzzer_random(state) % (size - 1)] ^= (uint8_t)(1 << (fuzzer_random(state) % 8));
+	}
+
+	return size;
+}
+
+static double get_seconds(void)
+{
+	return (double)clock() / CLOCKS_PER_SEC;
+}
+
+static int fuzzer_run_file(const char* path)
+{
+	static uint8_t input[FUZZER_MAX_INPUT_SIZE + 1];
+	FILE* file = strcmp(path, "-") ? fopen(path, "rb") : stdin;
+	size_t size;
+	if (!file)
+		return 0;
+
+	size = fread(input, 1, sizeof(input), file);
+	if (file != stdin)
+		fclose(file);
+
+	fuzzer_run(input, size);
+	return 1;
+}
+
+int main(int argc, char** argv)
+{
+	uint8_t input[FUZZER_MAX_GENERATED_TEXT_SIZE];
+	double seconds = 10.0, start, elapsed;
+	uint32_t seed = (uint32_t)time(0);
+	int i, num_files = 0;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--time") && i + 1 < argc)
+			seconds = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+			seed = (uint32_t)strtoul(argv[++i], 0, 0);
+		else if (!strcmp(argv[i], "--strict"))
+			strict = 1;
+		else if (!strcmp(argv[i], "--verbose"))
+			verbose = 1;
+	}
+
+	start = get_seconds();
+	for (i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--time") || !strcmp(argv[i], "--seed"))
+			i++;
+		else if (strcmp(argv[i], "--strict") && strcmp(argv[i], "--verbose"))
+		{
+			num_files++;
+			if (!fuzzer_run_file(argv[i]))
+			{
+				fprintf(stderr, "error: could not read '%s'\n", argv[i]);
+				return 1;
+			}
+		}
+	}
+
+	if (!num_files)
+	{
+		printf("seed: %u\n", seed);
+		if (!seed)
+			seed = 1; /* xorshift32 never leaves zero */
+
+		do
+		{
+			for (i = 0; i < 1024; i++)
+				fuzzer_run(input, fuzzer_generate(input, &seed));
+		} while ((elapsed = get_seconds() - start) < seconds);
+	}
+
+	fuzzer_report(get_seconds() - start);
+
+	return 0;
+}
+
+#endif /* ASSEMBLY_FUZZER_LIBFUZZER */
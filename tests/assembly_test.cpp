@@ -1,14 +1,25 @@
 #include <gtest/gtest.h>
+#include <vector>
 
 #define NMD_ASSEMBLY_IMPLEMENTATION
+#define NMD_ASSEMBLY_ENABLE_THREADS
 #include "../nmd_assembly.h"
 
+// The generator of the opcode tables, used to check that the tables in 'nmd_assembly.h' are up to date.
+namespace opcode_tables_generator {
+#define GENERATE_OPCODE_TABLES_NO_MAIN
+#include "../assembly/generate_opcode_tables.c"
+}
+
+NMD_X86_DEFINE_DECODER(nmd_x86_decode_64_minimal, NMD_X86_MODE_64, NMD_X86_DECODER_FLAGS_MINIMAL)
+NMD_X86_DEFINE_DECODER(nmd_x86_decode_32_full, NMD_X86_MODE_32, NMD_X86_DECODER_FLAGS_ALL)
+
 // This is a giant hack so we can use contructors. The structs are just copies.
 #define OP nmd_x86_operand2
 #define MEM nmd_x86_memory_operand2
 #define MODRM nmd_x86_modrm2
 union nmd_x86_modrm2 { struct { uint8_t rm : 3; uint8_t reg : 3; uint8_t mod : 2; } fields; uint8_t modrm; nmd_x86_modrm2(uint8_t modrm) : modrm(modrm) {} nmd_x86_modrm2(uint8_t mod, uint8_t reg, uint8_t rm) : modrm((mod<<6)|(reg<<3)|(rm)) {} };
-struct nmd_x86_memory_operand2 { uint8_t segment; uint8_t base; uint8_t index; uint8_t scale; int64_t disp; nmd_x86_memory_operand2(uint8_t segment, uint8_t base, uint8_t index, uint8_t scale, int64_t disp) : segment(segment), base(base), index(index), scale(scale), disp(disp) {} };
+struct nmd_x86_memory_operand2 { uint8_t segment; uint8_t base; uint8_t index; uint8_t scale; uint8_t size; int64_t disp; nmd_x86_memory_operand2(uint8_t segment, uint8_t base, uint8_t index, uint8_t scale, int64_t disp) : segment(segment), base(base), index(index), scale(scale), size(0), disp(disp) {} };
 struct nmd_x86_operand2 { uint8_t type; bool is_implicit; uint8_t action; union UN { uint8_t reg; int64_t imm; nmd_x86_memory_operand2 mem; UN() {} } fields; nmd_x86_operand2() : type(0), is_implicit(0), action(0) {}nmd_x86_operand2(uint8_t type, bool is_implicit, uint8_t action, int64_t x) : type(type), is_implicit(is_implicit), action(action) { fields.imm = x; }nmd_x86_operand2(uint8_t type, bool is_implicit, uint8_t action, nmd_x86_memory_operand2 mem) : type(type), is_implicit(is_implicit), action(action) { fields.mem = mem; } };
 struct nmd_x86_instruction2 { bool valid : 1; bool has_modrm : 1; bool has_sib : 1; bool has_rex : 1; bool rex_w_prefix : 1; bool repeat_prefix : 1; uint8_t mode; uint8_t length; uint8_t opcode; uint8_t opcode_size; uint16_t id; uint16_t prefixes; uint8_t num_prefixes; uint8_t num_operands; uint8_t group; uint8_t buffer[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH]; nmd_x86_operand2 operands[NMD_X86_MAXIMUM_NUM_OPERANDS]; nmd_x86_modrm2 modrm; nmd_x86_sib sib; uint8_t imm_mask; uint8_t disp_mask; uint64_t immediate; uint32_t displacement; uint8_t opcode_map; uint8_t encoding; nmd_x86_vex vex; nmd_x86_cpu_flags modified_flags; nmd_x86_cpu_flags tested_flags; nmd_x86_cpu_flags set_flags; nmd_x86_cpu_flags cleared_flags; nmd_x86_cpu_flags undefined_flags; uint8_t rex; uint8_t segment_override; uint16_t simd_prefix; };
 
@@ -955,6 +966,30 @@ TEST(side_tests_suite, side_tests)
 	{ SCOPED_TRACE("'jo 0x7fff' MODE:16"); buffer[0] = 0x0f; buffer[1] = 0x80; *(int32_t*)(buffer + 2) = 0x7fff; EXPECT_EQ(nmd_x86_decode(buffer, 4, &i, MODE_16, NMD_X86_DECODER_FLAGS_ALL), true); EXPECT_EQ(i.immediate, 0x0000000000007fff); }
 	{ SCOPED_TRACE("'jo 0x7fff' MODE:16"); buffer[0] = 0x0f; buffer[1] = 0x80; *(int32_t*)(buffer + 2) = 0x8000; EXPECT_EQ(nmd_x86_decode(buffer, 4, &i, MODE_16, NMD_X86_DECODER_FLAGS_ALL), true); EXPECT_EQ(i.immediate, 0xffffffffffff8000); }
 
+	/* AT&T syntax with a segment override and no pointer size. */
+	{
+		char string[NMD_X86_FORMATTER_MAX_LENGTH];
+		{ SCOPED_TRACE("'sar cs:[rdx],cl' AT&T MODE:64"); buffer[0] = 0x2e; buffer[1] = 0xd3; buffer[2] = 0x3a; EXPECT_EQ(nmd_x86_decode(buffer, 3, &i, MODE_64, NMD_X86_DECODER_FLAGS_ALL), true); nmd_x86_format(&i, string, NMD_X86_INVALID_RUNTIME_ADDRESS, NMD_X86_FORMAT_FLAGS_DEFAULT | NMD_X86_FORMAT_FLAGS_ATT_SYNTAX); EXPECT_STREQ(string, "sarq %cl,%cs:(%rdx)"); }
+		{ SCOPED_TRACE("'bt [rax],ecx' AT&T MODE:64"); buffer[0] = 0x0f; buffer[1] = 0xa3; buffer[2] = 0x08; EXPECT_EQ(nmd_x86_decode(buffer, 3, &i, MODE_64, NMD_X86_DECODER_FLAGS_ALL), true); nmd_x86_format(&i, string, NMD_X86_INVALID_RUNTIME_ADDRESS, NMD_X86_FORMAT_FLAGS_ATT_SYNTAX); EXPECT_GT(strlen(string), 0u); }
+	}
+
+	/* Found by tests/assembly_fuzzer.c */
+	{
+		char string[NMD_X86_FORMATTER_MAX_LENGTH];
+		{ SCOPED_TRACE("'bound eax,qword ptr [eax]' MODE:32"); buffer[0] = 0x62; buffer[1] = 0x00; EXPECT_EQ(nmd_x86_ldisasm(buffer, 2, MODE_32), 2); EXPECT_EQ(nmd_x86_decode(buffer, 2, &i, MODE_32, NMD_X86_DECODER_FLAGS_ALL), true); nmd_x86_format(&i, string, NMD_X86_INVALID_RUNTIME_ADDRESS, NMD_X86_FORMAT_FLAGS_DEFAULT | NMD_X86_FORMAT_FLAGS_POINTER_SIZE); EXPECT_STREQ(string, "bound eax,qword ptr [eax]"); }
+		{ SCOPED_TRACE("'62 C0'(EVEX) MODE:32"); buffer[0] = 0x62; buffer[1] = 0xc0; EXPECT_EQ(nmd_x86_ldisasm(buffer, 2, MODE_32), 0); EXPECT_EQ(nmd_x86_decode(buffer, 2, &i, MODE_32, NMD_X86_DECODER_FLAGS_ALL), false); }
+		{ SCOPED_TRACE("'movdqa xmm1,[rsi]'(F2 66) MODE:64"); buffer[0] = 0xf2; buffer[1] = 0x66; buffer[2] = 0x0f; buffer[3] = 0x6f; buffer[4] = 0x0e; EXPECT_EQ(nmd_x86_ldisasm(buffer, 5, MODE_64), 5); EXPECT_EQ(nmd_x86_decode(buffer, 5, &i, MODE_64, NMD_X86_DECODER_FLAGS_ALL), true); }
+		{ SCOPED_TRACE("'add ax,1234h' MODE:16"); buffer[0] = 0x05; buffer[1] = 0x34; buffer[2] = 0x12; EXPECT_EQ(nmd_x86_decode(buffer, 3, &i, MODE_16, NMD_X86_DECODER_FLAGS_ALL), true); nmd_x86_format(&i, string, NMD_X86_INVALID_RUNTIME_ADDRESS, NMD_X86_FORMAT_FLAGS_DEFAULT); EXPECT_STREQ(string, "add ax,1234h"); }
+		{ SCOPED_TRACE("'inc word ptr [bx]' MODE:16"); buffer[0] = 0xff; buffer[1] = 0x07; EXPECT_EQ(nmd_x86_decode(buffer, 2, &i, MODE_16, NMD_X86_DECODER_FLAGS_ALL), true); nmd_x86_format(&i, string, NMD_X86_INVALID_RUNTIME_ADDRESS, NMD_X86_FORMAT_FLAGS_DEFAULT | NMD_X86_FORMAT_FLAGS_POINTER_SIZE); EXPECT_STREQ(string, "inc word ptr [bx]"); }
+		{ SCOPED_TRACE("'mov eax,[rip+10h]' MODE:64"); buffer[0] = 0x8b; buffer[1] = 0x05; *(uint32_t*)(buffer + 2) = 0x10; EXPECT_EQ(nmd_x86_decode(buffer, 6, &i, MODE_64, NMD_X86_DECODER_FLAGS_ALL), true); nmd_x86_format(&i, string, NMD_X86_INVALID_RUNTIME_ADDRESS, NMD_X86_FORMAT_FLAGS_DEFAULT | NMD_X86_FORMAT_FLAGS_POINTER_SIZE); EXPECT_STREQ(string, "mov eax,dword ptr [rip+10h]"); }
+		{ SCOPED_TRACE("'xchg r8,rax' MODE:64"); buffer[0] = 0x49; buffer[1] = 0x90; EXPECT_EQ(nmd_x86_decode(buffer, 2, &i, MODE_64, NMD_X86_DECODER_FLAGS_ALL), true); EXPECT_EQ(i.num_operands, 2); EXPECT_EQ(i.operands[0].fields.reg, NMD_X86_REG_R8); EXPECT_EQ(i.operands[1].fields.reg, NMD_X86_REG_RAX); }
+		{ SCOPED_TRACE("'mov ax,[bp+si+4]' MODE:16"); buffer[0] = 0x8b; buffer[1] = 0x42; buffer[2] = 0x04; EXPECT_EQ(nmd_x86_decode(buffer, 3, &i, MODE_16, NMD_X86_DECODER_FLAGS_ALL), true); EXPECT_EQ(i.operands[1].fields.mem.segment, NMD_X86_REG_SS); EXPECT_EQ(i.operands[1].fields.mem.base, NMD_X86_REG_BP); EXPECT_EQ(i.operands[1].fields.mem.index, NMD_X86_REG_SI); EXPECT_EQ(i.operands[1].fields.mem.disp, 4); }
+		{ SCOPED_TRACE("'add [DDFEh],ax' MODE:16"); buffer[0] = 0x01; buffer[1] = 0x06; buffer[2] = 0xfe; buffer[3] = 0xdd; EXPECT_EQ(nmd_x86_decode(buffer, 4, &i, MODE_16, NMD_X86_DECODER_FLAGS_ALL), true); EXPECT_EQ(i.operands[0].fields.mem.base, NMD_X86_REG_NONE); EXPECT_EQ(i.operands[0].fields.mem.disp, 0xddfe); }
+		{ SCOPED_TRACE("'add [eax*8+10h],eax' MODE:32"); EXPECT_EQ(nmd_x86_assemble("add dword ptr [eax*8+0x10],eax", buffer, sizeof(buffer), NMD_X86_INVALID_RUNTIME_ADDRESS, MODE_32, 0), 7); EXPECT_EQ(buffer[1], 0x04); EXPECT_EQ(buffer[2], 0xc5); }
+		{ SCOPED_TRACE("'add eax,1' MODE:32"); EXPECT_EQ(nmd_x86_assemble("add eax,1", buffer, sizeof(buffer), NMD_X86_INVALID_RUNTIME_ADDRESS, MODE_32, 0), 3); EXPECT_EQ(buffer[0], 0x83); }
+		{ SCOPED_TRACE("'add rax,FFFFFFFFFFFFFFFFh' MODE:64"); EXPECT_EQ(nmd_x86_assemble("add rax,0xFFFFFFFFFFFFFFFF", buffer, sizeof(buffer), NMD_X86_INVALID_RUNTIME_ADDRESS, MODE_64, 0), 4); EXPECT_EQ(buffer[3], 0xff); }
+	}
+
 	/* Invalid instructions. */
 	{ SCOPED_TRACE("'into' MODE:64");           buffer[0] = 0xce; EXPECT_EQ(nmd_x86_ldisasm(buffer, 15, MODE_64), 0); EXPECT_EQ(nmd_x86_decode(buffer, 15, &i, MODE_64, NMD_X86_DECODER_FLAGS_ALL), false); }
 	{ SCOPED_TRACE("'push es' MODE:64");        buffer[0] = 0x06; EXPECT_EQ(nmd_x86_ldisasm(buffer, 15, MODE_64), 0); EXPECT_EQ(nmd_x86_decode(buffer, 15, &i, MODE_64, NMD_X86_DECODER_FLAGS_ALL), false); }
@@ -987,6 +1022,868 @@ TEST(side_tests_suite, side_tests)
 	{ SCOPED_TRACE("'4fh REX prefix' MODE:64"); buffer[0] = 0x4f; EXPECT_EQ(nmd_x86_ldisasm(buffer, 1,  MODE_64), 0); EXPECT_EQ(nmd_x86_decode(buffer, 1, &i,  MODE_64, NMD_X86_DECODER_FLAGS_ALL), false); }
 }
 
+TEST(side_tests_suite, buffer_tests)
+{
+	// xor eax,eax; inc eax; push 0deadbeefh; jmp $+2; ret; 0fh(truncated)
+	const uint8_t code[] = { 0x33, 0xc0, 0x40, 0x68, 0xef, 0xbe, 0xad, 0xde, 0xeb, 0x00, 0xc3, 0x0f };
+	nmd_x86_instruction instructions[8], instruction;
+	nmd_x86_buffer_info info;
+	memset(instructions, 0, sizeof(instructions));
+
+	EXPECT_EQ(nmd_x86_decode_buffer(code, sizeof(code), 0x1000, MODE_32, NMD_X86_DECODER_FLAGS_ALL, instructions, 8, &info), 5);
+	EXPECT_EQ(info.status, NMD_X86_BUFFER_STATUS_INVALID);
+	EXPECT_EQ(info.offset, sizeof(code) - 1);
+	EXPECT_EQ(info.runtime_address, 0x1000 + sizeof(code) - 1);
+
+	for (size_t j = 0, offset = 0; j < 5; offset += instructions[j++].length)
+	{
+		memset(&instruction, 0, sizeof(instruction));
+		EXPECT_TRUE(nmd_x86_decode(code + offset, sizeof(code) - offset, &instruction, MODE_32, NMD_X86_DECODER_FLAGS_ALL));
+		EXPECT_EQ(memcmp(&instruction, &instructions[j], sizeof(instruction)), 0);
+	}
+
+	EXPECT_EQ(nmd_x86_decode_buffer(code, sizeof(code) - 1, NMD_X86_INVALID_RUNTIME_ADDRESS, MODE_32, NMD_X86_DECODER_FLAGS_MINIMAL, instructions, 8, &info), 5);
+	EXPECT_EQ(info.status, NMD_X86_BUFFER_STATUS_END);
+	EXPECT_EQ(info.runtime_address, NMD_X86_INVALID_RUNTIME_ADDRESS);
+
+	EXPECT_EQ(nmd_x86_decode_buffer(code, sizeof(code), 0, MODE_32, NMD_X86_DECODER_FLAGS_MINIMAL, instructions, 2, &info), 2);
+	EXPECT_EQ(info.status, NMD_X86_BUFFER_STATUS_OUTPUT_FULL);
+	EXPECT_EQ(info.offset, 3);
+}
+
+TEST(side_tests_suite, zero_copy_tests)
+{
+	// xor eax,eax; inc eax; push 0deadbeefh; jmp $+2; ret
+	const uint8_t code[] = { 0x33, 0xc0, 0x40, 0x68, 0xef, 0xbe, 0xad, 0xde, 0xeb, 0x00, 0xc3 };
+	nmd_x86_instruction instructions[5], copied[5];
+	char expected[NMD_X86_FORMATTER_MAX_LENGTH], string[NMD_X86_FORMATTER_MAX_LENGTH];
+	memset(instructions, 0xcc, sizeof(instructions));
+
+	ASSERT_EQ(nmd_x86_decode_buffer(code, sizeof(code), 0x1000, MODE_32, NMD_X86_DECODER_FLAGS_ALL | NMD_X86_DECODER_FLAGS_ZERO_COPY, instructions, 5, NULL), 5);
+	ASSERT_EQ(nmd_x86_decode_buffer(code, sizeof(code), 0x1000, MODE_32, NMD_X86_DECODER_FLAGS_ALL, copied, 5, NULL), 5);
+	for (size_t i = 0, offset = 0; i < 5; offset += instructions[i++].length)
+	{
+		SCOPED_TRACE(i);
+		EXPECT_EQ(instructions[i].source, code + offset);
+		EXPECT_EQ(copied[i].source, (const uint8_t*)NULL);
+		EXPECT_EQ(instructions[i].length, copied[i].length);
+		EXPECT_EQ(instructions[i].id, copied[i].id);
+
+		/* The formatter reads the bytes from the decoded buffer */
+		nmd_x86_format(&copied[i], expected, 0x1000 + offset, NMD_X86_FORMAT_FLAGS_DEFAULT | NMD_X86_FORMAT_FLAGS_BYTES);
+		nmd_x86_format(&instructions[i], string, 0x1000 + offset, NMD_X86_FORMAT_FLAGS_DEFAULT | NMD_X86_FORMAT_FLAGS_BYTES);
+		EXPECT_STREQ(string, expected);
+	}
+}
+
+TEST(side_tests_suite, light_tests)
+{
+	// jmp $+5; mov eax, [rip+0x10]; lock inc dword ptr [rax]; rep movsb; call $-5
+	const uint8_t code[] = { 0xeb, 0x03, 0x8b, 0x05, 0x10, 0x00, 0x00, 0x00, 0xf0, 0xff, 0x00, 0xf3, 0xa4, 0xe8, 0xf6, 0xff, 0xff, 0xff };
+	nmd_x86_light_instruction lights[8];
+	nmd_x86_instruction instruction;
+	nmd_x86_buffer_info info;
+
+	EXPECT_EQ(nmd_x86_decode_buffer_light(code, sizeof(code), 0x1000, MODE_64, NMD_X86_DECODER_FLAGS_ALL, lights, 8, &info), 5);
+	EXPECT_EQ(info.status, NMD_X86_BUFFER_STATUS_END);
+	EXPECT_EQ(info.offset, sizeof(code));
+
+	EXPECT_EQ(lights[0].id, NMD_X86_INSTRUCTION_JMP);
+	EXPECT_TRUE(lights[0].flags & NMD_X86_LIGHT_FLAGS_BRANCH_TARGET);
+	EXPECT_EQ(lights[0].branch_target, 0x1005);
+
+	EXPECT_EQ(lights[1].id, NMD_X86_INSTRUCTION_MOV);
+	EXPECT_TRUE(lights[1].flags & NMD_X86_LIGHT_FLAGS_MEMORY_OPERAND);
+	EXPECT_EQ(lights[1].base, NMD_X86_REG_RIP);
+	EXPECT_EQ(lights[1].displacement, 0x10);
+
+	EXPECT_TRUE(lights[2].flags & NMD_X86_LIGHT_FLAGS_LOCK);
+	EXPECT_EQ(lights[2].base, NMD_X86_REG_RAX);
+	EXPECT_TRUE(lights[3].flags & NMD_X86_LIGHT_FLAGS_REPEAT);
+
+	EXPECT_EQ(lights[4].id, NMD_X86_INSTRUCTION_CALL);
+	EXPECT_EQ(lights[4].branch_target, 0x1008);
+
+	// Compare against the full decoder
+	uint8_t buffer[15];
+	const NMD_X86_MODE modes[] = { NMD_X86_MODE_16, NMD_X86_MODE_32, NMD_X86_MODE_64 };
+	uint32_t seed = 1;
+	for (size_t i = 0; i < 100000; i++)
+	{
+		for (size_t j = 0; j < sizeof(buffer); j++)
+			buffer[j] = (uint8_t)((seed = seed * 1103515245 + 12345) >> 16);
+
+		for (size_t j = 0; j < 3; j++)
+		{
+			const bool valid = nmd_x86_decode(buffer, sizeof(buffer), &instruction, modes[j], NMD_X86_DECODER_FLAGS_ALL);
+			ASSERT_EQ(nmd_x86_decode_light(buffer, sizeof(buffer), NMD_X86_INVALID_RUNTIME_ADDRESS, lights, modes[j], NMD_X86_DECODER_FLAGS_ALL), valid);
+			if (!valid)
+				continue;
+
+			SCOPED_TRACE(testing::Message() << "mode " << (int)modes[j] << ", bytes " << testing::PrintToString(std::vector<uint8_t>(buffer, buffer + instruction.length)));
+			EXPECT_EQ(lights[0].length, instruction.length);
+			EXPECT_EQ(lights[0].id, instruction.id);
+			EXPECT_EQ(lights[0].group, instruction.group);
+			EXPECT_EQ(lights[0].opcode, instruction.opcode);
+			EXPECT_EQ(lights[0].opcode_map, instruction.opcode_map);
+
+			// The ModR/M memory operand, if the full decoder describes it(moffs operands aren't part of the light record)
+			const bool has_memory_operand = instruction.has_modrm && instruction.modrm.fields.mod != 0b11;
+			EXPECT_EQ((lights[0].flags & NMD_X86_LIGHT_FLAGS_MEMORY_OPERAND) != 0, has_memory_operand);
+			for (size_t k = 0; has_memory_operand && k < instruction.num_operands; k++)
+			{
+				const nmd_x86_operand& operand = instruction.operands[k];
+				if (operand.type != NMD_X86_OPERAND_TYPE_MEMORY || operand.is_implicit)
+					continue;
+
+				EXPECT_EQ(lights[0].segment, operand.fields.mem.segment);
+				EXPECT_EQ(lights[0].base, operand.fields.mem.base);
+				EXPECT_EQ(lights[0].index, operand.fields.mem.index);
+				EXPECT_EQ(lights[0].scale, operand.fields.mem.scale);
+				EXPECT_EQ(lights[0].displacement, operand.fields.mem.disp);
+				break;
+			}
+
+			// Relative branches
+			const bool is_relative_branch = (instruction.group & NMD_GROUP_BRANCH) && (instruction.group & NMD_GROUP_RELATIVE_ADDRESSING) && instruction.imm_mask && instruction.imm_mask <= NMD_X86_IMM32;
+			ASSERT_EQ((lights[0].flags & NMD_X86_LIGHT_FLAGS_BRANCH_TARGET) != 0, is_relative_branch);
+			if (is_relative_branch)
+			{
+				const int64_t relative = instruction.imm_mask == NMD_X86_IMM8 ? (int8_t)instruction.immediate : (instruction.imm_mask == NMD_X86_IMM16 ? (int16_t)instruction.immediate : (int32_t)instruction.immediate);
+				EXPECT_EQ(lights[0].branch_target, (uint64_t)(relative + instruction.length));
+			}
+		}
+	}
+}
+
+TEST(side_tests_suite, opcode_tables_tests)
+{
+	// The tables must be regenerated every time the decoder's logic changes
+	using namespace opcode_tables_generator;
+	generate_tables();
+
+	for (size_t mode = 0; mode < 3; mode++)
+	{
+		for (size_t i = 0; i < 256; i++)
+		{
+			SCOPED_TRACE(testing::Message() << "mode " << mode << ", opcode " << i);
+			EXPECT_EQ(memcmp(&_nmd_x86_op1_info[mode][i], &op_info[0][mode][i], sizeof(_nmd_x86_opcode_info)), 0);
+			EXPECT_EQ(memcmp(&_nmd_x86_op2_info[mode][i], &op_info[1][mode][i], sizeof(_nmd_x86_opcode_info)), 0);
+			EXPECT_EQ(_nmd_x86_ldisasm_op1_flags[mode][i], ldisasm_flags[0][mode][i]);
+			EXPECT_EQ(_nmd_x86_ldisasm_op2_flags[mode][i], ldisasm_flags[1][mode][i]);
+		}
+	}
+
+	ASSERT_EQ(sizeof(_nmd_x86_opcode_extensions) / sizeof(*_nmd_x86_opcode_extensions), num_extensions);
+	EXPECT_EQ(memcmp(_nmd_x86_opcode_extensions, extensions, sizeof(_nmd_x86_opcode_extensions)), 0);
+	EXPECT_EQ(memcmp(_nmd_x86_prefix_classes, prefix_classes, sizeof(prefix_classes)), 0);
+	EXPECT_EQ(_nmd_x86_asm_mnemonic_hash_seed, mnemonic_hash_seed);
+	EXPECT_EQ(memcmp(_nmd_x86_asm_mnemonic_hash_table, mnemonic_hash_table, sizeof(mnemonic_hash_table)), 0);
+	EXPECT_EQ(_nmd_x86_asm_reg_hash_seed, reg_hash_seed);
+	EXPECT_EQ(memcmp(_nmd_x86_asm_reg_hash_table, reg_hash_table, sizeof(reg_hash_table)), 0);
+	ASSERT_EQ(sizeof(_nmd_x86_mnemonics), mnemonic_strings_size + MNEMONIC_PADDING);
+	EXPECT_EQ(memcmp(_nmd_x86_mnemonics, mnemonic_strings, sizeof(_nmd_x86_mnemonics)), 0);
+	EXPECT_EQ(memcmp(_nmd_x86_mnemonic_offsets, mnemonic_offsets, sizeof(mnemonic_offsets)), 0);
+
+	// The formatter gives the same string with the mnemonic table as with the mnemonics chosen by opcode(id cleared)
+	uint8_t buffer[15];
+	nmd_x86_instruction instruction;
+	char expected_string[NMD_X86_FORMATTER_MAX_LENGTH], string[NMD_X86_FORMATTER_MAX_LENGTH];
+	uint32_t seed = 1;
+	for (size_t i = 0; i < 100000; i++)
+	{
+		for (size_t j = 0; j < sizeof(buffer); j++)
+			buffer[j] = (uint8_t)((seed = seed * 1103515245 + 12345) >> 16);
+
+		for (size_t mode = 0; mode < 3; mode++)
+		{
+			if (!nmd_x86_decode(buffer, sizeof(buffer), &instruction, modes[mode], NMD_X86_DECODER_FLAGS_ALL))
+				continue;
+
+			nmd_x86_format(&instruction, string, 0x1000, NMD_X86_FORMAT_FLAGS_DEFAULT);
+			const uint16_t id = instruction.id;
+			instruction.id = 0;
+			nmd_x86_format(&instruction, expected_string, 0x1000, NMD_X86_FORMAT_FLAGS_DEFAULT);
+			EXPECT_STREQ(string, expected_string) << "id " << id;
+		}
+	}
+
+	// test al,al: the table-driven decoder agrees with the full decoder
+	const uint8_t test_al_al[] = { 0x84, 0xc0 };
+	nmd_x86_light_instruction light;
+	ASSERT_TRUE(nmd_x86_decode_light(test_al_al, sizeof(test_al_al), NMD_X86_INVALID_RUNTIME_ADDRESS, &light, NMD_X86_MODE_32, NMD_X86_DECODER_FLAGS_ALL));
+	EXPECT_EQ(light.id, NMD_X86_INSTRUCTION_TEST);
+}
+
+TEST(side_tests_suite, specialized_decoder_tests)
+{
+	// Compare the specialized decoders against the generic one
+	uint8_t buffer[15];
+	nmd_x86_instruction expected, instruction;
+	uint32_t seed = 1;
+	for (size_t i = 0; i < 100000; i++)
+	{
+		for (size_t j = 0; j < sizeof(buffer); j++)
+			buffer[j] = (uint8_t)((seed = seed * 1103515245 + 12345) >> 16);
+
+		memset(&instruction, 0xcc, sizeof(instruction));
+		EXPECT_EQ(nmd_x86_decode_32_full(buffer, sizeof(buffer), &instruction), nmd_x86_decode(buffer, sizeof(buffer), &expected, MODE_32, NMD_X86_DECODER_FLAGS_ALL));
+		EXPECT_EQ(memcmp(&instruction, &expected, offsetof(nmd_x86_instruction, buffer)), 0);
+		EXPECT_EQ(memcmp(instruction.buffer, expected.buffer, expected.length), 0);
+		EXPECT_EQ(memcmp(&instruction.operands, &expected.operands, sizeof(instruction) - offsetof(nmd_x86_instruction, operands)), 0);
+
+		EXPECT_EQ(nmd_x86_decode_64_minimal(buffer, sizeof(buffer), &instruction), nmd_x86_decode(buffer, sizeof(buffer), &expected, MODE_64, NMD_X86_DECODER_FLAGS_MINIMAL));
+		EXPECT_EQ(instruction.length, expected.length);
+		EXPECT_EQ(instruction.prefixes, expected.prefixes);
+		EXPECT_EQ(memcmp(instruction.buffer, expected.buffer, expected.length), 0);
+	}
+}
+
+TEST(side_tests_suite, ldisasm_tests)
+{
+	// xor eax,eax; mov rax, 0x1122334455667788; lock add dword ptr [rax], 1; 66 mov ax, 1; 0fh(truncated)
+	const uint8_t code[] = { 0x33, 0xc0, 0x48, 0xb8, 0x88, 0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11, 0xf0, 0x83, 0x00, 0x01, 0x66, 0xb8, 0x01, 0x00, 0x0f };
+	uint8_t lengths[8];
+	nmd_x86_buffer_info info;
+
+	EXPECT_EQ(nmd_x86_ldisasm_buffer(code, sizeof(code), MODE_64, lengths, 8, &info), 4);
+	EXPECT_EQ(info.status, NMD_X86_BUFFER_STATUS_INVALID);
+	EXPECT_EQ(info.offset, sizeof(code) - 1);
+	EXPECT_EQ(lengths[0], 2);
+	EXPECT_EQ(lengths[1], 10);
+	EXPECT_EQ(lengths[2], 4);
+	EXPECT_EQ(lengths[3], 4);
+
+	EXPECT_EQ(nmd_x86_ldisasm_buffer(code, sizeof(code) - 1, MODE_64, lengths, 2, &info), 2);
+	EXPECT_EQ(info.status, NMD_X86_BUFFER_STATUS_OUTPUT_FULL);
+	EXPECT_EQ(info.offset, 12);
+
+	// A REX prefix is ignored if it's not the last prefix(mov ebx, imm32) and mov to/from debug registers ignores the 'mod' field
+	const uint8_t rex[] = { 0x48, 0x46, 0xbb, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+	const uint8_t rex_legacy[] = { 0x48, 0xf3, 0xbb, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+	const uint8_t mov_dr[] = { 0x0f, 0x23, 0x6f, 0x00, 0x00 };
+	nmd_x86_instruction instruction;
+	EXPECT_EQ(nmd_x86_ldisasm(rex, sizeof(rex), MODE_64), 7);
+	EXPECT_EQ(_nmd_ldisasm(rex, sizeof(rex), MODE_64), 7);
+	EXPECT_EQ(nmd_x86_ldisasm(rex_legacy, sizeof(rex_legacy), MODE_64), 7);
+	EXPECT_EQ(_nmd_ldisasm(rex_legacy, sizeof(rex_legacy), MODE_64), 7);
+	EXPECT_TRUE(nmd_x86_decode(rex_legacy, sizeof(rex_legacy), &instruction, MODE_64, NMD_X86_DECODER_FLAGS_ALL));
+	EXPECT_EQ(instruction.length, 7);
+	EXPECT_EQ(instruction.operands[0].fields.reg, NMD_X86_REG_EBX);
+	EXPECT_EQ(nmd_x86_ldisasm(mov_dr, sizeof(mov_dr), MODE_32), 3);
+	EXPECT_TRUE(nmd_x86_decode(mov_dr, sizeof(mov_dr), &instruction, MODE_32, NMD_X86_DECODER_FLAGS_ALL));
+	EXPECT_EQ(instruction.length, 3);
+
+	// Compare the table-driven length disassembler against the branch-based one
+	uint8_t buffer[15];
+	const NMD_X86_MODE modes[] = { NMD_X86_MODE_16, NMD_X86_MODE_32, NMD_X86_MODE_64 };
+	uint32_t seed = 1;
+	for (size_t i = 0; i < 100000; i++)
+	{
+		for (size_t j = 0; j < sizeof(buffer); j++)
+			buffer[j] = (uint8_t)((seed = seed * 1103515245 + 12345) >> 16);
+
+		for (size_t j = 0; j < 3; j++)
+			EXPECT_EQ(nmd_x86_ldisasm(buffer, sizeof(buffer), modes[j]), _nmd_ldisasm(buffer, sizeof(buffer), modes[j]));
+	}
+
+	// With 16 or more bytes the prefixes are classified by the SSE2 path(if 'NMD_ASSEMBLY_ENABLE_LENGTH_DISASSEMBLER_SSE2' is defined), with 15 by the scalar one.
+	// Most bytes are prefixes, so long runs of mixed prefixes and REX prefixes in the middle of a run are covered.
+	const uint8_t prefixes[] = { 0x66, 0x67, 0xf0, 0xf2, 0xf3, 0x26, 0x2e, 0x36, 0x3e, 0x64, 0x65, 0x40, 0x41, 0x48, 0x4f };
+	uint8_t buffer16[16];
+	for (size_t i = 0; i < 100000; i++)
+	{
+		for (size_t j = 0; j < sizeof(buffer16); j++)
+		{
+			seed = seed * 1103515245 + 12345;
+			buffer16[j] = (seed >> 28) < 12 ? prefixes[(seed >> 16) % sizeof(prefixes)] : (uint8_t)(seed >> 16);
+		}
+
+		for (size_t j = 0; j < 3; j++)
+		{
+			EXPECT_EQ(nmd_x86_ldisasm(buffer16, sizeof(buffer16), modes[j]), nmd_x86_ldisasm(buffer16, 15, modes[j]));
+#ifdef NMD_ASSEMBLY_ENABLE_LENGTH_DISASSEMBLER_SSE2
+			uint8_t classes, classes_sse2;
+			const size_t num_prefixes = _nmd_ldisasm_scan_prefixes(buffer16, sizeof(buffer16), modes[j], &classes);
+			EXPECT_EQ(_nmd_ldisasm_scan_prefixes_sse2(buffer16, modes[j], &classes_sse2), num_prefixes);
+			EXPECT_EQ(classes_sse2, classes);
+#endif /* NMD_ASSEMBLY_ENABLE_LENGTH_DISASSEMBLER_SSE2 */
+		}
+	}
+}
+
+TEST(side_tests_suite, parallel_tests)
+{
+	// Random bytes make the streams of most chunks start in the middle of an instruction
+	const size_t size = 200000;
+	std::vector<uint8_t> buffer(size), lengths(size), expected(size, 0);
+	uint32_t seed = 1;
+	for (size_t i = 0; i < size; i++)
+		buffer[i] = (uint8_t)((seed = seed * 1103515245 + 12345) >> 16);
+
+	size_t num_valid = 0;
+	for (size_t offset = 0; offset < size;)
+	{
+		const size_t length = nmd_x86_ldisasm(&buffer[offset], size - offset, MODE_64);
+		expected[offset] = (uint8_t)length;
+		num_valid += length ? 1 : 0;
+		offset += length ? length : 1;
+	}
+
+	for (size_t num_threads = 1; num_threads <= 8; num_threads += 7)
+	{
+		EXPECT_EQ(nmd_x86_ldisasm_parallel(&buffer[0], size, MODE_64, &lengths[0], num_threads), num_valid);
+		EXPECT_TRUE(lengths == expected);
+	}
+
+	std::vector<nmd_x86_instruction> instructions(size);
+	num_valid = nmd_x86_decode_parallel(&buffer[0], size, MODE_32, NMD_X86_DECODER_FLAGS_ALL, &lengths[0], &instructions[0], size, 4);
+	size_t index = 0;
+	for (size_t offset = 0; offset < size;)
+	{
+		nmd_x86_instruction instruction;
+		if (nmd_x86_decode(&buffer[offset], size - offset, &instruction, MODE_32, NMD_X86_DECODER_FLAGS_ALL))
+		{
+			EXPECT_EQ(lengths[offset], instruction.length);
+			EXPECT_EQ(memcmp(&instruction, &instructions[index++], sizeof(instruction)), 0);
+			offset += instruction.length;
+		}
+		else
+		{
+			EXPECT_EQ(lengths[offset], 0);
+			offset++;
+		}
+	}
+	EXPECT_EQ(index, num_valid);
+}
+
+TEST(side_tests_suite, pipeline_tests)
+{
+	const size_t size = 30000;
+	const uint64_t addresses[2] = { 0x400000, 0x800000 };
+	const uint32_t format_flags = NMD_X86_FORMAT_FLAGS_DEFAULT | NMD_X86_FORMAT_FLAGS_ADDRESS;
+	std::vector<uint8_t> buffer(size);
+	uint32_t seed = 7;
+	for (size_t i = 0; i < size; i++)
+		buffer[i] = (uint8_t)((seed = seed * 1103515245 + 12345) >> 16);
+
+	// The buffer is disassembled as two streams, the second one starts at an unrelated address
+	std::vector<nmd_x86_pipeline_line> expected;
+	for (size_t stream = 0; stream < 2; stream++)
+	{
+		const size_t begin = stream * (size / 2), end = begin + size / 2;
+		for (size_t offset = begin; offset < end;)
+		{
+			const size_t length = nmd_x86_ldisasm(&buffer[offset], end - offset, MODE_64);
+			nmd_x86_instruction instruction;
+			if (length && nmd_x86_decode(&buffer[offset], length, &instruction, MODE_64, NMD_X86_DECODER_FLAGS_ALL))
+			{
+				nmd_x86_pipeline_line line;
+				line.runtime_address = addresses[stream] + offset - begin;
+				line.length = nmd_x86_format_ex(&instruction, line.string, sizeof(line.string), line.runtime_address, format_flags);
+				expected.push_back(line);
+			}
+			offset += length ? length : 1;
+		}
+	}
+
+	// Small rings, so the producer and the stages wait for each other
+	std::vector<uint8_t> memory(NMD_X86_PIPELINE_MEMORY_SIZE(32));
+	nmd_x86_pipeline pipeline;
+	EXPECT_EQ(nmd_x86_pipeline_start(&pipeline, MODE_64, NMD_X86_DECODER_FLAGS_ALL, format_flags, &memory[0], 100), 0);
+	ASSERT_EQ(nmd_x86_pipeline_start(&pipeline, MODE_64, NMD_X86_DECODER_FLAGS_ALL, format_flags, &memory[0], memory.size()), 32);
+
+	// Push the streams in chunks of irregular sizes, so instructions are split between pushes
+	std::vector<nmd_x86_pipeline_line> lines;
+	nmd_x86_pipeline_line batch[16];
+	size_t stream = 0, offset = 0, chunk = 1;
+	while (!nmd_x86_pipeline_finished(&pipeline))
+	{
+		if (stream < 2)
+		{
+			const size_t begin = stream * (size / 2), end = begin + size / 2;
+			const size_t num_bytes = std::min(chunk, end - begin - offset);
+			offset += nmd_x86_pipeline_push(&pipeline, &buffer[begin + offset], num_bytes, addresses[stream] + offset);
+			chunk = (chunk * 7 + 3) % 700 + 1;
+			if (offset == end - begin)
+			{
+				offset = 0;
+				if (++stream == 2)
+					nmd_x86_pipeline_close(&pipeline);
+			}
+		}
+
+		const size_t num_lines = nmd_x86_pipeline_pop(&pipeline, batch, 16);
+		lines.insert(lines.end(), batch, batch + num_lines);
+	}
+	nmd_x86_pipeline_stop(&pipeline);
+
+	ASSERT_EQ(lines.size(), expected.size());
+	for (size_t i = 0; i < lines.size(); i++)
+	{
+		EXPECT_EQ(lines[i].runtime_address, expected[i].runtime_address);
+		EXPECT_EQ(lines[i].length, expected[i].length);
+		EXPECT_STREQ(lines[i].string, expected[i].string);
+	}
+}
+
+TEST(side_tests_suite, format_ex_tests)
+{
+	// mov eax,12345678h; mov eax,5; add dword ptr [ebx+12h],0ah
+	const uint8_t code[] = { 0xb8, 0x78, 0x56, 0x34, 0x12, 0xb8, 0x05, 0x00, 0x00, 0x00, 0x83, 0x43, 0x12, 0x0a };
+	const uint32_t flags[] = { NMD_X86_FORMAT_FLAGS_DEFAULT, NMD_X86_FORMAT_FLAGS_DEFAULT | NMD_X86_FORMAT_FLAGS_BYTES | NMD_X86_FORMAT_FLAGS_UPPERCASE | NMD_X86_FORMAT_FLAGS_COMMA_SPACES | NMD_X86_FORMAT_FLAGS_OPERATOR_SPACES, NMD_X86_FORMAT_FLAGS_ATT_SYNTAX, 0, NMD_X86_FORMAT_FLAGS_HEX | NMD_X86_FORMAT_FLAGS_HEX_LOWERCASE | NMD_X86_FORMAT_FLAGS_0X_PREFIX };
+	nmd_x86_instruction instruction;
+	char expected[NMD_X86_FORMATTER_MAX_LENGTH], buffer[NMD_X86_FORMATTER_MAX_LENGTH], small[8];
+
+	for (size_t offset = 0; offset < sizeof(code); offset += instruction.length)
+	{
+		ASSERT_TRUE(nmd_x86_decode(code + offset, sizeof(code) - offset, &instruction, MODE_32, NMD_X86_DECODER_FLAGS_ALL));
+		for (size_t i = 0; i < sizeof(flags) / sizeof(flags[0]); i++)
+		{
+			nmd_x86_format(&instruction, expected, 0x1000, flags[i]);
+			EXPECT_EQ(nmd_x86_format_ex(&instruction, buffer, sizeof(buffer), 0x1000, flags[i]), strlen(expected));
+			EXPECT_STREQ(buffer, expected);
+
+			const size_t length = strlen(expected);
+			EXPECT_EQ(nmd_x86_format_ex(&instruction, buffer, length + 1, 0x1000, flags[i]), length);
+			EXPECT_STREQ(buffer, expected);
+			EXPECT_EQ(nmd_x86_format_ex(&instruction, buffer, length, 0x1000, flags[i]), 0);
+			EXPECT_EQ(buffer[0], '\0');
+		}
+	}
+
+	ASSERT_TRUE(nmd_x86_decode(code + 5, sizeof(code) - 5, &instruction, MODE_32, NMD_X86_DECODER_FLAGS_ALL));
+	EXPECT_EQ(nmd_x86_format_ex(&instruction, buffer, sizeof(buffer), 0, 0), 9);
+	EXPECT_STREQ(buffer, "mov eax,5");
+	EXPECT_EQ(nmd_x86_format_ex(&instruction, small, sizeof(small), 0, 0), 0);
+
+	ASSERT_TRUE(nmd_x86_decode(code, sizeof(code), &instruction, MODE_32, NMD_X86_DECODER_FLAGS_ALL));
+	EXPECT_EQ(nmd_x86_format_ex(&instruction, buffer, sizeof(buffer), 0, 0), 17);
+	EXPECT_STREQ(buffer, "mov eax,305419896");
+	EXPECT_EQ(nmd_x86_format_ex(&instruction, buffer, sizeof(buffer), 0, NMD_X86_FORMAT_FLAGS_HEX | NMD_X86_FORMAT_FLAGS_H_SUFFIX), 17);
+	EXPECT_STREQ(buffer, "mov eax,12345678h");
+}
+
+TEST(side_tests_suite, format_buffer_tests)
+{
+	// xor eax,eax; inc eax; push 0deadbeefh; jmp $+2; ret
+	const uint8_t code[] = { 0x33, 0xc0, 0x40, 0x68, 0xef, 0xbe, 0xad, 0xde, 0xeb, 0x00, 0xc3 };
+	nmd_x86_instruction instructions[8];
+	nmd_x86_text_line lines[8];
+	char text[512], line[NMD_X86_FORMATTER_MAX_LENGTH], expected[512];
+	size_t text_length;
+
+	ASSERT_EQ(nmd_x86_decode_buffer(code, sizeof(code), 0x1000, MODE_32, NMD_X86_DECODER_FLAGS_ALL, instructions, 8, NULL), 5);
+
+	EXPECT_EQ(nmd_x86_format_buffer(instructions, 5, 0x1000, NMD_X86_FORMAT_FLAGS_DEFAULT | NMD_X86_FORMAT_FLAGS_ADDRESS, text, sizeof(text), lines, &text_length), 5);
+	EXPECT_STREQ(text, "00001000 xor eax,eax\n00001002 inc eax\n00001003 push DEADBEEFh\n00001008 jmp 100Ah\n0000100A ret\n");
+	EXPECT_EQ(text_length, strlen(text));
+
+	expected[0] = '\0';
+	for (size_t i = 0, offset = 0; i < 5; offset += instructions[i++].length)
+	{
+		nmd_x86_format(&instructions[i], line, 0x1000 + offset, NMD_X86_FORMAT_FLAGS_DEFAULT | NMD_X86_FORMAT_FLAGS_BYTES);
+		strcat(expected, line);
+		strcat(expected, "\n");
+	}
+	EXPECT_EQ(nmd_x86_format_buffer(instructions, 5, 0x1000, NMD_X86_FORMAT_FLAGS_DEFAULT | NMD_X86_FORMAT_FLAGS_BYTES, text, sizeof(text), lines, &text_length), 5);
+	EXPECT_STREQ(text, expected);
+	for (size_t i = 0; i < 5; i++)
+	{
+		EXPECT_EQ(text[lines[i].offset + lines[i].length], '\n');
+		EXPECT_TRUE(i == 0 || lines[i].offset == lines[i - 1].offset + lines[i - 1].length + 1);
+	}
+
+	// Only the first two lines("xor eax,eax\ninc eax\n") fit.
+	EXPECT_EQ(nmd_x86_format_buffer(instructions, 5, NMD_X86_INVALID_RUNTIME_ADDRESS, NMD_X86_FORMAT_FLAGS_DEFAULT | NMD_X86_FORMAT_FLAGS_ADDRESS, text, 25, lines, &text_length), 2);
+	EXPECT_STREQ(text, "xor eax,eax\ninc eax\n");
+	EXPECT_EQ(text_length, 20);
+
+	instructions[1].valid = false;
+	EXPECT_EQ(nmd_x86_format_buffer(instructions, 5, 0x1000, NMD_X86_FORMAT_FLAGS_DEFAULT, text, sizeof(text), NULL, NULL), 1);
+	EXPECT_STREQ(text, "xor eax,eax\n");
+}
+
+TEST(side_tests_suite, assembler_lookup_tests)
+{
+	struct { const char* string; NMD_X86_MODE mode; size_t length; uint8_t bytes[8]; } tests[] = {
+		{ "xor esi,edx",          MODE_32, 2, { 0x31, 0xd6 } },
+		{ "add rax,rbx",          MODE_64, 3, { 0x48, 0x01, 0xd8 } },
+		{ "adc al,ch",            MODE_32, 2, { 0x10, 0xe8 } },
+		{ "cmp r9w,r8w",          MODE_64, 4, { 0x66, 0x45, 0x39, 0xc1 } },
+		{ "push fs",              MODE_32, 2, { 0x0f, 0xa0 } },
+		{ "ret far",              MODE_32, 1, { 0xcb } },
+		{ "dec dword ptr [eax]",  MODE_32, 2, { 0xff, 0x08 } },
+		{ "add [esp],eax",        MODE_32, 3, { 0x01, 0x04, 0x24 } },
+		{ "sub [ebp],cl",         MODE_32, 3, { 0x28, 0x4d, 0x00 } },
+		{ "emit 0x90 0x91",       MODE_32, 2, { 0x90, 0x91 } },
+		{ "lock add [eax],ebx",   MODE_32, 3, { 0xf0, 0x01, 0x18 } },
+		{ "rep ret",              MODE_64, 2, { 0xf3, 0xc3 } },
+		{ "lock repne inc ecx",   MODE_32, 3, { 0xf0, 0xf2, 0x41 } },
+		{ "lock lock inc ecx",    MODE_32, 0 },
+		{ "rep repz ret",         MODE_32, 0 },
+		{ "call eax",             MODE_32, 0 }, /* 'eax' is not the number EAh */
+		{ "mov al,ch",            MODE_32, 0 }, /* 'ch' is not the number Ch */
+		{ "pop cs",               MODE_32, 0 },
+		{ "add ax,bl",            MODE_32, 0 },
+		{ "xyz",                  MODE_32, 0 },
+	};
+	uint8_t buffer[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH];
+
+	for (size_t i = 0; i < sizeof(tests) / sizeof(*tests); i++)
+	{
+		SCOPED_TRACE(tests[i].string);
+		ASSERT_EQ(nmd_x86_assemble(tests[i].string, buffer, sizeof(buffer), NMD_X86_INVALID_RUNTIME_ADDRESS, tests[i].mode, 0), tests[i].length);
+		EXPECT_EQ(memcmp(buffer, tests[i].bytes, tests[i].length), 0);
+	}
+
+	/* Relative branches are relative to the end of the instruction, prefixes included */
+	ASSERT_EQ(nmd_x86_assemble("repne jmp 0x1000", buffer, sizeof(buffer), 0x1000, MODE_32, 0), 6);
+	EXPECT_EQ(memcmp(buffer, "\xf2\xe9\xfa\xff\xff\xff", 6), 0);
+}
+
+TEST(side_tests_suite, encode_tests)
+{
+	/* Instructions filled by the decoder are encoded to the same bytes(these are the encodings chosen by the encoder) */
+	struct { NMD_X86_MODE mode; size_t length; uint8_t bytes[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH]; } tests[] = {
+		{ MODE_64, 3,  { 0x48, 0x01, 0xd8 } },                                           /* add rax,rbx */
+		{ MODE_64, 5,  { 0x4c, 0x8b, 0x4c, 0x24, 0x08 } },                               /* mov r9,[rsp+8] */
+		{ MODE_64, 7,  { 0x48, 0x8b, 0x05, 0x10, 0x00, 0x00, 0x00 } },                   /* mov rax,[rip+10h] */
+		{ MODE_64, 4,  { 0xc6, 0x45, 0x00, 0x01 } },                                     /* mov byte ptr [rbp],1 */
+		{ MODE_64, 8,  { 0x42, 0x8d, 0x04, 0x8d, 0x00, 0x00, 0x00, 0x00 } },             /* lea eax,[r9*4] */
+		{ MODE_64, 7,  { 0x48, 0xc7, 0xc0, 0xff, 0xff, 0xff, 0xff } },                   /* mov rax,-1 */
+		{ MODE_64, 10, { 0x48, 0xb8, 0x89, 0x67, 0x45, 0x23, 0x01, 0x00, 0x00, 0x00 } }, /* mov rax,123456789h */
+		{ MODE_64, 3,  { 0x83, 0xc0, 0x7f } },                                           /* add eax,7Fh */
+		{ MODE_64, 5,  { 0x05, 0x00, 0x01, 0x00, 0x00 } },                               /* add eax,100h */
+		{ MODE_64, 3,  { 0xf0, 0xff, 0x00 } },                                           /* lock inc dword ptr [rax] */
+		{ MODE_64, 2,  { 0x41, 0x51 } },                                                 /* push r9 */
+		{ MODE_64, 3,  { 0x40, 0x88, 0xe0 } },                                           /* mov al,spl */
+		{ MODE_64, 2,  { 0x88, 0xe0 } },                                                 /* mov al,ah */
+		{ MODE_64, 3,  { 0x41, 0x88, 0xe8 } },                                           /* mov r8b,bpl */
+		{ MODE_64, 4,  { 0x40, 0x80, 0xc7, 0x01 } },                                     /* add dil,1 */
+		{ MODE_64, 3,  { 0x40, 0xb6, 0x05 } },                                           /* mov sil,5 */
+		{ MODE_64, 3,  { 0x40, 0x8a, 0x30 } },                                           /* mov sil,[rax] */
+		{ MODE_64, 3,  { 0x40, 0xfe, 0xc6 } },                                           /* inc sil */
+		{ MODE_64, 2,  { 0xeb, 0xfe } },                                                 /* jmp $ */
+		{ MODE_64, 6,  { 0x0f, 0x84, 0x00, 0x01, 0x00, 0x00 } },                         /* jz $+106h */
+		{ MODE_64, 2,  { 0x0f, 0x05 } },                                                 /* syscall */
+		{ MODE_32, 4,  { 0x89, 0x44, 0x24, 0x04 } },                                     /* mov [esp+4],eax */
+		{ MODE_32, 2,  { 0x6a, 0xff } },                                                 /* push -1 */
+		{ MODE_32, 2,  { 0x66, 0x40 } },                                                 /* inc ax */
+		{ MODE_32, 2,  { 0xcd, 0x80 } },                                                 /* int 80h */
+		{ MODE_32, 3,  { 0xc2, 0x08, 0x00 } },                                           /* ret 8 */
+	};
+	nmd_x86_instruction instruction;
+	uint8_t buffer[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH];
+
+	for (size_t i = 0; i < sizeof(tests) / sizeof(*tests); i++)
+	{
+		SCOPED_TRACE(i);
+		ASSERT_TRUE(nmd_x86_decode(tests[i].bytes, tests[i].length, &instruction, tests[i].mode, NMD_X86_DECODER_FLAGS_ALL));
+		ASSERT_EQ(nmd_x86_encode(&instruction, buffer, sizeof(buffer)), tests[i].length);
+		EXPECT_EQ(memcmp(buffer, tests[i].bytes, tests[i].length), 0);
+		EXPECT_EQ(nmd_x86_encode(&instruction, buffer, tests[i].length - 1), 0);
+	}
+
+	/* Far pointers and 16-bit addressing can't be encoded */
+	struct { NMD_X86_MODE mode; size_t length; uint8_t bytes[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH]; } unsupported[] = {
+		{ MODE_32, 7, { 0x9a, 0x78, 0x56, 0x34, 0x12, 0x08, 0x00 } }, /* call far 8h:12345678h */
+		{ MODE_16, 2, { 0x8b, 0x05 } },                               /* mov ax,[di] */
+		{ MODE_16, 2, { 0x8b, 0x00 } },                               /* mov ax,[bx+si] */
+		{ MODE_16, 2, { 0x01, 0x18 } },                               /* add [bx+si],bx */
+		{ MODE_16, 4, { 0x8b, 0x06, 0x34, 0x12 } },                   /* mov ax,[1234h] */
+	};
+	for (size_t i = 0; i < sizeof(unsupported) / sizeof(*unsupported); i++)
+	{
+		SCOPED_TRACE(i);
+		ASSERT_TRUE(nmd_x86_decode(unsupported[i].bytes, unsupported[i].length, &instruction, unsupported[i].mode, NMD_X86_DECODER_FLAGS_ALL));
+		EXPECT_EQ(nmd_x86_encode(&instruction, buffer, sizeof(buffer)), 0);
+	}
+
+	/* Relative branches keep their targets when a shorter encoding is used */
+	struct { NMD_X86_MODE mode; size_t length, encoded_length; uint8_t bytes[NMD_X86_MAXIMUM_INSTRUCTION_LENGTH]; } branches[] = {
+		{ MODE_64, 5, 2, { 0xe9, 0x10, 0x00, 0x00, 0x00 } },       /* jmp $+15h */
+		{ MODE_64, 5, 2, { 0xe9, 0xf0, 0xff, 0xff, 0xff } },       /* jmp $-0Bh */
+		{ MODE_64, 6, 2, { 0x0f, 0x84, 0x10, 0x00, 0x00, 0x00 } }, /* jz $+16h */
+		{ MODE_64, 6, 6, { 0x0f, 0x8c, 0x7e, 0x00, 0x00, 0x00 } }, /* jl $+84h */
+		{ MODE_64, 5, 5, { 0xe8, 0x10, 0x00, 0x00, 0x00 } },       /* call $+15h */
+		{ MODE_32, 2, 2, { 0x75, 0x80 } },                         /* jnz $-7Eh */
+	};
+	for (size_t i = 0; i < sizeof(branches) / sizeof(*branches); i++)
+	{
+		SCOPED_TRACE(i);
+		nmd_x86_instruction encoded;
+		ASSERT_TRUE(nmd_x86_decode(branches[i].bytes, branches[i].length, &instruction, branches[i].mode, NMD_X86_DECODER_FLAGS_ALL));
+		ASSERT_EQ(nmd_x86_encode(&instruction, buffer, sizeof(buffer)), branches[i].encoded_length);
+		ASSERT_TRUE(nmd_x86_decode(buffer, branches[i].encoded_length, &encoded, branches[i].mode, NMD_X86_DECODER_FLAGS_ALL));
+		EXPECT_EQ(encoded.id, instruction.id);
+		EXPECT_EQ(encoded.length + encoded.operands[0].fields.imm, instruction.length + instruction.operands[0].fields.imm);
+	}
+
+	/* 32-bit addressing in 16-bit mode */
+	{
+		const uint8_t bytes[] = { 0x67, 0x8b, 0x00 }; /* mov ax,[eax] */
+		ASSERT_TRUE(nmd_x86_decode(bytes, sizeof(bytes), &instruction, NMD_X86_MODE_16, NMD_X86_DECODER_FLAGS_ALL));
+		ASSERT_EQ(nmd_x86_encode(&instruction, buffer, sizeof(buffer)), sizeof(bytes));
+		EXPECT_EQ(memcmp(buffer, bytes, sizeof(bytes)), 0);
+	}
+
+	/* Instructions described by the application */
+	memset(&instruction, 0, sizeof(instruction));
+	instruction.mode = NMD_X86_MODE_64;
+	instruction.id = NMD_X86_INSTRUCTION_ADD;
+	instruction.num_operands = 2;
+	instruction.operands[0].type = NMD_X86_OPERAND_TYPE_MEMORY;
+	instruction.operands[0].fields.mem.base = NMD_X86_REG_R13;
+	instruction.operands[0].fields.mem.index = NMD_X86_REG_RCX;
+	instruction.operands[0].fields.mem.scale = 8;
+	instruction.operands[0].fields.mem.disp = -0x80;
+	instruction.operands[1].type = NMD_X86_OPERAND_TYPE_REGISTER;
+	instruction.operands[1].fields.reg = NMD_X86_REG_R10W;
+	{
+		const uint8_t bytes[] = { 0x66, 0x45, 0x01, 0x54, 0xcd, 0x80 }; /* add [r13+rcx*8-80h],r10w */
+		ASSERT_EQ(nmd_x86_encode(&instruction, buffer, sizeof(buffer)), sizeof(bytes));
+		EXPECT_EQ(memcmp(buffer, bytes, sizeof(bytes)), 0);
+	}
+
+	instruction.operands[0].fields.mem.index = NMD_X86_REG_RSP; /* rsp can't be an index register */
+	EXPECT_EQ(nmd_x86_encode(&instruction, buffer, sizeof(buffer)), 0);
+
+	instruction.mode = NMD_X86_MODE_32; /* 64-bit registers are only valid in 64-bit mode */
+	instruction.operands[0].fields.mem.index = NMD_X86_REG_RCX;
+	EXPECT_EQ(nmd_x86_encode(&instruction, buffer, sizeof(buffer)), 0);
+
+	/* 'ah' to 'bh' can't be encoded with a REX prefix, which 'r8b' requires */
+	instruction.mode = NMD_X86_MODE_64;
+	instruction.id = NMD_X86_INSTRUCTION_MOV;
+	instruction.operands[0].type = NMD_X86_OPERAND_TYPE_REGISTER;
+	instruction.operands[0].fields.reg = NMD_X86_REG_AH;
+	instruction.operands[1].fields.reg = NMD_X86_REG_R8B;
+	EXPECT_EQ(nmd_x86_encode(&instruction, buffer, sizeof(buffer)), 0);
+
+	/* With 'has_rex' the same description is 'mov spl,r8b' */
+	instruction.has_rex = true;
+	{
+		const uint8_t bytes[] = { 0x44, 0x88, 0xc4 }; /* mov spl,r8b */
+		ASSERT_EQ(nmd_x86_encode(&instruction, buffer, sizeof(buffer)), sizeof(bytes));
+		EXPECT_EQ(memcmp(buffer, bytes, sizeof(bytes)), 0);
+	}
+
+	/* Outside 64-bit mode there is no REX prefix */
+	instruction.mode = NMD_X86_MODE_32;
+	instruction.operands[1].fields.reg = NMD_X86_REG_AL;
+	EXPECT_EQ(nmd_x86_encode(&instruction, buffer, sizeof(buffer)), 0);
+}
+
+TEST(side_tests_suite, assemble_block_tests)
+{
+	struct { const char* string; uint64_t runtime_address; NMD_X86_MODE mode; size_t length; uint8_t bytes[16]; } tests[] = {
+		{ "start:\n mov cl,10\nloop: dec ecx\n jnz loop\n jmp end\n\n call start\nend: ret", 0x1000, MODE_32, 13, { 0xb1, 0x0a, 0x49, 0x75, 0xfd, 0xeb, 0x05, 0xe8, 0xf4, 0xff, 0xff, 0xff, 0xc3 } },
+		{ "jz Next\nemit 0x90 0x90\nnext:\nret",   NMD_X86_INVALID_RUNTIME_ADDRESS, MODE_64, 5, { 0x74, 0x02, 0x90, 0x90, 0xc3 } },
+		{ "jmp x\nx:\njmp 0x2000",                 0x1000, MODE_64, 7, { 0xeb, 0x00, 0xe9, 0xf9, 0x0f, 0x00, 0x00 } },
+		{ "jmp nowhere",                           0, MODE_32, 0 },
+		{ "a:\na:\nret",                           0, MODE_32, 0 },
+		{ "beef: nop\njmp beef",                   0x1000, MODE_32, 3, { 0x90, 0xeb, 0xfd } }, /* Labels take precedence over numbers */
+		{ "jmp add\nadd: ret",                     NMD_X86_INVALID_RUNTIME_ADDRESS, MODE_64, 3, { 0xeb, 0x00, 0xc3 } },
+		{ "call beef",                             0x1000, MODE_32, 5, { 0xe8, 0xea, 0xae, 0x00, 0x00 } },
+	};
+	char arena[1024];
+	uint8_t buffer[512];
+
+	for (size_t i = 0; i < sizeof(tests) / sizeof(*tests); i++)
+	{
+		SCOPED_TRACE(tests[i].string);
+		ASSERT_EQ(nmd_x86_assemble_block(tests[i].string, buffer, sizeof(buffer), tests[i].runtime_address, tests[i].mode, arena, sizeof(arena)), tests[i].length);
+		EXPECT_EQ(memcmp(buffer, tests[i].bytes, tests[i].length), 0);
+	}
+
+	/* The branch over the instructions grows and the instructions are moved */
+	std::string block = "top: jz bottom\n";
+	for (size_t i = 0; i < 30; i++)
+		block += "add eax,0x12345678\n";
+	block += "bottom: jmp top";
+	ASSERT_EQ(nmd_x86_assemble_block(block.c_str(), buffer, sizeof(buffer), 0x400000, MODE_32, arena, sizeof(arena)), 6 + 30 * 5 + 5);
+	EXPECT_EQ(memcmp(buffer, "\x0f\x84\x96\x00\x00\x00\x05\x78\x56\x34\x12", 11), 0);
+	EXPECT_EQ(memcmp(buffer + 6 + 29 * 5, "\x05\x78\x56\x34\x12\xe9\x5f\xff\xff\xff", 10), 0);
+
+	/* The arena and the buffer must be big enough */
+	EXPECT_EQ(nmd_x86_assemble_block(block.c_str(), buffer, 100, 0x400000, MODE_32, arena, sizeof(arena)), 0);
+	EXPECT_EQ(nmd_x86_assemble_block(block.c_str(), buffer, sizeof(buffer), 0x400000, MODE_32, arena, 64), 0);
+
+	/* nmd_x86_assemble() advances the runtime address after each instruction */
+	ASSERT_EQ(nmd_x86_assemble("jmp 0x1000\njmp 0x1000", buffer, sizeof(buffer), 0x1000, MODE_32, 0), 10);
+	EXPECT_EQ(memcmp(buffer, "\xe9\xfb\xff\xff\xff\xe9\xf6\xff\xff\xff", 10), 0);
+}
+
+TEST(side_tests_suite, cache_tests)
+{
+	// push rbp; mov rbp,rsp; sub rsp,20h; call 0x1000; leave; ret
+	uint8_t code[] = { 0x55, 0x48, 0x89, 0xe5, 0x48, 0x83, 0xec, 0x20, 0xe8, 0xf3, 0x0f, 0x00, 0x00, 0xc9, 0xc3 };
+	static uint64_t memory[NMD_X86_CACHE_MEMORY_SIZE(64) / 8 + 1];
+	nmd_x86_cache cache;
+	nmd_x86_instruction instruction;
+	char expected[NMD_X86_FORMATTER_MAX_LENGTH];
+
+	/* The block is aligned and rounded down to a power of two buckets */
+	EXPECT_EQ(nmd_x86_cache_init(&cache, memory, NMD_X86_CACHE_BUCKET_SIZE), 0);
+	EXPECT_EQ(nmd_x86_cache_init(&cache, (uint8_t*)memory + 1, NMD_X86_CACHE_MEMORY_SIZE(64) - 2), 32);
+	ASSERT_EQ(nmd_x86_cache_init(&cache, memory, NMD_X86_CACHE_MEMORY_SIZE(64)), 64);
+
+	/* The first pass decodes every instruction and the second one finds them in the cache */
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (size_t offset = 0; offset < sizeof(code); offset += instruction.length)
+		{
+			const nmd_x86_instruction* cached = nmd_x86_cache_decode(&cache, code + offset, sizeof(code) - offset, 0x1000 + offset, MODE_64, NMD_X86_DECODER_FLAGS_ALL);
+			ASSERT_TRUE(nmd_x86_decode(code + offset, sizeof(code) - offset, &instruction, MODE_64, NMD_X86_DECODER_FLAGS_ALL));
+			ASSERT_TRUE(cached);
+			EXPECT_EQ(cached->length, instruction.length);
+			EXPECT_EQ(cached->id, instruction.id);
+		}
+	}
+	EXPECT_EQ(cache.num_misses, 6);
+	EXPECT_EQ(cache.num_hits, 6);
+
+	/* Each combination of mode and flags is a different entry */
+	EXPECT_TRUE(nmd_x86_cache_decode(&cache, code, sizeof(code), 0x1000, MODE_64, NMD_X86_DECODER_FLAGS_MINIMAL));
+	EXPECT_EQ(cache.num_misses, 7);
+
+	/* The string is cached with its flags */
+	nmd_x86_decode(code + 8, sizeof(code) - 8, &instruction, MODE_64, NMD_X86_DECODER_FLAGS_ALL);
+	nmd_x86_format(&instruction, expected, 0x1008, NMD_X86_FORMAT_FLAGS_DEFAULT);
+	const char* string = nmd_x86_cache_format(&cache, code + 8, sizeof(code) - 8, 0x1008, MODE_64, NMD_X86_DECODER_FLAGS_ALL, NMD_X86_FORMAT_FLAGS_DEFAULT);
+	ASSERT_TRUE(string);
+	EXPECT_STREQ(string, expected);
+	EXPECT_EQ(nmd_x86_cache_format(&cache, code + 8, sizeof(code) - 8, 0x1008, MODE_64, NMD_X86_DECODER_FLAGS_ALL, NMD_X86_FORMAT_FLAGS_DEFAULT), string);
+	nmd_x86_format(&instruction, expected, 0x1008, NMD_X86_FORMAT_FLAGS_DEFAULT | NMD_X86_FORMAT_FLAGS_UPPERCASE);
+	EXPECT_STREQ(nmd_x86_cache_format(&cache, code + 8, sizeof(code) - 8, 0x1008, MODE_64, NMD_X86_DECODER_FLAGS_ALL, NMD_X86_FORMAT_FLAGS_DEFAULT | NMD_X86_FORMAT_FLAGS_UPPERCASE), expected);
+	EXPECT_EQ(cache.num_hits, 9);
+
+	/* Modified code is detected even if it's not invalidated */
+	code[0] = 0x53; // push rbx
+	const nmd_x86_instruction* cached = nmd_x86_cache_decode(&cache, code, sizeof(code), 0x1000, MODE_64, NMD_X86_DECODER_FLAGS_ALL);
+	ASSERT_TRUE(cached);
+	EXPECT_EQ(cached->buffer[0], 0x53);
+	EXPECT_EQ(cache.num_misses, 8);
+
+	/* Patching 'sub rsp,20h' removes it, but not the instructions around it. The range may also be as large as the address space */
+	EXPECT_EQ(nmd_x86_cache_invalidate(&cache, 0x1007, 1), 1);
+	EXPECT_TRUE(nmd_x86_cache_decode(&cache, code + 1, sizeof(code) - 1, 0x1001, MODE_64, NMD_X86_DECODER_FLAGS_ALL));
+	EXPECT_TRUE(nmd_x86_cache_decode(&cache, code + 8, sizeof(code) - 8, 0x1008, MODE_64, NMD_X86_DECODER_FLAGS_ALL));
+	EXPECT_EQ(cache.num_misses, 8);
+	EXPECT_TRUE(nmd_x86_cache_decode(&cache, code + 4, sizeof(code) - 4, 0x1004, MODE_64, NMD_X86_DECODER_FLAGS_ALL));
+	EXPECT_EQ(cache.num_misses, 9);
+	EXPECT_EQ(nmd_x86_cache_invalidate(&cache, 0, (size_t)-1), 7);
+	EXPECT_EQ(nmd_x86_cache_invalidate(&cache, 0x1000, 64), 0);
+
+	/* Invalid instructions are not cached */
+	uint8_t invalid = 0x06; // push es
+	EXPECT_FALSE(nmd_x86_cache_decode(&cache, &invalid, 1, 0x2000, MODE_64, NMD_X86_DECODER_FLAGS_ALL));
+	EXPECT_FALSE(nmd_x86_cache_decode(&cache, &invalid, 1, 0x2000, MODE_64, NMD_X86_DECODER_FLAGS_ALL));
+
+	nmd_x86_cache_clear(&cache);
+	EXPECT_EQ(cache.num_hits, 0);
+	EXPECT_EQ(nmd_x86_cache_invalidate(&cache, 0, (size_t)-1), 0);
+}
+
+TEST(side_tests_suite, cfg_tests)
+{
+	// 1000: push ebp; xor eax,eax; 1003: test ecx,ecx; jz 100c; 1007: call 1013; 100c: inc eax; jmp 1003; int3(x4); 1013: ret; jmp eax
+	const uint8_t code[] = { 0x55, 0x31, 0xc0, 0x85, 0xc9, 0x74, 0x05, 0xe8, 0x07, 0x00, 0x00, 0x00, 0x40, 0xeb, 0xf4, 0xcc, 0xcc, 0xcc, 0xcc, 0xc3, 0xff, 0xe0 };
+	const uint64_t entry_point = 0x1000;
+	uint8_t memory[NMD_X86_CFG_MEMORY_SIZE(sizeof(code))];
+	nmd_x86_cfg cfg;
+
+	ASSERT_EQ(nmd_x86_cfg_build(code, sizeof(code), 0x1000, MODE_32, &entry_point, 1, &cfg, memory, sizeof(memory)), 5);
+	const uint32_t offsets[] = { 0x0, 0x3, 0x7, 0xc, 0x13 }, sizes[] = { 3, 4, 5, 3, 1 }, num_instructions[] = { 2, 2, 1, 2, 1 }, first_edges[] = { 0, 1, 3, 4, 5, 5 };
+	const uint8_t flags[] = { NMD_X86_CFG_BLOCK_FUNCTION, 0, 0, 0, NMD_X86_CFG_BLOCK_FUNCTION | NMD_X86_CFG_BLOCK_RETURN };
+	for (size_t i = 0; i < 5; i++)
+	{
+		SCOPED_TRACE(i);
+		EXPECT_EQ(cfg.block_offset[i], offsets[i]);
+		EXPECT_EQ(cfg.block_size[i], sizes[i]);
+		EXPECT_EQ(cfg.block_num_instructions[i], num_instructions[i]);
+		EXPECT_EQ(cfg.block_flags[i], flags[i]);
+		EXPECT_EQ(cfg.block_first_edge[i], first_edges[i]);
+	}
+	EXPECT_EQ(cfg.block_first_edge[5], first_edges[5]);
+
+	const uint32_t targets[] = { 1, 3, 2, 3, 1 };
+	const uint8_t types[] = { NMD_X86_CFG_EDGE_FALLTHROUGH, NMD_X86_CFG_EDGE_BRANCH_TAKEN, NMD_X86_CFG_EDGE_FALLTHROUGH, NMD_X86_CFG_EDGE_FALLTHROUGH, NMD_X86_CFG_EDGE_JUMP };
+	ASSERT_EQ(cfg.num_edges, 5);
+	for (size_t i = 0; i < 5; i++)
+	{
+		SCOPED_TRACE(i);
+		EXPECT_EQ(cfg.edge_target[i], targets[i]);
+		EXPECT_EQ(cfg.edge_type[i], types[i]);
+	}
+
+	/* Besides a byte per byte of code, only the arrays of the graph need memory */
+	nmd_x86_cfg small_cfg;
+	size_t memory_size = sizeof(code);
+	while (!nmd_x86_cfg_build(code, sizeof(code), 0x1000, MODE_32, &entry_point, 1, &small_cfg, memory, memory_size) && memory_size < sizeof(memory))
+		memory_size++;
+	EXPECT_LT(memory_size, sizeof(code) + 4 + 5 * 27 + 4);
+	EXPECT_EQ(small_cfg.num_blocks, 5);
+	EXPECT_EQ(small_cfg.num_edges, 5);
+
+	/* Offsets are used as addresses if there's no runtime address. 0: jmp rax; 2: jnz 0x1000; 8: nop */
+	const uint8_t code2[] = { 0xff, 0xe0, 0x0f, 0x85, 0xf8, 0x0f, 0x00, 0x00, 0x90 };
+	const uint64_t entry_points[] = { 0, 2, 0x2000 };
+	ASSERT_EQ(nmd_x86_cfg_build(code2, sizeof(code2), NMD_X86_INVALID_RUNTIME_ADDRESS, MODE_64, entry_points, 3, &cfg, memory, sizeof(memory)), 3);
+	EXPECT_EQ(cfg.block_flags[0], NMD_X86_CFG_BLOCK_FUNCTION | NMD_X86_CFG_BLOCK_INDIRECT_BRANCH);
+	EXPECT_EQ(cfg.block_flags[1], NMD_X86_CFG_BLOCK_FUNCTION | NMD_X86_CFG_BLOCK_EXTERNAL_BRANCH);
+	EXPECT_EQ(cfg.block_flags[2], NMD_X86_CFG_BLOCK_TRUNCATED);
+	EXPECT_EQ(cfg.num_edges, 1);
+
+	EXPECT_EQ(nmd_x86_cfg_build(code2, sizeof(code2), 0x1000, MODE_64, entry_points, 3, &cfg, memory, sizeof(memory)), 0);
+}
+
+TEST(side_tests_suite, register_use_tests)
+{
+	const struct { uint8_t bytes[8]; size_t length; uint32_t gpr_read, gpr_written, vector_read, vector_written, flags_read, flags_written; } tests[] = {
+		{ { 0x01, 0xc8 }, 2, NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RCX, NMD_X86_REGISTER_USE_RAX, 0, 0, 0, NMD_X86_EFLAGS_OF | NMD_X86_EFLAGS_SF | NMD_X86_EFLAGS_ZF | NMD_X86_EFLAGS_AF | NMD_X86_EFLAGS_PF | NMD_X86_EFLAGS_CF }, /* add eax,ecx */
+		{ { 0x89, 0xc8 }, 2, NMD_X86_REGISTER_USE_RCX, NMD_X86_REGISTER_USE_RAX, 0, 0, 0, 0 }, /* mov eax,ecx */
+		{ { 0x88, 0xe0 }, 2, NMD_X86_REGISTER_USE_RAX, NMD_X86_REGISTER_USE_RAX, 0, 0, 0, 0 }, /* mov al,ah */
+		{ { 0x4c, 0x8b, 0x04, 0xc8 }, 4, NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RCX | NMD_X86_REGISTER_USE_DS, NMD_X86_REGISTER_USE_R8, 0, 0, 0, 0 }, /* mov r8,[rax+rcx*8] */
+		{ { 0x8d, 0x04, 0x08 }, 3, NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RCX, NMD_X86_REGISTER_USE_RAX, 0, 0, 0, 0 }, /* lea eax,[rax+rcx] */
+		{ { 0xf7, 0xe1 }, 2, NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RCX, NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RDX, 0, 0, 0, NMD_X86_EFLAGS_OF | NMD_X86_EFLAGS_SF | NMD_X86_EFLAGS_ZF | NMD_X86_EFLAGS_AF | NMD_X86_EFLAGS_PF | NMD_X86_EFLAGS_CF }, /* mul ecx */
+		{ { 0xd3, 0xe0 }, 2, NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RCX, NMD_X86_REGISTER_USE_RAX, 0, 0, 0, NMD_X86_EFLAGS_OF | NMD_X86_EFLAGS_SF | NMD_X86_EFLAGS_ZF | NMD_X86_EFLAGS_AF | NMD_X86_EFLAGS_PF | NMD_X86_EFLAGS_CF }, /* shl eax,cl */
+		{ { 0xf3, 0xa4 }, 2, NMD_X86_REGISTER_USE_RCX | NMD_X86_REGISTER_USE_RSI | NMD_X86_REGISTER_USE_RDI | NMD_X86_REGISTER_USE_ES | NMD_X86_REGISTER_USE_DS, NMD_X86_REGISTER_USE_RCX | NMD_X86_REGISTER_USE_RSI | NMD_X86_REGISTER_USE_RDI, 0, 0, NMD_X86_EFLAGS_DF, 0 }, /* rep movsb */
+		{ { 0x0f, 0x44, 0xc1 }, 3, NMD_X86_REGISTER_USE_RCX, NMD_X86_REGISTER_USE_RAX, 0, 0, NMD_X86_EFLAGS_ZF, 0 }, /* cmovz eax,ecx */
+		{ { 0x74, 0x00 }, 2, NMD_X86_REGISTER_USE_IP, NMD_X86_REGISTER_USE_IP, 0, 0, NMD_X86_EFLAGS_ZF, 0 }, /* jz +2 */
+		{ { 0xc3 }, 1, NMD_X86_REGISTER_USE_RSP | NMD_X86_REGISTER_USE_SS, NMD_X86_REGISTER_USE_RSP | NMD_X86_REGISTER_USE_IP, 0, 0, 0, 0 }, /* ret */
+		{ { 0x48, 0x8b, 0x05, 0x00, 0x00, 0x00, 0x00 }, 7, NMD_X86_REGISTER_USE_IP | NMD_X86_REGISTER_USE_DS, NMD_X86_REGISTER_USE_RAX, 0, 0, 0, 0 }, /* mov rax,[rip] */
+		{ { 0x0f, 0x28, 0xc1 }, 3, 0, 0, 1 << 1, 1 << 0, 0, 0 }, /* movaps xmm0,xmm1 */
+		{ { 0x44, 0x0f, 0xb6, 0xc1 }, 4, NMD_X86_REGISTER_USE_RCX | NMD_X86_REGISTER_USE_R8, NMD_X86_REGISTER_USE_R8, 0, 0, 0, 0 }, /* movzx r8d,cl(no operands, only the destination is written, it's also assumed to be read) */
+		{ { 0xc4, 0x43, 0x29, 0x4a, 0xc1, 0x90 }, 6, 0, 0, (1 << 8) | (1 << 9) | (1 << 10), 1 << 8, 0, 0 }, /* vblendvps xmm8,xmm10,xmm9,xmm9 */
+		{ { 0x0f, 0xac, 0xc1, 0x01 }, 4, NMD_X86_REGISTER_USE_RAX | NMD_X86_REGISTER_USE_RCX, NMD_X86_REGISTER_USE_RCX, 0, 0, 0, NMD_X86_EFLAGS_OF | NMD_X86_EFLAGS_SF | NMD_X86_EFLAGS_ZF | NMD_X86_EFLAGS_AF | NMD_X86_EFLAGS_PF | NMD_X86_EFLAGS_CF }, /* shrd ecx,eax,1(ModR/M.rm is the destination) */
+		{ { 0xc4, 0xe3, 0x7d, 0x19, 0xc1, 0x01 }, 6, 0, 0, (1 << 0) | (1 << 1), 1 << 1, 0, 0 }, /* vextractf128 xmm1,ymm0,1 */
+	};
+
+	for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+	{
+		SCOPED_TRACE(i);
+		nmd_x86_instruction instruction;
+		nmd_x86_register_use registers;
+		ASSERT_TRUE(nmd_x86_decode(tests[i].bytes, tests[i].length, &instruction, MODE_64, NMD_X86_DECODER_FLAGS_ALL | NMD_X86_DECODER_FLAGS_REGISTERS));
+		EXPECT_EQ(instruction.registers.gpr_read, tests[i].gpr_read);
+		EXPECT_EQ(instruction.registers.gpr_written, tests[i].gpr_written);
+		EXPECT_EQ(instruction.registers.vector_read, tests[i].vector_read);
+		EXPECT_EQ(instruction.registers.vector_written, tests[i].vector_written);
+		EXPECT_EQ(instruction.registers.flags_read, tests[i].flags_read);
+		EXPECT_EQ(instruction.registers.flags_written, tests[i].flags_written);
+
+		/* nmd_x86_get_register_use() gives the same masks */
+		nmd_x86_get_register_use(&instruction, &registers);
+		EXPECT_EQ(memcmp(&registers, &instruction.registers, sizeof(registers)), 0);
+
+		/* The registers are only filled if required */
+		ASSERT_TRUE(nmd_x86_decode(tests[i].bytes, tests[i].length, &instruction, MODE_64, NMD_X86_DECODER_FLAGS_ALL));
+		EXPECT_EQ(instruction.registers.gpr_read | instruction.registers.gpr_written | instruction.registers.vector_read | instruction.registers.flags_written, 0);
+	}
+}
+
 TEST(side_tests_suite, generic_tests)
 {
 	int64_t num;
@@ -0,0 +1,381 @@
+/*
+Headless benchmark of nmd_graphics.h. Records synthetic scenes into the draw list of the default context(no renderer is involved) and measures the
+time per frame, then writes the results and the counters of the last frame('nmd_get_context()->stats') in JSON.
+
+Scenes:
+ - 'lines':    anti-aliased polylines and lines of several thicknesses.
+ - 'shapes':   rounded rects, circles and ngons, filled and outlined.
+ - 'fills':    anti-aliased convex polygons.
+ - 'images':   rounded images(UV shading).
+ - 'text':     labels of the baked default font(nmd_add_text()).
+ - 'text_cached': the same labels through the glyph cache(nmd_add_text_cached()).
+ - 'retained': the 'shapes' scene recorded once and appended by every frame(nmd_begin_retained()).
+ - 'gui':      windows with text, buttons, checkboxes and sliders.
+
+Usage: graphics_benchmark [--json output.json] [--time seconds] [--compare baseline.json] [--threshold percent] [--scale n]
+ - '--json'      writes the results to a file instead of stdout.
+ - '--time'      is the minimum duration of each measurement(0.25 seconds by default).
+ - '--compare'   compares the results with the results of a previous run. The exit code is 2 if any result is slower by more than '--threshold' percent(10 by default).
+ - '--scale'     multiplies the number of primitives, labels and windows of each scene(1 by default).
+
+Build: gcc -std=c99 -O2 tests/graphics_benchmark.c -lm -o graphics_benchmark
+       Add -DNMD_GRAPHICS_ENABLE_SSE2(or -DNMD_GRAPHICS_ENABLE_NEON on AArch64) to measure the SIMD tessellation kernels.
+*/
+#define NMD_GRAPHICS_IMPLEMENTATION
+#include "../nmd_graphics.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCHMARK_MAX_RESULTS 64
+#define BENCHMARK_NUM_LABELS 64
+#define BENCHMARK_POLYLINE_POINTS 64
+
+typedef struct benchmark_result
+{
+	const char* name;
+	double frames;
+	double seconds;
+	double zone_seconds[2]; /* The time spent in nmd_new_frame() and nmd_end_frame(), measured by the profiler */
+	nmd_frame_stats stats; /* The counters of the last frame */
+} benchmark_result;
+
+typedef struct benchmark_scene
+{
+	const char* name;
+	void (*record)(void);
+} benchmark_scene;
+
+static benchmark_result results[BENCHMARK_MAX_RESULTS];
+static size_t num_results = 0;
+static double min_seconds = 0.25;
+static int scale = 1;
+static char labels[BENCHMARK_NUM_LABELS][64];
+static nmd_glyph_cache glyph_cache;
+static nmd_font font;
+static double zone_start[2];
+static benchmark_result* current_result;
+
+static double get_seconds(void)
+{
+	return (double)clock() / CLOCKS_PER_SEC;
+}
+
+static nmd_tex_id create_texture(void* pixels, int width, int height)
+{
+	(void)pixels;
+	(void)width;
+	(void)height;
+	return (nmd_tex_id)(intptr_t)1;
+}
+
+static void update_texture(nmd_tex_id texture, const void* pixels, int x, int y, int width, int height, int pitch)
+{
+	(void)texture;
+	(void)pixels;
+	(void)x;
+	(void)y;
+	(void)width;
+	(void)height;
+	(void)pitch;
+}
+
+static void profile(const char* zone, bool begin, void* user_data)
+{
+	const int index = !strcmp(zone, "nmd_new_frame") ? 0 : (!strcmp(zone, "nmd_end_frame") ? 1 : -1);
+	(void)user_data;
+	if (index < 0 || !current_result)
+		return;
+
+	if (begin)
+		zone_start[index] = get_seconds();
+	else
+		current_result->zone_seconds[index] += get_seconds() - zone_start[index];
+}
+
+static void record_lines(void)
+{
+	nmd_vec2 points[BENCHMARK_POLYLINE_POINTS];
+	int i, j;
+	for (i = 0; i < 40 * scale; i++)
+	{
+		for (j = 0; j < BENCHMARK_POLYLINE_POINTS; j++)
+		{
+			points[j].x = 10.0f + j * 12.0f;
+			points[j].y = 20.0f + (i % 40) * 18.0f + ((j * 7 + i) % 5) * 3.0f;
+		}
+		nmd_add_polyline(points, BENCHMARK_POLYLINE_POINTS, NMD_COLOR_WHITE, i % 2 == 0, 1.0f + (i % 3));
+		nmd_add_line(0.0f, (float)i, 800.0f, 600.0f - i, NMD_COLOR_WHITE, 1.5f);
+	}
+}
+
+static void record_shapes(void)
+{
+	int i;
+	for (i = 0; i < 200 * scale; i++)
+	{
+		const float x = (float)(i % 20) * 40.0f, y = (float)(i / 20 % 20) * 30.0f;
+		nmd_add_rect_filled(x, y, x + 36.0f, y + 26.0f, NMD_COLOR_GUI_BACKGROUND, 5.0f, NMD_CORNER_ALL);
+		nmd_add_rect(x, y, x + 36.0f, y + 26.0f, NMD_COLOR_WHITE, 5.0f, NMD_CORNER_ALL, 1.0f);
+		nmd_add_circle_filled(x + 18.0f, y + 13.0f, 8.0f + i % 5, NMD_COLOR_GUI_ACTIVE, 0);
+		nmd_add_ngon(x + 18.0f, y + 13.0f, 12.0f, NMD_COLOR_WHITE, 6, 1.0f);
+	}
+}
+
+static void record_fills(void)
+{
+	nmd_vec2 points[BENCHMARK_POLYLINE_POINTS];
+	int i, j;
+	for (i = 0; i < 100 * scale; i++)
+	{
+		for (j = 0; j < BENCHMARK_POLYLINE_POINTS; j++)
+		{
+			const float angle = j * (6.283185306f / BENCHMARK_POLYLINE_POINTS);
+			points[j].x = 400.0f + (i % 10) * 20.0f + 60.0f * cosf(angle);
+			points[j].y = 300.0f + (i / 10 % 10) * 20.0f + 40.0f * sinf(angle);
+		}
+		nmd_add_convex_polygon_filled(points, BENCHMARK_POLYLINE_POINTS, NMD_COLOR_GUI_MAIN);
+	}
+}
+
+static void record_images(void)
+{
+	int i;
+	for (i = 0; i < 200 * scale; i++)
+	{
+		const float x = (float)(i % 20) * 40.0f, y = (float)(i / 20 % 20) * 30.0f;
+		nmd_add_image_rounded((nmd_tex_id)(intptr_t)(1 + i % 4), x, y, x + 36.0f, y + 26.0f, 8.0f, NMD_CORNER_ALL, NMD_COLOR_WHITE);
+	}
+}
+
+static void record_text(void)
+{
+	int i;
+	for (i = 0; i < 4 * BENCHMARK_NUM_LABELS * scale; i++)
+		nmd_add_text(&nmd_get_context()->draw_list.default_atlas, (float)(i % 4) * 200.0f, (float)(i / 4 % 60) * 10.0f, labels[i % BENCHMARK_NUM_LABELS], 0, NMD_COLOR_WHITE);
+}
+
+static void record_text_cached(void)
+{
+	int i;
+	for (i = 0; i < 4 * BENCHMARK_NUM_LABELS * scale; i++)
+		nmd_add_text_cached(&font, 14.0f, (float)(i % 4) * 200.0f, (float)(i / 4 % 60) * 10.0f, labels[i % BENCHMARK_NUM_LABELS], 0, NMD_COLOR_WHITE);
+}
+
+static void record_retained(void)
+{
+	if (nmd_begin_retained(1))
+	{
+		record_shapes();
+		nmd_end_retained();
+	}
+}
+
+static void record_gui(void)
+{
+	static bool checked[BENCHMARK_NUM_LABELS];
+	static float values[BENCHMARK_NUM_LABELS];
+	char name[32];
+	int i;
+	for (i = 0; i < 16 * scale; i++)
+	{
+		sprintf(name, "Inspector %d", i);
+		if (nmd_begin(name))
+		{
+			nmd_text("Frame %d", i);
+			nmd_button(labels[i % BENCHMARK_NUM_LABELS]);
+			nmd_checkbox("Enabled", &checked[i % BENCHMARK_NUM_LABELS]);
+			nmd_slider_float("Value", &values[i % BENCHMARK_NUM_LABELS], 0.0f, 1.0f);
+			nmd_end();
+		}
+	}
+}
+
+static const benchmark_scene scenes[] = {
+	{ "lines",       record_lines },
+	{ "shapes",      record_shapes },
+	{ "fills",       record_fills },
+	{ "images",      record_images },
+	{ "text",        record_text },
+	{ "text_cached", record_text_cached },
+	{ "retained",    record_retained },
+	{ "gui",         record_gui }
+};
+
+static void benchmark_scene_frames(const benchmark_scene* scene)
+{
+	benchmark_result* result;
+	double start;
+
+	if (num_results == BENCHMARK_MAX_RESULTS)
+		return;
+
+	result = &results[num_results++];
+	memset(result, 0, sizeof(benchmark_result));
+	result->name = scene->name;
+
+	/* The first frame grows the buffers and fills the caches, it's not measured */
+	nmd_new_frame();
+	scene->record();
+	nmd_end_frame();
+
+	current_result = result;
+	start = get_seconds();
+	do
+	{
+		nmd_new_frame();
+		scene->record();
+		nmd_end_frame();
+		result->frames++;
+	} while ((result->seconds = get_seconds() - start) < min_seconds);
+	current_result = 0;
+
+	result->stats = nmd_get_context()->stats;
+}
+
+static const char* get_simd_name(void)
+{
+#if defined(NMD_GRAPHICS_ENABLE_SSE2)
+	return "sse2";
+#elif defined(NMD_GRAPHICS_ENABLE_NEON)
+	return "neon";
+#else
+	return "none";
+#endif
+}
+
+/* Every result is written in its own line, which is what compare_results() expects. */
+static void write_results(FILE* file)
+{
+	size_t i;
+	fprintf(file, "{\n  \"library\": \"nmd_graphics\",\n  \"simd\": \"%s\",\n  \"scale\": %d,\n  \"clocks_per_second\": %.0f,\n  \"results\": [\n", get_simd_name(), scale, (double)CLOCKS_PER_SEC);
+	for (i = 0; i < num_results; i++)
+	{
+		const benchmark_result* result = &results[i];
+		const double frames = result->frames > 0 ? result->frames : 1;
+		fprintf(file, "    { \"name\": \"%s\", \"frames\": %.0f, \"seconds\": %.6f, \"us_per_frame\": %.3f, \"new_frame_us\": %.3f, \"end_frame_us\": %.3f, \"vertices\": %lu, \"indices\": %lu, \"draw_commands\": %lu, \"reallocations\": %lu }%s\n",
+			result->name, result->frames, result->seconds, result->seconds * 1000000.0 / frames, result->zone_seconds[0] * 1000000.0 / frames, result->zone_seconds[1] * 1000000.0 / frames,
+			(unsigned long)result->stats.num_vertices, (unsigned long)result->stats.num_indices, (unsigned long)result->stats.num_draw_commands, (unsigned long)result->stats.num_reallocations, i + 1 < num_results ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+}
+
+/* Returns the number of results slower than the baseline by more than 'threshold' percent, or -1 if the baseline can't be read. */
+static int compare_results(const char* path, double threshold)
+{
+	char line[1024];
+	int num_regressions = 0;
+	size_t i;
+	FILE* file;
+
+	if (!(file = fopen(path, "r")))
+		return -1;
+
+	while (fgets(line, sizeof(line), file))
+	{
+		const char* name = strstr(line, "{ \"name\": \"");
+		const char* us = strstr(line, "\"us_per_frame\": ");
+		const char* name_end;
+		double baseline, current;
+
+		if (!name || !us || !(name_end = strchr(name + 11, '"')))
+			continue;
+
+		name += 11;
+		baseline = atof(us + 16);
+		for (i = 0; i < num_results; i++)
+		{
+			if (strlen(results[i].name) != (size_t)(name_end - name) || strncmp(results[i].name, name, (size_t)(name_end - name)))
+				continue;
+
+			current = results[i].frames > 0 ? results[i].seconds * 1000000.0 / results[i].frames : 0;
+			if (baseline > 0 && current > baseline * (1.0 + threshold / 100.0))
+			{
+				fprintf(stderr, "regression: %s %.3f -> %.3f us/frame (%+.1f%%)\n", results[i].name, baseline, current, (current / baseline - 1.0) * 100.0);
+				num_regressions++;
+			}
+			break;
+		}
+	}
+
+	fclose(file);
+	return num_regressions;
+}
+
+int main(int argc, char** argv)
+{
+	const char* json_path = 0;
+	const char* baseline_path = 0;
+	double threshold = 10.0;
+	FILE* output = stdout;
+	int i, num_regressions = 0;
+	size_t j;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--json") && i + 1 < argc)
+			json_path = argv[++i];
+		else if (!strcmp(argv[i], "--time") && i + 1 < argc)
+			min_seconds = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--compare") && i + 1 < argc)
+			baseline_path = argv[++i];
+		else if (!strcmp(argv[i], "--threshold") && i + 1 < argc)
+			threshold = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--scale") && i + 1 < argc)
+			{
+			scale = atoi(argv[++i]);
+			if (scale < 1)
+				scale = 1;
+		}
+		else
+		{
+			fprintf(stderr, "error: unknown argument '%s'\n", argv[i]);
+			return 1;
+		}
+	}
+
+	for (i = 0; i < BENCHMARK_NUM_LABELS; i++)
+		sprintf(labels[i], "Label %d: the quick brown fox", i);
+
+	if (!nmd_bake_font_from_memory(nmd_karla_ttf_regular, &nmd_get_context()->draw_list.default_atlas, 14.0f))
+	{
+		fprintf(stderr, "error: could not bake the default font\n");
+		return 1;
+	}
+
+	nmd_glyph_cache_init(&glyph_cache, 0, create_texture, update_texture);
+	if (!nmd_font_init(&font, &glyph_cache, nmd_karla_ttf_regular))
+	{
+		fprintf(stderr, "error: could not initialize the default font\n");
+		return 1;
+	}
+
+	nmd_set_profiler(profile, 0);
+
+	for (j = 0; j < sizeof(scenes) / sizeof(scenes[0]); j++)
+		benchmark_scene_frames(&scenes[j]);
+
+	if (json_path && !(output = fopen(json_path, "w")))
+	{
+		fprintf(stderr, "error: could not write '%s'\n", json_path);
+		return 1;
+	}
+
+	write_results(output);
+	if (output != stdout)
+		fclose(output);
+
+	if (baseline_path && (num_regressions = compare_results(baseline_path, threshold)) < 0)
+	{
+		fprintf(stderr, "error: could not read '%s'\n", baseline_path);
+		return 1;
+	}
+
+	nmd_font_destroy(&font);
+	nmd_glyph_cache_destroy(&glyph_cache);
+	nmd_destroy_context(nmd_get_context());
+
+	return num_regressions ? 2 : 0;
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <vector>
+
+#define NMD_MEMORY_IMPLEMENTATION
+#include "../platform_specific/nmd_memory.h"
+
+// The reference the compiled patterns are checked against: compares the pattern at every offset.
+static uint8_t* naive_find(const char* pattern, const char* mask, const uint8_t* start, const uint8_t* end)
+{
+	const size_t length = strlen(mask);
+	for (const uint8_t* b = start; b + length <= end; b++)
+	{
+		size_t i = 0;
+		while (i < length && (mask[i] == '?' || b[i] == (uint8_t)pattern[i]))
+			i++;
+		if (i == length)
+			return (uint8_t*)b;
+	}
+
+	return 0;
+}
+
+static uint32_t seed = 1;
+static uint32_t random_number() { return (seed = seed * 1103515245 + 12345) >> 16; }
+
+TEST(memory_tests_suite, pattern_compile_tests)
+{
+	nmd_pattern compiled;
+	char long_mask[NMD_PATTERN_MAX_LENGTH + 2] = { 0 };
+	char long_pattern[NMD_PATTERN_MAX_LENGTH + 2] = { 0 };
+	memset(long_mask, 'x', NMD_PATTERN_MAX_LENGTH + 1);
+	memset(long_pattern, 0x90, NMD_PATTERN_MAX_LENGTH + 1);
+
+	EXPECT_FALSE(nmd_pattern_compile(&compiled, "", ""));
+	EXPECT_FALSE(nmd_pattern_compile(&compiled, "\x00\x00\x00", "???"));
+	EXPECT_FALSE(nmd_pattern_compile(&compiled, long_pattern, long_mask));
+	long_mask[NMD_PATTERN_MAX_LENGTH] = '\0';
+	EXPECT_TRUE(nmd_pattern_compile(&compiled, long_pattern, long_mask));
+	EXPECT_EQ(compiled.length, NMD_PATTERN_MAX_LENGTH);
+
+	// The anchors are the two rarest bytes that are not wildcards('\xcc' and '\x2b' are rarer than '\x00' and '\x8b' in x86 code)
+	const char* const pattern = "\x8b\x00\xcc\x2b\x00";
+	ASSERT_TRUE(nmd_pattern_compile(&compiled, pattern, "x?xxx"));
+	EXPECT_EQ(compiled.length, 5);
+	EXPECT_EQ(compiled.source, pattern);
+	EXPECT_EQ(compiled.mask[1], 0x00);
+	EXPECT_EQ(compiled.mask[5], 0x00);
+	EXPECT_NE(compiled.anchor, compiled.anchor2);
+	EXPECT_TRUE(compiled.anchor == 2 || compiled.anchor == 3);
+	EXPECT_TRUE(compiled.anchor2 == 2 || compiled.anchor2 == 3);
+
+	// A pattern with a single byte is anchored twice at that byte
+	ASSERT_TRUE(nmd_pattern_compile(&compiled, "\x00\xcc\x00", "?x?"));
+	EXPECT_EQ(compiled.anchor, 1);
+	EXPECT_EQ(compiled.anchor2, 1);
+}
+
+TEST(memory_tests_suite, pattern_find_tests)
+{
+	nmd_pattern compiled;
+	const uint8_t code[] = { 0x55, 0x48, 0x89, 0xe5, 0x48, 0x83, 0xec, 0x20, 0xe8, 0x11, 0x22, 0x33, 0x44, 0xc3 };
+
+	ASSERT_TRUE(nmd_pattern_compile(&compiled, "\xe8\x00\x00\x00\x00\xc3", "x????x"));
+	EXPECT_EQ(nmd_pattern_find(&compiled, code, code + sizeof(code)), code + 8);
+	EXPECT_EQ(nmd_pattern_find(&compiled, code, code + sizeof(code) - 1), (uint8_t*)0);
+	EXPECT_EQ(nmd_pattern_find(&compiled, code + 9, code + sizeof(code)), (uint8_t*)0);
+	EXPECT_EQ(nmd_pattern_find(&compiled, code, code), (uint8_t*)0);
+
+	ASSERT_TRUE(nmd_pattern_compile(&compiled, "\x48", "x"));
+	EXPECT_EQ(nmd_pattern_find(&compiled, code, code + sizeof(code)), code + 1);
+	EXPECT_EQ(nmd_pattern_find(&compiled, code + 2, code + sizeof(code)), code + 4);
+
+	// Compare against the reference on random buffers whose bytes are drawn from a small alphabet so there are many candidates. The sizes
+	// cover the scalar tail and the SSE2 and AVX2 loops(if 'NMD_MEMORY_ENABLE_SSE2' or 'NMD_MEMORY_ENABLE_AVX2' is defined), and each buffer
+	// is allocated with its exact size so reads past the end are caught by the address sanitizer.
+	const uint8_t alphabet[] = { 0x00, 0x48, 0x8b, 0xff };
+	char pattern[40], mask[41];
+	for (size_t i = 0; i < 20000; i++)
+	{
+		std::vector<uint8_t> buffer(random_number() % 300);
+		for (size_t j = 0; j < buffer.size(); j++)
+			buffer[j] = alphabet[random_number() % sizeof(alphabet)];
+
+		const size_t length = 1 + random_number() % (sizeof(pattern) - 1);
+		const size_t offset = buffer.size() >= length ? random_number() % (buffer.size() - length + 1) : 0;
+		for (size_t j = 0; j < length; j++)
+		{
+			// Most patterns are taken from the buffer so they are found, some are random
+			pattern[j] = (char)(buffer.size() >= length && i % 4 ? buffer[offset + j] : alphabet[random_number() % sizeof(alphabet)]);
+			mask[j] = random_number() % 4 ? 'x' : '?';
+		}
+		mask[length] = '\0';
+		mask[random_number() % length] = 'x';
+
+		ASSERT_TRUE(nmd_pattern_compile(&compiled, pattern, mask));
+		const uint8_t* const start = buffer.data();
+		const uint8_t* const end = buffer.data() + buffer.size();
+		EXPECT_EQ(nmd_pattern_find(&compiled, start, end), naive_find(pattern, mask, start, end));
+	}
+}
+
+TEST(memory_tests_suite, pattern_set_tests)
+{
+	nmd_pattern_set set;
+	nmd_pattern_set_init(&set);
+	EXPECT_EQ(set.num_patterns, 0);
+
+	const uint8_t code[] = { 0x55, 0x48, 0x89, 0xe5, 0x48, 0x83, 0xec, 0x20, 0xe8, 0x11, 0x22, 0x33, 0x44, 0x48, 0x83, 0xc4, 0x20, 0x5d, 0xc3 };
+	EXPECT_EQ(nmd_pattern_set_add(&set, "\x48\x83\x00\x20", "xx?x"), 0);
+	EXPECT_EQ(nmd_pattern_set_add(&set, "\x5d\xc3", "xx"), 1);
+	EXPECT_EQ(nmd_pattern_set_add(&set, "\x00\x00", "??"), -1);
+	EXPECT_EQ(nmd_pattern_set_add(&set, "\xcc\xcc", "xx"), 2);
+	EXPECT_EQ(nmd_pattern_set_add(&set, "\xe8\x00\x00\x00\x00\x48", "x????x"), 3);
+	EXPECT_EQ(set.num_patterns, 4);
+
+	uint8_t* matches[4] = { 0 };
+	EXPECT_EQ(nmd_pattern_set_find(&set, code, code + sizeof(code), matches), 3);
+	EXPECT_EQ(matches[0], code + 4);
+	EXPECT_EQ(matches[1], code + 17);
+	EXPECT_EQ(matches[2], (uint8_t*)0);
+	EXPECT_EQ(matches[3], code + 8);
+
+	// The patterns that were found are not searched again, so a later buffer does not replace their matches
+	EXPECT_EQ(nmd_pattern_set_find(&set, code + 5, code + sizeof(code), matches), 3);
+	EXPECT_EQ(matches[0], code + 4);
+
+	// Each pattern's first match is the same as nmd_pattern_find()'s
+	uint8_t* matches2[4] = { 0 };
+	EXPECT_EQ(nmd_pattern_set_find(&set, code + 5, code + sizeof(code), matches2), 3);
+	EXPECT_EQ(matches2[0], code + 13);
+	for (size_t i = 0; i < set.num_patterns; i++)
+		EXPECT_EQ(matches2[i], nmd_pattern_find(&set.patterns[i], code + 5, code + sizeof(code)));
+
+	// The compiled copy of a pattern matches itself, but is never returned
+	nmd_pattern_set_init(&set);
+	ASSERT_EQ(nmd_pattern_set_add(&set, "\x0f\x05\xc3", "xxx"), 0);
+	uint8_t* matches3[1] = { 0 };
+	EXPECT_EQ(nmd_pattern_set_find(&set, set.patterns[0].bytes, set.patterns[0].bytes + 3, matches3), 0);
+
+	// A set is full after 'NMD_PATTERN_SET_MAX_PATTERNS' patterns
+	nmd_pattern_set_init(&set);
+	for (size_t i = 0; i < NMD_PATTERN_SET_MAX_PATTERNS; i++)
+		EXPECT_EQ(nmd_pattern_set_add(&set, "\x90", "x"), (int)i);
+	EXPECT_EQ(nmd_pattern_set_add(&set, "\x90", "x"), -1);
+}